@@ -9,6 +9,7 @@
 #include <linux/genhd.h>
 #include <linux/vmalloc.h>
 #include <linux/blktrace_api.h>
+#include <linux/ktime.h>
 #include <linux/raid/detect.h>
 #include "check.h"
 
@@ -85,6 +86,43 @@ static int (*check_part[])(struct parsed_partitions *) = {
 	NULL
 };
 
+#ifdef CONFIG_CMDLINE_PARTITION
+/*
+ * blkdevparts_only: the blkdevparts= layout is the only partition table of
+ * the board. Disks it does not name, like the emmc boot areas and rpmb, are
+ * left without partitions instead of taking the probing reads of every
+ * other format on the way to storage being ready.
+ */
+static bool cmdline_parts_only;
+
+static int __init cmdline_parts_only_setup(char *s)
+{
+	cmdline_parts_only = true;
+	return 1;
+}
+__setup("blkdevparts_only", cmdline_parts_only_setup);
+
+static bool check_part_skip(int (*check)(struct parsed_partitions *))
+{
+	return cmdline_parts_only && check != cmdline_partition;
+}
+#else
+static bool check_part_skip(int (*check)(struct parsed_partitions *))
+{
+	return false;
+}
+#endif
+
+/* partition_timing: log the time each parser took on each disk */
+static bool part_timing;
+
+static int __init part_timing_setup(char *s)
+{
+	part_timing = true;
+	return 1;
+}
+__setup("partition_timing", part_timing_setup);
+
 static struct parsed_partitions *allocate_partitions(struct gendisk *hd)
 {
 	struct parsed_partitions *state;
@@ -116,7 +154,10 @@ static struct parsed_partitions *check_partition(struct gendisk *hd,
 		struct block_device *bdev)
 {
 	struct parsed_partitions *state;
+	char timing[128];
 	int i, res, err;
+	size_t len = 0;
+	ktime_t start;
 
 	state = allocate_partitions(hd);
 	if (!state)
@@ -136,8 +177,18 @@ static struct parsed_partitions *check_partition(struct gendisk *hd,
 
 	i = res = err = 0;
 	while (!res && check_part[i]) {
+		if (check_part_skip(check_part[i])) {
+			i++;
+			continue;
+		}
 		memset(state->parts, 0, state->limit * sizeof(state->parts[0]));
-		res = check_part[i++](state);
+		start = ktime_get();
+		res = check_part[i](state);
+		if (part_timing)
+			len += scnprintf(timing + len, sizeof(timing) - len,
+					 " %ps:%lldus", check_part[i],
+					 ktime_us_delta(ktime_get(), start));
+		i++;
 		if (res < 0) {
 			/*
 			 * We have hit an I/O error which we don't report now.
@@ -148,6 +199,9 @@ static struct parsed_partitions *check_partition(struct gendisk *hd,
 		}
 
 	}
+	if (part_timing)
+		pr_info("%s: partition parsers%s\n", hd->disk_name,
+			len ? timing : " none");
 	if (res > 0) {
 		printk(KERN_INFO "%s", state->pp_buf);
 
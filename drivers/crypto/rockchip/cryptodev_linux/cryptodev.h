@@ -43,6 +43,13 @@ struct fcrypt {
 	struct list_head list;
 	struct list_head dma_map_list;
 	struct mutex sem;
+	/* recent dmabuf mappings of ops without RIOCCRYPT_FD_MAP */
+	struct list_head dma_cache_list;
+	struct mutex dma_cache_lock;
+	int dma_cache_count;
+	/* RIOCCRYPT_FD_BATCH still running asynchronously */
+	atomic_t batch_pending;
+	wait_queue_head_t batch_wait;
 };
 
 /* compatibility stuff */
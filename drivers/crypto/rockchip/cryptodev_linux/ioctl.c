@@ -594,6 +594,8 @@ cryptodev_open(struct inode *inode, struct file *filp)
 	INIT_LIST_HEAD(&pcr->done.list);
 
 	INIT_WORK(&pcr->cryptask, cryptask_routine);
+	rk_cryptodev_dma_cache_init(&pcr->fcrypt);
+	rk_cryptodev_batch_init(&pcr->fcrypt);
 
 	init_waitqueue_head(&pcr->user_waiter);
 
@@ -636,6 +638,7 @@ cryptodev_release(struct inode *inode, struct file *filp)
 		return 0;
 
 	cancel_work_sync(&pcr->cryptask);
+	rk_cryptodev_batch_flush(&pcr->fcrypt);
 
 	list_splice_tail(&pcr->todo.list, &pcr->free.list);
 	list_splice_tail(&pcr->done.list, &pcr->free.list);
@@ -653,6 +656,7 @@ cryptodev_release(struct inode *inode, struct file *filp)
 	}
 
 	crypto_finish_all_sessions(&pcr->fcrypt);
+	rk_cryptodev_dma_cache_release(&pcr->fcrypt);
 
 	mutex_destroy(&pcr->done.lock);
 	mutex_destroy(&pcr->todo.lock);
@@ -17,6 +17,9 @@
 #include <linux/dma-direct.h>
 #include <linux/dma-buf.h>
 #include <linux/list.h>
+#include <linux/eventfd.h>
+#include <linux/kthread.h>
+#include <linux/sched/mm.h>
 
 #include "version.h"
 #include "cipherapi.h"
@@ -336,28 +339,183 @@ static struct dma_fd_map_node *dma_fd_find_node(struct fcrypt *fcr, int dma_fd)
 	return NULL;
 }
 
+/*
+ * Transparent cache of recent dmabuf mappings per fcrypt. Callers that do
+ * not premap through RIOCCRYPT_FD_MAP pay attach and map on every op; the
+ * cache keeps the last RK_DMA_CACHE_MAX mappings, bidirectional, and does
+ * only the cache maintenance per op. An entry goes once its dmabuf is
+ * orphaned (only the cache still holds it) or on lru overflow.
+ */
+#define RK_DMA_CACHE_MAX	8
+
+struct dma_fd_cache_node {
+	struct list_head list;
+	struct dma_buf *dmabuf;
+	struct dma_buf_attachment *dma_attach;
+	struct sg_table *sgtbl;
+	int users;
+};
+
+static bool dma_fd_cache_orphaned(struct dma_fd_cache_node *node)
+{
+	return file_count(node->dmabuf->file) == 1;
+}
+
+static void dma_fd_cache_evict(struct fcrypt *fcr, struct dma_fd_cache_node *node)
+{
+	list_del(&node->list);
+	fcr->dma_cache_count--;
+
+	dma_buf_unmap_attachment(node->dma_attach, node->sgtbl, DMA_BIDIRECTIONAL);
+	dma_buf_detach(node->dmabuf, node->dma_attach);
+	dma_buf_put(node->dmabuf);
+	kfree(node);
+}
+
+/* unused entries that are orphaned or over the limit, oldest first */
+static void dma_fd_cache_reap(struct fcrypt *fcr)
+{
+	struct dma_fd_cache_node *node, *tmp;
+
+	list_for_each_entry_safe(node, tmp, &fcr->dma_cache_list, list) {
+		if (node->users)
+			continue;
+		if (fcr->dma_cache_count > RK_DMA_CACHE_MAX || dma_fd_cache_orphaned(node))
+			dma_fd_cache_evict(fcr, node);
+	}
+}
+
+static struct dma_fd_cache_node *
+dma_fd_cache_get(struct fcrypt *fcr, int dma_fd, enum dma_data_direction dir)
+{
+	struct device *crypto_dev = rk_cryptodev_find_dev(NULL);
+	struct dma_fd_cache_node *node;
+	struct dma_buf *dmabuf;
+	int ret;
+
+	if (!crypto_dev)
+		return ERR_PTR(-EINVAL);
+
+	/* fd numbers are reused, the dmabuf is the key */
+	dmabuf = dma_buf_get(dma_fd);
+	if (IS_ERR(dmabuf)) {
+		derr(1, "dmabuf error! ret = %d", (int)PTR_ERR(dmabuf));
+		return ERR_CAST(dmabuf);
+	}
+
+	mutex_lock(&fcr->dma_cache_lock);
+
+	list_for_each_entry(node, &fcr->dma_cache_list, list) {
+		if (node->dmabuf == dmabuf) {
+			list_move_tail(&node->list, &fcr->dma_cache_list);
+			node->users++;
+			mutex_unlock(&fcr->dma_cache_lock);
+			dma_buf_put(dmabuf);
+
+			/* the map synced a new entry, a cached one is synced here */
+			dma_sync_sgtable_for_device(crypto_dev, node->sgtbl, dir);
+			return node;
+		}
+	}
+
+	node = kzalloc(sizeof(*node), GFP_KERNEL);
+	if (!node) {
+		ret = -ENOMEM;
+		goto error;
+	}
+
+	node->dma_attach = dma_buf_attach(dmabuf, crypto_dev);
+	if (IS_ERR(node->dma_attach)) {
+		ret = PTR_ERR(node->dma_attach);
+		derr(1, "dma_attach error! ret = %d", ret);
+		goto error;
+	}
+
+	node->sgtbl = dma_buf_map_attachment(node->dma_attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(node->sgtbl)) {
+		ret = PTR_ERR(node->sgtbl);
+		derr(1, "sg_tbl error! ret = %d", ret);
+		dma_buf_detach(dmabuf, node->dma_attach);
+		goto error;
+	}
+
+	/* the lookup reference becomes the one of the entry */
+	node->dmabuf = dmabuf;
+	node->users = 1;
+	list_add_tail(&node->list, &fcr->dma_cache_list);
+	fcr->dma_cache_count++;
+	dma_fd_cache_reap(fcr);
+
+	mutex_unlock(&fcr->dma_cache_lock);
+
+	return node;
+error:
+	mutex_unlock(&fcr->dma_cache_lock);
+	kfree(node);
+	dma_buf_put(dmabuf);
+
+	return ERR_PTR(ret);
+}
+
+static void dma_fd_cache_put(struct fcrypt *fcr, struct dma_fd_cache_node *node,
+			     enum dma_data_direction dir)
+{
+	struct device *crypto_dev = rk_cryptodev_find_dev(NULL);
+
+	/* cache invalidate for output data */
+	if (crypto_dev && dir != DMA_TO_DEVICE)
+		dma_sync_sgtable_for_cpu(crypto_dev, node->sgtbl, dir);
+
+	mutex_lock(&fcr->dma_cache_lock);
+	if (!--node->users && dma_fd_cache_orphaned(node))
+		dma_fd_cache_evict(fcr, node);
+	mutex_unlock(&fcr->dma_cache_lock);
+}
+
+void rk_cryptodev_dma_cache_init(struct fcrypt *fcr)
+{
+	mutex_init(&fcr->dma_cache_lock);
+	INIT_LIST_HEAD(&fcr->dma_cache_list);
+	fcr->dma_cache_count = 0;
+}
+
+void rk_cryptodev_dma_cache_release(struct fcrypt *fcr)
+{
+	struct dma_fd_cache_node *node, *tmp;
+
+	mutex_lock(&fcr->dma_cache_lock);
+	list_for_each_entry_safe(node, tmp, &fcr->dma_cache_list, list) {
+		WARN_ON(node->users);
+		dma_fd_cache_evict(fcr, node);
+	}
+	mutex_unlock(&fcr->dma_cache_lock);
+
+	mutex_destroy(&fcr->dma_cache_lock);
+}
+
 /* This is the main crypto function - zero-copy edition */
 static int __crypto_fd_run(struct fcrypt *fcr, struct csession *ses_ptr,
 			   struct kernel_crypt_fd_op *kcop)
 {
 	struct crypt_fd_op *cop = &kcop->cop;
-	struct dma_buf *dma_buf_in = NULL, *dma_buf_out = NULL;
 	struct sg_table sg_tmp;
 	struct sg_table *sg_tbl_in = NULL, *sg_tbl_out = NULL;
-	struct dma_buf_attachment *dma_attach_in = NULL, *dma_attach_out = NULL;
 	struct dma_fd_map_node *node_src = NULL, *node_dst = NULL;
+	struct dma_fd_cache_node *cache_src = NULL, *cache_dst = NULL;
 	int ret = 0;
 
 	node_src = dma_fd_find_node(fcr, kcop->cop.src_fd);
 	if (node_src) {
 		sg_tbl_in = node_src->sgtbl;
 	} else {
-		ret = get_dmafd_sgtbl(kcop->cop.src_fd, kcop->cop.len, DMA_TO_DEVICE,
-				&sg_tbl_in, &dma_attach_in, &dma_buf_in);
-		if (unlikely(ret)) {
-			derr(1, "Error get_dmafd_sgtbl src.");
+		cache_src = dma_fd_cache_get(fcr, kcop->cop.src_fd, DMA_TO_DEVICE);
+		if (IS_ERR(cache_src)) {
+			ret = PTR_ERR(cache_src);
+			cache_src = NULL;
+			derr(1, "Error dma_fd_cache_get src.");
 			goto exit;
 		}
+		sg_tbl_in = cache_src->sgtbl;
 	}
 
 	/* only cipher has dst */
@@ -366,12 +524,14 @@ static int __crypto_fd_run(struct fcrypt *fcr, struct csession *ses_ptr,
 		if (node_dst) {
 			sg_tbl_out = node_dst->sgtbl;
 		} else {
-			ret = get_dmafd_sgtbl(kcop->cop.dst_fd, kcop->cop.len, DMA_FROM_DEVICE,
-				&sg_tbl_out, &dma_attach_out, &dma_buf_out);
-			if (unlikely(ret)) {
-				derr(1, "Error get_dmafd_sgtbl dst.");
+			cache_dst = dma_fd_cache_get(fcr, kcop->cop.dst_fd, DMA_FROM_DEVICE);
+			if (IS_ERR(cache_dst)) {
+				ret = PTR_ERR(cache_dst);
+				cache_dst = NULL;
+				derr(1, "Error dma_fd_cache_get dst.");
 				goto exit;
 			}
+			sg_tbl_out = cache_dst->sgtbl;
 		}
 	} else {
 		memset(&sg_tmp, 0x00, sizeof(sg_tmp));
@@ -381,13 +541,11 @@ static int __crypto_fd_run(struct fcrypt *fcr, struct csession *ses_ptr,
 	ret = hash_n_crypt_fd(ses_ptr, cop, sg_tbl_in->sgl, sg_tbl_out->sgl, cop->len);
 
 exit:
-	if (dma_buf_in)
-		put_dmafd_sgtbl(kcop->cop.src_fd, DMA_TO_DEVICE,
-				sg_tbl_in, dma_attach_in, dma_buf_in);
+	if (cache_src)
+		dma_fd_cache_put(fcr, cache_src, DMA_TO_DEVICE);
 
-	if (dma_buf_out)
-		put_dmafd_sgtbl(kcop->cop.dst_fd, DMA_FROM_DEVICE,
-				sg_tbl_out, dma_attach_out, dma_buf_out);
+	if (cache_dst)
+		dma_fd_cache_put(fcr, cache_dst, DMA_FROM_DEVICE);
 	return ret;
 }
 
@@ -806,11 +964,9 @@ static int crypto_auth_fd_zc_rk(struct fcrypt *fcr, struct csession *ses_ptr,
 				  struct kernel_crypt_auth_fd_op *kcaop)
 {
 	struct crypt_auth_fd_op *caop = &kcaop->caop;
-	struct dma_buf *dma_buf_in = NULL, *dma_buf_out = NULL, *dma_buf_auth = NULL;
 	struct sg_table *sg_tbl_in = NULL, *sg_tbl_out = NULL, *sg_tbl_auth = NULL;
-	struct dma_buf_attachment *dma_attach_in = NULL, *dma_attach_out = NULL;
-	struct dma_buf_attachment *dma_attach_auth = NULL;
 	struct dma_fd_map_node *node_src = NULL, *node_dst = NULL, *node_auth = NULL;
+	struct dma_fd_cache_node *cache_src = NULL, *cache_dst = NULL, *cache_auth = NULL;
 	struct scatterlist *dst_sg, *src_sg;
 	struct scatterlist auth_src[2], auth_dst[2], src[2], dst[2], tag[2];
 	unsigned char *tag_buf = NULL;
@@ -820,24 +976,28 @@ static int crypto_auth_fd_zc_rk(struct fcrypt *fcr, struct csession *ses_ptr,
 	if (node_src) {
 		sg_tbl_in = node_src->sgtbl;
 	} else {
-		ret = get_dmafd_sgtbl(caop->src_fd, caop->len, DMA_TO_DEVICE,
-				      &sg_tbl_in, &dma_attach_in, &dma_buf_in);
-		if (unlikely(ret)) {
-			derr(1, "Error get_dmafd_sgtbl src.");
+		cache_src = dma_fd_cache_get(fcr, caop->src_fd, DMA_TO_DEVICE);
+		if (IS_ERR(cache_src)) {
+			ret = PTR_ERR(cache_src);
+			cache_src = NULL;
+			derr(1, "Error dma_fd_cache_get src.");
 			goto exit;
 		}
+		sg_tbl_in = cache_src->sgtbl;
 	}
 
 	node_dst = dma_fd_find_node(fcr, caop->dst_fd);
 	if (node_dst) {
 		sg_tbl_out = node_dst->sgtbl;
 	} else {
-		ret = get_dmafd_sgtbl(caop->dst_fd, caop->len, DMA_FROM_DEVICE,
-				      &sg_tbl_out, &dma_attach_out, &dma_buf_out);
-		if (unlikely(ret)) {
-			derr(1, "Error get_dmafd_sgtbl dst.");
+		cache_dst = dma_fd_cache_get(fcr, caop->dst_fd, DMA_FROM_DEVICE);
+		if (IS_ERR(cache_dst)) {
+			ret = PTR_ERR(cache_dst);
+			cache_dst = NULL;
+			derr(1, "Error dma_fd_cache_get dst.");
 			goto exit;
 		}
+		sg_tbl_out = cache_dst->sgtbl;
 	}
 
 	src_sg = sg_tbl_in->sgl;
@@ -848,12 +1008,14 @@ static int crypto_auth_fd_zc_rk(struct fcrypt *fcr, struct csession *ses_ptr,
 		if (node_auth) {
 			sg_tbl_auth = node_auth->sgtbl;
 		} else {
-			ret = get_dmafd_sgtbl(caop->auth_fd, caop->auth_len, DMA_TO_DEVICE,
-					      &sg_tbl_auth, &dma_attach_auth, &dma_buf_auth);
-			if (unlikely(ret)) {
-				derr(1, "Error get_dmafd_sgtbl auth.");
+			cache_auth = dma_fd_cache_get(fcr, caop->auth_fd, DMA_TO_DEVICE);
+			if (IS_ERR(cache_auth)) {
+				ret = PTR_ERR(cache_auth);
+				cache_auth = NULL;
+				derr(1, "Error dma_fd_cache_get auth.");
 				goto exit;
 			}
+			sg_tbl_auth = cache_auth->sgtbl;
 		}
 
 		sg_init_table_set_page(auth_src, ARRAY_SIZE(auth_src),
@@ -918,17 +1080,14 @@ static int crypto_auth_fd_zc_rk(struct fcrypt *fcr, struct csession *ses_ptr,
 exit:
 	kfree(tag_buf);
 
-	if (dma_buf_in)
-		put_dmafd_sgtbl(caop->src_fd, DMA_TO_DEVICE,
-				sg_tbl_in, dma_attach_in, dma_buf_in);
+	if (cache_src)
+		dma_fd_cache_put(fcr, cache_src, DMA_TO_DEVICE);
 
-	if (dma_buf_out)
-		put_dmafd_sgtbl(caop->dst_fd, DMA_FROM_DEVICE,
-				sg_tbl_out, dma_attach_out, dma_buf_out);
+	if (cache_dst)
+		dma_fd_cache_put(fcr, cache_dst, DMA_FROM_DEVICE);
 
-	if (dma_buf_auth)
-		put_dmafd_sgtbl(caop->auth_fd, DMA_TO_DEVICE,
-				sg_tbl_auth, dma_attach_auth, dma_buf_auth);
+	if (cache_auth)
+		dma_fd_cache_put(fcr, cache_auth, DMA_TO_DEVICE);
 
 	return ret;
 }
@@ -1123,6 +1282,399 @@ static int kcaop_fd_to_user(struct kernel_crypt_auth_fd_op *kcaop,
 	return 0;
 }
 
+/*
+ * RIOCCRYPT_FD_BATCH: N cipher/aead ranges on dmabufs in one call, e.g. the
+ * segments of an encoded frame encrypted in place. Every distinct dmabuf is
+ * attached and mapped once per batch, not once per range. With an eventfd
+ * the ranges run from a work item and the eventfd is signalled once all
+ * results (and encrypt tags) are written back.
+ */
+struct rk_crypt_batch_buf {
+	int fd;
+	struct dma_buf *dmabuf;
+	struct dma_buf_attachment *dma_attach;
+	struct sg_table *sgtbl;
+};
+
+struct rk_crypt_batch {
+	struct work_struct work;
+	struct fcrypt *fcr;
+	struct mm_struct *mm;
+	struct eventfd_ctx *efd;
+	struct crypt_fd_range_op __user *uops;
+	u32 count;
+
+	int nbufs;
+	struct rk_crypt_batch_buf bufs[2 * RK_CRYPT_BATCH_MAX];
+	struct kernel_crypt_fd_range_op krops[];
+};
+
+void rk_cryptodev_batch_init(struct fcrypt *fcr)
+{
+	atomic_set(&fcr->batch_pending, 0);
+	init_waitqueue_head(&fcr->batch_wait);
+}
+
+/* the sessions and the fcrypt must outlive the batches using them */
+void rk_cryptodev_batch_flush(struct fcrypt *fcr)
+{
+	wait_event(fcr->batch_wait, !atomic_read(&fcr->batch_pending));
+}
+
+static int rk_crypt_batch_get_buf(struct rk_crypt_batch *batch, int fd)
+{
+	struct rk_crypt_batch_buf *buf;
+	int i, ret;
+
+	for (i = 0; i < batch->nbufs; i++)
+		if (batch->bufs[i].fd == fd)
+			return i;
+
+	/* in place ranges read and write the same buffer */
+	buf = &batch->bufs[batch->nbufs];
+	ret = get_dmafd_sgtbl(fd, 0, DMA_BIDIRECTIONAL, &buf->sgtbl,
+			      &buf->dma_attach, &buf->dmabuf);
+	if (unlikely(ret)) {
+		derr(1, "Error get_dmafd_sgtbl fd %d.", fd);
+		return ret;
+	}
+	buf->fd = fd;
+
+	return batch->nbufs++;
+}
+
+static void rk_crypt_batch_put_bufs(struct rk_crypt_batch *batch)
+{
+	struct rk_crypt_batch_buf *buf;
+	int i;
+
+	for (i = 0; i < batch->nbufs; i++) {
+		buf = &batch->bufs[i];
+		put_dmafd_sgtbl(buf->fd, DMA_BIDIRECTIONAL, buf->sgtbl,
+				buf->dma_attach, buf->dmabuf);
+	}
+	batch->nbufs = 0;
+}
+
+/*
+ * describe [offset, offset + len) of a mapped dmabuf in the initialized
+ * table sgl, as pages and as dma addresses. the last entry is left spare
+ * for the tag. returns the number of entries used.
+ */
+static int rk_sg_set_range(struct scatterlist *sgl, unsigned int nents,
+			   struct sg_table *sgt, unsigned int offset, unsigned int len)
+{
+	struct scatterlist *sg, *out = sgl;
+	bool contig = sgt->nents == 1;
+	unsigned int pos = 0, skip, seg, i;
+
+	/* partially merged by the iommu, no way back to the pages */
+	if (!contig && sgt->nents != sgt->orig_nents)
+		return -EINVAL;
+
+	for_each_sg(sgt->sgl, sg, sgt->orig_nents, i) {
+		if (!len)
+			break;
+
+		if (offset >= pos + sg->length) {
+			pos += sg->length;
+			continue;
+		}
+
+		if (out == sgl + nents - 1)
+			return -EINVAL;
+
+		skip = offset - pos;
+		seg = min(sg->length - skip, len);
+
+		sg_set_page(out, sg_page(sg), seg, sg->offset + skip);
+		if (contig)
+			sg_dma_address(out) = sg_dma_address(sgt->sgl) + offset;
+		else
+			sg_dma_address(out) = sg_dma_address(sg) + skip;
+		sg_dma_len(out) = seg;
+
+		out++;
+		offset += seg;
+		len -= seg;
+		pos += sg->length;
+	}
+
+	if (len)
+		return -EINVAL;
+
+	sg_unmark_end(sgl + nents - 1);
+	sg_mark_end(out - 1);
+
+	return out - sgl;
+}
+
+static int rk_crypt_range_run(struct fcrypt *fcr, struct rk_crypt_batch *batch,
+			      struct kernel_crypt_fd_range_op *krop)
+{
+	struct crypt_fd_range_op *rop = &krop->rop;
+	struct sg_table *sgt_src = batch->bufs[krop->src_buf].sgtbl;
+	struct sg_table *sgt_dst = batch->bufs[krop->dst_buf].sgtbl;
+	unsigned int src_nents, dst_nents;
+	struct scatterlist *src, *dst, *sgl;
+	struct csession *ses_ptr;
+	int max_tag_len;
+	int ret, n;
+
+	/* this also enters ses_ptr->sem */
+	ses_ptr = crypto_get_session_by_sid(fcr, rop->ses);
+	if (unlikely(!ses_ptr)) {
+		derr(1, "invalid session ID=0x%08X", rop->ses);
+		return -EINVAL;
+	}
+
+	/* hash and cipher + hmac sessions keep state across calls */
+	if (unlikely(!ses_ptr->cdata.init || ses_ptr->hdata.init)) {
+		derr(1, "batch needs a cipher or aead session");
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	if (ses_ptr->cdata.aead) {
+		max_tag_len = cryptodev_cipher_get_tag_size(&ses_ptr->cdata);
+		if (unlikely(rop->tag_len > max_tag_len)) {
+			derr(0, "Illegal tag length: %d", rop->tag_len);
+			ret = -EINVAL;
+			goto out_unlock;
+		}
+
+		if (rop->tag_len)
+			cryptodev_cipher_set_tag_size(&ses_ptr->cdata, rop->tag_len);
+		else
+			rop->tag_len = max_tag_len;
+
+		cryptodev_cipher_auth(&ses_ptr->cdata, NULL, rop->auth_len);
+	} else if (unlikely(rop->auth_len || rop->len % ses_ptr->cdata.blocksize)) {
+		derr(1, "data size (%u) isn't a multiple of block size (%u)",
+		     rop->len, ses_ptr->cdata.blocksize);
+		ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	/* one spare entry each for the tag */
+	src_nents = sgt_src->orig_nents + 1;
+	dst_nents = sgt_dst->orig_nents + 1;
+	src = kcalloc(src_nents + dst_nents, sizeof(*src), GFP_KERNEL);
+	if (unlikely(!src)) {
+		ret = -ENOMEM;
+		goto out_unlock;
+	}
+	dst = src + src_nents;
+	sg_init_table(src, src_nents);
+	sg_init_table(dst, dst_nents);
+
+	ret = rk_sg_set_range(src, src_nents, sgt_src, rop->src_offset,
+			      rop->auth_len + rop->len);
+	if (unlikely(ret < 0))
+		goto out_free;
+	src_nents = ret;
+
+	ret = rk_sg_set_range(dst, dst_nents, sgt_dst, rop->dst_offset,
+			      rop->auth_len + rop->len);
+	if (unlikely(ret < 0))
+		goto out_free;
+	dst_nents = ret;
+
+	/* the tag follows the ciphertext: written on encrypt, read on decrypt */
+	if (ses_ptr->cdata.aead && rop->tag) {
+		sgl = rop->op == COP_ENCRYPT ? dst : src;
+		n = rop->op == COP_ENCRYPT ? dst_nents : src_nents;
+		sg_unmark_end(&sgl[n - 1]);
+		sg_set_buf(&sgl[n], krop->tag, rop->tag_len);
+		sg_mark_end(&sgl[n]);
+	}
+
+	cryptodev_cipher_set_iv(&ses_ptr->cdata, krop->iv,
+				min_t(int, ses_ptr->cdata.ivsize, rop->iv_len));
+
+	if (rop->op == COP_ENCRYPT) {
+		ret = cryptodev_cipher_encrypt(&ses_ptr->cdata, src, dst, rop->len);
+		if (unlikely(ret))
+			derr(0, "cryptodev_cipher_encrypt: %d", ret);
+	} else {
+		if (ses_ptr->cdata.aead && rop->tag)
+			ret = cryptodev_cipher_decrypt(&ses_ptr->cdata, src, dst,
+						       rop->len + rop->tag_len);
+		else
+			ret = cryptodev_cipher_decrypt(&ses_ptr->cdata, src, dst,
+						       rop->len);
+		if (unlikely(ret))
+			derr(0, "cryptodev_cipher_decrypt: %d", ret);
+	}
+
+out_free:
+	kfree(src);
+out_unlock:
+	crypto_put_session(ses_ptr);
+
+	return ret;
+}
+
+/* runs the ranges and writes the results back, in the submitter's mm */
+static void rk_crypt_batch_run(struct rk_crypt_batch *batch)
+{
+	struct kernel_crypt_fd_range_op *krop;
+	u32 i;
+
+	for (i = 0; i < batch->count; i++) {
+		krop = &batch->krops[i];
+		krop->rop.ret = rk_crypt_range_run(batch->fcr, batch, krop);
+	}
+
+	rk_crypt_batch_put_bufs(batch);
+
+	for (i = 0; i < batch->count; i++) {
+		krop = &batch->krops[i];
+
+		if (!krop->rop.ret && krop->rop.op == COP_ENCRYPT && krop->rop.tag &&
+		    copy_to_user(u64_to_user_ptr(krop->rop.tag), krop->tag,
+				 krop->rop.tag_len))
+			krop->rop.ret = -EFAULT;
+
+		if (put_user(krop->rop.ret, &batch->uops[i].ret))
+			derr(1, "Cannot copy batch result to userspace");
+	}
+}
+
+static void rk_crypt_batch_free(struct rk_crypt_batch *batch)
+{
+	rk_crypt_batch_put_bufs(batch);
+	if (batch->efd)
+		eventfd_ctx_put(batch->efd);
+	kfree(batch);
+}
+
+static void rk_crypt_batch_work(struct work_struct *work)
+{
+	struct rk_crypt_batch *batch = container_of(work, struct rk_crypt_batch, work);
+	struct fcrypt *fcr = batch->fcr;
+
+	kthread_use_mm(batch->mm);
+	rk_crypt_batch_run(batch);
+	kthread_unuse_mm(batch->mm);
+	mmput(batch->mm);
+
+	eventfd_signal(batch->efd, 1);
+	rk_crypt_batch_free(batch);
+
+	if (atomic_dec_and_test(&fcr->batch_pending))
+		wake_up(&fcr->batch_wait);
+}
+
+static int rk_crypt_batch_prepare(struct rk_crypt_batch *batch,
+				  struct kernel_crypt_fd_range_op *krop)
+{
+	struct crypt_fd_range_op *rop = &krop->rop;
+	struct dma_buf *dmabuf;
+	u64 end;
+	int ret;
+
+	if (unlikely(rop->op != COP_ENCRYPT && rop->op != COP_DECRYPT)) {
+		ddebug(1, "invalid operation op=%u", rop->op);
+		return -EINVAL;
+	}
+
+	if (unlikely(rop->flags || !(rop->auth_len + rop->len) ||
+		     rop->iv_len > EALG_MAX_BLOCK_LEN ||
+		     rop->tag_len > AALG_MAX_RESULT_LEN || (rop->tag && !rop->tag_len)))
+		return -EINVAL;
+
+	if (rop->iv_len &&
+	    unlikely(copy_from_user(krop->iv, u64_to_user_ptr(rop->iv), rop->iv_len)))
+		return -EFAULT;
+
+	if (rop->tag && rop->op == COP_DECRYPT &&
+	    unlikely(copy_from_user(krop->tag, u64_to_user_ptr(rop->tag), rop->tag_len)))
+		return -EFAULT;
+
+	ret = rk_crypt_batch_get_buf(batch, rop->src_fd);
+	if (unlikely(ret < 0))
+		return ret;
+	krop->src_buf = ret;
+
+	ret = rk_crypt_batch_get_buf(batch, rop->dst_fd);
+	if (unlikely(ret < 0))
+		return ret;
+	krop->dst_buf = ret;
+
+	end = (u64)rop->auth_len + rop->len;
+	dmabuf = batch->bufs[krop->src_buf].dmabuf;
+	if (unlikely(rop->src_offset + end > dmabuf->size))
+		return -EINVAL;
+	dmabuf = batch->bufs[krop->dst_buf].dmabuf;
+	if (unlikely(rop->dst_offset + end > dmabuf->size))
+		return -EINVAL;
+
+	return 0;
+}
+
+static int crypto_fd_batch_run(struct fcrypt *fcr, void __user *arg)
+{
+	struct crypt_fd_batch_op bop;
+	struct rk_crypt_batch *batch;
+	u32 i;
+	int ret;
+
+	if (unlikely(copy_from_user(&bop, arg, sizeof(bop))))
+		return -EFAULT;
+
+	if (unlikely(!bop.count || bop.count > RK_CRYPT_BATCH_MAX || bop.flags))
+		return -EINVAL;
+
+	batch = kzalloc(struct_size(batch, krops, bop.count), GFP_KERNEL);
+	if (unlikely(!batch))
+		return -ENOMEM;
+
+	batch->fcr = fcr;
+	batch->count = bop.count;
+	batch->uops = u64_to_user_ptr(bop.ops);
+
+	for (i = 0; i < bop.count; i++) {
+		if (unlikely(copy_from_user(&batch->krops[i].rop, &batch->uops[i],
+					    sizeof(batch->krops[i].rop)))) {
+			ret = -EFAULT;
+			goto err_free;
+		}
+
+		ret = rk_crypt_batch_prepare(batch, &batch->krops[i]);
+		if (unlikely(ret)) {
+			derr(1, "invalid batch range %u", i);
+			goto err_free;
+		}
+	}
+
+	if (bop.eventfd < 0) {
+		rk_crypt_batch_run(batch);
+		rk_crypt_batch_free(batch);
+		return 0;
+	}
+
+	batch->efd = eventfd_ctx_fdget(bop.eventfd);
+	if (IS_ERR(batch->efd)) {
+		ret = PTR_ERR(batch->efd);
+		batch->efd = NULL;
+		goto err_free;
+	}
+
+	mmget(current->mm);
+	batch->mm = current->mm;
+	atomic_inc(&fcr->batch_pending);
+	INIT_WORK(&batch->work, rk_crypt_batch_work);
+	queue_work(system_unbound_wq, &batch->work);
+
+	return 0;
+
+err_free:
+	rk_crypt_batch_free(batch);
+
+	return ret;
+}
+
 long
 rk_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long arg_)
 {
@@ -1162,6 +1714,12 @@ rk_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long arg_)
 		}
 
 		return kcaop_fd_to_user(&kcaop, fcr, arg);
+	case RIOCCRYPT_FD_BATCH:
+		ret = crypto_fd_batch_run(fcr, arg);
+		if (unlikely(ret))
+			dwarning(1, "Error in crypto_fd_batch_run");
+
+		return ret;
 	case RIOCCRYPT_FD_MAP:
 		ret = kcop_map_fd_from_user(&kmop, fcr, arg);
 		if (unlikely(ret)) {
@@ -66,6 +66,18 @@ struct kernel_crypt_auth_fd_op {
 	struct mm_struct *mm;
 };
 
+/* kernel-internal extension to struct crypt_fd_range_op */
+struct kernel_crypt_fd_range_op {
+	struct crypt_fd_range_op rop;
+
+	__u8 iv[EALG_MAX_BLOCK_LEN];
+	__u8 tag[AALG_MAX_RESULT_LEN];
+
+	/* index of src_fd/dst_fd in the mapped buffers of the batch */
+	int src_buf;
+	int dst_buf;
+};
+
 /* kernel-internal extension to struct crypt_fd_map_op */
 struct kernel_crypt_fd_map_op {
 	struct crypt_fd_map_op mop;
@@ -106,4 +118,12 @@ const char *rk_get_hash_name(uint32_t id, int *is_hmac);
 
 bool rk_cryptodev_multi_thread(const char *name);
 
+void rk_cryptodev_dma_cache_init(struct fcrypt *fcr);
+
+void rk_cryptodev_dma_cache_release(struct fcrypt *fcr);
+
+void rk_cryptodev_batch_init(struct fcrypt *fcr);
+
+void rk_cryptodev_batch_flush(struct fcrypt *fcr);
+
 #endif
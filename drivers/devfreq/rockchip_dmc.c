@@ -2397,7 +2397,13 @@ static int rockchip_dmcfreq_system_status_notifier(struct notifier_block *nb,
 	unsigned int refresh = false;
 	bool is_fixed = false;
 
-	if (dmcfreq->fixed_rate && (is_dualview(status) || is_isp(status))) {
+	/*
+	 * with a bandwidth demand table the camera masters declare what they
+	 * stream, so isp no longer needs the fixed rate.
+	 */
+	if (dmcfreq->fixed_rate &&
+	    (is_dualview(status) ||
+	     (is_isp(status) && !dmcfreq->info.bw_demand_tbl))) {
 		if (dmcfreq->is_fixed)
 			return NOTIFY_OK;
 		is_fixed = true;
@@ -2618,6 +2624,7 @@ static int devfreq_dmc_ondemand_func(struct devfreq *df,
 		nocp_req_rate = get_nocp_req_rate(dmcfreq);
 		target_freq = max3(target_freq, nocp_req_rate,
 				   dmcfreq->info.vop_req_rate);
+		target_freq = max(target_freq, dmcfreq->info.bw_req_rate);
 		now = ktime_to_us(ktime_get());
 		if (now < dmcfreq->touchboostpulse_endtime)
 			target_freq = max(target_freq, dmcfreq->boost_rate);
@@ -2626,6 +2633,7 @@ static int devfreq_dmc_ondemand_func(struct devfreq *df,
 			target_freq = dmcfreq->status_rate;
 		else if (dmcfreq->normal_rate)
 			target_freq = dmcfreq->normal_rate;
+		target_freq = max(target_freq, dmcfreq->info.bw_req_rate);
 		if (target_freq)
 			*freq = target_freq;
 		if (dmcfreq->info.auto_freq_en && !devfreq_update_stats(df))
@@ -2968,6 +2976,12 @@ static void rockchip_dmcfreq_parse_dt(struct rockchip_dmcfreq *dmcfreq)
 	if (rockchip_get_rl_map_talbe(np, "vop-pn-msch-readlatency",
 				      &dmcfreq->info.vop_pn_rl_tbl))
 		dev_err(dev, "failed to get vop pn to msch rl\n");
+	if (rockchip_get_freq_map_talbe(np, "bw-demand-dmc-freq",
+					&dmcfreq->info.bw_demand_tbl))
+		dev_dbg(dev, "failed to get bandwidth demand to dmc rate\n");
+	dmcfreq->info.bw_demand_margin = 20;
+	of_property_read_u32(np, "bw-demand-margin",
+			     &dmcfreq->info.bw_demand_margin);
 
 	of_property_read_u32(np, "touchboost_duration",
 			     (u32 *)&dmcfreq->touchboostpulse_duration_val);
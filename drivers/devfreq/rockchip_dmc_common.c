@@ -16,6 +16,8 @@
 
 static struct dmcfreq_common_info *common_info;
 static DECLARE_RWSEM(rockchip_dmcfreq_sem);
+static LIST_HEAD(bw_request_list);
+static DEFINE_MUTEX(bw_request_lock);
 
 void rockchip_dmcfreq_lock(void)
 {
@@ -66,11 +68,51 @@ static void set_msch_rl_work(struct work_struct *work)
 	common_info->is_msch_rl_work_started = false;
 }
 
+static void bw_request_update_rate(void)
+{
+	struct dmcfreq_bw_request *req;
+	unsigned long last_rate, target = 0;
+	unsigned int total = 0;
+	int i;
+
+	lockdep_assert_held(&bw_request_lock);
+
+	if (!common_info || !common_info->bw_demand_tbl)
+		return;
+
+	list_for_each_entry(req, &bw_request_list, node)
+		total += req->mbyte;
+	total += total * common_info->bw_demand_margin / 100;
+
+	if (total) {
+		for (i = 0; common_info->bw_demand_tbl[i].freq != DMCFREQ_TABLE_END; i++) {
+			target = common_info->bw_demand_tbl[i].freq;
+			if (total <= common_info->bw_demand_tbl[i].max)
+				break;
+		}
+	}
+
+	dev_dbg(common_info->dev, "bw demand=%uMB/s, rate=%lu\n", total, target);
+
+	last_rate = common_info->bw_req_rate;
+	common_info->bw_req_rate = target;
+	if (target != last_rate) {
+		mutex_lock(&common_info->devfreq->lock);
+		update_devfreq(common_info->devfreq);
+		mutex_unlock(&common_info->devfreq->lock);
+	}
+}
+
 int rockchip_dmcfreq_vop_bandwidth_init(struct dmcfreq_common_info *info)
 {
 	if (info->set_msch_readlatency)
 		INIT_DELAYED_WORK(&info->msch_rl_work, set_msch_rl_work);
+
+	mutex_lock(&bw_request_lock);
 	common_info = info;
+	/* requests may be declared before the dmc is probed */
+	bw_request_update_rate();
+	mutex_unlock(&bw_request_lock);
 
 	return 0;
 }
@@ -163,6 +205,52 @@ int rockchip_dmcfreq_vop_bandwidth_request(struct dmcfreq_vop_info *vop_info)
 }
 EXPORT_SYMBOL(rockchip_dmcfreq_vop_bandwidth_request);
 
+void rockchip_dmcfreq_bw_request_add(struct dmcfreq_bw_request *req,
+				     const char *name)
+{
+	if (WARN_ON(req->active))
+		return;
+
+	mutex_lock(&bw_request_lock);
+	req->name = name;
+	req->mbyte = 0;
+	req->active = true;
+	list_add_tail(&req->node, &bw_request_list);
+	mutex_unlock(&bw_request_lock);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_bw_request_add);
+
+void rockchip_dmcfreq_bw_request_update(struct dmcfreq_bw_request *req,
+					unsigned int mbyte)
+{
+	if (WARN_ON(!req->active))
+		return;
+
+	mutex_lock(&bw_request_lock);
+	if (req->mbyte != mbyte) {
+		req->mbyte = mbyte;
+		bw_request_update_rate();
+	}
+	mutex_unlock(&bw_request_lock);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_bw_request_update);
+
+void rockchip_dmcfreq_bw_request_remove(struct dmcfreq_bw_request *req)
+{
+	if (!req->active)
+		return;
+
+	mutex_lock(&bw_request_lock);
+	list_del(&req->node);
+	req->active = false;
+	if (req->mbyte) {
+		req->mbyte = 0;
+		bw_request_update_rate();
+	}
+	mutex_unlock(&bw_request_lock);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_bw_request_remove);
+
 MODULE_AUTHOR("Finley Xiao <finley.xiao@rock-chips.com>");
 MODULE_DESCRIPTION("rockchip dmcfreq driver with devfreq framework");
 MODULE_LICENSE("GPL v2");
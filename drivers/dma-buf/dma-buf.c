@@ -24,6 +24,7 @@
 #include <linux/dma-resv.h>
 #include <linux/mm.h>
 #include <linux/mount.h>
+#include <linux/notifier.h>
 #include <linux/pseudo_fs.h>
 #include <linux/sched/task.h>
 
@@ -66,6 +67,138 @@ EXPORT_SYMBOL_GPL(get_each_dmabuf);
 #if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
 static size_t db_total_size;
 static size_t db_peak_size;
+static size_t db_budget;
+/* the budget notifier fired and total did not drop below it since */
+static bool db_over_budget;
+/* live sizes per exporting process and per exporter, with db_list.lock */
+static LIST_HEAD(db_acct_procs);
+static LIST_HEAD(db_acct_exps);
+static BLOCKING_NOTIFIER_HEAD(db_budget_chain);
+
+static struct dma_buf_acct *dma_buf_acct_get(struct list_head *list,
+					     pid_t tgid, const char *name)
+{
+	struct dma_buf_acct *acct;
+
+	list_for_each_entry(acct, list, node) {
+		if (tgid ? acct->tgid == tgid : !strcmp(acct->name, name))
+			return acct;
+	}
+
+	acct = kzalloc(sizeof(*acct), GFP_KERNEL);
+	if (!acct)
+		return NULL;
+	acct->tgid = tgid;
+	strscpy(acct->name, name, sizeof(acct->name));
+	list_add_tail(&acct->node, list);
+
+	return acct;
+}
+
+static void dma_buf_acct_add(struct dma_buf_acct *acct, size_t size)
+{
+	if (!acct)
+		return;
+	acct->count++;
+	acct->size += size;
+	acct->peak = max(acct->size, acct->peak);
+}
+
+static void dma_buf_acct_sub(struct dma_buf_acct *acct, size_t size)
+{
+	if (!acct)
+		return;
+	acct->size -= size;
+	/* processes come and go, exporters stay */
+	if (!--acct->count && acct->tgid) {
+		list_del(&acct->node);
+		kfree(acct);
+	}
+}
+
+/* with db_list.lock held, true when the budget notifier has to run */
+static bool dma_buf_charge(struct dma_buf *dmabuf)
+{
+	char comm[TASK_COMM_LEN];
+
+	get_task_comm(comm, current->group_leader);
+	dmabuf->acct_proc = dma_buf_acct_get(&db_acct_procs, current->tgid,
+					     comm);
+	dmabuf->acct_exp = dma_buf_acct_get(&db_acct_exps, 0,
+					    dmabuf->exp_name ?: "unknown");
+	dma_buf_acct_add(dmabuf->acct_proc, dmabuf->size);
+	dma_buf_acct_add(dmabuf->acct_exp, dmabuf->size);
+
+	db_total_size += dmabuf->size;
+	db_peak_size = max(db_total_size, db_peak_size);
+
+	if (!db_budget || db_over_budget || db_total_size <= db_budget)
+		return false;
+	db_over_budget = true;
+
+	return true;
+}
+
+static void dma_buf_uncharge(struct dma_buf *dmabuf)
+{
+	dma_buf_acct_sub(dmabuf->acct_proc, dmabuf->size);
+	dma_buf_acct_sub(dmabuf->acct_exp, dmabuf->size);
+	dmabuf->acct_proc = NULL;
+	dmabuf->acct_exp = NULL;
+
+	db_total_size -= dmabuf->size;
+	if (db_total_size <= db_budget)
+		db_over_budget = false;
+}
+
+void dma_buf_show_acct(struct seq_file *s, bool exporters)
+{
+	struct dma_buf_acct *acct;
+
+	mutex_lock(&db_list.lock);
+	list_for_each_entry(acct, exporters ? &db_acct_exps : &db_acct_procs,
+			    node) {
+		if (exporters)
+			seq_printf(s, "%-16s", acct->name);
+		else
+			seq_printf(s, "%-16s %7d", acct->name, acct->tgid);
+		seq_printf(s, " %6u %10zu KiB %10zu KiB\n", acct->count,
+			   acct->size >> 10, acct->peak >> 10);
+	}
+	mutex_unlock(&db_list.lock);
+}
+EXPORT_SYMBOL_GPL(dma_buf_show_acct);
+
+/*
+ * the budget notifier chain runs once each time the total size of the
+ * dmabufs rises above budget, from the exporting process.
+ */
+void dma_buf_set_budget(size_t budget)
+{
+	mutex_lock(&db_list.lock);
+	db_budget = budget;
+	db_over_budget = budget && db_total_size > budget;
+	mutex_unlock(&db_list.lock);
+}
+EXPORT_SYMBOL_GPL(dma_buf_set_budget);
+
+size_t dma_buf_get_budget(void)
+{
+	return READ_ONCE(db_budget);
+}
+EXPORT_SYMBOL_GPL(dma_buf_get_budget);
+
+int dma_buf_register_budget_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_register(&db_budget_chain, nb);
+}
+EXPORT_SYMBOL_GPL(dma_buf_register_budget_notifier);
+
+int dma_buf_unregister_budget_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_unregister(&db_budget_chain, nb);
+}
+EXPORT_SYMBOL_GPL(dma_buf_unregister_budget_notifier);
 
 void dma_buf_reset_peak_size(void)
 {
@@ -168,7 +301,7 @@ static int dma_buf_file_release(struct inode *inode, struct file *file)
 
 	mutex_lock(&db_list.lock);
 #if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
-	db_total_size -= dmabuf->size;
+	dma_buf_uncharge(dmabuf);
 #endif
 	list_del(&dmabuf->list_node);
 	mutex_unlock(&db_list.lock);
@@ -672,6 +805,10 @@ struct dma_buf *dma_buf_export(const struct dma_buf_export_info *exp_info)
 	struct dma_resv *resv = exp_info->resv;
 	struct file *file;
 	size_t alloc_size = sizeof(struct dma_buf);
+#if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
+	bool over_budget;
+	size_t total;
+#endif
 	int ret;
 
 	if (!exp_info->resv)
@@ -738,11 +875,18 @@ struct dma_buf *dma_buf_export(const struct dma_buf_export_info *exp_info)
 	mutex_lock(&db_list.lock);
 	list_add(&dmabuf->list_node, &db_list.head);
 #if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
-	db_total_size += dmabuf->size;
-	db_peak_size = max(db_total_size, db_peak_size);
+	over_budget = dma_buf_charge(dmabuf);
+	total = db_total_size;
 #endif
 	mutex_unlock(&db_list.lock);
 
+#if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
+	if (over_budget)
+		blocking_notifier_call_chain(&db_budget_chain,
+					     DMA_BUF_BUDGET_EXCEEDED,
+					     (void *)total);
+#endif
+
 	ret = dma_buf_stats_setup(dmabuf);
 	if (ret)
 		goto err_sysfs;
@@ -22,16 +22,99 @@
 #include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/scatterlist.h>
+#include <linux/shrinker.h>
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 #include <uapi/linux/rk-dma-heap.h>
 #include <linux/proc_fs.h>
 #include "../../../mm/cma.h"
 #include "rk-dma-heap.h"
 
+/* frame buffers of a pipeline come in a few sizes */
+#define RK_CMA_POOL_CLASSES	8
+
+static unsigned int pool_max_mb = 128;
+module_param(pool_max_mb, uint, 0644);
+MODULE_PARM_DESC(pool_max_mb, "Max freed buffers kept by the pool heap in MiB");
+
+static unsigned int topdown_kb = 4096;
+module_param(topdown_kb, uint, 0644);
+MODULE_PARM_DESC(topdown_kb, "Buffers placed from the top of the cma area from this size in KiB, 0 disables");
+
+static unsigned int compact_idle_ms = 3000;
+module_param(compact_idle_ms, uint, 0644);
+MODULE_PARM_DESC(compact_idle_ms, "Idle time of the heaps before the cma area is compacted in ms, 0 disables");
+
+static unsigned int compact_mb = 64;
+module_param(compact_mb, uint, 0644);
+MODULE_PARM_DESC(compact_mb, "Top part of the cma area the compaction keeps free of movable pages in MiB");
+
+/* log2 ms buckets, the last one takes everything from 1s on */
+#define RK_CMA_LAT_BUCKETS	12
+
+/*
+ * freed buffers of one size. clean ones were zeroed by the pool worker,
+ * dirty ones wait for it. the buffers are linked through page->lru of
+ * their first cma page.
+ */
+struct rk_cma_pool_class {
+	pgoff_t pagecount;
+	struct list_head clean;
+	struct list_head dirty;
+	unsigned int nr_clean;
+	unsigned int nr_dirty;
+	/* being zeroed by the worker */
+	unsigned int nr_busy;
+};
+
+struct rk_cma_pool {
+	struct cma *cma;
+	struct mutex lock;
+	struct rk_cma_pool_class class[RK_CMA_POOL_CLASSES];
+	/* pages of all the pooled buffers */
+	unsigned long pages;
+	struct work_struct zero_work;
+	struct shrinker shrinker;
+	bool has_shrinker;
+
+	u64 hits;
+	u64 misses;
+	u64 dropped;
+};
+
+/*
+ * placement and compaction of the cma area the heaps share. cma_alloc()
+ * fills the area from the bottom, the large media buffers are placed
+ * from the top instead, so the small ones do not split the room they
+ * need. the free cma pages meanwhile hold movable pages, e.g. pagecache,
+ * which a large allocation must migrate first. once the heaps have been
+ * idle for a while, the worker migrates them out of the top of the area,
+ * where the next large buffer lands.
+ */
+struct rk_cma_area {
+	struct cma *cma;
+	struct delayed_work compact_work;
+	/* allocations and frees, a compaction run stops when it moves */
+	atomic_t seq;
+	/* held over the pageblock the worker has claimed */
+	struct mutex compact_lock;
+	spinlock_t lock;
+
+	u64 lat[RK_CMA_LAT_BUCKETS];
+	u64 lat_max_us;
+	u64 topdown;
+	u64 topdown_fallback;
+	u64 compact_runs;
+	u64 compact_migrated;
+};
+
+static struct rk_cma_area rk_cma_area;
+
 struct rk_cma_heap {
 	struct rk_dma_heap *heap;
 	struct cma *cma;
+	struct rk_cma_pool *pool;
 };
 
 struct rk_cma_heap_buffer {
@@ -381,6 +464,454 @@ static int rk_cma_heap_add_contig_list(struct rk_dma_heap *heap,
 	return 0;
 }
 
+static void rk_cma_area_kick(void)
+{
+	unsigned int idle_ms = READ_ONCE(compact_idle_ms);
+
+	atomic_inc(&rk_cma_area.seq);
+	if (idle_ms && rk_cma_area.cma)
+		mod_delayed_work(system_unbound_wq, &rk_cma_area.compact_work,
+				 msecs_to_jiffies(idle_ms));
+}
+
+/* highest free area of bits below end, aligned like cma_alloc() does */
+static unsigned long rk_cma_find_top(struct cma *cma, unsigned long end,
+				     unsigned long bits, unsigned long mask,
+				     unsigned long offset)
+{
+	unsigned long no, next;
+
+	while (end >= bits + offset) {
+		no = ((end - bits - offset) & ~mask) + offset;
+		next = find_next_bit(cma->bitmap, no + bits, no);
+		if (next >= no + bits)
+			return no;
+		end = next;
+	}
+
+	return ULONG_MAX;
+}
+
+/*
+ * cma_alloc() from the top of the area. the range is claimed in the
+ * bitmap like cma_alloc() does, so cma_release() frees it as usual.
+ */
+static struct page *rk_cma_alloc_topdown(struct cma *cma, pgoff_t count,
+					 unsigned int align)
+{
+	unsigned long mask, offset, bits, end, no, pfn;
+	struct acr_info info = {0};
+	int ret;
+
+	mask = align > cma->order_per_bit ?
+	       (1UL << (align - cma->order_per_bit)) - 1 : 0;
+	offset = (ALIGN(cma->base_pfn, 1UL << align) - cma->base_pfn) >>
+		 cma->order_per_bit;
+	bits = ALIGN(count, 1UL << cma->order_per_bit) >> cma->order_per_bit;
+	end = cma_bitmap_maxno(cma);
+
+	for (;;) {
+		mutex_lock(&cma->lock);
+		no = rk_cma_find_top(cma, end, bits, mask, offset);
+		if (no == ULONG_MAX) {
+			mutex_unlock(&cma->lock);
+			return NULL;
+		}
+		bitmap_set(cma->bitmap, no, bits);
+		mutex_unlock(&cma->lock);
+
+		pfn = cma->base_pfn + (no << cma->order_per_bit);
+		ret = alloc_contig_range(pfn, pfn + count, MIGRATE_CMA,
+					 GFP_KERNEL | __GFP_NOWARN, &info);
+		if (!ret)
+			return pfn_to_page(pfn);
+
+		mutex_lock(&cma->lock);
+		bitmap_clear(cma->bitmap, no, bits);
+		mutex_unlock(&cma->lock);
+
+		/* pinned pages in the way, one alignment step lower */
+		if (ret != -EBUSY || no + bits <= mask + 1)
+			return NULL;
+		end = no + bits - mask - 1;
+	}
+}
+
+static void rk_cma_area_account(s64 us)
+{
+	u64 ms = div_u64(us, USEC_PER_MSEC);
+	int i = ms ? min_t(int, fls64(ms), RK_CMA_LAT_BUCKETS - 1) : 0;
+
+	spin_lock(&rk_cma_area.lock);
+	rk_cma_area.lat[i]++;
+	if (us > rk_cma_area.lat_max_us)
+		rk_cma_area.lat_max_us = us;
+	spin_unlock(&rk_cma_area.lock);
+}
+
+static struct page *rk_cma_heap_cma_alloc(struct cma *cma, pgoff_t pagecount,
+					  unsigned int align)
+{
+	unsigned long topdown = READ_ONCE(topdown_kb) >> (PAGE_SHIFT - 10);
+	ktime_t start = ktime_get();
+	struct page *page = NULL;
+	bool fallback = false;
+
+	/* stop a compaction run first */
+	rk_cma_area_kick();
+	if (topdown && pagecount >= topdown && cma == rk_cma_area.cma) {
+		page = rk_cma_alloc_topdown(cma, pagecount, align);
+		fallback = !page;
+	}
+	if (!page)
+		page = cma_alloc(cma, pagecount, align, GFP_KERNEL);
+	/* the pageblock the worker held may be just what was missing */
+	if (!page && cma == rk_cma_area.cma && READ_ONCE(compact_idle_ms)) {
+		mutex_lock(&rk_cma_area.compact_lock);
+		mutex_unlock(&rk_cma_area.compact_lock);
+		page = cma_alloc(cma, pagecount, align, GFP_KERNEL);
+	}
+
+	rk_cma_area_account(ktime_us_delta(ktime_get(), start));
+	if (topdown && pagecount >= topdown) {
+		spin_lock(&rk_cma_area.lock);
+		if (fallback)
+			rk_cma_area.topdown_fallback++;
+		else
+			rk_cma_area.topdown++;
+		spin_unlock(&rk_cma_area.lock);
+	}
+
+	return page;
+}
+
+static void rk_cma_heap_cma_release(struct cma *cma, struct page *page,
+				    pgoff_t pagecount)
+{
+	cma_release(cma, page, pagecount);
+	rk_cma_area_kick();
+}
+
+/*
+ * migrate the movable pages out of the free pageblocks at the top of the
+ * area. each pageblock is claimed, allocated and freed again at once; it
+ * goes back to the buddy free of movable pages, so the next cma_alloc()
+ * of it only isolates it.
+ */
+static void rk_cma_area_compact_work(struct work_struct *work)
+{
+	struct cma *cma = rk_cma_area.cma;
+	unsigned long bits, low, no, pfn, count = pageblock_nr_pages;
+	unsigned long migrated = 0;
+	int seq = atomic_read(&rk_cma_area.seq);
+	struct acr_info info;
+
+	if (count < (1UL << cma->order_per_bit))
+		count = 1UL << cma->order_per_bit;
+	bits = count >> cma->order_per_bit;
+	low = ((unsigned long)READ_ONCE(compact_mb) << (20 - PAGE_SHIFT)) >>
+	      cma->order_per_bit;
+	no = cma_bitmap_maxno(cma);
+	low = no > low ? no - low : 0;
+
+	while (no >= low + bits) {
+		/* the heaps are busy again */
+		if (atomic_read(&rk_cma_area.seq) != seq)
+			break;
+
+		no -= bits;
+		mutex_lock(&rk_cma_area.compact_lock);
+		mutex_lock(&cma->lock);
+		if (find_next_bit(cma->bitmap, no + bits, no) < no + bits) {
+			mutex_unlock(&cma->lock);
+			mutex_unlock(&rk_cma_area.compact_lock);
+			continue;
+		}
+		bitmap_set(cma->bitmap, no, bits);
+		mutex_unlock(&cma->lock);
+
+		memset(&info, 0, sizeof(info));
+		pfn = cma->base_pfn + (no << cma->order_per_bit);
+		if (!alloc_contig_range(pfn, pfn + count, MIGRATE_CMA,
+					GFP_KERNEL | __GFP_NOWARN, &info)) {
+			free_contig_range(pfn, count);
+			migrated += info.nr_migrated;
+		}
+
+		mutex_lock(&cma->lock);
+		bitmap_clear(cma->bitmap, no, bits);
+		mutex_unlock(&cma->lock);
+		mutex_unlock(&rk_cma_area.compact_lock);
+		cond_resched();
+	}
+
+	spin_lock(&rk_cma_area.lock);
+	rk_cma_area.compact_runs++;
+	rk_cma_area.compact_migrated += migrated;
+	spin_unlock(&rk_cma_area.lock);
+}
+
+static int rk_cma_area_procfs_show(struct seq_file *s, void *private)
+{
+	int i;
+
+	spin_lock(&rk_cma_area.lock);
+	seq_puts(s, "alloc latency:\n");
+	for (i = 0; i < RK_CMA_LAT_BUCKETS; i++) {
+		if (!i)
+			seq_printf(s, "\t   < 1 ms: %llu\n", rk_cma_area.lat[i]);
+		else if (i == RK_CMA_LAT_BUCKETS - 1)
+			seq_printf(s, "\t>= %4u ms: %llu\n", 1U << (i - 1),
+				   rk_cma_area.lat[i]);
+		else
+			seq_printf(s, "\t < %4u ms: %llu\n", 1U << i,
+				   rk_cma_area.lat[i]);
+	}
+	seq_printf(s, "max: %llu us\n", rk_cma_area.lat_max_us);
+	seq_printf(s, "topdown: %llu fallback: %llu, from %u KiB\n",
+		   rk_cma_area.topdown, rk_cma_area.topdown_fallback,
+		   READ_ONCE(topdown_kb));
+	seq_printf(s, "compaction runs: %llu migrated: %llu pages, top %u MiB after %u ms idle\n",
+		   rk_cma_area.compact_runs, rk_cma_area.compact_migrated,
+		   READ_ONCE(compact_mb), READ_ONCE(compact_idle_ms));
+	spin_unlock(&rk_cma_area.lock);
+
+	return 0;
+}
+
+static int rk_cma_heap_clear_pages(struct page *pages, pgoff_t pagecount,
+				   bool killable)
+{
+	/* Clear the cma pages */
+	if (PageHighMem(pages)) {
+		unsigned long nr_clear_pages = pagecount;
+		struct page *page = pages;
+
+		while (nr_clear_pages > 0) {
+			void *vaddr = kmap_atomic(page);
+
+			memset(vaddr, 0, PAGE_SIZE);
+			kunmap_atomic(vaddr);
+			/*
+			 * Avoid wasting time zeroing memory if the process
+			 * has been killed by SIGKILL
+			 */
+			if (killable && fatal_signal_pending(current))
+				return -EINTR;
+			page++;
+			nr_clear_pages--;
+		}
+	} else {
+		memset(page_address(pages), 0, pagecount << PAGE_SHIFT);
+	}
+
+	return 0;
+}
+
+static struct rk_cma_pool_class *rk_cma_pool_class(struct rk_cma_pool *pool,
+						   pgoff_t pagecount,
+						   bool create)
+{
+	struct rk_cma_pool_class *class, *empty = NULL;
+	int i;
+
+	for (i = 0; i < RK_CMA_POOL_CLASSES; i++) {
+		class = &pool->class[i];
+		if (class->pagecount == pagecount)
+			return class;
+		if (!empty && !class->nr_clean && !class->nr_dirty &&
+		    !class->nr_busy)
+			empty = class;
+	}
+
+	/* recycle a drained class for the new size */
+	if (create && empty)
+		empty->pagecount = pagecount;
+
+	return create ? empty : NULL;
+}
+
+/* a zeroed buffer of pagecount pages from the pool, NULL if there is none */
+static struct page *rk_cma_pool_get(struct rk_cma_heap *cma_heap,
+				    pgoff_t pagecount)
+{
+	struct rk_cma_pool *pool = cma_heap->pool;
+	struct rk_cma_pool_class *class;
+	struct page *page = NULL;
+	bool dirty = false;
+
+	mutex_lock(&pool->lock);
+	class = rk_cma_pool_class(pool, pagecount, false);
+	if (class && class->nr_clean) {
+		page = list_first_entry(&class->clean, struct page, lru);
+		class->nr_clean--;
+	} else if (class && class->nr_dirty) {
+		page = list_first_entry(&class->dirty, struct page, lru);
+		class->nr_dirty--;
+		dirty = true;
+	}
+	if (page) {
+		list_del(&page->lru);
+		pool->pages -= pagecount;
+		pool->hits++;
+	} else {
+		pool->misses++;
+	}
+	mutex_unlock(&pool->lock);
+
+	/* the worker did not get to it yet */
+	if (page && dirty && rk_cma_heap_clear_pages(page, pagecount, true)) {
+		rk_cma_heap_cma_release(cma_heap->cma, page, pagecount);
+		return ERR_PTR(-EINTR);
+	}
+
+	return page;
+}
+
+/* keep a freed buffer for the next allocation of its size */
+static bool rk_cma_pool_put(struct rk_cma_heap *cma_heap, struct page *page,
+			    pgoff_t pagecount)
+{
+	struct rk_cma_pool *pool = cma_heap->pool;
+	unsigned long max_pages = (unsigned long)READ_ONCE(pool_max_mb) <<
+				  (20 - PAGE_SHIFT);
+	struct rk_cma_pool_class *class;
+
+	mutex_lock(&pool->lock);
+	class = rk_cma_pool_class(pool, pagecount, true);
+	if (!class || pool->pages + pagecount > max_pages) {
+		pool->dropped++;
+		mutex_unlock(&pool->lock);
+		return false;
+	}
+	list_add_tail(&page->lru, &class->dirty);
+	class->nr_dirty++;
+	pool->pages += pagecount;
+	mutex_unlock(&pool->lock);
+
+	queue_work(system_unbound_wq, &pool->zero_work);
+
+	return true;
+}
+
+static void rk_cma_pool_zero_work(struct work_struct *work)
+{
+	struct rk_cma_pool *pool = container_of(work, struct rk_cma_pool,
+						zero_work);
+	struct rk_cma_pool_class *class;
+	struct page *page;
+	int i;
+
+	for (;;) {
+		page = NULL;
+		mutex_lock(&pool->lock);
+		for (i = 0; i < RK_CMA_POOL_CLASSES; i++) {
+			class = &pool->class[i];
+			if (!class->nr_dirty)
+				continue;
+			page = list_first_entry(&class->dirty, struct page, lru);
+			/* off the lists while zeroed, so nobody takes it */
+			list_del(&page->lru);
+			class->nr_dirty--;
+			class->nr_busy++;
+			break;
+		}
+		mutex_unlock(&pool->lock);
+		if (!page)
+			return;
+
+		rk_cma_heap_clear_pages(page, class->pagecount, false);
+
+		mutex_lock(&pool->lock);
+		list_add_tail(&page->lru, &class->clean);
+		class->nr_clean++;
+		class->nr_busy--;
+		mutex_unlock(&pool->lock);
+		cond_resched();
+	}
+}
+
+static unsigned long rk_cma_pool_count(struct shrinker *shrinker,
+				       struct shrink_control *sc)
+{
+	struct rk_cma_pool *pool = container_of(shrinker, struct rk_cma_pool,
+						shrinker);
+	unsigned long pages = READ_ONCE(pool->pages);
+
+	return pages ? pages : SHRINK_EMPTY;
+}
+
+static unsigned long rk_cma_pool_scan(struct shrinker *shrinker,
+				      struct shrink_control *sc)
+{
+	struct rk_cma_pool *pool = container_of(shrinker, struct rk_cma_pool,
+						shrinker);
+	struct rk_cma_pool_class *class;
+	unsigned long freed = 0;
+	struct list_head *list;
+	struct page *page;
+	int i;
+
+	if (!mutex_trylock(&pool->lock))
+		return SHRINK_STOP;
+
+	/* dirty buffers first, they are not worth zeroing any more */
+	for (i = 0; i < RK_CMA_POOL_CLASSES * 2 && freed < sc->nr_to_scan; ) {
+		class = &pool->class[i % RK_CMA_POOL_CLASSES];
+		list = i < RK_CMA_POOL_CLASSES ? &class->dirty : &class->clean;
+		if (list_empty(list)) {
+			i++;
+			continue;
+		}
+		page = list_first_entry(list, struct page, lru);
+		list_del(&page->lru);
+		if (list == &class->dirty)
+			class->nr_dirty--;
+		else
+			class->nr_clean--;
+		pool->pages -= class->pagecount;
+		freed += class->pagecount;
+		rk_cma_heap_cma_release(pool->cma, page, class->pagecount);
+	}
+	mutex_unlock(&pool->lock);
+
+	return freed;
+}
+
+static long rk_cma_heap_get_pool_size(struct rk_dma_heap *heap)
+{
+	struct rk_cma_heap *cma_heap = rk_dma_heap_get_drvdata(heap);
+
+	if (!cma_heap->pool)
+		return 0;
+
+	return READ_ONCE(cma_heap->pool->pages) << PAGE_SHIFT;
+}
+
+static int rk_cma_pool_procfs_show(struct seq_file *s, void *private)
+{
+	struct rk_cma_pool *pool = s->private;
+	struct rk_cma_pool_class *class;
+	int i;
+
+	mutex_lock(&pool->lock);
+	seq_printf(s, "Pool: %lu KiB, max %u MiB\n",
+		   pool->pages << (PAGE_SHIFT - 10), READ_ONCE(pool_max_mb));
+	seq_printf(s, "hits: %llu misses: %llu dropped: %llu\n",
+		   pool->hits, pool->misses, pool->dropped);
+	for (i = 0; i < RK_CMA_POOL_CLASSES; i++) {
+		class = &pool->class[i];
+		if (!class->nr_clean && !class->nr_dirty)
+			continue;
+		seq_printf(s, "\t%8lu KiB: clean %u dirty %u\n",
+			   class->pagecount << (PAGE_SHIFT - 10),
+			   class->nr_clean, class->nr_dirty);
+	}
+	mutex_unlock(&pool->lock);
+
+	return 0;
+}
+
 static void rk_cma_heap_dma_buf_release(struct dma_buf *dmabuf)
 {
 	struct rk_cma_heap_buffer *buffer = dmabuf->priv;
@@ -397,7 +928,10 @@ static void rk_cma_heap_dma_buf_release(struct dma_buf *dmabuf)
 	/* free page list */
 	kfree(buffer->pages);
 	/* release memory */
-	cma_release(cma_heap->cma, buffer->cma_pages, buffer->pagecount);
+	if (!cma_heap->pool ||
+	    !rk_cma_pool_put(cma_heap, buffer->cma_pages, buffer->pagecount))
+		rk_cma_heap_cma_release(cma_heap->cma, buffer->cma_pages,
+					buffer->pagecount);
 	rk_dma_heap_total_dec(heap, buffer->len);
 
 	kfree(buffer);
@@ -447,31 +981,19 @@ static struct dma_buf *rk_cma_heap_allocate(struct rk_dma_heap *heap,
 	if (align > CONFIG_DMABUF_HEAPS_ROCKCHIP_CMA_ALIGNMENT)
 		align = CONFIG_DMABUF_HEAPS_ROCKCHIP_CMA_ALIGNMENT;
 
-	cma_pages = cma_alloc(cma_heap->cma, pagecount, align, GFP_KERNEL);
-	if (!cma_pages)
+	cma_pages = cma_heap->pool ? rk_cma_pool_get(cma_heap, pagecount) : NULL;
+	if (IS_ERR(cma_pages)) {
+		ret = PTR_ERR(cma_pages);
 		goto free_buffer;
-
-	/* Clear the cma pages */
-	if (PageHighMem(cma_pages)) {
-		unsigned long nr_clear_pages = pagecount;
-		struct page *page = cma_pages;
-
-		while (nr_clear_pages > 0) {
-			void *vaddr = kmap_atomic(page);
-
-			memset(vaddr, 0, PAGE_SIZE);
-			kunmap_atomic(vaddr);
-			/*
-			 * Avoid wasting time zeroing memory if the process
-			 * has been killed by SIGKILL
-			 */
-			if (fatal_signal_pending(current))
-				goto free_cma;
-			page++;
-			nr_clear_pages--;
-		}
-	} else {
-		memset(page_address(cma_pages), 0, size);
+	}
+	if (!cma_pages) {
+		cma_pages = rk_cma_heap_cma_alloc(cma_heap->cma, pagecount,
+						  align);
+		if (!cma_pages)
+			goto free_buffer;
+
+		if (rk_cma_heap_clear_pages(cma_pages, pagecount, true))
+			goto free_cma;
 	}
 
 	buffer->pages = kmalloc_array(pagecount, sizeof(*buffer->pages),
@@ -518,7 +1040,7 @@ static struct dma_buf *rk_cma_heap_allocate(struct rk_dma_heap *heap,
 free_pages:
 	kfree(buffer->pages);
 free_cma:
-	cma_release(cma_heap->cma, cma_pages, pagecount);
+	rk_cma_heap_cma_release(cma_heap->cma, cma_pages, pagecount);
 free_buffer:
 	kfree(buffer);
 
@@ -538,13 +1060,13 @@ static struct page *rk_cma_heap_allocate_pages(struct rk_dma_heap *heap,
 	if (align > CONFIG_DMABUF_HEAPS_ROCKCHIP_CMA_ALIGNMENT)
 		align = CONFIG_DMABUF_HEAPS_ROCKCHIP_CMA_ALIGNMENT;
 
-	page = cma_alloc(cma_heap->cma, pagecount, align, GFP_KERNEL);
+	page = rk_cma_heap_cma_alloc(cma_heap->cma, pagecount, align);
 	if (!page)
 		return ERR_PTR(-ENOMEM);
 
 	ret = rk_cma_heap_add_contig_list(heap, page, size, name);
 	if (ret) {
-		cma_release(cma_heap->cma, page, pagecount);
+		rk_cma_heap_cma_release(cma_heap->cma, page, pagecount);
 		return ERR_PTR(-EINVAL);
 	}
 
@@ -562,7 +1084,7 @@ static void rk_cma_heap_free_pages(struct rk_dma_heap *heap,
 
 	rk_cma_heap_remove_contig_list(heap, page, name);
 
-	cma_release(cma_heap->cma, page, pagecount);
+	rk_cma_heap_cma_release(cma_heap->cma, page, pagecount);
 
 	rk_dma_heap_total_dec(heap, len);
 }
@@ -571,6 +1093,7 @@ static const struct rk_dma_heap_ops rk_cma_heap_ops = {
 	.allocate = rk_cma_heap_allocate,
 	.alloc_contig_pages = rk_cma_heap_allocate_pages,
 	.free_contig_pages = rk_cma_heap_free_pages,
+	.get_pool_size = rk_cma_heap_get_pool_size,
 };
 
 static int cma_procfs_show(struct seq_file *s, void *private);
@@ -601,18 +1124,101 @@ static int __rk_add_cma_heap(struct cma *cma, void *data)
 	if (cma_heap->heap->procfs)
 		proc_create_single_data("alloc_bitmap", 0, cma_heap->heap->procfs,
 					cma_procfs_show, cma);
+	if (cma_heap->heap->procfs && cma == rk_cma_area.cma)
+		proc_create_single_data("alloc_stats", 0, cma_heap->heap->procfs,
+					rk_cma_area_procfs_show, NULL);
 
 	return 0;
 }
 
+/*
+ * the pool heap allocates from the same cma area, but keeps the buffers
+ * freed to it in size classes and zeroes them in the background, so a
+ * stream start or mode switch reallocating its frame buffers neither
+ * migrates cma pages nor waits for the zeroing.
+ */
+static int __rk_add_cma_pool_heap(struct cma *cma)
+{
+	struct rk_cma_heap *cma_heap;
+	struct rk_cma_pool *pool;
+	struct rk_dma_heap_export_info exp_info;
+	int i, ret = -ENOMEM;
+
+	cma_heap = kzalloc(sizeof(*cma_heap), GFP_KERNEL);
+	if (!cma_heap)
+		return -ENOMEM;
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		goto free_heap;
+
+	mutex_init(&pool->lock);
+	for (i = 0; i < RK_CMA_POOL_CLASSES; i++) {
+		INIT_LIST_HEAD(&pool->class[i].clean);
+		INIT_LIST_HEAD(&pool->class[i].dirty);
+	}
+	INIT_WORK(&pool->zero_work, rk_cma_pool_zero_work);
+	pool->cma = cma;
+	cma_heap->cma = cma;
+	cma_heap->pool = pool;
+
+	exp_info.name = kasprintf(GFP_KERNEL, "%s-pool", cma_get_name(cma));
+	if (!exp_info.name)
+		goto free_pool;
+	exp_info.ops = &rk_cma_heap_ops;
+	exp_info.priv = cma_heap;
+	exp_info.support_cma = true;
+
+	cma_heap->heap = rk_dma_heap_add(&exp_info);
+	if (IS_ERR(cma_heap->heap)) {
+		ret = PTR_ERR(cma_heap->heap);
+		goto free_name;
+	}
+
+	pool->shrinker.count_objects = rk_cma_pool_count;
+	pool->shrinker.scan_objects = rk_cma_pool_scan;
+	pool->shrinker.seeks = DEFAULT_SEEKS;
+	pool->has_shrinker = !register_shrinker(&pool->shrinker);
+	if (!pool->has_shrinker)
+		pr_warn("%s: failed to register shrinker\n", exp_info.name);
+
+	if (cma_heap->heap->procfs)
+		proc_create_single_data("pool", 0, cma_heap->heap->procfs,
+					rk_cma_pool_procfs_show, pool);
+
+	return 0;
+
+free_name:
+	kfree(exp_info.name);
+free_pool:
+	kfree(pool);
+free_heap:
+	kfree(cma_heap);
+
+	return ret;
+}
+
 static int __init rk_add_default_cma_heap(void)
 {
 	struct cma *cma = rk_dma_heap_get_cma();
+	int ret;
 
 	if (WARN_ON(!cma))
 		return -EINVAL;
 
-	return __rk_add_cma_heap(cma, NULL);
+	spin_lock_init(&rk_cma_area.lock);
+	mutex_init(&rk_cma_area.compact_lock);
+	INIT_DELAYED_WORK(&rk_cma_area.compact_work, rk_cma_area_compact_work);
+	rk_cma_area.cma = cma;
+
+	ret = __rk_add_cma_heap(cma, NULL);
+	if (ret)
+		return ret;
+
+	/* the plain heap works without the pool */
+	if (__rk_add_cma_pool_heap(cma))
+		pr_warn("failed to add the cma pool heap\n");
+
+	return 0;
 }
 
 #if defined(CONFIG_VIDEO_ROCKCHIP_THUNDER_BOOT_ISP) && !defined(CONFIG_INITCALL_ASYNC)
@@ -145,89 +145,98 @@ char *sync_file_get_name(struct sync_file *sync_file, char *buf, int len)
 	return buf;
 }
 
-static int sync_file_set_fence(struct sync_file *sync_file,
-			       struct dma_fence **fences, int num_fences)
+static void add_fence(struct dma_fence **fences,
+		      int *i, struct dma_fence *fence)
 {
-	struct dma_fence_array *array;
-
-	/*
-	 * The reference for the fences in the new sync_file and held
-	 * in add_fence() during the merge procedure, so for num_fences == 1
-	 * we already own a new reference to the fence. For num_fence > 1
-	 * we own the reference of the dma_fence_array creation.
-	 */
-	if (num_fences == 1) {
-		sync_file->fence = fences[0];
-		kfree(fences);
-	} else {
-		array = dma_fence_array_create(num_fences, fences,
-					       dma_fence_context_alloc(1),
-					       1, false);
-		if (!array)
-			return -ENOMEM;
+	fences[*i] = fence;
 
-		sync_file->fence = &array->base;
+	if (!dma_fence_is_signaled(fence)) {
+		dma_fence_get(fence);
+		(*i)++;
 	}
-
-	return 0;
 }
 
-static struct dma_fence **get_fences(struct sync_file *sync_file,
-				     int *num_fences)
+static struct dma_fence **fence_get_fences(struct dma_fence **fence,
+					   int *num_fences)
 {
-	if (dma_fence_is_array(sync_file->fence)) {
-		struct dma_fence_array *array = to_dma_fence_array(sync_file->fence);
+	if (dma_fence_is_array(*fence)) {
+		struct dma_fence_array *array = to_dma_fence_array(*fence);
 
 		*num_fences = array->num_fences;
 		return array->fences;
 	}
 
 	*num_fences = 1;
-	return &sync_file->fence;
+	return fence;
 }
 
-static void add_fence(struct dma_fence **fences,
-		      int *i, struct dma_fence *fence)
+static struct dma_fence **get_fences(struct sync_file *sync_file,
+				     int *num_fences)
 {
-	fences[*i] = fence;
+	return fence_get_fences(&sync_file->fence, num_fences);
+}
 
-	if (!dma_fence_is_signaled(fence)) {
-		dma_fence_get(fence);
-		(*i)++;
+/*
+ * true when every unsignaled fence of b has a fence of the same context
+ * in a that is as late, so a merge of a and b would just be a again.
+ */
+static bool fence_covers(struct dma_fence **a_fences, int a_num_fences,
+			 struct dma_fence **b_fences, int b_num_fences)
+{
+	int i_a = 0, i_b;
+
+	for (i_b = 0; i_b < b_num_fences; i_b++) {
+		struct dma_fence *pt_b = b_fences[i_b];
+
+		while (i_a < a_num_fences &&
+		       a_fences[i_a]->context < pt_b->context)
+			i_a++;
+		if (i_a < a_num_fences &&
+		    a_fences[i_a]->context == pt_b->context &&
+		    (a_fences[i_a]->seqno == pt_b->seqno ||
+		     __dma_fence_is_later(a_fences[i_a]->seqno, pt_b->seqno,
+					  pt_b->ops)))
+			continue;
+		if (!dma_fence_is_signaled(pt_b))
+			return false;
 	}
+
+	return true;
 }
 
 /**
- * sync_file_merge() - merge two sync_files
- * @name:	name of new fence
- * @a:		sync_file a
- * @b:		sync_file b
+ * dma_fence_merge() - merge two fences without a sync_file
+ * @a:	fence a
+ * @b:	fence b
  *
- * Creates a new sync_file which contains copies of all the fences in both
- * @a and @b.  @a and @b remain valid, independent sync_file. Returns the
- * new merged sync_file or NULL in case of error.
+ * Returns a new reference to a fence that signals once both @a and @b
+ * have signaled, for drivers chaining their fences in the kernel where no
+ * fd is needed. When one of them already covers the other, as a frame
+ * fence merged again with a fence of the same stream does, that one is
+ * returned as it is and nothing is allocated. Returns NULL on error.
  */
-static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
-					 struct sync_file *b)
+struct dma_fence *dma_fence_merge(struct dma_fence *a, struct dma_fence *b)
 {
-	struct sync_file *sync_file;
-	struct dma_fence **fences = NULL, **nfences, **a_fences, **b_fences;
+	struct dma_fence **fences, **nfences, **a_fences, **b_fences;
+	struct dma_fence_array *array;
 	int i = 0, i_a, i_b, num_fences, a_num_fences, b_num_fences;
 
-	sync_file = sync_file_alloc();
-	if (!sync_file)
+	a_fences = fence_get_fences(&a, &a_num_fences);
+	b_fences = fence_get_fences(&b, &b_num_fences);
+	if (a_num_fences > INT_MAX - b_num_fences)
 		return NULL;
 
-	a_fences = get_fences(a, &a_num_fences);
-	b_fences = get_fences(b, &b_num_fences);
-	if (a_num_fences > INT_MAX - b_num_fences)
-		goto err;
+	/* reuse the fence or fence-array that does not change */
+	if (fence_covers(a_fences, a_num_fences, b_fences, b_num_fences))
+		return dma_fence_get(a);
+	if (fence_covers(b_fences, b_num_fences, a_fences, a_num_fences))
+		return dma_fence_get(b);
 
 	num_fences = a_num_fences + b_num_fences;
 
 	fences = kcalloc(num_fences, sizeof(*fences), GFP_KERNEL);
 	if (!fences)
-		goto err;
+		return NULL;
 
 	/*
 	 * Assume sync_file a and b are both ordered and have no
@@ -269,6 +278,18 @@ static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
 	if (i == 0)
 		fences[i++] = dma_fence_get(a_fences[0]);
 
+	/*
+	 * The references for the fences are held in add_fence() during the
+	 * merge, so for a single fence we already own a new reference to the
+	 * fence. For more we own the reference of the dma_fence_array creation.
+	 */
+	if (i == 1) {
+		struct dma_fence *fence = fences[0];
+
+		kfree(fences);
+		return fence;
+	}
+
 	if (num_fences > i) {
 		nfences = krealloc(fences, i * sizeof(*fences),
 				  GFP_KERNEL);
@@ -278,19 +299,48 @@ static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
 		fences = nfences;
 	}
 
-	if (sync_file_set_fence(sync_file, fences, i) < 0)
+	array = dma_fence_array_create(i, fences, dma_fence_context_alloc(1),
+				       1, false);
+	if (!array)
 		goto err;
 
-	strlcpy(sync_file->user_name, name, sizeof(sync_file->user_name));
-	return sync_file;
+	return &array->base;
 
 err:
 	while (i)
 		dma_fence_put(fences[--i]);
 	kfree(fences);
-	fput(sync_file->file);
 	return NULL;
+}
+EXPORT_SYMBOL(dma_fence_merge);
 
+/**
+ * sync_file_merge() - merge two sync_files
+ * @name:	name of new fence
+ * @a:		sync_file a
+ * @b:		sync_file b
+ *
+ * Creates a new sync_file which contains copies of all the fences in both
+ * @a and @b.  @a and @b remain valid, independent sync_file. Returns the
+ * new merged sync_file or NULL in case of error.
+ */
+static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
+					 struct sync_file *b)
+{
+	struct sync_file *sync_file;
+
+	sync_file = sync_file_alloc();
+	if (!sync_file)
+		return NULL;
+
+	sync_file->fence = dma_fence_merge(a->fence, b->fence);
+	if (!sync_file->fence) {
+		fput(sync_file->file);
+		return NULL;
+	}
+
+	strlcpy(sync_file->user_name, name, sizeof(sync_file->user_name));
+	return sync_file;
 }
 
 static int sync_file_release(struct inode *inode, struct file *file)
@@ -355,10 +355,27 @@ enum pl330_cond {
 
 struct dma_pl330_desc;
 
+/* Everything _setup_req() looks at when building a cyclic program */
+struct _pl330_mc_key {
+	u32 ccr;
+	u32 src_addr;
+	u32 dst_addr;
+	u32 bytes;
+	u32 num_periods;
+	u32 src_interlace_size;
+	u32 dst_interlace_size;
+	int ev;
+	u8 peri;
+	u8 rqtype;
+};
+
 struct _pl330_req {
 	u32 mc_bus;
 	void *mc_cpu;
 	struct dma_pl330_desc *desc;
+	/* program left in mc_cpu by the last cyclic submit */
+	struct _pl330_mc_key mc_key;
+	bool mc_valid;
 };
 
 /* ToBeDone for tasklet */
@@ -1469,7 +1486,9 @@ static int _period(struct pl330_dmac *pl330, unsigned int dry_run, u8 buf[],
 	}
 #endif
 
-	off += _emit_SEV(dry_run, &buf[off], ev);
+	/* no event per period if the client polls the residue instead */
+	if (ev >= 0)
+		off += _emit_SEV(dry_run, &buf[off], ev);
 
 	return off;
 }
@@ -1624,8 +1643,9 @@ static int _setup_req(struct pl330_dmac *pl330, unsigned dry_run,
 		/* DMAEND */
 		off += _emit_END(dry_run, &buf[off]);
 	} else {
-		off += _setup_xfer_cyclic(pl330, dry_run, &buf[off],
-					  pxs, thrd->ev);
+		off += _setup_xfer_cyclic(pl330, dry_run, &buf[off], pxs,
+					  pxs->desc->txd.flags & DMA_PREP_INTERRUPT ?
+					  thrd->ev : -1);
 	}
 
 	return off;
@@ -1668,10 +1688,32 @@ static inline u32 _prepare_ccr(const struct pl330_reqcfg *rqc)
  * Client is not notified after each xfer unit, just once after all
  * xfer units are done or some error occurs.
  */
+static void _mc_key_fill(struct _pl330_mc_key *key,
+			 struct pl330_thread *thrd,
+			 const struct _xfer_spec *pxs)
+{
+	const struct dma_pl330_desc *desc = pxs->desc;
+
+	memset(key, 0, sizeof(*key));
+	key->ccr = pxs->ccr;
+	key->src_addr = desc->px.src_addr;
+	key->dst_addr = desc->px.dst_addr;
+	key->bytes = desc->px.bytes;
+	key->num_periods = desc->num_periods;
+#ifdef CONFIG_NO_GKI
+	key->src_interlace_size = desc->src_interlace_size;
+	key->dst_interlace_size = desc->dst_interlace_size;
+#endif
+	key->ev = desc->txd.flags & DMA_PREP_INTERRUPT ? thrd->ev : -1;
+	key->peri = desc->peri;
+	key->rqtype = desc->rqtype;
+}
+
 static int pl330_submit_req(struct pl330_thread *thrd,
 	struct dma_pl330_desc *desc)
 {
 	struct pl330_dmac *pl330 = thrd->dmac;
+	struct _pl330_mc_key key;
 	struct _xfer_spec xs;
 	unsigned long flags;
 	unsigned idx;
@@ -1728,6 +1770,22 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	xs.ccr = ccr;
 	xs.desc = desc;
 
+	/*
+	 * A cyclic stream restarted with the same buffer and config, as
+	 * audio does on every start and resume, finds its program still in
+	 * the req buffer and skips the microcode generation.
+	 */
+	if (desc->cyclic) {
+		_mc_key_fill(&key, thrd, &xs);
+		if (thrd->req[idx].mc_valid &&
+		    !memcmp(&thrd->req[idx].mc_key, &key, sizeof(key))) {
+			thrd->lstenq = idx;
+			thrd->req[idx].desc = desc;
+			ret = 0;
+			goto xfer_exit;
+		}
+	}
+
 	/* First dry run to check if req is acceptable */
 	ret = _setup_req(pl330, 1, thrd, idx, &xs);
 	if (ret < 0)
@@ -1745,6 +1803,10 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	thrd->req[idx].desc = desc;
 	_setup_req(pl330, 0, thrd, idx, &xs);
 
+	thrd->req[idx].mc_valid = desc->cyclic;
+	if (desc->cyclic)
+		thrd->req[idx].mc_key = key;
+
 	ret = 0;
 
 xfer_exit:
@@ -176,6 +176,34 @@ static void rockchip_gpio_set(struct gpio_chip *gc, unsigned int offset,
 	raw_spin_unlock_irqrestore(&bank->slock, flags);
 }
 
+/*
+ * Lines of one bank set at once, a stepper motor or led matrix driver
+ * toggling several lines per tick gets one register write per half word
+ * instead of one per line. The v2 write mask leaves the other lines be.
+ */
+static void rockchip_gpio_set_multiple(struct gpio_chip *gc,
+				       unsigned long *mask,
+				       unsigned long *bits)
+{
+	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
+	void __iomem *reg = bank->reg_base + bank->gpio_regs->port_dr;
+	u32 m = mask[0], b = bits[0] & m;
+	unsigned long flags;
+	u32 data;
+
+	raw_spin_lock_irqsave(&bank->slock, flags);
+	if (bank->gpio_type == GPIO_TYPE_V2) {
+		if (m & 0xffff)
+			writel((m & 0xffff) << 16 | (b & 0xffff), reg);
+		if (m >> 16)
+			writel((m & 0xffff0000) | b >> 16, reg + 0x4);
+	} else {
+		data = readl(reg);
+		writel((data & ~m) | b, reg);
+	}
+	raw_spin_unlock_irqrestore(&bank->slock, flags);
+}
+
 static int rockchip_gpio_get(struct gpio_chip *gc, unsigned int offset)
 {
 	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
@@ -317,6 +345,7 @@ static const struct gpio_chip rockchip_gpiolib_chip = {
 	.request = gpiochip_generic_request,
 	.free = gpiochip_generic_free,
 	.set = rockchip_gpio_set,
+	.set_multiple = rockchip_gpio_set_multiple,
 	.get = rockchip_gpio_get,
 	.get_direction	= rockchip_gpio_get_direction,
 	.direction_input = rockchip_gpio_direction_input,
@@ -55,6 +55,7 @@
 #define EBC_VNUM				0x0054 //Line flag num
 #define EBC_WIN_MST2			0x0058 //Framecount memory start
 #define EBC_LUT_DATA_ADDR	0x1000 //lut data address
+#define EBC_LUT_MAX_WORDS	4096 //256 frames x 16 or 64 frames x 64
 
 #define DSP_HTOTAL(x)			UPDATE(x, 27, 16)
 #define DSP_HS_END(x)			UPDATE(x, 7, 0)
@@ -212,6 +213,9 @@ static int tcon_enable(struct ebc_tcon *tcon, struct ebc_panel *panel)
 				DSP_SWAP_MODE(panel->panel_16bit ? 2 : 3) | DSP_VCOM_MODE(1) | DSP_SDCLK_DIV(panel->panel_16bit ? 7 : 3));
 	tcon_cfg_done(tcon);
 
+	/* the lut sram does not survive a power domain off */
+	tcon->lut_valid = 0;
+
 	enable_irq(tcon->irq);
 
 	return 0;
@@ -267,9 +271,18 @@ static int tcon_lut_data_set(struct ebc_tcon *tcon, unsigned int *lut_data, int
 	else
 		lut_size = frame_count * 16;
 
+	/*
+	 * consecutive updates mostly reuse the waveform of the same mode and
+	 * temperature, only rewrite the lut words that actually changed.
+	 */
 	for (i = 0; i < lut_size; i++) {
+		if (i < tcon->lut_valid && tcon->lut_cache[i] == lut_data[i])
+			continue;
 		tcon_write(tcon, EBC_LUT_DATA_ADDR + (i * 4), lut_data[i]);
+		tcon->lut_cache[i] = lut_data[i];
 	}
+	if (lut_size > tcon->lut_valid)
+		tcon->lut_valid = lut_size;
 	tcon_cfg_done(tcon);
 
 	return 0;
@@ -339,6 +352,9 @@ static int ebc_tcon_probe(struct platform_device *pdev)
 		return PTR_ERR(tcon->regs);
 
 	tcon->len = resource_size(res);
+	tcon->lut_cache = devm_kcalloc(dev, EBC_LUT_MAX_WORDS, sizeof(u32), GFP_KERNEL);
+	if (!tcon->lut_cache)
+		return -ENOMEM;
 	ebc_regmap_config.max_register = resource_size(res) - 4;
 	ebc_regmap_config.name = "rockchip,ebc_tcon";
 	tcon->regmap_base = devm_regmap_init_mmio(dev, tcon->regs, &ebc_regmap_config);
@@ -39,6 +39,13 @@ struct ebc_tcon {
 	void (*frame_start)(struct ebc_tcon *tcon, int frame_total);
 
 	void (*dsp_end_callback)(void);
+
+	/*
+	 * shadow of the lut sram, lut_valid words of it match the hardware.
+	 * kept at the end, the prebuilt ebc core only sees the fields above.
+	 */
+	u32 *lut_cache;
+	int lut_valid;
 };
 
 static inline int ebc_tcon_enable(struct ebc_tcon *tcon, struct ebc_panel *panel)
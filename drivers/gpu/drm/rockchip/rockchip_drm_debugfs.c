@@ -11,7 +11,9 @@
 #include <drm/drm_of.h>
 #include <drm/drm_probe_helper.h>
 
+#include <linux/debugfs.h>
 #include <linux/file.h>
+#include <linux/math64.h>
 
 #include "rockchip_drm_drv.h"
 #include "rockchip_drm_debugfs.h"
@@ -216,3 +218,72 @@ int rockchip_drm_add_dump_buffer(struct drm_crtc *crtc, struct dentry *root)
 
 	return 0;
 }
+
+void rockchip_drm_update_stats_add(struct drm_crtc *crtc,
+				   enum rockchip_drm_update_path path, u64 ns)
+{
+	struct rockchip_drm_update_stats *stats;
+
+	stats = &to_rockchip_crtc(crtc)->update_stats[path];
+	stats->count++;
+	stats->total_ns += ns;
+	if (ns > stats->max_ns)
+		stats->max_ns = ns;
+}
+
+static int rockchip_drm_update_stats_show(struct seq_file *m, void *data)
+{
+	struct drm_crtc *crtc = m->private;
+	struct rockchip_crtc *rockchip_crtc = to_rockchip_crtc(crtc);
+	static const char * const names[] = { "full", "fb_only" };
+	struct rockchip_drm_update_stats *stats;
+	int i;
+
+	for (i = 0; i < ROCKCHIP_UPDATE_PATH_MAX; i++) {
+		stats = &rockchip_crtc->update_stats[i];
+		seq_printf(m, "%-8s count:%llu avg:%lluns max:%lluns\n", names[i],
+			   stats->count,
+			   stats->count ? div64_u64(stats->total_ns, stats->count) : 0,
+			   stats->max_ns);
+	}
+
+	return 0;
+}
+
+static int rockchip_drm_update_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rockchip_drm_update_stats_show, inode->i_private);
+}
+
+static ssize_t
+rockchip_drm_update_stats_write(struct file *file, const char __user *ubuf,
+				size_t len, loff_t *offp)
+{
+	struct seq_file *m = file->private_data;
+	struct rockchip_crtc *rockchip_crtc = to_rockchip_crtc(m->private);
+
+	/* any write resets the counters */
+	memset(rockchip_crtc->update_stats, 0, sizeof(rockchip_crtc->update_stats));
+
+	return len;
+}
+
+static const struct file_operations rockchip_drm_update_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = rockchip_drm_update_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+	.write = rockchip_drm_update_stats_write,
+};
+
+int rockchip_drm_add_update_stats(struct drm_crtc *crtc, struct dentry *root)
+{
+	struct rockchip_crtc *rockchip_crtc = to_rockchip_crtc(crtc);
+
+	memset(rockchip_crtc->update_stats, 0, sizeof(rockchip_crtc->update_stats));
+	debugfs_create_file("plane_update", 0644, root, crtc,
+			    &rockchip_drm_update_stats_fops);
+
+	return 0;
+}
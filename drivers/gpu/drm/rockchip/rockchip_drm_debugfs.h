@@ -52,9 +52,31 @@ enum vop_dump_status {
 	DUMP_KEEP
 };
 
+/**
+ * struct rockchip_drm_update_stats - plane update cost of one path
+ *
+ * @count: number of plane updates
+ * @total_ns: time spent in atomic_update
+ * @max_ns: the slowest single update
+ */
+struct rockchip_drm_update_stats {
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+};
+
+enum rockchip_drm_update_path {
+	ROCKCHIP_UPDATE_FULL = 0,
+	ROCKCHIP_UPDATE_FB_ONLY,
+	ROCKCHIP_UPDATE_PATH_MAX
+};
+
 #if defined(CONFIG_ROCKCHIP_DRM_DEBUG)
 int rockchip_drm_add_dump_buffer(struct drm_crtc *crtc, struct dentry *root);
 int rockchip_drm_dump_plane_buffer(struct vop_dump_info *dump_info, int frame_count);
+int rockchip_drm_add_update_stats(struct drm_crtc *crtc, struct dentry *root);
+void rockchip_drm_update_stats_add(struct drm_crtc *crtc,
+				   enum rockchip_drm_update_path path, u64 ns);
 #else
 static inline int
 rockchip_drm_add_dump_buffer(struct drm_crtc *crtc, struct dentry *root)
@@ -67,6 +89,18 @@ rockchip_drm_dump_plane_buffer(struct vop_dump_info *dump_info, int frame_count)
 {
 	return 0;
 }
+
+static inline int
+rockchip_drm_add_update_stats(struct drm_crtc *crtc, struct dentry *root)
+{
+	return 0;
+}
+
+static inline void
+rockchip_drm_update_stats_add(struct drm_crtc *crtc,
+			      enum rockchip_drm_update_path path, u64 ns)
+{
+}
 #endif
 
 #endif
@@ -4,8 +4,14 @@
  * Author: Sandy Huang <hjc@rock-chips.com>
  */
 #include <linux/dma-buf-cache.h>
+#include <linux/dma-resv.h>
 #include <linux/fdtable.h>
+#include <linux/kthread.h>
+#include <drm/drm_atomic.h>
 #include <drm/drm_atomic_uapi.h>
+#include <drm/drm_fourcc.h>
+#include <drm/drm_prime.h>
+#include <soc/rockchip/rockchip_direct_show.h>
 
 #include "../drm_internal.h"
 #include "rockchip_drm_direct_show.h"
@@ -316,3 +322,361 @@ int rockchip_drm_direct_show_disable_plane(struct drm_device *drm, struct drm_pl
 
 	return ret;
 }
+
+/* imported producer buffers, isp/cif streams run with a handful of them */
+#define DRM_DS_SINK_FB_CACHE	8
+
+struct rockchip_drm_direct_show_sink_fb {
+	struct dma_buf *dmabuf;
+	struct drm_framebuffer *fb;
+	u32 width;
+	u32 height;
+	u32 pixel_format;
+	u32 pitch;
+	u64 last_use;
+};
+
+struct rockchip_drm_direct_show_sink {
+	struct drm_device *drm;
+	struct drm_crtc *crtc;
+	struct drm_plane *plane;
+	struct rockchip_drm_direct_show_sink_cfg cfg;
+	struct kthread_worker *worker;
+	struct kthread_work flip_work;
+
+	spinlock_t lock; /* pending frame */
+	struct rockchip_drm_direct_show_frame pending;
+	bool has_pending;
+
+	/* below only touched by the worker or with it flushed */
+	struct rockchip_drm_direct_show_frame shown;
+	bool has_shown;
+	struct rockchip_drm_direct_show_sink_fb fbs[DRM_DS_SINK_FB_CACHE];
+	u64 use_seq;
+};
+
+static void rockchip_drm_direct_show_sink_release(struct rockchip_drm_direct_show_sink *sink,
+						  struct rockchip_drm_direct_show_frame *frame)
+{
+	dma_buf_put(frame->dmabuf);
+	sink->cfg.release(sink->cfg.data, frame->priv);
+}
+
+static void rockchip_drm_direct_show_sink_put_fb(struct rockchip_drm_direct_show_sink_fb *sfb)
+{
+	if (!sfb->fb)
+		return;
+	drm_framebuffer_put(sfb->fb);
+	dma_buf_put(sfb->dmabuf);
+	sfb->fb = NULL;
+	sfb->dmabuf = NULL;
+}
+
+static struct drm_framebuffer *
+rockchip_drm_direct_show_sink_get_fb(struct rockchip_drm_direct_show_sink *sink,
+				     const struct rockchip_drm_direct_show_frame *frame)
+{
+	const struct drm_format_info *info = drm_format_info(frame->pixel_format);
+	struct rockchip_drm_direct_show_sink_fb *sfb = NULL;
+	struct drm_gem_object *objs[ROCKCHIP_MAX_FB_BUFFER];
+	struct drm_mode_fb_cmd2 mode_cmd = { 0 };
+	struct drm_framebuffer *fb;
+	struct drm_gem_object *obj;
+	int i;
+
+	for (i = 0; i < DRM_DS_SINK_FB_CACHE; i++) {
+		struct rockchip_drm_direct_show_sink_fb *c = &sink->fbs[i];
+
+		if (c->fb && c->dmabuf == frame->dmabuf &&
+		    c->width == frame->width && c->height == frame->height &&
+		    c->pixel_format == frame->pixel_format &&
+		    c->pitch == frame->pitch) {
+			c->last_use = ++sink->use_seq;
+			return c->fb;
+		}
+	}
+
+	if (!info || info->num_planes > 2)
+		return ERR_PTR(-EINVAL);
+
+	/* a free slot, else the least recently used one not on screen */
+	for (i = 0; i < DRM_DS_SINK_FB_CACHE; i++) {
+		struct rockchip_drm_direct_show_sink_fb *c = &sink->fbs[i];
+
+		if (!c->fb) {
+			sfb = c;
+			break;
+		}
+		if (sink->has_shown && c->dmabuf == sink->shown.dmabuf)
+			continue;
+		if (!sfb || c->last_use < sfb->last_use)
+			sfb = c;
+	}
+	rockchip_drm_direct_show_sink_put_fb(sfb);
+
+	obj = drm_gem_prime_import(sink->drm, frame->dmabuf);
+	if (IS_ERR(obj)) {
+		DRM_DS_ERR("failed to import dmabuf, ret %ld\n", PTR_ERR(obj));
+		return ERR_CAST(obj);
+	}
+
+	mode_cmd.width = frame->width;
+	mode_cmd.height = frame->height;
+	mode_cmd.pixel_format = frame->pixel_format;
+	mode_cmd.pitches[0] = frame->pitch;
+	objs[0] = obj;
+	if (info->num_planes > 1) {
+		mode_cmd.pitches[1] = frame->pitch * info->cpp[1] / info->hsub;
+		mode_cmd.offsets[1] = frame->pitch * frame->height;
+		drm_gem_object_get(obj);
+		objs[1] = obj;
+	}
+
+	/* the fb owns the gem references from here on */
+	fb = rockchip_fb_alloc(sink->drm, &mode_cmd, objs, info->num_planes);
+	if (IS_ERR(fb)) {
+		for (i = 0; i < info->num_planes; i++)
+			drm_gem_object_put(objs[i]);
+		return fb;
+	}
+
+	get_dma_buf(frame->dmabuf);
+	sfb->dmabuf = frame->dmabuf;
+	sfb->fb = fb;
+	sfb->width = frame->width;
+	sfb->height = frame->height;
+	sfb->pixel_format = frame->pixel_format;
+	sfb->pitch = frame->pitch;
+	sfb->last_use = ++sink->use_seq;
+
+	return fb;
+}
+
+static int
+rockchip_drm_direct_show_sink_commit(struct rockchip_drm_direct_show_sink *sink,
+				     struct drm_framebuffer *fb,
+				     struct dma_fence *fence)
+{
+	struct rockchip_drm_direct_show_sink_cfg *cfg = &sink->cfg;
+	struct drm_modeset_acquire_ctx ctx;
+	struct drm_plane_state *plane_state;
+	struct drm_crtc_state *crtc_state;
+	struct drm_atomic_state *state;
+	struct drm_property *zpos_prop;
+	int ret;
+
+	state = drm_atomic_state_alloc(sink->drm);
+	if (!state)
+		return -ENOMEM;
+
+	drm_modeset_acquire_init(&ctx, 0);
+	state->acquire_ctx = &ctx;
+retry:
+	crtc_state = drm_atomic_get_crtc_state(state, sink->crtc);
+	if (IS_ERR(crtc_state)) {
+		ret = PTR_ERR(crtc_state);
+		goto out;
+	}
+
+	plane_state = drm_atomic_get_plane_state(state, sink->plane);
+	if (IS_ERR(plane_state)) {
+		ret = PTR_ERR(plane_state);
+		goto out;
+	}
+
+	ret = drm_atomic_set_crtc_for_plane(plane_state, sink->crtc);
+	if (ret)
+		goto out;
+	drm_atomic_set_fb_for_plane(plane_state, fb);
+
+	plane_state->crtc_x = cfg->dst_x;
+	plane_state->crtc_y = cfg->dst_y;
+	plane_state->crtc_w = cfg->dst_w ? cfg->dst_w : crtc_state->mode.hdisplay;
+	plane_state->crtc_h = cfg->dst_h ? cfg->dst_h : crtc_state->mode.vdisplay;
+	plane_state->src_x = 0;
+	plane_state->src_y = 0;
+	plane_state->src_w = fb->width << 16;
+	plane_state->src_h = fb->height << 16;
+	plane_state->rotation = cfg->rotation ? cfg->rotation : DRM_MODE_ROTATE_0;
+
+	if (cfg->top_zpos) {
+		zpos_prop = rockchip_drm_direct_show_find_prop(sink->drm,
+							       &sink->plane->base,
+							       "zpos");
+		if (zpos_prop)
+			plane_state->zpos = zpos_prop->values[1];
+	}
+
+	/* implicit sync: the commit waits for the producer to finish */
+	if (fence)
+		plane_state->fence = dma_fence_get(fence);
+
+	ret = drm_atomic_commit(state);
+out:
+	if (ret == -EDEADLK) {
+		drm_atomic_state_clear(state);
+		drm_modeset_backoff(&ctx);
+		goto retry;
+	}
+
+	drm_atomic_state_put(state);
+	drm_modeset_drop_locks(&ctx);
+	drm_modeset_acquire_fini(&ctx);
+
+	return ret;
+}
+
+static void rockchip_drm_direct_show_sink_flip(struct kthread_work *work)
+{
+	struct rockchip_drm_direct_show_sink *sink =
+		container_of(work, struct rockchip_drm_direct_show_sink, flip_work);
+	struct rockchip_drm_direct_show_frame frame;
+	struct drm_framebuffer *fb;
+	struct dma_fence *fence;
+	unsigned long flags;
+	int ret;
+
+	spin_lock_irqsave(&sink->lock, flags);
+	if (!sink->has_pending) {
+		spin_unlock_irqrestore(&sink->lock, flags);
+		return;
+	}
+	frame = sink->pending;
+	sink->has_pending = false;
+	spin_unlock_irqrestore(&sink->lock, flags);
+
+	fb = rockchip_drm_direct_show_sink_get_fb(sink, &frame);
+	if (IS_ERR(fb)) {
+		rockchip_drm_direct_show_sink_release(sink, &frame);
+		return;
+	}
+
+	fence = dma_resv_get_excl_rcu(frame.dmabuf->resv);
+	/* blocking commit, returns once the new frame is latched */
+	ret = rockchip_drm_direct_show_sink_commit(sink, fb, fence);
+	dma_fence_put(fence);
+	if (ret) {
+		DRM_DS_ERR("flip on plane[%s] failed, ret %d\n",
+			   sink->plane->name, ret);
+		rockchip_drm_direct_show_sink_release(sink, &frame);
+		return;
+	}
+
+	if (sink->has_shown)
+		rockchip_drm_direct_show_sink_release(sink, &sink->shown);
+	sink->shown = frame;
+	sink->has_shown = true;
+}
+
+struct rockchip_drm_direct_show_sink *
+rockchip_drm_direct_show_sink_create(const struct rockchip_drm_direct_show_sink_cfg *cfg)
+{
+	struct rockchip_drm_direct_show_sink *sink;
+	struct drm_device *drm;
+	int ret;
+
+	if (!cfg->plane_name || !cfg->release)
+		return ERR_PTR(-EINVAL);
+
+	drm = rockchip_drm_get_dev();
+	if (!drm)
+		return ERR_PTR(-EPROBE_DEFER);
+
+	sink = kzalloc(sizeof(*sink), GFP_KERNEL);
+	if (!sink)
+		return ERR_PTR(-ENOMEM);
+
+	sink->drm = drm;
+	sink->cfg = *cfg;
+	sink->cfg.crtc_name = NULL;
+	sink->cfg.plane_name = NULL;
+	spin_lock_init(&sink->lock);
+	kthread_init_work(&sink->flip_work, rockchip_drm_direct_show_sink_flip);
+
+	sink->crtc = rockchip_drm_direct_show_get_crtc(drm, cfg->crtc_name);
+	sink->plane = rockchip_drm_direct_show_get_plane(drm, cfg->plane_name);
+	if (!sink->crtc || !sink->plane) {
+		ret = -ENODEV;
+		goto err_free;
+	}
+
+	sink->worker = kthread_create_worker(0, "drm_ds_%s", sink->plane->name);
+	if (IS_ERR(sink->worker)) {
+		ret = PTR_ERR(sink->worker);
+		goto err_free;
+	}
+	sched_set_fifo(sink->worker->task);
+
+	DRM_DS_DBG("sink on plane[%s], crtc[%s]\n",
+		   sink->plane->name, sink->crtc->name);
+
+	return sink;
+
+err_free:
+	kfree(sink);
+	return ERR_PTR(ret);
+}
+EXPORT_SYMBOL_GPL(rockchip_drm_direct_show_sink_create);
+
+int rockchip_drm_direct_show_sink_queue(struct rockchip_drm_direct_show_sink *sink,
+					const struct rockchip_drm_direct_show_frame *frame)
+{
+	struct rockchip_drm_direct_show_frame dropped;
+	bool drop;
+	unsigned long flags;
+
+	get_dma_buf(frame->dmabuf);
+
+	spin_lock_irqsave(&sink->lock, flags);
+	drop = sink->has_pending;
+	dropped = sink->pending;
+	sink->pending = *frame;
+	sink->has_pending = true;
+	spin_unlock_irqrestore(&sink->lock, flags);
+
+	kthread_queue_work(sink->worker, &sink->flip_work);
+
+	if (drop)
+		rockchip_drm_direct_show_sink_release(sink, &dropped);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rockchip_drm_direct_show_sink_queue);
+
+/* take the plane down and hand every frame back, the sink stays usable */
+void rockchip_drm_direct_show_sink_flush(struct rockchip_drm_direct_show_sink *sink)
+{
+	unsigned long flags;
+	bool pending;
+	int i;
+
+	kthread_flush_work(&sink->flip_work);
+
+	spin_lock_irqsave(&sink->lock, flags);
+	pending = sink->has_pending;
+	sink->has_pending = false;
+	spin_unlock_irqrestore(&sink->lock, flags);
+	if (pending)
+		rockchip_drm_direct_show_sink_release(sink, &sink->pending);
+
+	if (sink->has_shown) {
+		rockchip_drm_direct_show_disable_plane(sink->drm, sink->plane);
+		rockchip_drm_direct_show_sink_release(sink, &sink->shown);
+		sink->has_shown = false;
+	}
+
+	for (i = 0; i < DRM_DS_SINK_FB_CACHE; i++)
+		rockchip_drm_direct_show_sink_put_fb(&sink->fbs[i]);
+}
+EXPORT_SYMBOL_GPL(rockchip_drm_direct_show_sink_flush);
+
+void rockchip_drm_direct_show_sink_destroy(struct rockchip_drm_direct_show_sink *sink)
+{
+	if (IS_ERR_OR_NULL(sink))
+		return;
+
+	rockchip_drm_direct_show_sink_flush(sink);
+	kthread_destroy_worker(sink->worker);
+	kfree(sink);
+}
+EXPORT_SYMBOL_GPL(rockchip_drm_direct_show_sink_destroy);
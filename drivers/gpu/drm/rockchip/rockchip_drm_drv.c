@@ -1228,6 +1228,16 @@ static int rockchip_drm_mm_dump(struct seq_file *s, void *data)
 	return 0;
 }
 
+static int rockchip_drm_gem_cache_show(struct seq_file *s, void *data)
+{
+	struct drm_info_node *node = s->private;
+	struct drm_minor *minor = node->minor;
+
+	rockchip_gem_cache_show(minor->dev, s);
+
+	return 0;
+}
+
 static int rockchip_drm_summary_show(struct seq_file *s, void *data)
 {
 	struct drm_info_node *node = s->private;
@@ -1290,6 +1300,7 @@ static struct drm_info_list rockchip_debugfs_files[] = {
 	{ "regs", rockchip_drm_regs_dump, 0, NULL },
 	{ "summary", rockchip_drm_summary_show, 0, NULL },
 	{ "mm_dump", rockchip_drm_mm_dump, 0, NULL },
+	{ "gem_cache", rockchip_drm_gem_cache_show, 0, NULL },
 };
 
 static void rockchip_drm_debugfs_init(struct drm_minor *minor)
@@ -1551,6 +1562,9 @@ static int rockchip_drm_bind(struct device *dev)
 		goto err_unbind_all;
 
 	rockchip_gem_pool_init(drm_dev);
+	ret = rockchip_gem_cache_init(drm_dev);
+	if (ret)
+		DRM_WARN("gem buffer cache disabled: %d\n", ret);
 	ret = of_reserved_mem_device_init(drm_dev->dev);
 	if (ret)
 		DRM_DEBUG_KMS("No reserved memory region assign to drm\n");
@@ -1573,6 +1587,7 @@ static int rockchip_drm_bind(struct device *dev)
 	drm_kms_helper_poll_fini(drm_dev);
 	rockchip_drm_fbdev_fini(drm_dev);
 err_iommu_cleanup:
+	rockchip_gem_cache_fini(drm_dev);
 	rockchip_iommu_cleanup(drm_dev);
 err_unbind_all:
 	component_unbind_all(dev, drm_dev);
@@ -1598,6 +1613,7 @@ static void rockchip_drm_unbind(struct device *dev)
 	drm_atomic_helper_shutdown(drm_dev);
 	component_unbind_all(dev, drm_dev);
 	drm_mode_config_cleanup(drm_dev);
+	rockchip_gem_cache_fini(drm_dev);
 	rockchip_iommu_cleanup(drm_dev);
 
 	drm_dev->dev_private = NULL;
@@ -139,8 +139,19 @@ struct rockchip_bcsh_state {
 	int cos_hue;
 };
 
+/*
+ * error interrupts of a crtc since boot, sampled around a run by the
+ * display benchmark to characterise display margin under ddr load
+ */
+struct rockchip_crtc_err_stats {
+	atomic_t post_buf_empty;
+	atomic_t win_empty;
+	atomic_t bus_error;
+};
+
 struct rockchip_crtc {
 	struct drm_crtc crtc;
+	struct rockchip_crtc_err_stats err_stats;
 #if defined(CONFIG_ROCKCHIP_DRM_DEBUG)
 	/**
 	 * @vop_dump_status the status of vop dump control
@@ -154,6 +165,10 @@ struct rockchip_crtc {
 	bool vop_dump_list_init_flag;
 	int vop_dump_times;
 	int frame_count;
+	/**
+	 * @update_stats: atomic_update cost of the full and fb only paths
+	 */
+	struct rockchip_drm_update_stats update_stats[ROCKCHIP_UPDATE_PATH_MAX];
 #endif
 };
 
@@ -391,6 +406,8 @@ struct next_hdr_sink_data {
  * @crtc_send_mcu_cmd: send mcu panel init cmd.
  * @te_handler: soft te hand for cmd mode panel.
  * @wait_vact_end: wait the last active line.
+ * @frame_push: refresh one frame on a crtc that only scans out on request
+ *	(mcu hold mode), -EOPNOTSUPP for continuously scanning crtcs.
  */
 struct rockchip_crtc_funcs {
 	int (*loader_protect)(struct drm_crtc *crtc, bool on);
@@ -413,6 +430,7 @@ struct rockchip_crtc_funcs {
 	void (*te_handler)(struct drm_crtc *crtc);
 	int (*wait_vact_end)(struct drm_crtc *crtc, unsigned int mstimeout);
 	void (*crtc_standby)(struct drm_crtc *crtc, bool standby);
+	int (*frame_push)(struct drm_crtc *crtc);
 };
 
 struct rockchip_dclk_pll {
@@ -433,6 +451,7 @@ struct rockchip_drm_private {
 	struct drm_gem_object *fbdev_bo;
 	struct iommu_domain *domain;
 	struct gen_pool *secure_buffer_pool;
+	struct rockchip_gem_cache *gem_cache;
 	struct mutex mm_lock;
 	struct drm_mm mm;
 	struct list_head psr_list;
@@ -80,9 +80,44 @@ static int rockchip_drm_gem_fb_create_handle(struct drm_framebuffer *fb,
 	return drm_gem_fb_create_handle(fb, file, handle);
 }
 
+/*
+ * push a frame on every crtc scanning out @fb that only refreshes on
+ * request. the mcu interface sends whole frames, so the clips only tell
+ * that something changed.
+ */
+static int rockchip_drm_fb_dirty(struct drm_framebuffer *fb,
+				 struct drm_file *file_priv, unsigned int flags,
+				 unsigned int color, struct drm_clip_rect *clips,
+				 unsigned int num_clips)
+{
+	struct rockchip_drm_private *priv = fb->dev->dev_private;
+	struct drm_plane *plane;
+	struct drm_crtc *crtc;
+	u32 crtc_mask = 0;
+	int pipe;
+
+	drm_modeset_lock_all(fb->dev);
+	drm_for_each_plane(plane, fb->dev) {
+		if (plane->state && plane->state->fb == fb && plane->state->crtc)
+			crtc_mask |= drm_crtc_mask(plane->state->crtc);
+	}
+
+	drm_for_each_crtc(crtc, fb->dev) {
+		pipe = drm_crtc_index(crtc);
+		if (!(crtc_mask & drm_crtc_mask(crtc)) || !crtc->state->active)
+			continue;
+		if (priv->crtc_funcs[pipe] && priv->crtc_funcs[pipe]->frame_push)
+			priv->crtc_funcs[pipe]->frame_push(crtc);
+	}
+	drm_modeset_unlock_all(fb->dev);
+
+	return 0;
+}
+
 static const struct drm_framebuffer_funcs rockchip_drm_fb_funcs = {
 	.destroy       = rockchip_drm_fb_destroy,
 	.create_handle = rockchip_drm_gem_fb_create_handle,
+	.dirty	       = rockchip_drm_fb_dirty,
 };
 
 struct drm_framebuffer *
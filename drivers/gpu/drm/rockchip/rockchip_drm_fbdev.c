@@ -16,6 +16,110 @@
 
 #define PREFERRED_BPP		32
 
+/*
+ * 0 keeps the fbdev buffer directly scanned out. otherwise writes through
+ * mmap and the cfb drawing ops are collected as damage and flushed to the
+ * crtcs with fb dirty at most this many times a second, which lets panels
+ * in mcu hold mode skip frames while the ui is static.
+ */
+static unsigned int fbdev_flush_fps;
+module_param(fbdev_flush_fps, uint, 0444);
+MODULE_PARM_DESC(fbdev_flush_fps, "fbdev damage flush rate cap, 0 disables deferred io");
+
+struct rockchip_drm_fbdev {
+	struct drm_fb_helper helper;
+	struct fb_deferred_io defio;
+	spinlock_t damage_lock; /* damage */
+	struct drm_clip_rect damage;
+};
+
+#define to_rockchip_fbdev(h) container_of(h, struct rockchip_drm_fbdev, helper)
+
+static void rockchip_fbdev_damage_reset(struct drm_clip_rect *clip)
+{
+	clip->x1 = ~0;
+	clip->y1 = ~0;
+	clip->x2 = 0;
+	clip->y2 = 0;
+}
+
+static void rockchip_fbdev_damage(struct fb_info *info, u32 x, u32 y,
+				  u32 width, u32 height)
+{
+	struct rockchip_drm_fbdev *fbdev = to_rockchip_fbdev(info->par);
+	struct drm_clip_rect *clip = &fbdev->damage;
+	unsigned long flags;
+
+	if (!info->fbdefio || !width || !height)
+		return;
+
+	spin_lock_irqsave(&fbdev->damage_lock, flags);
+	clip->x1 = min_t(u32, clip->x1, x);
+	clip->y1 = min_t(u32, clip->y1, y);
+	clip->x2 = max_t(u32, clip->x2, x + width);
+	clip->y2 = max_t(u32, clip->y2, y + height);
+	spin_unlock_irqrestore(&fbdev->damage_lock, flags);
+
+	/* a pending flush already covers the new damage */
+	schedule_delayed_work(&info->deferred_work, fbdev->defio.delay);
+}
+
+static void rockchip_fbdev_deferred_io(struct fb_info *info,
+				       struct list_head *pagelist)
+{
+	struct rockchip_drm_fbdev *fbdev = to_rockchip_fbdev(info->par);
+	struct drm_framebuffer *fb = fbdev->helper.fb;
+	unsigned long start, min = ULONG_MAX, max = 0;
+	struct drm_clip_rect clip;
+	unsigned long flags;
+	struct page *page;
+	u32 y1, y2;
+
+	list_for_each_entry(page, pagelist, lru) {
+		start = page->index << PAGE_SHIFT;
+		min = min(min, start);
+		max = max(max, start + PAGE_SIZE);
+	}
+
+	spin_lock_irqsave(&fbdev->damage_lock, flags);
+	if (min < max) {
+		y1 = min / info->fix.line_length;
+		y2 = min_t(u32, DIV_ROUND_UP(max, info->fix.line_length),
+			   info->var.yres_virtual);
+		fbdev->damage.x1 = 0;
+		fbdev->damage.y1 = min_t(u32, fbdev->damage.y1, y1);
+		fbdev->damage.x2 = info->var.xres_virtual;
+		fbdev->damage.y2 = max_t(u32, fbdev->damage.y2, y2);
+	}
+	clip = fbdev->damage;
+	rockchip_fbdev_damage_reset(&fbdev->damage);
+	spin_unlock_irqrestore(&fbdev->damage_lock, flags);
+
+	if (fb && fb->funcs->dirty && clip.x1 < clip.x2 && clip.y1 < clip.y2)
+		fb->funcs->dirty(fb, NULL, 0, 0, &clip, 1);
+}
+
+static void rockchip_fbdev_fillrect(struct fb_info *info,
+				    const struct fb_fillrect *rect)
+{
+	drm_fb_helper_cfb_fillrect(info, rect);
+	rockchip_fbdev_damage(info, rect->dx, rect->dy, rect->width, rect->height);
+}
+
+static void rockchip_fbdev_copyarea(struct fb_info *info,
+				    const struct fb_copyarea *area)
+{
+	drm_fb_helper_cfb_copyarea(info, area);
+	rockchip_fbdev_damage(info, area->dx, area->dy, area->width, area->height);
+}
+
+static void rockchip_fbdev_imageblit(struct fb_info *info,
+				     const struct fb_image *image)
+{
+	drm_fb_helper_cfb_imageblit(info, image);
+	rockchip_fbdev_damage(info, image->dx, image->dy, image->width, image->height);
+}
+
 static int rockchip_fbdev_mmap(struct fb_info *info,
 			       struct vm_area_struct *vma)
 {
@@ -29,9 +133,9 @@ static const struct fb_ops rockchip_drm_fbdev_ops = {
 	.owner		= THIS_MODULE,
 	DRM_FB_HELPER_DEFAULT_OPS,
 	.fb_mmap	= rockchip_fbdev_mmap,
-	.fb_fillrect	= drm_fb_helper_cfb_fillrect,
-	.fb_copyarea	= drm_fb_helper_cfb_copyarea,
-	.fb_imageblit	= drm_fb_helper_cfb_imageblit,
+	.fb_fillrect	= rockchip_fbdev_fillrect,
+	.fb_copyarea	= rockchip_fbdev_copyarea,
+	.fb_imageblit	= rockchip_fbdev_imageblit,
 };
 
 static int rockchip_drm_fbdev_create(struct drm_fb_helper *helper,
@@ -93,6 +197,18 @@ static int rockchip_drm_fbdev_create(struct drm_fb_helper *helper,
 	fbi->screen_size = rk_obj->base.size;
 	fbi->fix.smem_len = rk_obj->base.size;
 
+	if (fbdev_flush_fps) {
+		struct rockchip_drm_fbdev *fbdev = to_rockchip_fbdev(helper);
+
+		/* the deferred io fault handler looks up linear buffers by pfn */
+		if (!private->domain)
+			fbi->fix.smem_start = rk_obj->dma_handle;
+		fbdev->defio.delay = max_t(unsigned long, HZ / fbdev_flush_fps, 1);
+		fbdev->defio.deferred_io = rockchip_fbdev_deferred_io;
+		fbi->fbdefio = &fbdev->defio;
+		fb_deferred_io_init(fbi);
+	}
+
 	DRM_DEBUG_KMS("FB [%dx%d]-%d kvaddr=%p offset=%ld size=%zu\n",
 		      fb->width, fb->height, fb->format->depth,
 		      rk_obj->kvaddr,
@@ -112,15 +228,19 @@ static const struct drm_fb_helper_funcs rockchip_drm_fb_helper_funcs = {
 int rockchip_drm_fbdev_init(struct drm_device *dev)
 {
 	struct rockchip_drm_private *private = dev->dev_private;
+	struct rockchip_drm_fbdev *fbdev;
 	struct drm_fb_helper *helper;
 	int ret;
 
 	if (!dev->mode_config.num_crtc || !dev->mode_config.num_connector)
 		return -EINVAL;
 
-	helper = devm_kzalloc(dev->dev, sizeof(*helper), GFP_KERNEL);
-	if (!helper)
+	fbdev = devm_kzalloc(dev->dev, sizeof(*fbdev), GFP_KERNEL);
+	if (!fbdev)
 		return -ENOMEM;
+	spin_lock_init(&fbdev->damage_lock);
+	rockchip_fbdev_damage_reset(&fbdev->damage);
+	helper = &fbdev->helper;
 	private->fbdev_helper = helper;
 
 	drm_fb_helper_prepare(dev, helper, &rockchip_drm_fb_helper_funcs);
@@ -156,6 +276,9 @@ void rockchip_drm_fbdev_fini(struct drm_device *dev)
 	if (!helper)
 		return;
 
+	if (helper->fbdev && helper->fbdev->fbdefio)
+		fb_deferred_io_cleanup(helper->fbdev);
+
 	drm_fb_helper_unregister_fbi(helper);
 
 	if (helper->fb)
@@ -14,8 +14,12 @@
 #include <drm/drm_vma_manager.h>
 
 #include <linux/genalloc.h>
+#include <linux/hashtable.h>
+#include <linux/highmem.h>
 #include <linux/iommu.h>
 #include <linux/pagemap.h>
+#include <linux/seq_file.h>
+#include <linux/shrinker.h>
 #include <linux/vmalloc.h>
 #include <linux/rockchip/rockchip_sip.h>
 
@@ -32,6 +36,46 @@ struct page_info {
 
 #define PG_ROUND       8
 
+/*
+ * Recently freed shmem buffers are kept with their pages pinned and their
+ * iommu mapping in place, a create of the same size and flags takes one
+ * back instead of allocating, mapping and flushing the iotlb again. The
+ * pages are cleared before reuse. The cache is bounded by gem_cache_mb
+ * and drained by a shrinker under memory pressure.
+ */
+static unsigned int gem_cache_mb = 64;
+module_param(gem_cache_mb, uint, 0644);
+MODULE_PARM_DESC(gem_cache_mb, "freed gem buffers kept mapped for reuse, in MiB (0: off)");
+
+#define GEM_CACHE_HASH_BITS	6
+
+struct rockchip_gem_cache_entry {
+	struct hlist_node node;
+	struct list_head lru;
+	struct file *filp;
+	size_t size;
+	unsigned int flags;
+	struct page **pages;
+	unsigned long num_pages;
+	struct sg_table *sgt;
+	struct drm_mm_node mm;
+	size_t map_size;
+};
+
+struct rockchip_gem_cache {
+	struct drm_device *drm;
+	struct mutex lock;
+	DECLARE_HASHTABLE(buckets, GEM_CACHE_HASH_BITS);
+	struct list_head lru;
+	struct shrinker shrinker;
+	unsigned long pages;
+	unsigned long count;
+	u64 hits;
+	u64 misses;
+	u64 evicted;
+	u64 shrunk;
+};
+
 static int rockchip_gem_iommu_map(struct rockchip_gem_object *rk_obj)
 {
 	struct drm_device *drm = rk_obj->base.dev;
@@ -253,6 +297,258 @@ static void rockchip_gem_put_pages(struct rockchip_gem_object *rk_obj)
 	drm_gem_put_pages(&rk_obj->base, rk_obj->pages, true, true);
 }
 
+static void rockchip_gem_cache_evict(struct rockchip_gem_cache *cache,
+				     struct rockchip_gem_cache_entry *entry)
+{
+	struct rockchip_drm_private *private = cache->drm->dev_private;
+	unsigned long i;
+
+	hash_del(&entry->node);
+	list_del(&entry->lru);
+	cache->pages -= entry->num_pages;
+	cache->count--;
+
+	iommu_unmap(private->domain, entry->mm.start, entry->map_size);
+	mutex_lock(&private->mm_lock);
+	drm_mm_remove_node(&entry->mm);
+	mutex_unlock(&private->mm_lock);
+
+	/* same as drm_gem_put_pages(), the shmem file goes away with them */
+	mapping_clear_unevictable(entry->filp->f_mapping);
+	for (i = 0; i < entry->num_pages; i++)
+		put_page(entry->pages[i]);
+	kvfree(entry->pages);
+	sg_free_table(entry->sgt);
+	kfree(entry->sgt);
+	fput(entry->filp);
+	kfree(entry);
+}
+
+static unsigned long rockchip_gem_cache_shrink(struct rockchip_gem_cache *cache,
+					       unsigned long nr_pages)
+{
+	struct rockchip_gem_cache_entry *entry;
+	unsigned long freed = 0;
+
+	while (freed < nr_pages && !list_empty(&cache->lru)) {
+		entry = list_last_entry(&cache->lru,
+					struct rockchip_gem_cache_entry, lru);
+		freed += entry->num_pages;
+		rockchip_gem_cache_evict(cache, entry);
+	}
+
+	return freed;
+}
+
+static unsigned long
+rockchip_gem_cache_count_objects(struct shrinker *shrinker,
+				 struct shrink_control *sc)
+{
+	struct rockchip_gem_cache *cache =
+		container_of(shrinker, struct rockchip_gem_cache, shrinker);
+
+	return READ_ONCE(cache->pages) ? : SHRINK_EMPTY;
+}
+
+static unsigned long
+rockchip_gem_cache_scan_objects(struct shrinker *shrinker,
+				struct shrink_control *sc)
+{
+	struct rockchip_gem_cache *cache =
+		container_of(shrinker, struct rockchip_gem_cache, shrinker);
+	unsigned long freed;
+
+	if (!mutex_trylock(&cache->lock))
+		return SHRINK_STOP;
+	freed = rockchip_gem_cache_shrink(cache, sc->nr_to_scan);
+	cache->shrunk += freed;
+	mutex_unlock(&cache->lock);
+
+	return freed ? : SHRINK_STOP;
+}
+
+/*
+ * rockchip_gem_cache_get - take a cached buffer of the same size and flags,
+ * returns NULL on a miss and the caller allocates as usual.
+ */
+static struct rockchip_gem_object *
+rockchip_gem_cache_get(struct drm_device *drm, unsigned int size,
+		       bool alloc_kmap, unsigned int flags)
+{
+	struct rockchip_drm_private *private = drm->dev_private;
+	struct rockchip_gem_cache *cache = private->gem_cache;
+	struct rockchip_gem_cache_entry *entry, *found = NULL;
+	struct rockchip_gem_object *rk_obj;
+	unsigned long i;
+
+	if (!cache || alloc_kmap ||
+	    flags & (ROCKCHIP_BO_CONTIG | ROCKCHIP_BO_SECURE))
+		return NULL;
+
+	size = round_up(size, PAGE_SIZE);
+	rk_obj = kzalloc(sizeof(*rk_obj), GFP_KERNEL);
+	if (!rk_obj)
+		return NULL;
+
+	mutex_lock(&cache->lock);
+	hash_for_each_possible(cache->buckets, entry, node, size) {
+		if (entry->size == size && entry->flags == flags) {
+			found = entry;
+			break;
+		}
+	}
+	if (!found) {
+		cache->misses++;
+		mutex_unlock(&cache->lock);
+		kfree(rk_obj);
+		return NULL;
+	}
+	hash_del(&found->node);
+	list_del(&found->lru);
+	cache->pages -= found->num_pages;
+	cache->count--;
+	cache->hits++;
+	mutex_unlock(&cache->lock);
+
+	drm_gem_private_object_init(drm, &rk_obj->base, size);
+	rk_obj->base.filp = found->filp;
+	rk_obj->flags = flags;
+	rk_obj->buf_type = ROCKCHIP_GEM_BUF_TYPE_SHMEM;
+	rk_obj->pages = found->pages;
+	rk_obj->num_pages = found->num_pages;
+	rk_obj->sgt = found->sgt;
+	rk_obj->size = found->map_size;
+	mutex_lock(&private->mm_lock);
+	drm_mm_replace_node(&found->mm, &rk_obj->mm);
+	mutex_unlock(&private->mm_lock);
+	rk_obj->dma_addr = rk_obj->mm.start;
+	kfree(found);
+
+	/* never hand out what the previous owner left behind */
+	for (i = 0; i < rk_obj->num_pages; i++)
+		clear_highpage(rk_obj->pages[i]);
+	dma_sync_sgtable_for_device(drm->dev, rk_obj->sgt, DMA_TO_DEVICE);
+
+	return rk_obj;
+}
+
+/*
+ * rockchip_gem_cache_put - keep the buffer of a freed object mapped, the
+ * object itself is released by the caller as usual.
+ */
+static bool rockchip_gem_cache_put(struct rockchip_gem_object *rk_obj)
+{
+	struct drm_device *drm = rk_obj->base.dev;
+	struct rockchip_drm_private *private = drm->dev_private;
+	struct rockchip_gem_cache *cache = private->gem_cache;
+	struct rockchip_gem_cache_entry *entry;
+	unsigned long max_pages = (unsigned long)READ_ONCE(gem_cache_mb) <<
+				  (20 - PAGE_SHIFT);
+
+	if (!cache || rk_obj->buf_type != ROCKCHIP_GEM_BUF_TYPE_SHMEM ||
+	    rk_obj->kvaddr || !rk_obj->base.filp ||
+	    rk_obj->num_pages > max_pages)
+		return false;
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry)
+		return false;
+
+	entry->filp = get_file(rk_obj->base.filp);
+	entry->size = rk_obj->base.size;
+	entry->flags = rk_obj->flags;
+	entry->pages = rk_obj->pages;
+	entry->num_pages = rk_obj->num_pages;
+	entry->sgt = rk_obj->sgt;
+	entry->map_size = rk_obj->size;
+	mutex_lock(&private->mm_lock);
+	drm_mm_replace_node(&rk_obj->mm, &entry->mm);
+	mutex_unlock(&private->mm_lock);
+	rk_obj->pages = NULL;
+	rk_obj->sgt = NULL;
+
+	mutex_lock(&cache->lock);
+	hash_add(cache->buckets, &entry->node, entry->size);
+	list_add(&entry->lru, &cache->lru);
+	cache->pages += entry->num_pages;
+	cache->count++;
+	if (cache->pages > max_pages)
+		cache->evicted += rockchip_gem_cache_shrink(cache,
+							    cache->pages - max_pages);
+	mutex_unlock(&cache->lock);
+
+	return true;
+}
+
+int rockchip_gem_cache_init(struct drm_device *drm)
+{
+	struct rockchip_drm_private *private = drm->dev_private;
+	struct rockchip_gem_cache *cache;
+	int ret;
+
+	/* only the iommu map is worth keeping */
+	if (!private->domain)
+		return 0;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return -ENOMEM;
+
+	cache->drm = drm;
+	mutex_init(&cache->lock);
+	hash_init(cache->buckets);
+	INIT_LIST_HEAD(&cache->lru);
+	cache->shrinker.count_objects = rockchip_gem_cache_count_objects;
+	cache->shrinker.scan_objects = rockchip_gem_cache_scan_objects;
+	cache->shrinker.seeks = DEFAULT_SEEKS;
+	ret = register_shrinker(&cache->shrinker);
+	if (ret) {
+		kfree(cache);
+		return ret;
+	}
+
+	private->gem_cache = cache;
+
+	return 0;
+}
+
+void rockchip_gem_cache_fini(struct drm_device *drm)
+{
+	struct rockchip_drm_private *private = drm->dev_private;
+	struct rockchip_gem_cache *cache = private->gem_cache;
+
+	if (!cache)
+		return;
+
+	unregister_shrinker(&cache->shrinker);
+	private->gem_cache = NULL;
+	mutex_lock(&cache->lock);
+	rockchip_gem_cache_shrink(cache, ULONG_MAX);
+	mutex_unlock(&cache->lock);
+	kfree(cache);
+}
+
+void rockchip_gem_cache_show(struct drm_device *drm, struct seq_file *s)
+{
+	struct rockchip_drm_private *private = drm->dev_private;
+	struct rockchip_gem_cache *cache = private->gem_cache;
+
+	if (!cache) {
+		seq_puts(s, "disabled\n");
+		return;
+	}
+
+	mutex_lock(&cache->lock);
+	seq_printf(s, "buffers: %lu\n", cache->count);
+	seq_printf(s, "size: %lu KiB, limit: %u MiB\n",
+		   cache->pages << (PAGE_SHIFT - 10), READ_ONCE(gem_cache_mb));
+	seq_printf(s, "hits: %llu\n", cache->hits);
+	seq_printf(s, "misses: %llu\n", cache->misses);
+	seq_printf(s, "evicted pages: %llu\n", cache->evicted);
+	seq_printf(s, "shrunk pages: %llu\n", cache->shrunk);
+	mutex_unlock(&cache->lock);
+}
+
 static inline void *drm_calloc_large(size_t nmemb, size_t size);
 static inline void drm_free_large(void *ptr);
 static void rockchip_gem_free_dma(struct rockchip_gem_object *rk_obj);
@@ -504,6 +800,9 @@ static void rockchip_gem_free_buf(struct rockchip_gem_object *rk_obj)
 	struct drm_device *drm = rk_obj->base.dev;
 	struct rockchip_drm_private *private = drm->dev_private;
 
+	if (rockchip_gem_cache_put(rk_obj))
+		return;
+
 	if (private->domain)
 		rockchip_gem_iommu_unmap(rk_obj);
 
@@ -650,6 +949,10 @@ rockchip_gem_create_object(struct drm_device *drm, unsigned int size,
 	struct rockchip_gem_object *rk_obj;
 	int ret;
 
+	rk_obj = rockchip_gem_cache_get(drm, size, alloc_kmap, flags);
+	if (rk_obj)
+		return rk_obj;
+
 	rk_obj = rockchip_gem_alloc_object(drm, size, flags);
 	if (IS_ERR(rk_obj))
 		return rk_obj;
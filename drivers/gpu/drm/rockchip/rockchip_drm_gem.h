@@ -9,6 +9,8 @@
 
 #include <linux/dma-direction.h>
 
+struct seq_file;
+
 #define to_rockchip_obj(x) container_of(x, struct rockchip_gem_object, base)
 
 enum rockchip_gem_buf_type {
@@ -82,4 +84,8 @@ int rockchip_gem_prime_end_cpu_access(struct drm_gem_object *obj,
 				      enum dma_data_direction dir);
 
 void rockchip_gem_get_ddr_info(void);
+
+int rockchip_gem_cache_init(struct drm_device *drm);
+void rockchip_gem_cache_fini(struct drm_device *drm);
+void rockchip_gem_cache_show(struct drm_device *drm, struct seq_file *s);
 #endif /* _ROCKCHIP_DRM_GEM_H */
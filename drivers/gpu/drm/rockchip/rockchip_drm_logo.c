@@ -20,6 +20,17 @@
 #include "rockchip_drm_fb.h"
 #include "rockchip_drm_logo.h"
 
+/*
+ * adopt the loader display as is when every route still runs the loader
+ * timing: the logo state is checked and swapped in as the current state
+ * without a commit, so the pipe, its clocks and the logo window are not
+ * reprogrammed at all and the loader memory goes away once the first
+ * real frame replaced the logo fb.
+ */
+static bool logo_handoff = IS_ENABLED(CONFIG_ROCKCHIP_THUNDER_BOOT);
+module_param(logo_handoff, bool, 0444);
+MODULE_PARM_DESC(logo_handoff, "Adopt the loader logo state without a commit");
+
 static bool is_support_hotplug(uint32_t output_type)
 {
 	switch (output_type) {
@@ -906,6 +917,7 @@ void rockchip_drm_show_logo(struct drm_device *drm_dev)
 	struct list_head mode_unset_list;
 	unsigned int plane_mask = 0;
 	struct drm_crtc *crtc;
+	bool handoff;
 	int ret, i;
 
 	root = of_get_child_by_name(np, "route");
@@ -1039,7 +1051,19 @@ void rockchip_drm_show_logo(struct drm_device *drm_dev)
 			state->connectors[i].new_state->best_encoder = NULL;
 	}
 
-	ret = drm_atomic_commit(state);
+	handoff = logo_handoff;
+	list_for_each_entry(set, &mode_set_list, head) {
+		if (set->mode_changed || !set->fb)
+			handoff = false;
+	}
+
+	if (handoff) {
+		ret = drm_atomic_check_only(state);
+		if (!ret)
+			WARN_ON(drm_atomic_helper_swap_state(state, false));
+	} else {
+		ret = drm_atomic_commit(state);
+	}
 	/**
 	 * todo
 	 * drm_atomic_clean_old_fb(drm_dev, plane_mask, ret);
@@ -1071,6 +1095,8 @@ void rockchip_drm_show_logo(struct drm_device *drm_dev)
 
 	private->loader_protect = true;
 	drm_modeset_unlock_all(drm_dev);
+	if (handoff)
+		DRM_INFO("adopted the loader logo state\n");
 
 	if (private->fbdev_helper && private->fbdev_helper->fb) {
 		drm_for_each_crtc(crtc, drm_dev) {
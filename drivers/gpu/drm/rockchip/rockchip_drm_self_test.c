@@ -4,13 +4,19 @@
  * Author: Sandy Huang <hjc@rock-chips.com>
  */
 
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/init.h>
 #include <linux/kthread.h>
 #include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
 #include <linux/workqueue.h>
 
+#include <drm/drm_atomic.h>
 #include <drm/drm_atomic_uapi.h>
+#include <drm/drm_rect.h>
+#include <drm/drm_vblank.h>
 
 #include "rockchip_drm_drv.h"
 #include "rockchip_drm_direct_show.h"
@@ -36,6 +42,59 @@ struct rockchip_drm_self_test {
 
 static struct rockchip_drm_self_test rockchip_drm_st;
 
+/*
+ * display benchmark: flips up to BENCH_MAX_PLANES free planes of one crtc
+ * every vblank with a configurable format, afbc and scale factor, and
+ * reports the achieved fps and the post/win empty (underflow) and bus
+ * error interrupts seen during the run. the ddr load (isp, encoder or a
+ * memory stress test) is set up by the caller, e.g.
+ *
+ *   echo "planes=3 fmt=NV12 scale=150 frames=600" > /sys/kernel/debug/dri/0/display_bench
+ *   cat /sys/kernel/debug/dri/0/display_bench
+ *
+ * keys: crtc=<name> planes=<n> fmt=<fourcc> afbc=<0|1> width=<w>
+ * height=<h> (source size, default the crtc mode) scale=<percent>
+ * frames=<n>
+ */
+#define BENCH_MAX_PLANES	8
+#define BENCH_BUFFER_NUM	2
+
+struct rockchip_drm_bench_plane {
+	struct drm_plane *plane;
+	struct rockchip_drm_direct_show_buffer *buffer[BENCH_BUFFER_NUM];
+	struct drm_rect dst;
+	unsigned int zpos;
+};
+
+struct rockchip_drm_bench {
+	struct drm_device *dev;
+	struct mutex lock;	/* one run at a time, result */
+
+	/* parameters of the last run */
+	char crtc_name[32];
+	u32 num_planes;
+	u32 format;
+	bool afbc;
+	u32 width;
+	u32 height;
+	u32 scale;
+	u32 frames;
+
+	struct drm_crtc *crtc;
+	struct rockchip_drm_bench_plane planes[BENCH_MAX_PLANES];
+
+	/* result of the last run */
+	int ret;
+	u32 frames_done;
+	u32 vblanks;
+	u64 elapsed_ns;
+	u32 post_buf_empty;
+	u32 win_empty;
+	u32 bus_error;
+};
+
+static struct rockchip_drm_bench rockchip_drm_bench;
+
 static void __maybe_unused
 rockchip_drm_draw_white(struct rockchip_drm_direct_show_buffer *buffer)
 {
@@ -113,6 +172,462 @@ static int rockchip_drm_self_test_free_buffer(struct rockchip_drm_self_test *sel
 	return 0;
 }
 
+static bool rockchip_drm_bench_plane_usable(struct rockchip_drm_bench *bench,
+					    struct drm_plane *plane, u64 modifier)
+{
+	unsigned int i;
+
+	if (plane->type == DRM_PLANE_TYPE_CURSOR ||
+	    !(plane->possible_crtcs & drm_crtc_mask(bench->crtc)))
+		return false;
+	/* leave planes that are in use by a client alone */
+	if (!plane->state || plane->state->fb || plane->state->crtc)
+		return false;
+	if (modifier && plane->funcs->format_mod_supported &&
+	    !plane->funcs->format_mod_supported(plane, bench->format, modifier))
+		return false;
+
+	for (i = 0; i < plane->format_count; i++)
+		if (plane->format_types[i] == bench->format)
+			return true;
+
+	return false;
+}
+
+static int rockchip_drm_bench_alloc_buffer(struct rockchip_drm_bench *bench,
+					   struct rockchip_drm_direct_show_buffer *buffer,
+					   u64 modifier)
+{
+	const struct drm_format_info *info = drm_format_info(buffer->pixel_format);
+	struct drm_gem_object *objs[ROCKCHIP_MAX_FB_BUFFER];
+	struct drm_mode_fb_cmd2 mode_cmd = { 0 };
+	struct rockchip_gem_object *rk_obj;
+	struct drm_framebuffer *fb;
+	size_t size;
+	int i;
+
+	if (info->num_planes > 2 || (modifier && info->is_yuv))
+		return -EINVAL;
+
+	buffer->bpp = rockchip_drm_get_bpp(info);
+	buffer->pitch[0] = ALIGN(buffer->width * DIV_ROUND_UP(buffer->bpp, 8), 64);
+	size = buffer->pitch[0] * buffer->height;
+	if (info->num_planes > 1) {
+		buffer->pitch[1] = ALIGN(buffer->width / info->hsub * info->cpp[1], 64);
+		size += buffer->pitch[1] * buffer->height / info->vsub;
+	}
+	if (modifier) {
+		u32 blocks = DIV_ROUND_UP(buffer->width, 16) * DIV_ROUND_UP(buffer->height, 16);
+
+		/* 16 byte header per 16x16 superblock, then the uncompressed bodies */
+		size = ALIGN(blocks * 16, PAGE_SIZE) + blocks * 16 * 16 * info->cpp[0];
+		mode_cmd.flags = DRM_MODE_FB_MODIFIERS;
+		mode_cmd.modifier[0] = modifier;
+	}
+
+	rk_obj = rockchip_gem_create_object(bench->dev, size, true, 0);
+	if (IS_ERR(rk_obj))
+		return PTR_ERR(rk_obj);
+
+	mode_cmd.width = buffer->width;
+	mode_cmd.height = buffer->height;
+	mode_cmd.pixel_format = buffer->pixel_format;
+	mode_cmd.pitches[0] = buffer->pitch[0];
+	objs[0] = &rk_obj->base;
+	for (i = 1; i < info->num_planes; i++) {
+		/* the fb holds one reference per plane */
+		drm_gem_object_get(objs[0]);
+		objs[i] = objs[0];
+		mode_cmd.offsets[i] = buffer->pitch[0] * buffer->height;
+		mode_cmd.pitches[i] = buffer->pitch[1];
+	}
+
+	fb = rockchip_fb_alloc(bench->dev, &mode_cmd, objs, info->num_planes);
+	if (IS_ERR(fb)) {
+		for (i = 0; i < info->num_planes; i++)
+			drm_gem_object_put(objs[0]);
+		return PTR_ERR(fb);
+	}
+
+	buffer->rk_gem_obj = rk_obj;
+	buffer->fb = fb;
+	buffer->vir_addr[0] = rk_obj->kvaddr;
+	if (rk_obj->kvaddr && info->num_planes > 1)
+		buffer->vir_addr[1] = rk_obj->kvaddr + mode_cmd.offsets[1];
+
+	return 0;
+}
+
+static void rockchip_drm_bench_release(struct rockchip_drm_bench *bench)
+{
+	struct rockchip_drm_direct_show_buffer *buffer;
+	unsigned int i, j;
+
+	for (i = 0; i < BENCH_MAX_PLANES; i++) {
+		for (j = 0; j < BENCH_BUFFER_NUM; j++) {
+			buffer = bench->planes[i].buffer[j];
+			if (!buffer)
+				continue;
+			/* drops the gem object with the last fb reference */
+			if (buffer->fb)
+				drm_framebuffer_put(buffer->fb);
+			kfree(buffer);
+			bench->planes[i].buffer[j] = NULL;
+		}
+		bench->planes[i].plane = NULL;
+	}
+}
+
+static int rockchip_drm_bench_setup(struct rockchip_drm_bench *bench)
+{
+	const struct drm_display_mode *mode;
+	struct rockchip_drm_direct_show_buffer *buffer;
+	struct drm_plane *plane;
+	u64 modifier = 0;
+	u32 dst_w, dst_h, n = 0;
+	unsigned int i, j;
+	int ret;
+
+	bench->crtc = rockchip_drm_direct_show_get_crtc(bench->dev,
+							bench->crtc_name[0] ? bench->crtc_name : NULL);
+	if (!bench->crtc)
+		return -ENODEV;
+	mode = &bench->crtc->state->adjusted_mode;
+
+	if (!bench->width || !bench->height) {
+		bench->width = mode->hdisplay;
+		bench->height = mode->vdisplay;
+	}
+	dst_w = min_t(u32, bench->width * bench->scale / 100, mode->hdisplay);
+	dst_h = min_t(u32, bench->height * bench->scale / 100, mode->vdisplay);
+	if (!dst_w || !dst_h)
+		return -EINVAL;
+
+	if (bench->afbc)
+		modifier = DRM_FORMAT_MOD_ARM_AFBC(AFBC_FORMAT_MOD_BLOCK_SIZE_16x16);
+
+	drm_modeset_lock_all(bench->dev);
+	drm_for_each_plane(plane, bench->dev) {
+		if (n == bench->num_planes)
+			break;
+		if (rockchip_drm_bench_plane_usable(bench, plane, modifier))
+			bench->planes[n++].plane = plane;
+	}
+	drm_modeset_unlock_all(bench->dev);
+
+	if (n < bench->num_planes) {
+		struct drm_format_name_buf name;
+
+		pr_info("%s: only %u of %u planes are free for %s%s\n", __func__,
+			n, bench->num_planes, drm_get_format_name(bench->format, &name),
+			bench->afbc ? " afbc" : "");
+		bench->num_planes = n;
+	}
+	if (!n)
+		return -ENODEV;
+
+	for (i = 0; i < n; i++) {
+		struct rockchip_drm_bench_plane *bp = &bench->planes[i];
+		struct drm_property *zpos = bp->plane->zpos_property;
+		u32 x = min_t(u32, i * 32, mode->hdisplay - dst_w);
+		u32 y = min_t(u32, i * 32, mode->vdisplay - dst_h);
+
+		drm_rect_init(&bp->dst, x, y, dst_w, dst_h);
+		/* stack the planes in selection order */
+		bp->zpos = zpos ? max_t(int, zpos->values[1] - i, zpos->values[0]) : i;
+
+		for (j = 0; j < BENCH_BUFFER_NUM; j++) {
+			buffer = kzalloc(sizeof(*buffer), GFP_KERNEL);
+			if (!buffer)
+				return -ENOMEM;
+			bp->buffer[j] = buffer;
+			buffer->width = bench->width;
+			buffer->height = bench->height;
+			buffer->pixel_format = bench->format;
+			ret = rockchip_drm_bench_alloc_buffer(bench, buffer, modifier);
+			if (ret)
+				return ret;
+			if (!buffer->vir_addr[0])
+				continue;
+			/*
+			 * zeroed afbc headers decode as solid colour superblocks,
+			 * so afbc runs measure the best case compression
+			 */
+			if (modifier)
+				memset(buffer->vir_addr[0], 0, buffer->rk_gem_obj->base.size);
+			else
+				rockchip_drm_draw_color_bar(buffer);
+		}
+	}
+
+	return 0;
+}
+
+/* flip all bench planes to buffer @idx, or disable them when @idx < 0 */
+static int rockchip_drm_bench_commit(struct rockchip_drm_bench *bench, int idx)
+{
+	struct drm_modeset_acquire_ctx ctx;
+	struct drm_atomic_state *state;
+	struct drm_plane_state *pstate;
+	unsigned int i;
+	int ret;
+
+	state = drm_atomic_state_alloc(bench->dev);
+	if (!state)
+		return -ENOMEM;
+
+	drm_modeset_acquire_init(&ctx, 0);
+	state->acquire_ctx = &ctx;
+retry:
+	for (i = 0; i < bench->num_planes; i++) {
+		struct rockchip_drm_bench_plane *bp = &bench->planes[i];
+
+		pstate = drm_atomic_get_plane_state(state, bp->plane);
+		if (IS_ERR(pstate)) {
+			ret = PTR_ERR(pstate);
+			goto out;
+		}
+
+		if (idx < 0) {
+			ret = drm_atomic_set_crtc_for_plane(pstate, NULL);
+			if (ret)
+				goto out;
+			drm_atomic_set_fb_for_plane(pstate, NULL);
+			continue;
+		}
+
+		ret = drm_atomic_set_crtc_for_plane(pstate, bench->crtc);
+		if (ret)
+			goto out;
+		drm_atomic_set_fb_for_plane(pstate, bp->buffer[idx]->fb);
+		pstate->crtc_x = bp->dst.x1;
+		pstate->crtc_y = bp->dst.y1;
+		pstate->crtc_w = drm_rect_width(&bp->dst);
+		pstate->crtc_h = drm_rect_height(&bp->dst);
+		pstate->src_x = 0;
+		pstate->src_y = 0;
+		pstate->src_w = bench->width << 16;
+		pstate->src_h = bench->height << 16;
+		pstate->zpos = bp->zpos;
+	}
+
+	ret = drm_atomic_commit(state);
+out:
+	if (ret == -EDEADLK) {
+		drm_atomic_state_clear(state);
+		drm_modeset_backoff(&ctx);
+		goto retry;
+	}
+
+	drm_atomic_state_put(state);
+	drm_modeset_drop_locks(&ctx);
+	drm_modeset_acquire_fini(&ctx);
+
+	return ret;
+}
+
+static void rockchip_drm_bench_run(struct rockchip_drm_bench *bench)
+{
+	struct rockchip_crtc_err_stats *err;
+	u32 post_buf_empty, win_empty, bus_error;
+	u64 vblank, start;
+	u32 i;
+	int ret;
+
+	bench->frames_done = 0;
+	bench->vblanks = 0;
+	bench->elapsed_ns = 0;
+	bench->post_buf_empty = 0;
+	bench->win_empty = 0;
+	bench->bus_error = 0;
+
+	ret = rockchip_drm_bench_setup(bench);
+	if (ret)
+		goto out;
+
+	/* the first commit enables the planes, don't count it */
+	ret = rockchip_drm_bench_commit(bench, 0);
+	if (ret)
+		goto out;
+
+	err = &container_of(bench->crtc, struct rockchip_crtc, crtc)->err_stats;
+	post_buf_empty = atomic_read(&err->post_buf_empty);
+	win_empty = atomic_read(&err->win_empty);
+	bus_error = atomic_read(&err->bus_error);
+	vblank = drm_crtc_vblank_count(bench->crtc);
+	start = ktime_get_ns();
+
+	for (i = 1; i <= bench->frames; i++) {
+		ret = rockchip_drm_bench_commit(bench, i % BENCH_BUFFER_NUM);
+		if (ret)
+			break;
+		bench->frames_done++;
+	}
+
+	bench->elapsed_ns = ktime_get_ns() - start;
+	bench->vblanks = drm_crtc_vblank_count(bench->crtc) - vblank;
+	bench->post_buf_empty = atomic_read(&err->post_buf_empty) - post_buf_empty;
+	bench->win_empty = atomic_read(&err->win_empty) - win_empty;
+	bench->bus_error = atomic_read(&err->bus_error) - bus_error;
+
+	rockchip_drm_bench_commit(bench, -1);
+out:
+	bench->ret = ret;
+	rockchip_drm_bench_release(bench);
+}
+
+static int rockchip_drm_bench_parse(struct rockchip_drm_bench *bench, char *buf)
+{
+	char *opt, *val;
+	u32 num;
+
+	bench->crtc_name[0] = '\0';
+	bench->num_planes = 1;
+	bench->format = DRM_FORMAT_XRGB8888;
+	bench->afbc = false;
+	bench->width = 0;
+	bench->height = 0;
+	bench->scale = 100;
+	bench->frames = 300;
+
+	while ((opt = strsep(&buf, " \t\n")) != NULL) {
+		if (!*opt)
+			continue;
+		val = strchr(opt, '=');
+		if (!val)
+			return -EINVAL;
+		*val++ = '\0';
+
+		if (!strcmp(opt, "crtc")) {
+			strscpy(bench->crtc_name, val, sizeof(bench->crtc_name));
+			continue;
+		}
+		if (!strcmp(opt, "fmt")) {
+			if (strlen(val) != 4)
+				return -EINVAL;
+			bench->format = fourcc_code(val[0], val[1], val[2], val[3]);
+			if (!drm_format_info(bench->format))
+				return -EINVAL;
+			continue;
+		}
+
+		if (kstrtou32(val, 0, &num))
+			return -EINVAL;
+		if (!strcmp(opt, "planes"))
+			bench->num_planes = clamp_t(u32, num, 1, BENCH_MAX_PLANES);
+		else if (!strcmp(opt, "afbc"))
+			bench->afbc = !!num;
+		else if (!strcmp(opt, "width"))
+			bench->width = num;
+		else if (!strcmp(opt, "height"))
+			bench->height = num;
+		else if (!strcmp(opt, "scale"))
+			bench->scale = clamp_t(u32, num, 10, 400);
+		else if (!strcmp(opt, "frames"))
+			bench->frames = clamp_t(u32, num, 1, 100000);
+		else
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int rockchip_drm_bench_show(struct seq_file *s, void *data)
+{
+	struct rockchip_drm_bench *bench = s->private;
+	const struct drm_format_info *info;
+	struct drm_format_name_buf name;
+	u64 fps_x100 = 0, refresh_x100 = 0, fetch_mbps = 0;
+
+	mutex_lock(&bench->lock);
+	if (!bench->frames_done && !bench->ret) {
+		seq_puts(s, "no run yet\n");
+		goto out;
+	}
+
+	info = drm_format_info(bench->format);
+	if (bench->elapsed_ns) {
+		fps_x100 = div64_u64((u64)bench->frames_done * 100 * NSEC_PER_SEC,
+				     bench->elapsed_ns);
+		refresh_x100 = div64_u64((u64)bench->vblanks * 100 * NSEC_PER_SEC,
+					 bench->elapsed_ns);
+	}
+	/* the vop fetches every enabled plane once per vblank */
+	if (info)
+		fetch_mbps = div_u64((u64)bench->width * bench->height *
+				     rockchip_drm_get_bpp(info) / 8 * bench->num_planes *
+				     refresh_x100, 100 * 1000000);
+
+	seq_printf(s, "crtc: %s planes: %u fmt: %s%s src: %ux%u scale: %u%%\n",
+		   bench->crtc ? bench->crtc->name : "-", bench->num_planes,
+		   drm_get_format_name(bench->format, &name), bench->afbc ? " afbc" : "", bench->width,
+		   bench->height, bench->scale);
+	seq_printf(s, "result: %d frames: %u/%u vblanks: %u time: %llu ms\n",
+		   bench->ret, bench->frames_done, bench->frames, bench->vblanks,
+		   div_u64(bench->elapsed_ns, NSEC_PER_MSEC));
+	seq_printf(s, "fps: %llu.%02llu refresh: %llu.%02llu dropped: %u\n",
+		   fps_x100 / 100, fps_x100 % 100, refresh_x100 / 100,
+		   refresh_x100 % 100,
+		   bench->vblanks > bench->frames_done ?
+		   bench->vblanks - bench->frames_done : 0);
+	seq_printf(s, "post_buf_empty: %u win_empty: %u bus_error: %u\n",
+		   bench->post_buf_empty, bench->win_empty, bench->bus_error);
+	seq_printf(s, "fetch (uncompressed estimate): %llu MB/s\n", fetch_mbps);
+out:
+	mutex_unlock(&bench->lock);
+
+	return 0;
+}
+
+static int rockchip_drm_bench_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rockchip_drm_bench_show, inode->i_private);
+}
+
+static ssize_t rockchip_drm_bench_write(struct file *file, const char __user *ubuf,
+					size_t len, loff_t *offp)
+{
+	struct rockchip_drm_bench *bench = file_inode(file)->i_private;
+	char buf[128];
+	int ret;
+
+	if (len >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, len))
+		return -EFAULT;
+	buf[len] = '\0';
+
+	mutex_lock(&bench->lock);
+	ret = rockchip_drm_bench_parse(bench, buf);
+	if (!ret)
+		rockchip_drm_bench_run(bench);
+	mutex_unlock(&bench->lock);
+
+	return ret ? ret : len;
+}
+
+static const struct file_operations rockchip_drm_bench_fops = {
+	.owner = THIS_MODULE,
+	.open = rockchip_drm_bench_open,
+	.read = seq_read,
+	.write = rockchip_drm_bench_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void rockchip_drm_bench_init(struct drm_device *dev)
+{
+	struct rockchip_drm_bench *bench = &rockchip_drm_bench;
+
+	if (bench->dev || !dev->primary || !dev->primary->debugfs_root)
+		return;
+
+	bench->dev = dev;
+	mutex_init(&bench->lock);
+	debugfs_create_file("display_bench", 0644, dev->primary->debugfs_root,
+			    bench, &rockchip_drm_bench_fops);
+}
+
 static void rockchip_drm_self_test_commit(struct work_struct *work)
 {
 	struct rockchip_drm_self_test *self_test =
@@ -132,6 +647,8 @@ static void rockchip_drm_self_test_commit(struct work_struct *work)
 		return;
 	}
 
+	rockchip_drm_bench_init(self_test->dev);
+
 	/* alloc buffer */
 	if (!self_test->drm_buffer[0]) {
 		ret = rockchip_drm_self_test_alloc_buffer(self_test);
@@ -183,6 +183,8 @@ struct vop_plane_state {
 	unsigned long offset;
 	int pdaf_data_type;
 	bool async_commit;
+	/* only the buffer changed since the last commit, see vop_plane_fb_only() */
+	bool fb_only;
 	struct vop_dump_list *planlist;
 };
 
@@ -1730,6 +1732,39 @@ static bool rockchip_vop_mod_supported(struct drm_plane *plane,
 	return vop_convert_afbc_format(format) >= 0;
 }
 
+/*
+ * A video overlay flipping at the frame rate only ever swaps the buffer,
+ * keep the validated geometry of the current state then and let
+ * atomic_update write the buffer address alone.
+ */
+static bool vop_plane_fb_only(struct drm_plane *plane,
+			      struct drm_plane_state *state,
+			      struct drm_crtc_state *crtc_state)
+{
+	struct drm_plane_state *old_state = plane->state;
+	struct drm_framebuffer *fb = state->fb;
+	struct drm_framebuffer *old_fb = old_state->fb;
+
+	if (!old_state->visible || !old_fb || old_state->crtc != state->crtc ||
+	    drm_atomic_crtc_needs_modeset(crtc_state))
+		return false;
+
+	if (old_state->src_x != state->src_x || old_state->src_y != state->src_y ||
+	    old_state->src_w != state->src_w || old_state->src_h != state->src_h ||
+	    old_state->crtc_x != state->crtc_x || old_state->crtc_y != state->crtc_y ||
+	    old_state->crtc_w != state->crtc_w || old_state->crtc_h != state->crtc_h ||
+	    old_state->rotation != state->rotation)
+		return false;
+
+	if (old_fb->format != fb->format || old_fb->modifier != fb->modifier ||
+	    old_fb->width != fb->width || old_fb->height != fb->height ||
+	    old_fb->pitches[0] != fb->pitches[0] ||
+	    old_fb->pitches[1] != fb->pitches[1])
+		return false;
+
+	return true;
+}
+
 static int vop_plane_atomic_check(struct drm_plane *plane,
 			   struct drm_plane_state *state)
 {
@@ -1752,6 +1787,7 @@ static int vop_plane_atomic_check(struct drm_plane *plane,
 	unsigned long offset;
 	dma_addr_t dma_addr;
 
+	vop_plane_state->fb_only = false;
 	crtc = crtc ? crtc : plane->state->crtc;
 	if (!crtc || !fb) {
 		plane->state->visible = false;
@@ -1765,6 +1801,15 @@ static int vop_plane_atomic_check(struct drm_plane *plane,
 	vop_plane_state->zpos = state->zpos;
 	vop_plane_state->blend_mode = state->pixel_blend_mode;
 
+	if (vop_plane_fb_only(plane, state, crtc_state)) {
+		/* src, dest and format were copied along with the state */
+		state->visible = true;
+		state->src = plane->state->src;
+		state->dst = plane->state->dst;
+		vop_plane_state->fb_only = true;
+		goto dma_addr;
+	}
+
 	ret = drm_atomic_helper_check_plane_state(state, crtc_state,
 						  min_scale, max_scale,
 						  true, true);
@@ -1828,6 +1873,7 @@ static int vop_plane_atomic_check(struct drm_plane *plane,
 		return -EINVAL;
 	}
 
+dma_addr:
 	offset = (src->x1 >> 16) * fb->format->cpp[0];
 	vop_plane_state->offset = offset + fb->offsets[0];
 	if (state->rotation & DRM_MODE_REFLECT_Y)
@@ -1951,6 +1997,51 @@ static void vop_plane_setup_color_key(struct drm_plane *plane)
 	VOP_WIN_SET(vop, win, color_key, color_key);
 }
 
+/*
+ * The crtc side may still have changed blending, csc or the layer order
+ * in the same commit, fall back to the full update then.
+ */
+static bool vop_plane_fb_only_update(struct drm_plane *plane,
+				     struct drm_plane_state *old_state)
+{
+	struct drm_plane_state *state = plane->state;
+	struct vop_plane_state *vop_plane_state = to_vop_plane_state(state);
+	struct vop_plane_state *old_vop_plane_state = to_vop_plane_state(old_state);
+	struct drm_crtc_state *old_crtc_state;
+	struct vop *vop = to_vop(state->crtc);
+
+	if (!vop_plane_state->fb_only || !old_state->visible)
+		return false;
+
+	if (vop_plane_state->format != old_vop_plane_state->format ||
+	    vop_plane_state->global_alpha != old_vop_plane_state->global_alpha ||
+	    vop_plane_state->blend_mode != old_vop_plane_state->blend_mode ||
+	    vop_plane_state->color_key != old_vop_plane_state->color_key ||
+	    vop_plane_state->csc_mode != old_vop_plane_state->csc_mode ||
+	    vop_plane_state->y2r_en != old_vop_plane_state->y2r_en ||
+	    vop_plane_state->r2r_en != old_vop_plane_state->r2r_en ||
+	    vop_plane_state->r2y_en != old_vop_plane_state->r2y_en ||
+	    vop_plane_state->y2r_table != old_vop_plane_state->y2r_table ||
+	    vop_plane_state->r2r_table != old_vop_plane_state->r2r_table ||
+	    vop_plane_state->r2y_table != old_vop_plane_state->r2y_table)
+		return false;
+
+	old_crtc_state = drm_atomic_get_old_crtc_state(old_state->state, state->crtc);
+	if (old_crtc_state &&
+	    to_rockchip_crtc_state(old_crtc_state)->dsp_layer_sel !=
+	    to_rockchip_crtc_state(state->crtc->state)->dsp_layer_sel)
+		return false;
+
+#if defined(CONFIG_ROCKCHIP_DRM_DEBUG)
+	/* the buffer dump wants the full plane info */
+	if (vop->rockchip_crtc.vop_dump_status == DUMP_KEEP ||
+	    vop->rockchip_crtc.vop_dump_times > 0)
+		return false;
+#endif
+
+	return vop->is_enabled;
+}
+
 static void vop_plane_atomic_update(struct drm_plane *plane,
 		struct drm_plane_state *old_state)
 {
@@ -1974,6 +2065,7 @@ static void vop_plane_atomic_update(struct drm_plane *plane,
 	uint32_t val;
 	bool rb_swap, global_alpha_en;
 	int is_yuv = fb->format->is_yuv;
+	u64 start_ns = ktime_get_ns();
 
 #if defined(CONFIG_ROCKCHIP_DRM_DEBUG)
 	bool AFBC_flag = false;
@@ -2011,6 +2103,18 @@ static void vop_plane_atomic_update(struct drm_plane *plane,
 		return;
 	}
 
+	if (vop_plane_fb_only_update(plane, old_state)) {
+		spin_lock(&vop->reg_lock);
+		VOP_WIN_SET(vop, win, yrgb_mst, vop_plane_state->yrgb_mst);
+		if (is_yuv)
+			VOP_WIN_SET(vop, win, uv_mst, vop_plane_state->uv_mst);
+		spin_unlock(&vop->reg_lock);
+		vop->is_iommu_needed = true;
+		rockchip_drm_update_stats_add(crtc, ROCKCHIP_UPDATE_FB_ONLY,
+					      ktime_get_ns() - start_ns);
+		return;
+	}
+
 	mode = &crtc->state->adjusted_mode;
 	actual_w = drm_rect_width(src) >> 16;
 	actual_h = drm_rect_height(src) >> 16;
@@ -2140,6 +2244,8 @@ static void vop_plane_atomic_update(struct drm_plane *plane,
 	 * actual_w, actual_h)
 	 */
 	vop->is_iommu_needed = true;
+	rockchip_drm_update_stats_add(crtc, ROCKCHIP_UPDATE_FULL,
+				      ktime_get_ns() - start_ns);
 #if defined(CONFIG_ROCKCHIP_DRM_DEBUG)
 	kfree(vop_plane_state->planlist);
 	vop_plane_state->planlist = NULL;
@@ -2731,6 +2837,7 @@ static int vop_crtc_debugfs_init(struct drm_minor *minor, struct drm_crtc *crtc)
 	}
 #if defined(CONFIG_ROCKCHIP_DRM_DEBUG)
 	rockchip_drm_add_dump_buffer(crtc, vop->debugfs);
+	rockchip_drm_add_update_stats(crtc, vop->debugfs);
 #endif
 	for (i = 0; i < ARRAY_SIZE(vop_debugfs_files); i++)
 		vop->debugfs_files[i].data = vop;
@@ -2973,6 +3080,38 @@ static void vop_set_out_mode(struct vop *vop, u32 mode)
 
 }
 
+/*
+ * with mcu-hold-mode the panel keeps its own frame memory and the vop
+ * only sends a frame on a rising edge of mcu_frame_st.
+ */
+static void vop_mcu_frame_push(struct vop *vop)
+{
+	VOP_CTRL_SET(vop, mcu_frame_st, 0);
+	VOP_CTRL_SET(vop, mcu_frame_st, 1);
+}
+
+static int vop_crtc_frame_push(struct drm_crtc *crtc)
+{
+	struct vop *vop = to_vop(crtc);
+	unsigned long flags;
+	int ret = 0;
+
+	if (!vop->mcu_timing.mcu_pix_total || !vop->mcu_timing.mcu_hold_mode)
+		return -EOPNOTSUPP;
+
+	mutex_lock(&vop->vop_lock);
+	if (vop->is_enabled) {
+		spin_lock_irqsave(&vop->irq_lock, flags);
+		vop_mcu_frame_push(vop);
+		spin_unlock_irqrestore(&vop->irq_lock, flags);
+	} else {
+		ret = -ENODEV;
+	}
+	mutex_unlock(&vop->vop_lock);
+
+	return ret;
+}
+
 static void vop_crtc_send_mcu_cmd(struct drm_crtc *crtc,  u32 type, u32 value)
 {
 	struct rockchip_crtc_state *state;
@@ -3061,6 +3200,7 @@ static const struct rockchip_crtc_funcs private_crtc_funcs = {
 	.crtc_close = vop_crtc_close,
 	.crtc_send_mcu_cmd = vop_crtc_send_mcu_cmd,
 	.wait_vact_end = vop_crtc_wait_vact_end,
+	.frame_push = vop_crtc_frame_push,
 };
 
 static bool vop_crtc_mode_fixup(struct drm_crtc *crtc,
@@ -4036,8 +4176,12 @@ static void vop_crtc_atomic_flush(struct drm_crtc *crtc,
 	} else {
 		VOP_CTRL_SET(vop, reg_done_frm, 0);
 	}
-	if (vop->mcu_timing.mcu_pix_total)
-		VOP_CTRL_SET(vop, mcu_hold_mode, 0);
+	if (vop->mcu_timing.mcu_pix_total) {
+		if (vop->mcu_timing.mcu_hold_mode)
+			vop_mcu_frame_push(vop);
+		else
+			VOP_CTRL_SET(vop, mcu_hold_mode, 0);
+	}
 
 	spin_unlock_irqrestore(&vop->irq_lock, flags);
 
@@ -4408,6 +4552,14 @@ static irqreturn_t vop_isr(int irq, void *data)
 		} \
 	} while (0)
 
+	if (active_irqs & POST_BUF_EMPTY_INTR)
+		atomic_inc(&vop->rockchip_crtc.err_stats.post_buf_empty);
+	if (active_irqs & (WIN0_EMPTY_INTR | WIN1_EMPTY_INTR | WIN2_EMPTY_INTR |
+			   WIN3_EMPTY_INTR | HWC_EMPTY_INTR))
+		atomic_inc(&vop->rockchip_crtc.err_stats.win_empty);
+	if (active_irqs & BUS_ERROR_INTR)
+		atomic_inc(&vop->rockchip_crtc.err_stats.bus_error);
+
 	ERROR_HANDLER(BUS_ERROR);
 	ERROR_HANDLER(WIN0_EMPTY);
 	ERROR_HANDLER(WIN1_EMPTY);
@@ -10357,6 +10357,8 @@ static irqreturn_t vop2_isr(int irq, void *data)
 			ret = IRQ_HANDLED;
 		}
 
+		if (active_irqs & POST_BUF_EMPTY_INTR)
+			atomic_inc(&vp->rockchip_crtc.err_stats.post_buf_empty);
 		ERROR_HANDLER(POST_BUF_EMPTY);
 
 		/* Unhandled irqs are spurious. */
@@ -10373,6 +10375,9 @@ static irqreturn_t vop2_isr(int irq, void *data)
 	for (i = 0; i < axi_max; i++) {
 		active_irqs = axi_irqs[i];
 
+		/* the axi buses are shared by all ports, account them on vp0 */
+		if (active_irqs & BUS_ERROR_INTR)
+			atomic_inc(&vop2->vps[0].rockchip_crtc.err_stats.bus_error);
 		ERROR_HANDLER(BUS_ERROR);
 
 		/* Unhandled irqs are spurious. */
@@ -27,6 +27,7 @@
 #include <linux/math64.h>
 #include <linux/reboot.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
 #include <linux/soc/rockchip/rockchip_thunderboot_service.h>
 
 
@@ -103,6 +104,15 @@ enum {
 #define WAIT_TIMEOUT      200 /* ms */
 #define DEFAULT_SCL_RATE  (100 * 1000) /* Hz */
 
+/*
+ * Start the next message of a transfer from the irq of the previous one,
+ * instead of waking the caller to set it up. A register write, read back
+ * and a combined write/read each cost one caller round trip less.
+ */
+static bool queued_xfer = true;
+module_param(queued_xfer, bool, 0644);
+MODULE_PARM_DESC(queued_xfer, "chain the messages of a transfer in the irq");
+
 /**
  * struct i2c_spec_values:
  * @min_hold_start_ns: min hold time (repeated) START condition
@@ -212,6 +222,10 @@ struct rk3x_i2c_soc_data {
  * @state: state of i2c transfer
  * @processed: byte length which has been send or received
  * @error: error code for i2c transfer
+ * @msgs: messages of the transfer in progress, for queued_xfer
+ * @num: number of messages in @msgs
+ * @next: first message in @msgs not started yet
+ * @stats: transfer statistics of the bus
  * @i2c_restart_nb: make sure the i2c transfer to be finished
  * @system_restarting: true if system is restarting
  * @tb_cl: client for rockchip thunder boot service
@@ -251,6 +265,23 @@ struct rk3x_i2c {
 	int error;
 	unsigned int suspended:1;
 
+	/* Transfer in progress */
+	struct i2c_msg *msgs;
+	int num;
+	int next;
+
+	struct {
+		u64 xfers;
+		u64 msgs;
+		u64 bytes;
+		u64 errors;
+		u64 timeouts;
+		/* messages started from the irq */
+		u64 queued;
+		u64 total_us;
+		u64 max_us;
+	} stats;
+
 	struct notifier_block i2c_restart_nb;
 	bool system_restarting;
 	struct rk_tb_client tb_cl;
@@ -259,6 +290,8 @@ struct rk3x_i2c {
 
 static void rk3x_i2c_prepare_read(struct rk3x_i2c *i2c);
 static int rk3x_i2c_fill_transmit_buf(struct rk3x_i2c *i2c, bool sended);
+static int rk3x_i2c_setup(struct rk3x_i2c *i2c, struct i2c_msg *msgs, int num);
+static void rk3x_i2c_start(struct rk3x_i2c *i2c);
 
 static inline void rk3x_i2c_wake_up(struct rk3x_i2c *i2c)
 {
@@ -376,6 +409,33 @@ static void rk3x_i2c_start(struct rk3x_i2c *i2c)
 		rk3x_i2c_prepare_read(i2c);
 }
 
+/**
+ * Start the next message right away, with queued_xfer.
+ *
+ * Must be called with i2c->lock held, the current message done.
+ */
+static bool rk3x_i2c_queue_next(struct rk3x_i2c *i2c)
+{
+	u32 ctrl;
+
+	if (!queued_xfer || i2c->error || i2c->next >= i2c->num)
+		return false;
+
+	/* the same reset as for a repeated START from rk3x_i2c_xfer */
+	ctrl = i2c_readl(i2c, REG_CON) & REG_CON_TUNING_MASK;
+	i2c_writel(i2c, ctrl, REG_CON);
+
+	i2c->next += rk3x_i2c_setup(i2c, i2c->msgs + i2c->next,
+				    i2c->num - i2c->next);
+	if (i2c->next >= i2c->num)
+		i2c->is_last_msg = true;
+	i2c->stats.queued++;
+
+	rk3x_i2c_start(i2c);
+
+	return true;
+}
+
 /**
  * Generate a STOP condition, which triggers a REG_INT_STOP interrupt.
  *
@@ -399,6 +459,8 @@ static void rk3x_i2c_stop(struct rk3x_i2c *i2c, int error)
 		ctrl |= REG_CON_STOP;
 		ctrl &= ~REG_CON_START;
 		i2c_writel(i2c, ctrl, REG_CON);
+	} else if (rk3x_i2c_queue_next(i2c)) {
+		/* the caller keeps waiting, for the whole transfer */
 	} else {
 		/* Signal rk3x_i2c_xfer to start the next message. */
 		i2c->busy = false;
@@ -1206,9 +1268,11 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 {
 	struct rk3x_i2c *i2c = (struct rk3x_i2c *)adap->algo_data;
 	unsigned long timeout, flags;
+	ktime_t start = ktime_get();
 	u32 val, ipd = 0;
+	u64 us;
 	int ret = 0;
-	int i;
+	int i, j;
 
 	if (i2c->suspended)
 		return -EACCES;
@@ -1219,12 +1283,14 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 	clk_enable(i2c->pclk);
 
 	i2c->is_last_msg = false;
+	i2c->msgs = msgs;
+	i2c->num = num;
 
 	/*
 	 * Process msgs. We can handle more than one message at once (see
-	 * rk3x_i2c_setup()).
+	 * rk3x_i2c_setup()), and all of them with queued_xfer.
 	 */
-	for (i = 0; i < num; i += ret) {
+	for (i = 0; i < num; i = i2c->next) {
 		unsigned long xfer_time = WAIT_TIMEOUT;
 		int len;
 
@@ -1233,15 +1299,20 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 			dev_err(i2c->dev, "rk3x_i2c_setup() failed\n");
 			break;
 		}
+		i2c->next = i + ret;
 
 		/*
 		 * Transfer time in mSec = Total bits / transfer rate + interval time
 		 * Total bits = 9 bits per byte (including ACK bit) + Start & stop bits
+		 * The irq may go on with the rest of the msgs with queued_xfer.
 		 */
 		if (ret == 2)
 			len = msgs[i + 1].len;
 		else
 			len = msgs[i].len;
+		if (queued_xfer)
+			for (j = i + ret; j < num; j++)
+				len += msgs[j].len;
 		xfer_time += len / 64;
 		xfer_time += DIV_ROUND_CLOSEST(((len * 9) + 2) * MSEC_PER_SEC,
 					       i2c->t.bus_freq_hz);
@@ -1291,6 +1362,21 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 	clk_disable(i2c->pclk);
 	clk_disable(i2c->clk);
 
+	i2c->msgs = NULL;
+	i2c->num = 0;
+	i2c->stats.xfers++;
+	i2c->stats.msgs += num;
+	for (j = 0; j < num; j++)
+		i2c->stats.bytes += msgs[j].len;
+	if (ret == -ETIMEDOUT)
+		i2c->stats.timeouts++;
+	else if (ret < 0)
+		i2c->stats.errors++;
+	us = ktime_us_delta(ktime_get(), start);
+	i2c->stats.total_us += us;
+	if (us > i2c->stats.max_us)
+		i2c->stats.max_us = us;
+
 	spin_unlock_irqrestore(&i2c->lock, flags);
 
 	if ((ret == -ETIMEDOUT) && (ipd & REG_INT_SLV_HDSCL)) {
@@ -1431,6 +1517,50 @@ static __maybe_unused int rk3x_i2c_resume_noirq(struct device *dev)
 	return 0;
 }
 
+static ssize_t xfer_stats_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct rk3x_i2c *i2c = dev_get_drvdata(dev);
+	unsigned long flags;
+	u64 avg_us;
+	int len;
+
+	spin_lock_irqsave(&i2c->lock, flags);
+	avg_us = i2c->stats.xfers ?
+		 div64_u64(i2c->stats.total_us, i2c->stats.xfers) : 0;
+	len = sysfs_emit(buf,
+			 "xfers: %llu msgs: %llu bytes: %llu errors: %llu timeouts: %llu queued: %llu\n"
+			 "latency avg: %llu us max: %llu us\n",
+			 i2c->stats.xfers, i2c->stats.msgs, i2c->stats.bytes,
+			 i2c->stats.errors, i2c->stats.timeouts,
+			 i2c->stats.queued, avg_us, i2c->stats.max_us);
+	spin_unlock_irqrestore(&i2c->lock, flags);
+
+	return len;
+}
+
+/* any write clears the statistics */
+static ssize_t xfer_stats_store(struct device *dev,
+				 struct device_attribute *attr,
+				 const char *buf, size_t count)
+{
+	struct rk3x_i2c *i2c = dev_get_drvdata(dev);
+	unsigned long flags;
+
+	spin_lock_irqsave(&i2c->lock, flags);
+	memset(&i2c->stats, 0, sizeof(i2c->stats));
+	spin_unlock_irqrestore(&i2c->lock, flags);
+
+	return count;
+}
+static DEVICE_ATTR_RW(xfer_stats);
+
+static struct attribute *rk3x_i2c_attrs[] = {
+	&dev_attr_xfer_stats.attr,
+	NULL
+};
+ATTRIBUTE_GROUPS(rk3x_i2c);
+
 static u32 rk3x_i2c_func(struct i2c_adapter *adap)
 {
 	return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL | I2C_FUNC_PROTOCOL_MANGLING;
@@ -1633,6 +1763,8 @@ static int rk3x_i2c_probe(struct platform_device *pdev)
 	    device_property_read_bool(&pdev->dev, "rockchip,amp-shared")) {
 		i2c->tb_cl.data = i2c;
 		i2c->tb_cl.cb = rk3x_i2c_tb_cb;
+		i2c->tb_cl.name = dev_name(&pdev->dev);
+		i2c->tb_cl.id = RK_TB_CLIENT_I2C;
 		irq_set_status_flags(irq, IRQ_NOAUTOEN);
 	}
 
@@ -1740,6 +1872,7 @@ static struct platform_driver rk3x_i2c_driver = {
 		.name  = "rk3x-i2c",
 		.of_match_table = rk3x_i2c_match,
 		.pm = &rk3x_i2c_pm_ops,
+		.dev_groups = rk3x_i2c_groups,
 	},
 };
 
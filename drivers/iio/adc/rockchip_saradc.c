@@ -16,6 +16,7 @@
 #include <linux/reset.h>
 #include <linux/regulator/consumer.h>
 #include <linux/iio/buffer.h>
+#include <linux/iio/events.h>
 #include <linux/iio/iio.h>
 #include <linux/iio/trigger_consumer.h>
 #include <linux/iio/triggered_buffer.h>
@@ -36,6 +37,9 @@
 
 #define SARADC_TIMEOUT			msecs_to_jiffies(100)
 #define SARADC_MAX_CHANNELS		8
+/* rate of the threshold monitor */
+#define SARADC_MONITOR_HZ_DEFAULT	10
+#define SARADC_MONITOR_HZ_MAX		1000
 
 /* v2 registers */
 #define SARADC2_CONV_CON		0x0
@@ -75,6 +79,22 @@ struct rockchip_saradc {
 	const struct iio_chan_spec *last_chan;
 	struct notifier_block nb;
 	bool			suspended;
+
+	/*
+	 * threshold monitor: samples the channels with an event enabled at
+	 * monitor_hz and sends an iio event when one crosses its threshold,
+	 * so a light sensor or battery client sleeps on the event fd.
+	 */
+	struct iio_dev		*indio_dev;
+	struct delayed_work	monitor;
+	unsigned int		monitor_hz;
+	unsigned long		ev_rising;
+	unsigned long		ev_falling;
+	/* last sample was above the rising / below the falling threshold */
+	unsigned long		ev_above;
+	unsigned long		ev_below;
+	u16			thresh_high[SARADC_MAX_CHANNELS];
+	u16			thresh_low[SARADC_MAX_CHANNELS];
 #ifdef CONFIG_ROCKCHIP_SARADC_TEST_CHN
 	bool			test;
 	u32			chn;
@@ -214,11 +234,197 @@ static int rockchip_saradc_read_raw(struct iio_dev *indio_dev,
 		*val = info->uv_vref / 1000;
 		*val2 = chan->scan_type.realbits;
 		return IIO_VAL_FRACTIONAL_LOG2;
+	case IIO_CHAN_INFO_SAMP_FREQ:
+		*val = info->monitor_hz;
+		return IIO_VAL_INT;
 	default:
 		return -EINVAL;
 	}
 }
 
+static int rockchip_saradc_write_raw(struct iio_dev *indio_dev,
+				     struct iio_chan_spec const *chan,
+				     int val, int val2, long mask)
+{
+	struct rockchip_saradc *info = iio_priv(indio_dev);
+
+	if (mask != IIO_CHAN_INFO_SAMP_FREQ)
+		return -EINVAL;
+	if (val <= 0 || val > SARADC_MONITOR_HZ_MAX)
+		return -EINVAL;
+
+	WRITE_ONCE(info->monitor_hz, val);
+
+	return 0;
+}
+
+static unsigned long rockchip_saradc_monitor_delay(struct rockchip_saradc *info)
+{
+	return max_t(unsigned long, HZ / READ_ONCE(info->monitor_hz), 1);
+}
+
+/* with mlock held */
+static void rockchip_saradc_monitor_update(struct rockchip_saradc *info)
+{
+	if ((info->ev_rising | info->ev_falling) && !info->suspended)
+		queue_delayed_work(system_power_efficient_wq, &info->monitor,
+				   rockchip_saradc_monitor_delay(info));
+	else
+		cancel_delayed_work(&info->monitor);
+}
+
+static void rockchip_saradc_monitor_check(struct rockchip_saradc *info, int i,
+					  u16 val, s64 ts)
+{
+	struct iio_dev *indio_dev = info->indio_dev;
+
+	if (test_bit(i, &info->ev_rising)) {
+		if (val <= info->thresh_high[i])
+			__clear_bit(i, &info->ev_above);
+		else if (!__test_and_set_bit(i, &info->ev_above))
+			iio_push_event(indio_dev,
+				       IIO_UNMOD_EVENT_CODE(IIO_VOLTAGE, i,
+							    IIO_EV_TYPE_THRESH,
+							    IIO_EV_DIR_RISING),
+				       ts);
+	}
+
+	if (test_bit(i, &info->ev_falling)) {
+		if (val >= info->thresh_low[i])
+			__clear_bit(i, &info->ev_below);
+		else if (!__test_and_set_bit(i, &info->ev_below))
+			iio_push_event(indio_dev,
+				       IIO_UNMOD_EVENT_CODE(IIO_VOLTAGE, i,
+							    IIO_EV_TYPE_THRESH,
+							    IIO_EV_DIR_FALLING),
+				       ts);
+	}
+}
+
+/*
+ * deferrable, an idle system is not woken up just to sample; the first
+ * sample after an event is enabled reports the state it is already in.
+ */
+static void rockchip_saradc_monitor_work(struct work_struct *work)
+{
+	struct rockchip_saradc *info = container_of(to_delayed_work(work),
+						    struct rockchip_saradc,
+						    monitor);
+	struct iio_dev *indio_dev = info->indio_dev;
+	unsigned long mask;
+	int i;
+
+	mutex_lock(&indio_dev->mlock);
+	mask = info->ev_rising | info->ev_falling;
+	if (!mask || info->suspended)
+		goto out;
+#ifdef CONFIG_ROCKCHIP_SARADC_TEST_CHN
+	if (info->test)
+		goto next;
+#endif
+
+	for_each_set_bit(i, &mask, info->data->num_channels) {
+		if (rockchip_saradc_conversion(info, &info->data->channels[i])) {
+			rockchip_saradc_power_down(info);
+			continue;
+		}
+		rockchip_saradc_monitor_check(info, i, info->last_val,
+					      iio_get_time_ns(indio_dev));
+	}
+
+#ifdef CONFIG_ROCKCHIP_SARADC_TEST_CHN
+next:
+#endif
+	queue_delayed_work(system_power_efficient_wq, &info->monitor,
+			   rockchip_saradc_monitor_delay(info));
+out:
+	mutex_unlock(&indio_dev->mlock);
+}
+
+static int rockchip_saradc_read_event_config(struct iio_dev *indio_dev,
+					     const struct iio_chan_spec *chan,
+					     enum iio_event_type type,
+					     enum iio_event_direction dir)
+{
+	struct rockchip_saradc *info = iio_priv(indio_dev);
+
+	if (dir == IIO_EV_DIR_RISING)
+		return test_bit(chan->channel, &info->ev_rising);
+
+	return test_bit(chan->channel, &info->ev_falling);
+}
+
+static int rockchip_saradc_write_event_config(struct iio_dev *indio_dev,
+					      const struct iio_chan_spec *chan,
+					      enum iio_event_type type,
+					      enum iio_event_direction dir,
+					      int state)
+{
+	struct rockchip_saradc *info = iio_priv(indio_dev);
+	unsigned long *enabled, *last;
+
+	if (dir == IIO_EV_DIR_RISING) {
+		enabled = &info->ev_rising;
+		last = &info->ev_above;
+	} else {
+		enabled = &info->ev_falling;
+		last = &info->ev_below;
+	}
+
+	mutex_lock(&indio_dev->mlock);
+	if (state)
+		__set_bit(chan->channel, enabled);
+	else
+		__clear_bit(chan->channel, enabled);
+	__clear_bit(chan->channel, last);
+	rockchip_saradc_monitor_update(info);
+	mutex_unlock(&indio_dev->mlock);
+
+	return 0;
+}
+
+static int rockchip_saradc_read_event_value(struct iio_dev *indio_dev,
+					    const struct iio_chan_spec *chan,
+					    enum iio_event_type type,
+					    enum iio_event_direction dir,
+					    enum iio_event_info ev_info,
+					    int *val, int *val2)
+{
+	struct rockchip_saradc *info = iio_priv(indio_dev);
+
+	if (dir == IIO_EV_DIR_RISING)
+		*val = info->thresh_high[chan->channel];
+	else
+		*val = info->thresh_low[chan->channel];
+
+	return IIO_VAL_INT;
+}
+
+static int rockchip_saradc_write_event_value(struct iio_dev *indio_dev,
+					     const struct iio_chan_spec *chan,
+					     enum iio_event_type type,
+					     enum iio_event_direction dir,
+					     enum iio_event_info ev_info,
+					     int val, int val2)
+{
+	struct rockchip_saradc *info = iio_priv(indio_dev);
+
+	if (val < 0 || val > GENMASK(chan->scan_type.realbits - 1, 0))
+		return -EINVAL;
+
+	mutex_lock(&indio_dev->mlock);
+	if (dir == IIO_EV_DIR_RISING) {
+		info->thresh_high[chan->channel] = val;
+		__clear_bit(chan->channel, &info->ev_above);
+	} else {
+		info->thresh_low[chan->channel] = val;
+		__clear_bit(chan->channel, &info->ev_below);
+	}
+	mutex_unlock(&indio_dev->mlock);
+
+	return 0;
+}
+
 static irqreturn_t rockchip_saradc_isr(int irq, void *dev_id)
 {
 	struct rockchip_saradc *info = dev_id;
@@ -248,6 +454,25 @@ static irqreturn_t rockchip_saradc_isr(int irq, void *dev_id)
 
 static const struct iio_info rockchip_saradc_iio_info = {
 	.read_raw = rockchip_saradc_read_raw,
+	.write_raw = rockchip_saradc_write_raw,
+	.read_event_config = rockchip_saradc_read_event_config,
+	.write_event_config = rockchip_saradc_write_event_config,
+	.read_event_value = rockchip_saradc_read_event_value,
+	.write_event_value = rockchip_saradc_write_event_value,
+};
+
+static const struct iio_event_spec rockchip_saradc_events[] = {
+	{
+		.type = IIO_EV_TYPE_THRESH,
+		.dir = IIO_EV_DIR_RISING,
+		.mask_separate = BIT(IIO_EV_INFO_VALUE) |
+				 BIT(IIO_EV_INFO_ENABLE),
+	}, {
+		.type = IIO_EV_TYPE_THRESH,
+		.dir = IIO_EV_DIR_FALLING,
+		.mask_separate = BIT(IIO_EV_INFO_VALUE) |
+				 BIT(IIO_EV_INFO_ENABLE),
+	},
 };
 
 #define SARADC_CHANNEL(_index, _id, _res) {			\
@@ -256,6 +481,9 @@ static const struct iio_info rockchip_saradc_iio_info = {
 	.channel = _index,					\
 	.info_mask_separate = BIT(IIO_CHAN_INFO_RAW),		\
 	.info_mask_shared_by_type = BIT(IIO_CHAN_INFO_SCALE),	\
+	.info_mask_shared_by_all = BIT(IIO_CHAN_INFO_SAMP_FREQ),	\
+	.event_spec = rockchip_saradc_events,			\
+	.num_event_specs = ARRAY_SIZE(rockchip_saradc_events),	\
 	.datasheet_name = _id,					\
 	.scan_index = _index,					\
 	.scan_type = {						\
@@ -453,6 +681,13 @@ static void rockchip_saradc_pclk_disable(void *data)
 	clk_disable_unprepare(info->pclk);
 }
 
+static void rockchip_saradc_cancel_monitor(void *data)
+{
+	struct rockchip_saradc *info = data;
+
+	cancel_delayed_work_sync(&info->monitor);
+}
+
 static void rockchip_saradc_regulator_disable(void *data)
 {
 	struct rockchip_saradc *info = data;
@@ -644,6 +879,9 @@ static int rockchip_saradc_probe(struct platform_device *pdev)
 	}
 
 	init_completion(&info->completion);
+	info->indio_dev = indio_dev;
+	info->monitor_hz = SARADC_MONITOR_HZ_DEFAULT;
+	INIT_DEFERRABLE_WORK(&info->monitor, rockchip_saradc_monitor_work);
 
 	irq = platform_get_irq(pdev, 0);
 	if (irq < 0)
@@ -760,6 +998,11 @@ static int rockchip_saradc_probe(struct platform_device *pdev)
 	if (ret)
 		return ret;
 
+	ret = devm_add_action_or_reset(&pdev->dev,
+				       rockchip_saradc_cancel_monitor, info);
+	if (ret)
+		return ret;
+
 #ifdef CONFIG_ROCKCHIP_SARADC_TEST_CHN
 	info->wq = create_singlethread_workqueue("adc_wq");
 	INIT_DELAYED_WORK(&info->work, rockchip_saradc_test_work);
@@ -793,6 +1036,8 @@ static int rockchip_saradc_suspend(struct device *dev)
 	struct iio_dev *indio_dev = dev_get_drvdata(dev);
 	struct rockchip_saradc *info = iio_priv(indio_dev);
 
+	cancel_delayed_work_sync(&info->monitor);
+
 	/* Avoid reading saradc when suspending */
 	mutex_lock(&indio_dev->mlock);
 
@@ -824,7 +1069,10 @@ static int rockchip_saradc_resume(struct device *dev)
 	if (ret)
 		clk_disable_unprepare(info->pclk);
 
+	mutex_lock(&indio_dev->mlock);
 	info->suspended = false;
+	rockchip_saradc_monitor_update(info);
+	mutex_unlock(&indio_dev->mlock);
 
 	return ret;
 }
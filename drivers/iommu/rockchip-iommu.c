@@ -8,6 +8,7 @@
 
 #include <linux/clk.h>
 #include <linux/compiler.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/dma-iommu.h>
@@ -94,6 +95,17 @@ struct rk_iommu_domain {
 	spinlock_t iommus_lock; /* lock for iommus list */
 	spinlock_t dt_lock; /* lock for modifying page directory table */
 	bool shootdown_entire;
+	struct list_head node; /* entry in rk_domain_list */
+
+	/* page table stats, with dt_lock held */
+	unsigned int pt_count;
+	unsigned int pt_prealloc;
+	unsigned long mapped_pages;
+	/* physically contiguous runs mapped and their pages, for fragmentation */
+	unsigned long map_runs;
+	unsigned long map_run_pages;
+	atomic_long_t zap_lines;
+	atomic_long_t zap_all;
 
 	struct iommu_domain domain;
 };
@@ -135,6 +147,8 @@ struct rk_iommudata {
 };
 
 static struct device *dma_dev;
+static LIST_HEAD(rk_domain_list);
+static DEFINE_MUTEX(rk_domain_list_lock);
 static const struct rk_iommu_ops *rk_ops;
 static struct rk_iommu *rk_iommu_from_dev(struct device *dev);
 static char reserve_range[PAGE_SIZE] __aligned(PAGE_SIZE);
@@ -378,8 +392,8 @@ static void rk_iommu_zap_lines(struct rk_iommu *iommu, dma_addr_t iova_start,
 	int i;
 	dma_addr_t iova_end = iova_start + size;
 	/*
-	 * TODO(djkurtz): Figure out when it is more efficient to shootdown the
-	 * entire iotlb rather than iterate over individual iovas.
+	 * Callers shooting down more than RK_IOMMU_ZAP_LINES_MAX pages zap
+	 * the entire iotlb instead, see rk_iommu_zap_range().
 	 */
 	for (i = 0; i < iommu->num_mmu; i++) {
 		dma_addr_t iova;
@@ -896,6 +910,7 @@ static u32 *rk_dte_get_page_table(struct rk_iommu_domain *rk_domain,
 
 	dte = rk_ops->mk_dtentries(pt_dma);
 	*dte_addr = dte;
+	rk_domain->pt_count++;
 
 	rk_table_flush(rk_domain,
 		       rk_domain->dt_dma + dte_index * sizeof(u32), 1);
@@ -927,6 +942,8 @@ static size_t rk_iommu_unmap_iova(struct rk_iommu_domain *rk_domain,
 	}
 
 	rk_table_flush(rk_domain, pte_dma, pte_count);
+	rk_domain->mapped_pages -= min_t(unsigned long, pte_count,
+					 rk_domain->mapped_pages);
 
 	return pte_count * SPAGE_SIZE;
 }
@@ -973,16 +990,12 @@ static int rk_iommu_map_iova(struct rk_iommu_domain *rk_domain, u32 *pte_addr,
 		}
 	}
 
-	rk_table_flush(rk_domain, pte_dma, pte_total);
+	rk_domain->mapped_pages += pte_total;
 
 	/*
-	 * Zap the first and last iova to evict from iotlb any previously
-	 * mapped cachelines holding stale values for its dte and pte.
-	 * We only zap the first and last iova, since only they could have
-	 * dte or pte shared with an existing mapping.
+	 * The caller flushes the page table, and the iotlb is zapped once
+	 * for the whole mapping in rk_iommu_iotlb_sync_map().
 	 */
-	rk_iommu_zap_iova_first_last(rk_domain, iova, size);
-
 	return 0;
 unwind:
 	/* Unmap the range of iovas that we just mapped */
@@ -997,83 +1010,188 @@ static int rk_iommu_map_iova(struct rk_iommu_domain *rk_domain, u32 *pte_addr,
 	return -EADDRINUSE;
 }
 
-static int rk_iommu_map(struct iommu_domain *domain, unsigned long _iova,
-			phys_addr_t paddr, size_t size, int prot, gfp_t gfp)
+/* bytes of size from iova that lie in the page table of iova */
+static size_t rk_iova_pt_size(dma_addr_t iova, size_t size)
+{
+	size_t remain = (NUM_PT_ENTRIES - rk_iova_pte_index(iova)) * SPAGE_SIZE;
+
+	return min(size, remain);
+}
+
+/* map the part of a mapping that lies in one page table, with dt_lock held */
+static int rk_iommu_map_pt(struct rk_iommu_domain *rk_domain, dma_addr_t iova,
+			   phys_addr_t paddr, size_t size, int prot,
+			   dma_addr_t *pte_dma)
 {
-	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
-	unsigned long flags;
-	dma_addr_t pte_dma, iova = (dma_addr_t)_iova;
 	u32 *page_table, *pte_addr;
 	u32 dte, pte_index;
-	int ret;
 
-	spin_lock_irqsave(&rk_domain->dt_lock, flags);
-
-	/*
-	 * pgsize_bitmap specifies iova sizes that fit in one page table
-	 * (1024 4-KiB pages = 4 MiB).
-	 * So, size will always be 4096 <= size <= 4194304.
-	 * Since iommu_map() guarantees that both iova and size will be
-	 * aligned, we will always only be mapping from a single dte here.
-	 */
 	page_table = rk_dte_get_page_table(rk_domain, iova);
-	if (IS_ERR(page_table)) {
-		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
+	if (IS_ERR(page_table))
 		return PTR_ERR(page_table);
-	}
 
 	dte = rk_domain->dt[rk_iova_dte_index(iova)];
 	pte_index = rk_iova_pte_index(iova);
 	pte_addr = &page_table[pte_index];
-	pte_dma = rk_ops->pt_address(dte) + pte_index * sizeof(u32);
-	ret = rk_iommu_map_iova(rk_domain, pte_addr, pte_dma, iova,
-				paddr, size, prot);
+	*pte_dma = rk_ops->pt_address(dte) + pte_index * sizeof(u32);
+	return rk_iommu_map_iova(rk_domain, pte_addr, *pte_dma, iova,
+				 paddr, size, prot);
+}
+
+static int rk_iommu_map_pages(struct iommu_domain *domain, unsigned long _iova,
+			      phys_addr_t paddr, size_t pgsize, size_t pgcount,
+			      int prot, gfp_t gfp, size_t *mapped)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+	dma_addr_t pte_dma, iova = (dma_addr_t)_iova;
+	size_t len, size = pgsize * pgcount, done = 0;
+	unsigned long flags;
+	int ret = 0;
 
+	spin_lock_irqsave(&rk_domain->dt_lock, flags);
+	/* one table flush per page table the mapping spans */
+	while (done < size) {
+		len = rk_iova_pt_size(iova + done, size - done);
+		ret = rk_iommu_map_pt(rk_domain, iova + done, paddr + done,
+				      len, prot, &pte_dma);
+		if (ret)
+			break;
+		rk_table_flush(rk_domain, pte_dma, len / SPAGE_SIZE);
+		done += len;
+	}
+	if (done) {
+		rk_domain->map_runs++;
+		rk_domain->map_run_pages += done / SPAGE_SIZE;
+	}
 	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
 
+	*mapped = done;
 	return ret;
 }
 
-static size_t rk_iommu_unmap(struct iommu_domain *domain, unsigned long _iova,
-			     size_t size, struct iommu_iotlb_gather *gather)
+/*
+ * map a whole scatterlist under one dt_lock. the entries of one buffer
+ * mostly land in the same page table, which is flushed once for all of
+ * them when the mapping moves on to the next page table.
+ */
+static int rk_iommu_map_sg(struct iommu_domain *domain, unsigned long _iova,
+			   struct scatterlist *sg, unsigned int nents, int prot,
+			   gfp_t gfp, size_t *mapped)
 {
 	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+	dma_addr_t pte_dma, flush_dma = 0, iova = (dma_addr_t)_iova;
+	unsigned int flush_cnt = 0;
+	struct scatterlist *s;
+	size_t len, s_len, done = 0;
+	phys_addr_t s_phys, run_end = 0;
 	unsigned long flags;
-	dma_addr_t pte_dma, iova = (dma_addr_t)_iova;
-	phys_addr_t pt_phys;
-	u32 dte;
-	u32 *pte_addr;
-	size_t unmap_size;
-	struct rk_iommu *iommu = rk_iommu_get(rk_domain);
+	int i, ret = 0;
 
 	spin_lock_irqsave(&rk_domain->dt_lock, flags);
+	for_each_sg(sg, s, nents, i) {
+		s_phys = sg_phys(s);
+		s_len = s->length;
+		if (!IS_ALIGNED(s_phys | s_len, SPAGE_SIZE)) {
+			ret = -EINVAL;
+			break;
+		}
+		if (!i || s_phys != run_end)
+			rk_domain->map_runs++;
+		rk_domain->map_run_pages += s_len / SPAGE_SIZE;
+		run_end = s_phys + s_len;
+		while (s_len) {
+			len = rk_iova_pt_size(iova + done, s_len);
+			ret = rk_iommu_map_pt(rk_domain, iova + done, s_phys,
+					      len, prot, &pte_dma);
+			if (ret)
+				break;
+			/* ptes go on from the pending ones in the same table */
+			if (flush_cnt &&
+			    pte_dma != flush_dma + flush_cnt * sizeof(u32)) {
+				rk_table_flush(rk_domain, flush_dma, flush_cnt);
+				flush_cnt = 0;
+			}
+			if (!flush_cnt)
+				flush_dma = pte_dma;
+			flush_cnt += len / SPAGE_SIZE;
+			s_phys += len;
+			s_len -= len;
+			done += len;
+		}
+		if (ret)
+			break;
+	}
+	if (flush_cnt)
+		rk_table_flush(rk_domain, flush_dma, flush_cnt);
+	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
+
+	*mapped = done;
+	return ret;
+}
+
+static size_t rk_iommu_unmap_pt(struct rk_iommu_domain *rk_domain,
+				dma_addr_t iova, size_t size,
+				struct rk_iommu *iommu)
+{
+	dma_addr_t pte_dma;
+	phys_addr_t pt_phys;
+	u32 *pte_addr;
+	u32 dte;
 
-	/*
-	 * pgsize_bitmap specifies iova sizes that fit in one page table
-	 * (1024 4-KiB pages = 4 MiB).
-	 * So, size will always be 4096 <= size <= 4194304.
-	 * Since iommu_unmap() guarantees that both iova and size will be
-	 * aligned, we will always only be unmapping from a single dte here.
-	 */
 	dte = rk_domain->dt[rk_iova_dte_index(iova)];
 	/* Just return 0 if iova is unmapped */
-	if (!rk_dte_is_pt_valid(dte)) {
-		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
+	if (!rk_dte_is_pt_valid(dte))
 		return 0;
-	}
 
 	pt_phys = rk_ops->pt_address(dte);
 	pte_addr = (u32 *)phys_to_virt(pt_phys) + rk_iova_pte_index(iova);
 	pte_dma = pt_phys + rk_iova_pte_index(iova) * sizeof(u32);
-	unmap_size = rk_iommu_unmap_iova(rk_domain, pte_addr, pte_dma, size,
-					 iommu);
+	return rk_iommu_unmap_iova(rk_domain, pte_addr, pte_dma, size, iommu);
+}
+
+/* add an unmapped range to gather, zapping first a disjoint gathered one */
+static void rk_iommu_gather_add(struct iommu_domain *domain,
+				struct iommu_iotlb_gather *gather,
+				unsigned long iova, size_t size)
+{
+	unsigned long end = iova + size - 1;
+
+	if (!size)
+		return;
+	if (gather->pgsize &&
+	    (end + 1 < gather->start || iova > gather->end + 1))
+		iommu_iotlb_sync(domain, gather);
+	gather->pgsize = SPAGE_SIZE;
+	gather->start = min(gather->start, iova);
+	gather->end = max(gather->end, end);
+}
+
+static size_t rk_iommu_unmap_pages(struct iommu_domain *domain,
+				   unsigned long _iova, size_t pgsize,
+				   size_t pgcount,
+				   struct iommu_iotlb_gather *gather)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+	struct rk_iommu *iommu = rk_iommu_get(rk_domain);
+	dma_addr_t iova = (dma_addr_t)_iova;
+	size_t len, unmap_size, size = pgsize * pgcount, done = 0;
+	unsigned long flags;
 
+	spin_lock_irqsave(&rk_domain->dt_lock, flags);
+	while (done < size) {
+		len = rk_iova_pt_size(iova + done, size - done);
+		unmap_size = rk_iommu_unmap_pt(rk_domain, iova + done, len,
+					       iommu);
+		done += unmap_size;
+		if (unmap_size < len)
+			break;
+	}
 	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
 
-	/* Shootdown iotlb entries for iova range that was just unmapped */
-	rk_iommu_zap_iova(rk_domain, iova, unmap_size);
+	/* Shootdown iotlb entries at iotlb_sync, for all the gathered range */
+	rk_iommu_gather_add(domain, gather, iova, done);
 
-	return unmap_size;
+	return done;
 }
 
 static void rk_iommu_flush_tlb_all(struct iommu_domain *domain)
@@ -1105,6 +1223,47 @@ static void rk_iommu_flush_tlb_all(struct iommu_domain *domain)
 	spin_unlock_irqrestore(&rk_domain->iommus_lock, flags);
 }
 
+/* lines beyond this are cheaper to shoot down with a whole zap */
+#define RK_IOMMU_ZAP_LINES_MAX	64
+
+static void rk_iommu_zap_range(struct iommu_domain *domain,
+			       dma_addr_t iova, size_t size)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+
+	if (rk_domain->shootdown_entire)
+		return;
+	if (size > RK_IOMMU_ZAP_LINES_MAX * SPAGE_SIZE) {
+		atomic_long_inc(&rk_domain->zap_all);
+		rk_iommu_flush_tlb_all(domain);
+	} else {
+		atomic_long_add(size / SPAGE_SIZE, &rk_domain->zap_lines);
+		rk_iommu_zap_iova(rk_domain, iova, size);
+	}
+}
+
+static void rk_iommu_iotlb_sync(struct iommu_domain *domain,
+				struct iommu_iotlb_gather *gather)
+{
+	if (!gather->pgsize)
+		return;
+	rk_iommu_zap_range(domain, gather->start,
+			   gather->end - gather->start + 1);
+}
+
+/*
+ * Zap the first and last iova to evict from iotlb any previously
+ * mapped cachelines holding stale values for its dte and pte.
+ * We only zap the first and last iova, since only they could have
+ * dte or pte shared with an existing mapping.
+ */
+static void rk_iommu_iotlb_sync_map(struct iommu_domain *domain,
+				    unsigned long iova, size_t size)
+{
+	if (size)
+		rk_iommu_zap_iova_first_last(to_rk_domain(domain), iova, size);
+}
+
 static struct rk_iommu *rk_iommu_from_dev(struct device *dev)
 {
 	struct rk_iommudata *data = dev_iommu_priv_get(dev);
@@ -1236,6 +1395,66 @@ int rockchip_iommu_force_reset(struct device *dev)
 }
 EXPORT_SYMBOL(rockchip_iommu_force_reset);
 
+/*
+ * Allocate the page tables of [iova, iova + size) of the domain of dev up
+ * front. Page tables stay until the domain is freed, so a long-lived media
+ * domain no longer allocates them atomically on the map path of every
+ * buffer it sets up.
+ */
+int rockchip_iommu_prealloc_pt(struct device *dev, dma_addr_t iova, size_t size)
+{
+	struct iommu_domain *domain = iommu_get_domain_for_dev(dev);
+	struct rk_iommu_domain *rk_domain;
+	dma_addr_t end = iova + size;
+	unsigned long flags;
+	u32 *page_table;
+	dma_addr_t pt_dma;
+	u32 dte_index;
+
+	if (!domain || !dma_dev || !size)
+		return -ENODEV;
+
+	rk_domain = to_rk_domain(domain);
+	iova &= ~(dma_addr_t)(NUM_PT_ENTRIES * SPAGE_SIZE - 1);
+	for (; iova < end; iova += NUM_PT_ENTRIES * SPAGE_SIZE) {
+		dte_index = rk_iova_dte_index(iova);
+		if (rk_dte_is_pt_valid(READ_ONCE(rk_domain->dt[dte_index])))
+			continue;
+
+		page_table = (u32 *)get_zeroed_page(GFP_KERNEL | GFP_DMA32);
+		if (!page_table)
+			return -ENOMEM;
+
+		pt_dma = dma_map_single(dma_dev, page_table, SPAGE_SIZE,
+					DMA_TO_DEVICE);
+		if (dma_mapping_error(dma_dev, pt_dma)) {
+			free_page((unsigned long)page_table);
+			return -ENOMEM;
+		}
+
+		spin_lock_irqsave(&rk_domain->dt_lock, flags);
+		if (!rk_dte_is_pt_valid(rk_domain->dt[dte_index])) {
+			rk_domain->dt[dte_index] = rk_ops->mk_dtentries(pt_dma);
+			rk_table_flush(rk_domain, rk_domain->dt_dma +
+				       dte_index * sizeof(u32), 1);
+			rk_domain->pt_count++;
+			rk_domain->pt_prealloc++;
+			page_table = NULL;
+		}
+		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
+
+		/* raced with the map path */
+		if (page_table) {
+			dma_unmap_single(dma_dev, pt_dma, SPAGE_SIZE,
+					 DMA_TO_DEVICE);
+			free_page((unsigned long)page_table);
+		}
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(rockchip_iommu_prealloc_pt);
+
 static void rk_iommu_detach_device(struct iommu_domain *domain,
 				   struct device *dev)
 {
@@ -1351,6 +1570,10 @@ static struct iommu_domain *rk_iommu_domain_alloc(unsigned type)
 	spin_lock_init(&rk_domain->dt_lock);
 	INIT_LIST_HEAD(&rk_domain->iommus);
 
+	mutex_lock(&rk_domain_list_lock);
+	list_add_tail(&rk_domain->node, &rk_domain_list);
+	mutex_unlock(&rk_domain_list_lock);
+
 	rk_domain->domain.geometry.aperture_start = 0;
 	rk_domain->domain.geometry.aperture_end   = DMA_BIT_MASK(32);
 	rk_domain->domain.geometry.force_aperture = true;
@@ -1375,6 +1598,10 @@ static void rk_iommu_domain_free(struct iommu_domain *domain)
 
 	WARN_ON(!list_empty(&rk_domain->iommus));
 
+	mutex_lock(&rk_domain_list_lock);
+	list_del(&rk_domain->node);
+	mutex_unlock(&rk_domain_list_lock);
+
 	for (i = 0; i < NUM_DT_ENTRIES; i++) {
 		u32 dte = rk_domain->dt[i];
 		if (rk_dte_is_pt_valid(dte)) {
@@ -1504,9 +1731,12 @@ static const struct iommu_ops rk_iommu_ops = {
 	.domain_free = rk_iommu_domain_free,
 	.attach_dev = rk_iommu_attach_device,
 	.detach_dev = rk_iommu_detach_device,
-	.map = rk_iommu_map,
-	.unmap = rk_iommu_unmap,
+	.map_pages = rk_iommu_map_pages,
+	.map_sg = rk_iommu_map_sg,
+	.unmap_pages = rk_iommu_unmap_pages,
 	.flush_iotlb_all = rk_iommu_flush_tlb_all,
+	.iotlb_sync_map = rk_iommu_iotlb_sync_map,
+	.iotlb_sync = rk_iommu_iotlb_sync,
 	.probe_device = rk_iommu_probe_device,
 	.release_device = rk_iommu_release_device,
 	.iova_to_phys = rk_iommu_iova_to_phys,
@@ -1760,8 +1990,61 @@ static struct platform_driver rk_iommu_driver = {
 	},
 };
 
+#ifdef CONFIG_IOMMU_DEBUGFS
+static int rk_iommu_domains_show(struct seq_file *m, void *v)
+{
+	struct rk_iommu_domain *rk_domain;
+	unsigned long flags;
+	struct rk_iommu *iommu;
+
+	mutex_lock(&rk_domain_list_lock);
+	list_for_each_entry(rk_domain, &rk_domain_list, node) {
+		spin_lock_irqsave(&rk_domain->iommus_lock, flags);
+		iommu = list_first_entry_or_null(&rk_domain->iommus,
+						 struct rk_iommu, node);
+		seq_printf(m, "domain %p %s\n", rk_domain,
+			   iommu ? dev_name(iommu->dev) : "detached");
+		spin_unlock_irqrestore(&rk_domain->iommus_lock, flags);
+
+		spin_lock_irqsave(&rk_domain->dt_lock, flags);
+		seq_printf(m, "\tpage tables:%u prealloc:%u memory:%uKB mapped:%luKB\n",
+			   rk_domain->pt_count, rk_domain->pt_prealloc,
+			   (rk_domain->pt_count + 1) * 4,
+			   rk_domain->mapped_pages * 4);
+		seq_printf(m, "\truns:%lu pages/run:%lu\n",
+			   rk_domain->map_runs,
+			   rk_domain->map_runs ?
+			   rk_domain->map_run_pages / rk_domain->map_runs : 0);
+		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
+
+		seq_printf(m, "\tzap lines:%ld zap all:%ld shootdown entire:%d\n",
+			   atomic_long_read(&rk_domain->zap_lines),
+			   atomic_long_read(&rk_domain->zap_all),
+			   rk_domain->shootdown_entire);
+	}
+	mutex_unlock(&rk_domain_list_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rk_iommu_domains);
+
+static void rk_iommu_debugfs_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("rockchip", iommu_debugfs_dir);
+	debugfs_create_file("domains", 0444, dir, NULL, &rk_iommu_domains_fops);
+}
+#else
+static inline void rk_iommu_debugfs_init(void)
+{
+}
+#endif
+
 static int __init rk_iommu_init(void)
 {
+	rk_iommu_debugfs_init();
+
 	return platform_driver_register(&rk_iommu_driver);
 }
 subsys_initcall(rk_iommu_init);
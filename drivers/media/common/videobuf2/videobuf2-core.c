@@ -16,6 +16,8 @@
 
 #define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
 
+#include <linux/debugfs.h>
+#include <linux/dma-buf.h>
 #include <linux/err.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
@@ -34,6 +36,10 @@
 static int debug;
 module_param(debug, int, 0644);
 
+static bool dmabuf_cache = true;
+module_param(dmabuf_cache, bool, 0644);
+MODULE_PARM_DESC(dmabuf_cache, "Keep dmabuf attachments mapped across qbufs");
+
 #define dprintk(q, level, fmt, arg...)					\
 	do {								\
 		if (debug >= level)					\
@@ -303,6 +309,213 @@ static void __vb2_plane_dmabuf_put(struct vb2_buffer *vb, struct vb2_plane *p)
 	p->dbuf_mapped = 0;
 }
 
+/*
+ * A pool of dmabufs rotating through a queue is not queued in index order,
+ * so a plane that gets a different dmabuf than last time would detach and
+ * unmap the old one and attach and map the new one on every qbuf. The
+ * cache keeps the replaced attachment mapped and hands it back when its
+ * dmabuf is queued again, on whatever index.
+ */
+#define VB2_DMABUF_CACHE_SIZE	16
+
+struct vb2_dmabuf_cache_entry {
+	struct dma_buf *dbuf;
+	void *mem_priv;
+	struct device *dev;
+	unsigned int length;
+	unsigned int mapped:1;
+	u64 used;
+};
+
+struct vb2_dmabuf_cache {
+	struct list_head node;
+	struct vb2_queue *q;
+	struct vb2_dmabuf_cache_entry entry[VB2_DMABUF_CACHE_SIZE];
+	u64 seq;
+	u64 hits;
+	u64 misses;
+	u64 evicted;
+};
+
+static LIST_HEAD(vb2_dmabuf_caches);
+static DEFINE_MUTEX(vb2_dmabuf_cache_lock);
+/* of the queues gone */
+static u64 vb2_dmabuf_cache_hits, vb2_dmabuf_cache_misses;
+
+#ifdef CONFIG_VIDEO_ADV_DEBUG
+/* the plane moves between the buffer and the cache, keep the ops balanced */
+#define vb2_dmabuf_cache_count(vb, p, dir)				\
+	do {								\
+		(vb)->cnt_mem_attach_dmabuf += (dir) > 0;		\
+		(vb)->cnt_mem_detach_dmabuf += (dir) < 0;		\
+		if ((p)->dbuf_mapped) {					\
+			(vb)->cnt_mem_map_dmabuf += (dir) > 0;		\
+			(vb)->cnt_mem_unmap_dmabuf += (dir) < 0;	\
+		}							\
+	} while (0)
+#else
+#define vb2_dmabuf_cache_count(vb, p, dir)
+#endif
+
+static void vb2_dmabuf_cache_evict(struct vb2_queue *q,
+				   struct vb2_dmabuf_cache_entry *e)
+{
+	if (e->mapped && q->mem_ops->unmap_dmabuf)
+		q->mem_ops->unmap_dmabuf(e->mem_priv);
+	if (q->mem_ops->detach_dmabuf)
+		q->mem_ops->detach_dmabuf(e->mem_priv);
+	dma_buf_put(e->dbuf);
+	memset(e, 0, sizeof(*e));
+	q->dmabuf_cache->evicted++;
+}
+
+static void vb2_dmabuf_cache_flush(struct vb2_queue *q)
+{
+	struct vb2_dmabuf_cache *cache = q->dmabuf_cache;
+	int i;
+
+	if (!cache)
+		return;
+
+	for (i = 0; i < VB2_DMABUF_CACHE_SIZE; i++)
+		if (cache->entry[i].dbuf)
+			vb2_dmabuf_cache_evict(q, &cache->entry[i]);
+
+	mutex_lock(&vb2_dmabuf_cache_lock);
+	list_del(&cache->node);
+	vb2_dmabuf_cache_hits += cache->hits;
+	vb2_dmabuf_cache_misses += cache->misses;
+	mutex_unlock(&vb2_dmabuf_cache_lock);
+	kfree(cache);
+	q->dmabuf_cache = NULL;
+}
+
+/* keep the mapped plane p of vb in the cache instead of releasing it */
+static bool vb2_dmabuf_cache_put(struct vb2_buffer *vb, struct vb2_plane *p,
+				 struct device *dev)
+{
+	struct vb2_queue *q = vb->vb2_queue;
+	struct vb2_dmabuf_cache *cache = q->dmabuf_cache;
+	struct vb2_dmabuf_cache_entry *e, *victim = NULL;
+	int i;
+
+	if (!READ_ONCE(dmabuf_cache) || !p->mem_priv || !p->dbuf_mapped)
+		return false;
+
+	if (!cache) {
+		cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+		if (!cache)
+			return false;
+		cache->q = q;
+		q->dmabuf_cache = cache;
+		mutex_lock(&vb2_dmabuf_cache_lock);
+		list_add_tail(&cache->node, &vb2_dmabuf_caches);
+		mutex_unlock(&vb2_dmabuf_cache_lock);
+	}
+
+	for (i = 0; i < VB2_DMABUF_CACHE_SIZE; i++) {
+		e = &cache->entry[i];
+		/* freed by userspace, only the cache holds it */
+		if (e->dbuf && file_count(e->dbuf->file) == 1)
+			vb2_dmabuf_cache_evict(q, e);
+		if (!e->dbuf) {
+			victim = e;
+			break;
+		}
+		if (!victim || e->used < victim->used)
+			victim = e;
+	}
+	if (victim->dbuf)
+		vb2_dmabuf_cache_evict(q, victim);
+
+	victim->dbuf = p->dbuf;
+	victim->mem_priv = p->mem_priv;
+	victim->dev = dev;
+	victim->length = p->length;
+	victim->mapped = p->dbuf_mapped;
+	victim->used = ++cache->seq;
+	vb2_dmabuf_cache_count(vb, p, -1);
+
+	p->mem_priv = NULL;
+	p->dbuf = NULL;
+	p->dbuf_mapped = 0;
+
+	return true;
+}
+
+/* take the attachment of dbuf on dev from the cache into plane p of vb */
+static bool vb2_dmabuf_cache_get(struct vb2_buffer *vb, struct vb2_plane *p,
+				 struct dma_buf *dbuf, struct device *dev,
+				 unsigned int length)
+{
+	struct vb2_dmabuf_cache *cache = vb->vb2_queue->dmabuf_cache;
+	struct vb2_dmabuf_cache_entry *e;
+	int i;
+
+	if (!cache)
+		return false;
+
+	for (i = 0; i < VB2_DMABUF_CACHE_SIZE; i++) {
+		e = &cache->entry[i];
+		if (e->dbuf != dbuf || e->dev != dev || e->length != length)
+			continue;
+
+		/* the cache reference moves to the plane */
+		dma_buf_put(dbuf);
+		p->dbuf = e->dbuf;
+		p->mem_priv = e->mem_priv;
+		p->dbuf_mapped = e->mapped;
+		vb2_dmabuf_cache_count(vb, p, 1);
+		memset(e, 0, sizeof(*e));
+		cache->hits++;
+		return true;
+	}
+	cache->misses++;
+
+	return false;
+}
+
+#ifdef CONFIG_DEBUG_FS
+static int vb2_dmabuf_cache_show(struct seq_file *m, void *v)
+{
+	struct vb2_dmabuf_cache *cache;
+	int i, n;
+
+	mutex_lock(&vb2_dmabuf_cache_lock);
+	seq_printf(m, "released queues hits:%llu misses:%llu\n",
+		   vb2_dmabuf_cache_hits, vb2_dmabuf_cache_misses);
+	list_for_each_entry(cache, &vb2_dmabuf_caches, node) {
+		for (i = 0, n = 0; i < VB2_DMABUF_CACHE_SIZE; i++)
+			n += !!READ_ONCE(cache->entry[i].dbuf);
+		seq_printf(m, "%s entries:%d hits:%llu misses:%llu evicted:%llu\n",
+			   cache->q->name, n, cache->hits, cache->misses,
+			   cache->evicted);
+	}
+	mutex_unlock(&vb2_dmabuf_cache_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vb2_dmabuf_cache);
+
+static struct dentry *vb2_debugfs_dir;
+
+static int __init vb2_core_init(void)
+{
+	vb2_debugfs_dir = debugfs_create_dir("videobuf2", NULL);
+	debugfs_create_file("dmabuf_cache", 0444, vb2_debugfs_dir, NULL,
+			    &vb2_dmabuf_cache_fops);
+	return 0;
+}
+
+static void __exit vb2_core_exit(void)
+{
+	debugfs_remove_recursive(vb2_debugfs_dir);
+}
+
+module_init(vb2_core_init);
+module_exit(vb2_core_exit);
+#endif
+
 /*
  * __vb2_buf_dmabuf_put() - release memory associated with
  * a DMABUF shared buffer
@@ -602,6 +815,7 @@ static int __vb2_queue_free(struct vb2_queue *q, unsigned int buffers)
 
 	q->num_buffers -= buffers;
 	if (!q->num_buffers) {
+		vb2_dmabuf_cache_flush(q);
 		q->memory = VB2_MEMORY_UNKNOWN;
 		INIT_LIST_HEAD(&q->queued_list);
 	}
@@ -1240,6 +1454,7 @@ static int __prepare_dmabuf(struct vb2_buffer *vb)
 
 	for (plane = 0; plane < vb->num_planes; ++plane) {
 		struct dma_buf *dbuf = dma_buf_get(planes[plane].m.fd);
+		struct device *dev = q->alloc_devs[plane] ? : q->dev;
 
 		if (IS_ERR_OR_NULL(dbuf)) {
 			dprintk(q, 1, "invalid dmabuf fd for plane %d\n",
@@ -1277,15 +1492,20 @@ static int __prepare_dmabuf(struct vb2_buffer *vb)
 		}
 
 		/* Release previously acquired memory if present */
-		__vb2_plane_dmabuf_put(vb, &vb->planes[plane]);
+		if (!vb2_dmabuf_cache_put(vb, &vb->planes[plane], dev))
+			__vb2_plane_dmabuf_put(vb, &vb->planes[plane]);
 		vb->planes[plane].bytesused = 0;
 		vb->planes[plane].length = 0;
 		vb->planes[plane].m.fd = 0;
 		vb->planes[plane].data_offset = 0;
 
+		/* Still attached and mapped from an earlier qbuf */
+		if (vb2_dmabuf_cache_get(vb, &vb->planes[plane], dbuf, dev,
+					 planes[plane].length))
+			continue;
+
 		/* Acquire each plane's memory */
-		mem_priv = call_ptr_memop(vb, attach_dmabuf,
-				q->alloc_devs[plane] ? : q->dev,
+		mem_priv = call_ptr_memop(vb, attach_dmabuf, dev,
 				dbuf, planes[plane].length, q->dma_dir);
 		if (IS_ERR(mem_priv)) {
 			dprintk(q, 1, "failed to attach dmabuf\n");
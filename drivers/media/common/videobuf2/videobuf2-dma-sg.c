@@ -49,6 +49,14 @@ struct vb2_dma_sg_buf {
 	unsigned int			num_pages;
 	refcount_t			refcount;
 	struct vb2_vmarea_handler	handler;
+	/*
+	 * A cpu mapping of the buffer exists or existed, so the cache may
+	 * hold lines of it. Until then the prepare and finish syncs of a
+	 * buffer that only goes from device to device are skipped.
+	 */
+	bool				cpu_mapped;
+	/* lines written by the cpu not yet cleaned, e.g. the page zeroing */
+	bool				cpu_dirty;
 
 	struct dma_buf_attachment	*db_attach;
 };
@@ -155,6 +163,7 @@ static void *vb2_dma_sg_alloc(struct device *dev, unsigned long dma_attrs,
 	buf->handler.put = vb2_dma_sg_put;
 	buf->handler.arg = buf;
 
+	buf->cpu_dirty = true;
 	refcount_set(&buf->refcount, 1);
 
 	dprintk(1, "%s: Allocated buffer of %d pages\n",
@@ -202,7 +211,12 @@ static void vb2_dma_sg_prepare(void *buf_priv)
 	struct vb2_dma_sg_buf *buf = buf_priv;
 	struct sg_table *sgt = buf->dma_sgt;
 
+	/* nothing in the cache for the device unless the cpu wrote */
+	if (!buf->cpu_mapped && !buf->cpu_dirty)
+		return;
+
 	dma_sync_sgtable_for_device(buf->dev, sgt, buf->dma_dir);
+	buf->cpu_dirty = false;
 }
 
 static void vb2_dma_sg_finish(void *buf_priv)
@@ -210,9 +224,27 @@ static void vb2_dma_sg_finish(void *buf_priv)
 	struct vb2_dma_sg_buf *buf = buf_priv;
 	struct sg_table *sgt = buf->dma_sgt;
 
+	/* no cpu mapping to read stale lines through */
+	if (!buf->cpu_mapped)
+		return;
+
 	dma_sync_sgtable_for_cpu(buf->dev, sgt, buf->dma_dir);
 }
 
+/*
+ * The first cpu mapping of the buffer. The finish syncs skipped so far
+ * may have left stale lines, e.g. from speculation through the linear
+ * map, drop them before the cpu reads through the new mapping.
+ */
+static void vb2_dma_sg_cpu_map(struct vb2_dma_sg_buf *buf)
+{
+	if (buf->cpu_mapped)
+		return;
+
+	dma_sync_sgtable_for_cpu(buf->dev, buf->dma_sgt, buf->dma_dir);
+	buf->cpu_mapped = true;
+}
+
 static void *vb2_dma_sg_get_userptr(struct device *dev, unsigned long vaddr,
 				    unsigned long size,
 				    enum dma_data_direction dma_dir)
@@ -232,6 +264,7 @@ static void *vb2_dma_sg_get_userptr(struct device *dev, unsigned long vaddr,
 	buf->dev = dev;
 	buf->dma_dir = dma_dir;
 	buf->offset = vaddr & ~PAGE_MASK;
+	buf->cpu_mapped = true;
 	buf->size = size;
 	buf->dma_sgt = &buf->sg_table;
 	vec = vb2_create_framevec(vaddr, size);
@@ -303,6 +336,8 @@ static void *vb2_dma_sg_vaddr(void *buf_priv)
 			buf->vaddr = dma_buf_vmap(buf->db_attach->dmabuf);
 		else
 			buf->vaddr = vm_map_ram(buf->pages, buf->num_pages, -1);
+		if (buf->vaddr)
+			vb2_dma_sg_cpu_map(buf);
 	}
 
 	/* add offset in case userptr is not page-aligned */
@@ -339,6 +374,7 @@ static int vb2_dma_sg_mmap(void *buf_priv, struct vm_area_struct *vma)
 	vma->vm_ops		= &vb2_common_vm_ops;
 
 	vma->vm_ops->open(vma);
+	vb2_dma_sg_cpu_map(buf);
 
 	return 0;
 }
@@ -624,6 +660,8 @@ static void *vb2_dma_sg_attach_dmabuf(struct device *dev, struct dma_buf *dbuf,
 	}
 
 	buf->dma_dir = dma_dir;
+	/* the exporter syncs the cpu access to it */
+	buf->cpu_mapped = true;
 	buf->size = size;
 	buf->db_attach = dba;
 
@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (c) 2026 Rockchip Electronics Co., Ltd. */
+
+#ifndef CAM_I2C_BATCH_H
+#define CAM_I2C_BATCH_H
+
+#include <linux/i2c.h>
+#include <linux/kernel.h>
+#include <linux/types.h>
+
+/*
+ * batched sensor register writes: writes to consecutive addresses are
+ * merged into one auto increment message of up to burst bytes, and up
+ * to CAM_I2C_BATCH_MSGS messages go out in a single i2c_transfer.
+ * sensors without address auto increment use burst 1 and still save
+ * the per register transfer.
+ */
+#define CAM_I2C_BURST_MAX	32
+#define CAM_I2C_BATCH_MSGS	8
+
+struct cam_i2c_batch {
+	struct i2c_client *client;
+	u32 addr_len;
+	u32 burst;
+	u32 num_msgs;
+	u32 next_addr;
+	struct i2c_msg msgs[CAM_I2C_BATCH_MSGS];
+	u8 buf[CAM_I2C_BATCH_MSGS][2 + CAM_I2C_BURST_MAX];
+};
+
+static inline void cam_i2c_batch_init(struct cam_i2c_batch *batch,
+				      struct i2c_client *client,
+				      u32 addr_len, u32 burst)
+{
+	batch->client = client;
+	batch->addr_len = addr_len;
+	batch->burst = clamp_t(u32, burst, 1, CAM_I2C_BURST_MAX);
+	batch->num_msgs = 0;
+}
+
+static inline int cam_i2c_batch_flush(struct cam_i2c_batch *batch)
+{
+	int num = batch->num_msgs;
+	int ret;
+
+	if (!num)
+		return 0;
+	batch->num_msgs = 0;
+	ret = i2c_transfer(batch->client->adapter, batch->msgs, num);
+	if (ret < 0)
+		return ret;
+	return ret == num ? 0 : -EIO;
+}
+
+static inline int cam_i2c_batch_add(struct cam_i2c_batch *batch,
+				    u32 addr, u8 val)
+{
+	struct i2c_msg *msg;
+	int ret;
+
+	if (batch->num_msgs) {
+		msg = &batch->msgs[batch->num_msgs - 1];
+		if (addr == batch->next_addr &&
+		    msg->len < batch->addr_len + batch->burst) {
+			msg->buf[msg->len++] = val;
+			batch->next_addr++;
+			return 0;
+		}
+	}
+
+	if (batch->num_msgs == CAM_I2C_BATCH_MSGS) {
+		ret = cam_i2c_batch_flush(batch);
+		if (ret)
+			return ret;
+	}
+
+	msg = &batch->msgs[batch->num_msgs];
+	msg->addr = batch->client->addr;
+	msg->flags = 0;
+	msg->buf = batch->buf[batch->num_msgs];
+	msg->len = 0;
+	if (batch->addr_len == 2)
+		msg->buf[msg->len++] = addr >> 8;
+	msg->buf[msg->len++] = addr & 0xff;
+	msg->buf[msg->len++] = val;
+	batch->next_addr = addr + 1;
+	batch->num_msgs++;
+	return 0;
+}
+
+#endif
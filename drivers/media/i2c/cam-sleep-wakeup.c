@@ -128,7 +128,8 @@ int cam_sw_write_array(struct cam_sw_info *info)
 		return -EINVAL;
 	}
 
-	info->write_array(info->client, info->array_regs);
+	if (!info->write_array(info->client, info->array_regs))
+		info->loaded_regs = info->array_regs;
 
 	return 0;
 }
@@ -188,9 +189,32 @@ int cam_sw_prepare_sleep(struct cam_sw_info *info)
 
 	if (!IS_ERR(info->pin.supplies) && info->pin.supplies_num)
 		regulator_bulk_disable(info->pin.supplies_num, info->pin.supplies);
+	info->loaded_regs = NULL;
 
 	return 0;
 }
 EXPORT_SYMBOL_GPL(cam_sw_prepare_sleep);
 
+/*
+ * a sensor kept in standby still holds its registers, so starting the
+ * same mode again only needs the stream on write.
+ */
+bool cam_sw_regs_is_loaded(struct cam_sw_info *info, void *array_regs)
+{
+	if (IS_ERR_OR_NULL(info) || !array_regs)
+		return false;
+
+	return info->loaded_regs == array_regs;
+}
+EXPORT_SYMBOL_GPL(cam_sw_regs_is_loaded);
+
+void cam_sw_regs_set_loaded(struct cam_sw_info *info, void *array_regs)
+{
+	if (IS_ERR_OR_NULL(info))
+		return;
+
+	info->loaded_regs = array_regs;
+}
+EXPORT_SYMBOL_GPL(cam_sw_regs_set_loaded);
+
 MODULE_LICENSE("GPL");
@@ -33,6 +33,8 @@ struct cam_sw_info {
 	void *array_regs;
 	struct preisp_hdrae_exp_s hdr_ae;
 	sensor_write_array write_array;
+	/* register table the sensor holds now, NULL once it lost power */
+	void *loaded_regs;
 };
 
 #if IS_REACHABLE(CONFIG_VIDEO_CAM_SLEEP_WAKEUP)
@@ -55,6 +57,8 @@ int cam_sw_write_array_cb_init(struct cam_sw_info *info,
 int cam_sw_write_array(struct cam_sw_info *info);
 int cam_sw_prepare_wakeup(struct cam_sw_info *info, struct device *dev);
 int cam_sw_prepare_sleep(struct cam_sw_info *info);
+bool cam_sw_regs_is_loaded(struct cam_sw_info *info, void *array_regs);
+void cam_sw_regs_set_loaded(struct cam_sw_info *info, void *array_regs);
 
 #else
 
@@ -127,5 +131,16 @@ static inline int cam_sw_prepare_sleep(struct cam_sw_info *info)
 	return 0;
 }
 
+static inline bool cam_sw_regs_is_loaded(struct cam_sw_info *info,
+					 void *array_regs)
+{
+	return false;
+}
+
+static inline void cam_sw_regs_set_loaded(struct cam_sw_info *info,
+					  void *array_regs)
+{
+}
+
 #endif
 #endif
@@ -35,6 +35,7 @@
 #include <media/v4l2-image-sizes.h>
 #include <media/v4l2-mediabus.h>
 #include <media/v4l2-subdev.h>
+#include "cam-i2c-batch.h"
 
 #define DRIVER_VERSION          KERNEL_VERSION(0, 0x01, 0x02)
 #define GC2053_NAME             "gc2053"
@@ -372,17 +373,22 @@ static int gc2053_write_reg(struct i2c_client *client, u8 reg, u8 val)
 static int gc2053_write_array(struct i2c_client *client,
 				  const struct regval *regs)
 {
+	struct cam_i2c_batch batch;
 	int i, ret = 0;
 
+	/* page select at 0xfe rules out auto increment, batch messages only */
+	cam_i2c_batch_init(&batch, client, 1, 1);
 	i = 0;
 	while (regs[i].addr != REG_NULL) {
-		ret = gc2053_write_reg(client, regs[i].addr, regs[i].val);
-		if (ret) {
-			dev_err(&client->dev, "%s failed !\n", __func__);
+		ret = cam_i2c_batch_add(&batch, regs[i].addr, regs[i].val);
+		if (ret)
 			break;
-		}
 		i++;
 	}
+	if (!ret)
+		ret = cam_i2c_batch_flush(&batch);
+	if (ret)
+		dev_err(&client->dev, "%s failed !\n", __func__);
 
 	return ret;
 }
@@ -55,6 +55,7 @@
 #include "../platform/rockchip/isp/rkisp_tb_helper.h"
 #include "cam-tb-setup.h"
 #include "cam-sleep-wakeup.h"
+#include "cam-i2c-batch.h"
 
 #define DRIVER_VERSION			KERNEL_VERSION(0, 0x01, 0x08)
 
@@ -1379,21 +1380,26 @@ static int imx415_write_reg(struct i2c_client *client, u16 reg,
 static int imx415_write_array(struct i2c_client *client,
 			      const struct regval *regs)
 {
+	struct cam_i2c_batch batch;
 	u32 i;
 	int ret = 0;
 	if (!regs) {
 		dev_err(&client->dev, "write reg array error\n");
 		return ret;
 	}
+	cam_i2c_batch_init(&batch, client, 2, CAM_I2C_BURST_MAX);
 	for (i = 0; ret == 0 && regs[i].addr != REG_NULL; i++) {
 		if (regs[i].addr == REG_DELAY) {
+			/* everything before the delay must have reached the sensor */
+			ret = cam_i2c_batch_flush(&batch);
 			usleep_range(regs[i].val * 1000, regs[i].val * 1000 + 500);
 			dev_info(&client->dev, "write reg array, sleep %dms\n", regs[i].val);
 		} else {
-			ret = imx415_write_reg(client, regs[i].addr,
-				IMX415_REG_VALUE_08BIT, regs[i].val);
+			ret = cam_i2c_batch_add(&batch, regs[i].addr, regs[i].val);
 		}
 	}
+	if (!ret)
+		ret = cam_i2c_batch_flush(&batch);
 	return ret;
 }
 
@@ -27,6 +27,7 @@
 #include <linux/pinctrl/consumer.h>
 #include "../platform/rockchip/isp/rkisp_tb_helper.h"
 #include "cam-sleep-wakeup.h"
+#include "cam-i2c-batch.h"
 
 #define DRIVER_VERSION			KERNEL_VERSION(0, 0x01, 0x00)
 
@@ -619,12 +620,15 @@ static int sc230ai_write_reg(struct i2c_client *client, u16 reg,
 static int sc230ai_write_array(struct i2c_client *client,
 			       const struct regval *regs)
 {
+	struct cam_i2c_batch batch;
 	u32 i;
 	int ret = 0;
 
+	cam_i2c_batch_init(&batch, client, 2, CAM_I2C_BURST_MAX);
 	for (i = 0; ret == 0 && regs[i].addr != REG_NULL; i++)
-		ret = sc230ai_write_reg(client, regs[i].addr,
-					SC230AI_REG_VALUE_08BIT, regs[i].val);
+		ret = cam_i2c_batch_add(&batch, regs[i].addr, regs[i].val);
+	if (!ret)
+		ret = cam_i2c_batch_flush(&batch);
 
 	return ret;
 }
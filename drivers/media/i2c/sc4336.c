@@ -30,6 +30,7 @@
 #include "../platform/rockchip/isp/rkisp_tb_helper.h"
 #include "cam-tb-setup.h"
 #include "cam-sleep-wakeup.h"
+#include "cam-i2c-batch.h"
 
 #define DRIVER_VERSION			KERNEL_VERSION(0, 0x01, 0x01)
 
@@ -45,6 +46,10 @@
 					SC4336_LANES / SC4336_BITS_PER_SAMPLE)
 #define SC4336_XVCLK_FREQ		24000000
 
+static bool standby_hold;
+module_param(standby_hold, bool, 0644);
+MODULE_PARM_DESC(standby_hold, "keep the sensor powered in standby after stream off");
+
 #define CHIP_ID				0xdc42
 #define SC4336_REG_CHIP_ID		0x3107
 
@@ -159,6 +164,7 @@ struct sc4336 {
 	u32			cur_vts;
 	bool			is_thunderboot;
 	bool			is_first_streamoff;
+	bool			is_standby_hold;
 	struct cam_sw_info	*cam_sw_inf;
 };
 
@@ -380,12 +386,15 @@ static int sc4336_write_reg(struct i2c_client *client, u16 reg,
 static int sc4336_write_array(struct i2c_client *client,
 			       const struct regval *regs)
 {
+	struct cam_i2c_batch batch;
 	u32 i;
 	int ret = 0;
 
+	cam_i2c_batch_init(&batch, client, 2, CAM_I2C_BURST_MAX);
 	for (i = 0; ret == 0 && regs[i].addr != REG_NULL; i++)
-		ret = sc4336_write_reg(client, regs[i].addr,
-					SC4336_REG_VALUE_08BIT, regs[i].val);
+		ret = cam_i2c_batch_add(&batch, regs[i].addr, regs[i].val);
+	if (!ret)
+		ret = cam_i2c_batch_flush(&batch);
 
 	return ret;
 }
@@ -835,11 +844,16 @@ static long sc4336_compat_ioctl32(struct v4l2_subdev *sd,
 
 static int __sc4336_start_stream(struct sc4336 *sc4336)
 {
+	void *reg_list = (void *)sc4336->cur_mode->reg_list;
 	int ret;
-	if (!sc4336->is_thunderboot) {
+
+	/* controls set in standby were written right away, skip them too */
+	if (!sc4336->is_thunderboot &&
+	    !cam_sw_regs_is_loaded(sc4336->cam_sw_inf, reg_list)) {
 		ret = sc4336_write_array(sc4336->client, sc4336->cur_mode->reg_list);
 		if (ret)
 			return ret;
+		cam_sw_regs_set_loaded(sc4336->cam_sw_inf, reg_list);
 
 		/* In case these controls are set before streaming */
 		ret = __v4l2_ctrl_handler_setup(&sc4336->ctrl_handler);
@@ -879,10 +893,14 @@ static int sc4336_s_stream(struct v4l2_subdev *sd, int on)
 			__sc4336_power_on(sc4336);
 		}
 
-		ret = pm_runtime_get_sync(&client->dev);
-		if (ret < 0) {
-			pm_runtime_put_noidle(&client->dev);
-			goto unlock_and_return;
+		if (sc4336->is_standby_hold) {
+			sc4336->is_standby_hold = false;
+		} else {
+			ret = pm_runtime_get_sync(&client->dev);
+			if (ret < 0) {
+				pm_runtime_put_noidle(&client->dev);
+				goto unlock_and_return;
+			}
 		}
 
 		ret = __sc4336_start_stream(sc4336);
@@ -893,7 +911,11 @@ static int sc4336_s_stream(struct v4l2_subdev *sd, int on)
 		}
 	} else {
 		__sc4336_stop_stream(sc4336);
-		pm_runtime_put(&client->dev);
+		/* keep the power ref so the registers survive until next on */
+		if (standby_hold && !sc4336->is_thunderboot)
+			sc4336->is_standby_hold = true;
+		else
+			pm_runtime_put(&client->dev);
 	}
 
 	sc4336->streaming = on;
@@ -934,6 +956,10 @@ static int sc4336_s_power(struct v4l2_subdev *sd, int on)
 
 		sc4336->power_on = true;
 	} else {
+		if (sc4336->is_standby_hold) {
+			sc4336->is_standby_hold = false;
+			pm_runtime_put(&client->dev);
+		}
 		pm_runtime_put(&client->dev);
 		sc4336->power_on = false;
 	}
@@ -1016,6 +1042,7 @@ static void __sc4336_power_off(struct sc4336 *sc4336)
 	int ret;
 	struct device *dev = &sc4336->client->dev;
 
+	cam_sw_regs_set_loaded(sc4336->cam_sw_inf, NULL);
 	clk_disable_unprepare(sc4336->xvclk);
 	if (sc4336->is_thunderboot) {
 		if (sc4336->is_first_streamoff) {
@@ -1551,13 +1578,13 @@ static int sc4336_remove(struct i2c_client *client)
 	v4l2_ctrl_handler_free(&sc4336->ctrl_handler);
 	mutex_destroy(&sc4336->mutex);
 
-	cam_sw_deinit(sc4336->cam_sw_inf);
-
 	pm_runtime_disable(&client->dev);
 	if (!pm_runtime_status_suspended(&client->dev))
 		__sc4336_power_off(sc4336);
 	pm_runtime_set_suspended(&client->dev);
 
+	cam_sw_deinit(sc4336->cam_sw_inf);
+
 	return 0;
 }
 
@@ -20,8 +20,11 @@
 #include <soc/rockchip/rockchip-system-status.h>
 #include <dt-bindings/soc/rockchip-system-status.h>
 #include <soc/rockchip/rockchip_iommu.h>
+#include <soc/rockchip/rockchip_irq_align.h>
+#include <soc/rockchip/rockchip_frame_policy.h>
 #include <linux/rk-isp32-config.h>
 #include <linux/mm.h>
+#include <linux/soc/rockchip/rockchip_thunderboot_mem.h>
 
 #include "dev.h"
 #include "mipi-csi2.h"
@@ -29,6 +32,9 @@
 #include "rkcif-externel.h"
 #include "../../../i2c/cam-tb-setup.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/rkcif.h>
+
 #define CIF_REQ_BUFS_MIN	1
 #define CIF_MIN_WIDTH		64
 #define CIF_MIN_HEIGHT		64
@@ -45,6 +51,7 @@
 #define STREAM_PAD_SOURCE	1
 
 #define CIF_TIMEOUT_FRAME_NUM	(2)
+#define RKCIF_RECOVER_WAIT_FRAMES	(2)
 
 #define CIF_DVP_PCLK_DUAL_EDGE	(V4L2_MBUS_PCLK_SAMPLE_RISING |\
 				 V4L2_MBUS_PCLK_SAMPLE_FALLING)
@@ -2673,6 +2680,7 @@ static int rkcif_assign_new_buffer_update(struct rkcif_stream *stream,
 		}
 	} else {
 		buffer = NULL;
+		dev->irq_stats.frm_drop_cnt[stream->id]++;
 		if (!(stream->cur_stream_mode & RKCIF_STREAM_MODE_TOISP) && dummy_buf->vaddr) {
 			if (stream->frame_phase == CIF_CSI_FRAME0_READY) {
 				stream->curr_buf  = NULL;
@@ -3975,9 +3983,63 @@ static void rkcif_modify_frame_skip_config(struct rkcif_stream *stream)
 		stream->skip_info.skip_to_en = false;
 	} else if (stream->skip_info.skip_to_dis) {
 		rkcif_disable_skip_frame(stream);
+		stream->skip_info.skip_to_dis = false;
+	}
+}
+
+/*
+ * Queue a skip config, applied by rkcif_modify_frame_skip_config at the
+ * next channel config or frame start. The static fps config is kept
+ * aside and is not overridden while backpressure skip is active.
+ */
+static void rkcif_set_skip_frame(struct rkcif_stream *stream, bool skip_en,
+				 int cap_m, int skip_n, bool is_fps)
+{
+	if (is_fps) {
+		stream->skip_info.fps_skip_en = skip_en;
+		stream->skip_info.fps_cap_m = cap_m;
+		stream->skip_info.fps_skip_n = skip_n;
+		if (stream->bp_info.level)
+			return;
+	}
+
+	if (skip_en) {
+		stream->skip_info.cap_m = cap_m;
+		stream->skip_info.skip_n = skip_n;
+		stream->skip_info.skip_to_dis = false;
+		stream->skip_info.skip_to_en = true;
+	} else {
+		stream->skip_info.skip_to_en = false;
+		stream->skip_info.skip_to_dis = true;
 	}
 }
 
+/* capture cap_m frames then skip skip_n, indexed by rkcif_bp_info.level */
+static const struct {
+	u8 cap_m;
+	u8 skip_n;
+} rkcif_bp_skip_pattern[] = {
+	{ 0, 0 },	/* static fps config */
+	{ 3, 1 },
+	{ 1, 1 },
+	{ 1, 3 },
+	{ 1, 7 },
+};
+
+static void rkcif_apply_bp_level(struct rkcif_stream *stream, u32 level)
+{
+	struct rkcif_skip_info *skip = &stream->skip_info;
+
+	stream->bp_info.level = level;
+	if (level)
+		rkcif_set_skip_frame(stream, true,
+				     rkcif_bp_skip_pattern[level].cap_m,
+				     rkcif_bp_skip_pattern[level].skip_n, false);
+	else
+		rkcif_set_skip_frame(stream, skip->fps_skip_en,
+				     skip->fps_cap_m, skip->fps_skip_n, false);
+}
+
 /*config reg for rk3588*/
 static int rkcif_csi_channel_set_v1(struct rkcif_stream *stream,
 				       struct csi_channel_info *channel,
@@ -4190,6 +4252,7 @@ static int rkcif_csi_stream_start(struct rkcif_stream *stream, unsigned int mode
 
 	if (stream->state < RKCIF_STATE_STREAMING) {
 		stream->frame_idx = 0;
+		rk_lat_hist_reset(&stream->lat_hist);
 		stream->buf_wake_up_cnt = 0;
 		stream->frame_phase = 0;
 		stream->lack_buf_cnt = 0;
@@ -4769,9 +4832,8 @@ void rkcif_free_rx_buf(struct rkcif_stream *stream, int buf_num)
 			v4l2_info(&stream->cifdev->v4l2_dev,
 				  "free reserved mem start 0x%x, end 0x%x, share_head_size 0x%x, nr_buf_size 0x%x\n",
 				  (u32)resmem_free_start, (u32)resmem_free_end, share_head_size, dev->nr_buf_size);
-			free_reserved_area(phys_to_virt(resmem_free_start),
-					   phys_to_virt(resmem_free_end),
-					   -1, "rkisp_thunderboot");
+			rk_tb_mem_release("rkcif_thunderboot", resmem_free_start,
+					  resmem_free_end - resmem_free_start);
 			if (dev->is_rtt_suspend)
 				dev->resmem_size = rtt_min_size;
 			else
@@ -4992,7 +5054,9 @@ static int rkcif_create_dummy_buf(struct rkcif_stream *stream)
 
 	dummy_buf->is_need_vaddr = true;
 	dummy_buf->is_need_dbuf = true;
-	ret = rkcif_alloc_buffer(dev, dummy_buf);
+	ret = rkcif_alloc_pool_buffer(dev, dummy_buf);
+	if (ret)
+		ret = rkcif_alloc_buffer(dev, dummy_buf);
 	if (ret) {
 		v4l2_err(&dev->v4l2_dev,
 			 "Failed to allocate the memory for dummy buffer\n");
@@ -5235,6 +5299,8 @@ void rkcif_do_stop_stream(struct rkcif_stream *stream,
 			stream->skip_info.skip_en = false;
 			stream->skip_info.skip_to_en = true;
 		}
+		if (stream->bp_info.level)
+			rkcif_apply_bp_level(stream, 0);
 	} else if (mode == RKCIF_STREAM_MODE_CAPTURE && stream->dma_en & RKCIF_DMAEN_BY_VICAP) {
 		//only stop dma
 		stream->to_stop_dma = RKCIF_DMAEN_BY_VICAP;
@@ -5251,6 +5317,10 @@ void rkcif_do_stop_stream(struct rkcif_stream *stream,
 				   msecs_to_jiffies(1000));
 	}
 	if ((mode & RKCIF_STREAM_MODE_CAPTURE) == RKCIF_STREAM_MODE_CAPTURE) {
+		if (stream->tools_vdev && stream->tools_vdev->is_share) {
+			flush_work(&stream->tools_vdev->work);
+			rkcif_tools_share_flush(stream->tools_vdev, true);
+		}
 		/* release buffers */
 		spin_lock_irqsave(&stream->vbq_lock, flags);
 		if (stream->curr_buf)
@@ -5275,14 +5345,11 @@ void rkcif_do_stop_stream(struct rkcif_stream *stream,
 			vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_ERROR);
 		}
 		INIT_LIST_HEAD(&stream->buf_head);
-		while (!list_empty(&stream->vb_done_list)) {
-			buf = list_first_entry(&stream->vb_done_list,
-					       struct rkcif_buffer, queue);
-			if (buf) {
-				list_del(&buf->queue);
-				vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_ERROR);
-			}
-		}
+		/* wait the tasklet out so we are the only fifo consumer */
+		tasklet_disable(&stream->vb_done_tasklet);
+		while (kfifo_get(&stream->vb_done_fifo, &buf))
+			vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_ERROR);
+		tasklet_enable(&stream->vb_done_tasklet);
 		stream->total_buf_num = 0;
 		atomic_set(&stream->buf_cnt, 0);
 		stream->lack_buf_cnt = 0;
@@ -5293,6 +5360,8 @@ void rkcif_do_stop_stream(struct rkcif_stream *stream,
 		ret = dev->pipe.close(&dev->pipe);
 		if (ret < 0)
 			v4l2_err(v4l2_dev, "pipeline close failed error:%d\n", ret);
+		rk_exp_queue_reset(&dev->exp_queue);
+		rk_fill_light_stop(&dev->fill_light);
 		if (dev->hdr.hdr_mode == HDR_X2) {
 			if (dev->stream[RKCIF_STREAM_MIPI_ID0].state == RKCIF_STATE_READY &&
 			    dev->stream[RKCIF_STREAM_MIPI_ID1].state == RKCIF_STATE_READY) {
@@ -5338,7 +5407,6 @@ void rkcif_do_stop_stream(struct rkcif_stream *stream,
 		tasklet_disable(&stream->vb_done_tasklet);
 
 	stream->cur_stream_mode &= ~mode;
-	INIT_LIST_HEAD(&stream->vb_done_list);
 	v4l2_info(&dev->v4l2_dev, "stream[%d] stopping finished, dma_en 0x%x\n", stream->id, stream->dma_en);
 	mutex_unlock(&dev->stream_lock);
 	rkcif_detach_sync_mode(dev);
@@ -5899,6 +5967,7 @@ static int rkcif_stream_start(struct rkcif_stream *stream, unsigned int mode)
 
 	if (stream->state < RKCIF_STATE_STREAMING) {
 		stream->frame_idx = 0;
+		rk_lat_hist_reset(&stream->lat_hist);
 		stream->buf_wake_up_cnt = 0;
 		stream->lack_buf_cnt = 0;
 		stream->frame_phase = 0;
@@ -6555,6 +6624,9 @@ int rkcif_do_start_stream(struct rkcif_stream *stream, enum rkcif_stream_mode mo
 	dev->reset_work_cancel = false;
 	stream->cur_stream_mode |= mode;
 	rkcif_monitor_reset_event(dev);
+	/* the strobe is timed in lines */
+	if (rk_fill_light_present(&dev->fill_light) && dev->sensor_linetime <= 0)
+		dev->sensor_linetime = rkcif_get_linetime(stream);
 	goto out;
 
 stop_stream:
@@ -6881,7 +6953,7 @@ void rkcif_stream_init(struct rkcif_device *dev, u32 id)
 	stream->dma_en = 0;
 	stream->to_en_dma = 0;
 	stream->to_stop_dma = 0;
-	stream->to_en_scale = false;
+	stream->to_en_scale = 0;
 	stream->buf_owner = 0;
 	stream->buf_replace_cnt = 0;
 	stream->is_stop_capture = false;
@@ -7390,6 +7462,46 @@ static int rkcif_get_max_common_div(int a, int b)
 	return b;
 }
 
+/*
+ * Drop frames at the vicap dma when the consumer falls behind, instead of
+ * letting them pile up in ddr. Every report moves the hw skip ratio at most
+ * one step, up at high_wm and down at low_wm, so a depth hovering between
+ * the two marks keeps the current ratio.
+ */
+int rkcif_set_backpressure(struct rkcif_stream *stream,
+			   struct rkcif_backpressure *bp)
+{
+	struct rkcif_device *dev = stream->cifdev;
+	struct rkcif_bp_info *info = &stream->bp_info;
+	u32 level = info->level;
+
+	if (dev->inf_id != RKCIF_MIPI_LVDS || stream->id >= RKCIF_MAX_STREAM_MIPI)
+		return -EINVAL;
+	if (bp->high_wm && bp->low_wm >= bp->high_wm)
+		return -EINVAL;
+
+	info->high_wm = bp->high_wm;
+	info->low_wm = bp->low_wm;
+	info->depth = bp->depth;
+
+	if (!info->high_wm)
+		level = 0;
+	else if (info->depth >= info->high_wm &&
+		 level < ARRAY_SIZE(rkcif_bp_skip_pattern) - 1)
+		level++;
+	else if (info->depth <= info->low_wm && level)
+		level--;
+
+	if (level != info->level) {
+		rkcif_apply_bp_level(stream, level);
+		v4l2_dbg(1, rkcif_debug, &dev->v4l2_dev,
+			 "stream[%d] depth %u, backpressure level %u, cap_m %d, skip_n %d\n",
+			 stream->id, info->depth, level,
+			 stream->skip_info.cap_m, stream->skip_info.skip_n);
+	}
+	return 0;
+}
+
 void rkcif_set_fps(struct rkcif_stream *stream, struct rkcif_fps *fps)
 {
 	struct rkcif_sensor_info *sensor = &stream->cifdev->terminal_sensor;
@@ -7462,22 +7574,10 @@ void rkcif_set_fps(struct rkcif_stream *stream, struct rkcif_fps *fps)
 	if (fps->ch_num > 1 && fps->ch_num < 4) {
 		for (i = 0; i < fps->ch_num; i++) {
 			tmp_stream = &cif_dev->stream[i];
-			if (skip_en) {
-				tmp_stream->skip_info.skip_to_en = true;
-				tmp_stream->skip_info.cap_m = cap_m;
-				tmp_stream->skip_info.skip_n = skip_n;
-			} else {
-				tmp_stream->skip_info.skip_to_dis = true;
-			}
+			rkcif_set_skip_frame(tmp_stream, skip_en, cap_m, skip_n, true);
 		}
 	} else {
-		if (skip_en) {
-			stream->skip_info.skip_to_en = true;
-			stream->skip_info.cap_m = cap_m;
-			stream->skip_info.skip_n = skip_n;
-		} else {
-			stream->skip_info.skip_to_dis = true;
-		}
+		rkcif_set_skip_frame(stream, skip_en, cap_m, skip_n, true);
 	}
 	v4l2_dbg(1, rkcif_debug, &stream->cifdev->v4l2_dev,
 		    "skip_to_en %d, cap_m %d, skip_n %d\n",
@@ -7517,6 +7617,19 @@ static long rkcif_ioctl_default(struct file *file, void *fh,
 	int on = 0;
 
 	switch (cmd) {
+	case RK_EXP_CMD_QUEUE:
+		return rk_exp_queue_add(&dev->exp_queue, arg);
+	case RK_EXP_CMD_GET_STATS:
+		rk_exp_queue_get_stats(&dev->exp_queue, arg);
+		return 0;
+	case RK_FILL_LIGHT_CMD_SET_CFG:
+		return rk_fill_light_set_cfg(&dev->fill_light, arg);
+	case RK_FILL_LIGHT_CMD_GET_CFG:
+		rk_fill_light_get_cfg(&dev->fill_light, arg);
+		return 0;
+	case RK_FILL_LIGHT_CMD_GET_STATS:
+		rk_fill_light_get_stats(&dev->fill_light, arg);
+		return 0;
 	case RKCIF_CMD_GET_CSI_MEMORY_MODE:
 		if (stream->is_compact) {
 			*(int *)arg = CSI_LVDS_MEM_COMPACT;
@@ -7560,6 +7673,8 @@ static long rkcif_ioctl_default(struct file *file, void *fh,
 		fps = *(struct rkcif_fps *)arg;
 		rkcif_set_fps(stream, &fps);
 		break;
+	case RKCIF_CMD_SET_BACKPRESSURE:
+		return rkcif_set_backpressure(stream, (struct rkcif_backpressure *)arg);
 	case RKCIF_CMD_SET_RESET:
 		reset_src = *(int *)arg;
 		return rkcif_do_reset_work(dev, reset_src);
@@ -7718,6 +7833,7 @@ void rkcif_vb_done_oneframe(struct rkcif_stream *stream,
 			    struct vb2_v4l2_buffer *vb_done)
 {
 	const struct cif_output_fmt *fmt = stream->cif_fmt_out;
+	u64 ns = rkcif_time_get_ns(stream->cifdev);
 	u32 i;
 
 	/* Dequeue a filled buffer */
@@ -7726,6 +7842,18 @@ void rkcif_vb_done_oneframe(struct rkcif_stream *stream,
 				      stream->pixm.plane_fmt[i].sizeimage);
 	}
 
+	rk_lat_hist_add(&stream->lat_hist, ns - vb_done->vb2_buf.timestamp);
+	trace_rkcif_frame_done(dev_name(stream->cifdev->dev), stream->id,
+			       vb_done->sequence, vb_done->vb2_buf.timestamp, ns);
+	if (trace_rkcif_frame_buf_enabled()) {
+		struct vb2_buffer *vb = &vb_done->vb2_buf;
+		unsigned long ino = 0;
+
+		if (vb->memory == VB2_MEMORY_DMABUF && vb->planes[0].dbuf)
+			ino = file_inode(vb->planes[0].dbuf->file)->i_ino;
+		trace_rkcif_frame_buf(stream->id, vb_done->sequence,
+				      vb->timestamp, ns, ino);
+	}
 	vb2_buffer_done(&vb_done->vb2_buf, VB2_BUF_STATE_DONE);
 	v4l2_dbg(2, rkcif_debug, &stream->cifdev->v4l2_dev,
 		 "stream[%d] vb done, index: %d, sequence %d\n", stream->id,
@@ -7737,30 +7865,26 @@ static void rkcif_tasklet_handle(unsigned long data)
 {
 	struct rkcif_stream *stream = (struct rkcif_stream *)data;
 	struct rkcif_buffer *buf = NULL;
-	unsigned long flags = 0;
-	LIST_HEAD(local_list);
-
-	spin_lock_irqsave(&stream->vbq_lock, flags);
-	list_replace_init(&stream->vb_done_list, &local_list);
-	spin_unlock_irqrestore(&stream->vbq_lock, flags);
 
-	while (!list_empty(&local_list)) {
-		buf = list_first_entry(&local_list,
-				       struct rkcif_buffer, queue);
-		list_del(&buf->queue);
+	/* tasklet is the only consumer, no lock needed */
+	while (kfifo_get(&stream->vb_done_fifo, &buf))
 		rkcif_vb_done_oneframe(stream, &buf->vb);
-	}
 }
 
+/*
+ * Called from the frame end irq only, which is the single producer of
+ * vb_done_fifo, so the hand over to the tasklet is lockless.
+ */
 void rkcif_vb_done_tasklet(struct rkcif_stream *stream, struct rkcif_buffer *buf)
 {
-	unsigned long flags = 0;
-
 	if (!stream || !buf)
 		return;
-	spin_lock_irqsave(&stream->vbq_lock, flags);
-	list_add_tail(&buf->queue, &stream->vb_done_list);
-	spin_unlock_irqrestore(&stream->vbq_lock, flags);
+	if (!kfifo_put(&stream->vb_done_fifo, buf)) {
+		v4l2_warn(&stream->cifdev->v4l2_dev,
+			  "stream[%d] vb done fifo full, done in irq\n", stream->id);
+		rkcif_vb_done_oneframe(stream, &buf->vb);
+		return;
+	}
 	tasklet_schedule(&stream->vb_done_tasklet);
 }
 
@@ -7880,7 +8004,7 @@ static int rkcif_register_stream_vdev(struct rkcif_stream *stream,
 	if (ret < 0)
 		goto unreg;
 
-	INIT_LIST_HEAD(&stream->vb_done_list);
+	INIT_KFIFO(stream->vb_done_fifo);
 	tasklet_init(&stream->vb_done_tasklet,
 		     rkcif_tasklet_handle,
 		     (unsigned long)stream);
@@ -8590,6 +8714,36 @@ s32 rkcif_get_sensor_vblank_def(struct rkcif_device *dev)
 	return 0;
 }
 
+static s32 rkcif_get_sensor_exposure(struct rkcif_device *dev)
+{
+	struct v4l2_subdev *sd = dev->terminal_sensor.sd;
+	struct v4l2_ctrl *ctrl = NULL;
+
+	if (!sd || !sd->ctrl_handler)
+		return 0;
+
+	list_for_each_entry(ctrl, &sd->ctrl_handler->ctrls, node) {
+		if (ctrl->id == V4L2_CID_EXPOSURE)
+			return ctrl->val;
+	}
+
+	return 0;
+}
+
+static void rkcif_fill_light_sof(struct rkcif_device *dev)
+{
+	u32 height = dev->terminal_sensor.raw_rect.height;
+	s32 exp, vblank;
+
+	if (!rk_fill_light_strobe(&dev->fill_light))
+		return;
+
+	exp = rkcif_get_sensor_exposure(dev);
+	vblank = rkcif_get_sensor_vblank(dev);
+	rk_fill_light_sof(&dev->fill_light, max(exp, 0), height + max(vblank, 0),
+			  height, max(dev->sensor_linetime, 0));
+}
+
 static void rkcif_cal_csi_crop_width_vwidth(struct rkcif_stream *stream,
 					    u32 raw_width, u32 *crop_width,
 					    u32 *crop_vwidth)
@@ -8716,12 +8870,9 @@ static void rkcif_monitor_reset_event(struct rkcif_device *dev)
 {
 	struct rkcif_stream *stream = NULL;
 	struct rkcif_timer *timer = &dev->reset_watchdog_timer;
-	unsigned int cycle = 0;
-	u64 fps, timestamp0, timestamp1;
-	unsigned long flags, fps_flags;
 	int i = 0;
 
-	if (timer->is_running)
+	if (timer->is_running || work_pending(&timer->monitor_work))
 		return;
 
 	if (timer->monitor_mode == RKCIF_MONITOR_MODE_IDLE)
@@ -8738,6 +8889,35 @@ static void rkcif_monitor_reset_event(struct rkcif_device *dev)
 
 	timer->is_triggered = rkcif_is_triggered_monitoring(dev);
 
+	/* arming reads the sensor vblank ctrl, keep it out of the isr */
+	if (timer->is_triggered)
+		schedule_work(&timer->monitor_work);
+}
+
+void rkcif_reset_monitor_work(struct work_struct *work)
+{
+	struct rkcif_timer *timer = container_of(work, struct rkcif_timer,
+						 monitor_work);
+	struct rkcif_device *dev = container_of(timer, struct rkcif_device,
+						reset_watchdog_timer);
+	struct rkcif_stream *stream = NULL;
+	unsigned int cycle = 0;
+	u64 fps, timestamp0, timestamp1;
+	unsigned long flags, fps_flags;
+	int i = 0;
+
+	if (timer->is_running)
+		return;
+
+	for (i = 0; i < RKCIF_MAX_STREAM_MIPI; i++) {
+		stream = &dev->stream[i];
+		if (stream->state == RKCIF_STATE_STREAMING)
+			break;
+	}
+
+	if (i >= RKCIF_MAX_STREAM_MIPI)
+		return;
+
 	if (timer->is_triggered) {
 		struct v4l2_rect *raw_rect = &dev->terminal_sensor.raw_rect;
 		enum rkcif_monitor_mode mode;
@@ -8972,6 +9152,33 @@ static void rkcif_buf_done_with_tools(struct rkcif_stream *stream,
 	spin_unlock_irqrestore(&stream->tools_vdev->vbq_lock, flags);
 }
 
+/* true to drop the frame */
+static bool rkcif_frame_policy(struct rkcif_stream *stream,
+			       struct rkcif_buffer *buf)
+{
+	struct rkcif_device *cif_dev = stream->cifdev;
+	struct vb2_v4l2_buffer *vb = &buf->vb;
+	struct rk_frame_info info = {
+		.source = RK_FRAME_SRC_CIF,
+		.dev_id = cif_dev->csi_host_idx,
+		.stream_id = stream->id,
+		.seq = vb->sequence,
+		.width = stream->pixm.width,
+		.height = stream->pixm.height,
+		.fourcc = stream->pixm.pixelformat,
+		.sof_ns = vb->vb2_buf.timestamp,
+	};
+	int verdict;
+
+	info.nr_means = rk_md_get_luma(&cif_dev->luma_vdev.md, info.luma_mean,
+				       RK_FRAME_MEANS_MAX, &info.motion);
+	verdict = rk_frame_policy_run(&info);
+	if (verdict & RK_FRAME_DROP)
+		return true;
+	rk_frame_policy_tag(vb, verdict);
+	return false;
+}
+
 static void rkcif_buf_done_prepare(struct rkcif_stream *stream,
 				   struct rkcif_buffer *active_buf,
 				   int mipi_id,
@@ -9006,6 +9213,14 @@ static void rkcif_buf_done_prepare(struct rkcif_stream *stream,
 			rkcif_buf_queue(&active_buf->vb.vb2_buf);
 			return;
 		}
+		/* hdr frames are merged in pairs, keep those whole */
+		if ((cif_dev->hdr.hdr_mode == NO_HDR ||
+		     cif_dev->hdr.hdr_mode == HDR_COMPR) &&
+		    rk_frame_policy_enabled() &&
+		    rkcif_frame_policy(stream, active_buf)) {
+			rkcif_buf_queue(&active_buf->vb.vb2_buf);
+			return;
+		}
 	} else if (cif_dev->rdbk_buf[stream->id]) {
 		vb_done = &cif_dev->rdbk_buf[stream->id]->vb;
 		if (cif_dev->chip_id < CHIP_RK3588_CIF &&
@@ -9814,7 +10029,67 @@ static int rkcif_do_reset_work(struct rkcif_device *cif_dev,
 	return ret;
 }
 
-void rkcif_reset_work(struct work_struct *work)
+/* true if every streaming channel got a frame end within frm_num frames */
+static bool rkcif_wait_frame_resume(struct rkcif_device *dev, u32 frm_num)
+{
+	struct rkcif_timer *timer = &dev->reset_watchdog_timer;
+	u64 last_cnt[RKCIF_MAX_STREAM_MIPI];
+	unsigned long cycle_us = timer->frame_end_cycle_us;
+	bool is_streaming = false;
+	int i;
+
+	if (!cycle_us)
+		cycle_us = 33333;
+	for (i = 0; i < RKCIF_MAX_STREAM_MIPI; i++)
+		last_cnt[i] = dev->irq_stats.frm_end_cnt[i];
+
+	msleep(DIV_ROUND_UP(cycle_us * frm_num, 1000));
+
+	for (i = 0; i < RKCIF_MAX_STREAM_MIPI; i++) {
+		if (dev->stream[i].state != RKCIF_STATE_STREAMING)
+			continue;
+		is_streaming = true;
+		if (dev->irq_stats.frm_end_cnt[i] == last_cnt[i])
+			return false;
+	}
+	return is_streaming;
+}
+
+/* drop the half frame state and let hw pick up at the next frame start */
+static bool rkcif_recover_resync(struct rkcif_device *dev)
+{
+	struct rkcif_stream *stream;
+	int i;
+
+	for (i = 0; i < RKCIF_MAX_STREAM_MIPI; i++) {
+		stream = &dev->stream[i];
+		if (stream->state != RKCIF_STATE_STREAMING)
+			continue;
+		stream->is_fs_fe_not_paired = false;
+		stream->fs_cnt_in_single_frame = 0;
+	}
+	return rkcif_wait_frame_resume(dev, RKCIF_RECOVER_WAIT_FRAMES);
+}
+
+static bool rkcif_recover_csi_host(struct rkcif_device *dev)
+{
+	struct v4l2_mbus_config *mbus;
+	struct csi2_dev *csi;
+
+	if (!dev->active_sensor)
+		return false;
+	mbus = &dev->active_sensor->mbus;
+	if (mbus->type != V4L2_MBUS_CSI2_DPHY &&
+	    mbus->type != V4L2_MBUS_CSI2_CPHY)
+		return false;
+
+	csi = container_of(dev->active_sensor->sd, struct csi2_dev, sd);
+	if (rkcif_csi2_reset_host(csi))
+		return false;
+	return rkcif_wait_frame_resume(dev, RKCIF_RECOVER_WAIT_FRAMES);
+}
+
+void rkcif_reset_work(struct kthread_work *work)
 {
 	struct rkcif_work_struct *reset_work = container_of(work,
 							    struct rkcif_work_struct,
@@ -9822,11 +10097,45 @@ void rkcif_reset_work(struct work_struct *work)
 	struct rkcif_device *dev = container_of(reset_work,
 						struct rkcif_device,
 						reset_work);
+	enum rkmodule_reset_src reset_src = reset_work->reset_src;
+	enum rkcif_recover_tier tier = RKCIF_RECOVER_FULL;
+	u64 start = ktime_get_ns();
 	int ret;
 
-	ret = rkcif_do_reset_work(dev, reset_work->reset_src);
-	if (ret)
-		v4l2_info(&dev->v4l2_dev, "do reset work failed!\n");
+	/*
+	 * csi errors and a cut off stream usually heal without touching
+	 * the sensor, so try a resync and then a csi host reset before
+	 * paying for the full pipeline restart.
+	 */
+	if (reset_src == RKCIF_RESET_SRC_ERR_CSI2 ||
+	    reset_src == RKICF_RESET_SRC_ERR_CUTOFF) {
+		mutex_lock(&dev->stream_lock);
+		if (dev->reset_work_cancel) {
+			mutex_unlock(&dev->stream_lock);
+			return;
+		}
+		if (reset_src == RKCIF_RESET_SRC_ERR_CSI2 &&
+		    rkcif_recover_resync(dev))
+			tier = RKCIF_RECOVER_RESYNC;
+		else if (rkcif_recover_csi_host(dev))
+			tier = RKCIF_RECOVER_CSI_HOST;
+		mutex_unlock(&dev->stream_lock);
+	}
+
+	if (tier != RKCIF_RECOVER_FULL) {
+		dev->reset_watchdog_timer.csi2_err_triggered_cnt = 0;
+		rkcif_monitor_reset_event(dev);
+		v4l2_info(&dev->v4l2_dev, "recover by %s, reset source:%d\n",
+			  tier == RKCIF_RECOVER_RESYNC ? "resync" : "csi host reset",
+			  reset_src);
+	} else {
+		ret = rkcif_do_reset_work(dev, reset_src);
+		if (ret) {
+			v4l2_info(&dev->v4l2_dev, "do reset work failed!\n");
+			return;
+		}
+	}
+	rk_lat_hist_add(&reset_work->recover_hist[tier], ktime_get_ns() - start);
 }
 
 static bool rkcif_is_reduced_frame_rate(struct rkcif_device *dev)
@@ -9976,7 +10285,8 @@ static void rkcif_init_reset_work(struct rkcif_timer *timer)
 		rkcif_send_reset_event(dev, timer->reset_src);
 	} else {
 		dev->reset_work.reset_src = timer->reset_src;
-		if (!schedule_work(&dev->reset_work.work))
+		if (!dev->reset_worker ||
+		    !kthread_queue_work(dev->reset_worker, &dev->reset_work.work))
 			v4l2_info(&dev->v4l2_dev,
 				  "schedule reset work failed\n");
 	}
@@ -10095,6 +10405,15 @@ static int rkcif_detect_reset_event(struct rkcif_stream *stream,
 void rkcif_reset_watchdog_timer_handler(struct timer_list *t)
 {
 	struct rkcif_timer *timer = container_of(t, struct rkcif_timer, timer);
+
+	/* hotplug check reads the sensor over i2c, run it in process context */
+	schedule_work(&timer->detect_work);
+}
+
+void rkcif_reset_detect_work(struct work_struct *work)
+{
+	struct rkcif_timer *timer = container_of(work, struct rkcif_timer,
+						 detect_work);
 	struct rkcif_device *dev = container_of(timer,
 						struct rkcif_device,
 						reset_watchdog_timer);
@@ -10506,6 +10825,11 @@ static void rkcif_send_sof(struct rkcif_device *cif_dev)
 	} else {
 		rkcif_dvp_event_inc_sof(cif_dev);
 	}
+	rk_exp_queue_sof(&cif_dev->exp_queue, cif_dev->terminal_sensor.sd,
+			 rkcif_get_sof(cif_dev));
+	rkcif_fill_light_sof(cif_dev);
+	/* the cpu is up for the sof anyway, run deferred completions now */
+	rk_irq_align_anchor();
 }
 
 static int rkcif_g_toisp_ch(unsigned int intstat_glb, int index)
@@ -10648,10 +10972,8 @@ static void rkcif_toisp_check_stop_status(struct sditf_priv *priv,
 					  stream->frame_idx - 1);
 			if (stream->to_en_dma)
 				rkcif_enable_dma_capture(stream, false);
-			if (stream->to_en_scale) {
-				stream->to_en_scale = false;
-				rkcif_scale_start(stream->scale_vdev);
-			}
+			if (stream->to_en_scale)
+				rkcif_scale_start_pending(stream);
 			switch (ch) {
 			case RKCIF_TOISP_CH0:
 				val = TOISP_FS_CH0(index);
@@ -11001,6 +11323,7 @@ static int rkcif_subdevs_set_stream(struct rkcif_device *cif_dev, int on)
 			if (!rk_tb_mcu_is_done() && on) {
 				cif_dev->tb_client.data = p->subdevs[i];
 				cif_dev->tb_client.cb = rkcif_sensor_quick_streaming_cb;
+				rkcif_tb_client_init(cif_dev);
 				rk_tb_client_register_cb(&cif_dev->tb_client);
 			} else {
 				ret = v4l2_subdev_call(p->subdevs[i], core, ioctl,
@@ -11306,6 +11629,54 @@ int rkcif_stream_resume(struct rkcif_device *cif_dev, int mode)
 	return 0;
 }
 
+/*
+ * Move a running toisp pipeline between online and auto readback when the
+ * isp asks for it, that is when the other sensors on the isp stop or start
+ * streaming. The streams stop at a frame end and restart in the new mode
+ * the same way a reset in streaming does, so the isp only sees a frame or
+ * two missing. HDR and aiq readback pipelines are left as they are.
+ */
+int rkcif_switch_work_mode(struct rkcif_device *cif_dev, bool online)
+{
+	struct sditf_priv *priv = cif_dev->sditf[0];
+	struct rkisp_vicap_mode mode;
+	struct v4l2_subdev *sd;
+	int ret;
+
+	if (!priv || priv->hdr_cfg.hdr_mode != NO_HDR)
+		return -EINVAL;
+	if (online == (priv->mode.rdbk_mode == RKISP_VICAP_ONLINE))
+		return 0;
+	if (online && (priv->mode.rdbk_mode != RKISP_VICAP_RDBK_AUTO ||
+		       !rkcif_check_can_be_online(cif_dev) ||
+		       !rkcif_check_single_dev_stream_on(cif_dev->hw_dev)))
+		return -EINVAL;
+
+	sd = get_rkisp_sd(priv);
+	if (!sd)
+		return -ENODEV;
+
+	rkcif_stream_suspend(cif_dev, RKCIF_RESUME_ISP);
+
+	mode = priv->mode;
+	mode.rdbk_mode = online ? RKISP_VICAP_ONLINE : RKISP_VICAP_RDBK_AUTO;
+	ret = v4l2_subdev_call(sd, core, ioctl, RKISP_VICAP_CMD_MODE, &mode);
+	if (!ret) {
+		mutex_lock(&cif_dev->stream_lock);
+		priv->mode.rdbk_mode = mode.rdbk_mode;
+		mutex_unlock(&cif_dev->stream_lock);
+	} else {
+		v4l2_err(&cif_dev->v4l2_dev, "set isp work mode %s fail\n",
+			 online ? "online" : "readback");
+	}
+
+	rkcif_stream_resume(cif_dev, RKCIF_RESUME_ISP);
+
+	v4l2_dbg(1, rkcif_debug, &cif_dev->v4l2_dev,
+		 "%s: rdbk_mode %d\n", __func__, priv->mode.rdbk_mode);
+	return ret;
+}
+
 void rkcif_err_print_work(struct work_struct *work)
 {
 	struct rkcif_err_state_work *err_state_work = container_of(work,
@@ -11784,10 +12155,8 @@ void rkcif_irq_pingpong_v1(struct rkcif_device *cif_dev)
 
 			if (stream->cur_skip_frame)
 				stream->cur_skip_frame--;
-			if (stream->to_en_scale) {
-				stream->to_en_scale = false;
-				rkcif_scale_start(stream->scale_vdev);
-			}
+			if (stream->to_en_scale)
+				rkcif_scale_start_pending(stream);
 			rkcif_detect_wake_up_mode_change(stream);
 			if (cif_dev->chip_id < CHIP_RK3588_CIF &&
 			    mipi_id == RKCIF_STREAM_MIPI_ID0) {
@@ -11832,6 +12201,9 @@ void rkcif_irq_pingpong_v1(struct rkcif_device *cif_dev)
 				}
 				if (stream->to_en_dma)
 					rkcif_enable_dma_capture(stream, false);
+				else if (!stream->dma_en && stream->lack_buf_cnt == 2 &&
+					 !cif_dev->hw_dev->dummy_buf.vaddr)
+					cif_dev->irq_stats.frm_drop_cnt[stream->id]++;
 				spin_unlock_irqrestore(&stream->vbq_lock, flags);
 				if (rkcif_get_interlace_mode(stream) == RKCIF_INTERLACE_SOFT_AUTO)
 					rkcif_check_mipi_interlaced_frame_id(stream);
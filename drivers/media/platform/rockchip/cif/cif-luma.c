@@ -67,6 +67,22 @@ static int rkcif_luma_querycap(struct file *file,
 }
 
 /* ISP video device IOCTLs */
+static long rkcif_luma_ioctl_default(struct file *file, void *fh,
+				     bool valid_prio, unsigned int cmd, void *arg)
+{
+	struct rkcif_luma_vdev *luma_vdev = video_drvdata(file);
+
+	switch (cmd) {
+	case RK_MD_CMD_SET_CFG:
+		return rk_md_set_cfg(&luma_vdev->md, arg);
+	case RK_MD_CMD_GET_CFG:
+		rk_md_get_cfg(&luma_vdev->md, arg);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
 static const struct v4l2_ioctl_ops rkcif_luma_ioctl = {
 	.vidioc_reqbufs = vb2_ioctl_reqbufs,
 	.vidioc_querybuf = vb2_ioctl_querybuf,
@@ -81,7 +97,8 @@ static const struct v4l2_ioctl_ops rkcif_luma_ioctl = {
 	.vidioc_g_fmt_meta_cap = rkcif_luma_g_fmt_meta_cap,
 	.vidioc_s_fmt_meta_cap = rkcif_luma_g_fmt_meta_cap,
 	.vidioc_try_fmt_meta_cap = rkcif_luma_g_fmt_meta_cap,
-	.vidioc_querycap = rkcif_luma_querycap
+	.vidioc_querycap = rkcif_luma_querycap,
+	.vidioc_default = rkcif_luma_ioctl_default,
 };
 
 static int rkcif_luma_fh_open(struct file *filp)
@@ -295,7 +312,7 @@ void rkcif_luma_isr(struct rkcif_luma_vdev *luma_vdev, int mipi_id, u32 frame_id
 	u32 i, value;
 
 	spin_lock(&luma_vdev->irq_lock);
-	if (!luma_vdev->streamon)
+	if (!luma_vdev->streamon && !rk_md_enabled(&luma_vdev->md))
 		goto unlock;
 
 	switch (hdr_mode) {
@@ -360,6 +377,12 @@ void rkcif_luma_isr(struct rkcif_luma_vdev *luma_vdev, int mipi_id, u32 frame_id
 	}
 
 	if (send_task) {
+		/* id0 is read in every mode */
+		rk_md_frame(&luma_vdev->md, luma_vdev->work.luma[0].exp_mean,
+			    ISP2X_MIPI_LUMA_MEAN_MAX, frame_id);
+	}
+
+	if (send_task && luma_vdev->streamon) {
 		luma_vdev->work.readout = RKCIF_READOUT_LUMA;
 		luma_vdev->work.timestamp = rkcif_time_get_ns(luma_vdev->cifdev);
 		luma_vdev->work.frame_id = frame_id;
@@ -380,7 +403,9 @@ void rkcif_luma_isr(struct rkcif_luma_vdev *luma_vdev, int mipi_id, u32 frame_id
 				 "stats kfifo is full\n");
 
 		tasklet_schedule(&luma_vdev->rd_tasklet);
+	}
 
+	if (send_task) {
 		for (i = 0; i < RKCIF_RAW_MAX; i++)
 			luma_vdev->ystat_rdflg[i] = false;
 
@@ -495,6 +520,7 @@ int rkcif_register_luma_vdev(struct rkcif_luma_vdev *luma_vdev,
 		     rkcif_luma_readout_task,
 		     (unsigned long)luma_vdev);
 	tasklet_disable(&luma_vdev->rd_tasklet);
+	rk_md_init(&luma_vdev->md, dev->dev, dev_name(dev->dev));
 
 	return 0;
 
@@ -512,6 +538,7 @@ void rkcif_unregister_luma_vdev(struct rkcif_luma_vdev *luma_vdev)
 	struct rkcif_luma_node *node = &luma_vdev->vnode;
 	struct video_device *vdev = &node->vdev;
 
+	rk_md_remove(&luma_vdev->md);
 	kfifo_free(&luma_vdev->rd_kfifo);
 	tasklet_kill(&luma_vdev->rd_tasklet);
 	video_unregister_device(vdev);
@@ -7,6 +7,7 @@
 #include <linux/rk-isp1-config.h>
 #include <linux/interrupt.h>
 #include <linux/kfifo.h>
+#include <soc/rockchip/rockchip_motion_detect.h>
 #include "dev.h"
 
 #define RKCIF_LUMA_READOUT_WORK_SIZE	\
@@ -66,6 +67,7 @@ struct rkcif_luma_vdev {
 
 	bool ystat_rdflg[ISP2X_MIPI_RAW_MAX];
 	struct rkcif_luma_readout_work work;
+	struct rk_motion_detect md;
 };
 
 void rkcif_start_luma(struct rkcif_luma_vdev *luma_vdev, const struct cif_input_fmt *cif_fmt_in);
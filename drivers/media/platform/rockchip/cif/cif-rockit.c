@@ -282,6 +282,27 @@ int rkcif_rockit_pause_stream(struct rockit_rkcif_cfg *input_rockit_cfg)
 }
 EXPORT_SYMBOL(rkcif_rockit_pause_stream);
 
+int rkcif_rockit_set_backpressure(struct rockit_rkcif_cfg *input_rockit_cfg,
+				  u32 depth, u32 high_wm, u32 low_wm)
+{
+	struct rkcif_stream *stream = NULL;
+	struct rkcif_backpressure bp = {
+		.depth = depth,
+		.high_wm = high_wm,
+		.low_wm = low_wm,
+	};
+
+	stream = rkcif_rockit_get_stream(input_rockit_cfg);
+
+	if (stream == NULL) {
+		pr_err("the stream is NULL");
+		return -EINVAL;
+	}
+
+	return rkcif_set_backpressure(stream, &bp);
+}
+EXPORT_SYMBOL(rkcif_rockit_set_backpressure);
+
 int rkcif_rockit_config_stream(struct rockit_rkcif_cfg *input_rockit_cfg,
 				int width, int height, int v4l2_fmt)
 {
@@ -260,6 +260,7 @@ static long rkcif_scale_ioctl_default(struct file *file, void *fh,
 	struct rkcif_scale_vdev *scale_vdev = video_drvdata(file);
 	struct rkcif_device *dev = scale_vdev->cifdev;
 	struct bayer_blc *pblc;
+	int src_id;
 
 	switch (cmd) {
 	case RKCIF_CMD_GET_SCALE_BLC:
@@ -274,6 +275,25 @@ static long rkcif_scale_ioctl_default(struct file *file, void *fh,
 		v4l2_dbg(1, rkcif_debug, &dev->v4l2_dev, "set scale blc %d %d %d %d\n",
 			 pblc->pattern00, pblc->pattern01, pblc->pattern02, pblc->pattern03);
 		break;
+	case RKCIF_CMD_GET_SCALE_SRC:
+		*(int *)arg = scale_vdev->stream->id;
+		break;
+	case RKCIF_CMD_SET_SCALE_SRC:
+		/*
+		 * each scale channel picks its own source and decimation, so
+		 * one capture fans out to several scaled outputs in one pass
+		 * without reading the full frame back from ddr
+		 */
+		src_id = *(int *)arg;
+		if (dev->inf_id != RKCIF_MIPI_LVDS ||
+		    src_id < 0 || src_id >= RKCIF_MAX_STREAM_MIPI)
+			return -EINVAL;
+		if (vb2_is_busy(&scale_vdev->vnode.buf_queue))
+			return -EBUSY;
+		scale_vdev->stream = &dev->stream[src_id];
+		v4l2_dbg(1, rkcif_debug, &dev->v4l2_dev, "scale ch%d src stream[%d]\n",
+			 scale_vdev->ch, src_id);
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -597,7 +617,7 @@ static int rkcif_scale_channel_init(struct rkcif_scale_vdev *scale_vdev)
 	if (cif_dev->inf_id == RKCIF_DVP)
 		scale_vdev->ch_src = SCALE_DVP;
 	else
-		scale_vdev->ch_src = 4 * cif_dev->csi_host_idx + scale_vdev->ch;
+		scale_vdev->ch_src = 4 * cif_dev->csi_host_idx + scale_vdev->stream->id;
 	ch_info->width = pixm.width;
 	ch_info->height = pixm.height;
 	ch_info->vir_width = ALIGN(ch_info->width  * fmt->bpp[0] / 8, 8);
@@ -869,6 +889,20 @@ int rkcif_scale_start(struct rkcif_scale_vdev *scale_vdev)
 	return ret;
 }
 
+/* start the scale channels that attached to @stream while it was running */
+void rkcif_scale_start_pending(struct rkcif_stream *stream)
+{
+	struct rkcif_device *dev = stream->cifdev;
+	u32 pending = stream->to_en_scale;
+	int ch;
+
+	stream->to_en_scale = 0;
+	for (ch = 0; ch < RKCIF_MAX_SCALE_CH; ch++) {
+		if (pending & BIT(ch))
+			rkcif_scale_start(&dev->scale_vdev[ch]);
+	}
+}
+
 static int
 rkcif_scale_vb2_start_streaming(struct vb2_queue *queue,
 				unsigned int count)
@@ -878,7 +912,7 @@ rkcif_scale_vb2_start_streaming(struct vb2_queue *queue,
 	int ret = 0;
 
 	if (stream->state == RKCIF_STATE_STREAMING) {
-		stream->to_en_scale = true;
+		stream->to_en_scale |= BIT(scale_vdev->ch);
 	} else {
 		ret = rkcif_scale_start(scale_vdev);
 		if (ret)
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0
 /* Copyright (c) 2020 Rockchip Electronics Co., Ltd. */
 
+#include <linux/dma-buf.h>
 #include <linux/kfifo.h>
 #include <media/v4l2-common.h>
 #include <media/v4l2-ioctl.h>
@@ -27,6 +28,8 @@
 #define TOOLS_MIN_HEIGHT	4
 #define TOOLS_OUTPUT_STEP_WISE	1
 #define CIF_TOOLS_REQ_BUFS_MIN	1
+/* frames waiting for the tools user, older ones go back to capture */
+#define CIF_TOOLS_SHARE_DEPTH	2
 
 static const struct cif_output_fmt tools_out_fmts[] = {
 	{
@@ -212,10 +215,142 @@ static int rkcif_tools_querycap(struct file *file,
 	return 0;
 }
 
+static int rkcif_tools_put_frame(struct rkcif_tools_vdev *tools_vdev, u32 index)
+{
+	struct rkcif_tools_buffer *tools_buf;
+	bool is_find = false;
+	unsigned long flags;
+
+	spin_lock_irqsave(&tools_vdev->vbq_lock, flags);
+	list_for_each_entry(tools_buf, &tools_vdev->share_held_head, share_list) {
+		if (tools_buf->vb->vb2_buf.index == index) {
+			list_del_init(&tools_buf->share_list);
+			is_find = true;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&tools_vdev->vbq_lock, flags);
+	if (!is_find)
+		return -EINVAL;
+	/* drop the tools reference, hw gets it once capture releases too */
+	rkcif_buf_queue(&tools_buf->vb->vb2_buf);
+	return 0;
+}
+
+static int rkcif_tools_get_frame(struct rkcif_tools_vdev *tools_vdev,
+				 struct rkcif_tools_frame *frame,
+				 bool is_nonblock)
+{
+	struct rkcif_tools_buffer *tools_buf = NULL;
+	struct vb2_buffer *vb;
+	struct dma_buf *dbuf;
+	unsigned long flags;
+	int ret;
+
+	if (!tools_vdev->is_share)
+		return -EINVAL;
+	if (!is_nonblock) {
+		ret = wait_event_interruptible_timeout(tools_vdev->wq_share,
+						       !list_empty(&tools_vdev->share_ready_head) ||
+						       !tools_vdev->is_share,
+						       msecs_to_jiffies(1000));
+		if (ret < 0)
+			return ret;
+	}
+
+	spin_lock_irqsave(&tools_vdev->vbq_lock, flags);
+	if (!list_empty(&tools_vdev->share_ready_head)) {
+		tools_buf = list_first_entry(&tools_vdev->share_ready_head,
+					     struct rkcif_tools_buffer, share_list);
+		list_move_tail(&tools_buf->share_list, &tools_vdev->share_held_head);
+		tools_vdev->share_ready_cnt--;
+	}
+	spin_unlock_irqrestore(&tools_vdev->vbq_lock, flags);
+	if (!tools_buf)
+		return -EAGAIN;
+
+	vb = &tools_buf->vb->vb2_buf;
+	if (vb->memory == VB2_MEMORY_DMABUF) {
+		dbuf = vb->planes[0].dbuf;
+		get_dma_buf(dbuf);
+	} else if (vb->vb2_queue->mem_ops->get_dmabuf) {
+		dbuf = vb->vb2_queue->mem_ops->get_dmabuf(vb->planes[0].mem_priv,
+							  O_RDWR);
+	} else {
+		dbuf = NULL;
+	}
+	if (IS_ERR_OR_NULL(dbuf)) {
+		ret = -EINVAL;
+		goto put_frame;
+	}
+	ret = dma_buf_fd(dbuf, O_CLOEXEC);
+	if (ret < 0) {
+		dma_buf_put(dbuf);
+		goto put_frame;
+	}
+
+	frame->fd = ret;
+	frame->index = vb->index;
+	frame->sequence = tools_buf->frame_idx;
+	frame->bytesused = vb2_get_plane_payload(vb, 0);
+	frame->timestamp = tools_buf->timestamp;
+	return 0;
+
+put_frame:
+	rkcif_tools_put_frame(tools_vdev, vb->index);
+	return ret;
+}
+
+static int rkcif_tools_set_share(struct rkcif_tools_vdev *tools_vdev, int on)
+{
+	struct rkcif_device *dev = tools_vdev->cifdev;
+	int ret = 0;
+
+	mutex_lock(&dev->tools_lock);
+	if (on) {
+		if (tools_vdev->is_share) {
+			goto out;
+		} else if (tools_vdev->state == RKCIF_STATE_STREAMING) {
+			/* the copy path owns the node */
+			ret = -EBUSY;
+			goto out;
+		}
+		tools_vdev->frame_idx = 0;
+		tools_vdev->is_share = true;
+		tools_vdev->state = RKCIF_STATE_STREAMING;
+	} else if (tools_vdev->is_share) {
+		rkcif_tools_stop(tools_vdev);
+		tools_vdev->is_share = false;
+		flush_work(&tools_vdev->work);
+		rkcif_tools_share_flush(tools_vdev, false);
+		wake_up(&tools_vdev->wq_share);
+	}
+out:
+	mutex_unlock(&dev->tools_lock);
+	return ret;
+}
+
 static long rkcif_tools_ioctl_default(struct file *file, void *fh,
 				    bool valid_prio, unsigned int cmd, void *arg)
 {
-	return 0;
+	struct rkcif_tools_vdev *tools_vdev = video_drvdata(file);
+	long ret = 0;
+
+	switch (cmd) {
+	case RKCIF_CMD_SET_TOOLS_SHARE:
+		ret = rkcif_tools_set_share(tools_vdev, *(int *)arg);
+		break;
+	case RKCIF_CMD_GET_TOOLS_FRAME:
+		ret = rkcif_tools_get_frame(tools_vdev, arg,
+					    file->f_flags & O_NONBLOCK);
+		break;
+	case RKCIF_CMD_PUT_TOOLS_FRAME:
+		ret = rkcif_tools_put_frame(tools_vdev, *(u32 *)arg);
+		break;
+	default:
+		break;
+	}
+	return ret;
 }
 
 static int rkcif_tools_enum_input(struct file *file, void *priv,
@@ -370,6 +505,8 @@ static int rkcif_tools_fop_release(struct file *file)
 	struct rkcif_device *cifdev = tools_vdev->cifdev;
 	int ret = 0;
 
+	if (v4l2_fh_is_singular_file(file))
+		rkcif_tools_set_share(tools_vdev, 0);
 	ret = vb2_fop_release(file);
 	if (!ret)
 		v4l2_pipeline_pm_put(&vnode->vdev.entity);
@@ -589,6 +726,72 @@ static int rkcif_tools_init_vb2_queue(struct vb2_queue *q,
 	return vb2_queue_init(q);
 }
 
+static void rkcif_tools_share_frame(struct rkcif_tools_vdev *tools_vdev,
+				    struct rkcif_tools_buffer *tools_buf)
+{
+	struct rkcif_tools_buffer *old_buf = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&tools_vdev->vbq_lock, flags);
+	if (tools_vdev->share_ready_cnt >= CIF_TOOLS_SHARE_DEPTH) {
+		old_buf = list_first_entry(&tools_vdev->share_ready_head,
+					   struct rkcif_tools_buffer, share_list);
+		list_del_init(&old_buf->share_list);
+		tools_vdev->share_ready_cnt--;
+	}
+	list_add_tail(&tools_buf->share_list, &tools_vdev->share_ready_head);
+	tools_vdev->share_ready_cnt++;
+	spin_unlock_irqrestore(&tools_vdev->vbq_lock, flags);
+
+	/* tools user is too slow, give the oldest frame back to capture */
+	if (old_buf)
+		rkcif_buf_queue(&old_buf->vb->vb2_buf);
+	wake_up(&tools_vdev->wq_share);
+}
+
+/*
+ * drop every tools reference taken in share mode. on capture stop the
+ * buffers left with no owner are returned to vb2 here, and the tools
+ * entries are freed since the capture vb2 buffers may be reallocated.
+ */
+void rkcif_tools_share_flush(struct rkcif_tools_vdev *tools_vdev, bool is_stop)
+{
+	struct rkcif_tools_buffer *tools_buf, *tmp;
+	unsigned long flags;
+	LIST_HEAD(share_list);
+	bool is_done;
+
+	spin_lock_irqsave(&tools_vdev->vbq_lock, flags);
+	list_splice_init(&tools_vdev->share_ready_head, &share_list);
+	list_splice_init(&tools_vdev->share_held_head, &share_list);
+	tools_vdev->share_ready_cnt = 0;
+	spin_unlock_irqrestore(&tools_vdev->vbq_lock, flags);
+
+	list_for_each_entry_safe(tools_buf, tmp, &share_list, share_list) {
+		list_del_init(&tools_buf->share_list);
+		if (!is_stop) {
+			rkcif_buf_queue(&tools_buf->vb->vb2_buf);
+			continue;
+		}
+		spin_lock_irqsave(&tools_vdev->vbq_lock, flags);
+		if (tools_buf->use_cnt)
+			tools_buf->use_cnt--;
+		is_done = !tools_buf->use_cnt;
+		spin_unlock_irqrestore(&tools_vdev->vbq_lock, flags);
+		if (is_done)
+			vb2_buffer_done(&tools_buf->vb->vb2_buf, VB2_BUF_STATE_ERROR);
+	}
+	if (!is_stop)
+		return;
+
+	spin_lock_irqsave(&tools_vdev->vbq_lock, flags);
+	list_for_each_entry_safe(tools_buf, tmp, &tools_vdev->src_buf_head, list) {
+		list_del(&tools_buf->list);
+		kfree(tools_buf);
+	}
+	spin_unlock_irqrestore(&tools_vdev->vbq_lock, flags);
+}
+
 static void rkcif_tools_buf_done(struct rkcif_tools_vdev *tools_vdev)
 {
 	struct rkcif_stream *stream = tools_vdev->stream;
@@ -624,6 +827,7 @@ static void rkcif_tools_buf_done(struct rkcif_tools_vdev *tools_vdev)
 	if (!is_find_tools_buf) {
 		tools_buf = kzalloc(sizeof(struct rkcif_tools_buffer), GFP_KERNEL);
 		tools_buf->vb = &buf->vb;
+		INIT_LIST_HEAD(&tools_buf->share_list);
 		list_add_tail(&tools_buf->list, &tools_vdev->src_buf_head);
 	}
 	tools_buf->use_cnt = 2;
@@ -649,7 +853,9 @@ static void rkcif_tools_buf_done(struct rkcif_tools_vdev *tools_vdev)
 	}
 	rkcif_vb_done_oneframe(stream, &buf->vb);
 
-	if (!list_empty(&tools_vdev->buf_head)) {
+	if (tools_vdev->is_share) {
+		rkcif_tools_share_frame(tools_vdev, tools_buf);
+	} else if (!list_empty(&tools_vdev->buf_head)) {
 		tools_vdev->curr_buf = list_first_entry(&tools_vdev->buf_head,
 						    struct rkcif_buffer, queue);
 		if (!tools_vdev->curr_buf || tools_vdev->state != RKCIF_STATE_STREAMING) {
@@ -810,9 +1016,12 @@ void rkcif_init_tools_vdev(struct rkcif_device *cif_dev, u32 ch)
 	INIT_LIST_HEAD(&tools_vdev->buf_head);
 	INIT_LIST_HEAD(&tools_vdev->buf_done_head);
 	INIT_LIST_HEAD(&tools_vdev->src_buf_head);
+	INIT_LIST_HEAD(&tools_vdev->share_ready_head);
+	INIT_LIST_HEAD(&tools_vdev->share_held_head);
 	spin_lock_init(&tools_vdev->vbq_lock);
 	rkcif_tools_set_fmt(tools_vdev, &pixm, false);
 	init_waitqueue_head(&tools_vdev->wq_stopped);
+	init_waitqueue_head(&tools_vdev->wq_share);
 	INIT_WORK(&tools_vdev->work, rkcif_tools_work);
 }
 
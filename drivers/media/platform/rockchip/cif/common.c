@@ -4,6 +4,8 @@
 #include <media/videobuf2-dma-contig.h>
 #include <media/videobuf2-dma-sg.h>
 #include <linux/of_platform.h>
+#include <linux/soc/rockchip/rockchip_frame_pool.h>
+#include <linux/soc/rockchip/rockchip_thunderboot_mem.h>
 #include "dev.h"
 #include "common.h"
 
@@ -62,6 +64,65 @@ int rkcif_alloc_buffer(struct rkcif_device *dev,
 	return ret;
 }
 
+/*
+ * Scratch buffer attached from the shared frame pool, for dma write sink
+ * only: other drivers write to the same memory.
+ */
+int rkcif_alloc_pool_buffer(struct rkcif_device *dev,
+			    struct rkcif_dummy_buffer *buf)
+{
+	const struct vb2_mem_ops *g_ops = dev->hw_dev->mem_ops;
+	struct sg_table *sg_tbl;
+	struct dma_buf *dbuf;
+	void *mem_priv;
+	int ret;
+
+	if (!buf->size)
+		return -EINVAL;
+
+	buf->size = PAGE_ALIGN(buf->size);
+	dbuf = rk_frame_pool_get_scratch(buf->size);
+	if (IS_ERR(dbuf))
+		return PTR_ERR(dbuf);
+
+	mem_priv = g_ops->attach_dmabuf(dev->hw_dev->dev, dbuf,
+					buf->size, DMA_BIDIRECTIONAL);
+	if (IS_ERR(mem_priv)) {
+		ret = PTR_ERR(mem_priv);
+		goto put;
+	}
+	ret = g_ops->map_dmabuf(mem_priv);
+	if (ret)
+		goto detach;
+	if (dev->hw_dev->is_dma_sg_ops) {
+		sg_tbl = (struct sg_table *)g_ops->cookie(mem_priv);
+		buf->dma_addr = sg_dma_address(sg_tbl->sgl);
+	} else {
+		buf->dma_addr = *((dma_addr_t *)g_ops->cookie(mem_priv));
+	}
+	if (buf->is_need_vaddr) {
+		buf->vaddr = g_ops->vaddr(mem_priv);
+		if (!buf->vaddr) {
+			ret = -ENOMEM;
+			goto unmap;
+		}
+	}
+	buf->mem_priv = mem_priv;
+	buf->dbuf = dbuf;
+	buf->is_pool = true;
+	v4l2_dbg(1, rkcif_debug, &dev->v4l2_dev,
+		 "%s buf:0x%x~0x%x size:%d\n", __func__,
+		 (u32)buf->dma_addr, (u32)buf->dma_addr + buf->size, buf->size);
+	return 0;
+unmap:
+	g_ops->unmap_dmabuf(mem_priv);
+detach:
+	g_ops->detach_dmabuf(mem_priv);
+put:
+	rk_frame_pool_put_scratch(dbuf);
+	return ret;
+}
+
 void rkcif_free_buffer(struct rkcif_device *dev,
 			struct rkcif_dummy_buffer *buf)
 {
@@ -71,9 +132,16 @@ void rkcif_free_buffer(struct rkcif_device *dev,
 		v4l2_dbg(1, rkcif_debug, &dev->v4l2_dev,
 			 "%s buf:0x%x~0x%x\n", __func__,
 			 (u32)buf->dma_addr, (u32)buf->dma_addr + buf->size);
-		if (buf->dbuf)
-			dma_buf_put(buf->dbuf);
-		g_ops->put(buf->mem_priv);
+		if (buf->is_pool) {
+			g_ops->unmap_dmabuf(buf->mem_priv);
+			g_ops->detach_dmabuf(buf->mem_priv);
+			rk_frame_pool_put_scratch(buf->dbuf);
+			buf->is_pool = false;
+		} else {
+			if (buf->dbuf)
+				dma_buf_put(buf->dbuf);
+			g_ops->put(buf->mem_priv);
+		}
 		buf->size = 0;
 		buf->dbuf = NULL;
 		buf->vaddr = NULL;
@@ -378,9 +446,8 @@ void rkcif_free_reserved_mem_buf(struct rkcif_device *dev, struct rkcif_rx_buffe
 	if (dummy->is_need_vaddr)
 		dummy->dbuf->ops->vunmap(dummy->dbuf, dummy->vaddr);
 #ifdef CONFIG_VIDEO_ROCKCHIP_THUNDER_BOOT_ISP
-	free_reserved_area(phys_to_virt(buf->shmem.shm_start),
-			   phys_to_virt(buf->shmem.shm_start + buf->shmem.shm_size),
-			   -1, "rkisp_thunderboot");
+	rk_tb_mem_release("rkisp_thunderboot_shm", buf->shmem.shm_start,
+			  buf->shmem.shm_size);
 #endif
 	buf->dummy.is_free = true;
 }
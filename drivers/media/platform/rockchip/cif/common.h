@@ -17,6 +17,8 @@
 
 int rkcif_alloc_buffer(struct rkcif_device *dev,
 		       struct rkcif_dummy_buffer *buf);
+int rkcif_alloc_pool_buffer(struct rkcif_device *dev,
+			    struct rkcif_dummy_buffer *buf);
 void rkcif_free_buffer(struct rkcif_device *dev,
 			struct rkcif_dummy_buffer *buf);
 
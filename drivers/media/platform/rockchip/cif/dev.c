@@ -22,6 +22,7 @@
 #include <linux/iommu.h>
 #include <dt-bindings/soc/rockchip-system-status.h>
 #include <soc/rockchip/rockchip-system-status.h>
+#include <soc/rockchip/rockchip_performance.h>
 #include <linux/io.h>
 #include <linux/mfd/syscon.h>
 #include "dev.h"
@@ -1192,6 +1193,15 @@ static void rkcif_sensor_streaming_cb(void *data)
 	v4l2_subdev_call(subdevs, video, s_stream, 1);
 }
 
+/* sensor stream on by i2c, run with other cameras after i2c ready */
+void rkcif_tb_client_init(struct rkcif_device *cif_dev)
+{
+	cif_dev->tb_client.name = dev_name(cif_dev->dev);
+	cif_dev->tb_client.id = RK_TB_CLIENT_CIF;
+	cif_dev->tb_client.deps = RK_TB_CLIENT_DEP(RK_TB_CLIENT_I2C);
+	cif_dev->tb_client.flags = RK_TB_CLIENT_ASYNC;
+}
+
 /*
  * stream-on order: isp_subdev, mipi dphy, sensor
  * stream-off order: mipi dphy, sensor, isp_subdev
@@ -1227,6 +1237,10 @@ static int rkcif_pipeline_set_stream(struct rkcif_pipeline *p, bool on)
 			cif_dev->irq_stats.not_active_buf_cnt[1] = 0;
 			cif_dev->irq_stats.not_active_buf_cnt[2] = 0;
 			cif_dev->irq_stats.not_active_buf_cnt[3] = 0;
+			cif_dev->irq_stats.frm_drop_cnt[0] = 0;
+			cif_dev->irq_stats.frm_drop_cnt[1] = 0;
+			cif_dev->irq_stats.frm_drop_cnt[2] = 0;
+			cif_dev->irq_stats.frm_drop_cnt[3] = 0;
 			cif_dev->irq_stats.trig_simult_cnt[0] = 0;
 			cif_dev->irq_stats.trig_simult_cnt[1] = 0;
 			cif_dev->irq_stats.trig_simult_cnt[2] = 0;
@@ -1248,6 +1262,7 @@ static int rkcif_pipeline_set_stream(struct rkcif_pipeline *p, bool on)
 			    !rk_tb_mcu_is_done()) {
 				cif_dev->tb_client.data = p->subdevs[i];
 				cif_dev->tb_client.cb = rkcif_sensor_streaming_cb;
+				rkcif_tb_client_init(cif_dev);
 				rk_tb_client_register_cb(&cif_dev->tb_client);
 			} else {
 				ret = v4l2_subdev_call(p->subdevs[i], video, s_stream, on);
@@ -1312,6 +1327,10 @@ static int rkcif_pipeline_set_stream(struct rkcif_pipeline *p, bool on)
 				cif_dev->irq_stats.not_active_buf_cnt[1] = 0;
 				cif_dev->irq_stats.not_active_buf_cnt[2] = 0;
 				cif_dev->irq_stats.not_active_buf_cnt[3] = 0;
+				cif_dev->irq_stats.frm_drop_cnt[0] = 0;
+				cif_dev->irq_stats.frm_drop_cnt[1] = 0;
+				cif_dev->irq_stats.frm_drop_cnt[2] = 0;
+				cif_dev->irq_stats.frm_drop_cnt[3] = 0;
 				cif_dev->irq_stats.trig_simult_cnt[0] = 0;
 				cif_dev->irq_stats.trig_simult_cnt[1] = 0;
 				cif_dev->irq_stats.trig_simult_cnt[2] = 0;
@@ -1333,6 +1352,7 @@ static int rkcif_pipeline_set_stream(struct rkcif_pipeline *p, bool on)
 				    !rk_tb_mcu_is_done()) {
 					cif_dev->tb_client.data = p->subdevs[i];
 					cif_dev->tb_client.cb = rkcif_sensor_streaming_cb;
+					rkcif_tb_client_init(cif_dev);
 					rk_tb_client_register_cb(&cif_dev->tb_client);
 				} else {
 					ret = v4l2_subdev_call(p->subdevs[i], video, s_stream, on);
@@ -2006,8 +2026,16 @@ static void rkcif_init_reset_monitor(struct rkcif_device *dev)
 	timer->csi2_first_err_timestamp = 0;
 
 	timer_setup(&timer->timer, rkcif_reset_watchdog_timer_handler, 0);
-
-	INIT_WORK(&dev->reset_work.work, rkcif_reset_work);
+	INIT_WORK(&timer->monitor_work, rkcif_reset_monitor_work);
+	INIT_WORK(&timer->detect_work, rkcif_reset_detect_work);
+
+	kthread_init_work(&dev->reset_work.work, rkcif_reset_work);
+	/* recovery in rt, placed by the performance level */
+	dev->reset_worker = rockchip_perf_create_worker("rkcif_reset");
+	if (IS_ERR(dev->reset_worker)) {
+		dev_warn(dev->dev, "failed to create reset worker\n");
+		dev->reset_worker = NULL;
+	}
 }
 
 void rkcif_set_sensor_stream(struct work_struct *work)
@@ -2131,7 +2159,13 @@ int rkcif_plat_init(struct rkcif_device *cif_dev, struct device_node *node, int
 #else
 	cif_dev->is_use_dummybuf = false;
 #endif
-	if (cif_dev->chip_id == CHIP_RV1106_CIF)
+	/*
+	 * from rk3588 on, the pingpong irq gates dma off when both ping and
+	 * pong run out of buffers and turns it back on at the next frame
+	 * start after a qbuf, so the frame is dropped by hw without a
+	 * full size dummy write. bt656 multi channel still takes a dummy.
+	 */
+	if (cif_dev->chip_id >= CHIP_RK3588_CIF)
 		cif_dev->is_use_dummybuf = false;
 
 	strlcpy(cif_dev->media_dev.model, dev_name(dev),
@@ -2327,6 +2361,10 @@ static int rkcif_plat_probe(struct platform_device *pdev)
 	dev_set_drvdata(dev, cif_dev);
 	cif_dev->dev = dev;
 
+	ret = rk_fill_light_init(&cif_dev->fill_light, dev, dev_name(dev));
+	if (ret)
+		return ret;
+
 	if (sysfs_create_group(&pdev->dev.kobj, &dev_attr_grp))
 		return -ENODEV;
 
@@ -2350,6 +2388,8 @@ static int rkcif_plat_probe(struct platform_device *pdev)
 		dev_warn(dev, "dev:%s create proc failed\n", dev_name(dev));
 
 	rkcif_init_reset_monitor(cif_dev);
+	if (rk_exp_queue_init(&cif_dev->exp_queue, dev_name(dev)))
+		dev_warn(dev, "no exposure queue\n");
 	if (cif_dev->chip_id == CHIP_RV1106_CIF)
 		rkcif_rockit_dev_init(cif_dev);
 	pm_runtime_enable(&pdev->dev);
@@ -2365,7 +2405,12 @@ static int rkcif_plat_remove(struct platform_device *pdev)
 	rkcif_detach_hw(cif_dev);
 	rkcif_proc_cleanup(cif_dev);
 	sysfs_remove_group(&pdev->dev.kobj, &dev_attr_grp);
+	cancel_work_sync(&cif_dev->reset_watchdog_timer.monitor_work);
+	del_timer_sync(&cif_dev->reset_watchdog_timer.timer);
+	cancel_work_sync(&cif_dev->reset_watchdog_timer.detect_work);
 	del_timer_sync(&cif_dev->reset_watchdog_timer.timer);
+	rockchip_perf_destroy_worker(cif_dev->reset_worker);
+	rk_exp_queue_remove(&cif_dev->exp_queue);
 
 	return 0;
 }
@@ -8,6 +8,7 @@
 #ifndef _RKCIF_DEV_H
 #define _RKCIF_DEV_H
 
+#include <linux/kfifo.h>
 #include <linux/mutex.h>
 #include <media/media-device.h>
 #include <media/media-entity.h>
@@ -16,6 +17,10 @@
 #include <media/videobuf2-v4l2.h>
 #include <media/v4l2-mc.h>
 #include <linux/workqueue.h>
+#include <linux/kthread.h>
+#include <soc/rockchip/rockchip_exp_queue.h>
+#include <soc/rockchip/rockchip_fill_light.h>
+#include <soc/rockchip/rockchip_lat_hist.h>
 #include <linux/rk-camera-module.h>
 #include <linux/rkcif-config.h>
 #include <linux/soc/rockchip/rockchip_thunderboot_service.h>
@@ -67,6 +72,8 @@
 #define RKCIF_STREAM_MIPI_ID2	2
 #define RKCIF_STREAM_MIPI_ID3	3
 #define RKCIF_MAX_STREAM_MIPI	4
+/* done buffers handed from irq to tasklet, single producer and consumer */
+#define RKCIF_VB_DONE_FIFO_SIZE	VIDEO_MAX_FRAME
 #define RKCIF_MAX_STREAM_LVDS	4
 #define RKCIF_MAX_STREAM_DVP	4
 #define RKCIF_STREAM_DVP	4
@@ -203,6 +210,7 @@ struct rkcif_tools_buffer {
 	struct vb2_v4l2_buffer *vb;
 	struct rkisp_rx_buf *dbufs;
 	struct list_head list;
+	struct list_head share_list;
 	u32 frame_idx;
 	u64 timestamp;
 	int use_cnt;
@@ -354,6 +362,7 @@ struct rkcif_readout_stats {
  * @dvp_line_err_cnt: count dvp line err irq
  * @dvp_pix_err_cnt: count dvp pix err irq
  * @all_frm_end_cnt: raw frame end count
+ * @frm_drop_cnt: frames landed in dummy or reused buffer for lack of user buffer
  * @all_err_cnt: all err count
  * @
  */
@@ -370,6 +379,7 @@ struct rkcif_irq_stats {
 	u64 frm_end_cnt[RKCIF_MAX_STREAM_MIPI];
 	u64 not_active_buf_cnt[RKCIF_MAX_STREAM_MIPI];
 	u64 trig_simult_cnt[RKCIF_MAX_STREAM_MIPI];
+	u64 frm_drop_cnt[RKCIF_MAX_STREAM_MIPI];
 	u64 all_err_cnt;
 };
 
@@ -391,14 +401,25 @@ struct rkcif_resume_info {
 	u32 frm_sync_seq;
 };
 
+/* reset monitor recovery steps, tried from the cheapest one */
+enum rkcif_recover_tier {
+	RKCIF_RECOVER_RESYNC,
+	RKCIF_RECOVER_CSI_HOST,
+	RKCIF_RECOVER_FULL,
+	RKCIF_RECOVER_TIER_MAX,
+};
+
 struct rkcif_work_struct {
-	struct work_struct	work;
+	struct kthread_work	work;
 	enum rkmodule_reset_src	reset_src;
 	struct rkcif_resume_info	resume_info;
+	struct rk_lat_hist	recover_hist[RKCIF_RECOVER_TIER_MAX];
 };
 
 struct rkcif_timer {
 	struct timer_list	timer;
+	struct work_struct	monitor_work;
+	struct work_struct	detect_work;
 	spinlock_t		timer_lock;
 	spinlock_t		csi2_err_lock;
 	unsigned long		cycle;
@@ -472,6 +493,23 @@ struct rkcif_skip_info {
 	bool skip_en;
 	bool skip_to_en;
 	bool skip_to_dis;
+	/* static config from RKCIF_CMD_SET_FPS, restored when backpressure ends */
+	u8 fps_cap_m;
+	u8 fps_skip_n;
+	bool fps_skip_en;
+};
+
+/* struct rkcif_bp_info - adaptive skip state driven by consumer depth
+ * @high_wm: depth to step the skip ratio up, 0 means disabled
+ * @low_wm: depth to step the skip ratio down
+ * @depth: last depth reported by the consumer
+ * @level: index of the current skip pattern, 0 is no adaptive skip
+ */
+struct rkcif_bp_info {
+	u32 high_wm;
+	u32 low_wm;
+	u32 depth;
+	u32 level;
 };
 
 struct rkcif_sync_cfg {
@@ -540,6 +578,7 @@ struct rkcif_stream {
 	struct rkcif_fps_stats		fps_stats;
 	struct rkcif_extend_info	extend_line;
 	struct rkcif_readout_stats	readout;
+	struct rk_lat_hist		lat_hist;
 	unsigned int			fs_cnt_in_single_frame;
 	unsigned int			capture_mode;
 	struct rkcif_scale_vdev		*scale_vdev;
@@ -547,6 +586,7 @@ struct rkcif_stream {
 	int				dma_en;
 	int				to_en_dma;
 	int				to_stop_dma;
+	u32				to_en_scale; /* bit mask of scale ch waiting to start */
 	int				buf_owner;
 	int				buf_replace_cnt;
 	struct list_head		rx_buf_head_vicap;
@@ -559,8 +599,9 @@ struct rkcif_stream {
 	int				lack_buf_cnt;
 	unsigned int			buf_wake_up_cnt;
 	struct rkcif_skip_info		skip_info;
+	struct rkcif_bp_info		bp_info;
 	struct tasklet_struct		vb_done_tasklet;
-	struct list_head		vb_done_list;
+	DECLARE_KFIFO(vb_done_fifo, struct rkcif_buffer *, RKCIF_VB_DONE_FIFO_SIZE);
 	int				last_rx_buf_idx;
 	int				last_frame_idx;
 	int				new_fource_idx;
@@ -582,7 +623,6 @@ struct rkcif_stream {
 	bool				is_can_stop;
 	bool				is_buf_active;
 	bool				is_high_align;
-	bool				to_en_scale;
 	bool				is_finish_stop_dma;
 	bool				is_in_vblank;
 	bool				is_change_toisp;
@@ -773,8 +813,11 @@ struct rkcif_tools_vdev {
 	struct list_head buf_head;
 	struct list_head buf_done_head;
 	struct list_head src_buf_head;
+	struct list_head share_ready_head;
+	struct list_head share_held_head;
 	spinlock_t vbq_lock; /* vfd lock */
 	wait_queue_head_t wq_stopped;
+	wait_queue_head_t wq_share;
 	struct v4l2_pix_format_mplane	pixm;
 	const struct cif_output_fmt *tools_out_fmt;
 	struct rkcif_buffer *curr_buf;
@@ -782,7 +825,9 @@ struct rkcif_tools_vdev {
 	enum rkcif_state state;
 	int frame_phase;
 	unsigned int frame_idx;
+	u32 share_ready_cnt;
 	bool stopping;
+	bool is_share;
 };
 
 static inline
@@ -797,6 +842,7 @@ int rkcif_register_tools_vdevs(struct rkcif_device *cif_dev,
 				bool is_multi_input);
 void rkcif_unregister_tools_vdevs(struct rkcif_device *cif_dev,
 				   int stream_num);
+void rkcif_tools_share_flush(struct rkcif_tools_vdev *tools_vdev, bool is_stop);
 
 enum rkcif_err_state {
 	RKCIF_ERR_ID0_NOT_BUF = 0x1,
@@ -854,6 +900,8 @@ enum rkcif_interlace_mode {
  * @base_addr: base register address
  * @active_sensor: sensor in-use, set when streaming on
  * @stream: capture video device
+ * @exp_queue: sensor exposures written at the sof of their frame
+ * @fill_light: ir or white light strobed on the exposure window
  */
 struct rkcif_device {
 	struct list_head		list;
@@ -900,6 +948,9 @@ struct rkcif_device {
 	spinlock_t			buffree_lock;
 	struct rkcif_timer		reset_watchdog_timer;
 	struct rkcif_work_struct	reset_work;
+	struct kthread_worker		*reset_worker;
+	struct rk_exp_queue		exp_queue;
+	struct rk_fill_light		fill_light;
 	int				id_use_cnt;
 	unsigned int			csi_host_idx;
 	unsigned int			csi_host_idx_def;
@@ -951,6 +1002,8 @@ struct rkcif_device {
 
 extern struct platform_driver rkcif_plat_drv;
 void rkcif_set_fps(struct rkcif_stream *stream, struct rkcif_fps *fps);
+int rkcif_set_backpressure(struct rkcif_stream *stream,
+			   struct rkcif_backpressure *bp);
 int rkcif_do_start_stream(struct rkcif_stream *stream,
 				enum rkcif_stream_mode mode);
 void rkcif_do_stop_stream(struct rkcif_stream *stream,
@@ -962,6 +1015,7 @@ void rkcif_buf_queue(struct vb2_buffer *vb);
 void rkcif_vb_done_tasklet(struct rkcif_stream *stream, struct rkcif_buffer *buf);
 
 int rkcif_scale_start(struct rkcif_scale_vdev *scale_vdev);
+void rkcif_scale_start_pending(struct rkcif_stream *stream);
 
 const struct
 cif_input_fmt *rkcif_get_input_fmt(struct rkcif_device *dev,
@@ -1003,10 +1057,12 @@ int rkcif_attach_hw(struct rkcif_device *cif_dev);
 int rkcif_update_sensor_info(struct rkcif_stream *stream);
 int rkcif_reset_notifier(struct notifier_block *nb, unsigned long action, void *data);
 void rkcif_reset_watchdog_timer_handler(struct timer_list *t);
+void rkcif_reset_monitor_work(struct work_struct *work);
+void rkcif_reset_detect_work(struct work_struct *work);
 void rkcif_config_dvp_clk_sampling_edge(struct rkcif_device *dev,
 					enum rkcif_clk_edge edge);
 void rkcif_enable_dvp_clk_dual_edge(struct rkcif_device *dev, bool on);
-void rkcif_reset_work(struct work_struct *work);
+void rkcif_reset_work(struct kthread_work *work);
 
 void rkcif_vb_done_oneframe(struct rkcif_stream *stream,
 			    struct vb2_v4l2_buffer *vb_done);
@@ -1045,6 +1101,7 @@ void rkcif_rockit_dev_deinit(void);
 void rkcif_err_print_work(struct work_struct *work);
 int rkcif_stream_suspend(struct rkcif_device *cif_dev, int mode);
 int rkcif_stream_resume(struct rkcif_device *cif_dev, int mode);
+int rkcif_switch_work_mode(struct rkcif_device *cif_dev, bool online);
 
 static inline u64 rkcif_time_get_ns(struct rkcif_device *dev)
 {
@@ -1056,5 +1113,6 @@ static inline u64 rkcif_time_get_ns(struct rkcif_device *dev)
 
 bool rkcif_check_single_dev_stream_on(struct rkcif_hw *hw);
 void rkcif_dphy_quick_stream(struct rkcif_device *dev, int on);
+void rkcif_tb_client_init(struct rkcif_device *cif_dev);
 
 #endif
@@ -1154,6 +1154,37 @@ static const struct of_device_id rkcif_plat_of_match[] = {
 	{},
 };
 
+static struct rkcif_handover rkcif_handover;
+static DEFINE_MUTEX(rkcif_handover_lock);
+
+int rkcif_handover_register(const struct rkcif_handover *handover)
+{
+	int ret = 0;
+
+	mutex_lock(&rkcif_handover_lock);
+	if (rkcif_handover.release)
+		ret = -EBUSY;
+	else
+		rkcif_handover = *handover;
+	mutex_unlock(&rkcif_handover_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(rkcif_handover_register);
+
+static void rkcif_handover_release(void)
+{
+	struct rkcif_handover handover;
+
+	mutex_lock(&rkcif_handover_lock);
+	handover = rkcif_handover;
+	memset(&rkcif_handover, 0, sizeof(rkcif_handover));
+	mutex_unlock(&rkcif_handover_lock);
+
+	if (handover.release)
+		handover.release(handover.data);
+}
+
 static irqreturn_t rkcif_irq_handler(int irq, void *ctx)
 {
 	struct device *dev = ctx;
@@ -1162,6 +1193,10 @@ static irqreturn_t rkcif_irq_handler(int irq, void *ctx)
 	u64 irq_start, irq_stop;
 	int i;
 
+	/* the line is shared with a handed over pipeline still running */
+	if (!atomic_read(&cif_hw->power_cnt))
+		return IRQ_NONE;
+
 	irq_start = ktime_get_ns();
 	if (cif_hw->chip_id >= CHIP_RK3588_CIF) {
 		intstat_glb = rkcif_irq_global(cif_hw->cif_dev[0]);
@@ -1539,6 +1574,8 @@ static int __maybe_unused rkcif_runtime_resume(struct device *dev)
 	struct rkcif_hw *cif_hw = dev_get_drvdata(dev);
 	int ret;
 
+	if (atomic_read(&cif_hw->power_cnt) == 0)
+		rkcif_handover_release();
 	if (atomic_inc_return(&cif_hw->power_cnt) > 1)
 		return 0;
 	ret = pinctrl_pm_select_default_state(dev);
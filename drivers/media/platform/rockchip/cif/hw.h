@@ -86,6 +86,7 @@ struct rkcif_dummy_buffer {
 	bool is_need_dbuf;
 	bool is_need_dmafd;
 	bool is_free;
+	bool is_pool;
 };
 
 /*
@@ -153,9 +154,21 @@ struct rkcif_hw {
 	bool				is_rk3588s2;
 };
 
+/*
+ * A pipeline an early camera (the vehicle reverse camera) leaves
+ * streaming while the cif driver probes. release() stops it at the first
+ * power on of the cif, right before the hardware is reset, so the early
+ * preview goes on until userspace opens the camera.
+ */
+struct rkcif_handover {
+	void (*release)(void *data);
+	void *data;
+};
+
 void rkcif_hw_soft_reset(struct rkcif_hw *cif_hw, bool is_rst_iommu);
 void rkcif_disable_sys_clk(struct rkcif_hw *cif_hw);
 int rkcif_enable_sys_clk(struct rkcif_hw *cif_hw);
 int rk_cif_plat_drv_init(void);
+int rkcif_handover_register(const struct rkcif_handover *handover);
 
 #endif
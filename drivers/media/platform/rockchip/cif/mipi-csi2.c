@@ -15,9 +15,12 @@
 #include <linux/of_graph.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
+#include <linux/proc_fs.h>
 #include <linux/reset.h>
 #include <linux/rk-camera-module.h>
+#include <linux/seq_file.h>
 #include <media/v4l2-ioctl.h>
+#include <trace/events/rkcif.h>
 #include "mipi-csi2.h"
 #include <linux/regulator/consumer.h>
 
@@ -229,6 +232,23 @@ static void csi2_enable(struct csi2_hw *csi2_hw,
 	write_csihost_reg(base, CSIHOST_RESETN, 1);
 }
 
+static void csi2_stats_reset(struct csi2_dev *csi2)
+{
+	struct csi2_link_stats *stats = &csi2->stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	memset(stats->lane, 0, sizeof(stats->lane));
+	memset(stats->vc, 0, sizeof(stats->vc));
+	memset(stats->rate_hist, 0, sizeof(stats->rate_hist));
+	stats->ecc2 = 0;
+	stats->code_hs = 0;
+	stats->resets = 0;
+	stats->win_errs = 0;
+	stats->win_start = jiffies;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
 static int csi2_start(struct csi2_dev *csi2)
 {
 	enum host_type_t host_type;
@@ -236,6 +256,7 @@ static int csi2_start(struct csi2_dev *csi2)
 	int csi_idx = 0;
 
 	atomic_set(&csi2->frm_sync_seq, 0);
+	csi2_stats_reset(csi2);
 
 	csi2_update_sensor_info(csi2);
 
@@ -548,6 +569,45 @@ void rkcif_csi2_event_reset_pipe(struct csi2_dev *csi2_dev, int reset_src)
 	}
 }
 
+/* reset the csi host under a running stream, sensor and vicap go on */
+int rkcif_csi2_reset_host(struct csi2_dev *csi2_dev)
+{
+	struct csi2_hw *csi2_hw;
+	enum host_type_t host_type;
+	int i;
+
+	mutex_lock(&csi2_dev->lock);
+	if (!csi2_dev->stream_count) {
+		mutex_unlock(&csi2_dev->lock);
+		return -EINVAL;
+	}
+
+	if (csi2_dev->dsi_input_en == RKMODULE_DSI_INPUT)
+		host_type = RK_DSI_RXHOST;
+	else
+		host_type = RK_CSI_RXHOST;
+
+	for (i = 0; i < csi2_dev->csi_info.csi_num; i++) {
+		csi2_hw = csi2_dev->csi2_hw[csi2_dev->csi_info.csi_idx[i]];
+		disable_irq(csi2_hw->irq1);
+		disable_irq(csi2_hw->irq2);
+		csi2_disable(csi2_hw);
+		csi2_hw_do_reset(csi2_hw);
+		csi2_enable(csi2_hw, host_type);
+		enable_irq(csi2_hw->irq1);
+		enable_irq(csi2_hw->irq2);
+	}
+
+	for (i = 0; i < RK_CSI2_ERR_MAX; i++)
+		csi2_dev->err_list[i].cnt = 0;
+	spin_lock_irq(&csi2_dev->stats.lock);
+	csi2_dev->stats.resets++;
+	spin_unlock_irq(&csi2_dev->stats.lock);
+	mutex_unlock(&csi2_dev->lock);
+
+	return 0;
+}
+
 void rkcif_csi2_event_inc_sof(struct csi2_dev *csi2_dev)
 {
 	if (csi2_dev) {
@@ -779,6 +839,79 @@ static void csi2_find_err_vc(int val, char *vc_info)
 	if (strlen(dst_str) + strlen(src_str) < CSI_ERRSTR_LEN)\
 		strncat(dst_str, src_str, strlen(src_str)); }
 
+#define CSIHOST_ERR1_ALL	(CSIHOST_ERR1_PHYERR_SPTSYNCHS | \
+				 CSIHOST_ERR1_ERR_BNDRY_MATCH | \
+				 CSIHOST_ERR1_ERR_SEQ | \
+				 CSIHOST_ERR1_ERR_FRM_DATA | \
+				 CSIHOST_ERR1_ERR_CTRL | \
+				 CSIHOST_ERR1_ERR_CRC | \
+				 CSIHOST_ERR1_ERR_ECC2)
+#define CSIHOST_ERR2_ALL	(CSIHOST_ERR2_PHYERR_ESC | \
+				 CSIHOST_ERR2_PHYERR_SOTHS | \
+				 CSIHOST_ERR2_ECC_CORRECTED | \
+				 CSIHOST_ERR2_ERR_ID | \
+				 CSIHOST_ERR2_PHYERR_CODEHS)
+
+static void csi2_stats_add(u32 *cnt, u32 bits)
+{
+	int i;
+
+	for (i = 0; i < CSI2_STATS_CH_NUM; i++)
+		if (bits & BIT(i))
+			cnt[i]++;
+}
+
+/* close the one second windows that ended, stats->lock held */
+static void csi2_stats_rate(struct csi2_link_stats *stats, u32 errs)
+{
+	unsigned long elapsed = jiffies - stats->win_start;
+	unsigned long idle;
+
+	if (elapsed >= HZ) {
+		stats->rate_hist[min_t(int, fls(stats->win_errs),
+				       CSI2_STATS_HIST_NUM - 1)]++;
+		idle = elapsed / HZ - 1;
+		stats->rate_hist[0] += idle;
+		stats->win_start += (idle + 1) * HZ;
+		stats->win_errs = 0;
+	}
+	stats->win_errs += errs;
+}
+
+static void csi2_stats_err1(struct csi2_dev *csi2, u32 val)
+{
+	struct csi2_link_stats *stats = &csi2->stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	csi2_stats_add(stats->lane[CSI2_STATS_SOT_SYNC], val);
+	csi2_stats_add(stats->vc[CSI2_STATS_FSFE], val >> 4);
+	csi2_stats_add(stats->vc[CSI2_STATS_SEQ], val >> 8);
+	csi2_stats_add(stats->vc[CSI2_STATS_FRM_DATA], val >> 12);
+	csi2_stats_add(stats->vc[CSI2_STATS_CTRL], val >> 16);
+	csi2_stats_add(stats->vc[CSI2_STATS_CRC], val >> 24);
+	if (val & CSIHOST_ERR1_ERR_ECC2)
+		stats->ecc2++;
+	csi2_stats_rate(stats, hweight32(val & CSIHOST_ERR1_ALL));
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+static void csi2_stats_err2(struct csi2_dev *csi2, u32 val)
+{
+	struct csi2_link_stats *stats = &csi2->stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	csi2_stats_add(stats->lane[CSI2_STATS_ESC], val);
+	csi2_stats_add(stats->lane[CSI2_STATS_SOT_HS], val >> 4);
+	csi2_stats_add(stats->vc[CSI2_STATS_ECC], val >> 8);
+	csi2_stats_add(stats->vc[CSI2_STATS_ID], val >> 12);
+	if (val & CSIHOST_ERR2_PHYERR_CODEHS)
+		stats->code_hs++;
+	csi2_stats_rate(stats, hweight32(val & CSIHOST_ERR2_ALL));
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
 static irqreturn_t rk_csirx_irq1_handler(int irq, void *ctx)
 {
 	struct device *dev = ctx;
@@ -804,6 +937,8 @@ static irqreturn_t rk_csirx_irq1_handler(int irq, void *ctx)
 	}
 	val = read_csihost_reg(csi2_hw->base, CSIHOST_ERR1);
 	if (val) {
+		trace_rkcif_csi2_err(csi2_hw->dev_name, 1, val);
+		csi2_stats_err1(csi2, val);
 		if (val & CSIHOST_ERR1_PHYERR_SPTSYNCHS) {
 			err_list = &csi2->err_list[RK_CSI2_ERR_SOTSYN];
 			err_list->cnt++;
@@ -909,6 +1044,9 @@ static irqreturn_t rk_csirx_irq2_handler(int irq, void *ctx)
 
 	val = read_csihost_reg(csi2_hw->base, CSIHOST_ERR2);
 	if (val) {
+		trace_rkcif_csi2_err(csi2_hw->dev_name, 2, val);
+		if (csi2_hw->csi2)
+			csi2_stats_err2(csi2_hw->csi2, val);
 		if (val & CSIHOST_ERR2_PHYERR_ESC) {
 			csi2_find_err_vc(val & 0xf, vc_info);
 			snprintf(cur_str, CSI_ERRSTR_LEN, "(ULPM,lane:%s) ", vc_info);
@@ -1080,6 +1218,67 @@ static int csi2_attach_hw(struct csi2_dev *csi2)
 	return 0;
 }
 
+#ifdef CONFIG_PROC_FS
+static int csi2_stats_show(struct seq_file *f, void *data)
+{
+	static const char * const lane_name[] = {
+		"sot_sync", "sot_hs", "esc",
+	};
+	static const char * const vc_name[] = {
+		"crc", "ecc", "fs_fe", "seq", "frm_data", "ctrl", "id",
+	};
+	struct csi2_dev *csi2 = f->private;
+	struct csi2_link_stats *stats = &csi2->stats;
+	int i, j;
+
+	spin_lock_irq(&stats->lock);
+	if (csi2->stream_count)
+		csi2_stats_rate(stats, 0);
+	seq_printf(f, "%s streaming:%d resets:%u ecc2:%u code_hs:%u\n",
+		   csi2->dev_name, csi2->stream_count, stats->resets,
+		   stats->ecc2, stats->code_hs);
+	seq_printf(f, "%-10s 0 1 2 3\n", "lane");
+	for (i = 0; i < CSI2_STATS_LANE_MAX; i++) {
+		seq_printf(f, "%-10s", lane_name[i]);
+		for (j = 0; j < CSI2_STATS_CH_NUM; j++)
+			seq_printf(f, " %u", stats->lane[i][j]);
+		seq_putc(f, '\n');
+	}
+	seq_printf(f, "%-10s 0 1 2 3\n", "vc");
+	for (i = 0; i < CSI2_STATS_VC_MAX; i++) {
+		seq_printf(f, "%-10s", vc_name[i]);
+		for (j = 0; j < CSI2_STATS_CH_NUM; j++)
+			seq_printf(f, " %u", stats->vc[i][j]);
+		seq_putc(f, '\n');
+	}
+	seq_printf(f, "%-10s 0:%u", "errors/s", stats->rate_hist[0]);
+	for (i = 1; i < CSI2_STATS_HIST_NUM - 1; i++)
+		seq_printf(f, " %u-%u:%u", 1 << (i - 1), (1 << i) - 1,
+			   stats->rate_hist[i]);
+	seq_printf(f, " %u+:%u\n", 1 << (i - 1), stats->rate_hist[i]);
+	spin_unlock_irq(&stats->lock);
+
+	return 0;
+}
+
+static void csi2_proc_init(struct csi2_dev *csi2)
+{
+	csi2->procfs = proc_create_single_data(dev_name(csi2->dev), 0444,
+					       NULL, csi2_stats_show, csi2);
+	if (!csi2->procfs)
+		dev_warn(csi2->dev, "create proc/%s failed!\n",
+			 dev_name(csi2->dev));
+}
+
+static void csi2_proc_cleanup(struct csi2_dev *csi2)
+{
+	proc_remove(csi2->procfs);
+}
+#else
+static inline void csi2_proc_init(struct csi2_dev *csi2) {}
+static inline void csi2_proc_cleanup(struct csi2_dev *csi2) {}
+#endif
+
 static int csi2_probe(struct platform_device *pdev)
 {
 	const struct of_device_id *match;
@@ -1118,6 +1317,7 @@ static int csi2_probe(struct platform_device *pdev)
 		return -EINVAL;
 	}
 	mutex_init(&csi2->lock);
+	spin_lock_init(&csi2->stats.lock);
 
 	ret = csi2_media_init(&csi2->sd);
 	if (ret < 0)
@@ -1126,6 +1326,7 @@ static int csi2_probe(struct platform_device *pdev)
 	if (ret)
 		goto rmmutex;
 
+	csi2_proc_init(csi2);
 	v4l2_info(&csi2->sd, "probe success, v4l2_dev:%s!\n", csi2->sd.v4l2_dev->name);
 
 	return 0;
@@ -1140,6 +1341,7 @@ static int csi2_remove(struct platform_device *pdev)
 	struct v4l2_subdev *sd = platform_get_drvdata(pdev);
 	struct csi2_dev *csi2 = sd_to_dev(sd);
 
+	csi2_proc_cleanup(csi2);
 	v4l2_async_unregister_subdev(sd);
 	mutex_destroy(&csi2->lock);
 	media_entity_cleanup(&sd->entity);
@@ -33,6 +33,9 @@
 #define CSI_ERRSTR_LEN		(256)
 #define CSI_VCINFO_LEN		(12)
 
+#define CSI2_STATS_CH_NUM	4
+#define CSI2_STATS_HIST_NUM	9
+
 /*
  * The default maximum bit-rate per lane in Mbps, if the
  * source subdev does not provide V4L2_CID_LINK_FREQ.
@@ -139,6 +142,43 @@ struct csi2_err_stats {
 	unsigned int cnt;
 };
 
+/*
+ * Link error counters, kept from stream on to stream off including host
+ * resets. Phy errors are counted per data lane, packet errors per vc as
+ * the host reports them. rate_hist[0] counts streaming seconds without
+ * error, rate_hist[n] seconds with 2^(n-1) to 2^n - 1 errors, the last
+ * bucket everything above.
+ */
+enum csi2_stats_lane {
+	CSI2_STATS_SOT_SYNC,
+	CSI2_STATS_SOT_HS,
+	CSI2_STATS_ESC,
+	CSI2_STATS_LANE_MAX
+};
+
+enum csi2_stats_vc {
+	CSI2_STATS_CRC,
+	CSI2_STATS_ECC,
+	CSI2_STATS_FSFE,
+	CSI2_STATS_SEQ,
+	CSI2_STATS_FRM_DATA,
+	CSI2_STATS_CTRL,
+	CSI2_STATS_ID,
+	CSI2_STATS_VC_MAX
+};
+
+struct csi2_link_stats {
+	spinlock_t lock;
+	u32 lane[CSI2_STATS_LANE_MAX][CSI2_STATS_CH_NUM];
+	u32 vc[CSI2_STATS_VC_MAX][CSI2_STATS_CH_NUM];
+	u32 ecc2;
+	u32 code_hs;
+	u32 resets;
+	u32 rate_hist[CSI2_STATS_HIST_NUM];
+	u32 win_errs;
+	unsigned long win_start;
+};
+
 struct csi2_dev {
 	struct device		*dev;
 	struct v4l2_subdev	sd;
@@ -165,6 +205,10 @@ struct csi2_dev {
 	int			num_sensors;
 	atomic_t		frm_sync_seq;
 	struct csi2_err_stats	err_list[RK_CSI2_ERR_MAX];
+	struct csi2_link_stats	stats;
+#ifdef CONFIG_PROC_FS
+	struct proc_dir_entry	*procfs;
+#endif
 	struct csi2_hw		*csi2_hw[RK_MAX_CSI_HW];
 	int			irq1;
 	int			irq2;
@@ -201,5 +245,6 @@ void rkcif_csi2_hw_plat_drv_exit(void);
 int rkcif_csi2_register_notifier(struct notifier_block *nb);
 int rkcif_csi2_unregister_notifier(struct notifier_block *nb);
 void rkcif_csi2_event_reset_pipe(struct csi2_dev *csi2_dev, int reset_src);
+int rkcif_csi2_reset_host(struct csi2_dev *csi2_dev);
 
 #endif
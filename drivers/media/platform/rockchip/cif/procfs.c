@@ -361,6 +361,11 @@ static void rkcif_show_format(struct rkcif_device *dev, struct seq_file *f)
 			   dev->irq_stats.not_active_buf_cnt[1],
 			   dev->irq_stats.not_active_buf_cnt[2],
 			   dev->irq_stats.not_active_buf_cnt[3]);
+		seq_printf(f, "\t\t\tframe drop cnt:%llu %llu %llu %llu\n",
+			   dev->irq_stats.frm_drop_cnt[0],
+			   dev->irq_stats.frm_drop_cnt[1],
+			   dev->irq_stats.frm_drop_cnt[2],
+			   dev->irq_stats.frm_drop_cnt[3]);
 		seq_printf(f, "\t\t\tall err count:%llu\n", dev->irq_stats.all_err_cnt);
 		seq_printf(f, "\t\t\tframe dma end:%llu %llu %llu %llu\n",
 			   dev->irq_stats.frm_end_cnt[0],
@@ -381,6 +386,28 @@ static void rkcif_show_format(struct rkcif_device *dev, struct seq_file *f)
 			   dev->stream[1].total_buf_num,
 			   dev->stream[2].total_buf_num,
 			   dev->stream[3].total_buf_num);
+		for (i = 0; i < 4; i++) {
+			char name[24];
+
+			if (!dev->stream[i].lat_hist.cnt)
+				continue;
+			snprintf(name, sizeof(name), "stream%d latency", i);
+			rk_lat_hist_show(f, name, &dev->stream[i].lat_hist);
+		}
+	}
+}
+
+static void rkcif_show_recover(struct rkcif_device *dev, struct seq_file *f)
+{
+	static const char * const tier_name[] = {
+		"recover resync", "recover csi", "recover full",
+	};
+	int i;
+
+	for (i = 0; i < RKCIF_RECOVER_TIER_MAX; i++) {
+		if (!dev->reset_work.recover_hist[i].cnt)
+			continue;
+		rk_lat_hist_show(f, tier_name[i], &dev->reset_work.recover_hist[i]);
 	}
 }
 
@@ -392,6 +419,7 @@ static int rkcif_proc_show(struct seq_file *f, void *v)
 		rkcif_show_mixed_info(dev, f);
 		rkcif_show_clks(dev, f);
 		rkcif_show_format(dev, f);
+		rkcif_show_recover(dev, f);
 	} else {
 		seq_puts(f, "dev null\n");
 	}
@@ -383,6 +383,9 @@ static long sditf_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 			rkcif_stream_suspend(cif_dev, RKCIF_RESUME_ISP);
 		}
 		break;
+	case RKISP_VICAP_CMD_SWITCH_MODE:
+		on = (int *)arg;
+		return rkcif_switch_work_mode(cif_dev, *on);
 	case RKISP_VICAP_CMD_SET_RESET:
 		if (priv->mode.rdbk_mode == RKISP_VICAP_ONLINE) {
 			cif_dev->is_toisp_reset = true;
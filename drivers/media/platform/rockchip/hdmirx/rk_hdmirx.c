@@ -68,6 +68,7 @@ MODULE_PARM_DESC(debug, "debug level (0-3)");
 #define INIT_FIFO_STATE			64
 #define RK_IRQ_HDMIRX_HDMI		210
 #define FILTER_FRAME_CNT		6
+#define HDMIRX_MAX_FRAME_DECIM		16
 #define CPU_LIMIT_FREQ_KHZ		1200000
 #define WAIT_PHY_REG_TIME		50
 #define WAIT_TIMER_LOCK_TIME		50
@@ -173,6 +174,8 @@ struct hdmirx_stream {
 	u32 frame_idx;
 	u32 line_flag_int_cnt;
 	u32 irq_stat;
+	u32 frame_decim;
+	u32 decim_cnt;
 };
 
 struct rk_hdmirx_dev {
@@ -1577,6 +1580,63 @@ static int hdmirx_enum_input(struct file *file, void *priv,
 	return 0;
 }
 
+static void hdmirx_get_timeperframe(struct hdmirx_stream *stream,
+				    struct v4l2_fract *tpf)
+{
+	struct rk_hdmirx_dev *hdmirx_dev = stream->hdmirx_dev;
+
+	if (hdmirx_dev->get_timing && hdmirx_dev->fps) {
+		tpf->numerator = stream->frame_decim;
+		tpf->denominator = hdmirx_dev->fps;
+	} else {
+		tpf->numerator = 0;
+		tpf->denominator = 0;
+	}
+}
+
+static int hdmirx_g_parm(struct file *file, void *priv,
+			 struct v4l2_streamparm *parm)
+{
+	struct hdmirx_stream *stream = video_drvdata(file);
+
+	if (parm->type != V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+		return -EINVAL;
+
+	parm->parm.capture.capability = V4L2_CAP_TIMEPERFRAME;
+	parm->parm.capture.readbuffers = 0;
+	hdmirx_get_timeperframe(stream, &parm->parm.capture.timeperframe);
+
+	return 0;
+}
+
+/*
+ * frame rate conversion on capture: only every frame_decim-th frame gets a
+ * new buffer programmed, the frames in between land in the buffer that is
+ * still being filled and are never handed to userspace, so 60 to 30 fps
+ * costs no buffer round trips and no copies.
+ */
+static int hdmirx_s_parm(struct file *file, void *priv,
+			 struct v4l2_streamparm *parm)
+{
+	struct hdmirx_stream *stream = video_drvdata(file);
+	struct rk_hdmirx_dev *hdmirx_dev = stream->hdmirx_dev;
+	struct v4l2_fract *tpf = &parm->parm.capture.timeperframe;
+	u32 decim = 1;
+
+	if (parm->type != V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+		return -EINVAL;
+
+	if (tpf->numerator && tpf->denominator && hdmirx_dev->fps)
+		decim = DIV_ROUND_CLOSEST(hdmirx_dev->fps * tpf->numerator,
+					  tpf->denominator);
+	decim = clamp_t(u32, decim, 1, HDMIRX_MAX_FRAME_DECIM);
+	WRITE_ONCE(stream->frame_decim, decim);
+	v4l2_dbg(1, debug, &hdmirx_dev->v4l2_dev, "%s: frame decim:%u\n",
+		 __func__, decim);
+
+	return hdmirx_g_parm(file, priv, parm);
+}
+
 static int fcc_xysubs(u32 fcc, u32 *xsubs, u32 *ysubs)
 {
 	/* Note: cbcr plane bpp is 16 bit */
@@ -2026,6 +2086,7 @@ static int hdmirx_start_streaming(struct vb2_queue *queue, unsigned int count)
 	sip_hdmirx_config(HDMIRX_AUTO_TOUCH_EN, 0, 1, 100);
 	stream->frame_idx = 0;
 	stream->line_flag_int_cnt = 0;
+	stream->decim_cnt = 0;
 	stream->curr_buf = NULL;
 	stream->next_buf = NULL;
 	stream->irq_stat = 0;
@@ -2235,6 +2296,8 @@ static const struct v4l2_ioctl_ops hdmirx_v4l2_ioctl_ops = {
 	.vidioc_query_dv_timings = hdmirx_query_dv_timings,
 	.vidioc_dv_timings_cap = hdmirx_dv_timings_cap,
 	.vidioc_enum_input = hdmirx_enum_input,
+	.vidioc_g_parm = hdmirx_g_parm,
+	.vidioc_s_parm = hdmirx_s_parm,
 	.vidioc_g_edid = hdmirx_get_edid,
 	.vidioc_s_edid = hdmirx_set_edid,
 
@@ -2290,6 +2353,7 @@ static int hdmirx_register_stream_vdev(struct hdmirx_stream *stream)
 	vdev->device_caps = V4L2_CAP_VIDEO_CAPTURE_MPLANE |
 			    V4L2_CAP_STREAMING;
 	video_set_drvdata(vdev, stream);
+	stream->frame_decim = 1;
 	vdev->vfl_dir = VFL_DIR_RX;
 
 	hdmirx_init_vb2_queue(&stream->buf_queue, stream,
@@ -2624,6 +2688,14 @@ static void line_flag_int_handler(struct rk_hdmirx_dev *hdmirx_dev, bool *handle
 
 	if ((bt->interlaced != V4L2_DV_INTERLACED) ||
 			(stream->line_flag_int_cnt % 2 == 0)) {
+		if (!stream->next_buf && stream->frame_decim > 1 &&
+		    ++stream->decim_cnt < stream->frame_decim) {
+			v4l2_dbg(3, debug, v4l2_dev, "%s: decim skip frame\n",
+				 __func__);
+			goto LINE_FLAG_OUT;
+		}
+		stream->decim_cnt = 0;
+
 		if (!stream->next_buf) {
 			spin_lock(&stream->vbq_lock);
 			if (!list_empty(&stream->buf_head)) {
@@ -3530,6 +3602,27 @@ static ssize_t audio_rate_show(struct device *dev,
 	return snprintf(buf, PAGE_SIZE, "%d", hdmirx_dev->audio_state.fs_audio);
 }
 
+/*
+ * source vs local audio clock: the audio work trims the local clock in
+ * 10ppm steps to hold the audio fifo level, so the total trim is the drift
+ * of the source. fifo is the fill offset from the initial level in words.
+ */
+static ssize_t audio_drift_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct rk_hdmirx_dev *hdmirx_dev = dev_get_drvdata(dev);
+	struct hdmirx_audiostate *as = &hdmirx_dev->audio_state;
+	u32 nominal = as->fs_audio * 128;
+	s64 ppb = 0;
+
+	if (nominal)
+		ppb = div_s64(((s64)as->hdmirx_aud_clkrate - nominal) *
+			      NSEC_PER_SEC, nominal);
+
+	return sysfs_emit(buf, "ppb:%lld fifo:%d\n", ppb,
+			  as->pre_state ? as->pre_state - as->init_state : 0);
+}
+
 static ssize_t audio_present_show(struct device *dev,
 				  struct device_attribute *attr, char *buf)
 {
@@ -3628,12 +3721,14 @@ static ssize_t status_store(struct device *dev,
 
 static DEVICE_ATTR_RO(audio_rate);
 static DEVICE_ATTR_RO(audio_present);
+static DEVICE_ATTR_RO(audio_drift);
 static DEVICE_ATTR_RW(edid);
 static DEVICE_ATTR_RW(status);
 
 static struct attribute *hdmirx_attrs[] = {
 	&dev_attr_audio_rate.attr,
 	&dev_attr_audio_present.attr,
+	&dev_attr_audio_drift.attr,
 	&dev_attr_edid.attr,
 	&dev_attr_status.attr,
 	NULL
@@ -9,10 +9,14 @@
 #include <media/v4l2-ioctl.h>
 #include <media/v4l2-subdev.h>
 #include <media/videobuf2-dma-contig.h>
+#include <drm/drm_fourcc.h>
 #include "dev.h"
 #include "regs.h"
 #include "rkisp_tb_helper.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/rkisp.h>
+
 #define STREAM_MIN_MP_SP_INPUT_WIDTH		STREAM_MIN_RSZ_OUTPUT_WIDTH
 #define STREAM_MIN_MP_SP_INPUT_HEIGHT		STREAM_MIN_RSZ_OUTPUT_HEIGHT
 
@@ -434,6 +438,7 @@ int rkisp_stream_frame_start(struct rkisp_device *dev, u32 isp_mis)
 	if (isp_mis)
 		rkisp_dvbm_event(dev, CIF_ISP_V_START);
 	rkisp_bridge_update_mi(dev, isp_mis);
+	rkisp_mode_switch_sof(dev);
 
 	if (dev->isp_ver == ISP_V39)
 		rkisp_sditf_sof(dev, isp_mis);
@@ -1044,7 +1049,6 @@ static int rkisp_set_cmsk(struct rkisp_stream *stream, struct rkisp_cmsk_cfg *cf
 	}
 
 	spin_lock_irqsave(&dev->cmsk_lock, lock_flags);
-	dev->is_cmsk_upd = true;
 	for (i = 0; i < RKISP_CMSK_WIN_MAX; i++) {
 		win_en |= cfg->win[i].win_en ? BIT(i) : 0;
 		mode |= cfg->win[i].mode ? BIT(i) : 0;
@@ -1102,6 +1106,7 @@ static int rkisp_set_cmsk(struct rkisp_stream *stream, struct rkisp_cmsk_cfg *cf
 		break;
 	}
 	dev->cmsk_cfg.mosaic_block = cfg->mosaic_block;
+	rkisp_cmsk_regs_update(dev);
 	spin_unlock_irqrestore(&dev->cmsk_lock, lock_flags);
 	return 0;
 
@@ -1179,6 +1184,346 @@ static int rkisp_set_wrap_line(struct rkisp_stream *stream, struct rkisp_wrap_in
 	return stream->ops->set_wrap(stream, arg->height);
 }
 
+static int rkisp_set_snapshot(struct rkisp_stream *stream, int *num)
+{
+	struct rkisp_device *dev = stream->ispdev;
+
+	if (!stream->ops->set_snapshot) {
+		v4l2_err(&dev->v4l2_dev, "no support snapshot\n");
+		return -EINVAL;
+	}
+	return stream->ops->set_snapshot(stream, *num);
+}
+
+static const struct {
+	u32 v4l2;
+	u32 drm;
+} rkisp_ds_fmts[] = {
+	{ V4L2_PIX_FMT_NV12, DRM_FORMAT_NV12 },
+	{ V4L2_PIX_FMT_NV21, DRM_FORMAT_NV21 },
+	{ V4L2_PIX_FMT_NV16, DRM_FORMAT_NV16 },
+	{ V4L2_PIX_FMT_NV61, DRM_FORMAT_NV61 },
+};
+
+static u32 rkisp_ds_drm_fmt(u32 pixelformat)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(rkisp_ds_fmts); i++)
+		if (rkisp_ds_fmts[i].v4l2 == pixelformat)
+			return rkisp_ds_fmts[i].drm;
+	return 0;
+}
+
+/* called by the sink once a frame is off screen or dropped */
+static void rkisp_stream_ds_release(void *data, void *priv)
+{
+	struct rkisp_stream *stream = data;
+	struct rkisp_buffer *buf = priv;
+	struct vb2_buffer *vb = &buf->vb.vb2_buf;
+
+	if (stream->ds_flush || !stream->streaming)
+		vb2_buffer_done(vb, VB2_BUF_STATE_ERROR);
+	else
+		vb->vb2_queue->ops->buf_queue(vb);
+}
+
+static struct dma_buf *rkisp_stream_ds_get_dmabuf(struct vb2_buffer *vb)
+{
+	const struct vb2_mem_ops *ops = vb->vb2_queue->mem_ops;
+
+	if (vb->memory == VB2_MEMORY_DMABUF) {
+		get_dma_buf(vb->planes[0].dbuf);
+		return vb->planes[0].dbuf;
+	}
+	if (!ops->get_dmabuf)
+		return NULL;
+	return ops->get_dmabuf(vb->planes[0].mem_priv, O_RDWR);
+}
+
+/* export in process context, then hand the frames to the sink */
+static void rkisp_stream_ds_work(struct work_struct *work)
+{
+	struct rkisp_stream *stream = container_of(work, struct rkisp_stream,
+						   ds_work);
+	struct rockchip_drm_direct_show_frame frame = {
+		.width = stream->out_fmt.width,
+		.height = stream->out_fmt.height,
+		.pitch = stream->out_fmt.plane_fmt[0].bytesperline,
+		.pixel_format = rkisp_ds_drm_fmt(stream->out_fmt.pixelformat),
+	};
+	struct rkisp_buffer *buf;
+	struct dma_buf **dmabuf;
+	unsigned long lock_flags = 0;
+
+	for (;;) {
+		spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+		buf = list_first_entry_or_null(&stream->ds_list,
+					       struct rkisp_buffer, queue);
+		if (buf)
+			list_del(&buf->queue);
+		spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+		if (!buf)
+			break;
+
+		dmabuf = &stream->ds_dmabuf[buf->vb.vb2_buf.index];
+		if (!*dmabuf) {
+			*dmabuf = rkisp_stream_ds_get_dmabuf(&buf->vb.vb2_buf);
+			if (IS_ERR(*dmabuf))
+				*dmabuf = NULL;
+		}
+		frame.dmabuf = *dmabuf;
+		frame.priv = buf;
+		/* no preview for this one, give it to userspace as usual */
+		if (!frame.dmabuf || !frame.pixel_format ||
+		    rockchip_drm_direct_show_sink_queue(stream->ds_sink, &frame))
+			vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
+	}
+}
+
+/* take every frame back from the preview, called first in stop_streaming */
+void rkisp_stream_ds_stop(struct rkisp_stream *stream)
+{
+	struct rkisp_buffer *buf;
+	unsigned long lock_flags = 0;
+	LIST_HEAD(local_list);
+	int i;
+
+	if (!stream->ds_sink)
+		return;
+
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	stream->ds_flush = true;
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+
+	cancel_work_sync(&stream->ds_work);
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	list_replace_init(&stream->ds_list, &local_list);
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+	while (!list_empty(&local_list)) {
+		buf = list_first_entry(&local_list, struct rkisp_buffer, queue);
+		list_del(&buf->queue);
+		vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_ERROR);
+	}
+
+	rockchip_drm_direct_show_sink_flush(stream->ds_sink);
+	for (i = 0; i < VIDEO_MAX_FRAME; i++) {
+		if (stream->ds_dmabuf[i]) {
+			dma_buf_put(stream->ds_dmabuf[i]);
+			stream->ds_dmabuf[i] = NULL;
+		}
+	}
+}
+
+static int rkisp_set_direct_show(struct rkisp_stream *stream,
+				 struct rkisp_direct_show *arg)
+{
+	struct rkisp_device *dev = stream->ispdev;
+	struct rockchip_drm_direct_show_sink_cfg cfg = {
+		.crtc_name = arg->crtc[0] ? arg->crtc : NULL,
+		.plane_name = arg->plane,
+		.dst_x = arg->dst_x,
+		.dst_y = arg->dst_y,
+		.dst_w = arg->dst_w,
+		.dst_h = arg->dst_h,
+		.top_zpos = !!arg->top_zpos,
+		.release = rkisp_stream_ds_release,
+		.data = stream,
+	};
+	struct rockchip_drm_direct_show_sink *sink = NULL;
+
+	if (stream->streaming)
+		return -EBUSY;
+
+	arg->crtc[sizeof(arg->crtc) - 1] = '\0';
+	arg->plane[sizeof(arg->plane) - 1] = '\0';
+	if (arg->plane[0]) {
+		if (!rkisp_ds_drm_fmt(stream->out_fmt.pixelformat)) {
+			v4l2_err(&dev->v4l2_dev,
+				 "no direct show for format %c%c%c%c\n",
+				 stream->out_fmt.pixelformat,
+				 stream->out_fmt.pixelformat >> 8,
+				 stream->out_fmt.pixelformat >> 16,
+				 stream->out_fmt.pixelformat >> 24);
+			return -EINVAL;
+		}
+		sink = rockchip_drm_direct_show_sink_create(&cfg);
+		if (IS_ERR(sink))
+			return PTR_ERR(sink);
+	}
+
+	rockchip_drm_direct_show_sink_destroy(stream->ds_sink);
+	stream->ds_sink = sink;
+	return 0;
+}
+
+/*
+ * Multi output for isp32: mpds and bpds have no resizer, they write the
+ * frame of their parent at a quarter of its width and height in the
+ * same format, so they only help when one size is a quarter of another.
+ */
+static const u32 rkisp_multi_paths[] = {
+	RKISP_STREAM_MP, RKISP_STREAM_SP, RKISP_STREAM_BP,
+	RKISP_STREAM_MPDS, RKISP_STREAM_BPDS,
+};
+
+struct rkisp_multi_sol {
+	u32 id[RKISP_MULTI_OUTPUT_MAX];
+	u32 width[RKISP_MULTI_OUTPUT_MAX];
+	u32 height[RKISP_MULTI_OUTPUT_MAX];
+	u64 bytes;
+	u32 rsz;
+	bool valid;
+};
+
+static bool rkisp_multi_path_ok(struct rkisp_device *dev, u32 id,
+				const struct rkisp_output_req *req)
+{
+	struct rkisp_stream *stream = &dev->cap_dev.stream[id];
+	const struct stream_config *cfg = stream->config;
+	struct v4l2_rect max_rsz;
+
+	if (!stream->linked || !find_fmt(stream, req->fourcc))
+		return false;
+	if (id == RKISP_STREAM_MPDS || id == RKISP_STREAM_BPDS)
+		return true;
+
+	restrict_rsz_resolution(stream, cfg, &max_rsz);
+	return req->width >= cfg->min_rsz_width &&
+	       req->height >= cfg->min_rsz_height &&
+	       req->width <= max_rsz.width &&
+	       req->height <= max_rsz.height;
+}
+
+/* check downscale paths against their parent and cost the assignment */
+static void rkisp_multi_eval(const struct rkisp_multi_output *cfg,
+			     struct rkisp_multi_sol *cur, bool adjust,
+			     struct rkisp_multi_sol *best)
+{
+	const struct rkisp_output_req *req = cfg->out;
+	u32 i, j, parent, w, h;
+
+	cur->bytes = 0;
+	cur->rsz = 0;
+	for (i = 0; i < cfg->num; i++) {
+		cur->width[i] = req[i].width;
+		cur->height[i] = req[i].height;
+		if (cur->id[i] != RKISP_STREAM_MPDS &&
+		    cur->id[i] != RKISP_STREAM_BPDS) {
+			cur->rsz++;
+			goto next;
+		}
+
+		parent = cur->id[i] == RKISP_STREAM_MPDS ?
+			 RKISP_STREAM_MP : RKISP_STREAM_BP;
+		for (j = 0; j < cfg->num; j++)
+			if (cur->id[j] == parent)
+				break;
+		if (j == cfg->num || req[j].fourcc != req[i].fourcc)
+			return;
+		w = req[j].width / 4;
+		h = req[j].height / 4;
+		if (w != req[i].width || h != req[i].height) {
+			if (!adjust || w < req[i].width || h < req[i].height)
+				return;
+			cur->width[i] = w;
+			cur->height[i] = h;
+		}
+next:
+		cur->bytes += (u64)cur->width[i] * cur->height[i];
+	}
+
+	if (!best->valid || cur->bytes < best->bytes ||
+	    (cur->bytes == best->bytes && cur->rsz < best->rsz)) {
+		*best = *cur;
+		best->valid = true;
+	}
+}
+
+static void rkisp_multi_search(struct rkisp_device *dev,
+			       const struct rkisp_multi_output *cfg,
+			       struct rkisp_multi_sol *cur, u32 n, u32 used,
+			       bool adjust, struct rkisp_multi_sol *best)
+{
+	u32 i, id;
+
+	if (n == cfg->num) {
+		rkisp_multi_eval(cfg, cur, adjust, best);
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(rkisp_multi_paths); i++) {
+		if (used & BIT(i))
+			continue;
+		id = rkisp_multi_paths[i];
+		if (!rkisp_multi_path_ok(dev, id, &cfg->out[n]))
+			continue;
+		cur->id[n] = id;
+		rkisp_multi_search(dev, cfg, cur, n + 1, used | BIT(i),
+				   adjust, best);
+	}
+}
+
+static int rkisp_set_multi_output(struct rkisp_stream *stream,
+				  struct rkisp_multi_output *cfg)
+{
+	struct rkisp_device *dev = stream->ispdev;
+	struct rkisp_multi_sol cur = { 0 }, best = { 0 };
+	struct v4l2_pix_format_mplane pixm;
+	struct rkisp_stream *t;
+	int i, pass, ret;
+
+	if (dev->isp_ver != ISP_V32)
+		return -EINVAL;
+	if (!cfg->num || cfg->num > RKISP_MULTI_OUTPUT_MAX)
+		return -EINVAL;
+
+	/* exact sizes first, then downscale paths a bit over the request */
+	for (pass = 0; pass < 2 && !best.valid; pass++)
+		rkisp_multi_search(dev, cfg, &cur, 0, 0, pass, &best);
+	if (!best.valid) {
+		v4l2_err(&dev->v4l2_dev, "no path mapping for %d outputs\n",
+			 cfg->num);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < cfg->num; i++) {
+		cfg->out[i].stream_id = best.id[i];
+		cfg->out[i].adjusted = best.width[i] != cfg->out[i].width ||
+				       best.height[i] != cfg->out[i].height;
+		cfg->out[i].width = best.width[i];
+		cfg->out[i].height = best.height[i];
+		if (dev->cap_dev.stream[best.id[i]].streaming && !cfg->try_only)
+			return -EBUSY;
+	}
+	if (cfg->try_only)
+		return 0;
+
+	/* resizer paths first, the downscale paths follow their format */
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < cfg->num; i++) {
+			bool ds = best.id[i] == RKISP_STREAM_MPDS ||
+				  best.id[i] == RKISP_STREAM_BPDS;
+
+			if (ds != !!pass)
+				continue;
+			t = &dev->cap_dev.stream[best.id[i]];
+			pixm = t->out_fmt;
+			pixm.pixelformat = cfg->out[i].fourcc;
+			pixm.width = cfg->out[i].width;
+			pixm.height = cfg->out[i].height;
+			ret = rkisp_set_fmt(t, &pixm, false);
+			if (ret < 0)
+				return ret;
+			v4l2_dbg(1, rkisp_debug, &dev->v4l2_dev,
+				 "multi output %d: %s %dx%d\n", i,
+				 t->vnode.vdev.name, pixm.width, pixm.height);
+		}
+	}
+
+	return 0;
+}
+
 static int rkisp_set_fps(struct rkisp_stream *stream, int *fps)
 {
 	struct rkisp_device *dev = stream->ispdev;
@@ -1322,6 +1667,15 @@ static long rkisp_ioctl_default(struct file *file, void *fh,
 	case RKISP_CMD_SET_IQTOOL_CONN_ID:
 		ret = rkisp_set_iqtool_connect_id(stream, *(int *)arg);
 		break;
+	case RKISP_CMD_SET_SNAPSHOT:
+		ret = rkisp_set_snapshot(stream, arg);
+		break;
+	case RKISP_CMD_SET_DIRECT_SHOW:
+		ret = rkisp_set_direct_show(stream, arg);
+		break;
+	case RKISP_CMD_SET_MULTI_OUTPUT:
+		ret = rkisp_set_multi_output(stream, arg);
+		break;
 	default:
 		ret = -EINVAL;
 	}
@@ -1631,11 +1985,67 @@ static void rkisp_buf_done_task(unsigned long arg)
 			v4l2_dbg(0, rkisp_debug, &stream->ispdev->v4l2_dev,
 				 "seq:%d data no update:%llx %llx\n",
 				 buf->vb.sequence, *data, *(data + 1));
+		if (stream->ds_sink && stream->streaming) {
+			bool ds = false;
+
+			spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+			if (!stream->ds_flush) {
+				list_add_tail(&buf->queue, &stream->ds_list);
+				ds = true;
+			}
+			spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+			if (ds) {
+				queue_work(system_highpri_wq, &stream->ds_work);
+				continue;
+			}
+		}
 		vb2_buffer_done(&buf->vb.vb2_buf,
 				stream->streaming ? VB2_BUF_STATE_DONE : VB2_BUF_STATE_ERROR);
 	}
 }
 
+/* buf may be NULL, e.g. for the wrap line mainpath */
+void rkisp_stream_frame_latency(struct rkisp_stream *stream,
+				struct rkisp_buffer *buf, u32 seq, u64 ns)
+{
+	struct rkisp_device *dev = stream->ispdev;
+	u64 sof_ns = dev->isp_sdev.frm_timestamp;
+	u32 i;
+
+	rk_lat_hist_add(&stream->lat_hist, ns - sof_ns);
+	for (i = 0; i < stream->out_fmt.num_planes; i++)
+		stream->mi_bytes += stream->out_fmt.plane_fmt[i].sizeimage;
+	trace_rkisp_frame_done(dev->name, stream->id, seq, sof_ns, ns);
+	if (trace_rkisp_frame_buf_enabled()) {
+		struct vb2_buffer *vb = buf ? &buf->vb.vb2_buf : NULL;
+		unsigned long ino = 0;
+
+		if (vb && vb->memory == VB2_MEMORY_DMABUF && vb->planes[0].dbuf)
+			ino = file_inode(vb->planes[0].dbuf->file)->i_ino;
+		trace_rkisp_frame_buf(stream->id, seq, sof_ns, ns, ino);
+	}
+}
+
+/* thermal step-down: spread the kept frames evenly, true to drop this one */
+bool rkisp_stream_cool_skip(struct rkisp_stream *stream)
+{
+	struct rkisp_device *dev = stream->ispdev;
+	u32 fps = 100;
+
+	if (dev->cool_steps)
+		fps = dev->cool_fps[READ_ONCE(dev->cool_state)];
+	if (fps >= 100) {
+		stream->cool_acc = 0;
+		return false;
+	}
+	stream->cool_acc += fps;
+	if (stream->cool_acc >= 100) {
+		stream->cool_acc -= 100;
+		return false;
+	}
+	return true;
+}
+
 void rkisp_stream_buf_done(struct rkisp_stream *stream,
 			   struct rkisp_buffer *buf)
 {
@@ -1684,6 +2094,8 @@ static void rkisp_stream_fast(struct work_struct *work)
 void rkisp_unregister_stream_vdev(struct rkisp_stream *stream)
 {
 	tasklet_kill(&stream->buf_done_tasklet);
+	rockchip_drm_direct_show_sink_destroy(stream->ds_sink);
+	stream->ds_sink = NULL;
 	media_entity_cleanup(&stream->vnode.vdev.entity);
 	video_unregister_device(&stream->vnode.vdev);
 }
@@ -1744,6 +2156,8 @@ int rkisp_register_stream_vdev(struct rkisp_stream *stream)
 	if (ret < 0)
 		goto unreg;
 	INIT_LIST_HEAD(&stream->buf_done_list);
+	INIT_LIST_HEAD(&stream->ds_list);
+	INIT_WORK(&stream->ds_work, rkisp_stream_ds_work);
 	tasklet_init(&stream->buf_done_tasklet,
 		     rkisp_buf_done_task,
 		     (unsigned long)stream);
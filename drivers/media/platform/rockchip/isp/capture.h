@@ -36,6 +36,8 @@
 #define _RKISP_PATH_VIDEO_H
 
 #include <linux/interrupt.h>
+#include <soc/rockchip/rockchip_direct_show.h>
+#include <soc/rockchip/rockchip_lat_hist.h>
 
 #include "common.h"
 #include "capture_v1x.h"
@@ -71,6 +73,7 @@ struct rkisp_stream;
 enum {
 	ROCKIT_DVBM_END,
 	ROCKIT_DVBM_START,
+	ROCKIT_SNAPSHOT_END,
 };
 
 enum {
@@ -242,6 +245,8 @@ struct streams_ops {
 	int (*frame_end)(struct rkisp_stream *stream, u32 state);
 	int (*frame_start)(struct rkisp_stream *stream, u32 mis);
 	int (*set_wrap)(struct rkisp_stream *stream, int line);
+	int (*set_snapshot)(struct rkisp_stream *stream, int num);
+	int (*skip_next)(struct rkisp_stream *stream);
 };
 
 struct rockit_isp_ops {
@@ -271,6 +276,14 @@ struct rockit_isp_ops {
  * @done: wait frame end event queue
  * @burst: burst length for Y and CB/CR
  * @sequence: damtx video frame sequence
+ * @is_snapshot: hold queued buffers, only capture armed frames
+ * @snapshot_cnt: armed snapshot frames
+ * @fps_skip: mi closed on purpose for the next frame, not a frame loss
+ * @ds_sink: local preview, done frames go to a vop plane and are requeued
+ *	     once off screen instead of returning to userspace
+ * @ds_dmabuf: dmabuf of each vb2 buffer handed to the sink
+ * @ds_list: done frames waiting for ds_work to export and queue them
+ * @ds_flush: stream stopping, frames from the sink are returned as error
  */
 struct rkisp_stream {
 	unsigned int id;
@@ -298,16 +311,31 @@ struct rkisp_stream {
 	bool is_mf_upd;
 	bool is_flip;
 	bool is_pause;
+	bool is_snapshot;
 	bool is_crop_upd;
 	bool is_using_resmem;
 	bool frame_early;
+	bool fps_skip;
 	wait_queue_head_t done;
 	unsigned int burst;
 	atomic_t sequence;
 	struct frame_debug_info dbg;
+	/* sof to frame dma done latency */
+	struct rk_lat_hist lat_hist;
+	/* mi bytes written */
+	u64 mi_bytes;
 	int conn_id;
 	u32 memory;
 	u32 skip_frame;
+	/* rk_frame_policy verdict of the frame in progress */
+	int policy_verdict;
+	u32 cool_acc;
+	u32 snapshot_cnt;
+	struct rockchip_drm_direct_show_sink *ds_sink;
+	struct dma_buf *ds_dmabuf[VIDEO_MAX_FRAME];
+	struct list_head ds_list;
+	struct work_struct ds_work;
+	bool ds_flush;
 	union {
 		struct rkisp_stream_sp sp;
 		struct rkisp_stream_mp mp;
@@ -323,6 +351,20 @@ struct rkisp_vir_cpy {
 	struct rkisp_stream *stream;
 };
 
+/* mainpath wrap (online to encoder) per-frame progress and latency */
+struct rkisp_wrap_stat {
+	u64 sof_ns;
+	u32 frame_id;
+	u32 slice_line;
+	u32 line_cnt;
+	/* latency of last frame and max since stream on, unit us */
+	u32 slice_delay;
+	u32 frame_delay;
+	u32 slice_delay_max;
+	u32 frame_delay_max;
+	u32 slice_miss;
+};
+
 struct rkisp_capture_device {
 	struct rkisp_device *ispdev;
 	struct rkisp_stream stream[RKISP_MAX_STREAM];
@@ -333,6 +375,7 @@ struct rkisp_capture_device {
 	u32 wait_line;
 	u32 wrap_width;
 	u32 wrap_line;
+	struct rkisp_wrap_stat wrap_stat;
 	bool is_done_early;
 	bool is_mirror;
 
@@ -346,6 +389,10 @@ extern struct rockit_isp_ops rockit_isp_ops;
 void rkisp_stream_buf_done_early(struct rkisp_device *dev);
 void rkisp_stream_buf_done(struct rkisp_stream *stream,
 			   struct rkisp_buffer *buf);
+void rkisp_stream_frame_latency(struct rkisp_stream *stream,
+				struct rkisp_buffer *buf, u32 seq, u64 ns);
+bool rkisp_stream_cool_skip(struct rkisp_stream *stream);
+void rkisp_stream_ds_stop(struct rkisp_stream *stream);
 void rkisp_unregister_stream_vdev(struct rkisp_stream *stream);
 int rkisp_register_stream_vdev(struct rkisp_stream *stream);
 void rkisp_unregister_stream_vdevs(struct rkisp_device *dev);
@@ -1567,6 +1567,7 @@ static int rkisp_start(struct rkisp_stream *stream)
 		return ret;
 
 	stream->ops->enable_mi(stream);
+	stream->ds_flush = false;
 	stream->streaming = true;
 
 	return 0;
@@ -1761,6 +1762,7 @@ static void rkisp_stop_streaming(struct vb2_queue *queue)
 	struct v4l2_device *v4l2_dev = &dev->v4l2_dev;
 	int ret;
 
+	rkisp_stream_ds_stop(stream);
 	mutex_lock(&dev->hw_dev->dev_lock);
 
 	v4l2_dbg(1, rkisp_debug, &dev->v4l2_dev,
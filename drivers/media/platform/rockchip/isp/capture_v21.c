@@ -1222,7 +1222,7 @@ static int mi_frame_end(struct rkisp_stream *stream, u32 state)
 		struct vb2_buffer *vb2_buf = &stream->curr_buf->vb.vb2_buf;
 		u64 ns = 0;
 
-		if (stream->skip_frame) {
+		if (stream->skip_frame || rkisp_stream_cool_skip(stream)) {
 			spin_lock_irqsave(&stream->vbq_lock, lock_flags);
 			list_add_tail(&stream->curr_buf->queue, &stream->buf_queue);
 			spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
@@ -1410,8 +1410,10 @@ static int rkisp_start(struct rkisp_stream *stream)
 	stream->ops->enable_mi(stream);
 	if (stream->id == RKISP_STREAM_MP || stream->id == RKISP_STREAM_SP)
 		hdr_config_dmatx(dev);
+	stream->ds_flush = false;
 	stream->streaming = true;
 	stream->skip_frame = 0;
+	stream->cool_acc = 0;
 	return 0;
 }
 
@@ -1579,6 +1581,7 @@ static void rkisp_stop_streaming(struct vb2_queue *queue)
 	struct v4l2_device *v4l2_dev = &dev->v4l2_dev;
 	int ret;
 
+	rkisp_stream_ds_stop(stream);
 	mutex_lock(&dev->hw_dev->dev_lock);
 
 	v4l2_dbg(1, rkisp_debug, &dev->v4l2_dev,
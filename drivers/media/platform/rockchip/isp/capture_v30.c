@@ -978,7 +978,7 @@ static int mi_frame_end(struct rkisp_stream *stream, u32 state)
 		struct vb2_buffer *vb2_buf = &buf->vb.vb2_buf;
 		u64 ns = 0;
 
-		if (stream->skip_frame) {
+		if (stream->skip_frame || rkisp_stream_cool_skip(stream)) {
 			spin_lock_irqsave(&stream->vbq_lock, lock_flags);
 			list_add_tail(&buf->queue, &stream->buf_queue);
 			spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
@@ -1106,8 +1106,10 @@ static int rkisp_start(struct rkisp_stream *stream)
 		return ret;
 
 	stream->ops->enable_mi(stream);
+	stream->ds_flush = false;
 	stream->streaming = true;
 	stream->skip_frame = 0;
+	stream->cool_acc = 0;
 	return 0;
 }
 
@@ -1259,6 +1261,7 @@ static void rkisp_stop_streaming(struct vb2_queue *queue)
 	struct v4l2_device *v4l2_dev = &dev->v4l2_dev;
 	int ret;
 
+	rkisp_stream_ds_stop(stream);
 	mutex_lock(&dev->hw_dev->dev_lock);
 
 	v4l2_dbg(1, rkisp_debug, v4l2_dev, "%s %s %d\n",
@@ -10,6 +10,7 @@
 #include <media/v4l2-subdev.h>
 #include <media/videobuf2-dma-contig.h>
 #include <media/videobuf2-dma-sg.h>
+#include <soc/rockchip/rockchip_frame_policy.h>
 #include "dev.h"
 #include "regs.h"
 
@@ -1258,6 +1259,88 @@ static void update_mi(struct rkisp_stream *stream)
 		 stream->is_pause, stream->ops->is_stream_stopped(stream));
 }
 
+/* in snapshot mode queued buffers wait for an armed frame */
+static bool stream_has_buf(struct rkisp_stream *stream)
+{
+	if (list_empty(&stream->buf_queue))
+		return false;
+	return !stream->is_snapshot || stream->snapshot_cnt;
+}
+
+static struct rkisp_buffer *stream_get_buf(struct rkisp_stream *stream)
+{
+	struct rkisp_buffer *buf;
+
+	if (!stream_has_buf(stream))
+		return NULL;
+	buf = list_first_entry(&stream->buf_queue, struct rkisp_buffer, queue);
+	list_del(&buf->queue);
+	if (stream->is_snapshot)
+		stream->snapshot_cnt--;
+	return buf;
+}
+
+/*
+ * selfpath snapshot: num > 0 arms num frames, 0 holds the queued buffers
+ * and num < 0 returns to continuous capture. A buffer already set up for
+ * the next frame goes back to the queue so only armed frames are written.
+ * Snapshot buffers from rockit are handed back with ROCKIT_SNAPSHOT_END
+ * and go to the jpeg encoder in kernel.
+ */
+static int sp_set_snapshot(struct rkisp_stream *stream, int num)
+{
+	unsigned long lock_flags = 0;
+
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	if (num >= 0 && !stream->is_snapshot) {
+		stream->is_snapshot = true;
+		if (stream->streaming && stream->next_buf) {
+			list_add(&stream->next_buf->queue, &stream->buf_queue);
+			stream->next_buf = NULL;
+			stream->ops->update_mi(stream);
+		}
+	} else if (num < 0) {
+		stream->is_snapshot = false;
+	}
+	stream->snapshot_cnt = num > 0 ? num : 0;
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+
+	v4l2_dbg(1, rkisp_debug, &stream->ispdev->v4l2_dev,
+		 "stream:%d snapshot:%d cnt:%d\n",
+		 stream->id, stream->is_snapshot, stream->snapshot_cnt);
+	return 0;
+}
+
+/*
+ * Drop the next frame before it is written: the buffer set up for it goes
+ * back to the queue and the mi closes at this frame end the same way it
+ * does without buffers. The following frame start picks a buffer again.
+ * Readback mode programs the buffer per frame, let the caller drop it.
+ */
+static int mi_skip_next(struct rkisp_stream *stream)
+{
+	struct rkisp_device *dev = stream->ispdev;
+	struct rkisp_dummy_buffer *dummy_buf = &stream->dummy_buf;
+	unsigned long lock_flags = 0;
+
+	if (dev->isp_ver == ISP_V32_L)
+		dummy_buf = &dev->hw_dev->dummy_buf;
+	/* the frame would go to the dummy or reserved buffer anyway */
+	if (!dev->hw_dev->is_single || dummy_buf->mem_priv ||
+	    stream->is_using_resmem)
+		return -EINVAL;
+
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	if (stream->streaming && stream->next_buf) {
+		list_add(&stream->next_buf->queue, &stream->buf_queue);
+		stream->next_buf = NULL;
+		stream->ops->update_mi(stream);
+	}
+	stream->fps_skip = true;
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+	return 0;
+}
+
 static int set_mirror_flip(struct rkisp_stream *stream)
 {
 	struct rkisp_device *dev = stream->ispdev;
@@ -1417,6 +1500,7 @@ static struct streams_ops rkisp_mp_streams_ops = {
 	.update_mi = update_mi,
 	.frame_end = mi_frame_end,
 	.frame_start = mi_frame_start,
+	.skip_next = mi_skip_next,
 	.set_wrap = mp_set_wrap,
 };
 
@@ -1429,6 +1513,8 @@ static struct streams_ops rkisp_sp_streams_ops = {
 	.update_mi = update_mi,
 	.frame_end = mi_frame_end,
 	.frame_start = mi_frame_start,
+	.skip_next = mi_skip_next,
+	.set_snapshot = sp_set_snapshot,
 };
 
 static struct streams_ops rkisp_bp_streams_ops = {
@@ -1439,6 +1525,7 @@ static struct streams_ops rkisp_bp_streams_ops = {
 	.update_mi = update_mi,
 	.frame_end = mi_frame_end,
 	.frame_start = mi_frame_start,
+	.skip_next = mi_skip_next,
 };
 
 static struct streams_ops rkisp_bpds_streams_ops = {
@@ -1449,6 +1536,7 @@ static struct streams_ops rkisp_bpds_streams_ops = {
 	.update_mi = update_mi,
 	.frame_end = mi_frame_end,
 	.frame_start = mi_frame_start,
+	.skip_next = mi_skip_next,
 };
 
 static struct streams_ops rkisp_mpds_streams_ops = {
@@ -1459,6 +1547,7 @@ static struct streams_ops rkisp_mpds_streams_ops = {
 	.update_mi = update_mi,
 	.frame_end = mi_frame_end,
 	.frame_start = mi_frame_start,
+	.skip_next = mi_skip_next,
 };
 
 static struct streams_ops rkisp_luma_streams_ops = {
@@ -1480,12 +1569,10 @@ static int mi_frame_start(struct rkisp_stream *stream, u32 mis)
 			rkisp_stream_config_rsz(stream, false);
 			stream->is_crop_upd = false;
 		}
-		if (!list_empty(&stream->buf_queue) &&
+		if (stream_has_buf(stream) &&
 		    ((dev->hw_dev->is_single && !stream->next_buf) ||
 		     (!dev->hw_dev->is_single && !stream->curr_buf))) {
-			stream->next_buf = list_first_entry(&stream->buf_queue,
-							struct rkisp_buffer, queue);
-			list_del(&stream->next_buf->queue);
+			stream->next_buf = stream_get_buf(stream);
 			stream->ops->update_mi(stream);
 		} else if (dev->hw_dev->is_single &&
 			   stream->next_buf && !stream->curr_buf) {
@@ -1497,18 +1584,16 @@ static int mi_frame_start(struct rkisp_stream *stream, u32 mis)
 			}
 			if (!stream->ops->is_stream_stopped(stream)) {
 				stream->curr_buf = stream->next_buf;
-				stream->next_buf = NULL;
-				if (!list_empty(&stream->buf_queue)) {
-					stream->next_buf = list_first_entry(&stream->buf_queue,
-									struct rkisp_buffer, queue);
-					list_del(&stream->next_buf->queue);
-				}
+				stream->next_buf = stream_get_buf(stream);
 				stream->ops->update_mi(stream);
 			}
 		}
-		/* check frame loss */
-		if (stream->ops->is_stream_stopped(stream))
+		/* check frame loss, mi closed by skip_next isn't one */
+		if (stream->ops->is_stream_stopped(stream) && !stream->fps_skip) {
 			stream->dbg.frameloss++;
+			dev->perf.drop_nobuf++;
+		}
+		stream->fps_skip = false;
 	}
 	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
 
@@ -1559,7 +1644,8 @@ static int mi_frame_end(struct rkisp_stream *stream, u32 state)
 		struct rkisp_stream *vir = &dev->cap_dev.stream[RKISP_STREAM_VIR];
 		u64 ns = 0;
 
-		if (dev->skip_frame || stream->skip_frame) {
+		if (dev->skip_frame || stream->skip_frame ||
+		    rkisp_stream_cool_skip(stream)) {
 			spin_lock_irqsave(&stream->vbq_lock, lock_flags);
 			list_add_tail(&buf->queue, &stream->buf_queue);
 			spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
@@ -1579,11 +1665,14 @@ static int mi_frame_end(struct rkisp_stream *stream, u32 state)
 			ns = rkisp_time_get_ns(dev);
 		buf->vb.sequence = i;
 		buf->vb.vb2_buf.timestamp = ns;
+		rk_frame_policy_tag(&buf->vb, stream->policy_verdict);
+		stream->policy_verdict = 0;
 		ns = rkisp_time_get_ns(dev);
 		stream->dbg.interval = ns - stream->dbg.timestamp;
 		stream->dbg.delay = ns - dev->isp_sdev.frm_timestamp;
 		stream->dbg.timestamp = ns;
 		stream->dbg.id = i;
+		rkisp_stream_frame_latency(stream, buf, i, ns);
 
 		if (vb2_buf->memory) {
 			if (vir->streaming && vir->conn_id == stream->id) {
@@ -1597,7 +1686,8 @@ static int mi_frame_end(struct rkisp_stream *stream, u32 state)
 				rkisp_stream_buf_done(stream, buf);
 			}
 		} else {
-			rkisp_rockit_buf_done(stream, ROCKIT_DVBM_END);
+			rkisp_rockit_buf_done(stream, stream->is_snapshot ?
+					      ROCKIT_SNAPSHOT_END : ROCKIT_DVBM_END);
 		}
 	}
 
@@ -1607,12 +1697,7 @@ static int mi_frame_end(struct rkisp_stream *stream, u32 state)
 	set_mirror_flip(stream);
 	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
 	stream->curr_buf = stream->next_buf;
-	stream->next_buf = NULL;
-	if (!list_empty(&stream->buf_queue)) {
-		stream->next_buf = list_first_entry(&stream->buf_queue,
-						    struct rkisp_buffer, queue);
-		list_del(&stream->next_buf->queue);
-	}
+	stream->next_buf = stream_get_buf(stream);
 	stream->ops->update_mi(stream);
 	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
 	return 0;
@@ -1702,8 +1787,10 @@ static int rkisp_start(struct rkisp_stream *stream)
 	if (stream->ops->enable_mi && !stream->is_pause)
 		stream->ops->enable_mi(stream);
 
+	stream->ds_flush = false;
 	stream->streaming = true;
 	stream->skip_frame = 0;
+	stream->cool_acc = 0;
 	return 0;
 }
 
@@ -1886,6 +1973,7 @@ static void rkisp_stop_streaming(struct vb2_queue *queue)
 	struct v4l2_device *v4l2_dev = &dev->v4l2_dev;
 	int ret;
 
+	rkisp_stream_ds_stop(stream);
 	mutex_lock(&dev->hw_dev->dev_lock);
 
 	v4l2_dbg(1, rkisp_debug, v4l2_dev, "%s %s %d\n",
@@ -2088,6 +2176,8 @@ rkisp_start_streaming(struct vb2_queue *queue, unsigned int count)
 		mutex_unlock(&dev->hw_dev->dev_lock);
 		return -EBUSY;
 	}
+	rk_lat_hist_reset(&stream->lat_hist);
+	stream->mi_bytes = 0;
 
 	if (stream->id == RKISP_STREAM_VIR) {
 		struct rkisp_stream *t = &dev->cap_dev.stream[stream->conn_id];
@@ -2112,6 +2202,7 @@ rkisp_start_streaming(struct vb2_queue *queue, unsigned int count)
 
 	if (stream->id == RKISP_STREAM_LUMA) {
 		tasklet_enable(&dev->cap_dev.rd_tasklet);
+		stream->ds_flush = false;
 		stream->streaming = true;
 		goto end;
 	}
@@ -2405,14 +2496,23 @@ void rkisp_unregister_stream_v32(struct rkisp_device *dev)
 void rkisp_mi_v32_isr(u32 mis_val, struct rkisp_device *dev)
 {
 	struct rkisp_stream *stream;
-	unsigned int i, seq;
+	unsigned int i, seq, ends = 0;
 	u64 ns = 0;
 
 	v4l2_dbg(3, rkisp_debug, &dev->v4l2_dev,
 		 "mi isr:0x%x\n", mis_val);
 
+	/* mi end of the last unite part, drained behind the next read back */
+	if (mis_val & ISP3X_MI_MP_FRAME)
+		ends |= ISP_FRAME_MP;
+	if (mis_val & ISP3X_MI_SP_FRAME)
+		ends |= ISP_FRAME_SP;
+	if (mis_val & ISP3X_MI_BP_FRAME)
+		ends |= ISP_FRAME_BP;
+
 	if ((dev->unite_div == ISP_UNITE_DIV2 && dev->unite_index != ISP_UNITE_RIGHT) ||
-	    (dev->unite_div == ISP_UNITE_DIV4 && dev->unite_index != ISP_UNITE_RIGHT_B)) {
+	    (dev->unite_div == ISP_UNITE_DIV4 && dev->unite_index != ISP_UNITE_RIGHT_B) ||
+	    (READ_ONCE(dev->irq_ends_prev) & ends)) {
 		rkisp_write(dev, ISP3X_MI_ICR, mis_val, true);
 		goto end;
 	}
@@ -2455,6 +2555,7 @@ void rkisp_mi_v32_isr(u32 mis_val, struct rkisp_device *dev)
 			stream->dbg.delay = ns - dev->isp_sdev.frm_timestamp;
 			stream->dbg.timestamp = ns;
 			stream->dbg.id = seq;
+			rkisp_stream_frame_latency(stream, NULL, seq, ns);
 		} else {
 			mi_frame_end(stream, FRAME_IRQ);
 		}
@@ -1027,7 +1027,8 @@ static int mi_frame_end(struct rkisp_stream *stream, u32 state)
 		struct rkisp_stream *vir = &dev->cap_dev.stream[RKISP_STREAM_VIR];
 		u64 ns = 0;
 
-		if (dev->skip_frame || stream->skip_frame) {
+		if (dev->skip_frame || stream->skip_frame ||
+		    rkisp_stream_cool_skip(stream)) {
 			spin_lock_irqsave(&stream->vbq_lock, lock_flags);
 			list_add_tail(&buf->queue, &stream->buf_queue);
 			spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
@@ -1160,8 +1161,10 @@ static int rkisp_start(struct rkisp_stream *stream)
 	if (stream->ops->enable_mi && !stream->is_pause)
 		stream->ops->enable_mi(stream);
 
+	stream->ds_flush = false;
 	stream->streaming = true;
 	stream->skip_frame = 0;
+	stream->cool_acc = 0;
 	return 0;
 }
 
@@ -1299,6 +1302,7 @@ static void rkisp_stop_streaming(struct vb2_queue *queue)
 	struct v4l2_device *v4l2_dev = &dev->v4l2_dev;
 	int ret;
 
+	rkisp_stream_ds_stop(stream);
 	mutex_lock(&dev->hw_dev->dev_lock);
 
 	v4l2_dbg(1, rkisp_debug, v4l2_dev, "%s %s %d\n",
@@ -5,6 +5,7 @@
 #include <media/videobuf2-dma-sg.h>
 #include <linux/of_platform.h>
 #include <linux/slab.h>
+#include <linux/soc/rockchip/rockchip_frame_pool.h>
 #include "dev.h"
 #include "hw.h"
 #include "isp_ispp.h"
@@ -177,15 +178,19 @@ void rkisp_update_regs(struct rkisp_device *dev, u32 start, u32 end)
 {
 	struct rkisp_hw_dev *hw = dev->hw_dev;
 	void __iomem *base = hw->base_addr;
+	void *sw_base = dev->sw_base_addr;
 	u32 i;
 
 	if (end > RKISP_ISP_SW_REG_SIZE - 4) {
 		dev_err(dev->dev, "%s out of range\n", __func__);
 		return;
 	}
+	/* register copy of the unite part to run, once for the whole range */
+	if (hw->unite == ISP_UNITE_ONE && dev->unite_index > ISP_UNITE_LEFT)
+		sw_base += RKISP_ISP_SW_MAX_SIZE * dev->unite_index;
 	for (i = start; i <= end; i += 4) {
-		u32 *val = dev->sw_base_addr + i;
-		u32 *flag = dev->sw_base_addr + i + RKISP_ISP_SW_REG_SIZE;
+		u32 *val = sw_base + i;
+		u32 *flag = sw_base + i + RKISP_ISP_SW_REG_SIZE;
 
 		if (dev->procfs.mode & RKISP_PROCFS_FIL_SW) {
 			if (!((i >= ISP3X_ISP_ACQ_H_OFFS && i <= ISP3X_ISP_ACQ_V_SIZE) ||
@@ -196,11 +201,6 @@ void rkisp_update_regs(struct rkisp_device *dev, u32 start, u32 end)
 				continue;
 		}
 
-		if (hw->unite == ISP_UNITE_ONE && dev->unite_index > ISP_UNITE_LEFT) {
-			val += (RKISP_ISP_SW_MAX_SIZE * dev->unite_index / 4);
-			flag += (RKISP_ISP_SW_MAX_SIZE * dev->unite_index / 4);
-		}
-
 		if (*flag == SW_REG_CACHE) {
 			if ((i == ISP3X_MAIN_RESIZE_CTRL ||
 			     i == ISP32_BP_RESIZE_CTRL ||
@@ -310,6 +310,61 @@ int rkisp_alloc_buffer(struct rkisp_device *dev,
 	return ret;
 }
 
+/*
+ * Scratch buffer attached from the shared frame pool, for dma write sink
+ * only: vicap writes to the same memory.
+ */
+int rkisp_alloc_pool_buffer(struct rkisp_device *dev,
+			    struct rkisp_dummy_buffer *buf)
+{
+	const struct vb2_mem_ops *g_ops = dev->hw_dev->mem_ops;
+	struct sg_table *sg_tbl;
+	struct dma_buf *dbuf;
+	void *mem_priv;
+	int ret;
+
+	if (!buf->size)
+		return -EINVAL;
+
+	mutex_lock(&dev->buf_lock);
+	buf->size = PAGE_ALIGN(buf->size);
+	dbuf = rk_frame_pool_get_scratch(buf->size);
+	if (IS_ERR(dbuf)) {
+		ret = PTR_ERR(dbuf);
+		goto unlock;
+	}
+	mem_priv = g_ops->attach_dmabuf(dev->hw_dev->dev, dbuf,
+					buf->size, DMA_BIDIRECTIONAL);
+	if (IS_ERR(mem_priv)) {
+		ret = PTR_ERR(mem_priv);
+		goto put;
+	}
+	ret = g_ops->map_dmabuf(mem_priv);
+	if (ret) {
+		g_ops->detach_dmabuf(mem_priv);
+		goto put;
+	}
+	if (dev->hw_dev->is_dma_sg_ops) {
+		sg_tbl = (struct sg_table *)g_ops->cookie(mem_priv);
+		buf->dma_addr = sg_dma_address(sg_tbl->sgl);
+	} else {
+		buf->dma_addr = *((dma_addr_t *)g_ops->cookie(mem_priv));
+	}
+	buf->mem_priv = mem_priv;
+	buf->dbuf = dbuf;
+	buf->is_pool = true;
+	v4l2_dbg(1, rkisp_debug, &dev->v4l2_dev,
+		 "%s buf:0x%x~0x%x size:%d\n", __func__,
+		 (u32)buf->dma_addr, (u32)buf->dma_addr + buf->size, buf->size);
+	mutex_unlock(&dev->buf_lock);
+	return 0;
+put:
+	rk_frame_pool_put_scratch(dbuf);
+unlock:
+	mutex_unlock(&dev->buf_lock);
+	return ret;
+}
+
 void rkisp_free_buffer(struct rkisp_device *dev,
 			struct rkisp_dummy_buffer *buf)
 {
@@ -320,9 +375,16 @@ void rkisp_free_buffer(struct rkisp_device *dev,
 		v4l2_dbg(1, rkisp_debug, &dev->v4l2_dev,
 			 "%s buf:0x%x~0x%x\n", __func__,
 			 (u32)buf->dma_addr, (u32)buf->dma_addr + buf->size);
-		if (buf->dbuf)
-			dma_buf_put(buf->dbuf);
-		g_ops->put(buf->mem_priv);
+		if (buf->is_pool) {
+			g_ops->unmap_dmabuf(buf->mem_priv);
+			g_ops->detach_dmabuf(buf->mem_priv);
+			rk_frame_pool_put_scratch(buf->dbuf);
+			buf->is_pool = false;
+		} else {
+			if (buf->dbuf)
+				dma_buf_put(buf->dbuf);
+			g_ops->put(buf->mem_priv);
+		}
 		buf->size = 0;
 		buf->dbuf = NULL;
 		buf->vaddr = NULL;
@@ -491,7 +553,9 @@ int rkisp_alloc_common_dummy_buf(struct rkisp_device *dev)
 	}
 
 	dummy_buf->size = size;
-	ret = rkisp_alloc_buffer(dev, dummy_buf);
+	ret = rkisp_alloc_pool_buffer(dev, dummy_buf);
+	if (ret)
+		ret = rkisp_alloc_buffer(dev, dummy_buf);
 	if (!ret)
 		v4l2_dbg(1, rkisp_debug, &dev->v4l2_dev,
 			 "%s buf:0x%x size:%d\n", __func__,
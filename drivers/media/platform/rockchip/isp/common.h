@@ -134,6 +134,7 @@ struct rkisp_dummy_buffer {
 	bool is_need_vaddr;
 	bool is_need_dbuf;
 	bool is_need_dmafd;
+	bool is_pool;
 };
 
 extern int rkisp_debug;
@@ -141,6 +142,15 @@ extern bool rkisp_monitor;
 extern bool rkisp_irq_dbg;
 extern bool rkisp_buf_dbg;
 extern u64 rkisp_debug_reg;
+extern unsigned int rkisp_wrap_slice_line;
+extern unsigned int rkisp_rdbk_sched;
+extern unsigned int rkisp_rdbk_prio[];
+extern unsigned int rkisp_rdbk_fps[];
+extern unsigned int rkisp_stats_ring;
+extern bool rkisp_unite_overlap;
+extern bool rkisp_rdbk_once;
+extern bool rkisp_mesh_keep;
+extern unsigned int rkisp_bay3d_bwsaving;
 extern struct platform_driver rkisp_plat_drv;
 
 static inline
@@ -192,6 +202,7 @@ void rkisp_update_regs(struct rkisp_device *dev, u32 start, u32 end);
 int rkisp_buf_get_fd(struct rkisp_device *dev, struct rkisp_dummy_buffer *buf, bool try_fd);
 int rkisp_alloc_buffer(struct rkisp_device *dev, struct rkisp_dummy_buffer *buf);
 void rkisp_free_buffer(struct rkisp_device *dev, struct rkisp_dummy_buffer *buf);
+int rkisp_alloc_pool_buffer(struct rkisp_device *dev, struct rkisp_dummy_buffer *buf);
 void rkisp_prepare_buffer(struct rkisp_device *dev, struct rkisp_dummy_buffer *buf);
 void rkisp_finish_buffer(struct rkisp_device *dev, struct rkisp_dummy_buffer *buf);
 
@@ -27,6 +27,7 @@ enum {
 	T_CMD_DEQUEUE,
 	T_CMD_LEN,
 	T_CMD_END,
+	T_CMD_PEEK,
 };
 
 enum hdr_op_mode {
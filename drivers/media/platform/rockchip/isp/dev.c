@@ -45,6 +45,8 @@
 #include <linux/pm_runtime.h>
 #include <linux/pinctrl/consumer.h>
 #include <linux/regmap.h>
+#include <linux/thermal.h>
+#include <media/v4l2-event.h>
 #include <dt-bindings/soc/rockchip-system-status.h>
 #include <soc/rockchip/rockchip-system-status.h>
 #include "common.h"
@@ -96,6 +98,47 @@ static unsigned int rkisp_wrap_line;
 module_param_named(wrap_line, rkisp_wrap_line, uint, 0644);
 MODULE_PARM_DESC(wrap_line, "rkisp wrap line for mpp");
 
+unsigned int rkisp_wrap_slice_line;
+module_param_named(wrap_slice_line, rkisp_wrap_slice_line, uint, 0644);
+MODULE_PARM_DESC(wrap_slice_line, "rkisp wrap lines written before notify mpp to start");
+
+unsigned int rkisp_rdbk_sched;
+module_param_named(rdbk_sched, rkisp_rdbk_sched, uint, 0644);
+MODULE_PARM_DESC(rdbk_sched, "multi dev read back schedule, 0:longest fifo 1:priority and deadline");
+
+unsigned int rkisp_rdbk_prio[DEV_MAX];
+module_param_array_named(rdbk_prio, rkisp_rdbk_prio, uint, NULL, 0644);
+MODULE_PARM_DESC(rdbk_prio, "read back priority of each virtual isp, bigger is higher");
+
+unsigned int rkisp_rdbk_fps[DEV_MAX];
+module_param_array_named(rdbk_fps, rkisp_rdbk_fps, uint, NULL, 0644);
+MODULE_PARM_DESC(rdbk_fps, "read back target fps of each virtual isp for deadline");
+
+unsigned int rkisp_stats_ring;
+module_param_named(stats_ring, rkisp_stats_ring, uint, 0644);
+MODULE_PARM_DESC(stats_ring, "isp32 3a stats ring slot num, 0:disable, 3~8:enable");
+
+bool rkisp_unite_overlap;
+module_param_named(unite_overlap, rkisp_unite_overlap, bool, 0644);
+MODULE_PARM_DESC(unite_overlap, "unite one mode start next part read back while last part mi write drains");
+
+bool rkisp_rdbk_once;
+module_param_named(rdbk_once, rkisp_rdbk_once, bool, 0644);
+MODULE_PARM_DESC(rdbk_once, "multi sensor read back each raw frame from ddr only once, not for unite mode");
+
+bool rkisp_mesh_keep;
+module_param_named(mesh_keep, rkisp_mesh_keep, bool, 0644);
+MODULE_PARM_DESC(mesh_keep, "isp32 keep ldch/cac mesh buffers and their tables across stream restarts");
+
+unsigned int rkisp_bay3d_bwsaving;
+module_param_named(bay3d_bwsaving, rkisp_bay3d_bwsaving, uint, 0644);
+MODULE_PARM_DESC(bay3d_bwsaving, "isp32 bay3d reduced precision reference, 0:as configured 1:always 2:when it fits the row buffer in sram");
+
+/* ddr traffic per input pixel in 1/10 byte: raw in, bay3d iir and outputs */
+static unsigned int rkisp_bw_factor = 60;
+module_param_named(bw_factor, rkisp_bw_factor, uint, 0644);
+MODULE_PARM_DESC(bw_factor, "ddr bytes per input pixel x10 declared to dmc, 0:disable");
+
 static DEFINE_MUTEX(rkisp_dev_mutex);
 static LIST_HEAD(rkisp_device_list);
 
@@ -321,6 +364,137 @@ static int rkisp_pipeline_close(struct rkisp_pipeline *p)
 	return 0;
 }
 
+static u32 rkisp_hdr_exposures(struct rkisp_device *dev)
+{
+	switch (dev->hdr.op_mode) {
+	case HDR_RDBK_FRAME2:
+	case HDR_FRAMEX2_DDR:
+	case HDR_LINEX2_DDR:
+	case HDR_LINEX2_NO_DDR:
+		return 2;
+	case HDR_RDBK_FRAME3:
+	case HDR_FRAMEX3_DDR:
+	case HDR_LINEX3_DDR:
+		return 3;
+	default:
+		return 1;
+	}
+}
+
+/* declare the stream to the dmc and the system monitor */
+static void rkisp_update_load(struct rkisp_device *dev, bool on)
+{
+	struct rkisp_sensor_info *sensor = dev->active_sensor;
+	struct v4l2_subdev_frame_interval fi;
+	u32 w = dev->isp_sdev.in_crop.width;
+	u32 h = dev->isp_sdev.in_crop.height;
+	u64 mbyte = 0;
+
+	if (on) {
+		fi.interval.numerator = 1;
+		fi.interval.denominator = 30;
+		if (sensor)
+			v4l2_subdev_call(sensor->sd, video, g_frame_interval, &fi);
+		if (!fi.interval.numerator || !fi.interval.denominator) {
+			fi.interval.numerator = 1;
+			fi.interval.denominator = 30;
+		}
+		mbyte = (u64)w * h * rkisp_bw_factor * fi.interval.denominator;
+		mbyte = div_u64(mbyte, fi.interval.numerator * 10 * 1000000);
+
+		dev->video_load.type = ROCKCHIP_VIDEO_LOAD_ISP;
+		dev->video_load.width = w;
+		dev->video_load.height = h;
+		dev->video_load.fps = DIV_ROUND_CLOSEST(fi.interval.denominator,
+							fi.interval.numerator);
+		dev->video_load.hdr = rkisp_hdr_exposures(dev);
+	}
+	rockchip_dmcfreq_bw_request_update(&dev->bw_req, mbyte);
+	rockchip_system_monitor_video_load_update(&dev->video_load, on);
+}
+
+/*
+ * thermal cooling: each state keeps cool_fps[state] percent of the frames
+ * on the capture nodes, and the params node reports the state so that the
+ * 3a or app can lower the sensor fps or output size in step.
+ */
+static const u32 rkisp_cool_fps_def[] = { 100, 75, 50, 25 };
+
+static int rkisp_cool_get_max_state(struct thermal_cooling_device *cdev,
+				    unsigned long *state)
+{
+	struct rkisp_device *dev = cdev->devdata;
+
+	*state = dev->cool_steps - 1;
+	return 0;
+}
+
+static int rkisp_cool_get_cur_state(struct thermal_cooling_device *cdev,
+				    unsigned long *state)
+{
+	struct rkisp_device *dev = cdev->devdata;
+
+	*state = READ_ONCE(dev->cool_state);
+	return 0;
+}
+
+static int rkisp_cool_set_cur_state(struct thermal_cooling_device *cdev,
+				    unsigned long state)
+{
+	struct rkisp_device *dev = cdev->devdata;
+	struct v4l2_event ev = {
+		.type = CIFISP_V4L2_EVENT_COOLING,
+	};
+	struct cifisp_cooling_event *cool = (void *)ev.u.data;
+
+	if (state >= dev->cool_steps)
+		return -EINVAL;
+	if (state == dev->cool_state)
+		return 0;
+
+	WRITE_ONCE(dev->cool_state, state);
+	cool->state = state;
+	cool->max_state = dev->cool_steps - 1;
+	cool->fps_percent = dev->cool_fps[state];
+	v4l2_event_queue(&dev->params_vdev.vnode.vdev, &ev);
+	v4l2_dbg(1, rkisp_debug, &dev->v4l2_dev,
+		 "cooling state %lu fps %u%%\n", state, dev->cool_fps[state]);
+	return 0;
+}
+
+static const struct thermal_cooling_device_ops rkisp_cooling_ops = {
+	.get_max_state = rkisp_cool_get_max_state,
+	.get_cur_state = rkisp_cool_get_cur_state,
+	.set_cur_state = rkisp_cool_set_cur_state,
+};
+
+static void rkisp_cooling_register(struct rkisp_device *dev)
+{
+	struct device_node *np = dev->dev->of_node;
+	int i, num;
+
+	num = of_property_count_u32_elems(np, "rockchip,cooling-fps-steps");
+	if (num > 0) {
+		num = min(num, RKISP_COOL_STEPS_MAX);
+		of_property_read_u32_array(np, "rockchip,cooling-fps-steps",
+					   dev->cool_fps, num);
+	} else {
+		num = ARRAY_SIZE(rkisp_cool_fps_def);
+		memcpy(dev->cool_fps, rkisp_cool_fps_def, sizeof(rkisp_cool_fps_def));
+	}
+	for (i = 0; i < num; i++)
+		dev->cool_fps[i] = clamp_t(u32, dev->cool_fps[i], 1, 100);
+	dev->cool_steps = num;
+	dev->cool_state = 0;
+
+	dev->cdev = thermal_of_cooling_device_register(np, dev->name, dev,
+						       &rkisp_cooling_ops);
+	if (IS_ERR(dev->cdev)) {
+		dev_warn(dev->dev, "failed to register cooling device\n");
+		dev->cdev = NULL;
+	}
+}
+
 /*
  * stream-on order: isp_subdev, mipi dphy, sensor
  * stream-off order: mipi dphy, sensor, isp_subdev
@@ -338,6 +512,7 @@ static int rkisp_pipeline_set_stream(struct rkisp_pipeline *p, bool on)
 		if (dev->vs_irq >= 0)
 			enable_irq(dev->vs_irq);
 		rockchip_set_system_status(SYS_STATUS_ISP);
+		rkisp_update_load(dev, true);
 		ret = v4l2_subdev_call(&dev->isp_sdev.sd, video, s_stream, true);
 		if (ret < 0)
 			goto err;
@@ -371,6 +546,7 @@ static int rkisp_pipeline_set_stream(struct rkisp_pipeline *p, bool on)
 		if (dev->vs_irq >= 0)
 			disable_irq(dev->vs_irq);
 		v4l2_subdev_call(&dev->isp_sdev.sd, video, s_stream, false);
+		rkisp_update_load(dev, false);
 		rockchip_clear_system_status(SYS_STATUS_ISP);
 	}
 
@@ -381,6 +557,7 @@ static int rkisp_pipeline_set_stream(struct rkisp_pipeline *p, bool on)
 		v4l2_subdev_call(p->subdevs[i], video, s_stream, false);
 	v4l2_subdev_call(&dev->isp_sdev.sd, video, s_stream, false);
 err:
+	rkisp_update_load(dev, false);
 	rockchip_clear_system_status(SYS_STATUS_ISP);
 	atomic_dec_return(&p->stream_cnt);
 	return ret;
@@ -956,6 +1133,8 @@ static int rkisp_plat_probe(struct platform_device *pdev)
 	of_property_read_u32(dev->of_node, "wait-line", &rkisp_wait_line);
 
 	rkisp_proc_init(isp_dev);
+	rockchip_dmcfreq_bw_request_add(&isp_dev->bw_req, isp_dev->name);
+	rkisp_cooling_register(isp_dev);
 
 	mutex_lock(&rkisp_dev_mutex);
 	list_add_tail(&isp_dev->list, &rkisp_device_list);
@@ -979,6 +1158,9 @@ static int rkisp_plat_remove(struct platform_device *pdev)
 
 	pm_runtime_disable(&pdev->dev);
 
+	if (isp_dev->cdev)
+		thermal_cooling_device_unregister(isp_dev->cdev);
+	rockchip_dmcfreq_bw_request_remove(&isp_dev->bw_req);
 	rkisp_proc_cleanup(isp_dev);
 	media_device_unregister(&isp_dev->media_dev);
 	v4l2_async_notifier_unregister(&isp_dev->notifier);
@@ -35,6 +35,10 @@
 #ifndef _RKISP_DEV_H
 #define _RKISP_DEV_H
 
+#include <linux/kthread.h>
+#include <soc/rockchip/rockchip_dmc.h>
+#include <soc/rockchip/rockchip_exp_queue.h>
+#include <soc/rockchip/rockchip_system_monitor.h>
 #include "capture.h"
 #include "csi.h"
 #include "dmarx.h"
@@ -70,6 +74,8 @@
 
 #define RKISP_CONTI_ERR_MAX		50
 
+#define RKISP_COOL_STEPS_MAX		8
+
 enum rkisp_isp_state {
 	ISP_FRAME_END = BIT(0),
 	ISP_FRAME_IN = BIT(1),
@@ -195,6 +201,89 @@ struct rkisp_hdr {
 	struct rkisp_dummy_buffer dummy_buf[HDR_DMA_MAX][HDR_MAX_DUMMY_BUF];
 };
 
+/*
+ * struct rkisp_rdbk_stat - multi dev read back statistics
+ * @fps_ts: start of current fps window
+ * @fps_cnt: frames read back in current window
+ * @fps: achieved read back fps of last window
+ * @cnt: frames read back
+ * @overrun: frames read back later than one period of rdbk_fps
+ * @delay_hist: sof to read back start delay
+ */
+struct rkisp_rdbk_stat {
+	u64 fps_ts;
+	u32 fps_cnt;
+	u32 fps;
+	u32 cnt;
+	u32 overrun;
+	struct rk_lat_hist delay_hist;
+	/* ddr bytes read back per exposure, by rawrd0~2 */
+	u64 rd_bytes[HDR_DMA_MAX];
+	/* second reads of a frame skipped for rdbk_once */
+	u32 rd_saved;
+};
+
+/*
+ * struct rkisp_cmsk_regs - cmsk registers to write, per unite part
+ * entry 0~6 ctrl0~6, 7 pic size, then yuv, offs and size of each window.
+ * @mask: entries in use
+ */
+#define RKISP_CMSK_REG_PIC_SIZE	7
+#define RKISP_CMSK_REG_YUV	8
+#define RKISP_CMSK_REG_NUM	(RKISP_CMSK_REG_YUV + RKISP_CMSK_WIN_MAX * 3)
+
+struct rkisp_cmsk_regs {
+	u32 val[ISP_UNITE_DIV2][RKISP_CMSK_REG_NUM];
+	u64 mask[ISP_UNITE_DIV2];
+};
+
+/*
+ * struct rkisp_unite_stat - timing of the parts of a unite one mode frame
+ * @part_ts: read back start of the running part
+ * @end_ts: isp frame end of the part whose mi write still drains
+ * @overlap: parts started while the last part mi write drained
+ * @part_hist: read back start to isp frame end, per part
+ * @drain_hist: isp frame end to last mi frame end of overlapped parts
+ */
+struct rkisp_unite_stat {
+	u64 part_ts;
+	u64 end_ts;
+	u32 overlap;
+	struct rk_lat_hist part_hist[ISP_UNITE_MAX];
+	struct rk_lat_hist drain_hist;
+};
+
+/*
+ * struct rkisp_perf_stat - isr cost and frame drops, cheap enough to stay on
+ * updated from the isp irq only, the procfs reads them with no lock
+ * @isp_isr_hist: time in rkisp_isp_isr()
+ * @mi_isr_hist: time in the mi isr
+ * @params_hist: time to apply the params of a frame
+ * @drop_nobuf: output frames lost with no buffer queued
+ * @drop_overflow: input frames hit by isp data loss or size error
+ * @drop_rdbk_late: input frames skipped as the read back came late
+ */
+struct rkisp_perf_stat {
+	struct rk_lat_hist isp_isr_hist;
+	struct rk_lat_hist mi_isr_hist;
+	struct rk_lat_hist params_hist;
+	u32 drop_nobuf;
+	u32 drop_overflow;
+	u32 drop_rdbk_late;
+};
+
+/*
+ * struct rkisp_mode_sw - staged mode switch
+ * @cfg: the switch as staged, its state and switch point
+ * @work: writes the sensor controls and the ir-cut
+ * @lock: cfg between the ioctl, the sof and the work
+ */
+struct rkisp_mode_sw {
+	struct rkisp_mode_switch cfg;
+	struct work_struct work;
+	spinlock_t lock;
+};
+
 /*
  * struct rkisp_device - ISP platform device
  * @base_addr: base register address
@@ -206,6 +295,11 @@ struct rkisp_hdr {
  * @dmarx_dev: image input device
  * @csi_dev: mipi csi device
  * @br_dev: bridge of isp and ispp device
+ * @bw_req: ddr bandwidth declared to the dmc while streaming
+ * @video_load: stream declared to the system monitor for opp floors
+ * @cdev: thermal cooling device stepping the capture frame rate down
+ * @cool_fps: percent of frames kept for each cooling state
+ * @exp_queue: sensor exposures written at the sof of their frame
  */
 struct rkisp_device {
 	struct list_head list;
@@ -266,14 +360,24 @@ struct rkisp_device {
 	unsigned int skip_frame;
 	unsigned int irq_ends;
 	unsigned int irq_ends_mask;
+	/* mi ends still owed by the last unite part */
+	unsigned int irq_ends_prev;
 	bool send_fbcgain;
 	struct rkisp_ispp_buf *cur_fbcgain;
 	struct rkisp_buffer *cur_spbuf;
 
 	struct completion pm_cmpl;
 
-	struct work_struct rdbk_work;
+	struct kthread_work rdbk_work;
+	struct kthread_worker *rdbk_worker;
 	struct kfifo rdbk_kfifo;
+	struct rkisp_rdbk_stat rdbk_stat;
+	struct rkisp_unite_stat unite_stat;
+	struct rkisp_mode_sw mode_sw;
+	/* asks vicap to go online once the other isp devices stopped */
+	struct work_struct online_work;
+	struct rk_exp_queue exp_queue;
+	struct rkisp_perf_stat perf;
 	spinlock_t rdbk_lock;
 	int rdbk_cnt;
 	int rdbk_cnt_x1;
@@ -287,6 +391,10 @@ struct rkisp_device {
 	struct mutex buf_lock;
 	spinlock_t cmsk_lock;
 	struct rkisp_cmsk_cfg cmsk_cfg;
+	struct rkisp_cmsk_regs cmsk_regs;
+	/* cmsk registers as last written, to skip unchanged ones */
+	u32 cmsk_last[ISP_UNITE_DIV2][RKISP_CMSK_REG_NUM];
+	bool is_cmsk_last_valid;
 	bool is_cmsk_upd;
 	bool is_hw_link;
 	bool is_bigmode;
@@ -298,8 +406,16 @@ struct rkisp_device {
 	bool is_suspend;
 	bool suspend_sync;
 	bool is_suspend_one_frame;
+	/* online while other isp devices are linked but stopped */
+	bool is_dyn_online;
 
 	struct rkisp_vicap_input vicap_in;
+	struct dmcfreq_bw_request bw_req;
+	struct rockchip_video_load video_load;
+	struct thermal_cooling_device *cdev;
+	u32 cool_fps[RKISP_COOL_STEPS_MAX];
+	u32 cool_steps;
+	unsigned long cool_state;
 
 	u8 multi_mode;
 	u8 multi_index;
@@ -236,9 +236,7 @@ static irqreturn_t mi_irq_hdl(int irq, void *ctx)
 	if (hw_dev->is_thunderboot)
 		return IRQ_HANDLED;
 
-	if (rkisp_irq_dbg)
-		t = ktime_get();
-
+	t = ktime_get();
 	mis_val = readl(base + CIF_MI_MIS);
 	if (mis_val) {
 		if (mis_val & ~tx_isr)
@@ -247,6 +245,8 @@ static irqreturn_t mi_irq_hdl(int irq, void *ctx)
 			isp = hw_dev->isp[hw_dev->mipi_dev_id];
 			rkisp_mi_isr(mis_val & tx_isr, isp);
 		}
+		rk_lat_hist_add(&isp->perf.mi_isr_hist,
+				ktime_to_ns(ktime_sub(ktime_get(), t)));
 	}
 
 	if (rkisp_irq_dbg) {
@@ -271,14 +271,15 @@ static irqreturn_t isp_irq_hdl(int irq, void *ctx)
 	if (hw_dev->is_thunderboot)
 		return IRQ_HANDLED;
 
-	if (rkisp_irq_dbg)
-		t = ktime_get();
-
+	t = ktime_get();
 	mis_val = readl(base + CIF_ISP_MIS);
 	if (hw_dev->isp_ver >= ISP_V20)
 		mis_3a = readl(base + ISP_ISP3A_MIS);
-	if (mis_val || mis_3a)
+	if (mis_val || mis_3a) {
 		rkisp_isp_isr(mis_val, mis_3a, isp);
+		rk_lat_hist_add(&isp->perf.isp_isr_hist,
+				ktime_to_ns(ktime_sub(ktime_get(), t)));
+	}
 
 	if (rkisp_irq_dbg) {
 		us = ktime_us_delta(ktime_get(), t);
@@ -1073,10 +1074,25 @@ static int rkisp_get_sram(struct rkisp_hw_dev *hw_dev)
 		dev_err(dev, "get sram res error\n");
 		return ret;
 	}
-	size = resource_size(&res);
-	sram->dma_addr = dma_map_resource(dev, res.start, size, DMA_BIDIRECTIONAL, 0);
-	if (dma_mapping_error(dev, sram->dma_addr))
+	/* the bay3d line buffer, after the encoder rcb if they share it */
+	sram->client.name = dev_name(dev);
+	sram->client.prio = RK_SRAM_PRIO_NORMAL;
+	sram->client.want = resource_size(&res);
+	ret = rk_sram_register(&sram->client, &res);
+	if (ret)
+		return ret;
+	rk_sram_request(&sram->client);
+	size = sram->client.granted;
+	if (!size) {
+		dev_warn(dev, "no sram granted\n");
+		return 0;
+	}
+	sram->dma_addr = dma_map_resource(dev, sram->client.phys, size,
+					  DMA_BIDIRECTIONAL, 0);
+	if (dma_mapping_error(dev, sram->dma_addr)) {
+		rk_sram_unregister(&sram->client);
 		return -ENOMEM;
+	}
 	sram->size = size;
 	dev_info(dev, "get sram size:%d\n", size);
 	return 0;
@@ -1088,6 +1104,7 @@ static void rkisp_put_sram(struct rkisp_hw_dev *hw_dev)
 		dma_unmap_resource(hw_dev->dev, hw_dev->sram.dma_addr,
 				   hw_dev->sram.size, DMA_BIDIRECTIONAL, 0);
 	hw_dev->sram.size = 0;
+	rk_sram_unregister(&hw_dev->sram.client);
 }
 
 static int rkisp_hw_probe(struct platform_device *pdev)
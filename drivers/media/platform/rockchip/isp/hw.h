@@ -4,6 +4,8 @@
 #ifndef _RKISP_HW_H
 #define _RKISP_HW_H
 
+#include <soc/rockchip/rockchip_sram.h>
+
 #include "bridge.h"
 
 #define RKISP_MAX_BUS_CLK 10
@@ -35,6 +37,7 @@ struct rkisp_monitor {
 };
 
 struct rkisp_sram {
+	struct rk_sram_client client;
 	dma_addr_t dma_addr;
 	u32 size;
 };
@@ -70,25 +70,62 @@ void rkisp_dvbm_deinit(void)
 
 int rkisp_dvbm_event(struct rkisp_device *dev, u32 event)
 {
+	struct rkisp_wrap_stat *stat = &dev->cap_dev.wrap_stat;
+	struct dvbm_isp_frm_info info;
 	enum dvbm_cmd cmd;
-	u32 seq;
+	void *arg;
+	u32 seq, delay;
+	u64 ns;
 
 	if (!g_dvbm || dev->isp_ver != ISP_V32 ||
 	    !dev->cap_dev.wrap_line)
 		return -EINVAL;
 
 	rkisp_dmarx_get_frame(dev, &seq, NULL, NULL, true);
+	ns = rkisp_time_get_ns(dev);
+	arg = &seq;
 
 	switch (event) {
 	case CIF_ISP_V_START:
 		cmd = DVBM_ISP_FRM_START;
+		if (stat->sof_ns && stat->slice_line &&
+		    stat->line_cnt < stat->slice_line)
+			stat->slice_miss++;
+		stat->sof_ns = ns;
+		stat->frame_id = seq;
+		stat->line_cnt = 0;
+		break;
+	case ISP3X_OUT_FRM_HALF:
+		/* first slice of the wrap buffer is written */
+		if (!stat->slice_line || !stat->sof_ns)
+			return -EINVAL;
+		cmd = DVBM_ISP_FRM_LINE;
+		info.frame_cnt = seq;
+		info.line_cnt = ISP3X_ISP_OUT_LINE(rkisp_read(dev, ISP3X_ISP_DEBUG2, true));
+		if (info.line_cnt < stat->slice_line)
+			info.line_cnt = stat->slice_line;
+		info.wrap_line = dev->cap_dev.wrap_line;
+		info.max_line_cnt = dev->isp_sdev.out_crop.height;
+		arg = &info;
+		stat->line_cnt = info.line_cnt;
+		delay = div_u64(ns - stat->sof_ns, 1000);
+		stat->slice_delay = delay;
+		if (delay > stat->slice_delay_max)
+			stat->slice_delay_max = delay;
 		break;
 	case CIF_MI_MP_FRAME:
 		cmd = DVBM_ISP_FRM_END;
+		if (!stat->sof_ns)
+			break;
+		stat->line_cnt = dev->isp_sdev.out_crop.height;
+		delay = div_u64(ns - stat->sof_ns, 1000);
+		stat->frame_delay = delay;
+		if (delay > stat->frame_delay_max)
+			stat->frame_delay_max = delay;
 		break;
 	default:
 		return -EINVAL;
 	}
 
-	return rk_dvbm_ctrl(g_dvbm, cmd, &seq);
+	return rk_dvbm_ctrl(g_dvbm, cmd, arg);
 }
@@ -24,6 +24,10 @@
 #define RKISP_VICAP_CMD_SET_STREAM \
 	 _IOW('V', BASE_VIDIOC_PRIVATE + 5, int)
 
+/* move a running vicap pipeline to online (1) or auto readback (0) */
+#define RKISP_VICAP_CMD_SWITCH_MODE \
+	 _IOW('V', BASE_VIDIOC_PRIVATE + 6, int)
+
 #define RKISP_VICAP_BUF_CNT 3
 #define RKISP_VICAP_BUF_CNT_MAX 8
 #define RKISP_RX_BUF_POOL_MAX (RKISP_VICAP_BUF_CNT_MAX * 3)
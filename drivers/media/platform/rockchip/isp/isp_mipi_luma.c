@@ -59,6 +59,22 @@ static int rkisp_luma_querycap(struct file *file,
 	return 0;
 }
 
+static long rkisp_luma_ioctl_default(struct file *file, void *fh,
+				     bool valid_prio, unsigned int cmd, void *arg)
+{
+	struct rkisp_luma_vdev *luma_vdev = video_drvdata(file);
+
+	switch (cmd) {
+	case RK_MD_CMD_SET_CFG:
+		return rk_md_set_cfg(&luma_vdev->md, arg);
+	case RK_MD_CMD_GET_CFG:
+		rk_md_get_cfg(&luma_vdev->md, arg);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
 /* ISP video device IOCTLs */
 static const struct v4l2_ioctl_ops rkisp_luma_ioctl = {
 	.vidioc_reqbufs = vb2_ioctl_reqbufs,
@@ -74,7 +90,8 @@ static const struct v4l2_ioctl_ops rkisp_luma_ioctl = {
 	.vidioc_g_fmt_meta_cap = rkisp_luma_g_fmt_meta_cap,
 	.vidioc_s_fmt_meta_cap = rkisp_luma_g_fmt_meta_cap,
 	.vidioc_try_fmt_meta_cap = rkisp_luma_g_fmt_meta_cap,
-	.vidioc_querycap = rkisp_luma_querycap
+	.vidioc_querycap = rkisp_luma_querycap,
+	.vidioc_default = rkisp_luma_ioctl_default,
 };
 
 static int rkisp_luma_fh_open(struct file *filp)
@@ -296,7 +313,7 @@ void rkisp_luma_isr(struct rkisp_luma_vdev *luma_vdev, u32 isp_stat)
 	u32 i, value;
 
 	spin_lock(&luma_vdev->irq_lock);
-	if (!luma_vdev->streamon)
+	if (!luma_vdev->streamon && !rk_md_enabled(&luma_vdev->md))
 		goto unlock;
 
 	switch (op_mode) {
@@ -395,6 +412,12 @@ void rkisp_luma_isr(struct rkisp_luma_vdev *luma_vdev, u32 isp_stat)
 	}
 
 	if (send_task) {
+		/* raw2 is read in every mode */
+		rk_md_frame(&luma_vdev->md, luma_vdev->work.luma[2].exp_mean,
+			    ISP2X_MIPI_LUMA_MEAN_MAX, cur_frame_id);
+	}
+
+	if (send_task && luma_vdev->streamon) {
 		luma_vdev->work.readout = RKISP_ISP_READOUT_LUMA;
 		luma_vdev->work.timestamp = rkisp_time_get_ns(luma_vdev->dev);
 		luma_vdev->work.frame_id = cur_frame_id;
@@ -415,7 +438,9 @@ void rkisp_luma_isr(struct rkisp_luma_vdev *luma_vdev, u32 isp_stat)
 				 "stats kfifo is full\n");
 
 		tasklet_schedule(&luma_vdev->rd_tasklet);
+	}
 
+	if (send_task) {
 		for (i = 0; i < ISP2X_MIPI_RAW_MAX; i++) {
 			luma_vdev->ystat_isrcnt[i] = 0;
 			luma_vdev->ystat_rdflg[i] = false;
@@ -500,6 +525,7 @@ int rkisp_register_luma_vdev(struct rkisp_luma_vdev *luma_vdev,
 		     rkisp_luma_readout_task,
 		     (unsigned long)luma_vdev);
 	tasklet_disable(&luma_vdev->rd_tasklet);
+	rk_md_init(&luma_vdev->md, dev->dev, dev_name(dev->dev));
 
 	return 0;
 
@@ -519,6 +545,7 @@ void rkisp_unregister_luma_vdev(struct rkisp_luma_vdev *luma_vdev)
 
 	if (luma_vdev->dev->isp_ver != ISP_V20)
 		return;
+	rk_md_remove(&luma_vdev->md);
 	kfifo_free(&luma_vdev->rd_kfifo);
 	tasklet_kill(&luma_vdev->rd_tasklet);
 	video_unregister_device(vdev);
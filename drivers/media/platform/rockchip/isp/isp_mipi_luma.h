@@ -7,6 +7,7 @@
 #include <linux/rk-isp1-config.h>
 #include <linux/interrupt.h>
 #include <linux/kfifo.h>
+#include <soc/rockchip/rockchip_motion_detect.h>
 #include "common.h"
 
 #define RKISP_LUMA_READOUT_WORK_SIZE	\
@@ -56,6 +57,7 @@ struct rkisp_luma_vdev {
 	unsigned int ystat_isrcnt[ISP2X_MIPI_RAW_MAX];
 	bool ystat_rdflg[ISP2X_MIPI_RAW_MAX];
 	struct rkisp_luma_readout_work work;
+	struct rk_motion_detect md;
 };
 
 #if IS_ENABLED(CONFIG_VIDEO_ROCKCHIP_ISP_VERSION_V20)
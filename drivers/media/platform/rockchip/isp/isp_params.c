@@ -79,6 +79,8 @@ static int rkisp_params_subs_evt(struct v4l2_fh *fh,
 	case CIFISP_V4L2_EVENT_STREAM_STOP:
 		params_vdev->is_subs_evt = true;
 		return v4l2_event_subscribe(fh, sub, 0, NULL);
+	case CIFISP_V4L2_EVENT_COOLING:
+		return v4l2_event_subscribe(fh, sub, 1, NULL);
 	default:
 		return -EINVAL;
 	}
@@ -89,7 +91,8 @@ static int rkisp_params_unsubs_evt(struct v4l2_fh *fh,
 {
 	struct rkisp_isp_params_vdev *params_vdev = video_get_drvdata(fh->vdev);
 
-	params_vdev->is_subs_evt = false;
+	if (sub->type != CIFISP_V4L2_EVENT_COOLING)
+		params_vdev->is_subs_evt = false;
 	return v4l2_event_unsubscribe(fh, sub);
 }
 
@@ -404,8 +407,14 @@ static void rkisp_uninit_params_vdev(struct rkisp_isp_params_vdev *params_vdev)
 
 void rkisp_params_cfg(struct rkisp_isp_params_vdev *params_vdev, u32 frame_id)
 {
-	if (params_vdev->ops->param_cfg)
+	u64 ns;
+
+	if (params_vdev->ops->param_cfg) {
+		ns = ktime_get_ns();
 		params_vdev->ops->param_cfg(params_vdev, frame_id, RKISP_PARAMS_IMD);
+		rk_lat_hist_add(&params_vdev->dev->perf.params_hist,
+				ktime_get_ns() - ns);
+	}
 }
 
 void rkisp_params_cfgsram(struct rkisp_isp_params_vdev *params_vdev, bool is_check)
@@ -425,7 +434,13 @@ void rkisp_params_cfgsram(struct rkisp_isp_params_vdev *params_vdev, bool is_che
 void rkisp_params_isr(struct rkisp_isp_params_vdev *params_vdev,
 		      u32 isp_mis)
 {
+	u64 ns = ktime_get_ns();
+
 	params_vdev->ops->isr_hdl(params_vdev, isp_mis);
+	/* params are applied at frame end */
+	if (isp_mis & CIF_ISP_FRAME)
+		rk_lat_hist_add(&params_vdev->dev->perf.params_hist,
+				ktime_get_ns() - ns);
 }
 
 /* Not called when the camera active, thus not isr protection. */
@@ -3541,6 +3541,7 @@ isp_bay3d_config(struct rkisp_isp_params_vdev *params_vdev,
 		 const struct isp32_bay3d_cfg *arg, u32 id)
 {
 	struct rkisp_isp_params_val_v32 *priv_val;
+	bool is_bwsaving;
 	u32 i, value;
 
 	priv_val = (struct rkisp_isp_params_val_v32 *)params_vdev->priv_val;
@@ -3560,12 +3561,14 @@ isp_bay3d_config(struct rkisp_isp_params_vdev *params_vdev,
 	if (params_vdev->dev->isp_ver == ISP_V32)
 		value |= !!arg->hichnsplit_en << 7 |
 			 !!arg->himed_bypass_en << 4;
+	/* the buffers may be sized for bwsaving whatever the config says */
+	is_bwsaving = arg->bwsaving_en || priv_val->is_bwsaving;
 	if (!(value & ISP32_MODULE_EN)) {
 		value &= ~ISP32_BAY3D_BWSAVING(1);
-		if (arg->bwsaving_en)
+		if (is_bwsaving)
 			value |= ISP32_BAY3D_BWSAVING(1);
 	} else if ((value & ISP32_BAY3D_BWSAVING(1)) !=
-		   ISP32_BAY3D_BWSAVING(!!arg->bwsaving_en)) {
+		   ISP32_BAY3D_BWSAVING(is_bwsaving)) {
 		v4l2_warn(&params_vdev->dev->v4l2_dev,
 			  "bwsaving to %d no support change for bay3d en\n",
 			  arg->bwsaving_en);
@@ -4044,6 +4047,88 @@ struct rkisp_isp_params_ops_v32 isp_params_ops_v32 = {
 	.vsm_enable = isp_vsm_enable,
 };
 
+#define ISP32_MODULE_LUT_MASK (ISP32_MODULE_LSC | ISP32_MODULE_GOC | \
+			       ISP32_MODULE_GIC | ISP32_MODULE_3DLUT | \
+			       ISP32_MODULE_BAY3D | ISP32_MODULE_YNR | \
+			       ISP32_MODULE_SHARP | ISP32_MODULE_CNR)
+
+static bool
+isp_cfg_rec_same(struct rkisp_isp_params_rec_v32 *rec, u64 module,
+		 void *rec_cfg, const void *cfg, size_t size)
+{
+	if ((rec->valid & module) && !memcmp(rec_cfg, cfg, size))
+		return true;
+	memcpy(rec_cfg, cfg, size);
+	rec->valid |= module;
+	return false;
+}
+
+/*
+ * lut tables are mostly static between frames, but the whole table is
+ * rewritten for each update bit. Drop the update bit if the config is
+ * the same as the last written one, the register cache and lut buffer
+ * still hold it. RKISP_PARAMS_ALL always rewrite and reload the record.
+ */
+static u64
+isp_cfg_lut_filter(struct rkisp_isp_params_vdev *params_vdev,
+		   const struct isp32_isp_params_cfg *new_params,
+		   enum rkisp_params_type type, u64 module_cfg_update, u32 id)
+{
+	struct rkisp_isp_params_val_v32 *priv_val =
+		(struct rkisp_isp_params_val_v32 *)params_vdev->priv_val;
+	const struct isp32_isp_other_cfg *cfg = &new_params->others;
+	struct rkisp_isp_params_rec_v32 *rec;
+	u64 skip = 0;
+
+	if (!priv_val->cfg_rec || !(module_cfg_update & ISP32_MODULE_LUT_MASK))
+		return module_cfg_update;
+
+	rec = priv_val->cfg_rec + id;
+	if (type == RKISP_PARAMS_ALL)
+		rec->valid = 0;
+
+	if ((module_cfg_update & ISP32_MODULE_LSC) &&
+	    isp_cfg_rec_same(rec, ISP32_MODULE_LSC, &rec->lsc,
+			     &cfg->lsc_cfg, sizeof(rec->lsc)))
+		skip |= ISP32_MODULE_LSC;
+	if ((module_cfg_update & ISP32_MODULE_GOC) &&
+	    isp_cfg_rec_same(rec, ISP32_MODULE_GOC, &rec->goc,
+			     &cfg->gammaout_cfg, sizeof(rec->goc)))
+		skip |= ISP32_MODULE_GOC;
+	if ((module_cfg_update & ISP32_MODULE_GIC) &&
+	    isp_cfg_rec_same(rec, ISP32_MODULE_GIC, &rec->gic,
+			     &cfg->gic_cfg, sizeof(rec->gic)))
+		skip |= ISP32_MODULE_GIC;
+	if ((module_cfg_update & ISP32_MODULE_3DLUT) &&
+	    isp_cfg_rec_same(rec, ISP32_MODULE_3DLUT, &rec->lut3d,
+			     &cfg->isp3dlut_cfg, sizeof(rec->lut3d)))
+		skip |= ISP32_MODULE_3DLUT;
+	if ((module_cfg_update & ISP32_MODULE_BAY3D) &&
+	    isp_cfg_rec_same(rec, ISP32_MODULE_BAY3D, &rec->bay3d,
+			     &cfg->bay3d_cfg, sizeof(rec->bay3d)))
+		skip |= ISP32_MODULE_BAY3D;
+	if ((module_cfg_update & ISP32_MODULE_YNR) &&
+	    isp_cfg_rec_same(rec, ISP32_MODULE_YNR, &rec->ynr,
+			     &cfg->ynr_cfg, sizeof(rec->ynr)))
+		skip |= ISP32_MODULE_YNR;
+	if ((module_cfg_update & ISP32_MODULE_SHARP) &&
+	    isp_cfg_rec_same(rec, ISP32_MODULE_SHARP, &rec->sharp,
+			     &cfg->sharp_cfg, sizeof(rec->sharp)))
+		skip |= ISP32_MODULE_SHARP;
+	if ((module_cfg_update & ISP32_MODULE_CNR) &&
+	    isp_cfg_rec_same(rec, ISP32_MODULE_CNR, &rec->cnr,
+			     &cfg->cnr_cfg, sizeof(rec->cnr)))
+		skip |= ISP32_MODULE_CNR;
+
+	if (skip) {
+		priv_val->cfg_skip_cnt++;
+		v4l2_dbg(4, rkisp_debug, &params_vdev->dev->v4l2_dev,
+			 "%s id:%d seq:%d skip same lut:0x%llx\n",
+			 __func__, id, new_params->frame_id, skip);
+	}
+	return module_cfg_update & ~skip;
+}
+
 static __maybe_unused
 void __isp_isr_other_config(struct rkisp_isp_params_vdev *params_vdev,
 			    const struct isp32_isp_params_cfg *new_params,
@@ -4066,6 +4151,10 @@ void __isp_isr_other_config(struct rkisp_isp_params_vdev *params_vdev,
 		return;
 	}
 
+	if (!(module_cfg_update & ISP32_MODULE_FORCE))
+		module_cfg_update = isp_cfg_lut_filter(params_vdev, new_params, type,
+						       module_cfg_update, id);
+
 	v4l2_dbg(4, rkisp_debug, &params_vdev->dev->v4l2_dev,
 		 "%s id:%d seq:%d module_cfg_update:0x%llx\n",
 		 __func__, id, new_params->frame_id, module_cfg_update);
@@ -4391,6 +4480,33 @@ void rkisp_params_cfgsram_v32(struct rkisp_isp_params_vdev *params_vdev)
 	isp_rawawb_cfg_sram(params_vdev, &params->meas.rawawb, true, id);
 }
 
+/* bytes per line of the bay3d iir or cur reference */
+static u32 isp_bay3d_wsize(u32 w, bool is_bwopt_dis, bool is_bwsaving, bool is_pk)
+{
+	/*
+	 * bwopt_dis one line image with one line pk gain
+	 * other two line image with one line pk gain
+	 */
+	u32 wsize = is_bwopt_dis ? w : w * 2;
+
+	if (is_bwsaving)
+		wsize = wsize * 3 / 4;
+	/* pk gain to ddr */
+	if (is_pk)
+		wsize += w / 8;
+	/* pixel to Byte */
+	return wsize * 2;
+}
+
+/* the cur reference is a ring of wrap_line lines, in sram if it fits */
+static u32 isp_bay3d_cur_size(u32 w, u32 wrap_line, u32 div, bool is_bwopt_dis,
+			      bool is_bwsaving, bool is_pk)
+{
+	u32 wsize = ALIGN(isp_bay3d_wsize(w, is_bwopt_dis, is_bwsaving, is_pk), 16);
+
+	return ALIGN(wsize * wrap_line / div, 16);
+}
+
 static int
 rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 			 const struct isp32_isp_params_cfg *new_params)
@@ -4427,9 +4543,11 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 		bool is_glbpk = !!new_params->others.bay3d_cfg.glbpk_en;
 		bool is_bwopt_dis = !!new_params->others.bay3d_cfg.bwopt_gain_dis;
 		bool is_predgain = !!new_params->others.bls_cfg.isp_ob_predgain;
+		bool is_cur_pk = is_hdr || is_predgain;
 		u32 w = ALIGN(isp_sdev->in_crop.width, 16);
 		u32 h = ALIGN(isp_sdev->in_crop.height, 16);
-		u32 val, wrap_line, wsize, div;
+		u32 val, wrap_line, wsize, div, iir_full, frm, frm_full;
+		u32 sram_size = dev->hw_dev->sram.size;
 		bool is_alloc;
 
 		if (dev->unite_div > ISP_UNITE_DIV1)
@@ -4439,20 +4557,29 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 
 		priv_val->is_lo8x8 = (!new_params->others.bay3d_cfg.lo4x8_en &&
 				      !new_params->others.bay3d_cfg.lo4x4_en);
+		if (dev->isp_ver == ISP_V32)
+			wrap_line = priv_val->is_lo8x8 ? 76 : 36;
+		else
+			wrap_line = priv_val->is_lo8x8 ? 64 : 32;
+		div = is_bwopt_dis ? 1 : 2;
 
 		/*
-		 * bwopt_dis one line image with one line pk gain
-		 * other two line image with one line pk gain
+		 * The bwsaving reference trades the low bits for a quarter of
+		 * the iir and cur traffic, and may make the cur row buffer
+		 * small enough for the sram. It can't change while bay3d is
+		 * on, so it is decided here, with the buffer sizes.
 		 */
-		wsize = is_bwopt_dis ? w : w * 2;
-		if (is_bwsaving)
-			wsize = wsize * 3 / 4;
-		/* pk gain to ddr */
-		if (!is_glbpk)
-			wsize += w / 8;
-		/* pixel to Byte */
-		wsize *= 2;
-		div = is_bwopt_dis ? 1 : 2;
+		if (!is_bwsaving &&
+		    (rkisp_bay3d_bwsaving == 1 ||
+		     (rkisp_bay3d_bwsaving == 2 &&
+		      isp_bay3d_cur_size(w, wrap_line, div, is_bwopt_dis,
+					 false, is_cur_pk) > sram_size &&
+		      isp_bay3d_cur_size(w, wrap_line, div, is_bwopt_dis,
+					 true, is_cur_pk) <= sram_size)))
+			is_bwsaving = true;
+		priv_val->is_bwsaving = is_bwsaving;
+
+		wsize = isp_bay3d_wsize(w, is_bwopt_dis, is_bwsaving, !is_glbpk);
 		val = ALIGN(wsize * h / div, 16);
 		priv_val->bay3d_iir_size = val;
 		if (dev->unite_div > ISP_UNITE_DIV1)
@@ -4497,27 +4624,18 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 			}
 		}
 
-		if (dev->isp_ver == ISP_V32)
-			wrap_line = priv_val->is_lo8x8 ? 76 : 36;
-		else
-			wrap_line = priv_val->is_lo8x8 ? 64 : 32;
-		wsize = is_bwopt_dis ? w : w * 2;
-		if (is_bwsaving)
-			wsize = wsize * 3 / 4;
-		if (is_hdr || is_predgain)
-			wsize += w / 8;
-		/* pixel to Byte and align */
-		wsize = ALIGN(wsize * 2, 16);
 		div = is_bwopt_dis ? 1 : 2;
-		val = ALIGN(wsize * wrap_line / div, 16);
+		wsize = ALIGN(isp_bay3d_wsize(w, is_bwopt_dis, is_bwsaving, is_cur_pk), 16);
+		val = isp_bay3d_cur_size(w, wrap_line, div, is_bwopt_dis,
+					 is_bwsaving, is_cur_pk);
 		is_alloc = true;
 		if (priv_val->buf_3dnr_cur.mem_priv) {
-			if (val > priv_val->buf_3dnr_cur.size || val < dev->hw_dev->sram.size)
+			if (val > priv_val->buf_3dnr_cur.size || val < sram_size)
 				rkisp_free_buffer(dev, &priv_val->buf_3dnr_cur);
 			else
 				is_alloc = false;
 		}
-		if (val > dev->hw_dev->sram.size && is_alloc) {
+		if (val > sram_size && is_alloc) {
 			priv_val->buf_3dnr_cur.size = val;
 			ret = rkisp_alloc_buffer(dev, &priv_val->buf_3dnr_cur);
 			if (ret) {
@@ -4527,12 +4645,26 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 				goto err_3dnr;
 			}
 			priv_val->is_sram = false;
-		} else if (val <= dev->hw_dev->sram.size) {
+		} else if (val <= sram_size) {
 			priv_val->is_sram = true;
 		}
 		priv_val->bay3d_cur_size = val;
 		priv_val->bay3d_cur_wsize = wsize;
 		priv_val->bay3d_cur_wrap_line = wrap_line;
+
+		/* each frame writes and reads back the iir, ds and cur data */
+		iir_full = ALIGN(isp_bay3d_wsize(w, is_bwopt_dis, false, !is_glbpk) *
+				 h / div, 16);
+		frm = wsize * h / div;
+		frm_full = ALIGN(isp_bay3d_wsize(w, is_bwopt_dis, false, is_cur_pk), 16) *
+			   h / div;
+		val = max_t(u32, dev->unite_div, ISP_UNITE_DIV1) * 2;
+		priv_val->bay3d_bw_ddr = val * (priv_val->bay3d_iir_size +
+						priv_val->bay3d_ds_size +
+						(priv_val->is_sram ? 0 : frm));
+		priv_val->bay3d_bw_bwsaving = val * (iir_full - priv_val->bay3d_iir_size +
+						     (priv_val->is_sram ? 0 : frm_full - frm));
+		priv_val->bay3d_bw_sram = priv_val->is_sram ? val * frm : 0;
 	}
 
 	if (dev->isp_ver == ISP_V32_L) {
@@ -5075,6 +5207,10 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 				buf->dma_fd = dma_buf_fd(buf->dbuf, O_CLOEXEC);
 				if (buf->dma_fd < 0)
 					goto err;
+				/* kept from the last stream, table_id tells its content */
+				mesh_head = (struct isp2x_mesh_head *)buf->vaddr;
+				if (!(ispdev->isp_state & ISP_START))
+					mesh_head->stat = MESH_BUF_INIT;
 			}
 		}
 		if (is_alloc) {
@@ -5087,9 +5223,13 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 			mesh_head = (struct isp2x_mesh_head *)buf->vaddr;
 			mesh_head->stat = MESH_BUF_INIT;
 			mesh_head->data_oft = ALIGN(sizeof(struct isp2x_mesh_head), 16);
+			mesh_head->table_id = 0;
 		}
 		buf++;
 	}
+	/* a kept buffer past buf_cnt has no fd for userspace any more */
+	for (; i < ISP32_MESH_BUF_NUM; i++, buf++)
+		rkisp_free_buffer(params_vdev->dev, buf);
 
 	return 0;
 err:
@@ -5313,10 +5453,16 @@ rkisp_params_stream_stop_v32(struct rkisp_isp_params_vdev *params_vdev)
 	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_iir);
 	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_cur);
 	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_ds);
+	priv_val->is_bwsaving = false;
+	priv_val->bay3d_bw_ddr = 0;
+	priv_val->bay3d_bw_bwsaving = 0;
+	priv_val->bay3d_bw_sram = 0;
 	for (i = 0; i < ISP32_LSC_LUT_BUF_NUM; i++)
 		rkisp_free_buffer(ispdev, &priv_val->buf_lsclut[i]);
 	for (i = 0; i < RKISP_STATS_DDR_BUF_NUM; i++)
 		rkisp_free_buffer(ispdev, &ispdev->stats_vdev.stats_buf[i]);
+	ispdev->stats_vdev.ring_num = 0;
+	rkisp_free_buffer(ispdev, &ispdev->stats_vdev.ring_buf);
 	for (id = 0; id < ispdev->unite_div; id++) {
 		for (i = 0; i < ISP32_3DLUT_BUF_NUM; i++)
 			rkisp_free_buffer(ispdev, &priv_val->buf_3dlut[id][i]);
@@ -5333,6 +5479,10 @@ rkisp_params_fop_release_v32(struct rkisp_isp_params_vdev *params_vdev)
 {
 	int id;
 
+	/* pool for the next stream, freed by meshbuf free or at remove */
+	if (rkisp_mesh_keep)
+		return;
+
 	for (id = 0; id < params_vdev->dev->unite_div; id++) {
 		rkisp_deinit_mesh_buf(params_vdev, ISP32_MODULE_LDCH, id);
 		rkisp_deinit_mesh_buf(params_vdev, ISP32_MODULE_CAC, id);
@@ -5543,6 +5693,12 @@ int rkisp_init_params_vdev_v32(struct rkisp_isp_params_vdev *params_vdev)
 		return -ENOMEM;
 	}
 
+	size = sizeof(struct rkisp_isp_params_rec_v32);
+	if (params_vdev->dev->hw_dev->unite)
+		size *= ISP_UNITE_MAX;
+	/* optional, lut always rewrite without it */
+	priv_val->cfg_rec = vzalloc(size);
+
 	params_vdev->priv_val = (void *)priv_val;
 	params_vdev->ops = &rkisp_isp_params_ops_tbl;
 	params_vdev->priv_ops = &isp_params_ops_v32;
@@ -5559,11 +5715,17 @@ int rkisp_init_params_vdev_v32(struct rkisp_isp_params_vdev *params_vdev)
 void rkisp_uninit_params_vdev_v32(struct rkisp_isp_params_vdev *params_vdev)
 {
 	struct rkisp_isp_params_val_v32 *priv_val = params_vdev->priv_val;
+	int id;
 
 	if (params_vdev->isp32_params)
 		vfree(params_vdev->isp32_params);
 	if (priv_val) {
 		tasklet_kill(&priv_val->lsc_tasklet);
+		for (id = 0; id < params_vdev->dev->unite_div; id++) {
+			rkisp_deinit_mesh_buf(params_vdev, ISP32_MODULE_LDCH, id);
+			rkisp_deinit_mesh_buf(params_vdev, ISP32_MODULE_CAC, id);
+		}
+		vfree(priv_val->cfg_rec);
 		kfree(priv_val);
 		params_vdev->priv_val = NULL;
 	}
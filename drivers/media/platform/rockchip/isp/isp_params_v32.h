@@ -172,6 +172,19 @@ struct rkisp_isp_params_ops_v32 {
 			   bool en, u32 id);
 };
 
+/* last written lut config, rewrite skipped if new config is the same */
+struct rkisp_isp_params_rec_v32 {
+	struct isp3x_lsc_cfg lsc;
+	struct isp3x_gammaout_cfg goc;
+	struct isp21_gic_cfg gic;
+	struct isp2x_3dlut_cfg lut3d;
+	struct isp32_bay3d_cfg bay3d;
+	struct isp32_ynr_cfg ynr;
+	struct isp32_sharp_cfg sharp;
+	struct isp32_cnr_cfg cnr;
+	u64 valid;
+};
+
 struct rkisp_isp_params_val_v32 {
 	struct tasklet_struct lsc_tasklet;
 
@@ -197,12 +210,19 @@ struct rkisp_isp_params_val_v32 {
 	u32 bay3d_cur_size;
 	u32 bay3d_cur_wsize;
 	u32 bay3d_cur_wrap_line;
+	/* ddr bytes per frame, and what bwsaving and sram save of it */
+	u32 bay3d_bw_ddr;
+	u32 bay3d_bw_bwsaving;
+	u32 bay3d_bw_sram;
 	struct rkisp_dummy_buffer buf_3dnr_iir;
 	struct rkisp_dummy_buffer buf_3dnr_cur;
 	struct rkisp_dummy_buffer buf_3dnr_ds;
 
 	struct rkisp_dummy_buffer buf_frm;
 
+	struct rkisp_isp_params_rec_v32 *cfg_rec;
+	u32 cfg_skip_cnt;
+
 	bool dhaz_en;
 	bool drc_en;
 	bool lsc_en;
@@ -212,6 +232,7 @@ struct rkisp_isp_params_val_v32 {
 	bool is_bigmode;
 	bool is_lo8x8;
 	bool is_sram;
+	bool is_bwsaving;
 };
 
 #if IS_ENABLED(CONFIG_VIDEO_ROCKCHIP_ISP_VERSION_V32)
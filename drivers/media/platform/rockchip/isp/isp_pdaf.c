@@ -244,6 +244,7 @@ static int rkisp_pdaf_start_streaming(struct vb2_queue *vq, unsigned int count)
 		 "%s cnt:%d\n", __func__, count);
 	val = pdaf_vdev->fmt.plane_fmt[0].bytesperline;
 	rkisp_write(dev, ISP39_W3A_CTRL1, val, false);
+	pdaf_vdev->is_done_valid = false;
 	pdaf_vdev->streaming = true;
 	tasklet_enable(&pdaf_vdev->buf_done_tasklet);
 	return 0;
@@ -380,11 +381,38 @@ void rkisp_pdaf_isr(struct rkisp_device *dev)
 		buf->vb.vb2_buf.timestamp = ns;
 		spin_lock_irqsave(&pdaf_vdev->vbq_lock, flags);
 		list_add_tail(&buf->queue, &pdaf_vdev->buf_done_list);
+		pdaf_vdev->done_seq = seq;
+		pdaf_vdev->done_index = vb2_buf->index;
+		pdaf_vdev->is_done_valid = true;
 		spin_unlock_irqrestore(&pdaf_vdev->vbq_lock, flags);
 		tasklet_schedule(&pdaf_vdev->buf_done_tasklet);
 	}
 }
 
+/*
+ * the pdaf buffer of frame_id, for the stats of the same frame. the pdaf
+ * irq is handled ahead of the frame stats, so the buffer is already on
+ * its way to userspace when the stats are done.
+ */
+bool rkisp_pdaf_get_done(struct rkisp_device *dev, u32 frame_id, u32 *index)
+{
+	struct rkisp_pdaf_vdev *pdaf_vdev = &dev->pdaf_vdev;
+	unsigned long flags = 0;
+	bool ret = false;
+
+	if (!pdaf_vdev->streaming)
+		return false;
+
+	spin_lock_irqsave(&pdaf_vdev->vbq_lock, flags);
+	if (pdaf_vdev->is_done_valid && pdaf_vdev->done_seq == frame_id) {
+		*index = pdaf_vdev->done_index;
+		pdaf_vdev->is_done_valid = false;
+		ret = true;
+	}
+	spin_unlock_irqrestore(&pdaf_vdev->vbq_lock, flags);
+	return ret;
+}
+
 int rkisp_register_pdaf_vdev(struct rkisp_device *dev)
 {
 	struct rkisp_pdaf_vdev *pdaf_vdev = &dev->pdaf_vdev;
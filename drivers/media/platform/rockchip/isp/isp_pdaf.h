@@ -21,6 +21,10 @@ struct rkisp_pdaf_vdev {
 	struct rkisp_buffer *curr_buf;
 	struct rkisp_buffer *next_buf;
 	wait_queue_head_t done;
+	/* last buffer done, for the stats of the same frame */
+	u32 done_seq;
+	u32 done_index;
+	bool is_done_valid;
 	bool streaming;
 	bool stopping;
 };
@@ -28,11 +32,13 @@ struct rkisp_pdaf_vdev {
 #if IS_ENABLED(CONFIG_VIDEO_ROCKCHIP_ISP_VERSION_V39)
 void rkisp_pdaf_update_buf(struct rkisp_device *dev);
 void rkisp_pdaf_isr(struct rkisp_device *dev);
+bool rkisp_pdaf_get_done(struct rkisp_device *dev, u32 frame_id, u32 *index);
 int rkisp_register_pdaf_vdev(struct rkisp_device *dev);
 void rkisp_unregister_pdaf_vdev(struct rkisp_device *dev);
 #else
 static inline void rkisp_pdaf_update_buf(struct rkisp_device *dev) {}
 static inline void rkisp_pdaf_isr(struct rkisp_device *dev) {}
+static inline bool rkisp_pdaf_get_done(struct rkisp_device *dev, u32 frame_id, u32 *index) { return false; }
 static inline int rkisp_register_pdaf_vdev(struct rkisp_device *dev) { return 0; }
 static inline void rkisp_unregister_pdaf_vdev(struct rkisp_device *dev) {}
 #endif
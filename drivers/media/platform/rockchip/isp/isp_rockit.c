@@ -5,6 +5,7 @@
 
 #include <linux/of.h>
 #include <linux/of_platform.h>
+#include <soc/rockchip/rockchip_frame_policy.h>
 #include <soc/rockchip/rockchip_rockit.h>
 
 #include "dev.h"
@@ -257,7 +258,7 @@ int rkisp_rockit_buf_done(struct rkisp_stream *stream, int cmd)
 		return -EINVAL;
 
 	stream_cfg = &rockit_cfg->rkisp_dev_cfg[dev_id].rkisp_stream_cfg[stream->id];
-	if (cmd == ROCKIT_DVBM_END) {
+	if (cmd == ROCKIT_DVBM_END || cmd == ROCKIT_SNAPSHOT_END) {
 		isprk_buf =
 			container_of(stream->curr_buf, struct rkisp_rockit_buffer, isp_buf);
 
@@ -336,6 +337,21 @@ int rkisp_rockit_buf_done(struct rkisp_stream *stream, int cmd)
 	return 0;
 }
 
+/* arm num selfpath snapshot frames, see RKISP_CMD_SET_SNAPSHOT */
+int rkisp_rockit_snapshot(struct rockit_cfg *input_rockit_cfg, int num)
+{
+	struct rkisp_stream *stream = NULL;
+
+	stream = rkisp_rockit_get_stream(input_rockit_cfg);
+	if (!stream || !stream->ops->set_snapshot) {
+		pr_err("inval stream");
+		return -EINVAL;
+	}
+
+	return stream->ops->set_snapshot(stream, num);
+}
+EXPORT_SYMBOL(rkisp_rockit_snapshot);
+
 int rkisp_rockit_pause_stream(struct rockit_cfg *input_rockit_cfg)
 {
 	struct rkisp_stream *stream = NULL;
@@ -658,6 +674,44 @@ int rkisp_rockit_fps_get(int *dst_fps, struct rkisp_stream *stream)
 	return 0;
 }
 
+/* the verdict of the frame starting now, true to drop it */
+static bool rkisp_rockit_frame_policy(struct rkisp_stream *stream)
+{
+	struct rkisp_device *dev = stream->ispdev;
+	struct rk_frame_info info = {
+		.source = RK_FRAME_SRC_ISP,
+		.dev_id = dev->dev_id,
+		.stream_id = stream->id,
+		.width = stream->out_fmt.width,
+		.height = stream->out_fmt.height,
+		.fourcc = stream->out_fmt.pixelformat,
+	};
+
+	rkisp_dmarx_get_frame(dev, &info.seq, NULL, &info.sof_ns, true);
+	info.nr_means = rk_md_get_luma(&dev->luma_vdev.md, info.luma_mean,
+				       RK_FRAME_MEANS_MAX, &info.motion);
+	stream->policy_verdict = rk_frame_policy_run(&info);
+
+	return stream->policy_verdict & RK_FRAME_DROP;
+}
+
+/*
+ * Close the path mi for the next frame so a dropped frame never reaches
+ * ddr. The pause shifts the drop one frame later, the rate stays the same.
+ * Wrap and readback output fall back to recycling the written frame.
+ */
+static void rkisp_rockit_skip_frame(struct rkisp_stream *stream)
+{
+	bool is_wrap = stream->ispdev->cap_dev.wrap_line &&
+		       stream->id == RKISP_STREAM_MP;
+
+	if (!is_wrap && stream->ops->skip_next &&
+	    !stream->ops->skip_next(stream))
+		return;
+	if (stream->next_buf || !list_empty(&stream->buf_queue))
+		stream->skip_frame = 1;
+}
+
 static bool rkisp_rockit_ctrl_fps(struct rkisp_stream *stream)
 {
 	struct rkisp_device *dev = stream->ispdev;
@@ -673,6 +727,14 @@ static bool rkisp_rockit_ctrl_fps(struct rkisp_stream *stream)
 	if (!rockit_cfg || stream->id >= ROCKIT_STREAM_NUM_MAX)
 		return false;
 	stream_cfg = &rockit_cfg->rkisp_dev_cfg[dev_id].rkisp_stream_cfg[id];
+	if (rk_frame_policy_enabled() && stream->streaming &&
+	    rkisp_rockit_frame_policy(stream)) {
+		/* the fps control doesn't count the frames policy drops */
+		stream_cfg->is_discard = true;
+		if (stream->next_buf || !list_empty(&stream->buf_queue))
+			stream->skip_frame = 1;
+		return true;
+	}
 	fps_cnt = &stream_cfg->fps_cnt;
 	is_discard = &stream_cfg->is_discard;
 	old_time = &stream_cfg->old_time;
@@ -717,8 +779,7 @@ static bool rkisp_rockit_ctrl_fps(struct rkisp_stream *stream)
 
 		if (*fps_cnt < fps_in) {
 			*is_discard = true;
-			if (stream->next_buf || !list_empty(&stream->buf_queue))
-				stream->skip_frame = 1;
+			rkisp_rockit_skip_frame(stream);
 		} else {
 			*fps_cnt -= fps_in;
 			*is_discard = false;
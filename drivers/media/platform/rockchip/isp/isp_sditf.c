@@ -28,6 +28,60 @@ static int rkisp_sditf_get_set_fmt(struct v4l2_subdev *sd,
 	return v4l2_subdev_call(&dev->isp_sdev.sd, pad, get_fmt, NULL, fmt);
 }
 
+static void rkisp_sditf_ring_reset(struct rkisp_sditf_device *sditf)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&sditf->ring_lock, flags);
+	sditf->ring_wr = 0;
+	sditf->ring_rd = 0;
+	sditf->inflight_max = 0;
+	sditf->overrun = 0;
+	sditf->eof_unmatched = 0;
+	rk_lat_hist_reset(&sditf->lat_hist);
+	spin_unlock_irqrestore(&sditf->ring_lock, flags);
+}
+
+/* frame handed to the remote at isp sof */
+static void rkisp_sditf_ring_push(struct rkisp_sditf_device *sditf,
+				  u32 seq, u64 ns)
+{
+	struct rkisp_sditf_frame *frame;
+	unsigned long flags;
+	u32 inflight;
+
+	spin_lock_irqsave(&sditf->ring_lock, flags);
+	if (sditf->ring_wr - sditf->ring_rd >= RKISP_SDITF_RING_NUM) {
+		sditf->ring_rd++;
+		sditf->overrun++;
+	}
+	frame = &sditf->ring[sditf->ring_wr % RKISP_SDITF_RING_NUM];
+	frame->seq = seq;
+	frame->sof_ns = ns;
+	sditf->ring_wr++;
+	inflight = sditf->ring_wr - sditf->ring_rd;
+	if (inflight > sditf->inflight_max)
+		sditf->inflight_max = inflight;
+	spin_unlock_irqrestore(&sditf->ring_lock, flags);
+}
+
+/* oldest frame given back at remote eof */
+static void rkisp_sditf_ring_pop(struct rkisp_sditf_device *sditf)
+{
+	struct rkisp_sditf_frame *frame;
+	unsigned long flags;
+
+	spin_lock_irqsave(&sditf->ring_lock, flags);
+	if (sditf->ring_rd == sditf->ring_wr) {
+		sditf->eof_unmatched++;
+	} else {
+		frame = &sditf->ring[sditf->ring_rd % RKISP_SDITF_RING_NUM];
+		rk_lat_hist_add(&sditf->lat_hist, ktime_get_ns() - frame->sof_ns);
+		sditf->ring_rd++;
+	}
+	spin_unlock_irqrestore(&sditf->ring_lock, flags);
+}
+
 static int rkisp_sditf_s_stream(struct v4l2_subdev *sd, int on)
 {
 	struct rkisp_sditf_device *sditf = v4l2_get_subdevdata(sd);
@@ -53,6 +107,7 @@ static int rkisp_sditf_s_stream(struct v4l2_subdev *sd, int on)
 		ret = dev->pipe.set_stream(&dev->pipe, true);
 		if (ret < 0)
 			goto pipe_close;
+		rkisp_sditf_ring_reset(sditf);
 		sditf->is_on = true;
 		dev->irq_ends_mask |= ISP_FRAME_VPSS;
 		goto unlock;
@@ -96,9 +151,27 @@ void rkisp_sditf_sof(struct rkisp_device *dev, u32 irq)
 		return;
 	info.irq = irq;
 	rkisp_dmarx_get_frame(dev, &info.seq, NULL, &info.timestamp, true);
+	rkisp_sditf_ring_push(sditf, info.seq, ktime_get_ns());
 	v4l2_subdev_call(sditf->remote_sd, core, ioctl, RKISP_VPSS_CMD_SOF, &info);
 }
 
+void rkisp_sditf_show(struct rkisp_device *dev, struct seq_file *p)
+{
+	struct rkisp_sditf_device *sditf = dev->sditf_dev;
+	unsigned long flags;
+	u32 inflight;
+
+	if (!sditf || !sditf->lat_hist.cnt)
+		return;
+	spin_lock_irqsave(&sditf->ring_lock, flags);
+	inflight = sditf->ring_wr - sditf->ring_rd;
+	seq_printf(p, "%-16s frames:%u inflight:%u max:%u overrun:%u unmatched eof:%u\n",
+		   "Sditf", sditf->ring_wr, inflight, sditf->inflight_max,
+		   sditf->overrun, sditf->eof_unmatched);
+	rk_lat_hist_show(p, "sditf sof to eof", &sditf->lat_hist);
+	spin_unlock_irqrestore(&sditf->ring_lock, flags);
+}
+
 static long rkisp_sditf_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 {
 	struct rkisp_sditf_device *sditf = v4l2_get_subdevdata(sd);
@@ -106,6 +179,7 @@ static long rkisp_sditf_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *ar
 
 	switch (cmd) {
 	case RKISP_VPSS_CMD_EOF:
+		rkisp_sditf_ring_pop(sditf);
 		rkisp_check_idle(sditf->isp, ISP_FRAME_VPSS);
 		break;
 	default:
@@ -191,6 +265,7 @@ static int rkisp_sditf_probe(struct platform_device *pdev)
 		return -ENOMEM;
 	dev_set_drvdata(dev, sditf);
 	sditf->dev = dev;
+	spin_lock_init(&sditf->ring_lock);
 	sd = &sditf->sd;
 	v4l2_subdev_init(sd, &sditf_subdev_ops);
 	sd->flags |= V4L2_SUBDEV_FL_HAS_DEVNODE;
@@ -4,8 +4,21 @@
 #ifndef _RKISP_SDITF_H
 #define _RKISP_SDITF_H
 
+#define RKISP_SDITF_RING_NUM	4
+
+/* one frame handed to the remote, from its isp sof to the remote eof */
+struct rkisp_sditf_frame {
+	u32 seq;
+	u64 sof_ns;
+};
+
 /* struct rkisp_sditf_device
  * isp subdev interface link other media device
+ *
+ * the isp to remote link is online, frames are handed over at isp sof
+ * and given back at remote eof. the ring keeps the frames in flight, a
+ * remote falling behind by more than RKISP_SDITF_RING_NUM frames drops
+ * the oldest, which counts as overrun.
  */
 struct rkisp_sditf_device {
 	struct device *dev;
@@ -15,14 +28,26 @@ struct rkisp_sditf_device {
 	struct v4l2_async_notifier notifier;
 	struct v4l2_subdev *remote_sd;
 
+	spinlock_t ring_lock;
+	struct rkisp_sditf_frame ring[RKISP_SDITF_RING_NUM];
+	u32 ring_wr;
+	u32 ring_rd;
+	u32 inflight_max;
+	u32 overrun;
+	u32 eof_unmatched;
+	/* isp sof to remote eof */
+	struct rk_lat_hist lat_hist;
+
 	bool is_on;
 };
 
 #if IS_ENABLED(CONFIG_VIDEO_ROCKCHIP_ISP_VERSION_V39)
 extern struct platform_driver rkisp_sditf_drv;
 void rkisp_sditf_sof(struct rkisp_device *dev, u32 irq);
+void rkisp_sditf_show(struct rkisp_device *dev, struct seq_file *p);
 #else
 static inline void rkisp_sditf_sof(struct rkisp_device *dev, u32 irq) {}
+static inline void rkisp_sditf_show(struct rkisp_device *dev, struct seq_file *p) {}
 #endif
 
 #endif
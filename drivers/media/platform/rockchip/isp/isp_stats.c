@@ -368,6 +368,14 @@ void rkisp_stats_isr(struct rkisp_isp_stats_vdev *stats_vdev,
 	stats_vdev->ops->isr_hdl(stats_vdev, isp_ris, isp3a_ris);
 }
 
+int rkisp_stats_get_ring_info(struct rkisp_isp_stats_vdev *stats_vdev,
+			      struct rkisp_stats_ring_info *info)
+{
+	if (!stats_vdev->ops->get_ring_info)
+		return -EINVAL;
+	return stats_vdev->ops->get_ring_info(stats_vdev, info);
+}
+
 int rkisp_register_stats_vdev(struct rkisp_isp_stats_vdev *stats_vdev,
 			      struct v4l2_device *v4l2_dev,
 			      struct rkisp_device *dev)
@@ -35,6 +35,8 @@ struct rkisp_isp_stats_ops {
 			  struct rkisp_isp_readout_work *meas_work);
 	void (*rdbk_enable)(struct rkisp_isp_stats_vdev *stats_vdev, bool en);
 	void (*get_stat_size)(struct rkisp_isp_stats_vdev *stats_vdev, unsigned int sizes[]);
+	int (*get_ring_info)(struct rkisp_isp_stats_vdev *stats_vdev,
+			     struct rkisp_stats_ring_info *info);
 };
 
 /*
@@ -43,6 +45,11 @@ struct rkisp_isp_stats_ops {
  * @irq_lock: buffer queue lock
  * @stat: stats buffer list
  * @readout_wq: workqueue for statistics information read
+ * @ring_buf: stats ring written by hw directly, mmap by user via dma fd
+ * @ring_num: slot num of stats ring, 0 if disable
+ * @ring_cur: slot of current frame, -1 if none
+ * @ring_nxt: slot of next frame, -1 if none
+ * @ring_wr: last slot config to hw
  */
 struct rkisp_isp_stats_vdev {
 	struct rkisp_vdev_node vnode;
@@ -75,6 +82,14 @@ struct rkisp_isp_stats_vdev {
 	struct rkisp_buffer *cur_buf;
 	struct rkisp_buffer *nxt_buf;
 
+	struct rkisp_dummy_buffer ring_buf;
+	u32 ring_num;
+	u32 ring_head_size;
+	u32 ring_slot_size;
+	int ring_cur;
+	int ring_nxt;
+	int ring_wr;
+
 	bool af_meas_done_next;
 	bool ae_meas_done_next;
 };
@@ -87,6 +102,9 @@ void rkisp_stats_next_ddr_config(struct rkisp_isp_stats_vdev *stats_vdev);
 void rkisp_stats_isr(struct rkisp_isp_stats_vdev *stats_vdev,
 		     u32 isp_ris, u32 isp3a_ris);
 
+int rkisp_stats_get_ring_info(struct rkisp_isp_stats_vdev *stats_vdev,
+			      struct rkisp_stats_ring_info *info);
+
 int rkisp_register_stats_vdev(struct rkisp_isp_stats_vdev *stats_vdev,
 			       struct v4l2_device *v4l2_dev,
 			       struct rkisp_device *dev);
@@ -422,6 +422,80 @@ static struct rkisp_stats_ops_v32 __maybe_unused stats_ddr_ops_v32 = {
 	.get_vsm_stats = rkisp_stats_get_vsm_stats,
 };
 
+static void *
+rkisp_stats_ring_slot(struct rkisp_isp_stats_vdev *stats_vdev, int idx)
+{
+	return stats_vdev->ring_buf.vaddr + stats_vdev->ring_head_size +
+	       idx * stats_vdev->ring_slot_size;
+}
+
+static void
+rkisp_stats_ring_alloc(struct rkisp_isp_stats_vdev *stats_vdev, u32 size)
+{
+	struct rkisp_device *dev = stats_vdev->dev;
+	struct rkisp_dummy_buffer *buf = &stats_vdev->ring_buf;
+	struct rkisp_stats_ring_head *head;
+	u32 num = min_t(u32, rkisp_stats_ring, RKISP_STATS_RING_MAX);
+
+	stats_vdev->ring_num = 0;
+	stats_vdev->ring_cur = -1;
+	stats_vdev->ring_nxt = -1;
+	rkisp_free_buffer(dev, buf);
+	/* one slot for user, one for hw writing and one for margin */
+	if (num < 3 || !stats_vdev->rd_stats_from_ddr)
+		return;
+
+	stats_vdev->ring_head_size = ALIGN(sizeof(*head), 256);
+	buf->is_need_vaddr = true;
+	buf->size = stats_vdev->ring_head_size + size * num;
+	if (rkisp_alloc_buffer(dev, buf)) {
+		v4l2_warn(&dev->v4l2_dev, "stats ring alloc buf fail\n");
+		return;
+	}
+	memset(buf->vaddr, 0, buf->size);
+	head = buf->vaddr;
+	head->slot_num = num;
+	head->slot_size = size;
+	rkisp_prepare_buffer(dev, buf);
+	stats_vdev->ring_slot_size = size;
+	stats_vdev->ring_wr = num - 1;
+	stats_vdev->ring_num = num;
+}
+
+static void
+rkisp_stats_ring_publish(struct rkisp_isp_stats_vdev *stats_vdev, int idx,
+			 u32 frame_id, u64 timestamp)
+{
+	struct rkisp_stats_ring_head *head = stats_vdev->ring_buf.vaddr;
+
+	WRITE_ONCE(head->seq, head->seq + 1);
+	smp_wmb();
+	head->frame_id[idx] = frame_id;
+	head->timestamp[idx] = timestamp;
+	head->wr_idx = idx;
+	smp_wmb();
+	WRITE_ONCE(head->seq, head->seq + 1);
+	rkisp_prepare_buffer(stats_vdev->dev, &stats_vdev->ring_buf);
+}
+
+static int
+rkisp_stats_get_ring_info_v32(struct rkisp_isp_stats_vdev *stats_vdev,
+			      struct rkisp_stats_ring_info *info)
+{
+	struct rkisp_dummy_buffer *buf = &stats_vdev->ring_buf;
+
+	if (!stats_vdev->ring_num)
+		return -EINVAL;
+	if (rkisp_buf_get_fd(stats_vdev->dev, buf, true) < 0)
+		return -ENOMEM;
+	info->buf_fd = buf->dma_fd;
+	info->buf_size = buf->size;
+	info->head_size = stats_vdev->ring_head_size;
+	info->slot_num = stats_vdev->ring_num;
+	info->slot_size = stats_vdev->ring_slot_size;
+	return 0;
+}
+
 static void
 rkisp_stats_update_buf(struct rkisp_isp_stats_vdev *stats_vdev)
 {
@@ -432,6 +506,21 @@ rkisp_stats_update_buf(struct rkisp_isp_stats_vdev *stats_vdev)
 	u32 val = 0;
 	int i;
 
+	/* hw write to ring, vb2 buffer copy from it */
+	if (stats_vdev->ring_num) {
+		if (stats_vdev->ring_nxt < 0) {
+			stats_vdev->ring_wr = (stats_vdev->ring_wr + 1) % stats_vdev->ring_num;
+			stats_vdev->ring_nxt = stats_vdev->ring_wr;
+		}
+		val = stats_vdev->ring_buf.dma_addr + stats_vdev->ring_head_size +
+		      stats_vdev->ring_nxt * stats_vdev->ring_slot_size;
+		if (!dev->hw_dev->is_single) {
+			stats_vdev->ring_cur = stats_vdev->ring_nxt;
+			stats_vdev->ring_nxt = -1;
+		}
+		goto out;
+	}
+
 	spin_lock_irqsave(&stats_vdev->rd_lock, flags);
 	if (!stats_vdev->nxt_buf && !list_empty(&stats_vdev->stat)) {
 		buf = list_first_entry(&stats_vdev->stat,
@@ -455,6 +544,7 @@ rkisp_stats_update_buf(struct rkisp_isp_stats_vdev *stats_vdev)
 		val = stats_vdev->stats_buf[0].dma_addr;
 	}
 
+out:
 	for (i = 0; i < dev->unite_div && val; i++)
 		rkisp_idx_write(dev, ISP3X_MI_3A_WR_BASE,
 				val + i * size / dev->unite_div, i, false);
@@ -556,11 +646,23 @@ rkisp_stats_send_meas(struct rkisp_isp_stats_vdev *stats_vdev,
 		(struct rkisp_stats_ops_v32 *)stats_vdev->priv_ops;
 	u32 size = stats_vdev->vdev_fmt.fmt.meta.buffersize;
 	u32 cur_frame_id = meas_work->frame_id;
+	void *dummy_vaddr = stats_vdev->stats_buf[0].vaddr;
+	int ring_idx = -1;
 	bool is_dummy = false;
 	unsigned long flags;
 
 	if (!stats_vdev->rdbk_drop) {
-		if (!cur_buf && stats_vdev->stats_buf[0].mem_priv) {
+		if (stats_vdev->ring_num && stats_vdev->ring_cur >= 0) {
+			ring_idx = stats_vdev->ring_cur;
+			rkisp_finish_buffer(stats_vdev->dev, &stats_vdev->ring_buf);
+			dummy_vaddr = rkisp_stats_ring_slot(stats_vdev, ring_idx);
+			cur_stat_buf = dummy_vaddr;
+			if (hw->unite != ISP_UNITE_ONE || dev->unite_index == ISP_UNITE_LEFT)
+				cur_stat_buf->meas_type = 0;
+			cur_stat_buf->frame_id = cur_frame_id;
+			cur_stat_buf->params_id = params_vdev->cur_frame_id;
+			is_dummy = true;
+		} else if (!cur_buf && stats_vdev->stats_buf[0].mem_priv) {
 			rkisp_finish_buffer(stats_vdev->dev, &stats_vdev->stats_buf[0]);
 			cur_stat_buf = stats_vdev->stats_buf[0].vaddr;
 			cur_stat_buf->frame_id = cur_frame_id;
@@ -579,6 +681,8 @@ rkisp_stats_send_meas(struct rkisp_isp_stats_vdev *stats_vdev,
 				is_dummy = false;
 			} else if (cur_stat_buf) {
 				cur_stat_buf = (void *)cur_stat_buf + size / 2;
+				if (ring_idx >= 0)
+					cur_stat_buf->meas_type = 0;
 				cur_stat_buf->frame_id = cur_frame_id;
 				cur_stat_buf->params_id = params_vdev->cur_frame_id;
 			}
@@ -591,6 +695,8 @@ rkisp_stats_send_meas(struct rkisp_isp_stats_vdev *stats_vdev,
 				stats_vdev->cur_buf = stats_vdev->nxt_buf;
 				stats_vdev->nxt_buf = NULL;
 			}
+			stats_vdev->ring_cur = stats_vdev->ring_nxt;
+			stats_vdev->ring_nxt = -1;
 			rkisp_stats_update_buf(stats_vdev);
 		}
 	} else {
@@ -638,6 +744,10 @@ rkisp_stats_send_meas(struct rkisp_isp_stats_vdev *stats_vdev,
 	if (cur_stat_buf && stats_vdev->dev->is_first_double)
 		cur_stat_buf->meas_type |= ISP32_STAT_RTT_FST;
 
+	if (is_dummy && ring_idx >= 0)
+		rkisp_stats_ring_publish(stats_vdev, ring_idx, cur_frame_id,
+					 meas_work->timestamp);
+
 	if (is_dummy) {
 		spin_lock_irqsave(&stats_vdev->rd_lock, flags);
 		if (!list_empty(&stats_vdev->stat)) {
@@ -646,7 +756,7 @@ rkisp_stats_send_meas(struct rkisp_isp_stats_vdev *stats_vdev,
 		}
 		spin_unlock_irqrestore(&stats_vdev->rd_lock, flags);
 		if (cur_buf) {
-			memcpy(cur_buf->vaddr[0], stats_vdev->stats_buf[0].vaddr, size);
+			memcpy(cur_buf->vaddr[0], dummy_vaddr, size);
 			cur_stat_buf = cur_buf->vaddr[0];
 		}
 	}
@@ -1092,6 +1202,7 @@ static struct rkisp_isp_stats_ops rkisp_isp_stats_ops_tbl = {
 	.send_meas = rkisp_stats_send_meas_v32,
 	.rdbk_enable = rkisp_stats_rdbk_enable_v32,
 	.get_stat_size = rkisp_get_stat_size_v32,
+	.get_ring_info = rkisp_stats_get_ring_info_v32,
 };
 
 void rkisp_stats_first_ddr_config_v32(struct rkisp_isp_stats_vdev *stats_vdev)
@@ -1109,6 +1220,7 @@ void rkisp_stats_first_ddr_config_v32(struct rkisp_isp_stats_vdev *stats_vdev)
 		v4l2_warn(&dev->v4l2_dev, "stats alloc buf fail\n");
 	else
 		memset(stats_vdev->stats_buf[0].vaddr, 0, size);
+	rkisp_stats_ring_alloc(stats_vdev, size);
 	rkisp_stats_update_buf(stats_vdev);
 	rkisp_unite_write(dev, ISP3X_MI_DBR_WR_SIZE, size / div, false);
 	rkisp_unite_set_bits(dev, ISP3X_SWS_CFG, 0, ISP3X_3A_DDR_WRITE_EN, false);
@@ -1116,6 +1228,10 @@ void rkisp_stats_first_ddr_config_v32(struct rkisp_isp_stats_vdev *stats_vdev)
 		stats_vdev->cur_buf = stats_vdev->nxt_buf;
 		stats_vdev->nxt_buf = NULL;
 	}
+	if (stats_vdev->ring_nxt >= 0) {
+		stats_vdev->ring_cur = stats_vdev->ring_nxt;
+		stats_vdev->ring_nxt = -1;
+	}
 }
 
 void rkisp_stats_next_ddr_config_v32(struct rkisp_isp_stats_vdev *stats_vdev)
@@ -1139,6 +1255,9 @@ void rkisp_init_stats_vdev_v32(struct rkisp_isp_stats_vdev *stats_vdev)
 		stats_vdev->rd_stats_from_ddr = false;
 	}
 	stats_vdev->ops = &rkisp_isp_stats_ops_tbl;
+	stats_vdev->ring_num = 0;
+	stats_vdev->ring_cur = -1;
+	stats_vdev->ring_nxt = -1;
 }
 
 void rkisp_uninit_stats_vdev_v32(struct rkisp_isp_stats_vdev *stats_vdev)
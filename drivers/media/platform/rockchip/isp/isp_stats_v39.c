@@ -105,6 +105,27 @@ rkisp_stats_get_bay3d_stats(struct rkisp_isp_stats_vdev *stats_vdev,
 	return 0;
 }
 
+static void
+rkisp_stats_get_pdaf_stats(struct rkisp_isp_stats_vdev *stats_vdev,
+			   struct rkisp39_stat_buffer *pbuf, u32 frame_id)
+{
+	struct rkisp_pdaf_vdev *pdaf_vdev = &stats_vdev->dev->pdaf_vdev;
+	struct isp39_pdaf_stat *pdaf = &pbuf->pdaf;
+	u32 index;
+
+	pdaf->frame_id = -1;
+	pdaf->buf_index = -1;
+	if (!rkisp_pdaf_get_done(stats_vdev->dev, frame_id, &index))
+		return;
+	pdaf->frame_id = frame_id;
+	pdaf->buf_index = index;
+	pdaf->width = pdaf_vdev->fmt.width;
+	pdaf->height = pdaf_vdev->fmt.height;
+	pdaf->bytesperline = pdaf_vdev->fmt.plane_fmt[0].bytesperline;
+	pdaf->sizeimage = pdaf_vdev->fmt.plane_fmt[0].sizeimage;
+	pbuf->meas_type |= ISP39_STAT_PDAF;
+}
+
 static int
 rkisp_stats_update_buf(struct rkisp_isp_stats_vdev *stats_vdev)
 {
@@ -327,6 +348,7 @@ rkisp_stats_send_meas_v39(struct rkisp_isp_stats_vdev *stats_vdev,
 		cur_stat_buf->stat.info2ddr.buf_fd = -1;
 		cur_stat_buf->stat.info2ddr.owner = 0;
 		rkisp_stats_info2ddr(stats_vdev, cur_stat_buf);
+		rkisp_stats_get_pdaf_stats(stats_vdev, cur_stat_buf, cur_frame_id);
 
 		vb2_set_plane_payload(&cur_buf->vb.vb2_buf, 0, size);
 		cur_buf->vb.sequence = cur_frame_id;
@@ -688,6 +688,16 @@ static void isp32_show(struct rkisp_device *dev, struct seq_file *p)
 		seq_printf(p, "%-10s %s warp:%d\n", "ISP2ENC",
 			   dev->cap_dev.wrap_line ? "online" : "offline",
 			   dev->cap_dev.wrap_line);
+		if (dev->cap_dev.wrap_line) {
+			struct rkisp_wrap_stat *stat = &dev->cap_dev.wrap_stat;
+
+			seq_printf(p, "%-10s frame:%d slice_line:%d line:%d miss:%d\n"
+				   "\t   sof2slice:%dus(max:%d) sof2end:%dus(max:%d)\n",
+				   "WRAP", stat->frame_id, stat->slice_line,
+				   stat->line_cnt, stat->slice_miss,
+				   stat->slice_delay, stat->slice_delay_max,
+				   stat->frame_delay, stat->frame_delay_max);
+		}
 		tmp = rkisp_read(dev, ISP32_MI_WR_VFLIP_CTRL, false);
 		val = rkisp_read(dev, ISP3X_ISP_CTRL0, false);
 		seq_printf(p, "%-10s mirror:%d flip(mp:%d sp:%d bp:%d mpds:%d bpds:%d)\n",
@@ -742,6 +752,10 @@ static void isp32_show(struct rkisp_device *dev, struct seq_file *p)
 		   (val & 1) ? "ON" : "OFF", val, tmp, !!(val & BIT(1)), !!(val & BIT(13)),
 		   (tmp & BIT(4)) ? "lo4x4" : ((tmp & BIT(3)) ? "lo4x8" : "lo8x8"),
 		   priv->is_sram ? "sram" : "ddr");
+	if (val & 1)
+		seq_printf(p, "\t   ddr:%uKB/frame saved bwsaving:%uKB sram:%uKB\n",
+			   priv->bay3d_bw_ddr / 1024, priv->bay3d_bw_bwsaving / 1024,
+			   priv->bay3d_bw_sram / 1024);
 	val = rkisp_read(dev, ISP3X_YNR_GLOBAL_CTRL, false);
 	seq_printf(p, "%-10s %s(0x%x)\n", "YNR", (val & 1) ? "ON" : "OFF", val);
 	val = rkisp_read(dev, ISP3X_CNR_CTRL, false);
@@ -1017,6 +1031,11 @@ static int isp_show(struct seq_file *p, void *v)
 		seq_printf(p, "\t   hw link:%d idle:%d vir(mode:%d index:%d)\n",
 			   dev->hw_dev->dev_link_num, dev->hw_dev->is_idle,
 			   dev->multi_mode, dev->multi_index);
+		seq_printf(p, "\t   rd bytes(rd0:%llu rd1:%llu rd2:%llu) once:%d saved:%u\n",
+			   dev->rdbk_stat.rd_bytes[HDR_DMA0],
+			   dev->rdbk_stat.rd_bytes[HDR_DMA1],
+			   dev->rdbk_stat.rd_bytes[HDR_DMA2],
+			   rkisp_rdbk_once, dev->rdbk_stat.rd_saved);
 	} else {
 		seq_printf(p, "%-10s frame:%d state:%s time:%dms v-blank:%dus\n",
 			   "Isp online",
@@ -1276,12 +1295,70 @@ static const struct proc_ops ops = {
 	.proc_write	= rkisp_proc_write,
 };
 
+static int isp_latency_show(struct seq_file *p, void *v)
+{
+	struct rkisp_device *dev = p->private;
+	struct rkisp_stream *stream;
+	u32 i;
+
+	for (i = 0; i < RKISP_MAX_STREAM; i++) {
+		stream = &dev->cap_dev.stream[i];
+		if (!stream->lat_hist.cnt)
+			continue;
+		rk_lat_hist_show(p, stream->vnode.vdev.name, &stream->lat_hist);
+		seq_printf(p, "\tmi bytes:%llu frameloss:%u\n",
+			   stream->mi_bytes, stream->dbg.frameloss);
+	}
+	if (dev->perf.isp_isr_hist.cnt) {
+		seq_printf(p, "%-16s nobuf:%u overflow:%u rdbk late:%u\n", "Drop",
+			   dev->perf.drop_nobuf, dev->perf.drop_overflow,
+			   dev->perf.drop_rdbk_late);
+		rk_lat_hist_show(p, "isp isr", &dev->perf.isp_isr_hist);
+		if (dev->perf.mi_isr_hist.cnt)
+			rk_lat_hist_show(p, "mi isr", &dev->perf.mi_isr_hist);
+		if (dev->perf.params_hist.cnt)
+			rk_lat_hist_show(p, "params apply", &dev->perf.params_hist);
+	}
+	if (dev->rdbk_stat.cnt) {
+		seq_printf(p, "%-16s cnt:%u fps:%u overrun:%u prio:%u target fps:%u\n",
+			   "Readback", dev->rdbk_stat.cnt, dev->rdbk_stat.fps,
+			   dev->rdbk_stat.overrun, rkisp_rdbk_prio[dev->dev_id],
+			   rkisp_rdbk_fps[dev->dev_id]);
+		rk_lat_hist_show(p, "rdbk queue", &dev->rdbk_stat.delay_hist);
+	}
+	if (dev->hw_dev->unite == ISP_UNITE_ONE &&
+	    dev->unite_stat.part_hist[ISP_UNITE_LEFT].cnt) {
+		static const char * const part[ISP_UNITE_MAX] = {
+			"unite left", "unite right", "unite left b", "unite right b"
+		};
+
+		seq_printf(p, "%-16s overlap:%u%s\n", "Unite",
+			   dev->unite_stat.overlap,
+			   rkisp_unite_overlap ? "" : " (off)");
+		for (i = 0; i < ISP_UNITE_MAX; i++) {
+			if (dev->unite_stat.part_hist[i].cnt)
+				rk_lat_hist_show(p, part[i], &dev->unite_stat.part_hist[i]);
+		}
+		if (dev->unite_stat.drain_hist.cnt)
+			rk_lat_hist_show(p, "unite mi drain", &dev->unite_stat.drain_hist);
+	}
+	if (dev->isp_ver == ISP_V39)
+		rkisp_sditf_show(dev, p);
+	return 0;
+}
+
 int rkisp_proc_init(struct rkisp_device *dev)
 {
+	char name[sizeof(dev->name) + 8];
+
 	memset(&dev->procfs, 0, sizeof(dev->procfs));
 	dev->procfs.procfs = proc_create_data(dev->name, 0, NULL, &ops, dev);
 	if (!dev->procfs.procfs)
 		return -EINVAL;
+	/* sof to frame done histogram, one per output stream */
+	snprintf(name, sizeof(name), "%s-latency", dev->name);
+	dev->procfs.lat_procfs = proc_create_single_data(name, 0444, NULL,
+							 isp_latency_show, dev);
 	init_waitqueue_head(&dev->procfs.fs_wait);
 	init_waitqueue_head(&dev->procfs.fe_wait);
 	return 0;
@@ -1289,6 +1366,8 @@ int rkisp_proc_init(struct rkisp_device *dev)
 
 void rkisp_proc_cleanup(struct rkisp_device *dev)
 {
+	proc_remove(dev->procfs.lat_procfs);
+	dev->procfs.lat_procfs = NULL;
 	if (dev->procfs.procfs)
 		remove_proc_entry(dev->name, NULL);
 	dev->procfs.procfs = NULL;
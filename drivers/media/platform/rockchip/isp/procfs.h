@@ -14,6 +14,7 @@ enum {
 
 struct rkisp_procfs {
 	struct proc_dir_entry *procfs;
+	struct proc_dir_entry *lat_procfs;
 	wait_queue_head_t fs_wait;
 	wait_queue_head_t fe_wait;
 	u32 mode;
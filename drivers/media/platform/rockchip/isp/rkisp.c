@@ -45,8 +45,11 @@
 #include <linux/rk-preisp.h>
 #include <linux/rk-isp21-config.h>
 #include <linux/iommu.h>
+#include <linux/soc/rockchip/rockchip_thunderboot_mem.h>
 #include <media/v4l2-event.h>
 #include <media/media-entity.h>
+#include <soc/rockchip/rockchip_irq_align.h>
+#include <soc/rockchip/rockchip_performance.h>
 
 #include "common.h"
 #include "isp_external.h"
@@ -582,6 +585,26 @@ static void rkisp_multi_overflow_hdl(struct rkisp_device *dev, bool on)
  * for hdr read back mode, rawrd read back data
  * this will update rawrd base addr to shadow.
  */
+/* raw bytes the dma reads from ddr for one trigger, per exposure */
+static void rkisp_rdbk_bytes_update(struct rkisp_device *dev, u32 times)
+{
+	struct rkisp_rdbk_stat *stat = &dev->rdbk_stat;
+	struct rkisp_stream *stream;
+	u64 size;
+	u32 i;
+
+	for (i = RKISP_STREAM_RAWRD0; i <= RKISP_STREAM_RAWRD2; i++) {
+		if ((i == RKISP_STREAM_RAWRD0 && dev->rd_mode == HDR_RDBK_FRAME1) ||
+		    (i == RKISP_STREAM_RAWRD1 && dev->rd_mode != HDR_RDBK_FRAME3))
+			continue;
+		stream = &dev->dmarx_dev.stream[i];
+		size = (u64)stream->out_fmt.plane_fmt[0].bytesperline *
+		       stream->out_fmt.height * times;
+		/* a unite part reads its share of the frame */
+		stat->rd_bytes[i - RKISP_STREAM_RAWRD0] += div_u64(size, dev->unite_div);
+	}
+}
+
 void rkisp_trigger_read_back(struct rkisp_device *dev, u8 dma2frm, u32 mode, bool is_try)
 {
 	struct rkisp_isp_params_vdev *params_vdev = &dev->params_vdev;
@@ -685,7 +708,11 @@ void rkisp_trigger_read_back(struct rkisp_device *dev, u8 dma2frm, u32 mode, boo
 		if (dev->isp_ver == ISP_V20 &&
 		    (rkisp_read(dev, ISP_DHAZ_CTRL, false) & ISP_DHAZ_ENMUX ||
 		     rkisp_read(dev, ISP_HDRTMO_CTRL, false) & ISP_HDRTMO_EN)) {
-			dma2frm += (dma2frm ? 0 : 1);
+			/* dhaz and tmo use the stats of the last sensor for once */
+			if (!dma2frm && rkisp_rdbk_once)
+				dev->rdbk_stat.rd_saved++;
+			else
+				dma2frm += (dma2frm ? 0 : 1);
 		} else if (dev->isp_ver == ISP_V21) {
 			val = rkisp_read(dev, MI_WR_CTRL2, false);
 			rkisp_set_bits(dev, MI_WR_CTRL2, 0, val, true);
@@ -730,6 +757,8 @@ void rkisp_trigger_read_back(struct rkisp_device *dev, u8 dma2frm, u32 mode, boo
 		params_vdev->rdbk_times = dma2frm + 1;
 
 run_next:
+	if (hw->unite == ISP_UNITE_ONE)
+		dev->unite_stat.part_ts = ktime_get_ns();
 	if (!dev->sw_rd_cnt)
 		rkisp_rockit_frame_start(dev);
 	rkisp_params_cfgsram(params_vdev, true);
@@ -889,8 +918,10 @@ void rkisp_trigger_read_back(struct rkisp_device *dev, u8 dma2frm, u32 mode, boo
 	v4l2_dbg(2, rkisp_debug, &dev->v4l2_dev,
 		 "readback frame:%d time:%d 0x%x try:%d\n",
 		 cur_frame_id, dma2frm + 1, val, is_try);
-	if (!hw->is_shutdown)
+	if (!hw->is_shutdown) {
 		rkisp_unite_write(dev, CSI2RX_CTRL0, val, true);
+		rkisp_rdbk_bytes_update(dev, dev->isp_ver == ISP_V20 ? dma2frm + 1 : 1);
+	}
 }
 
 static void rkisp_fast_switch_rx_buf(struct rkisp_device *dev, bool is_current)
@@ -929,6 +960,61 @@ static void rkisp_fast_switch_rx_buf(struct rkisp_device *dev, bool is_current)
 	}
 }
 
+static void rkisp_rdbk_stat_update(struct rkisp_device *dev,
+				   struct isp2x_csi_trigger *t)
+{
+	struct rkisp_rdbk_stat *stat = &dev->rdbk_stat;
+	u32 fps = rkisp_rdbk_fps[dev->dev_id];
+	u64 ns = rkisp_time_get_ns(dev);
+	u64 delay = ns > t->sof_timestamp ? ns - t->sof_timestamp : 0;
+
+	stat->cnt++;
+	rk_lat_hist_add(&stat->delay_hist, delay);
+	if (fps && delay > div_u64(NSEC_PER_SEC, fps))
+		stat->overrun++;
+
+	if (!stat->fps_ts)
+		stat->fps_ts = ns;
+	stat->fps_cnt++;
+	if (ns - stat->fps_ts >= NSEC_PER_SEC) {
+		stat->fps = div64_u64((u64)stat->fps_cnt * NSEC_PER_SEC,
+				      ns - stat->fps_ts);
+		stat->fps_cnt = 0;
+		stat->fps_ts = ns;
+	}
+}
+
+/*
+ * pick the dev to read back for rdbk_sched=1: highest rdbk_prio first,
+ * then earliest deadline of the oldest queued frame, that is its sof
+ * plus one period of rdbk_fps.
+ */
+static int rkisp_rdbk_sched_pick(struct rkisp_hw_dev *hw, int *len)
+{
+	struct isp2x_csi_trigger t;
+	u64 deadline, best_deadline = 0;
+	u32 prio, best_prio = 0;
+	int i, id = -1;
+
+	for (i = 0; i < hw->dev_num; i++) {
+		if (!len[i])
+			continue;
+		if (rkisp_rdbk_trigger_event(hw->isp[i], T_CMD_PEEK, &t) < 0)
+			continue;
+		deadline = t.sof_timestamp;
+		if (rkisp_rdbk_fps[i])
+			deadline += div_u64(NSEC_PER_SEC, rkisp_rdbk_fps[i]);
+		prio = rkisp_rdbk_prio[i];
+		if (id < 0 || prio > best_prio ||
+		    (prio == best_prio && deadline < best_deadline)) {
+			id = i;
+			best_prio = prio;
+			best_deadline = deadline;
+		}
+	}
+	return id;
+}
+
 static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 {
 	struct rkisp_hw_dev *hw = dev->hw_dev;
@@ -985,6 +1071,11 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 			id = i;
 		}
 	}
+	if (max && rkisp_rdbk_sched && hw->dev_num > 1) {
+		i = rkisp_rdbk_sched_pick(hw, len);
+		if (i >= 0)
+			id = i;
+	}
 
 	/* wait 2 frame to start isp for fast */
 	if (dev->is_rtt_first && max == 1 && !atomic_read(&dev->isp_sdev.frm_sync_seq))
@@ -995,11 +1086,15 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 		v4l2_dbg(2, rkisp_debug, &isp->v4l2_dev,
 			 "trigger fifo len:%d\n", max);
 		rkisp_rdbk_trigger_event(isp, T_CMD_DEQUEUE, &t);
+		rkisp_rdbk_stat_update(isp, &t);
 		isp->dmarx_dev.pre_frame = isp->dmarx_dev.cur_frame;
 		if (t.frame_id > isp->dmarx_dev.pre_frame.id &&
-		    t.frame_id - isp->dmarx_dev.pre_frame.id > 1)
+		    t.frame_id - isp->dmarx_dev.pre_frame.id > 1) {
 			isp->isp_sdev.dbg.frameloss +=
 				t.frame_id - isp->dmarx_dev.pre_frame.id + 1;
+			isp->perf.drop_rdbk_late +=
+				t.frame_id - isp->dmarx_dev.pre_frame.id - 1;
+		}
 		isp->dmarx_dev.cur_frame.id = t.frame_id;
 		isp->dmarx_dev.cur_frame.sof_timestamp = t.sof_timestamp;
 		isp->dmarx_dev.cur_frame.timestamp = t.frame_timestamp;
@@ -1013,15 +1108,21 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 		isp->sw_rd_cnt = 0;
 		isp->is_frame_double = false;
 		isp->unite_index = ISP_UNITE_LEFT;
+		isp->irq_ends_prev = 0;
 		if (hw->is_multi_overflow) {
 			/* frame double for multi camera resolution out of hardware limit
 			 * first for HW save this camera information, and second to output image
 			 */
-			if ((hw->unite == ISP_UNITE_ONE ||
-			    (hw->pre_dev_id != -1 && hw->pre_dev_id != id))) {
-				isp->is_frame_double = true;
-				isp->sw_rd_cnt = 1;
-				times = 0;
+			if (hw->unite == ISP_UNITE_ONE ||
+			    (hw->pre_dev_id != -1 && hw->pre_dev_id != id)) {
+				if (hw->unite != ISP_UNITE_ONE && rkisp_rdbk_once) {
+					/* output at the first read, with the state of the last sensor */
+					isp->rdbk_stat.rd_saved++;
+				} else {
+					isp->is_frame_double = true;
+					isp->sw_rd_cnt = 1;
+					times = 0;
+				}
 			}
 			/* resolution out of hardware limit
 			 * frame is vertically divided into left and right
@@ -1083,6 +1184,12 @@ int rkisp_rdbk_trigger_event(struct rkisp_device *dev, u32 cmd, void *arg)
 		val = kfifo_len(fifo) / sizeof(struct isp2x_csi_trigger);
 		*(u32 *)arg = val;
 		break;
+	case T_CMD_PEEK:
+		if (!kfifo_is_empty(fifo))
+			ret = kfifo_out_peek(fifo, arg, sizeof(struct isp2x_csi_trigger));
+		if (!ret)
+			ret = -EINVAL;
+		break;
 	default:
 		break;
 	}
@@ -1093,7 +1200,7 @@ int rkisp_rdbk_trigger_event(struct rkisp_device *dev, u32 cmd, void *arg)
 	return ret;
 }
 
-static void rkisp_rdbk_work(struct work_struct *work)
+static void rkisp_rdbk_work(struct kthread_work *work)
 {
 	struct rkisp_device *dev = container_of(work, struct rkisp_device, rdbk_work);
 
@@ -1101,6 +1208,43 @@ static void rkisp_rdbk_work(struct work_struct *work)
 	rkisp_rdbk_trigger_event(dev, T_CMD_END, NULL);
 }
 
+/*
+ * unite one mode: the next read back is a new part of the same frame, so
+ * it can start at isp frame end while the mi write of this part drains.
+ */
+static bool rkisp_unite_can_overlap(struct rkisp_device *dev)
+{
+	struct rkisp_hw_dev *hw = dev->hw_dev;
+
+	if (!rkisp_unite_overlap || hw->unite != ISP_UNITE_ONE ||
+	    !dev->sw_rd_cnt || dev->irq_ends_prev)
+		return false;
+	/* see rkisp_rdbk_trigger_handle, odd count left is a new part */
+	if (hw->is_multi_overflow)
+		return (dev->sw_rd_cnt - 1) & 0x1;
+	return hw->is_frm_buf;
+}
+
+static void rkisp_unite_frame_end(struct rkisp_device *dev)
+{
+	struct rkisp_unite_stat *stat = &dev->unite_stat;
+	u32 mi = ISP_FRAME_MP | ISP_FRAME_SP | ISP_FRAME_BP;
+	u32 pending = dev->irq_ends_mask & ~dev->irq_ends;
+	u64 ns = ktime_get_ns();
+
+	if (stat->part_ts)
+		rk_lat_hist_add(&stat->part_hist[dev->unite_index], ns - stat->part_ts);
+	stat->part_ts = 0;
+
+	if (!pending || (pending & ~mi) || !rkisp_unite_can_overlap(dev))
+		return;
+	/* the mi ends of this part are accounted to irq_ends_prev */
+	dev->irq_ends_prev = pending;
+	dev->irq_ends |= pending;
+	stat->end_ts = ns;
+	stat->overlap++;
+}
+
 void rkisp_check_idle(struct rkisp_device *dev, u32 irq)
 {
 	unsigned long lock_flags = 0;
@@ -1110,7 +1254,17 @@ void rkisp_check_idle(struct rkisp_device *dev, u32 irq)
 		return;
 
 	spin_lock_irqsave(&dev->hw_dev->rdbk_lock, lock_flags);
+	if (irq & dev->irq_ends_prev) {
+		dev->irq_ends_prev &= ~irq;
+		if (!dev->irq_ends_prev)
+			rk_lat_hist_add(&dev->unite_stat.drain_hist,
+					ktime_get_ns() - dev->unite_stat.end_ts);
+		spin_unlock_irqrestore(&dev->hw_dev->rdbk_lock, lock_flags);
+		return;
+	}
 	dev->irq_ends |= (irq & dev->irq_ends_mask);
+	if (irq == ISP_FRAME_END && dev->hw_dev->unite == ISP_UNITE_ONE)
+		rkisp_unite_frame_end(dev);
 	v4l2_dbg(3, rkisp_debug, &dev->v4l2_dev,
 		 "%s irq:0x%x ends:0x%x mask:0x%x\n",
 		 __func__, irq, dev->irq_ends, dev->irq_ends_mask);
@@ -1170,7 +1324,7 @@ void rkisp_check_idle(struct rkisp_device *dev, u32 irq)
 end:
 	dev->irq_ends = 0;
 	if (dev->hw_dev->is_dvfs)
-		schedule_work(&dev->rdbk_work);
+		kthread_queue_work(dev->rdbk_worker, &dev->rdbk_work);
 	else
 		rkisp_rdbk_trigger_event(dev, T_CMD_END, NULL);
 	if (dev->isp_state == ISP_STOP)
@@ -1444,70 +1598,90 @@ static void rkisp_config_color_space(struct rkisp_device *dev)
 				  CIF_ISP_CTRL_ISP_CSM_C_FULL_ENA), false);
 }
 
-static void rkisp_config_cmsk_single(struct rkisp_device *dev,
-				     struct rkisp_cmsk_cfg *cfg)
+/* register of cmsk table entry n, see struct rkisp_cmsk_regs */
+static u32 rkisp_cmsk_reg(u32 n)
 {
-	u32 i, val, ctrl = 0;
+	if (n < RKISP_CMSK_REG_YUV)
+		return ISP3X_CMSK_CTRL0 + n * 4;
+	n -= RKISP_CMSK_REG_YUV;
+	switch (n % 3) {
+	case 0:
+		return ISP3X_CMSK_YUV0 + n / 3 * 4;
+	case 1:
+		return ISP3X_CMSK_OFFS0 + n / 3 * 8;
+	default:
+		return ISP3X_CMSK_SIZE0 + n / 3 * 8;
+	}
+}
+
+static void rkisp_cmsk_set(struct rkisp_cmsk_regs *regs, int idx, u32 n, u32 val)
+{
+	regs->val[idx][n] = val;
+	regs->mask[idx] |= BIT_ULL(n);
+}
+
+static void rkisp_cmsk_set_path(struct rkisp_cmsk_regs *regs, int idx,
+				struct rkisp_cmsk_cfg *cfg, u32 *ctrl)
+{
+	static const u32 path_en[3] = {
+		ISP3X_SW_CMSK_EN_MP, ISP3X_SW_CMSK_EN_SP, ISP3X_SW_CMSK_EN_BP
+	};
+	u32 i;
+
+	/* ctrl1~3 window enable, ctrl4~6 window mode of mp sp bp */
+	for (i = 0; i < 3; i++) {
+		if (!cfg->win[i].win_en)
+			continue;
+		*ctrl |= path_en[i];
+		rkisp_cmsk_set(regs, idx, 1 + i, cfg->win[i].win_en);
+		rkisp_cmsk_set(regs, idx, 4 + i, cfg->win[i].mode);
+	}
+}
+
+static void rkisp_cmsk_set_win(struct rkisp_cmsk_regs *regs, int idx,
+			       struct rkisp_cmsk_win *win, u32 i)
+{
+	u32 n = RKISP_CMSK_REG_YUV + i * 3;
+
+	rkisp_cmsk_set(regs, idx, n, ISP3X_SW_CMSK_YUV(win->cover_color_y,
+						       win->cover_color_u,
+						       win->cover_color_v));
+	rkisp_cmsk_set(regs, idx, n + 1, ISP_PACK_2SHORT(win->h_offs, win->v_offs));
+	rkisp_cmsk_set(regs, idx, n + 2, ISP_PACK_2SHORT(win->h_size, win->v_size));
+}
+
+static void rkisp_cmsk_regs_single(struct rkisp_device *dev,
+				   struct rkisp_cmsk_cfg *cfg,
+				   struct rkisp_cmsk_regs *regs)
+{
+	u32 i, ctrl = 0;
 	u32 mp_en = cfg->win[0].win_en;
 	u32 sp_en = cfg->win[1].win_en;
 	u32 bp_en = cfg->win[2].win_en;
 	u32 win_max = (dev->isp_ver == ISP_V30) ?
 		RKISP_CMSK_WIN_MAX_V30 : RKISP_CMSK_WIN_MAX;
 
-	if (mp_en) {
-		ctrl |= ISP3X_SW_CMSK_EN_MP;
-		rkisp_write(dev, ISP3X_CMSK_CTRL1, mp_en, false);
-		val = cfg->win[0].mode;
-		rkisp_write(dev, ISP3X_CMSK_CTRL4, val, false);
-	}
-
-	if (sp_en) {
-		ctrl |= ISP3X_SW_CMSK_EN_SP;
-		rkisp_write(dev, ISP3X_CMSK_CTRL2, sp_en, false);
-		val = cfg->win[1].mode;
-		rkisp_write(dev, ISP3X_CMSK_CTRL5, val, false);
-	}
-
-	if (bp_en) {
-		ctrl |= ISP3X_SW_CMSK_EN_BP;
-		rkisp_write(dev, ISP3X_CMSK_CTRL3, bp_en, false);
-		val = cfg->win[2].mode;
-		rkisp_write(dev, ISP3X_CMSK_CTRL6, val, false);
-	}
+	rkisp_cmsk_set_path(regs, ISP_UNITE_LEFT, cfg, &ctrl);
 
 	for (i = 0; i < win_max; i++) {
 		if (!(mp_en & BIT(i)) && !(sp_en & BIT(i)) && !(bp_en & BIT(i)))
 			continue;
-
-		val = ISP3X_SW_CMSK_YUV(cfg->win[i].cover_color_y,
-					cfg->win[i].cover_color_u,
-					cfg->win[i].cover_color_v);
-		rkisp_write(dev, ISP3X_CMSK_YUV0 + i * 4, val, false);
-
-		val = ISP_PACK_2SHORT(cfg->win[i].h_offs, cfg->win[i].v_offs);
-		rkisp_write(dev, ISP3X_CMSK_OFFS0 + i * 8, val, false);
-
-		val = ISP_PACK_2SHORT(cfg->win[i].h_size, cfg->win[i].v_size);
-		rkisp_write(dev, ISP3X_CMSK_SIZE0 + i * 8, val, false);
+		rkisp_cmsk_set_win(regs, ISP_UNITE_LEFT, &cfg->win[i], i);
 	}
 
 	if (ctrl) {
-		val = ISP_PACK_2SHORT(dev->isp_sdev.out_crop.width,
-				      dev->isp_sdev.out_crop.height);
-		rkisp_write(dev, ISP3X_CMSK_PIC_SIZE, val, false);
+		rkisp_cmsk_set(regs, ISP_UNITE_LEFT, RKISP_CMSK_REG_PIC_SIZE,
+			       ISP_PACK_2SHORT(dev->isp_sdev.out_crop.width,
+					       dev->isp_sdev.out_crop.height));
 		ctrl |= ISP3X_SW_CMSK_EN | ISP3X_SW_CMSK_ORDER_MODE;
 		ctrl |= ISP3X_SW_CMSK_BLKSIZE(cfg->mosaic_block);
 	}
-	rkisp_write(dev, ISP3X_CMSK_CTRL0, ctrl, false);
-
-	val = rkisp_read(dev, ISP3X_CMSK_CTRL0, true);
-	if (dev->hw_dev->is_single &&
-	    ((val & ISP32_SW_CMSK_EN_PATH) != (val & ISP32_SW_CMSK_EN_PATH_SHD)))
-		rkisp_write(dev, ISP3X_CMSK_CTRL0, val | ISP3X_SW_CMSK_FORCE_UPD, true);
+	rkisp_cmsk_set(regs, ISP_UNITE_LEFT, 0, ctrl);
 }
 
-static void rkisp_config_cmsk_dual(struct rkisp_device *dev,
-				   struct rkisp_cmsk_cfg *cfg)
+static void rkisp_cmsk_regs_dual(struct rkisp_device *dev,
+				 struct rkisp_cmsk_cfg *cfg,
+				 struct rkisp_cmsk_regs *regs)
 {
 	struct rkisp_cmsk_cfg left = *cfg;
 	struct rkisp_cmsk_cfg right = *cfg;
@@ -1548,86 +1722,82 @@ static void rkisp_config_cmsk_dual(struct rkisp_device *dev,
 			right.win[i].h_offs -= right.win[i].h_size - val;
 		}
 
-		val = ISP3X_SW_CMSK_YUV(left.win[i].cover_color_y,
-					left.win[i].cover_color_u,
-					left.win[i].cover_color_v);
-		rkisp_unite_write(dev, ISP3X_CMSK_YUV0 + i * 4, val, false);
-
-		val = ISP_PACK_2SHORT(left.win[i].h_offs, left.win[i].v_offs);
-		rkisp_idx_write(dev, ISP3X_CMSK_OFFS0 + i * 8, val, ISP_UNITE_LEFT, false);
-		val = ISP_PACK_2SHORT(left.win[i].h_size, left.win[i].v_size);
-		rkisp_idx_write(dev, ISP3X_CMSK_SIZE0 + i * 8, val, ISP_UNITE_LEFT, false);
-
-		val = ISP_PACK_2SHORT(right.win[i].h_offs, right.win[i].v_offs);
-		rkisp_idx_write(dev, ISP3X_CMSK_OFFS0 + i * 8, val, ISP_UNITE_RIGHT, false);
-		val = ISP_PACK_2SHORT(right.win[i].h_size, right.win[i].v_size);
-		rkisp_idx_write(dev, ISP3X_CMSK_SIZE0 + i * 8, val, ISP_UNITE_RIGHT, false);
+		rkisp_cmsk_set_win(regs, ISP_UNITE_LEFT, &left.win[i], i);
+		rkisp_cmsk_set_win(regs, ISP_UNITE_RIGHT, &right.win[i], i);
 	}
 
 	w += RKMOUDLE_UNITE_EXTEND_PIXEL;
 	ctrl = 0;
-	if (left.win[0].win_en) {
-		ctrl |= ISP3X_SW_CMSK_EN_MP;
-		rkisp_write(dev, ISP3X_CMSK_CTRL1, left.win[0].win_en, false);
-		val = left.win[0].mode;
-		rkisp_write(dev, ISP3X_CMSK_CTRL4, val, false);
-	}
-	if (left.win[1].win_en) {
-		ctrl |= ISP3X_SW_CMSK_EN_SP;
-		rkisp_write(dev, ISP3X_CMSK_CTRL2, left.win[1].win_en, false);
-		val = left.win[1].mode;
-		rkisp_write(dev, ISP3X_CMSK_CTRL5, val, false);
-	}
-	if (left.win[2].win_en) {
-		ctrl |= ISP3X_SW_CMSK_EN_BP;
-		rkisp_write(dev, ISP3X_CMSK_CTRL3, left.win[2].win_en, false);
-		val = left.win[2].mode;
-		rkisp_write(dev, ISP3X_CMSK_CTRL6, val, false);
-	}
+	rkisp_cmsk_set_path(regs, ISP_UNITE_LEFT, &left, &ctrl);
 	if (ctrl) {
-		val = ISP_PACK_2SHORT(w, height);
-		rkisp_write(dev, ISP3X_CMSK_PIC_SIZE, val, false);
+		rkisp_cmsk_set(regs, ISP_UNITE_LEFT, RKISP_CMSK_REG_PIC_SIZE,
+			       ISP_PACK_2SHORT(w, height));
 		ctrl |= ISP3X_SW_CMSK_EN | ISP3X_SW_CMSK_ORDER_MODE;
 	}
-	rkisp_write(dev, ISP3X_CMSK_CTRL0, ctrl, false);
+	rkisp_cmsk_set(regs, ISP_UNITE_LEFT, 0, ctrl);
 
 	ctrl = 0;
-	if (right.win[0].win_en) {
-		ctrl |= ISP3X_SW_CMSK_EN_MP;
-		rkisp_idx_write(dev, ISP3X_CMSK_CTRL1, right.win[0].win_en, ISP_UNITE_RIGHT, false);
-		val = right.win[0].mode;
-		rkisp_idx_write(dev, ISP3X_CMSK_CTRL4, val, ISP_UNITE_RIGHT, false);
-	}
-	if (right.win[1].win_en) {
-		ctrl |= ISP3X_SW_CMSK_EN_SP;
-		rkisp_idx_write(dev, ISP3X_CMSK_CTRL2, right.win[1].win_en, ISP_UNITE_RIGHT, false);
-		val = right.win[1].mode;
-		rkisp_idx_write(dev, ISP3X_CMSK_CTRL5, val, ISP_UNITE_RIGHT, false);
-	}
-	if (right.win[2].win_en) {
-		ctrl |= ISP3X_SW_CMSK_EN_BP;
-		rkisp_idx_write(dev, ISP3X_CMSK_CTRL3, right.win[2].win_en, ISP_UNITE_RIGHT, false);
-		val = right.win[2].mode;
-		rkisp_idx_write(dev, ISP3X_CMSK_CTRL6, val, ISP_UNITE_RIGHT, false);
-	}
+	rkisp_cmsk_set_path(regs, ISP_UNITE_RIGHT, &right, &ctrl);
 	if (ctrl) {
-		val = ISP_PACK_2SHORT(w, height);
-		rkisp_idx_write(dev, ISP3X_CMSK_PIC_SIZE, val, ISP_UNITE_RIGHT, false);
+		rkisp_cmsk_set(regs, ISP_UNITE_RIGHT, RKISP_CMSK_REG_PIC_SIZE,
+			       ISP_PACK_2SHORT(w, height));
 		ctrl |= ISP3X_SW_CMSK_EN | ISP3X_SW_CMSK_ORDER_MODE;
 	}
-	rkisp_idx_write(dev, ISP3X_CMSK_CTRL0, ctrl, ISP_UNITE_RIGHT, false);
+	rkisp_cmsk_set(regs, ISP_UNITE_RIGHT, 0, ctrl);
+}
+
+/*
+ * registers of cmsk_cfg for the current output size, built at
+ * RKISP_CMD_SET_CMSK and at stream on so the frame end only writes them.
+ * call with cmsk_lock held.
+ */
+void rkisp_cmsk_regs_update(struct rkisp_device *dev)
+{
+	struct rkisp_cmsk_regs *regs = &dev->cmsk_regs;
+
+	memset(regs, 0, sizeof(*regs));
+	if (!dev->hw_dev->unite)
+		rkisp_cmsk_regs_single(dev, &dev->cmsk_cfg, regs);
+	else
+		rkisp_cmsk_regs_dual(dev, &dev->cmsk_cfg, regs);
+	dev->is_cmsk_upd = true;
+}
+
+/* write the entries that differ from the last written, ctrl0 at last */
+static void rkisp_cmsk_apply(struct rkisp_device *dev,
+			     struct rkisp_cmsk_regs *regs, int idx, bool is_last)
+{
+	u32 *last = dev->cmsk_last[idx];
+	u32 n, val;
+	bool is_upd = false;
+
+	for (n = RKISP_CMSK_REG_NUM; n-- > 0;) {
+		if (!(regs->mask[idx] & BIT_ULL(n)))
+			continue;
+		val = regs->val[idx][n];
+		if (dev->is_cmsk_last_valid && last[n] == val)
+			continue;
+		if (idx == ISP_UNITE_LEFT)
+			rkisp_write(dev, rkisp_cmsk_reg(n), val, false);
+		else
+			rkisp_idx_write(dev, rkisp_cmsk_reg(n), val, idx, false);
+		last[n] = val;
+		is_upd = true;
+	}
+	/* path enable change takes effect at frame end, or force it */
+	if (!is_upd || !is_last || !dev->hw_dev->is_single)
+		return;
 
-	val = rkisp_idx_read(dev, ISP3X_CMSK_CTRL0, ISP_UNITE_RIGHT, true);
-	if (dev->hw_dev->is_single &&
-	    ((val & ISP32_SW_CMSK_EN_PATH) != (val & ISP32_SW_CMSK_EN_PATH_SHD)))
+	val = rkisp_idx_read(dev, ISP3X_CMSK_CTRL0, idx, true);
+	if ((val & ISP32_SW_CMSK_EN_PATH) != (val & ISP32_SW_CMSK_EN_PATH_SHD))
 		rkisp_idx_write(dev, ISP3X_CMSK_CTRL0, val | ISP3X_SW_CMSK_FORCE_UPD,
-				ISP_UNITE_RIGHT, false);
+				idx, idx == ISP_UNITE_LEFT);
 }
 
 static void rkisp_config_cmsk(struct rkisp_device *dev)
 {
 	unsigned long lock_flags = 0;
-	struct rkisp_cmsk_cfg cfg;
+	struct rkisp_cmsk_regs regs;
 
 	if (dev->isp_ver != ISP_V30 && dev->isp_ver != ISP_V32)
 		return;
@@ -1638,13 +1808,13 @@ static void rkisp_config_cmsk(struct rkisp_device *dev)
 		return;
 	}
 	dev->is_cmsk_upd = false;
-	cfg = dev->cmsk_cfg;
+	regs = dev->cmsk_regs;
 	spin_unlock_irqrestore(&dev->cmsk_lock, lock_flags);
 
-	if (!dev->hw_dev->unite)
-		rkisp_config_cmsk_single(dev, &cfg);
-	else
-		rkisp_config_cmsk_dual(dev, &cfg);
+	rkisp_cmsk_apply(dev, &regs, ISP_UNITE_LEFT, !dev->hw_dev->unite);
+	if (dev->hw_dev->unite)
+		rkisp_cmsk_apply(dev, &regs, ISP_UNITE_RIGHT, true);
+	dev->is_cmsk_last_valid = true;
 }
 
 /*
@@ -1662,6 +1832,7 @@ static int rkisp_config_isp(struct rkisp_device *dev)
 	u32 acq_mult = 0;
 	u32 acq_prop = 0;
 	u32 extend_line = 0;
+	unsigned long lock_flags;
 	u32 width, height;
 
 	sensor = dev->active_sensor;
@@ -1808,6 +1979,13 @@ static int rkisp_config_isp(struct rkisp_device *dev)
 		rkisp_update_regs(dev, CIF_ISP_OUT_H_SIZE, CIF_ISP_OUT_V_SIZE);
 	}
 
+	if (dev->isp_ver == ISP_V30 || dev->isp_ver == ISP_V32) {
+		/* output size may change, rebuild and rewrite all */
+		spin_lock_irqsave(&dev->cmsk_lock, lock_flags);
+		dev->is_cmsk_last_valid = false;
+		rkisp_cmsk_regs_update(dev);
+		spin_unlock_irqrestore(&dev->cmsk_lock, lock_flags);
+	}
 	rkisp_config_cmsk(dev);
 	return 0;
 }
@@ -2195,6 +2373,24 @@ static int rkisp_isp_start(struct rkisp_device *dev)
 		}
 	}
 
+	/* line irq to notify encoder that first wrap slice is written */
+	memset(&dev->cap_dev.wrap_stat, 0, sizeof(dev->cap_dev.wrap_stat));
+	memset(&dev->rdbk_stat, 0, sizeof(dev->rdbk_stat));
+	memset(&dev->unite_stat, 0, sizeof(dev->unite_stat));
+	if (dev->isp_ver == ISP_V32 && dev->cap_dev.wrap_line) {
+		if (dev->cap_dev.wait_line) {
+			val = dev->cap_dev.wait_line;
+		} else {
+			val = min_t(u32, rkisp_wrap_slice_line,
+				    dev->isp_sdev.out_crop.height);
+			if (val) {
+				rkisp_write(dev, ISP32_ISP_IRQ_CFG0, val << 16, false);
+				rkisp_set_bits(dev, CIF_ISP_IMSC, 0, ISP3X_OUT_FRM_HALF, false);
+			}
+		}
+		dev->cap_dev.wrap_stat.slice_line = val;
+	}
+
 	/* Activate MIPI */
 	if (sensor && sensor->mbus.type == V4L2_MBUS_CSI2_DPHY) {
 		if (dev->isp_ver == ISP_V12 || dev->isp_ver == ISP_V13) {
@@ -2223,8 +2419,10 @@ static int rkisp_isp_start(struct rkisp_device *dev)
 
 	dev->isp_err_cnt = 0;
 	dev->isp_isr_cnt = 0;
+	memset(&dev->perf, 0, sizeof(dev->perf));
 	dev->irq_ends_mask |= ISP_FRAME_END;
 	dev->irq_ends = 0;
+	dev->irq_ends_prev = 0;
 
 	/* XXX: Is the 1000us too long?
 	 * CIF spec says to wait for sufficient time after enabling
@@ -2951,6 +3149,93 @@ static void rkisp_global_update_mi(struct rkisp_device *dev)
 	rkisp_stats_next_ddr_config(&dev->stats_vdev);
 }
 
+static void rkisp_online_work(struct work_struct *work)
+{
+	struct rkisp_device *isp_dev =
+		container_of(work, struct rkisp_device, online_work);
+	struct v4l2_subdev *remote;
+	int on = 1;
+
+	if (!(isp_dev->isp_state & ISP_START) ||
+	    !(isp_dev->isp_inp & INP_CIF) ||
+	    !IS_HDR_RDBK(isp_dev->rd_mode) ||
+	    !rkisp_is_sole_started(isp_dev))
+		return;
+
+	remote = get_remote_sensor(&isp_dev->isp_sdev.sd);
+	if (remote &&
+	    !v4l2_subdev_call(remote, core, ioctl,
+			      RKISP_VICAP_CMD_SWITCH_MODE, &on))
+		v4l2_dbg(1, rkisp_debug, &isp_dev->v4l2_dev,
+			 "switch to online as the only streaming sensor\n");
+}
+
+/*
+ * One device streaming stopped: it gives back single mode if it had it, and
+ * the device left streaming alone, if any, gets the chance to go online.
+ */
+static void rkisp_dyn_online_stop(struct rkisp_device *isp_dev)
+{
+	struct rkisp_hw_dev *hw = isp_dev->hw_dev;
+	struct rkisp_device *isp, *sole = NULL;
+	int i;
+
+	if (isp_dev->is_dyn_online) {
+		isp_dev->is_dyn_online = false;
+		hw->is_single = false;
+		switch (isp_dev->rd_mode) {
+		case HDR_LINEX3_DDR:
+			isp_dev->rd_mode = HDR_RDBK_FRAME3;
+			break;
+		case HDR_LINEX2_DDR:
+			isp_dev->rd_mode = HDR_RDBK_FRAME2;
+			break;
+		default:
+			isp_dev->rd_mode = HDR_RDBK_FRAME1;
+		}
+		isp_dev->hdr.op_mode = isp_dev->rd_mode;
+		return;
+	}
+
+	if (hw->is_single)
+		return;
+	for (i = 0; i < hw->dev_num; i++) {
+		isp = hw->isp[i];
+		if (!isp || isp == isp_dev || !(isp->isp_state & ISP_START))
+			continue;
+		if (sole)
+			return;
+		sole = isp;
+	}
+	if (sole)
+		schedule_work(&sole->online_work);
+}
+
+/* another device is starting, whoever is online on its own goes back */
+static void rkisp_dyn_online_exit(struct rkisp_device *isp_dev)
+{
+	struct rkisp_hw_dev *hw = isp_dev->hw_dev;
+	struct v4l2_subdev *remote;
+	struct rkisp_device *isp;
+	int i, on = 0;
+
+	for (i = 0; i < hw->dev_num; i++) {
+		isp = hw->isp[i];
+		if (!isp || isp == isp_dev)
+			continue;
+		cancel_work_sync(&isp->online_work);
+		if (!isp->is_dyn_online)
+			continue;
+		remote = get_remote_sensor(&isp->isp_sdev.sd);
+		if (remote)
+			v4l2_subdev_call(remote, core, ioctl,
+					 RKISP_VICAP_CMD_SWITCH_MODE, &on);
+		if (isp->is_dyn_online)
+			v4l2_warn(&isp_dev->v4l2_dev,
+				  "isp%d still online\n", isp->dev_id);
+	}
+}
+
 static int rkisp_isp_sd_s_stream(struct v4l2_subdev *sd, int on)
 {
 	struct rkisp_device *isp_dev = sd_to_isp_dev(sd);
@@ -2980,9 +3265,15 @@ static int rkisp_isp_sd_s_stream(struct v4l2_subdev *sd, int on)
 		rkisp_params_stream_stop(&isp_dev->params_vdev);
 		atomic_set(&isp_dev->isp_sdev.frm_sync_seq, 0);
 		rkisp_stop_3a_run(isp_dev);
+		cancel_work_sync(&isp_dev->mode_sw.work);
+		cancel_work_sync(&isp_dev->online_work);
+		rk_exp_queue_reset(&isp_dev->exp_queue);
+		WRITE_ONCE(isp_dev->mode_sw.cfg.state, RKISP_MODE_SWITCH_IDLE);
+		rkisp_dyn_online_stop(isp_dev);
 		return 0;
 	}
 
+	rkisp_dyn_online_exit(isp_dev);
 	hw_dev->is_runing = true;
 	rkisp_start_3a_run(isp_dev);
 	memset(&isp_dev->isp_sdev.dbg, 0, sizeof(isp_dev->isp_sdev.dbg));
@@ -3456,6 +3747,7 @@ static int rkisp_subdev_fmt_link_validate(struct v4l2_subdev *sd,
 void
 rkisp_isp_queue_event_sof(struct rkisp_isp_subdev *isp)
 {
+	struct rkisp_device *dev = sd_to_isp_dev(&isp->sd);
 	struct v4l2_event event = {
 		.type = V4L2_EVENT_FRAME_SYNC,
 		.u.frame_sync.frame_sequence =
@@ -3463,6 +3755,11 @@ rkisp_isp_queue_event_sof(struct rkisp_isp_subdev *isp)
 	};
 
 	v4l2_event_queue(isp->sd.devnode, &event);
+	rk_exp_queue_sof(&dev->exp_queue,
+			 dev->active_sensor ? dev->active_sensor->sd : NULL,
+			 event.u.frame_sync.frame_sequence);
+	/* the cpu is up for the sof anyway, run deferred completions now */
+	rk_irq_align_anchor();
 }
 
 static int rkisp_isp_sd_subs_evt(struct v4l2_subdev *sd, struct v4l2_fh *fh,
@@ -3528,6 +3825,23 @@ static int rkisp_get_info(struct rkisp_device *dev, struct rkisp_isp_info *info)
 	return 0;
 }
 
+/* no other linked isp device is streaming */
+static bool rkisp_is_sole_started(struct rkisp_device *isp_dev)
+{
+	struct rkisp_hw_dev *hw = isp_dev->hw_dev;
+	struct rkisp_device *isp;
+	int i;
+
+	for (i = 0; i < hw->dev_num; i++) {
+		isp = hw->isp[i];
+		if (!isp || isp == isp_dev || !isp->is_hw_link)
+			continue;
+		if (isp->isp_state & ISP_START)
+			return false;
+	}
+	return true;
+}
+
 static int rkisp_set_work_mode_by_vicap(struct rkisp_device *isp_dev,
 					struct rkisp_vicap_mode *vicap_mode)
 {
@@ -3536,8 +3850,19 @@ static int rkisp_set_work_mode_by_vicap(struct rkisp_device *isp_dev,
 
 	isp_dev->is_suspend_one_frame = false;
 	if (vicap_mode->rdbk_mode == RKISP_VICAP_ONLINE) {
-		if (!hw->is_single)
-			return -EINVAL;
+		/*
+		 * with several sensors linked, online is still fine while
+		 * the others are stopped. The hw runs as single until this
+		 * device goes back to readback or stops.
+		 */
+		if (!hw->is_single) {
+			if (hw->unite == ISP_UNITE_ONE ||
+			    !rkisp_is_sole_started(isp_dev))
+				return -EINVAL;
+			hw->is_single = true;
+			hw->cur_dev_id = isp_dev->dev_id;
+			isp_dev->is_dyn_online = true;
+		}
 		/* switch to online mode for single sensor */
 		switch (rd_mode) {
 		case HDR_RDBK_FRAME3:
@@ -3564,6 +3889,10 @@ static int rkisp_set_work_mode_by_vicap(struct rkisp_device *isp_dev,
 		}
 		if (vicap_mode->rdbk_mode == RKISP_VICAP_RDBK_AUTO_ONE_FRAME)
 			isp_dev->is_suspend_one_frame = true;
+		if (isp_dev->is_dyn_online) {
+			isp_dev->is_dyn_online = false;
+			hw->is_single = false;
+		}
 	} else {
 		return -EINVAL;
 	}
@@ -3581,6 +3910,129 @@ static int rkisp_set_work_mode_by_vicap(struct rkisp_device *isp_dev,
 	return 0;
 }
 
+/*
+ * ir-cut of the camera module of the sensor, both named
+ * m<index>_<facing>_, else the only ir-cut there is
+ */
+static struct v4l2_ctrl *rkisp_mode_switch_ircut(struct rkisp_device *dev,
+						 struct v4l2_subdev *sensor)
+{
+	struct v4l2_ctrl *ctrl, *any = NULL;
+	struct v4l2_subdev *sd;
+
+	list_for_each_entry(sd, &dev->v4l2_dev.subdevs, list) {
+		if (sd->entity.function != MEDIA_ENT_F_LENS || !sd->ctrl_handler)
+			continue;
+		ctrl = v4l2_ctrl_find(sd->ctrl_handler, V4L2_CID_BAND_STOP_FILTER);
+		if (!ctrl)
+			continue;
+		if (sensor && !strncmp(sd->name, sensor->name, 6))
+			return ctrl;
+		any = any ? ERR_PTR(-EBUSY) : ctrl;
+	}
+	return IS_ERR(any) ? NULL : any;
+}
+
+static void rkisp_mode_switch_work(struct work_struct *work)
+{
+	struct rkisp_mode_sw *msw = container_of(work, struct rkisp_mode_sw, work);
+	struct rkisp_device *dev = container_of(msw, struct rkisp_device, mode_sw);
+	struct v4l2_subdev *sd = NULL;
+	struct rkisp_mode_switch cfg;
+	struct v4l2_ctrl *ctrl;
+	unsigned long flags;
+	int i, ret = 0;
+
+	spin_lock_irqsave(&msw->lock, flags);
+	cfg = msw->cfg;
+	spin_unlock_irqrestore(&msw->lock, flags);
+
+	if (dev->active_sensor)
+		sd = dev->active_sensor->sd;
+	if (cfg.ctrl_num && !sd)
+		ret = -ENODEV;
+	for (i = 0; i < cfg.ctrl_num && !ret; i++) {
+		ctrl = v4l2_ctrl_find(sd->ctrl_handler, cfg.ctrl[i].id);
+		ret = ctrl ? v4l2_ctrl_s_ctrl(ctrl, cfg.ctrl[i].value) : -EINVAL;
+	}
+	if (!ret && cfg.ircut >= 0) {
+		ctrl = rkisp_mode_switch_ircut(dev, sd);
+		ret = ctrl ? v4l2_ctrl_s_ctrl(ctrl, cfg.ircut) : -ENODEV;
+	}
+	if (ret) {
+		v4l2_err(&dev->v4l2_dev, "mode switch at frame:%d fail:%d\n",
+			 cfg.switch_frame_id, ret);
+		spin_lock_irqsave(&msw->lock, flags);
+		msw->cfg.state = RKISP_MODE_SWITCH_FAIL;
+		spin_unlock_irqrestore(&msw->lock, flags);
+	}
+}
+
+/*
+ * at sof, write the staged sensor controls and the ir-cut once they
+ * take effect at the switch frame.
+ */
+void rkisp_mode_switch_sof(struct rkisp_device *dev)
+{
+	struct rkisp_mode_sw *msw = &dev->mode_sw;
+	struct rkisp_mode_switch *cfg = &msw->cfg;
+	unsigned long flags;
+	bool is_run = false;
+	u32 seq;
+
+	if (READ_ONCE(cfg->state) != RKISP_MODE_SWITCH_PENDING)
+		return;
+
+	rkisp_dmarx_get_frame(dev, &seq, NULL, NULL, true);
+	spin_lock_irqsave(&msw->lock, flags);
+	if (cfg->state == RKISP_MODE_SWITCH_PENDING &&
+	    seq + cfg->sensor_delay >= cfg->frame_id) {
+		cfg->switch_frame_id = seq + cfg->sensor_delay;
+		cfg->switch_timestamp = ktime_get_ns();
+		cfg->state = cfg->switch_frame_id > cfg->frame_id ?
+			     RKISP_MODE_SWITCH_LATE : RKISP_MODE_SWITCH_DONE;
+		is_run = true;
+	}
+	spin_unlock_irqrestore(&msw->lock, flags);
+	if (is_run) {
+		v4l2_dbg(1, rkisp_debug, &dev->v4l2_dev,
+			 "mode switch seq:%d at frame:%d for %d\n",
+			 seq, cfg->switch_frame_id, cfg->frame_id);
+		schedule_work(&msw->work);
+	}
+}
+
+static int rkisp_mode_switch_set(struct rkisp_device *dev,
+				 struct rkisp_mode_switch *arg)
+{
+	struct rkisp_mode_sw *msw = &dev->mode_sw;
+	unsigned long flags;
+
+	if (arg->ctrl_num > RKISP_MODE_SWITCH_CTRL_MAX)
+		return -EINVAL;
+
+	/* the last switch is written before this one is staged */
+	flush_work(&msw->work);
+	spin_lock_irqsave(&msw->lock, flags);
+	msw->cfg = *arg;
+	msw->cfg.state = RKISP_MODE_SWITCH_PENDING;
+	msw->cfg.switch_frame_id = 0;
+	msw->cfg.switch_timestamp = 0;
+	spin_unlock_irqrestore(&msw->lock, flags);
+	return 0;
+}
+
+static void rkisp_mode_switch_get(struct rkisp_device *dev,
+				  struct rkisp_mode_switch *arg)
+{
+	struct rkisp_mode_sw *msw = &dev->mode_sw;
+	unsigned long flags;
+
+	spin_lock_irqsave(&msw->lock, flags);
+	*arg = msw->cfg;
+	spin_unlock_irqrestore(&msw->lock, flags);
+}
+
 static long rkisp_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 {
 	struct rkisp_device *isp_dev = sd_to_isp_dev(sd);
@@ -3647,9 +4099,8 @@ static long rkisp_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 			dma_unmap_single(isp_dev->dev, isp_dev->resmem_pa,
 					 sizeof(struct rkisp_thunderboot_resmem_head),
 					 DMA_FROM_DEVICE);
-			free_reserved_area(phys_to_virt(isp_dev->resmem_pa),
-					   phys_to_virt(isp_dev->resmem_pa) + isp_dev->resmem_size,
-					   -1, "rkisp_thunderboot");
+			rk_tb_mem_release("rkisp_thunderboot", isp_dev->resmem_pa,
+					  isp_dev->resmem_size);
 
 			isp_dev->resmem_pa = 0;
 			isp_dev->resmem_size = 0;
@@ -3664,9 +4115,8 @@ static long rkisp_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 			dma_unmap_single(isp_dev->dev, isp_dev->resmem_pa,
 					 sizeof(struct rkisp_thunderboot_resmem_head),
 					 DMA_FROM_DEVICE);
-			free_reserved_area(phys_to_virt(isp_dev->resmem_pa),
-					   phys_to_virt(isp_dev->resmem_pa) + isp_dev->resmem_size,
-					   -1, "rkisp_thunderboot");
+			rk_tb_mem_release("rkisp_thunderboot", isp_dev->resmem_pa,
+					  isp_dev->resmem_size);
 		}
 
 		isp_dev->resmem_pa = 0;
@@ -3724,6 +4174,21 @@ static long rkisp_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 	case RKISP_CMD_GET_BAY3D_BUFFD:
 		rkisp_params_get_bay3d_buffd(&isp_dev->params_vdev, arg);
 		break;
+	case RKISP_CMD_GET_STATS_RING:
+		ret = rkisp_stats_get_ring_info(&isp_dev->stats_vdev, arg);
+		break;
+	case RKISP_CMD_SET_MODE_SWITCH:
+		ret = rkisp_mode_switch_set(isp_dev, arg);
+		break;
+	case RKISP_CMD_GET_MODE_SWITCH:
+		rkisp_mode_switch_get(isp_dev, arg);
+		break;
+	case RK_EXP_CMD_QUEUE:
+		ret = rk_exp_queue_add(&isp_dev->exp_queue, arg);
+		break;
+	case RK_EXP_CMD_GET_STATS:
+		rk_exp_queue_get_stats(&isp_dev->exp_queue, arg);
+		break;
 	default:
 		ret = -ENOIOCTLCMD;
 	}
@@ -3803,6 +4268,26 @@ static long rkisp_compat_ioctl32(struct v4l2_subdev *sd,
 		size = sizeof(struct rkisp_bay3dbuf_info);
 		cp_t_us = true;
 		break;
+	case RKISP_CMD_GET_STATS_RING:
+		size = sizeof(struct rkisp_stats_ring_info);
+		cp_t_us = true;
+		break;
+	case RKISP_CMD_SET_MODE_SWITCH:
+		size = sizeof(struct rkisp_mode_switch);
+		cp_f_us = true;
+		break;
+	case RKISP_CMD_GET_MODE_SWITCH:
+		size = sizeof(struct rkisp_mode_switch);
+		cp_t_us = true;
+		break;
+	case RK_EXP_CMD_QUEUE:
+		size = sizeof(struct rk_exp_req);
+		cp_f_us = true;
+		break;
+	case RK_EXP_CMD_GET_STATS:
+		size = sizeof(struct rk_exp_stats);
+		cp_t_us = true;
+		break;
 	default:
 		return -ENOIOCTLCMD;
 	}
@@ -3892,11 +4377,15 @@ int rkisp_register_isp_subdev(struct rkisp_device *isp_dev,
 {
 	struct rkisp_isp_subdev *isp_sdev = &isp_dev->isp_sdev;
 	struct v4l2_subdev *sd = &isp_sdev->sd;
+	char name[32];
 	int ret;
 
 	mutex_init(&isp_dev->buf_lock);
 	spin_lock_init(&isp_dev->cmsk_lock);
 	spin_lock_init(&isp_dev->rdbk_lock);
+	spin_lock_init(&isp_dev->mode_sw.lock);
+	INIT_WORK(&isp_dev->mode_sw.work, rkisp_mode_switch_work);
+	INIT_WORK(&isp_dev->online_work, rkisp_online_work);
 	ret = kfifo_alloc(&isp_dev->rdbk_kfifo,
 		16 * sizeof(struct isp2x_csi_trigger), GFP_KERNEL);
 	if (ret < 0) {
@@ -3936,9 +4425,21 @@ int rkisp_register_isp_subdev(struct rkisp_device *isp_dev,
 	isp_dev->isp_state = ISP_STOP;
 	atomic_set(&isp_sdev->frm_sync_seq, 0);
 	rkisp_monitor_init(isp_dev);
-	INIT_WORK(&isp_dev->rdbk_work, rkisp_rdbk_work);
+	/* dvfs at readback frame end, rt and placed by the performance level */
+	snprintf(name, sizeof(name), "%s_rdbk", isp_dev->name);
+	isp_dev->rdbk_worker = rockchip_perf_create_worker(name);
+	if (IS_ERR(isp_dev->rdbk_worker)) {
+		ret = PTR_ERR(isp_dev->rdbk_worker);
+		isp_dev->rdbk_worker = NULL;
+		goto err_unreg_subdev;
+	}
+	kthread_init_work(&isp_dev->rdbk_work, rkisp_rdbk_work);
 	init_completion(&isp_dev->pm_cmpl);
+	if (rk_exp_queue_init(&isp_dev->exp_queue, isp_dev->name))
+		v4l2_warn(v4l2_dev, "no exposure queue\n");
 	return 0;
+err_unreg_subdev:
+	v4l2_device_unregister_subdev(sd);
 err_cleanup_media_entity:
 	media_entity_cleanup(&sd->entity);
 free_kfifo:
@@ -3950,6 +4451,11 @@ void rkisp_unregister_isp_subdev(struct rkisp_device *isp_dev)
 {
 	struct v4l2_subdev *sd = &isp_dev->isp_sdev.sd;
 
+	cancel_work_sync(&isp_dev->mode_sw.work);
+	cancel_work_sync(&isp_dev->online_work);
+	rk_exp_queue_remove(&isp_dev->exp_queue);
+	rockchip_perf_destroy_worker(isp_dev->rdbk_worker);
+	isp_dev->rdbk_worker = NULL;
 	kfifo_free(&isp_dev->rdbk_kfifo);
 	v4l2_device_unregister_subdev(sd);
 	media_entity_cleanup(&sd->entity);
@@ -4321,6 +4827,7 @@ void rkisp_isp_isr(unsigned int isp_mis,
 			writel(CIF_ISP_DATA_LOSS, base + CIF_ISP_ICR);
 		}
 
+		dev->perf.drop_overflow++;
 		if (dev->isp_err_cnt++ > RKISP_CONTI_ERR_MAX) {
 			if (!(dev->isp_state & ISP_ERROR)) {
 				rkisp_set_state(&dev->isp_state, ISP_ERROR);
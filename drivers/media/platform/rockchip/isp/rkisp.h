@@ -182,6 +182,10 @@ void rkisp_isp_queue_event_sof(struct rkisp_isp_subdev *isp);
 
 void rkisp_check_idle(struct rkisp_device *dev, u32 irq);
 
+void rkisp_cmsk_regs_update(struct rkisp_device *dev);
+
+void rkisp_mode_switch_sof(struct rkisp_device *dev);
+
 void rkisp_trigger_read_back(struct rkisp_device *dev, u8 dma2frm, u32 mode, bool is_try);
 
 int rkisp_rdbk_trigger_event(struct rkisp_device *dev, u32 cmd, void *arg);
@@ -230,6 +230,9 @@ static int rkisp_tb_plat_probe(struct platform_device *pdev)
 
 	if (IS_ENABLED(CONFIG_ROCKCHIP_THUNDER_BOOT_SERVICE)) {
 		tb_cl.cb = rkisp_tb_cb;
+		tb_cl.name = dev_name(&pdev->dev);
+		tb_cl.id = RK_TB_CLIENT_ISP;
+		tb_cl.flags = RK_TB_CLIENT_ASYNC;
 		return rk_tb_client_register_cb(&tb_cl);
 	}
 
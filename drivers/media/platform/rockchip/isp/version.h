@@ -504,6 +504,11 @@
  * 17.add ioctl to get bay3d buf
  * 18.fix isp32 lite frame buffer data read
  * 19.support 8k for isp32 lite
+ * 20.isp32 wrap mode notify encoder on first slice line
+ * 21.add sof to frame done latency histogram and trace event
+ * 22.multi dev read back schedule by priority and deadline
+ * 23.isp32 skip rewrite of unchanged lut config
+ * 24.add RKISP_CMD_GET_STATS_RING for isp32 3a stats ring
  */
 
 #define RKISP_DRIVER_VERSION RKISP_API_VERSION
@@ -1016,6 +1016,13 @@ static void update_dmatx0(struct rkisp1_stream *stream)
 		mi_raw0_set_addr(base, dummy_buf->dma_addr);
 }
 
+/* mp/sp may close mi instead of writing the dummy buf once streaming */
+static bool mi_can_pause(struct rkisp1_stream *stream)
+{
+	return rkisp1_mi_pause && stream->streaming && !stream->interlaced &&
+	       stream->id != RKISP1_STREAM_RAW;
+}
+
 /* Update buffer info to memory interface, it's called in interrupt */
 static void update_mi(struct rkisp1_stream *stream)
 {
@@ -1031,6 +1038,20 @@ static void update_mi(struct rkisp1_stream *stream)
 			stream->next_buf->buff_addr[RKISP1_PLANE_CB]);
 		mi_set_cr_addr(stream,
 			stream->next_buf->buff_addr[RKISP1_PLANE_CR]);
+		if (stream->is_pause) {
+			/* like a second stream start, on from next frame */
+			stream->ops->enable_mi(stream);
+			stream->is_pause = false;
+		}
+	} else if (mi_can_pause(stream)) {
+		/* closed at this frame end, no frame end irq until reopen */
+		if (!stream->is_pause) {
+			v4l2_dbg(1, rkisp1_debug, &stream->ispdev->v4l2_dev,
+				 "stream %d: pause mi\n", stream->id);
+			stream->ops->disable_mi(stream);
+			stream->is_pause = true;
+		}
+		return;
 	} else {
 		v4l2_dbg(1, rkisp1_debug, &stream->ispdev->v4l2_dev,
 			 "stream %d: to dummy buf\n", stream->id);
@@ -1110,6 +1131,23 @@ static int mi_frame_end(struct rkisp1_stream *stream)
 	unsigned long lock_flags = 0;
 	int i = 0;
 
+	/*
+	 * First irq after qbuf reopened the mi. If the frame the mi was
+	 * reopened in ended, the next frame goes to next_buf as usual.
+	 * Otherwise the frames in between had no irq and next_buf is
+	 * already filled.
+	 */
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	if (stream->is_rearm) {
+		stream->is_rearm = false;
+		if (atomic_read(&isp_sd->frm_sync_seq) - 1 != stream->rearm_seq &&
+		    !stream->curr_buf) {
+			stream->curr_buf = stream->next_buf;
+			stream->next_buf = NULL;
+		}
+	}
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+
 	if (stream->curr_buf &&
 		(!interlaced ||
 		(stream->u.sp.field_rec == RKISP_FIELD_ODD &&
@@ -1188,7 +1226,9 @@ static void rkisp1_stream_stop(struct rkisp1_stream *stream)
 	stream->stopping = true;
 	stream->ops->stop_mi(stream);
 	if (dev->isp_state == ISP_START &&
-	    dev->isp_inp != INP_DMARX_ISP) {
+	    dev->isp_inp != INP_DMARX_ISP &&
+	    !(stream->is_pause &&
+	      stream->ops->is_stream_stopped(dev->base_addr))) {
 		ret = wait_event_timeout(stream->done,
 					 !stream->streaming,
 					 msecs_to_jiffies(1000));
@@ -1211,6 +1251,8 @@ static void rkisp1_stream_stop(struct rkisp1_stream *stream)
 		CIF_MI_CTRL_BURST_LEN_LUM_16 |
 		CIF_MI_CTRL_BURST_LEN_CHROM_16;
 	stream->interlaced = false;
+	stream->is_pause = false;
+	stream->is_rearm = false;
 }
 
 /*
@@ -1364,6 +1406,14 @@ static void rkisp1_buf_queue(struct vb2_buffer *vb)
 	    atomic_read(&stream->ispdev->isp_sdev.frm_sync_seq) == 0) {
 		stream->next_buf = ispbuf;
 		stream->ops->update_mi(stream);
+	} else if (stream->is_pause && !stream->next_buf &&
+		   !stream->stopping) {
+		/* no frame end irq while paused, reopen mi from here */
+		stream->next_buf = ispbuf;
+		stream->is_rearm = true;
+		stream->rearm_seq =
+			atomic_read(&stream->ispdev->isp_sdev.frm_sync_seq) - 1;
+		stream->ops->update_mi(stream);
 	} else {
 		list_add_tail(&ispbuf->queue, &stream->buf_queue);
 	}
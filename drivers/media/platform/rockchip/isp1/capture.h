@@ -177,6 +177,8 @@ struct streams_ops {
  * rkisp1 use shadowsock registers, so it need two buffer at a time
  * @curr_buf: the buffer used for current frame
  * @next_buf: the buffer used for next frame
+ * @is_pause: mi closed for lack of buffers, frames are dropped by hw
+ * @is_rearm: mi reopened by qbuf, @rearm_seq is the frame it was done in
  */
 struct rkisp1_stream {
 	unsigned id:2;
@@ -196,6 +198,9 @@ struct rkisp1_stream {
 	bool streaming;
 	bool stopping;
 	bool frame_end;
+	bool is_pause;
+	bool is_rearm;
+	u32 rearm_seq;
 	wait_queue_head_t done;
 	unsigned int burst;
 	union {
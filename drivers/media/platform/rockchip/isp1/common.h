@@ -107,6 +107,8 @@ struct rkisp1_dummy_buffer {
 };
 
 extern int rkisp1_debug;
+extern bool rkisp1_mi_pause;
+extern unsigned int rkisp1_stats_ring;
 
 static inline
 struct rkisp1_vdev_node *vdev_to_node(struct video_device *vdev)
@@ -73,6 +73,14 @@ int rkisp1_debug;
 module_param_named(debug, rkisp1_debug, int, 0644);
 MODULE_PARM_DESC(debug, "Debug level (0-1)");
 
+bool rkisp1_mi_pause = true;
+module_param_named(mi_pause, rkisp1_mi_pause, bool, 0644);
+MODULE_PARM_DESC(mi_pause, "close mp/sp mi instead of writing the dummy buf when no buf queued");
+
+unsigned int rkisp1_stats_ring;
+module_param_named(stats_ring, rkisp1_stats_ring, uint, 0644);
+MODULE_PARM_DESC(stats_ring, "3a stats ring slot num, 0:disable, 3~8:enable");
+
 static char rkisp1_version[RKISP_VERNO_LEN];
 module_param_string(version, rkisp1_version, RKISP_VERNO_LEN, 0444);
 MODULE_PARM_DESC(version, "version number");
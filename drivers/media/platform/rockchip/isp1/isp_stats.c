@@ -32,6 +32,7 @@
  * SOFTWARE.
  */
 
+#include <linux/dma-buf.h>
 #include <linux/kfifo.h>
 #include <media/v4l2-common.h>
 #include <media/v4l2-ioctl.h>
@@ -89,6 +90,49 @@ static int rkisp1_stats_querycap(struct file *file,
 	return 0;
 }
 
+static int rkisp1_stats_get_ring_info(struct rkisp1_isp_stats_vdev *stats_vdev,
+				      struct rkisp1_stats_ring_info *info)
+{
+	const struct vb2_mem_ops *ops = &vb2_vmalloc_memops;
+	struct dma_buf *dbuf;
+	int fd;
+
+	if (!stats_vdev->ring_num)
+		return -EINVAL;
+
+	/* the dma buf holds a ref of the ring, so it outlives stream off */
+	dbuf = ops->get_dmabuf(stats_vdev->ring_priv, O_RDWR);
+	if (!dbuf)
+		return -ENOMEM;
+	fd = dma_buf_fd(dbuf, O_CLOEXEC);
+	if (fd < 0) {
+		dma_buf_put(dbuf);
+		return fd;
+	}
+
+	info->buf_fd = fd;
+	info->buf_size = stats_vdev->ring_head_size +
+			 stats_vdev->ring_num * sizeof(struct rkisp1_stat_buffer);
+	info->head_size = stats_vdev->ring_head_size;
+	info->slot_num = stats_vdev->ring_num;
+	info->slot_size = sizeof(struct rkisp1_stat_buffer);
+	return 0;
+}
+
+static long rkisp1_stats_ioctl_default(struct file *file, void *fh,
+				       bool valid_prio, unsigned int cmd,
+				       void *arg)
+{
+	struct rkisp1_isp_stats_vdev *stats_vdev = video_drvdata(file);
+
+	switch (cmd) {
+	case RKISP1_CMD_GET_STATS_RING:
+		return rkisp1_stats_get_ring_info(stats_vdev, arg);
+	default:
+		return -EINVAL;
+	}
+}
+
 /* ISP video device IOCTLs */
 static const struct v4l2_ioctl_ops rkisp1_stats_ioctl = {
 	.vidioc_reqbufs = vb2_ioctl_reqbufs,
@@ -104,12 +148,16 @@ static const struct v4l2_ioctl_ops rkisp1_stats_ioctl = {
 	.vidioc_g_fmt_meta_cap = rkisp1_stats_g_fmt_meta_cap,
 	.vidioc_s_fmt_meta_cap = rkisp1_stats_g_fmt_meta_cap,
 	.vidioc_try_fmt_meta_cap = rkisp1_stats_g_fmt_meta_cap,
-	.vidioc_querycap = rkisp1_stats_querycap
+	.vidioc_querycap = rkisp1_stats_querycap,
+	.vidioc_default = rkisp1_stats_ioctl_default,
 };
 
 struct v4l2_file_operations rkisp1_stats_fops = {
 	.mmap = vb2_fop_mmap,
 	.unlocked_ioctl = video_ioctl2,
+#ifdef CONFIG_COMPAT
+	.compat_ioctl32 = video_ioctl2,
+#endif
 	.poll = vb2_fop_poll,
 	.open = v4l2_fh_open,
 	.release = vb2_fop_release
@@ -149,6 +197,72 @@ static void rkisp1_stats_vb2_buf_queue(struct vb2_buffer *vb)
 	spin_unlock_bh(&stats_dev->rd_lock);
 }
 
+static void *rkisp1_stats_ring_slot(struct rkisp1_isp_stats_vdev *stats_vdev,
+				    int idx)
+{
+	return stats_vdev->ring_vaddr + stats_vdev->ring_head_size +
+	       idx * sizeof(struct rkisp1_stat_buffer);
+}
+
+static void rkisp1_stats_ring_free(struct rkisp1_isp_stats_vdev *stats_vdev)
+{
+	stats_vdev->ring_num = 0;
+	if (stats_vdev->ring_priv)
+		vb2_vmalloc_memops.put(stats_vdev->ring_priv);
+	stats_vdev->ring_priv = NULL;
+	stats_vdev->ring_vaddr = NULL;
+}
+
+static void rkisp1_stats_ring_alloc(struct rkisp1_isp_stats_vdev *stats_vdev)
+{
+	const struct vb2_mem_ops *ops = &vb2_vmalloc_memops;
+	struct rkisp1_stats_ring_head *head;
+	u32 num = min_t(u32, rkisp1_stats_ring, RKISP1_STATS_RING_MAX);
+	u32 size;
+	void *priv;
+
+	rkisp1_stats_ring_free(stats_vdev);
+	/* one slot for user, one for writing and one for margin */
+	if (num < 3)
+		return;
+
+	stats_vdev->ring_head_size = ALIGN(sizeof(*head), 256);
+	size = stats_vdev->ring_head_size +
+	       num * sizeof(struct rkisp1_stat_buffer);
+	priv = ops->alloc(stats_vdev->dev->dev, 0, PAGE_ALIGN(size),
+			  DMA_FROM_DEVICE, GFP_KERNEL);
+	if (IS_ERR_OR_NULL(priv)) {
+		v4l2_warn(stats_vdev->vnode.vdev.v4l2_dev,
+			  "stats ring alloc buf fail\n");
+		return;
+	}
+
+	stats_vdev->ring_priv = priv;
+	stats_vdev->ring_vaddr = ops->vaddr(priv);
+	memset(stats_vdev->ring_vaddr, 0, size);
+	head = stats_vdev->ring_vaddr;
+	head->slot_num = num;
+	head->slot_size = sizeof(struct rkisp1_stat_buffer);
+	stats_vdev->ring_wr = num - 1;
+	stats_vdev->ring_num = num;
+}
+
+static void
+rkisp1_stats_ring_publish(struct rkisp1_isp_stats_vdev *stats_vdev, int idx,
+			  u32 frame_id, u64 timestamp)
+{
+	struct rkisp1_stats_ring_head *head = stats_vdev->ring_vaddr;
+
+	WRITE_ONCE(head->seq, head->seq + 1);
+	smp_wmb();
+	head->frame_id[idx] = frame_id;
+	head->timestamp[idx] = timestamp;
+	head->wr_idx = idx;
+	smp_wmb();
+	WRITE_ONCE(head->seq, head->seq + 1);
+	stats_vdev->ring_wr = idx;
+}
+
 static void rkisp1_stats_vb2_stop_streaming(struct vb2_queue *vq)
 {
 	struct rkisp1_isp_stats_vdev *stats_vdev = vq->drv_priv;
@@ -173,6 +287,8 @@ static void rkisp1_stats_vb2_stop_streaming(struct vb2_queue *vq)
 		vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_ERROR);
 	}
 	spin_unlock_bh(&stats_vdev->rd_lock);
+
+	rkisp1_stats_ring_free(stats_vdev);
 }
 
 static int
@@ -181,6 +297,7 @@ rkisp1_stats_vb2_start_streaming(struct vb2_queue *queue,
 {
 	struct rkisp1_isp_stats_vdev *stats_vdev = queue->drv_priv;
 
+	rkisp1_stats_ring_alloc(stats_vdev);
 	stats_vdev->streamon = true;
 	kfifo_reset(&stats_vdev->rd_kfifo);
 	tasklet_enable(&stats_vdev->rd_tasklet);
@@ -450,6 +567,7 @@ rkisp1_stats_send_measurement(struct rkisp1_isp_stats_vdev *stats_vdev,
 	struct rkisp1_stat_buffer *cur_stat_buf;
 	struct rkisp1_buffer *cur_buf = NULL;
 	struct rkisp1_stats_ops *ops = stats_vdev->ops;
+	int ring_idx = -1;
 
 	cur_frame_id = atomic_read(&stats_vdev->dev->isp_sdev.frm_sync_seq) - 1;
 	if (cur_frame_id != meas_work->frame_id) {
@@ -468,11 +586,16 @@ rkisp1_stats_send_measurement(struct rkisp1_isp_stats_vdev *stats_vdev,
 	}
 	spin_unlock(&stats_vdev->rd_lock);
 
-	if (!cur_buf)
+	/* read out to the ring, vb2 buffer copy from it */
+	if (stats_vdev->ring_num) {
+		ring_idx = (stats_vdev->ring_wr + 1) % stats_vdev->ring_num;
+		cur_stat_buf = rkisp1_stats_ring_slot(stats_vdev, ring_idx);
+	} else if (cur_buf) {
+		cur_stat_buf =
+			(struct rkisp1_stat_buffer *)(cur_buf->vaddr[0]);
+	} else {
 		return;
-
-	cur_stat_buf =
-		(struct rkisp1_stat_buffer *)(cur_buf->vaddr[0]);
+	}
 	memset(cur_stat_buf, 0, sizeof(*cur_stat_buf));
 	cur_stat_buf->frame_id = cur_frame_id;
 	if (meas_work->isp_ris & CIF_ISP_AWB_DONE) {
@@ -500,6 +623,14 @@ rkisp1_stats_send_measurement(struct rkisp1_isp_stats_vdev *stats_vdev,
 		ops->get_emb_data)
 		ops->get_emb_data(stats_vdev, cur_stat_buf);
 
+	if (ring_idx >= 0) {
+		rkisp1_stats_ring_publish(stats_vdev, ring_idx, cur_frame_id,
+					  meas_work->timestamp);
+		if (!cur_buf)
+			return;
+		memcpy(cur_buf->vaddr[0], cur_stat_buf, sizeof(*cur_stat_buf));
+	}
+
 	vb2_set_plane_payload(&cur_buf->vb.vb2_buf, 0,
 			      sizeof(struct rkisp1_stat_buffer));
 	cur_buf->vb.sequence = cur_frame_id;
@@ -83,6 +83,9 @@ struct rkisp1_stats_config {
  * @irq_lock: buffer queue lock
  * @stat: stats buffer list
  * @readout_wq: workqueue for statistics information read
+ * @ring_priv: vmalloc stats ring filled by the readout tasklet
+ * @ring_num: slot num of stats ring, 0 if disable
+ * @ring_wr: slot of the latest stats
  */
 struct rkisp1_isp_stats_vdev {
 	struct rkisp1_vdev_node vnode;
@@ -99,6 +102,12 @@ struct rkisp1_isp_stats_vdev {
 
 	struct rkisp1_stats_ops *ops;
 	struct rkisp1_stats_config *config;
+
+	void *ring_priv;
+	void *ring_vaddr;
+	u32 ring_num;
+	u32 ring_head_size;
+	int ring_wr;
 };
 
 int rkisp1_stats_isr(struct rkisp1_isp_stats_vdev *stats_vdev, u32 isp_ris);
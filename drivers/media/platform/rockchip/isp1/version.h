@@ -54,8 +54,12 @@
  *1. fix kernel reboot in monkey test;
  *2. fix raw patch wrong RG10 format;
  *3. fix isp iommu work after suspend;
+ *
+ *v0.1.6:
+ *1. add RKISP1_CMD_GET_STATS_RING for 3a stats ring;
+ *2. close mp/sp mi instead of dummy buf when no buf queued;
  */
 
-#define RKISP1_DRIVER_VERSION KERNEL_VERSION(0, 1, 0x5)
+#define RKISP1_DRIVER_VERSION KERNEL_VERSION(0, 1, 0x6)
 
 #endif
@@ -3,6 +3,9 @@
 
 #include <linux/clk.h>
 #include <linux/delay.h>
+#include <linux/dma-fence.h>
+#include <linux/file.h>
+#include <linux/sync_file.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-fh.h>
 #include <media/v4l2-ioctl.h>
@@ -26,6 +29,45 @@ struct rkispp_fec_buf {
 	void *mem;
 };
 
+#define FEC_JOB_TIMEOUT_MS	300
+#define FEC_FLUSH_TIMEOUT_MS	1000
+
+/* mesh tables of one lens/geometry: xint, xfra, yint, yfra */
+struct rkispp_fec_mesh_buf {
+	struct list_head list;
+	struct file *file;
+	int id;
+	u32 out_w;
+	u32 out_h;
+	void *mem[4];
+};
+
+/* register values of one request, started from the queue */
+struct rkispp_fec_job {
+	struct list_head list;
+	struct rkispp_fec_dev *fec;
+	u32 in_y;
+	u32 in_uv;
+	u32 out_y;
+	u32 out_uv;
+	u32 mesh[4];
+	u32 ctrl;
+	u32 rd_stride;
+	u32 wr_stride;
+	u32 dst_size;
+	u32 src_size;
+	u32 mesh_size;
+	u32 core_ctrl;
+	struct dma_fence *in_fence;
+	struct dma_fence_cb in_cb;
+	struct dma_fence *out_fence;
+	struct completion cmpl;
+	ktime_t t;
+	bool ready;
+	bool async;
+	int ret;
+};
+
 static const struct vb2_mem_ops *g_ops = &vb2_dma_contig_memops;
 
 static void *fec_buf_add(struct file *file, int fd, int size)
@@ -94,17 +136,56 @@ static void *fec_buf_add(struct file *file, int fd, int size)
 	return mem;
 }
 
+static void fec_mesh_del(struct rkispp_fec_dev *fec, struct file *file, void *mem)
+{
+	struct rkispp_fec_mesh_buf *mesh, *next;
+	int i;
+
+	list_for_each_entry_safe(mesh, next, &fec->mesh_list, list) {
+		if (mesh->file != file)
+			continue;
+		for (i = 0; mem && i < ARRAY_SIZE(mesh->mem); i++)
+			if (mesh->mem[i] == mem)
+				break;
+		if (mem && i == ARRAY_SIZE(mesh->mem))
+			continue;
+		list_del(&mesh->list);
+		kfree(mesh);
+	}
+}
+
+static void fec_mesh_del_id(struct rkispp_fec_dev *fec, struct file *file, int id)
+{
+	struct rkispp_fec_mesh_buf *mesh, *next;
+
+	list_for_each_entry_safe(mesh, next, &fec->mesh_list, list) {
+		if (mesh->file == file && mesh->id == id) {
+			list_del(&mesh->list);
+			kfree(mesh);
+		}
+	}
+}
+
+static void fec_job_flush(struct rkispp_fec_dev *fec);
+
 static void fec_buf_del(struct file *file, int fd, bool is_all)
 {
 	struct rkispp_fec_dev *fec = video_drvdata(file);
 	struct rkispp_fec_buf *buf, *next;
 
+	/* queued jobs still point at the mappings */
+	fec_job_flush(fec);
+
 	mutex_lock(&fec->hw->dev_lock);
+	if (is_all)
+		fec_mesh_del(fec, file, NULL);
 	list_for_each_entry_safe(buf, next, &fec->list, list) {
 		if (buf->file == file && (is_all || buf->fd == fd)) {
 			v4l2_dbg(4, rkispp_debug, &fec->v4l2_dev,
 				 "%s file:%p fd:%d dbuf:%p\n",
 				 __func__, file, buf->fd, buf->dbuf);
+			if (!is_all)
+				fec_mesh_del(fec, file, buf->mem);
 			g_ops->unmap_dmabuf(buf->mem);
 			g_ops->detach_dmabuf(buf->mem);
 			dma_buf_put(buf->dbuf);
@@ -119,22 +200,93 @@ static void fec_buf_del(struct file *file, int fd, bool is_all)
 	mutex_unlock(&fec->hw->dev_lock);
 }
 
-static int fec_running(struct file *file, struct rkispp_fec_in_out *buf)
+static u32 fec_buf_addr(void *mem)
+{
+	return *((dma_addr_t *)g_ops->cookie(mem));
+}
+
+/* map the mesh of one geometry once, jobs then refer to it by id */
+static int fec_mesh_set(struct file *file, struct rkispp_fec_mesh *req)
+{
+	struct rkispp_fec_dev *fec = video_drvdata(file);
+	struct rkispp_fec_mesh_buf *mesh;
+	int fds[4] = { req->mesh_xint_fd, req->mesh_xfra_fd,
+		       req->mesh_yint_fd, req->mesh_yfra_fd };
+	u32 mesh_size;
+	void *mem[4];
+	int i;
+
+	if (req->mesh_id < 0 || req->out_width <= 0 || req->out_height <= 0)
+		return -EINVAL;
+
+	mesh_size = cal_fec_mesh(req->out_width, req->out_height,
+				 req->out_width > 1920);
+	for (i = 0; i < ARRAY_SIZE(fds); i++) {
+		/* int tables are twice the size of the fraction ones */
+		mem[i] = fec_buf_add(file, fds[i], i % 2 ? mesh_size : mesh_size * 2);
+		if (!mem[i])
+			return -ENOMEM;
+	}
+
+	mesh = kzalloc(sizeof(*mesh), GFP_KERNEL);
+	if (!mesh)
+		return -ENOMEM;
+	mesh->file = file;
+	mesh->id = req->mesh_id;
+	mesh->out_w = req->out_width;
+	mesh->out_h = req->out_height;
+	memcpy(mesh->mem, mem, sizeof(mem));
+
+	mutex_lock(&fec->hw->dev_lock);
+	fec_mesh_del_id(fec, file, req->mesh_id);
+	list_add_tail(&mesh->list, &fec->mesh_list);
+	mutex_unlock(&fec->hw->dev_lock);
+
+	v4l2_dbg(3, rkispp_debug, &fec->v4l2_dev,
+		 "%s file:%p id:%d %dx%d\n", __func__, file,
+		 req->mesh_id, req->out_width, req->out_height);
+	return 0;
+}
+
+static int fec_mesh_get(struct rkispp_fec_dev *fec, struct file *file,
+			int id, u32 out_w, u32 out_h, u32 *addr)
+{
+	struct rkispp_fec_mesh_buf *mesh;
+	int i, ret = -EINVAL;
+
+	mutex_lock(&fec->hw->dev_lock);
+	list_for_each_entry(mesh, &fec->mesh_list, list) {
+		if (mesh->file != file || mesh->id != id)
+			continue;
+		if (mesh->out_w != out_w || mesh->out_h != out_h)
+			break;
+		for (i = 0; i < ARRAY_SIZE(mesh->mem); i++)
+			addr[i] = fec_buf_addr(mesh->mem[i]);
+		ret = 0;
+		break;
+	}
+	mutex_unlock(&fec->hw->dev_lock);
+
+	if (ret)
+		v4l2_err(&fec->v4l2_dev, "no mesh id:%d for %dx%d\n", id, out_w, out_h);
+	return ret;
+}
+
+/* resolve formats and buffers of one request into the job registers */
+static int fec_job_prepare(struct file *file, struct rkispp_fec_in_out *buf,
+			   int mesh_id, struct rkispp_fec_job *job)
 {
 	struct rkispp_fec_dev *fec = video_drvdata(file);
 	u32 in_fmt, out_fmt, in_mult = 1, out_mult = 1;
-	u32 in_size, in_offs, out_size, out_offs, val;
+	u32 in_size, in_offs, out_size, out_offs;
 	u32 in_w = buf->in_width, in_h = buf->in_height;
 	u32 out_w = buf->out_width, out_h = buf->out_height;
 	u32 density, mesh_size;
-	void __iomem *base = fec->hw->base_addr;
 	void *mem;
 	int ret = -EINVAL;
-	ktime_t t = 0;
-	s64 us = 0;
 
 	if (rkispp_debug)
-		t = ktime_get();
+		job->t = ktime_get();
 	v4l2_dbg(3, rkispp_debug, &fec->v4l2_dev,
 		 "%s enter %dx%d->%dx%d format(in:%c%c%c%c out:%c%c%c%c)\n",
 		 __func__, in_w, in_h, out_w, out_h,
@@ -146,7 +298,6 @@ static int fec_running(struct file *file, struct rkispp_fec_in_out *buf)
 	if (clk_get_rate(fec->hw->clks[0]) <= fec->hw->core_clk_min)
 		rkispp_set_clk_rate(fec->hw->clks[0], fec->hw->core_clk_max);
 
-	init_completion(&fec->cmpl);
 	density = out_w > 1920 ? SW_MESH_DENSITY : 0;
 	mesh_size = cal_fec_mesh(out_w, out_h, !!density);
 
@@ -218,61 +369,82 @@ static int fec_running(struct file *file, struct rkispp_fec_in_out *buf)
 	mem = fec_buf_add(file, buf->in_pic_fd, in_size);
 	if (!mem)
 		goto free_buf;
-	val = *((dma_addr_t *)g_ops->cookie(mem));
-	writel(val, base + RKISPP_FEC_RD_Y_BASE);
-	val += in_offs;
-	writel(val, base + RKISPP_FEC_RD_UV_BASE);
+	job->in_y = fec_buf_addr(mem);
+	job->in_uv = job->in_y + in_offs;
 
 	/* output picture buf */
 	mem = fec_buf_add(file, buf->out_pic_fd, out_size);
 	if (!mem)
 		goto free_buf;
-	val = *((dma_addr_t *)g_ops->cookie(mem));
-	writel(val, base + RKISPP_FEC_WR_Y_BASE);
-	val += out_offs;
-	writel(val, base + RKISPP_FEC_WR_UV_BASE);
-
-	/* mesh xint buf */
-	mem = fec_buf_add(file, buf->mesh_xint_fd, mesh_size * 2);
-	if (!mem)
-		goto free_buf;
-	val = *((dma_addr_t *)g_ops->cookie(mem));
-	writel(val, base + RKISPP_FEC_MESH_XINT_BASE);
+	job->out_y = fec_buf_addr(mem);
+	job->out_uv = job->out_y + out_offs;
+
+	if (mesh_id >= 0) {
+		/* mesh cached by geometry id */
+		ret = fec_mesh_get(fec, file, mesh_id, buf->out_width,
+				   buf->out_height, job->mesh);
+		if (ret)
+			return ret;
+	} else {
+		/* mesh xint buf */
+		mem = fec_buf_add(file, buf->mesh_xint_fd, mesh_size * 2);
+		if (!mem)
+			goto free_buf;
+		job->mesh[0] = fec_buf_addr(mem);
+
+		/* mesh xfra buf */
+		mem = fec_buf_add(file, buf->mesh_xfra_fd, mesh_size);
+		if (!mem)
+			goto free_buf;
+		job->mesh[1] = fec_buf_addr(mem);
+
+		/* mesh yint buf */
+		mem = fec_buf_add(file, buf->mesh_yint_fd, mesh_size * 2);
+		if (!mem)
+			goto free_buf;
+		job->mesh[2] = fec_buf_addr(mem);
+
+		/* mesh yfra buf */
+		mem = fec_buf_add(file, buf->mesh_yfra_fd, mesh_size);
+		if (!mem)
+			goto free_buf;
+		job->mesh[3] = fec_buf_addr(mem);
+	}
 
-	/* mesh xfra buf */
-	mem = fec_buf_add(file, buf->mesh_xfra_fd, mesh_size);
-	if (!mem)
-		goto free_buf;
-	val = *((dma_addr_t *)g_ops->cookie(mem));
-	writel(val, base + RKISPP_FEC_MESH_XFRA_BASE);
+	job->ctrl = out_fmt << 4 | in_fmt;
+	job->rd_stride = ALIGN(in_w * in_mult, 16) >> 2;
+	job->wr_stride = ALIGN(out_w * out_mult, 16) >> 2;
+	job->dst_size = out_h << 16 | out_w;
+	job->src_size = in_h << 16 | in_w;
+	job->mesh_size = mesh_size;
+	job->core_ctrl = SW_FEC_EN | density;
+	return 0;
+free_buf:
+	fec_buf_del(file, 0, true);
+	return ret;
+}
 
-	/* mesh yint buf */
-	mem = fec_buf_add(file, buf->mesh_yint_fd, mesh_size * 2);
-	if (!mem)
-		goto free_buf;
-	val = *((dma_addr_t *)g_ops->cookie(mem));
-	writel(val, base + RKISPP_FEC_MESH_YINT_BASE);
+/* with job_lock held, from process, irq or fence callback context */
+static void fec_job_hw_start(struct rkispp_fec_dev *fec, struct rkispp_fec_job *job)
+{
+	void __iomem *base = fec->hw->base_addr;
 
-	/* mesh yfra buf */
-	mem = fec_buf_add(file, buf->mesh_yfra_fd, mesh_size);
-	if (!mem)
-		goto free_buf;
-	val = *((dma_addr_t *)g_ops->cookie(mem));
-	writel(val, base + RKISPP_FEC_MESH_YFRA_BASE);
-
-	val = out_fmt << 4 | in_fmt;
-	writel(val, base + RKISPP_FEC_CTRL);
-	val = ALIGN(in_w * in_mult, 16) >> 2;
-	writel(val, base + RKISPP_FEC_RD_VIR_STRIDE);
-	val = ALIGN(out_w * out_mult, 16) >> 2;
-	writel(val, base + RKISPP_FEC_WR_VIR_STRIDE);
-	val = out_h << 16 | out_w;
-	writel(val, base + RKISPP_FEC_DST_SIZE);
-	val = in_h << 16 | in_w;
-	writel(val, base + RKISPP_FEC_SRC_SIZE);
-	writel(mesh_size, base + RKISPP_FEC_MESH_SIZE);
-	val = SW_FEC_EN | density;
-	writel(val, base + RKISPP_FEC_CORE_CTRL);
+	writel(job->in_y, base + RKISPP_FEC_RD_Y_BASE);
+	writel(job->in_uv, base + RKISPP_FEC_RD_UV_BASE);
+	writel(job->out_y, base + RKISPP_FEC_WR_Y_BASE);
+	writel(job->out_uv, base + RKISPP_FEC_WR_UV_BASE);
+	writel(job->mesh[0], base + RKISPP_FEC_MESH_XINT_BASE);
+	writel(job->mesh[1], base + RKISPP_FEC_MESH_XFRA_BASE);
+	writel(job->mesh[2], base + RKISPP_FEC_MESH_YINT_BASE);
+	writel(job->mesh[3], base + RKISPP_FEC_MESH_YFRA_BASE);
+
+	writel(job->ctrl, base + RKISPP_FEC_CTRL);
+	writel(job->rd_stride, base + RKISPP_FEC_RD_VIR_STRIDE);
+	writel(job->wr_stride, base + RKISPP_FEC_WR_VIR_STRIDE);
+	writel(job->dst_size, base + RKISPP_FEC_DST_SIZE);
+	writel(job->src_size, base + RKISPP_FEC_SRC_SIZE);
+	writel(job->mesh_size, base + RKISPP_FEC_MESH_SIZE);
+	writel(job->core_ctrl, base + RKISPP_FEC_CORE_CTRL);
 
 	writel(FEC_FORCE_UPD, base + RKISPP_CTRL_UPDATE);
 	v4l2_dbg(3, rkispp_debug, &fec->v4l2_dev,
@@ -298,22 +470,239 @@ static int fec_running(struct file *file, struct rkispp_fec_in_out *buf)
 	if (!fec->hw->is_shutdown)
 		writel(FEC_ST, base + RKISPP_CTRL_STRT);
 
-	ret = wait_for_completion_timeout(&fec->cmpl, msecs_to_jiffies(300));
-	if (!ret) {
-		v4l2_err(&fec->v4l2_dev, "fec working timeout\n");
-		ret = -EAGAIN;
-	} else {
-		ret = 0;
+	fec->cur_deadline = jiffies + msecs_to_jiffies(FEC_JOB_TIMEOUT_MS);
+	mod_delayed_work(system_wq, &fec->watchdog,
+			 msecs_to_jiffies(FEC_JOB_TIMEOUT_MS));
+}
+
+/* start the head of the queue if the hardware is free, job_lock held */
+static void fec_job_kick(struct rkispp_fec_dev *fec)
+{
+	struct rkispp_fec_job *job;
+
+	if (fec->cur_job || list_empty(&fec->job_list))
+		return;
+
+	job = list_first_entry(&fec->job_list, struct rkispp_fec_job, list);
+	if (!job->ready)
+		return;
+
+	list_del_init(&job->list);
+	fec->cur_job = job;
+	fec_job_hw_start(fec, job);
+}
+
+static void fec_job_finish(struct rkispp_fec_job *job, int ret)
+{
+	job->ret = ret;
+
+	if (job->in_fence)
+		dma_fence_put(job->in_fence);
+	if (job->out_fence) {
+		if (ret)
+			dma_fence_set_error(job->out_fence, ret);
+		dma_fence_signal(job->out_fence);
+		dma_fence_put(job->out_fence);
 	}
-	writel(SW_FEC2DDR_DIS, base + RKISPP_FEC_CORE_CTRL);
+
+	/* a synchronous job lives on the stack of its waiter */
+	if (job->async)
+		kfree(job);
+	else
+		complete(&job->cmpl);
+}
+
+static void __fec_job_done(struct rkispp_fec_dev *fec, int ret)
+{
+	struct rkispp_fec_job *job = fec->cur_job;
+	s64 us = 0;
+
+	if (!job)
+		return;
+
+	fec->cur_job = NULL;
+	writel(SW_FEC2DDR_DIS, fec->hw->base_addr + RKISPP_FEC_CORE_CTRL);
 
 	if (rkispp_debug)
-		us = ktime_us_delta(ktime_get(), t);
+		us = ktime_us_delta(ktime_get(), job->t);
 	v4l2_dbg(3, rkispp_debug, &fec->v4l2_dev,
 		 "%s exit ret:%d, time:%lldus\n", __func__, ret, us);
-	return ret;
-free_buf:
-	fec_buf_del(file, 0, true);
+
+	fec_job_finish(job, ret);
+	fec_job_kick(fec);
+	wake_up_all(&fec->idle_wait);
+}
+
+static void fec_job_watchdog(struct work_struct *work)
+{
+	struct rkispp_fec_dev *fec =
+		container_of(to_delayed_work(work), struct rkispp_fec_dev, watchdog);
+	unsigned long flags;
+
+	spin_lock_irqsave(&fec->job_lock, flags);
+	if (fec->cur_job && time_after_eq(jiffies, fec->cur_deadline)) {
+		v4l2_err(&fec->v4l2_dev, "fec working timeout\n");
+		__fec_job_done(fec, -EAGAIN);
+	}
+	spin_unlock_irqrestore(&fec->job_lock, flags);
+}
+
+static void fec_job_in_fence_cb(struct dma_fence *fence, struct dma_fence_cb *cb)
+{
+	struct rkispp_fec_job *job = container_of(cb, struct rkispp_fec_job, in_cb);
+	struct rkispp_fec_dev *fec = job->fec;
+	unsigned long flags;
+
+	spin_lock_irqsave(&fec->job_lock, flags);
+	job->ready = true;
+	fec_job_kick(fec);
+	spin_unlock_irqrestore(&fec->job_lock, flags);
+}
+
+static void fec_job_queue(struct rkispp_fec_dev *fec, struct rkispp_fec_job *job)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&fec->job_lock, flags);
+	job->ready = !job->in_fence;
+	list_add_tail(&job->list, &fec->job_list);
+	fec_job_kick(fec);
+	spin_unlock_irqrestore(&fec->job_lock, flags);
+
+	/* fence callbacks take job_lock under the fence lock */
+	if (job->in_fence &&
+	    dma_fence_add_callback(job->in_fence, &job->in_cb, fec_job_in_fence_cb))
+		fec_job_in_fence_cb(job->in_fence, &job->in_cb);
+}
+
+static bool fec_job_idle(struct rkispp_fec_dev *fec)
+{
+	unsigned long flags;
+	bool idle;
+
+	spin_lock_irqsave(&fec->job_lock, flags);
+	idle = !fec->cur_job && list_empty(&fec->job_list);
+	spin_unlock_irqrestore(&fec->job_lock, flags);
+
+	return idle;
+}
+
+/* wait for the queue to drain, cancel what still waits on in fences */
+static void fec_job_flush(struct rkispp_fec_dev *fec)
+{
+	struct rkispp_fec_job *job, *next;
+	unsigned long flags;
+	LIST_HEAD(cancel);
+
+	if (wait_event_timeout(fec->idle_wait, fec_job_idle(fec),
+			       msecs_to_jiffies(FEC_FLUSH_TIMEOUT_MS)))
+		return;
+
+	spin_lock_irqsave(&fec->job_lock, flags);
+	list_splice_init(&fec->job_list, &cancel);
+	spin_unlock_irqrestore(&fec->job_lock, flags);
+
+	list_for_each_entry_safe(job, next, &cancel, list) {
+		v4l2_warn(&fec->v4l2_dev, "cancel fec job still waiting\n");
+		list_del_init(&job->list);
+		/* once removed or already run, the callback is done with job */
+		if (job->in_fence)
+			dma_fence_remove_callback(job->in_fence, &job->in_cb);
+		fec_job_finish(job, -ECANCELED);
+	}
+}
+
+static const char *fec_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "rkispp";
+}
+
+static const char *fec_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "fec";
+}
+
+static const struct dma_fence_ops fec_fence_ops = {
+	.get_driver_name = fec_fence_get_driver_name,
+	.get_timeline_name = fec_fence_get_timeline_name,
+};
+
+static int fec_running(struct file *file, struct rkispp_fec_in_out *buf)
+{
+	struct rkispp_fec_dev *fec = video_drvdata(file);
+	struct rkispp_fec_job job = { .fec = fec };
+	int ret;
+
+	ret = fec_job_prepare(file, buf, -1, &job);
+	if (ret)
+		return ret;
+
+	init_completion(&job.cmpl);
+	fec_job_queue(fec, &job);
+	wait_for_completion(&job.cmpl);
+
+	return job.ret;
+}
+
+static int fec_running_async(struct file *file, struct rkispp_fec_in_out_async *req)
+{
+	struct rkispp_fec_dev *fec = video_drvdata(file);
+	struct rkispp_fec_job *job;
+	struct sync_file *sync_file;
+	int fd, ret;
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job)
+		return -ENOMEM;
+	job->fec = fec;
+	job->async = true;
+
+	ret = fec_job_prepare(file, &req->io, req->mesh_id, job);
+	if (ret)
+		goto free_job;
+
+	if (req->in_fence_fd >= 0) {
+		job->in_fence = sync_file_get_fence(req->in_fence_fd);
+		if (!job->in_fence) {
+			v4l2_err(&fec->v4l2_dev, "invalid in fence fd:%d\n",
+				 req->in_fence_fd);
+			ret = -EINVAL;
+			goto free_job;
+		}
+	}
+
+	job->out_fence = kzalloc(sizeof(*job->out_fence), GFP_KERNEL);
+	if (!job->out_fence) {
+		ret = -ENOMEM;
+		goto put_in_fence;
+	}
+	dma_fence_init(job->out_fence, &fec_fence_ops, &fec->fence_lock,
+		       fec->fence_context, ++fec->fence_seqno);
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		ret = fd;
+		goto put_out_fence;
+	}
+	sync_file = sync_file_create(job->out_fence);
+	if (!sync_file) {
+		put_unused_fd(fd);
+		ret = -ENOMEM;
+		goto put_out_fence;
+	}
+	req->out_fence_fd = fd;
+
+	/* the sync file holds its own reference, the job may be gone already */
+	fec_job_queue(fec, job);
+	fd_install(fd, sync_file->file);
+	return 0;
+put_out_fence:
+	dma_fence_put(job->out_fence);
+put_in_fence:
+	if (job->in_fence)
+		dma_fence_put(job->in_fence);
+free_job:
+	kfree(job);
 	return ret;
 }
 
@@ -329,6 +718,12 @@ static long fec_ioctl_default(struct file *file, void *fh,
 	case RKISPP_CMD_FEC_IN_OUT:
 		ret = fec_running(file, arg);
 		break;
+	case RKISPP_CMD_FEC_IN_OUT_ASYNC:
+		ret = fec_running_async(file, arg);
+		break;
+	case RKISPP_CMD_FEC_MESH_SET:
+		ret = fec_mesh_set(file, arg);
+		break;
 	case RKISPP_CMD_FEC_BUF_ADD:
 		if (!fec_buf_add(file, *(int *)arg, 0))
 			ret = -ENOMEM;
@@ -405,8 +800,9 @@ void rkispp_fec_irq(struct rkispp_hw_dev *hw)
 	v4l2_dbg(3, rkispp_debug, &hw->fec_dev.v4l2_dev,
 		 "%s\n", __func__);
 
-	if (!completion_done(&hw->fec_dev.cmpl))
-		complete(&hw->fec_dev.cmpl);
+	spin_lock(&hw->fec_dev.job_lock);
+	__fec_job_done(&hw->fec_dev, 0);
+	spin_unlock(&hw->fec_dev.job_lock);
 }
 
 int rkispp_register_fec(struct rkispp_hw_dev *hw)
@@ -440,6 +836,13 @@ int rkispp_register_fec(struct rkispp_hw_dev *hw)
 	}
 	video_set_drvdata(vfd, fec);
 	INIT_LIST_HEAD(&fec->list);
+	INIT_LIST_HEAD(&fec->mesh_list);
+	INIT_LIST_HEAD(&fec->job_list);
+	spin_lock_init(&fec->job_lock);
+	spin_lock_init(&fec->fence_lock);
+	INIT_DELAYED_WORK(&fec->watchdog, fec_job_watchdog);
+	init_waitqueue_head(&fec->idle_wait);
+	fec->fence_context = dma_fence_context_alloc(1);
 	return 0;
 unreg_v4l2:
 	mutex_destroy(&fec->apilock);
@@ -452,6 +855,7 @@ void rkispp_unregister_fec(struct rkispp_hw_dev *hw)
 	if (!IS_ENABLED(CONFIG_VIDEO_ROCKCHIP_ISPP_FEC))
 		return;
 
+	cancel_delayed_work_sync(&hw->fec_dev.watchdog);
 	mutex_destroy(&hw->fec_dev.apilock);
 	video_unregister_device(&hw->fec_dev.vfd);
 	v4l2_device_unregister(&hw->fec_dev.v4l2_dev);
@@ -4,15 +4,30 @@
 #ifndef _RKISPP_FEC_H
 #define _RKISPP_FEC_H
 
+#include <linux/workqueue.h>
 #include "hw.h"
 
+struct rkispp_fec_job;
+
 struct rkispp_fec_dev {
 	struct rkispp_hw_dev *hw;
 	struct v4l2_device v4l2_dev;
 	struct video_device vfd;
 	struct mutex apilock;
-	struct completion cmpl;
 	struct list_head list;
+	/* meshes by geometry id, under hw->dev_lock like list */
+	struct list_head mesh_list;
+	/* queued jobs and the one on the hardware */
+	spinlock_t job_lock;
+	struct list_head job_list;
+	struct rkispp_fec_job *cur_job;
+	unsigned long cur_deadline;
+	struct delayed_work watchdog;
+	wait_queue_head_t idle_wait;
+	/* out fences of async jobs */
+	spinlock_t fence_lock;
+	u64 fence_context;
+	u32 fence_seqno;
 };
 
 #if IS_ENABLED(CONFIG_VIDEO_ROCKCHIP_ISPP_FEC)
@@ -97,21 +97,12 @@ static void rga_buf_stop_streaming(struct vb2_queue *q)
 	pm_runtime_put(rga->dev);
 }
 
-const struct vb2_ops rga_qops = {
-	.queue_setup = rga_queue_setup,
-	.buf_prepare = rga_buf_prepare,
-	.buf_queue = rga_buf_queue,
-	.wait_prepare = vb2_ops_wait_prepare,
-	.wait_finish = vb2_ops_wait_finish,
-	.start_streaming = rga_buf_start_streaming,
-	.stop_streaming = rga_buf_stop_streaming,
-};
-
 /* RGA MMU is a 1-Level MMU, so it can't be used through the IOMMU API.
  * We use it more like a scatter-gather list.
  */
-void rga_buf_map(struct vb2_buffer *vb)
+static int rga_buf_init(struct vb2_buffer *vb)
 {
+	struct rga_buffer *buf = to_rga_buffer(to_vb2_v4l2_buffer(vb));
 	struct rga_ctx *ctx = vb2_get_drv_priv(vb->vb2_queue);
 	struct rockchip_rga *rga = ctx->rga;
 	struct sg_table *sgt;
@@ -119,20 +110,25 @@ void rga_buf_map(struct vb2_buffer *vb)
 	unsigned int *pages;
 	unsigned int address, len, i, p;
 	unsigned int mapped_size = 0;
-
-	if (vb->type == V4L2_BUF_TYPE_VIDEO_OUTPUT)
-		pages = rga->src_mmu_pages;
-	else
-		pages = rga->dst_mmu_pages;
+	size_t size;
 
 	/* Create local MMU table for RGA */
 	sgt = vb2_plane_cookie(vb, 0);
+	if (!sgt)
+		return -EINVAL;
+
+	size = PAGE_ALIGN(vb2_plane_size(vb, 0)) >> PAGE_SHIFT;
+	buf->mmu_order = get_order(size * sizeof(*pages));
+	pages = (unsigned int *)__get_free_pages(GFP_KERNEL | __GFP_ZERO,
+						 buf->mmu_order);
+	if (!pages)
+		return -ENOMEM;
 
 	for_each_sg(sgt->sgl, sgl, sgt->nents, i) {
 		len = sg_dma_len(sgl) >> PAGE_SHIFT;
 		address = sg_phys(sgl);
 
-		for (p = 0; p < len; p++) {
+		for (p = 0; p < len && mapped_size + p < size; p++) {
 			dma_addr_t phys = address +
 					  ((dma_addr_t)p << PAGE_SHIFT);
 
@@ -144,5 +140,32 @@ void rga_buf_map(struct vb2_buffer *vb)
 
 	/* sync local MMU table for RGA */
 	dma_sync_single_for_device(rga->dev, virt_to_phys(pages),
-				   8 * PAGE_SIZE, DMA_BIDIRECTIONAL);
+				   PAGE_SIZE << buf->mmu_order,
+				   DMA_BIDIRECTIONAL);
+	buf->mmu_pages = pages;
+
+	return 0;
 }
+
+static void rga_buf_cleanup(struct vb2_buffer *vb)
+{
+	struct rga_buffer *buf = to_rga_buffer(to_vb2_v4l2_buffer(vb));
+
+	if (!buf->mmu_pages)
+		return;
+
+	free_pages((unsigned long)buf->mmu_pages, buf->mmu_order);
+	buf->mmu_pages = NULL;
+}
+
+const struct vb2_ops rga_qops = {
+	.queue_setup = rga_queue_setup,
+	.buf_init = rga_buf_init,
+	.buf_prepare = rga_buf_prepare,
+	.buf_queue = rga_buf_queue,
+	.buf_cleanup = rga_buf_cleanup,
+	.wait_prepare = vb2_ops_wait_prepare,
+	.wait_finish = vb2_ops_wait_finish,
+	.start_streaming = rga_buf_start_streaming,
+	.stop_streaming = rga_buf_stop_streaming,
+};
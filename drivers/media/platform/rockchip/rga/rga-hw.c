@@ -119,10 +119,8 @@ static struct rga_addr_offset *rga_lookup_draw_pos(struct
 	return NULL;
 }
 
-static void rga_cmd_set_src_addr(struct rga_ctx *ctx, void *mmu_pages)
+static void rga_cmd_set_src_addr(u32 *dest, void *mmu_pages)
 {
-	struct rockchip_rga *rga = ctx->rga;
-	u32 *dest = rga->cmdbuf_virt;
 	unsigned int reg;
 
 	reg = RGA_MMU_SRC_BASE - RGA_MODE_BASE_REG;
@@ -132,10 +130,8 @@ static void rga_cmd_set_src_addr(struct rga_ctx *ctx, void *mmu_pages)
 	dest[reg >> 2] |= 0x7;
 }
 
-static void rga_cmd_set_src1_addr(struct rga_ctx *ctx, void *mmu_pages)
+static void rga_cmd_set_src1_addr(u32 *dest, void *mmu_pages)
 {
-	struct rockchip_rga *rga = ctx->rga;
-	u32 *dest = rga->cmdbuf_virt;
 	unsigned int reg;
 
 	reg = RGA_MMU_SRC1_BASE - RGA_MODE_BASE_REG;
@@ -145,10 +141,8 @@ static void rga_cmd_set_src1_addr(struct rga_ctx *ctx, void *mmu_pages)
 	dest[reg >> 2] |= 0x7 << 4;
 }
 
-static void rga_cmd_set_dst_addr(struct rga_ctx *ctx, void *mmu_pages)
+static void rga_cmd_set_dst_addr(u32 *dest, void *mmu_pages)
 {
-	struct rockchip_rga *rga = ctx->rga;
-	u32 *dest = rga->cmdbuf_virt;
 	unsigned int reg;
 
 	reg = RGA_MMU_DST_BASE - RGA_MODE_BASE_REG;
@@ -158,10 +152,10 @@ static void rga_cmd_set_dst_addr(struct rga_ctx *ctx, void *mmu_pages)
 	dest[reg >> 2] |= 0x7 << 8;
 }
 
-static void rga_cmd_set_trans_info(struct rga_ctx *ctx)
+static void rga_cmd_set_trans_info(struct rga_ctx *ctx, u32 *dest,
+				   const struct v4l2_rect *out_rect)
 {
 	struct rockchip_rga *rga = ctx->rga;
-	u32 *dest = rga->cmdbuf_virt;
 	unsigned int scale_dst_w, scale_dst_h;
 	unsigned int src_h, src_w, src_x, src_y, dst_h, dst_w, dst_x, dst_y;
 	union rga_src_info src_info;
@@ -181,10 +175,10 @@ static void rga_cmd_set_trans_info(struct rga_ctx *ctx)
 	src_w = ctx->in.crop.width;
 	src_x = ctx->in.crop.left;
 	src_y = ctx->in.crop.top;
-	dst_h = ctx->out.crop.height;
-	dst_w = ctx->out.crop.width;
-	dst_x = ctx->out.crop.left;
-	dst_y = ctx->out.crop.top;
+	dst_h = out_rect->height;
+	dst_w = out_rect->width;
+	dst_x = out_rect->left;
+	dst_y = out_rect->top;
 
 	src_info.val = dest[(RGA_SRC_INFO - RGA_MODE_BASE_REG) >> 2];
 	dst_info.val = dest[(RGA_DST_INFO - RGA_MODE_BASE_REG) >> 2];
@@ -352,10 +346,8 @@ static void rga_cmd_set_trans_info(struct rga_ctx *ctx)
 	dest[(RGA_DST_INFO - RGA_MODE_BASE_REG) >> 2] = dst_info.val;
 }
 
-static void rga_cmd_set_mode(struct rga_ctx *ctx)
+static void rga_cmd_set_mode(u32 *dest)
 {
-	struct rockchip_rga *rga = ctx->rga;
-	u32 *dest = rga->cmdbuf_virt;
 	union rga_mode_ctrl mode;
 	union rga_alpha_ctrl0 alpha_ctrl0;
 	union rga_alpha_ctrl1 alpha_ctrl1;
@@ -375,36 +367,35 @@ static void rga_cmd_set_mode(struct rga_ctx *ctx)
 	dest[(RGA_MODE_CTRL - RGA_MODE_BASE_REG) >> 2] = mode.val;
 }
 
-static void rga_cmd_set(struct rga_ctx *ctx)
+/*
+ * rga_hw_set_cmd - build command @idx of the job, @src scaled into
+ * @out_rect of @dst
+ */
+void rga_hw_set_cmd(struct rga_ctx *ctx, unsigned int idx,
+		    struct rga_buffer *src, struct rga_buffer *dst,
+		    const struct v4l2_rect *out_rect)
 {
 	struct rockchip_rga *rga = ctx->rga;
+	u32 *dest = (u32 *)rga->cmdbuf_virt + idx * RGA_CMDBUF_SIZE;
 
-	memset(rga->cmdbuf_virt, 0, RGA_CMDBUF_SIZE * 4);
+	memset(dest, 0, RGA_CMDBUF_SIZE * 4);
 
-	rga_cmd_set_src_addr(ctx, rga->src_mmu_pages);
+	rga_cmd_set_src_addr(dest, src->mmu_pages);
 	/*
 	 * Due to hardware bug,
 	 * src1 mmu also should be configured when using alpha blending.
 	 */
-	rga_cmd_set_src1_addr(ctx, rga->dst_mmu_pages);
+	rga_cmd_set_src1_addr(dest, dst->mmu_pages);
 
-	rga_cmd_set_dst_addr(ctx, rga->dst_mmu_pages);
-	rga_cmd_set_mode(ctx);
+	rga_cmd_set_dst_addr(dest, dst->mmu_pages);
+	rga_cmd_set_mode(dest);
 
-	rga_cmd_set_trans_info(ctx);
-
-	rga_write(rga, RGA_CMD_BASE, rga->cmdbuf_phy);
-
-	/* sync CMD buf for RGA */
-	dma_sync_single_for_device(rga->dev, rga->cmdbuf_phy,
-		PAGE_SIZE, DMA_BIDIRECTIONAL);
+	rga_cmd_set_trans_info(ctx, dest, out_rect);
 }
 
-void rga_hw_start(struct rockchip_rga *rga)
+static void rga_hw_run(struct rockchip_rga *rga, unsigned int idx, u32 cmd_ctrl)
 {
-	struct rga_ctx *ctx = rga->curr;
-
-	rga_cmd_set(ctx);
+	rga_write(rga, RGA_CMD_BASE, rga->cmdbuf_phy + idx * RGA_CMDBUF_SIZE * 4);
 
 	rga_write(rga, RGA_SYS_CTRL, 0x00);
 
@@ -412,5 +403,34 @@ void rga_hw_start(struct rockchip_rga *rga)
 
 	rga_write(rga, RGA_INT, 0x600);
 
-	rga_write(rga, RGA_CMD_CTRL, 0x1);
+	rga_write(rga, RGA_CMD_CTRL, cmd_ctrl);
+}
+
+/*
+ * rga_hw_start - run the @count commands built with rga_hw_set_cmd()
+ *
+ * With @cmd_list the hardware walks the whole command line and raises a
+ * single all commands done interrupt, otherwise rga_hw_start_next() runs
+ * the next command from the interrupt of the previous one.
+ */
+void rga_hw_start(struct rockchip_rga *rga, unsigned int count, bool cmd_list)
+{
+	u32 cmd_ctrl = RGA_CMD_CTRL_LINE_START;
+
+	/* sync CMD buf for RGA */
+	dma_sync_single_for_device(rga->dev, rga->cmdbuf_phy,
+		RGA_CMDBUF_SIZE * 4 * count, DMA_BIDIRECTIONAL);
+
+	rga->cmd_count = count;
+	rga->cmd_next = cmd_list ? count : 1;
+	if (cmd_list && count > 1)
+		cmd_ctrl |= RGA_CMD_CTRL_INCR_VALID |
+			    RGA_CMD_CTRL_INCR_NUM(count - 1);
+
+	rga_hw_run(rga, 0, cmd_ctrl);
+}
+
+void rga_hw_start_next(struct rockchip_rga *rga)
+{
+	rga_hw_run(rga, rga->cmd_next++, RGA_CMD_CTRL_LINE_START);
 }
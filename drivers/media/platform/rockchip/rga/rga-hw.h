@@ -8,6 +8,10 @@
 
 #define RGA_CMDBUF_SIZE 0x20
 
+/* commands of one job, one per source tile */
+#define RGA_MAX_TILES 16
+#define RGA_CMDBUF_BYTES (RGA_CMDBUF_SIZE * 4 * RGA_MAX_TILES)
+
 /* Hardware limits */
 #define MAX_WIDTH 8192
 #define MAX_HEIGHT 8192
@@ -66,6 +70,11 @@
 #define RGA_MMU_SRC1_BASE 0x0174
 #define RGA_MMU_DST_BASE 0x0178
 
+/* RGA_CMD_CTRL */
+#define RGA_CMD_CTRL_LINE_START BIT(0)
+#define RGA_CMD_CTRL_INCR_VALID BIT(1)
+#define RGA_CMD_CTRL_INCR_NUM(n) (((n) & 0x3ff) << 3)
+
 /* Registers value */
 #define RGA_MODE_RENDER_BITBLT 0
 #define RGA_MODE_RENDER_COLOR_PALETTE 1
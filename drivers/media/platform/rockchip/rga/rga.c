@@ -31,24 +31,70 @@
 static int debug;
 module_param(debug, int, 0644);
 
+/*
+ * run the commands of a tiled job as one incremental command line
+ * (CMD_CTRL incr num), 0 starts each command from the previous interrupt
+ */
+static bool cmd_list = true;
+module_param(cmd_list, bool, 0644);
+MODULE_PARM_DESC(cmd_list, "Run all tiles of a job as one command line");
+
+static void rga_tile_rect(struct rga_ctx *ctx, unsigned int idx,
+			  unsigned int tiles, unsigned int cols,
+			  struct v4l2_rect *rect)
+{
+	const struct v4l2_rect *crop = &ctx->out.crop;
+	unsigned int rows = DIV_ROUND_UP(tiles, cols);
+	unsigned int w = ALIGN_DOWN(crop->width / cols, 2);
+	unsigned int h = ALIGN_DOWN(crop->height / rows, 2);
+
+	rect->left = crop->left + (idx % cols) * w;
+	rect->top = crop->top + (idx / cols) * h;
+	rect->width = w;
+	rect->height = h;
+}
+
+static int job_ready(void *prv)
+{
+	struct rga_ctx *ctx = prv;
+
+	return v4l2_m2m_num_src_bufs_ready(ctx->fh.m2m_ctx) >= ctx->tiles;
+}
+
 static void device_run(void *prv)
 {
 	struct rga_ctx *ctx = prv;
 	struct rockchip_rga *rga = ctx->rga;
-	struct vb2_v4l2_buffer *src, *dst;
+	struct v4l2_m2m_buffer *b;
+	struct rga_buffer *dst;
+	struct v4l2_rect rect;
+	unsigned int tiles, cols, i = 0;
 	unsigned long flags;
 
 	spin_lock_irqsave(&rga->ctrl_lock, flags);
 
 	rga->curr = ctx;
 
-	src = v4l2_m2m_next_src_buf(ctx->fh.m2m_ctx);
-	dst = v4l2_m2m_next_dst_buf(ctx->fh.m2m_ctx);
+	tiles = ctx->tiles;
+	cols = ctx->tile_cols ? min(ctx->tile_cols, tiles) :
+				int_sqrt(tiles - 1) + 1;
+	dst = to_rga_buffer(v4l2_m2m_next_dst_buf(ctx->fh.m2m_ctx));
 
-	rga_buf_map(&src->vb2_buf);
-	rga_buf_map(&dst->vb2_buf);
+	if (tiles == 1) {
+		rga_hw_set_cmd(ctx, 0,
+			       to_rga_buffer(v4l2_m2m_next_src_buf(ctx->fh.m2m_ctx)),
+			       dst, &ctx->out.crop);
+	} else {
+		v4l2_m2m_for_each_src_buf(ctx->fh.m2m_ctx, b) {
+			if (i == tiles)
+				break;
+			rga_tile_rect(ctx, i, tiles, cols, &rect);
+			rga_hw_set_cmd(ctx, i++, to_rga_buffer(&b->vb), dst,
+				       &rect);
+		}
+	}
 
-	rga_hw_start(rga);
+	rga_hw_start(rga, tiles, cmd_list);
 
 	spin_unlock_irqrestore(&rga->ctrl_lock, flags);
 }
@@ -65,23 +111,35 @@ static irqreturn_t rga_isr(int irq, void *prv)
 	if (intr & 0x04) {
 		struct vb2_v4l2_buffer *src, *dst;
 		struct rga_ctx *ctx = rga->curr;
+		unsigned int i;
 
 		WARN_ON(!ctx);
 
+		if (rga->cmd_next < rga->cmd_count) {
+			rga_hw_start_next(rga);
+			return IRQ_HANDLED;
+		}
+
 		rga->curr = NULL;
 
-		src = v4l2_m2m_src_buf_remove(ctx->fh.m2m_ctx);
 		dst = v4l2_m2m_dst_buf_remove(ctx->fh.m2m_ctx);
-
-		WARN_ON(!src);
 		WARN_ON(!dst);
 
-		dst->timecode = src->timecode;
-		dst->vb2_buf.timestamp = src->vb2_buf.timestamp;
-		dst->flags &= ~V4L2_BUF_FLAG_TSTAMP_SRC_MASK;
-		dst->flags |= src->flags & V4L2_BUF_FLAG_TSTAMP_SRC_MASK;
+		for (i = 0; i < rga->cmd_count; i++) {
+			src = v4l2_m2m_src_buf_remove(ctx->fh.m2m_ctx);
+			WARN_ON(!src);
+
+			if (!i) {
+				dst->timecode = src->timecode;
+				dst->vb2_buf.timestamp = src->vb2_buf.timestamp;
+				dst->flags &= ~V4L2_BUF_FLAG_TSTAMP_SRC_MASK;
+				dst->flags |= src->flags &
+					      V4L2_BUF_FLAG_TSTAMP_SRC_MASK;
+			}
+
+			v4l2_m2m_buf_done(src, VB2_BUF_STATE_DONE);
+		}
 
-		v4l2_m2m_buf_done(src, VB2_BUF_STATE_DONE);
 		v4l2_m2m_buf_done(dst, VB2_BUF_STATE_DONE);
 		v4l2_m2m_job_finish(rga->m2m_dev, ctx->fh.m2m_ctx);
 	}
@@ -91,6 +149,7 @@ static irqreturn_t rga_isr(int irq, void *prv)
 
 static const struct v4l2_m2m_ops rga_m2m_ops = {
 	.device_run = device_run,
+	.job_ready = job_ready,
 };
 
 static int
@@ -104,7 +163,7 @@ queue_init(void *priv, struct vb2_queue *src_vq, struct vb2_queue *dst_vq)
 	src_vq->drv_priv = ctx;
 	src_vq->ops = &rga_qops;
 	src_vq->mem_ops = &vb2_dma_sg_memops;
-	src_vq->buf_struct_size = sizeof(struct v4l2_m2m_buffer);
+	src_vq->buf_struct_size = sizeof(struct rga_buffer);
 	src_vq->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_COPY;
 	src_vq->lock = &ctx->rga->mutex;
 	src_vq->dev = ctx->rga->v4l2_dev.dev;
@@ -118,7 +177,7 @@ queue_init(void *priv, struct vb2_queue *src_vq, struct vb2_queue *dst_vq)
 	dst_vq->drv_priv = ctx;
 	dst_vq->ops = &rga_qops;
 	dst_vq->mem_ops = &vb2_dma_sg_memops;
-	dst_vq->buf_struct_size = sizeof(struct v4l2_m2m_buffer);
+	dst_vq->buf_struct_size = sizeof(struct rga_buffer);
 	dst_vq->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_COPY;
 	dst_vq->lock = &ctx->rga->mutex;
 	dst_vq->dev = ctx->rga->v4l2_dev.dev;
@@ -146,6 +205,12 @@ static int rga_s_ctrl(struct v4l2_ctrl *ctrl)
 	case V4L2_CID_BG_COLOR:
 		ctx->fill_color = ctrl->val;
 		break;
+	case V4L2_CID_RGA_TILES:
+		ctx->tiles = ctrl->val;
+		break;
+	case V4L2_CID_RGA_TILE_COLUMNS:
+		ctx->tile_cols = ctrl->val;
+		break;
 	}
 	spin_unlock_irqrestore(&ctx->rga->ctrl_lock, flags);
 	return 0;
@@ -155,11 +220,33 @@ static const struct v4l2_ctrl_ops rga_ctrl_ops = {
 	.s_ctrl = rga_s_ctrl,
 };
 
+static const struct v4l2_ctrl_config rga_ctrl_tiles = {
+	.ops = &rga_ctrl_ops,
+	.id = V4L2_CID_RGA_TILES,
+	.name = "Tiles",
+	.type = V4L2_CTRL_TYPE_INTEGER,
+	.min = 1,
+	.max = RGA_MAX_TILES,
+	.step = 1,
+	.def = 1,
+};
+
+static const struct v4l2_ctrl_config rga_ctrl_tile_cols = {
+	.ops = &rga_ctrl_ops,
+	.id = V4L2_CID_RGA_TILE_COLUMNS,
+	.name = "Tile Columns",
+	.type = V4L2_CTRL_TYPE_INTEGER,
+	.min = 0,
+	.max = RGA_MAX_TILES,
+	.step = 1,
+	.def = 0,
+};
+
 static int rga_setup_ctrls(struct rga_ctx *ctx)
 {
 	struct rockchip_rga *rga = ctx->rga;
 
-	v4l2_ctrl_handler_init(&ctx->ctrl_handler, 4);
+	v4l2_ctrl_handler_init(&ctx->ctrl_handler, 6);
 
 	v4l2_ctrl_new_std(&ctx->ctrl_handler, &rga_ctrl_ops,
 			  V4L2_CID_HFLIP, 0, 1, 1, 0);
@@ -173,6 +260,9 @@ static int rga_setup_ctrls(struct rga_ctx *ctx)
 	v4l2_ctrl_new_std(&ctx->ctrl_handler, &rga_ctrl_ops,
 			  V4L2_CID_BG_COLOR, 0, 0xffffffff, 1, 0);
 
+	v4l2_ctrl_new_custom(&ctx->ctrl_handler, &rga_ctrl_tiles, NULL);
+	v4l2_ctrl_new_custom(&ctx->ctrl_handler, &rga_ctrl_tile_cols, NULL);
+
 	if (ctx->ctrl_handler.error) {
 		int err = ctx->ctrl_handler.error;
 
@@ -879,7 +969,7 @@ static int rga_probe(struct platform_device *pdev)
 	pm_runtime_put(rga->dev);
 
 	/* Create CMD buffer */
-	rga->cmdbuf_virt = dma_alloc_attrs(rga->dev, RGA_CMDBUF_SIZE,
+	rga->cmdbuf_virt = dma_alloc_attrs(rga->dev, RGA_CMDBUF_BYTES,
 					   &rga->cmdbuf_phy, GFP_KERNEL,
 					   DMA_ATTR_WRITE_COMBINE);
 	if (!rga->cmdbuf_virt) {
@@ -887,26 +977,13 @@ static int rga_probe(struct platform_device *pdev)
 		goto rel_m2m;
 	}
 
-	rga->src_mmu_pages =
-		(unsigned int *)__get_free_pages(GFP_KERNEL | __GFP_ZERO, 3);
-	if (!rga->src_mmu_pages) {
-		ret = -ENOMEM;
-		goto free_dma;
-	}
-	rga->dst_mmu_pages =
-		(unsigned int *)__get_free_pages(GFP_KERNEL | __GFP_ZERO, 3);
-	if (!rga->dst_mmu_pages) {
-		ret = -ENOMEM;
-		goto free_src_pages;
-	}
-
 	def_frame.stride = (def_frame.width * def_frame.fmt->depth) >> 3;
 	def_frame.size = def_frame.stride * def_frame.height;
 
 	ret = video_register_device(vfd, VFL_TYPE_VIDEO, -1);
 	if (ret) {
 		v4l2_err(&rga->v4l2_dev, "Failed to register video device\n");
-		goto free_dst_pages;
+		goto free_dma;
 	}
 
 	v4l2_info(&rga->v4l2_dev, "Registered %s as /dev/%s\n",
@@ -914,12 +991,8 @@ static int rga_probe(struct platform_device *pdev)
 
 	return 0;
 
-free_dst_pages:
-	free_pages((unsigned long)rga->dst_mmu_pages, 3);
-free_src_pages:
-	free_pages((unsigned long)rga->src_mmu_pages, 3);
 free_dma:
-	dma_free_attrs(rga->dev, RGA_CMDBUF_SIZE, rga->cmdbuf_virt,
+	dma_free_attrs(rga->dev, RGA_CMDBUF_BYTES, rga->cmdbuf_virt,
 		       rga->cmdbuf_phy, DMA_ATTR_WRITE_COMBINE);
 rel_m2m:
 	v4l2_m2m_release(rga->m2m_dev);
@@ -937,12 +1010,9 @@ static int rga_remove(struct platform_device *pdev)
 {
 	struct rockchip_rga *rga = platform_get_drvdata(pdev);
 
-	dma_free_attrs(rga->dev, RGA_CMDBUF_SIZE, rga->cmdbuf_virt,
+	dma_free_attrs(rga->dev, RGA_CMDBUF_BYTES, rga->cmdbuf_virt,
 		       rga->cmdbuf_phy, DMA_ATTR_WRITE_COMBINE);
 
-	free_pages((unsigned long)rga->src_mmu_pages, 3);
-	free_pages((unsigned long)rga->dst_mmu_pages, 3);
-
 	v4l2_info(&rga->v4l2_dev, "Removing\n");
 
 	v4l2_m2m_release(rga->m2m_dev);
@@ -10,9 +10,15 @@
 #include <media/videobuf2-v4l2.h>
 #include <media/v4l2-ctrls.h>
 #include <media/v4l2-device.h>
+#include <media/v4l2-mem2mem.h>
 
 #define RGA_NAME "rockchip-rga"
 
+/* sources composed into one capture buffer, as a grid of tiles */
+#define V4L2_CID_RGA_TILES		(V4L2_CID_USER_BASE | 0x1090)
+/* grid columns, 0 picks the smallest square grid */
+#define V4L2_CID_RGA_TILE_COLUMNS	(V4L2_CID_USER_BASE | 0x1091)
+
 struct rga_fmt {
 	u32 fourcc;
 	int depth;
@@ -58,8 +64,26 @@ struct rga_ctx {
 	u32 vflip;
 	u32 rotate;
 	u32 fill_color;
+	u32 tiles;
+	u32 tile_cols;
 };
 
+/*
+ * The RGA MMU table of a buffer is built when vb2 binds memory to it
+ * (buf_init: allocation or a new dmabuf) and reused by every job until
+ * buf_cleanup, instead of being rebuilt and flushed per job.
+ */
+struct rga_buffer {
+	struct v4l2_m2m_buffer m2m_buf;
+	unsigned int *mmu_pages;
+	unsigned int mmu_order;
+};
+
+static inline struct rga_buffer *to_rga_buffer(struct vb2_v4l2_buffer *vbuf)
+{
+	return container_of(vbuf, struct rga_buffer, m2m_buf.vb);
+}
+
 struct rockchip_rga {
 	struct v4l2_device v4l2_dev;
 	struct v4l2_m2m_dev *m2m_dev;
@@ -79,17 +103,17 @@ struct rockchip_rga {
 	spinlock_t ctrl_lock;
 
 	struct rga_ctx *curr;
+	/* commands of the running job, and the next one without cmd list */
+	unsigned int cmd_count;
+	unsigned int cmd_next;
 	dma_addr_t cmdbuf_phy;
 	void *cmdbuf_virt;
-	unsigned int *src_mmu_pages;
-	unsigned int *dst_mmu_pages;
 };
 
 struct rga_frame *rga_get_frame(struct rga_ctx *ctx, enum v4l2_buf_type type);
 
 /* RGA Buffers Manage */
 extern const struct vb2_ops rga_qops;
-void rga_buf_map(struct vb2_buffer *vb);
 
 /* RGA Hardware */
 static inline void rga_write(struct rockchip_rga *rga, u32 reg, u32 value)
@@ -110,6 +134,10 @@ static inline void rga_mod(struct rockchip_rga *rga, u32 reg, u32 val, u32 mask)
 	rga_write(rga, reg, temp);
 };
 
-void rga_hw_start(struct rockchip_rga *rga);
+void rga_hw_set_cmd(struct rga_ctx *ctx, unsigned int idx,
+		    struct rga_buffer *src, struct rga_buffer *dst,
+		    const struct v4l2_rect *out_rect);
+void rga_hw_start(struct rockchip_rga *rga, unsigned int count, bool cmd_list);
+void rga_hw_start_next(struct rockchip_rga *rga);
 
 #endif
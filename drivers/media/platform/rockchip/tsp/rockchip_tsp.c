@@ -289,10 +289,17 @@ static void rockchip_feed_sec_buf(struct tsp_dev *dev)
 	int index, pid;
 	int temp;
 	int offset;
+	u64 pending;
 
 	spin_lock_irqsave(&dev->list_lock, flags);
+	pending = dev->sec_pending;
+	dev->sec_pending = 0;
 	list_for_each_entry_safe(ctx, ctx_temp, &dev->pid_list, pid_list) {
 		index = ctx->index;
+		/* only the channels that raised a section irq since last run */
+		if (ctx->filter_type == TSP_SECTION_FILTER &&
+		    !(pending & BIT_ULL(index)))
+			continue;
 		read_addr = ctx->read;
 		top_addr = ctx->top;
 		base_addr = ctx->base;
@@ -626,15 +633,26 @@ static irqreturn_t rockchip_tsp_interrupt(int irq, void *dev_id)
 	struct tsp_dev *dev = platform_get_drvdata(pdev);
 
 	if (irq == dev->tsp_irq) {
+		u64 pending;
+
 		reg_val = TSP_RD(dev, PTI0_PID_STS0);
-		if (reg_val != 0) {
+		if (reg_val != 0)
 			TSP_WR(dev, PTI0_PID_STS0, reg_val);
-			queue_work(dev->sec_queue, &dev->sec_work);
-		}
+		pending = reg_val;
 
 		reg_val = TSP_RD(dev, PTI0_PID_STS1);
-		if (reg_val != 0) {
+		if (reg_val != 0)
 			TSP_WR(dev, PTI0_PID_STS1, reg_val);
+		pending |= (u64)reg_val << 32;
+
+		/*
+		 * one work run drains the sections of all the channels that
+		 * signalled until it gets to run
+		 */
+		if (pending) {
+			spin_lock(&dev->list_lock);
+			dev->sec_pending |= pending;
+			spin_unlock(&dev->list_lock);
 			queue_work(dev->sec_queue, &dev->sec_work);
 		}
 
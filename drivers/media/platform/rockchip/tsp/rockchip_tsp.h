@@ -211,6 +211,8 @@ struct tsp_dev {
 	/* section workque */
 	struct work_struct sec_work;
 	struct workqueue_struct *sec_queue;
+	/* channels with a section irq not yet handled, under list_lock */
+	u64 sec_pending;
 
 	int tsp_start_descram;
 
@@ -21,7 +21,9 @@
 #include <linux/string.h>
 #include <linux/errno.h>
 #include <linux/init.h>
+#include <linux/io_uring.h>
 #include <linux/kmod.h>
+#include <linux/poll.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 
@@ -364,6 +366,50 @@ static long v4l2_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 	return ret;
 }
 
+/*
+ * IORING_OP_URING_CMD: cmd_op and the first u64 of the command data are the
+ * cmd and the argument of a buffer queue ioctl, so a capture loop runs from
+ * an io_uring without a syscall per frame. A dequeue that would wait goes
+ * to an io-wq worker.
+ */
+static int v4l2_uring_cmd(struct io_uring_cmd *ioucmd, unsigned int issue_flags)
+{
+	struct file *filp = ioucmd->file;
+	unsigned int cmd = ioucmd->cmd_op;
+	unsigned long arg = (unsigned long)READ_ONCE(*(const u64 *)ioucmd->cmd);
+	struct v4l2_buffer __user *ubuf = (void __user *)arg;
+	__poll_t mask;
+	u32 type;
+
+	/* the layout of v4l2_buffer differs for compat tasks */
+	if (issue_flags & IO_URING_F_COMPAT)
+		return -EOPNOTSUPP;
+
+	if (_IOC_TYPE(cmd) != 'V')
+		return -ENOTTY;
+
+	/* by number, to take the time32 variants as well */
+	switch (_IOC_NR(cmd)) {
+	case _IOC_NR(VIDIOC_QBUF):
+	case _IOC_NR(VIDIOC_PREPARE_BUF):
+		break;
+	case _IOC_NR(VIDIOC_DQBUF):
+		if (!(issue_flags & IO_URING_F_NONBLOCK) ||
+		    (filp->f_flags & O_NONBLOCK))
+			break;
+		if (get_user(type, &ubuf->type))
+			return -EFAULT;
+		mask = V4L2_TYPE_IS_OUTPUT(type) ? EPOLLOUT : EPOLLIN;
+		if (!(vfs_poll(filp, NULL) & (mask | EPOLLERR)))
+			return -EAGAIN;
+		break;
+	default:
+		return -ENOTTY;
+	}
+
+	return v4l2_ioctl(filp, cmd, arg);
+}
+
 #ifdef CONFIG_MMU
 #define v4l2_get_unmapped_area NULL
 #else
@@ -480,6 +526,7 @@ static const struct file_operations v4l2_fops = {
 	.release = v4l2_release,
 	.poll = v4l2_poll,
 	.llseek = no_llseek,
+	.uring_cmd = v4l2_uring_cmd,
 };
 
 /**
@@ -12,6 +12,7 @@
 #include <linux/pm_runtime.h>
 #include <linux/rockchip/cpu.h>
 #include <linux/slab.h>
+#include <linux/soc/rockchip/rk_vendor_storage.h>
 
 #include "dw_mmc.h"
 #include "dw_mmc-pltfm.h"
@@ -184,6 +185,183 @@ static int dw_mci_v2_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 	return 0;
 }
 
+/*
+ * Tuned sample phases are cached per controller, card CID, clock and
+ * timing, and kept in vendor storage so they survive a power cycle. A
+ * cached phase is only trusted after it passes a couple of tuning blocks,
+ * otherwise the full sweep runs as before.
+ */
+#define DW_MCI_RK_TUNING_MAGIC		0x4e555444 /* "DTUN" */
+#define DW_MCI_RK_TUNING_ENTRIES	4
+#define DW_MCI_RK_TUNING_VERIFY		2
+
+struct dw_mci_rk_tuning_entry {
+	u32 host;
+	u32 cid[4];
+	u32 clock;
+	u32 timing;
+	s32 phase;
+};
+
+struct dw_mci_rk_tuning {
+	u32 magic;
+	u32 next;
+	struct dw_mci_rk_tuning_entry entry[DW_MCI_RK_TUNING_ENTRIES];
+};
+
+static struct dw_mci_rk_tuning dw_mci_rk_tuning;
+static bool dw_mci_rk_tuning_loaded;
+static DEFINE_MUTEX(dw_mci_rk_tuning_lock);
+
+static bool dw_mci_rk_tuning_match(const struct dw_mci_rk_tuning_entry *a,
+				   const struct dw_mci_rk_tuning_entry *b)
+{
+	return a->host == b->host && a->clock == b->clock &&
+	       a->timing == b->timing && !memcmp(a->cid, b->cid, sizeof(a->cid));
+}
+
+static struct dw_mci_rk_tuning_entry *
+dw_mci_rk_tuning_find(struct dw_mci_rk_tuning *tbl,
+		      const struct dw_mci_rk_tuning_entry *key, bool alloc)
+{
+	struct dw_mci_rk_tuning_entry *e;
+	int i;
+
+	for (i = 0; i < DW_MCI_RK_TUNING_ENTRIES; i++)
+		if (tbl->entry[i].clock &&
+		    dw_mci_rk_tuning_match(&tbl->entry[i], key))
+			return &tbl->entry[i];
+
+	if (!alloc)
+		return NULL;
+
+	e = &tbl->entry[tbl->next % DW_MCI_RK_TUNING_ENTRIES];
+	tbl->next = (tbl->next + 1) % DW_MCI_RK_TUNING_ENTRIES;
+	*e = *key;
+	e->phase = -1;
+
+	return e;
+}
+
+/* Writing vendor storage may need this very host, so never do it inline */
+static void dw_mci_rk_tuning_store(struct work_struct *work)
+{
+	struct dw_mci_rk_tuning tbl;
+
+	if (!is_rk_vendor_ready())
+		return;
+
+	mutex_lock(&dw_mci_rk_tuning_lock);
+	tbl = dw_mci_rk_tuning;
+	mutex_unlock(&dw_mci_rk_tuning_lock);
+
+	rk_vendor_write(MMC_TUNING_ID, &tbl, sizeof(tbl));
+}
+
+static DECLARE_WORK(dw_mci_rk_tuning_work, dw_mci_rk_tuning_store);
+
+/* Called with dw_mci_rk_tuning_lock held */
+static void dw_mci_rk_tuning_load(void)
+{
+	struct dw_mci_rk_tuning tbl;
+	struct dw_mci_rk_tuning_entry *e;
+	bool merged = false;
+	int i;
+
+	if (dw_mci_rk_tuning_loaded || !is_rk_vendor_ready())
+		return;
+	dw_mci_rk_tuning_loaded = true;
+
+	if (rk_vendor_read(MMC_TUNING_ID, &tbl, sizeof(tbl)) != sizeof(tbl) ||
+	    tbl.magic != DW_MCI_RK_TUNING_MAGIC) {
+		memset(&tbl, 0, sizeof(tbl));
+		tbl.magic = DW_MCI_RK_TUNING_MAGIC;
+	}
+
+	/* Phases tuned before vendor storage came up are newer */
+	for (i = 0; i < DW_MCI_RK_TUNING_ENTRIES; i++) {
+		if (!dw_mci_rk_tuning.entry[i].clock)
+			continue;
+		e = dw_mci_rk_tuning_find(&tbl, &dw_mci_rk_tuning.entry[i], true);
+		*e = dw_mci_rk_tuning.entry[i];
+		merged = true;
+	}
+
+	dw_mci_rk_tuning = tbl;
+	if (merged)
+		schedule_work(&dw_mci_rk_tuning_work);
+}
+
+static void dw_mci_rk_tuning_key(struct dw_mci_slot *slot,
+				 struct dw_mci_rk_tuning_entry *key)
+{
+	struct mmc_host *mmc = slot->mmc;
+
+	memset(key, 0, sizeof(*key));
+	key->host = (u32)slot->host->phy_regs;
+	memcpy(key->cid, slot->cid, sizeof(key->cid));
+	key->clock = mmc->ios.clock;
+	key->timing = mmc->ios.timing;
+}
+
+static int dw_mci_rk_tuning_reuse(struct dw_mci_slot *slot, u32 opcode)
+{
+	struct dw_mci *host = slot->host;
+	struct dw_mci_rockchip_priv_data *priv = host->priv;
+	struct dw_mci_rk_tuning_entry key, *e;
+	int i, phase = -1;
+
+	dw_mci_rk_tuning_key(slot, &key);
+
+	mutex_lock(&dw_mci_rk_tuning_lock);
+	dw_mci_rk_tuning_load();
+	e = dw_mci_rk_tuning_find(&dw_mci_rk_tuning, &key, false);
+	if (e)
+		phase = e->phase;
+	mutex_unlock(&dw_mci_rk_tuning_lock);
+
+	if (phase < 0)
+		return -ENOENT;
+
+	clk_set_phase(priv->sample_clk, phase);
+	for (i = 0; i < DW_MCI_RK_TUNING_VERIFY; i++) {
+		if (mmc_send_tuning(slot->mmc, opcode, NULL)) {
+			dev_info(host->dev, "Cached phase %d failed, retuning\n",
+				 phase);
+			return -EIO;
+		}
+	}
+
+	dev_info(host->dev, "Reused tuned phase %d\n", phase);
+	return 0;
+}
+
+static void dw_mci_rk_tuning_save(struct dw_mci_slot *slot)
+{
+	struct dw_mci_rockchip_priv_data *priv = slot->host->priv;
+	struct dw_mci_rk_tuning_entry key, *e;
+	int phase = clk_get_phase(priv->sample_clk);
+	bool changed = false;
+
+	if (phase < 0)
+		return;
+
+	dw_mci_rk_tuning_key(slot, &key);
+
+	mutex_lock(&dw_mci_rk_tuning_lock);
+	dw_mci_rk_tuning_load();
+	dw_mci_rk_tuning.magic = DW_MCI_RK_TUNING_MAGIC;
+	e = dw_mci_rk_tuning_find(&dw_mci_rk_tuning, &key, true);
+	if (e->phase != phase) {
+		e->phase = phase;
+		changed = true;
+	}
+	mutex_unlock(&dw_mci_rk_tuning_lock);
+
+	if (changed && dw_mci_rk_tuning_loaded)
+		schedule_work(&dw_mci_rk_tuning_work);
+}
+
 static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 {
 	struct dw_mci *host = slot->host;
@@ -207,10 +385,15 @@ static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 		return -EIO;
 	}
 
+	if (!dw_mci_rk_tuning_reuse(slot, opcode))
+		return 0;
+
 	if (priv->use_v2_tuning) {
 		ret = dw_mci_v2_execute_tuning(slot, opcode);
-		if (!ret)
+		if (!ret) {
+			dw_mci_rk_tuning_save(slot);
 			return 0;
+		}
 		/* Otherwise we continue using fine tuning */
 	}
 
@@ -334,6 +517,8 @@ static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 	clk_set_phase(priv->sample_clk, real_middle_phase);
 
 free:
+	if (!ret)
+		dw_mci_rk_tuning_save(slot);
 	kfree(ranges);
 	return ret;
 }
@@ -405,6 +590,7 @@ static int dw_mci_rockchip_init(struct dw_mci *host)
 	}
 
 	host->need_xfer_timer = true;
+	host->use_hsq = device_property_read_bool(host->dev, "rockchip,use-hsq");
 	return 0;
 }
 
@@ -489,6 +675,7 @@ static int dw_mci_rockchip_remove(struct platform_device *pdev)
 	pm_runtime_get_sync(&pdev->dev);
 	pm_runtime_disable(&pdev->dev);
 	pm_runtime_put_noidle(&pdev->dev);
+	flush_work(&dw_mci_rk_tuning_work);
 
 	return dw_mci_pltfm_remove(pdev);
 }
@@ -40,6 +40,9 @@
 #include <linux/soc/rockchip/rockchip_decompress.h>
 
 #include "dw_mmc.h"
+#ifdef CONFIG_MMC_DW_HSQ
+#include "mmc_hsq.h"
+#endif
 
 /* Common flag combinations */
 #define DW_MCI_DATA_ERROR_FLAGS	(SDMMC_INT_DRTO | SDMMC_INT_DCRC | \
@@ -1429,6 +1432,17 @@ static void dw_mci_queue_request(struct dw_mci *host, struct dw_mci_slot *slot,
 }
 
 static bool dw_mci_reset(struct dw_mci *host);
+static void dw_mci_mrq_done(struct dw_mci *host, struct mmc_host *mmc,
+			    struct mmc_request *mrq)
+{
+#ifdef CONFIG_MMC_DW_HSQ
+	/* the software queue pumps its next request from here */
+	if (host->use_hsq && mmc_hsq_finalize_request(mmc, mrq))
+		return;
+#endif
+	mmc_request_done(mmc, mrq);
+}
+
 static void dw_mci_request(struct mmc_host *mmc, struct mmc_request *mrq)
 {
 	struct dw_mci_slot *slot = mmc_priv(mmc);
@@ -1444,7 +1458,7 @@ static void dw_mci_request(struct mmc_host *mmc, struct mmc_request *mrq)
 
 	if (!dw_mci_get_cd(mmc)) {
 		mrq->cmd->error = -ENOMEDIUM;
-		mmc_request_done(mmc, mrq);
+		dw_mci_mrq_done(host, mmc, mrq);
 		return;
 	}
 
@@ -1458,6 +1472,29 @@ static void dw_mci_request(struct mmc_host *mmc, struct mmc_request *mrq)
 	spin_unlock_bh(&host->lock);
 }
 
+/*
+ * Called by the host software queue from the completion tasklet, so the
+ * next request is started as soon as the previous one is done and its
+ * sg list was already mapped by pre_req. Card detect through gpio and the
+ * rv1106 sd reset may sleep, leave those to dw_mci_request().
+ */
+static int dw_mci_request_atomic(struct mmc_host *mmc, struct mmc_request *mrq)
+{
+	struct dw_mci_slot *slot = mmc_priv(mmc);
+	struct dw_mci *host = slot->host;
+
+	if (host->is_rv1106_sd || !test_bit(DW_MMC_CARD_PRESENT, &slot->flags))
+		return -EBUSY;
+
+	WARN_ON(slot->mrq);
+
+	spin_lock_bh(&host->lock);
+	dw_mci_queue_request(host, slot, mrq);
+	spin_unlock_bh(&host->lock);
+
+	return 0;
+}
+
 static void dw_mci_set_ios(struct mmc_host *mmc, struct mmc_ios *ios)
 {
 	struct dw_mci_slot *slot = mmc_priv(mmc);
@@ -1571,6 +1608,9 @@ static void dw_mci_set_ios(struct mmc_host *mmc, struct mmc_ios *ios)
 		regs = mci_readl(slot->host, PWREN);
 		regs &= ~(1 << slot->id);
 		mci_writel(slot->host, PWREN, regs);
+
+		if (test_and_clear_bit(DW_MMC_CARD_SDIO_RPM, &slot->flags))
+			pm_runtime_put_noidle(slot->host->dev);
 		break;
 	default:
 		break;
@@ -1683,20 +1723,32 @@ static void dw_mci_init_card(struct mmc_host *mmc, struct mmc_card *card)
 	struct dw_mci_slot *slot = mmc_priv(mmc);
 	struct dw_mci *host = slot->host;
 
+	bool sdio = card->type == MMC_TYPE_SDIO ||
+		    card->type == MMC_TYPE_SD_COMBO;
+
+	/*
+	 * SDIO wifi issues back to back CMD53s; don't let runtime PM gate
+	 * the clocks and reset the controller between bursts. The reference
+	 * is dropped again when the card is powered off.
+	 */
+	if (sdio && !test_and_set_bit(DW_MMC_CARD_SDIO_RPM, &slot->flags))
+		pm_runtime_get_noresume(host->dev);
+
 	/*
 	 * Low power mode will stop the card clock when idle.  According to the
 	 * description of the CLKENA register we should disable low power mode
-	 * for SDIO cards if we need SDIO interrupts to work.
+	 * for SDIO cards if we need SDIO interrupts to work. Out of band irq
+	 * cards keep the clock running too, restarting it for every command
+	 * only adds latency to each transfer.
 	 */
-	if (mmc->caps & MMC_CAP_SDIO_IRQ) {
+	if (sdio || mmc->caps & MMC_CAP_SDIO_IRQ) {
 		const u32 clken_low_pwr = SDMMC_CLKEN_LOW_PWR << slot->id;
 		u32 clk_en_a_old;
 		u32 clk_en_a;
 
 		clk_en_a_old = mci_readl(host, CLKENA);
 
-		if (card->type == MMC_TYPE_SDIO ||
-		    card->type == MMC_TYPE_SD_COMBO) {
+		if (sdio) {
 			set_bit(DW_MMC_CARD_NO_LOW_PWR, &slot->flags);
 			clk_en_a = clk_en_a_old & ~clken_low_pwr;
 		} else {
@@ -1846,6 +1898,7 @@ static bool dw_mci_reset(struct dw_mci *host)
 
 static const struct mmc_host_ops dw_mci_ops = {
 	.request		= dw_mci_request,
+	.request_atomic		= dw_mci_request_atomic,
 	.pre_req		= dw_mci_pre_req,
 	.post_req		= dw_mci_post_req,
 	.set_ios		= dw_mci_set_ios,
@@ -1894,7 +1947,7 @@ static void dw_mci_request_end(struct dw_mci *host, struct mmc_request *mrq)
 
 	spin_unlock(&host->lock);
 
-	mmc_request_done(prev_mmc, mrq);
+	dw_mci_mrq_done(host, prev_mmc, mrq);
 	spin_lock(&host->lock);
 }
 
@@ -1928,6 +1981,10 @@ static int dw_mci_command_complete(struct dw_mci *host, struct mmc_command *cmd)
 	else
 		cmd->error = 0;
 
+	/* Identifies the card for the platform tuning cache */
+	if (cmd->opcode == MMC_ALL_SEND_CID && !cmd->error)
+		memcpy(host->slot->cid, cmd->resp, sizeof(host->slot->cid));
+
 	return cmd->error;
 }
 
@@ -2990,6 +3047,24 @@ static int dw_mci_init_slot(struct dw_mci *host)
 
 	dw_mci_get_cd(mmc);
 
+#ifdef CONFIG_MMC_DW_HSQ
+	if (host->use_hsq) {
+		struct mmc_hsq *hsq;
+
+		hsq = devm_kzalloc(host->dev, sizeof(*hsq), GFP_KERNEL);
+		if (!hsq) {
+			ret = -ENOMEM;
+			goto err_host_allocated;
+		}
+
+		ret = mmc_hsq_init(hsq, mmc);
+		if (ret)
+			goto err_host_allocated;
+	}
+#else
+	host->use_hsq = false;
+#endif
+
 	ret = mmc_add_host(mmc);
 	if (ret)
 		goto err_host_allocated;
@@ -3617,6 +3692,11 @@ int dw_mci_runtime_suspend(struct device *dev)
 {
 	struct dw_mci *host = dev_get_drvdata(dev);
 
+#ifdef CONFIG_MMC_DW_HSQ
+	if (host->use_hsq && host->slot)
+		mmc_hsq_suspend(host->slot->mmc);
+#endif
+
 	if (host->use_dma && host->dma_ops->exit)
 		host->dma_ops->exit(host);
 
@@ -3695,6 +3775,11 @@ int dw_mci_runtime_resume(struct device *dev)
 	/* Now that slots are all setup, we can enable card detect */
 	dw_mci_enable_cd(host);
 
+#ifdef CONFIG_MMC_DW_HSQ
+	if (host->use_hsq)
+		mmc_hsq_resume(host->slot->mmc);
+#endif
+
 	return 0;
 
 err:
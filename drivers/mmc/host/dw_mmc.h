@@ -233,6 +233,7 @@ struct dw_mci {
 	bool			need_xfer_timer;
 	struct timer_list       xfer_timer;
 	bool			is_rv1106_sd;
+	bool			use_hsq;
 	struct pinctrl		*pinctrl;
 	struct pinctrl_state	*normal_state;
 	struct pinctrl_state	*idle_state;
@@ -522,6 +523,7 @@ extern int dw_mci_runtime_resume(struct device *device);
  * @flags: Random state bits associated with the slot.
  * @id: Number of this slot.
  * @sdio_id: Number of this slot in the SDIO interrupt registers.
+ * @cid: CID of the card as answered to ALL_SEND_CID, zero for SDIO.
  */
 struct dw_mci_slot {
 	struct mmc_host		*mmc;
@@ -541,8 +543,10 @@ struct dw_mci_slot {
 #define DW_MMC_CARD_NO_LOW_PWR	2
 #define DW_MMC_CARD_NO_USE_HOLD 3
 #define DW_MMC_CARD_NEEDS_POLL	4
+#define DW_MMC_CARD_SDIO_RPM	5
 	int			id;
 	int			sdio_id;
+	u32			cid[4];
 };
 
 /**
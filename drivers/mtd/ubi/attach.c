@@ -73,7 +73,9 @@
 #include <linux/slab.h>
 #include <linux/crc32.h>
 #include <linux/math64.h>
+#include <linux/mm.h>
 #include <linux/random.h>
+#include <linux/workqueue.h>
 #include "ubi.h"
 
 static int self_check_ai(struct ubi_device *ubi, struct ubi_attach_info *ai);
@@ -944,13 +946,17 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	struct ubi_ec_hdr *ech = ai->ech;
 	struct ubi_vid_io_buf *vidb = ai->vidb;
 	struct ubi_vid_hdr *vidh = ubi_get_vid_hdr(vidb);
+	struct ubi_scan_hdr *pre = NULL;
 	long long ec;
 	int err, bitflips = 0, vol_id = -1, ec_err = 0;
 
 	dbg_bld("scan PEB %d", pnum);
 
+	if (ai->pre && pnum >= ai->pre_start && ai->pre[pnum - ai->pre_start].valid)
+		pre = &ai->pre[pnum - ai->pre_start];
+
 	/* Skip bad physical eraseblocks */
-	err = ubi_io_is_bad(ubi, pnum);
+	err = pre ? pre->bad : ubi_io_is_bad(ubi, pnum);
 	if (err < 0)
 		return err;
 	else if (err) {
@@ -958,7 +964,12 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
-	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+	if (pre) {
+		err = pre->ec_err;
+		memcpy(ech, &pre->ech, UBI_EC_HDR_SIZE);
+	} else {
+		err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+	}
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -1041,7 +1052,12 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 
 	/* OK, we've done with the EC header, let's look at the VID header */
 
-	err = ubi_io_read_vid_hdr(ubi, pnum, vidb, 0);
+	if (pre) {
+		err = pre->vid_err;
+		memcpy(vidh, &pre->vidh, UBI_VID_HDR_SIZE);
+	} else {
+		err = ubi_io_read_vid_hdr(ubi, pnum, vidb, 0);
+	}
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -1361,6 +1377,125 @@ static void destroy_ai(struct ubi_attach_info *ai)
 	kfree(ai);
 }
 
+/*
+ * Reading the EC and VID headers dominates the scanning time on large flash.
+ * Before the serial pass of scan_all() the headers are read ahead by up to
+ * %UBI_SCAN_MAX_THREADS threads, each taking %UBI_SCAN_CHUNK PEBs at a time,
+ * so that the MTD and ECC overhead of one read overlaps with the others.
+ * scan_peb() then consumes the read ahead headers and all the attaching
+ * information is still built in PEB order by a single thread.
+ */
+#define UBI_SCAN_MAX_THREADS	4
+#define UBI_SCAN_CHUNK		32
+
+struct ubi_scan_ctx {
+	struct ubi_device *ubi;
+	struct ubi_scan_hdr *hdr;
+	int start;
+	atomic_t next;
+};
+
+struct ubi_scan_worker {
+	struct work_struct work;
+	struct ubi_scan_ctx *ctx;
+};
+
+static void prefetch_hdrs(struct ubi_scan_ctx *ctx)
+{
+	struct ubi_device *ubi = ctx->ubi;
+	struct ubi_vid_io_buf *vidb;
+	struct ubi_ec_hdr *ech;
+	int pnum, end;
+
+	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
+	vidb = ubi_alloc_vid_buf(ubi, GFP_KERNEL);
+	if (!ech || !vidb)
+		goto out;
+
+	/* PEBs left !valid by a failed worker are read by scan_peb() itself */
+	while ((pnum = atomic_fetch_add(UBI_SCAN_CHUNK, &ctx->next)) <
+	       ubi->peb_count) {
+		end = min(pnum + UBI_SCAN_CHUNK, ubi->peb_count);
+		for (; pnum < end; pnum++) {
+			struct ubi_scan_hdr *h = &ctx->hdr[pnum - ctx->start];
+
+			h->bad = ubi_io_is_bad(ubi, pnum);
+			if (!h->bad) {
+				h->ec_err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+				memcpy(&h->ech, ech, UBI_EC_HDR_SIZE);
+				if (h->ec_err >= 0 && h->ec_err != UBI_IO_FF &&
+				    h->ec_err != UBI_IO_FF_BITFLIPS) {
+					h->vid_err = ubi_io_read_vid_hdr(ubi,
+								pnum, vidb, 0);
+					memcpy(&h->vidh, ubi_get_vid_hdr(vidb),
+					       UBI_VID_HDR_SIZE);
+				}
+			}
+			h->valid = 1;
+			cond_resched();
+		}
+	}
+
+out:
+	ubi_free_vid_buf(vidb);
+	kfree(ech);
+}
+
+static void prefetch_work_fn(struct work_struct *work)
+{
+	struct ubi_scan_worker *w = container_of(work, struct ubi_scan_worker,
+						 work);
+
+	prefetch_hdrs(w->ctx);
+}
+
+/**
+ * scan_prefetch - read the PEB headers of a scan in parallel.
+ * @ubi: UBI device description object
+ * @ai: attach info object
+ * @start: first PEB which is going to be scanned
+ *
+ * This is an optimization only, so nothing is read ahead if the device is
+ * small, there is one CPU online or the memory cannot be allocated.
+ */
+static void scan_prefetch(struct ubi_device *ubi, struct ubi_attach_info *ai,
+			  int start)
+{
+	struct ubi_scan_worker w[UBI_SCAN_MAX_THREADS - 1];
+	struct ubi_scan_ctx ctx;
+	int count = ubi->peb_count - start;
+	int i, threads;
+
+	threads = min_t(int, num_online_cpus(), UBI_SCAN_MAX_THREADS);
+	threads = min(threads, DIV_ROUND_UP(count, UBI_SCAN_CHUNK));
+	ubi->attach_threads = max(ubi->attach_threads, 1);
+	if (threads < 2)
+		return;
+
+	ai->pre = kvcalloc(count, sizeof(*ai->pre), GFP_KERNEL);
+	if (!ai->pre)
+		return;
+	ai->pre_start = start;
+
+	ctx.ubi = ubi;
+	ctx.hdr = ai->pre;
+	ctx.start = start;
+	atomic_set(&ctx.next, start);
+
+	for (i = 0; i < threads - 1; i++) {
+		w[i].ctx = &ctx;
+		INIT_WORK_ONSTACK(&w[i].work, prefetch_work_fn);
+		queue_work(system_unbound_wq, &w[i].work);
+	}
+	prefetch_hdrs(&ctx);
+	for (i = 0; i < threads - 1; i++) {
+		flush_work(&w[i].work);
+		destroy_work_on_stack(&w[i].work);
+	}
+
+	ubi->attach_threads = max(ubi->attach_threads, threads);
+}
+
 /**
  * scan_all - scan entire MTD device.
  * @ubi: UBI device description object
@@ -1378,6 +1513,8 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	struct rb_node *rb1, *rb2;
 	struct ubi_ainf_volume *av;
 	struct ubi_ainf_peb *aeb;
+	s64 scan_us;
+	ktime_t t;
 
 	err = -ENOMEM;
 
@@ -1389,6 +1526,9 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!ai->vidb)
 		goto out_ech;
 
+	t = ktime_get();
+	scan_prefetch(ubi, ai, start);
+
 	for (pnum = start; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
@@ -1398,7 +1538,11 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 			goto out_vidh;
 	}
 
-	ubi_msg(ubi, "scanning is finished");
+	kvfree(ai->pre);
+	ai->pre = NULL;
+	scan_us = ktime_us_delta(ktime_get(), t);
+	ubi->attach_scan_us += scan_us;
+	ubi_msg(ubi, "scanning is finished in %lld us", scan_us);
 
 	/* Calculate mean erase counter */
 	if (ai->ec_count)
@@ -1441,6 +1585,8 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	return 0;
 
 out_vidh:
+	kvfree(ai->pre);
+	ai->pre = NULL;
 	ubi_free_vid_buf(ai->vidb);
 out_ech:
 	kfree(ai->ech);
@@ -1556,6 +1702,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 {
 	int err;
 	struct ubi_attach_info *ai;
+	ktime_t start = ktime_get();
 
 	ai = alloc_ai();
 	if (!ai)
@@ -1635,6 +1782,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 #endif
 
 	destroy_ai(ai);
+	ubi->attach_us = ktime_us_delta(ktime_get(), start);
 	return 0;
 
 out_wl:
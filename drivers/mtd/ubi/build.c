@@ -69,6 +69,8 @@ static struct mtd_dev_param mtd_dev_param[UBI_MAX_DEVICES];
 /* UBI module parameter to enable fastmap automatically on non-fastmap images */
 static bool fm_autoconvert;
 static bool fm_debug;
+/* Delay of the first fastmap write after attaching by scanning, 0 disables */
+static unsigned int fm_regen_delay = 10;
 #endif
 
 /* Slab cache for wear-leveling entries */
@@ -1020,6 +1022,12 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 	wake_up_process(ubi->bgt_thread);
 	spin_unlock(&ubi->wl_lock);
 
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	if (!ubi->fm_disabled && !ubi->fm && !ubi->ro_mode && fm_regen_delay)
+		schedule_delayed_work(&ubi->fm_regen_work,
+				      fm_regen_delay * HZ);
+#endif
+
 	ubi_devices[ubi_num] = ubi;
 	ubi_notify_all(ubi, UBI_VOLUME_ADDED, NULL);
 	return ubi_num;
@@ -1086,6 +1094,7 @@ int ubi_detach_mtd_dev(int ubi_num, int anyway)
 	 * EC updates that have been made since the last written fastmap.
 	 * In case of fastmap debugging we omit the update to simulate an
 	 * unclean shutdown. */
+	cancel_delayed_work_sync(&ubi->fm_regen_work);
 	if (!ubi_dbg_chk_fastmap(ubi))
 		ubi_update_fastmap(ubi);
 #endif
@@ -1464,6 +1473,8 @@ module_param(fm_autoconvert, bool, 0644);
 MODULE_PARM_DESC(fm_autoconvert, "Set this parameter to enable fastmap automatically on images without a fastmap.");
 module_param(fm_debug, bool, 0);
 MODULE_PARM_DESC(fm_debug, "Set this parameter to enable fastmap debugging by default. Warning, this will make fastmap slow!");
+module_param(fm_regen_delay, uint, 0644);
+MODULE_PARM_DESC(fm_regen_delay, "Seconds after a scanning attach to write a fresh fastmap, 0 waits for the first write instead (default: 10)");
 #endif
 MODULE_VERSION(__stringify(UBI_VERSION));
 MODULE_DESCRIPTION("UBI - Unsorted Block Images");
@@ -493,6 +493,52 @@ static const struct file_operations eraseblk_count_fops = {
 	.release = eraseblk_count_release,
 };
 
+static int attach_timing_show(struct seq_file *s, void *unused)
+{
+	struct ubi_device *ubi = s->private;
+
+	seq_printf(s, "attach_mode:\t%s\n", ubi->fast_attach ? "fastmap" : "scan");
+	seq_printf(s, "attach_us:\t%llu\n", ubi->attach_us);
+	seq_printf(s, "scan_us:\t%llu\n", ubi->attach_scan_us);
+	seq_printf(s, "scan_threads:\t%d\n", ubi->attach_threads);
+	seq_printf(s, "fm_regen_us:\t%llu\n", ubi->fm_regen_us);
+
+	return 0;
+}
+
+static int attach_timing_open(struct inode *inode, struct file *f)
+{
+	struct ubi_device *ubi = ubi_get_device((unsigned long)inode->i_private);
+	int err;
+
+	if (!ubi)
+		return -ENODEV;
+
+	err = single_open(f, attach_timing_show, ubi);
+	if (err)
+		ubi_put_device(ubi);
+
+	return err;
+}
+
+static int attach_timing_release(struct inode *inode, struct file *f)
+{
+	struct seq_file *s = f->private_data;
+	struct ubi_device *ubi = s->private;
+
+	ubi_put_device(ubi);
+
+	return single_release(inode, f);
+}
+
+static const struct file_operations attach_timing_fops = {
+	.owner = THIS_MODULE,
+	.open = attach_timing_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = attach_timing_release,
+};
+
 /**
  * ubi_debugfs_init_dev - initialize debugfs for an UBI device.
  * @ubi: UBI device description object
@@ -558,6 +604,9 @@ int ubi_debugfs_init_dev(struct ubi_device *ubi)
 	debugfs_create_file("detailed_erase_block_info", S_IRUSR, d->dfs_dir,
 			    (void *)ubi_num, &eraseblk_count_fops);
 
+	debugfs_create_file("attach_timing", S_IRUSR, d->dfs_dir,
+			    (void *)ubi_num, &attach_timing_fops);
+
 	return 0;
 }
 
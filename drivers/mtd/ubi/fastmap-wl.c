@@ -19,6 +19,30 @@ static void update_fastmap_work_fn(struct work_struct *wrk)
 	spin_unlock(&ubi->wl_lock);
 }
 
+/**
+ * fm_regen_work_fn - writes the first fastmap after a scanning attach
+ * @wrk: the work description object
+ *
+ * Without it the first fastmap is written when the pools run empty, which
+ * is usually the first write after boot.
+ */
+static void fm_regen_work_fn(struct work_struct *wrk)
+{
+	struct ubi_device *ubi = container_of(to_delayed_work(wrk),
+					      struct ubi_device, fm_regen_work);
+	ktime_t start;
+	int err;
+
+	if (ubi->fm)
+		return;
+
+	start = ktime_get();
+	err = ubi_update_fastmap(ubi);
+	ubi->fm_regen_us = ktime_us_delta(ktime_get(), start);
+	if (err)
+		ubi_msg(ubi, "Unable to write a new fastmap: %i", err);
+}
+
 /**
  * find_anchor_wl_entry - find wear-leveling entry to used as anchor PEB.
  * @root: the RB-tree where to look for
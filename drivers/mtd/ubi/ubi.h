@@ -490,6 +490,7 @@ struct ubi_debug_info {
  * @fm_eba_sem: allows ubi_update_fastmap() to block EBA table changes
  * @fm_work: fastmap work queue
  * @fm_work_scheduled: non-zero if fastmap work was scheduled
+ * @fm_regen_work: writes the first fastmap some time after a scanning attach
  * @fast_attach: non-zero if UBI was attached by fastmap
  * @fm_anchor: The next anchor PEB to use for fastmap
  * @fm_do_produce_anchor: If true produce an anchor PEB in wl
@@ -554,6 +555,11 @@ struct ubi_debug_info {
  * @buf_mutex: protects @peb_buf
  * @ckvol_mutex: serializes static volume checking when opening
  *
+ * @attach_us: time taken by ubi_attach() in microseconds
+ * @attach_scan_us: part of @attach_us spent reading PEB headers
+ * @attach_threads: number of threads which read the PEB headers
+ * @fm_regen_us: time taken by the deferred fastmap write, 0 if none happened
+ *
  * @dbg: debugging information for this UBI device
  */
 struct ubi_device {
@@ -600,6 +606,7 @@ struct ubi_device {
 	size_t fm_size;
 	struct work_struct fm_work;
 	int fm_work_scheduled;
+	struct delayed_work fm_regen_work;
 	int fast_attach;
 	struct ubi_wl_entry *fm_anchor;
 	int fm_do_produce_anchor;
@@ -654,6 +661,11 @@ struct ubi_device {
 	struct mutex buf_mutex;
 	struct mutex ckvol_mutex;
 
+	u64 attach_us;
+	u64 attach_scan_us;
+	int attach_threads;
+	u64 fm_regen_us;
+
 	struct ubi_debug_info dbg;
 };
 
@@ -722,6 +734,25 @@ struct ubi_ainf_volume {
 	struct rb_root root;
 };
 
+/**
+ * struct ubi_scan_hdr - PEB headers read ahead during scanning.
+ * @valid: non-zero if the fields below were filled in
+ * @bad: result of ubi_io_is_bad()
+ * @ec_err: result of ubi_io_read_ec_hdr()
+ * @vid_err: result of ubi_io_read_vid_hdr(), only if the EC header was not
+ *           empty
+ * @ech: the EC header as read
+ * @vidh: the VID header as read
+ */
+struct ubi_scan_hdr {
+	int valid;
+	int bad;
+	int ec_err;
+	int vid_err;
+	struct ubi_ec_hdr ech;
+	struct ubi_vid_hdr vidh;
+};
+
 /**
  * struct ubi_attach_info - MTD device attaching information.
  * @volumes: root of the volume RB-tree
@@ -753,6 +784,9 @@ struct ubi_ainf_volume {
  * @aeb_slab_cache: slab cache for &struct ubi_ainf_peb objects
  * @ech: temporary EC header. Only available during scan
  * @vidh: temporary VID buffer. Only available during scan
+ * @pre: PEB headers read ahead by the parallel scan, indexed from @pre_start.
+ *       Only available during scan
+ * @pre_start: first PEB covered by @pre
  *
  * This data structure contains the result of attaching an MTD device and may
  * be used by other UBI sub-systems to build final UBI data structures, further
@@ -783,6 +817,8 @@ struct ubi_attach_info {
 	struct kmem_cache *aeb_slab_cache;
 	struct ubi_ec_hdr *ech;
 	struct ubi_vid_io_buf *vidb;
+	struct ubi_scan_hdr *pre;
+	int pre_start;
 };
 
 /**
@@ -3,7 +3,9 @@
  * Copyright (c) 2020 Fuzhou Rockchip Electronics Co., Ltd
  */
 
+#include <linux/interrupt.h>
 #include <linux/ip.h>
+#include <linux/rtnetlink.h>
 #include <linux/tcp.h>
 #include <linux/skbuff.h>
 #include <linux/if_ether.h>
@@ -87,8 +89,59 @@ struct dwmac_rk_lb_priv {
 	int final_tx;
 	int final_rx;
 	int max_delay;
+
+	/* throughput benchmark */
+	int bench;
+	int bench_size;
+	u32 bench_ms;
+};
+
+#define DWMAC_RK_BENCH_RING	64
+#define DWMAC_RK_BENCH_MAX_MS	10000
+#define DWMAC_RK_BENCH_DRAIN_MS	10
+
+struct dwmac_rk_bench_result {
+	char ifname[IFNAMSIZ];
+	int type;
+	int speed;
+	int size;
+	u32 ms;
+	int ret;
+	u64 tx_pkts;
+	u64 rx_pkts;
+	u64 rx_bytes;
+	u64 rx_errors;
+	s64 irqs;
+	u64 ns;
+	struct rk_lat_hist lat;
 };
 
+struct dwmac_rk_bench {
+	struct stmmac_priv *priv;
+	struct dwmac_rk_bench_result *res;
+	struct dwmac_rk_packet_attrs attr;
+
+	struct dma_desc *dma_tx;
+	dma_addr_t dma_tx_phy;
+	struct sk_buff *tx_skb[DWMAC_RK_BENCH_RING];
+	dma_addr_t tx_dma[DWMAC_RK_BENCH_RING];
+	u32 tx_seq[DWMAC_RK_BENCH_RING];
+	u64 tx_ns[DWMAC_RK_BENCH_RING];
+	unsigned int tx_len;
+	unsigned int hdr_off;
+	u32 cur_tx;
+	u32 dirty_tx;
+
+	struct dma_desc *dma_rx;
+	dma_addr_t dma_rx_phy;
+	struct sk_buff *rx_skb[DWMAC_RK_BENCH_RING];
+	dma_addr_t rx_dma[DWMAC_RK_BENCH_RING];
+	u32 cur_rx;
+};
+
+/* last benchmark run, shown by lb_bench */
+static struct dwmac_rk_bench_result dwmac_rk_bench_res;
+
 #define DMA_CONTROL_OSP		BIT(4)
 #define DMA_CHAN_BASE_ADDR	0x00001100
 #define DMA_CHAN_BASE_OFFSET	0x80
@@ -1320,6 +1373,329 @@ static int dwmac_rk_phy_poll_reset(struct stmmac_priv *priv, int addr)
 	return 0;
 }
 
+static irqreturn_t dwmac_rk_bench_interrupt(int irq, void *dev_id)
+{
+	struct dwmac_rk_bench *bench = dev_id;
+	struct stmmac_priv *priv = bench->priv;
+	u32 status;
+
+	if (priv->plat->has_gmac4) {
+		status = readl(priv->ioaddr + DMA_CHAN_STATUS(0));
+		writel(status, priv->ioaddr + DMA_CHAN_STATUS(0));
+	} else {
+		status = readl(priv->ioaddr + DMA_STATUS);
+		writel((status & 0x1ffff), priv->ioaddr + DMA_STATUS);
+	}
+	stmmac_host_irq_status(priv, priv->hw, &priv->xstats);
+
+	bench->res->irqs++;
+
+	return IRQ_HANDLED;
+}
+
+static void dwmac_rk_bench_free(struct stmmac_priv *priv,
+				struct dwmac_rk_bench *bench,
+				struct dwmac_rk_lb_priv *lb_priv)
+{
+	int i;
+
+	for (i = 0; i < DWMAC_RK_BENCH_RING; i++) {
+		if (bench->tx_dma[i])
+			dma_unmap_single(priv->device, bench->tx_dma[i],
+					 bench->tx_len, DMA_TO_DEVICE);
+		if (bench->tx_skb[i])
+			dev_kfree_skb(bench->tx_skb[i]);
+		if (bench->rx_dma[i])
+			dma_unmap_single(priv->device, bench->rx_dma[i],
+					 lb_priv->dma_buf_sz, DMA_FROM_DEVICE);
+		if (bench->rx_skb[i])
+			dev_kfree_skb(bench->rx_skb[i]);
+	}
+
+	if (bench->dma_tx)
+		dma_free_coherent(priv->device,
+				  DWMAC_RK_BENCH_RING * sizeof(struct dma_desc),
+				  bench->dma_tx, bench->dma_tx_phy);
+	if (bench->dma_rx)
+		dma_free_coherent(priv->device,
+				  DWMAC_RK_BENCH_RING * sizeof(struct dma_desc),
+				  bench->dma_rx, bench->dma_rx_phy);
+}
+
+static int dwmac_rk_bench_alloc(struct stmmac_priv *priv,
+				struct dwmac_rk_bench *bench,
+				struct dwmac_rk_lb_priv *lb_priv)
+{
+	struct sk_buff *skb;
+	dma_addr_t des;
+	int i;
+
+	bench->dma_tx = dma_alloc_coherent(priv->device,
+					   DWMAC_RK_BENCH_RING * sizeof(struct dma_desc),
+					   &bench->dma_tx_phy, GFP_KERNEL);
+	bench->dma_rx = dma_alloc_coherent(priv->device,
+					   DWMAC_RK_BENCH_RING * sizeof(struct dma_desc),
+					   &bench->dma_rx_phy, GFP_KERNEL);
+	if (!bench->dma_tx || !bench->dma_rx)
+		return -ENOMEM;
+
+	/* tx frames are built once and only get a new sequence number */
+	for (i = 0; i < DWMAC_RK_BENCH_RING; i++) {
+		skb = dwmac_rk_get_skb(priv, lb_priv);
+		if (!skb)
+			return -ENOMEM;
+		bench->tx_skb[i] = skb;
+		bench->tx_len = skb_headlen(skb);
+
+		des = dma_map_single(priv->device, skb->data, bench->tx_len,
+				     DMA_TO_DEVICE);
+		if (dma_mapping_error(priv->device, des))
+			return -EFAULT;
+		bench->tx_dma[i] = des;
+
+		stmmac_init_tx_desc(priv, bench->dma_tx + i, priv->mode,
+				    i == DWMAC_RK_BENCH_RING - 1);
+	}
+	bench->hdr_off = skb_transport_offset(bench->tx_skb[0]) +
+			 sizeof(struct udphdr);
+
+	for (i = 0; i < DWMAC_RK_BENCH_RING; i++) {
+		skb = netdev_alloc_skb_ip_align(priv->dev, lb_priv->dma_buf_sz);
+		if (!skb)
+			return -ENOMEM;
+		bench->rx_skb[i] = skb;
+
+		des = dma_map_single(priv->device, skb->data,
+				     lb_priv->dma_buf_sz, DMA_FROM_DEVICE);
+		if (dma_mapping_error(priv->device, des))
+			return -EFAULT;
+		bench->rx_dma[i] = des;
+
+		stmmac_init_rx_desc(priv, bench->dma_rx + i, priv->use_riwt,
+				    priv->mode, i == DWMAC_RK_BENCH_RING - 1,
+				    lb_priv->dma_buf_sz);
+		stmmac_set_desc_addr(priv, bench->dma_rx + i, des);
+		dma_wmb();
+		stmmac_set_rx_owner(priv, bench->dma_rx + i, priv->use_riwt);
+	}
+
+	return 0;
+}
+
+static void dwmac_rk_bench_tx(struct stmmac_priv *priv,
+			      struct dwmac_rk_bench *bench, bool fill)
+{
+	struct dwmac_rk_bench_result *res = bench->res;
+	struct dwmac_rk_hdr *shdr;
+	struct dma_desc *p;
+	unsigned int entry;
+	u32 coal = priv->tx_coal_frames;
+	bool queued = false;
+	int status;
+
+	while (bench->dirty_tx != bench->cur_tx) {
+		p = bench->dma_tx + bench->dirty_tx % DWMAC_RK_BENCH_RING;
+		status = stmmac_tx_status(priv, &priv->dev->stats,
+					  &priv->xstats, p, priv->ioaddr);
+		if (status & tx_dma_own)
+			break;
+		stmmac_release_tx_desc(priv, p, priv->mode);
+		bench->dirty_tx++;
+	}
+
+	while (fill && bench->cur_tx - bench->dirty_tx < DWMAC_RK_BENCH_RING - 1) {
+		entry = bench->cur_tx % DWMAC_RK_BENCH_RING;
+		p = bench->dma_tx + entry;
+
+		shdr = (struct dwmac_rk_hdr *)(bench->tx_skb[entry]->data +
+					       bench->hdr_off);
+		shdr->id = bench->cur_tx;
+		dma_sync_single_for_device(priv->device, bench->tx_dma[entry],
+					   bench->tx_len, DMA_TO_DEVICE);
+
+		stmmac_set_desc_addr(priv, p, bench->tx_dma[entry]);
+		/* same tx coalescing as the running driver */
+		if (!coal || (bench->cur_tx + 1) % coal == 0)
+			stmmac_set_tx_ic(priv, p);
+		stmmac_prepare_tx_desc(priv, p, 1, bench->tx_len, 1,
+				       priv->mode, 0, 1, bench->tx_len);
+		dma_wmb();
+		stmmac_set_tx_owner(priv, p);
+
+		bench->tx_seq[entry] = bench->cur_tx;
+		bench->tx_ns[entry] = ktime_get_ns();
+		bench->cur_tx++;
+		res->tx_pkts++;
+		queued = true;
+	}
+
+	if (queued) {
+		stmmac_enable_dma_transmission(priv, priv->ioaddr);
+		stmmac_set_tx_tail_ptr(priv, priv->ioaddr, bench->dma_tx_phy +
+				       (bench->cur_tx % DWMAC_RK_BENCH_RING) *
+				       sizeof(struct dma_desc), 0);
+	}
+}
+
+static int dwmac_rk_bench_rx(struct stmmac_priv *priv,
+			     struct dwmac_rk_bench *bench,
+			     struct dwmac_rk_lb_priv *lb_priv)
+{
+	struct dwmac_rk_bench_result *res = bench->res;
+	int coe = priv->hw->rx_csum;
+	struct dwmac_rk_hdr *shdr;
+	unsigned int entry, len;
+	struct dma_desc *p;
+	int status, count = 0;
+	u64 now = ktime_get_ns();
+
+	for (;;) {
+		entry = bench->cur_rx % DWMAC_RK_BENCH_RING;
+		p = bench->dma_rx + entry;
+
+		status = stmmac_rx_status(priv, &priv->dev->stats,
+					  &priv->xstats, p);
+		if (status & dma_own)
+			break;
+
+		dma_sync_single_for_cpu(priv->device, bench->rx_dma[entry],
+					lb_priv->dma_buf_sz, DMA_FROM_DEVICE);
+		len = stmmac_get_rx_frame_len(priv, p, coe);
+		shdr = (struct dwmac_rk_hdr *)(bench->rx_skb[entry]->data +
+					       bench->hdr_off);
+		if (status == discard_frame ||
+		    len != bench->tx_len + ETH_FCS_LEN ||
+		    shdr->magic != cpu_to_be64(DWMAC_RK_TEST_PKT_MAGIC)) {
+			res->rx_errors++;
+		} else {
+			unsigned int tx_entry = shdr->id % DWMAC_RK_BENCH_RING;
+
+			res->rx_pkts++;
+			res->rx_bytes += len;
+			/* the tx slot may already carry a newer frame */
+			if (bench->tx_seq[tx_entry] == shdr->id)
+				rk_lat_hist_add(&res->lat,
+						now - bench->tx_ns[tx_entry]);
+		}
+		dma_sync_single_for_device(priv->device, bench->rx_dma[entry],
+					   lb_priv->dma_buf_sz, DMA_FROM_DEVICE);
+
+		stmmac_set_desc_addr(priv, p, bench->rx_dma[entry]);
+		dma_wmb();
+		stmmac_set_rx_owner(priv, p, priv->use_riwt);
+
+		bench->cur_rx++;
+		count++;
+	}
+
+	if (count)
+		stmmac_set_rx_tail_ptr(priv, priv->ioaddr, bench->dma_rx_phy +
+				       (bench->cur_rx % DWMAC_RK_BENCH_RING) *
+				       sizeof(struct dma_desc), 0);
+
+	return count;
+}
+
+/*
+ * Sustained loopback: keep the tx ring full and recycle rx buffers in
+ * place for bench_ms, then drain. The data path is polled, the DMA irq
+ * is only counted so the tx/rx coalescing settings of the driver show
+ * up as irqs per packet.
+ */
+static int dwmac_rk_loopback_bench(struct stmmac_priv *priv,
+				   struct dwmac_rk_lb_priv *lb_priv)
+{
+	struct dwmac_rk_bench_result *res = &dwmac_rk_bench_res;
+	struct dwmac_rk_bench *bench;
+	u64 start, end, idle;
+	bool irq;
+	int ret;
+
+	/* the rings below rely on the end of ring bit / ring length */
+	if (priv->mode == STMMAC_CHAIN_MODE)
+		return -EOPNOTSUPP;
+
+	bench = kzalloc(sizeof(*bench), GFP_KERNEL);
+	if (!bench)
+		return -ENOMEM;
+
+	memset(res, 0, sizeof(*res));
+	strscpy(res->ifname, netdev_name(priv->dev), sizeof(res->ifname));
+	res->type = lb_priv->type;
+	res->speed = lb_priv->speed;
+	res->size = lb_priv->bench_size;
+	res->ms = lb_priv->bench_ms;
+
+	bench->priv = priv;
+	bench->res = res;
+	bench->attr = dwmac_rk_udp_attr;
+	bench->attr.size = lb_priv->bench_size;
+	lb_priv->packet = &bench->attr;
+	lb_priv->id = 0;
+	lb_priv->tx = 0;
+	lb_priv->rx = 0;
+
+	ret = dwmac_rk_bench_alloc(priv, bench, lb_priv);
+	if (ret)
+		goto out;
+
+	/* move the channels from the single test descriptor to the rings */
+	stmmac_init_rx_chan(priv, priv->ioaddr, priv->plat->dma_cfg,
+			    bench->dma_rx_phy, 0);
+	stmmac_init_tx_chan(priv, priv->ioaddr, priv->plat->dma_cfg,
+			    bench->dma_tx_phy, 0);
+	stmmac_set_rx_ring_len(priv, priv->ioaddr, DWMAC_RK_BENCH_RING - 1, 0);
+	stmmac_set_tx_ring_len(priv, priv->ioaddr, DWMAC_RK_BENCH_RING - 1, 0);
+	stmmac_set_rx_tail_ptr(priv, priv->ioaddr, bench->dma_rx_phy +
+			       DWMAC_RK_BENCH_RING * sizeof(struct dma_desc), 0);
+	stmmac_set_tx_tail_ptr(priv, priv->ioaddr, bench->dma_tx_phy, 0);
+	if (priv->use_riwt)
+		stmmac_rx_watchdog(priv, priv->ioaddr, priv->rx_riwt, 1);
+
+	irq = !request_irq(priv->dev->irq, dwmac_rk_bench_interrupt, 0,
+			   "dwmac-rk-bench", bench);
+	if (!irq)
+		res->irqs = -1;
+
+	stmmac_mac_set(priv, priv->ioaddr, true);
+	stmmac_start_rx(priv, priv->ioaddr, 0);
+	stmmac_start_tx(priv, priv->ioaddr, 0);
+
+	start = ktime_get_ns();
+	end = start + (u64)lb_priv->bench_ms * NSEC_PER_MSEC;
+	do {
+		dwmac_rk_bench_tx(priv, bench, true);
+		dwmac_rk_bench_rx(priv, bench, lb_priv);
+		cond_resched();
+	} while (ktime_get_ns() < end);
+
+	/* let the frames still in flight come back */
+	idle = ktime_get_ns() + DWMAC_RK_BENCH_DRAIN_MS * NSEC_PER_MSEC;
+	while (ktime_get_ns() < idle) {
+		dwmac_rk_bench_tx(priv, bench, false);
+		if (dwmac_rk_bench_rx(priv, bench, lb_priv))
+			idle = ktime_get_ns() +
+			       DWMAC_RK_BENCH_DRAIN_MS * NSEC_PER_MSEC;
+		cond_resched();
+	}
+	res->ns = ktime_get_ns() - start;
+
+	stmmac_stop_rx(priv, priv->ioaddr, 0);
+	stmmac_stop_tx(priv, priv->ioaddr, 0);
+	stmmac_mac_set(priv, priv->ioaddr, false);
+	/* wait for state machine is disabled */
+	usleep_range(100, 150);
+
+	if (irq)
+		free_irq(priv->dev->irq, bench);
+out:
+	dwmac_rk_bench_free(priv, bench, lb_priv);
+	kfree(bench);
+	res->ret = ret;
+
+	return ret;
+}
+
 static int dwmac_rk_loopback_run(struct stmmac_priv *priv,
 				 struct dwmac_rk_lb_priv *lb_priv)
 {
@@ -1383,6 +1759,8 @@ static int dwmac_rk_loopback_run(struct stmmac_priv *priv,
 			goto out;
 		}
 		ret = dwmac_rk_loopback_delayline_scan(priv, lb_priv);
+	} else if (lb_priv->bench) {
+		ret = dwmac_rk_loopback_bench(priv, lb_priv);
 	} else {
 		lb_priv->id++;
 		lb_priv->tx = 0;
@@ -1563,6 +1941,106 @@ static ssize_t phy_lb_scan_store(struct device *dev,
 }
 static DEVICE_ATTR_WO(phy_lb_scan);
 
+static ssize_t lb_bench_show(struct device *dev,
+			     struct device_attribute *attr,
+			     char *buf)
+{
+	struct dwmac_rk_bench_result *res = &dwmac_rk_bench_res;
+	u64 ns, lost = 0;
+	ssize_t len = 0;
+	int i;
+
+	rtnl_lock();
+	ns = res->ns ? res->ns : 1;
+	if (res->tx_pkts > res->rx_pkts)
+		lost = res->tx_pkts - res->rx_pkts;
+
+	len += scnprintf(buf + len, PAGE_SIZE - len,
+			 "%s %s loopback, speed %d, payload %d, %u ms: %s\n",
+			 res->ifname[0] ? res->ifname : "none",
+			 res->type == LOOPBACK_TYPE_PHY ? "phy" : "mac",
+			 res->speed, res->size, res->ms,
+			 res->ret ? "FAIL" : "done");
+	len += scnprintf(buf + len, PAGE_SIZE - len,
+			 "tx %llu rx %llu lost %llu (%llu.%02llu%%) errors %llu\n",
+			 res->tx_pkts, res->rx_pkts, lost,
+			 res->tx_pkts ? div64_u64(lost * 100, res->tx_pkts) : 0,
+			 res->tx_pkts ? div64_u64(lost * 10000, res->tx_pkts) % 100 : 0,
+			 res->rx_errors);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "%llu pps, %llu Mbps\n",
+			 div64_u64(res->rx_pkts * NSEC_PER_SEC, ns),
+			 div64_u64(res->rx_bytes * 8 * NSEC_PER_USEC, ns));
+	if (res->irqs < 0)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "irqs n/a\n");
+	else
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "irqs %lld, %llu pkts/irq\n", res->irqs,
+				 res->irqs ? div64_u64(res->rx_pkts, res->irqs) : 0);
+	len += scnprintf(buf + len, PAGE_SIZE - len,
+			 "latency cnt %llu avg %lluus max %uus\n", res->lat.cnt,
+			 res->lat.cnt ? div64_u64(res->lat.sum_us, res->lat.cnt) : 0,
+			 res->lat.max_us);
+	for (i = 0; i < RK_LAT_HIST_BUCKETS; i++) {
+		if (!res->lat.bucket[i])
+			continue;
+		if (i == RK_LAT_HIST_BUCKETS - 1)
+			len += scnprintf(buf + len, PAGE_SIZE - len,
+					 "\t[%u, inf) us: %u\n",
+					 1U << (i - 1), res->lat.bucket[i]);
+		else
+			len += scnprintf(buf + len, PAGE_SIZE - len,
+					 "\t[%u, %u) us: %u\n",
+					 i ? 1U << (i - 1) : 0, 1U << i,
+					 res->lat.bucket[i]);
+	}
+	rtnl_unlock();
+
+	return len;
+}
+
+static ssize_t lb_bench_store(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t count)
+{
+	struct net_device *ndev = dev_get_drvdata(dev);
+	struct stmmac_priv *priv = netdev_priv(ndev);
+	struct dwmac_rk_lb_priv *lb_priv;
+	int max_size = DWMAC_RK_TEST_PKT_MAX_SIZE - DWMAC_RK_TEST_PKT_SIZE -
+		       sizeof(struct udphdr) - 1;
+	char type[4];
+	int ret, speed, size;
+	u32 ms;
+
+	if (sscanf(buf, "%3s %d %d %u", type, &speed, &size, &ms) != 4 ||
+	    (strcmp(type, "mac") && strcmp(type, "phy")) ||
+	    size < 0 || size > max_size || !ms || ms > DWMAC_RK_BENCH_MAX_MS) {
+		pr_err("usage: <mac|phy> <speed> <payload 0-%d> <ms 1-%d>\n",
+		       max_size, DWMAC_RK_BENCH_MAX_MS);
+		return -EINVAL;
+	}
+
+	lb_priv = kzalloc(sizeof(*lb_priv), GFP_KERNEL);
+	if (!lb_priv)
+		return -ENOMEM;
+
+	lb_priv->sysfs = 1;
+	lb_priv->type = strcmp(type, "phy") ? LOOPBACK_TYPE_GMAC :
+					     LOOPBACK_TYPE_PHY;
+	lb_priv->speed = speed;
+	lb_priv->scan = 0;
+	lb_priv->bench = 1;
+	lb_priv->bench_size = size;
+	lb_priv->bench_ms = ms;
+
+	ret = dwmac_rk_loopback_run(priv, lb_priv);
+	kfree(lb_priv);
+
+	pr_info("%s loopback bench: %s\n", type, ret ? "FAIL" : "done");
+
+	return count;
+}
+static DEVICE_ATTR_RW(lb_bench);
+
 int dwmac_rk_create_loopback_sysfs(struct device *device)
 {
 	int ret;
@@ -1583,8 +2061,15 @@ int dwmac_rk_create_loopback_sysfs(struct device *device)
 	if (ret)
 		goto remove_phy_lb;
 
+	ret = device_create_file(device, &dev_attr_lb_bench);
+	if (ret)
+		goto remove_phy_lb_scan;
+
 	return 0;
 
+remove_phy_lb_scan:
+	device_remove_file(device, &dev_attr_phy_lb_scan);
+
 remove_rgmii_delayline:
 	device_remove_file(device, &dev_attr_rgmii_delayline);
 
@@ -1603,6 +2088,7 @@ int dwmac_rk_remove_loopback_sysfs(struct device *device)
 	device_remove_file(device, &dev_attr_mac_lb);
 	device_remove_file(device, &dev_attr_phy_lb);
 	device_remove_file(device, &dev_attr_phy_lb_scan);
+	device_remove_file(device, &dev_attr_lb_bench);
 
 	return 0;
 }
@@ -42,6 +42,8 @@ struct rk_gmac_ops {
 	void (*set_clock_selection)(struct rk_priv_data *bsp_priv, bool input,
 				    bool enable);
 	void (*integrated_phy_power)(struct rk_priv_data *bsp_priv, bool up);
+	/* TSO validated on this MAC, enable it without "snps,tso" */
+	bool tso_en;
 };
 
 struct rk_priv_data {
@@ -50,6 +52,7 @@ struct rk_priv_data {
 	int bus_id;
 	struct regulator *regulator;
 	bool suspended;
+	bool wol_aclk_off;
 	const struct rk_gmac_ops *ops;
 
 	bool clk_enabled;
@@ -2068,6 +2071,7 @@ static const struct rk_gmac_ops rv1106_ops = {
 	.set_to_rmii = rv1106_set_to_rmii,
 	.set_rmii_speed = rv1106_set_rmii_speed,
 	.integrated_phy_power = rv1106_integrated_sphy_power,
+	.tso_en = true,
 };
 
 #define RV1108_GRF_GMAC_CON0		0X0900
@@ -2777,6 +2781,8 @@ static int rk_gmac_probe(struct platform_device *pdev)
 		plat_dat->has_gmac = true;
 
 	plat_dat->sph_disable = true;
+	if (data->tso_en)
+		plat_dat->tso_en = true;
 	plat_dat->fix_mac_speed = rk_fix_speed;
 	plat_dat->get_eth_addr = rk_get_eth_addr;
 	plat_dat->integrated_phy_power = rk_integrated_phy_power;
@@ -2834,6 +2840,12 @@ static int rk_gmac_suspend(struct device *dev)
 	if (!device_may_wakeup(dev)) {
 		rk_gmac_powerdown(bsp_priv);
 		bsp_priv->suspended = true;
+	} else if (!ret && !IS_ERR(bsp_priv->aclk_mac)) {
+		/* DMA is stopped in PMT power down, the MAC only checks wake
+		 * packets and answers ARP, neither goes through the AXI bus.
+		 */
+		clk_disable_unprepare(bsp_priv->aclk_mac);
+		bsp_priv->wol_aclk_off = true;
 	}
 
 	return ret;
@@ -2849,6 +2861,11 @@ static int rk_gmac_resume(struct device *dev)
 		bsp_priv->suspended = false;
 	}
 
+	if (bsp_priv->wol_aclk_off) {
+		clk_prepare_enable(bsp_priv->aclk_mac);
+		bsp_priv->wol_aclk_off = false;
+	}
+
 	return stmmac_resume(dev);
 }
 #endif /* CONFIG_PM_SLEEP */
@@ -35,6 +35,7 @@
 #define GMAC_PCS_BASE			0x000000e0
 #define GMAC_PHYIF_CONTROL_STATUS	0x000000f8
 #define GMAC_PMT			0x000000c0
+#define GMAC_RWK_PACKET_FILTER		0x000000c4
 #define GMAC_DEBUG			0x00000114
 #define GMAC_HW_FEATURE0		0x0000011c
 #define GMAC_HW_FEATURE1		0x00000120
@@ -170,6 +171,10 @@ enum power_event {
 	power_down = 0x00000001,
 };
 
+/* Remote wake-up packet filter command, one nibble per filter */
+#define GMAC_RWK_FILTER_EN		BIT(0)
+#define GMAC_RWK_FILTERS		4
+
 /* Energy Efficient Ethernet (EEE) for GMAC4
  *
  * LPI status, timer and control register offset
@@ -310,6 +310,10 @@ static void dwmac4_pmt(struct mac_device_info *hw, unsigned long mode)
 		pr_debug("GMAC: WOL on global unicast\n");
 		pmt |= power_down | global_unicast | wake_up_frame_en;
 	}
+	if (mode & WAKE_FILTER) {
+		pr_debug("GMAC: WOL on wake-up packet filters\n");
+		pmt |= power_down | wake_up_frame_en;
+	}
 
 	if (pmt) {
 		/* The receiver must be enabled for WOL before powering down */
@@ -320,6 +324,32 @@ static void dwmac4_pmt(struct mac_device_info *hw, unsigned long mode)
 	writel(pmt, ioaddr + GMAC_PMT);
 }
 
+static void dwmac4_set_wake_filter(struct mac_device_info *hw,
+				   const struct stmmac_wake_filter *filt,
+				   u32 count)
+{
+	void __iomem *ioaddr = hw->pcsr;
+	u32 regs[2 * GMAC_RWK_FILTERS] = { };
+	u32 i;
+
+	/* byte masks, commands, offsets, then two CRCs per word. The
+	 * address type bit is left clear so broadcasts such as ARP
+	 * requests never match.
+	 */
+	for (i = 0; i < min_t(u32, count, GMAC_RWK_FILTERS); i++) {
+		if (!filt[i].in_use)
+			continue;
+		regs[i] = filt[i].mask;
+		regs[4] |= GMAC_RWK_FILTER_EN << (8 * i);
+		regs[5] |= filt[i].offset << (8 * i);
+		regs[6 + i / 2] |= filt[i].crc << (16 * (i % 2));
+	}
+
+	writel(readl(ioaddr + GMAC_PMT) | pointer_reset, ioaddr + GMAC_PMT);
+	for (i = 0; i < ARRAY_SIZE(regs); i++)
+		writel(regs[i], ioaddr + GMAC_RWK_PACKET_FILTER);
+}
+
 static void dwmac4_set_umac_addr(struct mac_device_info *hw,
 				 unsigned char *addr, unsigned int reg_n)
 {
@@ -839,7 +869,12 @@ static int dwmac4_irq_status(struct mac_device_info *hw,
 		x->mmc_rx_csum_offload_irq_n++;
 	/* Clear the PMT bits 5 and 6 by reading the PMT status reg */
 	if (unlikely(intr_status & pmt_irq)) {
-		readl(ioaddr + GMAC_PMT);
+		u32 pmt = readl(ioaddr + GMAC_PMT);
+
+		if (pmt & magic_frame)
+			x->wol_magic_n++;
+		if (pmt & wake_up_rx_frame)
+			x->wol_wake_frame_n++;
 		x->irq_receive_pmt_irq_n++;
 	}
 
@@ -1183,6 +1218,7 @@ const struct stmmac_ops dwmac4_ops = {
 	.sarc_configure = dwmac4_sarc_configure,
 	.enable_vlan = dwmac4_enable_vlan,
 	.set_arp_offload = dwmac4_set_arp_offload,
+	.set_wake_filter = dwmac4_set_wake_filter,
 	.config_l3_filter = dwmac4_config_l3_filter,
 	.config_l4_filter = dwmac4_config_l4_filter,
 	.add_hw_vlan_rx_fltr = dwmac4_add_hw_vlan_rx_fltr,
@@ -1228,6 +1264,7 @@ const struct stmmac_ops dwmac410_ops = {
 	.sarc_configure = dwmac4_sarc_configure,
 	.enable_vlan = dwmac4_enable_vlan,
 	.set_arp_offload = dwmac4_set_arp_offload,
+	.set_wake_filter = dwmac4_set_wake_filter,
 	.config_l3_filter = dwmac4_config_l3_filter,
 	.config_l4_filter = dwmac4_config_l4_filter,
 #ifdef CONFIG_STMMAC_FULL
@@ -1279,6 +1316,7 @@ const struct stmmac_ops dwmac510_ops = {
 	.sarc_configure = dwmac4_sarc_configure,
 	.enable_vlan = dwmac4_enable_vlan,
 	.set_arp_offload = dwmac4_set_arp_offload,
+	.set_wake_filter = dwmac4_set_wake_filter,
 	.config_l3_filter = dwmac4_config_l3_filter,
 	.config_l4_filter = dwmac4_config_l4_filter,
 	.est_configure = dwmac5_est_configure,
@@ -282,6 +282,7 @@ struct net_device;
 struct rgmii_adv;
 struct stmmac_safety_stats;
 struct stmmac_tc_entry;
+struct stmmac_wake_filter;
 struct stmmac_pps_cfg;
 struct stmmac_rss;
 struct stmmac_est;
@@ -390,6 +391,9 @@ struct stmmac_ops {
 				bool en, bool udp, bool sa, bool inv,
 				u32 match);
 	void (*set_arp_offload)(struct mac_device_info *hw, bool en, u32 addr);
+	void (*set_wake_filter)(struct mac_device_info *hw,
+				const struct stmmac_wake_filter *filt,
+				u32 count);
 	int (*est_configure)(void __iomem *ioaddr, struct stmmac_est *cfg,
 			     unsigned int ptp_rate);
 	void (*fpe_configure)(void __iomem *ioaddr, u32 num_txq, u32 num_rxq,
@@ -486,6 +490,8 @@ struct stmmac_ops {
 	stmmac_do_callback(__priv, mac, config_l4_filter, __args)
 #define stmmac_set_arp_offload(__priv, __args...) \
 	stmmac_do_void_callback(__priv, mac, set_arp_offload, __args)
+#define stmmac_set_wake_filter(__priv, __args...) \
+	stmmac_do_void_callback(__priv, mac, set_wake_filter, __args)
 #define stmmac_est_configure(__priv, __args...) \
 	stmmac_do_callback(__priv, mac, est_configure, __args)
 #define stmmac_fpe_configure(__priv, __args...) \
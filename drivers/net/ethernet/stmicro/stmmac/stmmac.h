@@ -13,6 +13,7 @@
 #define DRV_MODULE_VERSION	"Jan_2016"
 
 #include <linux/clk.h>
+#include <linux/dim.h>
 #include <linux/if_vlan.h>
 #include <linux/stmmac.h>
 #include <linux/phylink.h>
@@ -22,6 +23,9 @@
 #include <linux/net_tstamp.h>
 #include <linux/reset.h>
 #include <net/page_pool.h>
+#include <net/xdp.h>
+#include <soc/rockchip/rockchip_irq_align.h>
+#include <soc/rockchip/rockchip_lat_hist.h>
 
 struct stmmac_resources {
 	void __iomem *addr;
@@ -31,12 +35,20 @@ struct stmmac_resources {
 	int irq;
 };
 
+enum stmmac_txbuf_type {
+	STMMAC_TXBUF_T_SKB,
+	STMMAC_TXBUF_T_XDP_TX,
+	STMMAC_TXBUF_T_XDP_NDO,
+};
+
 struct stmmac_tx_info {
 	dma_addr_t buf;
 	bool map_as_page;
 	unsigned len;
 	bool last_segment;
 	bool is_jumbo;
+	enum stmmac_txbuf_type buf_type;
+	u64 xmit_ns;
 };
 
 #define STMMAC_TBS_AVAIL	BIT(0)
@@ -47,18 +59,22 @@ struct stmmac_tx_queue {
 	u32 tx_count_frames;
 	int tbs;
 	struct timer_list txtimer;
+	struct rk_irq_align_work txalign;
 	u32 queue_index;
 	struct stmmac_priv *priv_data;
 	struct dma_extended_desc *dma_etx ____cacheline_aligned_in_smp;
 	struct dma_edesc *dma_entx;
 	struct dma_desc *dma_tx;
 	struct sk_buff **tx_skbuff;
+	struct xdp_frame **xdpf;
 	struct stmmac_tx_info *tx_skbuff_dma;
 	unsigned int cur_tx;
 	unsigned int dirty_tx;
 	dma_addr_t dma_tx_phy;
 	u32 tx_tail_addr;
 	u32 mss;
+	/* ndo_start_xmit to tx_clean latency of every skb */
+	struct rk_lat_hist tx_lat;
 };
 
 struct stmmac_rx_buffer {
@@ -66,12 +82,14 @@ struct stmmac_rx_buffer {
 	struct page *sec_page;
 	dma_addr_t addr;
 	dma_addr_t sec_addr;
+	u32 page_offset;
 };
 
 struct stmmac_rx_queue {
 	u32 rx_count_frames;
 	u32 queue_index;
 	struct page_pool *page_pool;
+	struct xdp_rxq_info xdp_rxq;
 	struct stmmac_rx_buffer *buf_pool;
 	struct stmmac_priv *priv_data;
 	struct dma_extended_desc *dma_erx;
@@ -95,6 +113,20 @@ struct stmmac_channel {
 	struct stmmac_priv *priv_data;
 	spinlock_t lock;
 	u32 index;
+
+	/* RX NAPI kicked on this CPU by IPI, -1 polls on the IRQ CPU */
+	int rx_cpu;
+	call_single_data_t rx_csd;
+
+	/* Dynamic interrupt moderation, sampled once per NAPI cycle */
+	struct dim rx_dim;
+	struct dim tx_dim;
+	u16 rx_dim_events;
+	u16 tx_dim_events;
+	u64 rx_dim_pkts;
+	u64 rx_dim_bytes;
+	u64 tx_dim_pkts;
+	u64 tx_dim_bytes;
 };
 
 struct stmmac_tc_entry {
@@ -121,6 +153,21 @@ struct stmmac_tc_entry {
 	} __packed val;
 };
 
+/* Remote wake-up packet filter built from an ethtool RX_CLS_FLOW_WAKE rule.
+ * Bit n of mask selects byte offset + n, crc is the CRC-16 of the selected
+ * bytes.
+ */
+#define STMMAC_WAKE_FILTERS	4
+#define STMMAC_WAKE_OFFSET	12
+#define STMMAC_WAKE_LEN		31
+struct stmmac_wake_filter {
+	bool in_use;
+	struct ethtool_rx_flow_spec fs;
+	u32 mask;
+	u8 offset;
+	u16 crc;
+};
+
 #define STMMAC_PPS_MAX		4
 struct stmmac_pps_cfg {
 	bool available;
@@ -151,10 +198,13 @@ struct stmmac_priv {
 	u32 rx_coal_frames;
 
 	int tx_coalesce;
+	bool rx_dim_en;
+	bool tx_dim_en;
 	int hwts_tx_en;
 	bool tx_path_in_lpi_mode;
 	bool tso;
 	int sph;
+	int sph_cap;
 	u32 sarc_type;
 
 	unsigned int dma_buf_sz;
@@ -199,6 +249,7 @@ struct stmmac_priv {
 	u32 msg_enable;
 	int wolopts;
 	int wol_irq;
+	struct stmmac_wake_filter wake_filters[STMMAC_WAKE_FILTERS];
 	int clk_csr;
 	struct timer_list eee_ctrl_timer;
 	int lpi_irq;
@@ -244,6 +295,9 @@ struct stmmac_priv {
 
 	/* Receive Side Scaling */
 	struct stmmac_rss rss;
+
+	/* XDP BPF Program */
+	struct bpf_prog *xdp_prog;
 };
 
 enum stmmac_state {
@@ -251,6 +305,7 @@ enum stmmac_state {
 	STMMAC_RESET_REQUESTED,
 	STMMAC_RESETING,
 	STMMAC_SERVICE_SCHED,
+	STMMAC_TSO_FALLBACK,
 };
 
 int stmmac_mdio_unregister(struct net_device *ndev);
@@ -279,6 +334,23 @@ bool stmmac_eee_init(struct stmmac_priv *priv);
 int stmmac_reinit_queues(struct net_device *dev, u32 rx_cnt, u32 tx_cnt);
 int stmmac_reinit_ringparam(struct net_device *dev, u32 rx_size, u32 tx_size);
 int stmmac_bus_clks_config(struct stmmac_priv *priv, bool enabled);
+void stmmac_tso_fallback(struct stmmac_priv *priv);
+int stmmac_open(struct net_device *dev);
+int stmmac_release(struct net_device *dev);
+u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv);
+
+static inline bool stmmac_xdp_is_enabled(struct stmmac_priv *priv)
+{
+	return !!priv->xdp_prog;
+}
+
+static inline unsigned int stmmac_rx_offset(struct stmmac_priv *priv)
+{
+	if (stmmac_xdp_is_enabled(priv))
+		return XDP_PACKET_HEADROOM;
+
+	return 0;
+}
 
 #if IS_ENABLED(CONFIG_STMMAC_SELFTESTS)
 void stmmac_selftest_run(struct net_device *dev,
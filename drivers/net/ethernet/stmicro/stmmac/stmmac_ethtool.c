@@ -8,9 +8,11 @@
   Author: Giuseppe Cavallaro <peppe.cavallaro@st.com>
 *******************************************************************************/
 
+#include <linux/crc16.h>
 #include <linux/etherdevice.h>
 #include <linux/ethtool.h>
 #include <linux/interrupt.h>
+#include <linux/ip.h>
 #include <linux/mii.h>
 #include <linux/phylink.h>
 #include <linux/net_tstamp.h>
@@ -98,6 +100,8 @@ static const struct stmmac_stats stmmac_gstrings_stats[] = {
 	STMMAC_STAT(tx_clean),
 	STMMAC_STAT(tx_set_ic_bit),
 	STMMAC_STAT(irq_receive_pmt_irq_n),
+	STMMAC_STAT(wol_magic_n),
+	STMMAC_STAT(wol_wake_frame_n),
 	/* MMC info */
 	STMMAC_STAT(mmc_tx_irq_n),
 	STMMAC_STAT(mmc_rx_irq_n),
@@ -166,9 +170,13 @@ static const struct stmmac_stats stmmac_gstrings_stats[] = {
 	/* TSO */
 	STMMAC_STAT(tx_tso_frames),
 	STMMAC_STAT(tx_tso_nfrags),
+	STMMAC_STAT(tx_tso_errors),
 };
 #define STMMAC_STATS_LEN ARRAY_SIZE(stmmac_gstrings_stats)
 
+/* per tx queue latency: cnt, avg, max and one counter per bucket */
+#define STMMAC_TX_LAT_STATS_LEN	(3 + RK_LAT_HIST_BUCKETS)
+
 /* HW MAC Management counters (if supported) */
 #define STMMAC_MMC_STAT(m)	\
 	{ #m, sizeof_field(struct stmmac_counters, m),	\
@@ -528,6 +536,7 @@ static void stmmac_get_ethtool_stats(struct net_device *dev,
 	u32 tx_queues_count = priv->plat->tx_queues_to_use;
 	unsigned long count;
 	int i, j = 0, ret;
+	u32 q;
 
 	if (priv->dma_cap.asp) {
 		for (i = 0; i < STMMAC_SAFETY_FEAT_SIZE; i++) {
@@ -570,6 +579,15 @@ static void stmmac_get_ethtool_stats(struct net_device *dev,
 		data[j++] = (stmmac_gstrings_stats[i].sizeof_stat ==
 			     sizeof(u64)) ? (*(u64 *)p) : (*(u32 *)p);
 	}
+	for (q = 0; q < tx_queues_count; q++) {
+		struct rk_lat_hist *hist = &priv->tx_queue[q].tx_lat;
+
+		data[j++] = hist->cnt;
+		data[j++] = hist->cnt ? div64_u64(hist->sum_us, hist->cnt) : 0;
+		data[j++] = hist->max_us;
+		for (i = 0; i < RK_LAT_HIST_BUCKETS; i++)
+			data[j++] = hist->bucket[i];
+	}
 }
 
 static int stmmac_get_sset_count(struct net_device *netdev, int sset)
@@ -580,6 +598,7 @@ static int stmmac_get_sset_count(struct net_device *netdev, int sset)
 	switch (sset) {
 	case ETH_SS_STATS:
 		len = STMMAC_STATS_LEN;
+		len += priv->plat->tx_queues_to_use * STMMAC_TX_LAT_STATS_LEN;
 
 		if (priv->dma_cap.rmon)
 			len += STMMAC_MMC_STATS_LEN;
@@ -605,6 +624,7 @@ static int stmmac_get_sset_count(struct net_device *netdev, int sset)
 static void stmmac_get_strings(struct net_device *dev, u32 stringset, u8 *data)
 {
 	int i;
+	u32 q;
 	u8 *p = data;
 	struct stmmac_priv *priv = netdev_priv(dev);
 
@@ -632,6 +652,22 @@ static void stmmac_get_strings(struct net_device *dev, u32 stringset, u8 *data)
 				ETH_GSTRING_LEN);
 			p += ETH_GSTRING_LEN;
 		}
+		for (q = 0; q < priv->plat->tx_queues_to_use; q++) {
+			snprintf(p, ETH_GSTRING_LEN, "q%u_tx_lat_cnt", q);
+			p += ETH_GSTRING_LEN;
+			snprintf(p, ETH_GSTRING_LEN, "q%u_tx_lat_avg_us", q);
+			p += ETH_GSTRING_LEN;
+			snprintf(p, ETH_GSTRING_LEN, "q%u_tx_lat_max_us", q);
+			p += ETH_GSTRING_LEN;
+			for (i = 0; i < RK_LAT_HIST_BUCKETS - 1; i++) {
+				snprintf(p, ETH_GSTRING_LEN,
+					 "q%u_tx_lat_lt_%uus", q, 1U << i);
+				p += ETH_GSTRING_LEN;
+			}
+			snprintf(p, ETH_GSTRING_LEN, "q%u_tx_lat_ge_%uus", q,
+				 1U << (RK_LAT_HIST_BUCKETS - 2));
+			p += ETH_GSTRING_LEN;
+		}
 		break;
 	case ETH_SS_TEST:
 		stmmac_selftest_get_strings(priv, p);
@@ -653,6 +689,8 @@ static void stmmac_get_wol(struct net_device *dev, struct ethtool_wolinfo *wol)
 	mutex_lock(&priv->lock);
 	if (device_can_wakeup(priv->device)) {
 		wol->supported = WAKE_MAGIC | WAKE_UCAST;
+		if (priv->hw->mac->set_wake_filter)
+			wol->supported |= WAKE_FILTER;
 		if (priv->hw_cap_support && !priv->dma_cap.pmt_magic_frame)
 			wol->supported &= ~WAKE_MAGIC;
 		wol->wolopts = priv->wolopts;
@@ -668,6 +706,9 @@ static int stmmac_set_wol(struct net_device *dev, struct ethtool_wolinfo *wol)
 	if (!device_can_wakeup(priv->device))
 		return -EOPNOTSUPP;
 
+	if (priv->hw->mac->set_wake_filter)
+		support |= WAKE_FILTER;
+
 	if (!priv->plat->pmt) {
 		int ret = phylink_ethtool_set_wol(priv->phylink, wol);
 
@@ -746,19 +787,6 @@ static int stmmac_ethtool_op_set_eee(struct net_device *dev,
 	return 0;
 }
 
-static u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv)
-{
-	unsigned long clk = clk_get_rate(priv->plat->stmmac_clk);
-
-	if (!clk) {
-		clk = priv->plat->clk_ref_rate;
-		if (!clk)
-			return 0;
-	}
-
-	return (usec * (clk / 1000000)) / 256;
-}
-
 static u32 stmmac_riwt2usec(u32 riwt, struct stmmac_priv *priv)
 {
 	unsigned long clk = clk_get_rate(priv->plat->stmmac_clk);
@@ -779,6 +807,8 @@ static int stmmac_get_coalesce(struct net_device *dev,
 
 	ec->tx_coalesce_usecs = priv->tx_coal_timer;
 	ec->tx_max_coalesced_frames = priv->tx_coal_frames;
+	ec->use_adaptive_rx_coalesce = priv->rx_dim_en;
+	ec->use_adaptive_tx_coalesce = priv->tx_dim_en;
 
 	if (priv->use_riwt) {
 		ec->rx_max_coalesced_frames = priv->rx_coal_frames;
@@ -795,6 +825,10 @@ static int stmmac_set_coalesce(struct net_device *dev,
 	u32 rx_cnt = priv->plat->rx_queues_to_use;
 	unsigned int rx_riwt;
 
+	/* rx moderation is driven through the riwt watchdog */
+	if (ec->use_adaptive_rx_coalesce && !priv->use_riwt)
+		return -EOPNOTSUPP;
+
 	if (priv->use_riwt && (ec->rx_coalesce_usecs > 0)) {
 		rx_riwt = stmmac_usec2riwt(ec->rx_coalesce_usecs, priv);
 
@@ -817,6 +851,103 @@ static int stmmac_set_coalesce(struct net_device *dev,
 	priv->tx_coal_frames = ec->tx_max_coalesced_frames;
 	priv->tx_coal_timer = ec->tx_coalesce_usecs;
 	priv->rx_coal_frames = ec->rx_max_coalesced_frames;
+
+	/* With DIM on, the static values are only a starting point and
+	 * get replaced by the profile levels picked at run time.
+	 */
+	priv->rx_dim_en = ec->use_adaptive_rx_coalesce;
+	priv->tx_dim_en = ec->use_adaptive_tx_coalesce;
+	return 0;
+}
+
+static int stmmac_wake_pattern(u8 *pattern, u32 *mask, unsigned int off,
+			       const void *val, const void *m,
+			       unsigned int len)
+{
+	const u8 *v = val, *vm = m;
+	unsigned int i, pos;
+
+	for (i = 0; i < len; i++) {
+		if (!vm[i])
+			continue;
+		/* The filter compares whole bytes only */
+		if (vm[i] != 0xff)
+			return -EINVAL;
+		pos = off + i - STMMAC_WAKE_OFFSET;
+		pattern[pos] = v[i];
+		*mask |= BIT(pos);
+	}
+
+	return 0;
+}
+
+static int stmmac_wake_filter_build(struct stmmac_wake_filter *filt,
+				    const struct ethtool_rx_flow_spec *fs)
+{
+	const struct ethtool_tcpip4_spec *l4 = &fs->h_u.tcp_ip4_spec;
+	const struct ethtool_tcpip4_spec *l4m = &fs->m_u.tcp_ip4_spec;
+	const unsigned int ports = ETH_HLEN + sizeof(struct iphdr);
+	const unsigned int ip = ETH_HLEN;
+	u8 pattern[STMMAC_WAKE_LEN] = { };
+	__be16 proto = htons(ETH_P_IP);
+	__be16 full16 = htons(0xffff);
+	u8 ip_proto, full8 = 0xff;
+	u32 i, mask = 0;
+	u16 crc = 0xffff;
+	int ret;
+
+	switch (fs->flow_type) {
+	case ETHER_FLOW:
+		ret = stmmac_wake_pattern(pattern, &mask,
+					  offsetof(struct ethhdr, h_proto),
+					  &fs->h_u.ether_spec.h_proto,
+					  &fs->m_u.ether_spec.h_proto, 2);
+		if (ret)
+			return ret;
+		break;
+	case TCP_V4_FLOW:
+	case UDP_V4_FLOW:
+		/* Ports are matched at fixed offsets, IP options miss */
+		if (l4m->tos)
+			return -EINVAL;
+		ip_proto = fs->flow_type == TCP_V4_FLOW ? IPPROTO_TCP :
+							  IPPROTO_UDP;
+		ret = stmmac_wake_pattern(pattern, &mask,
+					  offsetof(struct ethhdr, h_proto),
+					  &proto, &full16, 2);
+		ret |= stmmac_wake_pattern(pattern, &mask,
+					   ip + offsetof(struct iphdr, protocol),
+					   &ip_proto, &full8, 1);
+		ret |= stmmac_wake_pattern(pattern, &mask,
+					   ip + offsetof(struct iphdr, saddr),
+					   &l4->ip4src, &l4m->ip4src, 4);
+		ret |= stmmac_wake_pattern(pattern, &mask,
+					   ip + offsetof(struct iphdr, daddr),
+					   &l4->ip4dst, &l4m->ip4dst, 4);
+		ret |= stmmac_wake_pattern(pattern, &mask, ports,
+					   &l4->psrc, &l4m->psrc, 2);
+		ret |= stmmac_wake_pattern(pattern, &mask, ports + 2,
+					   &l4->pdst, &l4m->pdst, 2);
+		if (ret)
+			return -EINVAL;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (!mask)
+		return -EINVAL;
+
+	for (i = 0; i < STMMAC_WAKE_LEN; i++) {
+		if (mask & BIT(i))
+			crc = crc16(crc, &pattern[i], 1);
+	}
+
+	filt->fs = *fs;
+	filt->mask = mask;
+	filt->offset = STMMAC_WAKE_OFFSET;
+	filt->crc = crc;
+	filt->in_use = true;
 	return 0;
 }
 
@@ -824,16 +955,100 @@ static int stmmac_get_rxnfc(struct net_device *dev,
 			    struct ethtool_rxnfc *rxnfc, u32 *rule_locs)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
+	struct stmmac_wake_filter *filt;
+	int i, cnt = 0, ret = 0;
 
 	switch (rxnfc->cmd) {
 	case ETHTOOL_GRXRINGS:
 		rxnfc->data = priv->plat->rx_queues_to_use;
+		return 0;
+	case ETHTOOL_GRXCLSRLCNT:
+	case ETHTOOL_GRXCLSRULE:
+	case ETHTOOL_GRXCLSRLALL:
+		if (!priv->hw->mac->set_wake_filter)
+			return -EOPNOTSUPP;
 		break;
 	default:
 		return -EOPNOTSUPP;
 	}
 
-	return 0;
+	mutex_lock(&priv->lock);
+	switch (rxnfc->cmd) {
+	case ETHTOOL_GRXCLSRLCNT:
+		for (i = 0; i < STMMAC_WAKE_FILTERS; i++)
+			cnt += priv->wake_filters[i].in_use;
+		rxnfc->rule_cnt = cnt;
+		rxnfc->data = STMMAC_WAKE_FILTERS;
+		break;
+	case ETHTOOL_GRXCLSRULE:
+		if (rxnfc->fs.location >= STMMAC_WAKE_FILTERS) {
+			ret = -EINVAL;
+			break;
+		}
+		filt = &priv->wake_filters[rxnfc->fs.location];
+		if (!filt->in_use) {
+			ret = -ENOENT;
+			break;
+		}
+		rxnfc->fs = filt->fs;
+		break;
+	case ETHTOOL_GRXCLSRLALL:
+		for (i = 0; i < STMMAC_WAKE_FILTERS; i++) {
+			if (!priv->wake_filters[i].in_use)
+				continue;
+			if (cnt == rxnfc->rule_cnt) {
+				ret = -EMSGSIZE;
+				break;
+			}
+			rule_locs[cnt++] = i;
+		}
+		rxnfc->rule_cnt = cnt;
+		rxnfc->data = STMMAC_WAKE_FILTERS;
+		break;
+	}
+	mutex_unlock(&priv->lock);
+
+	return ret;
+}
+
+/* Only wake rules, ethtool -N eth0 flow-type udp4 dst-port 5000 action -2 */
+static int stmmac_set_rxnfc(struct net_device *dev, struct ethtool_rxnfc *rxnfc)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	struct ethtool_rx_flow_spec *fs = &rxnfc->fs;
+	struct stmmac_wake_filter filt = { };
+	int ret = 0;
+
+	if (!priv->hw->mac->set_wake_filter)
+		return -EOPNOTSUPP;
+
+	switch (rxnfc->cmd) {
+	case ETHTOOL_SRXCLSRLINS:
+		if (fs->location >= STMMAC_WAKE_FILTERS ||
+		    fs->ring_cookie != RX_CLS_FLOW_WAKE)
+			return -EINVAL;
+		ret = stmmac_wake_filter_build(&filt, fs);
+		if (ret)
+			return ret;
+		mutex_lock(&priv->lock);
+		priv->wake_filters[fs->location] = filt;
+		mutex_unlock(&priv->lock);
+		break;
+	case ETHTOOL_SRXCLSRLDEL:
+		if (fs->location >= STMMAC_WAKE_FILTERS)
+			return -EINVAL;
+		mutex_lock(&priv->lock);
+		if (priv->wake_filters[fs->location].in_use)
+			priv->wake_filters[fs->location].in_use = false;
+		else
+			ret = -ENOENT;
+		mutex_unlock(&priv->lock);
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	return ret;
 }
 
 static u32 stmmac_get_rxfh_key_size(struct net_device *dev)
@@ -988,7 +1203,8 @@ static int stmmac_set_tunable(struct net_device *dev,
 
 static const struct ethtool_ops stmmac_ethtool_ops = {
 	.supported_coalesce_params = ETHTOOL_COALESCE_USECS |
-				     ETHTOOL_COALESCE_MAX_FRAMES,
+				     ETHTOOL_COALESCE_MAX_FRAMES |
+				     ETHTOOL_COALESCE_USE_ADAPTIVE,
 	.begin = stmmac_check_if_running,
 	.get_drvinfo = stmmac_ethtool_getdrvinfo,
 	.get_msglevel = stmmac_ethtool_getmsglevel,
@@ -1010,6 +1226,7 @@ static const struct ethtool_ops stmmac_ethtool_ops = {
 	.set_eee = stmmac_ethtool_op_set_eee,
 	.get_sset_count	= stmmac_get_sset_count,
 	.get_rxnfc = stmmac_get_rxnfc,
+	.set_rxnfc = stmmac_set_rxnfc,
 	.get_rxfh_key_size = stmmac_get_rxfh_key_size,
 	.get_rxfh_indir_size = stmmac_get_rxfh_indir_size,
 	.get_rxfh = stmmac_get_rxfh,
@@ -26,6 +26,7 @@
 #include <linux/mii.h>
 #include <linux/if.h>
 #include <linux/if_vlan.h>
+#include <linux/inetdevice.h>
 #include <linux/dma-mapping.h>
 #include <linux/slab.h>
 #include <linux/pm_runtime.h>
@@ -38,15 +39,20 @@
 #include <linux/net_tstamp.h>
 #include <linux/phylink.h>
 #include <linux/udp.h>
+#include <linux/bpf_trace.h>
 #include <net/pkt_cls.h>
 #include "stmmac_ptp.h"
 #include "stmmac.h"
+#include "stmmac_xdp.h"
 #include <linux/reset.h>
 #include <linux/of_mdio.h>
 #include "dwmac1000.h"
 #include "dwxgmac2.h"
 #include "hwif.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/stmmac.h>
+
 /* As long as the interface is active, we keep the timestamping counter enabled
  * with fine resolution and binary rollover. This avoid non-monotonic behavior
  * (clock jumps) when changing timestamping settings at runtime.
@@ -72,6 +78,14 @@ module_param(phyaddr, int, 0444);
 MODULE_PARM_DESC(phyaddr, "Physical device address");
 
 #define STMMAC_TX_THRESH(x)	((x)->dma_tx_size / 4)
+
+/* failed TSO frames before falling back to software GSO */
+#define STMMAC_TSO_ERR_THRESH	8
+
+#define STMMAC_XDP_PASS		0
+#define STMMAC_XDP_CONSUMED	BIT(0)
+#define STMMAC_XDP_TX		BIT(1)
+#define STMMAC_XDP_REDIRECT	BIT(2)
 #define STMMAC_RX_THRESH(x)	((x)->dma_rx_size / 4)
 
 static int flow_ctrl = FLOW_AUTO;
@@ -148,6 +162,19 @@ EXPORT_SYMBOL_GPL(stmmac_bus_clks_config);
  * Description: it checks the driver parameters and set a default in case of
  * errors.
  */
+u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv)
+{
+	unsigned long clk = clk_get_rate(priv->plat->stmmac_clk);
+
+	if (!clk) {
+		clk = priv->plat->clk_ref_rate;
+		if (!clk)
+			return 0;
+	}
+
+	return (usec * (clk / 1000000)) / 256;
+}
+
 static void stmmac_verify_args(void)
 {
 	if (unlikely(watchdog < 0))
@@ -1327,6 +1354,14 @@ static void stmmac_clear_descriptors(struct stmmac_priv *priv)
 		stmmac_clear_tx_descriptors(priv, queue);
 }
 
+/* pages backing one RX buffer, including the XDP headroom if any */
+static unsigned int stmmac_rx_buf_pages(struct stmmac_priv *priv)
+{
+	return roundup_pow_of_two(DIV_ROUND_UP(priv->dma_buf_sz +
+					       stmmac_rx_offset(priv),
+					       PAGE_SIZE));
+}
+
 /**
  * stmmac_init_rx_buffers - init the RX descriptor buffer.
  * @priv: driver private structure
@@ -1363,7 +1398,8 @@ static int stmmac_init_rx_buffers(struct stmmac_priv *priv, struct dma_desc *p,
 		stmmac_set_desc_sec_addr(priv, p, buf->sec_addr, false);
 	}
 
-	buf->addr = page_pool_get_dma_addr(buf->page);
+	buf->page_offset = stmmac_rx_offset(priv);
+	buf->addr = page_pool_get_dma_addr(buf->page) + buf->page_offset;
 	stmmac_set_desc_addr(priv, p, buf->addr);
 	if (priv->dma_buf_sz == BUF_SIZE_16KiB)
 		stmmac_init_desc3(priv, p);
@@ -1401,7 +1437,8 @@ static void stmmac_free_tx_buffer(struct stmmac_priv *priv, u32 queue, int i)
 {
 	struct stmmac_tx_queue *tx_q = &priv->tx_queue[queue];
 
-	if (tx_q->tx_skbuff_dma[i].buf) {
+	if (tx_q->tx_skbuff_dma[i].buf &&
+	    tx_q->tx_skbuff_dma[i].buf_type != STMMAC_TXBUF_T_XDP_TX) {
 		if (tx_q->tx_skbuff_dma[i].map_as_page)
 			dma_unmap_page(priv->device,
 				       tx_q->tx_skbuff_dma[i].buf,
@@ -1414,6 +1451,13 @@ static void stmmac_free_tx_buffer(struct stmmac_priv *priv, u32 queue, int i)
 					 DMA_TO_DEVICE);
 	}
 
+	if (tx_q->xdpf[i]) {
+		xdp_return_frame(tx_q->xdpf[i]);
+		tx_q->xdpf[i] = NULL;
+		tx_q->tx_skbuff_dma[i].buf = 0;
+		tx_q->tx_skbuff_dma[i].buf_type = STMMAC_TXBUF_T_SKB;
+	}
+
 	if (tx_q->tx_skbuff[i]) {
 		dev_kfree_skb_any(tx_q->tx_skbuff[i]);
 		tx_q->tx_skbuff[i] = NULL;
@@ -1651,6 +1695,9 @@ static void free_dma_rx_desc_resources(struct stmmac_priv *priv)
 					  sizeof(struct dma_extended_desc),
 					  rx_q->dma_erx, rx_q->dma_rx_phy);
 
+		if (xdp_rxq_info_is_reg(&rx_q->xdp_rxq))
+			xdp_rxq_info_unreg(&rx_q->xdp_rxq);
+
 		kfree(rx_q->buf_pool);
 		if (rx_q->page_pool)
 			page_pool_destroy(rx_q->page_pool);
@@ -1692,6 +1739,7 @@ static void free_dma_tx_desc_resources(struct stmmac_priv *priv)
 
 		kfree(tx_q->tx_skbuff_dma);
 		kfree(tx_q->tx_skbuff);
+		kfree(tx_q->xdpf);
 	}
 }
 
@@ -1720,12 +1768,14 @@ static int alloc_dma_rx_desc_resources(struct stmmac_priv *priv)
 
 		pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
 		pp_params.pool_size = priv->dma_rx_size;
-		num_pages = DIV_ROUND_UP(priv->dma_buf_sz, PAGE_SIZE);
+		num_pages = stmmac_rx_buf_pages(priv);
 		pp_params.order = ilog2(num_pages);
 		pp_params.nid = dev_to_node(priv->device);
 		pp_params.dev = priv->device;
-		pp_params.dma_dir = DMA_FROM_DEVICE;
-		pp_params.max_len = num_pages * PAGE_SIZE;
+		pp_params.dma_dir = stmmac_xdp_is_enabled(priv) ?
+				    DMA_BIDIRECTIONAL : DMA_FROM_DEVICE;
+		pp_params.offset = stmmac_rx_offset(priv);
+		pp_params.max_len = num_pages * PAGE_SIZE - pp_params.offset;
 
 		rx_q->page_pool = page_pool_create(&pp_params);
 		if (IS_ERR(rx_q->page_pool)) {
@@ -1734,6 +1784,22 @@ static int alloc_dma_rx_desc_resources(struct stmmac_priv *priv)
 			goto err_dma;
 		}
 
+		ret = xdp_rxq_info_reg(&rx_q->xdp_rxq, priv->dev,
+				       rx_q->queue_index);
+		if (ret) {
+			netdev_err(priv->dev, "Failed to register xdp rxq info\n");
+			goto err_dma;
+		}
+
+		ret = xdp_rxq_info_reg_mem_model(&rx_q->xdp_rxq,
+						 MEM_TYPE_PAGE_POOL,
+						 rx_q->page_pool);
+		if (ret) {
+			netdev_err(priv->dev, "Failed to register xdp mem model\n");
+			goto err_dma;
+		}
+		ret = -ENOMEM;
+
 		rx_q->buf_pool = kcalloc(priv->dma_rx_size,
 					 sizeof(*rx_q->buf_pool),
 					 GFP_KERNEL);
@@ -1797,6 +1863,11 @@ static int alloc_dma_tx_desc_resources(struct stmmac_priv *priv)
 		if (!tx_q->tx_skbuff_dma)
 			goto err_dma;
 
+		tx_q->xdpf = kcalloc(priv->dma_tx_size, sizeof(*tx_q->xdpf),
+				     GFP_KERNEL);
+		if (!tx_q->xdpf)
+			goto err_dma;
+
 		tx_q->tx_skbuff = kcalloc(priv->dma_tx_size,
 					  sizeof(struct sk_buff *),
 					  GFP_KERNEL);
@@ -2048,14 +2119,17 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 	struct stmmac_tx_queue *tx_q = &priv->tx_queue[queue];
 	unsigned int bytes_compl = 0, pkts_compl = 0;
 	unsigned int entry, count = 0;
+	u64 now;
 
 	__netif_tx_lock_bh(netdev_get_tx_queue(priv->dev, queue));
 
 	priv->xstats.tx_clean++;
+	now = ktime_get_ns();
 
 	entry = tx_q->dirty_tx;
 	while ((entry != tx_q->cur_tx) && (count < budget)) {
 		struct sk_buff *skb = tx_q->tx_skbuff[entry];
+		struct xdp_frame *xdpf = tx_q->xdpf[entry];
 		struct dma_desc *p;
 		int status;
 
@@ -2084,6 +2158,11 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 			/* ... verify the status error condition */
 			if (unlikely(status & tx_err)) {
 				priv->dev->stats.tx_errors++;
+				if (skb && skb_is_gso(skb) && priv->tso &&
+				    netif_carrier_ok(priv->dev) &&
+				    ++priv->xstats.tx_tso_errors ==
+				    STMMAC_TSO_ERR_THRESH)
+					stmmac_tso_fallback(priv);
 			} else {
 				priv->dev->stats.tx_packets++;
 				priv->xstats.tx_pkt_n++;
@@ -2091,7 +2170,9 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 			stmmac_get_tx_hwtstamp(priv, p, skb);
 		}
 
-		if (likely(tx_q->tx_skbuff_dma[entry].buf)) {
+		/* XDP_TX buffers stay mapped by the RX page_pool */
+		if (likely(tx_q->tx_skbuff_dma[entry].buf) &&
+		    tx_q->tx_skbuff_dma[entry].buf_type != STMMAC_TXBUF_T_XDP_TX) {
 			if (tx_q->tx_skbuff_dma[entry].map_as_page)
 				dma_unmap_page(priv->device,
 					       tx_q->tx_skbuff_dma[entry].buf,
@@ -2102,17 +2183,27 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 						 tx_q->tx_skbuff_dma[entry].buf,
 						 tx_q->tx_skbuff_dma[entry].len,
 						 DMA_TO_DEVICE);
-			tx_q->tx_skbuff_dma[entry].buf = 0;
-			tx_q->tx_skbuff_dma[entry].len = 0;
-			tx_q->tx_skbuff_dma[entry].map_as_page = false;
 		}
+		tx_q->tx_skbuff_dma[entry].buf = 0;
+		tx_q->tx_skbuff_dma[entry].len = 0;
+		tx_q->tx_skbuff_dma[entry].map_as_page = false;
 
 		stmmac_clean_desc3(priv, tx_q, p);
 
 		tx_q->tx_skbuff_dma[entry].last_segment = false;
 		tx_q->tx_skbuff_dma[entry].is_jumbo = false;
 
+		if (xdpf) {
+			xdp_return_frame(xdpf);
+			tx_q->xdpf[entry] = NULL;
+			tx_q->tx_skbuff_dma[entry].buf_type = STMMAC_TXBUF_T_SKB;
+		}
+
 		if (likely(skb != NULL)) {
+			rk_lat_hist_add(&tx_q->tx_lat,
+					now - tx_q->tx_skbuff_dma[entry].xmit_ns);
+			trace_stmmac_tx_done(skb, queue,
+					     tx_q->tx_skbuff_dma[entry].xmit_ns, now);
 			pkts_compl++;
 			bytes_compl += skb->len;
 			dev_consume_skb_any(skb);
@@ -2125,6 +2216,9 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 	}
 	tx_q->dirty_tx = entry;
 
+	priv->channel[queue].tx_dim_pkts += pkts_compl;
+	priv->channel[queue].tx_dim_bytes += bytes_compl;
+
 	netdev_tx_completed_queue(netdev_get_tx_queue(priv->dev, queue),
 				  pkts_compl, bytes_compl);
 
@@ -2143,7 +2237,9 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 	}
 
 	/* We still have pending packets, let's call for a new scheduling */
-	if (tx_q->dirty_tx != tx_q->cur_tx)
+	if (tx_q->dirty_tx != tx_q->cur_tx &&
+	    !rk_irq_align_queue(&tx_q->txalign,
+				(u64)priv->tx_coal_timer * NSEC_PER_USEC))
 		mod_timer(&tx_q->txtimer, STMMAC_COAL_TIMER(priv->tx_coal_timer));
 
 	__netif_tx_unlock_bh(netdev_get_tx_queue(priv->dev, queue));
@@ -2226,6 +2322,25 @@ static bool stmmac_safety_feat_interrupt(struct stmmac_priv *priv)
 	return false;
 }
 
+static void stmmac_rx_napi_ipi(void *data)
+{
+	struct stmmac_channel *ch = data;
+
+	__napi_schedule_irqoff(&ch->rx_napi);
+}
+
+static void stmmac_rx_napi_schedule(struct stmmac_channel *ch)
+{
+	int cpu = ch->rx_cpu;
+
+	/* The csd is only reused once the poll it kicked has completed,
+	 * napi_schedule_prep() guarantees that.
+	 */
+	if (cpu < 0 || cpu == smp_processor_id() ||
+	    smp_call_function_single_async(cpu, &ch->rx_csd))
+		__napi_schedule(&ch->rx_napi);
+}
+
 static int stmmac_napi_check(struct stmmac_priv *priv, u32 chan)
 {
 	int status = stmmac_dma_interrupt_status(priv, priv->ioaddr,
@@ -2234,15 +2349,17 @@ static int stmmac_napi_check(struct stmmac_priv *priv, u32 chan)
 	unsigned long flags;
 
 	if ((status & handle_rx) && (chan < priv->plat->rx_queues_to_use)) {
+		ch->rx_dim_events++;
 		if (napi_schedule_prep(&ch->rx_napi)) {
 			spin_lock_irqsave(&ch->lock, flags);
 			stmmac_disable_dma_irq(priv, priv->ioaddr, chan, 1, 0);
 			spin_unlock_irqrestore(&ch->lock, flags);
-			__napi_schedule(&ch->rx_napi);
+			stmmac_rx_napi_schedule(ch);
 		}
 	}
 
 	if ((status & handle_tx) && (chan < priv->plat->tx_queues_to_use)) {
+		ch->tx_dim_events++;
 		if (napi_schedule_prep(&ch->tx_napi)) {
 			spin_lock_irqsave(&ch->lock, flags);
 			stmmac_disable_dma_irq(priv, priv->ioaddr, chan, 0, 1);
@@ -2431,18 +2548,23 @@ static void stmmac_tx_timer_arm(struct stmmac_priv *priv, u32 queue)
 {
 	struct stmmac_tx_queue *tx_q = &priv->tx_queue[queue];
 
+	/* tx clean can wait, let it ride on a wakeup that happens anyway */
+	if (rk_irq_align_queue(&tx_q->txalign,
+			       (u64)priv->tx_coal_timer * NSEC_PER_USEC))
+		return;
+
 	mod_timer(&tx_q->txtimer, STMMAC_COAL_TIMER(priv->tx_coal_timer));
 }
 
 /**
- * stmmac_tx_timer - mitigation sw timer for tx.
- * @t: data pointer
+ * stmmac_tx_kick - mitigation sw timer for tx.
+ * @tx_q: tx queue
  * Description:
- * This is the timer handler to directly invoke the stmmac_tx_clean.
+ * This is the timer (or aligned wakeup) handler to directly invoke the
+ * stmmac_tx_clean.
  */
-static void stmmac_tx_timer(struct timer_list *t)
+static void stmmac_tx_kick(struct stmmac_tx_queue *tx_q)
 {
-	struct stmmac_tx_queue *tx_q = from_timer(tx_q, t, txtimer);
 	struct stmmac_priv *priv = tx_q->priv_data;
 	struct stmmac_channel *ch;
 
@@ -2458,6 +2580,21 @@ static void stmmac_tx_timer(struct timer_list *t)
 	}
 }
 
+static void stmmac_tx_timer(struct timer_list *t)
+{
+	struct stmmac_tx_queue *tx_q = from_timer(tx_q, t, txtimer);
+
+	stmmac_tx_kick(tx_q);
+}
+
+static void stmmac_tx_align(struct rk_irq_align_work *work)
+{
+	struct stmmac_tx_queue *tx_q =
+		container_of(work, struct stmmac_tx_queue, txalign);
+
+	stmmac_tx_kick(tx_q);
+}
+
 /**
  * stmmac_init_coalesce - init mitigation options.
  * @priv: driver private structure
@@ -2479,6 +2616,7 @@ static void stmmac_init_coalesce(struct stmmac_priv *priv)
 		struct stmmac_tx_queue *tx_q = &priv->tx_queue[chan];
 
 		timer_setup(&tx_q->txtimer, stmmac_tx_timer, 0);
+		rk_irq_align_init_work(&tx_q->txalign, stmmac_tx_align);
 	}
 }
 
@@ -2857,7 +2995,7 @@ static void stmmac_hw_teardown(struct net_device *dev)
  *  0 on success and an appropriate (-)ve integer as defined in errno.h
  *  file on failure.
  */
-static int stmmac_open(struct net_device *dev)
+int stmmac_open(struct net_device *dev)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
 	int bfsize = 0;
@@ -2997,8 +3135,10 @@ static int stmmac_open(struct net_device *dev)
 irq_error:
 	phylink_stop(priv->phylink);
 
-	for (chan = 0; chan < priv->plat->tx_queues_to_use; chan++)
+	for (chan = 0; chan < priv->plat->tx_queues_to_use; chan++) {
 		del_timer_sync(&priv->tx_queue[chan].txtimer);
+		rk_irq_align_cancel(&priv->tx_queue[chan].txalign);
+	}
 
 	stmmac_hw_teardown(dev);
 init_error:
@@ -3016,7 +3156,7 @@ static int stmmac_open(struct net_device *dev)
  *  Description:
  *  This is the stop entry point of the driver.
  */
-static int stmmac_release(struct net_device *dev)
+int stmmac_release(struct net_device *dev)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
 	u32 chan;
@@ -3032,8 +3172,15 @@ static int stmmac_release(struct net_device *dev)
 
 	stmmac_disable_all_queues(priv);
 
-	for (chan = 0; chan < priv->plat->tx_queues_to_use; chan++)
+	for (chan = 0; chan < priv->plat->tx_queues_to_use; chan++) {
 		del_timer_sync(&priv->tx_queue[chan].txtimer);
+		rk_irq_align_cancel(&priv->tx_queue[chan].txalign);
+	}
+
+	for (chan = 0; chan < priv->plat->rx_queues_to_use; chan++)
+		cancel_work_sync(&priv->channel[chan].rx_dim.work);
+	for (chan = 0; chan < priv->plat->tx_queues_to_use; chan++)
+		cancel_work_sync(&priv->channel[chan].tx_dim.work);
 
 	/* Free the IRQ lines */
 	free_irq(dev->irq, dev);
@@ -3308,6 +3455,7 @@ static netdev_tx_t stmmac_tso_xmit(struct sk_buff *skb, struct net_device *dev)
 
 	/* Only the last descriptor gets to point to the skb. */
 	tx_q->tx_skbuff[tx_q->cur_tx] = skb;
+	tx_q->tx_skbuff_dma[tx_q->cur_tx].xmit_ns = ktime_get_ns();
 
 	/* Manage tx mitigation */
 	tx_packets = (tx_q->cur_tx + 1) - first_tx;
@@ -3443,6 +3591,8 @@ static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
 	tx_q = &priv->tx_queue[queue];
 	first_tx = tx_q->cur_tx;
 
+	trace_stmmac_xmit(skb, queue);
+
 	if (priv->tx_path_in_lpi_mode)
 		stmmac_disable_eee_mode(priv);
 
@@ -3533,6 +3683,7 @@ static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
 
 	/* Only the last descriptor gets to point to the skb. */
 	tx_q->tx_skbuff[entry] = skb;
+	tx_q->tx_skbuff_dma[entry].xmit_ns = ktime_get_ns();
 
 	/* According to the coalesce parameter the IC bit for the latest
 	 * segment is reset and the timer re-started to clean the tx status.
@@ -3696,6 +3847,203 @@ static void stmmac_rx_vlan(struct net_device *dev, struct sk_buff *skb)
  * Description : this is to reallocate the skb for the reception process
  * that is based on zero-copy.
  */
+static int stmmac_xdp_get_tx_queue(struct stmmac_priv *priv, int cpu)
+{
+	int index = cpu;
+
+	if (unlikely(index < 0))
+		index = 0;
+
+	while (index >= priv->plat->tx_queues_to_use)
+		index -= priv->plat->tx_queues_to_use;
+
+	return index;
+}
+
+/* Called with the netdev tx queue lock held */
+static int stmmac_xdp_xmit_xdpf(struct stmmac_priv *priv, int queue,
+				struct xdp_frame *xdpf, bool dma_map)
+{
+	struct stmmac_tx_queue *tx_q = &priv->tx_queue[queue];
+	unsigned int entry = tx_q->cur_tx;
+	struct dma_desc *tx_desc;
+	dma_addr_t dma_addr;
+	bool set_ic;
+
+	if (stmmac_tx_avail(priv, queue) < STMMAC_TX_THRESH(priv))
+		return STMMAC_XDP_CONSUMED;
+
+	if (likely(priv->extend_desc))
+		tx_desc = (struct dma_desc *)(tx_q->dma_etx + entry);
+	else if (tx_q->tbs & STMMAC_TBS_AVAIL)
+		tx_desc = &tx_q->dma_entx[entry].basic;
+	else
+		tx_desc = tx_q->dma_tx + entry;
+
+	if (dma_map) {
+		dma_addr = dma_map_single(priv->device, xdpf->data,
+					  xdpf->len, DMA_TO_DEVICE);
+		if (dma_mapping_error(priv->device, dma_addr))
+			return STMMAC_XDP_CONSUMED;
+
+		tx_q->tx_skbuff_dma[entry].buf_type = STMMAC_TXBUF_T_XDP_NDO;
+	} else {
+		struct page *page = virt_to_page(xdpf->data);
+
+		dma_addr = page_pool_get_dma_addr(page) + sizeof(*xdpf) +
+			   xdpf->headroom;
+		dma_sync_single_for_device(priv->device, dma_addr,
+					   xdpf->len, DMA_BIDIRECTIONAL);
+
+		tx_q->tx_skbuff_dma[entry].buf_type = STMMAC_TXBUF_T_XDP_TX;
+	}
+
+	tx_q->tx_skbuff_dma[entry].buf = dma_addr;
+	tx_q->tx_skbuff_dma[entry].map_as_page = false;
+	tx_q->tx_skbuff_dma[entry].len = xdpf->len;
+	tx_q->tx_skbuff_dma[entry].last_segment = true;
+	tx_q->tx_skbuff_dma[entry].is_jumbo = false;
+
+	tx_q->xdpf[entry] = xdpf;
+
+	stmmac_set_desc_addr(priv, tx_desc, dma_addr);
+
+	stmmac_prepare_tx_desc(priv, tx_desc, 1, xdpf->len,
+			       0, priv->mode, true, true,
+			       xdpf->len);
+
+	tx_q->tx_count_frames++;
+
+	if (!priv->tx_coal_frames)
+		set_ic = false;
+	else if (tx_q->tx_count_frames % priv->tx_coal_frames == 0)
+		set_ic = true;
+	else
+		set_ic = false;
+
+	if (set_ic) {
+		tx_q->tx_count_frames = 0;
+		stmmac_set_tx_ic(priv, tx_desc);
+		priv->xstats.tx_set_ic_bit++;
+	}
+
+	entry = STMMAC_GET_ENTRY(entry, priv->dma_tx_size);
+	tx_q->cur_tx = entry;
+
+	return STMMAC_XDP_TX;
+}
+
+static void stmmac_xdp_flush_tx(struct stmmac_priv *priv, int queue)
+{
+	struct stmmac_tx_queue *tx_q = &priv->tx_queue[queue];
+	int desc_size;
+
+	/* Descriptors must be visible before kicking the DMA */
+	wmb();
+
+	stmmac_enable_dma_transmission(priv, priv->ioaddr);
+
+	if (likely(priv->extend_desc))
+		desc_size = sizeof(struct dma_extended_desc);
+	else if (tx_q->tbs & STMMAC_TBS_AVAIL)
+		desc_size = sizeof(struct dma_edesc);
+	else
+		desc_size = sizeof(struct dma_desc);
+
+	tx_q->tx_tail_addr = tx_q->dma_tx_phy + (tx_q->cur_tx * desc_size);
+	stmmac_set_tx_tail_ptr(priv, priv->ioaddr, tx_q->tx_tail_addr, queue);
+	stmmac_tx_timer_arm(priv, queue);
+}
+
+static int stmmac_xdp_xmit_back(struct stmmac_priv *priv,
+				struct xdp_buff *xdp)
+{
+	struct xdp_frame *xdpf = xdp_convert_buff_to_frame(xdp);
+	int cpu = smp_processor_id();
+	struct netdev_queue *nq;
+	int queue;
+	int res;
+
+	if (unlikely(!xdpf))
+		return STMMAC_XDP_CONSUMED;
+
+	queue = stmmac_xdp_get_tx_queue(priv, cpu);
+	nq = netdev_get_tx_queue(priv->dev, queue);
+
+	__netif_tx_lock(nq, cpu);
+	/* Avoids TX time-out as we are sharing with slow path */
+	nq->trans_start = jiffies;
+
+	res = stmmac_xdp_xmit_xdpf(priv, queue, xdpf, false);
+	if (res == STMMAC_XDP_TX)
+		stmmac_xdp_flush_tx(priv, queue);
+
+	__netif_tx_unlock(nq);
+
+	return res;
+}
+
+/**
+ * stmmac_rx_xdp - run the XDP program on a received frame
+ * @priv: driver private structure
+ * @rx_q: RX queue the frame was received on
+ * @buf: RX buffer holding the whole frame
+ * @prog: XDP program
+ * @data: frame start, updated for XDP_PASS
+ * @len: frame length, updated for XDP_PASS
+ * Description: on anything but XDP_PASS the buffer page is handed over
+ * (TX/REDIRECT) or recycled (DROP/ABORTED) and buf->page is cleared.
+ */
+static int stmmac_rx_xdp(struct stmmac_priv *priv,
+			 struct stmmac_rx_queue *rx_q,
+			 struct stmmac_rx_buffer *buf,
+			 struct bpf_prog *prog,
+			 void **data, unsigned int *len)
+{
+	struct xdp_buff xdp;
+	int res;
+	u32 act;
+
+	xdp.data_hard_start = page_address(buf->page);
+	xdp.data = *data;
+	xdp.data_end = xdp.data + *len;
+	xdp_set_data_meta_invalid(&xdp);
+	xdp.frame_sz = stmmac_rx_buf_pages(priv) * PAGE_SIZE;
+	xdp.rxq = &rx_q->xdp_rxq;
+
+	act = bpf_prog_run_xdp(prog, &xdp);
+	switch (act) {
+	case XDP_PASS:
+		*data = xdp.data;
+		*len = xdp.data_end - xdp.data;
+		return STMMAC_XDP_PASS;
+	case XDP_TX:
+		res = stmmac_xdp_xmit_back(priv, &xdp);
+		break;
+	case XDP_REDIRECT:
+		if (xdp_do_redirect(priv->dev, &xdp, prog) < 0)
+			res = STMMAC_XDP_CONSUMED;
+		else
+			res = STMMAC_XDP_REDIRECT;
+		break;
+	default:
+		bpf_warn_invalid_xdp_action(act);
+		fallthrough;
+	case XDP_ABORTED:
+		trace_xdp_exception(priv->dev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		res = STMMAC_XDP_CONSUMED;
+		break;
+	}
+
+	if (res == STMMAC_XDP_CONSUMED)
+		page_pool_recycle_direct(rx_q->page_pool, buf->page);
+	buf->page = NULL;
+
+	return res;
+}
+
 static inline void stmmac_rx_refill(struct stmmac_priv *priv, u32 queue)
 {
 	struct stmmac_rx_queue *rx_q = &priv->rx_queue[queue];
@@ -3732,7 +4080,8 @@ static inline void stmmac_rx_refill(struct stmmac_priv *priv, u32 queue)
 			buf->sec_addr = page_pool_get_dma_addr(buf->sec_page);
 		}
 
-		buf->addr = page_pool_get_dma_addr(buf->page);
+		buf->page_offset = stmmac_rx_offset(priv);
+		buf->addr = page_pool_get_dma_addr(buf->page) + buf->page_offset;
 		stmmac_set_desc_addr(priv, p, buf->addr);
 		if (priv->sph)
 			stmmac_set_desc_sec_addr(priv, p, buf->sec_addr, true);
@@ -3823,10 +4172,17 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 	struct stmmac_rx_queue *rx_q = &priv->rx_queue[queue];
 	struct stmmac_channel *ch = &priv->channel[queue];
 	unsigned int count = 0, error = 0, len = 0;
+	unsigned int rx_bytes = 0;
 	int status = 0, coe = priv->hw->rx_csum;
 	unsigned int next_entry = rx_q->cur_rx;
+	enum dma_data_direction dma_dir;
 	unsigned int desc_size;
 	struct sk_buff *skb = NULL;
+	struct bpf_prog *prog;
+	int xdp_status = 0;
+
+	dma_dir = page_pool_get_dma_dir(rx_q->page_pool);
+	prog = READ_ONCE(priv->xdp_prog);
 
 	if (netif_msg_rx_status(priv)) {
 		void *rx_head;
@@ -3944,6 +4300,35 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 		}
 
 		if (!skb) {
+			void *data = page_address(buf->page) + buf->page_offset;
+
+			dma_sync_single_for_cpu(priv->device, buf->addr,
+						buf1_len, dma_dir);
+
+			/* XDP runs on whole frames, SPH is off so a frame
+			 * that fits the MTU always ends in its first buffer.
+			 */
+			if (prog && likely(!(status & rx_not_ls))) {
+				unsigned int xdp_len = buf1_len;
+				int res;
+
+				res = stmmac_rx_xdp(priv, rx_q, buf, prog,
+						    &data, &buf1_len);
+				if (res != STMMAC_XDP_PASS) {
+					if (res & STMMAC_XDP_CONSUMED) {
+						priv->dev->stats.rx_dropped++;
+					} else {
+						priv->dev->stats.rx_packets++;
+						priv->dev->stats.rx_bytes += len;
+						rx_bytes += len;
+					}
+					xdp_status |= res;
+					count++;
+					continue;
+				}
+				len = len - xdp_len + buf1_len;
+			}
+
 			skb = napi_alloc_skb(&ch->rx_napi, buf1_len);
 			if (!skb) {
 				priv->dev->stats.rx_dropped++;
@@ -3951,10 +4336,7 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 				goto drain_data;
 			}
 
-			dma_sync_single_for_cpu(priv->device, buf->addr,
-						buf1_len, DMA_FROM_DEVICE);
-			skb_copy_to_linear_data(skb, page_address(buf->page),
-						buf1_len);
+			skb_copy_to_linear_data(skb, data, buf1_len);
 			skb_put(skb, buf1_len);
 
 			/* Data payload copied into SKB, page ready for recycle */
@@ -3962,9 +4344,9 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 			buf->page = NULL;
 		} else if (buf1_len) {
 			dma_sync_single_for_cpu(priv->device, buf->addr,
-						buf1_len, DMA_FROM_DEVICE);
+						buf1_len, dma_dir);
 			skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags,
-					buf->page, 0, buf1_len,
+					buf->page, buf->page_offset, buf1_len,
 					priv->dma_buf_sz);
 
 			/* Data payload appended into SKB */
@@ -3974,7 +4356,7 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 
 		if (buf2_len) {
 			dma_sync_single_for_cpu(priv->device, buf->sec_addr,
-						buf2_len, DMA_FROM_DEVICE);
+						buf2_len, dma_dir);
 			skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags,
 					buf->sec_page, 0, buf2_len,
 					priv->dma_buf_sz);
@@ -4010,6 +4392,7 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 
 		priv->dev->stats.rx_packets++;
 		priv->dev->stats.rx_bytes += len;
+		rx_bytes += len;
 		count++;
 	}
 
@@ -4020,13 +4403,108 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 		rx_q->state.len = len;
 	}
 
+	if (xdp_status & STMMAC_XDP_REDIRECT)
+		xdp_do_flush();
+
 	stmmac_rx_refill(priv, queue);
 
 	priv->xstats.rx_pkt_n += count;
+	ch->rx_dim_pkts += count;
+	ch->rx_dim_bytes += rx_bytes;
 
 	return count;
 }
 
+/* DIM levels from least to most moderated, usec/pkts pairs.  Tuned for
+ * the single core Rockchip parts where every rx/tx irq competes with the
+ * camera pipeline: the top levels hold interrupts off much longer than
+ * the generic net_dim tables.
+ */
+#define STMMAC_DIM_PROFILES	5
+
+static const struct dim_cq_moder stmmac_dim_rx_profile[STMMAC_DIM_PROFILES] = {
+	{ .usec = 16, .pkts = 1 },
+	{ .usec = 32, .pkts = 8 },
+	{ .usec = 64, .pkts = 16 },
+	{ .usec = 128, .pkts = 32 },
+	{ .usec = 256, .pkts = 64 },
+};
+
+static const struct dim_cq_moder stmmac_dim_tx_profile[STMMAC_DIM_PROFILES] = {
+	{ .usec = 250, .pkts = 4 },
+	{ .usec = 500, .pkts = 16 },
+	{ .usec = 1000, .pkts = 25 },
+	{ .usec = 2000, .pkts = 64 },
+	{ .usec = 4000, .pkts = 128 },
+};
+
+static void stmmac_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_channel *ch =
+		container_of(dim, struct stmmac_channel, rx_dim);
+	struct stmmac_priv *priv = ch->priv_data;
+	const struct dim_cq_moder *moder;
+	u32 riwt;
+
+	moder = &stmmac_dim_rx_profile[min_t(u8, dim->profile_ix,
+					     STMMAC_DIM_PROFILES - 1)];
+	riwt = clamp_t(u32, stmmac_usec2riwt(moder->usec, priv),
+		       MIN_DMA_RIWT, MAX_DMA_RIWT);
+
+	/* The watchdog is programmed for all rx channels at once, on the
+	 * single queue setups this targets that is exactly one channel.
+	 */
+	priv->rx_riwt = riwt;
+	priv->rx_coal_frames = moder->pkts;
+	stmmac_rx_watchdog(priv, priv->ioaddr, riwt,
+			   priv->plat->rx_queues_to_use);
+
+	dim->state = DIM_START_MEASURE;
+}
+
+static void stmmac_tx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_channel *ch =
+		container_of(dim, struct stmmac_channel, tx_dim);
+	struct stmmac_priv *priv = ch->priv_data;
+	const struct dim_cq_moder *moder;
+
+	moder = &stmmac_dim_tx_profile[min_t(u8, dim->profile_ix,
+					     STMMAC_DIM_PROFILES - 1)];
+	priv->tx_coal_timer = moder->usec;
+	priv->tx_coal_frames = moder->pkts;
+
+	dim->state = DIM_START_MEASURE;
+}
+
+static void stmmac_rx_dim_update(struct stmmac_priv *priv,
+				 struct stmmac_channel *ch)
+{
+	struct dim_sample sample = {};
+
+	if (!priv->rx_dim_en)
+		return;
+
+	dim_update_sample(ch->rx_dim_events, ch->rx_dim_pkts,
+			  ch->rx_dim_bytes, &sample);
+	net_dim(&ch->rx_dim, sample);
+}
+
+static void stmmac_tx_dim_update(struct stmmac_priv *priv,
+				 struct stmmac_channel *ch)
+{
+	struct dim_sample sample = {};
+
+	if (!priv->tx_dim_en)
+		return;
+
+	dim_update_sample(ch->tx_dim_events, ch->tx_dim_pkts,
+			  ch->tx_dim_bytes, &sample);
+	net_dim(&ch->tx_dim, sample);
+}
+
 static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 {
 	struct stmmac_channel *ch =
@@ -4041,6 +4519,8 @@ static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 	if (work_done < budget && napi_complete_done(napi, work_done)) {
 		unsigned long flags;
 
+		stmmac_rx_dim_update(priv, ch);
+
 		spin_lock_irqsave(&ch->lock, flags);
 		stmmac_enable_dma_irq(priv, priv->ioaddr, chan, 1, 0);
 		spin_unlock_irqrestore(&ch->lock, flags);
@@ -4065,6 +4545,8 @@ static int stmmac_napi_poll_tx(struct napi_struct *napi, int budget)
 	if (work_done < budget && napi_complete_done(napi, work_done)) {
 		unsigned long flags;
 
+		stmmac_tx_dim_update(priv, ch);
+
 		spin_lock_irqsave(&ch->lock, flags);
 		stmmac_enable_dma_irq(priv, priv->ioaddr, chan, 0, 1);
 		spin_unlock_irqrestore(&ch->lock, flags);
@@ -4132,6 +4614,11 @@ static int stmmac_change_mtu(struct net_device *dev, int new_mtu)
 		return -EBUSY;
 	}
 
+	if (stmmac_xdp_is_enabled(priv) && new_mtu > ETH_DATA_LEN) {
+		netdev_dbg(priv->dev, "Jumbo frames not supported for XDP\n");
+		return -EINVAL;
+	}
+
 	new_mtu = STMMAC_ALIGN(new_mtu);
 
 	/* If condition true, FIFO is too small or MTU too large */
@@ -4166,10 +4653,14 @@ static netdev_features_t stmmac_fix_features(struct net_device *dev,
 
 	/* Disable tso if asked by ethtool */
 	if ((priv->plat->tso_en) && (priv->dma_cap.tsoen)) {
-		if (features & NETIF_F_TSO)
+		if (features & NETIF_F_TSO) {
+			/* (re-)enabled, give the hardware a fresh start */
+			if (!priv->tso)
+				priv->xstats.tx_tso_errors = 0;
 			priv->tso = true;
-		else
+		} else {
 			priv->tso = false;
+		}
 	}
 
 	return features;
@@ -4745,6 +5236,59 @@ static int stmmac_vlan_rx_kill_vid(struct net_device *ndev, __be16 proto, u16 vi
 	return ret;
 }
 
+static int stmmac_bpf(struct net_device *dev, struct netdev_bpf *bpf)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return stmmac_xdp_set_prog(priv, bpf->prog, bpf->extack);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static int stmmac_xdp_xmit(struct net_device *dev, int num_frames,
+			   struct xdp_frame **frames, u32 flags)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	int cpu = smp_processor_id();
+	struct netdev_queue *nq;
+	int i, drops = 0;
+	int queue;
+
+	if (unlikely(!netif_running(dev) ||
+		     test_bit(STMMAC_DOWN, &priv->state)))
+		return -ENETDOWN;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	queue = stmmac_xdp_get_tx_queue(priv, cpu);
+	nq = netdev_get_tx_queue(priv->dev, queue);
+
+	__netif_tx_lock(nq, cpu);
+	/* Avoids TX time-out as we are sharing with slow path */
+	nq->trans_start = jiffies;
+
+	for (i = 0; i < num_frames; i++) {
+		int res;
+
+		res = stmmac_xdp_xmit_xdpf(priv, queue, frames[i], true);
+		if (res == STMMAC_XDP_CONSUMED) {
+			xdp_return_frame_rx_napi(frames[i]);
+			drops++;
+		}
+	}
+
+	if (flags & XDP_XMIT_FLUSH)
+		stmmac_xdp_flush_tx(priv, queue);
+
+	__netif_tx_unlock(nq);
+
+	return num_frames - drops;
+}
+
 static const struct net_device_ops stmmac_netdev_ops = {
 	.ndo_open = stmmac_open,
 	.ndo_start_xmit = stmmac_xmit,
@@ -4763,6 +5307,8 @@ static const struct net_device_ops stmmac_netdev_ops = {
 	.ndo_set_mac_address = stmmac_set_mac_address,
 	.ndo_vlan_rx_add_vid = stmmac_vlan_rx_add_vid,
 	.ndo_vlan_rx_kill_vid = stmmac_vlan_rx_kill_vid,
+	.ndo_bpf = stmmac_bpf,
+	.ndo_xdp_xmit = stmmac_xdp_xmit,
 };
 
 static void stmmac_reset_subtask(struct stmmac_priv *priv)
@@ -4787,12 +5333,45 @@ static void stmmac_reset_subtask(struct stmmac_priv *priv)
 	rtnl_unlock();
 }
 
+/**
+ * stmmac_tso_fallback - stop using hardware TSO
+ * @priv: driver private structure
+ * Description: called when TSO frames keep failing on the wire or the
+ * TSO selftest fails. TSO is turned off as if by "ethtool -K tso off",
+ * so the stack segments in software from now on and the user may turn
+ * it back on once the cause is known. Safe from any context.
+ */
+void stmmac_tso_fallback(struct stmmac_priv *priv)
+{
+	set_bit(STMMAC_TSO_FALLBACK, &priv->state);
+	stmmac_service_event_schedule(priv);
+}
+
+static void stmmac_tso_fallback_subtask(struct stmmac_priv *priv)
+{
+	struct net_device *dev = priv->dev;
+
+	if (!test_and_clear_bit(STMMAC_TSO_FALLBACK, &priv->state))
+		return;
+
+	rtnl_lock();
+	if (dev->wanted_features & (NETIF_F_TSO | NETIF_F_TSO6 |
+				    NETIF_F_GSO_UDP_L4)) {
+		netdev_warn(dev, "TSO misbehaving, falling back to GSO\n");
+		dev->wanted_features &= ~(NETIF_F_TSO | NETIF_F_TSO6 |
+					  NETIF_F_GSO_UDP_L4);
+		netdev_update_features(dev);
+	}
+	rtnl_unlock();
+}
+
 static void stmmac_service_task(struct work_struct *work)
 {
 	struct stmmac_priv *priv = container_of(work, struct stmmac_priv,
 			service_task);
 
 	stmmac_reset_subtask(priv);
+	stmmac_tso_fallback_subtask(priv);
 	clear_bit(STMMAC_SERVICE_SCHED, &priv->state);
 }
 
@@ -4895,6 +5474,14 @@ static int stmmac_hw_init(struct stmmac_priv *priv)
 			 "Enable RX Mitigation via HW Watchdog Timer\n");
 	}
 
+	/* A single core has no other cpu to absorb the irq load, let
+	 * DIM pick the moderation there unless ethtool turns it off.
+	 */
+	if (num_possible_cpus() == 1) {
+		priv->rx_dim_en = priv->use_riwt;
+		priv->tx_dim_en = true;
+	}
+
 	return 0;
 }
 
@@ -4918,7 +5505,21 @@ static void stmmac_napi_add(struct net_device *dev)
 		ch->index = queue;
 		spin_lock_init(&ch->lock);
 
+		INIT_WORK(&ch->rx_dim.work, stmmac_rx_dim_work);
+		ch->rx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+		INIT_WORK(&ch->tx_dim.work, stmmac_tx_dim_work);
+		ch->tx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+
+		ch->rx_cpu = -1;
 		if (queue < priv->plat->rx_queues_to_use) {
+			struct stmmac_rxq_cfg *cfg = &priv->plat->rx_queues_cfg[queue];
+
+			if (cfg->use_cpu && cfg->cpu < nr_cpu_ids &&
+			    cpu_possible(cfg->cpu))
+				ch->rx_cpu = cfg->cpu;
+			ch->rx_csd.func = stmmac_rx_napi_ipi;
+			ch->rx_csd.info = ch;
+
 			netif_napi_add(dev, &ch->rx_napi, stmmac_napi_poll_rx,
 				       rx_budget);
 		}
@@ -5085,7 +5686,8 @@ int stmmac_dvr_probe(struct device *device,
 	if (priv->dma_cap.sphen && !priv->plat->sph_disable) {
 		ndev->hw_features |= NETIF_F_GRO;
 		if (!priv->plat->sph_disable) {
-			priv->sph = true;
+			priv->sph_cap = true;
+			priv->sph = priv->sph_cap;
 			dev_info(priv->device, "SPH feature enabled\n");
 		}
 	}
@@ -5285,6 +5887,39 @@ int stmmac_dvr_remove(struct device *dev)
 }
 EXPORT_SYMBOL_GPL(stmmac_dvr_remove);
 
+/**
+ * stmmac_wol_offload - arm the PMT helpers that keep the host asleep
+ * @priv: driver private structure
+ * @en: arm before power down, disarm on resume
+ * Description: while powered down the MAC answers ARP requests for the
+ * first IPv4 address of the interface, and only wakes the host for the
+ * packets matching the ethtool wake filters.
+ */
+static void stmmac_wol_offload(struct stmmac_priv *priv, bool en)
+{
+	struct in_device *in_dev;
+	struct in_ifaddr *ifa;
+	u32 addr = 0;
+
+	if (en && (priv->wolopts & WAKE_FILTER))
+		stmmac_set_wake_filter(priv, priv->hw, priv->wake_filters,
+				       STMMAC_WAKE_FILTERS);
+
+	if (!priv->dma_cap.arpoffsel)
+		return;
+
+	if (en) {
+		rcu_read_lock();
+		in_dev = __in_dev_get_rcu(priv->dev);
+		ifa = in_dev ? rcu_dereference(in_dev->ifa_list) : NULL;
+		if (ifa)
+			addr = ntohl(ifa->ifa_local);
+		rcu_read_unlock();
+	}
+
+	stmmac_set_arp_offload(priv, priv->hw, !!addr, addr);
+}
+
 /**
  * stmmac_suspend - suspend callback
  * @dev: device pointer
@@ -5309,8 +5944,10 @@ int stmmac_suspend(struct device *dev)
 
 	stmmac_disable_all_queues(priv);
 
-	for (chan = 0; chan < priv->plat->tx_queues_to_use; chan++)
+	for (chan = 0; chan < priv->plat->tx_queues_to_use; chan++) {
 		del_timer_sync(&priv->tx_queue[chan].txtimer);
+		rk_irq_align_cancel(&priv->tx_queue[chan].txalign);
+	}
 
 	if (priv->eee_enabled) {
 		priv->tx_path_in_lpi_mode = false;
@@ -5325,6 +5962,7 @@ int stmmac_suspend(struct device *dev)
 
 	/* Enable Power down mode by programming the PMT regs */
 	if (device_may_wakeup(priv->device) && priv->plat->pmt) {
+		stmmac_wol_offload(priv, true);
 		stmmac_pmt(priv, priv->hw, priv->wolopts);
 		priv->irq_wake = 1;
 	} else {
@@ -5401,6 +6039,7 @@ int stmmac_resume(struct device *dev)
 	if (device_may_wakeup(priv->device) && priv->plat->pmt) {
 		mutex_lock(&priv->lock);
 		stmmac_pmt(priv, priv->hw, 0);
+		stmmac_wol_offload(priv, false);
 		mutex_unlock(&priv->lock);
 		priv->irq_wake = 0;
 	} else {
@@ -198,6 +198,13 @@ static int stmmac_mtl_setup(struct platform_device *pdev,
 			plat->rx_queues_cfg[queue].use_prio = true;
 		}
 
+		/* CPU that runs the NAPI poll of this RX queue */
+		if (of_property_read_u32(q_node, "snps,napi-cpu",
+					 &plat->rx_queues_cfg[queue].cpu))
+			plat->rx_queues_cfg[queue].use_cpu = false;
+		else
+			plat->rx_queues_cfg[queue].use_cpu = true;
+
 		/* RX queue specific packet type routing */
 		if (of_property_read_bool(q_node, "snps,route-avcp"))
 			plat->rx_queues_cfg[queue].pkt_route = PACKET_AVCPQ;
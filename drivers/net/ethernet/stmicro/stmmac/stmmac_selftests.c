@@ -1811,6 +1811,182 @@ static int stmmac_test_tbs(struct stmmac_priv *priv)
 	return ret;
 }
 
+struct stmmac_tso_priv {
+	struct packet_type pt;
+	struct completion comp;
+	u16 dport;
+	u32 mss;
+	u32 start;
+	u32 seq;
+	u32 total;
+	bool ok;
+};
+
+/*
+ * every segment must carry the next mss of the pattern, in order. GRO may
+ * hand several of them over merged, then gso_size tells the segment size.
+ */
+static int stmmac_test_tso_validate(struct sk_buff *skb,
+				    struct net_device *ndev,
+				    struct packet_type *pt,
+				    struct net_device *orig_ndev)
+{
+	struct stmmac_tso_priv *tpriv = pt->af_packet_priv;
+	struct tcphdr *thdr;
+	struct iphdr *ihdr;
+	u32 len, off, i;
+	u8 *data;
+
+	if (completion_done(&tpriv->comp))
+		goto out;
+
+	skb = skb_unshare(skb, GFP_ATOMIC);
+	if (!skb)
+		goto out;
+
+	if (skb_linearize(skb))
+		goto out;
+	if (skb_headlen(skb) < sizeof(*ihdr) + sizeof(*thdr))
+		goto out;
+
+	ihdr = ip_hdr(skb);
+	if (ihdr->protocol != IPPROTO_TCP)
+		goto out;
+
+	thdr = (struct tcphdr *)((u8 *)ihdr + 4 * ihdr->ihl);
+	if (thdr->dest != htons(tpriv->dport))
+		goto out;
+
+	len = ntohs(ihdr->tot_len) - 4 * ihdr->ihl - 4 * thdr->doff;
+	off = ntohl(thdr->seq) - tpriv->start;
+	data = (u8 *)thdr + 4 * thdr->doff;
+
+	if (ip_fast_csum((u8 *)ihdr, ihdr->ihl) ||
+	    ntohl(thdr->seq) != tpriv->seq || !len ||
+	    data + len > skb_tail_pointer(skb))
+		goto fail;
+	if (skb_is_gso(skb) ? skb_shinfo(skb)->gso_size != tpriv->mss :
+	    len > tpriv->mss)
+		goto fail;
+
+	for (i = 0; i < len; i++)
+		if (data[i] != (u8)(off + i))
+			goto fail;
+
+	tpriv->seq += len;
+	if (tpriv->seq - tpriv->start == tpriv->total) {
+		tpriv->ok = true;
+		complete(&tpriv->comp);
+	} else if (len % tpriv->mss) {
+		goto fail;
+	}
+	goto out;
+
+fail:
+	tpriv->ok = false;
+	complete(&tpriv->comp);
+out:
+	kfree_skb(skb);
+	return 0;
+}
+
+static int __stmmac_test_tso(struct stmmac_priv *priv, u32 mss, u32 payload)
+{
+	struct stmmac_packet_attrs attr = { };
+	struct stmmac_tso_priv *tpriv;
+	struct sk_buff *skb;
+	struct tcphdr *thdr;
+	struct iphdr *ihdr;
+	u8 *data;
+	u32 i;
+	int ret;
+
+	tpriv = kzalloc(sizeof(*tpriv), GFP_KERNEL);
+	if (!tpriv)
+		return -ENOMEM;
+
+	init_completion(&tpriv->comp);
+	tpriv->dport = 9;
+	tpriv->mss = mss;
+	tpriv->total = payload;
+	tpriv->start = 0x10000 * mss;
+	tpriv->seq = tpriv->start;
+
+	tpriv->pt.type = htons(ETH_P_IP);
+	tpriv->pt.func = stmmac_test_tso_validate;
+	tpriv->pt.dev = priv->dev;
+	tpriv->pt.af_packet_priv = tpriv;
+	dev_add_pack(&tpriv->pt);
+
+	attr.dst = priv->dev->dev_addr;
+	attr.tcp = 1;
+	attr.sport = 9;
+	attr.dport = tpriv->dport;
+	attr.size = payload - sizeof(struct stmmachdr);
+
+	skb = stmmac_test_get_udp_skb(priv, &attr);
+	if (!skb) {
+		ret = -ENOMEM;
+		goto cleanup;
+	}
+
+	/* pseudo header without length, the MAC fills it per segment */
+	ihdr = ip_hdr(skb);
+	thdr = tcp_hdr(skb);
+	thdr->seq = htonl(tpriv->start);
+	thdr->ack = 1;
+	thdr->check = ~tcp_v4_check(0, ihdr->saddr, ihdr->daddr, 0);
+
+	data = (u8 *)thdr + sizeof(*thdr);
+	for (i = 0; i < payload; i++)
+		data[i] = (u8)i;
+
+	skb_shinfo(skb)->gso_size = mss;
+	skb_shinfo(skb)->gso_type = SKB_GSO_TCPV4;
+	skb_shinfo(skb)->gso_segs = DIV_ROUND_UP(payload, mss);
+
+	ret = dev_direct_xmit(skb, 0);
+	if (ret)
+		goto cleanup;
+
+	if (!wait_for_completion_timeout(&tpriv->comp, STMMAC_LB_TIMEOUT))
+		ret = -ETIMEDOUT;
+	else if (!tpriv->ok)
+		ret = -EINVAL;
+
+cleanup:
+	dev_remove_pack(&tpriv->pt);
+	kfree(tpriv);
+	return ret;
+}
+
+static int stmmac_test_tso(struct stmmac_priv *priv)
+{
+	/* small, odd and full size mss, the last case spans more than one
+	 * TSO_MAX_BUFF_SIZE descriptor
+	 */
+	static const u32 mss[] = { 536, 1000, 1448, 1448 };
+	static const u32 segs[] = { 4, 5, 3, 12 };
+	int ret = 0;
+	int i;
+
+	if (!priv->tso)
+		return -EOPNOTSUPP;
+
+	for (i = 0; i < ARRAY_SIZE(mss); i++) {
+		/* short last segment */
+		ret = __stmmac_test_tso(priv, mss[i],
+					segs[i] * mss[i] + mss[i] / 2);
+		if (ret)
+			break;
+	}
+
+	if (ret == -EINVAL || ret == -ETIMEDOUT)
+		stmmac_tso_fallback(priv);
+
+	return ret;
+}
+
 #define STMMAC_LOOPBACK_NONE	0
 #define STMMAC_LOOPBACK_MAC	1
 #define STMMAC_LOOPBACK_PHY	2
@@ -1948,6 +2124,10 @@ static const struct stmmac_test {
 		.name = "TBS (ETF Scheduler)        ",
 		.lb = STMMAC_LOOPBACK_PHY,
 		.fn = stmmac_test_tbs,
+	}, {
+		.name = "TSO                        ",
+		.lb = STMMAC_LOOPBACK_PHY,
+		.fn = stmmac_test_tso,
 	},
 };
 
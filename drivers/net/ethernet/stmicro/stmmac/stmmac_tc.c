@@ -64,10 +64,11 @@ static int tc_fill_actions(struct stmmac_tc_entry *entry,
 	int i;
 
 	exts = cls->knode.exts;
-	if (!tcf_exts_has_actions(exts))
-		return -EINVAL;
 	if (frag)
 		action_entry = frag;
+	/* A bare classid is a valid steering rule */
+	if (!tcf_exts_has_actions(exts))
+		return action_entry->val.af ? 0 : -EINVAL;
 
 	tcf_exts_for_each_action(i, act, exts) {
 		/* Accept */
@@ -77,6 +78,8 @@ static int tc_fill_actions(struct stmmac_tc_entry *entry,
 		}
 		/* Drop */
 		if (is_tcf_gact_shot(act)) {
+			if (action_entry->val.dma_ch_no)
+				return -EINVAL;
 			action_entry->val.rf = 1;
 			break;
 		}
@@ -88,6 +91,27 @@ static int tc_fill_actions(struct stmmac_tc_entry *entry,
 	return 0;
 }
 
+/* "classid ffff:ffe0 + N", as flower hw_tc N, steers to RX queue N */
+static int tc_fill_queue(struct stmmac_priv *priv,
+			 struct stmmac_tc_entry *entry,
+			 struct tc_cls_u32_offload *cls)
+{
+	u32 classid = cls->knode.res->classid;
+	u32 queue;
+
+	if (TC_H_MIN(classid) < TC_H_MIN_PRIORITY)
+		return 0;
+
+	queue = TC_H_MIN(classid) - TC_H_MIN_PRIORITY;
+	if (queue >= priv->plat->rx_queues_to_use)
+		return -EINVAL;
+
+	/* The parser takes a bitmap of DMA channels */
+	entry->val.af = 1;
+	entry->val.dma_ch_no = BIT(priv->plat->rx_queues_cfg[queue].chan);
+	return 0;
+}
+
 static int tc_fill_entry(struct stmmac_priv *priv,
 			 struct tc_cls_u32_offload *cls)
 {
@@ -155,6 +179,10 @@ static int tc_fill_entry(struct stmmac_priv *priv,
 		entry->prio = prio;
 	}
 
+	ret = tc_fill_queue(priv, frag ? frag : entry, cls);
+	if (ret)
+		goto err_unuse;
+
 	ret = tc_fill_actions(entry, frag, cls);
 	if (ret)
 		goto err_unuse;
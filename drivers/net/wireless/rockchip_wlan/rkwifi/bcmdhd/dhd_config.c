@@ -3929,6 +3929,21 @@ dhd_conf_read_sdio_params(dhd_pub_t *dhd, char *full_param, uint len_param)
 		conf->deferred_tx_len = (int)simple_strtol(data, NULL, 10);
 		CONFIG_MSG("deferred_tx_len = %d\n", conf->deferred_tx_len);
 	}
+	else if (!strncmp("vi_lowlat=", full_param, len_param)) {
+		if (!strncmp(data, "0", 1))
+			conf->vi_lowlat = FALSE;
+		else
+			conf->vi_lowlat = TRUE;
+		CONFIG_MSG("vi_lowlat = %d\n", conf->vi_lowlat);
+	}
+	else if (!strncmp("vi_kbps=", full_param, len_param)) {
+		conf->vi_kbps = (uint)simple_strtol(data, NULL, 10);
+		CONFIG_MSG("vi_kbps = %d\n", conf->vi_kbps);
+	}
+	else if (!strncmp("vi_ampdu_us=", full_param, len_param)) {
+		conf->vi_ampdu_us = (uint)simple_strtol(data, NULL, 10);
+		CONFIG_MSG("vi_ampdu_us = %d\n", conf->vi_ampdu_us);
+	}
 	else if (!strncmp("txctl_tmo_fix=", full_param, len_param)) {
 		conf->txctl_tmo_fix = (int)simple_strtol(data, NULL, 0);
 		CONFIG_MSG("txctl_tmo_fix = %d\n", conf->txctl_tmo_fix);
@@ -4770,6 +4785,20 @@ dhd_conf_postinit_ioctls(dhd_pub_t *dhd)
 		char ampdu_mpdu[] = "ampdu_mpdu=16";
 		dhd_conf_set_wl_cmd(dhd, ampdu_mpdu, TRUE);
 	}
+	if (conf->vi_lowlat && conf->vi_kbps) {
+		int mpdu_max = (conf->chip == BCM43751_CHIP_ID ||
+			conf->chip == BCM43752_CHIP_ID) ? 32 : 16;
+		int mpdu;
+		/* smaller aggregates for a low bitrate stream, so the first
+		 * frame of a burst does not wait for the rest to be encoded
+		 */
+		mpdu = (int)((conf->vi_kbps / 8) * (conf->vi_ampdu_us / 100) / 10);
+		mpdu = (mpdu + ETHER_MAX_DATA - 1) / ETHER_MAX_DATA;
+		mpdu = MIN(MAX(mpdu, 2), mpdu_max);
+		CONFIG_MSG("vi_kbps %d vi_ampdu_us %d, ampdu_mpdu %d\n",
+			conf->vi_kbps, conf->vi_ampdu_us, mpdu);
+		dhd_conf_set_intiovar(dhd, 0, WLC_SET_VAR, "ampdu_mpdu", mpdu, 0, FALSE);
+	}
 #endif
 
 #ifdef DHD_TPUT_PATCH
@@ -4928,6 +4957,9 @@ dhd_conf_preinit(dhd_pub_t *dhd)
 	conf->txctl_tmo_fix = 300;
 	conf->txglom_mode = SDPCM_TXGLOM_CPY;
 	conf->deferred_tx_len = 0;
+	conf->vi_lowlat = FALSE;
+	conf->vi_kbps = 0;
+	conf->vi_ampdu_us = 2000;
 	conf->dhd_txminmax = 1;
 	conf->txinrx_thres = -1;
 #ifdef MINIME
@@ -260,6 +260,14 @@ typedef struct dhd_conf {
 	int txctl_tmo_fix;
 	bool txglom_mode;
 	uint deferred_tx_len;
+	/* low latency video:
+	 * vi_lowlat: AC_VI/AC_VO frames skip deferred_tx_len batching
+	 * vi_kbps/vi_ampdu_us: ampdu_mpdu is sized so the encoder bitrate
+	 * fills one aggregate in about vi_ampdu_us
+	 */
+	bool vi_lowlat;
+	uint vi_kbps;
+	uint vi_ampdu_us;
 	/*txglom_bucket_size:
 	 * 43362/4330: 1680
 	 * 43340/43341/43241: 1684
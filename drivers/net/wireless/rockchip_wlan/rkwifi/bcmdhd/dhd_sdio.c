@@ -480,6 +480,14 @@ typedef struct dhd_bus {
 #endif /* defined (BT_OVER_SDIO) */
 	uint		txglomframes;	/* Number of tx glom frames (superframes) */
 	uint		txglompkts;		/* Number of packets from tx glom frames */
+	/* per AC tx counters: packets sent, deepest bus queue seen and
+	 * SDIO bus time spent on the AC, shared by bytes within a glom
+	 */
+	uint32		ac_txpkts[AC_COUNT];
+	uint64		ac_txbytes[AC_COUNT];
+	uint32		ac_qmax[AC_COUNT];
+	uint64		ac_bus_us[AC_COUNT];
+	uint32		ac_lowlat_kick;	/* DPC kicked early for low latency VI/VO */
 #ifdef PKT_STATICS
 	struct pkt_statics tx_statics;
 #endif
@@ -527,6 +535,12 @@ static int qcount[NUMPRIO];
 static int tx_packets[NUMPRIO];
 #endif /* DHD_DEBUG */
 
+static const uint8 dhdsdio_prio2ac[NUMPRIO] = {
+	AC_BE, AC_BK, AC_BK, AC_BE, AC_VI, AC_VI, AC_VO, AC_VO
+};
+static const char *dhdsdio_ac_name[AC_COUNT] = { "BE", "BK", "VI", "VO" };
+#define DHDSDIO_PKT2AC(pkt)	dhdsdio_prio2ac[PKTPRIO(pkt) & PRIOMASK]
+
 /* Deferred transmit */
 const uint dhd_deferred_tx = 1;
 
@@ -2288,7 +2302,7 @@ dhd_bus_txdata(struct dhd_bus *bus, void *pkt)
 {
 	int ret = BCME_ERROR;
 	osl_t *osh;
-	uint datalen, prec;
+	uint datalen, prec, ac;
 
 	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
 
@@ -2312,6 +2326,7 @@ dhd_bus_txdata(struct dhd_bus *bus, void *pkt)
 #endif /* SDTEST */
 
 	prec = PRIO2PREC((PKTPRIO(pkt) & PRIOMASK));
+	ac = DHDSDIO_PKT2AC(pkt);
 
 	/* move from dhdsdio_sendfromq(), try to orphan skb early */
 	if (bus->dhd->conf->orphan_move == 1)
@@ -2379,11 +2394,24 @@ dhd_bus_txdata(struct dhd_bus *bus, void *pkt)
 			qcount[prec] = pktqprec_n_pkts(&bus->txq, prec);
 		dhd_os_sdunlock_txq(bus->dhd);
 #endif
+		if (deq_ret) {
+			dhd_os_sdlock_txq(bus->dhd);
+			pkq_len = dhdsdio_ac_qlen(bus, ac);
+			if ((uint32)pkq_len > bus->ac_qmax[ac])
+				bus->ac_qmax[ac] = pkq_len;
+			dhd_os_sdunlock_txq(bus->dhd);
+		}
 
 		/* Schedule DPC if needed to send queued packet(s) */
 		/* XXX Also here, since other deferral conditions may no longer hold? */
 		if (dhd_deferred_tx && !bus->dpc_sched) {
-			if (bus->dhd->conf->deferred_tx_len) {
+			/* video and voice do not wait for deferred_tx_len to fill */
+			if (bus->dhd->conf->vi_lowlat && ac >= AC_VI &&
+					bus->dhd->conf->deferred_tx_len) {
+				bus->ac_lowlat_kick++;
+				bus->dpc_sched = TRUE;
+				dhd_sched_dpc(bus->dhd);
+			} else if (bus->dhd->conf->deferred_tx_len) {
 				if(dhd_os_wd_timer_enabled(bus->dhd) == FALSE) {
 					bus->dpc_sched = TRUE;
 					dhd_sched_dpc(bus->dhd);
@@ -2891,6 +2919,37 @@ static int dhdsdio_txpkt(dhd_bus_t *bus, uint chan, void** pkts, int num_pkt, bo
 	return ret;
 }
 
+/* packets queued on the bus for one AC, txq lock held */
+static uint
+dhdsdio_ac_qlen(dhd_bus_t *bus, uint ac)
+{
+	uint prio, qlen = 0;
+
+	for (prio = 0; prio < NUMPRIO; prio++) {
+		if (dhdsdio_prio2ac[prio] == ac)
+			qlen += pktqprec_n_pkts(&bus->txq, PRIO2PREC(prio));
+	}
+	return qlen;
+}
+
+/* share the bus time of one glom between the ACs it carried */
+static void
+dhdsdio_ac_account(dhd_bus_t *bus, uint *ac_num, uint *ac_len, uint datalen,
+	uint32 bus_us)
+{
+	uint ac;
+
+	if (!datalen)
+		return;
+	for (ac = 0; ac < AC_COUNT; ac++) {
+		if (!ac_len[ac])
+			continue;
+		bus->ac_txpkts[ac] += ac_num[ac];
+		bus->ac_txbytes[ac] += ac_len[ac];
+		bus->ac_bus_us[ac] += DIV_U64_BY_U32((uint64)bus_us * ac_len[ac], datalen);
+	}
+}
+
 static uint
 dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 {
@@ -2929,6 +2988,9 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 		void *pkts[MAX_TX_PKTCHAIN_CNT];
 		int prec_out;
 		uint datalen = 0;
+		uint ac_num[AC_COUNT] = { 0 };
+		uint ac_len[AC_COUNT] = { 0 };
+		uint64 tx_start;
 
 		dhd_os_sdlock_txq(bus->dhd);
 		if (bus->txglom_enable) {
@@ -2981,15 +3043,20 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 #endif /* DHD_LOSSLESS_ROAMING || DHD_8021X_DUMP */
 			if (!bus->dhd->conf->orphan_move)
 				PKTORPHAN(pkts[i], bus->dhd->conf->tsq);
+			ac_num[DHDSDIO_PKT2AC(pkts[i])]++;
+			ac_len[DHDSDIO_PKT2AC(pkts[i])] += PKTLEN(osh, pkts[i]);
 			datalen += PKTLEN(osh, pkts[i]);
 		}
 		dhd_os_sdunlock_txq(bus->dhd);
 
 		if (i == 0)
 			break;
+		tx_start = OSL_SYSUPTIME_US();
 		if (dhdsdio_txpkt(bus, SDPCM_DATA_CHANNEL, pkts, i, TRUE) != BCME_OK)
 			dhd->tx_errors++;
 		else {
+			dhdsdio_ac_account(bus, ac_num, ac_len, datalen,
+				(uint32)(OSL_SYSUPTIME_US() - tx_start));
 			dhd->dstats.tx_bytes += datalen;
 			bus->txglomframes++;
 			bus->txglompkts += num_pkt;
@@ -3472,6 +3539,7 @@ enum {
 	IOV_FWPATH,
 #endif
 	IOV_TXGLOMSIZE,
+	IOV_VI_LOWLAT,
 	IOV_TXGLOMMODE,
 	IOV_HANGREPORT,
 	IOV_TXINRX_THRES,
@@ -3553,6 +3621,7 @@ const bcm_iovar_t dhdsdio_iovars[] = {
 	{"fwpath", IOV_FWPATH, 0, 0, IOVT_BUFFER, 0 },
 #endif
 	{"txglomsize", IOV_TXGLOMSIZE, 0, 0, IOVT_UINT32, 0 },
+	{"vi_lowlat", IOV_VI_LOWLAT, 0, 0, IOVT_BOOL, 0 },
 	{"fw_hang_report", IOV_HANGREPORT, 0, 0, IOVT_BOOL, 0 },
 	{"txinrx_thres", IOV_TXINRX_THRES, 0, 0, IOVT_INT32, 0 },
 	{"sdio_suspend", IOV_SDIO_SUSPEND, 0, 0, IOVT_UINT32, 0 },
@@ -3709,6 +3778,20 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 	dhd_dump_pct(strbuf, ", pkts/glom", bus->txglompkts, bus->txglomframes);
 	bcm_bprintf(strbuf, "\n");
 	bcm_bprintf(strbuf, "txglomframes %u, txglompkts %u\n", bus->txglomframes, bus->txglompkts);
+	bcm_bprintf(strbuf, "vi_lowlat %d, deferred_tx_len %d, lowlat kicks %u\n",
+		bus->dhd->conf->vi_lowlat, bus->dhd->conf->deferred_tx_len,
+		bus->ac_lowlat_kick);
+	bcm_bprintf(strbuf, "AC   txpkts      txbytes   qlen   qmax       bus_us\n");
+	for (i = 0; i < AC_COUNT; i++) {
+		uint qlen;
+
+		dhd_os_sdlock_txq(bus->dhd);
+		qlen = dhdsdio_ac_qlen(bus, i);
+		dhd_os_sdunlock_txq(bus->dhd);
+		bcm_bprintf(strbuf, "%s  %8u %12llu %6u %6u %12llu\n",
+			dhdsdio_ac_name[i], bus->ac_txpkts[i], bus->ac_txbytes[i],
+			qlen, bus->ac_qmax[i], bus->ac_bus_us[i]);
+	}
 	bcm_bprintf(strbuf, "\n");
 }
 
@@ -3730,6 +3813,11 @@ dhd_bus_clearcounts(dhd_pub_t *dhdp)
 	bus->tx_deferred = bus->flowcontrol = 0;
 #endif
 	bus->txglomframes = bus->txglompkts = 0;
+	bzero(bus->ac_txpkts, sizeof(bus->ac_txpkts));
+	bzero(bus->ac_txbytes, sizeof(bus->ac_txbytes));
+	bzero(bus->ac_qmax, sizeof(bus->ac_qmax));
+	bzero(bus->ac_bus_us, sizeof(bus->ac_bus_us));
+	bus->ac_lowlat_kick = 0;
 }
 
 #ifdef SDTEST
@@ -5226,6 +5314,15 @@ dhdsdio_doiovar(dhd_bus_t *bus, const bcm_iovar_t *vi, uint32 actionid, const ch
 			bus->txglomsize = (uint)int_val;
 		}
 		break;
+
+	case IOV_GVAL(IOV_VI_LOWLAT):
+		int_val = (int32)bus->dhd->conf->vi_lowlat;
+		bcopy(&int_val, arg, val_size);
+		break;
+
+	case IOV_SVAL(IOV_VI_LOWLAT):
+		bus->dhd->conf->vi_lowlat = bool_val;
+		break;
 	case IOV_SVAL(IOV_HANGREPORT):
 		bus->dhd->hang_report = bool_val;
 		DHD_ERROR(("%s: Set hang_report as %d\n", __FUNCTION__, bus->dhd->hang_report));
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (C) Rockchip Electronics Co.Ltd
+ */
+
+#ifndef __LINUX_RKNPU_DEVFREQ_H_
+#define __LINUX_RKNPU_DEVFREQ_H_
+
+#include <linux/atomic.h>
+#include <linux/fs.h>
+#include <linux/ktime.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
+#define RKNPU_DEVFREQ_GOV_NAME "rknpu_job"
+
+struct rknpu_device;
+struct rknpu_job;
+
+/*
+ * struct rknpu_devfreq_gov - state of the job driven devfreq governor
+ *
+ * The rate follows the measured hardware time of the jobs: the cycles of a
+ * job (hw time * rate it ran at) over the declared per job deadline give
+ * the rate needed, plus headroom. A submit on an idle npu boosts at once,
+ * once the npu stays idle for idle_hold_ms the rate decays one opp per
+ * devfreq poll.
+ */
+struct rknpu_devfreq_gov {
+	spinlock_t lock;
+	atomic_t active;
+	struct work_struct boost_work;
+	ktime_t last_busy;
+	/* ewma of the cycles of one job */
+	u64 job_cycles;
+	u64 job_hw_us;
+	u64 jobs;
+	u64 boosts;
+	u64 decays;
+	/* parameters, set through the debugger */
+	u32 deadline_us;
+	u32 headroom;
+	u32 idle_hold_ms;
+	unsigned long boost_freq;
+};
+
+#ifdef CONFIG_PM_DEVFREQ
+int rknpu_devfreq_gov_register(void);
+void rknpu_devfreq_gov_unregister(void);
+void rknpu_devfreq_gov_init(struct rknpu_device *rknpu_dev);
+void rknpu_devfreq_gov_remove(struct rknpu_device *rknpu_dev);
+void rknpu_devfreq_job_begin(struct rknpu_device *rknpu_dev,
+			     struct rknpu_job *job);
+void rknpu_devfreq_job_done(struct rknpu_device *rknpu_dev,
+			    struct rknpu_job *job);
+int rknpu_devfreq_gov_show(struct seq_file *m, void *data);
+ssize_t rknpu_devfreq_gov_write(struct file *file, const char __user *ubuf,
+				size_t len, loff_t *offp);
+#else
+static inline int rknpu_devfreq_gov_register(void)
+{
+	return 0;
+}
+
+static inline void rknpu_devfreq_gov_unregister(void)
+{
+}
+
+static inline void rknpu_devfreq_gov_init(struct rknpu_device *rknpu_dev)
+{
+}
+
+static inline void rknpu_devfreq_gov_remove(struct rknpu_device *rknpu_dev)
+{
+}
+
+static inline void rknpu_devfreq_job_begin(struct rknpu_device *rknpu_dev,
+					   struct rknpu_job *job)
+{
+}
+
+static inline void rknpu_devfreq_job_done(struct rknpu_device *rknpu_dev,
+					  struct rknpu_job *job)
+{
+}
+#endif
+
+#endif /* __LINUX_RKNPU_DEVFREQ_H_ */
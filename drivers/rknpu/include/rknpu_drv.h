@@ -27,6 +27,7 @@
 #include "rknpu_fence.h"
 #include "rknpu_debugger.h"
 #include "rknpu_mm.h"
+#include "rknpu_devfreq.h"
 
 #define DRIVER_NAME "rknpu"
 #define DRIVER_DESC "RKNPU driver"
@@ -130,6 +131,7 @@ struct rknpu_device {
 	struct thermal_cooling_device *devfreq_cooling;
 	struct devfreq *devfreq;
 	unsigned long ondemand_freq;
+	struct rknpu_devfreq_gov devfreq_gov;
 #ifndef FPGA_PLATFORM
 #if KERNEL_VERSION(5, 10, 0) <= LINUX_VERSION_CODE
 	struct rockchip_opp_info opp_info;
@@ -161,6 +163,8 @@ struct rknpu_device {
 	void __iomem *nbuf_base_io;
 	struct rknpu_mm *sram_mm;
 	unsigned long power_put_delay;
+	/* bytes of cache maintenance skipped on device only buffers */
+	atomic64_t mem_sync_skipped;
 };
 
 struct rknpu_session {
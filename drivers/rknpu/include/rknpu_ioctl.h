@@ -108,6 +108,14 @@ enum e_rknpu_job_mode {
 			 RKNPU_JOB_FENCE_OUT
 };
 
+/* submit priority definitions, a higher class may run between the tasks
+ * of a lower one. out of range values are clamped. */
+enum e_rknpu_priority {
+	RKNPU_PRIORITY_LOW = -1,
+	RKNPU_PRIORITY_NORMAL = 0,
+	RKNPU_PRIORITY_HIGH = 1,
+};
+
 /* action definitions */
 enum e_rknpu_action {
 	RKNPU_GET_HW_VERSION = 0,
@@ -247,13 +255,16 @@ struct rknpu_subcore_task {
  * @task_start: task start index
  * @task_number: task number
  * @task_counter: task counter
- * @priority: submit priority
+ * @priority: submit priority, one of e_rknpu_priority
  * @task_obj_addr: address of task object
  * @regcfg_obj_addr: address of register config object
  * @task_base_addr: task base address
  * @user_data: (optional) user data
  * @core_mask: core mask of rknpu
- * @fence_fd: dma fence fd
+ * @fence_fd: dma fence fd, in and out: with RKNPU_JOB_FENCE_IN the job
+ *            is held until this fence signals (e.g. the release fence of
+ *            an rga request), with RKNPU_JOB_FENCE_OUT it returns the fence
+ *            of the job
  * @subcore_task: subcore task
  *
  */
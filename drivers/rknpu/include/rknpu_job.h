@@ -7,6 +7,7 @@
 #ifndef __LINUX_RKNPU_JOB_H_
 #define __LINUX_RKNPU_JOB_H_
 
+#include <linux/cgroup_hwaccel.h>
 #include <linux/spinlock.h>
 #include <linux/dma-fence.h>
 #include <linux/irq.h>
@@ -47,6 +48,10 @@ struct rknpu_job {
 	ktime_t hw_recoder_time;
 	ktime_t commit_pc_time;
 	atomic_t submit_count[RKNPU_MAX_CORES];
+	int prio_class;
+	uint32_t preempt_count;
+	/* hwaccel cgroup of the submitter, charged with the hw time */
+	struct hwaccel_cgroup *hwcg;
 };
 
 irqreturn_t rknpu_core0_irq_handler(int irq, void *data);
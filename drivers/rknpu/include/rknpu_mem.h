@@ -7,6 +7,8 @@
 #ifndef __LINUX_RKNPU_MEM_H
 #define __LINUX_RKNPU_MEM_H
 
+#include <linux/atomic.h>
+#include <linux/dma-buf.h>
 #include <linux/mm_types.h>
 #include <linux/version.h>
 
@@ -24,6 +26,7 @@
  * @sgt: Imported sg_table.
  * @dmabuf: buffer for this attachment.
  * @owner: Is this memory internally allocated.
+ * @cpu_access: A cpu mapping of this memory was handed out by rknpu.
  */
 struct rknpu_mem_object {
 	unsigned long flags;
@@ -35,8 +38,34 @@ struct rknpu_mem_object {
 	struct dma_buf *dmabuf;
 	struct list_head head;
 	unsigned int owner;
+	bool cpu_access;
 };
 
+/*
+ * An imported buffer that rknpu never mapped for the cpu is device only:
+ * it comes from a hardware producer (isp, rga, mpp) and any cpu access to
+ * it goes through its exporter with DMA_BUF_IOCTL_SYNC, so a flush or
+ * invalidate from rknpu_mem_sync_ioctl() is pure overhead.
+ */
+static inline bool rknpu_mem_is_device_only(struct rknpu_mem_object *obj)
+{
+	if (obj->owner || obj->cpu_access || obj->kv_addr)
+		return false;
+
+	return !obj->dmabuf || !obj->dmabuf->vmapping_counter;
+}
+
+/* true if the sync of size bytes can be skipped, accounted in skipped */
+static inline bool rknpu_mem_sync_elide(struct rknpu_mem_object *obj,
+					u64 size, atomic64_t *skipped)
+{
+	if (!rknpu_mem_is_device_only(obj))
+		return false;
+
+	atomic64_add(size, skipped);
+	return true;
+}
+
 int rknpu_mem_create_ioctl(struct rknpu_device *rknpu_dev, unsigned long data,
 			   struct file *file);
 int rknpu_mem_destroy_ioctl(struct rknpu_device *rknpu_dev, unsigned long data,
@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (C) Rockchip Electronics Co.Ltd
+ */
+
+#ifndef __LINUX_RKNPU_SCHED_H_
+#define __LINUX_RKNPU_SCHED_H_
+
+#include "rknpu_job.h"
+
+struct rknpu_subcore_data;
+
+/*
+ * Priority classes of the per core todo lists. Jobs are kept sorted by
+ * class, FIFO inside a class. A running job is only preempted at a task
+ * boundary: when a chunk of its tasks is done and a job of a higher class
+ * waits, the job is put back at the head of its own class and resumes at
+ * the next task once the urgent work is done.
+ *
+ * Inside a class the jobs of different cgroups are ordered by their
+ * hwaccel weights at queue time, and jobs of a cgroup over its hwaccel
+ * quota are passed over until its next period.
+ *
+ * All helpers but job init and fini expect rknpu_dev->irq_lock to be held.
+ */
+enum rknpu_prio_class {
+	RKNPU_PRIO_CLASS_HIGH,
+	RKNPU_PRIO_CLASS_NORMAL,
+	RKNPU_PRIO_CLASS_LOW,
+};
+
+void rknpu_sched_job_init(struct rknpu_job *job);
+void rknpu_sched_job_fini(struct rknpu_job *job);
+void rknpu_sched_job_charge(struct rknpu_job *job, u64 ns);
+struct rknpu_job *rknpu_sched_next_job(struct rknpu_subcore_data *subcore_data,
+				       int core_index, u64 *throttle_ns);
+void rknpu_sched_queue(struct rknpu_subcore_data *subcore_data,
+		       struct rknpu_job *job, int core_index);
+bool rknpu_sched_should_yield(struct rknpu_subcore_data *subcore_data,
+			      struct rknpu_job *job, int core_index);
+void rknpu_sched_requeue(struct rknpu_subcore_data *subcore_data,
+			 struct rknpu_job *job, int core_index);
+
+#endif /* __LINUX_RKNPU_SCHED_H_ */
@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) Rockchip Electronics Co.Ltd
+ */
+
+#include <linux/devfreq.h>
+#include <linux/math64.h>
+#include <linux/pm_opp.h>
+#include <linux/uaccess.h>
+
+#include "../devfreq/governor.h"
+
+#include "rknpu_drv.h"
+#include "rknpu_devfreq.h"
+
+/* default parameters */
+#define RKNPU_GOV_HEADROOM 20
+#define RKNPU_GOV_IDLE_HOLD_MS 50
+
+static struct rknpu_device *rknpu_devfreq_to_dev(struct devfreq *df)
+{
+	return dev_get_drvdata(df->dev.parent);
+}
+
+/* the next opp below freq, freq itself if it is the lowest */
+static unsigned long rknpu_devfreq_lower(struct devfreq *df,
+					 unsigned long freq)
+{
+	struct dev_pm_opp *opp;
+	unsigned long lower = freq - 1;
+
+	opp = dev_pm_opp_find_freq_floor(df->dev.parent, &lower);
+	if (IS_ERR(opp))
+		return freq;
+	dev_pm_opp_put(opp);
+
+	return lower;
+}
+
+static int rknpu_devfreq_gov_func(struct devfreq *df, unsigned long *freq)
+{
+	struct rknpu_device *rknpu_dev = rknpu_devfreq_to_dev(df);
+	struct rknpu_devfreq_gov *gov = &rknpu_dev->devfreq_gov;
+	unsigned long cur = df->previous_freq;
+	unsigned long boost, target;
+	unsigned long flags;
+	u64 job_cycles;
+	s64 idle_ms;
+
+	spin_lock_irqsave(&gov->lock, flags);
+	job_cycles = gov->job_cycles;
+	idle_ms = ktime_ms_delta(ktime_get(), gov->last_busy);
+	spin_unlock_irqrestore(&gov->lock, flags);
+
+	boost = gov->boost_freq ? gov->boost_freq : DEVFREQ_MAX_FREQ;
+
+	if (atomic_read(&gov->active)) {
+		/* no deadline or no measurement yet: run flat out */
+		if (!gov->deadline_us || !job_cycles) {
+			*freq = boost;
+			return 0;
+		}
+		target = div_u64(job_cycles * USEC_PER_SEC, gov->deadline_us);
+		target += target / 100 * gov->headroom;
+		*freq = target;
+		return 0;
+	}
+
+	if (idle_ms < gov->idle_hold_ms) {
+		*freq = cur ? cur : boost;
+		return 0;
+	}
+
+	/* idle for a while, step down one opp per poll */
+	target = rknpu_devfreq_lower(df, cur);
+	if (target != cur)
+		gov->decays++;
+	*freq = target;
+
+	return 0;
+}
+
+static int rknpu_devfreq_gov_handler(struct devfreq *df, unsigned int event,
+				     void *data)
+{
+	switch (event) {
+	case DEVFREQ_GOV_START:
+		devfreq_monitor_start(df);
+		break;
+	case DEVFREQ_GOV_STOP:
+		devfreq_monitor_stop(df);
+		break;
+	case DEVFREQ_GOV_UPDATE_INTERVAL:
+		devfreq_update_interval(df, (unsigned int *)data);
+		break;
+	case DEVFREQ_GOV_SUSPEND:
+		devfreq_monitor_suspend(df);
+		break;
+	case DEVFREQ_GOV_RESUME:
+		devfreq_monitor_resume(df);
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static struct devfreq_governor rknpu_devfreq_governor = {
+	.name = RKNPU_DEVFREQ_GOV_NAME,
+	.get_target_freq = rknpu_devfreq_gov_func,
+	.event_handler = rknpu_devfreq_gov_handler,
+};
+
+static bool rknpu_devfreq_gov_active(struct rknpu_device *rknpu_dev)
+{
+	struct devfreq *df = rknpu_dev->devfreq;
+
+	return df && df->governor == &rknpu_devfreq_governor;
+}
+
+static void rknpu_devfreq_boost_work(struct work_struct *work)
+{
+	struct rknpu_devfreq_gov *gov =
+		container_of(work, struct rknpu_devfreq_gov, boost_work);
+	struct rknpu_device *rknpu_dev =
+		container_of(gov, struct rknpu_device, devfreq_gov);
+	struct devfreq *df = rknpu_dev->devfreq;
+
+	if (!rknpu_devfreq_gov_active(rknpu_dev))
+		return;
+
+	mutex_lock(&df->lock);
+	update_devfreq(df);
+	mutex_unlock(&df->lock);
+}
+
+int rknpu_devfreq_gov_register(void)
+{
+	return devfreq_add_governor(&rknpu_devfreq_governor);
+}
+
+void rknpu_devfreq_gov_unregister(void)
+{
+	devfreq_remove_governor(&rknpu_devfreq_governor);
+}
+
+void rknpu_devfreq_gov_init(struct rknpu_device *rknpu_dev)
+{
+	struct rknpu_devfreq_gov *gov = &rknpu_dev->devfreq_gov;
+
+	spin_lock_init(&gov->lock);
+	atomic_set(&gov->active, 0);
+	INIT_WORK(&gov->boost_work, rknpu_devfreq_boost_work);
+	gov->last_busy = ktime_get();
+	gov->headroom = RKNPU_GOV_HEADROOM;
+	gov->idle_hold_ms = RKNPU_GOV_IDLE_HOLD_MS;
+}
+
+void rknpu_devfreq_gov_remove(struct rknpu_device *rknpu_dev)
+{
+	cancel_work_sync(&rknpu_dev->devfreq_gov.boost_work);
+}
+
+/* called when the job is committed to the hardware */
+void rknpu_devfreq_job_begin(struct rknpu_device *rknpu_dev,
+			     struct rknpu_job *job)
+{
+	struct rknpu_devfreq_gov *gov = &rknpu_dev->devfreq_gov;
+
+	if (atomic_inc_return(&gov->active) != 1 ||
+	    !rknpu_devfreq_gov_active(rknpu_dev))
+		return;
+
+	gov->boosts++;
+	queue_work(system_highpri_wq, &gov->boost_work);
+}
+
+/* called from the job done interrupt */
+void rknpu_devfreq_job_done(struct rknpu_device *rknpu_dev,
+			    struct rknpu_job *job)
+{
+	struct rknpu_devfreq_gov *gov = &rknpu_dev->devfreq_gov;
+	ktime_t now = ktime_get();
+	unsigned long flags;
+	u64 hw_us, cycles;
+
+	if (atomic_dec_if_positive(&gov->active) < 0)
+		return;
+
+	hw_us = ktime_us_delta(now, job->hw_recoder_time);
+	cycles = div_u64(hw_us * (rknpu_dev->current_freq / 1000), 1000);
+
+	spin_lock_irqsave(&gov->lock, flags);
+	gov->last_busy = now;
+	gov->jobs++;
+	if (!gov->job_cycles) {
+		gov->job_cycles = cycles;
+		gov->job_hw_us = hw_us;
+	} else {
+		gov->job_cycles = (gov->job_cycles * 3 + cycles) >> 2;
+		gov->job_hw_us = (gov->job_hw_us * 3 + hw_us) >> 2;
+	}
+	spin_unlock_irqrestore(&gov->lock, flags);
+}
+
+static struct rknpu_device *rknpu_devfreq_node_to_dev(struct seq_file *m)
+{
+	struct rknpu_debugger_node *node = m->private;
+
+	return container_of(node->debugger, struct rknpu_device, debugger);
+}
+
+int rknpu_devfreq_gov_show(struct seq_file *m, void *data)
+{
+	struct rknpu_device *rknpu_dev = rknpu_devfreq_node_to_dev(m);
+	struct rknpu_devfreq_gov *gov = &rknpu_dev->devfreq_gov;
+	unsigned long flags;
+
+	seq_printf(m, "governor: %s\n",
+		   rknpu_devfreq_gov_active(rknpu_dev) ? "active" : "inactive");
+	seq_printf(m, "deadline_us: %u\n", gov->deadline_us);
+	seq_printf(m, "headroom: %u\n", gov->headroom);
+	seq_printf(m, "idle_hold_ms: %u\n", gov->idle_hold_ms);
+	seq_printf(m, "boost_freq: %lu\n", gov->boost_freq);
+
+	spin_lock_irqsave(&gov->lock, flags);
+	seq_printf(m, "active: %d jobs: %llu boosts: %llu decays: %llu\n",
+		   atomic_read(&gov->active), gov->jobs, gov->boosts,
+		   gov->decays);
+	seq_printf(m, "job hw time: %lluus cycles: %llu\n", gov->job_hw_us,
+		   gov->job_cycles);
+	spin_unlock_irqrestore(&gov->lock, flags);
+
+	return 0;
+}
+
+/* "<parameter> <value>", e.g. "deadline_us 33000" */
+ssize_t rknpu_devfreq_gov_write(struct file *file, const char __user *ubuf,
+				size_t len, loff_t *offp)
+{
+	struct seq_file *m = file->private_data;
+	struct rknpu_device *rknpu_dev = rknpu_devfreq_node_to_dev(m);
+	struct rknpu_devfreq_gov *gov = &rknpu_dev->devfreq_gov;
+	char buf[48], name[16];
+	unsigned long val;
+
+	if (len >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, len))
+		return -EFAULT;
+	buf[len] = '\0';
+
+	if (sscanf(buf, "%15s %lu", name, &val) != 2)
+		return -EINVAL;
+
+	if (!strcmp(name, "deadline_us"))
+		gov->deadline_us = val;
+	else if (!strcmp(name, "headroom") && val <= 100)
+		gov->headroom = val;
+	else if (!strcmp(name, "idle_hold_ms"))
+		gov->idle_hold_ms = val;
+	else if (!strcmp(name, "boost_freq"))
+		gov->boost_freq = val;
+	else
+		return -EINVAL;
+
+	return len;
+}
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) Rockchip Electronics Co.Ltd
+ */
+
+#include <linux/list.h>
+
+#include "rknpu_drv.h"
+#include "rknpu_sched.h"
+
+void rknpu_sched_job_init(struct rknpu_job *job)
+{
+	int priority = job->args->priority;
+
+	if (priority >= RKNPU_PRIORITY_HIGH)
+		job->prio_class = RKNPU_PRIO_CLASS_HIGH;
+	else if (priority <= RKNPU_PRIORITY_LOW)
+		job->prio_class = RKNPU_PRIO_CLASS_LOW;
+	else
+		job->prio_class = RKNPU_PRIO_CLASS_NORMAL;
+	job->preempt_count = 0;
+	job->hwcg = hwaccel_cgroup_get();
+}
+
+void rknpu_sched_job_fini(struct rknpu_job *job)
+{
+	hwaccel_cgroup_put(job->hwcg);
+	job->hwcg = NULL;
+}
+
+/* the hw time of the job on one core */
+void rknpu_sched_job_charge(struct rknpu_job *job, u64 ns)
+{
+	hwaccel_cgroup_charge(job->hwcg, HWACCEL_NPU, ns);
+}
+
+/*
+ * behind every job of a higher class. In its own class in front of the
+ * first new job of a cgroup that has had more npu time for its weight,
+ * preempted jobs keep their place.
+ */
+void rknpu_sched_queue(struct rknpu_subcore_data *subcore_data,
+		       struct rknpu_job *job, int core_index)
+{
+	struct rknpu_job *pos;
+
+	list_for_each_entry(pos, &subcore_data->todo_list, head[core_index]) {
+		if (pos->prio_class > job->prio_class ||
+		    (pos->prio_class == job->prio_class && !pos->preempt_count &&
+		     hwaccel_cgroup_cmp(job->hwcg, pos->hwcg, HWACCEL_NPU) < 0)) {
+			list_add_tail(&job->head[core_index],
+				      &pos->head[core_index]);
+			return;
+		}
+	}
+	list_add_tail(&job->head[core_index], &subcore_data->todo_list);
+}
+
+/* the first job of the todo list whose cgroup is not throttled */
+struct rknpu_job *rknpu_sched_next_job(struct rknpu_subcore_data *subcore_data,
+				       int core_index, u64 *throttle_ns)
+{
+	struct rknpu_job *job;
+	u64 wait_ns;
+
+	*throttle_ns = 0;
+	list_for_each_entry(job, &subcore_data->todo_list, head[core_index]) {
+		wait_ns = hwaccel_cgroup_throttled(job->hwcg, HWACCEL_NPU);
+		if (!wait_ns)
+			return job;
+		if (!*throttle_ns || wait_ns < *throttle_ns)
+			*throttle_ns = wait_ns;
+	}
+
+	return NULL;
+}
+
+/*
+ * at a task boundary of the running job: yield if a job of a higher class
+ * is waiting. the todo list is sorted, the first entry decides.
+ */
+bool rknpu_sched_should_yield(struct rknpu_subcore_data *subcore_data,
+			      struct rknpu_job *job, int core_index)
+{
+	struct rknpu_job *first;
+
+	first = list_first_entry_or_null(&subcore_data->todo_list,
+					 struct rknpu_job, head[core_index]);
+
+	return first && first != job && first->prio_class < job->prio_class;
+}
+
+/* a preempted job goes in front of its own class so it is not starved */
+void rknpu_sched_requeue(struct rknpu_subcore_data *subcore_data,
+			 struct rknpu_job *job, int core_index)
+{
+	struct rknpu_job *pos;
+
+	job->preempt_count++;
+	list_for_each_entry(pos, &subcore_data->todo_list, head[core_index]) {
+		if (pos->prio_class >= job->prio_class) {
+			list_add_tail(&job->head[core_index],
+				      &pos->head[core_index]);
+			return;
+		}
+	}
+	list_add_tail(&job->head[core_index], &subcore_data->todo_list);
+}
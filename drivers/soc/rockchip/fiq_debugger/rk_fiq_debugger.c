@@ -234,7 +234,22 @@ static DEFINE_KFIFO(fifo, unsigned char, FIFO_SIZE);
 static DEFINE_KFIFO(tty_fifo, unsigned char, TTY_FIFO_SIZE);
 static bool console_thread_stop; /* write on console_write */
 static bool console_thread_running; /* write on console_thread */
-static unsigned int console_dropped_messages;
+/* dropped since the last "messages dropped" line */
+static atomic_t console_dropped_messages = ATOMIC_INIT(0);
+
+/* totals, printk callers never wait for the uart so losses show here */
+static unsigned int console_dropped;
+static unsigned int console_dropped_bytes;
+static unsigned int tty_dropped_bytes;
+static unsigned int console_fifo_peak;
+module_param(console_dropped, uint, 0444);
+MODULE_PARM_DESC(console_dropped, "console messages dropped on a full fifo");
+module_param(console_dropped_bytes, uint, 0444);
+MODULE_PARM_DESC(console_dropped_bytes, "bytes of the dropped console messages");
+module_param(tty_dropped_bytes, uint, 0444);
+MODULE_PARM_DESC(tty_dropped_bytes, "ttyFIQ bytes not queued on a full fifo");
+module_param(console_fifo_peak, uint, 0444);
+MODULE_PARM_DESC(console_fifo_peak, "highest console fifo level in bytes");
 
 static int write_room(struct platform_device *pdev)
 {
@@ -362,10 +377,9 @@ static int console_thread(void *data)
 			fiq_tty_wake_up(pdev);
 		len_tty = 0;
 
-		dropped = console_dropped_messages;
-		if (dropped && !console_thread_stop) {
-			console_dropped_messages = 0;
-			smp_wmb();
+		dropped = console_thread_stop ? 0 :
+			  atomic_xchg(&console_dropped_messages, 0);
+		if (dropped) {
 			len = sprintf(buf, "** %u console messages dropped **\n",
 				       dropped);
 			console_put(pdev, buf, len);
@@ -402,12 +416,18 @@ static void console_write(struct platform_device *pdev, const char *s, unsigned
 	} else if (count) {
 		unsigned int ret = 0;
 
-		if (kfifo_len(&fifo) + count <= FIFO_SIZE)
+		unsigned int level = kfifo_len(&fifo) + count;
+
+		if (level <= FIFO_SIZE)
 			ret = kfifo_in(&fifo, s, count);
 		if (!ret) {
-			console_dropped_messages++;
-			smp_wmb();
+			atomic_inc(&console_dropped_messages);
+			WRITE_ONCE(console_dropped, console_dropped + 1);
+			WRITE_ONCE(console_dropped_bytes,
+				   console_dropped_bytes + count);
 		} else {
+			if (level > console_fifo_peak)
+				WRITE_ONCE(console_fifo_peak, level);
 			wake_up_console_thread(t->console_task);
 		}
 	}
@@ -426,8 +446,10 @@ static int tty_write(struct platform_device *pdev, const char *s, int count)
 		if (kfifo_len(&tty_fifo) + count <= TTY_FIFO_SIZE)
 			ret = kfifo_in(&tty_fifo, s, count);
 
-		if (ret <= 0)
+		if (ret <= 0) {
+			WRITE_ONCE(tty_dropped_bytes, tty_dropped_bytes + count);
 			return 0;
+		}
 		wake_up_console_thread(t->console_task);
 	}
 	return count;
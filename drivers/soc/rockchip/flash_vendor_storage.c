@@ -7,9 +7,11 @@
 #include <linux/miscdevice.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/reboot.h>
 #include <linux/slab.h>
 #include <linux/soc/rockchip/rk_vendor_storage.h>
 #include <linux/uaccess.h>
+#include <linux/workqueue.h>
 #include <misc/rkflash_vendor_storage.h>
 
 #include "flash_vendor_storage.h"
@@ -35,6 +37,9 @@ struct vendor_item {
 #define FLASH_VENDOR_PART_NUM		4
 #define FLASH_VENDOR_TAG		0x524B5644
 
+/* write back all cached vendor writes, no argument */
+#define VENDOR_SYNC_IO			_IOW('v', 0x03, unsigned int)
+
 struct tag_vendor_info {
 	u32	tag;
 	u32	version;
@@ -52,6 +57,24 @@ static int (*_flash_read)(u32 sec, u32 n_sec, void *p_data);
 static int (*_flash_write)(u32 sec, u32 n_sec, void *p_data);
 static struct tag_vendor_info *g_vendor;
 
+/*
+ * Vendor writes only update g_vendor and mark it dirty. The part is
+ * written back to the next slot at most write_back_ms later, on
+ * VENDOR_SYNC_IO and at reboot, so a burst of small writes costs one
+ * flash write and one version instead of one each. Every write back
+ * rewrites the whole part into the next of the rotating slots, so there
+ * is nothing to gain from tracking dirty sectors. write_back_ms 0
+ * restores write through.
+ */
+static unsigned int write_back_ms = 2000;
+module_param(write_back_ms, uint, 0644);
+MODULE_PARM_DESC(write_back_ms, "delay in ms before cached vendor writes reach flash, 0 to write through");
+
+static DEFINE_MUTEX(g_vendor_lock);
+static bool g_vendor_dirty;
+static void flash_vendor_flush_work(struct work_struct *work);
+static DECLARE_DELAYED_WORK(g_vendor_flush, flash_vendor_flush_work);
+
 int flash_vendor_dev_ops_register(int (*read)(u32 sec,
 					      u32 n_sec,
 					      void *p_data),
@@ -119,6 +142,7 @@ static int flash_vendor_read(u32 id, void *pbuf, u32 size)
 	if (!g_vendor)
 		return -1;
 
+	mutex_lock(&g_vendor_lock);
 	for (i = 0; i < g_vendor->item_num; i++) {
 		if (g_vendor->item[i].id == id) {
 			if (size > g_vendor->item[i].size)
@@ -126,27 +150,84 @@ static int flash_vendor_read(u32 id, void *pbuf, u32 size)
 			memcpy(pbuf,
 			       &g_vendor->data[g_vendor->item[i].offset],
 			       size);
+			mutex_unlock(&g_vendor_lock);
 			return size;
 		}
 	}
+	mutex_unlock(&g_vendor_lock);
 	return (-1);
 }
 
-static int flash_vendor_write(u32 id, void *pbuf, u32 size)
+/* write g_vendor to the next slot, called with g_vendor_lock held */
+static int flash_vendor_flush(void)
+{
+	u32 next_index;
+
+	if (!g_vendor_dirty)
+		return 0;
+
+	next_index = g_vendor->next_index;
+	g_vendor->version++;
+	g_vendor->version2 = g_vendor->version;
+	g_vendor->next_index++;
+	if (g_vendor->next_index >= FLASH_VENDOR_PART_NUM)
+		g_vendor->next_index = 0;
+	if (_flash_write(FLASH_VENDOR_PART_START +
+			 FLASH_VENDOR_PART_SIZE * next_index,
+			 FLASH_VENDOR_PART_SIZE,
+			 g_vendor))
+		return -1;
+
+	g_vendor_dirty = false;
+	return 0;
+}
+
+static void flash_vendor_flush_work(struct work_struct *work)
+{
+	mutex_lock(&g_vendor_lock);
+	if (flash_vendor_flush())
+		pr_err("flash vendor storage write back failed\n");
+	mutex_unlock(&g_vendor_lock);
+}
+
+/* g_vendor was changed, called with g_vendor_lock held */
+static int flash_vendor_commit(void)
+{
+	g_vendor_dirty = true;
+	if (!write_back_ms)
+		return flash_vendor_flush();
+
+	schedule_delayed_work(&g_vendor_flush,
+			      msecs_to_jiffies(write_back_ms));
+	return 0;
+}
+
+static int flash_vendor_sync(void)
+{
+	int ret;
+
+	if (!g_vendor)
+		return -1;
+
+	cancel_delayed_work_sync(&g_vendor_flush);
+	mutex_lock(&g_vendor_lock);
+	ret = flash_vendor_flush();
+	mutex_unlock(&g_vendor_lock);
+
+	return ret;
+}
+
+static int flash_vendor_write_item(u32 id, void *pbuf, u32 size)
 {
-	u32 i, j, next_index, align_size, alloc_size, item_num;
+	u32 i, j, align_size, alloc_size, item_num;
 	u32 offset, next_size;
 	u8 *p_data;
 	struct vendor_item *item;
 	struct vendor_item *next_item;
 
-	if (!g_vendor)
-		return -1;
-
 	p_data = g_vendor->data;
 	item_num = g_vendor->item_num;
 	align_size = ALIGN(size, 0x40); /* align to 64 bytes*/
-	next_index = g_vendor->next_index;
 	for (i = 0; i < item_num; i++) {
 		item = &g_vendor->item[i];
 		if (item->id == id) {
@@ -182,16 +263,7 @@ static int flash_vendor_write(u32 id, void *pbuf, u32 size)
 				       size);
 				g_vendor->item[i].size = size;
 			}
-			g_vendor->version++;
-			g_vendor->version2 = g_vendor->version;
-			g_vendor->next_index++;
-			if (g_vendor->next_index >= FLASH_VENDOR_PART_NUM)
-				g_vendor->next_index = 0;
-			_flash_write(FLASH_VENDOR_PART_START +
-					FLASH_VENDOR_PART_SIZE * next_index,
-					FLASH_VENDOR_PART_SIZE,
-					g_vendor);
-			return 0;
+			return flash_vendor_commit();
 		}
 	}
 
@@ -205,21 +277,26 @@ static int flash_vendor_write(u32 id, void *pbuf, u32 size)
 		g_vendor->free_size -= align_size;
 		memcpy(&g_vendor->data[item->offset], pbuf, size);
 		g_vendor->item_num++;
-		g_vendor->version++;
-		g_vendor->next_index++;
-		g_vendor->version2 = g_vendor->version;
-		if (g_vendor->next_index >= FLASH_VENDOR_PART_NUM)
-			g_vendor->next_index = 0;
-		_flash_write(FLASH_VENDOR_PART_START +
-				FLASH_VENDOR_PART_SIZE * next_index,
-				FLASH_VENDOR_PART_SIZE,
-			g_vendor);
-		return 0;
+		return flash_vendor_commit();
 	}
 
 	return(-1);
 }
 
+static int flash_vendor_write(u32 id, void *pbuf, u32 size)
+{
+	int ret;
+
+	if (!g_vendor)
+		return -1;
+
+	mutex_lock(&g_vendor_lock);
+	ret = flash_vendor_write_item(id, pbuf, size);
+	mutex_unlock(&g_vendor_lock);
+
+	return ret;
+}
+
 #if (FLASH_VENDOR_TEST)
 static void print_hex(char *s, void *buf, int width, int len)
 {
@@ -308,6 +385,9 @@ static long vendor_storage_ioctl(struct file *file,
 						 req->data,
 						 req->len);
 	} break;
+	case VENDOR_SYNC_IO:
+		ret = flash_vendor_sync();
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -327,6 +407,17 @@ static struct miscdevice vender_storage_dev = {
 	.fops  = &vendor_storage_fops,
 };
 
+static int vendor_reboot_notify(struct notifier_block *nb,
+				unsigned long action, void *data)
+{
+	flash_vendor_sync();
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block vendor_reboot_nb = {
+	.notifier_call = vendor_reboot_notify,
+};
+
 static int vendor_init_thread(void *arg)
 {
 	int ret;
@@ -335,6 +426,7 @@ static int vendor_init_thread(void *arg)
 	ret = flash_vendor_init();
 	if (!ret) {
 		ret = misc_register(&vender_storage_dev);
+		register_reboot_notifier(&vendor_reboot_nb);
 		#ifdef CONFIG_ROCKCHIP_VENDOR_STORAGE
 		rk_vendor_register(flash_vendor_read, flash_vendor_write);
 		#endif
@@ -353,6 +445,8 @@ static __exit void vendor_storage_deinit(void)
 {
 	if (g_vendor) {
 		misc_deregister(&vender_storage_dev);
+		unregister_reboot_notifier(&vendor_reboot_nb);
+		flash_vendor_sync();
 		kfree(g_vendor);
 		g_vendor = NULL;
 	}
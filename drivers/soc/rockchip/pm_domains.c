@@ -106,6 +106,14 @@ struct rockchip_pm_domain {
 	bool is_ignore_pwr;
 	bool is_qos_saved;
 	bool is_qos_need_init;
+	/* memory keeps its content while the domain is off */
+	bool mem_retention;
+	/* genpd state, the hardware may be on ahead of it when pre-warmed */
+	bool genpd_on;
+	bool is_prewarmed;
+	/* last measured power on time */
+	u32 power_on_us;
+	struct delayed_work prewarm_work;
 	struct regulator *supply;
 };
 
@@ -125,6 +133,11 @@ module_param_named(always_on, pm_domain_always_on, bool, 0644);
 MODULE_PARM_DESC(always_on,
 		 "Always keep pm domains power on except for system suspend.");
 
+static unsigned int pd_prewarm_hold_ms = 50;
+module_param_named(prewarm_hold_ms, pd_prewarm_hold_ms, uint, 0644);
+MODULE_PARM_DESC(prewarm_hold_ms,
+		 "Time a pre-warmed domain stays on waiting for its device.");
+
 #ifdef MODULE
 static bool keepon_startup = true;
 static void rockchip_pd_keepon_do_release(void);
@@ -715,7 +728,8 @@ static int rockchip_do_pmu_set_power_domain(struct rockchip_pm_domain *pd,
 
 	dsb(sy);
 
-	if (is_mem_on) {
+	/* retained memory is still valid, only a lost one needs the reset */
+	if (is_mem_on && !pd->mem_retention) {
 		ret = rockchip_pmu_domain_mem_reset(pd);
 		if (ret)
 			goto error;
@@ -736,11 +750,13 @@ static int rockchip_do_pmu_set_power_domain(struct rockchip_pm_domain *pd,
 	return ret;
 }
 
-static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
+/* must be called with the pmu lock held */
+static int rockchip_pd_power_locked(struct rockchip_pm_domain *pd, bool power_on)
 {
 	struct rockchip_pmu *pmu = pd->pmu;
 	int ret = 0;
 	struct generic_pm_domain *genpd = &pd->genpd;
+	ktime_t start = ktime_get();
 
 	if (pm_domain_always_on && !power_on)
 		return 0;
@@ -750,8 +766,6 @@ static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 			return 0;
 	}
 
-	rockchip_pmu_lock(pd);
-
 	if (rockchip_pmu_domain_is_on(pd) != power_on) {
 		if (IS_ERR_OR_NULL(pd->supply) &&
 		    PTR_ERR(pd->supply) != -ENODEV)
@@ -763,7 +777,6 @@ static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 			if (ret < 0) {
 				dev_err(pd->pmu->dev, "failed to set vdd supply enable '%s',\n",
 					genpd->name);
-				rockchip_pmu_unlock(pd);
 				return ret;
 			}
 		}
@@ -771,7 +784,6 @@ static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 		ret = clk_bulk_enable(pd->num_clks, pd->clks);
 		if (ret < 0) {
 			dev_err(pmu->dev, "failed to enable clocks\n");
-			rockchip_pmu_unlock(pd);
 			return ret;
 		}
 		rockchip_pmu_ungate_clk(pd, true);
@@ -819,9 +831,36 @@ static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 
 		if (!power_on && !IS_ERR(pd->supply))
 			ret = regulator_disable(pd->supply);
+		else if (power_on && !ret)
+			pd->power_on_us = ktime_us_delta(ktime_get(), start);
 	}
 
+	return ret;
+}
+
+static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
+{
+	int ret;
+
+	rockchip_pmu_lock(pd);
+	ret = rockchip_pd_power_locked(pd, power_on);
 	rockchip_pmu_unlock(pd);
+
+	return ret;
+}
+
+static int rockchip_pd_genpd_power(struct rockchip_pm_domain *pd, bool power_on)
+{
+	int ret;
+
+	rockchip_pmu_lock(pd);
+	ret = rockchip_pd_power_locked(pd, power_on);
+	if (!ret) {
+		pd->genpd_on = power_on;
+		pd->is_prewarmed = false;
+	}
+	rockchip_pmu_unlock(pd);
+
 	return ret;
 }
 
@@ -832,7 +871,7 @@ static int rockchip_pd_power_on(struct generic_pm_domain *domain)
 	if (pd->is_ignore_pwr)
 		return 0;
 
-	return rockchip_pd_power(pd, true);
+	return rockchip_pd_genpd_power(pd, true);
 }
 
 static int rockchip_pd_power_off(struct generic_pm_domain *domain)
@@ -842,9 +881,71 @@ static int rockchip_pd_power_off(struct generic_pm_domain *domain)
 	if (pd->is_ignore_pwr)
 		return 0;
 
-	return rockchip_pd_power(pd, false);
+	return rockchip_pd_genpd_power(pd, false);
+}
+
+/*
+ * First run powers the domain up ahead of the predicted frame, so the
+ * power on, qos restore and clock enable are paid before the device asks
+ * for it. If the device does not take the domain within the hold time the
+ * second run powers it off again.
+ */
+static void rockchip_pd_prewarm_work(struct work_struct *work)
+{
+	struct rockchip_pm_domain *pd =
+		container_of(to_delayed_work(work), struct rockchip_pm_domain,
+			     prewarm_work);
+
+	rockchip_pmu_lock(pd);
+	if (pd->genpd_on) {
+		pd->is_prewarmed = false;
+	} else if (!pd->is_prewarmed) {
+		if (!rockchip_pd_power_locked(pd, true)) {
+			pd->is_prewarmed = true;
+			mod_delayed_work(system_highpri_wq, &pd->prewarm_work,
+					 msecs_to_jiffies(pd_prewarm_hold_ms));
+		}
+	} else {
+		rockchip_pd_power_locked(pd, false);
+		pd->is_prewarmed = false;
+	}
+	rockchip_pmu_unlock(pd);
 }
 
+/**
+ * rockchip_pmu_pd_prewarm - power up the domain of @dev just before @expires
+ * @dev: device whose runtime resume is expected at @expires
+ * @expires: predicted time of the next frame, CLOCK_MONOTONIC
+ *
+ * Used by low frame rate capture, the domain comes up early by its last
+ * measured power on time, one jiffy of timer slack included.
+ */
+int rockchip_pmu_pd_prewarm(struct device *dev, ktime_t expires)
+{
+	struct generic_pm_domain *genpd;
+	struct rockchip_pm_domain *pd;
+	s64 delay_us;
+
+	if (IS_ERR_OR_NULL(dev))
+		return -EINVAL;
+
+	if (IS_ERR_OR_NULL(dev->pm_domain))
+		return -EINVAL;
+
+	genpd = pd_to_genpd(dev->pm_domain);
+	pd = to_rockchip_pd(genpd);
+	if (pd->is_ignore_pwr)
+		return 0;
+
+	delay_us = ktime_us_delta(expires, ktime_get()) -
+		   READ_ONCE(pd->power_on_us) - jiffies_to_usecs(1);
+	mod_delayed_work(system_highpri_wq, &pd->prewarm_work,
+			 delay_us > 0 ? usecs_to_jiffies(delay_us) : 0);
+
+	return 0;
+}
+EXPORT_SYMBOL(rockchip_pmu_pd_prewarm);
+
 int rockchip_pmu_pd_on(struct device *dev)
 {
 	struct generic_pm_domain *genpd;
@@ -1026,6 +1127,8 @@ static int rockchip_pm_add_one_domain(struct rockchip_pmu *pmu,
 	pd->pmu = pmu;
 	if (!pd_info->pwr_mask)
 		pd->is_ignore_pwr = true;
+	pd->mem_retention = of_property_read_bool(node, "rockchip,mem-retention");
+	INIT_DELAYED_WORK(&pd->prewarm_work, rockchip_pd_prewarm_work);
 
 	pd->num_clks = of_clk_get_parent_count(node);
 	if (pd->num_clks > 0) {
@@ -1177,7 +1280,8 @@ static int rockchip_pm_add_one_domain(struct rockchip_pmu *pmu,
 	}
 	rockchip_pd_qos_init(pd);
 
-	pm_genpd_init(&pd->genpd, NULL, !rockchip_pmu_domain_is_on(pd));
+	pd->genpd_on = rockchip_pmu_domain_is_on(pd);
+	pm_genpd_init(&pd->genpd, NULL, !pd->genpd_on);
 
 	pmu->genpd_data.domains[id] = &pd->genpd;
 	return 0;
@@ -1204,6 +1308,8 @@ static void rockchip_pm_remove_one_domain(struct rockchip_pm_domain *pd)
 		dev_err(pd->pmu->dev, "failed to remove domain '%s' : %d - state may be inconsistent\n",
 			pd->genpd.name, ret);
 
+	cancel_delayed_work_sync(&pd->prewarm_work);
+
 	clk_bulk_unprepare(pd->num_clks, pd->clks);
 	clk_bulk_put(pd->num_clks, pd->clks);
 
@@ -5,7 +5,9 @@
 
 #include <linux/dma-buf.h>
 #include <linux/module.h>
+#include <linux/notifier.h>
 #include <linux/platform_device.h>
+#include <linux/poll.h>
 #include <linux/proc_fs.h>
 #include <linux/scatterlist.h>
 #include <linux/seq_file.h>
@@ -143,6 +145,103 @@ static int rk_dmabuf_peak_show(struct seq_file *s, void *v)
 	return 0;
 }
 
+static int rk_dmabuf_procs_show(struct seq_file *s, void *v)
+{
+	seq_printf(s, "%-16s %7s %6s %14s %14s\n",
+		   "PROCESS", "PID", "COUNT", "SIZE", "PEAK");
+	dma_buf_show_acct(s, false);
+
+	return 0;
+}
+
+static int rk_dmabuf_exporters_show(struct seq_file *s, void *v)
+{
+	seq_printf(s, "%-16s %6s %14s %14s\n", "EXPORTER", "COUNT", "SIZE", "PEAK");
+	dma_buf_show_acct(s, true);
+
+	return 0;
+}
+
+/*
+ * the budget file takes the media memory budget in KiB, 0 for none. poll
+ * on it wakes up with EPOLLPRI each time the total rises above the budget.
+ */
+static DECLARE_WAIT_QUEUE_HEAD(rk_dmabuf_budget_wait);
+static atomic_t rk_dmabuf_budget_events = ATOMIC_INIT(0);
+
+static int rk_dmabuf_budget_notify(struct notifier_block *nb,
+				   unsigned long action, void *data)
+{
+	atomic_inc(&rk_dmabuf_budget_events);
+	wake_up_interruptible(&rk_dmabuf_budget_wait);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block rk_dmabuf_budget_nb = {
+	.notifier_call = rk_dmabuf_budget_notify,
+};
+
+static int rk_dmabuf_budget_show(struct seq_file *s, void *v)
+{
+	seq_printf(s, "Budget: %lu KiB\n", K(dma_buf_get_budget()));
+	seq_printf(s, "Total: %lu KiB\n", K(dma_buf_get_total_size()));
+	seq_printf(s, "Exceeded: %d\n", atomic_read(&rk_dmabuf_budget_events));
+
+	return 0;
+}
+
+static ssize_t rk_dmabuf_budget_write(struct file *file,
+				      const char __user *buffer,
+				      size_t count, loff_t *ppos)
+{
+	unsigned long kib;
+	int rc;
+
+	rc = kstrtoul_from_user(buffer, count, 0, &kib);
+	if (rc)
+		return rc;
+
+	dma_buf_set_budget((size_t)kib << 10);
+
+	return count;
+}
+
+static int rk_dmabuf_budget_open(struct inode *inode, struct file *file)
+{
+	int ret = single_open(file, rk_dmabuf_budget_show, NULL);
+
+	/* the events seen by this opener */
+	if (!ret)
+		((struct seq_file *)file->private_data)->private =
+			(void *)(long)atomic_read(&rk_dmabuf_budget_events);
+
+	return ret;
+}
+
+static __poll_t rk_dmabuf_budget_poll(struct file *file, poll_table *wait)
+{
+	struct seq_file *s = file->private_data;
+	int events;
+
+	poll_wait(file, &rk_dmabuf_budget_wait, wait);
+	events = atomic_read(&rk_dmabuf_budget_events);
+	if (events == (long)s->private)
+		return 0;
+	s->private = (void *)(long)events;
+
+	return EPOLLPRI;
+}
+
+static const struct proc_ops rk_dmabuf_budget_ops = {
+	.proc_open	= rk_dmabuf_budget_open,
+	.proc_read	= seq_read,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= single_release,
+	.proc_write	= rk_dmabuf_budget_write,
+	.proc_poll	= rk_dmabuf_budget_poll,
+};
+
 static ssize_t rk_dmabuf_peak_write(struct file *file,
 				    const char __user *buffer,
 				    size_t count, loff_t *ppos)
@@ -193,6 +292,10 @@ static int __init rk_dmabuf_init(void)
 	proc_create_single("dev", 0, root, rk_dmabuf_dev_show);
 	proc_create_single("size", 0, root, rk_dmabuf_size_show);
 	proc_create("peak", 0644, root, &rk_dmabuf_peak_ops);
+	proc_create_single("procs", 0, root, rk_dmabuf_procs_show);
+	proc_create_single("exporters", 0, root, rk_dmabuf_exporters_show);
+	proc_create("budget", 0644, root, &rk_dmabuf_budget_ops);
+	dma_buf_register_budget_notifier(&rk_dmabuf_budget_nb);
 
 	return 0;
 }
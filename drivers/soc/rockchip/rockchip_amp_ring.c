@@ -0,0 +1,356 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Rockchip AMP shared memory ring.
+ *
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+ */
+#include <linux/io.h>
+#include <linux/kernel.h>
+#include <linux/log2.h>
+#include <linux/mailbox_client.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/of_address.h>
+#include <linux/platform_device.h>
+#include <linux/spinlock.h>
+#include <soc/rockchip/rockchip-mailbox.h>
+#include <soc/rockchip/rockchip_amp_ring.h>
+
+#define RK_AMP_RING_NUM_DEF	64
+#define RK_AMP_RING_SLOT_DEF	256
+
+struct rk_amp_ring_client {
+	rk_amp_ring_rx_cb cb;
+	void *data;
+};
+
+struct rk_amp_ring {
+	struct device *dev;
+	void *base;
+	size_t size;
+	struct rk_amp_ring_ctrl *tx;
+	struct rk_amp_ring_ctrl *rx;
+	void *tx_slots;
+	void *rx_slots;
+	u32 num;
+	u32 slot_size;
+	u32 tx_head;
+	u32 tx_seq;
+	u32 rx_tail;
+	u32 rx_cnt;
+	u32 rx_bad;
+	u32 kicks;
+	struct mbox_client mbox_cl;
+	struct mbox_chan *mbox_tx_chan;
+	struct mbox_chan *mbox_rx_chan;
+};
+
+static struct rk_amp_ring *amp_ring;
+/* linux side producers of the tx ring */
+static DEFINE_SPINLOCK(tx_lock);
+/* rx drain against client register */
+static DEFINE_SPINLOCK(rx_lock);
+static struct rk_amp_ring_client clients[RK_AMP_RING_TYPE_MAX];
+
+static void rk_amp_ring_doorbell(struct rk_amp_ring *ring, u32 cmd, u32 data)
+{
+	struct rockchip_mbox_msg msg = {
+		.cmd = cmd,
+		.data = data,
+	};
+
+	if (mbox_send_message(ring->mbox_tx_chan, &msg) < 0)
+		dev_warn_ratelimited(ring->dev, "failed to send doorbell\n");
+	else
+		ring->kicks++;
+}
+
+int rk_amp_ring_send(u32 type, const void *msg, u32 len)
+{
+	struct rk_amp_ring *ring;
+	struct rk_amp_ring_slot *slot;
+	unsigned long flags;
+	bool kick = false;
+	u32 head;
+	int ret = 0;
+
+	if (!type || type >= RK_AMP_RING_TYPE_MAX)
+		return -EINVAL;
+
+	spin_lock_irqsave(&tx_lock, flags);
+	ring = amp_ring;
+	if (!ring) {
+		ret = -ENODEV;
+		goto out;
+	}
+	if (len > ring->slot_size - sizeof(*slot)) {
+		ret = -EMSGSIZE;
+		goto out;
+	}
+
+	head = ring->tx_head;
+	if (head - READ_ONCE(ring->tx->tail) >= ring->num) {
+		WRITE_ONCE(ring->tx->drops, ring->tx->drops + 1);
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	slot = ring->tx_slots + (head & (ring->num - 1)) * ring->slot_size;
+	slot->type = type;
+	slot->len = len;
+	slot->seq = ring->tx_seq++;
+	memcpy(slot->data, msg, len);
+	/* slot content before head */
+	dma_wmb();
+	ring->tx_head = ++head;
+	WRITE_ONCE(ring->tx->head, head);
+	/* head before kick, pairs with the consumer arming kick */
+	mb();
+	kick = READ_ONCE(ring->tx->kick);
+	if (kick)
+		rk_amp_ring_doorbell(ring, RK_AMP_RING_CMD_KICK, head);
+out:
+	spin_unlock_irqrestore(&tx_lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(rk_amp_ring_send);
+
+int rk_amp_ring_register(u32 type, rk_amp_ring_rx_cb cb, void *data)
+{
+	unsigned long flags;
+	int ret = 0;
+
+	if (!type || type >= RK_AMP_RING_TYPE_MAX || !cb)
+		return -EINVAL;
+
+	spin_lock_irqsave(&rx_lock, flags);
+	if (clients[type].cb) {
+		ret = -EBUSY;
+	} else {
+		clients[type].cb = cb;
+		clients[type].data = data;
+	}
+	spin_unlock_irqrestore(&rx_lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(rk_amp_ring_register);
+
+void rk_amp_ring_unregister(u32 type)
+{
+	unsigned long flags;
+
+	if (!type || type >= RK_AMP_RING_TYPE_MAX)
+		return;
+
+	spin_lock_irqsave(&rx_lock, flags);
+	clients[type].cb = NULL;
+	clients[type].data = NULL;
+	spin_unlock_irqrestore(&rx_lock, flags);
+}
+EXPORT_SYMBOL_GPL(rk_amp_ring_unregister);
+
+static void rk_amp_ring_drain(struct rk_amp_ring *ring)
+{
+	struct rk_amp_ring_ctrl *ctrl = ring->rx;
+	struct rk_amp_ring_slot *slot;
+	struct rk_amp_ring_client *client;
+	unsigned long flags;
+	u32 tail, head;
+
+	spin_lock_irqsave(&rx_lock, flags);
+	WRITE_ONCE(ctrl->kick, 0);
+	for (;;) {
+		tail = ring->rx_tail;
+		head = READ_ONCE(ctrl->head);
+		if (head == tail) {
+			/* arm the doorbell then look again, the producer may be in between */
+			WRITE_ONCE(ctrl->kick, 1);
+			mb();
+			if (READ_ONCE(ctrl->head) == tail)
+				break;
+			WRITE_ONCE(ctrl->kick, 0);
+			continue;
+		}
+		if (head - tail > ring->num) {
+			/* producer is broken, drop everything queued */
+			ring->rx_bad++;
+			ring->rx_tail = head;
+			WRITE_ONCE(ctrl->tail, head);
+			continue;
+		}
+		/* head before slot content */
+		dma_rmb();
+		slot = ring->rx_slots + (tail & (ring->num - 1)) * ring->slot_size;
+		if (slot->type < RK_AMP_RING_TYPE_MAX &&
+		    slot->len <= ring->slot_size - sizeof(*slot)) {
+			client = &clients[slot->type];
+			if (client->cb)
+				client->cb(client->data, slot->type, slot->data, slot->len);
+			ring->rx_cnt++;
+		} else {
+			ring->rx_bad++;
+		}
+		/* slot read before it is handed back */
+		mb();
+		ring->rx_tail = ++tail;
+		WRITE_ONCE(ctrl->tail, tail);
+	}
+	spin_unlock_irqrestore(&rx_lock, flags);
+}
+
+static void rk_amp_ring_rx_callback(struct mbox_client *mbox_cl, void *message)
+{
+	struct rk_amp_ring *ring = container_of(mbox_cl, struct rk_amp_ring, mbox_cl);
+	struct rockchip_mbox_msg msg;
+
+	rockchip_mbox_read_msg(ring->mbox_rx_chan, &msg);
+	rk_amp_ring_drain(ring);
+}
+
+static void rk_amp_ring_ctrl_init(struct rk_amp_ring_ctrl *ctrl, u32 num, u32 slot_size)
+{
+	memset(ctrl, 0, sizeof(*ctrl));
+	ctrl->num = num;
+	ctrl->slot_size = slot_size;
+	/* the consumer is idle until the first message */
+	ctrl->kick = 1;
+	dma_wmb();
+	WRITE_ONCE(ctrl->magic, RK_AMP_RING_MAGIC);
+}
+
+static ssize_t status_show(struct device *dev,
+			   struct device_attribute *attr, char *buf)
+{
+	struct rk_amp_ring *ring = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf,
+			  "slots:%u size:%u\n"
+			  "tx head:%u tail:%u drops:%u kicks:%u\n"
+			  "rx head:%u tail:%u cnt:%u bad:%u\n",
+			  ring->num, ring->slot_size,
+			  READ_ONCE(ring->tx->head), READ_ONCE(ring->tx->tail),
+			  READ_ONCE(ring->tx->drops), ring->kicks,
+			  READ_ONCE(ring->rx->head), ring->rx_tail,
+			  ring->rx_cnt, ring->rx_bad);
+}
+static DEVICE_ATTR_RO(status);
+
+static int rk_amp_ring_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct rk_amp_ring *ring;
+	struct device_node *mem;
+	struct resource reg;
+	unsigned long flags;
+	u32 num = RK_AMP_RING_NUM_DEF;
+	u32 slot_size = RK_AMP_RING_SLOT_DEF;
+	int ret;
+
+	ring = devm_kzalloc(dev, sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return -ENOMEM;
+	ring->dev = dev;
+
+	mem = of_parse_phandle(dev->of_node, "memory-region", 0);
+	if (!mem) {
+		dev_err(dev, "missing \"memory-region\" property\n");
+		return -ENODEV;
+	}
+	ret = of_address_to_resource(mem, 0, &reg);
+	of_node_put(mem);
+	if (ret) {
+		dev_err(dev, "missing \"reg\" property\n");
+		return -ENODEV;
+	}
+
+	of_property_read_u32(dev->of_node, "rockchip,slots", &num);
+	of_property_read_u32(dev->of_node, "rockchip,slot-size", &slot_size);
+	if (!is_power_of_2(num) || slot_size < sizeof(struct rk_amp_ring_slot) + 4 ||
+	    !IS_ALIGNED(slot_size, 8)) {
+		dev_err(dev, "invalid slots %u size %u\n", num, slot_size);
+		return -EINVAL;
+	}
+	ring->num = num;
+	ring->slot_size = slot_size;
+	ring->size = RK_AMP_RING_HDR + 2 * (size_t)num * slot_size;
+	if (ring->size > resource_size(&reg)) {
+		dev_err(dev, "memory-region too small, need %zu\n", ring->size);
+		return -EINVAL;
+	}
+
+	/* the other core may not snoop our caches */
+	ring->base = devm_memremap(dev, reg.start, ring->size, MEMREMAP_WC);
+	if (IS_ERR(ring->base))
+		return PTR_ERR(ring->base);
+	ring->tx = ring->base;
+	ring->rx = ring->base + sizeof(struct rk_amp_ring_ctrl);
+	ring->tx_slots = ring->base + RK_AMP_RING_HDR;
+	ring->rx_slots = ring->tx_slots + (size_t)num * slot_size;
+	rk_amp_ring_ctrl_init(ring->tx, num, slot_size);
+	rk_amp_ring_ctrl_init(ring->rx, num, slot_size);
+
+	ring->mbox_cl.dev = dev;
+	ring->mbox_cl.tx_block = false;
+	ring->mbox_cl.knows_txdone = false;
+	ring->mbox_cl.rx_callback = rk_amp_ring_rx_callback;
+	ring->mbox_tx_chan = mbox_request_channel_byname(&ring->mbox_cl, "tx");
+	if (IS_ERR(ring->mbox_tx_chan)) {
+		dev_err(dev, "failed to request mbox tx chan\n");
+		return PTR_ERR(ring->mbox_tx_chan);
+	}
+	ring->mbox_rx_chan = mbox_request_channel_byname(&ring->mbox_cl, "rx");
+	if (IS_ERR(ring->mbox_rx_chan)) {
+		dev_err(dev, "failed to request mbox rx chan\n");
+		mbox_free_channel(ring->mbox_tx_chan);
+		return PTR_ERR(ring->mbox_rx_chan);
+	}
+
+	platform_set_drvdata(pdev, ring);
+	if (device_create_file(dev, &dev_attr_status))
+		dev_warn(dev, "failed to create status attr\n");
+
+	spin_lock_irqsave(&tx_lock, flags);
+	amp_ring = ring;
+	rk_amp_ring_doorbell(ring, RK_AMP_RING_CMD_INIT, num);
+	spin_unlock_irqrestore(&tx_lock, flags);
+
+	dev_info(dev, "%u slots of %u bytes each way\n", num, slot_size);
+	return 0;
+}
+
+static int rk_amp_ring_remove(struct platform_device *pdev)
+{
+	struct rk_amp_ring *ring = platform_get_drvdata(pdev);
+	unsigned long flags;
+
+	spin_lock_irqsave(&tx_lock, flags);
+	amp_ring = NULL;
+	spin_unlock_irqrestore(&tx_lock, flags);
+
+	device_remove_file(&pdev->dev, &dev_attr_status);
+	mbox_free_channel(ring->mbox_rx_chan);
+	mbox_free_channel(ring->mbox_tx_chan);
+
+	return 0;
+}
+
+static const struct of_device_id rk_amp_ring_dt_match[] = {
+	{ .compatible = "rockchip,amp-ring" },
+	{},
+};
+MODULE_DEVICE_TABLE(of, rk_amp_ring_dt_match);
+
+static struct platform_driver rk_amp_ring_driver = {
+	.probe		= rk_amp_ring_probe,
+	.remove		= rk_amp_ring_remove,
+	.driver		= {
+		.name		= "rockchip-amp-ring",
+		.of_match_table	= rk_amp_ring_dt_match,
+	},
+};
+module_platform_driver(rk_amp_ring_driver);
+
+MODULE_DESCRIPTION("Rockchip AMP shared memory ring");
+MODULE_LICENSE("GPL");
@@ -4,6 +4,7 @@
  */
 #include <linux/clk.h>
 #include <linux/delay.h>
+#include <linux/dma-mapping.h>
 #include <linux/initramfs.h>
 #include <linux/interrupt.h>
 #include <linux/kernel.h>
@@ -14,7 +15,11 @@
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
 #include <linux/reset.h>
+#include <linux/sizes.h>
 #include <linux/soc/rockchip/rockchip_decompress.h>
+#include <linux/soc/rockchip/rockchip_thunderboot_mem.h>
+#include <linux/xxhash.h>
+#include <asm/unaligned.h>
 
 #define DECOM_CTRL		0x0
 #define DECOM_ENR		0x4
@@ -73,6 +78,9 @@
 #define DECOM_ENABLE		0x1
 #define DECOM_DISABLE		0x0
 
+/* keep off the tail of the output which may still be in flight */
+#define DECOM_PROGRESS_MARGIN	SZ_4K
+
 #define DECOM_INT_MASK \
 	(DSOLIEN | ZDICTEIEN | GCMEIEN | GIDEIEN | \
 	CCCEIEN | BCCEIEN | HCCEIEN | CSEIEN | \
@@ -98,6 +106,16 @@ static bool g_decom_complete;
 static bool g_decom_noblocking;
 static u64 g_decom_data_len;
 
+/* dst of current decompress, for reader of partly done output */
+static DEFINE_SPINLOCK(g_decom_lock);
+static bool g_decom_running;
+static phys_addr_t g_decom_dst;
+static u32 g_decom_dst_size;
+
+static bool decom_progress;
+module_param(decom_progress, bool, 0644);
+MODULE_PARM_DESC(decom_progress, "serve output decompressed so far by TSIZE before complete");
+
 void __init wait_initrd_hw_decom_done(void)
 {
 	wait_event(g_decom_wait, g_decom_complete);
@@ -112,6 +130,9 @@ int rk_decom_wait_done(u32 timeout, u64 *decom_len)
 
 	ret = wait_event_timeout(g_decom_wait, g_decom_complete, timeout * HZ);
 	if (!ret) {
+		spin_lock_irq(&g_decom_lock);
+		g_decom_running = false;
+		spin_unlock_irq(&g_decom_lock);
 		if (g_decom)
 			clk_bulk_disable_unprepare(g_decom->num_clocks, g_decom->clocks);
 
@@ -124,7 +145,52 @@ int rk_decom_wait_done(u32 timeout, u64 *decom_len)
 }
 EXPORT_SYMBOL(rk_decom_wait_done);
 
+static u64 rk_decom_get_progress(void)
+{
+	unsigned long flags;
+	u64 len = 0;
+
+	spin_lock_irqsave(&g_decom_lock, flags);
+	if (g_decom_running && decom_progress) {
+		len = readl(g_decom->regs + DECOM_TSIZEH);
+		len = (len << 32) | readl(g_decom->regs + DECOM_TSIZEL);
+		len = len > DECOM_PROGRESS_MARGIN ? len - DECOM_PROGRESS_MARGIN : 0;
+	}
+	spin_unlock_irqrestore(&g_decom_lock, flags);
+
+	return len;
+}
+
+int rk_decom_wait_range(phys_addr_t start, size_t len, u32 timeout_ms)
+{
+	unsigned long timeout = jiffies + msecs_to_jiffies(timeout_ms);
+	u64 end;
+
+	/* not output of the current decompress */
+	if (!g_decom_dst || start < g_decom_dst ||
+	    start + len > g_decom_dst + g_decom_dst_size)
+		return 0;
+
+	end = start + len - g_decom_dst;
+	while (!READ_ONCE(g_decom_complete)) {
+		if (rk_decom_get_progress() >= end)
+			return 0;
+		if (time_after(jiffies, timeout))
+			return -ETIMEDOUT;
+		wait_event_timeout(g_decom_wait, g_decom_complete,
+				   decom_progress ? 1 : msecs_to_jiffies(timeout_ms));
+	}
+
+	/* range after the end of output is not part of the image, not an error */
+	return g_decom_data_len ? 0 : -EIO;
+}
+EXPORT_SYMBOL(rk_decom_wait_range);
+
 static DECLARE_WAIT_QUEUE_HEAD(decom_init_done);
+static DEFINE_MUTEX(g_decom_run_lock);
+
+/* timeout of rk_decom_run in seconds */
+#define DECOM_RUN_TIMEOUT	1
 
 int rk_decom_start(u32 mode, phys_addr_t src, phys_addr_t dst, u32 dst_max_size)
 {
@@ -148,6 +214,8 @@ int rk_decom_start(u32 mode, phys_addr_t src, phys_addr_t dst, u32 dst_max_size)
 	g_decom_complete   = false;
 	g_decom_data_len   = 0;
 	g_decom_noblocking = rk_get_noblocking_flag(mode);
+	g_decom_dst        = dst;
+	g_decom_dst_size   = dst_max_size;
 
 	decom_enr = readl(g_decom->regs + DECOM_ENR);
 	if (decom_enr & 0x1) {
@@ -196,15 +264,89 @@ int rk_decom_start(u32 mode, phys_addr_t src, phys_addr_t dst, u32 dst_max_size)
 
 	writel(DECOM_INT_MASK, g_decom->regs + DECOM_IEN);
 	writel(DECOM_ENABLE, g_decom->regs + DECOM_ENR);
+	spin_lock_irq(&g_decom_lock);
+	g_decom_running = true;
+	spin_unlock_irq(&g_decom_lock);
 
 	return 0;
 error:
+	g_decom_dst = 0;
 	clk_bulk_disable_unprepare(g_decom->num_clocks, g_decom->clocks);
 
 	return ret;
 }
 EXPORT_SYMBOL(rk_decom_start);
 
+/*
+ * Decompress service for in kernel users such as filesystems. Requests
+ * are serialized on the single engine; the caller sleeps until done and
+ * gets the decompressed length. A failed stream stops the engine instead
+ * of retrying so the caller can fall back to software decompression.
+ */
+int rk_decom_run(u32 mode, void *src, size_t src_len, void *dst, size_t dst_len,
+		 u64 *decom_len)
+{
+	dma_addr_t src_dma, dst_dma;
+	struct device *dev;
+	int ret;
+
+	if (!g_decom || !decom_len)
+		return -ENODEV;
+	dev = g_decom->dev;
+
+	mutex_lock(&g_decom_run_lock);
+	src_dma = dma_map_single(dev, src, src_len, DMA_TO_DEVICE);
+	if (dma_mapping_error(dev, src_dma)) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	dst_dma = dma_map_single(dev, dst, dst_len, DMA_FROM_DEVICE);
+	if (dma_mapping_error(dev, dst_dma)) {
+		ret = -ENOMEM;
+		goto unmap_src;
+	}
+
+	ret = rk_decom_start(mode | DECOM_NOBLOCKING, src_dma, dst_dma, dst_len);
+	if (!ret)
+		ret = rk_decom_wait_done(DECOM_RUN_TIMEOUT, decom_len);
+	if (!ret && !*decom_len)
+		ret = -EIO;
+	g_decom_dst = 0;
+
+	dma_unmap_single(dev, dst_dma, dst_len, DMA_FROM_DEVICE);
+unmap_src:
+	dma_unmap_single(dev, src_dma, src_len, DMA_TO_DEVICE);
+out:
+	mutex_unlock(&g_decom_run_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL(rk_decom_run);
+
+/*
+ * The engine only takes lz4 frames, while filesystems and swap store raw
+ * lz4 blocks. Wrap the block in place with a frame header in the head
+ * room (version 01, independent blocks, no checksums, 4MB max block) and
+ * the end mark in the tail room.
+ */
+int rk_decom_lz4_block(void *buf, size_t len, void *dst, size_t dst_len,
+		       u64 *decom_len)
+{
+	u8 *hdr = buf;
+
+	put_unaligned_le32(0x184D2204, hdr);
+	hdr[4] = 0x60;
+	hdr[5] = 0x70;
+	hdr[6] = (xxh32(hdr + 4, 2, 0) >> 8) & 0xff;
+	put_unaligned_le32(len, hdr + 7);
+	put_unaligned_le32(0, hdr + RK_DECOM_LZ4_HEAD + len);
+
+	return rk_decom_run(LZ4_MOD, buf,
+			    RK_DECOM_LZ4_HEAD + len + RK_DECOM_LZ4_TAIL,
+			    dst, dst_len, decom_len);
+}
+EXPORT_SYMBOL(rk_decom_lz4_block);
+
 static irqreturn_t rk_decom_irq_handler(int irq, void *priv)
 {
 	struct rk_decom *rk_dec = priv;
@@ -257,19 +399,19 @@ static irqreturn_t rk_decom_irq_thread(int irq, void *priv)
 	struct rk_decom *rk_dec = priv;
 
 	if (g_decom_complete) {
-		void *start, *end;
-
 		if (rk_dec->mem_start) {
 			/*
 			 * Now it is safe to free reserve memory that
 			 * store the origin ramdisk file
 			 */
-			start = phys_to_virt(rk_dec->mem_start);
-			end = start + rk_dec->mem_size;
-			free_reserved_area(start, end, -1, "ramdisk gzip archive");
+			rk_tb_mem_release("ramdisk gzip archive",
+					  rk_dec->mem_start, rk_dec->mem_size);
 			rk_dec->mem_start = 0;
 		}
 
+		spin_lock_irq(&g_decom_lock);
+		g_decom_running = false;
+		spin_unlock_irq(&g_decom_lock);
 		clk_bulk_disable_unprepare(rk_dec->num_clocks, rk_dec->clocks);
 	}
 
@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Frame synchronous sensor exposure. An ae update written whenever its
+ * ioctl arrives lands in whichever frame the sensor is exposing then, so
+ * the ae loop has to wait an extra frame to see it. Queued exposures are
+ * held until the sof of the frame they have to be written in and then
+ * written from an rt worker, which also counts how many made it on time.
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <media/v4l2-ctrls.h>
+#include <media/v4l2-subdev.h>
+#include <soc/rockchip/rockchip_exp_queue.h>
+#include <soc/rockchip/rockchip_performance.h>
+
+static LIST_HEAD(exp_queue_list);
+static DEFINE_MUTEX(exp_queue_list_lock);
+
+static int rk_exp_queue_write(struct v4l2_subdev *sd,
+			      const struct rk_exp_req *req)
+{
+	struct v4l2_ctrl *ctrl;
+	int i, ret = 0;
+
+	if (!sd || !sd->ctrl_handler)
+		return -ENODEV;
+
+	for (i = 0; i < req->ctrl_num && !ret; i++) {
+		ctrl = v4l2_ctrl_find(sd->ctrl_handler, req->ctrl[i].id);
+		ret = ctrl ? v4l2_ctrl_s_ctrl(ctrl, req->ctrl[i].value) : -EINVAL;
+	}
+
+	return ret;
+}
+
+static void rk_exp_queue_work(struct kthread_work *work)
+{
+	struct rk_exp_queue *q = container_of(work, struct rk_exp_queue, work);
+	struct rk_exp_entry run[RK_EXP_QUEUE_DEPTH];
+	struct v4l2_subdev *sd;
+	unsigned long flags;
+	u32 i, n, failed = 0;
+	u64 sof_ns, us;
+
+	spin_lock_irqsave(&q->lock, flags);
+	n = q->nr_run;
+	memcpy(run, q->run, n * sizeof(run[0]));
+	q->nr_run = 0;
+	sd = q->sd;
+	sof_ns = q->sof_ns;
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	for (i = 0; i < n; i++) {
+		if (rk_exp_queue_write(sd, &run[i].req)) {
+			pr_debug("%s: exposure for frame %u failed\n", q->name,
+				 run[i].req.frame_id);
+			failed++;
+		}
+	}
+	us = div_u64(ktime_get_ns() - sof_ns, NSEC_PER_USEC);
+
+	spin_lock_irqsave(&q->lock, flags);
+	q->stats.failed += failed;
+	if (us > q->stats.max_write_us)
+		q->stats.max_write_us = min_t(u64, us, U32_MAX);
+	spin_unlock_irqrestore(&q->lock, flags);
+}
+
+int rk_exp_queue_init(struct rk_exp_queue *q, const char *name)
+{
+	char buf[32];
+
+	memset(q, 0, sizeof(*q));
+	spin_lock_init(&q->lock);
+	kthread_init_work(&q->work, rk_exp_queue_work);
+	q->name = name;
+
+	snprintf(buf, sizeof(buf), "%s_exp", name);
+	q->worker = rockchip_perf_create_worker(buf);
+	if (IS_ERR(q->worker)) {
+		int ret = PTR_ERR(q->worker);
+
+		q->worker = NULL;
+		return ret;
+	}
+
+	mutex_lock(&exp_queue_list_lock);
+	list_add_tail(&q->node, &exp_queue_list);
+	mutex_unlock(&exp_queue_list_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rk_exp_queue_init);
+
+void rk_exp_queue_remove(struct rk_exp_queue *q)
+{
+	if (!q->worker)
+		return;
+
+	mutex_lock(&exp_queue_list_lock);
+	list_del(&q->node);
+	mutex_unlock(&exp_queue_list_lock);
+
+	rockchip_perf_destroy_worker(q->worker);
+	q->worker = NULL;
+}
+EXPORT_SYMBOL_GPL(rk_exp_queue_remove);
+
+int rk_exp_queue_add(struct rk_exp_queue *q, const struct rk_exp_req *req)
+{
+	struct rk_exp_entry *entry;
+	unsigned long flags;
+	u32 i, write_seq;
+	int ret = 0;
+
+	if (!q->worker)
+		return -ENODEV;
+	if (!req->ctrl_num || req->ctrl_num > RK_EXP_CTRL_MAX)
+		return -EINVAL;
+
+	write_seq = req->frame_id - min(req->sensor_delay, req->frame_id);
+
+	spin_lock_irqsave(&q->lock, flags);
+	if (q->nr_pending == RK_EXP_QUEUE_DEPTH) {
+		q->stats.dropped++;
+		ret = -EBUSY;
+		goto unlock;
+	}
+	/* after the ones for the same sof, they are written in order */
+	for (i = q->nr_pending; i && q->pending[i - 1].write_seq > write_seq; i--)
+		q->pending[i] = q->pending[i - 1];
+	entry = &q->pending[i];
+	entry->req = *req;
+	memset(entry->req.reserved, 0, sizeof(entry->req.reserved));
+	entry->write_seq = write_seq;
+	q->nr_pending++;
+	q->stats.queued++;
+unlock:
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(rk_exp_queue_add);
+
+/* the frame seq has just started, sd is the sensor */
+void rk_exp_queue_sof(struct rk_exp_queue *q, struct v4l2_subdev *sd, u32 seq)
+{
+	unsigned long flags;
+	u32 i;
+
+	if (!READ_ONCE(q->nr_pending))
+		return;
+
+	spin_lock_irqsave(&q->lock, flags);
+	for (i = 0; i < q->nr_pending && q->pending[i].write_seq <= seq; i++) {
+		if (q->nr_run == RK_EXP_QUEUE_DEPTH) {
+			/* the worker is behind by a whole queue */
+			q->stats.dropped++;
+			continue;
+		}
+		q->run[q->nr_run++] = q->pending[i];
+		if (q->pending[i].write_seq == seq)
+			q->stats.on_time++;
+		else
+			q->stats.late++;
+	}
+	q->nr_pending -= i;
+	memmove(q->pending, q->pending + i, q->nr_pending * sizeof(q->pending[0]));
+	if (i) {
+		q->sd = sd;
+		q->sof_ns = ktime_get_ns();
+	}
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	if (i)
+		kthread_queue_work(q->worker, &q->work);
+}
+EXPORT_SYMBOL_GPL(rk_exp_queue_sof);
+
+/* at stream off, the frame sequence starts over */
+void rk_exp_queue_reset(struct rk_exp_queue *q)
+{
+	unsigned long flags;
+
+	if (!q->worker)
+		return;
+
+	kthread_flush_work(&q->work);
+	spin_lock_irqsave(&q->lock, flags);
+	q->nr_pending = 0;
+	q->nr_run = 0;
+	memset(&q->stats, 0, sizeof(q->stats));
+	spin_unlock_irqrestore(&q->lock, flags);
+}
+EXPORT_SYMBOL_GPL(rk_exp_queue_reset);
+
+void rk_exp_queue_get_stats(struct rk_exp_queue *q, struct rk_exp_stats *stats)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&q->lock, flags);
+	*stats = q->stats;
+	spin_unlock_irqrestore(&q->lock, flags);
+}
+EXPORT_SYMBOL_GPL(rk_exp_queue_get_stats);
+
+static int rk_exp_queue_show(struct seq_file *m, void *v)
+{
+	struct rk_exp_stats stats;
+	struct rk_exp_queue *q;
+	u32 pending;
+
+	mutex_lock(&exp_queue_list_lock);
+	list_for_each_entry(q, &exp_queue_list, node) {
+		spin_lock_irq(&q->lock);
+		stats = q->stats;
+		pending = q->nr_pending;
+		spin_unlock_irq(&q->lock);
+		seq_printf(m, "%s pending:%u queued:%u on time:%u late:%u dropped:%u failed:%u max write:%uus\n",
+			   q->name, pending, stats.queued, stats.on_time,
+			   stats.late, stats.dropped, stats.failed,
+			   stats.max_write_us);
+	}
+	mutex_unlock(&exp_queue_list_lock);
+
+	return 0;
+}
+
+static int __init rk_exp_queue_module_init(void)
+{
+	proc_create_single("rk_exp_queue", 0444, NULL, rk_exp_queue_show);
+	return 0;
+}
+
+static void __exit rk_exp_queue_module_exit(void)
+{
+	remove_proc_entry("rk_exp_queue", NULL);
+}
+
+module_init(rk_exp_queue_module_init);
+module_exit(rk_exp_queue_module_exit);
+
+MODULE_DESCRIPTION("Rockchip frame synchronous sensor exposure queue");
+MODULE_LICENSE("GPL");
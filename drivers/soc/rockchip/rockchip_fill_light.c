@@ -0,0 +1,315 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Fill light pulsed on the sensor exposure. An ir or white light driven
+ * at a constant duty burns most of its power while no row is exposing,
+ * and lights moving objects over the whole frame time. Strobed from the
+ * sof, it is only lit while the next frame exposes: for exposures longer
+ * than the readout only while all rows expose together, which also
+ * freezes motion like a global shutter flash.
+ */
+#include <linux/device.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/proc_fs.h>
+#include <linux/pwm.h>
+#include <linux/seq_file.h>
+#include <soc/rockchip/rockchip_fill_light.h>
+
+/* an edge due this close is switched at once */
+#define RK_FILL_LIGHT_SLACK_NS	(5 * NSEC_PER_USEC)
+
+static LIST_HEAD(fill_light_list);
+static DEFINE_MUTEX(fill_light_list_lock);
+
+/* called with the lock held, from the timer too */
+static void rk_fill_light_set(struct rk_fill_light *fl, bool on)
+{
+	struct pwm_state state;
+
+	pwm_init_state(fl->pwm, &state);
+	pwm_set_relative_duty_cycle(&state, fl->cfg.brightness, 100);
+	state.enabled = on && fl->cfg.brightness;
+#ifdef CONFIG_PWM_ROCKCHIP_ONESHOT
+	state.oneshot_count = 0;
+#endif
+	pwm_apply_state(fl->pwm, &state);
+}
+
+static void rk_fill_light_off(struct rk_fill_light *fl, u64 now)
+{
+	rk_fill_light_set(fl, false);
+	fl->lit = false;
+	fl->on_total_ns += now - fl->lit_ns;
+}
+
+static enum hrtimer_restart rk_fill_light_timer(struct hrtimer *timer)
+{
+	struct rk_fill_light *fl = container_of(timer, struct rk_fill_light, timer);
+	unsigned long flags;
+	u64 now = ktime_get_ns();
+	u64 expire, late;
+
+	spin_lock_irqsave(&fl->lock, flags);
+	if (fl->cfg.mode != RK_FILL_LIGHT_MODE_STROBE) {
+		/* set_cfg has already set the light for the new mode */
+		if (fl->lit)
+			fl->on_total_ns += now - fl->lit_ns;
+		fl->lit = false;
+		goto stop;
+	}
+
+	if (!fl->lit) {
+		/* a later sof moved the pulse */
+		if (now + RK_FILL_LIGHT_SLACK_NS < fl->on_ns) {
+			expire = fl->on_ns;
+			goto restart;
+		}
+		rk_fill_light_set(fl, true);
+		fl->lit = true;
+		fl->lit_ns = now;
+		fl->stats.pulses++;
+		late = div_u64(now > fl->on_ns ? now - fl->on_ns : 0, NSEC_PER_USEC);
+		if (late > RK_FILL_LIGHT_LATE_US)
+			fl->stats.late++;
+		if (late > fl->stats.max_late_us)
+			fl->stats.max_late_us = min_t(u64, late, U32_MAX);
+		expire = fl->off_ns;
+		goto restart;
+	}
+
+	/* stretched by the next frame */
+	if (now + RK_FILL_LIGHT_SLACK_NS < fl->off_ns) {
+		expire = fl->off_ns;
+		goto restart;
+	}
+	rk_fill_light_off(fl, now);
+	if (!fl->next_on_ns)
+		goto stop;
+	fl->on_ns = fl->next_on_ns;
+	fl->off_ns = fl->next_off_ns;
+	fl->next_on_ns = 0;
+	expire = fl->on_ns;
+
+restart:
+	hrtimer_set_expires(timer, ns_to_ktime(expire));
+	spin_unlock_irqrestore(&fl->lock, flags);
+	return HRTIMER_RESTART;
+
+stop:
+	fl->busy = false;
+	spin_unlock_irqrestore(&fl->lock, flags);
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * the frame has just started, exp_lines and frame_lines (height plus
+ * vblank) are the sensor's current exposure and frame length.
+ */
+void rk_fill_light_sof(struct rk_fill_light *fl, u32 exp_lines,
+		       u32 frame_lines, u32 height, u32 line_ns)
+{
+	unsigned long flags;
+	u64 now, on, off;
+	u32 start, width;
+
+	if (!fl->pwm || !rk_fill_light_strobe(fl))
+		return;
+
+	now = ktime_get_ns();
+	spin_lock_irqsave(&fl->lock, flags);
+	if (fl->cfg.mode != RK_FILL_LIGHT_MODE_STROBE)
+		goto unlock;
+	fl->stats.frames++;
+	if (!exp_lines || !line_ns || exp_lines > frame_lines) {
+		fl->stats.skipped++;
+		goto unlock;
+	}
+
+	/*
+	 * row r of the next frame is read out at frame_lines + r and exposes
+	 * the exp_lines before. past the readout all rows expose together
+	 * from the start of the last row to the end of the first, shorter
+	 * ones need the light from the start of the first row to the end of
+	 * the last.
+	 */
+	if (exp_lines > height) {
+		start = frame_lines - exp_lines + height;
+		width = exp_lines - height;
+	} else {
+		start = frame_lines - exp_lines;
+		width = exp_lines + height;
+	}
+	on = now + (u64)start * line_ns;
+	off = on + (u64)width * line_ns;
+
+	if (fl->lit && on <= fl->off_ns) {
+		fl->off_ns = max(fl->off_ns, off);
+	} else if (fl->lit) {
+		fl->next_on_ns = on;
+		fl->next_off_ns = off;
+	} else {
+		fl->on_ns = on;
+		fl->off_ns = off;
+		fl->next_on_ns = 0;
+	}
+
+	/* a queued or running timer picks up the new edges itself */
+	if (!fl->busy) {
+		fl->busy = true;
+		hrtimer_start(&fl->timer, ns_to_ktime(fl->on_ns),
+			      HRTIMER_MODE_ABS);
+	}
+unlock:
+	spin_unlock_irqrestore(&fl->lock, flags);
+}
+EXPORT_SYMBOL_GPL(rk_fill_light_sof);
+
+/* at stream off, no more sofs */
+void rk_fill_light_stop(struct rk_fill_light *fl)
+{
+	unsigned long flags;
+
+	if (!fl->pwm)
+		return;
+
+	hrtimer_cancel(&fl->timer);
+	spin_lock_irqsave(&fl->lock, flags);
+	if (fl->lit)
+		rk_fill_light_off(fl, ktime_get_ns());
+	fl->busy = false;
+	fl->next_on_ns = 0;
+	fl->on_total_ns = 0;
+	memset(&fl->stats, 0, sizeof(fl->stats));
+	spin_unlock_irqrestore(&fl->lock, flags);
+}
+EXPORT_SYMBOL_GPL(rk_fill_light_stop);
+
+int rk_fill_light_set_cfg(struct rk_fill_light *fl,
+			  const struct rk_fill_light_cfg *cfg)
+{
+	unsigned long flags;
+
+	if (!fl->pwm)
+		return -ENODEV;
+	if (cfg->mode > RK_FILL_LIGHT_MODE_STROBE || cfg->brightness > 100)
+		return -EINVAL;
+
+	spin_lock_irqsave(&fl->lock, flags);
+	fl->cfg = *cfg;
+	memset(fl->cfg.reserved, 0, sizeof(fl->cfg.reserved));
+	/* the timer of a strobe in flight sees the new mode and stops */
+	rk_fill_light_set(fl, cfg->mode == RK_FILL_LIGHT_MODE_CONTINUOUS ||
+			  (cfg->mode == RK_FILL_LIGHT_MODE_STROBE && fl->lit));
+	spin_unlock_irqrestore(&fl->lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rk_fill_light_set_cfg);
+
+void rk_fill_light_get_cfg(struct rk_fill_light *fl,
+			   struct rk_fill_light_cfg *cfg)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&fl->lock, flags);
+	*cfg = fl->cfg;
+	spin_unlock_irqrestore(&fl->lock, flags);
+}
+EXPORT_SYMBOL_GPL(rk_fill_light_get_cfg);
+
+void rk_fill_light_get_stats(struct rk_fill_light *fl,
+			     struct rk_fill_light_stats *stats)
+{
+	unsigned long flags;
+	u64 on_ns;
+
+	spin_lock_irqsave(&fl->lock, flags);
+	*stats = fl->stats;
+	on_ns = fl->on_total_ns;
+	if (fl->lit)
+		on_ns += ktime_get_ns() - fl->lit_ns;
+	spin_unlock_irqrestore(&fl->lock, flags);
+	stats->on_ms = min_t(u64, div_u64(on_ns, NSEC_PER_MSEC), U32_MAX);
+}
+EXPORT_SYMBOL_GPL(rk_fill_light_get_stats);
+
+static void rk_fill_light_release(void *data)
+{
+	struct rk_fill_light *fl = data;
+
+	mutex_lock(&fill_light_list_lock);
+	list_del(&fl->node);
+	mutex_unlock(&fill_light_list_lock);
+
+	hrtimer_cancel(&fl->timer);
+	pwm_disable(fl->pwm);
+}
+
+/* the "fill-light" pwm of dev, without one the light stays absent */
+int rk_fill_light_init(struct rk_fill_light *fl, struct device *dev,
+		       const char *name)
+{
+	struct pwm_device *pwm;
+
+	memset(fl, 0, sizeof(*fl));
+	spin_lock_init(&fl->lock);
+	hrtimer_init(&fl->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	fl->timer.function = rk_fill_light_timer;
+	fl->name = name;
+
+	if (of_property_match_string(dev->of_node, "pwm-names", "fill-light") < 0)
+		return 0;
+
+	pwm = devm_of_pwm_get(dev, dev->of_node, "fill-light");
+	if (IS_ERR(pwm))
+		return dev_err_probe(dev, PTR_ERR(pwm), "no fill light pwm\n");
+	fl->pwm = pwm;
+	fl->cfg.brightness = 100;
+
+	mutex_lock(&fill_light_list_lock);
+	list_add_tail(&fl->node, &fill_light_list);
+	mutex_unlock(&fill_light_list_lock);
+
+	return devm_add_action_or_reset(dev, rk_fill_light_release, fl);
+}
+EXPORT_SYMBOL_GPL(rk_fill_light_init);
+
+static int rk_fill_light_show(struct seq_file *m, void *v)
+{
+	struct rk_fill_light_stats stats;
+	struct rk_fill_light_cfg cfg;
+	struct rk_fill_light *fl;
+
+	mutex_lock(&fill_light_list_lock);
+	list_for_each_entry(fl, &fill_light_list, node) {
+		rk_fill_light_get_cfg(fl, &cfg);
+		rk_fill_light_get_stats(fl, &stats);
+		seq_printf(m, "%s mode:%u brightness:%u%% frames:%u pulses:%u late:%u skipped:%u max late:%uus on:%ums\n",
+			   fl->name, cfg.mode, cfg.brightness, stats.frames,
+			   stats.pulses, stats.late, stats.skipped,
+			   stats.max_late_us, stats.on_ms);
+	}
+	mutex_unlock(&fill_light_list_lock);
+
+	return 0;
+}
+
+static int __init rk_fill_light_module_init(void)
+{
+	proc_create_single("rk_fill_light", 0444, NULL, rk_fill_light_show);
+	return 0;
+}
+
+static void __exit rk_fill_light_module_exit(void)
+{
+	remove_proc_entry("rk_fill_light", NULL);
+}
+
+module_init(rk_fill_light_module_init);
+module_exit(rk_fill_light_module_exit);
+
+MODULE_DESCRIPTION("Rockchip fill light strobed on the sensor exposure");
+MODULE_LICENSE("GPL");
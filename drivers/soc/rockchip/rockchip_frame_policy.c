@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Per frame drop and routing policy of the camera drivers. Which frame
+ * goes to the npu, which is dropped under load and which is kept for the
+ * recording used to cost a userspace wakeup per frame. rk_frame_policy()
+ * is an error injection point, so a kprobe bpf program can decide in the
+ * frame irq with bpf_override_return(); without one every frame passes.
+ */
+#include <linux/error-injection.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <soc/rockchip/rockchip_frame_policy.h>
+
+bool rk_frame_policy_enable;
+EXPORT_SYMBOL_GPL(rk_frame_policy_enable);
+module_param_named(enable, rk_frame_policy_enable, bool, 0644);
+MODULE_PARM_DESC(enable, "Call rk_frame_policy() for every cif and isp frame");
+
+static atomic64_t nr_frames[2];
+static atomic64_t nr_dropped[2];
+static atomic64_t nr_tagged[2];
+
+/* the hook, the return value is the verdict */
+noinline int rk_frame_policy(const struct rk_frame_info *info)
+{
+	return RK_FRAME_PASS;
+}
+ALLOW_ERROR_INJECTION(rk_frame_policy, ERRNO);
+
+int rk_frame_policy_run(struct rk_frame_info *info)
+{
+	u32 src = info->source ? RK_FRAME_SRC_ISP : RK_FRAME_SRC_CIF;
+	int verdict;
+
+	info->size = sizeof(*info);
+	verdict = rk_frame_policy(info);
+	/* an errno from fail_function or a broken program */
+	if (verdict < 0)
+		verdict = RK_FRAME_PASS;
+
+	atomic64_inc(&nr_frames[src]);
+	if (verdict & RK_FRAME_DROP)
+		atomic64_inc(&nr_dropped[src]);
+	else if (verdict & RK_FRAME_TAG_MASK)
+		atomic64_inc(&nr_tagged[src]);
+
+	return verdict;
+}
+EXPORT_SYMBOL_GPL(rk_frame_policy_run);
+
+static int rk_frame_policy_show(struct seq_file *m, void *v)
+{
+	static const char * const names[] = { "cif", "isp" };
+	int i;
+
+	seq_printf(m, "enable:%d\n", READ_ONCE(rk_frame_policy_enable));
+	for (i = 0; i < ARRAY_SIZE(names); i++)
+		seq_printf(m, "%s frames:%lld dropped:%lld tagged:%lld\n",
+			   names[i], atomic64_read(&nr_frames[i]),
+			   atomic64_read(&nr_dropped[i]),
+			   atomic64_read(&nr_tagged[i]));
+
+	return 0;
+}
+
+static int __init rk_frame_policy_init(void)
+{
+	proc_create_single("rk_frame_policy", 0444, NULL, rk_frame_policy_show);
+	return 0;
+}
+
+static void __exit rk_frame_policy_exit(void)
+{
+	remove_proc_entry("rk_frame_policy", NULL);
+}
+
+module_init(rk_frame_policy_init);
+module_exit(rk_frame_policy_exit);
+
+MODULE_DESCRIPTION("Rockchip per frame camera policy hook");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Scratch frame buffers shared by the camera drivers. A dummy buffer is only
+ * a dma write sink for frames nobody queued a buffer for, its content is
+ * never read, so vicap and isp can point their dma at the same memory
+ * instead of each keeping a full frame of its own. Buffers are rounded up to
+ * size classes, a request is served by the smallest pooled buffer that fits
+ * and the last user frees it.
+ */
+#include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
+#include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/soc/rockchip/rockchip_frame_pool.h>
+
+#define RK_FRAME_POOL_CLASS	SZ_1M
+
+struct rk_frame_pool_buf {
+	struct list_head list;
+	struct dma_buf *dbuf;
+	size_t size;
+	u32 users;
+};
+
+static LIST_HEAD(pool_list);
+static DEFINE_MUTEX(pool_lock);
+
+static char *heap_name = "linux,cma";
+module_param(heap_name, charp, 0444);
+MODULE_PARM_DESC(heap_name, "dma heap backing the pool");
+
+struct dma_buf *rk_frame_pool_get_scratch(size_t size)
+{
+	struct rk_frame_pool_buf *buf, *best = NULL;
+	struct dma_heap *heap;
+	struct dma_buf *dbuf;
+
+	if (!size)
+		return ERR_PTR(-EINVAL);
+	size = ALIGN(size, RK_FRAME_POOL_CLASS);
+
+	mutex_lock(&pool_lock);
+	list_for_each_entry(buf, &pool_list, list) {
+		if (buf->size >= size && (!best || buf->size < best->size))
+			best = buf;
+	}
+	if (best)
+		goto out;
+
+	heap = dma_heap_find(heap_name);
+	if (!heap) {
+		dbuf = ERR_PTR(-ENODEV);
+		goto unlock;
+	}
+	best = kzalloc(sizeof(*best), GFP_KERNEL);
+	if (!best) {
+		dma_heap_put(heap);
+		dbuf = ERR_PTR(-ENOMEM);
+		goto unlock;
+	}
+	dbuf = dma_heap_buffer_alloc(heap, size, O_RDWR, 0);
+	dma_heap_put(heap);
+	if (IS_ERR(dbuf)) {
+		kfree(best);
+		goto unlock;
+	}
+	best->dbuf = dbuf;
+	best->size = size;
+	list_add_tail(&best->list, &pool_list);
+	pr_info("%s: alloc %zu bytes from %s\n", __func__, size, heap_name);
+out:
+	best->users++;
+	get_dma_buf(best->dbuf);
+	dbuf = best->dbuf;
+unlock:
+	mutex_unlock(&pool_lock);
+	return dbuf;
+}
+EXPORT_SYMBOL(rk_frame_pool_get_scratch);
+
+void rk_frame_pool_put_scratch(struct dma_buf *dbuf)
+{
+	struct rk_frame_pool_buf *buf;
+
+	if (IS_ERR_OR_NULL(dbuf))
+		return;
+
+	mutex_lock(&pool_lock);
+	list_for_each_entry(buf, &pool_list, list) {
+		if (buf->dbuf != dbuf)
+			continue;
+		dma_buf_put(dbuf);
+		if (--buf->users == 0) {
+			list_del(&buf->list);
+			dma_buf_put(buf->dbuf);
+			kfree(buf);
+		}
+		break;
+	}
+	mutex_unlock(&pool_lock);
+}
+EXPORT_SYMBOL(rk_frame_pool_put_scratch);
+
+MODULE_DESCRIPTION("Rockchip shared camera frame pool");
+MODULE_LICENSE("GPL");
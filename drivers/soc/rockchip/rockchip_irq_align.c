@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Wakeup alignment of deferrable completions. On single core parts every
+ * device interrupt pulls the cpu out of deep idle, so completions that can
+ * wait (tx clean, housekeeping) are run on a wakeup that happens anyway:
+ * the next sensor sof reported by the camera drivers, or any timer
+ * interrupt inside the slack window of the work.
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <soc/rockchip/rockchip_irq_align.h>
+
+#define RK_IRQ_ALIGN_PENDING	0
+
+static bool enable = true;
+module_param(enable, bool, 0644);
+MODULE_PARM_DESC(enable, "align deferrable completions to anchor wakeups");
+
+static LIST_HEAD(align_list);
+static DEFINE_SPINLOCK(align_lock);
+
+static u64 cnt_anchor;
+static u64 cnt_anchored;
+static u64 cnt_timer;
+static ktime_t last_anchor;
+static s64 anchor_period_us;
+
+static void rk_irq_align_run(struct rk_irq_align_work *work)
+{
+	clear_bit(RK_IRQ_ALIGN_PENDING, &work->pending);
+	work->fn(work);
+}
+
+static enum hrtimer_restart rk_irq_align_timer(struct hrtimer *timer)
+{
+	struct rk_irq_align_work *work =
+		container_of(timer, struct rk_irq_align_work, timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&align_lock, flags);
+	if (list_empty(&work->node)) {
+		/* taken by an anchor */
+		spin_unlock_irqrestore(&align_lock, flags);
+		return HRTIMER_NORESTART;
+	}
+	list_del_init(&work->node);
+	cnt_timer++;
+	spin_unlock_irqrestore(&align_lock, flags);
+
+	rk_irq_align_run(work);
+	return HRTIMER_NORESTART;
+}
+
+void rk_irq_align_init_work(struct rk_irq_align_work *work,
+			    void (*fn)(struct rk_irq_align_work *work))
+{
+	hrtimer_init(&work->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	work->timer.function = rk_irq_align_timer;
+	INIT_LIST_HEAD(&work->node);
+	work->fn = fn;
+	work->pending = 0;
+}
+EXPORT_SYMBOL_GPL(rk_irq_align_init_work);
+
+/*
+ * run work within slack_ns. the timer may fire from a quarter of the
+ * slack on, that is the earliest point another timer can carry it.
+ * returns false if the facility is off, true once queued or if it
+ * already was.
+ */
+bool rk_irq_align_queue(struct rk_irq_align_work *work, u64 slack_ns)
+{
+	unsigned long flags;
+	u64 soft;
+
+	if (!READ_ONCE(enable) || !work->fn)
+		return false;
+	if (test_and_set_bit(RK_IRQ_ALIGN_PENDING, &work->pending))
+		return true;
+
+	soft = slack_ns >> 2;
+	spin_lock_irqsave(&align_lock, flags);
+	list_add_tail(&work->node, &align_list);
+	hrtimer_start_range_ns(&work->timer, ns_to_ktime(soft),
+			       slack_ns - soft, HRTIMER_MODE_REL);
+	spin_unlock_irqrestore(&align_lock, flags);
+
+	return true;
+}
+EXPORT_SYMBOL_GPL(rk_irq_align_queue);
+
+void rk_irq_align_cancel(struct rk_irq_align_work *work)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&align_lock, flags);
+	list_del_init(&work->node);
+	spin_unlock_irqrestore(&align_lock, flags);
+	hrtimer_cancel(&work->timer);
+	clear_bit(RK_IRQ_ALIGN_PENDING, &work->pending);
+}
+EXPORT_SYMBOL_GPL(rk_irq_align_cancel);
+
+/* a wakeup that happens anyway, run everything queued now */
+void rk_irq_align_anchor(void)
+{
+	struct rk_irq_align_work *work, *n;
+	unsigned long flags;
+	ktime_t now = ktime_get();
+	LIST_HEAD(run);
+
+	spin_lock_irqsave(&align_lock, flags);
+	cnt_anchor++;
+	if (last_anchor)
+		anchor_period_us = ktime_us_delta(now, last_anchor);
+	last_anchor = now;
+	list_for_each_entry_safe(work, n, &align_list, node) {
+		/* a timer callback already running takes the work itself */
+		if (hrtimer_try_to_cancel(&work->timer) < 0)
+			continue;
+		list_move_tail(&work->node, &run);
+		cnt_anchored++;
+	}
+	spin_unlock_irqrestore(&align_lock, flags);
+
+	while (!list_empty(&run)) {
+		work = list_first_entry(&run, struct rk_irq_align_work, node);
+		list_del_init(&work->node);
+		rk_irq_align_run(work);
+	}
+}
+EXPORT_SYMBOL_GPL(rk_irq_align_anchor);
+
+static int rk_irq_align_show(struct seq_file *m, void *v)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&align_lock, flags);
+	seq_printf(m, "enable:%d anchors:%llu period:%lldus\n",
+		   READ_ONCE(enable), cnt_anchor, anchor_period_us);
+	seq_printf(m, "run at anchor:%llu at timer:%llu\n",
+		   cnt_anchored, cnt_timer);
+	spin_unlock_irqrestore(&align_lock, flags);
+
+	return 0;
+}
+
+static int __init rk_irq_align_init(void)
+{
+	proc_create_single("rk_irq_align", 0444, NULL, rk_irq_align_show);
+	return 0;
+}
+
+static void __exit rk_irq_align_exit(void)
+{
+	remove_proc_entry("rk_irq_align", NULL);
+}
+
+module_init(rk_irq_align_init);
+module_exit(rk_irq_align_exit);
+
+MODULE_DESCRIPTION("Rockchip wakeup alignment of deferrable completions");
+MODULE_LICENSE("GPL");
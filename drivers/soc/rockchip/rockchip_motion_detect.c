@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Motion detection on the mipi luma grid of the camera drivers. Battery
+ * cameras sleep until something moves; running the detector on the luma
+ * means in the frame irq keeps the userspace ai stack asleep for every
+ * quiet frame and starts the recording with no userspace round trip.
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/pm_wakeup.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <soc/rockchip/rockchip_motion_detect.h>
+
+/* frames to learn the background before detecting */
+#define RK_MD_LEARN_FRAMES	4
+/* background follows a quiet zone by 1/16 per frame */
+#define RK_MD_REF_SHIFT		4
+
+static LIST_HEAD(md_list);
+static DEFINE_MUTEX(md_list_lock);
+static ATOMIC_NOTIFIER_HEAD(md_chain);
+
+int rk_md_register_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_register(&md_chain, nb);
+}
+EXPORT_SYMBOL_GPL(rk_md_register_notifier);
+
+int rk_md_unregister_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_unregister(&md_chain, nb);
+}
+EXPORT_SYMBOL_GPL(rk_md_unregister_notifier);
+
+void rk_md_init(struct rk_motion_detect *md, struct device *dev,
+		const char *name)
+{
+	memset(md, 0, sizeof(*md));
+	spin_lock_init(&md->lock);
+	md->dev = dev;
+	md->name = name;
+
+	mutex_lock(&md_list_lock);
+	list_add_tail(&md->node, &md_list);
+	mutex_unlock(&md_list_lock);
+}
+EXPORT_SYMBOL_GPL(rk_md_init);
+
+void rk_md_remove(struct rk_motion_detect *md)
+{
+	mutex_lock(&md_list_lock);
+	list_del(&md->node);
+	mutex_unlock(&md_list_lock);
+}
+EXPORT_SYMBOL_GPL(rk_md_remove);
+
+int rk_md_set_cfg(struct rk_motion_detect *md, const struct rk_md_cfg *cfg)
+{
+	unsigned long flags;
+
+	if (cfg->enable &&
+	    (!(cfg->zone_mask & GENMASK(RK_MD_ZONES_MAX - 1, 0)) ||
+	     !cfg->threshold || !cfg->min_zones ||
+	     cfg->min_zones > RK_MD_ZONES_MAX))
+		return -EINVAL;
+
+	spin_lock_irqsave(&md->lock, flags);
+	md->cfg = *cfg;
+	md->cfg.zone_mask &= GENMASK(RK_MD_ZONES_MAX - 1, 0);
+	memset(md->cfg.reserved, 0, sizeof(md->cfg.reserved));
+	/* learn the background again */
+	md->ref_frames = 0;
+	md->quiet = 0;
+	md->active = false;
+	spin_unlock_irqrestore(&md->lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rk_md_set_cfg);
+
+void rk_md_get_cfg(struct rk_motion_detect *md, struct rk_md_cfg *cfg)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&md->lock, flags);
+	*cfg = md->cfg;
+	spin_unlock_irqrestore(&md->lock, flags);
+}
+EXPORT_SYMBOL_GPL(rk_md_get_cfg);
+
+/* the luma means of one frame, from the frame irq */
+void rk_md_frame(struct rk_motion_detect *md, const u32 *mean, u32 num,
+		 u32 frame_id)
+{
+	struct rk_md_event event;
+	unsigned long flags;
+	u32 i, ref, diff, zones = 0;
+	s64 cur;
+	bool fire = false;
+
+	num = min_t(u32, num, RK_MD_ZONES_MAX);
+	spin_lock_irqsave(&md->lock, flags);
+	memcpy(md->mean, mean, num * sizeof(*mean));
+	md->nr_mean = num;
+	if (!md->cfg.enable) {
+		spin_unlock_irqrestore(&md->lock, flags);
+		return;
+	}
+
+	md->frames++;
+	for (i = 0; i < num; i++) {
+		if (!(md->cfg.zone_mask & BIT(i)))
+			continue;
+		cur = (s64)mean[i] << RK_MD_REF_SHIFT;
+		if (!md->ref_frames) {
+			md->ref[i] = cur;
+			continue;
+		}
+		ref = md->ref[i] >> RK_MD_REF_SHIFT;
+		diff = abs((s64)mean[i] - ref);
+		if (md->ref_frames >= RK_MD_LEARN_FRAMES &&
+		    (u64)diff * 100 > (u64)(ref + 1) * md->cfg.threshold) {
+			zones |= BIT(i);
+			continue;
+		}
+		md->ref[i] += (cur - md->ref[i]) >> RK_MD_REF_SHIFT;
+	}
+	if (md->ref_frames < RK_MD_LEARN_FRAMES) {
+		md->ref_frames++;
+		goto unlock;
+	}
+
+	md->last_zones = zones;
+	if (hweight32(zones) >= md->cfg.min_zones) {
+		md->quiet = 0;
+		if (!md->active) {
+			md->active = true;
+			md->events++;
+			fire = true;
+		}
+	} else if (md->active && ++md->quiet >= md->cfg.hold_frames) {
+		md->active = false;
+	}
+unlock:
+	spin_unlock_irqrestore(&md->lock, flags);
+
+	if (!fire)
+		return;
+
+	if (md->dev)
+		pm_wakeup_dev_event(md->dev, 0, true);
+	event.name = md->name;
+	event.frame_id = frame_id;
+	event.zones = zones;
+	atomic_notifier_call_chain(&md_chain, RK_MD_EVENT_MOTION, &event);
+}
+EXPORT_SYMBOL_GPL(rk_md_frame);
+
+/* the means and moving zones of the last frame, returns the number of means */
+u32 rk_md_get_luma(struct rk_motion_detect *md, u32 *mean, u32 num, u32 *zones)
+{
+	unsigned long flags;
+
+	/* never set up, the luma node is optional */
+	if (!md->name) {
+		*zones = 0;
+		return 0;
+	}
+
+	spin_lock_irqsave(&md->lock, flags);
+	num = min(num, md->nr_mean);
+	memcpy(mean, md->mean, num * sizeof(*mean));
+	*zones = md->cfg.enable ? md->last_zones : 0;
+	spin_unlock_irqrestore(&md->lock, flags);
+
+	return num;
+}
+EXPORT_SYMBOL_GPL(rk_md_get_luma);
+
+static int rk_md_show(struct seq_file *m, void *v)
+{
+	struct rk_motion_detect *md;
+	unsigned long flags;
+
+	mutex_lock(&md_list_lock);
+	list_for_each_entry(md, &md_list, node) {
+		spin_lock_irqsave(&md->lock, flags);
+		seq_printf(m, "%s enable:%d zones:0x%x threshold:%u%% min:%u hold:%u\n",
+			   md->name, md->cfg.enable, md->cfg.zone_mask,
+			   md->cfg.threshold, md->cfg.min_zones,
+			   md->cfg.hold_frames);
+		seq_printf(m, "\tframes:%llu events:%llu active:%d last zones:0x%x\n",
+			   md->frames, md->events, md->active, md->last_zones);
+		spin_unlock_irqrestore(&md->lock, flags);
+	}
+	mutex_unlock(&md_list_lock);
+
+	return 0;
+}
+
+static int __init rk_md_module_init(void)
+{
+	proc_create_single("rk_motion_detect", 0444, NULL, rk_md_show);
+	return 0;
+}
+
+static void __exit rk_md_module_exit(void)
+{
+	remove_proc_entry("rk_motion_detect", NULL);
+}
+
+module_init(rk_md_module_init);
+module_exit(rk_md_module_exit);
+
+MODULE_DESCRIPTION("Rockchip motion detection on the camera luma grid");
+MODULE_LICENSE("GPL");
@@ -6,6 +6,7 @@
 //#define DEBUG
 #include <linux/clk.h>
 #include <linux/cpufreq.h>
+#include <linux/crc32.h>
 #include <linux/devfreq.h>
 #include <linux/mfd/syscon.h>
 #include <linux/module.h>
@@ -14,9 +15,12 @@
 #include <linux/regulator/consumer.h>
 #include <linux/slab.h>
 #include <linux/soc/rockchip/pvtm.h>
+#include <linux/soc/rockchip/rk_vendor_storage.h>
 #include <linux/thermal.h>
 #include <linux/pm_opp.h>
 #include <linux/version.h>
+#include <linux/workqueue.h>
+#include <asm/system_info.h>
 #include <soc/rockchip/rockchip_opp_select.h>
 
 #include "../../clk/rockchip/clk.h"
@@ -83,6 +87,29 @@ struct otp_opp_info {
 static int pvtm_value[PVTM_CH_MAX][PVTM_SUB_CH_MAX];
 static int lkg_version;
 
+/*
+ * Measured pvtm values are kept in vendor storage and reused on the next
+ * boot if they come from the same chip and the same measuring config, so
+ * dvfs init need not force clock and supply and sample for milliseconds.
+ */
+#define PVTM_CACHE_MAGIC	0x4d545650	/* "PVTM" */
+#define PVTM_CACHE_RETRY	10
+#define PVTM_CACHE_RETRY_DELAY	msecs_to_jiffies(1000)
+
+struct pvtm_cache {
+	u32 magic;
+	u32 serial_low;
+	u32 serial_high;
+	/* crc of the measuring config, 0 for an empty entry */
+	u32 cfg[PVTM_CH_MAX][PVTM_SUB_CH_MAX];
+	int value[PVTM_CH_MAX][PVTM_SUB_CH_MAX];
+};
+
+static struct pvtm_cache pvtm_cache;
+static bool pvtm_cache_loaded;
+static int pvtm_cache_retry;
+static DEFINE_MUTEX(pvtm_cache_lock);
+
 /*
  * temp = temp * 10
  * conv = exp(-ln(1.2) / 5 * (temp - 23)) * 100
@@ -350,6 +377,133 @@ static int rockchip_parse_pvtm_config(struct device_node *np,
 	return 0;
 }
 
+static u32 rockchip_pvtm_cache_cfg(struct device_node *np)
+{
+	u32 cfg[6] = { 0 };
+
+	of_property_read_u32(np, "rockchip,pvtm-freq", &cfg[0]);
+	of_property_read_u32(np, "rockchip,pvtm-volt", &cfg[1]);
+	of_property_read_u32(np, "rockchip,pvtm-sample-time", &cfg[2]);
+	of_property_read_u32(np, "rockchip,pvtm-ref-temp", &cfg[3]);
+	of_property_read_u32(np, "rockchip,pvtm-offset", &cfg[4]);
+	cfg[5] = of_property_read_bool(np, "rockchip,pvtm-pvtpll");
+
+	return crc32(~0, cfg, sizeof(cfg)) ?: 1;
+}
+
+/* Called with pvtm_cache_lock held */
+static void rockchip_pvtm_cache_load(void)
+{
+	struct pvtm_cache *cache;
+	int i, j;
+
+	if (pvtm_cache_loaded || !is_rk_vendor_ready())
+		return;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return;
+	pvtm_cache_loaded = true;
+
+	if (rk_vendor_read(PVTM_CACHE_ID, cache, sizeof(*cache)) != sizeof(*cache) ||
+	    cache->magic != PVTM_CACHE_MAGIC ||
+	    cache->serial_low != system_serial_low ||
+	    cache->serial_high != system_serial_high) {
+		memset(cache, 0, sizeof(*cache));
+		cache->magic = PVTM_CACHE_MAGIC;
+		cache->serial_low = system_serial_low;
+		cache->serial_high = system_serial_high;
+	}
+
+	/* Values measured before vendor storage came up are newer */
+	for (i = 0; i < PVTM_CH_MAX; i++) {
+		for (j = 0; j < PVTM_SUB_CH_MAX; j++) {
+			if (!pvtm_cache.cfg[i][j])
+				continue;
+			cache->cfg[i][j] = pvtm_cache.cfg[i][j];
+			cache->value[i][j] = pvtm_cache.value[i][j];
+		}
+	}
+
+	pvtm_cache = *cache;
+	kfree(cache);
+}
+
+/* Writing vendor storage may wait for its device, so never do it inline */
+static void rockchip_pvtm_cache_store(struct work_struct *work)
+{
+	struct pvtm_cache *cache;
+
+	mutex_lock(&pvtm_cache_lock);
+	rockchip_pvtm_cache_load();
+	if (!pvtm_cache_loaded) {
+		if (pvtm_cache_retry++ < PVTM_CACHE_RETRY)
+			schedule_delayed_work(to_delayed_work(work),
+					      PVTM_CACHE_RETRY_DELAY);
+		mutex_unlock(&pvtm_cache_lock);
+		return;
+	}
+	cache = kmemdup(&pvtm_cache, sizeof(pvtm_cache), GFP_KERNEL);
+	mutex_unlock(&pvtm_cache_lock);
+	if (!cache)
+		return;
+
+	rk_vendor_write(PVTM_CACHE_ID, cache, sizeof(*cache));
+	kfree(cache);
+}
+
+static DECLARE_DELAYED_WORK(pvtm_cache_work, rockchip_pvtm_cache_store);
+
+static bool rockchip_pvtm_cache_usable(unsigned int *ch)
+{
+	/* without a chip id there is no telling whose values these are */
+	if (!system_serial_low && !system_serial_high)
+		return false;
+
+	return ch[0] < PVTM_CH_MAX && ch[1] < PVTM_SUB_CH_MAX;
+}
+
+static int rockchip_pvtm_cache_get(struct device_node *np, unsigned int *ch,
+				   int *value)
+{
+	u32 cfg;
+	int ret = -ENOENT;
+
+	if (!rockchip_pvtm_cache_usable(ch))
+		return -ENODEV;
+
+	cfg = rockchip_pvtm_cache_cfg(np);
+	mutex_lock(&pvtm_cache_lock);
+	rockchip_pvtm_cache_load();
+	if (pvtm_cache.cfg[ch[0]][ch[1]] == cfg &&
+	    pvtm_cache.value[ch[0]][ch[1]] > 0) {
+		*value = pvtm_cache.value[ch[0]][ch[1]];
+		ret = 0;
+	}
+	mutex_unlock(&pvtm_cache_lock);
+
+	return ret;
+}
+
+static void rockchip_pvtm_cache_put(struct device_node *np, unsigned int *ch,
+				    int value)
+{
+	u32 cfg;
+
+	if (value <= 0 || !rockchip_pvtm_cache_usable(ch))
+		return;
+
+	cfg = rockchip_pvtm_cache_cfg(np);
+	mutex_lock(&pvtm_cache_lock);
+	rockchip_pvtm_cache_load();
+	pvtm_cache.cfg[ch[0]][ch[1]] = cfg;
+	pvtm_cache.value[ch[0]][ch[1]] = value;
+	pvtm_cache_retry = 0;
+	mutex_unlock(&pvtm_cache_lock);
+
+	schedule_delayed_work(&pvtm_cache_work, 0);
+}
+
 static int rockchip_get_pvtm_specific_value(struct device *dev,
 					    struct device_node *np,
 					    struct clk *clk,
@@ -1056,6 +1210,11 @@ static int rockchip_get_pvtm_pvtpll(struct device *dev, struct device_node *np,
 	if (ret)
 		goto out;
 
+	if (!rockchip_pvtm_cache_get(np, pvtm->ch, &pvtm_value)) {
+		dev_info(dev, "pvtm=%d, from vendor storage\n", pvtm_value);
+		goto out;
+	}
+
 	clk = clk_get(dev, NULL);
 	if (IS_ERR_OR_NULL(clk)) {
 		dev_warn(dev, "Failed to get clk\n");
@@ -1098,6 +1257,7 @@ static int rockchip_get_pvtm_pvtpll(struct device *dev, struct device_node *np,
 	pvtm_value += diff_value;
 
 	dev_info(dev, "pvtm=%d\n", pvtm_value);
+	rockchip_pvtm_cache_put(np, pvtm->ch, pvtm_value);
 
 resetore_volt:
 	regulator_set_voltage(reg, old_volt, INT_MAX);
@@ -1138,6 +1298,12 @@ static int rockchip_get_pvtm(struct device *dev, struct device_node *np,
 		return pvtm_value[ch[0]][ch[1]];
 	}
 
+	if (!rockchip_pvtm_cache_get(np, ch, &pvtm)) {
+		pvtm_value[ch[0]][ch[1]] = pvtm;
+		dev_info(dev, "pvtm = %d, from vendor storage\n", pvtm);
+		return pvtm;
+	}
+
 	clk = clk_get(dev, NULL);
 	if (IS_ERR_OR_NULL(clk)) {
 		dev_warn(dev, "Failed to get clk\n");
@@ -1151,7 +1317,8 @@ static int rockchip_get_pvtm(struct device *dev, struct device_node *np,
 		return PTR_ERR_OR_ZERO(reg);
 	}
 
-	rockchip_get_pvtm_specific_value(dev, np, clk, reg, &pvtm);
+	if (!rockchip_get_pvtm_specific_value(dev, np, clk, reg, &pvtm))
+		rockchip_pvtm_cache_put(np, ch, pvtm);
 
 	regulator_put(reg);
 	clk_put(clk);
@@ -3,16 +3,33 @@
  * Copyright (C) 2022 Rockchip Electronics Co., Ltd.
  */
 #include <linux/kernel.h>
+#include <linux/kthread.h>
 #include <linux/proc_fs.h>
+#include <linux/sched/task.h>
 #include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <uapi/linux/sched/types.h>
 #include <soc/rockchip/rockchip_performance.h>
 #include <../../kernel/sched/sched.h>
 
 static int perf_level = CONFIG_ROCKCHIP_PERFORMANCE_LEVEL;
 static cpumask_var_t cpul_mask, cpub_mask;
+static unsigned long cpul_capacity;
 static bool perf_init_done;
 static DEFINE_MUTEX(update_mutex);
 
+/*
+ * media worker threads registered by the drivers, they run SCHED_FIFO so
+ * they follow the rt uclamp minimum and rt cpu selection of the level,
+ * and are bound to the little or big cluster at the low or high level.
+ */
+struct perf_task {
+	struct list_head node;
+	struct task_struct *task;
+};
+
+static LIST_HEAD(perf_task_list);
+
 #ifdef CONFIG_UCLAMP_TASK
 static inline void set_uclamp_util_min_rt(unsigned int util)
 {
@@ -66,10 +83,56 @@ static void update_perf_level_locked(int level)
 	set_uclamp_util_min_rt(uclamp_util_min_rt);
 }
 
+/* capacity the task asked for with a uclamp minimum, 0 if none */
+static unsigned int perf_task_capacity(struct task_struct *p)
+{
+#ifdef CONFIG_UCLAMP_TASK
+	if (p->uclamp_req[UCLAMP_MIN].user_defined)
+		return uclamp_eff_value(p, UCLAMP_MIN);
+#endif
+	return 0;
+}
+
+/*
+ * an explicit capacity request wins over the global level: a request the
+ * little cores can serve keeps the task there, a larger one needs big.
+ */
+static int perf_task_level(struct task_struct *p)
+{
+	unsigned int cap = perf_task_capacity(p);
+
+	if (!cap)
+		return perf_level;
+
+	return cap > cpul_capacity ? ROCKCHIP_PERFORMANCE_HIGH :
+				     ROCKCHIP_PERFORMANCE_LOW;
+}
+
+static void perf_task_set_affinity(struct task_struct *task)
+{
+	const struct cpumask *mask = cpu_possible_mask;
+	int level = perf_task_level(task);
+
+	if (static_branch_unlikely(&sched_asym_cpucapacity)) {
+		if (level == ROCKCHIP_PERFORMANCE_LOW)
+			mask = cpul_mask;
+		else if (level == ROCKCHIP_PERFORMANCE_HIGH)
+			mask = cpub_mask;
+	}
+	if (cpumask_empty(mask))
+		mask = cpu_possible_mask;
+
+	set_cpus_allowed_ptr(task, mask);
+}
+
 static void update_perf_level(int level)
 {
+	struct perf_task *pt;
+
 	mutex_lock(&update_mutex);
 	update_perf_level_locked(level);
+	list_for_each_entry(pt, &perf_task_list, node)
+		perf_task_set_affinity(pt->task);
 	mutex_unlock(&update_mutex);
 }
 
@@ -106,10 +169,12 @@ static __init int rockchip_perf_init(void)
 		return -ENOMEM;
 
 	for_each_possible_cpu(cpu) {
-		if (arch_scale_cpu_capacity(cpu) > cpub_min_cap)
+		if (arch_scale_cpu_capacity(cpu) > cpub_min_cap) {
 			cpumask_set_cpu(cpu, cpub_mask);
-		else
+		} else {
 			cpumask_set_cpu(cpu, cpul_mask);
+			cpul_capacity = max(cpul_capacity, arch_scale_cpu_capacity(cpu));
+		}
 	}
 
 	update_perf_level(perf_level);
@@ -125,6 +190,126 @@ int rockchip_perf_get_level(void)
 	return perf_level;
 }
 
+int rockchip_perf_register_task(struct task_struct *task)
+{
+	struct perf_task *pt;
+
+	if (IS_ERR_OR_NULL(task))
+		return -EINVAL;
+
+	pt = kzalloc(sizeof(*pt), GFP_KERNEL);
+	if (!pt)
+		return -ENOMEM;
+
+	get_task_struct(task);
+	pt->task = task;
+	sched_set_fifo_low(task);
+
+	mutex_lock(&update_mutex);
+	list_add_tail(&pt->node, &perf_task_list);
+	if (perf_init_done)
+		perf_task_set_affinity(task);
+	mutex_unlock(&update_mutex);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rockchip_perf_register_task);
+
+void rockchip_perf_unregister_task(struct task_struct *task)
+{
+	struct perf_task *pt, *found = NULL;
+
+	mutex_lock(&update_mutex);
+	list_for_each_entry(pt, &perf_task_list, node) {
+		if (pt->task == task) {
+			list_del(&pt->node);
+			found = pt;
+			break;
+		}
+	}
+	mutex_unlock(&update_mutex);
+
+	if (!found)
+		return;
+
+	set_cpus_allowed_ptr(task, cpu_possible_mask);
+	sched_set_normal(task, 0);
+	put_task_struct(task);
+	kfree(found);
+}
+EXPORT_SYMBOL_GPL(rockchip_perf_unregister_task);
+
+/*
+ * capacity request of a kernel thread in capacity units, 0 drops it. the
+ * same thing userspace does with sched_setattr(SCHED_FLAG_UTIL_CLAMP_MIN),
+ * both raise the frequency and, on big.LITTLE, pick the cluster.
+ */
+int rockchip_perf_set_task_capacity(struct task_struct *task, unsigned int capacity)
+{
+	struct sched_attr attr = {
+		.sched_flags = SCHED_FLAG_KEEP_ALL | SCHED_FLAG_UTIL_CLAMP_MIN,
+		.sched_util_min = capacity ? min_t(unsigned int, capacity,
+						   SCHED_CAPACITY_SCALE) : -1,
+	};
+	struct perf_task *pt;
+	int ret;
+
+	if (IS_ERR_OR_NULL(task))
+		return -EINVAL;
+
+	/* keep policy and priority, only the clamp changes */
+	attr.sched_policy = task->policy;
+	attr.sched_priority = task->rt_priority;
+	attr.sched_nice = task_nice(task);
+	if (task->sched_reset_on_fork)
+		attr.sched_flags |= SCHED_FLAG_RESET_ON_FORK;
+
+	ret = sched_setattr_nocheck(task, &attr);
+	if (ret)
+		return ret;
+
+	mutex_lock(&update_mutex);
+	list_for_each_entry(pt, &perf_task_list, node) {
+		if (pt->task == task && perf_init_done) {
+			perf_task_set_affinity(task);
+			break;
+		}
+	}
+	mutex_unlock(&update_mutex);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rockchip_perf_set_task_capacity);
+
+struct kthread_worker *rockchip_perf_create_worker(const char *name)
+{
+	struct kthread_worker *worker;
+	int ret;
+
+	worker = kthread_create_worker(0, "%s", name);
+	if (IS_ERR(worker))
+		return worker;
+
+	ret = rockchip_perf_register_task(worker->task);
+	if (ret) {
+		kthread_destroy_worker(worker);
+		return ERR_PTR(ret);
+	}
+
+	return worker;
+}
+EXPORT_SYMBOL_GPL(rockchip_perf_create_worker);
+
+void rockchip_perf_destroy_worker(struct kthread_worker *worker)
+{
+	if (IS_ERR_OR_NULL(worker))
+		return;
+
+	rockchip_perf_unregister_task(worker->task);
+	kthread_destroy_worker(worker);
+}
+EXPORT_SYMBOL_GPL(rockchip_perf_destroy_worker);
+
 struct cpumask *rockchip_perf_get_cpul_mask(void)
 {
 	if (static_branch_unlikely(&sched_asym_cpucapacity))
@@ -142,19 +327,24 @@ struct cpumask *rockchip_perf_get_cpub_mask(void)
 }
 
 #ifdef CONFIG_SMP
-int rockchip_perf_select_rt_cpu(int prev_cpu, struct cpumask *lowest_mask)
+int rockchip_perf_select_rt_cpu(struct task_struct *p, int prev_cpu,
+				struct cpumask *lowest_mask)
 {
 	struct cpumask target_mask;
 	int cpu = nr_cpu_ids;
+	int level;
 
 	if (!perf_init_done)
 		return prev_cpu;
 
 	if (static_branch_unlikely(&sched_asym_cpucapacity)) {
-		if (perf_level == 0)
+		level = perf_task_level(p);
+		if (level == ROCKCHIP_PERFORMANCE_LOW)
 			cpumask_and(&target_mask, lowest_mask, cpul_mask);
-		if (perf_level == 2)
+		else if (level == ROCKCHIP_PERFORMANCE_HIGH)
 			cpumask_and(&target_mask, lowest_mask, cpub_mask);
+		else
+			return prev_cpu;
 
 		if (cpumask_test_cpu(prev_cpu, &target_mask))
 			return prev_cpu;
@@ -168,15 +358,18 @@ int rockchip_perf_select_rt_cpu(int prev_cpu, struct cpumask *lowest_mask)
 	return prev_cpu;
 }
 
-bool rockchip_perf_misfit_rt(int cpu)
+bool rockchip_perf_misfit_rt(struct task_struct *p, int cpu)
 {
+	int level;
+
 	if (!perf_init_done)
 		return false;
 
 	if (static_branch_unlikely(&sched_asym_cpucapacity)) {
-		if ((perf_level == 0) && cpumask_test_cpu(cpu, cpub_mask))
+		level = perf_task_level(p);
+		if ((level == ROCKCHIP_PERFORMANCE_LOW) && cpumask_test_cpu(cpu, cpub_mask))
 			return true;
-		if ((perf_level == 2) && cpumask_test_cpu(cpu, cpul_mask))
+		if ((level == ROCKCHIP_PERFORMANCE_HIGH) && cpumask_test_cpu(cpu, cpul_mask))
 			return true;
 	}
 
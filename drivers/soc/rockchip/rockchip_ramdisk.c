@@ -8,15 +8,19 @@
 
 #include <linux/backing-dev.h>
 #include <linux/dax.h>
+#include <linux/highmem.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
 #include <linux/pfn_t.h>
 #include <linux/platform_device.h>
+#include <linux/soc/rockchip/rockchip_decompress.h>
 #include <linux/uio.h>
 
 #define PAGE_SECTORS_SHIFT	(PAGE_SHIFT - SECTOR_SHIFT)
 #define PAGE_SECTORS		(1 << PAGE_SECTORS_SHIFT)
 
+#define RD_DECOM_TIMEOUT_MS	5000
+
 struct rd_device {
 	struct request_queue	*rd_queue;
 	struct gendisk		*rd_disk;
@@ -32,106 +36,74 @@ struct rd_device {
 static int rd_major;
 
 /*
- * Look up and return a rd's page for a given sector.
+ * rd may be the output of hw decompress still running, wait for the
+ * range to be written instead of the whole image.
  */
-static struct page *rd_lookup_page(struct rd_device *rd, sector_t sector)
+static int rd_wait_decom(struct rd_device *rd, sector_t sector, size_t len)
 {
-	pgoff_t idx;
-	struct page *page;
-
-	idx = sector >> PAGE_SECTORS_SHIFT; /* sector to page index */
-	page = phys_to_page(rd->mem_addr + (idx << PAGE_SHIFT));
-	BUG_ON(!page);
-
-	return page;
-}
+	int ret;
 
-/*
- * Copy n bytes from src to the rd starting at sector. Does not sleep.
- */
-static void copy_to_rd(struct rd_device *rd, const void *src,
-		       sector_t sector, size_t n)
-{
-	struct page *page;
-	void *dst;
-	unsigned int offset = (sector & (PAGE_SECTORS - 1)) << SECTOR_SHIFT;
-	size_t copy;
-
-	copy = min_t(size_t, n, PAGE_SIZE - offset);
-	page = rd_lookup_page(rd, sector);
-	BUG_ON(!page);
-
-	dst = kmap_atomic(page);
-	memcpy(dst + offset, src, copy);
-	kunmap_atomic(dst);
-
-	if (copy < n) {
-		src += copy;
-		sector += copy >> SECTOR_SHIFT;
-		copy = n - copy;
-		page = rd_lookup_page(rd, sector);
-		BUG_ON(!page);
-
-		dst = kmap_atomic(page);
-		memcpy(dst, src, copy);
-		kunmap_atomic(dst);
-	}
+	ret = rk_decom_wait_range(rd->mem_addr + ((phys_addr_t)sector << SECTOR_SHIFT),
+				  len, RD_DECOM_TIMEOUT_MS);
+	if (ret)
+		dev_err_ratelimited(rd->dev, "wait decom sector:%llu len:%zu ret:%d\n",
+				    (unsigned long long)sector, len, ret);
+	return ret;
 }
 
-/*
- * Copy n bytes to dst from the rd starting at sector. Does not sleep.
- */
-static void copy_from_rd(void *dst, struct rd_device *rd,
-			 sector_t sector, size_t n)
+static void rd_flush_dcache(struct page *page, unsigned int off,
+			    unsigned int len)
 {
-	struct page *page;
-	void *src;
-	unsigned int offset = (sector & (PAGE_SECTORS - 1)) << SECTOR_SHIFT;
-	size_t copy;
-
-	copy = min_t(size_t, n, PAGE_SIZE - offset);
-	page = rd_lookup_page(rd, sector);
-	if (page) {
-		src = kmap_atomic(page);
-		memcpy(dst, src + offset, copy);
-		kunmap_atomic(src);
-	} else {
-		memset(dst, 0, copy);
-	}
+	unsigned int i;
 
-	if (copy < n) {
-		dst += copy;
-		sector += copy >> SECTOR_SHIFT;
-		copy = n - copy;
-		page = rd_lookup_page(rd, sector);
-		if (page) {
-			src = kmap_atomic(page);
-			memcpy(dst, src, copy);
-			kunmap_atomic(src);
-		} else {
-			memset(dst, 0, copy);
-		}
-	}
+	for (i = off >> PAGE_SHIFT; i <= (off + len - 1) >> PAGE_SHIFT; i++)
+		flush_dcache_page(nth_page(page, i));
 }
 
 /*
- * Process a single bvec of a bio.
+ * Process a (possibly multi-page) bvec of a bio. The reservation is one
+ * linear mapped range, so lowmem bvecs are copied with a single memcpy,
+ * only highmem pages still need to be mapped one at a time.
  */
 static int rd_do_bvec(struct rd_device *rd, struct page *page,
 		      unsigned int len, unsigned int off, unsigned int op,
 		      sector_t sector)
 {
+	void *rd_mem = rd->mem_kaddr + ((size_t)sector << SECTOR_SHIFT);
+	bool write = op_is_write(op);
+	unsigned int copy;
 	void *mem;
 
-	mem = kmap_atomic(page);
-	if (!op_is_write(op)) {
-		copy_from_rd(mem + off, rd, sector, len);
-		flush_dcache_page(page);
-	} else {
-		flush_dcache_page(page);
-		copy_to_rd(rd, mem + off, sector, len);
+	if (!PageHighMem(page)) {
+		mem = page_address(page) + off;
+		if (!write) {
+			memcpy(mem, rd_mem, len);
+			rd_flush_dcache(page, off, len);
+		} else {
+			rd_flush_dcache(page, off, len);
+			memcpy(rd_mem, mem, len);
+		}
+		return 0;
+	}
+
+	page = nth_page(page, off >> PAGE_SHIFT);
+	off &= ~PAGE_MASK;
+	while (len) {
+		copy = min_t(unsigned int, len, PAGE_SIZE - off);
+		mem = kmap_atomic(page);
+		if (!write) {
+			memcpy(mem + off, rd_mem, copy);
+			flush_dcache_page(page);
+		} else {
+			flush_dcache_page(page);
+			memcpy(rd_mem, mem + off, copy);
+		}
+		kunmap_atomic(mem);
+		rd_mem += copy;
+		len -= copy;
+		off = 0;
+		page = nth_page(page, 1);
 	}
-	kunmap_atomic(mem);
 
 	return 0;
 }
@@ -146,8 +118,10 @@ static blk_qc_t rd_submit_bio(struct bio *bio)
 	sector = bio->bi_iter.bi_sector;
 	if (bio_end_sector(bio) > get_capacity(bio->bi_disk))
 		goto io_error;
+	if (rd_wait_decom(rd, sector, bio->bi_iter.bi_size))
+		goto io_error;
 
-	bio_for_each_segment(bvec, bio, iter) {
+	bio_for_each_bvec(bvec, bio, iter) {
 		unsigned int len = bvec.bv_len;
 		int err;
 
@@ -177,7 +151,9 @@ static int rd_rw_page(struct block_device *bdev, sector_t sector,
 
 	if (PageTransHuge(page))
 		return -ENOTSUPP;
-	err = rd_do_bvec(rd, page, PAGE_SIZE, 0, op, sector);
+	err = rd_wait_decom(rd, sector, PAGE_SIZE);
+	if (!err)
+		err = rd_do_bvec(rd, page, PAGE_SIZE, 0, op, sector);
 	page_endio(page, op_is_write(op), err);
 	return err;
 }
@@ -194,14 +170,24 @@ static long rd_dax_direct_access(struct dax_device *dax_dev, pgoff_t pgoff,
 	struct rd_device *rd = dax_get_private(dax_dev);
 
 	phys_addr_t offset = PFN_PHYS(pgoff);
-	size_t max_nr_pages = rd->mem_pages - pgoff;
+	long max_nr_pages = rd->mem_pages - pgoff;
+
+	/*
+	 * The whole reservation is physically contiguous, so any request
+	 * is served in one go, including the PMD_SIZE ranges the fs dax
+	 * fault path asks for when the pfn is suitably aligned.
+	 */
+	if (nr_pages > max_nr_pages)
+		nr_pages = max_nr_pages;
+	if (rd_wait_decom(rd, offset >> SECTOR_SHIFT, PFN_PHYS(nr_pages)))
+		return -EIO;
 
 	if (kaddr)
 		*kaddr = rd->mem_kaddr + offset;
 	if (pfn)
 		*pfn = phys_to_pfn_t(rd->mem_addr + offset, PFN_DEV | PFN_MAP);
 
-	return nr_pages > max_nr_pages ? max_nr_pages : nr_pages;
+	return nr_pages;
 }
 
 static bool rd_dax_supported(struct dax_device *dax_dev,
@@ -276,6 +262,15 @@ static int rd_init(struct rd_device *rd, int major, int minor)
 
 	rd->mem_kaddr = phys_to_virt(rd->mem_addr);
 	rd->mem_pages = PHYS_PFN(rd->mem_size);
+	/*
+	 * Huge dax mappings need the pfn aligned to PMD_SIZE, which only
+	 * holds when the reservation itself starts on a PMD boundary.
+	 */
+	if (!IS_ALIGNED(rd->mem_addr, PMD_SIZE))
+		dev_warn(rd->dev, "base %pa not PMD aligned, no huge dax mappings\n",
+			 &rd->mem_addr);
+	else
+		blk_queue_io_opt(rd->rd_queue, PMD_SIZE);
 	rd->dax_dev = alloc_dax(rd, disk->disk_name, &rd_dax_ops, DAXDEV_F_SYNC);
 	if (IS_ERR(rd->dax_dev)) {
 		ret = PTR_ERR(rd->dax_dev);
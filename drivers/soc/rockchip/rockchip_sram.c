@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Arbitration of the on-chip srams between the media blocks. The encoder
+ * rcb, the isp line buffers and the audio vad ring each save ddr traffic
+ * per byte of sram they get, by different amounts. Clients register what
+ * they want with a priority, and a request leaves the sram wanted by the
+ * registered higher priority clients untouched, so the sram goes where it
+ * saves the most bandwidth whatever the probe order.
+ */
+#include <linux/genalloc.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <soc/rockchip/rockchip_sram.h>
+
+struct rk_sram_area {
+	struct list_head node;
+	phys_addr_t start;
+	size_t size;
+	struct gen_pool *pool;
+	struct list_head clients;
+};
+
+static LIST_HEAD(sram_areas);
+static DEFINE_MUTEX(sram_lock);
+
+static struct rk_sram_area *rk_sram_area_get(const struct resource *res)
+{
+	struct rk_sram_area *area;
+	phys_addr_t start = round_up(res->start, PAGE_SIZE);
+	phys_addr_t end = round_down(res->start + resource_size(res), PAGE_SIZE);
+
+	if (end <= start)
+		return ERR_PTR(-ENOMEM);
+
+	list_for_each_entry(area, &sram_areas, node) {
+		if (area->start == start)
+			return area;
+	}
+
+	area = kzalloc(sizeof(*area), GFP_KERNEL);
+	if (!area)
+		return ERR_PTR(-ENOMEM);
+
+	area->pool = gen_pool_create(PAGE_SHIFT, -1);
+	if (!area->pool) {
+		kfree(area);
+		return ERR_PTR(-ENOMEM);
+	}
+	if (gen_pool_add(area->pool, start, end - start, -1)) {
+		gen_pool_destroy(area->pool);
+		kfree(area);
+		return ERR_PTR(-ENOMEM);
+	}
+	area->start = start;
+	area->size = end - start;
+	INIT_LIST_HEAD(&area->clients);
+	list_add_tail(&area->node, &sram_areas);
+
+	return area;
+}
+
+int rk_sram_register(struct rk_sram_client *client, const struct resource *res)
+{
+	struct rk_sram_area *area;
+	struct rk_sram_client *pos;
+
+	mutex_lock(&sram_lock);
+	area = rk_sram_area_get(res);
+	if (IS_ERR(area)) {
+		mutex_unlock(&sram_lock);
+		return PTR_ERR(area);
+	}
+
+	client->area = area;
+	client->base = area->start;
+	client->size = area->size;
+	client->granted = 0;
+	client->want = PAGE_ALIGN(client->want);
+	/* by priority, the highest first */
+	list_for_each_entry(pos, &area->clients, node) {
+		if (pos->prio < client->prio)
+			break;
+	}
+	list_add_tail(&client->node, &pos->node);
+	mutex_unlock(&sram_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rk_sram_register);
+
+void rk_sram_unregister(struct rk_sram_client *client)
+{
+	if (!client->area)
+		return;
+
+	rk_sram_release(client);
+	mutex_lock(&sram_lock);
+	list_del(&client->node);
+	client->area = NULL;
+	mutex_unlock(&sram_lock);
+}
+EXPORT_SYMBOL_GPL(rk_sram_unregister);
+
+/* grant client what the higher priority clients leave, 0 is a ddr fallback */
+int rk_sram_request(struct rk_sram_client *client)
+{
+	struct rk_sram_area *area = client->area;
+	struct rk_sram_client *pos;
+	size_t avail, size;
+	unsigned long addr = 0;
+
+	if (!area)
+		return -EINVAL;
+
+	mutex_lock(&sram_lock);
+	if (client->granted)
+		goto out;
+
+	avail = gen_pool_avail(area->pool);
+	list_for_each_entry(pos, &area->clients, node) {
+		if (pos == client || pos->prio <= client->prio)
+			break;
+		/* yet to ask for its sram */
+		if (!pos->granted)
+			avail -= min(avail, pos->want);
+	}
+
+	size = min(client->want, avail);
+	/* the largest piece that is free in one go */
+	for (; size; size -= PAGE_SIZE) {
+		addr = gen_pool_alloc(area->pool, size);
+		if (addr)
+			break;
+	}
+
+	client->requests++;
+	if (size == client->want)
+		client->full_grants++;
+	client->phys = addr;
+	client->granted = size;
+out:
+	mutex_unlock(&sram_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rk_sram_request);
+
+void rk_sram_release(struct rk_sram_client *client)
+{
+	struct rk_sram_area *area = client->area;
+
+	mutex_lock(&sram_lock);
+	if (area && client->granted)
+		gen_pool_free(area->pool, client->phys, client->granted);
+	client->granted = 0;
+	mutex_unlock(&sram_lock);
+}
+EXPORT_SYMBOL_GPL(rk_sram_release);
+
+static int rk_sram_show(struct seq_file *m, void *v)
+{
+	struct rk_sram_area *area;
+	struct rk_sram_client *client;
+
+	mutex_lock(&sram_lock);
+	list_for_each_entry(area, &sram_areas, node) {
+		seq_printf(m, "sram %pa size:%zuKB free:%zuKB\n", &area->start,
+			   area->size >> 10, gen_pool_avail(area->pool) >> 10);
+		list_for_each_entry(client, &area->clients, node)
+			seq_printf(m, "\t%-16s prio:%d want:%zuKB sram:%zuKB ddr:%zuKB requests:%llu full:%llu\n",
+				   client->name, client->prio,
+				   client->want >> 10, client->granted >> 10,
+				   (client->want - client->granted) >> 10,
+				   client->requests, client->full_grants);
+	}
+	mutex_unlock(&sram_lock);
+
+	return 0;
+}
+
+static int __init rk_sram_init(void)
+{
+	proc_create_single("rk_sram", 0444, NULL, rk_sram_show);
+	return 0;
+}
+
+static void __exit rk_sram_exit(void)
+{
+	remove_proc_entry("rk_sram", NULL);
+}
+
+subsys_initcall(rk_sram_init);
+module_exit(rk_sram_exit);
+
+MODULE_DESCRIPTION("Rockchip on-chip sram arbitration");
+MODULE_LICENSE("GPL");
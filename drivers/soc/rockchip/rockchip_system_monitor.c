@@ -88,10 +88,18 @@ static DEFINE_MUTEX(cpu_on_off_mutex);
 static DECLARE_RWSEM(mdev_list_sem);
 
 static LIST_HEAD(video_info_list);
+static LIST_HEAD(video_load_list);
 static LIST_HEAD(monitor_dev_list);
 static struct system_monitor *system_monitor;
 static atomic_t monitor_in_suspend;
 
+/* cost of one pixel in percent per load type, "rockchip,video-load-cost" */
+static unsigned int video_load_cost[ROCKCHIP_VIDEO_LOAD_MAX] = { 100, 100, 150 };
+/* sum of all video loads, weighted Mpixel per second */
+static unsigned int video_load_total;
+
+static void rockchip_system_monitor_video_load_apply(void);
+
 static BLOCKING_NOTIFIER_HEAD(system_monitor_notifier_list);
 static BLOCKING_NOTIFIER_HEAD(system_status_notifier_list);
 
@@ -293,6 +301,43 @@ static void rockchip_del_video_info(struct video_info *video_info)
 	}
 }
 
+static unsigned int rockchip_video_load_cost(unsigned int type,
+					     unsigned int width,
+					     unsigned int height,
+					     unsigned int fps,
+					     unsigned int hdr, bool hevc)
+{
+	u64 cost;
+
+	if (type >= ROCKCHIP_VIDEO_LOAD_MAX)
+		return 0;
+
+	cost = (u64)width * height * (fps ? fps : 30) * max(hdr, 1U) *
+	       video_load_cost[type] * (hevc ? 125 : 100);
+
+	return div_u64(cost, 100 * 100 * 1000000);
+}
+
+/* must be called with video_info_mutex held */
+static void rockchip_update_video_load(void)
+{
+	struct rockchip_video_load *load;
+	struct video_info *video_info;
+	unsigned int total = 0;
+
+	list_for_each_entry(video_info, &video_info_list, node)
+		total += rockchip_video_load_cost(ROCKCHIP_VIDEO_LOAD_DEC,
+						  video_info->width,
+						  video_info->height,
+						  video_info->videoFramerate,
+						  0, video_info->ishevc);
+	list_for_each_entry(load, &video_load_list, node)
+		total += rockchip_video_load_cost(load->type, load->width,
+						  load->height, load->fps,
+						  load->hdr, load->hevc);
+	video_load_total = total;
+}
+
 static void rockchip_update_video_info(void)
 {
 	struct video_info *video_info;
@@ -300,8 +345,10 @@ static void rockchip_update_video_info(void)
 	unsigned int max_video_framerate = 0;
 
 	mutex_lock(&video_info_mutex);
+	rockchip_update_video_load();
 	if (list_empty(&video_info_list)) {
 		mutex_unlock(&video_info_mutex);
+		rockchip_system_monitor_video_load_apply();
 		rockchip_clear_system_status(SYS_STATUS_VIDEO);
 		return;
 	}
@@ -316,6 +363,7 @@ static void rockchip_update_video_info(void)
 			max_video_framerate = video_info->videoFramerate;
 	}
 	mutex_unlock(&video_info_mutex);
+	rockchip_system_monitor_video_load_apply();
 
 	if (max_res <= VIDEO_1080P_SIZE) {
 		rockchip_set_system_status(SYS_STATUS_VIDEO_1080P);
@@ -328,6 +376,27 @@ static void rockchip_update_video_info(void)
 	}
 }
 
+/*
+ * isp and encoder drivers declare their streams here, decoders still come
+ * from the video_info strings. The weighted pixel rate of all of them
+ * picks the cpu, dmc and npu floors from each "rockchip,video-load-freq".
+ */
+void rockchip_system_monitor_video_load_update(struct rockchip_video_load *load,
+					       bool on)
+{
+	mutex_lock(&video_info_mutex);
+	if (on && !load->active)
+		list_add_tail(&load->node, &video_load_list);
+	else if (!on && load->active)
+		list_del(&load->node);
+	load->active = on;
+	rockchip_update_video_load();
+	mutex_unlock(&video_info_mutex);
+
+	rockchip_system_monitor_video_load_apply();
+}
+EXPORT_SYMBOL(rockchip_system_monitor_video_load_update);
+
 void rockchip_update_system_status(const char *buf)
 {
 	struct video_info *video_info;
@@ -442,6 +511,33 @@ static int rockchip_get_temp_freq_table(struct device_node *np,
 	return 0;
 }
 
+static int rockchip_get_video_load_freq_table(struct device_node *np,
+					      char *porp_name,
+					      struct video_load_freq_table **freq_table)
+{
+	struct video_load_freq_table *table;
+	int count, i;
+
+	count = of_property_count_u32_elems(np, porp_name);
+	if (count <= 0 || count % 2)
+		return -EINVAL;
+
+	table = kzalloc(sizeof(*table) * (count / 2 + 1), GFP_KERNEL);
+	if (!table)
+		return -ENOMEM;
+
+	for (i = 0; i < count / 2; i++) {
+		of_property_read_u32_index(np, porp_name, 2 * i,
+					   &table[i].load);
+		of_property_read_u32_index(np, porp_name, 2 * i + 1,
+					   &table[i].freq);
+	}
+	table[i].load = UINT_MAX;
+	*freq_table = table;
+
+	return 0;
+}
+
 static int rockchip_get_adjust_volt_table(struct device_node *np,
 					  char *porp_name,
 					  struct volt_adjust_table **table)
@@ -708,6 +804,8 @@ static int monitor_device_parse_status_config(struct device_node *np,
 				   &info->video_4k_freq);
 	ret &= of_property_read_u32(np, "rockchip,reboot-freq",
 				    &info->reboot_freq);
+	ret &= rockchip_get_video_load_freq_table(np, "rockchip,video-load-freq",
+						  &info->video_load_table);
 	if (info->devp->type == MONITOR_TPYE_CPU) {
 		if (!info->reboot_freq) {
 			info->reboot_freq = CPU_REBOOT_FREQ;
@@ -1145,6 +1243,16 @@ rockchip_system_monitor_freq_qos_requset(struct monitor_dev_info *info)
 			dev_info(info->dev, "failed to add freq constraint\n");
 			return ret;
 		}
+		if (!info->video_load_table)
+			return 0;
+		ret = dev_pm_qos_add_request(devfreq->dev.parent,
+					     &info->dev_min_freq_req,
+					     DEV_PM_QOS_MIN_FREQUENCY,
+					     PM_QOS_MIN_FREQUENCY_DEFAULT_VALUE);
+		if (ret < 0) {
+			dev_info(info->dev, "failed to add min freq constraint\n");
+			return ret;
+		}
 	}
 
 	return 0;
@@ -1445,6 +1553,9 @@ rockchip_system_monitor_register(struct device *dev,
 	list_add(&info->node, &monitor_dev_list);
 	up_write(&mdev_list_sem);
 
+	if (info->video_load_table)
+		rockchip_system_monitor_video_load_apply();
+
 	return info;
 }
 EXPORT_SYMBOL(rockchip_system_monitor_register);
@@ -1468,8 +1579,11 @@ void rockchip_system_monitor_unregister(struct monitor_dev_info *info)
 	} else {
 		if (dev_pm_qos_request_active(&info->dev_max_freq_req))
 			dev_pm_qos_remove_request(&info->dev_max_freq_req);
+		if (dev_pm_qos_request_active(&info->dev_min_freq_req))
+			dev_pm_qos_remove_request(&info->dev_min_freq_req);
 	}
 
+	kfree(info->video_load_table);
 	kfree(info->low_temp_adjust_table);
 	kfree(info->opp_table);
 	kfree(info->set_opp_data);
@@ -1522,6 +1636,9 @@ static int rockchip_system_monitor_parse_dt(struct system_monitor *monitor)
 	else
 		cpulist_parse(buf, &monitor->video_4k_offline_cpus);
 
+	of_property_read_u32_array(np, "rockchip,video-load-cost",
+				   video_load_cost, ROCKCHIP_VIDEO_LOAD_MAX);
+
 	if (of_property_read_string(np, "rockchip,thermal-zone", &tz_name))
 		goto out;
 	monitor->tz = thermal_zone_get_zone_by_name(tz_name);
@@ -1684,6 +1801,57 @@ static void rockchip_system_status_cpu_limit_freq(struct monitor_dev_info *info,
 					FREQ_QOS_MAX_DEFAULT_VALUE);
 }
 
+static void rockchip_system_monitor_video_load_freq(struct monitor_dev_info *info,
+						    unsigned int load)
+{
+	unsigned int target_freq = 0;
+	int i;
+
+	if (!info->video_load_table)
+		return;
+
+	if (load) {
+		for (i = 0; info->video_load_table[i].load != UINT_MAX; i++) {
+			if (load < info->video_load_table[i].load)
+				break;
+			target_freq = info->video_load_table[i].freq;
+		}
+	}
+
+	if (target_freq == info->video_load_freq)
+		return;
+
+	if (info->devp->type == MONITOR_TPYE_CPU) {
+		if (!freq_qos_request_active(&info->min_sta_freq_req))
+			return;
+		/* the reboot limit owns the cpu minimum */
+		if (system_status & SYS_STATUS_REBOOT)
+			return;
+		freq_qos_update_request(&info->min_sta_freq_req,
+					target_freq ? target_freq :
+					FREQ_QOS_MIN_DEFAULT_VALUE);
+	} else {
+		if (!dev_pm_qos_request_active(&info->dev_min_freq_req))
+			return;
+		dev_pm_qos_update_request(&info->dev_min_freq_req,
+					  target_freq ? target_freq :
+					  PM_QOS_MIN_FREQUENCY_DEFAULT_VALUE);
+	}
+	info->video_load_freq = target_freq;
+	dev_dbg(info->dev, "video load %u, min freq %u KHz\n", load, target_freq);
+}
+
+static void rockchip_system_monitor_video_load_apply(void)
+{
+	struct monitor_dev_info *info;
+	unsigned int load = READ_ONCE(video_load_total);
+
+	down_read(&mdev_list_sem);
+	list_for_each_entry(info, &monitor_dev_list, node)
+		rockchip_system_monitor_video_load_freq(info, load);
+	up_read(&mdev_list_sem);
+}
+
 static void rockchip_system_status_limit_freq(unsigned long status)
 {
 	struct monitor_dev_info *info;
@@ -23,6 +23,8 @@
 #define SHA256_PROBE_TIMEOUT		1000
 #define SHA256_COMPARE_TIMEOUT		2000
 #define SHA256_HASH_SIZE		32
+#define SHA256_BLOCK_SIZE		64
+#define SHA256_ITEM_TIMEOUT_US		(500 * USEC_PER_MSEC)
 #define _SBF(s, v)			((v) << (s))
 #define CRYPTO_WRITE_MASK_SHIFT		(16)
 #define CRYPTO_WRITE_MASK_ALL		((0xffffu << CRYPTO_WRITE_MASK_SHIFT))
@@ -151,6 +153,7 @@ struct  crypto_data {
 					   u8 *hash_val);
 	void			*cb_data;
 	u8			*hash;
+	bool			started;
 };
 
 enum endian_mode {
@@ -268,7 +271,14 @@ static irqreturn_t rk_tb_crypto_irq_handle(int irq, void *dev_id)
 	return IRQ_HANDLED;
 }
 
-int rk_tb_sha256(dma_addr_t data, size_t data_len, void *user_data)
+/*
+ * Chunked sha256 of data still being loaded: start once, then update with
+ * each piece as soon as the loader has finished it, so the hash runs
+ * behind the storage transfer instead of after it. The engine pauses at
+ * the end of each piece and the single descriptor is reused. All pieces
+ * but the last must be a multiple of the block size.
+ */
+int rk_tb_sha256_start(void *user_data)
 {
 	u32 reg_ctrl = 0;
 	struct crypto_data *crypto_info;
@@ -279,8 +289,9 @@ int rk_tb_sha256(dma_addr_t data, size_t data_len, void *user_data)
 	if (!crypto_info)
 		return -ENODEV;
 
-	if (data % 4)
-		return -EINVAL;
+	crypto_info->hash = devm_kzalloc(crypto_info->dev, 32, GFP_KERNEL);
+	if (!crypto_info->hash)
+		return -ENOMEM;
 
 	clear_hash_out_reg(crypto_info);
 
@@ -288,6 +299,7 @@ int rk_tb_sha256(dma_addr_t data, size_t data_len, void *user_data)
 	CRYPTO_WRITE(crypto_info, CRYPTO_HASH_CTL,
 		     reg_ctrl | CRYPTO_WRITE_MASK_ALL);
 
+	/* the pauses between pieces are polled, only the end interrupts */
 	reg_ctrl = CRYPTO_ZERO_ERR_INT_EN |
 		   CRYPTO_LIST_ERR_INT_EN |
 		   CRYPTO_SRC_ERR_INT_EN |
@@ -297,16 +309,53 @@ int rk_tb_sha256(dma_addr_t data, size_t data_len, void *user_data)
 	CRYPTO_WRITE(crypto_info, CRYPTO_FIFO_CTL, 0x00030003);
 	CRYPTO_WRITE(crypto_info, CRYPTO_DMA_INT_EN, reg_ctrl);
 
+	crypto_info->calc_ret = -1;
+
+	crypto_info->done_cb = sha256_done_cb;
+	crypto_info->cb_data = user_data;
+	crypto_info->started = false;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rk_tb_sha256_start);
+
+int rk_tb_sha256_update(dma_addr_t data, size_t data_len, bool last)
+{
+	struct crypto_data *crypto_info = g_crypto_info;
+	u32 status;
+
+	if (!crypto_info || !crypto_info->hash)
+		return -ENODEV;
+
+	if (data % 4 || (!last && data_len % SHA256_BLOCK_SIZE))
+		return -EINVAL;
+
+	/* the engine must be done with the previous piece */
+	if (crypto_info->started) {
+		if (readl_poll_timeout(crypto_info->reg + CRYPTO_DMA_INT_ST, status,
+				       status & CRYPTO_SRC_ITEM_DONE_INT_ST, 10,
+				       SHA256_ITEM_TIMEOUT_US))
+			return -ETIMEDOUT;
+		CRYPTO_WRITE(crypto_info, CRYPTO_DMA_INT_ST,
+			     CRYPTO_SRC_ITEM_DONE_INT_ST);
+	}
+
 	memset(crypto_info->desc, 0x00, sizeof(*crypto_info->desc));
 
 	crypto_info->desc->src_addr    = (u32)data;
 	crypto_info->desc->src_len     = data_len;
-	crypto_info->desc->next_addr   = 0;
-	crypto_info->desc->dma_ctrl    = LLI_DMA_CTRL_LIST_DONE |
-					 LLI_DMA_CTRL_LAST;
-	crypto_info->desc->user_define = LLI_USER_CPIHER_START |
-					 LLI_USER_STRING_START |
-					 LLI_USER_STRING_LAST;
+	if (!crypto_info->started)
+		crypto_info->desc->user_define = LLI_USER_CPIHER_START |
+						 LLI_USER_STRING_START;
+	if (last) {
+		crypto_info->desc->next_addr    = 0;
+		crypto_info->desc->dma_ctrl     = LLI_DMA_CTRL_LIST_DONE |
+						  LLI_DMA_CTRL_LAST;
+		crypto_info->desc->user_define |= LLI_USER_STRING_LAST;
+	} else {
+		crypto_info->desc->next_addr    = crypto_info->desc_dma;
+		crypto_info->desc->dma_ctrl     = LLI_DMA_CTRL_PAUSE;
+	}
 #ifdef CONFIG_ARM64
 	__flush_dcache_area((void *)crypto_info->desc,
 			    sizeof(struct crypto_data));
@@ -314,6 +363,14 @@ int rk_tb_sha256(dma_addr_t data, size_t data_len, void *user_data)
 	__cpuc_flush_dcache_area((void *)crypto_info->desc,
 				 sizeof(struct crypto_data));
 #endif
+
+	if (crypto_info->started) {
+		CRYPTO_WRITE(crypto_info, CRYPTO_DMA_CTL,
+			     (CRYPTO_DMA_RESTART << CRYPTO_WRITE_MASK_SHIFT) |
+			     CRYPTO_DMA_RESTART);
+		return 0;
+	}
+
 	CRYPTO_WRITE(crypto_info, CRYPTO_DMA_LLI_ADDR, crypto_info->desc_dma);
 	CRYPTO_WRITE(crypto_info, CRYPTO_HASH_CTL,
 		     (CRYPTO_HASH_ENABLE <<
@@ -321,16 +378,21 @@ int rk_tb_sha256(dma_addr_t data, size_t data_len, void *user_data)
 		      CRYPTO_HASH_ENABLE);
 
 	CRYPTO_WRITE(crypto_info, CRYPTO_DMA_CTL, 0x00010001); /* start */
+	crypto_info->started = true;
 
-	crypto_info->calc_ret = -1;
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rk_tb_sha256_update);
 
-	crypto_info->done_cb = sha256_done_cb;
-	crypto_info->cb_data = user_data;
-	crypto_info->hash = devm_kzalloc(crypto_info->dev, 32, GFP_KERNEL);
-	if (!crypto_info->hash)
-		return -ENOMEM;
+int rk_tb_sha256(dma_addr_t data, size_t data_len, void *user_data)
+{
+	int ret;
 
-	return 0;
+	ret = rk_tb_sha256_start(user_data);
+	if (ret)
+		return ret;
+
+	return rk_tb_sha256_update(data, data_len, true);
 }
 EXPORT_SYMBOL_GPL(rk_tb_sha256);
 
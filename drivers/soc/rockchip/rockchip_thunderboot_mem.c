@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Release of the memory thunderboot reserves for the mcu, the isp and
+ * the decompress buffers. Each client frees its reservation once it is
+ * done, in blocks of the largest order instead of page by page, and
+ * drops it from memblock.reserved, so rk_memblock shows what is left.
+ */
+#include <linux/kernel.h>
+#include <linux/memblock.h>
+#include <linux/mm.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/timekeeping.h>
+#include <linux/soc/rockchip/rockchip_thunderboot_mem.h>
+
+#define RK_TB_MEM_RECORD_MAX	16
+
+struct rk_tb_mem_record {
+	char name[24];
+	phys_addr_t start;
+	phys_addr_t size;
+	u64 ns;
+};
+
+static struct rk_tb_mem_record records[RK_TB_MEM_RECORD_MAX];
+static int record_cnt;
+static unsigned long released_pages;
+static DEFINE_SPINLOCK(lock);
+
+static void rk_tb_mem_free_pages(unsigned long pfn, unsigned long end_pfn)
+{
+	struct page *page;
+	unsigned int order;
+	unsigned long i;
+
+	while (pfn < end_pfn) {
+		order = pfn ? min_t(unsigned int, __ffs(pfn), MAX_ORDER - 1) :
+			MAX_ORDER - 1;
+		while (pfn + (1UL << order) > end_pfn)
+			order--;
+
+		page = pfn_to_page(pfn);
+		for (i = 0; i < (1UL << order); i++) {
+			ClearPageReserved(page + i);
+			set_page_count(page + i, 0);
+		}
+		set_page_count(page, 1);
+		adjust_managed_page_count(page, 1UL << order);
+		__free_pages(page, order);
+
+		pfn += 1UL << order;
+	}
+}
+
+unsigned long rk_tb_mem_release(const char *name, phys_addr_t start,
+				phys_addr_t size)
+{
+	unsigned long pfn = PFN_UP(start);
+	unsigned long end_pfn = PFN_DOWN(start + size);
+	struct rk_tb_mem_record *rec;
+	unsigned long flags;
+
+	if (!size || end_pfn <= pfn)
+		return 0;
+
+	rk_tb_mem_free_pages(pfn, end_pfn);
+	if (IS_ENABLED(CONFIG_ARCH_KEEP_MEMBLOCK))
+		memblock_free(PFN_PHYS(pfn), PFN_PHYS(end_pfn - pfn));
+
+	spin_lock_irqsave(&lock, flags);
+	released_pages += end_pfn - pfn;
+	if (record_cnt < RK_TB_MEM_RECORD_MAX) {
+		rec = &records[record_cnt++];
+		strscpy(rec->name, name ? name : "unknown", sizeof(rec->name));
+		rec->start = PFN_PHYS(pfn);
+		rec->size = PFN_PHYS(end_pfn - pfn);
+		rec->ns = ktime_get_boottime_ns();
+	}
+	spin_unlock_irqrestore(&lock, flags);
+
+	pr_info("Freeing %s memory: %luK\n", name ? name : "thunderboot",
+		(end_pfn - pfn) << (PAGE_SHIFT - 10));
+
+	return PFN_PHYS(end_pfn - pfn);
+}
+EXPORT_SYMBOL(rk_tb_mem_release);
+
+static int rk_tb_mem_show(struct seq_file *m, void *v)
+{
+	struct rk_tb_mem_record *rec;
+	phys_addr_t end;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&lock, flags);
+	for (i = 0; i < record_cnt; i++) {
+		rec = &records[i];
+		end = rec->start + rec->size - 1;
+		seq_printf(m, "%-24s %pa..%pa %8llu KiB at %lluus\n", rec->name,
+			   &rec->start, &end, (u64)rec->size >> 10,
+			   div_u64(rec->ns, NSEC_PER_USEC));
+	}
+	seq_printf(m, "Total: %lu KiB\n", released_pages << (PAGE_SHIFT - 10));
+	spin_unlock_irqrestore(&lock, flags);
+
+	return 0;
+}
+
+static int __init rk_tb_mem_init(void)
+{
+	proc_create_single("rk_tb_mem", 0444, NULL, rk_tb_mem_show);
+	return 0;
+}
+late_initcall_sync(rk_tb_mem_init);
@@ -2,7 +2,9 @@
 /*
  * Copyright (C) 2020 Rockchip Electronics Co., Ltd.
  */
+#include <asm/cacheflush.h>
 #include <linux/clk.h>
+#include <linux/delay.h>
 #include <linux/iopoll.h>
 #include <linux/kernel.h>
 #include <linux/kthread.h>
@@ -12,14 +14,125 @@
 #include <linux/of_address.h>
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
+#include <linux/sizes.h>
 #include <linux/soc/rockchip/rockchip_decompress.h>
 #include <linux/soc/rockchip/rockchip_thunderboot_crypto.h>
+#include <linux/soc/rockchip/rockchip_thunderboot_mem.h>
 
 #define SDMMC_RINTSTS		0x044
 #define SDMMC_STATUS		0x048
 #define SDMMC_IDSTS		0x08c
 #define SDMMC_INTR_ERROR	0xB7C2
 
+#define SDMMC_BUSY		(BIT(10) | GENMASK(7, 4))
+#define SDMMC_IDMAC_BUSY	GENMASK(16, 13)
+
+#define IDMAC_DES0_OWN		BIT(31)
+#define IDMAC_DES1_BS1(x)	((x) & 0x1fff)
+
+/* pieces the ramdisk is hashed in while it is being read */
+#define TB_HASH_CHUNK		SZ_64K
+
+/* 32 bit idmac descriptor, as set up by the loader */
+struct rk_tb_idmac_desc {
+	__le32 des0;
+	__le32 des1;
+	__le32 des2;
+	__le32 des3;
+};
+
+/*
+ * Bytes of the ramdisk the idmac has finished. The loader reads in
+ * ascending order, so that is everything below the lowest buffer the
+ * controller still owns, or, with none owned, up to the end of the highest
+ * finished one.
+ */
+static u32 rk_tb_mmc_loaded(struct rk_tb_idmac_desc *desc, int num,
+			    phys_addr_t start, u32 size)
+{
+	u32 addr, end, owned = size, done = 0;
+	bool own = false;
+	int i;
+
+#ifdef CONFIG_ARM64
+	__flush_dcache_area(desc, num * sizeof(*desc));
+#else
+	__cpuc_flush_dcache_area(desc, num * sizeof(*desc));
+#endif
+
+	for (i = 0; i < num; i++) {
+		addr = le32_to_cpu(desc[i].des2);
+		if (addr < start || addr >= start + size)
+			continue;
+
+		addr -= start;
+		if (le32_to_cpu(desc[i].des0) & IDMAC_DES0_OWN) {
+			own = true;
+			owned = min(owned, addr);
+		} else {
+			end = addr + IDMAC_DES1_BS1(le32_to_cpu(desc[i].des1));
+			done = max(done, min(end, size));
+		}
+	}
+
+	return own ? owned : done;
+}
+
+/*
+ * Hash the ramdisk right behind the idmac while the loader is still
+ * reading it, instead of after the controller went idle. Returns the bytes
+ * hashed so far, the rest is hashed once the controller is idle, or < 0 if
+ * the hash was not started.
+ */
+static int rk_tb_mmc_hash_behind(void __iomem *regs, struct device_node *rds,
+				 struct device_node *dma)
+{
+	ktime_t timeout = ktime_add_ms(ktime_get(), 500);
+	struct resource src, idmac;
+	const u32 *digest_org;
+	u32 rdk_size = 0, loaded, fed = 0;
+	int num;
+
+	if (!IS_ENABLED(CONFIG_ROCKCHIP_THUNDER_BOOT_CRYPTO) || !rds || !dma)
+		return -ENODEV;
+
+	if (of_address_to_resource(rds, 0, &src) < 0 ||
+	    of_address_to_resource(dma, 0, &idmac) < 0)
+		return -ENODEV;
+
+	of_property_read_u32(rds, "size", &rdk_size);
+	digest_org = of_get_property(rds->child, "value", NULL);
+	if (!digest_org || !rdk_size)
+		return -ENODEV;
+
+	if (rk_tb_sha256_start((void *)digest_org))
+		return -ENODEV;
+
+	num = resource_size(&idmac) / sizeof(struct rk_tb_idmac_desc);
+	while (ktime_before(ktime_get(), timeout)) {
+		if (!(readl_relaxed(regs + SDMMC_STATUS) & SDMMC_BUSY) &&
+		    !(readl_relaxed(regs + SDMMC_IDSTS) & SDMMC_IDMAC_BUSY))
+			break;
+
+		loaded = rk_tb_mmc_loaded(phys_to_virt(idmac.start), num,
+					  src.start, rdk_size);
+		/* the last piece is left for after the transfer */
+		loaded = min(round_down(loaded, TB_HASH_CHUNK),
+			     round_down(rdk_size - 1, TB_HASH_CHUNK));
+		if (loaded <= fed) {
+			usleep_range(50, 100);
+			continue;
+		}
+
+		if (rk_tb_sha256_update((dma_addr_t)src.start + fed,
+					loaded - fed, false))
+			break;
+		fed = loaded;
+	}
+
+	return fed;
+}
+
 static int rk_tb_mmc_thread(void *p)
 {
 	int ret = 0;
@@ -31,6 +144,7 @@ static int rk_tb_mmc_thread(void *p)
 	struct clk_bulk_data *clk_bulks;
 	int clk_num;
 	u32 status;
+	int hashed;
 
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
 	regs = ioremap(res->start, resource_size(res));
@@ -55,13 +169,15 @@ static int rk_tb_mmc_thread(void *p)
 		return clk_num;
 	}
 
+	hashed = rk_tb_mmc_hash_behind(regs, rds, dma);
+
 	if (readl_poll_timeout(regs + SDMMC_STATUS, status,
-			       !(status & (BIT(10) | GENMASK(7, 4))), 100,
+			       !(status & SDMMC_BUSY), 100,
 			       500 * USEC_PER_MSEC))
 		dev_err(dev, "Controller is occupied!\n");
 
 	if (readl_poll_timeout(regs + SDMMC_IDSTS, status,
-			       !(status & GENMASK(16, 13)), 100,
+			       !(status & SDMMC_IDMAC_BUSY), 100,
 			       500 * USEC_PER_MSEC))
 		dev_err(dev, "DMA is still running!\n");
 
@@ -82,7 +198,10 @@ static int rk_tb_mmc_thread(void *p)
 			if (IS_ENABLED(CONFIG_ROCKCHIP_THUNDER_BOOT_CRYPTO)) {
 				of_property_read_u32(rds, "size", &rdk_size);
 				digest_org = of_get_property(rds->child, "value", NULL);
-				if (digest_org && rdk_size)
+				if (digest_org && rdk_size && hashed >= 0)
+					rk_tb_sha256_update((dma_addr_t)src.start + hashed,
+							    rdk_size - hashed, true);
+				else if (digest_org && rdk_size)
 					rk_tb_sha256((dma_addr_t)src.start, rdk_size,
 						     (void *)digest_org);
 			}
@@ -104,9 +223,8 @@ static int rk_tb_mmc_thread(void *p)
 
 		ret = of_address_to_resource(dma, 0, &idmac);
 		if (ret >= 0)
-			free_reserved_area(phys_to_virt(idmac.start),
-					   phys_to_virt(idmac.start) + resource_size(&idmac),
-					   -1, "memory-region-idmac");
+			rk_tb_mem_release("memory-region-idmac", idmac.start,
+					  resource_size(&idmac));
 	}
 
 out:
@@ -2,6 +2,7 @@
 /*
  * Copyright (C) 2022 Rockchip Electronics Co., Ltd.
  */
+#include <linux/async.h>
 #include <linux/delay.h>
 #include <linux/kernel.h>
 #include <linux/mailbox_client.h>
@@ -11,12 +12,19 @@
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
 #include <linux/reset.h>
+#include <linux/timekeeping.h>
+#include <linux/wait.h>
+#include <linux/soc/rockchip/rockchip_thunderboot_mem.h>
 #include <linux/soc/rockchip/rockchip_thunderboot_service.h>
 #include <soc/rockchip/rockchip-mailbox.h>
 
 #define CMD_MCU_STATUS		(0x0000f00d)
 #define MCU_STATUS_DONE		(0xdeadbeef)
 
+#define RK_TB_RECORD_MAX	32
+/* async client wait for deps, in case of loop or lost client */
+#define RK_TB_DEPS_TIMEOUT_MS	1000
+
 struct rk_tb_serv {
 	struct device *dev;
 	struct mbox_chan *mbox_rx_chan;
@@ -27,52 +35,127 @@ struct rk_tb_serv {
 	bool mem_no_free;
 };
 
+struct rk_tb_record {
+	char name[16];
+	u32 id;
+	u32 flags;
+	u64 start_ns;
+	u64 end_ns;
+};
+
 static atomic_t mcu_done = ATOMIC_INIT(0);
 static LIST_HEAD(clients_list);
 static DEFINE_SPINLOCK(lock);
 
+/* clients of each id not yet done */
+static atomic_t clients_pending[RK_TB_CLIENT_MAX];
+static DECLARE_WAIT_QUEUE_HEAD(clients_wq);
+static ASYNC_DOMAIN_EXCLUSIVE(clients_domain);
+
+static struct rk_tb_record records[RK_TB_RECORD_MAX];
+static atomic_t record_cnt = ATOMIC_INIT(0);
+static u64 mcu_done_ns;
+
 bool rk_tb_mcu_is_done(void)
 {
 	return atomic_read(&mcu_done);
 }
 EXPORT_SYMBOL(rk_tb_mcu_is_done);
 
-int rk_tb_client_register_cb(struct rk_tb_client *client)
+static bool rk_tb_client_valid(struct rk_tb_client *client)
 {
 	if (!client || !client->cb)
-		return -EINVAL;
+		return false;
+	if (client->id >= RK_TB_CLIENT_MAX ||
+	    client->deps & ~GENMASK(RK_TB_CLIENT_MAX - 1, RK_TB_CLIENT_NONE + 1))
+		return false;
+	/* depend on itself never done */
+	if (client->id && client->deps & RK_TB_CLIENT_DEP(client->id))
+		return false;
+	return true;
+}
 
-	spin_lock(&lock);
-	if (rk_tb_mcu_is_done()) {
-		spin_unlock(&lock);
-		client->cb(client->data);
-		return 0;
+static bool rk_tb_client_deps_done(u32 deps)
+{
+	int id;
+
+	for (id = RK_TB_CLIENT_NONE + 1; id < RK_TB_CLIENT_MAX; id++) {
+		if ((deps & RK_TB_CLIENT_DEP(id)) &&
+		    atomic_read(&clients_pending[id]))
+			return false;
 	}
+	return true;
+}
 
-	list_add_tail(&client->node, &clients_list);
-	spin_unlock(&lock);
+static void rk_tb_client_run(struct rk_tb_client *client, bool is_pending)
+{
+	struct rk_tb_record *rec = NULL;
+	int idx;
+
+	idx = atomic_inc_return(&record_cnt) - 1;
+	if (idx < RK_TB_RECORD_MAX) {
+		rec = &records[idx];
+		strscpy(rec->name, client->name ? client->name : "unknown",
+			sizeof(rec->name));
+		rec->id = client->id;
+		rec->flags = client->flags;
+		rec->start_ns = ktime_get_boottime_ns();
+	}
 
-	return 0;
+	client->cb(client->data);
+
+	if (rec)
+		rec->end_ns = ktime_get_boottime_ns();
+	if (is_pending && client->id) {
+		atomic_dec(&clients_pending[client->id]);
+		wake_up_all(&clients_wq);
+	}
 }
-EXPORT_SYMBOL(rk_tb_client_register_cb);
 
-int rk_tb_client_register_cb_head(struct rk_tb_client *client)
+static void rk_tb_client_async(void *data, async_cookie_t cookie)
 {
-	if (!client || !client->cb)
+	struct rk_tb_client *client = data;
+
+	if (!wait_event_timeout(clients_wq, rk_tb_client_deps_done(client->deps),
+				msecs_to_jiffies(RK_TB_DEPS_TIMEOUT_MS)))
+		pr_warn("%s: %s wait deps:0x%x timeout\n", __func__,
+			client->name ? client->name : "unknown", client->deps);
+	rk_tb_client_run(client, true);
+}
+
+static int rk_tb_client_add(struct rk_tb_client *client, bool head)
+{
+	if (!rk_tb_client_valid(client))
 		return -EINVAL;
 
 	spin_lock(&lock);
 	if (rk_tb_mcu_is_done()) {
 		spin_unlock(&lock);
-		client->cb(client->data);
+		rk_tb_client_run(client, false);
 		return 0;
 	}
 
-	list_add(&client->node, &clients_list);
+	if (head)
+		list_add(&client->node, &clients_list);
+	else
+		list_add_tail(&client->node, &clients_list);
+	if (client->id)
+		atomic_inc(&clients_pending[client->id]);
 	spin_unlock(&lock);
 
 	return 0;
 }
+
+int rk_tb_client_register_cb(struct rk_tb_client *client)
+{
+	return rk_tb_client_add(client, false);
+}
+EXPORT_SYMBOL(rk_tb_client_register_cb);
+
+int rk_tb_client_register_cb_head(struct rk_tb_client *client)
+{
+	return rk_tb_client_add(client, true);
+}
 EXPORT_SYMBOL(rk_tb_client_register_cb_head);
 
 static void do_mcu_done(struct rk_tb_serv *serv)
@@ -82,16 +165,14 @@ static void do_mcu_done(struct rk_tb_serv *serv)
 
 	rockchip_mbox_read_msg(serv->mbox_rx_chan, &msg);
 	if (msg.cmd == CMD_MCU_STATUS && msg.data == MCU_STATUS_DONE) {
-		void *start, *end;
-
 		/* make sure mcu is wfi */
 		udelay(15);
 		reset_control_assert(serv->rsts);
 
-		start = phys_to_virt(serv->mem_start);
-		end = start + serv->mem_size;
-		if (!serv->mem_no_free)
-			free_reserved_area(start, end, -1, "rtos");
+		if (!serv->mem_no_free) {
+			rk_tb_mem_release("rtos", serv->mem_start, serv->mem_size);
+			serv->mem_no_free = true;
+		}
 
 		spin_lock(&lock);
 		if (atomic_read(&mcu_done)) {
@@ -99,19 +180,50 @@ static void do_mcu_done(struct rk_tb_serv *serv)
 			return;
 		}
 
+		mcu_done_ns = ktime_get_boottime_ns();
+		/*
+		 * async clients start at once and wait for their deps,
+		 * the others run here in order of register as before.
+		 */
 		while (!list_empty(&clients_list)) {
 			client = list_first_entry(&clients_list, struct rk_tb_client, node);
 			list_del(&client->node);
 			spin_unlock(&lock);
-			if (client->cb)
-				client->cb(client->data);
+			if (client->flags & RK_TB_CLIENT_ASYNC)
+				async_schedule_domain(rk_tb_client_async, client,
+						      &clients_domain);
+			else
+				rk_tb_client_run(client, true);
 			spin_lock(&lock);
 		}
 		atomic_set(&mcu_done, 1);
 		spin_unlock(&lock);
+		async_synchronize_full_domain(&clients_domain);
 	}
 }
 
+static ssize_t clients_show(struct device *dev,
+			    struct device_attribute *attr, char *buf)
+{
+	struct rk_tb_record *rec;
+	int i, cnt, len;
+
+	len = sysfs_emit(buf, "mcu done: %lluus\n", div_u64(mcu_done_ns, NSEC_PER_USEC));
+	cnt = min_t(int, atomic_read(&record_cnt), RK_TB_RECORD_MAX);
+	for (i = 0; i < cnt; i++) {
+		rec = &records[i];
+		len += sysfs_emit_at(buf, len, "%-16s id:%u %s start:%lluus end:%lluus cost:%lluus\n",
+				     rec->name, rec->id,
+				     rec->flags & RK_TB_CLIENT_ASYNC ? "async" : "sync",
+				     div_u64(rec->start_ns, NSEC_PER_USEC),
+				     div_u64(rec->end_ns, NSEC_PER_USEC),
+				     rec->end_ns > rec->start_ns ?
+				     div_u64(rec->end_ns - rec->start_ns, NSEC_PER_USEC) : 0);
+	}
+	return len;
+}
+static DEVICE_ATTR_RO(clients);
+
 static void rk_tb_rx_callback(struct mbox_client *mbox_cl, void *message)
 {
 	struct rk_tb_serv *serv = dev_get_drvdata(mbox_cl->dev);
@@ -156,6 +268,9 @@ static int rk_tb_serv_probe(struct platform_device *pdev)
 
 	platform_set_drvdata(pdev, serv);
 
+	if (device_create_file(&pdev->dev, &dev_attr_clients))
+		dev_warn(&pdev->dev, "failed to create clients attr\n");
+
 	mbox_cl = &serv->mbox_cl;
 	mbox_cl->dev = &pdev->dev;
 	mbox_cl->rx_callback = rk_tb_rx_callback;
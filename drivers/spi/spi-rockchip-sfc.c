@@ -148,6 +148,7 @@
 #define  SFC_CMD_ADDR_32BITS		2
 #define  SFC_CMD_ADDR_XBITS		3
 #define  SFC_CMD_TRAN_BYTES_SHIFT	16
+#define  SFC_CMD_TRAN_BYTES_MASK	GENMASK(29, 16)
 #define  SFC_CMD_CS_SHIFT		30
 
 /* Address */
@@ -197,6 +198,13 @@ struct rockchip_sfc {
 	struct spi_master *master;
 };
 
+/* dirmap read op encoded once at dirmap_create */
+struct rockchip_sfc_dirmap {
+	u32 ctrl;
+	u32 cmd;
+	u32 abit;
+};
+
 static int rockchip_sfc_reset(struct rockchip_sfc *sfc)
 {
 	int err;
@@ -355,13 +363,11 @@ static void rockchip_sfc_adjust_op_work(struct spi_mem_op *op)
 	}
 }
 
-static int rockchip_sfc_xfer_setup(struct rockchip_sfc *sfc,
-				   struct spi_mem *mem,
-				   const struct spi_mem_op *op,
-				   u32 len)
+static void rockchip_sfc_xfer_encode(struct rockchip_sfc *sfc,
+				     const struct spi_mem_op *op,
+				     u8 cs, u32 len, u32 *ctrl_out, u32 *cmd_out)
 {
 	u32 ctrl = 0, cmd = 0;
-	u8 cs = mem->spi->chip_select;
 
 	/* set CMD */
 	cmd = op->cmd.opcode;
@@ -369,14 +375,12 @@ static int rockchip_sfc_xfer_setup(struct rockchip_sfc *sfc,
 
 	/* set ADDR */
 	if (op->addr.nbytes) {
-		if (op->addr.nbytes == 4) {
+		if (op->addr.nbytes == 4)
 			cmd |= SFC_CMD_ADDR_32BITS << SFC_CMD_ADDR_SHIFT;
-		} else if (op->addr.nbytes == 3) {
+		else if (op->addr.nbytes == 3)
 			cmd |= SFC_CMD_ADDR_24BITS << SFC_CMD_ADDR_SHIFT;
-		} else {
+		else
 			cmd |= SFC_CMD_ADDR_XBITS << SFC_CMD_ADDR_SHIFT;
-			writel(op->addr.nbytes * 8 - 1, sfc->regbase + cs * SFC_CS1_REG_OFFSET + SFC_ABIT);
-		}
 
 		ctrl |= ((op->addr.buswidth >> 1) << SFC_CTRL_ADDR_BITS_SHIFT);
 	}
@@ -392,9 +396,7 @@ static int rockchip_sfc_xfer_setup(struct rockchip_sfc *sfc,
 	}
 
 	/* set DATA */
-	if (sfc->version >= SFC_VER_4) /* Clear it if no data to transfer */
-		writel(len, sfc->regbase + SFC_LEN_EXT);
-	else
+	if (sfc->version < SFC_VER_4)
 		cmd |= len << SFC_CMD_TRAN_BYTES_SHIFT;
 	if (len) {
 		if (op->data.dir == SPI_MEM_DATA_OUT)
@@ -409,6 +411,25 @@ static int rockchip_sfc_xfer_setup(struct rockchip_sfc *sfc,
 	ctrl |= SFC_CTRL_PHASE_SEL_NEGETIVE;
 	cmd |= cs << SFC_CMD_CS_SHIFT;
 
+	*ctrl_out = ctrl;
+	*cmd_out = cmd;
+}
+
+static int rockchip_sfc_xfer_setup(struct rockchip_sfc *sfc,
+				   struct spi_mem *mem,
+				   const struct spi_mem_op *op,
+				   u32 len)
+{
+	u32 ctrl, cmd;
+	u8 cs = mem->spi->chip_select;
+
+	rockchip_sfc_xfer_encode(sfc, op, cs, len, &ctrl, &cmd);
+
+	if (op->addr.nbytes && op->addr.nbytes != 3 && op->addr.nbytes != 4)
+		writel(op->addr.nbytes * 8 - 1, sfc->regbase + cs * SFC_CS1_REG_OFFSET + SFC_ABIT);
+	if (sfc->version >= SFC_VER_4) /* Clear it if no data to transfer */
+		writel(len, sfc->regbase + SFC_LEN_EXT);
+
 	dev_dbg(sfc->dev, "sfc addr.nbytes=%x(x%d) dummy.nbytes=%x(x%d)\n",
 		op->addr.nbytes, op->addr.buswidth,
 		op->dummy.nbytes, op->dummy.buswidth);
@@ -697,6 +718,34 @@ static void rockchip_sfc_delay_lines_tuning(struct rockchip_sfc *sfc, struct spi
 	}
 }
 
+static int rockchip_sfc_set_speed(struct rockchip_sfc *sfc, struct spi_mem *mem)
+{
+	u8 cs = mem->spi->chip_select;
+	int ret;
+
+	if (likely(mem->spi->max_speed_hz == sfc->speed[cs]) ||
+	    has_acpi_companion(sfc->dev))
+		return 0;
+
+	ret = rockchip_sfc_clk_set_rate(sfc, mem->spi->max_speed_hz);
+	if (ret)
+		return ret;
+	sfc->speed[cs] = mem->spi->max_speed_hz;
+	sfc->cur_speed = mem->spi->max_speed_hz;
+	sfc->cur_real_speed = rockchip_sfc_clk_get_rate(sfc);
+	if (rockchip_sfc_get_version(sfc) >= SFC_VER_4) {
+		if (sfc->cur_real_speed > SFC_DLL_THRESHOLD_RATE)
+			rockchip_sfc_delay_lines_tuning(sfc, mem);
+		else
+			rockchip_sfc_set_delay_lines(sfc, 0, cs);
+	}
+
+	dev_dbg(sfc->dev, "set_freq=%dHz real_freq=%ldHz\n",
+		sfc->speed[cs], rockchip_sfc_clk_get_rate(sfc));
+
+	return 0;
+}
+
 static int rockchip_sfc_exec_mem_op(struct spi_mem *mem, const struct spi_mem_op *op)
 {
 	struct rockchip_sfc *sfc = spi_master_get_devdata(mem->spi->master);
@@ -710,24 +759,9 @@ static int rockchip_sfc_exec_mem_op(struct spi_mem *mem, const struct spi_mem_op
 		return ret;
 	}
 
-	if (unlikely(mem->spi->max_speed_hz != sfc->speed[cs]) &&
-	    !has_acpi_companion(sfc->dev)) {
-		ret = rockchip_sfc_clk_set_rate(sfc, mem->spi->max_speed_hz);
-		if (ret)
-			goto out;
-		sfc->speed[cs] = mem->spi->max_speed_hz;
-		sfc->cur_speed = mem->spi->max_speed_hz;
-		sfc->cur_real_speed = rockchip_sfc_clk_get_rate(sfc);
-		if (rockchip_sfc_get_version(sfc) >= SFC_VER_4) {
-			if (sfc->cur_real_speed > SFC_DLL_THRESHOLD_RATE)
-				rockchip_sfc_delay_lines_tuning(sfc, mem);
-			else
-				rockchip_sfc_set_delay_lines(sfc, 0, cs);
-		}
-
-		dev_dbg(sfc->dev, "set_freq=%dHz real_freq=%ldHz\n",
-			sfc->speed[cs], rockchip_sfc_clk_get_rate(sfc));
-	}
+	ret = rockchip_sfc_set_speed(sfc, mem);
+	if (ret)
+		goto out;
 
 	rockchip_sfc_adjust_op_work((struct spi_mem_op *)op);
 	rockchip_sfc_set_cs_gpio(sfc, cs, true);
@@ -767,9 +801,193 @@ static int rockchip_sfc_adjust_op_size(struct spi_mem *mem, struct spi_mem_op *o
 	return 0;
 }
 
+/*
+ * Direct mapping for reads: the op template is encoded once here so a
+ * read only programs ctrl, length, cmd and address, and aligned reads go
+ * by dma straight into the caller buffer without the bounce copy. Writes
+ * keep using exec_op.
+ */
+static int rockchip_sfc_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct rockchip_sfc *sfc = spi_master_get_devdata(desc->mem->spi->master);
+	struct spi_mem_op op = desc->info.op_tmpl;
+	struct rockchip_sfc_dirmap *map;
+	u8 cs = desc->mem->spi->chip_select;
+
+	if (op.data.dir != SPI_MEM_DATA_IN)
+		return -EOPNOTSUPP;
+	if (!spi_mem_supports_op(desc->mem, &op))
+		return -EOPNOTSUPP;
+
+	map = devm_kzalloc(sfc->dev, sizeof(*map), GFP_KERNEL);
+	if (!map)
+		return -ENOMEM;
+
+	rockchip_sfc_adjust_op_work(&op);
+	rockchip_sfc_xfer_encode(sfc, &op, cs, 1, &map->ctrl, &map->cmd);
+	map->cmd &= ~SFC_CMD_TRAN_BYTES_MASK;
+	if (op.addr.nbytes && op.addr.nbytes != 3 && op.addr.nbytes != 4)
+		map->abit = op.addr.nbytes * 8 - 1;
+	desc->priv = map;
+
+	return 0;
+}
+
+static void rockchip_sfc_dirmap_destroy(struct spi_mem_dirmap_desc *desc)
+{
+	struct rockchip_sfc *sfc = spi_master_get_devdata(desc->mem->spi->master);
+
+	devm_kfree(sfc->dev, desc->priv);
+}
+
+static void rockchip_sfc_dma_start(struct rockchip_sfc *sfc, dma_addr_t dma, u32 len)
+{
+	init_completion(&sfc->cp);
+	rockchip_sfc_irq_unmask(sfc, SFC_IMR_DMA);
+	rockchip_sfc_fifo_transfer_dma(sfc, dma, len);
+}
+
+static int rockchip_sfc_dma_wait(struct rockchip_sfc *sfc)
+{
+	int ret = 0;
+
+	if (!wait_for_completion_timeout(&sfc->cp, msecs_to_jiffies(2000))) {
+		dev_err(sfc->dev, "DMA wait for transfer finish timeout\n");
+		ret = -ETIMEDOUT;
+	}
+	rockchip_sfc_irq_mask(sfc, SFC_IMR_DMA);
+
+	return ret;
+}
+
+static void rockchip_sfc_dirmap_cmd(struct rockchip_sfc *sfc,
+				    struct rockchip_sfc_dirmap *map,
+				    u8 cs, u32 addr, u32 len)
+{
+	u32 cmd = map->cmd;
+
+	if (sfc->version >= SFC_VER_4)
+		writel(len, sfc->regbase + SFC_LEN_EXT);
+	else
+		cmd |= len << SFC_CMD_TRAN_BYTES_SHIFT;
+	writel(map->ctrl, sfc->regbase + cs * SFC_CS1_REG_OFFSET + SFC_CTRL);
+	writel(cmd, sfc->regbase + SFC_CMD);
+	writel(addr, sfc->regbase + SFC_ADDR);
+}
+
+/*
+ * The whole request is read here in max_iosize chunks. Chunk completion
+ * comes from the dma irq. With the bounce buffer the two halves are
+ * used in turn, and the copy out of one chunk runs while the next is
+ * in flight, so the flash bus only idles for the command setup.
+ */
+static ssize_t rockchip_sfc_dirmap_read(struct spi_mem_dirmap_desc *desc,
+					u64 offs, size_t len, void *buf)
+{
+	struct spi_mem *mem = desc->mem;
+	struct rockchip_sfc *sfc = spi_master_get_devdata(mem->spi->master);
+	struct rockchip_sfc_dirmap *map = desc->priv;
+	u8 cs = mem->spi->chip_select;
+	u32 addr = desc->info.offset + offs;
+	dma_addr_t dma = DMA_MAPPING_ERROR;
+	size_t done = 0, pend = 0;
+	void *pend_buf = NULL;
+	int idx = 0, pend_idx = 0;
+	int ret;
+
+	ret = pm_runtime_get_sync(sfc->dev);
+	if (ret < 0) {
+		pm_runtime_put_noidle(sfc->dev);
+		return ret;
+	}
+
+	ret = rockchip_sfc_set_speed(sfc, mem);
+	if (ret)
+		goto out;
+
+	if (likely(sfc->use_dma) && virt_addr_valid(buf) &&
+	    IS_ALIGNED((unsigned long)buf | len, ARCH_DMA_MINALIGN)) {
+		dma = dma_map_single(sfc->dev, buf, len, DMA_FROM_DEVICE);
+		if (dma_mapping_error(sfc->dev, dma)) {
+			dma = DMA_MAPPING_ERROR;
+		} else if (upper_32_bits(dma + len - 1)) {
+			dma_unmap_single(sfc->dev, dma, len, DMA_FROM_DEVICE);
+			dma = DMA_MAPPING_ERROR;
+		}
+	}
+
+	rockchip_sfc_set_cs_gpio(sfc, cs, true);
+	if (map->abit)
+		writel(map->abit, sfc->regbase + cs * SFC_CS1_REG_OFFSET + SFC_ABIT);
+
+	while (done < len) {
+		u32 chunk = min_t(size_t, len - done, sfc->max_iosize);
+		bool use_dma = likely(sfc->use_dma) &&
+			       chunk >= SFC_DMA_TRANS_THRETHOLD && !(chunk & 0x3);
+
+		rockchip_sfc_dirmap_cmd(sfc, map, cs, addr + done, chunk);
+		if (use_dma && dma != DMA_MAPPING_ERROR)
+			rockchip_sfc_dma_start(sfc, dma + done, chunk);
+		else if (use_dma)
+			rockchip_sfc_dma_start(sfc, sfc->dma_buffer +
+					       idx * sfc->max_iosize, chunk);
+		else
+			ret = rockchip_sfc_read_fifo(sfc, buf + done, chunk);
+
+		/* copy out the previous chunk while this one is in flight */
+		if (pend) {
+			dma_sync_single_for_cpu(sfc->dev, sfc->dma_buffer +
+						pend_idx * sfc->max_iosize,
+						pend, DMA_FROM_DEVICE);
+			memcpy(pend_buf, sfc->buffer + pend_idx * sfc->max_iosize, pend);
+			pend = 0;
+		}
+
+		if (use_dma) {
+			ret = rockchip_sfc_dma_wait(sfc);
+			if (ret)
+				break;
+			if (dma == DMA_MAPPING_ERROR) {
+				pend = chunk;
+				pend_buf = buf + done;
+				pend_idx = idx;
+				idx ^= 1;
+			}
+		} else if (ret != chunk) {
+			dev_err(sfc->dev, "dirmap read failed ret %d\n", ret);
+			ret = -EIO;
+			break;
+		}
+
+		ret = rockchip_sfc_xfer_done(sfc, 100000);
+		if (ret)
+			break;
+		done += chunk;
+	}
+
+	if (!ret && pend) {
+		dma_sync_single_for_cpu(sfc->dev, sfc->dma_buffer +
+					pend_idx * sfc->max_iosize,
+					pend, DMA_FROM_DEVICE);
+		memcpy(pend_buf, sfc->buffer + pend_idx * sfc->max_iosize, pend);
+	}
+	if (dma != DMA_MAPPING_ERROR)
+		dma_unmap_single(sfc->dev, dma, len, DMA_FROM_DEVICE);
+
+	rockchip_sfc_set_cs_gpio(sfc, cs, false);
+out:
+	pm_runtime_mark_last_busy(sfc->dev);
+	pm_runtime_put_autosuspend(sfc->dev);
+
+	return ret ? ret : len;
+}
+
 static const struct spi_controller_mem_ops rockchip_sfc_mem_ops = {
 	.exec_op = rockchip_sfc_exec_mem_op,
 	.adjust_op_size = rockchip_sfc_adjust_op_size,
+	.dirmap_create = rockchip_sfc_dirmap_create,
+	.dirmap_destroy = rockchip_sfc_dirmap_destroy,
+	.dirmap_read = rockchip_sfc_dirmap_read,
 };
 
 static irqreturn_t rockchip_sfc_irq_handler(int irq, void *dev_id)
@@ -952,7 +1170,9 @@ static int rockchip_sfc_probe(struct platform_device *pdev)
 	pm_runtime_get_noresume(dev);
 
 	if (sfc->use_dma) {
-		sfc->buffer = (u8 *)__get_free_pages(GFP_KERNEL | GFP_DMA32, get_order(sfc->max_iosize));
+		/* two halves so dirmap reads can copy one while filling the other */
+		sfc->buffer = (u8 *)__get_free_pages(GFP_KERNEL | GFP_DMA32,
+						     get_order(sfc->max_iosize * 2));
 		if (!sfc->buffer) {
 			return -ENOMEM;
 			goto err_dma;
@@ -970,7 +1190,7 @@ static int rockchip_sfc_probe(struct platform_device *pdev)
 	return 0;
 
 err_register:
-	free_pages((unsigned long)sfc->buffer, get_order(sfc->max_iosize));
+	free_pages((unsigned long)sfc->buffer, get_order(sfc->max_iosize * 2));
 err_dma:
 	pm_runtime_disable(sfc->dev);
 	pm_runtime_set_suspended(sfc->dev);
@@ -988,7 +1208,7 @@ static int rockchip_sfc_remove(struct platform_device *pdev)
 	struct rockchip_sfc *sfc = platform_get_drvdata(pdev);
 	struct spi_master *master = sfc->master;
 
-	free_pages((unsigned long)sfc->buffer, get_order(sfc->max_iosize));
+	free_pages((unsigned long)sfc->buffer, get_order(sfc->max_iosize * 2));
 	spi_unregister_master(master);
 
 	clk_disable_unprepare(sfc->clk);
@@ -203,6 +203,11 @@ struct rockchip_spi {
 	u32 version;
 	/*depth of the FIFO buffer */
 	u32 fifo_len;
+	/* transfers of at least this many words go by dma */
+	u32 dma_threshold;
+	/* slave config last written to each channel, 0 if none */
+	u32 rx_conf;
+	u32 tx_conf;
 	/* frequency of spiclk */
 	u32 freq;
 	/* speed of io rate */
@@ -470,10 +475,41 @@ static u32 rockchip_spi_calc_burst_size(u32 data_len)
 	return i;
 }
 
+/*
+ * the caller mapped the buffers of the message itself and passed them in
+ * tx_dma / rx_dma, see spi_message.is_dma_mapped. The core maps nothing
+ * for such a message, so a panel or radar client can stream from one
+ * persistent buffer with no map, unmap and cache maintenance per frame.
+ */
+static bool rockchip_spi_premapped(struct spi_controller *ctlr,
+				   struct spi_transfer *xfer)
+{
+	if (!ctlr->cur_msg || !ctlr->cur_msg->is_dma_mapped)
+		return false;
+
+	return (!xfer->tx_buf || xfer->tx_dma) && (!xfer->rx_buf || xfer->rx_dma);
+}
+
+/* the slave config only changes with the word size and the burst */
+static void rockchip_spi_dma_config(struct dma_chan *chan, u32 *cur,
+				    struct dma_slave_config *conf)
+{
+	u32 key = conf->direction << 16 | conf->src_addr_width << 8 |
+		  conf->src_maxburst | conf->dst_addr_width << 8 |
+		  conf->dst_maxburst;
+
+	if (*cur == key)
+		return;
+
+	if (!dmaengine_slave_config(chan, conf))
+		*cur = key;
+}
+
 static int rockchip_spi_prepare_dma(struct rockchip_spi *rs,
 		struct spi_controller *ctlr, struct spi_transfer *xfer)
 {
 	struct dma_async_tx_descriptor *rxdesc, *txdesc;
+	bool premapped = rockchip_spi_premapped(ctlr, xfer);
 
 	atomic_set(&rs->state, 0);
 
@@ -486,12 +522,17 @@ static int rockchip_spi_prepare_dma(struct rockchip_spi *rs,
 			.src_maxburst = rockchip_spi_calc_burst_size(xfer->len / rs->n_bytes),
 		};
 
-		dmaengine_slave_config(ctlr->dma_rx, &rxconf);
+		rockchip_spi_dma_config(ctlr->dma_rx, &rs->rx_conf, &rxconf);
 
-		rxdesc = dmaengine_prep_slave_sg(
-				ctlr->dma_rx,
-				xfer->rx_sg.sgl, xfer->rx_sg.nents,
-				DMA_DEV_TO_MEM, DMA_PREP_INTERRUPT);
+		if (premapped)
+			rxdesc = dmaengine_prep_slave_single(
+					ctlr->dma_rx, xfer->rx_dma, xfer->len,
+					DMA_DEV_TO_MEM, DMA_PREP_INTERRUPT);
+		else
+			rxdesc = dmaengine_prep_slave_sg(
+					ctlr->dma_rx,
+					xfer->rx_sg.sgl, xfer->rx_sg.nents,
+					DMA_DEV_TO_MEM, DMA_PREP_INTERRUPT);
 		if (!rxdesc)
 			return -EINVAL;
 
@@ -508,12 +549,17 @@ static int rockchip_spi_prepare_dma(struct rockchip_spi *rs,
 			.dst_maxburst = rs->fifo_len / 4,
 		};
 
-		dmaengine_slave_config(ctlr->dma_tx, &txconf);
+		rockchip_spi_dma_config(ctlr->dma_tx, &rs->tx_conf, &txconf);
 
-		txdesc = dmaengine_prep_slave_sg(
-				ctlr->dma_tx,
-				xfer->tx_sg.sgl, xfer->tx_sg.nents,
-				DMA_MEM_TO_DEV, DMA_PREP_INTERRUPT);
+		if (premapped)
+			txdesc = dmaengine_prep_slave_single(
+					ctlr->dma_tx, xfer->tx_dma, xfer->len,
+					DMA_MEM_TO_DEV, DMA_PREP_INTERRUPT);
+		else
+			txdesc = dmaengine_prep_slave_sg(
+					ctlr->dma_tx,
+					xfer->tx_sg.sgl, xfer->tx_sg.nents,
+					DMA_MEM_TO_DEV, DMA_PREP_INTERRUPT);
 		if (!txdesc) {
 			if (rxdesc)
 				dmaengine_terminate_sync(ctlr->dma_rx);
@@ -811,7 +857,8 @@ static int rockchip_spi_transfer_one(
 	if (rs->poll) {
 		xfer_mode = ROCKCHIP_SPI_POLL;
 	} else {
-		use_dma = ctlr->can_dma ? ctlr->can_dma(ctlr, spi, xfer) : false;
+		use_dma = ctlr->can_dma ? ctlr->can_dma(ctlr, spi, xfer) ||
+			  rockchip_spi_premapped(ctlr, xfer) : false;
 		if (use_dma)
 			xfer_mode = ROCKCHIP_SPI_DMA;
 		else
@@ -842,11 +889,17 @@ static bool rockchip_spi_can_dma(struct spi_controller *ctlr,
 	struct rockchip_spi *rs = spi_controller_get_devdata(ctlr);
 	unsigned int bytes_per_word = xfer->bits_per_word <= 8 ? 1 : 2;
 
+	/* mapped by the caller, the core must not map it again */
+	if (rockchip_spi_premapped(ctlr, xfer))
+		return false;
+
 	/* if the numbor of spi words to transfer is less than the fifo
 	 * length we can just fill the fifo and wait for a single irq,
-	 * so don't bother setting up dma
+	 * so don't bother setting up dma. Boards may move the threshold
+	 * up with rockchip,dma-threshold where the dma setup costs more
+	 * than a few more fifo irqs.
 	 */
-	return xfer->len / bytes_per_word >= rs->fifo_len;
+	return xfer->len / bytes_per_word >= rs->dma_threshold;
 }
 
 static int rockchip_spi_setup(struct spi_device *spi)
@@ -1061,6 +1114,10 @@ static int rockchip_spi_probe(struct platform_device *pdev)
 		ret = -EINVAL;
 		goto err_disable_sclk_in;
 	}
+	if (device_property_read_u32(&pdev->dev, "rockchip,dma-threshold",
+				     &rs->dma_threshold) ||
+	    rs->dma_threshold < rs->fifo_len)
+		rs->dma_threshold = rs->fifo_len;
 	quirks_cfg = device_get_match_data(&pdev->dev);
 	if (quirks_cfg)
 		rs->max_baud_div_in_cpha = quirks_cfg->max_baud_div_in_cpha;
@@ -50,6 +50,15 @@ struct uart_8250_dma {
 	unsigned char		rx_running;
 #if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
 	size_t			rx_index;
+	/* the cyclic rx ring is drained every rx_period bytes */
+	size_t			rx_period;
+
+	/* rx ring stats, under the port lock */
+	unsigned long		rx_period_drains;
+	unsigned long		rx_idle_drains;
+	/* a period drain found more than a period, the ring nearly wrapped */
+	unsigned long		rx_late;
+	size_t			rx_max_drain;
 #endif
 };
 
@@ -16,6 +16,8 @@
 #define MAX_FIFO_SIZE		64
 #define UART_RFL_16550A		0x21
 #define DW_UART_DMASA		0x2a
+/* periods of the cyclic rx ring */
+#define RX_DMA_PERIODS		4
 #endif
 
 static void __dma_tx_complete(void *param)
@@ -49,7 +51,8 @@ static void __dma_tx_complete(void *param)
 
 #if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
 
-static void __dma_rx_complete(void *param)
+/* drains the ring up to the dma position, with the port lock held */
+static unsigned int __dma_rx_complete(void *param)
 {
 	struct uart_8250_port	*p = param;
 	struct uart_8250_dma	*dma = p->dma;
@@ -61,7 +64,7 @@ static void __dma_rx_complete(void *param)
 	cur_index = dma->rx_size - state.residue;
 
 	if (cur_index == dma->rx_index)
-		return;
+		return 0;
 	else if (cur_index > dma->rx_index)
 		count = cur_index - dma->rx_index;
 	else
@@ -76,6 +79,32 @@ static void __dma_rx_complete(void *param)
 
 	p->port.icount.rx += count;
 	dma->rx_index = cur_index;
+	if (count > dma->rx_max_drain)
+		dma->rx_max_drain = count;
+
+	return count;
+}
+
+/*
+ * a streaming link never goes idle long enough for the rx timeout irq,
+ * so the ring is also drained at every period boundary
+ */
+static void __dma_rx_period(void *param)
+{
+	struct uart_8250_port	*p = param;
+	struct uart_8250_dma	*dma = p->dma;
+	unsigned long		flags;
+	unsigned int		count;
+
+	spin_lock_irqsave(&p->port.lock, flags);
+	count = __dma_rx_complete(p);
+	if (count) {
+		dma->rx_period_drains++;
+		if (count > dma->rx_period)
+			dma->rx_late++;
+		tty_flip_buffer_push(&p->port.state->port);
+	}
+	spin_unlock_irqrestore(&p->port.lock, flags);
 }
 
 #else
@@ -190,6 +219,7 @@ int serial8250_rx_dma(struct uart_8250_port *p)
 		buf[i++] = serial_port_in(port, UART_RX);
 
 	__dma_rx_complete(p);
+	dma->rx_idle_drains++;
 
 	tty_insert_flip_string(tty_port, buf, i);
 	p->port.icount.rx += i;
@@ -206,15 +236,15 @@ int serial8250_start_rx_dma(struct uart_8250_port *p)
 	struct dma_async_tx_descriptor	*desc;
 
 	desc = dmaengine_prep_dma_cyclic(dma->rxchan, dma->rx_addr,
-					 dma->rx_size, dma->rx_size,
+					 dma->rx_size, dma->rx_period,
 					 DMA_DEV_TO_MEM, DMA_PREP_INTERRUPT |
 					 DMA_CTRL_ACK);
 	if (!desc)
 		return -EBUSY;
 
 	dma->rx_running = 1;
-	desc->callback = NULL;
-	desc->callback_param = NULL;
+	desc->callback = __dma_rx_period;
+	desc->callback_param = p;
 
 	dma->rx_cookie = dmaengine_submit(desc);
 	dma_async_issue_pending(dma->rxchan);
@@ -317,6 +347,7 @@ int serial8250_request_dma(struct uart_8250_port *p)
 #if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
 	if (!dma->rx_size)
 		dma->rx_size = PAGE_SIZE * 2;
+	dma->rx_period = dma->rx_size / RX_DMA_PERIODS;
 #else
 	if (!dma->rx_size)
 		dma->rx_size = PAGE_SIZE;
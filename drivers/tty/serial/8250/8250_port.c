@@ -1928,6 +1928,9 @@ int serial8250_handle_irq(struct uart_port *port, unsigned int iir)
 
 		if (!up->dma || dma_err)
 			status = serial8250_rx_chars(up, status);
+		else if (status & UART_LSR_OE)
+			/* drained by dma, rx_chars did not see the overrun */
+			port->icount.overrun++;
 	}
 #else
 	/*
@@ -3220,8 +3223,45 @@ static ssize_t rx_trig_bytes_store(struct device *dev,
 
 static DEVICE_ATTR_RW(rx_trig_bytes);
 
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+static ssize_t rx_dma_stats_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct tty_port *port = dev_get_drvdata(dev);
+	struct uart_state *state = container_of(port, struct uart_state, port);
+	struct uart_port *uport;
+	struct uart_8250_dma *dma;
+	unsigned long flags;
+	ssize_t len = 0;
+
+	mutex_lock(&port->mutex);
+	uport = state->uart_port;
+	dma = uport ? up_to_u8250p(uport)->dma : NULL;
+	if (dma && dma->rxchan) {
+		spin_lock_irqsave(&uport->lock, flags);
+		len = scnprintf(buf, PAGE_SIZE,
+				"ring:%zu period:%zu period drains:%lu idle drains:%lu late:%lu max drain:%zu overrun:%u\n",
+				dma->rx_size, dma->rx_period,
+				dma->rx_period_drains, dma->rx_idle_drains,
+				dma->rx_late, dma->rx_max_drain,
+				uport->icount.overrun);
+		spin_unlock_irqrestore(&uport->lock, flags);
+	} else {
+		len = scnprintf(buf, PAGE_SIZE, "no rx dma\n");
+	}
+	mutex_unlock(&port->mutex);
+
+	return len;
+}
+
+static DEVICE_ATTR_RO(rx_dma_stats);
+#endif
+
 static struct attribute *serial8250_dev_attrs[] = {
 	&dev_attr_rx_trig_bytes.attr,
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	&dev_attr_rx_dma_stats.attr,
+#endif
 	NULL
 };
 
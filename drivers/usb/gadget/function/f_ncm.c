@@ -75,6 +75,8 @@ struct f_ncm {
 	bool				timer_force_tx;
 	struct hrtimer			task_timer;
 	bool				timer_stopping;
+	u32				tx_timeout_ns;
+	u32				tx_flush_bytes;
 };
 
 static inline struct f_ncm *func_to_ncm(struct usb_function *f)
@@ -117,6 +119,7 @@ static inline unsigned ncm_bitrate(struct usb_gadget *g)
 
 /* Delay for the transmit to wait before sending an unfilled NTB frame. */
 #define TX_TIMEOUT_NSECS	300000
+#define TX_TIMEOUT_MAX_USECS	10000
 
 #define FORMATS_SUPPORTED	(USB_CDC_NCM_NTB16_SUPPORTED |	\
 				 USB_CDC_NCM_NTB32_SUPPORTED)
@@ -1103,7 +1106,7 @@ static struct sk_buff *ncm_wrap_ntb(struct gether *port,
 			/* Note: we skip opts->next_ndp_index */
 
 			/* Start the timer. */
-			hrtimer_start(&ncm->task_timer, TX_TIMEOUT_NSECS,
+			hrtimer_start(&ncm->task_timer, ncm->tx_timeout_ns,
 				      HRTIMER_MODE_REL_SOFT);
 		}
 
@@ -1126,6 +1129,18 @@ static struct sk_buff *ncm_wrap_ntb(struct gether *port,
 		dev_consume_skb_any(skb);
 		skb = NULL;
 
+		/*
+		 * Send the NTB once it holds enough data rather than
+		 * waiting for it to fill up or for the timer. If an NTB
+		 * went out above already, this one goes with the next.
+		 */
+		if (!skb2 && ncm->tx_flush_bytes &&
+		    ncm->skb_tx_data->len >= ncm->tx_flush_bytes) {
+			skb2 = package_for_tx(ncm);
+			if (!skb2)
+				goto err;
+		}
+
 	} else if (ncm->skb_tx_data && ncm->timer_force_tx) {
 		/* If the tx was requested because of a timeout then send */
 		skb2 = package_for_tx(ncm);
@@ -1594,11 +1609,100 @@ USB_ETHERNET_CONFIGFS_ITEM_ATTR_QMULT(ncm);
 /* f_ncm_opts_ifname */
 USB_ETHERNET_CONFIGFS_ITEM_ATTR_IFNAME(ncm);
 
+static ssize_t ncm_opts_tx_timeout_us_show(struct config_item *item,
+					   char *page)
+{
+	struct f_ncm_opts *opts = to_f_ncm_opts(item);
+	int ret;
+
+	mutex_lock(&opts->lock);
+	ret = sprintf(page, "%u\n", opts->tx_timeout_us);
+	mutex_unlock(&opts->lock);
+
+	return ret;
+}
+
+static ssize_t ncm_opts_tx_timeout_us_store(struct config_item *item,
+					    const char *page, size_t len)
+{
+	struct f_ncm_opts *opts = to_f_ncm_opts(item);
+	u32 val;
+	int ret;
+
+	mutex_lock(&opts->lock);
+	if (opts->refcnt) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	ret = kstrtou32(page, 0, &val);
+	if (ret)
+		goto out;
+	if (!val || val > TX_TIMEOUT_MAX_USECS) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	opts->tx_timeout_us = val;
+	ret = len;
+out:
+	mutex_unlock(&opts->lock);
+	return ret;
+}
+
+CONFIGFS_ATTR(ncm_opts_, tx_timeout_us);
+
+static ssize_t ncm_opts_tx_flush_bytes_show(struct config_item *item,
+					    char *page)
+{
+	struct f_ncm_opts *opts = to_f_ncm_opts(item);
+	int ret;
+
+	mutex_lock(&opts->lock);
+	ret = sprintf(page, "%u\n", opts->tx_flush_bytes);
+	mutex_unlock(&opts->lock);
+
+	return ret;
+}
+
+static ssize_t ncm_opts_tx_flush_bytes_store(struct config_item *item,
+					     const char *page, size_t len)
+{
+	struct f_ncm_opts *opts = to_f_ncm_opts(item);
+	u32 val;
+	int ret;
+
+	mutex_lock(&opts->lock);
+	if (opts->refcnt) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	/* 0 sends an NTB only when it is full or the timer fires */
+	ret = kstrtou32(page, 0, &val);
+	if (ret)
+		goto out;
+	if (val > NTB_DEFAULT_IN_SIZE) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	opts->tx_flush_bytes = val;
+	ret = len;
+out:
+	mutex_unlock(&opts->lock);
+	return ret;
+}
+
+CONFIGFS_ATTR(ncm_opts_, tx_flush_bytes);
+
 static struct configfs_attribute *ncm_attrs[] = {
 	&ncm_opts_attr_dev_addr,
 	&ncm_opts_attr_host_addr,
 	&ncm_opts_attr_qmult,
 	&ncm_opts_attr_ifname,
+	&ncm_opts_attr_tx_timeout_us,
+	&ncm_opts_attr_tx_flush_bytes,
 	NULL,
 };
 
@@ -1634,6 +1738,7 @@ static struct usb_function_instance *ncm_alloc_inst(void)
 	opts->ncm_os_desc.ext_compat_id = opts->ncm_ext_compat_id;
 
 	mutex_init(&opts->lock);
+	opts->tx_timeout_us = TX_TIMEOUT_NSECS / NSEC_PER_USEC;
 	opts->func_inst.free_func_inst = ncm_free_inst;
 	opts->net = gether_setup_default();
 	if (IS_ERR(opts->net)) {
@@ -1722,6 +1827,8 @@ static struct usb_function *ncm_alloc(struct usb_function_instance *fi)
 
 	spin_lock_init(&ncm->lock);
 	ncm_reset_values(ncm);
+	ncm->tx_timeout_ns = opts->tx_timeout_us * NSEC_PER_USEC;
+	ncm->tx_flush_bytes = opts->tx_flush_bytes;
 	ncm->port.ioport = netdev_priv(opts->net);
 	mutex_unlock(&opts->lock);
 	ncm->port.is_fixed = true;
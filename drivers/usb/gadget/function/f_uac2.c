@@ -1322,6 +1322,8 @@ afunc_bind(struct usb_configuration *cfg, struct usb_function *fn)
 	}
 	agdev->params.req_number = uac2_opts->req_number;
 	agdev->params.fb_max = uac2_opts->fb_max;
+	agdev->params.req_batch = uac2_opts->req_batch;
+	agdev->params.fb_auto = uac2_opts->fb_auto;
 
 	if (FUOUT_EN(uac2_opts) || FUIN_EN(uac2_opts))
     agdev->notify = afunc_notify;
@@ -2092,6 +2094,8 @@ UAC2_ATTRIBUTE(s16, c_volume_min);
 UAC2_ATTRIBUTE(s16, c_volume_max);
 UAC2_ATTRIBUTE(s16, c_volume_res);
 UAC2_ATTRIBUTE(u32, fb_max);
+UAC2_ATTRIBUTE(u32, req_batch);
+UAC2_ATTRIBUTE(bool, fb_auto);
 UAC2_ATTRIBUTE_STRING(function_name);
 
 static struct configfs_attribute *f_uac2_attrs[] = {
@@ -2106,6 +2110,8 @@ static struct configfs_attribute *f_uac2_attrs[] = {
 	&f_uac2_opts_attr_c_sync,
 	&f_uac2_opts_attr_req_number,
 	&f_uac2_opts_attr_fb_max,
+	&f_uac2_opts_attr_req_batch,
+	&f_uac2_opts_attr_fb_auto,
 
 	&f_uac2_opts_attr_p_mute_present,
 	&f_uac2_opts_attr_p_volume_present,
@@ -2176,6 +2182,7 @@ static struct usb_function_instance *afunc_alloc_inst(void)
 
 	opts->req_number = UAC2_DEF_REQ_NUM;
 	opts->fb_max = FBACK_FAST_MAX;
+	opts->req_batch = UAC2_DEF_REQ_BATCH;
 
 	snprintf(opts->function_name, sizeof(opts->function_name), "Source/Sink");
 
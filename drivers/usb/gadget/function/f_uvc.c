@@ -6,6 +6,7 @@
  *	    Laurent Pinchart (laurent.pinchart@ideasonboard.com)
  */
 
+#include <linux/debugfs.h>
 #include <linux/device.h>
 #include <linux/errno.h>
 #include <linux/fs.h>
@@ -13,7 +14,9 @@
 #include <linux/list.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
+#include <linux/seq_file.h>
 #include <linux/string.h>
+#include <linux/usb.h>
 #include <linux/usb/ch9.h>
 #include <linux/usb/gadget.h>
 #include <linux/usb/g_uvc.h>
@@ -579,6 +582,77 @@ static ssize_t function_name_show(struct device *dev,
 
 static DEVICE_ATTR_RO(function_name);
 
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+/* per frame qbuf to buffer done latency of the current stream */
+static ssize_t pump_latency_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct uvc_device *uvc = dev_get_drvdata(dev);
+	struct uvc_video_queue *queue = &uvc->video.queue;
+	struct rk_lat_hist hist;
+	unsigned long flags;
+	ssize_t len;
+	u32 i;
+
+	spin_lock_irqsave(&queue->irqlock, flags);
+	hist = queue->pump_lat;
+	spin_unlock_irqrestore(&queue->irqlock, flags);
+
+	len = sysfs_emit(buf, "cnt:%llu avg:%lluus max:%uus\n", hist.cnt,
+			 hist.cnt ? div64_u64(hist.sum_us, hist.cnt) : 0,
+			 hist.max_us);
+	for (i = 0; i < RK_LAT_HIST_BUCKETS; i++) {
+		if (!hist.bucket[i])
+			continue;
+		if (i == RK_LAT_HIST_BUCKETS - 1)
+			len += sysfs_emit_at(buf, len, "[%u, inf) us: %u\n",
+					     1U << (i - 1), hist.bucket[i]);
+		else
+			len += sysfs_emit_at(buf, len, "[%u, %u) us: %u\n",
+					     i ? 1U << (i - 1) : 0, 1U << i,
+					     hist.bucket[i]);
+	}
+
+	return len;
+}
+
+static DEVICE_ATTR_RO(pump_latency);
+
+static int uvc_stats_show(struct seq_file *s, void *unused)
+{
+	struct uvc_device *uvc = s->private;
+	struct uvc_video *video = &uvc->video;
+	struct uvc_video_queue *queue = &video->queue;
+	struct rk_lat_hist hist;
+	unsigned long flags;
+	u32 frames, fps;
+
+	spin_lock_irqsave(&queue->irqlock, flags);
+	frames = queue->sequence;
+	fps = queue->fps;
+	hist = queue->pump_lat;
+	spin_unlock_irqrestore(&queue->irqlock, flags);
+
+	seq_printf(s, "streaming: %d\n", uvc->state == UVC_STATE_STREAMING);
+	if (video->ep && video->ep->desc)
+		seq_printf(s, "transfer: %s interval: %u\n",
+			   usb_endpoint_xfer_bulk(video->ep->desc) ?
+			   "bulk" : "isoc", video->ep->desc->bInterval);
+	seq_printf(s, "requests: %d/%u size: %u\n",
+		   atomic_read(&video->reqs_queued), video->uvc_num_requests,
+		   video->req_size);
+	seq_printf(s, "frames: %u fps: %u\n", frames, fps);
+	seq_printf(s, "underruns: %d refills: %d\n",
+		   atomic_read(&video->underruns),
+		   atomic_read(&video->refills));
+	rk_lat_hist_show(s, "pump", &hist);
+
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(uvc_stats);
+#endif
+
 static int
 uvc_register_video(struct uvc_device *uvc)
 {
@@ -607,6 +681,20 @@ uvc_register_video(struct uvc_device *uvc)
 		return ret;
 	}
 
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	ret = device_create_file(&uvc->vdev.dev, &dev_attr_pump_latency);
+	if (ret < 0) {
+		device_remove_file(&uvc->vdev.dev, &dev_attr_function_name);
+		video_unregister_device(&uvc->vdev);
+		return ret;
+	}
+
+	uvc->debugfs = debugfs_create_dir(dev_name(&uvc->vdev.dev),
+					  usb_debug_root);
+	debugfs_create_file("stats", 0444, uvc->debugfs, uvc,
+			    &uvc_stats_fops);
+#endif
+
 	return 0;
 }
 
@@ -1214,6 +1302,11 @@ static void uvc_function_unbind(struct usb_configuration *c,
 		uvcg_dbg(f, "done waiting with ret: %ld\n", wait_ret);
 	}
 
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	debugfs_remove_recursive(uvc->debugfs);
+	uvc->debugfs = NULL;
+	device_remove_file(&uvc->vdev.dev, &dev_attr_pump_latency);
+#endif
 	device_remove_file(&uvc->vdev.dev, &dev_attr_function_name);
 	video_unregister_device(&uvc->vdev);
 	v4l2_device_unregister(&uvc->v4l2_dev);
@@ -37,6 +37,9 @@ enum {
 
 #define CLK_PPM_GROUP_SIZE	20
 
+/* auto feedback pulls the capture ring back to half full in about this */
+#define FBACK_AUTO_TAU_SEC	4
+
 /* Runtime data params for one stream */
 struct uac_rtd_params {
 	struct snd_uac_chip *uac; /* parent chip */
@@ -150,6 +153,59 @@ static void u_audio_set_fback_frequency(enum usb_device_speed speed,
 	*(__le32 *)buf = cpu_to_le32(ff);
 }
 
+/*
+ * Only the last request of each req_batch asks for an interrupt, the
+ * controller then gives back the whole batch at once. Batching needs
+ * a second batch queued while the first one completes.
+ */
+static bool u_audio_req_no_interrupt(const struct uac_params *params, int i)
+{
+	int batch = params->req_batch;
+
+	if (batch <= 1 || params->req_number < 2 * batch ||
+	    params->req_number % batch)
+		return false;
+
+	return (i % batch) != batch - 1;
+}
+
+/*
+ * Rate matching for async OUT: whoever drains the capture ring does so
+ * at the local (I2S) clock, so its fill level tells how far the host is
+ * off. Steer the pitch to keep the ring half full.
+ */
+static void u_audio_fback_auto(struct uac_rtd_params *prm,
+			       const struct uac_params *params)
+{
+	struct snd_pcm_substream *substream = prm->ss;
+	struct snd_pcm_runtime *runtime;
+	snd_pcm_sframes_t avail, err;
+	long long pitch;
+
+	if (!substream)
+		return;
+
+	snd_pcm_stream_lock(substream);
+	runtime = substream->runtime;
+	if (!runtime || !snd_pcm_running(substream)) {
+		snd_pcm_stream_unlock(substream);
+		return;
+	}
+
+	avail = bytes_to_frames(runtime, prm->hw_ptr) -
+		runtime->control->appl_ptr % runtime->buffer_size;
+	if (avail < 0)
+		avail += runtime->buffer_size;
+	err = avail - runtime->buffer_size / 2;
+	snd_pcm_stream_unlock(substream);
+
+	pitch = 1000000LL - div_s64(err * 1000000LL,
+				    prm->srate * FBACK_AUTO_TAU_SEC);
+	prm->pitch = clamp_t(long long, pitch,
+			     (1000 - FBACK_SLOW_MAX) * 1000,
+			     (1000 + params->fb_max) * 1000);
+}
+
 static void u_audio_iso_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	unsigned int pending;
@@ -307,6 +363,9 @@ static void u_audio_iso_fback_complete(struct usb_ep *ep,
 		pr_debug("%s: iso_complete status(%d) %d/%d\n",
 			__func__, status, req->actual, req->length);
 
+	if (audio_dev->params.fb_auto)
+		u_audio_fback_auto(prm, &audio_dev->params);
+
 	u_audio_set_fback_frequency(audio_dev->gadget->speed, audio_dev->out_ep,
 				    prm->srate, prm->pitch,
 				    req->buf);
@@ -634,6 +693,7 @@ int u_audio_start_capture(struct g_audio *audio_dev)
 			prm->reqs[i] = req;
 
 			req->zero = 0;
+			req->no_interrupt = u_audio_req_no_interrupt(params, i);
 			req->context = prm;
 			req->length = req_len;
 			req->complete = u_audio_iso_complete;
@@ -770,6 +830,7 @@ int u_audio_start_playback(struct g_audio *audio_dev)
 			prm->reqs[i] = req;
 
 			req->zero = 0;
+			req->no_interrupt = u_audio_req_no_interrupt(params, i);
 			req->context = prm;
 			req->length = req_len;
 			req->complete = u_audio_iso_complete;
@@ -57,6 +57,8 @@ struct uac_params {
 
 	int req_number; /* number of preallocated requests */
 	int fb_max;	/* upper frequency drift feedback limit per-mil */
+	int req_batch;	/* requests completed per interrupt */
+	bool fb_auto;	/* feedback follows the capture ring fill level */
 };
 
 enum usb_state_index {
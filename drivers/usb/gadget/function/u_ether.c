@@ -64,6 +64,9 @@ struct eth_dev {
 	atomic_t		tx_qlen;
 
 	struct sk_buff_head	rx_frames;
+	/* unwrapped frames handed from rx_complete() to napi for gro */
+	struct sk_buff_head	rx_gro;
+	struct napi_struct	napi;
 
 	unsigned		qmult;
 
@@ -300,10 +303,12 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 			/* no buffer copies needed, unless hardware can't
 			 * use skb buffers.
 			 */
-			status = netif_rx(skb2);
+			skb_queue_tail(&dev->rx_gro, skb2);
 next_frame:
 			skb2 = skb_dequeue(&dev->rx_frames);
 		}
+		if (!skb_queue_empty(&dev->rx_gro))
+			napi_schedule(&dev->napi);
 		break;
 
 	/* software-driven interface shutdown */
@@ -344,6 +349,32 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 		rx_submit(dev, req, GFP_ATOMIC);
 }
 
+/*
+ * Frames of one NTB or one RNDIS transfer usually belong to the same
+ * flows, so pass them up through gro rather than one by one through
+ * netif_rx().
+ */
+static int eth_napi_poll(struct napi_struct *napi, int budget)
+{
+	struct eth_dev	*dev = container_of(napi, struct eth_dev, napi);
+	struct sk_buff	*skb;
+	int		work = 0;
+
+	while (work < budget) {
+		skb = skb_dequeue(&dev->rx_gro);
+		if (!skb)
+			break;
+		napi_gro_receive(napi, skb);
+		work++;
+	}
+
+	if (work < budget && napi_complete_done(napi, work) &&
+	    !skb_queue_empty(&dev->rx_gro))
+		napi_schedule(napi);
+
+	return work;
+}
+
 static int prealloc(struct list_head *list, struct usb_ep *ep, unsigned n)
 {
 	unsigned		i;
@@ -628,6 +659,7 @@ static int eth_open(struct net_device *net)
 	struct gether	*link;
 
 	DBG(dev, "%s\n", __func__);
+	napi_enable(&dev->napi);
 	if (netif_carrier_ok(dev->net))
 		eth_start(dev, GFP_KERNEL);
 
@@ -686,6 +718,9 @@ static int eth_stop(struct net_device *net)
 	}
 	spin_unlock_irqrestore(&dev->lock, flags);
 
+	napi_disable(&dev->napi);
+	skb_queue_purge(&dev->rx_gro);
+
 	return 0;
 }
 
@@ -767,6 +802,7 @@ struct eth_dev *gether_setup_name(struct usb_gadget *g,
 	INIT_LIST_HEAD(&dev->rx_reqs);
 
 	skb_queue_head_init(&dev->rx_frames);
+	skb_queue_head_init(&dev->rx_gro);
 
 	/* network device setup */
 	dev->net = net;
@@ -790,6 +826,7 @@ struct eth_dev *gether_setup_name(struct usb_gadget *g,
 	net->netdev_ops = &eth_netdev_ops;
 
 	net->ethtool_ops = &ops;
+	netif_napi_add(net, &dev->napi, eth_napi_poll, NAPI_POLL_WEIGHT);
 
 	/* MTU range: 14 - 15412 */
 	net->min_mtu = ETH_HLEN;
@@ -840,6 +877,7 @@ struct net_device *gether_setup_name_default(const char *netname)
 	net->addr_assign_type = NET_ADDR_RANDOM;
 
 	skb_queue_head_init(&dev->rx_frames);
+	skb_queue_head_init(&dev->rx_gro);
 
 	/* network device setup */
 	dev->net = net;
@@ -854,6 +892,7 @@ struct net_device *gether_setup_name_default(const char *netname)
 	net->netdev_ops = &eth_netdev_ops;
 
 	net->ethtool_ops = &ops;
+	netif_napi_add(net, &dev->napi, eth_napi_poll, NAPI_POLL_WEIGHT);
 	SET_NETDEV_DEVTYPE(net, &gadget_type);
 
 	/* MTU range: 14 - 15412 */
@@ -1060,6 +1099,7 @@ void gether_cleanup(struct eth_dev *dev)
 
 	unregister_netdev(dev->net);
 	flush_work(&dev->work);
+	skb_queue_purge(&dev->rx_gro);
 	free_netdev(dev->net);
 }
 EXPORT_SYMBOL_GPL(gether_cleanup);
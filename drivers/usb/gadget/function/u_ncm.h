@@ -23,6 +23,9 @@ struct f_ncm_opts {
 	struct config_group		*ncm_interf_group;
 	struct usb_os_desc		ncm_os_desc;
 	char				ncm_ext_compat_id[16];
+	/* tx ntb aggregation: timer and size to send an unfilled ntb */
+	u32				tx_timeout_us;
+	u32				tx_flush_bytes;
 	/*
 	 * Read/write access to configfs attributes is handled by configfs.
 	 *
@@ -33,6 +33,7 @@
 #define UAC2_DEF_RES_DB		(1*256)		/* 1 dB */
 
 #define UAC2_DEF_REQ_NUM 2
+#define UAC2_DEF_REQ_BATCH 1
 #define UAC2_DEF_INT_REQ_NUM	10
 
 struct f_uac2_opts {
@@ -61,6 +62,8 @@ struct f_uac2_opts {
 
 	int				req_number;
 	int				fb_max;
+	int				req_batch;
+	bool			fb_auto;
 	bool			bound;
 
 	char			function_name[32];
@@ -18,6 +18,16 @@
 #include <linux/usb/video.h>
 
 #define fi_to_f_uvc_opts(f)	container_of(f, struct f_uvc_opts, func_inst)
+
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+/*
+ * uvc_zero_copy modes
+ * GAP: contiguous producer buffer which leaves room for the payload headers
+ * SG: dmabuf sent as is, header and data chained in one sg request
+ */
+#define UVC_ZERO_COPY_GAP	1
+#define UVC_ZERO_COPY_SG	2
+#endif
 DECLARE_UVC_EXTENSION_UNIT_DESCRIPTOR(1, 1);
 
 struct f_uvc_opts {
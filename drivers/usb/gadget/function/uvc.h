@@ -69,6 +69,8 @@ extern unsigned int uvc_gadget_trace_param;
 
 #define UVC_MAX_REQUEST_SIZE			64
 #define UVC_MAX_EVENTS				4
+/* sg entries per request: header plus data */
+#define UVC_MAX_REQUEST_SG			64
 
 /* ------------------------------------------------------------------------
  * Structures
@@ -79,6 +81,10 @@ struct uvc_request {
 	struct uvc_video *video;
 #if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
 	struct completion req_done;
+	struct sg_table sgt;
+	struct scatterlist *sg_end;
+	/* frame whose last data is in this request */
+	struct uvc_buffer *last_buf;
 #endif
 };
 
@@ -113,6 +119,14 @@ struct uvc_video {
 
 	struct uvc_video_queue queue;
 	unsigned int fid;
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	/* requests owned by the udc */
+	atomic_t reqs_queued;
+	/* completions that left the udc with nothing to send */
+	atomic_t underruns;
+	/* completions refilled in place instead of by the pump */
+	atomic_t refills;
+#endif
 };
 
 enum uvc_state {
@@ -148,6 +162,10 @@ struct uvc_device {
 
 	unsigned int streaming_intf;
 
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	struct dentry *debugfs;
+#endif
+
 	/* Events */
 	unsigned int event_length;
 	unsigned int event_setup_out : 1;
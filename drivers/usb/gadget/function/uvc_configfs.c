@@ -2769,7 +2769,7 @@ UVCG_OPTS_ATTR(streaming_maxburst, streaming_maxburst, 15);
 UVCG_OPTS_ATTR(pm_qos_latency, pm_qos_latency, PM_QOS_LATENCY_ANY);
 #if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
 UVCG_OPTS_ATTR(uvc_num_request, uvc_num_request, 64);
-UVCG_OPTS_ATTR(uvc_zero_copy, uvc_zero_copy, 1);
+UVCG_OPTS_ATTR(uvc_zero_copy, uvc_zero_copy, UVC_ZERO_COPY_SG);
 #endif
 
 #undef UVCG_OPTS_ATTR
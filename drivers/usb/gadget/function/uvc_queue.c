@@ -134,7 +134,8 @@ static void *uvc_buffer_mem_prepare(struct vb2_buffer *vb,
 	struct f_uvc_opts *opts = fi_to_f_uvc_opts(uvc->func.fi);
 	void *mem;
 
-	if (!opts->uvc_zero_copy || video->fcc == V4L2_PIX_FMT_YUYV)
+	if (opts->uvc_zero_copy != UVC_ZERO_COPY_GAP ||
+	    video->fcc == V4L2_PIX_FMT_YUYV)
 		return (vb2_plane_vaddr(vb, 0) + vb2_plane_data_offset(vb, 0));
 
 	mem = uvc_dma_buf_phys_to_virt(uvc, vb->planes[0].dbuf);
@@ -143,6 +144,80 @@ static void *uvc_buffer_mem_prepare(struct vb2_buffer *vb,
 
 	return (mem + vb2_plane_data_offset(vb, 0));
 }
+
+static bool uvc_queue_use_sg(struct uvc_video_queue *queue)
+{
+	struct uvc_video *video = container_of(queue, struct uvc_video, queue);
+	struct uvc_device *uvc = container_of(video, struct uvc_device, video);
+	struct f_uvc_opts *opts = fi_to_f_uvc_opts(uvc->func.fi);
+
+	return opts->uvc_zero_copy == UVC_ZERO_COPY_SG &&
+	       uvc->func.config->cdev->gadget->sg_supported;
+}
+
+/*
+ * Map an imported dmabuf once for the udc, the pages are then chained
+ * straight into the usb requests without any copy. Called again by vb2
+ * whenever a different dmabuf is queued on this buffer.
+ */
+static int uvc_buffer_init(struct vb2_buffer *vb)
+{
+	struct uvc_video_queue *queue = vb2_get_drv_priv(vb->vb2_queue);
+	struct vb2_v4l2_buffer *vbuf = to_vb2_v4l2_buffer(vb);
+	struct uvc_buffer *buf = container_of(vbuf, struct uvc_buffer, buf);
+	struct uvc_video *video = container_of(queue, struct uvc_video, queue);
+	struct uvc_device *uvc = container_of(video, struct uvc_device, video);
+	struct usb_gadget *gadget = uvc->func.config->cdev->gadget;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+
+	if (vb->memory != VB2_MEMORY_DMABUF || !uvc_queue_use_sg(queue))
+		return 0;
+
+	attach = dma_buf_attach(vb->planes[0].dbuf, gadget->dev.parent);
+	if (IS_ERR(attach))
+		return PTR_ERR(attach);
+
+	sgt = dma_buf_map_attachment(attach, DMA_TO_DEVICE);
+	if (IS_ERR(sgt)) {
+		dma_buf_detach(vb->planes[0].dbuf, attach);
+		return PTR_ERR(sgt);
+	}
+
+	buf->db_attach = attach;
+	buf->sgt = sgt;
+
+	return 0;
+}
+
+static void uvc_buffer_cleanup(struct vb2_buffer *vb)
+{
+	struct vb2_v4l2_buffer *vbuf = to_vb2_v4l2_buffer(vb);
+	struct uvc_buffer *buf = container_of(vbuf, struct uvc_buffer, buf);
+
+	if (!buf->db_attach)
+		return;
+
+	dma_buf_unmap_attachment(buf->db_attach, buf->sgt, DMA_TO_DEVICE);
+	dma_buf_detach(vb->planes[0].dbuf, buf->db_attach);
+	buf->db_attach = NULL;
+	buf->sgt = NULL;
+}
+
+/* point the sg walk at the first payload byte */
+static void uvc_buffer_sg_prepare(struct vb2_buffer *vb, struct uvc_buffer *buf)
+{
+	unsigned int offset = vb2_plane_data_offset(vb, 0);
+	struct scatterlist *sg = buf->sgt->sgl;
+
+	while (sg && offset >= sg->length) {
+		offset -= sg->length;
+		sg = sg_next(sg);
+	}
+
+	buf->sg = sg;
+	buf->sg_offset = offset;
+}
 #endif
 
 static int uvc_buffer_prepare(struct vb2_buffer *vb)
@@ -162,7 +237,12 @@ static int uvc_buffer_prepare(struct vb2_buffer *vb)
 
 	buf->state = UVC_BUF_STATE_QUEUED;
 #if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
-	buf->mem = uvc_buffer_mem_prepare(vb, queue);
+	if (buf->sgt) {
+		uvc_buffer_sg_prepare(vb, buf);
+		buf->mem = NULL;
+	} else {
+		buf->mem = uvc_buffer_mem_prepare(vb, queue);
+	}
 	if (IS_ERR(buf->mem))
 		return -ENOMEM;
 #else
@@ -187,6 +267,9 @@ static void uvc_buffer_queue(struct vb2_buffer *vb)
 	spin_lock_irqsave(&queue->irqlock, flags);
 
 	if (likely(!(queue->flags & UVC_QUEUE_DISCONNECTED))) {
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+		buf->qbuf_ns = ktime_get_ns();
+#endif
 		list_add_tail(&buf->queue, &queue->irqqueue);
 	} else {
 		/* If the device is disconnected return the buffer to userspace
@@ -201,6 +284,10 @@ static void uvc_buffer_queue(struct vb2_buffer *vb)
 
 static const struct vb2_ops uvc_queue_qops = {
 	.queue_setup = uvc_queue_setup,
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	.buf_init = uvc_buffer_init,
+	.buf_cleanup = uvc_buffer_cleanup,
+#endif
 	.buf_prepare = uvc_buffer_prepare,
 	.buf_queue = uvc_buffer_queue,
 	.wait_prepare = vb2_ops_wait_prepare,
@@ -378,6 +465,12 @@ int uvcg_queue_enable(struct uvc_video_queue *queue, int enable)
 
 		queue->sequence = 0;
 		queue->buf_used = 0;
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+		rk_lat_hist_reset(&queue->pump_lat);
+		queue->fps_start_ns = ktime_get_ns();
+		queue->fps_frames = 0;
+		queue->fps = 0;
+#endif
 	} else {
 		ret = vb2_streamoff(&queue->queue, queue->queue.type);
 		if (ret < 0)
@@ -419,14 +512,43 @@ struct uvc_buffer *uvcg_queue_next_buffer(struct uvc_video_queue *queue,
 	else
 		nextbuf = NULL;
 
+	uvcg_queue_complete_buffer(queue, buf, false);
+
+	return nextbuf;
+}
+
+/*
+ * Hand a buffer already off the irq queue back to userspace, called with
+ * &queue_irqlock held. Sg buffers come here from the request completion
+ * of their last data, the others as soon as the data is copied.
+ */
+void uvcg_queue_complete_buffer(struct uvc_video_queue *queue,
+				struct uvc_buffer *buf, bool error)
+{
+	u64 now = ktime_get_ns();
+
 	buf->buf.field = V4L2_FIELD_NONE;
 	buf->buf.sequence = queue->sequence++;
-	buf->buf.vb2_buf.timestamp = ktime_get_ns();
+	buf->buf.vb2_buf.timestamp = now;
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	rk_lat_hist_add(&queue->pump_lat, now - buf->qbuf_ns);
+	if (now - queue->fps_start_ns >= NSEC_PER_SEC) {
+		queue->fps = queue->fps_frames;
+		queue->fps_frames = 0;
+		queue->fps_start_ns = now;
+	}
+	if (!error)
+		queue->fps_frames++;
+#endif
+
+	if (error) {
+		buf->state = UVC_BUF_STATE_ERROR;
+		vb2_buffer_done(&buf->buf.vb2_buf, VB2_BUF_STATE_ERROR);
+		return;
+	}
 
 	vb2_set_plane_payload(&buf->buf.vb2_buf, 0, buf->bytesused);
 	vb2_buffer_done(&buf->buf.vb2_buf, VB2_BUF_STATE_DONE);
-
-	return nextbuf;
 }
 
 struct uvc_buffer *uvcg_queue_head(struct uvc_video_queue *queue)
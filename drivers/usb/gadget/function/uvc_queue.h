@@ -7,6 +7,9 @@
 #include <linux/spinlock.h>
 
 #include <media/videobuf2-v4l2.h>
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+#include <soc/rockchip/rockchip_lat_hist.h>
+#endif
 
 struct file;
 struct mutex;
@@ -36,6 +39,15 @@ struct uvc_buffer {
 	void *mem;
 	unsigned int length;
 	unsigned int bytesused;
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	/* dmabuf mapped for UVC_ZERO_COPY_SG, NULL otherwise */
+	struct dma_buf_attachment *db_attach;
+	struct sg_table *sgt;
+	/* next data to send */
+	struct scatterlist *sg;
+	unsigned int sg_offset;
+	u64 qbuf_ns;
+#endif
 };
 
 #define UVC_QUEUE_DISCONNECTED		(1 << 0)
@@ -51,6 +63,14 @@ struct uvc_video_queue {
 
 	spinlock_t irqlock;	/* Protects flags and irqqueue */
 	struct list_head irqqueue;
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	/* qbuf to frame handed back, protected by irqlock */
+	struct rk_lat_hist pump_lat;
+	/* frames handed back in the current and the last one second window */
+	u64 fps_start_ns;
+	u32 fps_frames;
+	u32 fps;
+#endif
 };
 
 static inline int uvc_queue_streaming(struct uvc_video_queue *queue)
@@ -90,6 +110,9 @@ int uvcg_queue_enable(struct uvc_video_queue *queue, int enable);
 struct uvc_buffer *uvcg_queue_next_buffer(struct uvc_video_queue *queue,
 					  struct uvc_buffer *buf);
 
+void uvcg_queue_complete_buffer(struct uvc_video_queue *queue,
+				struct uvc_buffer *buf, bool error);
+
 struct uvc_buffer *uvcg_queue_head(struct uvc_video_queue *queue);
 
 #endif /* _UVC_QUEUE_H_ */
@@ -27,7 +27,8 @@ static bool uvc_using_zero_copy(struct uvc_video *video)
 	struct uvc_device *uvc = container_of(video, struct uvc_device, video);
 	struct f_uvc_opts *opts = fi_to_f_uvc_opts(uvc->func.fi);
 
-	if (opts && opts->uvc_zero_copy && video->fcc != V4L2_PIX_FMT_YUYV)
+	if (opts && opts->uvc_zero_copy == UVC_ZERO_COPY_GAP &&
+	    video->fcc != V4L2_PIX_FMT_YUYV)
 		return true;
 	else
 		return false;
@@ -60,6 +61,163 @@ static void uvc_wait_req_complete(struct uvc_video *video, struct uvc_request *u
 
 	spin_unlock_irqrestore(&video->req_lock, flags);
 }
+
+static bool uvc_using_sg(struct uvc_video *video)
+{
+	struct uvc_device *uvc = container_of(video, struct uvc_device, video);
+	struct f_uvc_opts *opts = fi_to_f_uvc_opts(uvc->func.fi);
+
+	return opts && opts->uvc_zero_copy == UVC_ZERO_COPY_SG &&
+	       uvc->func.config->cdev->gadget->sg_supported;
+}
+
+/*
+ * Chain the payload header and the dmabuf pages into one sg request. An
+ * isoc request carries one service interval as usual, a bulk request a
+ * whole payload of up to max_payload_size.
+ */
+static void
+uvc_video_encode_sg(struct usb_request *req, struct uvc_video *video,
+		    struct uvc_buffer *buf)
+{
+	struct uvc_request *ureq = req->context;
+	struct uvc_video_queue *queue = &video->queue;
+	struct scatterlist *iter = ureq->sgt.sgl;
+	struct scatterlist *sg = buf->sg;
+	unsigned int header_len = 2;
+	unsigned int len, part, nents = 1;
+	u8 *header = ureq->req_buffer;
+
+	if (ureq->sg_end)
+		sg_unmark_end(ureq->sg_end);
+
+	if (video->max_payload_size)
+		len = video->max_payload_size - header_len;
+	else
+		len = video->req_size - header_len;
+	len = min(len, buf->bytesused - queue->buf_used);
+
+	sg_set_buf(iter, header, header_len);
+	ureq->sg_end = iter;
+	req->length = header_len;
+
+	while (len && sg && nents < ureq->sgt.orig_nents) {
+		part = min(len, sg->length - buf->sg_offset);
+		iter = sg_next(iter);
+		sg_set_page(iter, sg_page(sg), part, sg->offset + buf->sg_offset);
+		ureq->sg_end = iter;
+		nents++;
+
+		req->length += part;
+		queue->buf_used += part;
+		len -= part;
+		buf->sg_offset += part;
+		if (buf->sg_offset == sg->length) {
+			sg = sg_next(sg);
+			buf->sg_offset = 0;
+		}
+	}
+	buf->sg = sg;
+	sg_mark_end(ureq->sg_end);
+
+	/* a dmabuf shorter than bytesused ends the frame early */
+	if (!sg)
+		queue->buf_used = buf->bytesused;
+
+	header[0] = header_len;
+	header[1] = UVC_STREAM_EOH | video->fid;
+	if (queue->buf_used == buf->bytesused)
+		header[1] |= UVC_STREAM_EOF;
+
+	req->buf = NULL;
+	req->sg = ureq->sgt.sgl;
+	req->num_sgs = nents;
+	req->zero = video->max_payload_size &&
+		    req->length != video->max_payload_size;
+
+	if (queue->buf_used == buf->bytesused) {
+		queue->buf_used = 0;
+		buf->state = UVC_BUF_STATE_DONE;
+		list_del(&buf->queue);
+		ureq->last_buf = buf;
+		video->fid ^= UVC_STREAM_FID;
+	}
+}
+
+static void uvc_video_encode(struct usb_request *req, struct uvc_video *video,
+			     struct uvc_buffer *buf)
+{
+	struct uvc_request *ureq = req->context;
+
+	if (buf->sgt) {
+		uvc_video_encode_sg(req, video, buf);
+		return;
+	}
+
+	if (req->num_sgs) {
+		req->num_sgs = 0;
+		req->sg = NULL;
+		req->buf = ureq->req_buffer;
+	}
+	video->encode(req, video, buf);
+}
+
+static void uvc_video_complete_buffer(struct uvc_video *video,
+				      struct usb_request *req, bool error)
+{
+	struct uvc_request *ureq = req->context;
+	struct uvc_video_queue *queue = &video->queue;
+	unsigned long flags;
+
+	if (!ureq->last_buf)
+		return;
+
+	spin_lock_irqsave(&queue->irqlock, flags);
+	uvcg_queue_complete_buffer(queue, ureq->last_buf, error);
+	spin_unlock_irqrestore(&queue->irqlock, flags);
+	ureq->last_buf = NULL;
+}
+
+static int uvcg_video_ep_queue(struct uvc_video *video, struct usb_request *req);
+
+/*
+ * Requeue a completed request from the completion handler itself when the
+ * head buffer needs no copy, so a high bandwidth isoc endpoint is not left
+ * waiting on the pump work for every service interval. Returns false when
+ * the request is to go back to req_free.
+ */
+static bool uvc_video_refill(struct uvc_video *video, struct usb_request *req)
+{
+	struct uvc_video_queue *queue = &video->queue;
+	struct uvc_buffer *buf;
+	unsigned long flags;
+	int ret;
+
+	if (!video->ep->enabled)
+		return false;
+
+	spin_lock_irqsave(&queue->irqlock, flags);
+	buf = uvcg_queue_head(queue);
+	if (!buf || !(buf->sgt || uvc_using_zero_copy(video))) {
+		spin_unlock_irqrestore(&queue->irqlock, flags);
+		return false;
+	}
+
+	uvc_video_encode(req, video, buf);
+	atomic_inc(&video->reqs_queued);
+	ret = uvcg_video_ep_queue(video, req);
+	spin_unlock_irqrestore(&queue->irqlock, flags);
+
+	if (ret < 0) {
+		atomic_dec(&video->reqs_queued);
+		uvc_video_complete_buffer(video, req, true);
+		uvcg_queue_cancel(queue, 0);
+		return false;
+	}
+
+	atomic_inc(&video->refills);
+	return true;
+}
 #else
 static inline bool uvc_using_zero_copy(struct uvc_video *video)
 {
@@ -68,6 +226,18 @@ static inline bool uvc_using_zero_copy(struct uvc_video *video)
 
 static inline void uvc_wait_req_complete(struct uvc_video *video, struct uvc_request *ureq)
 { }
+
+static inline void uvc_video_encode(struct usb_request *req,
+				    struct uvc_video *video,
+				    struct uvc_buffer *buf)
+{
+	video->encode(req, video, buf);
+}
+
+static inline void uvc_video_complete_buffer(struct uvc_video *video,
+					     struct usb_request *req,
+					     bool error)
+{ }
 #endif
 
 /* --------------------------------------------------------------------------
@@ -224,6 +394,9 @@ uvc_video_complete(struct usb_ep *ep, struct usb_request *req)
 	struct uvc_video_queue *queue = &video->queue;
 	struct uvc_device *uvc = video->uvc;
 	unsigned long flags;
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	int queued;
+#endif
 
 	switch (req->status) {
 	case 0:
@@ -241,6 +414,18 @@ uvc_video_complete(struct usb_ep *ep, struct usb_request *req)
 		uvcg_queue_cancel(queue, 0);
 	}
 
+	uvc_video_complete_buffer(video, req, req->status != 0);
+
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	queued = atomic_dec_return(&video->reqs_queued);
+	if (uvc->state == UVC_STATE_STREAMING && !req->status) {
+		if (uvc_video_refill(video, req))
+			return;
+		if (!queued)
+			atomic_inc(&video->underruns);
+	}
+#endif
+
 	spin_lock_irqsave(&video->req_lock, flags);
 	list_add_tail(&req->list, &video->req_free);
 #if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
@@ -269,6 +454,11 @@ uvc_video_free_requests(struct uvc_video *video)
 				kfree(video->ureq[i].req_buffer);
 				video->ureq[i].req_buffer = NULL;
 			}
+
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+			sg_free_table(&video->ureq[i].sgt);
+			video->ureq[i].sg_end = NULL;
+#endif
 		}
 
 		kfree(video->ureq);
@@ -319,6 +509,10 @@ uvc_video_alloc_requests(struct uvc_video *video)
 
 #if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
 		init_completion(&video->ureq[i].req_done);
+		if (uvc_using_sg(video) &&
+		    sg_alloc_table(&video->ureq[i].sgt, UVC_MAX_REQUEST_SG,
+				   GFP_KERNEL))
+			goto error;
 #endif
 		list_add_tail(&video->ureq[i].req->list, &video->req_free);
 	}
@@ -375,13 +569,20 @@ static void uvcg_video_pump(struct work_struct *work)
 			break;
 		}
 
-		video->encode(req, video, buf);
+		uvc_video_encode(req, video, buf);
 
 		/* Queue the USB request */
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+		atomic_inc(&video->reqs_queued);
+#endif
 		ret = uvcg_video_ep_queue(video, req);
 		spin_unlock_irqrestore(&queue->irqlock, flags);
 
 		if (ret < 0) {
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+			atomic_dec(&video->reqs_queued);
+#endif
+			uvc_video_complete_buffer(video, req, true);
 			uvcg_queue_cancel(queue, 0);
 			break;
 		}
@@ -440,6 +641,12 @@ int uvcg_video_enable(struct uvc_video *video, int enable)
 	if ((ret = uvc_video_alloc_requests(video)) < 0)
 		return ret;
 
+#if defined(CONFIG_ARCH_ROCKCHIP) && defined(CONFIG_NO_GKI)
+	atomic_set(&video->reqs_queued, 0);
+	atomic_set(&video->underruns, 0);
+	atomic_set(&video->refills, 0);
+#endif
+
 	if (video->max_payload_size) {
 		video->encode = uvc_video_encode_bulk;
 		video->payload_size = 0;
@@ -33,7 +33,11 @@
 
 #define AV1DEC_DRIVER_NAME		"mpp_av1dec"
 
-#define	AV1DEC_SESSION_MAX_BUFFERS		40
+/*
+ * Reference frames with their mv and aux buffers, the stream and the film
+ * grain tables don't fit in 40 at 4k, evicted ones get remapped per frame.
+ */
+#define	AV1DEC_SESSION_MAX_BUFFERS		MPP_SESSION_MAX_BUFFERS
 
 /* REG_DEC_INT, bits for interrupt */
 #define	AV1DEC_INT_PIC_INF		BIT(24)
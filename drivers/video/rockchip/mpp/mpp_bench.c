@@ -0,0 +1,470 @@
+// SPDX-License-Identifier: (GPL-2.0+ OR MIT)
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Register replay benchmark. The register writes of one task are recorded
+ * as dev_ops->run issues them and the buffers of the task are copied into
+ * private fixtures, the recording is then replayed on the idle hardware
+ * as often as asked for. Hardware time is measured from the start write
+ * to the irq, so a codec regression shows up without userspace, a camera
+ * or a bitstream parser in the loop.
+ *
+ *   echo capture > /proc/mpp_service/<dev>/bench   # record the next task
+ *   echo run 1000 > /proc/mpp_service/<dev>/bench  # replay it 1000 times
+ *   cat /proc/mpp_service/<dev>/bench
+ */
+#include <linux/delay.h>
+#include <linux/dma-buf.h>
+#include <linux/mm.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+
+#include "mpp_debug.h"
+#include "mpp_common.h"
+#include "mpp_iommu.h"
+
+#define MPP_BENCH_MAX_REGS		4096
+#define MPP_BENCH_MAX_BUFS		MPP_MAX_REG_TRANS_NUM
+#define MPP_BENCH_MAX_SIZE		SZ_64M
+#define MPP_BENCH_MAX_LOOPS		100000
+#define MPP_BENCH_TIMEOUT_MS		500
+#define MPP_BENCH_IDLE_TIMEOUT_MS	1000
+
+struct mpp_bench_write {
+	u32 reg;
+	u32 val;
+};
+
+struct mpp_bench_buf {
+	/* iova the task had the buffer at */
+	dma_addr_t iova;
+	unsigned long len;
+	struct mpp_dma_buffer *copy;
+};
+
+struct mpp_bench {
+	struct mpp_dev *mpp;
+	/* capture against replay and the procfs */
+	struct mutex lock;
+	bool armed;
+	bool captured;
+	int error;
+
+	struct mpp_bench_write *writes;
+	struct mpp_bench_write *replay;
+	u32 nr_writes;
+	bool overflow;
+	struct mpp_bench_buf bufs[MPP_BENCH_MAX_BUFS];
+	u32 nr_bufs;
+	size_t size;
+
+	struct completion done;
+	u64 irq_ns;
+	u32 irq_status;
+
+	/* results of the last run */
+	u32 loops;
+	u32 timeouts;
+	struct rk_lat_hist setup_hist;
+	struct rk_lat_hist hw_hist;
+	struct rk_lat_hist wake_hist;
+};
+
+static void mpp_bench_free_bufs(struct mpp_bench *bench)
+{
+	u32 i;
+
+	for (i = 0; i < bench->nr_bufs; i++)
+		mpp_dma_free(bench->bufs[i].copy);
+	bench->nr_bufs = 0;
+	bench->size = 0;
+	bench->captured = false;
+}
+
+/* from the write helpers, while dev_ops->run programs the captured task */
+void mpp_bench_record(struct mpp_dev *mpp, u32 reg, u32 val)
+{
+	struct mpp_bench *bench = mpp->bench;
+
+	/* the irq of the previous task may clear its status meanwhile */
+	if (in_interrupt())
+		return;
+
+	if (bench->nr_writes == MPP_BENCH_MAX_REGS) {
+		bench->overflow = true;
+		return;
+	}
+	bench->writes[bench->nr_writes].reg = reg;
+	bench->writes[bench->nr_writes].val = val;
+	bench->nr_writes++;
+}
+
+static int mpp_bench_copy_buf(struct mpp_bench *bench,
+			      struct mpp_mem_region *mem)
+{
+	struct mpp_dma_buffer *buffer = mem->hdl;
+	struct mpp_bench_buf *buf;
+	void *vaddr;
+	int ret;
+
+	if (bench->nr_bufs == MPP_BENCH_MAX_BUFS ||
+	    bench->size + mem->len > MPP_BENCH_MAX_SIZE)
+		return -E2BIG;
+
+	buf = &bench->bufs[bench->nr_bufs];
+	buf->copy = mpp_dma_alloc(bench->mpp->dev, mem->len);
+	if (!buf->copy)
+		return -ENOMEM;
+
+	ret = dma_buf_begin_cpu_access(buffer->dmabuf, DMA_FROM_DEVICE);
+	if (ret)
+		goto err_free;
+	vaddr = dma_buf_vmap(buffer->dmabuf);
+	if (!vaddr) {
+		ret = -ENOMEM;
+		goto err_end;
+	}
+	memcpy(buf->copy->vaddr, vaddr, mem->len);
+	dma_buf_vunmap(buffer->dmabuf, vaddr);
+	dma_buf_end_cpu_access(buffer->dmabuf, DMA_FROM_DEVICE);
+
+	buf->iova = mem->iova;
+	buf->len = mem->len;
+	bench->size += buf->copy->size;
+	bench->nr_bufs++;
+
+	return 0;
+
+err_end:
+	dma_buf_end_cpu_access(buffer->dmabuf, DMA_FROM_DEVICE);
+err_free:
+	mpp_dma_free(buf->copy);
+	return ret;
+}
+
+/*
+ * called before dev_ops->run of every task. The buffers are copied before
+ * the hardware is started so the fixtures hold the input, not the output.
+ */
+void mpp_bench_capture_begin(struct mpp_dev *mpp, struct mpp_task *task)
+{
+	struct mpp_bench *bench = mpp->bench;
+	struct mpp_mem_region *mem;
+	int ret = 0;
+
+	if (!bench || !READ_ONCE(bench->armed))
+		return;
+	/* a replay in progress waits for this task, do not wait for it */
+	if (!mutex_trylock(&bench->lock))
+		return;
+	if (!bench->armed)
+		goto unlock;
+
+	bench->armed = false;
+	mpp_bench_free_bufs(bench);
+	list_for_each_entry(mem, &task->mem_region_list, reg_link) {
+		if (mem->is_dup || !mem->hdl)
+			continue;
+		ret = mpp_bench_copy_buf(bench, mem);
+		if (ret)
+			break;
+	}
+	if (ret) {
+		dev_err(mpp->dev, "bench: copy task buffers failed %d\n", ret);
+		mpp_bench_free_bufs(bench);
+		bench->error = ret;
+		goto unlock;
+	}
+
+	bench->nr_writes = 0;
+	bench->overflow = false;
+	/* held until capture_end, the record hook needs no locking */
+	WRITE_ONCE(mpp->bench_rec, true);
+	return;
+
+unlock:
+	mutex_unlock(&bench->lock);
+}
+
+void mpp_bench_capture_end(struct mpp_dev *mpp)
+{
+	struct mpp_bench *bench = mpp->bench;
+
+	if (!bench || !mpp->bench_rec)
+		return;
+
+	WRITE_ONCE(mpp->bench_rec, false);
+	if (bench->overflow || !bench->nr_writes) {
+		mpp_bench_free_bufs(bench);
+		bench->error = -E2BIG;
+	} else {
+		bench->captured = true;
+		bench->error = 0;
+	}
+	mutex_unlock(&bench->lock);
+}
+
+/* from mpp_dev_irq while a replay runs, the isr thread has no task to finish */
+irqreturn_t mpp_bench_irq(struct mpp_dev *mpp)
+{
+	struct mpp_bench *bench = mpp->bench;
+	irqreturn_t ret;
+
+	ret = mpp->dev_ops->irq(mpp);
+	if (ret != IRQ_WAKE_THREAD)
+		return ret;
+
+	bench->irq_ns = ktime_get_ns();
+	bench->irq_status = mpp->irq_status;
+	mpp_iommu_dev_deactivate(mpp->iommu_info, mpp);
+	complete(&bench->done);
+
+	return IRQ_HANDLED;
+}
+
+/*
+ * point every recorded address into a task buffer at the same offset of
+ * its fixture. Addresses only, a control value happening to fall into a
+ * buffer is rebased too, which the iova layout makes unlikely.
+ */
+static void mpp_bench_rebase(struct mpp_bench *bench)
+{
+	u32 i, j, val;
+
+	for (i = 0; i < bench->nr_writes; i++) {
+		val = bench->writes[i].val;
+		for (j = 0; j < bench->nr_bufs; j++) {
+			struct mpp_bench_buf *buf = &bench->bufs[j];
+
+			if (val >= buf->iova && val < buf->iova + buf->len) {
+				val = val - buf->iova + buf->copy->iova;
+				break;
+			}
+		}
+		bench->replay[i].reg = bench->writes[i].reg;
+		bench->replay[i].val = val;
+	}
+}
+
+static bool mpp_bench_queue_idle(struct mpp_taskqueue *queue)
+{
+	unsigned long flags;
+	bool idle;
+
+	spin_lock_irqsave(&queue->running_lock, flags);
+	idle = list_empty(&queue->running_list);
+	spin_unlock_irqrestore(&queue->running_lock, flags);
+
+	return idle;
+}
+
+static int mpp_bench_run_one(struct mpp_bench *bench)
+{
+	struct mpp_dev *mpp = bench->mpp;
+	struct mpp_bench_write *w = bench->replay;
+	u32 i, last = bench->nr_writes - 1;
+	u64 t0, t1, t2;
+
+	reinit_completion(&bench->done);
+	mpp_iommu_dev_activate(mpp->iommu_info, mpp);
+
+	t0 = ktime_get_ns();
+	for (i = 0; i < last; i++)
+		writel_relaxed(w[i].val, mpp->reg_base + w[i].reg);
+	/* the start is the last write of dev_ops->run */
+	wmb();
+	t1 = ktime_get_ns();
+	WRITE_ONCE(mpp->bench_run, true);
+	writel(w[last].val, mpp->reg_base + w[last].reg);
+
+	if (!wait_for_completion_timeout(&bench->done,
+					 msecs_to_jiffies(MPP_BENCH_TIMEOUT_MS))) {
+		WRITE_ONCE(mpp->bench_run, false);
+		synchronize_irq(mpp->irq);
+		/* raced with the irq */
+		if (!try_wait_for_completion(&bench->done)) {
+			mpp_iommu_dev_deactivate(mpp->iommu_info, mpp);
+			return -ETIMEDOUT;
+		}
+	}
+	t2 = ktime_get_ns();
+	WRITE_ONCE(mpp->bench_run, false);
+
+	rk_lat_hist_add(&bench->setup_hist, t1 - t0);
+	rk_lat_hist_add(&bench->hw_hist, bench->irq_ns - t1);
+	rk_lat_hist_add(&bench->wake_hist, t2 - bench->irq_ns);
+
+	return 0;
+}
+
+static int mpp_bench_run(struct mpp_bench *bench, u32 loops)
+{
+	struct mpp_dev *mpp = bench->mpp;
+	struct mpp_taskqueue *queue = mpp->queue;
+	unsigned long timeout;
+	int ret = 0;
+	u32 i;
+
+	if (!bench->captured)
+		return -ENODATA;
+
+	/* no task is picked while the pending list is locked */
+	mutex_lock(&queue->pending_lock);
+	timeout = jiffies + msecs_to_jiffies(MPP_BENCH_IDLE_TIMEOUT_MS);
+	while (!mpp_bench_queue_idle(queue)) {
+		if (time_after(jiffies, timeout)) {
+			ret = -EBUSY;
+			goto unlock;
+		}
+		usleep_range(500, 1000);
+	}
+
+	if (mpp->hw_ops->set_grf)
+		mpp->hw_ops->set_grf(mpp);
+	else
+		mpp_set_grf(mpp->grf_info);
+	ret = mpp_iommu_attach(mpp->iommu_info);
+	if (ret)
+		goto unlock;
+	mpp_power_on(mpp);
+
+	mpp_bench_rebase(bench);
+	bench->loops = 0;
+	bench->timeouts = 0;
+	rk_lat_hist_reset(&bench->setup_hist);
+	rk_lat_hist_reset(&bench->hw_hist);
+	rk_lat_hist_reset(&bench->wake_hist);
+
+	for (i = 0; i < loops; i++) {
+		if (mpp_bench_run_one(bench)) {
+			bench->timeouts++;
+			dev_err(mpp->dev, "bench: loop %u timeout\n", i);
+			if (mpp->hw_ops->reset)
+				mpp->hw_ops->reset(mpp);
+			mpp_iommu_refresh(mpp->iommu_info, mpp->dev);
+			/* a hung recording will not recover */
+			if (bench->timeouts > 3)
+				break;
+			continue;
+		}
+		bench->loops++;
+		if (fatal_signal_pending(current))
+			break;
+		cond_resched();
+	}
+
+	mpp_power_off(mpp);
+unlock:
+	mutex_unlock(&queue->pending_lock);
+	/* tasks queued meanwhile */
+	kthread_queue_work(&queue->worker, &mpp->work);
+
+	return ret;
+}
+
+static int mpp_bench_show(struct seq_file *m, void *v)
+{
+	struct mpp_bench *bench = m->private;
+
+	mutex_lock(&bench->lock);
+	seq_printf(m, "%s armed:%d captured:%d error:%d writes:%u buffers:%u size:%zuKB\n",
+		   dev_name(bench->mpp->dev), bench->armed, bench->captured,
+		   bench->error, bench->nr_writes, bench->nr_bufs,
+		   bench->size / SZ_1K);
+	seq_printf(m, "loops:%u timeouts:%u last irq_status:%08x\n",
+		   bench->loops, bench->timeouts, bench->irq_status);
+	rk_lat_hist_show(m, "sw-setup", &bench->setup_hist);
+	rk_lat_hist_show(m, "hw-run", &bench->hw_hist);
+	rk_lat_hist_show(m, "irq-to-wake", &bench->wake_hist);
+	mutex_unlock(&bench->lock);
+
+	return 0;
+}
+
+static int mpp_bench_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, mpp_bench_show, PDE_DATA(inode));
+}
+
+static ssize_t mpp_bench_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct mpp_bench *bench = m->private;
+	char buf[32];
+	u32 loops;
+	int ret = 0;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	mutex_lock(&bench->lock);
+	if (sysfs_streq(buf, "capture")) {
+		mpp_bench_free_bufs(bench);
+		bench->nr_writes = 0;
+		bench->error = 0;
+		WRITE_ONCE(bench->armed, true);
+	} else if (sysfs_streq(buf, "clear")) {
+		mpp_bench_free_bufs(bench);
+		bench->nr_writes = 0;
+		bench->armed = false;
+	} else if (sscanf(buf, "run %u", &loops) == 1 && loops &&
+		   loops <= MPP_BENCH_MAX_LOOPS) {
+		ret = mpp_bench_run(bench, loops);
+	} else {
+		ret = -EINVAL;
+	}
+	mutex_unlock(&bench->lock);
+
+	return ret ? ret : count;
+}
+
+static const struct proc_ops mpp_bench_fops = {
+	.proc_open = mpp_bench_open,
+	.proc_read = seq_read,
+	.proc_release = single_release,
+	.proc_write = mpp_bench_write,
+};
+
+static void mpp_bench_release(void *data)
+{
+	struct mpp_bench *bench = data;
+
+	mpp_bench_free_bufs(bench);
+	kvfree(bench->writes);
+	kvfree(bench->replay);
+}
+
+/* only for devices whose irq goes through mpp_dev_irq */
+void mpp_bench_procfs_init(struct proc_dir_entry *parent, struct mpp_dev *mpp)
+{
+	struct mpp_bench *bench;
+
+	bench = devm_kzalloc(mpp->dev, sizeof(*bench), GFP_KERNEL);
+	if (!bench)
+		return;
+
+	bench->writes = kvcalloc(MPP_BENCH_MAX_REGS, sizeof(*bench->writes),
+				 GFP_KERNEL);
+	bench->replay = kvcalloc(MPP_BENCH_MAX_REGS, sizeof(*bench->replay),
+				 GFP_KERNEL);
+	if (!bench->writes || !bench->replay) {
+		kvfree(bench->writes);
+		kvfree(bench->replay);
+		return;
+	}
+	bench->mpp = mpp;
+	mutex_init(&bench->lock);
+	init_completion(&bench->done);
+	if (devm_add_action_or_reset(mpp->dev, mpp_bench_release, bench))
+		return;
+
+	mpp->bench = bench;
+	proc_create_data("bench", 0644, parent, &mpp_bench_fops, bench);
+}
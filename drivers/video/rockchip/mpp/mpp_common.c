@@ -13,8 +13,10 @@
 
 #include <linux/clk.h>
 #include <linux/delay.h>
+#include <linux/dma-buf.h>
 #include <linux/interrupt.h>
 #include <linux/iopoll.h>
+#include <linux/io_uring.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
@@ -25,9 +27,14 @@
 #include <linux/regmap.h>
 #include <linux/rwsem.h>
 #include <linux/mfd/syscon.h>
+#include <linux/net.h>
 #include <linux/seq_file.h>
 #include <linux/slab.h>
+#include <linux/socket.h>
+#include <linux/sync_file.h>
+#include <linux/thermal.h>
 #include <linux/uaccess.h>
+#include <linux/uio.h>
 #include <linux/nospec.h>
 
 #include <soc/rockchip/pm_domains.h>
@@ -36,6 +43,9 @@
 #include "mpp_common.h"
 #include "mpp_iommu.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/rkmpp.h>
+
 #define MPP_WAIT_TIMEOUT_DELAY		(2000)
 
 /* Use 'v' as magic number */
@@ -128,6 +138,100 @@ mpp_taskqueue_get_pending_task(struct mpp_taskqueue *queue)
 	return task;
 }
 
+/* vtime a batch session is charged per task at weight 1 */
+#define MPP_SCHED_VTIME_UNIT	(1024)
+#define MPP_SCHED_DEFAULT_FPS	(30)
+
+/*
+ * Pick the next task to run. Only the oldest pending task of each session
+ * is a candidate so that tasks of one session keep their order. Time
+ * critical sessions go first, highest prio then earliest frame deadline.
+ * Batch sessions share the rest by weight through a virtual time.
+ *
+ * Tasks of a cgroup over its hwaccel quota are skipped, throttle_ns is
+ * then set to when the first of them may run. Without a session sched
+ * the queue stays fifo apart from the cgroup weights.
+ */
+static struct mpp_task *
+mpp_taskqueue_pick_pending_task(struct mpp_taskqueue *queue, u64 *throttle_ns)
+{
+	struct mpp_task *task, *rt_task = NULL, *fair_task = NULL;
+	u64 rt_deadline = 0, fair_vtime = 0;
+	u64 wait_ns;
+	u32 pass;
+	int cmp;
+
+	*throttle_ns = 0;
+	mutex_lock(&queue->pending_lock);
+	if (!queue->sched_en && !IS_ENABLED(CONFIG_CGROUP_HWACCEL)) {
+		rt_task = list_first_entry_or_null(&queue->pending_list,
+						   struct mpp_task, queue_link);
+		goto done;
+	}
+
+	pass = ++queue->sched_pass;
+	list_for_each_entry(task, &queue->pending_list, queue_link) {
+		struct mpp_session *session = task->session;
+
+		if (session->sched_pass == pass)
+			continue;
+		session->sched_pass = pass;
+
+		wait_ns = hwaccel_cgroup_throttled(task->hwcg, HWACCEL_MPP);
+		if (wait_ns) {
+			if (!*throttle_ns || wait_ns < *throttle_ns)
+				*throttle_ns = wait_ns;
+			continue;
+		}
+
+		if (!queue->sched_en) {
+			if (!fair_task ||
+			    hwaccel_cgroup_cmp(task->hwcg, fair_task->hwcg,
+					       HWACCEL_MPP) < 0)
+				fair_task = task;
+		} else if (session->sched.prio) {
+			u32 fps = session->sched.fps ? : MPP_SCHED_DEFAULT_FPS;
+			u64 deadline = task->lat_create_ns + div_u64(NSEC_PER_SEC, fps);
+
+			if (!rt_task ||
+			    session->sched.prio > rt_task->session->sched.prio ||
+			    (session->sched.prio == rt_task->session->sched.prio &&
+			     deadline < rt_deadline)) {
+				rt_task = task;
+				rt_deadline = deadline;
+			}
+		} else {
+			/* an idle session does not bank vtime */
+			u64 vtime = max(session->sched_vtime, queue->sched_vtime);
+
+			cmp = fair_task ? hwaccel_cgroup_cmp(task->hwcg, fair_task->hwcg,
+							     HWACCEL_MPP) : -1;
+			if (cmp < 0 || (!cmp && vtime < fair_vtime)) {
+				fair_task = task;
+				fair_vtime = vtime;
+			}
+		}
+	}
+	if (!rt_task)
+		rt_task = fair_task;
+done:
+	mutex_unlock(&queue->pending_lock);
+
+	return rt_task;
+}
+
+static void mpp_session_set_sched(struct mpp_session *session,
+				  struct mpp_sched_cfg *cfg)
+{
+	struct mpp_taskqueue *queue = session->mpp->queue;
+
+	mutex_lock(&queue->pending_lock);
+	session->sched = *cfg;
+	session->sched_vtime = queue->sched_vtime;
+	queue->sched_en = 1;
+	mutex_unlock(&queue->pending_lock);
+}
+
 static bool
 mpp_taskqueue_is_running(struct mpp_taskqueue *queue)
 {
@@ -152,6 +256,14 @@ mpp_taskqueue_pending_to_run(struct mpp_taskqueue *queue,
 	list_move_tail(&task->queue_link, &queue->running_list);
 	spin_unlock_irqrestore(&queue->running_lock, flags);
 
+	if (queue->sched_en && !task->session->sched.prio) {
+		struct mpp_session *session = task->session;
+		u32 weight = session->sched.weight ? : 1;
+
+		session->sched_vtime = max(session->sched_vtime, queue->sched_vtime) +
+				       MPP_SCHED_VTIME_UNIT / weight;
+		queue->sched_vtime = session->sched_vtime - MPP_SCHED_VTIME_UNIT / weight;
+	}
 	mutex_unlock(&queue->pending_lock);
 
 	return 0;
@@ -195,6 +307,15 @@ mpp_taskqueue_trigger_work(struct mpp_dev *mpp)
 	kthread_queue_work(&mpp->queue->worker, &mpp->work);
 }
 
+static enum hrtimer_restart mpp_throttle_timer(struct hrtimer *timer)
+{
+	struct mpp_dev *mpp = container_of(timer, struct mpp_dev, throttle_timer);
+
+	mpp_taskqueue_trigger_work(mpp);
+
+	return HRTIMER_NORESTART;
+}
+
 int mpp_power_on(struct mpp_dev *mpp)
 {
 	pm_runtime_get_sync(mpp->dev);
@@ -231,6 +352,8 @@ static void task_msgs_reset(struct mpp_task_msgs *msgs)
 	msgs->req_cnt = 0;
 	msgs->set_cnt = 0;
 	msgs->poll_cnt = 0;
+	msgs->fence_req = NULL;
+	msgs->in_fence_req = NULL;
 }
 
 static void task_msgs_init(struct mpp_task_msgs *msgs, struct mpp_session *session)
@@ -521,6 +644,131 @@ mpp_session_get_pending_task(struct mpp_session *session)
 	return task;
 }
 
+struct mpp_fence {
+	struct dma_fence base;
+	spinlock_t lock;
+	char timeline[32];
+};
+
+static const char *mpp_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "mpp";
+}
+
+static const char *mpp_fence_get_timeline_name(struct dma_fence *fence)
+{
+	struct mpp_fence *f = container_of(fence, struct mpp_fence, base);
+
+	return f->timeline;
+}
+
+static const struct dma_fence_ops mpp_fence_ops = {
+	.get_driver_name = mpp_fence_get_driver_name,
+	.get_timeline_name = mpp_fence_get_timeline_name,
+};
+
+static int mpp_task_fence_create(struct mpp_task *task, struct mpp_dev *mpp,
+				 s32 __user *usr_fd)
+{
+	struct mpp_fence *fence;
+	struct sync_file *sync_file;
+	int fd;
+	int ret;
+
+	fence = kzalloc(sizeof(*fence), GFP_KERNEL);
+	if (!fence)
+		return -ENOMEM;
+
+	spin_lock_init(&fence->lock);
+	strscpy(fence->timeline, dev_name(mpp->dev), sizeof(fence->timeline));
+	dma_fence_init(&fence->base, &mpp_fence_ops, &fence->lock,
+		       mpp->fence_context, task->task_index);
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		ret = fd;
+		goto err_put_fence;
+	}
+
+	sync_file = sync_file_create(&fence->base);
+	if (!sync_file) {
+		ret = -ENOMEM;
+		goto err_put_fd;
+	}
+
+	if (put_user(fd, usr_fd)) {
+		fput(sync_file->file);
+		ret = -EFAULT;
+		goto err_put_fd;
+	}
+
+	/* sync_file holds its own reference, this one belongs to the task */
+	task->out_fence = &fence->base;
+	fd_install(fd, sync_file->file);
+
+	return 0;
+
+err_put_fd:
+	put_unused_fd(fd);
+err_put_fence:
+	dma_fence_put(&fence->base);
+	return ret;
+}
+
+static void mpp_task_in_fence_cb(struct dma_fence *fence, struct dma_fence_cb *cb)
+{
+	struct mpp_task *task = container_of(cb, struct mpp_task, in_fence_cb);
+
+	/* the task worker holds the task while its input is not ready */
+	mpp_taskqueue_trigger_work(task->session->mpp);
+}
+
+static void mpp_task_worker_default(struct kthread_work *work_s);
+
+static int mpp_task_in_fence_add(struct mpp_task *task, struct mpp_dev *mpp,
+				 s32 __user *usr_fd)
+{
+	struct dma_fence *fence;
+	long ret;
+	s32 fd;
+
+	if (get_user(fd, usr_fd))
+		return -EFAULT;
+	if (fd < 0)
+		return 0;
+
+	fence = sync_file_get_fence(fd);
+	if (!fence)
+		return -EINVAL;
+
+	/* only the default worker knows to hold the task, wait here otherwise */
+	if (mpp->work.func != mpp_task_worker_default) {
+		ret = dma_fence_wait_timeout(fence, true,
+					     msecs_to_jiffies(MPP_WAIT_TIMEOUT_DELAY));
+		dma_fence_put(fence);
+		if (!ret)
+			return -ETIMEDOUT;
+		return ret < 0 ? ret : 0;
+	}
+
+	task->in_fence = fence;
+	dma_fence_add_callback(fence, &task->in_fence_cb, mpp_task_in_fence_cb);
+
+	return 0;
+}
+
+void mpp_task_fence_signal(struct mpp_task *task, int error)
+{
+	struct dma_fence *fence = task->out_fence;
+
+	if (!fence || test_bit(DMA_FENCE_FLAG_SIGNALED_BIT, &fence->flags))
+		return;
+
+	if (error)
+		dma_fence_set_error(fence, error);
+	dma_fence_signal(fence);
+}
+
 void mpp_free_task(struct kref *ref)
 {
 	struct mpp_dev *mpp;
@@ -538,6 +786,19 @@ void mpp_free_task(struct kref *ref)
 		       atomic_read(&task->abort_request));
 
 	mpp = mpp_get_task_used_device(task, session);
+	hwaccel_cgroup_put(task->hwcg);
+	task->hwcg = NULL;
+	if (task->out_fence) {
+		/* task dropped before done, e.g. session release */
+		mpp_task_fence_signal(task, -ECANCELED);
+		dma_fence_put(task->out_fence);
+		task->out_fence = NULL;
+	}
+	if (task->in_fence) {
+		dma_fence_remove_callback(task->in_fence, &task->in_fence_cb);
+		dma_fence_put(task->in_fence);
+		task->in_fence = NULL;
+	}
 	if (mpp->dev_ops->free_task)
 		mpp->dev_ops->free_task(session, task);
 
@@ -546,9 +807,32 @@ void mpp_free_task(struct kref *ref)
 	atomic_dec(&mpp->task_count);
 }
 
+/*
+ * Recover from a timeout by aborting only the stuck task. If the core
+ * comes back from its own soft reset, the iommu mapping and clocks stay
+ * as they are, and the pending queue replays right away. A page fault, or
+ * a core that does not come back, falls back to mpp_dev_reset.
+ */
+static int mpp_dev_soft_recover(struct mpp_dev *mpp)
+{
+	int ret;
+
+	if (!mpp->hw_ops->soft_reset || mpp->iommu_fault)
+		return -ENODEV;
+
+	mpp_reset_down_write(mpp->reset_group);
+	ret = mpp->hw_ops->soft_reset(mpp);
+	if (!ret)
+		atomic_set(&mpp->reset_request, 0);
+	mpp_reset_up_write(mpp->reset_group);
+
+	return ret;
+}
+
 static void mpp_task_timeout_work(struct work_struct *work_s)
 {
 	struct mpp_dev *mpp;
+	u64 recover_ns;
 	struct mpp_session *session;
 	struct mpp_task *task = container_of(to_delayed_work(work_s),
 					     struct mpp_task,
@@ -586,11 +870,23 @@ static void mpp_task_timeout_work(struct work_struct *work_s)
 
 	/* hardware maybe dead, reset it */
 	mpp_reset_up_read(mpp->reset_group);
-	mpp_dev_reset(mpp);
+	recover_ns = ktime_get_boottime_ns();
+	/* the hung task held the core until now */
+	if (task->lat_start_ns)
+		hwaccel_cgroup_charge(task->hwcg, HWACCEL_MPP,
+				      recover_ns - task->lat_start_ns);
+	if (!mpp_dev_soft_recover(mpp)) {
+		mpp->recover_soft++;
+	} else {
+		mpp_dev_reset(mpp);
+		mpp->recover_full++;
+	}
+	rk_lat_hist_add(&mpp->recover_hist, ktime_get_boottime_ns() - recover_ns);
 	mpp_power_off(mpp);
 
 	set_bit(TASK_STATE_TIMEOUT, &task->state);
 	set_bit(TASK_STATE_DONE, &task->state);
+	mpp_task_fence_signal(task, -ETIMEDOUT);
 	/* Wake up the GET thread */
 	wake_up(&task->wait);
 
@@ -606,6 +902,22 @@ static void mpp_task_timeout_work(struct work_struct *work_s)
 	mpp_taskqueue_trigger_work(mpp);
 }
 
+/* the dma-bufs of a task, to follow a camera frame into the encoder */
+static void mpp_task_trace_bufs(struct mpp_task *task)
+{
+	struct mpp_mem_region *mem_region;
+	struct mpp_dma_buffer *buffer;
+
+	list_for_each_entry(mem_region, &task->mem_region_list, reg_link) {
+		buffer = mem_region->hdl;
+		if (mem_region->is_dup || !buffer || !buffer->dmabuf)
+			continue;
+		trace_rkmpp_task_buf(task->session->index, task->task_index,
+				     mem_region->fd,
+				     file_inode(buffer->dmabuf->file)->i_ino);
+	}
+}
+
 static int mpp_process_task_default(struct mpp_session *session,
 				    struct mpp_task_msgs *msgs)
 {
@@ -637,6 +949,7 @@ static int mpp_process_task_default(struct mpp_session *session,
 		set_bit(TASK_TIMING_CREATE_END, &task->state);
 		set_bit(TASK_TIMING_CREATE, &task->state);
 	}
+	task->lat_create_ns = ktime_get_boottime_ns();
 
 	/* ensure current device */
 	mpp = mpp_get_task_used_device(task, session);
@@ -646,6 +959,8 @@ static int mpp_process_task_default(struct mpp_session *session,
 	atomic_set(&task->abort_request, 0);
 	task->task_index = atomic_fetch_inc(&mpp->task_index);
 	task->task_id = atomic_fetch_inc(&mpp->queue->task_id);
+	if (trace_rkmpp_task_buf_enabled())
+		mpp_task_trace_bufs(task);
 	INIT_DELAYED_WORK(&task->timeout_work, mpp_task_timeout_work);
 
 	if (mpp->auto_freq_en && mpp->hw_ops->get_freq)
@@ -756,6 +1071,7 @@ int mpp_dev_reset(struct mpp_dev *mpp)
 	 * will be update the domain. In this way, domain can really attach.
 	 */
 	mpp_iommu_refresh(mpp->iommu_info, mpp->dev);
+	mpp->iommu_fault = 0;
 
 	mpp_reset_up_write(mpp->reset_group);
 	mpp_iommu_up_write(mpp->iommu_info);
@@ -767,10 +1083,23 @@ int mpp_dev_reset(struct mpp_dev *mpp)
 
 void mpp_task_run_begin(struct mpp_task *task, u32 timing_en, u32 timeout)
 {
+	struct mpp_dev *mpp = mpp_get_task_used_device(task, task->session);
+
 	preempt_disable();
 
 	set_bit(TASK_STATE_START, &task->state);
 
+	task->lat_start_ns = ktime_get_boottime_ns();
+	if (task->lat_create_ns) {
+		rk_lat_hist_add(&mpp->wait_hist,
+				task->lat_start_ns - task->lat_create_ns);
+		rk_lat_hist_add(&task->session->wait_hist,
+				task->lat_start_ns - task->lat_create_ns);
+		trace_rkmpp_task_start(dev_name(mpp->dev), task->session->index,
+				       task->task_index, task->lat_create_ns,
+				       task->lat_start_ns);
+	}
+
 	mpp_time_record(task);
 	schedule_delayed_work(&task->timeout_work, msecs_to_jiffies(timeout));
 
@@ -844,8 +1173,10 @@ static int mpp_task_run(struct mpp_dev *mpp,
 	mpp_reset_down_read(mpp->reset_group);
 
 	mpp_iommu_dev_activate(mpp->iommu_info, mpp);
+	mpp_bench_capture_begin(mpp, task);
 	if (mpp->dev_ops->run)
 		mpp->dev_ops->run(mpp, task);
+	mpp_bench_capture_end(mpp);
 
 	mpp_debug_leave();
 
@@ -857,13 +1188,18 @@ static void mpp_task_worker_default(struct kthread_work *work_s)
 	struct mpp_task *task;
 	struct mpp_dev *mpp = container_of(work_s, struct mpp_dev, work);
 	struct mpp_taskqueue *queue = mpp->queue;
+	u64 throttle_ns;
 
 	mpp_debug_enter();
 
 again:
-	task = mpp_taskqueue_get_pending_task(queue);
-	if (!task)
+	task = mpp_taskqueue_pick_pending_task(queue, &throttle_ns);
+	if (!task) {
+		if (throttle_ns)
+			hrtimer_start(&mpp->throttle_timer, ns_to_ktime(throttle_ns),
+				      HRTIMER_MODE_REL);
 		goto done;
+	}
 
 	/* if task timeout and aborted, remove it */
 	if (atomic_read(&task->abort_request) > 0) {
@@ -871,6 +1207,10 @@ static void mpp_task_worker_default(struct kthread_work *work_s)
 		goto again;
 	}
 
+	/* input still being produced, the in fence callback kicks us again */
+	if (task->in_fence && !dma_fence_is_signaled(task->in_fence))
+		goto done;
+
 	/* get device for current task */
 	mpp = task->session->mpp;
 
@@ -1173,6 +1513,108 @@ static __u32 mpp_get_cmd_butt(__u32 cmd)
 	return mask;
 }
 
+static int mpp_sock_send_dmabuf(struct mpp_session *session,
+				struct mpp_sock_send *cfg)
+{
+	struct mpp_dev *mpp = session->mpp;
+	struct dma_buf_attachment *attach;
+	struct msghdr msg = { 0 };
+	struct dma_buf *dmabuf;
+	struct scatterlist *sg;
+	struct bio_vec *bvec;
+	struct socket *sock;
+	struct sg_table *sgt;
+	u32 skip = cfg->offset;
+	u32 left = cfg->len;
+	int i, nr = 0;
+	int ret;
+
+	if (!cfg->len)
+		return -EINVAL;
+
+	sock = sockfd_lookup(cfg->sock_fd, &ret);
+	if (!sock)
+		return ret;
+
+	dmabuf = dma_buf_get(cfg->buf_fd);
+	if (IS_ERR(dmabuf)) {
+		ret = PTR_ERR(dmabuf);
+		goto put_sock;
+	}
+	if (cfg->offset > dmabuf->size ||
+	    cfg->len > dmabuf->size - cfg->offset) {
+		ret = -EINVAL;
+		goto put_buf;
+	}
+
+	attach = dma_buf_attach(dmabuf, mpp->dev);
+	if (IS_ERR(attach)) {
+		ret = PTR_ERR(attach);
+		goto put_buf;
+	}
+	sgt = dma_buf_map_attachment(attach, DMA_TO_DEVICE);
+	if (IS_ERR(sgt)) {
+		ret = PTR_ERR(sgt);
+		goto detach;
+	}
+
+	bvec = kvmalloc_array(sgt->orig_nents, sizeof(*bvec), GFP_KERNEL);
+	if (!bvec) {
+		ret = -ENOMEM;
+		goto unmap;
+	}
+
+	for_each_sgtable_sg(sgt, sg, i) {
+		u32 len = sg->length;
+
+		if (skip >= len) {
+			skip -= len;
+			continue;
+		}
+		/* carveout buffers have no struct page to hang an skb on */
+		if (!sg_page(sg)) {
+			ret = -EOPNOTSUPP;
+			goto free_bvec;
+		}
+		bvec[nr].bv_page = sg_page(sg);
+		bvec[nr].bv_offset = sg->offset + skip;
+		bvec[nr].bv_len = min(len - skip, left);
+		left -= bvec[nr].bv_len;
+		skip = 0;
+		nr++;
+		if (!left)
+			break;
+	}
+
+	/*
+	 * The stack takes its own page references for the frags, the
+	 * attachment is only needed to look the pages up.
+	 */
+	iov_iter_bvec(&msg.msg_iter, WRITE, bvec, nr, cfg->len);
+	msg.msg_flags = MSG_ZEROCOPY | MSG_NOSIGNAL |
+			(cfg->flags & (MSG_DONTWAIT | MSG_MORE));
+	ret = sock_sendmsg(sock, &msg);
+	if (ret >= 0) {
+		cfg->sent = ret;
+		ret = 0;
+	}
+
+	mpp_debug(DEBUG_IOCTL, "send buf fd %d off %u len %u on sock %d ret %d\n",
+		  cfg->buf_fd, cfg->offset, cfg->len, cfg->sock_fd, ret);
+free_bvec:
+	kvfree(bvec);
+unmap:
+	dma_buf_unmap_attachment(attach, sgt, DMA_TO_DEVICE);
+detach:
+	dma_buf_detach(dmabuf, attach);
+put_buf:
+	dma_buf_put(dmabuf);
+put_sock:
+	sockfd_put(sock);
+
+	return ret;
+}
+
 static int mpp_process_request(struct mpp_session *session,
 			       struct mpp_service *srv,
 			       struct mpp_request *req,
@@ -1217,6 +1659,26 @@ static int mpp_process_request(struct mpp_session *session,
 		if (put_user(hw_info->hw_id, (u32 __user *)req->data))
 			return -EFAULT;
 	} break;
+	case MPP_CMD_QUERY_COOLING_STATE: {
+		u32 client_type;
+
+		mpp = NULL;
+		if (session && session->mpp) {
+			mpp = session->mpp;
+		} else {
+			if (get_user(client_type, (u32 __user *)req->data))
+				return -EFAULT;
+			client_type = array_index_nospec(client_type, MPP_DEVICE_BUTT);
+			if (test_bit(client_type, &srv->hw_support))
+				mpp = srv->sub_devices[client_type];
+		}
+
+		if (!mpp)
+			return -EINVAL;
+
+		if (put_user(READ_ONCE(mpp->cooling_state), (u32 __user *)req->data))
+			return -EFAULT;
+	} break;
 	case MPP_CMD_QUERY_CMD_SUPPORT: {
 		__u32 cmd = 0;
 
@@ -1244,7 +1706,8 @@ static int mpp_process_request(struct mpp_session *session,
 			return -EINVAL;
 
 		session->device_type = (enum MPP_DEVICE_TYPE)client_type;
-		session->dma = mpp_dma_session_create(mpp->dev, mpp->session_max_buffers);
+		session->dma = mpp_dma_session_create(mpp->dev, mpp->session_max_buffers,
+						      mpp->dma_cache);
 		session->mpp = mpp;
 		if (mpp->dev_ops) {
 			if (mpp->dev_ops->process_task)
@@ -1304,6 +1767,21 @@ static int mpp_process_request(struct mpp_session *session,
 		msgs->flags |= req->flags;
 		msgs->set_cnt++;
 	} break;
+	case MPP_CMD_SET_OUT_FENCE: {
+		if (req->size < sizeof(s32))
+			return -EINVAL;
+		msgs->fence_req = req;
+	} break;
+	case MPP_CMD_SET_IN_FENCE: {
+		if (req->size < sizeof(s32))
+			return -EINVAL;
+		msgs->in_fence_req = req;
+	} break;
+	case MPP_CMD_SET_SLICE_EVENT: {
+		/* parsed by the device in alloc_task */
+		if (!req->size || !req->data)
+			return -EINVAL;
+	} break;
 	case MPP_CMD_POLL_HW_FINISH: {
 		msgs->flags |= req->flags;
 		msgs->poll_cnt++;
@@ -1384,6 +1862,34 @@ static int mpp_process_request(struct mpp_session *session,
 			return -EINVAL;
 		}
 	} break;
+	case MPP_CMD_SET_SESSION_SCHED: {
+		struct mpp_sched_cfg cfg;
+
+		if (!session->mpp || req->size < sizeof(cfg))
+			return -EINVAL;
+		if (copy_from_user(&cfg, req->data, sizeof(cfg))) {
+			mpp_err("copy_from_user failed.\n");
+			return -EINVAL;
+		}
+		mpp_session_set_sched(session, &cfg);
+	} break;
+	case MPP_CMD_SEND_DMABUF_SOCK: {
+		struct mpp_sock_send cfg;
+
+		if (!session->mpp || req->size < sizeof(cfg))
+			return -EINVAL;
+		if (copy_from_user(&cfg, req->data, sizeof(cfg))) {
+			mpp_err("copy_from_user failed.\n");
+			return -EINVAL;
+		}
+		ret = mpp_sock_send_dmabuf(session, &cfg);
+		if (ret)
+			return ret;
+		if (copy_to_user(req->data, &cfg, sizeof(cfg))) {
+			mpp_err("copy_to_user failed.\n");
+			return -EINVAL;
+		}
+	} break;
 	case MPP_CMD_RELEASE_FD: {
 		u32 i;
 		int ret;
@@ -1435,6 +1941,28 @@ static void task_msgs_add(struct mpp_task_msgs *msgs, struct list_head *head)
 		/* NOTE: update msg_flags for fd over 1024 */
 		session->msg_flags = msgs->flags;
 		ret = mpp_process_task(session, msgs);
+		/* task is not queued yet, so the fence can not miss done */
+		if (!ret && msgs->fence_req && msgs->task) {
+			ret = mpp_task_fence_create(msgs->task, msgs->mpp,
+						    msgs->fence_req->data);
+			if (ret) {
+				mpp_err("session %d create out fence failed %d\n",
+					session->index, ret);
+				/* let userspace fall back to poll */
+				put_user(-1, (s32 __user *)msgs->fence_req->data);
+				ret = 0;
+			}
+		}
+		if (!ret && msgs->in_fence_req && msgs->task) {
+			ret = mpp_task_in_fence_add(msgs->task, msgs->mpp,
+						    msgs->in_fence_req->data);
+			if (ret) {
+				/* the task is queued already, run it unfenced */
+				mpp_err("session %d in fence failed %d\n",
+					session->index, ret);
+				ret = 0;
+			}
+		}
 	}
 
 	if (!ret) {
@@ -1577,8 +2105,11 @@ static int mpp_collect_msgs(struct list_head *head, struct mpp_session *session,
 static void mpp_msgs_trigger(struct list_head *msgs_list)
 {
 	struct mpp_task_msgs *msgs, *n;
-	struct mpp_dev *mpp_prev = NULL;
 	struct mpp_taskqueue *queue_prev = NULL;
+	/* taskqueue_cnt never exceeds MPP_DEVICE_BUTT, one slot per queue */
+	struct mpp_dev *kick[MPP_DEVICE_BUTT];
+	u32 kick_cnt = 0;
+	u32 i;
 
 	/* push task to queue */
 	list_for_each_entry_safe(msgs, n, msgs_list, list) {
@@ -1594,16 +2125,17 @@ static void mpp_msgs_trigger(struct list_head *msgs_list)
 		queue = msgs->queue;
 
 		if (queue_prev != queue) {
-			if (queue_prev && mpp_prev) {
+			if (queue_prev)
 				mutex_unlock(&queue_prev->pending_lock);
-				mpp_taskqueue_trigger_work(mpp_prev);
-			}
-
-			if (queue)
-				mutex_lock(&queue->pending_lock);
 
-			mpp_prev = mpp;
+			mutex_lock(&queue->pending_lock);
 			queue_prev = queue;
+
+			for (i = 0; i < kick_cnt; i++)
+				if (kick[i]->queue == queue)
+					break;
+			if (i == kick_cnt && kick_cnt < ARRAY_SIZE(kick))
+				kick[kick_cnt++] = mpp;
 		}
 
 		if (test_bit(TASK_STATE_ABORT, &task->state))
@@ -1613,10 +2145,15 @@ static void mpp_msgs_trigger(struct list_head *msgs_list)
 		list_add_tail(&task->queue_link, &queue->pending_list);
 	}
 
-	if (mpp_prev && queue_prev) {
+	if (queue_prev)
 		mutex_unlock(&queue_prev->pending_lock);
-		mpp_taskqueue_trigger_work(mpp_prev);
-	}
+
+	/*
+	 * Wake each queue worker once after the whole batch is queued, so
+	 * multi-session batches do not pay one wakeup per session switch.
+	 */
+	for (i = 0; i < kick_cnt; i++)
+		mpp_taskqueue_trigger_work(kick[i]);
 }
 
 static void mpp_msgs_wait(struct list_head *msgs_list)
@@ -1681,6 +2218,24 @@ static long mpp_dev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg
 	return ret;
 }
 
+/*
+ * IORING_OP_URING_CMD: cmd_op and the first u64 of the command data are
+ * the cmd and the argument of the ioctl. The messages may wait for the
+ * hardware, so they always run from an io-wq worker where the ring
+ * batches their completions.
+ */
+static int mpp_dev_uring_cmd(struct io_uring_cmd *ioucmd,
+			     unsigned int issue_flags)
+{
+	const u64 *arg = ioucmd->cmd;
+
+	if (issue_flags & IO_URING_F_NONBLOCK)
+		return -EAGAIN;
+
+	return mpp_dev_ioctl(ioucmd->file, ioucmd->cmd_op,
+			     (unsigned long)READ_ONCE(*arg));
+}
+
 static int mpp_dev_open(struct inode *inode, struct file *filp)
 {
 	struct mpp_session *session = NULL;
@@ -1742,6 +2297,7 @@ const struct file_operations rockchip_mpp_fops = {
 #ifdef CONFIG_COMPAT
 	.compat_ioctl   = mpp_dev_ioctl,
 #endif
+	.uring_cmd	= mpp_dev_uring_cmd,
 };
 
 struct mpp_mem_region *
@@ -1954,6 +2510,7 @@ int mpp_task_init(struct mpp_session *session, struct mpp_task *task)
 	task->state = 0;
 	task->mem_count = 0;
 	task->session = session;
+	task->hwcg = hwaccel_cgroup_get();
 
 	return 0;
 }
@@ -1973,6 +2530,7 @@ int mpp_task_finish(struct mpp_session *session,
 
 	set_bit(TASK_STATE_FINISH, &task->state);
 	set_bit(TASK_STATE_DONE, &task->state);
+	mpp_task_fence_signal(task, 0);
 
 	if (session->srv->timing_en) {
 		s64 time_diff;
@@ -2100,6 +2658,65 @@ void mpp_reg_show_range(struct mpp_dev *mpp, u32 start, u32 end)
 }
 
 /* The device will do more probing work after this */
+/*
+ * thermal cooling: the encoder or decoder can not drop frames on its own,
+ * the state is reported through MPP_CMD_QUERY_COOLING_STATE so that the
+ * user lowers fps, resolution or bitrate in planned steps, and drivers
+ * may skip their clock boost while it is non zero.
+ */
+static int mpp_cool_get_max_state(struct thermal_cooling_device *cdev,
+				  unsigned long *state)
+{
+	struct mpp_dev *mpp = cdev->devdata;
+
+	*state = mpp->cooling_max;
+	return 0;
+}
+
+static int mpp_cool_get_cur_state(struct thermal_cooling_device *cdev,
+				  unsigned long *state)
+{
+	struct mpp_dev *mpp = cdev->devdata;
+
+	*state = READ_ONCE(mpp->cooling_state);
+	return 0;
+}
+
+static int mpp_cool_set_cur_state(struct thermal_cooling_device *cdev,
+				  unsigned long state)
+{
+	struct mpp_dev *mpp = cdev->devdata;
+
+	if (state > mpp->cooling_max)
+		return -EINVAL;
+
+	WRITE_ONCE(mpp->cooling_state, state);
+	return 0;
+}
+
+static const struct thermal_cooling_device_ops mpp_cooling_ops = {
+	.get_max_state = mpp_cool_get_max_state,
+	.get_cur_state = mpp_cool_get_cur_state,
+	.set_cur_state = mpp_cool_set_cur_state,
+};
+
+static void mpp_cooling_register(struct mpp_dev *mpp)
+{
+	struct device_node *np = mpp->dev->of_node;
+
+	if (!of_find_property(np, "#cooling-cells", NULL))
+		return;
+
+	mpp->cooling_max = 3;
+	of_property_read_u32(np, "rockchip,cooling-levels", &mpp->cooling_max);
+	mpp->cdev = thermal_of_cooling_device_register(np, dev_name(mpp->dev),
+						       mpp, &mpp_cooling_ops);
+	if (IS_ERR(mpp->cdev)) {
+		dev_warn(mpp->dev, "failed to register cooling device\n");
+		mpp->cdev = NULL;
+	}
+}
+
 int mpp_dev_probe(struct mpp_dev *mpp,
 		  struct platform_device *pdev)
 {
@@ -2136,11 +2753,15 @@ int mpp_dev_probe(struct mpp_dev *mpp,
 	pm_runtime_use_autosuspend(dev);
 
 	kthread_init_work(&mpp->work, mpp_task_worker_default);
+	hrtimer_init(&mpp->throttle_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	mpp->throttle_timer.function = mpp_throttle_timer;
 
 	atomic_set(&mpp->reset_request, 0);
 	atomic_set(&mpp->session_index, 0);
 	atomic_set(&mpp->task_count, 0);
 	atomic_set(&mpp->task_index, 0);
+	mpp->fence_context = dma_fence_context_alloc(1);
+	mpp->dma_cache = mpp_dma_cache_create();
 
 	device_init_wakeup(dev, true);
 	pm_runtime_enable(dev);
@@ -2198,9 +2819,12 @@ int mpp_dev_probe(struct mpp_dev *mpp,
 			mpp->hw_ops->clk_off(mpp);
 		pm_runtime_put_sync(dev);
 	}
+	mpp_cooling_register(mpp);
 
 	return ret;
 failed:
+	mpp_dma_cache_destroy(mpp->dma_cache);
+	mpp->dma_cache = NULL;
 	mpp_detach_workqueue(mpp);
 	device_init_wakeup(dev, false);
 	pm_runtime_disable(dev);
@@ -2210,10 +2834,15 @@ int mpp_dev_probe(struct mpp_dev *mpp,
 
 int mpp_dev_remove(struct mpp_dev *mpp)
 {
+	if (mpp->cdev)
+		thermal_cooling_device_unregister(mpp->cdev);
 	if (mpp->hw_ops->exit)
 		mpp->hw_ops->exit(mpp);
 
 	mpp_iommu_remove(mpp->iommu_info);
+	mpp_dma_cache_destroy(mpp->dma_cache);
+	mpp->dma_cache = NULL;
+	hrtimer_cancel(&mpp->throttle_timer);
 	mpp_detach_workqueue(mpp);
 	device_init_wakeup(mpp->dev, false);
 	pm_runtime_disable(mpp->dev);
@@ -2258,6 +2887,10 @@ irqreturn_t mpp_dev_irq(int irq, void *param)
 	irqreturn_t irq_ret = IRQ_NONE;
 	u32 timing_en = mpp->srv->timing_en;
 
+#ifdef CONFIG_ROCKCHIP_MPP_BENCH
+	if (unlikely(READ_ONCE(mpp->bench_run)))
+		return mpp_bench_irq(mpp);
+#endif
 	if (task && timing_en) {
 		task->on_irq = ktime_get();
 		set_bit(TASK_TIMING_IRQ, &task->state);
@@ -2282,6 +2915,15 @@ irqreturn_t mpp_dev_irq(int irq, void *param)
 				set_bit(TASK_TIMING_TO_CANCEL, &task->state);
 			}
 			cancel_delayed_work(&task->timeout_work);
+			if (task->lat_start_ns) {
+				u64 ns = ktime_get_boottime_ns();
+
+				rk_lat_hist_add(&mpp->hw_hist, ns - task->lat_start_ns);
+				hwaccel_cgroup_charge(task->hwcg, HWACCEL_MPP,
+						      ns - task->lat_start_ns);
+				trace_rkmpp_task_done(dev_name(mpp->dev), task->session->index,
+						      task->task_index, task->lat_start_ns, ns);
+			}
 			/* normal condition, set state and wake up isr thread */
 			set_bit(TASK_STATE_IRQ, &task->state);
 		}
@@ -2624,9 +3266,41 @@ mpp_procfs_create_u32(const char *name, umode_t mode,
 	return proc_create_data(name, mode, parent, &procfs_fops_u32, data);
 }
 
+static int mpp_show_latency(struct seq_file *file, void *v)
+{
+	struct mpp_dev *mpp = file->private;
+
+	rk_lat_hist_show(file, "create-to-start", &mpp->wait_hist);
+	rk_lat_hist_show(file, "hw-run", &mpp->hw_hist);
+	seq_printf(file, "%-16s soft:%u full:%u\n", "timeout-recover",
+		   mpp->recover_soft, mpp->recover_full);
+	rk_lat_hist_show(file, "recover", &mpp->recover_hist);
+
+	return 0;
+}
+
+static int mpp_show_dma_cache(struct seq_file *file, void *v)
+{
+	struct mpp_dev *mpp = file->private;
+
+	mpp_dma_cache_show(file, mpp->dma_cache);
+
+	return 0;
+}
+
 void mpp_procfs_create_common(struct proc_dir_entry *parent, struct mpp_dev *mpp)
 {
 	mpp_procfs_create_u32("disable_work", 0644, parent, &mpp->disable);
 	mpp_procfs_create_u32("timing_check", 0644, parent, &mpp->timing_check);
+	if (mpp->cdev)
+		mpp_procfs_create_u32("cooling_state", 0444, parent,
+				      &mpp->cooling_state);
+	proc_create_single_data("latency", 0444, parent, mpp_show_latency, mpp);
+	if (mpp->dma_cache) {
+		proc_create_single_data("dma-cache", 0444, parent,
+					mpp_show_dma_cache, mpp);
+		mpp_procfs_create_u32("dma_cache_max", 0644, parent,
+				      &mpp->dma_cache->max_buffers);
+	}
 }
 #endif
@@ -12,8 +12,11 @@
 #define __ROCKCHIP_MPP_COMMON_H__
 
 #include <linux/cdev.h>
+#include <linux/cgroup_hwaccel.h>
 #include <linux/clk.h>
 #include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/hrtimer.h>
 #include <linux/kfifo.h>
 #include <linux/types.h>
 #include <linux/time.h>
@@ -24,6 +27,7 @@
 #include <linux/poll.h>
 #include <linux/platform_device.h>
 #include <soc/rockchip/pm_domains.h>
+#include <soc/rockchip/rockchip_lat_hist.h>
 
 #define MHZ				(1000 * 1000)
 #define MPP_WORK_TIMEOUT_DELAY		(500)
@@ -37,6 +41,10 @@
 #define MPP_FLAGS_REG_FD_NO_TRANS	(0x00000004)
 #define MPP_FLAGS_SCL_FD_NO_TRANS	(0x00000008)
 #define MPP_FLAGS_REG_NO_OFFSET		(0x00000010)
+/* reg write is kept by the session and replayed for following tasks */
+#define MPP_FLAGS_REG_TEMPLATE		(0x00000020)
+/* reg write starts the next picture of a batch task, jpgdec only */
+#define MPP_FLAGS_BATCH_PIC		(0x00000040)
 #define MPP_FLAGS_SECURE_MODE		(0x00010000)
 
 /* grf mask for get value */
@@ -101,6 +109,7 @@ enum MPP_DEV_COMMAND_TYPE {
 	MPP_CMD_QUERY_HW_SUPPORT	= MPP_CMD_QUERY_BASE + 0,
 	MPP_CMD_QUERY_HW_ID		= MPP_CMD_QUERY_BASE + 1,
 	MPP_CMD_QUERY_CMD_SUPPORT	= MPP_CMD_QUERY_BASE + 2,
+	MPP_CMD_QUERY_COOLING_STATE	= MPP_CMD_QUERY_BASE + 3,
 	MPP_CMD_QUERY_BUTT,
 
 	MPP_CMD_INIT_BASE		= 0x100,
@@ -115,6 +124,9 @@ enum MPP_DEV_COMMAND_TYPE {
 	MPP_CMD_SET_REG_ADDR_OFFSET	= MPP_CMD_SEND_BASE + 2,
 	MPP_CMD_SET_RCB_INFO		= MPP_CMD_SEND_BASE + 3,
 	MPP_CMD_SET_SESSION_FD		= MPP_CMD_SEND_BASE + 4,
+	MPP_CMD_SET_OUT_FENCE		= MPP_CMD_SEND_BASE + 5,
+	MPP_CMD_SET_SLICE_EVENT		= MPP_CMD_SEND_BASE + 6,
+	MPP_CMD_SET_IN_FENCE		= MPP_CMD_SEND_BASE + 7,
 	MPP_CMD_SEND_BUTT,
 
 	MPP_CMD_POLL_BASE		= 0x300,
@@ -127,6 +139,9 @@ enum MPP_DEV_COMMAND_TYPE {
 	MPP_CMD_TRANS_FD_TO_IOVA	= MPP_CMD_CONTROL_BASE + 1,
 	MPP_CMD_RELEASE_FD		= MPP_CMD_CONTROL_BASE + 2,
 	MPP_CMD_SEND_CODEC_INFO		= MPP_CMD_CONTROL_BASE + 3,
+	MPP_CMD_SET_ONLINE_MODE		= MPP_CMD_CONTROL_BASE + 4,
+	MPP_CMD_SET_SESSION_SCHED	= MPP_CMD_CONTROL_BASE + 5,
+	MPP_CMD_SEND_DMABUF_SOCK	= MPP_CMD_CONTROL_BASE + 6,
 	MPP_CMD_CONTROL_BUTT,
 
 	MPP_CMD_BUTT,
@@ -226,6 +241,10 @@ struct mpp_task_msgs {
 
 	struct mpp_request reqs[MPP_MAX_MSG_NUM];
 	struct mpp_request *poll_req;
+	/* return sync_file fd of task done fence */
+	struct mpp_request *fence_req;
+	/* sync_file fd the task waits on before it runs */
+	struct mpp_request *in_fence_req;
 };
 
 struct mpp_grf_info {
@@ -273,6 +292,41 @@ struct codec_info_elem {
 	__u64 data;
 };
 
+/*
+ * session scheduling on a shared taskqueue, set by MPP_CMD_SET_SESSION_SCHED
+ * prio: 0 for batch sessions shared by weight, above 0 for time critical
+ *       sessions which always run first, earliest frame deadline first
+ * weight: share of batch sessions, 0 means 1
+ * fps: frame rate for the deadline of time critical sessions, 0 means 30
+ */
+struct mpp_sched_cfg {
+	__u32 prio;
+	__u32 weight;
+	__u32 fps;
+	__u32 reserved;
+};
+
+/*
+ * send a range of a page backed dmabuf (e.g. encoder output) on a socket,
+ * set by MPP_CMD_SEND_DMABUF_SOCK
+ * the pages go to the stack as skb frags with MSG_ZEROCOPY, so with
+ * SO_ZEROCOPY set on the socket nothing is copied and the buffer may be
+ * reused once its completion is read from the socket error queue
+ * sock_fd: socket to send on
+ * buf_fd: dmabuf fd
+ * offset, len: range of the dmabuf to send
+ * flags: MSG_DONTWAIT / MSG_MORE passed to sendmsg
+ * sent: bytes queued, written back
+ */
+struct mpp_sock_send {
+	__s32 sock_fd;
+	__s32 buf_fd;
+	__u32 offset;
+	__u32 len;
+	__u32 flags;
+	__u32 sent;
+};
+
 struct mpp_clk_info {
 	struct clk *clk;
 
@@ -321,6 +375,8 @@ struct mpp_dev {
 
 	/* per-device work for attached taskqueue */
 	struct kthread_work work;
+	/* kicks the work again once a throttled cgroup may run */
+	struct hrtimer throttle_timer;
 	/* the flag for get/get/reduce freq */
 	bool auto_freq_en;
 	/* the flag for pmu idle request before device reset */
@@ -370,6 +426,28 @@ struct mpp_dev {
 	/* common per-device procfs */
 	u32 disable;
 	u32 timing_check;
+	/* create to hw start and hw start to irq latency */
+	struct rk_lat_hist wait_hist;
+	struct rk_lat_hist hw_hist;
+	/* timeout recovery by soft reset or full reset and its latency */
+	u32 iommu_fault;
+	u32 recover_soft;
+	u32 recover_full;
+	struct rk_lat_hist recover_hist;
+	/* dma_fence timeline of task done */
+	u64 fence_context;
+	/* dma-buf mappings shared by sessions */
+	struct mpp_dma_cache *dma_cache;
+	/* thermal cooling state reported to the user, 0 is full quality */
+	struct thermal_cooling_device *cdev;
+	u32 cooling_state;
+	u32 cooling_max;
+#ifdef CONFIG_ROCKCHIP_MPP_BENCH
+	/* register replay benchmark, recording or replaying */
+	struct mpp_bench *bench;
+	bool bench_rec;
+	bool bench_run;
+#endif
 };
 
 struct mpp_session {
@@ -416,6 +494,13 @@ struct mpp_session {
 	struct list_head list_msgs;
 	struct list_head list_msgs_idle;
 	spinlock_t lock_msgs;
+
+	/* scheduling on taskqueue, protected by queue pending_lock */
+	struct mpp_sched_cfg sched;
+	u64 sched_vtime;
+	u32 sched_pass;
+	/* task create to hardware start */
+	struct rk_lat_hist wait_hist;
 };
 
 /* task state in work thread */
@@ -485,6 +570,14 @@ struct mpp_task {
 	ktime_t on_cancel_timeout;
 	ktime_t on_isr;
 	ktime_t on_finish;
+	/* boottime stamps for latency histogram and trace */
+	u64 lat_create_ns;
+	u64 lat_start_ns;
+	/* signalled when task is done, exported by MPP_CMD_SET_OUT_FENCE */
+	struct dma_fence *out_fence;
+	/* input producer fence, set by MPP_CMD_SET_IN_FENCE */
+	struct dma_fence *in_fence;
+	struct dma_fence_cb in_fence_cb;
 
 	/* hardware info for current task */
 	struct mpp_hw_info *hw_info;
@@ -499,6 +592,8 @@ struct mpp_task {
 	s32 core_id;
 	/* hw cycles */
 	u32 hw_cycles;
+	/* hwaccel cgroup of the submitter, charged with the hw time */
+	struct hwaccel_cgroup *hwcg;
 };
 
 struct mpp_taskqueue {
@@ -545,6 +640,11 @@ struct mpp_taskqueue {
 	u32 core_count;
 	unsigned long dev_active_flags;
 	u32 iommu_fault;
+
+	/* some session set MPP_CMD_SET_SESSION_SCHED, stop plain fifo */
+	u32 sched_en;
+	u32 sched_pass;
+	u64 sched_vtime;
 };
 
 struct mpp_reset_group {
@@ -608,6 +708,8 @@ struct mpp_hw_ops {
 			struct mpp_task *mpp_task);
 	int (*reduce_freq)(struct mpp_dev *mpp);
 	int (*reset)(struct mpp_dev *mpp);
+	/* core only reset, keeps iommu and clock state */
+	int (*soft_reset)(struct mpp_dev *mpp);
 	int (*set_grf)(struct mpp_dev *mpp);
 };
 
@@ -688,6 +790,7 @@ void mpp_task_dump_timing(struct mpp_task *task, s64 time_diff);
 void mpp_reg_show(struct mpp_dev *mpp, u32 offset);
 void mpp_reg_show_range(struct mpp_dev *mpp, u32 start, u32 end);
 void mpp_free_task(struct kref *ref);
+void mpp_task_fence_signal(struct mpp_task *task, int error);
 
 void mpp_session_deinit(struct mpp_session *session);
 void mpp_session_cleanup_detach(struct mpp_taskqueue *queue,
@@ -735,12 +838,42 @@ unsigned long mpp_get_clk_info_rate_hz(struct mpp_clk_info *clk_info,
 int mpp_clk_set_rate(struct mpp_clk_info *clk_info,
 		     enum MPP_CLOCK_MODE mode);
 
+#ifdef CONFIG_ROCKCHIP_MPP_BENCH
+void mpp_bench_record(struct mpp_dev *mpp, u32 reg, u32 val);
+void mpp_bench_capture_begin(struct mpp_dev *mpp, struct mpp_task *task);
+void mpp_bench_capture_end(struct mpp_dev *mpp);
+irqreturn_t mpp_bench_irq(struct mpp_dev *mpp);
+void mpp_bench_procfs_init(struct proc_dir_entry *parent, struct mpp_dev *mpp);
+
+static inline void mpp_bench_write(struct mpp_dev *mpp, u32 reg, u32 val)
+{
+	if (unlikely(READ_ONCE(mpp->bench_rec)))
+		mpp_bench_record(mpp, reg, val);
+}
+#else
+static inline void mpp_bench_capture_begin(struct mpp_dev *mpp,
+					   struct mpp_task *task)
+{
+}
+static inline void mpp_bench_capture_end(struct mpp_dev *mpp)
+{
+}
+static inline void mpp_bench_procfs_init(struct proc_dir_entry *parent,
+					 struct mpp_dev *mpp)
+{
+}
+static inline void mpp_bench_write(struct mpp_dev *mpp, u32 reg, u32 val)
+{
+}
+#endif
+
 static inline int mpp_write(struct mpp_dev *mpp, u32 reg, u32 val)
 {
 	int idx = reg / sizeof(u32);
 
 	mpp_debug(DEBUG_SET_REG,
 		  "write reg[%03d]: %04x: 0x%08x\n", idx, reg, val);
+	mpp_bench_write(mpp, reg, val);
 	writel(val, mpp->reg_base + reg);
 
 	return 0;
@@ -752,6 +885,7 @@ static inline int mpp_write_relaxed(struct mpp_dev *mpp, u32 reg, u32 val)
 
 	mpp_debug(DEBUG_SET_REG,
 		  "write reg[%03d]: %04x: 0x%08x\n", idx, reg, val);
+	mpp_bench_write(mpp, reg, val);
 	writel_relaxed(val, mpp->reg_base + reg);
 
 	return 0;
@@ -57,6 +57,181 @@ mpp_dma_find_buffer_fd(struct mpp_dma_session *dma, int fd)
 	return out;
 }
 
+static void mpp_dma_cache_free_entry(struct mpp_dma_cache_entry *entry)
+{
+	dma_buf_unmap_attachment(entry->attach, entry->sgt, entry->dir);
+	dma_buf_detach(entry->dmabuf, entry->attach);
+	dma_buf_put(entry->dmabuf);
+	kfree(entry);
+}
+
+/* Take over the cached mapping of dmabuf, with its dmabuf reference */
+static struct mpp_dma_cache_entry *
+mpp_dma_cache_get(struct mpp_dma_cache *cache, struct dma_buf *dmabuf)
+{
+	struct mpp_dma_cache_entry *entry, *out = NULL;
+
+	if (!cache)
+		return NULL;
+
+	mutex_lock(&cache->lock);
+	list_for_each_entry(entry, &cache->lru, link) {
+		if (entry->dmabuf == dmabuf) {
+			list_del_init(&entry->link);
+			cache->count--;
+			out = entry;
+			break;
+		}
+	}
+	if (out)
+		cache->hit++;
+	else
+		cache->miss++;
+	mutex_unlock(&cache->lock);
+
+	return out;
+}
+
+/* Park the mapping of buffer in cache, return false if caller must unmap */
+static bool mpp_dma_cache_put(struct mpp_dma_cache *cache,
+			      struct mpp_dma_buffer *buffer)
+{
+	struct mpp_dma_cache_entry *entry = NULL, *oldest;
+
+	if (!cache)
+		return false;
+
+	if (READ_ONCE(cache->max_buffers))
+		entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+
+	mutex_lock(&cache->lock);
+	if (entry) {
+		entry->dmabuf = buffer->dmabuf;
+		entry->attach = buffer->attach;
+		entry->sgt = buffer->sgt;
+		entry->dir = buffer->dir;
+		list_add_tail(&entry->link, &cache->lru);
+		cache->count++;
+	}
+	while (cache->count > cache->max_buffers) {
+		oldest = list_first_entry(&cache->lru,
+					  struct mpp_dma_cache_entry, link);
+		list_del_init(&oldest->link);
+		cache->count--;
+		cache->evict++;
+		mpp_dma_cache_free_entry(oldest);
+	}
+	mutex_unlock(&cache->lock);
+
+	return entry ? true : false;
+}
+
+/*
+ * No fd or other user is left for a dma-buf the cache holds the last
+ * reference of, so the entry can never hit again and only pins memory.
+ */
+static bool mpp_dma_cache_entry_orphan(struct mpp_dma_cache_entry *entry)
+{
+	return file_count(entry->dmabuf->file) == 1;
+}
+
+static unsigned long
+mpp_dma_cache_count_objects(struct shrinker *shrinker,
+			    struct shrink_control *sc)
+{
+	struct mpp_dma_cache *cache =
+		container_of(shrinker, struct mpp_dma_cache, shrinker);
+	struct mpp_dma_cache_entry *entry;
+	unsigned long pages = 0;
+
+	if (!mutex_trylock(&cache->lock))
+		return 0;
+	list_for_each_entry(entry, &cache->lru, link) {
+		if (mpp_dma_cache_entry_orphan(entry))
+			pages += entry->dmabuf->size >> PAGE_SHIFT;
+	}
+	mutex_unlock(&cache->lock);
+
+	return pages ? : SHRINK_EMPTY;
+}
+
+static unsigned long
+mpp_dma_cache_scan_objects(struct shrinker *shrinker,
+			   struct shrink_control *sc)
+{
+	struct mpp_dma_cache *cache =
+		container_of(shrinker, struct mpp_dma_cache, shrinker);
+	struct mpp_dma_cache_entry *entry, *n;
+	unsigned long freed = 0;
+
+	if (!mutex_trylock(&cache->lock))
+		return SHRINK_STOP;
+	list_for_each_entry_safe(entry, n, &cache->lru, link) {
+		if (freed >= sc->nr_to_scan)
+			break;
+		if (!mpp_dma_cache_entry_orphan(entry))
+			continue;
+		freed += entry->dmabuf->size >> PAGE_SHIFT;
+		list_del_init(&entry->link);
+		cache->count--;
+		mpp_dma_cache_free_entry(entry);
+	}
+	cache->shrunk += freed;
+	mutex_unlock(&cache->lock);
+
+	return freed ? : SHRINK_STOP;
+}
+
+struct mpp_dma_cache *mpp_dma_cache_create(void)
+{
+	struct mpp_dma_cache *cache;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return NULL;
+
+	INIT_LIST_HEAD(&cache->lru);
+	mutex_init(&cache->lock);
+	cache->max_buffers = MPP_DMA_CACHE_MAX_BUFFERS;
+
+	/* orphans cost nothing to drop, so go before any page cache */
+	cache->shrinker.count_objects = mpp_dma_cache_count_objects;
+	cache->shrinker.scan_objects = mpp_dma_cache_scan_objects;
+	cache->shrinker.seeks = 1;
+	cache->has_shrinker = !register_shrinker(&cache->shrinker);
+
+	return cache;
+}
+
+void mpp_dma_cache_destroy(struct mpp_dma_cache *cache)
+{
+	struct mpp_dma_cache_entry *entry, *n;
+
+	if (!cache)
+		return;
+
+	if (cache->has_shrinker)
+		unregister_shrinker(&cache->shrinker);
+	mutex_lock(&cache->lock);
+	list_for_each_entry_safe(entry, n, &cache->lru, link) {
+		list_del_init(&entry->link);
+		mpp_dma_cache_free_entry(entry);
+	}
+	cache->count = 0;
+	mutex_unlock(&cache->lock);
+
+	kfree(cache);
+}
+
+void mpp_dma_cache_show(struct seq_file *file, struct mpp_dma_cache *cache)
+{
+	mutex_lock(&cache->lock);
+	seq_printf(file, "count %u max %u hit %llu miss %llu evict %llu shrunk %llu pages\n",
+		   cache->count, cache->max_buffers,
+		   cache->hit, cache->miss, cache->evict, cache->shrunk);
+	mutex_unlock(&cache->lock);
+}
+
 /* Release the buffer from the current list */
 static void mpp_dma_release_buffer(struct kref *ref)
 {
@@ -66,9 +241,11 @@ static void mpp_dma_release_buffer(struct kref *ref)
 	buffer->dma->buffer_count--;
 	list_move_tail(&buffer->link, &buffer->dma->unused_list);
 
-	dma_buf_unmap_attachment(buffer->attach, buffer->sgt, buffer->dir);
-	dma_buf_detach(buffer->dmabuf, buffer->attach);
-	dma_buf_put(buffer->dmabuf);
+	if (!mpp_dma_cache_put(buffer->dma->cache, buffer)) {
+		dma_buf_unmap_attachment(buffer->attach, buffer->sgt, buffer->dir);
+		dma_buf_detach(buffer->dmabuf, buffer->attach);
+		dma_buf_put(buffer->dmabuf);
+	}
 	buffer->dma = NULL;
 	buffer->dmabuf = NULL;
 	buffer->attach = NULL;
@@ -184,6 +361,7 @@ struct mpp_dma_buffer *mpp_dma_import_fd(struct mpp_iommu_info *iommu_info,
 	struct dma_buf *dmabuf;
 	struct mpp_dma_buffer *buffer;
 	struct dma_buf_attachment *attach;
+	struct mpp_dma_cache_entry *entry;
 
 	if (!dma) {
 		mpp_err("dma session is null\n");
@@ -226,6 +404,18 @@ struct mpp_dma_buffer *mpp_dma_import_fd(struct mpp_iommu_info *iommu_info,
 	buffer->dir = DMA_BIDIRECTIONAL;
 	buffer->last_used = ktime_get();
 
+	/* reuse the mapping released by this or an other session */
+	entry = mpp_dma_cache_get(dma->cache, dmabuf);
+	if (entry) {
+		/* the cache entry brings its own dmabuf reference */
+		dma_buf_put(dmabuf);
+		attach = entry->attach;
+		sgt = entry->sgt;
+		buffer->dir = entry->dir;
+		kfree(entry);
+		goto mapped;
+	}
+
 	attach = dma_buf_attach(buffer->dmabuf, dma->dev);
 	if (IS_ERR(attach)) {
 		ret = PTR_ERR(attach);
@@ -239,6 +429,7 @@ struct mpp_dma_buffer *mpp_dma_import_fd(struct mpp_iommu_info *iommu_info,
 		mpp_err("dma_buf_map_attachment fd %d failed(%d)\n", fd, ret);
 		goto fail_map;
 	}
+mapped:
 	buffer->iova = sg_dma_address(sgt->sgl);
 	buffer->size = sg_dma_len(sgt->sgl);
 	buffer->attach = attach;
@@ -342,7 +533,8 @@ int mpp_dma_session_destroy(struct mpp_dma_session *dma)
 }
 
 struct mpp_dma_session *
-mpp_dma_session_create(struct device *dev, u32 max_buffers)
+mpp_dma_session_create(struct device *dev, u32 max_buffers,
+		       struct mpp_dma_cache *cache)
 {
 	int i;
 	struct mpp_dma_session *dma = NULL;
@@ -371,6 +563,7 @@ mpp_dma_session_create(struct device *dev, u32 max_buffers)
 		list_add_tail(&buffer->link, &dma->unused_list);
 	}
 	dma->dev = dev;
+	dma->cache = cache;
 
 	return dma;
 }
@@ -454,6 +647,9 @@ static int mpp_iommu_handle(struct iommu_domain *iommu,
 		return 0;
 	}
 
+	/* a stalled iommu needs the full reset on timeout */
+	mpp->iommu_fault = 1;
+
 	if (mpp->dev_ops && mpp->dev_ops->dump_dev)
 		mpp->dev_ops->dump_dev(mpp);
 	else
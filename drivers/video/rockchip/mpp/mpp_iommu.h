@@ -14,6 +14,8 @@
 #include <linux/iommu.h>
 #include <linux/dma-mapping.h>
 #include <linux/interrupt.h>
+#include <linux/seq_file.h>
+#include <linux/shrinker.h>
 
 struct mpp_dma_buffer {
 	/* link to dma session buffer list */
@@ -39,6 +41,37 @@ struct mpp_dma_buffer {
 };
 
 #define MPP_SESSION_MAX_BUFFERS		60
+#define MPP_DMA_CACHE_MAX_BUFFERS	32
+
+/*
+ * Device level cache of dma-buf mappings released by sessions. Lookup is
+ * keyed by struct dma_buf, so a buffer pool rotating fds or sessions being
+ * recreated do not remap the same buffers again.
+ */
+struct mpp_dma_cache_entry {
+	struct list_head link;
+	struct dma_buf *dmabuf;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	enum dma_data_direction dir;
+};
+
+struct mpp_dma_cache {
+	/* least recently released at head */
+	struct list_head lru;
+	struct mutex lock;
+	u32 count;
+	/* 0 disables the cache */
+	u32 max_buffers;
+
+	u64 hit;
+	u64 miss;
+	u64 evict;
+	/* entries whose dma-buf only the cache still holds, in pages */
+	struct shrinker shrinker;
+	bool has_shrinker;
+	u64 shrunk;
+};
 
 struct mpp_dma_session {
 	/* the buffer used in session */
@@ -51,6 +84,8 @@ struct mpp_dma_session {
 	u32 max_buffers;
 	/* the count for the buffer list */
 	int buffer_count;
+	/* device cache shared by all sessions, may be NULL */
+	struct mpp_dma_cache *cache;
 
 	struct device *dev;
 };
@@ -86,9 +121,14 @@ struct mpp_iommu_info {
 };
 
 struct mpp_dma_session *
-mpp_dma_session_create(struct device *dev, u32 max_buffers);
+mpp_dma_session_create(struct device *dev, u32 max_buffers,
+		       struct mpp_dma_cache *cache);
 int mpp_dma_session_destroy(struct mpp_dma_session *dma);
 
+struct mpp_dma_cache *mpp_dma_cache_create(void);
+void mpp_dma_cache_destroy(struct mpp_dma_cache *cache);
+void mpp_dma_cache_show(struct seq_file *file, struct mpp_dma_cache *cache);
+
 struct mpp_dma_buffer *
 mpp_dma_alloc(struct device *dev, size_t size);
 int mpp_dma_free(struct mpp_dma_buffer *buffer);
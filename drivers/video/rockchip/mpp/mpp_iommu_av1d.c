@@ -43,6 +43,14 @@ struct av1_iommu_domain {
 	/* for av1 iommu */
 	u64 *pta; /* page directory table */
 	dma_addr_t pta_dma;
+	/*
+	 * Bumped on every table or mmu state change. The decoder asks for a
+	 * tlb flush before each frame, which is only done when the tables
+	 * moved on since the last one, so a session reusing its mapped
+	 * buffers keeps a warm tlb.
+	 */
+	atomic_t map_gen;
+	u32 tlb_gen; /* map_gen seen by the last flush, iommus_lock */
 };
 
 struct av1_iommu {
@@ -189,6 +197,8 @@ static void av1_iommu_disable(struct av1_iommu *iommu)
 {
 	int i;
 
+	if (iommu->domain)
+		atomic_inc(&to_av1_domain(iommu->domain)->map_gen);
 	/* Ignore error while disabling, just keep going */
 	WARN_ON(clk_bulk_enable(iommu->num_clocks, iommu->clocks));
 	for (i = 0; i < iommu->num_mmu; i++)
@@ -219,6 +229,7 @@ static int av1_iommu_enable(struct av1_iommu *iommu)
 	if (ret)
 		return ret;
 
+	atomic_inc(&av1_domain->map_gen);
 	for (i = 0; i < iommu->num_mmu; i++) {
 		u32 val = readl(iommu->bases[i] + AV1_MMU_AHB_CONTROL_BASE);
 
@@ -288,11 +299,15 @@ static void av1_iommu_write(void __iomem *base, u32 offset, u32 value)
 static void av1_iommu_flush_tlb_all(struct iommu_domain *domain)
 {
 	struct av1_iommu_domain *av1_domain = to_av1_domain(domain);
+	u32 gen = atomic_read(&av1_domain->map_gen);
+	bool flushed = true;
 	struct list_head *pos;
 	unsigned long flags;
 	int i;
 
 	spin_lock_irqsave(&av1_domain->iommus_lock, flags);
+	if (av1_domain->tlb_gen == gen)
+		goto out;
 	list_for_each(pos, &av1_domain->iommus) {
 		struct av1_iommu *iommu;
 		int ret;
@@ -310,8 +325,14 @@ static void av1_iommu_flush_tlb_all(struct iommu_domain *domain)
 			}
 			clk_bulk_disable(iommu->num_clocks, iommu->clocks);
 			pm_runtime_put(iommu->dev);
+		} else {
+			flushed = false;
 		}
 	}
+	/* flush again next time when an mmu was powered down */
+	if (flushed)
+		av1_domain->tlb_gen = gen;
+out:
 	spin_unlock_irqrestore(&av1_domain->iommus_lock, flags);
 }
 
@@ -413,6 +434,8 @@ static struct iommu_domain *av1_iommu_domain_alloc(unsigned type)
 	spin_lock_init(&av1_domain->iommus_lock);
 	spin_lock_init(&av1_domain->dt_lock);
 	INIT_LIST_HEAD(&av1_domain->iommus);
+	/* nothing flushed yet */
+	atomic_set(&av1_domain->map_gen, 1);
 
 	av1_domain->domain.geometry.aperture_start = 0;
 	av1_domain->domain.geometry.aperture_end   = DMA_BIT_MASK(32);
@@ -584,6 +607,7 @@ static size_t av1_iommu_unmap(struct iommu_domain *domain, unsigned long _iova,
 	pte_addr = (u32 *)phys_to_virt(pt_phys) + av1_iova_pte_index(iova);
 	pte_dma = pt_phys + av1_iova_pte_index(iova) * sizeof(u32);
 	unmap_size = av1_iommu_unmap_iova(av1_domain, pte_addr, pte_dma, size);
+	atomic_inc(&av1_domain->map_gen);
 
 	spin_unlock_irqrestore(&av1_domain->dt_lock, flags);
 
@@ -614,6 +638,7 @@ static int av1_iommu_map(struct iommu_domain *domain, unsigned long _iova,
 	pte_dma = av1_dte_pt_address(dte) + pte_index * sizeof(u32);
 	ret = av1_iommu_map_iova(av1_domain, pte_addr, pte_dma, iova,
 				   paddr, size, prot);
+	atomic_inc(&av1_domain->map_gen);
 
 	spin_unlock_irqrestore(&av1_domain->dt_lock, flags);
 
@@ -57,6 +57,8 @@
 #define JPGDEC_TIMEOUT_EN		BIT(2)
 #define JPGDEC_IRQ_DIS			BIT(1)
 #define JPGDEC_START_EN			BIT(0)
+#define JPGDEC_ERROR_MASK		(JPGDEC_BUS_STA | JPGDEC_ERROR_STA | \
+					 JPGDEC_TIMEOUT_STA | JPGDEC_BUF_EMPTY_STA)
 
 #define JPGDEC_REG_SYS_BASE		0x008
 #define JPGDEC_FORCE_SOFTRESET_VALID	BIT(17)
@@ -69,26 +71,45 @@
 #define JPGDEC_REG_STREAM_RLC_BASE		0x030
 #define JPGDEC_REG_STREAM_RLC_BASE_INDEX	(12)
 
+/* every picture needs a write and a read, one more for the poll */
+#define JPGDEC_BATCH_MAX		((MPP_MAX_MSG_NUM - 1) / 2)
+
 #define to_jpgdec_task(task)	\
 		container_of(task, struct jpgdec_task, mpp_task)
 #define to_jpgdec_dev(dev)	\
 		container_of(dev, struct jpgdec_dev, mpp)
 
-struct jpgdec_task {
-	struct mpp_task mpp_task;
-	enum MPP_CLOCK_MODE clk_mode;
+struct jpgdec_pic {
 	u32 reg[JPGDEC_REG_NUM];
 
 	struct reg_offset_info off_inf;
 	u32 strm_addr;
 	u32 irq_status;
-	/* req for current task */
+	/* req for current picture */
 	u32 w_req_cnt;
 	struct mpp_request w_reqs[MPP_MAX_MSG_NUM];
 	u32 r_req_cnt;
 	struct mpp_request r_reqs[MPP_MAX_MSG_NUM];
 };
 
+/*
+ * A task may carry a batch of pictures, each following one started by a
+ * reg write with MPP_FLAGS_BATCH_PIC. The irq of one picture starts the
+ * next, so a batch of thumbnails pays the session, worker and isr round
+ * trip once and maps a buffer shared by its pictures once.
+ */
+struct jpgdec_task {
+	struct mpp_task mpp_task;
+	enum MPP_CLOCK_MODE clk_mode;
+
+	struct jpgdec_pic pic;
+	/* pictures after the first one */
+	struct jpgdec_pic *batch;
+	u32 pic_cnt;
+	/* picture on the hardware */
+	u32 pic_idx;
+};
+
 struct jpgdec_dev {
 	struct mpp_dev mpp;
 
@@ -124,22 +145,50 @@ static struct mpp_trans_info jpgdec_v1_trans[] = {
 	},
 };
 
+static struct jpgdec_pic *jpgdec_get_pic(struct jpgdec_task *task, u32 idx)
+{
+	return idx ? &task->batch[idx - 1] : &task->pic;
+}
+
 static int jpgdec_process_reg_fd(struct mpp_session *session,
 				 struct jpgdec_task *task,
 				 struct mpp_task_msgs *msgs)
 {
+	struct jpgdec_pic *pic;
 	int ret = 0;
+	u32 i;
 
-	ret = mpp_translate_reg_address(session, &task->mpp_task,
-					JPEGDEC_FMT_DEFAULT, task->reg, &task->off_inf);
-	if (ret)
-		return ret;
+	/* a dma-buf shared by the pictures is attached to the task once */
+	for (i = 0; i < task->pic_cnt; i++) {
+		pic = jpgdec_get_pic(task, i);
+		ret = mpp_translate_reg_address(session, &task->mpp_task,
+						JPEGDEC_FMT_DEFAULT, pic->reg,
+						&pic->off_inf);
+		if (ret)
+			return ret;
 
-	mpp_translate_reg_offset_info(&task->mpp_task,
-				      &task->off_inf, task->reg);
+		mpp_translate_reg_offset_info(&task->mpp_task,
+					      &pic->off_inf, pic->reg);
+	}
 	return 0;
 }
 
+static struct jpgdec_pic *jpgdec_next_pic(struct jpgdec_task *task)
+{
+	if (task->pic_cnt == JPGDEC_BATCH_MAX) {
+		mpp_err("more than %d pictures in a batch\n", JPGDEC_BATCH_MAX);
+		return ERR_PTR(-EINVAL);
+	}
+	if (!task->batch) {
+		task->batch = kcalloc(JPGDEC_BATCH_MAX - 1,
+				      sizeof(*task->batch), GFP_KERNEL);
+		if (!task->batch)
+			return ERR_PTR(-ENOMEM);
+	}
+
+	return jpgdec_get_pic(task, task->pic_cnt++);
+}
+
 static int jpgdec_extract_task_msg(struct jpgdec_task *task,
 				   struct mpp_task_msgs *msgs)
 {
@@ -147,7 +196,9 @@ static int jpgdec_extract_task_msg(struct jpgdec_task *task,
 	int ret;
 	struct mpp_request *req;
 	struct mpp_hw_info *hw_info = task->mpp_task.hw_info;
+	struct jpgdec_pic *pic = &task->pic;
 
+	task->pic_cnt = 1;
 	for (i = 0; i < msgs->req_cnt; i++) {
 		u32 off_s, off_e;
 
@@ -159,37 +210,42 @@ static int jpgdec_extract_task_msg(struct jpgdec_task *task,
 		case MPP_CMD_SET_REG_WRITE: {
 			off_s = hw_info->reg_start * sizeof(u32);
 			off_e = hw_info->reg_end * sizeof(u32);
-			ret = mpp_check_req(req, 0, sizeof(task->reg),
+			ret = mpp_check_req(req, 0, sizeof(pic->reg),
 					    off_s, off_e);
 			if (ret)
 				continue;
-			if (copy_from_user((u8 *)task->reg + req->offset,
+			if ((req->flags & MPP_FLAGS_BATCH_PIC) && pic->w_req_cnt) {
+				pic = jpgdec_next_pic(task);
+				if (IS_ERR(pic))
+					return PTR_ERR(pic);
+			}
+			if (copy_from_user((u8 *)pic->reg + req->offset,
 					   req->data, req->size)) {
 				mpp_err("copy_from_user reg failed\n");
 				return -EIO;
 			}
-			memcpy(&task->w_reqs[task->w_req_cnt++],
+			memcpy(&pic->w_reqs[pic->w_req_cnt++],
 			       req, sizeof(*req));
 		} break;
 		case MPP_CMD_SET_REG_READ: {
 			off_s = hw_info->reg_start * sizeof(u32);
 			off_e = hw_info->reg_end * sizeof(u32);
-			ret = mpp_check_req(req, 0, sizeof(task->reg),
+			ret = mpp_check_req(req, 0, sizeof(pic->reg),
 					    off_s, off_e);
 			if (ret)
 				continue;
-			memcpy(&task->r_reqs[task->r_req_cnt++],
+			memcpy(&pic->r_reqs[pic->r_req_cnt++],
 			       req, sizeof(*req));
 		} break;
 		case MPP_CMD_SET_REG_ADDR_OFFSET: {
-			mpp_extract_reg_offset_info(&task->off_inf, req);
+			mpp_extract_reg_offset_info(&pic->off_inf, req);
 		} break;
 		default:
 			break;
 		}
 	}
-	mpp_debug(DEBUG_TASK_INFO, "w_req_cnt %d, r_req_cnt %d\n",
-		  task->w_req_cnt, task->r_req_cnt);
+	mpp_debug(DEBUG_TASK_INFO, "pictures %d, w_req_cnt %d, r_req_cnt %d\n",
+		  task->pic_cnt, task->pic.w_req_cnt, task->pic.r_req_cnt);
 
 	return 0;
 }
@@ -198,8 +254,10 @@ static void *jpgdec_alloc_task(struct mpp_session *session,
 			       struct mpp_task_msgs *msgs)
 {
 	int ret;
+	u32 i;
 	struct mpp_task *mpp_task = NULL;
 	struct jpgdec_task *task = NULL;
+	struct jpgdec_pic *pic;
 	struct mpp_dev *mpp = session->mpp;
 
 	mpp_debug_enter();
@@ -211,7 +269,7 @@ static void *jpgdec_alloc_task(struct mpp_session *session,
 	mpp_task = &task->mpp_task;
 	mpp_task_init(session, mpp_task);
 	mpp_task->hw_info = mpp->var->hw_info;
-	mpp_task->reg = task->reg;
+	mpp_task->reg = task->pic.reg;
 	/* extract reqs for current task */
 	ret = jpgdec_extract_task_msg(task, msgs);
 	if (ret)
@@ -222,7 +280,10 @@ static void *jpgdec_alloc_task(struct mpp_session *session,
 		if (ret)
 			goto fail;
 	}
-	task->strm_addr = task->reg[JPGDEC_REG_STREAM_RLC_BASE_INDEX];
+	for (i = 0; i < task->pic_cnt; i++) {
+		pic = jpgdec_get_pic(task, i);
+		pic->strm_addr = pic->reg[JPGDEC_REG_STREAM_RLC_BASE_INDEX];
+	}
 	task->clk_mode = CLK_MODE_NORMAL;
 
 	mpp_debug_leave();
@@ -233,6 +294,7 @@ static void *jpgdec_alloc_task(struct mpp_session *session,
 	mpp_task_dump_mem_region(mpp, mpp_task);
 	mpp_task_dump_reg(mpp, mpp_task);
 	mpp_task_finalize(session, mpp_task);
+	kfree(task->batch);
 	kfree(task);
 	return NULL;
 }
@@ -245,10 +307,48 @@ static int jpgdec_soft_reset(struct mpp_dev *mpp)
 	return 0;
 }
 
+static void jpgdec_write_pic(struct mpp_dev *mpp, struct jpgdec_pic *pic,
+			     u32 reg_en)
+{
+	u32 i;
+
+	for (i = 0; i < pic->w_req_cnt; i++) {
+		struct mpp_request *req = &pic->w_reqs[i];
+		int s = req->offset / sizeof(u32);
+		int e = s + req->size / sizeof(u32);
+
+		mpp_write_req(mpp, pic->reg, s, e, reg_en);
+	}
+}
+
+static void jpgdec_read_pic(struct mpp_dev *mpp, struct jpgdec_pic *pic)
+{
+	u32 i, s, e;
+	u32 dec_get;
+	s32 dec_length;
+	struct mpp_request *req;
+
+	/* read register after running */
+	for (i = 0; i < pic->r_req_cnt; i++) {
+		req = &pic->r_reqs[i];
+		s = req->offset / sizeof(u32);
+		e = s + req->size / sizeof(u32);
+		mpp_read_req(mpp, pic->reg, s, e);
+	}
+	/* revert hack for irq status */
+	pic->reg[JPGDEC_REG_INT_EN_INDEX] = pic->irq_status;
+	/* revert hack for decoded length */
+	dec_get = mpp_read_relaxed(mpp, JPGDEC_REG_STREAM_RLC_BASE);
+	dec_length = dec_get - pic->strm_addr;
+	pic->reg[JPGDEC_REG_STREAM_RLC_BASE_INDEX] = dec_length << 10;
+
+	mpp_debug(DEBUG_REGISTER,
+		  "dec_get %08x dec_length %d\n", dec_get, dec_length);
+}
+
 static int jpgdec_run(struct mpp_dev *mpp,
 		      struct mpp_task *mpp_task)
 {
-	u32 i;
 	u32 reg_en;
 	struct jpgdec_task *task = to_jpgdec_task(mpp_task);
 	u32 timing_en = mpp->srv->timing_en;
@@ -257,13 +357,8 @@ static int jpgdec_run(struct mpp_dev *mpp,
 
 	/* set registers for hardware */
 	reg_en = mpp_task->hw_info->reg_en;
-	for (i = 0; i < task->w_req_cnt; i++) {
-		struct mpp_request *req = &task->w_reqs[i];
-		int s = req->offset / sizeof(u32);
-		int e = s + req->size / sizeof(u32);
-
-		mpp_write_req(mpp, task->reg, s, e, reg_en);
-	}
+	task->pic_idx = 0;
+	jpgdec_write_pic(mpp, &task->pic, reg_en);
 	/* flush tlb before starting hardware */
 	mpp_iommu_flush_tlb(mpp->iommu_info);
 
@@ -275,7 +370,7 @@ static int jpgdec_run(struct mpp_dev *mpp,
 	/* Flush the register before the start the device */
 	wmb();
 	mpp_write(mpp, JPGDEC_REG_INT_EN_BASE,
-		  task->reg[reg_en] | JPGDEC_START_EN);
+		  task->pic.reg[reg_en] | JPGDEC_START_EN);
 
 	mpp_task_run_end(mpp_task, timing_en);
 
@@ -287,40 +382,26 @@ static int jpgdec_run(struct mpp_dev *mpp,
 static int jpgdec_finish(struct mpp_dev *mpp,
 			 struct mpp_task *mpp_task)
 {
-	u32 i;
-	u32 s, e;
-	u32 dec_get;
-	s32 dec_length;
-	struct mpp_request *req;
 	struct jpgdec_task *task = to_jpgdec_task(mpp_task);
+	struct jpgdec_pic *pic = jpgdec_get_pic(task, task->pic_idx);
+	u32 i;
 
 	mpp_debug_enter();
 
-	/* read register after running */
-	for (i = 0; i < task->r_req_cnt; i++) {
-		req = &task->r_reqs[i];
-		s = req->offset / sizeof(u32);
-		e = s + req->size / sizeof(u32);
-		mpp_read_req(mpp, task->reg, s, e);
-	}
-	/* revert hack for irq status */
-	task->reg[JPGDEC_REG_INT_EN_INDEX] = task->irq_status;
-	/* revert hack for decoded length */
-	dec_get = mpp_read_relaxed(mpp, JPGDEC_REG_STREAM_RLC_BASE);
-	dec_length = dec_get - task->strm_addr;
-	task->reg[JPGDEC_REG_STREAM_RLC_BASE_INDEX] = dec_length << 10;
+	/* the pictures before were read back by the irq starting the next */
+	jpgdec_read_pic(mpp, pic);
+	/* the ones after a failed picture are not decoded */
+	for (i = task->pic_idx + 1; i < task->pic_cnt; i++)
+		jpgdec_get_pic(task, i)->reg[JPGDEC_REG_INT_EN_INDEX] = 0;
 	/*
 	 * If the softrest_rdy bit is low,
 	 * it means that the soft-reset of the previous frame
 	 * has not been completed.We have to manually trigger to do soft-reset.
 	 */
-	if (!(task->irq_status & JPGDEC_SOFT_RSET_READY) &&
+	if (!(pic->irq_status & JPGDEC_SOFT_RSET_READY) &&
 	    !atomic_read(&mpp->reset_request))
 		jpgdec_soft_reset(mpp);
 
-	mpp_debug(DEBUG_REGISTER,
-		  "dec_get %08x dec_length %d\n", dec_get, dec_length);
-
 	mpp_debug_leave();
 
 	return 0;
@@ -330,19 +411,23 @@ static int jpgdec_result(struct mpp_dev *mpp,
 			 struct mpp_task *mpp_task,
 			 struct mpp_task_msgs *msgs)
 {
-	u32 i;
+	u32 i, j;
 	struct mpp_request *req;
+	struct jpgdec_pic *pic;
 	struct jpgdec_task *task = to_jpgdec_task(mpp_task);
 
-	/* FIXME may overflow the kernel */
-	for (i = 0; i < task->r_req_cnt; i++) {
-		req = &task->r_reqs[i];
+	for (j = 0; j < task->pic_cnt; j++) {
+		pic = jpgdec_get_pic(task, j);
+		/* FIXME may overflow the kernel */
+		for (i = 0; i < pic->r_req_cnt; i++) {
+			req = &pic->r_reqs[i];
 
-		if (copy_to_user(req->data,
-				 (u8 *)task->reg + req->offset,
-				 req->size)) {
-			mpp_err("copy_to_user reg fail\n");
-			return -EIO;
+			if (copy_to_user(req->data,
+					 (u8 *)pic->reg + req->offset,
+					 req->size)) {
+				mpp_err("copy_to_user reg fail\n");
+				return -EIO;
+			}
 		}
 	}
 
@@ -355,6 +440,7 @@ static int jpgdec_free_task(struct mpp_session *session,
 	struct jpgdec_task *task = to_jpgdec_task(mpp_task);
 
 	mpp_task_finalize(session, mpp_task);
+	kfree(task->batch);
 	kfree(task);
 
 	return 0;
@@ -386,6 +472,7 @@ static int jpgdec_procfs_init(struct mpp_dev *mpp)
 
 	/* for common mpp_dev options */
 	mpp_procfs_create_common(dec->procfs, mpp);
+	mpp_bench_procfs_init(dec->procfs, mpp);
 
 	mpp_procfs_create_u32("aclk", 0644,
 			      dec->procfs, &dec->aclk_info.debug_rate_hz);
@@ -484,10 +571,55 @@ static int jpgdec_irq(struct mpp_dev *mpp)
 	return IRQ_WAKE_THREAD;
 }
 
+/*
+ * the next picture of a batch is started from the hard irq of the one
+ * before, the threaded isr only runs for the last or a failed picture
+ */
+static irqreturn_t jpgdec_batch_irq(int irq, void *param)
+{
+	struct mpp_dev *mpp = param;
+	struct mpp_task *mpp_task = mpp->cur_task;
+	struct jpgdec_task *task;
+	struct jpgdec_pic *pic;
+	u32 irq_status, reg_en;
+
+	if (!mpp_task)
+		goto out;
+	task = to_jpgdec_task(mpp_task);
+	if (task->pic_idx + 1 >= task->pic_cnt)
+		goto out;
+
+	irq_status = mpp_read(mpp, JPGDEC_REG_INT_EN_BASE);
+	if (!(irq_status & JPGDEC_IRQ_RAW) ||
+	    (irq_status & JPGDEC_ERROR_MASK))
+		goto out;
+	mpp_write(mpp, JPGDEC_REG_INT_EN_BASE, 0);
+
+	pic = jpgdec_get_pic(task, task->pic_idx);
+	pic->irq_status = irq_status;
+	jpgdec_read_pic(mpp, pic);
+	if (!(irq_status & JPGDEC_SOFT_RSET_READY))
+		jpgdec_soft_reset(mpp);
+
+	pic = jpgdec_get_pic(task, ++task->pic_idx);
+	reg_en = mpp_task->hw_info->reg_en;
+	/* all the pictures were mapped and flushed before the first */
+	jpgdec_write_pic(mpp, pic, reg_en);
+	/* Flush the register before the start the device */
+	wmb();
+	mpp_write(mpp, JPGDEC_REG_INT_EN_BASE,
+		  pic->reg[reg_en] | JPGDEC_START_EN);
+
+	return IRQ_HANDLED;
+out:
+	return mpp_dev_irq(irq, param);
+}
+
 static int jpgdec_isr(struct mpp_dev *mpp)
 {
 	int error_mask;
 	struct jpgdec_task *task = NULL;
+	struct jpgdec_pic *pic;
 	struct mpp_task *mpp_task = mpp->cur_task;
 
 	/* FIXME use a spin lock here */
@@ -498,14 +630,14 @@ static int jpgdec_isr(struct mpp_dev *mpp)
 	mpp_time_diff(mpp_task);
 	mpp->cur_task = NULL;
 	task = to_jpgdec_task(mpp_task);
-	task->irq_status = mpp->irq_status;
-	mpp_debug(DEBUG_IRQ_STATUS, "irq_status: %08x\n",
-		  task->irq_status);
+	pic = jpgdec_get_pic(task, task->pic_idx);
+	pic->irq_status = mpp->irq_status;
+	mpp_debug(DEBUG_IRQ_STATUS, "picture %d irq_status: %08x\n",
+		  task->pic_idx, pic->irq_status);
 
-	error_mask = JPGDEC_BUS_STA | JPGDEC_ERROR_STA |
-		     JPGDEC_TIMEOUT_STA | JPGDEC_BUF_EMPTY_STA;
+	error_mask = JPGDEC_ERROR_MASK;
 
-	if (error_mask & task->irq_status)
+	if (error_mask & pic->irq_status)
 		atomic_inc(&mpp->reset_request);
 
 	mpp_task_finish(mpp_task->session, mpp_task);
@@ -601,7 +733,7 @@ static int jpgdec_probe(struct platform_device *pdev)
 	}
 
 	ret = devm_request_threaded_irq(dev, mpp->irq,
-					mpp_dev_irq,
+					jpgdec_batch_irq,
 					mpp_dev_isr_sched,
 					IRQF_SHARED,
 					dev_name(dev), mpp);
@@ -631,6 +631,7 @@ static int rkvdec2_init_session(struct mpp_session *session)
 	priv = kzalloc(sizeof(*priv), GFP_KERNEL);
 	if (!priv)
 		return -ENOMEM;
+	priv->last_core = -1;
 	session->priv = priv;
 
 	return 0;
@@ -656,6 +657,18 @@ static int rkvdec2_show_pref_sel_offset(struct seq_file *file, void *v)
 	return 0;
 }
 
+static int rkvdec2_show_ccu_load(struct seq_file *file, void *v)
+{
+	struct rkvdec2_dev *dec = file->private;
+	u32 util = rkvdec2_ccu_core_util(dec);
+
+	seq_printf(file, "util: %u.%u%%\n", util / 10, util % 10);
+	seq_printf(file, "load: %llu us\n", dec->load_us);
+	seq_printf(file, "tasks: %u\n", dec->task_index);
+
+	return 0;
+}
+
 static int rkvdec2_procfs_init(struct mpp_dev *mpp)
 {
 	struct rkvdec2_dev *dec = to_rkvdec2_dev(mpp);
@@ -676,6 +689,9 @@ static int rkvdec2_procfs_init(struct mpp_dev *mpp)
 
 	/* for common mpp_dev options */
 	mpp_procfs_create_common(dec->procfs, mpp);
+	/* link and ccu mode take the irq in their own handlers */
+	if (!dec->link_dec && !dec->ccu)
+		mpp_bench_procfs_init(dec->procfs, mpp);
 
 	mpp_procfs_create_u32("aclk", 0644,
 			      dec->procfs, &dec->aclk_info.debug_rate_hz);
@@ -691,6 +707,9 @@ static int rkvdec2_procfs_init(struct mpp_dev *mpp)
 			   dec->procfs, rkvdec2_show_pref_sel_offset);
 	mpp_procfs_create_u32("task_count", 0644,
 			      dec->procfs, &mpp->task_index);
+	if (dec->ccu && dec->ccu->ccu_mode == RKVDEC2_CCU_TASK_SOFT)
+		proc_create_single_data("ccu_load", 0444, dec->procfs,
+					rkvdec2_show_ccu_load, dec);
 
 	return 0;
 }
@@ -145,6 +145,9 @@ struct rkvdec2_task {
 	u32 width;
 	u32 height;
 	u32 pixels;
+	/* predicted hw time in us, used by soft ccu dispatch */
+	u32 pred_us;
+	ktime_t on_core;
 
 	/* task index for link table rnunning list */
 	int slot_idx;
@@ -166,6 +169,11 @@ struct rkvdec2_session_priv {
 	} codec_info[DEC_INFO_BUTT];
 	/* rcb_info for sram */
 	struct rkvdec2_rcb_info rcb_inf;
+	/* averaged hw time per frame and per 1k pixels */
+	u32 avg_us;
+	u32 avg_ns_per_kpix;
+	/* last core the session ran on, -1 for none */
+	int last_core;
 };
 
 struct rkvdec2_dev {
@@ -220,6 +228,13 @@ struct rkvdec2_dev {
 	struct rkvdec2_ccu *ccu;
 	u32 core_mask;
 	u32 task_index;
+	/* predicted load of the core, decayed over time */
+	u64 load_us;
+	ktime_t load_stamp;
+	/* measured busy time and utilisation over the last window */
+	u64 busy_us;
+	ktime_t busy_stamp;
+	u32 util;
 	/* mmu info */
 	void __iomem *mmu_base;
 	u32 fault_iova;
@@ -300,6 +300,13 @@ static void rkvdec_link_counter(const char *func, struct rkvdec_link_dev *dev)
 	mpp_err("task write %d read %d send %d recv %d run %d decoded %d total %d\n",
 		dev->task_write, dev->task_read, dev->task_send, dev->task_recv,
 		dev->task_to_run, dev->task_decoded, dev->task_total);
+	mpp_err("queue depth %u refill %u occupancy avg %llu max %u\n",
+		dev->queue_depth, dev->refill_wm,
+		dev->occupancy_cnt ? div_u64(dev->occupancy_sum, dev->occupancy_cnt) : 0,
+		dev->occupancy_max);
+	mpp_err("irq %u coalesced %u task %llu irq per 100 task %llu\n",
+		dev->irq_cnt, dev->irq_coalesced, dev->done_cnt,
+		dev->done_cnt ? div64_u64((u64)dev->irq_cnt * 100, dev->done_cnt) : 0);
 }
 
 int rkvdec_link_dump(struct mpp_dev *mpp)
@@ -716,6 +723,7 @@ static int rkvdec_link_isr_recv_task(struct mpp_dev *mpp,
 		/* Wake up the GET thread */
 		wake_up(&task->wait);
 		kref_put(&mpp_task->ref, rkvdec2_link_free_task);
+		link_dec->done_cnt++;
 	}
 
 	return 0;
@@ -958,6 +966,10 @@ static int rkvdec2_link_alloc_table(struct mpp_dev *mpp,
 
 	link_dec->table	     = table;
 	link_dec->task_size  = task_capacity;
+	/* two slots are kept for the rk356x stuff task */
+	link_dec->queue_depth = task_capacity - 2;
+	link_dec->refill_wm = link_dec->queue_depth - 1;
+	link_dec->irq_coalesce = 1;
 	link_dec->task_count = 0;
 	link_dec->task_write = 0;
 	link_dec->task_read  = link_dec->task_size;
@@ -981,9 +993,16 @@ int rkvdec2_link_procfs_init(struct mpp_dev *mpp)
 
 	link_dec->statistic_count = 0;
 
-	if (dec->procfs)
+	if (dec->procfs) {
 		mpp_procfs_create_u32("statistic_count", 0644,
 				      dec->procfs, &link_dec->statistic_count);
+		mpp_procfs_create_u32("link_queue_depth", 0644,
+				      dec->procfs, &link_dec->queue_depth);
+		mpp_procfs_create_u32("link_refill_wm", 0644,
+				      dec->procfs, &link_dec->refill_wm);
+		mpp_procfs_create_u32("link_irq_coalesce", 0644,
+				      dec->procfs, &link_dec->irq_coalesce);
+	}
 
 	return 0;
 }
@@ -1284,8 +1303,6 @@ static int mpp_task_queue(struct mpp_dev *mpp, struct mpp_task *task)
 {
 	struct rkvdec2_dev *dec = to_rkvdec2_dev(mpp);
 	struct rkvdec_link_dev *link_dec = dec->link_dec;
-	u32 task_to_run = 0;
-	int slot_idx = 0;
 
 	mpp_debug_enter();
 
@@ -1299,31 +1316,82 @@ static int mpp_task_queue(struct mpp_dev *mpp, struct mpp_task *task)
 
 	rkvdec2_link_prepare(mpp, task);
 
-	task_to_run = link_dec->task_to_run;
-	if (!task_to_run) {
+	if (!link_dec->task_to_run)
 		dev_err(link_dec->dev, "nothing to run\n");
-		goto done;
-	}
+
+	mpp_debug_leave();
+
+	return 0;
+}
+
+/* send all tasks written to the link table since last send in one add */
+static void rkvdec2_link_send_batch(struct mpp_dev *mpp)
+{
+	struct rkvdec2_dev *dec = to_rkvdec2_dev(mpp);
+	struct rkvdec_link_dev *link_dec = dec->link_dec;
+	u32 task_to_run = link_dec->task_to_run;
+	int slot_idx;
+
+	if (!task_to_run)
+		return;
 
 	mpp_reset_down_read(mpp->reset_group);
 	link_dec->task_to_run = 0;
 	slot_idx = rkvdec_link_get_task_send(link_dec);
 	link_dec->task_running += task_to_run;
-	rkvdec_link_send_task_to_hw(link_dec, task, slot_idx, task_to_run, 0);
+	rkvdec_link_send_task_to_hw(link_dec, link_dec->tasks_hw[slot_idx],
+				    slot_idx, task_to_run, 0);
 
-done:
-	mpp_debug_leave();
+	link_dec->occupancy_sum += link_dec->task_running;
+	link_dec->occupancy_cnt++;
+	link_dec->occupancy_max = max(link_dec->occupancy_max,
+				      link_dec->task_running);
+}
 
-	return 0;
+static u32 rkvdec2_link_queue_depth(struct rkvdec_link_dev *link_dec)
+{
+	return clamp_t(u32, link_dec->queue_depth, 1, link_dec->task_capacity - 2);
+}
+
+/*
+ * Let the worker sleep until irq_coalesce tasks are done, as long as the
+ * hardware is still busy on the rest of the queue. The last task of the
+ * queue and any error always wake it up.
+ */
+static bool rkvdec2_link_irq_coalesce(struct rkvdec_link_dev *link_dec)
+{
+	void __iomem *reg_base = link_dec->reg_base;
+	struct rkvdec_link_status *status = &link_dec->info->reg_status;
+	u32 decoded, total;
+
+	if (link_dec->irq_coalesce <= 1)
+		return false;
+
+	if (!readl(reg_base + RKVDEC_LINK_EN_BASE) ||
+	    (readl(reg_base + status->err_flag_base) & status->err_flag_bit))
+		return false;
+
+	decoded = readl(reg_base + RKVDEC_LINK_DEC_NUM_BASE) & status->dec_num_mask;
+	total = readl(reg_base + RKVDEC_LINK_TOTAL_NUM_BASE);
+	if (decoded >= total)
+		return false;
+
+	return (decoded - link_dec->task_decoded) < link_dec->irq_coalesce;
 }
 
 irqreturn_t rkvdec2_link_irq_proc(int irq, void *param)
 {
 	struct mpp_dev *mpp = param;
+	struct rkvdec_link_dev *link_dec = to_rkvdec2_dev(mpp)->link_dec;
 	int ret = rkvdec2_link_irq(mpp);
 
-	if (!ret)
-		rkvdec2_link_trigger_irq(mpp);
+	if (!ret) {
+		link_dec->irq_cnt++;
+		if (rkvdec2_link_irq_coalesce(link_dec))
+			link_dec->irq_coalesced++;
+		else
+			rkvdec2_link_trigger_irq(mpp);
+	}
 
 	return IRQ_HANDLED;
 }
@@ -1455,6 +1523,7 @@ void rkvdec2_link_worker(struct kthread_work *work_s)
 	struct rkvdec_link_dev *link_dec = dec->link_dec;
 	struct mpp_task *task;
 	struct mpp_taskqueue *queue = mpp->queue;
+	bool refill = false;
 
 	mpp_debug_enter();
 
@@ -1502,9 +1571,17 @@ void rkvdec2_link_worker(struct kthread_work *work_s)
 	}
 
 	/*
-	 * if target device can accept more task send the task to run.
+	 * refill once the hardware queue drains to the watermark, then fill
+	 * it up to the queue depth and send the whole batch in one add.
 	 */
-	if (link_dec->task_running >= link_dec->task_capacity - 2)
+	if (!refill) {
+		if (link_dec->task_running &&
+		    link_dec->task_running > link_dec->refill_wm)
+			goto done;
+		refill = true;
+	}
+	if (link_dec->task_running + link_dec->task_to_run >=
+	    rkvdec2_link_queue_depth(link_dec))
 		goto done;
 
 	if (mpp_task_queue(mpp, task)) {
@@ -1519,6 +1596,7 @@ void rkvdec2_link_worker(struct kthread_work *work_s)
 		goto again;
 	}
 done:
+	rkvdec2_link_send_batch(mpp);
 	mpp_debug_leave();
 
 	if (link_dec->task_irq != link_dec->task_irq_prev ||
@@ -1735,6 +1813,112 @@ static int rkvdec2_ccu_power_off(struct mpp_taskqueue *queue,
 	return 0;
 }
 
+/*
+ * Soft ccu dispatch keeps a predicted load per core: the hw time expected
+ * for each task it took, halved every RKVDEC2_LOAD_HALF_LIFE_MS. The
+ * prediction starts from the frame size and codec and switches to the
+ * session's own measured hw time once it has decoded a frame.
+ */
+#define RKVDEC2_LOAD_HALF_LIFE_MS	(100)
+#define RKVDEC2_UTIL_WINDOW_US		(1000 * USEC_PER_MSEC)
+/* keep a session on its last core unless that is this much more loaded */
+#define RKVDEC2_AFFINITY_SLACK_US	(2000)
+#define RKVDEC2_DEFAULT_KPIX		((1920 * 1088) >> 10)
+
+/* rough hw time per 1k pixels at nominal clock */
+static const u32 rkvdec2_fmt_ns_per_kpix[] = {
+	[RKVDEC_FMT_H265D]	= 1000,
+	[RKVDEC_FMT_H264D]	= 1300,
+	[RKVDEC_FMT_VP9D]	= 1000,
+	[RKVDEC_FMT_AVS2]	= 1300,
+};
+
+static u32 rkvdec2_ccu_predict_cost(struct mpp_task *mpp_task)
+{
+	struct rkvdec2_task *task = to_rkvdec2_task(mpp_task);
+	struct rkvdec2_session_priv *priv = mpp_task->session->priv;
+	u32 kpix = task->pixels >> 10;
+	u32 fmt;
+
+	if (priv && priv->avg_ns_per_kpix && kpix)
+		return div_u64((u64)kpix * priv->avg_ns_per_kpix, 1000);
+	if (priv && priv->avg_us)
+		return priv->avg_us;
+
+	fmt = RKVDEC_GET_FORMAT(task->reg[RKVDEC_REG_FORMAT_INDEX]);
+	if (fmt >= ARRAY_SIZE(rkvdec2_fmt_ns_per_kpix))
+		fmt = RKVDEC_FMT_H264D;
+	if (!kpix)
+		kpix = RKVDEC2_DEFAULT_KPIX;
+
+	return div_u64((u64)kpix * rkvdec2_fmt_ns_per_kpix[fmt], 1000);
+}
+
+static u64 rkvdec2_ccu_core_load(struct rkvdec2_dev *dec, ktime_t now)
+{
+	s64 ms = ktime_ms_delta(now, dec->load_stamp);
+	u32 shift;
+
+	if (ms >= RKVDEC2_LOAD_HALF_LIFE_MS * 64) {
+		dec->load_us = 0;
+		dec->load_stamp = now;
+	} else if (ms >= RKVDEC2_LOAD_HALF_LIFE_MS) {
+		shift = (u32)ms / RKVDEC2_LOAD_HALF_LIFE_MS;
+		dec->load_us >>= shift;
+		dec->load_stamp = ktime_add_ms(dec->load_stamp,
+					       shift * RKVDEC2_LOAD_HALF_LIFE_MS);
+	}
+
+	return dec->load_us;
+}
+
+/* utilisation in permille, over the last window or the current one if longer */
+u32 rkvdec2_ccu_core_util(struct rkvdec2_dev *dec)
+{
+	s64 us = ktime_us_delta(ktime_get(), dec->busy_stamp);
+
+	if (us < RKVDEC2_UTIL_WINDOW_US)
+		return dec->util;
+
+	return min_t(u64, div64_u64(dec->busy_us * 1000, us), 1000);
+}
+
+static void rkvdec2_ccu_account(struct rkvdec2_dev *dec,
+				struct mpp_task *mpp_task, bool done)
+{
+	struct rkvdec2_task *task = to_rkvdec2_task(mpp_task);
+	struct rkvdec2_session_priv *priv = mpp_task->session->priv;
+	u32 clk_mhz = dec->cycle_clk->real_rate_hz / 1000000;
+	u32 kpix = task->pixels >> 10;
+	ktime_t now = ktime_get();
+	u32 hw_us, rate;
+	s64 us;
+
+	if (clk_mhz && mpp_task->hw_cycles)
+		hw_us = mpp_task->hw_cycles / clk_mhz;
+	else
+		hw_us = ktime_us_delta(now, task->on_core);
+
+	dec->busy_us += hw_us;
+	us = ktime_us_delta(now, dec->busy_stamp);
+	if (us >= RKVDEC2_UTIL_WINDOW_US) {
+		dec->util = min_t(u64, div64_u64(dec->busy_us * 1000, us), 1000);
+		dec->busy_us = 0;
+		dec->busy_stamp = now;
+	}
+
+	/* a timed out or aborted task says nothing about the stream */
+	if (!done || !priv || !hw_us)
+		return;
+
+	priv->avg_us = priv->avg_us ? (priv->avg_us * 7 + hw_us) / 8 : hw_us;
+	if (kpix) {
+		rate = div_u64((u64)hw_us * 1000, kpix);
+		priv->avg_ns_per_kpix = priv->avg_ns_per_kpix ?
+			(priv->avg_ns_per_kpix * 7 + rate) / 8 : rate;
+	}
+}
+
 static int rkvdec2_soft_ccu_dequeue(struct mpp_taskqueue *queue)
 {
 	struct mpp_task *mpp_task = NULL, *n;
@@ -1779,6 +1963,8 @@ static int rkvdec2_soft_ccu_dequeue(struct mpp_taskqueue *queue)
 
 			set_bit(TASK_STATE_FINISH, &mpp_task->state);
 			set_bit(TASK_STATE_DONE, &mpp_task->state);
+			mpp_task_fence_signal(mpp_task, irq_status ? 0 : -ETIMEDOUT);
+			rkvdec2_ccu_account(dec, mpp_task, irq_status && !timeout_flag);
 
 			set_bit(mpp->core_id, &queue->core_idle);
 			mpp_dbg_core("set core %d idle %lx\n", mpp->core_id, queue->core_idle);
@@ -2032,7 +2218,13 @@ static struct mpp_dev *rkvdec2_get_idle_core(struct mpp_taskqueue *queue,
 					     struct mpp_task *mpp_task)
 {
 	u32 i = 0;
+	struct rkvdec2_task *task = to_rkvdec2_task(mpp_task);
+	struct rkvdec2_session_priv *priv = mpp_task->session->priv;
 	struct rkvdec2_dev *dec = NULL;
+	struct rkvdec2_dev *affine = NULL;
+	ktime_t now = ktime_get();
+	u64 min_load = U64_MAX;
+	u64 load;
 
 	for (i = 0; i < queue->core_count; i++) {
 		struct mpp_dev *mpp = queue->cores[i];
@@ -2042,23 +2234,36 @@ static struct mpp_dev *rkvdec2_get_idle_core(struct mpp_taskqueue *queue,
 			continue;
 
 		if (test_bit(i, &queue->core_idle)) {
-			if (!dec) {
+			load = rkvdec2_ccu_core_load(core, now);
+			if (priv && priv->last_core == mpp->core_id)
+				affine = core;
+			/* set the less loaded core, then the less work one */
+			if (!dec || load < min_load ||
+			    (load == min_load && core->task_index < dec->task_index)) {
 				dec = core;
-				continue;
+				min_load = load;
 			}
-			/* set the less work core */
-			if (core->task_index < dec->task_index)
-				dec = core;
 		}
 	}
+	/* stay on the last core to reuse its caches if it is not much busier */
+	if (affine && affine != dec &&
+	    affine->load_us <= min_load + RKVDEC2_AFFINITY_SLACK_US)
+		dec = affine;
 	/* if get core */
 	if (dec) {
+		task->pred_us = rkvdec2_ccu_predict_cost(mpp_task);
+		task->on_core = now;
+		dec->load_us += task->pred_us;
+		if (priv)
+			priv->last_core = dec->mpp.core_id;
+
 		mpp_task->mpp = &dec->mpp;
 		mpp_task->core_id = dec->mpp.core_id;
 		clear_bit(mpp_task->core_id, &queue->core_idle);
 		dec->task_index++;
 		atomic_inc(&dec->mpp.task_count);
-		mpp_dbg_core("clear core %d idle\n", mpp_task->core_id);
+		mpp_dbg_core("clear core %d idle, pred %u us load %llu us\n",
+			     mpp_task->core_id, task->pred_us, dec->load_us);
 		return mpp_task->mpp;
 	}
 
@@ -2347,6 +2552,7 @@ static int rkvdec2_hard_ccu_dequeue(struct mpp_taskqueue *queue,
 
 			set_bit(TASK_STATE_FINISH, &mpp_task->state);
 			set_bit(TASK_STATE_DONE, &mpp_task->state);
+			mpp_task_fence_signal(mpp_task, irq_status ? 0 : -ETIMEDOUT);
 
 			if (timeout_flag && !dump_reg && mpp_debug_unlikely(DEBUG_DUMP_ERR_REG)) {
 				u32 i;
@@ -2665,6 +2871,7 @@ static void rkvdec2_hard_ccu_handle_pagefault_task(struct rkvdec2_dev *dec,
 	rkvdec2_hard_ccu_finish(dec->link_dec->info, task);
 	set_bit(TASK_STATE_FINISH, &mpp_task->state);
 	set_bit(TASK_STATE_DONE, &mpp_task->state);
+	mpp_task_fence_signal(mpp_task, 0);
 	list_move_tail(&task->table->link, &dec->ccu->unused_list);
 	list_del_init(&mpp_task->queue_link);
 	/* Wake up the GET thread */
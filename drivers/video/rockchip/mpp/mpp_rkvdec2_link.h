@@ -183,6 +183,18 @@ struct rkvdec_link_dev {
 	u32 task_cnt;
 	u64 stuff_cycle_sum;
 	u32 stuff_cnt;
+
+	/* queue tuning from procfs */
+	u32 queue_depth;
+	u32 refill_wm;
+	u32 irq_coalesce;
+	/* queue statistic */
+	u32 irq_cnt;
+	u32 irq_coalesced;
+	u64 done_cnt;
+	u64 occupancy_sum;
+	u32 occupancy_cnt;
+	u32 occupancy_max;
 };
 
 enum RKVDEC2_CCU_MODE {
@@ -239,6 +251,7 @@ int rkvdec2_ccu_iommu_fault_handle(struct iommu_domain *iommu,
 				   unsigned long iova, int status, void *arg);
 irqreturn_t rkvdec2_soft_ccu_irq(int irq, void *param);
 void rkvdec2_soft_ccu_worker(struct kthread_work *work_s);
+u32 rkvdec2_ccu_core_util(struct rkvdec2_dev *dec);
 
 int rkvdec2_ccu_alloc_table(struct rkvdec2_dev *dec,
 			    struct rkvdec_link_dev *link_dec);
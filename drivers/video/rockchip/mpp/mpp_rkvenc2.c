@@ -11,6 +11,7 @@
 #include <linux/delay.h>
 #include <linux/devfreq.h>
 #include <linux/devfreq_cooling.h>
+#include <linux/eventfd.h>
 #include <linux/iopoll.h>
 #include <linux/interrupt.h>
 #include <linux/kernel.h>
@@ -26,11 +27,15 @@
 #include <linux/proc_fs.h>
 #include <linux/pm_runtime.h>
 #include <linux/nospec.h>
+#include <linux/percpu.h>
 #include <linux/workqueue.h>
 #include <linux/dma-iommu.h>
 #include <soc/rockchip/pm_domains.h>
+#include <soc/rockchip/rockchip_dmc.h>
+#include <soc/rockchip/rockchip_dvbm.h>
 #include <soc/rockchip/rockchip_ipa.h>
 #include <soc/rockchip/rockchip_opp_select.h>
+#include <soc/rockchip/rockchip_sram.h>
 #include <soc/rockchip/rockchip_system_monitor.h>
 
 #include "mpp_debug.h"
@@ -175,6 +180,8 @@ union rkvenc2_dual_core_handshake_id {
 #define RKVENC2_BIT_SLI_SPLIT		BIT(0)
 #define RKVENC2_BIT_SLI_FLUSH		BIT(15)
 
+/* bitstream length of the finished frame */
+#define RKVENC2_REG_ST_BSL		(0x4000)
 #define RKVENC2_REG_SLICE_NUM_BASE	(0x4034)
 #define RKVENC2_REG_SLICE_LEN_BASE	(0x4038)
 
@@ -195,6 +202,20 @@ struct rkvenc_poll_slice_cfg {
 	union rkvenc2_slice_len_info slice_info[];
 };
 
+/*
+ * MPP_CMD_SET_SLICE_EVENT data
+ * efd: eventfd signalled with the number of new slices on each slice irq
+ * bs_fd: bitstream buffer synced for cpu up to the last slice before the
+ *        signal, -1 if the buffer is uncached or synced by userspace
+ * bs_offset: byte offset of the first slice in bs_fd
+ */
+struct rkvenc_slice_event_cfg {
+	s32 efd;
+	s32 bs_fd;
+	u32 bs_offset;
+	u32 reserved;
+};
+
 struct rkvenc_task {
 	struct mpp_task mpp_task;
 	int fmt;
@@ -227,10 +248,19 @@ struct rkvenc_task {
 	u32 slice_wr_cnt;
 	u32 slice_rd_cnt;
 	DECLARE_KFIFO(slice_info, union rkvenc2_slice_len_info, RKVENC_MAX_SLICE_FIFO_LEN);
+	/* slice done notify for streaming out before the frame is done */
+	struct eventfd_ctx *slice_efd;
+	s32 slice_bs_fd;
+	u32 slice_bs_offset;
+	u32 slice_bs_len;
+	struct mpp_dma_buffer *slice_bs_buf;
 
 	/* jpege bitstream */
 	struct mpp_dma_buffer *bs_buf;
 	u32 offset_bs;
+
+	/* source from isp wrap buffer, start after first slice written */
+	u32 online;
 };
 
 #define RKVENC_MAX_RCB_NUM		(4)
@@ -245,8 +275,49 @@ struct rkvenc2_rcb_info {
 	struct rcb_info_elem elem[RKVENC_MAX_RCB_NUM];
 };
 
+/* moving window of hw cycles per 16x16 block, used to pick core clock */
+#define RKVENC2_DVFS_WIN		(8)
+/* headroom over the window peak, in percent */
+#define RKVENC2_DVFS_MARGIN		(20)
+/* a frame this many times over the window average is a scene change */
+#define RKVENC2_DVFS_JUMP		(2)
+/*
+ * ddr traffic per source pixel in 1/10 byte, declared to the dmc: yuv420
+ * source read, reference read with search overlap and recon write.
+ */
+#define RKVENC2_BW_FACTOR		(50)
+/* MppCodingType of h.265 in ENC_INFO_FORMAT */
+#define RKVENC2_CODING_HEVC		(0x1000004)
+
+struct rkvenc2_dvfs_info {
+	/* lock for window updated from isr of any core */
+	spinlock_t lock;
+	u32 cpm[RKVENC2_DVFS_WIN];
+	u32 idx;
+	u32 cnt;
+	u32 frame_cnt;
+	/* run next frame at full rate */
+	u32 boost;
+	/* core clock this session needs to meet its frame rate */
+	u32 need_mhz;
+};
+
+/*
+ * always on session counters, per cpu so the irq path takes no lock.
+ * hw time is kept as a log2 histogram in us for the p99 estimate.
+ */
+struct rkvenc2_session_stat {
+	u64 frames;
+	u64 bytes;
+	u64 hw_us;
+	u32 timeouts;
+	u32 resets;
+	u32 hw_bucket[RK_LAT_HIST_BUCKETS];
+};
+
 struct rkvenc2_session_priv {
 	struct rw_semaphore rw_sem;
+	struct rkvenc2_session_stat __percpu *stat;
 	/* codec info from user */
 	struct {
 		/* show mode */
@@ -256,6 +327,44 @@ struct rkvenc2_session_priv {
 	} codec_info[ENC_INFO_BUTT];
 	/* rcb_info for sram */
 	struct rkvenc2_rcb_info rcb_inf;
+	/* online mode set by user */
+	u32 online;
+	/* measured hw load for content adaptive dvfs */
+	struct rkvenc2_dvfs_info dvfs;
+	/* ddr bandwidth this session declared, MB/s */
+	u32 bw_mbyte;
+	/* stream declared to the system monitor for opp floors */
+	struct rockchip_video_load video_load;
+	/* register template written with MPP_FLAGS_REG_TEMPLATE */
+	struct {
+		u32 valid;
+		u32 *data;
+		/* written range in register offset */
+		u32 s;
+		u32 e;
+	} tmpl[RKVENC_CLASS_BUTT];
+};
+
+/* isp to encoder online (wrap buffer) handoff state */
+struct rkvenc2_online_info {
+	/* lock for online state updated from isp irq */
+	spinlock_t lock;
+	/* task waiting for the first slice of current frame */
+	struct mpp_task *wait_task;
+	u32 start_val;
+	/* isp frame progress */
+	u32 frame_id;
+	u32 line_cnt;
+	u32 frame_ready;
+	ktime_t sof_time;
+	ktime_t start_time;
+	/* latency counters, unit us */
+	u32 frame_cnt;
+	u32 wait_cnt;
+	u32 sof2start;
+	u32 sof2start_max;
+	u32 enc_time;
+	u32 enc_time_max;
 };
 
 struct rkvenc_dev {
@@ -266,6 +375,12 @@ struct rkvenc_dev {
 	struct mpp_clk_info hclk_info;
 	struct mpp_clk_info core_clk_info;
 	u32 default_max_load;
+	/* content adaptive dvfs, sum of session need in MHz */
+	u32 dvfs_en;
+	atomic_t dvfs_load_mhz;
+	/* sum of session ddr bandwidth declared to the dmc, MB/s */
+	atomic_t bw_mbyte;
+	struct dmcfreq_bw_request bw_req;
 #ifdef CONFIG_ROCKCHIP_MPP_PROC_FS
 	struct proc_dir_entry *procfs;
 #endif
@@ -277,11 +392,19 @@ struct rkvenc_dev {
 	struct list_head core_link;
 
 	/* internal rcb-memory */
+	struct rk_sram_client sram_client;
 	u32 sram_size;
 	u32 sram_used;
 	dma_addr_t sram_iova;
 	u32 sram_enabled;
 	struct page *rcb_page;
+	/* rcb placement of the last task, in bytes */
+	u32 rcb_sram_bytes;
+	u32 rcb_ddr_bytes;
+
+	/* online mode with isp */
+	struct dvbm_port *dvbm_port;
+	struct rkvenc2_online_info online;
 
 #ifdef CONFIG_PM_DEVFREQ
 	struct rockchip_opp_info opp_info;
@@ -678,17 +801,119 @@ static int rkvenc2_extract_rcb_info(struct rkvenc2_rcb_info *rcb_inf,
 	return 0;
 }
 
+static int rkvenc2_update_template(struct rkvenc2_session_priv *priv,
+				   struct rkvenc_task *task,
+				   struct mpp_request *req)
+{
+	u32 j;
+	struct mpp_request wreq;
+	struct rkvenc_hw_info *hw = task->hw_info;
+
+	for (j = 0; j < hw->reg_class; j++) {
+		u32 base_s = hw->reg_msg[j].base_s;
+		u32 base_e = hw->reg_msg[j].base_e;
+		u8 *data;
+
+		if (!req_over_class(req, task, j))
+			continue;
+
+		if (!priv->tmpl[j].data) {
+			priv->tmpl[j].data = kzalloc(base_e - base_s + sizeof(u32),
+						     GFP_KERNEL);
+			if (!priv->tmpl[j].data)
+				return -ENOMEM;
+		}
+		rkvenc_update_req(task, j, req, &wreq);
+		data = (u8 *)priv->tmpl[j].data + (wreq.offset - base_s);
+		if (copy_from_user(data, wreq.data, wreq.size)) {
+			mpp_err("copy_from_user fail, template offset %08x\n",
+				wreq.offset);
+			return -EIO;
+		}
+		if (!priv->tmpl[j].valid) {
+			priv->tmpl[j].s = wreq.offset;
+			priv->tmpl[j].e = wreq.offset + wreq.size;
+			priv->tmpl[j].valid = 1;
+		} else {
+			priv->tmpl[j].s = min(priv->tmpl[j].s, wreq.offset);
+			priv->tmpl[j].e = max(priv->tmpl[j].e, wreq.offset + wreq.size);
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Start the task from the session template so that userspace only sends
+ * the registers changed since the template was written. Fds in the
+ * template are kept untranslated and go through the normal translation
+ * of each task, which holds its own buffer reference.
+ */
+static int rkvenc2_apply_template(struct rkvenc2_session_priv *priv,
+				  struct rkvenc_task *task)
+{
+	u32 j;
+	int ret;
+	struct mpp_request *wreq;
+	struct rkvenc_hw_info *hw = task->hw_info;
+
+	for (j = 0; j < hw->reg_class; j++) {
+		if (!priv->tmpl[j].valid)
+			continue;
+
+		if (task->w_req_cnt >= MPP_MAX_MSG_NUM)
+			return -EINVAL;
+
+		ret = rkvenc_alloc_class_msg(task, j);
+		if (ret)
+			return ret;
+		memcpy(task->reg[j].data, priv->tmpl[j].data, task->reg[j].size);
+		task->reg[j].valid = 1;
+
+		wreq = &task->w_reqs[task->w_req_cnt++];
+		wreq->offset = priv->tmpl[j].s;
+		wreq->size = priv->tmpl[j].e - priv->tmpl[j].s;
+		wreq->data = NULL;
+	}
+
+	return 0;
+}
+
 static int rkvenc_extract_task_msg(struct mpp_session *session,
 				   struct rkvenc_task *task,
 				   struct mpp_task_msgs *msgs)
 {
 	int ret;
 	u32 i, j;
+	bool has_tmpl = false;
 	struct mpp_request *req;
 	struct rkvenc_hw_info *hw = task->hw_info;
+	struct rkvenc2_session_priv *priv = session->priv;
 
 	mpp_debug_enter();
 
+	if (priv) {
+		ret = 0;
+		down_write(&priv->rw_sem);
+		for (i = 0; i < msgs->req_cnt; i++) {
+			req = &msgs->reqs[i];
+			if (!req->size || req->cmd != MPP_CMD_SET_REG_WRITE ||
+			    !(req->flags & MPP_FLAGS_REG_TEMPLATE))
+				continue;
+			ret = rkvenc2_update_template(priv, task, req);
+			if (ret)
+				break;
+		}
+		if (!ret)
+			ret = rkvenc2_apply_template(priv, task);
+		up_write(&priv->rw_sem);
+		if (ret) {
+			mpp_err("apply register template failed %d\n", ret);
+			goto fail;
+		}
+		has_tmpl = true;
+	}
+
 	for (i = 0; i < msgs->req_cnt; i++) {
 		req = &msgs->reqs[i];
 		if (!req->size)
@@ -699,10 +924,19 @@ static int rkvenc_extract_task_msg(struct mpp_session *session,
 			void *data;
 			struct mpp_request *wreq;
 
+			/* already copied with the template */
+			if (has_tmpl && (req->flags & MPP_FLAGS_REG_TEMPLATE))
+				break;
+
 			for (j = 0; j < hw->reg_class; j++) {
 				if (!req_over_class(req, task, j))
 					continue;
 
+				if (task->w_req_cnt >= MPP_MAX_MSG_NUM) {
+					mpp_err("too many reg write msg\n");
+					ret = -EINVAL;
+					goto fail;
+				}
 				ret = rkvenc_alloc_class_msg(task, j);
 				if (ret) {
 					mpp_err("alloc class msg %d fail.\n", j);
@@ -752,6 +986,31 @@ static int rkvenc_extract_task_msg(struct mpp_session *session,
 			if (priv)
 				rkvenc2_extract_rcb_info(&priv->rcb_inf, req);
 		} break;
+		case MPP_CMD_SET_SLICE_EVENT: {
+			struct rkvenc_slice_event_cfg cfg;
+			struct eventfd_ctx *efd;
+
+			if (req->size < sizeof(cfg)) {
+				ret = -EINVAL;
+				goto fail;
+			}
+			if (copy_from_user(&cfg, req->data, sizeof(cfg))) {
+				mpp_err("copy_from_user fail, slice event\n");
+				ret = -EIO;
+				goto fail;
+			}
+			efd = eventfd_ctx_fdget(cfg.efd);
+			if (IS_ERR(efd)) {
+				mpp_err("invalid slice eventfd %d\n", cfg.efd);
+				ret = PTR_ERR(efd);
+				goto fail;
+			}
+			if (task->slice_efd)
+				eventfd_ctx_put(task->slice_efd);
+			task->slice_efd = efd;
+			task->slice_bs_fd = cfg.bs_fd;
+			task->slice_bs_offset = cfg.bs_offset;
+		} break;
 		default:
 			break;
 		}
@@ -792,29 +1051,54 @@ static int rkvenc_task_get_format(struct mpp_dev *mpp,
 	return 0;
 }
 
+/*
+ * The rcb iova is sram followed by ddr pages when sram is short. Place
+ * the larger buffers first and only where they fit whole, so the sram
+ * takes as many bytes as possible and no buffer straddles into ddr.
+ * Buffers that do not fit the rcb iova keep the address from user.
+ */
 static int rkvenc2_set_rcbbuf(struct mpp_dev *mpp, struct mpp_session *session,
 			      struct rkvenc_task *task)
 {
 	struct rkvenc_dev *enc = to_rkvenc_dev(mpp);
 	struct rkvenc2_session_priv *priv = session->priv;
 	u32 sram_enabled = 0;
+	u32 sram_bytes = 0, ddr_bytes = 0;
 
 	mpp_debug_enter();
 
 	if (priv && enc->sram_iova) {
-		int i;
+		int i, j;
 		u32 *reg;
 		u32 reg_idx, rcb_size, rcb_offset;
+		u32 sram_offset = 0, ddr_offset = enc->sram_size;
 		struct rkvenc2_rcb_info *rcb_inf = &priv->rcb_inf;
+		int order[RKVENC_MAX_RCB_NUM];
 
-		rcb_offset = 0;
 		for (i = 0; i < rcb_inf->cnt; i++) {
-			reg_idx = rcb_inf->elem[i].index;
-			rcb_size = rcb_inf->elem[i].size;
+			for (j = i; j > 0; j--) {
+				if (rcb_inf->elem[order[j - 1]].size >= rcb_inf->elem[i].size)
+					break;
+				order[j] = order[j - 1];
+			}
+			order[j] = i;
+		}
 
-			if (rcb_offset > enc->sram_size ||
-			    (rcb_offset + rcb_size) > enc->sram_used)
+		for (i = 0; i < rcb_inf->cnt; i++) {
+			reg_idx = rcb_inf->elem[order[i]].index;
+			rcb_size = rcb_inf->elem[order[i]].size;
+
+			if (sram_offset + rcb_size <= enc->sram_size) {
+				rcb_offset = sram_offset;
+				sram_offset += rcb_size;
+				sram_bytes += rcb_size;
+			} else if (ddr_offset + rcb_size <= enc->sram_used) {
+				rcb_offset = ddr_offset;
+				ddr_offset += rcb_size;
+				ddr_bytes += rcb_size;
+			} else {
 				continue;
+			}
 
 			mpp_debug(DEBUG_SRAM_INFO, "rcb: reg %d offset %d, size %d\n",
 				  reg_idx, rcb_offset, rcb_size);
@@ -823,7 +1107,6 @@ static int rkvenc2_set_rcbbuf(struct mpp_dev *mpp, struct mpp_session *session,
 			if (reg)
 				*reg = enc->sram_iova + rcb_offset;
 
-			rcb_offset += rcb_size;
 			sram_enabled = 1;
 		}
 	}
@@ -831,6 +1114,8 @@ static int rkvenc2_set_rcbbuf(struct mpp_dev *mpp, struct mpp_session *session,
 		mpp_debug(DEBUG_SRAM_INFO, "sram %s\n", sram_enabled ? "enabled" : "disabled");
 		enc->sram_enabled = sram_enabled;
 	}
+	enc->rcb_sram_bytes = sram_bytes;
+	enc->rcb_ddr_bytes = ddr_bytes;
 
 	mpp_debug_leave();
 
@@ -905,6 +1190,7 @@ static void *rkvenc_alloc_task(struct mpp_session *session,
 	mpp_task_init(session, mpp_task);
 	mpp_task->hw_info = mpp->var->hw_info;
 	task->hw_info = to_rkvenc_info(mpp_task->hw_info);
+	task->slice_bs_fd = -1;
 	/* extract reqs for current task */
 	ret = rkvenc_extract_task_msg(session, task, msgs);
 	if (ret)
@@ -962,9 +1248,17 @@ static void *rkvenc_alloc_task(struct mpp_session *session,
 				mpp_dma_buf_sync(bs_buf, 0, task->offset_bs, DMA_TO_DEVICE, false);
 			task->bs_buf = bs_buf;
 		}
+		if (task->slice_efd && task->slice_bs_fd >= 0)
+			task->slice_bs_buf = mpp_dma_find_buffer_fd(session->dma,
+								    task->slice_bs_fd);
 	}
 	rkvenc2_setup_task_id(session->index, task);
 	task->clk_mode = CLK_MODE_NORMAL;
+	if (session->priv) {
+		struct rkvenc2_session_priv *priv = session->priv;
+
+		task->online = (priv->online && to_rkvenc_dev(mpp)->dvbm_port) ? 1 : 0;
+	}
 	rkvenc2_check_split_task(task);
 
 	mpp_debug_leave();
@@ -978,6 +1272,8 @@ static void *rkvenc_alloc_task(struct mpp_session *session,
 	/* free class register buffer */
 	rkvenc_free_class_msg(task);
 free_task:
+	if (task->slice_efd)
+		eventfd_ctx_put(task->slice_efd);
 	kfree(task);
 
 	return NULL;
@@ -1178,6 +1474,163 @@ static void rkvenc2_update_dchs(struct rkvenc_dev *enc, struct rkvenc_task *task
 	spin_unlock_irqrestore(&ccu->lock_dchs, flags);
 }
 
+static void rkvenc2_online_start(struct rkvenc_dev *enc, u32 start_val)
+{
+	struct rkvenc2_online_info *online = &enc->online;
+	ktime_t now = ktime_get();
+	u32 delay = ktime_us_delta(now, online->sof_time);
+
+	online->frame_ready = 0;
+	online->start_time = now;
+	online->sof2start = delay;
+	if (delay > online->sof2start_max)
+		online->sof2start_max = delay;
+
+	mpp_write(&enc->mpp, enc->hw_info->enc_start_base, start_val);
+}
+
+/*
+ * In online mode the source is the isp wrap buffer. Start the encoder as
+ * soon as the first slice of the frame is written, otherwise keep the task
+ * and let the isp line event start it.
+ */
+static void rkvenc2_online_run(struct rkvenc_dev *enc, struct mpp_task *mpp_task,
+			       u32 start_val)
+{
+	struct rkvenc2_online_info *online = &enc->online;
+	unsigned long flags;
+
+	spin_lock_irqsave(&online->lock, flags);
+	if (online->frame_ready) {
+		rkvenc2_online_start(enc, start_val);
+	} else {
+		online->wait_task = mpp_task;
+		online->start_val = start_val;
+		online->wait_cnt++;
+		mpp_dbg_slice("task %d wait isp frame %d line %d\n",
+			      mpp_task->task_id, online->frame_id, online->line_cnt);
+	}
+	spin_unlock_irqrestore(&online->lock, flags);
+}
+
+static void rkvenc2_online_done(struct rkvenc_dev *enc)
+{
+	struct rkvenc2_online_info *online = &enc->online;
+	unsigned long flags;
+	u32 enc_time;
+
+	spin_lock_irqsave(&online->lock, flags);
+	enc_time = ktime_us_delta(ktime_get(), online->start_time);
+	online->enc_time = enc_time;
+	if (enc_time > online->enc_time_max)
+		online->enc_time_max = enc_time;
+	spin_unlock_irqrestore(&online->lock, flags);
+}
+
+static void rkvenc2_online_reset(struct rkvenc_dev *enc)
+{
+	unsigned long flags;
+
+	if (!enc->dvbm_port)
+		return;
+
+	spin_lock_irqsave(&enc->online.lock, flags);
+	enc->online.wait_task = NULL;
+	enc->online.frame_ready = 0;
+	spin_unlock_irqrestore(&enc->online.lock, flags);
+}
+
+static int rkvenc2_dvbm_cb(void *ctx, enum dvbm_cb_event event, void *arg)
+{
+	struct rkvenc_dev *enc = ctx;
+	struct rkvenc2_online_info *online = &enc->online;
+	unsigned long flags;
+
+	spin_lock_irqsave(&online->lock, flags);
+	switch (event) {
+	case DVBM_VEPU_NOTIFY_FRM_STR: {
+		online->line_cnt = 0;
+		online->frame_ready = 0;
+		online->sof_time = ktime_get();
+		online->frame_cnt++;
+	} break;
+	case DVBM_VEPU_NOTIFY_FRM_LINE: {
+		struct dvbm_isp_frm_info *info = arg;
+
+		if (info) {
+			online->frame_id = info->frame_cnt;
+			online->line_cnt = info->line_cnt;
+		}
+		online->frame_ready = 1;
+	} break;
+	case DVBM_VEPU_NOTIFY_FRM_END: {
+		/* no line event configured on isp, fallback to frame end */
+		online->frame_ready = 1;
+	} break;
+	default:
+		break;
+	}
+
+	if (online->frame_ready && online->wait_task) {
+		mpp_dbg_slice("task %d start on isp frame %d line %d\n",
+			      online->wait_task->task_id, online->frame_id,
+			      online->line_cnt);
+		online->wait_task = NULL;
+		rkvenc2_online_start(enc, online->start_val);
+	}
+	spin_unlock_irqrestore(&online->lock, flags);
+
+	return 0;
+}
+
+static int rkvenc2_dvbm_init(struct rkvenc_dev *enc)
+{
+	struct device *dev = enc->mpp.dev;
+	struct device_node *np_dvbm;
+	struct platform_device *pdev;
+	struct dvbm_port *port;
+	struct dvbm_cb dvbm_cb;
+
+	spin_lock_init(&enc->online.lock);
+
+	np_dvbm = of_parse_phandle(dev->of_node, "dvbm", 0);
+	if (!np_dvbm)
+		return 0;
+	if (!of_device_is_available(np_dvbm)) {
+		of_node_put(np_dvbm);
+		return 0;
+	}
+
+	pdev = of_find_device_by_node(np_dvbm);
+	of_node_put(np_dvbm);
+	if (!pdev)
+		return -ENODEV;
+
+	port = rk_dvbm_get_port(pdev, DVBM_VEPU_PORT);
+	platform_device_put(pdev);
+	if (IS_ERR_OR_NULL(port)) {
+		dev_warn(dev, "failed to get dvbm port\n");
+		return -ENODEV;
+	}
+
+	dvbm_cb.cb = rkvenc2_dvbm_cb;
+	dvbm_cb.ctx = enc;
+	dvbm_cb.event = DVBM_VEPU_NOTIFY_FRM_LINE;
+	rk_dvbm_set_cb(port, &dvbm_cb);
+	enc->dvbm_port = port;
+	dev_info(dev, "online mode with dvbm\n");
+
+	return 0;
+}
+
+static void rkvenc2_dvbm_deinit(struct rkvenc_dev *enc)
+{
+	if (enc->dvbm_port) {
+		rk_dvbm_put(enc->dvbm_port);
+		enc->dvbm_port = NULL;
+	}
+}
+
 static int rkvenc_run(struct mpp_dev *mpp, struct mpp_task *mpp_task)
 {
 	u32 i, j;
@@ -1239,7 +1692,10 @@ static int rkvenc_run(struct mpp_dev *mpp, struct mpp_task *mpp_task)
 	/* Flush the register before the start the device */
 	wmb();
 
-	mpp_write(mpp, enc->hw_info->enc_start_base, start_val);
+	if (task->online)
+		rkvenc2_online_run(enc, mpp_task, start_val);
+	else
+		mpp_write(mpp, enc->hw_info->enc_start_base, start_val);
 
 	mpp_task_run_end(mpp_task, timing_en);
 
@@ -1254,6 +1710,7 @@ static void rkvenc2_read_slice_len(struct mpp_dev *mpp, struct rkvenc_task *task
 	u32 sli_num = mpp_read_relaxed(mpp, RKVENC2_REG_SLICE_NUM_BASE);
 	union rkvenc2_slice_len_info slice_info;
 	u32 task_id = task->mpp_task.task_id;
+	u32 slice_len = 0;
 	u32 i;
 
 	mpp_dbg_slice("task %d wr %3d len start %s\n", task_id,
@@ -1273,6 +1730,7 @@ static void rkvenc2_read_slice_len(struct mpp_dev *mpp, struct rkvenc_task *task
 
 		kfifo_in(&task->slice_info, &slice_info, 1);
 		task->slice_wr_cnt++;
+		slice_len += slice_info.slice_len;
 	}
 
 	/* Fixup for async between last flag and slice number register */
@@ -1281,7 +1739,24 @@ static void rkvenc2_read_slice_len(struct mpp_dev *mpp, struct rkvenc_task *task
 		slice_info.last = 1;
 		slice_info.slice_len = 0;
 		kfifo_in(&task->slice_info, &slice_info, 1);
+		sli_num++;
+	}
+
+	if (!task->slice_efd || !sli_num)
+		return;
+
+	/* slice bytes must be visible to the cpu before userspace is told */
+	if (task->slice_bs_buf && slice_len) {
+		u32 start = task->slice_bs_offset + task->slice_bs_len;
+		u32 size = task->slice_bs_buf->size;
+
+		if (start < size)
+			mpp_dma_buf_sync(task->slice_bs_buf, start,
+					 min_t(u32, slice_len, size - start),
+					 DMA_FROM_DEVICE, true);
 	}
+	task->slice_bs_len += slice_len;
+	eventfd_signal(task->slice_efd, sli_num);
 }
 
 static int rkvenc_irq(struct mpp_dev *mpp)
@@ -1333,6 +1808,127 @@ static int rkvenc_irq(struct mpp_dev *mpp)
 	return ret;
 }
 
+static u32 rkvenc2_dvfs_mbs(struct rkvenc2_session_priv *priv)
+{
+	u32 w = priv->codec_info[ENC_INFO_WIDTH].val;
+	u32 h = priv->codec_info[ENC_INFO_HEIGHT].val;
+
+	return DIV_ROUND_UP(w, 16) * DIV_ROUND_UP(h, 16);
+}
+
+static void rkvenc2_dvfs_update(struct rkvenc_dev *enc, struct mpp_task *mpp_task)
+{
+	struct mpp_session *session = mpp_task->session;
+	struct rkvenc2_session_priv *priv = session->priv;
+	struct rkvenc2_dvfs_info *dvfs;
+	struct rkvenc_dev *main_enc;
+	u32 rate_mhz = enc->core_clk_info.real_rate_hz / MHZ;
+	u32 mbs, fps, cpm, peak = 0, need;
+	u64 sum = 0, cycles;
+	unsigned long flags;
+	u32 i;
+
+	if (!priv || !session->mpp || !mpp_task->lat_start_ns || !rate_mhz)
+		return;
+	mbs = rkvenc2_dvfs_mbs(priv);
+	if (!mbs)
+		return;
+	fps = priv->codec_info[ENC_INFO_FPS_OUT].val;
+	if (!fps)
+		fps = 30;
+
+	/* hw time at the current rate back to cycles, so rate changes cancel out */
+	cycles = div_u64((ktime_get_boottime_ns() - mpp_task->lat_start_ns) * rate_mhz,
+			 NSEC_PER_USEC);
+	cpm = min_t(u64, div_u64(cycles, mbs), U32_MAX);
+
+	dvfs = &priv->dvfs;
+	spin_lock_irqsave(&dvfs->lock, flags);
+	for (i = 0; i < dvfs->cnt; i++)
+		sum += dvfs->cpm[i];
+	/* a busy frame predicts the next ones are busy too */
+	dvfs->boost = dvfs->cnt && cpm > RKVENC2_DVFS_JUMP * div_u64(sum, dvfs->cnt);
+
+	dvfs->cpm[dvfs->idx] = cpm;
+	dvfs->idx = (dvfs->idx + 1) % RKVENC2_DVFS_WIN;
+	if (dvfs->cnt < RKVENC2_DVFS_WIN)
+		dvfs->cnt++;
+	for (i = 0; i < dvfs->cnt; i++)
+		peak = max(peak, dvfs->cpm[i]);
+
+	need = div_u64((u64)peak * mbs * fps * (100 + RKVENC2_DVFS_MARGIN),
+		       100 * MHZ);
+	main_enc = to_rkvenc_dev(session->mpp);
+	atomic_add((int)need - (int)dvfs->need_mhz, &main_enc->dvfs_load_mhz);
+	dvfs->need_mhz = need;
+	spin_unlock_irqrestore(&dvfs->lock, flags);
+}
+
+/*
+ * declare the session ddr bandwidth and video load from the size and frame
+ * rate userspace sent with the codec info, the dmc and the system monitor
+ * keep rates that cover all streams.
+ */
+static void rkvenc2_bw_update(struct mpp_session *session, bool release)
+{
+	struct rkvenc2_session_priv *priv = session->priv;
+	struct rkvenc_dev *main_enc;
+	u32 w = 0, h = 0, fps, mbyte = 0;
+
+	if (!priv || !session->mpp)
+		return;
+
+	if (!release) {
+		w = priv->codec_info[ENC_INFO_WIDTH].val;
+		h = priv->codec_info[ENC_INFO_HEIGHT].val;
+		fps = priv->codec_info[ENC_INFO_FPS_OUT].val;
+		if (!fps)
+			fps = 30;
+		mbyte = div_u64((u64)w * h * fps * RKVENC2_BW_FACTOR, 10 * 1000000);
+
+		priv->video_load.type = ROCKCHIP_VIDEO_LOAD_ENC;
+		priv->video_load.width = w;
+		priv->video_load.height = h;
+		priv->video_load.fps = fps;
+		priv->video_load.hevc = priv->codec_info[ENC_INFO_FORMAT].val ==
+					RKVENC2_CODING_HEVC;
+	}
+	rockchip_system_monitor_video_load_update(&priv->video_load, w && h);
+
+	main_enc = to_rkvenc_dev(session->mpp);
+	mbyte = atomic_add_return((int)mbyte - (int)xchg(&priv->bw_mbyte, mbyte),
+				  &main_enc->bw_mbyte);
+	rockchip_dmcfreq_bw_request_update(&main_enc->bw_req, mbyte);
+}
+
+static void rkvenc2_stat_update(struct mpp_dev *mpp, struct mpp_task *mpp_task)
+{
+	struct rkvenc_task *task = to_rkvenc_task(mpp_task);
+	struct rkvenc_dev *enc = to_rkvenc_dev(mpp);
+	struct rkvenc2_session_priv *priv = mpp_task->session->priv;
+	u32 us, idx = 0;
+
+	if (!priv || !priv->stat)
+		return;
+
+	if (task->irq_status & enc->hw_info->err_mask) {
+		this_cpu_inc(priv->stat->resets);
+		return;
+	}
+
+	us = 0;
+	if (mpp_task->lat_start_ns)
+		us = min_t(u64, div_u64(ktime_get_boottime_ns() - mpp_task->lat_start_ns,
+					NSEC_PER_USEC), U32_MAX);
+	if (us)
+		idx = min_t(u32, ilog2(us) + 1, RK_LAT_HIST_BUCKETS - 1);
+
+	this_cpu_inc(priv->stat->frames);
+	this_cpu_add(priv->stat->bytes, mpp_read_relaxed(mpp, RKVENC2_REG_ST_BSL));
+	this_cpu_add(priv->stat->hw_us, us);
+	this_cpu_inc(priv->stat->hw_bucket[idx]);
+}
+
 static int rkvenc_isr(struct mpp_dev *mpp)
 {
 	struct rkvenc_task *task;
@@ -1359,11 +1955,17 @@ static int rkvenc_isr(struct mpp_dev *mpp)
 	task = to_rkvenc_task(mpp_task);
 	task->irq_status = mpp->irq_status;
 
+	if (!(task->irq_status & enc->hw_info->err_mask))
+		rkvenc2_dvfs_update(enc, mpp_task);
 	rkvenc2_update_dchs(enc, task);
+	if (task->online)
+		rkvenc2_online_done(enc);
 
 	mpp_debug(DEBUG_IRQ_STATUS, "%s irq_status: %08x\n",
 		  dev_name(mpp->dev), task->irq_status);
 
+	rkvenc2_stat_update(mpp, mpp_task);
+
 	if (task->irq_status & enc->hw_info->err_mask) {
 		atomic_inc(&mpp->reset_request);
 
@@ -1460,6 +2062,8 @@ static int rkvenc_free_task(struct mpp_session *session,
 
 	mpp_task_finalize(session, mpp_task);
 	rkvenc_free_class_msg(task);
+	if (task->slice_efd)
+		eventfd_ctx_put(task->slice_efd);
 	kfree(task);
 
 	return 0;
@@ -1498,6 +2102,25 @@ static int rkvenc_control(struct mpp_session *session, struct mpp_request *req)
 					elem.type, elem.flag);
 			}
 		}
+		rkvenc2_bw_update(session, false);
+	} break;
+	case MPP_CMD_SET_ONLINE_MODE: {
+		struct rkvenc2_session_priv *priv;
+		u32 online;
+
+		if (!session || !session->priv) {
+			mpp_err("session info null\n");
+			return -EINVAL;
+		}
+		priv = session->priv;
+
+		if (get_user(online, (u32 __user *)req->data))
+			return -EFAULT;
+
+		down_write(&priv->rw_sem);
+		priv->online = online;
+		up_write(&priv->rw_sem);
+		mpp_debug(DEBUG_IOCTL, "session %d online %d\n", session->index, online);
 	} break;
 	default: {
 		mpp_err("unknown mpp ioctl cmd %x\n", req->cmd);
@@ -1510,6 +2133,17 @@ static int rkvenc_control(struct mpp_session *session, struct mpp_request *req)
 static int rkvenc_free_session(struct mpp_session *session)
 {
 	if (session && session->priv) {
+		struct rkvenc2_session_priv *priv = session->priv;
+		u32 i;
+
+		if (session->mpp)
+			atomic_sub(priv->dvfs.need_mhz,
+				   &to_rkvenc_dev(session->mpp)->dvfs_load_mhz);
+		rkvenc2_bw_update(session, true);
+
+		for (i = 0; i < RKVENC_CLASS_BUTT; i++)
+			kfree(priv->tmpl[i].data);
+		free_percpu(priv->stat);
 		kfree(session->priv);
 		session->priv = NULL;
 	}
@@ -1530,7 +2164,14 @@ static int rkvenc_init_session(struct mpp_session *session)
 	if (!priv)
 		return -ENOMEM;
 
+	priv->stat = alloc_percpu(struct rkvenc2_session_stat);
+	if (!priv->stat) {
+		kfree(priv);
+		return -ENOMEM;
+	}
+
 	init_rwsem(&priv->rw_sem);
+	spin_lock_init(&priv->dvfs.lock);
 	session->priv = priv;
 
 	return 0;
@@ -1614,6 +2255,101 @@ static int rkvenc_show_session_info(struct seq_file *seq, void *offset)
 	return 0;
 }
 
+static void rkvenc2_dump_session_stat(struct mpp_session *session,
+				      struct seq_file *seq)
+{
+	struct rkvenc2_session_priv *priv = session->priv;
+	struct rkvenc2_session_stat sum, *stat;
+	u32 i, p99 = 0;
+	u64 cnt = 0;
+	int cpu;
+
+	memset(&sum, 0, sizeof(sum));
+	for_each_possible_cpu(cpu) {
+		stat = per_cpu_ptr(priv->stat, cpu);
+		sum.frames += READ_ONCE(stat->frames);
+		sum.bytes += READ_ONCE(stat->bytes);
+		sum.hw_us += READ_ONCE(stat->hw_us);
+		sum.timeouts += READ_ONCE(stat->timeouts);
+		sum.resets += READ_ONCE(stat->resets);
+		for (i = 0; i < RK_LAT_HIST_BUCKETS; i++)
+			sum.hw_bucket[i] += READ_ONCE(stat->hw_bucket[i]);
+	}
+
+	/* upper bound of the bucket holding the 99th percentile */
+	for (i = 0; i < RK_LAT_HIST_BUCKETS; i++) {
+		cnt += sum.hw_bucket[i];
+		if (cnt * 100 >= sum.frames * 99) {
+			p99 = 1U << i;
+			break;
+		}
+	}
+
+	seq_printf(seq, "%d %d %llu %llu %llu %u %u %u\n",
+		   session->pid, session->index, sum.frames, sum.bytes,
+		   sum.frames ? div64_u64(sum.hw_us, sum.frames) : 0,
+		   sum.frames ? p99 : 0, sum.timeouts, sum.resets);
+}
+
+/*
+ * one line per session, cheap to scrape: the counters are summed at
+ * read time and the encode path never waits on this reader.
+ */
+static int rkvenc_show_session_stat(struct seq_file *seq, void *offset)
+{
+	struct mpp_session *session = NULL, *n;
+	struct mpp_dev *mpp = seq->private;
+
+	seq_puts(seq, "pid session frames bytes avg_us p99_us timeouts resets\n");
+	mutex_lock(&mpp->srv->session_lock);
+	list_for_each_entry_safe(session, n,
+				 &mpp->srv->session_list,
+				 service_link) {
+		struct rkvenc2_session_priv *priv = session->priv;
+
+		if (session->device_type != MPP_DEVICE_RKVENC)
+			continue;
+		if (!priv || !priv->stat)
+			continue;
+		rkvenc2_dump_session_stat(session, seq);
+	}
+	mutex_unlock(&mpp->srv->session_lock);
+
+	return 0;
+}
+
+static int rkvenc_show_rcb_info(struct seq_file *seq, void *offset)
+{
+	struct rkvenc_dev *enc = seq->private;
+
+	seq_printf(seq, "%-12s %u\n", "sram_size", enc->sram_size);
+	seq_printf(seq, "%-12s %u\n", "rcb_size", enc->sram_used);
+	seq_printf(seq, "%-12s %u\n", "rcb_sram", enc->rcb_sram_bytes);
+	seq_printf(seq, "%-12s %u\n", "rcb_ddr", enc->rcb_ddr_bytes);
+
+	return 0;
+}
+
+static int rkvenc_show_online_info(struct seq_file *seq, void *offset)
+{
+	struct rkvenc_dev *enc = seq->private;
+	struct rkvenc2_online_info *online = &enc->online;
+	unsigned long flags;
+
+	spin_lock_irqsave(&online->lock, flags);
+	seq_printf(seq, "%-12s %d\n", "frame_cnt", online->frame_cnt);
+	seq_printf(seq, "%-12s %d\n", "wait_cnt", online->wait_cnt);
+	seq_printf(seq, "%-12s %d line %d\n", "isp_frame",
+		   online->frame_id, online->line_cnt);
+	seq_printf(seq, "%-12s %d us max %d us\n", "sof2start",
+		   online->sof2start, online->sof2start_max);
+	seq_printf(seq, "%-12s %d us max %d us\n", "enc_time",
+		   online->enc_time, online->enc_time_max);
+	spin_unlock_irqrestore(&online->lock, flags);
+
+	return 0;
+}
+
 static int rkvenc_procfs_init(struct mpp_dev *mpp)
 {
 	struct rkvenc_dev *enc = to_rkvenc_dev(mpp);
@@ -1635,6 +2371,7 @@ static int rkvenc_procfs_init(struct mpp_dev *mpp)
 
 	/* for common mpp_dev options */
 	mpp_procfs_create_common(enc->procfs, mpp);
+	mpp_bench_procfs_init(enc->procfs, mpp);
 
 	/* for debug */
 	mpp_procfs_create_u32("aclk", 0644,
@@ -1643,9 +2380,19 @@ static int rkvenc_procfs_init(struct mpp_dev *mpp)
 			      enc->procfs, &enc->core_clk_info.debug_rate_hz);
 	mpp_procfs_create_u32("session_buffers", 0644,
 			      enc->procfs, &mpp->session_max_buffers);
+	mpp_procfs_create_u32("dvfs", 0644, enc->procfs, &enc->dvfs_en);
 	/* for show session info */
 	proc_create_single_data("sessions-info", 0444,
 				enc->procfs, rkvenc_show_session_info, mpp);
+	proc_create_single_data("sessions-stat", 0444,
+				enc->procfs, rkvenc_show_session_stat, mpp);
+	if (enc->sram_iova)
+		proc_create_single_data("rcb-info", 0444,
+					enc->procfs, rkvenc_show_rcb_info, enc);
+	/* for online mode latency */
+	if (enc->dvbm_port)
+		proc_create_single_data("online-info", 0444,
+					enc->procfs, rkvenc_show_online_info, enc);
 
 	return 0;
 }
@@ -1793,6 +2540,9 @@ static int rkvenc_init(struct mpp_dev *mpp)
 	of_property_read_u32(mpp->dev->of_node,
 			     "rockchip,default-max-load",
 			     &enc->default_max_load);
+	/* closed loop core clock from measured hw cycles, also set by procfs */
+	enc->dvfs_en = of_property_read_bool(mpp->dev->of_node,
+					     "rockchip,adaptive-dvfs");
 	/* Set default rates */
 	mpp_set_clk_info_rate_hz(&enc->aclk_info, CLK_MODE_DEFAULT, 300 * MHZ);
 	mpp_set_clk_info_rate_hz(&enc->core_clk_info, CLK_MODE_DEFAULT, 600 * MHZ);
@@ -1847,11 +2597,38 @@ static int rkvenc_soft_reset(struct mpp_dev *mpp)
 
 }
 
+static void rkvenc2_reset_state(struct mpp_dev *mpp)
+{
+	struct rkvenc_dev *enc = to_rkvenc_dev(mpp);
+	struct mpp_taskqueue *queue = mpp->queue;
+
+	set_bit(mpp->core_id, &queue->core_idle);
+	if (enc->ccu)
+		enc->ccu->dchs[mpp->core_id].val = 0;
+	rkvenc2_online_reset(enc);
+
+	mpp_dbg_core("core %d reset idle %lx\n", mpp->core_id, queue->core_idle);
+}
+
+/* timeout recovery without cru reset and iommu refresh */
+static int rkvenc2_soft_recover(struct mpp_dev *mpp)
+{
+	int ret;
+
+	ret = rkvenc_soft_reset(mpp);
+	if (ret) {
+		mpp_err("core %d soft reset timeout\n", mpp->core_id);
+		return ret;
+	}
+	rkvenc2_reset_state(mpp);
+
+	return 0;
+}
+
 static int rkvenc_reset(struct mpp_dev *mpp)
 {
 	struct rkvenc_dev *enc = to_rkvenc_dev(mpp);
 	int ret = 0;
-	struct mpp_taskqueue *queue = mpp->queue;
 
 	mpp_debug_enter();
 
@@ -1872,11 +2649,7 @@ static int rkvenc_reset(struct mpp_dev *mpp)
 		mpp_pmu_idle_request(mpp, false);
 	}
 
-	set_bit(mpp->core_id, &queue->core_idle);
-	if (enc->ccu)
-		enc->ccu->dchs[mpp->core_id].val = 0;
-
-	mpp_dbg_core("core %d reset idle %lx\n", mpp->core_id, queue->core_idle);
+	rkvenc2_reset_state(mpp);
 
 	mpp_debug_leave();
 
@@ -1905,13 +2678,68 @@ static int rkvenc_clk_off(struct mpp_dev *mpp)
 	return 0;
 }
 
+/*
+ * Pick the lowest core clock that still encodes every session in time,
+ * from the cycles measured on previous frames. I frames, predicted from
+ * the gop size, and frames after a scene change run at full rate.
+ */
+static int rkvenc2_dvfs_set_rate(struct rkvenc_dev *enc, struct mpp_task *mpp_task)
+{
+	struct mpp_session *session = mpp_task->session;
+	struct rkvenc2_session_priv *priv = session->priv;
+	struct mpp_clk_info *clk_info = &enc->core_clk_info;
+	struct rkvenc_dev *main_enc;
+	unsigned long rate, rate_min, rate_max;
+	u32 core_num, gop, boost;
+	unsigned long flags;
+
+	if (!enc->dvfs_en || !clk_info->clk || clk_info->debug_rate_hz ||
+	    !priv || !session->mpp)
+		return -EINVAL;
+
+	spin_lock_irqsave(&priv->dvfs.lock, flags);
+	gop = priv->codec_info[ENC_INFO_GOP_SIZE].val;
+	boost = priv->dvfs.boost || priv->dvfs.cnt < RKVENC2_DVFS_WIN ||
+		(gop && !(priv->dvfs.frame_cnt % gop));
+	/* no boost while the thermal policy is stepping the stream down */
+	if (READ_ONCE(enc->mpp.cooling_state))
+		boost = 0;
+	priv->dvfs.frame_cnt++;
+	priv->dvfs.boost = 0;
+	spin_unlock_irqrestore(&priv->dvfs.lock, flags);
+
+	main_enc = to_rkvenc_dev(session->mpp);
+	core_num = main_enc->ccu ? main_enc->ccu->core_num : 1;
+	rate_min = mpp_get_clk_info_rate_hz(clk_info, CLK_MODE_REDUCE);
+	rate_max = mpp_get_clk_info_rate_hz(clk_info, boost ?
+					    CLK_MODE_ADVANCED : CLK_MODE_NORMAL);
+	if (boost)
+		rate = rate_max;
+	else
+		rate = clamp_t(unsigned long,
+			       (unsigned long)atomic_read(&main_enc->dvfs_load_mhz) *
+			       MHZ / max_t(u32, core_num, 1), rate_min, rate_max);
+
+	if (rate != clk_info->used_rate_hz) {
+		clk_info->used_rate_hz = rate;
+		clk_set_rate(clk_info->clk, rate);
+		clk_info->real_rate_hz = clk_get_rate(clk_info->clk);
+	}
+
+	return 0;
+}
+
 static int rkvenc_set_freq(struct mpp_dev *mpp, struct mpp_task *mpp_task)
 {
 	struct rkvenc_dev *enc = to_rkvenc_dev(mpp);
 	struct rkvenc_task *task = to_rkvenc_task(mpp_task);
+	enum MPP_CLOCK_MODE clk_mode = task->clk_mode;
 
-	mpp_clk_set_rate(&enc->aclk_info, task->clk_mode);
-	mpp_clk_set_rate(&enc->core_clk_info, task->clk_mode);
+	if (clk_mode == CLK_MODE_ADVANCED && READ_ONCE(mpp->cooling_state))
+		clk_mode = CLK_MODE_NORMAL;
+	mpp_clk_set_rate(&enc->aclk_info, clk_mode);
+	if (rkvenc2_dvfs_set_rate(enc, mpp_task))
+		mpp_clk_set_rate(&enc->core_clk_info, clk_mode);
 
 	return 0;
 }
@@ -1959,6 +2787,13 @@ static void rkvenc2_task_timeout_process(struct mpp_session *session,
 		session->pid, session->index, atomic_read(&session->task_count),
 		task->task_id, kref_read(&task->ref));
 
+	if (session->priv) {
+		struct rkvenc2_session_priv *priv = session->priv;
+
+		if (priv->stat)
+			this_cpu_inc(priv->stat->timeouts);
+	}
+
 	if (task->mpp) {
 		struct mpp_dev *mpp = task->mpp;
 		u32 start = RKVENC2_TIMEOUT_DUMP_REG_START;
@@ -2097,6 +2932,7 @@ static struct mpp_hw_ops rkvenc_hw_ops = {
 	.clk_off = rkvenc_clk_off,
 	.set_freq = rkvenc_set_freq,
 	.reset = rkvenc_reset,
+	.soft_reset = rkvenc2_soft_recover,
 };
 
 static struct mpp_dev_ops rkvenc_dev_ops_v2 = {
@@ -2267,7 +3103,7 @@ static int rkvenc2_alloc_rcbbuf(struct platform_device *pdev, struct rkvenc_dev
 	u32 sram_used, sram_size;
 	struct device_node *sram_np;
 	struct resource sram_res;
-	resource_size_t sram_start, sram_end;
+	resource_size_t sram_start;
 	struct iommu_domain *domain;
 	struct device *dev = &pdev->dev;
 
@@ -2301,22 +3137,30 @@ static int rkvenc2_alloc_rcbbuf(struct platform_device *pdev, struct rkvenc_dev
 		dev_err(dev, "find sram res error\n");
 		return ret;
 	}
-	/* check sram start and size is PAGE_SIZE align */
-	sram_start = round_up(sram_res.start, PAGE_SIZE);
-	sram_end = round_down(sram_res.start + resource_size(&sram_res), PAGE_SIZE);
-	if (sram_end <= sram_start) {
-		dev_err(dev, "no available sram, phy_start %pa, phy_end %pa\n",
-			&sram_start, &sram_end);
-		return -ENOMEM;
+	/*
+	 * the rcb is read and written for every ctu row, it goes first in
+	 * the sram it shares with other blocks. the arbiter page aligns it.
+	 */
+	enc->sram_client.name = dev_name(dev);
+	enc->sram_client.prio = RK_SRAM_PRIO_HIGH;
+	enc->sram_client.want = sram_used;
+	ret = rk_sram_register(&enc->sram_client, &sram_res);
+	if (ret) {
+		dev_err(dev, "no available sram, phy_start %pa\n", &sram_res.start);
+		return ret;
 	}
-	sram_size = sram_end - sram_start;
-	sram_size = sram_used < sram_size ? sram_used : sram_size;
+	rk_sram_request(&enc->sram_client);
+	sram_start = enc->sram_client.phys;
+	sram_size = enc->sram_client.granted;
 	/* iova map to sram */
 	domain = enc->mpp.iommu_info->domain;
-	ret = iommu_map(domain, iova, sram_start, sram_size, IOMMU_READ | IOMMU_WRITE);
-	if (ret) {
-		dev_err(dev, "sram iommu_map error.\n");
-		return ret;
+	if (sram_size) {
+		ret = iommu_map(domain, iova, sram_start, sram_size,
+				IOMMU_READ | IOMMU_WRITE);
+		if (ret) {
+			dev_err(dev, "sram iommu_map error.\n");
+			goto err_sram_put;
+		}
 	}
 	/* alloc dma for the remaining buffer, sram + dma */
 	if (sram_size < sram_used) {
@@ -2352,7 +3196,10 @@ static int rkvenc2_alloc_rcbbuf(struct platform_device *pdev, struct rkvenc_dev
 	return 0;
 
 err_sram_map:
-	iommu_unmap(domain, iova, sram_size);
+	if (sram_size)
+		iommu_unmap(domain, iova, sram_size);
+err_sram_put:
+	rk_sram_unregister(&enc->sram_client);
 
 	return ret;
 }
@@ -2427,8 +3274,10 @@ static int rkvenc_core_probe(struct platform_device *pdev)
 	rkvenc_procfs_ccu_init(mpp);
 
 	/* if current is main-core, register current device to mpp service */
-	if (mpp == enc->ccu->main_core)
+	if (mpp == enc->ccu->main_core) {
+		rockchip_dmcfreq_bw_request_add(&enc->bw_req, dev_name(dev));
 		mpp_dev_register_srv(mpp, mpp->srv);
+	}
 
 	return 0;
 }
@@ -2471,7 +3320,9 @@ static int rkvenc_probe_default(struct platform_device *pdev)
 	}
 	mpp->session_max_buffers = RKVENC_SESSION_MAX_BUFFERS;
 	enc->hw_info = to_rkvenc_info(mpp->var->hw_info);
+	rkvenc2_dvbm_init(enc);
 	rkvenc_procfs_init(mpp);
+	rockchip_dmcfreq_bw_request_add(&enc->bw_req, dev_name(dev));
 	mpp_dev_register_srv(mpp, mpp->srv);
 
 	return 0;
@@ -2515,6 +3366,7 @@ static int rkvenc2_free_rcbbuf(struct platform_device *pdev, struct rkvenc_dev *
 		domain = enc->mpp.iommu_info->domain;
 		iommu_unmap(domain, enc->sram_iova, enc->sram_used);
 	}
+	rk_sram_unregister(&enc->sram_client);
 
 	return 0;
 }
@@ -2537,6 +3389,7 @@ static int rkvenc_remove(struct platform_device *pdev)
 			enc->ccu->core_num--;
 			mutex_unlock(&enc->ccu->lock);
 		}
+		rockchip_dmcfreq_bw_request_remove(&enc->bw_req);
 		rkvenc2_free_rcbbuf(pdev, enc);
 		mpp_dev_remove(&enc->mpp);
 		rkvenc_procfs_remove(&enc->mpp);
@@ -2545,6 +3398,8 @@ static int rkvenc_remove(struct platform_device *pdev)
 		struct rkvenc_dev *enc = to_rkvenc_dev(mpp);
 
 		dev_info(dev, "remove device\n");
+		rkvenc2_dvbm_deinit(enc);
+		rockchip_dmcfreq_bw_request_remove(&enc->bw_req);
 		rkvenc2_free_rcbbuf(pdev, enc);
 		mpp_dev_remove(mpp);
 		rkvenc_procfs_remove(mpp);
@@ -19,6 +19,7 @@
 #include <linux/slab.h>
 #include <linux/nospec.h>
 #include <linux/mfd/syscon.h>
+#include <soc/rockchip/rockchip_performance.h>
 
 #include "mpp_debug.h"
 #include "mpp_common.h"
@@ -228,6 +229,9 @@ static int mpp_dump_session(struct mpp_session *session, struct seq_file *s)
 	seq_printf(s, "session: pid=%d index=%d\n", session->pid, session->index);
 	seq_printf(s, " device: %s\n", dev_name(session->mpp->dev));
 	seq_printf(s, " memory: %lu MiB\n", K(K(t)));
+	seq_printf(s, " sched: prio %u weight %u fps %u\n", session->sched.prio,
+		   session->sched.weight, session->sched.fps);
+	rk_lat_hist_show(s, " wait", &session->wait_hist);
 
 	return 0;
 }
@@ -266,6 +270,7 @@ static int mpp_show_support_cmd(struct seq_file *file, void *v)
 	seq_printf(file, "QUERY_HW_SUPPORT:     0x%08x\n", MPP_CMD_QUERY_HW_SUPPORT);
 	seq_printf(file, "QUERY_HW_ID:          0x%08x\n", MPP_CMD_QUERY_HW_ID);
 	seq_printf(file, "QUERY_CMD_SUPPORT:    0x%08x\n", MPP_CMD_QUERY_CMD_SUPPORT);
+	seq_printf(file, "QUERY_COOLING_STATE:  0x%08x\n", MPP_CMD_QUERY_COOLING_STATE);
 	seq_printf(file, "QUERY_BUTT:           0x%08x\n", MPP_CMD_QUERY_BUTT);
 	seq_puts(file, "----\n");
 	seq_printf(file, "INIT_CLIENT_TYPE:     0x%08x\n", MPP_CMD_INIT_CLIENT_TYPE);
@@ -275,6 +280,9 @@ static int mpp_show_support_cmd(struct seq_file *file, void *v)
 	seq_printf(file, "SET_REG_WRITE:        0x%08x\n", MPP_CMD_SET_REG_WRITE);
 	seq_printf(file, "SET_REG_READ:         0x%08x\n", MPP_CMD_SET_REG_READ);
 	seq_printf(file, "SET_REG_ADDR_OFFSET:  0x%08x\n", MPP_CMD_SET_REG_ADDR_OFFSET);
+	seq_printf(file, "SET_OUT_FENCE:        0x%08x\n", MPP_CMD_SET_OUT_FENCE);
+	seq_printf(file, "SET_SLICE_EVENT:      0x%08x\n", MPP_CMD_SET_SLICE_EVENT);
+	seq_printf(file, "SET_IN_FENCE:         0x%08x\n", MPP_CMD_SET_IN_FENCE);
 	seq_printf(file, "SEND_BUTT:            0x%08x\n", MPP_CMD_SEND_BUTT);
 	seq_puts(file, "----\n");
 	seq_printf(file, "POLL_HW_FINISH:       0x%08x\n", MPP_CMD_POLL_HW_FINISH);
@@ -284,6 +292,7 @@ static int mpp_show_support_cmd(struct seq_file *file, void *v)
 	seq_printf(file, "TRANS_FD_TO_IOVA:     0x%08x\n", MPP_CMD_TRANS_FD_TO_IOVA);
 	seq_printf(file, "RELEASE_FD:           0x%08x\n", MPP_CMD_RELEASE_FD);
 	seq_printf(file, "SEND_CODEC_INFO:      0x%08x\n", MPP_CMD_SEND_CODEC_INFO);
+	seq_printf(file, "SET_SESSION_SCHED:    0x%08x\n", MPP_CMD_SET_SESSION_SCHED);
 	seq_printf(file, "CONTROL_BUTT:         0x%08x\n", MPP_CMD_CONTROL_BUTT);
 
 	return 0;
@@ -356,6 +365,7 @@ static int mpp_service_probe(struct platform_device *pdev)
 	struct mpp_taskqueue *queue;
 	struct device *dev = &pdev->dev;
 	struct device_node *np = dev->of_node;
+	u32 worker_cap = 0;
 
 	dev_info(dev, "%s\n", mpp_version);
 	dev_info(dev, "probe start\n");
@@ -379,6 +389,8 @@ static int mpp_service_probe(struct platform_device *pdev)
 		return -EINVAL;
 	}
 
+	/* capacity units the workers need whatever the performance level */
+	of_property_read_u32(np, "rockchip,worker-capacity", &worker_cap);
 	for (i = 0; i < srv->taskqueue_cnt; i++) {
 		queue = mpp_taskqueue_init(dev);
 		if (!queue)
@@ -387,6 +399,13 @@ static int mpp_service_probe(struct platform_device *pdev)
 		kthread_init_worker(&queue->worker);
 		queue->kworker_task = kthread_run(kthread_worker_fn, &queue->worker,
 						  "queue_work%d", i);
+		/* rt priority and cpu placement follow the performance level */
+		if (!IS_ERR(queue->kworker_task)) {
+			rockchip_perf_register_task(queue->kworker_task);
+			if (worker_cap)
+				rockchip_perf_set_task_capacity(queue->kworker_task,
+								worker_cap);
+		}
 		srv->task_queues[i] = queue;
 	}
 
@@ -459,6 +478,7 @@ static int mpp_service_remove(struct platform_device *pdev)
 		queue = srv->task_queues[i];
 		if (queue && queue->kworker_task) {
 			kthread_flush_worker(&queue->worker);
+			rockchip_perf_unregister_task(queue->kworker_task);
 			kthread_stop(queue->kworker_task);
 			queue->kworker_task = NULL;
 		}
@@ -8,6 +8,7 @@
 #ifndef __LINUX_RGA_DRV_H_
 #define __LINUX_RGA_DRV_H_
 
+#include <linux/cgroup_hwaccel.h>
 #include <linux/clk.h>
 #include <linux/completion.h>
 #include <linux/debugfs.h>
@@ -184,6 +185,9 @@ struct rga_dma_buffer {
 
 	/* The scheduler of the mapping */
 	struct rga_scheduler_t *scheduler;
+
+	/* Owned by the mapping cache, release with rga_mm_cache_unmap() */
+	void *cache_entry;
 };
 
 struct rga_virt_addr {
@@ -297,6 +301,9 @@ struct rga_job {
 	int ret;
 	pid_t pid;
 	bool use_batch_mode;
+	uint64_t predicted_ns;
+	/* hwaccel cgroup of the submitter, charged with the hw time */
+	struct hwaccel_cgroup *hwcg;
 
 	struct kref refcount;
 	unsigned long state;
@@ -343,6 +350,14 @@ struct rga_scheduler_t {
 	int core;
 
 	struct rga_timer timer;
+
+	/* jobs of one batch request run back to back without a re-schedule */
+	uint64_t merge_count;
+	uint64_t merged_jobs;
+
+	/* predicted time of the queued and running jobs, see rga_cost.c */
+	uint64_t cost_pending_ns;
+	uint64_t cost_scale;
 };
 
 struct rga_request {
@@ -21,6 +21,21 @@ enum job_flags {
 	RGA_JOB_UNSUPPORT_RGA_MMU	= 1 << 4,
 };
 
+/*
+ * job may run right behind prev from the same irq, without going through
+ * the todo list again: both come from one batch request of one session
+ * and run on the same core, so their order is kept.
+ */
+static inline bool rga_job_mergeable(struct rga_job *prev, struct rga_job *job)
+{
+	if (!prev || !job->use_batch_mode || !prev->use_batch_mode)
+		return false;
+
+	return prev->session == job->session &&
+	       prev->request_id == job->request_id &&
+	       prev->core == job->core;
+}
+
 void rga_job_scheduler_dump_info(struct rga_scheduler_t *scheduler);
 void rga_job_next(struct rga_scheduler_t *scheduler);
 struct rga_job *rga_job_done(struct rga_scheduler_t *scheduler);
@@ -29,6 +44,16 @@ int rga_job_mpi_commit(struct rga_req *rga_command_base, struct rga_request *req
 
 int rga_job_assign(struct rga_job *job);
 
+uint64_t rga_cost_predict_ns(struct rga_scheduler_t *scheduler, struct rga_job *job);
+struct rga_scheduler_t *rga_cost_pick_scheduler(struct rga_job *job, int core_mask);
+void rga_cost_job_queued(struct rga_scheduler_t *scheduler, struct rga_job *job);
+void rga_cost_job_done(struct rga_scheduler_t *scheduler, struct rga_job *job);
+struct rga_job *rga_cost_next_job(struct rga_scheduler_t *scheduler, u64 *throttle_ns);
+void rga_cost_job_init(struct rga_job *job);
+void rga_cost_job_fini(struct rga_job *job);
+void rga_cost_scheduler_init(struct rga_scheduler_t *scheduler);
+void rga_cost_dump_info(struct seq_file *m, struct rga_scheduler_t *scheduler);
+
 
 int rga_request_check(struct rga_user_request *req);
 struct rga_request *rga_request_lookup(struct rga_pending_request_manager *request_manager,
@@ -61,6 +61,13 @@ int rga_mm_import_buffer(struct rga_external_buffer *external_buffer,
 int rga_mm_release_buffer(uint32_t handle);
 int rga_mm_session_release_buffer(struct rga_session *session);
 
+int rga_mm_cache_map(struct dma_buf *dma_buf, struct rga_scheduler_t *scheduler,
+		     enum dma_data_direction dir, struct rga_dma_buffer *buffer);
+void rga_mm_cache_unmap(struct rga_dma_buffer *buffer);
+void rga_mm_cache_dump_info(struct seq_file *m);
+int rga_mm_cache_init(void);
+void rga_mm_cache_remove(void);
+
 int rga_mm_init(struct rga_mm **session);
 int rga_mm_remove(struct rga_mm **session);
 
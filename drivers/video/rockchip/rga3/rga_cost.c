@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) Rockchip Electronics Co., Ltd.
+ */
+
+#include <linux/clk.h>
+#include <linux/seq_file.h>
+
+#include "rga_job.h"
+#include "rga_common.h"
+
+/* setup, irq and readback of one job */
+#define RGA_COST_JOB_OVERHEAD_NS	20000
+/* fixed point unit of the learned correction */
+#define RGA_COST_SCALE_ONE		1024
+/* fallback when the core clock is unknown */
+#define RGA_COST_DEFAULT_RATE		300000000
+
+static uint64_t rga_img_pixels(const struct rga_img_info_t *img)
+{
+	return (uint64_t)img->act_w * img->act_h;
+}
+
+static unsigned long rga_cost_core_rate(struct rga_scheduler_t *scheduler)
+{
+	unsigned long rate, max_rate = 0;
+	int i;
+
+	for (i = 0; i < scheduler->num_clks; i++) {
+		rate = clk_get_rate(scheduler->clks[i]);
+		if (rate > max_rate)
+			max_rate = rate;
+	}
+
+	return max_rate ? max_rate : RGA_COST_DEFAULT_RATE;
+}
+
+/*
+ * raw cycles of a job on a core: every output or input pixel, whichever
+ * is more, at the pixel rate of the core, weighted by the bytes moved and
+ * by the transforms the core is slow at.
+ */
+static uint64_t rga_cost_cycles(struct rga_scheduler_t *scheduler,
+				struct rga_job *job)
+{
+	struct rga_req *req = &job->rga_command_base;
+	uint64_t src_px = rga_img_pixels(&req->src);
+	uint64_t dst_px = rga_img_pixels(&req->dst);
+	uint64_t cycles = max(src_px, dst_px);
+	int bits;
+
+	/* rga3 moves two pixels per cycle, rga2 one */
+	if (scheduler->core != RGA2_SCHEDULER_CORE0)
+		cycles >>= 1;
+
+	/* memory bound above 32 bpp, e.g. 10 bit or a blend with src1 */
+	bits = max(rga_get_format_bits(req->src.format),
+		   rga_get_format_bits(req->dst.format));
+	if (bits > 32)
+		cycles = cycles * bits / 32;
+	if (req->pat.yrgb_addr && req->pat.act_w)
+		cycles += rga_img_pixels(&req->pat) >> 1;
+
+	/* strong downscale reads lines it throws away */
+	if (req->dst.act_h && req->src.act_h > 2 * req->dst.act_h)
+		cycles += src_px >> 2;
+
+	/* 90/270 rotation breaks the burst pattern on rga2 */
+	if (req->rotate_mode == 1 && req->sina &&
+	    scheduler->core == RGA2_SCHEDULER_CORE0)
+		cycles += cycles >> 1;
+
+	return cycles;
+}
+
+uint64_t rga_cost_predict_ns(struct rga_scheduler_t *scheduler,
+			     struct rga_job *job)
+{
+	uint64_t ns;
+
+	ns = div_u64(rga_cost_cycles(scheduler, job) * NSEC_PER_SEC,
+		     rga_cost_core_rate(scheduler));
+	ns = ns * READ_ONCE(scheduler->cost_scale) / RGA_COST_SCALE_ONE;
+
+	return ns + RGA_COST_JOB_OVERHEAD_NS;
+}
+
+/*
+ * the core with the earliest predicted finish of job, among the cores in
+ * core_mask that can take it.
+ */
+struct rga_scheduler_t *rga_cost_pick_scheduler(struct rga_job *job,
+						int core_mask)
+{
+	struct rga_scheduler_t *scheduler, *best = NULL;
+	uint64_t cost, finish, best_finish = U64_MAX, best_cost = 0;
+	int i;
+
+	for (i = 0; i < rga_drvdata->num_of_scheduler; i++) {
+		scheduler = rga_drvdata->scheduler[i];
+		if (!(scheduler->core & core_mask))
+			continue;
+
+		cost = rga_cost_predict_ns(scheduler, job);
+		finish = READ_ONCE(scheduler->cost_pending_ns) + cost;
+		if (finish < best_finish) {
+			best_finish = finish;
+			best_cost = cost;
+			best = scheduler;
+		}
+	}
+
+	if (best)
+		job->predicted_ns = best_cost;
+
+	return best;
+}
+
+/* both with scheduler->irq_lock held */
+void rga_cost_job_queued(struct rga_scheduler_t *scheduler, struct rga_job *job)
+{
+	scheduler->cost_pending_ns += job->predicted_ns;
+}
+
+void rga_cost_job_done(struct rga_scheduler_t *scheduler, struct rga_job *job)
+{
+	uint64_t actual, scale;
+
+	scheduler->cost_pending_ns -= min(scheduler->cost_pending_ns,
+					  job->predicted_ns);
+
+	if (!job->hw_running_time)
+		return;
+	actual = ktime_to_ns(ktime_sub(ktime_get(), job->hw_running_time));
+	/* a failed job held the core as well */
+	hwaccel_cgroup_charge(job->hwcg, HWACCEL_RGA, actual);
+
+	if (!job->predicted_ns || job->ret)
+		return;
+
+	/* learn how far off the model is on this core, ewma 1/8 */
+	if (actual <= RGA_COST_JOB_OVERHEAD_NS ||
+	    job->predicted_ns <= RGA_COST_JOB_OVERHEAD_NS)
+		return;
+	scale = div64_u64((actual - RGA_COST_JOB_OVERHEAD_NS) * scheduler->cost_scale,
+			  job->predicted_ns - RGA_COST_JOB_OVERHEAD_NS);
+	scale = clamp_t(uint64_t, scale, RGA_COST_SCALE_ONE / 8,
+			RGA_COST_SCALE_ONE * 8);
+	scheduler->cost_scale = (scheduler->cost_scale * 7 + scale) >> 3;
+}
+
+/*
+ * the job rga_job_next() takes off the todo list, scheduler->irq_lock
+ * held. The list is sorted by priority: jobs of cgroups over their hwaccel
+ * quota are passed over, and the cgroup weights decide between the jobs
+ * of the first priority left. throttle_ns is set to when a passed over
+ * job may run, for when no job is left at all.
+ */
+struct rga_job *rga_cost_next_job(struct rga_scheduler_t *scheduler, u64 *throttle_ns)
+{
+	struct rga_job *job, *best = NULL;
+	u64 wait_ns;
+
+	*throttle_ns = 0;
+	list_for_each_entry(job, &scheduler->todo_list, head) {
+		wait_ns = hwaccel_cgroup_throttled(job->hwcg, HWACCEL_RGA);
+		if (wait_ns) {
+			if (!*throttle_ns || wait_ns < *throttle_ns)
+				*throttle_ns = wait_ns;
+			continue;
+		}
+
+		if (!best) {
+			best = job;
+			if (!IS_ENABLED(CONFIG_CGROUP_HWACCEL))
+				break;
+		} else if (job->priority != best->priority) {
+			break;
+		} else if (hwaccel_cgroup_cmp(job->hwcg, best->hwcg, HWACCEL_RGA) < 0) {
+			best = job;
+		}
+	}
+
+	return best;
+}
+
+/* at job alloc and free, in the context of the submitter for the first */
+void rga_cost_job_init(struct rga_job *job)
+{
+	job->hwcg = hwaccel_cgroup_get();
+}
+
+void rga_cost_job_fini(struct rga_job *job)
+{
+	hwaccel_cgroup_put(job->hwcg);
+	job->hwcg = NULL;
+}
+
+void rga_cost_scheduler_init(struct rga_scheduler_t *scheduler)
+{
+	scheduler->cost_pending_ns = 0;
+	scheduler->cost_scale = RGA_COST_SCALE_ONE;
+}
+
+void rga_cost_dump_info(struct seq_file *m, struct rga_scheduler_t *scheduler)
+{
+	seq_printf(m, "\t predicted backlog: %llu us, model scale: %llu/%d\n",
+		   div_u64(READ_ONCE(scheduler->cost_pending_ns), NSEC_PER_USEC),
+		   READ_ONCE(scheduler->cost_scale), RGA_COST_SCALE_ONE);
+}
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) Rockchip Electronics Co., Ltd.
+ *
+ * Persistent iommu mappings of recurring dmabufs. Pipelines cycle a small
+ * buffer pool through the rga, so an fd mode job pays attach, sg map and
+ * iommu map for a buffer it mapped a frame ago. The cache keeps the whole
+ * mapping per (dmabuf, scheduler) across jobs and sessions, and drops it
+ * once the dmabuf is orphaned (only the cache still holds it), on lru
+ * overflow or under memory pressure.
+ */
+
+#define pr_fmt(fmt) "rga_mm_cache: " fmt
+
+#include <linux/shrinker.h>
+
+#include "rga_mm.h"
+#include "rga_dma_buf.h"
+#include "rga_hw_config.h"
+
+#define RGA_MM_CACHE_MAX	32
+
+struct rga_mm_cache_entry {
+	struct list_head node;
+	struct dma_buf *dma_buf;
+	struct rga_scheduler_t *scheduler;
+	struct rga_dma_buffer buffer;
+	int users;
+};
+
+struct rga_mm_cache {
+	struct mutex lock;
+	/* lru, the tail is the most recently used */
+	struct list_head list;
+	int count;
+	struct shrinker shrinker;
+	bool has_shrinker;
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evicted;
+};
+
+static struct rga_mm_cache rga_mm_cache;
+
+static bool rga_mm_cache_orphaned(struct rga_mm_cache_entry *entry)
+{
+	return file_count(entry->dma_buf->file) == 1;
+}
+
+static void rga_mm_cache_evict(struct rga_mm_cache_entry *entry)
+{
+	list_del(&entry->node);
+	rga_mm_cache.count--;
+	rga_mm_cache.evicted++;
+
+	rga_iommu_unmap(&entry->buffer);
+	rga_dma_unmap_buf(&entry->buffer);
+	dma_buf_put(entry->dma_buf);
+	kfree(entry);
+}
+
+/* unused entries, orphaned ones first, then the least recently used */
+static unsigned long rga_mm_cache_reap(unsigned long nr, bool orphans_only)
+{
+	struct rga_mm_cache_entry *entry, *n;
+	unsigned long freed = 0;
+
+	list_for_each_entry_safe(entry, n, &rga_mm_cache.list, node) {
+		if (freed >= nr)
+			return freed;
+		if (!entry->users && rga_mm_cache_orphaned(entry)) {
+			rga_mm_cache_evict(entry);
+			freed++;
+		}
+	}
+
+	if (orphans_only)
+		return freed;
+
+	list_for_each_entry_safe(entry, n, &rga_mm_cache.list, node) {
+		if (freed >= nr)
+			break;
+		if (!entry->users) {
+			rga_mm_cache_evict(entry);
+			freed++;
+		}
+	}
+
+	return freed;
+}
+
+/*
+ * map dma_buf for scheduler through the cache. on success buffer holds the
+ * cached mapping and must be released with rga_mm_cache_unmap(). returns
+ * -EOPNOTSUPP for schedulers without iommu, the caller maps it itself.
+ */
+int rga_mm_cache_map(struct dma_buf *dma_buf, struct rga_scheduler_t *scheduler,
+		     enum dma_data_direction dir, struct rga_dma_buffer *buffer)
+{
+	struct rga_mm_cache_entry *entry;
+	int ret;
+
+	if (scheduler->data->mmu != RGA_IOMMU)
+		return -EOPNOTSUPP;
+
+	mutex_lock(&rga_mm_cache.lock);
+
+	list_for_each_entry(entry, &rga_mm_cache.list, node) {
+		if (entry->dma_buf == dma_buf && entry->scheduler == scheduler &&
+		    (entry->buffer.dir == dir ||
+		     entry->buffer.dir == DMA_BIDIRECTIONAL)) {
+			entry->users++;
+			list_move_tail(&entry->node, &rga_mm_cache.list);
+			rga_mm_cache.hits++;
+			goto found;
+		}
+	}
+
+	rga_mm_cache.misses++;
+	rga_mm_cache_reap(ULONG_MAX, true);
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry) {
+		ret = -ENOMEM;
+		goto err_unlock;
+	}
+
+	ret = rga_dma_map_buf(dma_buf, &entry->buffer, DMA_BIDIRECTIONAL,
+			      scheduler->dev);
+	if (ret < 0)
+		goto err_free_entry;
+
+	if (!entry->buffer.size)
+		entry->buffer.size = dma_buf->size;
+	ret = rga_iommu_map_sgt(entry->buffer.sgt, entry->buffer.size,
+				&entry->buffer, scheduler->dev);
+	if (ret < 0)
+		goto err_unmap_buf;
+
+	entry->buffer.scheduler = scheduler;
+	entry->buffer.dir = DMA_BIDIRECTIONAL;
+	entry->scheduler = scheduler;
+	get_dma_buf(dma_buf);
+	entry->dma_buf = dma_buf;
+	entry->users = 1;
+	list_add_tail(&entry->node, &rga_mm_cache.list);
+	if (++rga_mm_cache.count > RGA_MM_CACHE_MAX)
+		rga_mm_cache_reap(rga_mm_cache.count - RGA_MM_CACHE_MAX, false);
+
+found:
+	*buffer = entry->buffer;
+	buffer->cache_entry = entry;
+	mutex_unlock(&rga_mm_cache.lock);
+
+	return 0;
+
+err_unmap_buf:
+	rga_dma_unmap_buf(&entry->buffer);
+err_free_entry:
+	kfree(entry);
+err_unlock:
+	mutex_unlock(&rga_mm_cache.lock);
+
+	return ret;
+}
+
+void rga_mm_cache_unmap(struct rga_dma_buffer *buffer)
+{
+	struct rga_mm_cache_entry *entry = buffer->cache_entry;
+
+	if (!entry)
+		return;
+
+	mutex_lock(&rga_mm_cache.lock);
+	if (!--entry->users && rga_mm_cache_orphaned(entry))
+		rga_mm_cache_evict(entry);
+	mutex_unlock(&rga_mm_cache.lock);
+
+	buffer->cache_entry = NULL;
+}
+
+static unsigned long rga_mm_cache_count(struct shrinker *shrinker,
+					struct shrink_control *sc)
+{
+	struct rga_mm_cache_entry *entry;
+	unsigned long count = 0;
+
+	if (!mutex_trylock(&rga_mm_cache.lock))
+		return 0;
+	list_for_each_entry(entry, &rga_mm_cache.list, node)
+		if (!entry->users)
+			count++;
+	mutex_unlock(&rga_mm_cache.lock);
+
+	return count ? count : SHRINK_EMPTY;
+}
+
+static unsigned long rga_mm_cache_scan(struct shrinker *shrinker,
+				       struct shrink_control *sc)
+{
+	unsigned long freed;
+
+	/* the map path allocates with the lock held */
+	if (!mutex_trylock(&rga_mm_cache.lock))
+		return SHRINK_STOP;
+	freed = rga_mm_cache_reap(sc->nr_to_scan, false);
+	mutex_unlock(&rga_mm_cache.lock);
+
+	return freed;
+}
+
+void rga_mm_cache_dump_info(struct seq_file *m)
+{
+	mutex_lock(&rga_mm_cache.lock);
+	seq_printf(m, "mapping cache: %d entries, hits: %llu, misses: %llu, evicted: %llu\n",
+		   rga_mm_cache.count, rga_mm_cache.hits, rga_mm_cache.misses,
+		   rga_mm_cache.evicted);
+	mutex_unlock(&rga_mm_cache.lock);
+}
+
+int rga_mm_cache_init(void)
+{
+	mutex_init(&rga_mm_cache.lock);
+	INIT_LIST_HEAD(&rga_mm_cache.list);
+
+	rga_mm_cache.shrinker.count_objects = rga_mm_cache_count;
+	rga_mm_cache.shrinker.scan_objects = rga_mm_cache_scan;
+	rga_mm_cache.shrinker.seeks = 1;
+	rga_mm_cache.has_shrinker = !register_shrinker(&rga_mm_cache.shrinker);
+	if (!rga_mm_cache.has_shrinker)
+		pr_warn("failed to register shrinker\n");
+
+	return 0;
+}
+
+void rga_mm_cache_remove(void)
+{
+	struct rga_mm_cache_entry *entry, *n;
+
+	if (rga_mm_cache.has_shrinker)
+		unregister_shrinker(&rga_mm_cache.shrinker);
+
+	mutex_lock(&rga_mm_cache.lock);
+	list_for_each_entry_safe(entry, n, &rga_mm_cache.list, node) {
+		WARN_ON(entry->users);
+		rga_mm_cache_evict(entry);
+	}
+	mutex_unlock(&rga_mm_cache.lock);
+}
@@ -39,6 +39,8 @@
 #include <video/display_timing.h>
 #endif
 
+#include <soc/rockchip/rockchip_direct_show.h>
+
 #include "vehicle_flinger.h"
 #include "../../../gpu/drm/rockchip/rockchip_drm_direct_show.h"
 #include "../drivers/video/rockchip/rga3/include/rga_drv.h"
@@ -47,6 +49,13 @@ static int vehicle_dump_cif;
 static int vehicle_dump_rga;
 static int vehicle_dump_vop;
 static bool nv12_display = true;
+/* cvbs: read one field of the cif frame instead of render then deinterlace */
+static bool field_render = true;
+/*
+ * progressive input without rotation: the vop plane scales the cif buffer
+ * itself, no rga pass, and the flip is queued instead of waited for
+ */
+static bool vop_direct = true;
 
 enum force_value {
 	FORCE_WIDTH = 1920,
@@ -108,6 +117,27 @@ struct queue_buffer {
 	struct graphic_buffer *buffer;
 };
 
+enum flinger_stage {
+	FLINGER_STAGE_WAIT,	/* cif frame done to worker pick up */
+	FLINGER_STAGE_RENDER,	/* rga render, rotation and format */
+	FLINGER_STAGE_DEINTERLACE,
+	FLINGER_STAGE_SCALER,
+	FLINGER_STAGE_SHOW,	/* vop commit or direct show queue */
+	FLINGER_STAGE_TOTAL,	/* cif frame done to show */
+	FLINGER_STAGE_MAX,
+};
+
+static const char * const flinger_stage_names[FLINGER_STAGE_MAX] = {
+	"wait", "render", "deinterlace", "scaler", "show", "total",
+};
+
+struct flinger_stage_stat {
+	u64 count;
+	u64 total_us;
+	u32 last_us;
+	u32 max_us;
+};
+
 struct flinger {
 	struct device *dev;
 	struct ion_client *ion_client;
@@ -137,10 +167,69 @@ struct flinger {
 	struct drm_plane *plane;
 	const char *crtc_name;
 	const char *plane_name;
+	/* vop direct path, NULL when every frame goes through rga */
+	struct rockchip_drm_direct_show_sink *sink;
+	struct flinger_stage_stat stats[FLINGER_STAGE_MAX];
 };
 
 static struct flinger *flinger;
 
+static ktime_t rk_flinger_stage_done(struct flinger *flg, int stage,
+				     ktime_t start)
+{
+	struct flinger_stage_stat *stat = &flg->stats[stage];
+	ktime_t now = ktime_get();
+	u32 us = ktime_us_delta(now, start);
+
+	stat->count++;
+	stat->total_us += us;
+	stat->last_us = us;
+	if (us > stat->max_us)
+		stat->max_us = us;
+
+	return now;
+}
+
+static ssize_t flinger_timing_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct flinger *flg = flinger;
+	struct flinger_stage_stat *stat;
+	int i, len = 0;
+
+	if (!flg)
+		return -ENODEV;
+
+	len += scnprintf(buf + len, PAGE_SIZE - len, "path: %s\n",
+			 flg->sink ? "vop direct" : "rga");
+	for (i = 0; i < FLINGER_STAGE_MAX; i++) {
+		stat = &flg->stats[i];
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%-12s count:%llu last:%uus avg:%lluus max:%uus\n",
+				 flinger_stage_names[i], stat->count, stat->last_us,
+				 stat->count ? div64_u64(stat->total_us, stat->count) : 0,
+				 stat->max_us);
+	}
+
+	return len;
+}
+
+static ssize_t flinger_timing_store(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *buf, size_t count)
+{
+	struct flinger *flg = flinger;
+
+	if (!flg)
+		return -ENODEV;
+
+	/* any write resets the summary */
+	memset(flg->stats, 0, sizeof(flg->stats));
+
+	return count;
+}
+static DEVICE_ATTR_RW(flinger_timing);
+
 static int rk_flinger_queue_work(struct flinger *flinger,
 				 struct graphic_buffer *src_buffer);
 
@@ -416,6 +505,9 @@ int vehicle_flinger_init(struct device *dev, struct vehicle_cfg *v_cfg)
 		goto free_dst_alloc;
 	}
 
+	if (device_create_file(dev, &dev_attr_flinger_timing))
+		VEHICLE_DGERR("failed to create flinger_timing\n");
+
 	VEHICLE_INFO("vehicle flinger init ok\n");
 	inited = true;
 
@@ -444,6 +536,10 @@ __maybe_unused int vehicle_flinger_deinit(void)
 	flush_work(&flg->render_work);
 	flush_workqueue(flg->render_workqueue);
 	rk_flinger_destroy_worker(flg);
+	rockchip_drm_direct_show_sink_destroy(flg->sink);
+	flg->sink = NULL;
+	if (flg->dev)
+		device_remove_file(flg->dev, &dev_attr_flinger_timing);
 
 	flinger = NULL;
 	for (i = 0; i < NUM_SOURCE_BUFFERS; i++)
@@ -1005,6 +1101,41 @@ static int rk_flinger_rga_render(struct flinger *flinger,
 	return 0;
 }
 
+/*
+ * Render only the top field of an interlaced cif frame. Doubling the
+ * source stride and halving its height makes rga skip the bottom field
+ * lines, and the uv plane offset stride * height stays the same. This
+ * replaces the full frame render plus the half height deinterlace pass.
+ */
+static int rk_flinger_rga_render_field(struct flinger *flinger,
+				       struct graphic_buffer *src_buffer,
+				       struct graphic_buffer *dst_buffer)
+{
+	struct rect src_rect, dst_rect;
+	int ret;
+
+	if (!flinger || !src_buffer || !dst_buffer)
+		return -EINVAL;
+
+	src_rect = src_buffer->src;
+	dst_rect = src_buffer->dst;
+
+	src_buffer->src.h /= 2;
+	src_buffer->src.s *= 2;
+	if (src_buffer->rotation == RGA_TRANSFORM_ROT_90 ||
+	    src_buffer->rotation == RGA_TRANSFORM_ROT_270)
+		src_buffer->dst.w /= 2;
+	else
+		src_buffer->dst.h /= 2;
+
+	ret = rk_flinger_rga_render(flinger, src_buffer, dst_buffer);
+
+	src_buffer->src = src_rect;
+	src_buffer->dst = dst_rect;
+
+	return ret;
+}
+
 static void rk_drm_vehicle_commit(struct flinger *flinger, struct graphic_buffer *buffer)
 {
 	struct rockchip_drm_direct_show_commit_info commit_info;
@@ -1141,6 +1272,88 @@ static int rk_flinger_vop_show(struct flinger *flinger,
 	return 0;
 }
 
+/* called by the sink once the cif buffer is off screen or dropped */
+static void rk_flinger_vop_direct_release(void *data, void *priv)
+{
+	struct graphic_buffer *buffer = priv;
+
+	buffer->state = FREE;
+}
+
+static u32 rk_flinger_vop_direct_rotation(int rotate_mirror)
+{
+	/* the vop can mirror yuv planes in x only and does not rotate */
+	switch (rotate_mirror) {
+	case RGA_TRANSFORM_ROT_0:
+		return DRM_MODE_ROTATE_0;
+	case RGA_TRANSFORM_FLIP_H:
+		return DRM_MODE_ROTATE_0 | DRM_MODE_REFLECT_X;
+	default:
+		return 0;
+	}
+}
+
+static void rk_flinger_vop_direct_open(struct flinger *flg, int hal_format)
+{
+	struct rockchip_drm_direct_show_sink_cfg cfg = {
+		.crtc_name = flg->crtc_name,
+		.plane_name = flg->plane_name,
+		.top_zpos = true,
+		.release = rk_flinger_vop_direct_release,
+		.data = flg,
+	};
+	struct rockchip_drm_direct_show_sink *sink;
+
+	/* no cif frames come in while reverse is closed */
+	rockchip_drm_direct_show_sink_destroy(flg->sink);
+	flg->sink = NULL;
+
+	if (!vop_direct ||
+	    flg->v_cfg.input_format == CIF_INPUT_FORMAT_PAL ||
+	    flg->v_cfg.input_format == CIF_INPUT_FORMAT_NTSC)
+		return;
+
+	cfg.rotation = rk_flinger_vop_direct_rotation(flg->v_cfg.rotate_mirror);
+	if (!cfg.rotation || !rk_flinger_HAL_format_to_DRM(hal_format))
+		return;
+
+	sink = rockchip_drm_direct_show_sink_create(&cfg);
+	if (IS_ERR(sink)) {
+		VEHICLE_INFO("vop direct show unavailable(%ld), use rga\n",
+			     PTR_ERR(sink));
+		return;
+	}
+	flg->sink = sink;
+}
+
+/* hand the cif buffer to the vop, it comes back through the release hook */
+static int rk_flinger_vop_direct_show(struct flinger *flg,
+				      struct graphic_buffer *buffer)
+{
+	struct rockchip_drm_direct_show_frame frame = {
+		.dmabuf = buffer->drm_buffer->rk_gem_obj->base.dma_buf,
+		.width = buffer->src.w,
+		.height = buffer->src.h,
+		.pitch = buffer->src.s,
+		.pixel_format = rk_flinger_HAL_format_to_DRM(buffer->src.f),
+		.priv = buffer,
+	};
+	int ret;
+
+	if (!flg->running || !frame.dmabuf)
+		return -EINVAL;
+
+	buffer->state = DISPLAY;
+	ret = rockchip_drm_direct_show_sink_queue(flg->sink, &frame);
+	if (ret) {
+		buffer->state = ACQUIRE;
+		return ret;
+	}
+	flg->debug_vop_count++;
+
+	return 0;
+}
+
 static void rk_flinger_first_done(struct work_struct *work)
 {
 	struct graphic_buffer *buffer;
@@ -1176,6 +1389,7 @@ static void rk_flinger_render_show(struct work_struct *work)
 	static int count = -1;
 	static int last_src_index = -1;
 	bool cvbs_flag = true;
+	ktime_t stage_start;
 	struct flinger *flg_test =
 			container_of(work, struct flinger, render_work);
 	struct vehicle_cfg *v_cfg = &flg_test->v_cfg;
@@ -1222,6 +1436,8 @@ static void rk_flinger_render_show(struct work_struct *work)
 
 		count++;
 		src_buffer->state = ACQUIRE;
+		stage_start = rk_flinger_stage_done(flg, FLINGER_STAGE_WAIT,
+						    src_buffer->timestamp);
 		/* save rkcif buffer */
 		if (vehicle_dump_cif) {
 			// struct file *filep = NULL;
@@ -1260,6 +1476,14 @@ static void rk_flinger_render_show(struct work_struct *work)
 			}
 		}
 
+		if (flg->sink && !src_buffer->offset &&
+		    !rk_flinger_vop_direct_show(flg, src_buffer)) {
+			rk_flinger_stage_done(flg, FLINGER_STAGE_SHOW, stage_start);
+			rk_flinger_stage_done(flg, FLINGER_STAGE_TOTAL,
+					      src_buffer->timestamp);
+			continue;
+		}
+
 		/*  2. find dst buffer */
 		dst_buffer = NULL;
 		iep_buffer = NULL;
@@ -1298,15 +1522,22 @@ static void rk_flinger_render_show(struct work_struct *work)
 			if (!nv12_display) {
 				rk_flinger_rga_render(flg, src_buffer, iep_buffer);
 				src_buffer->state = FREE;
+				stage_start = rk_flinger_stage_done(flg, FLINGER_STAGE_RENDER,
+								    stage_start);
 				rk_flinger_rga_scaler(flg, iep_buffer, dst_buffer);
 				iep_buffer->state = FREE;
+				stage_start = rk_flinger_stage_done(flg, FLINGER_STAGE_SCALER,
+								    stage_start);
 				rk_flinger_vop_show(flg, dst_buffer);
 			} else {
 				rk_flinger_rga_render(flg, src_buffer, dst_buffer);
 				src_buffer->state = FREE;
+				stage_start = rk_flinger_stage_done(flg, FLINGER_STAGE_RENDER,
+								    stage_start);
 				rk_flinger_vop_show(flg, dst_buffer);
 				// rk_flinger_vop_show(flg, src_buffer);
 			}
+			rk_flinger_stage_done(flg, FLINGER_STAGE_SHOW, stage_start);
 
 			for (i = 0; i < NUM_TARGET_BUFFERS; i++) {
 				buffer = &(flinger->target_buffer[i]);
@@ -1318,12 +1549,26 @@ static void rk_flinger_render_show(struct work_struct *work)
 		} else {
 			// cvbs
 			VEHICLE_DG("it is a cvbs signal\n");
-			rk_flinger_rga_render(flg, src_buffer, dst_buffer);
-			src_buffer->state = FREE;
-			rk_flinger_iep_deinterlace(flg, dst_buffer, iep_buffer);
-			dst_buffer->state = FREE;
+			if (field_render && !src_buffer->offset) {
+				rk_flinger_rga_render_field(flg, src_buffer, iep_buffer);
+				src_buffer->state = FREE;
+				stage_start = rk_flinger_stage_done(flg, FLINGER_STAGE_RENDER,
+								    stage_start);
+			} else {
+				rk_flinger_rga_render(flg, src_buffer, dst_buffer);
+				src_buffer->state = FREE;
+				stage_start = rk_flinger_stage_done(flg, FLINGER_STAGE_RENDER,
+								    stage_start);
+				rk_flinger_iep_deinterlace(flg, dst_buffer, iep_buffer);
+				dst_buffer->state = FREE;
+				stage_start = rk_flinger_stage_done(flg, FLINGER_STAGE_DEINTERLACE,
+								    stage_start);
+			}
 			rk_flinger_rga_scaler(flg, iep_buffer, dst_buffer);
+			stage_start = rk_flinger_stage_done(flg, FLINGER_STAGE_SCALER,
+							    stage_start);
 			rk_flinger_vop_show(flg, dst_buffer);
+			rk_flinger_stage_done(flg, FLINGER_STAGE_SHOW, stage_start);
 			iep_buffer->state = FREE;
 
 			for (i = 0; i < NUM_TARGET_BUFFERS; i++) {
@@ -1333,6 +1578,7 @@ static void rk_flinger_render_show(struct work_struct *work)
 			}
 			dst_buffer->state = DISPLAY;
 		}
+		rk_flinger_stage_done(flg, FLINGER_STAGE_TOTAL, src_buffer->timestamp);
 	} while (1);
 }
 
@@ -1449,6 +1695,7 @@ int vehicle_flinger_reverse_open(struct vehicle_cfg *v_cfg,
 
 	flg->cvbs_field_count = 0;
 	memcpy(&flg->v_cfg, v_cfg, sizeof(struct vehicle_cfg));
+	rk_flinger_vop_direct_open(flg, hal_format);
 	flg->running = true;
 
 	return 0;
@@ -1459,7 +1706,11 @@ int vehicle_flinger_reverse_close(bool android_is_ready)
 	struct flinger *flg = flinger;
 
 	flg->running = false;
-	rockchip_drm_direct_show_disable_plane(flg->drm_dev, flg->plane);
+	/* the render worker may still look at the sink, it goes at deinit */
+	if (flg->sink)
+		rockchip_drm_direct_show_sink_flush(flg->sink);
+	if (flg->plane)
+		rockchip_drm_direct_show_disable_plane(flg->drm_dev, flg->plane);
 	VEHICLE_DG("%s(%d) done\n", __func__, __LINE__);
 
 	return 0;
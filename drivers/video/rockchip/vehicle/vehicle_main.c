@@ -65,6 +65,11 @@ struct vehicle {
 	int state;
 	bool android_is_ready;
 	bool gpio_over;
+	/* leave the preview streaming until the rkcif driver powers on */
+	bool handover;
+	bool handed_over;
+	bool release;
+	struct completion released;
 };
 
 static struct vehicle *g_vehicle;
@@ -86,6 +91,9 @@ static int vehicle_parse_dt(struct vehicle *vehicle_info)
 			dev_err(dev, "get default pinstate failed\n");
 	}
 
+	vehicle_info->handover = of_property_read_bool(dev->of_node,
+						      "rockchip,handover");
+
 	return 0;
 }
 
@@ -348,6 +356,7 @@ static int vehicle_probe(struct platform_device *pdev)
 	vehicle_info->state = STATE_CLOSE;
 	vehicle_info->android_is_ready = false;
 	vehicle_info->gpio_over = false;
+	init_completion(&vehicle_info->released);
 
 	g_vehicle = vehicle_info;
 
@@ -405,6 +414,52 @@ static void vehicle_exit_complete_notify(struct vehicle *v)
 	kfree(status);
 }
 
+static void vehicle_drv_init(void)
+{
+	vehicle_to_v4l2_drv_init();
+	msleep(500);
+	rockchip_csi2_dphy_hw_init();
+	rockchip_csi2_dphy_init();
+	rk_cif_plat_drv_init();
+	// rkcif_csi2_plat_drv_init();
+	rkcif_clr_unready_dev();
+}
+
+/*
+ * called by the rkcif driver at its first power on, the preview has to be
+ * stopped before the cif is reset under it.
+ */
+static void vehicle_handover_release(void *data)
+{
+	struct vehicle *v = data;
+
+	VEHICLE_INFO("rkcif takes over, stop the preview\n");
+	v->release = true;
+	atomic_set(&v->vehicle_atomic, 1);
+	wake_up(&v->vehicle_wait);
+	wait_for_completion(&v->released);
+}
+
+/*
+ * probe the normal drivers while the reverse preview still runs, so the
+ * camera does not go dark for the whole driver init once android is up.
+ */
+static void vehicle_handover(struct vehicle *v)
+{
+	struct rkcif_handover handover = {
+		.release = vehicle_handover_release,
+		.data = v,
+	};
+
+	if (rkcif_handover_register(&handover)) {
+		VEHICLE_DGERR("rkcif handover busy, re-init after close\n");
+		v->handover = false;
+		return;
+	}
+	v->handed_over = true;
+	vehicle_drv_init();
+}
+
 static int rk_vehicle_system_main(void *arg)
 {
 	int ret = -1;
@@ -446,20 +501,30 @@ static int rk_vehicle_system_main(void *arg)
 	pm_runtime_get_sync(v->dev);
 
 	//while (STATE_OPEN == v->state || !v->vehicle_need_exit) {
-	while (v->state == STATE_OPEN || !v->android_is_ready) {
+	while ((v->state == STATE_OPEN || !v->android_is_ready) && !v->release) {
 		if (v->android_is_ready && !v->state)
 			v->gpio_over = true;
+		if (v->android_is_ready && v->state == STATE_OPEN &&
+		    v->handover && !v->handed_over)
+			vehicle_handover(v);
 		wait_event_timeout(v->vehicle_wait,
 				   atomic_read(&v->vehicle_atomic),
 				   msecs_to_jiffies(100));
 		if (atomic_read(&v->vehicle_atomic)) {
 			atomic_set(&v->vehicle_atomic, 0);
-			vehicle_state_change(v);
+			if (!v->release)
+				vehicle_state_change(v);
 		}
 		VEHICLE_DG("loop time(%d) \r\n", loop_times);
 		loop_times++;
 	}
 
+	if (v->state == STATE_OPEN) {
+		vehicle_close();
+		vehicle_ad_stream(&v->ad, 0);
+		v->state = STATE_CLOSE;
+	}
+
 VEHICLE_CIF_DEINIT:
 	vehicle_cif_deinit(&v->cif);
 
@@ -475,13 +540,11 @@ static int rk_vehicle_system_main(void *arg)
 		vehicle_flinger_deinit();
 	// if (v && v->pinctrl)
 	//	pinctrl_put(v->pinctrl);
-	vehicle_to_v4l2_drv_init();
-	msleep(500);
-	rockchip_csi2_dphy_hw_init();
-	rockchip_csi2_dphy_init();
-	rk_cif_plat_drv_init();
-	// rkcif_csi2_plat_drv_init();
-	rkcif_clr_unready_dev();
+	if (v && v->handed_over)
+		/* a late release() finds the preview gone */
+		complete_all(&v->released);
+	else
+		vehicle_drv_init();
 #ifdef CONFIG_GPIO_DET
 	//gpio_det_init();
 #endif
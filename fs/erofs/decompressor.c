@@ -7,6 +7,9 @@
 #include "compress.h"
 #include <linux/module.h>
 #include <linux/lz4.h>
+#ifdef CONFIG_EROFS_FS_ZIP_ROCKCHIP_HW
+#include <linux/soc/rockchip/rockchip_decompress.h>
+#endif
 
 #ifndef LZ4_DISTANCE_MAX	/* history window size */
 #define LZ4_DISTANCE_MAX 65535	/* set to maximum value by default */
@@ -299,6 +302,94 @@ static void copy_from_pcpubuf(struct page **out, const char *dst,
 	}
 }
 
+#ifdef CONFIG_EROFS_FS_ZIP_ROCKCHIP_HW
+/* pclusters smaller than this or compressing worse than the ratio stay on cpu */
+static unsigned int hw_lz4_min_size = 4 * PAGE_SIZE;
+module_param(hw_lz4_min_size, uint, 0644);
+MODULE_PARM_DESC(hw_lz4_min_size, "smallest pcluster in bytes for hw lz4");
+
+static unsigned int hw_lz4_min_ratio = 200;
+module_param(hw_lz4_min_ratio, uint, 0644);
+MODULE_PARM_DESC(hw_lz4_min_ratio, "smallest output to input ratio in percent for hw lz4");
+
+/*
+ * The engine reads from physically contiguous memory, so the raw lz4
+ * block of the pcluster is copied into a buffer with room for the frame
+ * rk_decom_lz4_block() wraps it in, and the output is copied to the
+ * destination pages afterwards. -EAGAIN leaves the request untouched for
+ * the cpu decompressor.
+ */
+static int z_erofs_hw_lz4_decompress(struct z_erofs_decompress_req *rq)
+{
+	const unsigned int nrpages_in = PAGE_ALIGN(rq->inputsize) >> PAGE_SHIFT;
+	unsigned int inputmargin = 0, inputsize, src_order, dst_order, i;
+	struct page *src_page, *dst_page;
+	u8 *src, *in;
+	u64 len = 0;
+	int ret;
+
+	if (rq->partial_decoding ||
+	    !erofs_sb_has_lz4_0padding(EROFS_SB(rq->sb)))
+		return -EAGAIN;
+	if (rq->inputsize < hw_lz4_min_size ||
+	    (u64)rq->outputsize * 100 < (u64)rq->inputsize * hw_lz4_min_ratio)
+		return -EAGAIN;
+
+	src_order = get_order(RK_DECOM_LZ4_HEAD + rq->inputsize +
+			      RK_DECOM_LZ4_TAIL);
+	dst_order = get_order(rq->outputsize);
+	src_page = alloc_pages(GFP_NOIO | GFP_DMA32 | __GFP_NOWARN, src_order);
+	if (!src_page)
+		return -EAGAIN;
+	dst_page = alloc_pages(GFP_NOIO | GFP_DMA32 | __GFP_NOWARN, dst_order);
+	if (!dst_page) {
+		__free_pages(src_page, src_order);
+		return -EAGAIN;
+	}
+
+	src = page_address(src_page);
+	in = src + RK_DECOM_LZ4_HEAD;
+	for (i = 0; i < nrpages_in; ++i) {
+		u8 *p = kmap_atomic(rq->in[i]);
+
+		memcpy(in + i * PAGE_SIZE, p,
+		       min_t(unsigned int, PAGE_SIZE, rq->inputsize - i * PAGE_SIZE));
+		kunmap_atomic(p);
+	}
+
+	/* 0padding only sits in the head block */
+	while (inputmargin < PAGE_SIZE && !in[inputmargin])
+		++inputmargin;
+	if (inputmargin >= rq->inputsize) {
+		ret = -EIO;
+		goto out;
+	}
+	inputsize = rq->inputsize - inputmargin;
+
+	ret = rk_decom_lz4_block(src + inputmargin, inputsize,
+				 page_address(dst_page), PAGE_SIZE << dst_order,
+				 &len);
+	if (ret || len != rq->outputsize) {
+		erofs_dbg("hw lz4 failed %d len %llu out[%u], use cpu",
+			  ret, len, rq->outputsize);
+		ret = -EAGAIN;
+		goto out;
+	}
+
+	copy_from_pcpubuf(rq->out, page_address(dst_page), rq->pageofs_out,
+			  rq->outputsize);
+out:
+	__free_pages(dst_page, dst_order);
+	__free_pages(src_page, src_order);
+	return ret;
+}
+#else
+static int z_erofs_hw_lz4_decompress(struct z_erofs_decompress_req *rq)
+{
+	return -EAGAIN;
+}
+#endif
+
 static int z_erofs_decompress_generic(struct z_erofs_decompress_req *rq,
 				      struct list_head *pagepool)
 {
@@ -309,6 +400,12 @@ static int z_erofs_decompress_generic(struct z_erofs_decompress_req *rq,
 	void *dst;
 	int ret;
 
+	if (rq->alg == Z_EROFS_COMPRESSION_LZ4) {
+		ret = z_erofs_hw_lz4_decompress(rq);
+		if (ret != -EAGAIN)
+			return ret;
+	}
+
 	/* two optimized fast paths only for non bigpcluster cases yet */
 	if (rq->inputsize <= PAGE_SIZE) {
 		if (nrpages_out == 1 && !rq->inplace_io) {
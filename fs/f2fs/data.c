@@ -2557,6 +2557,11 @@ bool f2fs_should_update_inplace(struct inode *inode, struct f2fs_io_info *fio)
 	if (f2fs_is_pinned_file(inode))
 		return true;
 
+	/* a recording stream fills its preallocated sections in place */
+	if (is_inode_flag_set(inode, FI_STREAM_FILE) &&
+			!is_inode_flag_set(inode, FI_OPU_WRITE))
+		return true;
+
 	/* if this is cold file, we should overwrite to avoid fragmentation */
 	if (file_is_cold(inode) && !is_inode_flag_set(inode, FI_OPU_WRITE))
 		return true;
@@ -3472,8 +3477,12 @@ static int f2fs_write_begin(struct file *file, struct address_space *mapping,
 
 	if (need_balance && !IS_NOQUOTA(inode) &&
 			has_not_enough_free_secs(sbi, 0, 0)) {
+		ktime_t start = ktime_get();
+
 		unlock_page(page);
 		f2fs_balance_fs(sbi, true);
+		if (is_inode_flag_set(inode, FI_STREAM_FILE))
+			f2fs_update_stream_stall(sbi, start);
 		lock_page(page);
 		if (page->mapping != mapping) {
 			/* The page got truncated from under us */
@@ -59,6 +59,19 @@ void f2fs_update_sit_info(struct f2fs_sb_info *sbi)
 		si->avg_vblocks = 0;
 }
 
+/* time a recording writer spent in foreground GC or checkpoint since start */
+void f2fs_update_stream_stall(struct f2fs_sb_info *sbi, ktime_t start)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	spin_lock(&sbi->stat_lock);
+	sbi->stream_stall_count++;
+	sbi->stream_stall_ns += ns;
+	if (ns > sbi->stream_stall_max_ns)
+		sbi->stream_stall_max_ns = ns;
+	spin_unlock(&sbi->stat_lock);
+}
+
 #ifdef CONFIG_DEBUG_FS
 static void update_general_status(struct f2fs_sb_info *sbi)
 {
@@ -178,6 +191,13 @@ static void update_general_status(struct f2fs_sb_info *sbi)
 	si->alloc_nids = NM_I(sbi)->nid_cnt[PREALLOC_NID];
 	si->io_skip_bggc = sbi->io_skip_bggc;
 	si->other_skip_bggc = sbi->other_skip_bggc;
+	si->stream_skip_bggc = sbi->stream_skip_bggc;
+	si->stream_defer_cp = sbi->stream_defer_cp;
+	spin_lock(&sbi->stat_lock);
+	si->stream_stall_count = sbi->stream_stall_count;
+	si->stream_stall_ns = sbi->stream_stall_ns;
+	si->stream_stall_max_ns = sbi->stream_stall_max_ns;
+	spin_unlock(&sbi->stat_lock);
 	si->skipped_atomic_files[BG_GC] = sbi->skipped_atomic_files[BG_GC];
 	si->skipped_atomic_files[FG_GC] = sbi->skipped_atomic_files[FG_GC];
 	si->util_free = (int)(free_user_blocks(sbi) >> sbi->log_blocks_per_seg)
@@ -441,6 +461,10 @@ static int stat_show(struct seq_file *s, void *v)
 			   si->curseg[CURSEG_ALL_DATA_ATGC],
 			   si->cursec[CURSEG_ALL_DATA_ATGC],
 			   si->curzone[CURSEG_ALL_DATA_ATGC]);
+		seq_printf(s, "  - Stream data: %8d %8d %8d\n",
+			   si->curseg[CURSEG_STREAM_DATA],
+			   si->cursec[CURSEG_STREAM_DATA],
+			   si->curzone[CURSEG_STREAM_DATA]);
 		seq_printf(s, "\n  - Valid: %d\n  - Dirty: %d\n",
 			   si->main_area_segs - si->dirty_count -
 			   si->prefree_count - si->free_segs,
@@ -488,6 +512,12 @@ static int stat_show(struct seq_file *s, void *v)
 				si->skipped_atomic_files[BG_GC]);
 		seq_printf(s, "BG skip : IO: %u, Other: %u\n",
 				si->io_skip_bggc, si->other_skip_bggc);
+		seq_printf(s, "Stream : BG skip: %u, CP deferred: %u\n",
+				si->stream_skip_bggc, si->stream_defer_cp);
+		seq_printf(s, "  - stalls : %u, total: %llu(ms), max: %llu(us)\n",
+				si->stream_stall_count,
+				div_u64(si->stream_stall_ns, NSEC_PER_MSEC),
+				div_u64(si->stream_stall_max_ns, NSEC_PER_USEC));
 		seq_puts(s, "\nExtent Cache (Read):\n");
 		seq_printf(s, "  - Hit Count: L1-1:%llu L1-2:%llu L2:%llu\n",
 				si->hit_largest, si->hit_cached[EX_READ],
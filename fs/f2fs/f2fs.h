@@ -229,6 +229,8 @@ enum {
 #define DEF_DISABLE_INTERVAL		5	/* 5 secs */
 #define DEF_DISABLE_QUICK_INTERVAL	1	/* 1 secs */
 #define DEF_UMOUNT_DISCARD_TIMEOUT	5	/* 5 secs */
+#define DEF_STREAM_INTERVAL		10	/* 10 secs */
+#define STREAM_CP_DEFER_FACTOR		4	/* 4 cp intervals at most */
 
 struct cp_control {
 	int reason;
@@ -779,6 +781,7 @@ enum {
 	FI_ENABLE_COMPRESS,	/* enable compression in "user" compression mode */
 	FI_COMPRESS_RELEASED,	/* compressed blocks were released */
 	FI_ALIGNED_WRITE,	/* enable aligned write */
+	FI_STREAM_FILE,		/* indicate file is a recording stream */
 	FI_MAX,			/* max flag, never be used */
 };
 
@@ -839,6 +842,8 @@ struct f2fs_inode_info {
 	unsigned char i_compress_level;		/* compress level (lz4hc,zstd) */
 	unsigned short i_compress_flag;		/* compress flag */
 	unsigned int i_cluster_size;		/* cluster size */
+
+	pgoff_t stream_prealloc_end;	/* end of preallocated stream blocks */
 };
 
 static inline void get_read_extent_info(struct extent_info *ext,
@@ -976,7 +981,7 @@ static inline void set_new_dnode(struct dnode_of_data *dn, struct inode *inode,
  */
 #define	NR_CURSEG_DATA_TYPE	(3)
 #define NR_CURSEG_NODE_TYPE	(3)
-#define NR_CURSEG_INMEM_TYPE	(2)
+#define NR_CURSEG_INMEM_TYPE	(3)
 #define NR_CURSEG_RO_TYPE	(2)
 #define NR_CURSEG_PERSIST_TYPE	(NR_CURSEG_DATA_TYPE + NR_CURSEG_NODE_TYPE)
 #define NR_CURSEG_TYPE		(NR_CURSEG_INMEM_TYPE + NR_CURSEG_PERSIST_TYPE)
@@ -992,6 +997,7 @@ enum {
 	CURSEG_COLD_DATA_PINNED = NR_PERSISTENT_LOG,
 				/* pinned file that needs consecutive block address */
 	CURSEG_ALL_DATA_ATGC,	/* SSR alloctor in hot/warm/cold data area */
+	CURSEG_STREAM_DATA,	/* appended data of recording streams */
 	NO_CHECK_TYPE,		/* number of persistent & inmem log */
 };
 
@@ -1278,6 +1284,7 @@ enum {
 	GC_TIME,
 	DISABLE_TIME,
 	UMOUNT_DISCARD_TIMEOUT,
+	STREAM_TIME,
 	MAX_TIME,
 };
 
@@ -1606,6 +1613,8 @@ struct f2fs_sb_info {
 	unsigned long last_time[MAX_TIME];	/* to store time in jiffies */
 	long interval_time[MAX_TIME];		/* to store thresholds */
 	struct ckpt_req_control cprc_info;	/* for checkpoint request control */
+	bool stream_written;			/* a recording stream was written */
+	bool stream_rotated;			/* a recording stream was closed */
 
 	struct inode_management im[MAX_INO_ENTRY];	/* manage inode cache */
 
@@ -1730,6 +1739,11 @@ struct f2fs_sb_info {
 	atomic_t max_vw_cnt;			/* max # of volatile writes */
 	unsigned int io_skip_bggc;		/* skip background gc for in-flight IO */
 	unsigned int other_skip_bggc;		/* skip background gc for other reasons */
+	unsigned int stream_skip_bggc;		/* skip background gc for recording */
+	unsigned int stream_defer_cp;		/* defer checkpoint for recording */
+	unsigned int stream_stall_count;	/* # of recording write stalls */
+	unsigned long long stream_stall_ns;	/* total recording stall time */
+	unsigned long long stream_stall_max_ns;	/* max recording stall time */
 	unsigned int ndirty_inode[NR_INODE_TYPE];	/* # of dirty inodes */
 #endif
 	spinlock_t stat_lock;			/* lock for stat operations */
@@ -1870,6 +1884,13 @@ static inline bool f2fs_time_over(struct f2fs_sb_info *sbi, int type)
 	return time_after(jiffies, sbi->last_time[type] + interval);
 }
 
+/* a recording stream was written within stream_interval */
+static inline bool f2fs_stream_active(struct f2fs_sb_info *sbi)
+{
+	return READ_ONCE(sbi->stream_written) &&
+		!f2fs_time_over(sbi, STREAM_TIME);
+}
+
 static inline unsigned int f2fs_time_to_wait(struct f2fs_sb_info *sbi,
 						int type)
 {
@@ -3827,6 +3848,8 @@ struct f2fs_stat_info {
 	int nr_rd_data, nr_rd_node, nr_rd_meta;
 	int nr_dio_read, nr_dio_write;
 	unsigned int io_skip_bggc, other_skip_bggc;
+	unsigned int stream_skip_bggc, stream_defer_cp, stream_stall_count;
+	unsigned long long stream_stall_ns, stream_stall_max_ns;
 	int nr_flushing, nr_flushed, flush_list_empty;
 	int nr_discarding, nr_discarded;
 	int nr_discard_cmd;
@@ -3874,6 +3897,8 @@ static inline struct f2fs_stat_info *F2FS_STAT(struct f2fs_sb_info *sbi)
 #define stat_inc_bggc_count(si)		((si)->bg_gc++)
 #define stat_io_skip_bggc_count(sbi)	((sbi)->io_skip_bggc++)
 #define stat_other_skip_bggc_count(sbi)	((sbi)->other_skip_bggc++)
+#define stat_stream_skip_bggc_count(sbi)	((sbi)->stream_skip_bggc++)
+#define stat_stream_defer_cp_count(sbi)	((sbi)->stream_defer_cp++)
 #define stat_inc_dirty_inode(sbi, type)	((sbi)->ndirty_inode[type]++)
 #define stat_dec_dirty_inode(sbi, type)	((sbi)->ndirty_inode[type]--)
 #define stat_inc_total_hit(sbi, type)		(atomic64_inc(&(sbi)->total_hit_ext[type]))
@@ -3996,6 +4021,7 @@ void f2fs_destroy_stats(struct f2fs_sb_info *sbi);
 void __init f2fs_create_root_stats(void);
 void f2fs_destroy_root_stats(void);
 void f2fs_update_sit_info(struct f2fs_sb_info *sbi);
+void f2fs_update_stream_stall(struct f2fs_sb_info *sbi, ktime_t start);
 #else
 #define stat_inc_cp_count(si)				do { } while (0)
 #define stat_inc_bg_cp_count(si)			do { } while (0)
@@ -4003,6 +4029,8 @@ void f2fs_update_sit_info(struct f2fs_sb_info *sbi);
 #define stat_inc_bggc_count(si)				do { } while (0)
 #define stat_io_skip_bggc_count(sbi)			do { } while (0)
 #define stat_other_skip_bggc_count(sbi)			do { } while (0)
+#define stat_stream_skip_bggc_count(sbi)		do { } while (0)
+#define stat_stream_defer_cp_count(sbi)			do { } while (0)
 #define stat_inc_dirty_inode(sbi, type)			do { } while (0)
 #define stat_dec_dirty_inode(sbi, type)			do { } while (0)
 #define stat_inc_total_hit(sbi, type)			do { } while (0)
@@ -4037,6 +4065,8 @@ static inline void f2fs_destroy_stats(struct f2fs_sb_info *sbi) { }
 static inline void __init f2fs_create_root_stats(void) { }
 static inline void f2fs_destroy_root_stats(void) { }
 static inline void f2fs_update_sit_info(struct f2fs_sb_info *sbi) {}
+static inline void f2fs_update_stream_stall(struct f2fs_sb_info *sbi,
+						ktime_t start) {}
 #endif
 
 extern const struct file_operations f2fs_dir_operations;
@@ -22,6 +22,7 @@
 #include <linux/file.h>
 #include <linux/nls.h>
 #include <linux/sched/signal.h>
+#include <linux/fadvise.h>
 
 #include "f2fs.h"
 #include "node.h"
@@ -1673,16 +1674,24 @@ static int expand_inode_data(struct inode *inode, loff_t offset,
 	if (!map.m_len)
 		return 0;
 
-	if (f2fs_is_pinned_file(inode)) {
+	if (f2fs_is_pinned_file(inode) ||
+			is_inode_flag_set(inode, FI_STREAM_FILE)) {
 		block_t sec_blks = BLKS_PER_SEC(sbi);
 		block_t sec_len = roundup(map.m_len, sec_blks);
+		bool stream = !f2fs_is_pinned_file(inode);
+		int seg_type = stream ? CURSEG_STREAM_DATA :
+					CURSEG_COLD_DATA_PINNED;
 
 		map.m_len = sec_blks;
 next_alloc:
 		if (has_not_enough_free_secs(sbi, 0,
 			GET_SEC_FROM_SEG(sbi, overprovision_segments(sbi)))) {
+			ktime_t start = ktime_get();
+
 			f2fs_down_write(&sbi->gc_lock);
 			err = f2fs_gc(sbi, true, false, false, NULL_SEGNO);
+			if (stream)
+				f2fs_update_stream_stall(sbi, start);
 			if (err && err != -ENODATA && err != -EAGAIN)
 				goto out_err;
 		}
@@ -1690,10 +1699,10 @@ static int expand_inode_data(struct inode *inode, loff_t offset,
 		f2fs_down_write(&sbi->pin_sem);
 
 		f2fs_lock_op(sbi);
-		f2fs_allocate_new_section(sbi, CURSEG_COLD_DATA_PINNED, false);
+		f2fs_allocate_new_section(sbi, seg_type, false);
 		f2fs_unlock_op(sbi);
 
-		map.m_seg_type = CURSEG_COLD_DATA_PINNED;
+		map.m_seg_type = seg_type;
 		err = f2fs_map_blocks(inode, &map, 1, F2FS_GET_BLOCK_PRE_DIO);
 
 		f2fs_up_write(&sbi->pin_sem);
@@ -1735,6 +1744,57 @@ static int expand_inode_data(struct inode *inode, loff_t offset,
 	return err;
 }
 
+/*
+ * appends of a recording stream run into whole sections preallocated
+ * beyond i_size, so its data stays contiguous in the stream log and is
+ * written in place, without a node update per block. the part left
+ * unused is trimmed when the file is closed.
+ */
+static void f2fs_stream_prealloc(struct inode *inode, loff_t pos,
+							size_t count)
+{
+	struct f2fs_inode_info *fi = F2FS_I(inode);
+	loff_t sec_size = (loff_t)BLKS_PER_SEC(F2FS_I_SB(inode)) << PAGE_SHIFT;
+	loff_t start = (loff_t)fi->stream_prealloc_end << PAGE_SHIFT;
+	loff_t len;
+
+	if (pos + count <= start)
+		return;
+
+	start = max_t(loff_t, start, round_down(pos, PAGE_SIZE));
+	len = roundup(pos + count - start, sec_size);
+
+	/* best effort, the write allocates what is not preallocated */
+	if (!expand_inode_data(inode, start, len, FALLOC_FL_KEEP_SIZE))
+		fi->stream_prealloc_end = (start + len) >> PAGE_SHIFT;
+}
+
+/* the last writer of a recording stream closes it, i.e. the file rotates */
+static void f2fs_stream_release(struct inode *inode)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+	struct f2fs_inode_info *fi = F2FS_I(inode);
+
+	inode_lock(inode);
+	if (fi->stream_prealloc_end >
+			DIV_ROUND_UP(i_size_read(inode), PAGE_SIZE)) {
+		f2fs_down_write(&fi->i_gc_rwsem[WRITE]);
+		f2fs_down_write(&fi->i_mmap_sem);
+		f2fs_truncate_blocks(inode, i_size_read(inode), true);
+		f2fs_up_write(&fi->i_mmap_sem);
+		f2fs_up_write(&fi->i_gc_rwsem[WRITE]);
+	}
+	fi->stream_prealloc_end = 0;
+	inode_unlock(inode);
+
+	/* checkpoint between two files, see f2fs_balance_fs_bg() */
+	WRITE_ONCE(sbi->stream_rotated, true);
+	if (f2fs_time_over(sbi, CP_TIME) && sbi->gc_thread) {
+		sbi->gc_thread->gc_wake = 1;
+		wake_up_interruptible_all(&sbi->gc_thread->gc_wait_queue_head);
+	}
+}
+
 static long f2fs_fallocate(struct file *file, int mode,
 				loff_t offset, loff_t len)
 {
@@ -1810,6 +1870,9 @@ static int f2fs_release_file(struct inode *inode, struct file *filp)
 			atomic_read(&inode->i_writecount) != 1)
 		return 0;
 
+	if (is_inode_flag_set(inode, FI_STREAM_FILE))
+		f2fs_stream_release(inode);
+
 	/* some remained atomic pages should discarded */
 	if (f2fs_is_atomic_file(inode))
 		f2fs_drop_inmem_pages(inode);
@@ -4460,6 +4523,11 @@ static ssize_t f2fs_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 					allow_outplace_dio(inode, iocb, from))
 				goto write;
 		}
+		if (is_inode_flag_set(inode, FI_STREAM_FILE) &&
+				!(iocb->ki_flags & IOCB_DIRECT))
+			f2fs_stream_prealloc(inode, iocb->ki_pos,
+						iov_iter_count(from));
+
 		preallocated = true;
 		target_size = iocb->ki_pos + iov_iter_count(from);
 
@@ -4480,12 +4548,18 @@ static ssize_t f2fs_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 			f2fs_down_write(&F2FS_I(inode)->i_gc_rwsem[WRITE]);
 			f2fs_down_write(&F2FS_I(inode)->i_mmap_sem);
 			f2fs_truncate(inode);
+			F2FS_I(inode)->stream_prealloc_end = 0;
 			f2fs_up_write(&F2FS_I(inode)->i_mmap_sem);
 			f2fs_up_write(&F2FS_I(inode)->i_gc_rwsem[WRITE]);
 		}
 
 		if (ret > 0)
 			f2fs_update_iostat(F2FS_I_SB(inode), APP_WRITE_IO, ret);
+
+		if (ret > 0 && is_inode_flag_set(inode, FI_STREAM_FILE)) {
+			WRITE_ONCE(F2FS_I_SB(inode)->stream_written, true);
+			f2fs_update_time(F2FS_I_SB(inode), STREAM_TIME);
+		}
 	}
 unlock:
 	inode_unlock(inode);
@@ -4497,6 +4571,28 @@ static ssize_t f2fs_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	return ret;
 }
 
+/*
+ * POSIX_FADV_NOREUSE marks a recording stream: data appended once and
+ * read back rarely, e.g. video written by a recorder.
+ * POSIX_FADV_NORMAL turns it back into a normal file.
+ */
+static int f2fs_file_fadvise(struct file *filp, loff_t offset, loff_t len,
+						int advice)
+{
+	struct inode *inode = file_inode(filp);
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+
+	if (S_ISREG(inode->i_mode) && advice == POSIX_FADV_NOREUSE &&
+			!f2fs_compressed_file(inode) &&
+			!f2fs_is_pinned_file(inode) &&
+			!f2fs_lfs_mode(sbi) && !f2fs_sb_has_blkzoned(sbi))
+		set_inode_flag(inode, FI_STREAM_FILE);
+	else if (advice == POSIX_FADV_NORMAL)
+		clear_inode_flag(inode, FI_STREAM_FILE);
+
+	return generic_fadvise(filp, offset, len, advice);
+}
+
 #ifdef CONFIG_COMPAT
 struct compat_f2fs_gc_range {
 	u32 sync;
@@ -4633,4 +4729,5 @@ const struct file_operations f2fs_file_operations = {
 #endif
 	.splice_read	= generic_file_splice_read,
 	.splice_write	= iter_file_splice_write,
+	.fadvise	= f2fs_file_fadvise,
 };
@@ -111,6 +111,18 @@ static int gc_thread_func(void *data)
 			goto next;
 		}
 
+		/*
+		 * a recording is running, victim moves in the middle of it
+		 * stall its appends. foreground GC still runs on low space.
+		 */
+		if (f2fs_stream_active(sbi)) {
+			increase_sleep_time(gc_th, &wait_ms);
+			f2fs_up_write(&sbi->gc_lock);
+			stat_stream_skip_bggc_count(sbi);
+			f2fs_balance_fs_bg(sbi, true);
+			goto next;
+		}
+
 		if (has_enough_invalid_blocks(sbi))
 			decrease_sleep_time(gc_th, &wait_ms);
 		else
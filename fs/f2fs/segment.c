@@ -530,6 +530,23 @@ void f2fs_balance_fs(struct f2fs_sb_info *sbi, bool need)
 	}
 }
 
+/*
+ * while recording, hold the periodical checkpoint back to the next file
+ * rotation of the stream, so that its node and meta writes land between
+ * two files instead of in the middle of one. a stream which does not
+ * rotate gets one after STREAM_CP_DEFER_FACTOR checkpoint intervals.
+ */
+static bool f2fs_stream_defer_cp(struct f2fs_sb_info *sbi)
+{
+	unsigned long bound = sbi->interval_time[CP_TIME] * HZ *
+						STREAM_CP_DEFER_FACTOR;
+
+	if (!f2fs_stream_active(sbi) || READ_ONCE(sbi->stream_rotated))
+		return false;
+
+	return !time_after(jiffies, sbi->last_time[CP_TIME] + bound);
+}
+
 void f2fs_balance_fs_bg(struct f2fs_sb_info *sbi, bool from_bg)
 {
 	if (unlikely(is_sbi_flag_set(sbi, SBI_POR_DOING)))
@@ -564,8 +581,11 @@ void f2fs_balance_fs_bg(struct f2fs_sb_info *sbi, bool from_bg)
 		return;
 
 	/* exceed periodical checkpoint timeout threshold */
-	if (f2fs_time_over(sbi, CP_TIME))
-		goto do_sync;
+	if (f2fs_time_over(sbi, CP_TIME)) {
+		if (!f2fs_stream_defer_cp(sbi))
+			goto do_sync;
+		stat_stream_defer_cp_count(sbi);
+	}
 
 	/* checkpoint is the only way to shrink partial cached entries */
 	if (f2fs_available_free_memory(sbi, NAT_ENTRIES) ||
@@ -2802,6 +2822,8 @@ void f2fs_save_inmem_curseg(struct f2fs_sb_info *sbi)
 
 	if (sbi->am.atgc_enabled)
 		__f2fs_save_inmem_curseg(sbi, CURSEG_ALL_DATA_ATGC);
+
+	__f2fs_save_inmem_curseg(sbi, CURSEG_STREAM_DATA);
 }
 
 static void __f2fs_restore_inmem_curseg(struct f2fs_sb_info *sbi, int type)
@@ -2827,6 +2849,8 @@ void f2fs_restore_inmem_curseg(struct f2fs_sb_info *sbi)
 
 	if (sbi->am.atgc_enabled)
 		__f2fs_restore_inmem_curseg(sbi, CURSEG_ALL_DATA_ATGC);
+
+	__f2fs_restore_inmem_curseg(sbi, CURSEG_STREAM_DATA);
 }
 
 static int get_ssr_segment(struct f2fs_sb_info *sbi, int type,
@@ -3332,6 +3356,11 @@ static int __get_segment_type_6(struct f2fs_io_info *fio)
 			else
 				return CURSEG_COLD_DATA;
 		}
+		/* keep the appends of a recording apart from other data */
+		if (is_inode_flag_set(inode, FI_STREAM_FILE) &&
+				CURSEG_I(fio->sbi, CURSEG_STREAM_DATA)->inited)
+			return CURSEG_STREAM_DATA;
+
 		if (file_is_cold(inode) || f2fs_need_compress_data(inode))
 			return CURSEG_COLD_DATA;
 
@@ -4493,6 +4522,8 @@ static int build_curseg(struct f2fs_sb_info *sbi)
 			array[i].seg_type = CURSEG_COLD_DATA;
 		else if (i == CURSEG_ALL_DATA_ATGC)
 			array[i].seg_type = CURSEG_COLD_DATA;
+		else if (i == CURSEG_STREAM_DATA)
+			array[i].seg_type = CURSEG_COLD_DATA;
 		array[i].segno = NULL_SEGNO;
 		array[i].next_blkoff = 0;
 		array[i].inited = false;
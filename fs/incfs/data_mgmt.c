@@ -334,6 +334,8 @@ struct data_file *incfs_open_data_file(struct mount_info *mi, struct file *bf)
 	return df;
 }
 
+static void drop_pending_hints(struct data_file *df);
+
 void incfs_free_data_file(struct data_file *df)
 {
 	u32 data_blocks_written, hash_blocks_written;
@@ -363,6 +365,7 @@ void incfs_free_data_file(struct data_file *df)
 			pr_warn("incfs: failed to write status to backing file\n");
 	}
 
+	drop_pending_hints(df);
 	incfs_free_mtree(df->df_hash_tree);
 	incfs_free_bfc(df->df_backing_file_context);
 	kfree(df->df_signature);
@@ -1017,7 +1020,7 @@ static void set_read_done(struct pending_read *read)
  * Returns a new pending read entry.
  */
 static struct pending_read *add_pending_read(struct data_file *df,
-					     int block_index)
+					     int block_index, bool hint)
 {
 	struct pending_read *result = NULL;
 	struct data_file_segment *segment = NULL;
@@ -1034,9 +1037,16 @@ static struct pending_read *add_pending_read(struct data_file *df,
 	result->block_index = block_index;
 	result->timestamp_us = ktime_to_us(ktime_get());
 	result->uid = current_uid().val;
+	result->hint = hint;
 
 	spin_lock(&mi->pending_read_lock);
 
+	if (hint && mi->mi_pending_hints >= INCFS_MAX_PENDING_HINTS) {
+		spin_unlock(&mi->pending_read_lock);
+		kfree(result);
+		return NULL;
+	}
+	mi->mi_pending_hints += hint;
 	result->serial_number = ++mi->mi_last_pending_read_number;
 	mi->mi_pending_reads_count++;
 
@@ -1084,6 +1094,17 @@ static void remove_pending_read(struct data_file *df, struct pending_read *read)
 	call_rcu(&read->rcu, free_pending_read_entry);
 }
 
+/* Needs mi->pending_read_lock */
+static void remove_pending_hint(struct mount_info *mi,
+				struct pending_read *read)
+{
+	list_del_rcu(&read->mi_reads_list);
+	list_del_rcu(&read->segment_reads_list);
+	mi->mi_pending_reads_count--;
+	mi->mi_pending_hints--;
+	call_rcu(&read->rcu, free_pending_read_entry);
+}
+
 static void notify_pending_reads(struct mount_info *mi,
 		struct data_file_segment *segment,
 		int index)
@@ -1094,8 +1115,15 @@ static void notify_pending_reads(struct mount_info *mi,
 	rcu_read_lock();
 	list_for_each_entry_rcu(entry, &segment->reads_list_head,
 						segment_reads_list) {
-		if (entry->block_index == index)
-			set_read_done(entry);
+		if (entry->block_index != index)
+			continue;
+		set_read_done(entry);
+		/* nobody waits for a hint, so nobody else removes it */
+		if (entry->hint) {
+			spin_lock(&mi->pending_read_lock);
+			remove_pending_hint(mi, entry);
+			spin_unlock(&mi->pending_read_lock);
+		}
 	}
 	rcu_read_unlock();
 	wake_up_all(&segment->new_data_arrival_wq);
@@ -1169,7 +1197,7 @@ static int wait_for_data_block(struct data_file *df, int block_index,
 	} else {
 		/* If it's not found, create a pending read */
 		if (timeouts && timeouts->max_pending_time_us) {
-			read = add_pending_read(df, block_index);
+			read = add_pending_read(df, block_index, false);
 			if (!read)
 				return -ENOMEM;
 		} else {
@@ -1446,6 +1474,93 @@ int incfs_process_new_data_block(struct data_file *df,
 	return error;
 }
 
+static bool is_block_pending(struct data_file_segment *segment, int index)
+{
+	struct pending_read *entry;
+	bool found = false;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(entry, &segment->reads_list_head,
+				segment_reads_list) {
+		if (entry->block_index == index) {
+			found = true;
+			break;
+		}
+	}
+	rcu_read_unlock();
+	return found;
+}
+
+/*
+ * Readahead hint for [offset, offset + len): every missing block becomes a
+ * pending read the data loader sees in the order of the hints, but nobody
+ * waits for it. A model runtime hints the layers it runs next, so the
+ * loader fills them in that order while the earlier ones already run.
+ * Returns the number of missing blocks.
+ */
+int incfs_hint_data_blocks(struct data_file *df, loff_t offset, loff_t len)
+{
+	struct data_file_segment *segment;
+	struct data_file_block block;
+	int first, last, i, missing = 0;
+	int error;
+
+	if (!df || df->df_blockmap_off <= 0 || !df->df_mount_info)
+		return 0;
+	if (offset < 0 || offset >= df->df_size)
+		return 0;
+
+	first = offset / INCFS_DATA_FILE_BLOCK_SIZE;
+	if (!len || len > df->df_size - offset)
+		len = df->df_size - offset;
+	last = min_t(loff_t, df->df_data_block_count,
+		     DIV_ROUND_UP(offset + len, INCFS_DATA_FILE_BLOCK_SIZE));
+
+	for (i = first; i < last; i++) {
+		segment = get_file_segment(df, i);
+
+		/* a block filled meanwhile would leave the hint behind */
+		error = down_read_killable(&segment->rwsem);
+		if (error)
+			return error;
+
+		error = get_data_file_block(df, i, &block);
+		if (!error && !is_data_block_present(&block)) {
+			missing++;
+			if (!is_block_pending(segment, i) &&
+			    !add_pending_read(df, i, true))
+				error = -EAGAIN;
+		}
+
+		up_read(&segment->rwsem);
+
+		/* out of hints, the demand reads still get through */
+		if (error)
+			break;
+	}
+
+	return error && !missing ? error : missing;
+}
+
+static void drop_pending_hints(struct data_file *df)
+{
+	struct mount_info *mi = df->df_mount_info;
+	struct pending_read *entry, *tmp;
+	int i;
+
+	if (!mi)
+		return;
+
+	spin_lock(&mi->pending_read_lock);
+	for (i = 0; i < ARRAY_SIZE(df->df_segments); i++)
+		list_for_each_entry_safe(entry, tmp,
+					 &df->df_segments[i].reads_list_head,
+					 segment_reads_list)
+			if (entry->hint)
+				remove_pending_hint(mi, entry);
+	spin_unlock(&mi->pending_read_lock);
+}
+
 int incfs_read_file_signature(struct data_file *df, struct mem_range dst)
 {
 	struct backing_file_context *bfc = df->df_backing_file_context;
@@ -1781,6 +1896,8 @@ int incfs_collect_pending_reads(struct mount_info *mi, int sn_lowerbound,
 			reads2[reported_reads].timestamp_us =
 				entry->timestamp_us;
 			reads2[reported_reads].uid = entry->uid;
+			reads2[reported_reads].flags = entry->hint ?
+				INCFS_PENDING_READ_HINT : 0;
 		}
 
 		if (entry->serial_number > *new_max_sn)
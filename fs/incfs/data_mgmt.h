@@ -24,6 +24,9 @@
 
 #define SEGMENTS_PER_FILE 3
 
+/* Readahead hints queued per mount, 16MB of blocks */
+#define INCFS_MAX_PENDING_HINTS 4096
+
 enum LOG_RECORD_TYPE {
 	FULL,
 	SAME_FILE,
@@ -167,6 +170,9 @@ struct mount_info {
 	/* Total number of items in reads_list_head */
 	int mi_pending_reads_count;
 
+	/* Of those, readahead hints nobody waits for */
+	int mi_pending_hints;
+
 	/*
 	 * Last serial number that was assigned to a pending read.
 	 * 0 means no pending reads have been seen yet.
@@ -260,6 +266,9 @@ struct pending_read {
 
 	uid_t uid;
 
+	/* Readahead hint, dropped when the block arrives */
+	bool hint;
+
 	struct list_head mi_reads_list;
 
 	struct list_head segment_reads_list;
@@ -443,6 +452,8 @@ int incfs_read_file_signature(struct data_file *df, struct mem_range dst);
 int incfs_process_new_data_block(struct data_file *df,
 				 struct incfs_fill_block *block, u8 *data);
 
+int incfs_hint_data_blocks(struct data_file *df, loff_t offset, loff_t len);
+
 int incfs_process_new_hash_block(struct data_file *df,
 				 struct incfs_fill_block *block, u8 *data);
 
@@ -5,6 +5,7 @@
 
 #include <linux/blkdev.h>
 #include <linux/compat.h>
+#include <linux/fadvise.h>
 #include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/fs_stack.h>
@@ -137,6 +138,25 @@ static int incfs_file_mmap(struct file *file, struct vm_area_struct *vma)
 	return 0;
 }
 
+/*
+ * WILLNEED on missing blocks would block in readahead until the data
+ * loader fills them in, queue them as hints for the loader instead.
+ */
+static int incfs_file_fadvise(struct file *file, loff_t offset, loff_t len,
+			      int advice)
+{
+	int missing;
+
+	if (advice == POSIX_FADV_WILLNEED) {
+		missing = incfs_hint_data_blocks(get_incfs_data_file(file),
+						 offset, len);
+		if (missing)
+			return missing < 0 ? missing : 0;
+	}
+
+	return generic_fadvise(file, offset, len, advice);
+}
+
 const struct file_operations incfs_file_ops = {
 	.open = file_open,
 	.release = file_release,
@@ -144,6 +164,7 @@ const struct file_operations incfs_file_ops = {
 	.mmap = incfs_file_mmap,
 	.splice_read = generic_file_splice_read,
 	.llseek = generic_file_llseek,
+	.fadvise = incfs_file_fadvise,
 	.unlocked_ioctl = dispatch_ioctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = incfs_compat_ioctl,
@@ -128,6 +128,10 @@ int jffs2_erase_pending_blocks(struct jffs2_sb_info *c, int count)
 			jffs2_dbg(1, "Starting erase of pending block 0x%08x\n",
 				  jeb->offset);
 			list_del(&jeb->list);
+			if (jeb->nosum) {
+				jeb->nosum = 0;
+				c->nr_nosum_blocks--;
+			}
 			c->erasing_size += c->sector_size;
 			c->wasted_size -= jeb->wasted_size;
 			c->free_size -= jeb->free_size;
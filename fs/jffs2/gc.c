@@ -41,12 +41,46 @@ static int jffs2_garbage_collect_live(struct jffs2_sb_info *c,  struct jffs2_era
 			       struct jffs2_raw_node_ref *raw, struct jffs2_inode_info *f);
 
 /* Called with erase_completion_lock held */
+/* Full blocks the scan found without a summary are rewritten while there
+   is space to spare, so that the next mount need not read them whole. */
+static struct jffs2_eraseblock *jffs2_find_nosum_block(struct jffs2_sb_info *c)
+{
+	struct list_head *lists[] = { &c->clean_list, &c->dirty_list, &c->very_dirty_list };
+	struct jffs2_eraseblock *jeb;
+	int i;
+
+	if (!c->nr_nosum_blocks || c->nr_free_blocks <= c->resv_blocks_gctrigger)
+		return NULL;
+
+	for (i = 0; i < ARRAY_SIZE(lists); i++) {
+		list_for_each_entry(jeb, lists[i], list) {
+			if (jeb->nosum) {
+				jffs2_dbg(1, "Picking block at 0x%08x without summary to GC next\n",
+					  jeb->offset);
+				jeb->nosum = 0;
+				c->nr_nosum_blocks--;
+				return jeb;
+			}
+		}
+	}
+
+	/* The rest is on its way to be erased */
+	for (i = 0; i < c->nr_blocks; i++)
+		c->blocks[i].nosum = 0;
+	c->nr_nosum_blocks = 0;
+	return NULL;
+}
+
 static struct jffs2_eraseblock *jffs2_find_gc_block(struct jffs2_sb_info *c)
 {
 	struct jffs2_eraseblock *ret;
 	struct list_head *nextlist = NULL;
 	int n = jiffies % 128;
 
+	ret = jffs2_find_nosum_block(c);
+	if (ret)
+		goto picked;
+
 	/* Pick an eraseblock to garbage collect next. This is where we'll
 	   put the clever wear-levelling algorithms. Eventually.  */
 	/* We possibly want to favour the dirtier blocks more when the
@@ -95,6 +129,7 @@ static struct jffs2_eraseblock *jffs2_find_gc_block(struct jffs2_sb_info *c)
 	}
 
 	ret = list_entry(nextlist->next, struct jffs2_eraseblock, list);
+ picked:
 	list_del(&ret->list);
 	c->gcblock = ret;
 	ret->gc_node = ret->first_node;
@@ -28,6 +28,7 @@
 #define JFFS2_SB_FLAG_BUILDING 4 /* File system building is in progress */
 
 struct jffs2_inodirty;
+struct jffs2_scan_ra;
 
 struct jffs2_mount_opts {
 	bool override_compr;
@@ -40,6 +41,12 @@ struct jffs2_mount_opts {
 	 * available space is less then 'rp_size'. */
 	bool set_rp_size;
 	unsigned int rp_size;
+
+	/* How long a partly filled write buffer may wait for more nodes
+	 * before it is written out, in milliseconds. Zero follows the VM
+	 * dirty_writeback_interval. */
+	bool set_wbuf_delay;
+	unsigned int wbuf_delay;
 };
 
 /* A struct for the overall file system control.  Pointers to
@@ -76,6 +83,7 @@ struct jffs2_sb_info {
 
 	uint32_t nr_free_blocks;
 	uint32_t nr_erasing_blocks;
+	uint32_t nr_nosum_blocks;	/* Full blocks to rewrite for a summary */
 
 	/* Number of free blocks there must be before we... */
 	uint8_t resv_blocks_write;	/* ... allow a normal filesystem write */
@@ -135,12 +143,14 @@ struct jffs2_sb_info {
 	struct rw_semaphore wbuf_sem;	/* Protects the write buffer */
 
 	struct delayed_work wbuf_dwork; /* write-buffer write-out work */
+	unsigned long wbuf_dirty_time;	/* first write left in the wbuf, jiffies */
 
 	unsigned char *oobbuf;
 	int oobavail; /* How many bytes are available for JFFS2 in OOB */
 #endif
 
 	struct jffs2_summary *summary;		/* Summary information */
+	struct jffs2_scan_ra *scan_ra;		/* Read-ahead of the block being scanned */
 	struct jffs2_mount_opts mount_opts;
 
 #ifdef CONFIG_JFFS2_FS_XATTR
@@ -291,6 +291,8 @@ struct jffs2_eraseblock
 	struct jffs2_raw_node_ref *last_node;
 
 	struct jffs2_raw_node_ref *gc_node;	/* Next node to be garbage collected */
+
+	unsigned char nosum;	/* Scanned without a summary, to be rewritten */
 };
 
 static inline int jffs2_blocks_use_vmalloc(struct jffs2_sb_info *c)
@@ -865,6 +865,10 @@ int jffs2_thread_should_wake(struct jffs2_sb_info *c)
 			(dirty > c->nospc_dirty_size))
 		ret = 1;
 
+	/* Rewrite full blocks without a summary while there is space */
+	if (c->nr_nosum_blocks && c->nr_free_blocks > c->resv_blocks_gctrigger)
+		ret = 1;
+
 	list_for_each_entry(jeb, &c->very_dirty_list, list) {
 		nr_very_dirty++;
 		if (nr_very_dirty == c->vdirty_blocks_gctrigger) {
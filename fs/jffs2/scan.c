@@ -18,12 +18,19 @@
 #include <linux/pagemap.h>
 #include <linux/crc32.h>
 #include <linux/compiler.h>
+#include <linux/workqueue.h>
 #include "nodelist.h"
 #include "summary.h"
 #include "debug.h"
 
 #define DEFAULT_EMPTY_SCAN_SIZE 256
 
+/* Eraseblocks read ahead of the scan, each by its own worker */
+#define JFFS2_SCAN_RA_DEPTH 4
+
+/* Blocks without a summary rewritten in the background per mount */
+#define JFFS2_NOSUM_REGEN_MAX 16
+
 #define noisy_printk(noise, fmt, ...)					\
 do {									\
 	if (*(noise)) {							\
@@ -66,6 +73,115 @@ static inline uint32_t EMPTY_SCAN_SIZE(uint32_t sector_size) {
 		return DEFAULT_EMPTY_SCAN_SIZE;
 }
 
+/*
+ * Read-ahead of one eraseblock. The worker reads what the scan is going
+ * to look at, in one flash read per region: the summary when the block
+ * has one, else the head to tell an erased block, and then the whole
+ * block. jffs2_fill_scan_buf() serves the scan from it.
+ */
+struct jffs2_scan_ra {
+	struct work_struct work;
+	struct completion done;
+	struct jffs2_sb_info *c;
+	struct jffs2_eraseblock *jeb;
+	unsigned char *buf;	/* mirrors the eraseblock */
+	uint32_t head_len;	/* valid from the start of the block */
+	uint32_t tail_len;	/* valid up to the end of the block */
+	bool queued;
+};
+
+static int jffs2_scan_ra_read(struct jffs2_sb_info *c, struct jffs2_scan_ra *ra,
+			      uint32_t start, uint32_t len)
+{
+	size_t retlen;
+	int ret;
+
+	ret = jffs2_flash_read(c, ra->jeb->offset + start, len, &retlen,
+			       ra->buf + start);
+	if (!ret && retlen < len)
+		ret = -EIO;
+	return ret;
+}
+
+static void jffs2_scan_ra_work(struct work_struct *work)
+{
+	struct jffs2_scan_ra *ra = container_of(work, struct jffs2_scan_ra, work);
+	struct jffs2_sb_info *c = ra->c;
+	uint32_t empty = EMPTY_SCAN_SIZE(c->sector_size);
+	uint32_t i;
+
+	ra->head_len = ra->tail_len = 0;
+
+	if (jffs2_sum_active()) {
+		struct jffs2_sum_marker *sm;
+		uint32_t sumlen;
+
+		sm = (void *)ra->buf + c->sector_size - sizeof(*sm);
+		if (jffs2_scan_ra_read(c, ra, c->sector_size - sizeof(*sm), sizeof(*sm)))
+			goto out;
+		ra->tail_len = sizeof(*sm);
+
+		sumlen = c->sector_size - je32_to_cpu(sm->offset);
+		if (je32_to_cpu(sm->magic) == JFFS2_SUM_MAGIC &&
+		    sumlen > sizeof(*sm) && sumlen <= c->sector_size) {
+			if (!jffs2_scan_ra_read(c, ra, c->sector_size - sumlen,
+						sumlen - sizeof(*sm)))
+				ra->tail_len = sumlen;
+			goto out;
+		}
+	}
+
+	if (jffs2_scan_ra_read(c, ra, 0, empty))
+		goto out;
+	ra->head_len = empty;
+
+	for (i = 0; i < empty; i += 4)
+		if (*(uint32_t *)(&ra->buf[i]) != 0xFFFFFFFF)
+			break;
+	if (i == empty)
+		goto out;
+
+	if (!jffs2_scan_ra_read(c, ra, empty, c->sector_size - empty))
+		ra->head_len = c->sector_size;
+ out:
+	complete(&ra->done);
+}
+
+static void jffs2_scan_ra_queue(struct jffs2_scan_ra *ra, struct jffs2_eraseblock *jeb)
+{
+	ra->jeb = jeb;
+	ra->queued = true;
+	reinit_completion(&ra->done);
+	queue_work(system_unbound_wq, &ra->work);
+}
+
+static void jffs2_scan_ra_wait(struct jffs2_scan_ra *ra)
+{
+	if (ra->queued)
+		wait_for_completion(&ra->done);
+	ra->queued = false;
+}
+
+/* Copy the range from the read-ahead of the block being scanned, if it has it */
+static bool jffs2_scan_ra_hit(struct jffs2_sb_info *c, void *buf,
+			      uint32_t ofs, uint32_t len)
+{
+	struct jffs2_scan_ra *ra = c->scan_ra;
+	uint32_t start;
+
+	if (!ra || ofs < ra->jeb->offset)
+		return false;
+
+	start = ofs - ra->jeb->offset;
+	if (start > c->sector_size || len > c->sector_size - start)
+		return false;
+	if (start + len > ra->head_len && start < c->sector_size - ra->tail_len)
+		return false;
+
+	memcpy(buf, ra->buf + start, len);
+	return true;
+}
+
 static int file_dirty(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb)
 {
 	int ret;
@@ -95,6 +211,8 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 	unsigned char *flashbuf = NULL;
 	uint32_t buf_size = 0;
 	struct jffs2_summary *s = NULL; /* summary info collected by the scan process */
+	struct jffs2_scan_ra *ra = NULL;
+	int nr_ra = 0;
 #ifndef __ECOS
 	size_t pointlen, try_size;
 
@@ -111,12 +229,9 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 		jffs2_dbg(1, "MTD point failed %d\n", ret);
 #endif
 	if (!flashbuf) {
-		/* For NAND it's quicker to read a whole eraseblock at a time,
-		   apparently */
-		if (jffs2_cleanmarker_oob(c))
-			try_size = c->sector_size;
-		else
-			try_size = PAGE_SIZE;
+		/* It's quicker to read a whole eraseblock at a time, for NAND
+		   and for NOR behind a controller doing large reads by DMA */
+		try_size = c->sector_size;
 
 		jffs2_dbg(1, "Trying to allocate readbuf of %zu "
 			  "bytes\n", try_size);
@@ -140,6 +255,26 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 		}
 	}
 
+	/* Read the next blocks ahead while this one is parsed. NAND reads
+	   its OOB as well, leave it alone */
+	if (buf_size && !jffs2_cleanmarker_oob(c)) {
+		ra = kcalloc(JFFS2_SCAN_RA_DEPTH, sizeof(*ra), GFP_KERNEL);
+		for (nr_ra = 0; ra && nr_ra < JFFS2_SCAN_RA_DEPTH; nr_ra++) {
+			ra[nr_ra].buf = kmalloc(c->sector_size, GFP_KERNEL | __GFP_NOWARN);
+			if (!ra[nr_ra].buf)
+				break;
+			ra[nr_ra].c = c;
+			INIT_WORK(&ra[nr_ra].work, jffs2_scan_ra_work);
+			init_completion(&ra[nr_ra].done);
+		}
+		if (nr_ra < 2)
+			jffs2_dbg(1, "No memory to read eraseblocks ahead\n");
+		else
+			jffs2_dbg(1, "Reading %d eraseblocks ahead\n", nr_ra);
+		for (i = 0; nr_ra >= 2 && i < nr_ra && i < c->nr_blocks; i++)
+			jffs2_scan_ra_queue(&ra[i], &c->blocks[i]);
+	}
+
 	for (i=0; i<c->nr_blocks; i++) {
 		struct jffs2_eraseblock *jeb = &c->blocks[i];
 
@@ -148,12 +283,30 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 		/* reset summary info for next eraseblock scan */
 		jffs2_sum_reset_collected(s);
 
+		if (nr_ra >= 2) {
+			jffs2_scan_ra_wait(&ra[i % nr_ra]);
+			c->scan_ra = &ra[i % nr_ra];
+		}
+
 		ret = jffs2_scan_eraseblock(c, jeb, buf_size?flashbuf:(flashbuf+jeb->offset),
 						buf_size, s);
 
+		c->scan_ra = NULL;
+		if (nr_ra >= 2 && i + nr_ra < c->nr_blocks)
+			jffs2_scan_ra_queue(&ra[i % nr_ra], &c->blocks[i + nr_ra]);
+
 		if (ret < 0)
 			goto out;
 
+		/* Only full blocks are worth rewriting, GC gets to the others */
+		if (jeb->nosum) {
+			if (ret == BLK_STATE_CLEAN &&
+			    c->nr_nosum_blocks < JFFS2_NOSUM_REGEN_MAX)
+				c->nr_nosum_blocks++;
+			else
+				jeb->nosum = 0;
+		}
+
 		jffs2_dbg_acct_paranoia_check_nolock(c, jeb);
 
 		/* Now decide which list to put it on */
@@ -273,8 +426,16 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 		jffs2_garbage_collect_trigger(c);
 		spin_unlock(&c->erase_completion_lock);
 	}
+	if (c->nr_nosum_blocks)
+		jffs2_dbg(1, "%d full blocks have no summary, rewriting them in the background\n",
+			  c->nr_nosum_blocks);
 	ret = 0;
  out:
+	for (i = 0; i < nr_ra; i++) {
+		jffs2_scan_ra_wait(&ra[i]);
+		kfree(ra[i].buf);
+	}
+	kfree(ra);
 	jffs2_sum_reset_collected(s);
 	kfree(s);
  out_buf:
@@ -293,6 +454,9 @@ static int jffs2_fill_scan_buf(struct jffs2_sb_info *c, void *buf,
 	int ret;
 	size_t retlen;
 
+	if (jffs2_scan_ra_hit(c, buf, ofs, len))
+		return 0;
+
 	ret = jffs2_flash_read(c, ofs, len, &retlen, buf);
 	if (ret) {
 		jffs2_dbg(1, "mtd->read(0x%x bytes from 0x%x) returned %d\n",
@@ -555,6 +719,10 @@ static int jffs2_scan_eraseblock (struct jffs2_sb_info *c, struct jffs2_eraseblo
 	}
 
 full_scan:
+	/* Rewritten later, so that the next mount finds a summary */
+	if (jffs2_sum_active())
+		jeb->nosum = 1;
+
 	buf_ofs = jeb->offset;
 
 	if (!buf_size) {
@@ -90,6 +90,8 @@ static int jffs2_show_options(struct seq_file *s, struct dentry *root)
 		seq_printf(s, ",compr=%s", jffs2_compr_name(opts->compr));
 	if (opts->set_rp_size)
 		seq_printf(s, ",rp_size=%u", opts->rp_size / 1024);
+	if (opts->set_wbuf_delay)
+		seq_printf(s, ",wbuf_delay=%u", opts->wbuf_delay);
 
 	return 0;
 }
@@ -161,10 +163,12 @@ static const struct export_operations jffs2_export_ops = {
  * Opt_source: The source device
  * Opt_override_compr: override default compressor
  * Opt_rp_size: size of reserved pool in KiB
+ * Opt_wbuf_delay: write-out delay of a partly filled write buffer in ms
  */
 enum {
 	Opt_override_compr,
 	Opt_rp_size,
+	Opt_wbuf_delay,
 };
 
 static const struct constant_table jffs2_param_compr[] = {
@@ -181,6 +185,7 @@ static const struct constant_table jffs2_param_compr[] = {
 static const struct fs_parameter_spec jffs2_fs_parameters[] = {
 	fsparam_enum	("compr",	Opt_override_compr, jffs2_param_compr),
 	fsparam_u32	("rp_size",	Opt_rp_size),
+	fsparam_u32	("wbuf_delay",	Opt_wbuf_delay),
 	{}
 };
 
@@ -205,6 +210,12 @@ static int jffs2_parse_param(struct fs_context *fc, struct fs_parameter *param)
 		c->mount_opts.rp_size = result.uint_32 * 1024;
 		c->mount_opts.set_rp_size = true;
 		break;
+	case Opt_wbuf_delay:
+		if (result.uint_32 > 3600 * MSEC_PER_SEC)
+			return invalf(fc, "jffs2: wbuf_delay over an hour");
+		c->mount_opts.wbuf_delay = result.uint_32;
+		c->mount_opts.set_wbuf_delay = true;
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -226,6 +237,10 @@ static inline void jffs2_update_mount_opts(struct fs_context *fc)
 		c->mount_opts.set_rp_size = new_c->mount_opts.set_rp_size;
 		c->mount_opts.rp_size = new_c->mount_opts.rp_size;
 	}
+	if (new_c->mount_opts.set_wbuf_delay) {
+		c->mount_opts.set_wbuf_delay = new_c->mount_opts.set_wbuf_delay;
+		c->mount_opts.wbuf_delay = new_c->mount_opts.wbuf_delay;
+	}
 	mutex_unlock(&c->alloc_sem);
 }
 
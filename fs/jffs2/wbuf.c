@@ -86,6 +86,10 @@ static void jffs2_wbuf_dirties_inode(struct jffs2_sb_info *c, uint32_t ino)
 {
 	struct jffs2_inodirty *new;
 
+	/* The first write since the last write-out starts the clock */
+	if (!c->wbuf_inodes)
+		c->wbuf_dirty_time = jiffies;
+
 	/* Schedule delayed write-buffer write-out */
 	jffs2_dirty_trigger(c);
 
@@ -1157,15 +1161,38 @@ static struct jffs2_sb_info *work_to_sb(struct work_struct *work)
 	return container_of(dwork, struct jffs2_sb_info, wbuf_dwork);
 }
 
+static unsigned long jffs2_wbuf_delay(struct jffs2_sb_info *c)
+{
+	if (c->mount_opts.wbuf_delay)
+		return msecs_to_jiffies(c->mount_opts.wbuf_delay);
+
+	return msecs_to_jiffies(dirty_writeback_interval * 10);
+}
+
 static void delayed_wbuf_sync(struct work_struct *work)
 {
 	struct jffs2_sb_info *c = work_to_sb(work);
 	struct super_block *sb = OFNI_BS_2SFFJ(c);
+	unsigned long delay = jffs2_wbuf_delay(c);
+	unsigned long age;
 
-	if (!sb_rdonly(sb)) {
-		jffs2_dbg(1, "%s()\n", __func__);
-		jffs2_flush_wbuf_gc(c, 0);
+	if (sb_rdonly(sb))
+		return;
+
+	/* The page the timer was armed for has filled up and gone out
+	   meanwhile. Give what came after it its own full delay to
+	   collect more nodes, rather than padding it out now. */
+	down_read(&c->wbuf_sem);
+	age = jiffies - c->wbuf_dirty_time;
+	if (c->wbuf_inodes && age < delay) {
+		up_read(&c->wbuf_sem);
+		queue_delayed_work(system_long_wq, &c->wbuf_dwork, delay - age);
+		return;
 	}
+	up_read(&c->wbuf_sem);
+
+	jffs2_dbg(1, "%s()\n", __func__);
+	jffs2_flush_wbuf_gc(c, 0);
 }
 
 void jffs2_dirty_trigger(struct jffs2_sb_info *c)
@@ -1176,7 +1203,7 @@ void jffs2_dirty_trigger(struct jffs2_sb_info *c)
 	if (sb_rdonly(sb))
 		return;
 
-	delay = msecs_to_jiffies(dirty_writeback_interval * 10);
+	delay = jffs2_wbuf_delay(c);
 	if (queue_delayed_work(system_long_wq, &c->wbuf_dwork, delay))
 		jffs2_dbg(1, "%s()\n", __func__);
 }
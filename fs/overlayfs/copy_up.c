@@ -36,6 +36,11 @@ static int ovl_ccup_get(char *buf, const struct kernel_param *param)
 module_param_call(check_copy_up, ovl_ccup_set, ovl_ccup_get, NULL, 0644);
 MODULE_PARM_DESC(check_copy_up, "Obsolete; does nothing");
 
+static bool ovl_lazy_copy_up_def;
+module_param_named(lazy_copy_up, ovl_lazy_copy_up_def, bool, 0644);
+MODULE_PARM_DESC(lazy_copy_up,
+		 "Copy up data of large files chunk by chunk on write, needs metacopy");
+
 static bool ovl_must_copy_xattr(const char *name)
 {
 	return !strcmp(name, XATTR_POSIX_ACL_ACCESS) ||
@@ -229,6 +234,163 @@ static int ovl_copy_up_data(struct ovl_fs *ofs, struct path *old,
 	return error;
 }
 
+/*
+ * Lazy data copy up. The lower data is split in at most OVL_LAZY_MAX_CHUNKS
+ * chunks of at least 64K, a chunk is copied up on the first write to it.
+ * The "lazycopy" xattr on the metacopy upper records the copied chunks, it
+ * is written before the write to the chunk goes to the upper file.
+ */
+#define OVL_LAZY_MIN_SHIFT	16
+#define OVL_LAZY_MAX_SHIFT	40
+#define OVL_LAZY_MAX_CHUNKS	8192
+#define OVL_LAZY_VERSION	1
+
+struct ovl_lazy_xattr {
+	u8 version;
+	u8 shift;
+	u8 pad[6];
+	__le64 size;
+	u8 map[];
+} __packed;
+
+static struct ovl_lazy *ovl_lazy_alloc(loff_t size, unsigned int shift)
+{
+	unsigned long nr = DIV_ROUND_UP_ULL(size, 1ULL << shift);
+	struct ovl_lazy *lazy;
+
+	lazy = kzalloc(struct_size(lazy, map, BITS_TO_LONGS(nr)), GFP_KERNEL);
+	if (!lazy)
+		return NULL;
+
+	lazy->size = size;
+	lazy->shift = shift;
+	lazy->nr = lazy->left = nr;
+
+	return lazy;
+}
+
+static int ovl_lazy_store(struct ovl_fs *ofs, struct dentry *upper,
+			  struct ovl_lazy *lazy)
+{
+	struct ovl_lazy_xattr *lx;
+	size_t len = sizeof(*lx) + DIV_ROUND_UP(lazy->nr, BITS_PER_BYTE);
+	int err;
+
+	lx = kzalloc(len, GFP_KERNEL);
+	if (!lx)
+		return -ENOMEM;
+
+	lx->version = OVL_LAZY_VERSION;
+	lx->shift = lazy->shift;
+	lx->size = cpu_to_le64(lazy->size);
+	memcpy(lx->map, lazy->map, len - sizeof(*lx));
+	err = ovl_do_setxattr(ofs, upper, OVL_XATTR_LAZYCOPY, lx, len);
+	kfree(lx);
+
+	return err;
+}
+
+static int ovl_lazy_copy_chunk(struct file *old_file, struct file *new_file,
+			       loff_t pos, loff_t len)
+{
+	loff_t old_pos = pos, new_pos = pos;
+	long bytes;
+
+	while (len) {
+		if (signal_pending_state(TASK_KILLABLE, current))
+			return -EINTR;
+
+		bytes = do_splice_direct(old_file, &old_pos, new_file, &new_pos,
+					 min_t(loff_t, len,
+					       OVL_COPY_UP_CHUNK_SIZE),
+					 SPLICE_F_MOVE);
+		if (bytes <= 0)
+			return bytes ?: -EIO;
+
+		len -= bytes;
+	}
+
+	return 0;
+}
+
+/* Copy up the chunks of [start, end) that are not yet, ovl_inode lock held */
+static int ovl_lazy_copy_chunks(struct dentry *dentry, loff_t start,
+				loff_t end)
+{
+	struct ovl_fs *ofs = OVL_FS(dentry->d_sb);
+	struct ovl_lazy *lazy = OVL_I(d_inode(dentry))->lazy;
+	struct path upperpath, datapath;
+	struct file *old_file, *new_file;
+	unsigned long i, last;
+	bool dirty = false;
+	loff_t pos;
+	int err = 0, err2;
+
+	if (!lazy->left || end <= start || start >= lazy->size)
+		return 0;
+
+	i = start >> lazy->shift;
+	last = min_t(unsigned long,
+		     DIV_ROUND_UP_ULL(end, 1ULL << lazy->shift), lazy->nr);
+	i = find_next_zero_bit_le(lazy->map, last, i);
+	if (i >= last)
+		return 0;
+
+	ovl_path_upper(dentry, &upperpath);
+	ovl_path_lowerdata(dentry, &datapath);
+	if (WARN_ON(!upperpath.dentry || !datapath.dentry))
+		return -EIO;
+
+	old_file = ovl_path_open(&datapath, O_LARGEFILE | O_RDONLY);
+	if (IS_ERR(old_file))
+		return PTR_ERR(old_file);
+
+	new_file = ovl_path_open(&upperpath, O_LARGEFILE | O_WRONLY);
+	if (IS_ERR(new_file)) {
+		err = PTR_ERR(new_file);
+		goto out_fput;
+	}
+
+	for (; i < last; i = find_next_zero_bit_le(lazy->map, last, i + 1)) {
+		pos = (loff_t)i << lazy->shift;
+		err = ovl_lazy_copy_chunk(old_file, new_file, pos,
+					  min_t(loff_t, lazy->size - pos,
+						1ULL << lazy->shift));
+		if (err)
+			break;
+
+		__set_bit_le(i, lazy->map);
+		lazy->left--;
+		dirty = true;
+	}
+
+	if (dirty && ovl_should_sync(ofs)) {
+		err2 = vfs_fsync(new_file, 0);
+		err = err ?: err2;
+	}
+	if (dirty) {
+		err2 = ovl_lazy_store(ofs, upperpath.dentry, lazy);
+		err = err ?: err2;
+	}
+	fput(new_file);
+out_fput:
+	fput(old_file);
+
+	return err;
+}
+
+/* All data is in the upper file now, ovl_inode lock held */
+static void ovl_lazy_done(struct dentry *dentry, struct dentry *upper)
+{
+	struct ovl_fs *ofs = OVL_FS(dentry->d_sb);
+	struct inode *inode = d_inode(dentry);
+
+	/* a stale xattr without metacopy is ignored */
+	ovl_do_removexattr(ofs, upper, OVL_XATTR_LAZYCOPY);
+	ovl_clear_flag(OVL_LAZYDATA, inode);
+	ovl_lazy_free(inode);
+}
+
 static int ovl_set_size(struct dentry *upperdentry, struct kstat *stat)
 {
 	struct iattr attr = {
@@ -834,7 +996,11 @@ static int ovl_copy_up_meta_inode_data(struct ovl_copy_up_ctx *c)
 			goto out;
 	}
 
-	err = ovl_copy_up_data(ofs, &datapath, &upperpath, c->stat.size);
+	if (ovl_is_lazy(d_inode(c->dentry)))
+		err = ovl_lazy_copy_chunks(c->dentry, 0, c->stat.size);
+	else
+		err = ovl_copy_up_data(ofs, &datapath, &upperpath,
+				       c->stat.size);
 	if (err)
 		goto out_free;
 
@@ -855,6 +1021,8 @@ static int ovl_copy_up_meta_inode_data(struct ovl_copy_up_ctx *c)
 		goto out_free;
 
 	ovl_set_upperdata(d_inode(c->dentry));
+	if (ovl_is_lazy(d_inode(c->dentry)))
+		ovl_lazy_done(c->dentry, upperpath.dentry);
 out_free:
 	kfree(capability);
 out:
@@ -1008,3 +1176,240 @@ int ovl_copy_up(struct dentry *dentry)
 {
 	return ovl_copy_up_flags(dentry, 0);
 }
+
+/* Make the metacopy upper of dentry lazy, ovl_inode lock held */
+static int ovl_lazy_start(struct dentry *dentry)
+{
+	struct ovl_fs *ofs = OVL_FS(dentry->d_sb);
+	struct inode *inode = d_inode(dentry);
+	struct dentry *upper = ovl_dentry_upper(dentry);
+	struct inode *lowerdata = ovl_inode_lowerdata(inode);
+	struct ovl_lazy *lazy;
+	unsigned int shift = OVL_LAZY_MIN_SHIFT;
+	loff_t size;
+	int err;
+
+	if (ovl_is_lazy(inode))
+		return 1;
+	if (ovl_has_upperdata(inode) || !upper || !lowerdata)
+		return 0;
+
+	size = i_size_read(lowerdata);
+	while (DIV_ROUND_UP_ULL(size, 1ULL << shift) > OVL_LAZY_MAX_CHUNKS)
+		shift++;
+
+	lazy = ovl_lazy_alloc(size, shift);
+	if (!lazy)
+		return -ENOMEM;
+
+	err = ovl_lazy_store(ofs, upper, lazy);
+	if (err) {
+		kfree(lazy);
+		/* copy up all data on open as before */
+		return err == -EOPNOTSUPP ? 0 : err;
+	}
+
+	OVL_I(inode)->lazy = lazy;
+	/* Pairs with the smp_rmb() of ovl_has_upperdata() */
+	smp_wmb();
+	ovl_set_flag(OVL_LAZYDATA, inode);
+
+	return 1;
+}
+
+/*
+ * Open for write of a large lower file: copy up metadata only and leave
+ * the data to ovl_lazy_copy_up_range() on write. Returns 1 if dentry is
+ * lazy now, 0 if the open has to copy up as usual.
+ */
+int ovl_maybe_lazy_copy_up(struct dentry *dentry, int flags)
+{
+	struct ovl_fs *ofs = OVL_FS(dentry->d_sb);
+	struct inode *inode = d_inode(dentry);
+	struct inode *lowerdata;
+	const struct cred *old_cred;
+	int err;
+
+	if (ovl_is_lazy(inode))
+		return 1;
+
+	if (!ovl_lazy_copy_up_def || !ofs->config.metacopy ||
+	    !S_ISREG(inode->i_mode) || !(OPEN_FMODE(flags) & FMODE_WRITE) ||
+	    (flags & O_TRUNC) || ovl_has_upperdata(inode))
+		return 0;
+
+	lowerdata = ovl_inode_lowerdata(inode);
+	if (!lowerdata || i_size_read(lowerdata) < OVL_COPY_UP_CHUNK_SIZE)
+		return 0;
+
+	err = ovl_want_write(dentry);
+	if (err)
+		return err;
+
+	err = ovl_copy_up(dentry);
+	if (!err) {
+		old_cred = ovl_override_creds(dentry->d_sb);
+		ovl_inode_lock(inode);
+		err = ovl_lazy_start(dentry);
+		ovl_inode_unlock(inode);
+		ovl_revert_creds(dentry->d_sb, old_cred);
+	}
+	ovl_drop_write(dentry);
+
+	return err;
+}
+
+/* Copy up the data that a write to [start, end) is going to modify */
+int ovl_lazy_copy_up_range(struct dentry *dentry, loff_t start, loff_t end)
+{
+	struct inode *inode = d_inode(dentry);
+	const struct cred *old_cred;
+	int err;
+
+	err = ovl_inode_lock_interruptible(inode);
+	if (err)
+		return err;
+
+	if (OVL_I(inode)->lazy) {
+		/* a write past lower data moves its tail away from EOF */
+		start = min(start, OVL_I(inode)->lazy->size);
+		old_cred = ovl_override_creds(dentry->d_sb);
+		err = ovl_lazy_copy_chunks(dentry, start, end);
+		ovl_revert_creds(dentry->d_sb, old_cred);
+	}
+	ovl_inode_unlock(inode);
+
+	return err;
+}
+
+/*
+ * Length of the run from pos on that is all in the upper file or all in
+ * lower data, ovl_inode lock held.
+ */
+size_t ovl_lazy_extent(struct ovl_lazy *lazy, loff_t pos, size_t count,
+		       bool *upper)
+{
+	unsigned long i;
+	loff_t end;
+	bool copied;
+
+	if (pos >= lazy->size) {
+		*upper = true;
+		return count;
+	}
+
+	i = pos >> lazy->shift;
+	copied = test_bit_le(i, lazy->map);
+	if (copied)
+		i = find_next_zero_bit_le(lazy->map, lazy->nr, i);
+	else
+		i = find_next_bit_le(lazy->map, lazy->nr, i);
+
+	if (i < lazy->nr)
+		end = (loff_t)i << lazy->shift;
+	else
+		end = copied ? LLONG_MAX : lazy->size;
+
+	*upper = copied;
+
+	return min_t(loff_t, count, end - pos);
+}
+
+/* Lower data for reads of the chunks not copied up, ovl_inode lock held */
+struct file *ovl_lazy_lower_file(struct dentry *dentry)
+{
+	struct ovl_lazy *lazy = OVL_I(d_inode(dentry))->lazy;
+	struct path datapath;
+	struct file *file;
+
+	if (lazy->lower)
+		return lazy->lower;
+
+	ovl_path_lowerdata(dentry, &datapath);
+	if (WARN_ON(!datapath.dentry))
+		return ERR_PTR(-EIO);
+
+	file = ovl_path_open(&datapath, O_LARGEFILE | O_RDONLY);
+	if (!IS_ERR(file))
+		lazy->lower = file;
+
+	return file;
+}
+
+/* Lazy state of a metacopy upper found on lookup */
+int ovl_lazy_load(struct inode *inode, struct dentry *upper)
+{
+	struct ovl_fs *ofs = OVL_FS(inode->i_sb);
+	struct ovl_lazy_xattr *lx;
+	struct ovl_lazy *lazy = NULL;
+	unsigned long i;
+	ssize_t res;
+	u64 size;
+
+	if (!S_ISREG(inode->i_mode) || ovl_check_metacopy_xattr(ofs, upper) <= 0)
+		return 0;
+
+	res = ovl_do_getxattr(ofs, upper, OVL_XATTR_LAZYCOPY, NULL, 0);
+	if (res == -ENODATA || res == -EOPNOTSUPP)
+		return 0;
+	if (res < 0)
+		return res;
+	if (res < sizeof(*lx))
+		goto invalid;
+
+	lx = kzalloc(res, GFP_KERNEL);
+	if (!lx)
+		return -ENOMEM;
+
+	res = ovl_do_getxattr(ofs, upper, OVL_XATTR_LAZYCOPY, lx, res);
+	if (res < 0) {
+		kfree(lx);
+		return res;
+	}
+
+	size = le64_to_cpu(lx->size);
+	if (res < sizeof(*lx) || lx->version != OVL_LAZY_VERSION ||
+	    lx->shift < OVL_LAZY_MIN_SHIFT || lx->shift > OVL_LAZY_MAX_SHIFT ||
+	    size > MAX_LFS_FILESIZE ||
+	    DIV_ROUND_UP_ULL(size, 1ULL << lx->shift) > OVL_LAZY_MAX_CHUNKS)
+		goto invalid_free;
+
+	lazy = ovl_lazy_alloc(size, lx->shift);
+	if (!lazy) {
+		kfree(lx);
+		return -ENOMEM;
+	}
+	if (res != sizeof(*lx) + DIV_ROUND_UP(lazy->nr, BITS_PER_BYTE))
+		goto invalid_free;
+
+	memcpy(lazy->map, lx->map, res - sizeof(*lx));
+	kfree(lx);
+	for (i = 0; i < lazy->nr; i++)
+		if (test_bit_le(i, lazy->map))
+			lazy->left--;
+
+	OVL_I(inode)->lazy = lazy;
+	ovl_set_flag(OVL_LAZYDATA, inode);
+
+	return 0;
+
+invalid_free:
+	kfree(lazy);
+	kfree(lx);
+invalid:
+	pr_warn_ratelimited("invalid lazycopy xattr (%pd2)\n", upper);
+	return -EIO;
+}
+
+void ovl_lazy_free(struct inode *inode)
+{
+	struct ovl_lazy *lazy = OVL_I(inode)->lazy;
+
+	if (!lazy)
+		return;
+
+	if (lazy->lower)
+		fput(lazy->lower);
+	kfree(lazy);
+	OVL_I(inode)->lazy = NULL;
+}
@@ -154,8 +154,10 @@ static int ovl_open(struct inode *inode, struct file *file)
 	struct file *realfile;
 	int err;
 
-	err = ovl_maybe_copy_up(file_dentry(file), file->f_flags);
-	if (err)
+	err = ovl_maybe_lazy_copy_up(file_dentry(file), file->f_flags);
+	if (!err)
+		err = ovl_maybe_copy_up(file_dentry(file), file->f_flags);
+	if (err < 0)
 		return err;
 
 	/* No longer need these flags, so don't pass them on to underlying fs */
@@ -170,6 +172,42 @@ static int ovl_open(struct inode *inode, struct file *file)
 	return 0;
 }
 
+/*
+ * Mapping the upper file or handing it to the upper fs needs all the data of
+ * a lazy file copied up.
+ */
+static int ovl_lazy_complete(struct file *file, bool mmap_locked)
+{
+	struct dentry *dentry = file_dentry(file);
+	struct super_block *upper_sb;
+	int err;
+
+	if (!ovl_is_lazy(file_inode(file)))
+		return 0;
+
+	if (!mmap_locked) {
+		err = ovl_want_write(dentry);
+		if (!err) {
+			err = ovl_copy_up_with_data(dentry);
+			ovl_drop_write(dentry);
+		}
+		return err;
+	}
+
+	/*
+	 * sb_start_write() under mmap_lock would invert the order of a write
+	 * faulting in its buffer. Opening the upper for write in the copy up
+	 * still gets the mount write access.
+	 */
+	upper_sb = ovl_upper_mnt(OVL_FS(dentry->d_sb))->mnt_sb;
+	if (!sb_start_write_trylock(upper_sb))
+		return -EAGAIN;
+	err = ovl_copy_up_with_data(dentry);
+	sb_end_write(upper_sb);
+
+	return err;
+}
+
 static int ovl_release(struct inode *inode, struct file *file)
 {
 	fput(file->private_data);
@@ -200,6 +238,17 @@ static loff_t ovl_llseek(struct file *file, loff_t offset, int whence)
 	if (ret)
 		return ret;
 
+	/* Holes of the upper file of a lazy file may still be lower data */
+	if (ovl_is_lazy(inode) && (whence == SEEK_DATA || whence == SEEK_HOLE)) {
+		ovl_inode_lock(inode);
+		ret = generic_file_llseek_size(file, offset, whence,
+					       inode->i_sb->s_maxbytes,
+					       i_size_read(inode));
+		ovl_inode_unlock(inode);
+		fdput(real);
+		return ret;
+	}
+
 	/*
 	 * Overlay file f_pos is the master copy that is preserved
 	 * through copy up and modified on read/write, but only real
@@ -281,6 +330,58 @@ static void ovl_aio_rw_complete(struct kiocb *iocb, long res, long res2)
 	orig_iocb->ki_complete(orig_iocb, res, res2);
 }
 
+/*
+ * Read of a lazy file: the chunks copied up come from the upper file, the
+ * others still from lower data. Done synchronously also for aio.
+ */
+static ssize_t ovl_lazy_read_iter(struct file *file, struct file *upperfile,
+				  struct kiocb *iocb, struct iov_iter *iter)
+{
+	struct inode *inode = file_inode(file);
+	rwf_t flags = iocb_to_rw_flags(iocb->ki_flags, OVL_IOCB_MASK);
+	struct ovl_lazy *lazy;
+	struct file *realfile;
+	size_t count, len;
+	ssize_t ret, done = 0;
+	bool upper;
+
+	ret = ovl_inode_lock_interruptible(inode);
+	if (ret)
+		return ret;
+
+	lazy = OVL_I(inode)->lazy;
+	if (!lazy) {
+		/* all copied up meanwhile */
+		ret = vfs_iter_read(upperfile, iter, &iocb->ki_pos, flags);
+		goto out_unlock;
+	}
+
+	while (iov_iter_count(iter)) {
+		count = iov_iter_count(iter);
+		len = ovl_lazy_extent(lazy, iocb->ki_pos, count, &upper);
+		realfile = upperfile;
+		if (!upper)
+			realfile = ovl_lazy_lower_file(file_dentry(file));
+		if (IS_ERR(realfile)) {
+			ret = PTR_ERR(realfile);
+			break;
+		}
+
+		iov_iter_truncate(iter, len);
+		ret = vfs_iter_read(realfile, iter, &iocb->ki_pos, flags);
+		iov_iter_reexpand(iter, count - max_t(ssize_t, ret, 0));
+		if (ret <= 0)
+			break;
+		done += ret;
+		if (ret < len)
+			break;
+	}
+out_unlock:
+	ovl_inode_unlock(inode);
+
+	return done ?: ret;
+}
+
 static ssize_t ovl_read_iter(struct kiocb *iocb, struct iov_iter *iter)
 {
 	struct file *file = iocb->ki_filp;
@@ -302,7 +403,9 @@ static ssize_t ovl_read_iter(struct kiocb *iocb, struct iov_iter *iter)
 		goto out_fdput;
 
 	old_cred = ovl_override_creds(file_inode(file)->i_sb);
-	if (is_sync_kiocb(iocb)) {
+	if (ovl_is_lazy(file_inode(file))) {
+		ret = ovl_lazy_read_iter(file, real.file, iocb, iter);
+	} else if (is_sync_kiocb(iocb)) {
 		ret = vfs_iter_read(real.file, iter, &iocb->ki_pos,
 				    iocb_to_rw_flags(iocb->ki_flags,
 						     OVL_IOCB_MASK));
@@ -364,6 +467,16 @@ static ssize_t ovl_write_iter(struct kiocb *iocb, struct iov_iter *iter)
 	     !real.file->f_mapping->a_ops->direct_IO))
 		goto out_fdput;
 
+	if (ovl_is_lazy(inode)) {
+		loff_t pos = ifl & IOCB_APPEND ? i_size_read(inode) :
+						 iocb->ki_pos;
+
+		ret = ovl_lazy_copy_up_range(file_dentry(file), pos,
+					     pos + iov_iter_count(iter));
+		if (ret)
+			goto out_fdput;
+	}
+
 	if (!ovl_should_sync(OVL_FS(inode->i_sb)))
 		ifl &= ~(IOCB_DSYNC | IOCB_SYNC);
 
@@ -438,6 +551,15 @@ static ssize_t ovl_splice_write(struct pipe_inode_info *pipe, struct file *out,
 	if (ret)
 		goto out_unlock;
 
+	if (ovl_is_lazy(inode)) {
+		ret = ovl_lazy_copy_up_range(file_dentry(out), *ppos,
+					     *ppos + len);
+		if (ret) {
+			fdput(real);
+			goto out_unlock;
+		}
+	}
+
 	old_cred = ovl_override_creds(inode->i_sb);
 	file_start_write(real.file);
 
@@ -490,6 +612,10 @@ static int ovl_mmap(struct file *file, struct vm_area_struct *vma)
 	if (!realfile->f_op->mmap)
 		return -ENODEV;
 
+	ret = ovl_lazy_complete(file, true);
+	if (ret)
+		return ret;
+
 	if (WARN_ON(file != vma->vm_file))
 		return -EIO;
 
@@ -519,6 +645,10 @@ static long ovl_fallocate(struct file *file, int mode, loff_t offset, loff_t len
 	const struct cred *old_cred;
 	int ret;
 
+	ret = ovl_lazy_complete(file, false);
+	if (ret)
+		return ret;
+
 	ret = ovl_real_fdget(file, &real);
 	if (ret)
 		return ret;
@@ -675,6 +805,11 @@ static loff_t ovl_copyfile(struct file *file_in, loff_t pos_in,
 	const struct cred *old_cred;
 	loff_t ret;
 
+	ret = ovl_lazy_complete(file_out, false) ?:
+	      ovl_lazy_complete(file_in, false);
+	if (ret)
+		return ret;
+
 	ret = ovl_real_fdget(file_out, &real_out);
 	if (ret)
 		return ret;
@@ -1024,6 +1024,16 @@ struct inode *ovl_get_inode(struct super_block *sb,
 	if (oip->index)
 		ovl_set_flag(OVL_INDEX, inode);
 
+	if (upperdentry && oip->lowerpath) {
+		err = ovl_lazy_load(inode, upperdentry);
+		if (err) {
+			/* upperdentry is put by the caller on error */
+			dget(upperdentry);
+			iget_failed(inode);
+			goto out_err;
+		}
+	}
+
 	OVL_I(inode)->redirect = oip->redirect;
 
 	if (bylower)
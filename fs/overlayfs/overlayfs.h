@@ -32,6 +32,7 @@ enum ovl_xattr {
 	OVL_XATTR_NLINK,
 	OVL_XATTR_UPPER,
 	OVL_XATTR_METACOPY,
+	OVL_XATTR_LAZYCOPY,
 };
 
 enum ovl_inode_flag {
@@ -41,6 +42,8 @@ enum ovl_inode_flag {
 	OVL_WHITEOUTS,
 	OVL_INDEX,
 	OVL_UPPERDATA,
+	/* Metacopy upper with part of the data copied up, see ovl_lazy */
+	OVL_LAZYDATA,
 	/* Inode number will remain constant over copy up. */
 	OVL_CONST_INO,
 };
@@ -339,6 +342,12 @@ static inline bool ovl_test_flag(unsigned long flag, struct inode *inode)
 	return test_bit(flag, &OVL_I(inode)->flags);
 }
 
+/* Data partly in the upper file, partly still in lower data */
+static inline bool ovl_is_lazy(struct inode *inode)
+{
+	return ovl_test_flag(OVL_LAZYDATA, inode);
+}
+
 static inline bool ovl_is_impuredir(struct super_block *sb,
 				    struct dentry *dentry)
 {
@@ -540,6 +549,13 @@ long ovl_compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg);
 int ovl_copy_up(struct dentry *dentry);
 int ovl_copy_up_with_data(struct dentry *dentry);
 int ovl_maybe_copy_up(struct dentry *dentry, int flags);
+int ovl_maybe_lazy_copy_up(struct dentry *dentry, int flags);
+int ovl_lazy_copy_up_range(struct dentry *dentry, loff_t start, loff_t end);
+size_t ovl_lazy_extent(struct ovl_lazy *lazy, loff_t pos, size_t count,
+		       bool *upper);
+struct file *ovl_lazy_lower_file(struct dentry *dentry);
+int ovl_lazy_load(struct inode *inode, struct dentry *upper);
+void ovl_lazy_free(struct inode *inode);
 int ovl_copy_xattr(struct super_block *sb, struct dentry *old,
 		   struct dentry *new);
 int ovl_set_attr(struct dentry *upper, struct kstat *stat);
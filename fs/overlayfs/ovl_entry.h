@@ -118,6 +118,20 @@ static inline struct ovl_entry *OVL_E(struct dentry *dentry)
 	return (struct ovl_entry *) dentry->d_fsdata;
 }
 
+/*
+ * Lazy data copy up of a metacopy upper: the data is copied up in chunks on
+ * the first write to each chunk instead of all of it on open for write.
+ * The copied chunks are kept in the "lazycopy" xattr of the upper.
+ */
+struct ovl_lazy {
+	loff_t size;			/* lower data size */
+	unsigned int shift;		/* chunk size order */
+	unsigned long nr;		/* chunks of lower data */
+	unsigned long left;		/* chunks not copied up yet */
+	struct file *lower;		/* lower data, opened on first read */
+	unsigned long map[];		/* copied up chunks, le bit order */
+};
+
 struct ovl_inode {
 	union {
 		struct ovl_dir_cache *cache;	/* directory */
@@ -129,6 +143,7 @@ struct ovl_inode {
 	struct inode vfs_inode;
 	struct dentry *__upperdentry;
 	struct inode *lower;
+	struct ovl_lazy *lazy;
 
 	/* synchronize copy up and more */
 	struct mutex lock;
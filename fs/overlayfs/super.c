@@ -192,6 +192,7 @@ static struct inode *ovl_alloc_inode(struct super_block *sb)
 	oi->__upperdentry = NULL;
 	oi->lower = NULL;
 	oi->lowerdata = NULL;
+	oi->lazy = NULL;
 	mutex_init(&oi->lock);
 
 	return &oi->vfs_inode;
@@ -216,6 +217,7 @@ static void ovl_destroy_inode(struct inode *inode)
 		ovl_dir_cache_free(inode);
 	else
 		iput(oi->lowerdata);
+	ovl_lazy_free(inode);
 }
 
 static void ovl_free_fs(struct ovl_fs *ofs)
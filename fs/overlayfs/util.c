@@ -272,7 +272,7 @@ struct inode *ovl_inode_realdata(struct inode *inode)
 	struct inode *upperinode;
 
 	upperinode = ovl_inode_upper(inode);
-	if (upperinode && ovl_has_upperdata(inode))
+	if (upperinode && (ovl_has_upperdata(inode) || ovl_is_lazy(inode)))
 		return upperinode;
 
 	return ovl_inode_lowerdata(inode);
@@ -590,6 +590,7 @@ bool ovl_check_dir_xattr(struct super_block *sb, struct dentry *dentry,
 #define OVL_XATTR_NLINK_POSTFIX		"nlink"
 #define OVL_XATTR_UPPER_POSTFIX		"upper"
 #define OVL_XATTR_METACOPY_POSTFIX	"metacopy"
+#define OVL_XATTR_LAZYCOPY_POSTFIX	"lazycopy"
 
 #define OVL_XATTR_TAB_ENTRY(x) \
 	[x] = OVL_XATTR_PREFIX x ## _POSTFIX
@@ -602,6 +603,7 @@ const char *ovl_xattr_table[] = {
 	OVL_XATTR_TAB_ENTRY(OVL_XATTR_NLINK),
 	OVL_XATTR_TAB_ENTRY(OVL_XATTR_UPPER),
 	OVL_XATTR_TAB_ENTRY(OVL_XATTR_METACOPY),
+	OVL_XATTR_TAB_ENTRY(OVL_XATTR_LAZYCOPY),
 };
 
 int ovl_check_setxattr(struct dentry *dentry, struct dentry *upperdentry,
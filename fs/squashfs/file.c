@@ -34,11 +34,13 @@
 #include <linux/string.h>
 #include <linux/pagemap.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
 #include "squashfs_fs_i.h"
 #include "squashfs.h"
+#include "page_actor.h"
 
 /*
  * Locate cache slot in range [offset, index] for specified inode.  If
@@ -494,7 +496,209 @@ static int squashfs_readpage(struct file *file, struct page *page)
 	return 0;
 }
 
+#ifdef CONFIG_SQUASHFS_FILE_DIRECT
+/*
+ * Readahead decompresses whole datablocks straight into the page cache
+ * pages of the request.  Up to SQUASHFS_RA_BLOCKS datablocks are gathered
+ * per batch, all but the last one are read and decompressed from
+ * squashfs_ra_wq so that their I/O and decompression run on the other
+ * CPUs while the caller does the last one.  Datablocks not fully covered
+ * by the request, sparse blocks and the fragment are left to readpage.
+ */
+#define SQUASHFS_RA_BLOCKS	8
+
+static struct workqueue_struct *squashfs_ra_wq;
+
+struct squashfs_ra_block {
+	struct work_struct work;
+	struct super_block *sb;
+	struct page **page;
+	int pages;
+	u64 block;
+	int bsize;
+	int expected;
+	int res;
+};
+
+static void squashfs_ra_read(struct squashfs_ra_block *rb)
+{
+	struct squashfs_page_actor *actor;
+
+	rb->res = -ENOMEM;
+	actor = squashfs_page_actor_init_special(rb->page, rb->pages, 0);
+	if (actor == NULL)
+		return;
+
+	rb->res = squashfs_read_data(rb->sb, rb->block, rb->bsize, NULL, actor);
+	kfree(actor);
+}
+
+static void squashfs_ra_work(struct work_struct *work)
+{
+	squashfs_ra_read(container_of(work, struct squashfs_ra_block, work));
+}
+
+static void squashfs_ra_release(struct squashfs_ra_block *rb, bool uptodate)
+{
+	int i;
+
+	for (i = 0; i < rb->pages; i++) {
+		if (uptodate) {
+			flush_dcache_page(rb->page[i]);
+			SetPageUptodate(rb->page[i]);
+		}
+		unlock_page(rb->page[i]);
+		put_page(rb->page[i]);
+	}
+}
+
+static void squashfs_ra_finish(struct squashfs_ra_block *rb)
+{
+	int bytes;
+	void *pageaddr;
+
+	if (rb->res != rb->expected) {
+		/* leave the pages !uptodate, readpage retries and reports */
+		squashfs_ra_release(rb, false);
+		return;
+	}
+
+	/* Last page may have trailing bytes not filled */
+	bytes = rb->res % PAGE_SIZE;
+	if (bytes) {
+		pageaddr = kmap_atomic(rb->page[rb->pages - 1]);
+		memset(pageaddr + bytes, 0, PAGE_SIZE - bytes);
+		kunmap_atomic(pageaddr);
+	}
+
+	squashfs_ra_release(rb, true);
+}
+
+static void squashfs_ra_batch(struct squashfs_ra_block *rb, int nr)
+{
+	bool parallel = squashfs_ra_wq && num_online_cpus() > 1;
+	int i;
+
+	for (i = 0; i < nr - 1; i++) {
+		if (parallel) {
+			INIT_WORK(&rb[i].work, squashfs_ra_work);
+			queue_work(squashfs_ra_wq, &rb[i].work);
+		} else {
+			squashfs_ra_read(&rb[i]);
+		}
+	}
+	squashfs_ra_read(&rb[nr - 1]);
+
+	for (i = 0; i < nr; i++) {
+		if (parallel && i < nr - 1)
+			flush_work(&rb[i].work);
+		squashfs_ra_finish(&rb[i]);
+	}
+}
+
+static void squashfs_readahead(struct readahead_control *ractl)
+{
+	struct inode *inode = ractl->mapping->host;
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	int shift = msblk->block_log - PAGE_SHIFT;
+	int max_pages = 1 << shift;
+	loff_t i_size = i_size_read(inode);
+	int file_end = i_size >> msblk->block_log;
+	pgoff_t last_page = (i_size - 1) >> PAGE_SHIFT;
+	struct squashfs_ra_block *rb;
+	struct page *page;
+	int i, nr = 0;
+
+	if (i_size == 0)
+		return;
+
+	rb = kcalloc(SQUASHFS_RA_BLOCKS, sizeof(*rb), GFP_KERNEL);
+	if (rb == NULL)
+		return;
+
+	for (i = 0; i < SQUASHFS_RA_BLOCKS; i++) {
+		rb[i].page = kmalloc_array(max_pages, sizeof(void *),
+					   GFP_KERNEL);
+		if (rb[i].page == NULL)
+			goto out;
+	}
+
+	page = readahead_page(ractl);
+	while (page) {
+		struct squashfs_ra_block *cur = &rb[nr];
+		int index = page->index >> shift;
+		pgoff_t first = (pgoff_t)index << shift;
+		int pages = page->index > last_page ? 0 :
+			min_t(pgoff_t, max_pages, last_page - first + 1);
+
+		/* Gather the consecutive pages of this datablock */
+		cur->pages = 0;
+		do {
+			cur->page[cur->pages++] = page;
+			page = readahead_page(ractl);
+		} while (page && cur->pages < pages &&
+			 page->index == first + cur->pages);
+
+		if (cur->page[0]->index != first || cur->pages != pages)
+			goto skip;
+
+		if (index == file_end && squashfs_i(inode)->fragment_block !=
+						SQUASHFS_INVALID_BLK)
+			goto skip;
+
+		cur->bsize = read_blocklist(inode, index, &cur->block);
+		if (cur->bsize <= 0)
+			goto skip;
+
+		cur->sb = inode->i_sb;
+		cur->expected = index == file_end ?
+				(i_size & (msblk->block_size - 1)) :
+				 msblk->block_size;
+
+		if (++nr == SQUASHFS_RA_BLOCKS) {
+			squashfs_ra_batch(rb, nr);
+			nr = 0;
+		}
+		continue;
+
+skip:
+		squashfs_ra_release(cur, false);
+	}
+
+	if (nr)
+		squashfs_ra_batch(rb, nr);
+
+out:
+	for (i = 0; i < SQUASHFS_RA_BLOCKS; i++)
+		kfree(rb[i].page);
+	kfree(rb);
+}
+
+int __init squashfs_init_readahead(void)
+{
+	squashfs_ra_wq = alloc_workqueue("squashfs_ra",
+					 WQ_UNBOUND | WQ_HIGHPRI, 0);
+	return squashfs_ra_wq ? 0 : -ENOMEM;
+}
+
+void squashfs_destroy_readahead(void)
+{
+	destroy_workqueue(squashfs_ra_wq);
+}
+#else
+int __init squashfs_init_readahead(void)
+{
+	return 0;
+}
+
+void squashfs_destroy_readahead(void)
+{
+}
+#endif
 
 const struct address_space_operations squashfs_aops = {
-	.readpage = squashfs_readpage
+	.readpage = squashfs_readpage,
+#ifdef CONFIG_SQUASHFS_FILE_DIRECT
+	.readahead = squashfs_readahead,
+#endif
 };
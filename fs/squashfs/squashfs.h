@@ -57,6 +57,8 @@ extern __le64 *squashfs_read_fragment_index_table(struct super_block *,
 void squashfs_fill_page(struct page *, struct squashfs_cache_entry *, int, int);
 void squashfs_copy_cache(struct page *, struct squashfs_cache_entry *, int,
 				int);
+extern int squashfs_init_readahead(void);
+extern void squashfs_destroy_readahead(void);
 
 /* file_xxx.c */
 extern int squashfs_readpage_block(struct page *, u64, int, int);
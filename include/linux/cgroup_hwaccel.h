@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+
+#ifndef _CGROUP_HWACCEL_H
+#define _CGROUP_HWACCEL_H
+
+#include <linux/types.h>
+
+enum hwaccel_type {
+	HWACCEL_MPP,
+	HWACCEL_RGA,
+	HWACCEL_NPU,
+	HWACCEL_TYPE_MAX,
+};
+
+struct hwaccel_cgroup;
+
+#ifdef CONFIG_CGROUP_HWACCEL
+
+/*
+ * A job scheduler takes the cgroup of the submitter when a job is queued
+ * and drops it when the job is freed. In between it asks whether the job
+ * may run, which of two jobs goes first, and charges the hardware time
+ * once the job is done. All but get and put may be called from irq.
+ */
+struct hwaccel_cgroup *hwaccel_cgroup_get(void);
+void hwaccel_cgroup_put(struct hwaccel_cgroup *hwcg);
+void hwaccel_cgroup_charge(struct hwaccel_cgroup *hwcg,
+			   enum hwaccel_type type, u64 ns);
+u64 hwaccel_cgroup_throttled(struct hwaccel_cgroup *hwcg,
+			     enum hwaccel_type type);
+int hwaccel_cgroup_cmp(struct hwaccel_cgroup *a, struct hwaccel_cgroup *b,
+		       enum hwaccel_type type);
+
+#else
+
+static inline struct hwaccel_cgroup *hwaccel_cgroup_get(void)
+{
+	return NULL;
+}
+
+static inline void hwaccel_cgroup_put(struct hwaccel_cgroup *hwcg) {}
+
+static inline void hwaccel_cgroup_charge(struct hwaccel_cgroup *hwcg,
+					 enum hwaccel_type type, u64 ns) {}
+
+static inline u64 hwaccel_cgroup_throttled(struct hwaccel_cgroup *hwcg,
+					   enum hwaccel_type type)
+{
+	return 0;
+}
+
+static inline int hwaccel_cgroup_cmp(struct hwaccel_cgroup *a,
+				     struct hwaccel_cgroup *b,
+				     enum hwaccel_type type)
+{
+	return 0;
+}
+
+#endif /* CONFIG_CGROUP_HWACCEL */
+
+#endif /* _CGROUP_HWACCEL_H */
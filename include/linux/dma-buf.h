@@ -26,6 +26,8 @@
 struct device;
 struct dma_buf;
 struct dma_buf_attachment;
+struct notifier_block;
+struct seq_file;
 
 /**
  * struct dma_buf_ops - operations possible on struct dma_buf
@@ -444,6 +446,11 @@ struct dma_buf {
 	void *dtor_data;
 	struct mutex cache_lock;
 #endif
+#if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
+	/* accounting of the exporting process and of the exporter */
+	struct dma_buf_acct *acct_proc;
+	struct dma_buf_acct *acct_exp;
+#endif
 
 	ANDROID_KABI_RESERVE(1);
 	ANDROID_KABI_RESERVE(2);
@@ -662,14 +669,51 @@ static inline void dma_buf_set_destructor(struct dma_buf *dmabuf,
 }
 #endif
 
+/*
+ * struct dma_buf_acct - live dmabuf memory of one process or exporter
+ * @node: entry in the process or the exporter list
+ * @tgid: the process, 0 for an exporter
+ * @name: comm of the process or exp_name of the exporter
+ * @size: bytes of the dmabufs alive
+ * @peak: most bytes alive at once
+ * @count: dmabufs alive
+ */
+struct dma_buf_acct {
+	struct list_head node;
+	pid_t tgid;
+	char name[TASK_COMM_LEN];
+	size_t size;
+	size_t peak;
+	unsigned int count;
+};
+
+/* budget notifier action, data is the total size */
+#define DMA_BUF_BUDGET_EXCEEDED		1
+
 #if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
 void dma_buf_reset_peak_size(void);
 size_t dma_buf_get_peak_size(void);
 size_t dma_buf_get_total_size(void);
+void dma_buf_show_acct(struct seq_file *s, bool exporters);
+void dma_buf_set_budget(size_t budget);
+size_t dma_buf_get_budget(void);
+int dma_buf_register_budget_notifier(struct notifier_block *nb);
+int dma_buf_unregister_budget_notifier(struct notifier_block *nb);
 #else
 static inline void dma_buf_reset_peak_size(void) {}
 static inline size_t dma_buf_get_peak_size(void) { return 0; }
 static inline size_t dma_buf_get_total_size(void) { return 0; }
+static inline void dma_buf_show_acct(struct seq_file *s, bool exporters) {}
+static inline void dma_buf_set_budget(size_t budget) {}
+static inline size_t dma_buf_get_budget(void) { return 0; }
+static inline int dma_buf_register_budget_notifier(struct notifier_block *nb)
+{
+	return -EOPNOTSUPP;
+}
+static inline int dma_buf_unregister_budget_notifier(struct notifier_block *nb)
+{
+	return 0;
+}
 #endif
 
 #endif /* __DMA_BUF_H__ */
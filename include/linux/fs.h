@@ -1874,6 +1874,7 @@ struct dir_context {
 #define COPY_FILE_SPLICE		(1 << 0)
 
 struct iov_iter;
+struct io_uring_cmd;
 
 struct file_operations {
 	struct module *owner;
@@ -1916,7 +1917,8 @@ struct file_operations {
 				   loff_t len, unsigned int remap_flags);
 	int (*fadvise)(struct file *, loff_t, loff_t, int);
 
-	ANDROID_KABI_RESERVE(1);
+	ANDROID_KABI_USE(1, int (*uring_cmd)(struct io_uring_cmd *ioucmd,
+					     unsigned int issue_flags));
 	ANDROID_KABI_RESERVE(2);
 	ANDROID_KABI_RESERVE(3);
 	ANDROID_KABI_RESERVE(4);
@@ -67,7 +67,34 @@ struct io_uring_task {
 #endif	/* ANDROID ABI HACK */
 
 
+enum io_uring_cmd_flags {
+	IO_URING_F_NONBLOCK		= 1,
+	IO_URING_F_COMPLETE_DEFER	= 2,
+	/* the ring was set up by a compat task */
+	IO_URING_F_COMPAT		= 4,
+};
+
+/*
+ * IORING_OP_URING_CMD as seen by file_operations->uring_cmd(). cmd points
+ * to IORING_URING_CMD_SIZE bytes of command data, valid until completion.
+ * ->uring_cmd() returns the result, -EAGAIN with IO_URING_F_NONBLOCK to be
+ * called again from an io-wq worker where it may block, or -EIOCBQUEUED
+ * and completes it later with io_uring_cmd_done().
+ */
+struct io_uring_cmd {
+	struct file	*file;
+	const void	*cmd;
+	/* callback to defer completions to task context */
+	void (*task_work_cb)(struct io_uring_cmd *cmd);
+	u32		cmd_op;
+	u32		flags;
+	u8		pdu[32];	/* available inline for free use */
+};
+
 #if defined(CONFIG_IO_URING)
+void io_uring_cmd_done(struct io_uring_cmd *cmd, ssize_t ret);
+void io_uring_cmd_complete_in_task(struct io_uring_cmd *ioucmd,
+			void (*task_work_cb)(struct io_uring_cmd *));
 struct sock *io_uring_get_socket(struct file *file);
 void __io_uring_cancel(bool cancel_all);
 void __io_uring_free(struct task_struct *tsk);
@@ -88,6 +115,13 @@ static inline void io_uring_free(struct task_struct *tsk)
 		__io_uring_free(tsk);
 }
 #else
+static inline void io_uring_cmd_done(struct io_uring_cmd *cmd, ssize_t ret)
+{
+}
+static inline void io_uring_cmd_complete_in_task(struct io_uring_cmd *ioucmd,
+			void (*task_work_cb)(struct io_uring_cmd *))
+{
+}
 static inline struct sock *io_uring_get_socket(struct file *file)
 {
 	return NULL;
@@ -28,6 +28,8 @@
 #define IMEI_ID				15
 #define LAN_RGMII_DL_ID			16
 #define EINK_VCOM_ID			17
+#define MMC_TUNING_ID			18
+#define PVTM_CACHE_ID			19
 
 #if IS_REACHABLE(CONFIG_ROCKCHIP_VENDOR_STORAGE)
 int rk_vendor_read(u32 id, void *pbuf, u32 size);
@@ -13,6 +13,10 @@ enum decom_mod {
 /* The high 16 bits indicate whether decompression is non-blocking */
 #define DECOM_NOBLOCKING		(0x00010000)
 
+/* room rk_decom_lz4_block() needs around a raw lz4 block for the frame */
+#define RK_DECOM_LZ4_HEAD		11
+#define RK_DECOM_LZ4_TAIL		4
+
 static inline u32 rk_get_decom_mode(u32 mode)
 {
 	return mode & 0x0000ffff;
@@ -27,6 +31,14 @@ static inline bool rk_get_noblocking_flag(u32 mode)
 int rk_decom_start(u32 mode, phys_addr_t src, phys_addr_t dst, u32 dst_max_size);
 /* timeout in seconds */
 int rk_decom_wait_done(u32 timeout, u64 *decom_len);
+/* wait for dst range of current decompress written, timeout in ms */
+int rk_decom_wait_range(phys_addr_t start, size_t len, u32 timeout_ms);
+/* serialized decompress between physically contiguous kernel buffers */
+int rk_decom_run(u32 mode, void *src, size_t src_len, void *dst, size_t dst_len,
+		 u64 *decom_len);
+/* raw lz4 block of len bytes at buf + RK_DECOM_LZ4_HEAD */
+int rk_decom_lz4_block(void *buf, size_t len, void *dst, size_t dst_len,
+		       u64 *decom_len);
 #else
 static inline int rk_decom_start(u32 mode, phys_addr_t src, phys_addr_t dst, u32 dst_max_size)
 {
@@ -37,6 +49,23 @@ static inline int rk_decom_wait_done(u32 timeout, u64 *decom_len)
 {
 	return -EINVAL;
 }
+
+static inline int rk_decom_wait_range(phys_addr_t start, size_t len, u32 timeout_ms)
+{
+	return 0;
+}
+
+static inline int rk_decom_run(u32 mode, void *src, size_t src_len, void *dst,
+			       size_t dst_len, u64 *decom_len)
+{
+	return -ENODEV;
+}
+
+static inline int rk_decom_lz4_block(void *buf, size_t len, void *dst,
+				     size_t dst_len, u64 *decom_len)
+{
+	return -ENODEV;
+}
 #endif
 
 #endif
@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_FRAME_POOL_H
+#define __SOC_ROCKCHIP_FRAME_POOL_H
+
+#include <linux/dma-buf.h>
+#include <linux/err.h>
+
+#if IS_REACHABLE(CONFIG_ROCKCHIP_FRAME_POOL)
+struct dma_buf *rk_frame_pool_get_scratch(size_t size);
+void rk_frame_pool_put_scratch(struct dma_buf *dbuf);
+#else
+static inline struct dma_buf *rk_frame_pool_get_scratch(size_t size)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline void rk_frame_pool_put_scratch(struct dma_buf *dbuf)
+{
+}
+#endif
+
+#endif
@@ -5,5 +5,7 @@
 #define _ROCKCHIP_THUNDERBOOT_CRYPTO_
 
 int rk_tb_sha256(dma_addr_t data, size_t data_len, void *user_data);
+int rk_tb_sha256_start(void *user_data);
+int rk_tb_sha256_update(dma_addr_t data, size_t data_len, bool last);
 
 #endif
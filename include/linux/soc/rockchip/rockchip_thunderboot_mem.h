@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/* Copyright (c) 2026 Rockchip Electronics Co., Ltd */
+
+#ifndef _ROCKCHIP_THUNDERBOOT_MEM_H
+#define _ROCKCHIP_THUNDERBOOT_MEM_H
+
+#include <linux/io.h>
+#include <linux/mm.h>
+#include <linux/types.h>
+
+/*
+ * rk_tb_mem_release - give a thunderboot reservation to the page allocator
+ *
+ * @name: owner of the memory, for the report in /proc/rk_tb_mem
+ * @start: physical start, the pages only partly in the range are kept
+ * @size: size in bytes
+ *
+ * called by each thunderboot client once it is done with its buffers,
+ * returns the bytes freed.
+ */
+#ifdef CONFIG_ROCKCHIP_THUNDER_BOOT
+unsigned long rk_tb_mem_release(const char *name, phys_addr_t start,
+				phys_addr_t size);
+#else
+static inline unsigned long rk_tb_mem_release(const char *name,
+					      phys_addr_t start,
+					      phys_addr_t size)
+{
+	return free_reserved_area(phys_to_virt(start),
+				  phys_to_virt(start) + size, -1, name) <<
+	       PAGE_SHIFT;
+}
+#endif
+#endif
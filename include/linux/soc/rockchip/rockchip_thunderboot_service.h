@@ -4,10 +4,40 @@
 #ifndef _ROCKCHIP_THUNDERBOOT_SERVICE_H
 #define _ROCKCHIP_THUNDERBOOT_SERVICE_H
 
+#include <linux/bits.h>
+#include <linux/list.h>
+
+enum rk_tb_client_id {
+	RK_TB_CLIENT_NONE,
+	RK_TB_CLIENT_I2C,
+	RK_TB_CLIENT_ISP,
+	RK_TB_CLIENT_CIF,
+	RK_TB_CLIENT_VENC,
+	RK_TB_CLIENT_STORAGE,
+	RK_TB_CLIENT_MAX,
+};
+
+/* cb run on async domain after clients of deps done */
+#define RK_TB_CLIENT_ASYNC		BIT(0)
+
+#define RK_TB_CLIENT_DEP(id)		BIT(id)
+
+/*
+ * struct rk_tb_client - callback on mcu done
+ *
+ * @name: optional, name of client for run time record
+ * @id: optional, enum rk_tb_client_id for others to depend on
+ * @deps: mask of RK_TB_CLIENT_DEP(id) waited before cb, async only
+ * @flags: RK_TB_CLIENT_ASYNC or 0 to run in order of register
+ */
 struct rk_tb_client {
 	struct list_head node;
 	void *data;
 	void (*cb)(void *data);
+	const char *name;
+	u32 id;
+	u32 deps;
+	u32 flags;
 };
 
 #ifdef CONFIG_ROCKCHIP_THUNDER_BOOT_SERVICE
@@ -129,6 +129,8 @@ struct stmmac_rxq_cfg {
 	u8 pkt_route;
 	bool use_prio;
 	u32 prio;
+	bool use_cpu;
+	u32 cpu;
 };
 
 struct stmmac_txq_cfg {
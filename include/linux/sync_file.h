@@ -58,5 +58,6 @@ struct sync_file {
 struct sync_file *sync_file_create(struct dma_fence *fence);
 struct dma_fence *sync_file_get_fence(int fd);
 char *sync_file_get_name(struct sync_file *sync_file, char *buf, int len);
+struct dma_fence *dma_fence_merge(struct dma_fence *a, struct dma_fence *b);
 
 #endif /* _LINUX_SYNC_H */
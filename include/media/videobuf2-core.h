@@ -45,6 +45,7 @@ enum vb2_memory {
 
 struct vb2_fileio_data;
 struct vb2_threadio_data;
+struct vb2_dmabuf_cache;
 
 /**
  * struct vb2_mem_ops - memory handling/memory allocator operations.
@@ -561,6 +562,8 @@ struct vb2_buf_ops {
  *		when a buffer with the %V4L2_BUF_FLAG_LAST is dequeued.
  * @fileio:	file io emulator internal data, used only if emulator is active
  * @threadio:	thread io internal data, used only if thread is active
+ * @dmabuf_cache: dmabuf attachments kept mapped after their plane moved to
+ *		another dmabuf, used only for %VB2_MEMORY_DMABUF
  * @name:	queue name, used for logging purpose. Initialized automatically
  *		if left empty by drivers.
  */
@@ -623,6 +626,7 @@ struct vb2_queue {
 
 	struct vb2_fileio_data		*fileio;
 	struct vb2_threadio_data	*threadio;
+	struct vb2_dmabuf_cache		*dmabuf_cache;
 
 	char				name[32];
 
@@ -3,6 +3,7 @@
 #define __SOC_ROCKCHIP_PM_DOMAINS_H
 
 #include <linux/errno.h>
+#include <linux/ktime.h>
 
 struct device;
 
@@ -11,6 +12,7 @@ int rockchip_pmu_pd_on(struct device *dev);
 int rockchip_pmu_pd_off(struct device *dev);
 bool rockchip_pmu_pd_is_on(struct device *dev);
 int rockchip_pmu_idle_request(struct device *dev, bool idle);
+int rockchip_pmu_pd_prewarm(struct device *dev, ktime_t expires);
 int rockchip_save_qos(struct device *dev);
 int rockchip_restore_qos(struct device *dev);
 void rockchip_dump_pmu(void);
@@ -35,6 +37,11 @@ static inline int rockchip_pmu_idle_request(struct device *dev, bool idle)
 	return -ENOTSUPP;
 }
 
+static inline int rockchip_pmu_pd_prewarm(struct device *dev, ktime_t expires)
+{
+	return -ENOTSUPP;
+}
+
 static inline int rockchip_save_qos(struct device *dev)
 {
 	return -ENOTSUPP;
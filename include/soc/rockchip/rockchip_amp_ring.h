@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_AMP_RING_H
+#define __SOC_ROCKCHIP_AMP_RING_H
+
+#include <linux/errno.h>
+#include <linux/types.h>
+
+/*
+ * shared memory rings between linux and the rtos core, one per direction.
+ * each ring is single producer single consumer and lock free: the producer
+ * only writes head, the consumer only writes tail and kick. a doorbell
+ * goes over the mailbox only when the consumer has set kick, i.e. it has
+ * drained the ring and waits, so a busy ring costs no interrupt at all.
+ *
+ * layout of the memory-region:
+ *   0x00                   struct rk_amp_ring_ctrl, linux to rtos
+ *   0x40                   struct rk_amp_ring_ctrl, rtos to linux
+ *   RK_AMP_RING_HDR        linux to rtos slots, num * slot_size bytes
+ *   following              rtos to linux slots, num * slot_size bytes
+ *
+ * a slot starts with struct rk_amp_ring_slot followed by len bytes.
+ */
+#define RK_AMP_RING_MAGIC	0x524d4152	/* "RAMR" */
+#define RK_AMP_RING_HDR		0x100
+
+/* mailbox cmd of the doorbell, data is the producer head */
+#define RK_AMP_RING_CMD_KICK	0x52410001
+/* linux has (re)initialized both rings */
+#define RK_AMP_RING_CMD_INIT	0x52410002
+
+struct rk_amp_ring_ctrl {
+	u32 magic;
+	u32 num;		/* slots, power of two */
+	u32 slot_size;
+	u32 head;
+	u32 tail;
+	u32 kick;
+	u32 drops;		/* messages the producer could not queue */
+	u32 reserved[9];
+};
+
+struct rk_amp_ring_slot {
+	u16 type;
+	u16 len;
+	u32 seq;
+	u8 data[];
+};
+
+enum rk_amp_ring_type {
+	RK_AMP_RING_TYPE_NONE,
+	RK_AMP_RING_TYPE_AE_STATS,
+	RK_AMP_RING_TYPE_AE_RESULT,
+	RK_AMP_RING_TYPE_FRAME_META,
+	RK_AMP_RING_TYPE_PIR,
+	RK_AMP_RING_TYPE_RADAR,
+	RK_AMP_RING_TYPE_MAX = 32,
+};
+
+/* called from the doorbell interrupt, must not sleep */
+typedef void (*rk_amp_ring_rx_cb)(void *data, u32 type, const void *msg, u32 len);
+
+#if IS_REACHABLE(CONFIG_ROCKCHIP_AMP_RING)
+int rk_amp_ring_register(u32 type, rk_amp_ring_rx_cb cb, void *data);
+void rk_amp_ring_unregister(u32 type);
+int rk_amp_ring_send(u32 type, const void *msg, u32 len);
+#else
+static inline int rk_amp_ring_register(u32 type, rk_amp_ring_rx_cb cb, void *data)
+{
+	return -ENODEV;
+}
+
+static inline void rk_amp_ring_unregister(u32 type)
+{
+}
+
+static inline int rk_amp_ring_send(u32 type, const void *msg, u32 len)
+{
+	return -ENODEV;
+}
+#endif
+
+#endif
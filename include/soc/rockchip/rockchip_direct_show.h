@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: (GPL-2.0+ OR MIT) */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_DIRECT_SHOW_H
+#define __SOC_ROCKCHIP_DIRECT_SHOW_H
+
+#include <linux/dma-buf.h>
+#include <linux/err.h>
+#include <linux/types.h>
+
+/*
+ * direct show sink: in-kernel producers such as the isp/cif streams hand
+ * completed dmabuf frames to a vop plane, the flip waits on the implicit
+ * (exclusive) fence of the dmabuf and no userspace compositor is involved.
+ *
+ * queue() may be called from atomic context, the newest frame wins and a
+ * frame that was not shown yet is handed back at once. release() is called
+ * for every queued frame once it is off screen, dropped or flushed, either
+ * from queue() or from the sink worker.
+ */
+struct rockchip_drm_direct_show_sink;
+
+struct rockchip_drm_direct_show_sink_cfg {
+	const char *crtc_name;	/* NULL: the first active crtc */
+	const char *plane_name;
+	u32 dst_x;
+	u32 dst_y;
+	u32 dst_w;		/* 0: full crtc mode */
+	u32 dst_h;
+	bool top_zpos;
+	u32 rotation;		/* DRM_MODE_ROTATE_* | DRM_MODE_REFLECT_*, 0: none */
+	void (*release)(void *data, void *frame_priv);
+	void *data;
+};
+
+struct rockchip_drm_direct_show_frame {
+	struct dma_buf *dmabuf;
+	u32 width;
+	u32 height;
+	u32 pixel_format;	/* DRM_FORMAT_*, chroma at pitch * height */
+	u32 pitch;
+	void *priv;
+};
+
+#if IS_REACHABLE(CONFIG_DRM_ROCKCHIP) && IS_ENABLED(CONFIG_ROCKCHIP_DRM_DIRECT_SHOW)
+struct rockchip_drm_direct_show_sink *
+rockchip_drm_direct_show_sink_create(const struct rockchip_drm_direct_show_sink_cfg *cfg);
+int rockchip_drm_direct_show_sink_queue(struct rockchip_drm_direct_show_sink *sink,
+					const struct rockchip_drm_direct_show_frame *frame);
+void rockchip_drm_direct_show_sink_flush(struct rockchip_drm_direct_show_sink *sink);
+void rockchip_drm_direct_show_sink_destroy(struct rockchip_drm_direct_show_sink *sink);
+#else
+static inline struct rockchip_drm_direct_show_sink *
+rockchip_drm_direct_show_sink_create(const struct rockchip_drm_direct_show_sink_cfg *cfg)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline int
+rockchip_drm_direct_show_sink_queue(struct rockchip_drm_direct_show_sink *sink,
+				    const struct rockchip_drm_direct_show_frame *frame)
+{
+	return -ENODEV;
+}
+
+static inline void
+rockchip_drm_direct_show_sink_flush(struct rockchip_drm_direct_show_sink *sink)
+{
+}
+
+static inline void
+rockchip_drm_direct_show_sink_destroy(struct rockchip_drm_direct_show_sink *sink)
+{
+}
+#endif
+
+#endif
@@ -50,8 +50,11 @@ struct dmcfreq_common_info {
 	struct freq_map_table *vop_bw_tbl;
 	struct freq_map_table *vop_frame_bw_tbl;
 	struct rl_map_table *vop_pn_rl_tbl;
+	struct freq_map_table *bw_demand_tbl;
 	struct delayed_work msch_rl_work;
 	unsigned long vop_req_rate;
+	unsigned long bw_req_rate;
+	unsigned int bw_demand_margin;
 	unsigned int read_latency;
 	unsigned int auto_freq_en;
 	bool is_msch_rl_work_started;
@@ -64,6 +67,18 @@ struct dmcfreq_vop_info {
 	unsigned int plane_num;
 };
 
+/*
+ * declared ddr bandwidth demand of a streaming master (isp, vepu, ...),
+ * the sum of all requests plus bw_demand_margin percent is mapped to a
+ * minimum dmc rate by the "bw-demand-dmc-freq" table.
+ */
+struct dmcfreq_bw_request {
+	struct list_head node;
+	const char *name;
+	unsigned int mbyte;	/* MB/s */
+	bool active;
+};
+
 #if IS_REACHABLE(CONFIG_ARM_ROCKCHIP_DMC_DEVFREQ)
 void rockchip_dmcfreq_lock(void);
 void rockchip_dmcfreq_lock_nested(void);
@@ -74,6 +89,11 @@ int rockchip_dmcfreq_wait_complete(void);
 int rockchip_dmcfreq_vop_bandwidth_init(struct dmcfreq_common_info *info);
 int rockchip_dmcfreq_vop_bandwidth_request(struct dmcfreq_vop_info *vop_info);
 void rockchip_dmcfreq_vop_bandwidth_update(struct dmcfreq_vop_info *vop_info);
+void rockchip_dmcfreq_bw_request_add(struct dmcfreq_bw_request *req,
+				     const char *name);
+void rockchip_dmcfreq_bw_request_update(struct dmcfreq_bw_request *req,
+					unsigned int mbyte);
+void rockchip_dmcfreq_bw_request_remove(struct dmcfreq_bw_request *req);
 #else
 static inline void rockchip_dmcfreq_lock(void)
 {
@@ -116,6 +136,23 @@ static inline void
 rockchip_dmcfreq_vop_bandwidth_init(struct dmcfreq_common_info *info)
 {
 }
+
+static inline void
+rockchip_dmcfreq_bw_request_add(struct dmcfreq_bw_request *req,
+				const char *name)
+{
+}
+
+static inline void
+rockchip_dmcfreq_bw_request_update(struct dmcfreq_bw_request *req,
+				   unsigned int mbyte)
+{
+}
+
+static inline void
+rockchip_dmcfreq_bw_request_remove(struct dmcfreq_bw_request *req)
+{
+}
 #endif
 
 #endif
@@ -21,6 +21,8 @@ enum dvbm_cmd {
 	DVBM_ISP_FRM_QUARTER,
 	DVBM_ISP_FRM_HALF,
 	DVBM_ISP_FRM_THREE_QUARTERS,
+	/* arg: struct dvbm_isp_frm_info, lines written in current frame */
+	DVBM_ISP_FRM_LINE,
 	DVBM_ISP_CMD_BUTT,
 
 	DVBM_VEPU_CMD_BASE  = 0x10,
@@ -51,6 +53,8 @@ enum dvbm_cb_event {
 	DVBM_VEPU_NOTIFY_FRM_STR,
 	DVBM_VEPU_NOTIFY_FRM_END,
 	DVBM_VEPU_NOTIFY_FRM_INFO,
+	/* arg: struct dvbm_isp_frm_info, forward of DVBM_ISP_FRM_LINE */
+	DVBM_VEPU_NOTIFY_FRM_LINE,
 	DVBM_VEPU_EVENT_BUTT,
 };
 
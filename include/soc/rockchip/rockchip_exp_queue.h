@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_EXP_QUEUE_H
+#define __SOC_ROCKCHIP_EXP_QUEUE_H
+
+#include <linux/kthread.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+#include <linux/rk-exp-queue.h>
+
+struct v4l2_subdev;
+
+#define RK_EXP_QUEUE_DEPTH	8
+
+struct rk_exp_entry {
+	struct rk_exp_req req;
+	/* sof the controls are written at */
+	u32 write_seq;
+};
+
+/*
+ * exposure queue of one sensor. queued exposures wait sorted by the sof
+ * they are written at, the sof hands the due ones to an rt worker which
+ * writes them over i2c while the frame has just started.
+ */
+struct rk_exp_queue {
+	const char *name;
+	struct list_head node;
+	spinlock_t lock;
+	struct rk_exp_entry pending[RK_EXP_QUEUE_DEPTH];
+	u32 nr_pending;
+	/* due at the last sof, for the worker */
+	struct rk_exp_entry run[RK_EXP_QUEUE_DEPTH];
+	u32 nr_run;
+	struct v4l2_subdev *sd;
+	u64 sof_ns;
+	struct kthread_worker *worker;
+	struct kthread_work work;
+	struct rk_exp_stats stats;
+};
+
+#if IS_REACHABLE(CONFIG_ROCKCHIP_EXP_QUEUE)
+int rk_exp_queue_init(struct rk_exp_queue *q, const char *name);
+void rk_exp_queue_remove(struct rk_exp_queue *q);
+int rk_exp_queue_add(struct rk_exp_queue *q, const struct rk_exp_req *req);
+void rk_exp_queue_sof(struct rk_exp_queue *q, struct v4l2_subdev *sd, u32 seq);
+void rk_exp_queue_reset(struct rk_exp_queue *q);
+void rk_exp_queue_get_stats(struct rk_exp_queue *q, struct rk_exp_stats *stats);
+#else
+static inline int rk_exp_queue_init(struct rk_exp_queue *q, const char *name)
+{
+	return 0;
+}
+
+static inline void rk_exp_queue_remove(struct rk_exp_queue *q)
+{
+}
+
+static inline int rk_exp_queue_add(struct rk_exp_queue *q,
+				   const struct rk_exp_req *req)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline void rk_exp_queue_sof(struct rk_exp_queue *q,
+				    struct v4l2_subdev *sd, u32 seq)
+{
+}
+
+static inline void rk_exp_queue_reset(struct rk_exp_queue *q)
+{
+}
+
+static inline void rk_exp_queue_get_stats(struct rk_exp_queue *q,
+					  struct rk_exp_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+}
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_FILL_LIGHT_H
+#define __SOC_ROCKCHIP_FILL_LIGHT_H
+
+#include <linux/hrtimer.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+#include <linux/rk-fill-light.h>
+
+struct device;
+struct pwm_device;
+
+/*
+ * fill light of one sensor. in strobe mode every sof works out the
+ * exposure window of the next frame and an hrtimer switches the pwm on
+ * and off at its edges; a pulse still lit when the next one is due is
+ * stretched over both. the pwm is applied from the timer, it must not
+ * sleep.
+ */
+struct rk_fill_light {
+	const char *name;
+	struct list_head node;
+	struct pwm_device *pwm;
+	spinlock_t lock;
+	struct hrtimer timer;
+	struct rk_fill_light_cfg cfg;
+	/* current pulse, and the one queued behind it while lit */
+	u64 on_ns;
+	u64 off_ns;
+	u64 next_on_ns;
+	u64 next_off_ns;
+	u64 lit_ns;
+	u64 on_total_ns;
+	bool lit;
+	/* timer queued or running */
+	bool busy;
+	struct rk_fill_light_stats stats;
+};
+
+#if IS_REACHABLE(CONFIG_ROCKCHIP_FILL_LIGHT)
+int rk_fill_light_init(struct rk_fill_light *fl, struct device *dev,
+		       const char *name);
+int rk_fill_light_set_cfg(struct rk_fill_light *fl,
+			  const struct rk_fill_light_cfg *cfg);
+void rk_fill_light_get_cfg(struct rk_fill_light *fl,
+			   struct rk_fill_light_cfg *cfg);
+void rk_fill_light_get_stats(struct rk_fill_light *fl,
+			     struct rk_fill_light_stats *stats);
+void rk_fill_light_sof(struct rk_fill_light *fl, u32 exp_lines,
+		       u32 frame_lines, u32 height, u32 line_ns);
+void rk_fill_light_stop(struct rk_fill_light *fl);
+
+static inline bool rk_fill_light_present(struct rk_fill_light *fl)
+{
+	return fl->pwm;
+}
+
+static inline bool rk_fill_light_strobe(struct rk_fill_light *fl)
+{
+	return READ_ONCE(fl->cfg.mode) == RK_FILL_LIGHT_MODE_STROBE;
+}
+#else
+static inline int rk_fill_light_init(struct rk_fill_light *fl,
+				     struct device *dev, const char *name)
+{
+	return 0;
+}
+
+static inline int rk_fill_light_set_cfg(struct rk_fill_light *fl,
+					const struct rk_fill_light_cfg *cfg)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline void rk_fill_light_get_cfg(struct rk_fill_light *fl,
+					 struct rk_fill_light_cfg *cfg)
+{
+	memset(cfg, 0, sizeof(*cfg));
+}
+
+static inline void rk_fill_light_get_stats(struct rk_fill_light *fl,
+					   struct rk_fill_light_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+}
+
+static inline void rk_fill_light_sof(struct rk_fill_light *fl, u32 exp_lines,
+				     u32 frame_lines, u32 height, u32 line_ns)
+{
+}
+
+static inline void rk_fill_light_stop(struct rk_fill_light *fl)
+{
+}
+
+static inline bool rk_fill_light_present(struct rk_fill_light *fl)
+{
+	return false;
+}
+
+static inline bool rk_fill_light_strobe(struct rk_fill_light *fl)
+{
+	return false;
+}
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_FRAME_POLICY_H
+#define __SOC_ROCKCHIP_FRAME_POLICY_H
+
+#include <linux/types.h>
+#include <linux/rk-frame-policy.h>
+#include <media/videobuf2-v4l2.h>
+
+#if IS_REACHABLE(CONFIG_ROCKCHIP_FRAME_POLICY)
+extern bool rk_frame_policy_enable;
+
+int rk_frame_policy_run(struct rk_frame_info *info);
+
+/* filling the info costs, skip it while no policy is loaded */
+static inline bool rk_frame_policy_enabled(void)
+{
+	return READ_ONCE(rk_frame_policy_enable);
+}
+#else
+static inline int rk_frame_policy_run(struct rk_frame_info *info)
+{
+	return RK_FRAME_PASS;
+}
+
+static inline bool rk_frame_policy_enabled(void)
+{
+	return false;
+}
+#endif
+
+/*
+ * hand the tag of verdict to userspace in the timecode of vb, qbuf clears
+ * the flag of a capture buffer again.
+ */
+static inline void rk_frame_policy_tag(struct vb2_v4l2_buffer *vb, int verdict)
+{
+	if (!(verdict & RK_FRAME_TAG_MASK))
+		return;
+	memset(&vb->timecode, 0, sizeof(vb->timecode));
+	vb->timecode.userbits[0] = (verdict & RK_FRAME_TAG_MASK) >> RK_FRAME_TAG_SHIFT;
+	vb->flags |= V4L2_BUF_FLAG_TIMECODE;
+}
+
+#endif
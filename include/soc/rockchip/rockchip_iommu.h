@@ -5,6 +5,8 @@
 #ifndef __SOC_ROCKCHIP_IOMMU_H
 #define __SOC_ROCKCHIP_IOMMU_H
 
+#include <linux/types.h>
+
 struct device;
 
 #if IS_ENABLED(CONFIG_ROCKCHIP_IOMMU)
@@ -16,6 +18,7 @@ bool rockchip_iommu_is_enabled(struct device *dev);
 void rockchip_iommu_mask_irq(struct device *dev);
 void rockchip_iommu_unmask_irq(struct device *dev);
 int rockchip_iommu_force_reset(struct device *dev);
+int rockchip_iommu_prealloc_pt(struct device *dev, dma_addr_t iova, size_t size);
 #else
 static inline int rockchip_iommu_enable(struct device *dev)
 {
@@ -47,6 +50,11 @@ static inline int rockchip_iommu_force_reset(struct device *dev)
 {
 	return -ENODEV;
 }
+static inline int rockchip_iommu_prealloc_pt(struct device *dev,
+					     dma_addr_t iova, size_t size)
+{
+	return -ENODEV;
+}
 #endif
 
 #endif
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_IRQ_ALIGN_H
+#define __SOC_ROCKCHIP_IRQ_ALIGN_H
+
+#include <linux/hrtimer.h>
+#include <linux/list.h>
+#include <linux/types.h>
+
+/*
+ * wakeup alignment for deferrable completions: a queued work runs at the
+ * next anchor, a wakeup that happens anyway such as the sensor sof, or at
+ * the latest when its slack runs out. the fallback timer is a range timer
+ * so it also rides on any other timer interrupt inside the window.
+ *
+ * fn runs in hard irq context, it should only kick a napi, tasklet or work.
+ */
+struct rk_irq_align_work {
+	struct hrtimer timer;
+	struct list_head node;
+	void (*fn)(struct rk_irq_align_work *work);
+	unsigned long pending;
+};
+
+#if IS_REACHABLE(CONFIG_ROCKCHIP_IRQ_ALIGN)
+void rk_irq_align_init_work(struct rk_irq_align_work *work,
+			    void (*fn)(struct rk_irq_align_work *work));
+bool rk_irq_align_queue(struct rk_irq_align_work *work, u64 slack_ns);
+void rk_irq_align_cancel(struct rk_irq_align_work *work);
+void rk_irq_align_anchor(void);
+#else
+static inline void rk_irq_align_init_work(struct rk_irq_align_work *work,
+					  void (*fn)(struct rk_irq_align_work *work))
+{
+}
+
+/* false: not queued, the caller falls back to its own timer */
+static inline bool rk_irq_align_queue(struct rk_irq_align_work *work, u64 slack_ns)
+{
+	return false;
+}
+
+static inline void rk_irq_align_cancel(struct rk_irq_align_work *work)
+{
+}
+
+static inline void rk_irq_align_anchor(void)
+{
+}
+#endif
+
+#endif
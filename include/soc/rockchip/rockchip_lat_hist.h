@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_LAT_HIST_H
+#define __SOC_ROCKCHIP_LAT_HIST_H
+
+#include <linux/kernel.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/seq_file.h>
+#include <linux/string.h>
+
+/*
+ * log2 latency histogram shared by the camera and codec drivers.
+ * bucket 0 holds samples below 1us, bucket n holds [2^(n-1), 2^n) us,
+ * the last bucket collects everything above.
+ */
+#define RK_LAT_HIST_BUCKETS	20
+
+struct rk_lat_hist {
+	u32 bucket[RK_LAT_HIST_BUCKETS];
+	u64 cnt;
+	u64 sum_us;
+	u32 max_us;
+};
+
+static inline void rk_lat_hist_reset(struct rk_lat_hist *hist)
+{
+	memset(hist, 0, sizeof(*hist));
+}
+
+static inline void rk_lat_hist_add(struct rk_lat_hist *hist, s64 ns)
+{
+	u32 us, idx = 0;
+
+	if (ns < 0)
+		ns = 0;
+	us = min_t(u64, div_u64(ns, NSEC_PER_USEC), U32_MAX);
+	if (us)
+		idx = min_t(u32, ilog2(us) + 1, RK_LAT_HIST_BUCKETS - 1);
+
+	hist->bucket[idx]++;
+	hist->cnt++;
+	hist->sum_us += us;
+	if (us > hist->max_us)
+		hist->max_us = us;
+}
+
+/* upper bound in us of the pct percentile, to the bucket resolution */
+static inline u32 rk_lat_hist_pct(const struct rk_lat_hist *hist, u32 pct)
+{
+	u64 sum = 0, target;
+	u32 i;
+
+	if (!hist->cnt)
+		return 0;
+	target = div_u64(hist->cnt * pct + 99, 100);
+	for (i = 0; i < RK_LAT_HIST_BUCKETS - 1; i++) {
+		sum += hist->bucket[i];
+		if (sum >= target)
+			return min_t(u32, 1U << i, hist->max_us);
+	}
+	return hist->max_us;
+}
+
+static inline void rk_lat_hist_show(struct seq_file *p, const char *name,
+				    const struct rk_lat_hist *hist)
+{
+	u32 i;
+
+	seq_printf(p, "%-16s cnt:%llu avg:%lluus p99:%uus max:%uus\n", name,
+		   hist->cnt, hist->cnt ? div64_u64(hist->sum_us, hist->cnt) : 0,
+		   rk_lat_hist_pct(hist, 99), hist->max_us);
+	for (i = 0; i < RK_LAT_HIST_BUCKETS; i++) {
+		if (!hist->bucket[i])
+			continue;
+		if (i == RK_LAT_HIST_BUCKETS - 1)
+			seq_printf(p, "\t[%u, inf) us: %u\n",
+				   1U << (i - 1), hist->bucket[i]);
+		else
+			seq_printf(p, "\t[%u, %u) us: %u\n", i ? 1U << (i - 1) : 0,
+				   1U << i, hist->bucket[i]);
+	}
+}
+
+#endif
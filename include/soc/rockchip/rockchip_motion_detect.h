@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_MOTION_DETECT_H
+#define __SOC_ROCKCHIP_MOTION_DETECT_H
+
+#include <linux/device.h>
+#include <linux/list.h>
+#include <linux/notifier.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+#include <linux/rk-motion-detect.h>
+
+/* notifier action, data is a struct rk_md_event */
+#define RK_MD_EVENT_MOTION	1
+
+struct rk_md_event {
+	const char *name;
+	u32 frame_id;
+	/* moving zones, bit n for mean n */
+	u32 zones;
+};
+
+/*
+ * motion detector of one luma source. the background of each zone
+ * follows the quiet frames slowly, a zone moves if its mean departs from
+ * the background by more than threshold percent. the first frame with
+ * min_zones moving raises an event: a hard wakeup of dev, which aborts a
+ * suspend in progress, and the motion notifier chain, on which an
+ * encoder or the thunderboot recording can start at once.
+ */
+struct rk_motion_detect {
+	struct device *dev;
+	const char *name;
+	struct list_head node;
+	spinlock_t lock;
+	struct rk_md_cfg cfg;
+	/* background means, 4 bit fixed point */
+	u32 ref[RK_MD_ZONES_MAX];
+	u32 ref_frames;
+	u32 quiet;
+	bool active;
+	u32 last_zones;
+	/* luma means of the last frame, also while disabled */
+	u32 mean[RK_MD_ZONES_MAX];
+	u32 nr_mean;
+	u64 frames;
+	u64 events;
+};
+
+#if IS_REACHABLE(CONFIG_ROCKCHIP_MOTION_DETECT)
+void rk_md_init(struct rk_motion_detect *md, struct device *dev,
+		const char *name);
+void rk_md_remove(struct rk_motion_detect *md);
+int rk_md_set_cfg(struct rk_motion_detect *md, const struct rk_md_cfg *cfg);
+void rk_md_get_cfg(struct rk_motion_detect *md, struct rk_md_cfg *cfg);
+void rk_md_frame(struct rk_motion_detect *md, const u32 *mean, u32 num,
+		 u32 frame_id);
+u32 rk_md_get_luma(struct rk_motion_detect *md, u32 *mean, u32 num,
+		   u32 *zones);
+int rk_md_register_notifier(struct notifier_block *nb);
+int rk_md_unregister_notifier(struct notifier_block *nb);
+
+static inline bool rk_md_enabled(struct rk_motion_detect *md)
+{
+	return READ_ONCE(md->cfg.enable);
+}
+#else
+static inline void rk_md_init(struct rk_motion_detect *md, struct device *dev,
+			      const char *name)
+{
+}
+
+static inline void rk_md_remove(struct rk_motion_detect *md)
+{
+}
+
+static inline int rk_md_set_cfg(struct rk_motion_detect *md,
+				const struct rk_md_cfg *cfg)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline void rk_md_get_cfg(struct rk_motion_detect *md,
+				 struct rk_md_cfg *cfg)
+{
+	memset(cfg, 0, sizeof(*cfg));
+}
+
+static inline void rk_md_frame(struct rk_motion_detect *md, const u32 *mean,
+			       u32 num, u32 frame_id)
+{
+}
+
+static inline u32 rk_md_get_luma(struct rk_motion_detect *md, u32 *mean,
+				 u32 num, u32 *zones)
+{
+	*zones = 0;
+	return 0;
+}
+
+static inline int rk_md_register_notifier(struct notifier_block *nb)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline int rk_md_unregister_notifier(struct notifier_block *nb)
+{
+	return 0;
+}
+
+static inline bool rk_md_enabled(struct rk_motion_detect *md)
+{
+	return false;
+}
+#endif
+
+#endif
@@ -5,6 +5,8 @@
 #ifndef __SOC_ROCKCHIP_PERFORMANCE_H
 #define __SOC_ROCKCHIP_PERFORMANCE_H
 
+#include <linux/kthread.h>
+
 enum {
 	ROCKCHIP_PERFORMANCE_LOW = 0,
 	ROCKCHIP_PERFORMANCE_NORMAL,
@@ -15,19 +17,42 @@ enum {
 extern int rockchip_perf_get_level(void);
 extern struct cpumask *rockchip_perf_get_cpul_mask(void);
 extern struct cpumask *rockchip_perf_get_cpub_mask(void);
-extern int rockchip_perf_select_rt_cpu(int prev_cpu, struct cpumask *lowest_mask);
-extern bool rockchip_perf_misfit_rt(int cpu);
+extern int rockchip_perf_select_rt_cpu(struct task_struct *p, int prev_cpu,
+				       struct cpumask *lowest_mask);
+extern bool rockchip_perf_misfit_rt(struct task_struct *p, int cpu);
 extern void rockchip_perf_uclamp_sync_util_min_rt_default(void);
+extern int rockchip_perf_register_task(struct task_struct *task);
+extern void rockchip_perf_unregister_task(struct task_struct *task);
+extern int rockchip_perf_set_task_capacity(struct task_struct *task, unsigned int capacity);
+extern struct kthread_worker *rockchip_perf_create_worker(const char *name);
+extern void rockchip_perf_destroy_worker(struct kthread_worker *worker);
 #else
 static inline int rockchip_perf_get_level(void) { return ROCKCHIP_PERFORMANCE_NORMAL; }
 static inline struct cpumask *rockchip_perf_get_cpul_mask(void) { return NULL; };
 static inline struct cpumask *rockchip_perf_get_cpub_mask(void) { return NULL; };
-static inline int rockchip_perf_select_rt_cpu(int prev_cpu, struct cpumask *lowest_mask)
+static inline int rockchip_perf_select_rt_cpu(struct task_struct *p, int prev_cpu,
+					      struct cpumask *lowest_mask)
 {
 	return prev_cpu;
 }
-static inline bool rockchip_perf_misfit_rt(int cpu) { return false; }
+static inline bool rockchip_perf_misfit_rt(struct task_struct *p, int cpu) { return false; }
 static inline void rockchip_perf_uclamp_sync_util_min_rt_default(void) {}
+static inline int rockchip_perf_register_task(struct task_struct *task) { return 0; }
+static inline void rockchip_perf_unregister_task(struct task_struct *task) {}
+static inline int rockchip_perf_set_task_capacity(struct task_struct *task,
+						  unsigned int capacity)
+{
+	return 0;
+}
+static inline struct kthread_worker *rockchip_perf_create_worker(const char *name)
+{
+	return kthread_create_worker(0, "%s", name);
+}
+static inline void rockchip_perf_destroy_worker(struct kthread_worker *worker)
+{
+	if (!IS_ERR_OR_NULL(worker))
+		kthread_destroy_worker(worker);
+}
 #endif
 
 #endif
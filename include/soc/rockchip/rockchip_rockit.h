@@ -138,6 +138,7 @@ int rkisp_rockit_get_tb_stream_info(struct rockit_cfg *input_rockit_cfg,
 				    struct rkisp_tb_stream_info *info);
 int rkisp_rockit_free_tb_stream_buf(struct rockit_cfg *input_rockit_cfg);
 int rkisp_rockit_free_stream_buf(struct rockit_cfg *input_rockit_cfg);
+int rkisp_rockit_snapshot(struct rockit_cfg *input_rockit_cfg, int num);
 
 void *rkcif_rockit_function_register(void *function, int cmd);
 int rkcif_rockit_get_cifdev(char **name);
@@ -146,6 +147,8 @@ int rkcif_rockit_config_stream(struct rockit_rkcif_cfg *input_rockit_cfg,
 				int width, int height, int v4l2_fmt);
 int rkcif_rockit_resume_stream(struct rockit_rkcif_cfg *input_rockit_cfg);
 int rkcif_rockit_pause_stream(struct rockit_rkcif_cfg *input_rockit_cfg);
+int rkcif_rockit_set_backpressure(struct rockit_rkcif_cfg *input_rockit_cfg,
+				  u32 depth, u32 high_wm, u32 low_wm);
 
 #else
 
@@ -186,6 +189,11 @@ static inline int rkisp_rockit_free_stream_buf(struct rockit_cfg *input_rockit_c
 	return -EINVAL;
 }
 
+static inline int rkisp_rockit_snapshot(struct rockit_cfg *input_rockit_cfg, int num)
+{
+	return -EINVAL;
+}
+
 #endif
 
 #endif
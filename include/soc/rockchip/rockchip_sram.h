@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __SOC_ROCKCHIP_SRAM_H
+#define __SOC_ROCKCHIP_SRAM_H
+
+#include <linux/ioport.h>
+#include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <linux/types.h>
+
+/* higher is served first */
+enum rk_sram_prio {
+	RK_SRAM_PRIO_LOW,
+	RK_SRAM_PRIO_NORMAL,
+	RK_SRAM_PRIO_HIGH,
+};
+
+/*
+ * one user of an on-chip sram, such as the encoder rcb or the isp line
+ * buffers. the client asks for want bytes of the sram behind res, and the
+ * arbiter grants what is left after the higher priority clients of the
+ * same sram. whatever is not granted the client places in ddr, so a grant
+ * smaller than want, down to 0, is not an error.
+ */
+struct rk_sram_client {
+	const char *name;
+	enum rk_sram_prio prio;
+	size_t want;
+
+	/* the page aligned sram, set by rk_sram_register() */
+	phys_addr_t base;
+	size_t size;
+
+	/* set by rk_sram_request() */
+	phys_addr_t phys;
+	size_t granted;
+
+	/* private to the arbiter */
+	struct list_head node;
+	void *area;
+	u64 requests;
+	u64 full_grants;
+};
+
+#if IS_REACHABLE(CONFIG_ROCKCHIP_SRAM_ARB)
+int rk_sram_register(struct rk_sram_client *client, const struct resource *res);
+void rk_sram_unregister(struct rk_sram_client *client);
+int rk_sram_request(struct rk_sram_client *client);
+void rk_sram_release(struct rk_sram_client *client);
+#else
+/* without the arbiter every client owns its sram, as it did before */
+static inline int rk_sram_register(struct rk_sram_client *client,
+				   const struct resource *res)
+{
+	phys_addr_t start = round_up(res->start, PAGE_SIZE);
+	phys_addr_t end = round_down(res->start + resource_size(res), PAGE_SIZE);
+
+	if (end <= start)
+		return -ENOMEM;
+	client->base = start;
+	client->size = end - start;
+	client->phys = start;
+	return 0;
+}
+
+static inline void rk_sram_unregister(struct rk_sram_client *client)
+{
+}
+
+static inline int rk_sram_request(struct rk_sram_client *client)
+{
+	client->granted = min(PAGE_ALIGN(client->want), client->size);
+	return 0;
+}
+
+static inline void rk_sram_release(struct rk_sram_client *client)
+{
+	client->granted = 0;
+}
+#endif
+
+#endif
@@ -34,6 +34,40 @@ struct temp_freq_table {
 	unsigned int freq;	/* KHz */
 };
 
+struct video_load_freq_table {
+	unsigned int load;	/* weighted Mpixel per second */
+	unsigned int freq;	/* KHz */
+};
+
+enum rockchip_video_load_type {
+	ROCKCHIP_VIDEO_LOAD_DEC = 0,
+	ROCKCHIP_VIDEO_LOAD_ISP,
+	ROCKCHIP_VIDEO_LOAD_ENC,
+	ROCKCHIP_VIDEO_LOAD_MAX,
+};
+
+/**
+ * struct rockchip_video_load - streaming use case declared by a driver
+ * @type:	Decoder, isp or encoder, picks the per-SoC cost
+ * @width:	Frame width in pixels
+ * @height:	Frame height in pixels
+ * @fps:	Frames per second, 0 for 30
+ * @hdr:	Exposures merged per frame, 0 or 1 for linear
+ * @hevc:	True for h.265 sessions
+ * @node:	Node in video_load_list
+ * @active:	True while the load is counted
+ */
+struct rockchip_video_load {
+	unsigned int type;
+	unsigned int width;
+	unsigned int height;
+	unsigned int fps;
+	unsigned int hdr;
+	bool hevc;
+	struct list_head node;
+	bool active;
+};
+
 /**
  * struct temp_opp_table - System monitor device OPP description structure
  * @rate:		Frequency in hertz
@@ -74,6 +108,9 @@ struct temp_opp_table {
  *			to system status.
  * @dev_max_freq_req:	Devices maximum frequency constraint changed according
  *			to temperature.
+ * @dev_min_freq_req:	Devices minimum frequency constraint changed according
+ *			to the video load.
+ * @video_load_table:	Minimum frequency for the sum of all video loads
  * @low_limit:		Limit maximum frequency when low temperature, in Hz
  * @high_limit:		Limit maximum frequency when high temperature, in Hz
  * @max_volt:		Maximum voltage in microvolt
@@ -86,6 +123,7 @@ struct temp_opp_table {
  * @reboot_freq:	Limit maximum and minimum frequency when reboot, in KHz
  * @status_min_limit:	Minimum frequency of some status frequency, in KHz
  * @status_max_limit:	Minimum frequency of all status frequency, in KHz
+ * @video_load_freq:	Current minimum frequency for the video load, in KHz
  * @low_temp:		Low temperature trip point, in millicelsius
  * @high_temp:		High temperature trip point, in millicelsius
  * @temp_hysteresis:	A low hysteresis value on low_temp, in millicelsius
@@ -107,6 +145,8 @@ struct monitor_dev_info {
 	struct freq_qos_request min_sta_freq_req;
 	struct freq_qos_request max_sta_freq_req;
 	struct dev_pm_qos_request dev_max_freq_req;
+	struct dev_pm_qos_request dev_min_freq_req;
+	struct video_load_freq_table *video_load_table;
 	struct regulator *early_reg;
 	struct regulator **regulators;
 	struct dev_pm_set_opp_data *set_opp_data;
@@ -121,6 +161,7 @@ struct monitor_dev_info {
 	unsigned int init_freq;
 	unsigned int status_min_limit;
 	unsigned int status_max_limit;
+	unsigned int video_load_freq;
 	unsigned int early_min_volt;
 	unsigned int regulator_count;
 	int low_temp;
@@ -162,6 +203,8 @@ int rockchip_monitor_dev_high_temp_adjust(struct monitor_dev_info *info,
 int rockchip_monitor_suspend_low_temp_adjust(int cpu);
 int rockchip_system_monitor_register_notifier(struct notifier_block *nb);
 void rockchip_system_monitor_unregister_notifier(struct notifier_block *nb);
+void rockchip_system_monitor_video_load_update(struct rockchip_video_load *load,
+					       bool on);
 #else
 static inline struct monitor_dev_info *
 rockchip_system_monitor_register(struct device *dev,
@@ -232,6 +275,12 @@ static inline void
 rockchip_system_monitor_unregister_notifier(struct notifier_block *nb)
 {
 };
+
+static inline void
+rockchip_system_monitor_video_load_update(struct rockchip_video_load *load,
+					  bool on)
+{
+};
 #endif /* CONFIG_ROCKCHIP_SYSTEM_MONITOR */
 
 #endif
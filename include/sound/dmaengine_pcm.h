@@ -109,6 +109,18 @@ int snd_dmaengine_pcm_refine_runtime_hwparams(
  * playback.
  */
 #define SND_DMAENGINE_PCM_FLAG_HALF_DUPLEX BIT(3)
+/*
+ * Advertise SNDRV_PCM_INFO_NO_PERIOD_WAKEUP, the DMA is then set up without
+ * per period interrupts and the position comes from the residue alone. Only
+ * honoured when the DMA reports a residue finer than a descriptor.
+ */
+#define SND_DMAENGINE_PCM_FLAG_NO_PERIOD_WAKEUP BIT(4)
+/*
+ * Also offer SNDRV_PCM_ACCESS_RW_NONINTERLEAVED for capture. The DMA buffer
+ * stays interleaved and the channels are split into the user planes on
+ * read, mmap access remains interleaved only.
+ */
+#define SND_DMAENGINE_PCM_FLAG_PLANAR_CAPTURE BIT(5)
 
 /**
  * struct snd_dmaengine_pcm_config - Configuration data for dmaengine based PCM
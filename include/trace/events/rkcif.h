@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM rkcif
+
+#if !defined(_TRACE_RKCIF_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_RKCIF_H
+
+#include <linux/tracepoint.h>
+
+/*
+ * Fields match rkisp_frame_done and rkmpp_task_* so one script can
+ * follow a frame through cif, isp and encoder by seq and timestamps.
+ */
+TRACE_EVENT(rkcif_frame_done,
+
+	TP_PROTO(const char *name, u32 stream_id, u32 seq, u64 sof_ns, u64 done_ns),
+
+	TP_ARGS(name, stream_id, seq, sof_ns, done_ns),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(u32, stream_id)
+		__field(u32, seq)
+		__field(u64, sof_ns)
+		__field(u64, done_ns)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->stream_id = stream_id;
+		__entry->seq = seq;
+		__entry->sof_ns = sof_ns;
+		__entry->done_ns = done_ns;
+	),
+
+	TP_printk("%s stream:%u seq:%u sof:%llu done:%llu lat:%lld",
+		  __get_str(name), __entry->stream_id, __entry->seq,
+		  __entry->sof_ns, __entry->done_ns,
+		  (s64)(__entry->done_ns - __entry->sof_ns))
+);
+
+/*
+ * Raw tracepoint friendly frame record, scalars only. buf is the inode
+ * number of the dma-buf the frame landed in, as fstat() shows it on the
+ * fd, so the frame can be followed into rkmpp_task_buf. 0 for buffers
+ * not imported as V4L2_MEMORY_DMABUF.
+ */
+TRACE_EVENT(rkcif_frame_buf,
+
+	TP_PROTO(u32 stream_id, u32 seq, u64 sof_ns, u64 done_ns, unsigned long buf),
+
+	TP_ARGS(stream_id, seq, sof_ns, done_ns, buf),
+
+	TP_STRUCT__entry(
+		__field(u32, stream_id)
+		__field(u32, seq)
+		__field(u64, sof_ns)
+		__field(u64, done_ns)
+		__field(unsigned long, buf)
+	),
+
+	TP_fast_assign(
+		__entry->stream_id = stream_id;
+		__entry->seq = seq;
+		__entry->sof_ns = sof_ns;
+		__entry->done_ns = done_ns;
+		__entry->buf = buf;
+	),
+
+	TP_printk("stream:%u seq:%u sof:%llu done:%llu buf:%lu",
+		  __entry->stream_id, __entry->seq, __entry->sof_ns,
+		  __entry->done_ns, __entry->buf)
+);
+
+/*
+ * Raw csi2 host error register, reg is 1 or 2 for ERR1 and ERR2. The
+ * per lane and per vc split is in the host's procfs node.
+ */
+TRACE_EVENT(rkcif_csi2_err,
+
+	TP_PROTO(const char *name, u32 reg, u32 val),
+
+	TP_ARGS(name, reg, val),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(u32, reg)
+		__field(u32, val)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->reg = reg;
+		__entry->val = val;
+	),
+
+	TP_printk("%s ERR%u:0x%x", __get_str(name), __entry->reg, __entry->val)
+);
+
+#endif /* _TRACE_RKCIF_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
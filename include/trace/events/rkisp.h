@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM rkisp
+
+#if !defined(_TRACE_RKISP_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_RKISP_H
+
+#include <linux/tracepoint.h>
+
+/*
+ * seq is the v4l2 buffer sequence, sof_ns and done_ns use the same
+ * clock as the vb2 timestamp.
+ */
+TRACE_EVENT(rkisp_frame_done,
+
+	TP_PROTO(const char *name, u32 stream_id, u32 seq, u64 sof_ns, u64 done_ns),
+
+	TP_ARGS(name, stream_id, seq, sof_ns, done_ns),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(u32, stream_id)
+		__field(u32, seq)
+		__field(u64, sof_ns)
+		__field(u64, done_ns)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->stream_id = stream_id;
+		__entry->seq = seq;
+		__entry->sof_ns = sof_ns;
+		__entry->done_ns = done_ns;
+	),
+
+	TP_printk("%s stream:%u seq:%u sof:%llu done:%llu lat:%lld",
+		  __get_str(name), __entry->stream_id, __entry->seq,
+		  __entry->sof_ns, __entry->done_ns,
+		  (s64)(__entry->done_ns - __entry->sof_ns))
+);
+
+/* scalars only for raw tracepoints, buf as in rkcif_frame_buf */
+TRACE_EVENT(rkisp_frame_buf,
+
+	TP_PROTO(u32 stream_id, u32 seq, u64 sof_ns, u64 done_ns, unsigned long buf),
+
+	TP_ARGS(stream_id, seq, sof_ns, done_ns, buf),
+
+	TP_STRUCT__entry(
+		__field(u32, stream_id)
+		__field(u32, seq)
+		__field(u64, sof_ns)
+		__field(u64, done_ns)
+		__field(unsigned long, buf)
+	),
+
+	TP_fast_assign(
+		__entry->stream_id = stream_id;
+		__entry->seq = seq;
+		__entry->sof_ns = sof_ns;
+		__entry->done_ns = done_ns;
+		__entry->buf = buf;
+	),
+
+	TP_printk("stream:%u seq:%u sof:%llu done:%llu buf:%lu",
+		  __entry->stream_id, __entry->seq, __entry->sof_ns,
+		  __entry->done_ns, __entry->buf)
+);
+
+#endif /* _TRACE_RKISP_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM rkmpp
+
+#if !defined(_TRACE_RKMPP_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_RKMPP_H
+
+#include <linux/tracepoint.h>
+
+/* timestamps are boottime ns, the clock rkcif/rkisp use on rv1106 */
+DECLARE_EVENT_CLASS(rkmpp_task,
+
+	TP_PROTO(const char *name, u32 session, u32 task, u64 begin_ns, u64 end_ns),
+
+	TP_ARGS(name, session, task, begin_ns, end_ns),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(u32, session)
+		__field(u32, task)
+		__field(u64, begin_ns)
+		__field(u64, end_ns)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->session = session;
+		__entry->task = task;
+		__entry->begin_ns = begin_ns;
+		__entry->end_ns = end_ns;
+	),
+
+	TP_printk("%s session:%u task:%u begin:%llu end:%llu lat:%lld",
+		  __get_str(name), __entry->session, __entry->task,
+		  __entry->begin_ns, __entry->end_ns,
+		  (s64)(__entry->end_ns - __entry->begin_ns))
+);
+
+/* begin is task creation, end is hardware start */
+DEFINE_EVENT(rkmpp_task, rkmpp_task_start,
+	TP_PROTO(const char *name, u32 session, u32 task, u64 begin_ns, u64 end_ns),
+	TP_ARGS(name, session, task, begin_ns, end_ns)
+);
+
+/* begin is hardware start, end is hardware irq */
+DEFINE_EVENT(rkmpp_task, rkmpp_task_done,
+	TP_PROTO(const char *name, u32 session, u32 task, u64 begin_ns, u64 end_ns),
+	TP_ARGS(name, session, task, begin_ns, end_ns)
+);
+
+/* buf is the dma-buf inode number, see rkcif_frame_buf */
+TRACE_EVENT(rkmpp_task_buf,
+
+	TP_PROTO(u32 session, u32 task, int fd, unsigned long buf),
+
+	TP_ARGS(session, task, fd, buf),
+
+	TP_STRUCT__entry(
+		__field(u32, session)
+		__field(u32, task)
+		__field(int, fd)
+		__field(unsigned long, buf)
+	),
+
+	TP_fast_assign(
+		__entry->session = session;
+		__entry->task = task;
+		__entry->fd = fd;
+		__entry->buf = buf;
+	),
+
+	TP_printk("session:%u task:%u fd:%d buf:%lu",
+		  __entry->session, __entry->task, __entry->fd, __entry->buf)
+);
+
+#endif /* _TRACE_RKMPP_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
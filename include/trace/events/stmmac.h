@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM stmmac
+
+#if !defined(_TRACE_STMMAC_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_STMMAC_H
+
+#include <linux/skbuff.h>
+#include <linux/tracepoint.h>
+
+/* skb handed to the tx dma ring */
+TRACE_EVENT(stmmac_xmit,
+
+	TP_PROTO(const struct sk_buff *skb, u32 queue),
+
+	TP_ARGS(skb, queue),
+
+	TP_STRUCT__entry(
+		__field(const void *, skbaddr)
+		__field(u32, queue)
+		__field(u32, len)
+	),
+
+	TP_fast_assign(
+		__entry->skbaddr = skb;
+		__entry->queue = queue;
+		__entry->len = skb->len;
+	),
+
+	TP_printk("skbaddr=%p queue=%u len=%u",
+		  __entry->skbaddr, __entry->queue, __entry->len)
+);
+
+/*
+ * skb reclaimed after the dma sent it. xmit_ns and done_ns are
+ * CLOCK_MONOTONIC, only their difference is meant to be used.
+ */
+TRACE_EVENT(stmmac_tx_done,
+
+	TP_PROTO(const struct sk_buff *skb, u32 queue, u64 xmit_ns, u64 done_ns),
+
+	TP_ARGS(skb, queue, xmit_ns, done_ns),
+
+	TP_STRUCT__entry(
+		__field(const void *, skbaddr)
+		__field(u32, queue)
+		__field(u64, xmit_ns)
+		__field(u64, done_ns)
+	),
+
+	TP_fast_assign(
+		__entry->skbaddr = skb;
+		__entry->queue = queue;
+		__entry->xmit_ns = xmit_ns;
+		__entry->done_ns = done_ns;
+	),
+
+	TP_printk("skbaddr=%p queue=%u lat:%lld",
+		  __entry->skbaddr, __entry->queue,
+		  (s64)(__entry->done_ns - __entry->xmit_ns))
+);
+
+#endif /* _TRACE_STMMAC_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
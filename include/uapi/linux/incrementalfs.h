@@ -227,9 +227,20 @@ struct incfs_pending_read_info2 {
 	/* The UID of the reading process */
 	__u32 uid;
 
-	__u32 reserved;
+	union {
+		__u32 reserved;
+		/* INCFS_PENDING_READ_* */
+		__u32 flags;
+	};
 };
 
+/*
+ * The pending read is a readahead hint, posix_fadvise(POSIX_FADV_WILLNEED),
+ * readahead() or madvise(MADV_WILLNEED) on a missing range. Nobody waits
+ * for it yet, fill it after the other pending reads.
+ */
+#define INCFS_PENDING_READ_HINT		(1 << 0)
+
 /*
  * Description of a data or hash block to add to a data file.
  */
@@ -28,6 +28,8 @@ enum {
 	MPTCP_SUBFLOW_ATTR_ID_REM,
 	MPTCP_SUBFLOW_ATTR_ID_LOC,
 	MPTCP_SUBFLOW_ATTR_PAD,
+	MPTCP_SUBFLOW_ATTR_SCHED_BYTES,
+	MPTCP_SUBFLOW_ATTR_REDUNDANT_BYTES,
 	__MPTCP_SUBFLOW_ATTR_MAX
 };
 
@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: ((GPL-2.0+ WITH Linux-syscall-note) OR MIT) */
+/*
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef _UAPI_RK_EXP_QUEUE_H
+#define _UAPI_RK_EXP_QUEUE_H
+
+#include <linux/types.h>
+#include <linux/videodev2.h>
+
+/*
+ * frame synchronous sensor exposure, on the rkisp-isp-subdev and on the
+ * rkcif capture nodes. an exposure is queued for the frame it is meant
+ * for, the kernel writes its controls to the sensor right after the sof
+ * of frame frame_id - sensor_delay.
+ */
+#define RK_EXP_CTRL_MAX		4
+
+/*
+ * struct rk_exp_req - sensor exposure for one frame
+ *
+ * @frame_id: frame the exposure takes effect on
+ * @sensor_delay: frames from the write to the frame it takes effect on,
+ *		  the exp_delay or gain_delay of RKMODULE_GET_EXP_DELAY
+ * @ctrl_num: controls in @ctrl
+ * @ctrl: v4l2 control id and value of the sensor, written in order
+ */
+struct rk_exp_req {
+	__u32 frame_id;
+	__u32 sensor_delay;
+	__u32 ctrl_num;
+	struct {
+		__u32 id;
+		__s32 value;
+	} ctrl[RK_EXP_CTRL_MAX];
+	__u32 reserved[2];
+} __attribute__ ((packed));
+
+/*
+ * struct rk_exp_stats - exposure queue counters since the stream on
+ *
+ * @queued: exposures queued
+ * @on_time: exposures written at the sof they were meant for
+ * @late: exposures written one or more sofs too late
+ * @dropped: exposures refused with the queue full
+ * @failed: exposures the sensor refused
+ * @max_write_us: longest time from the sof to the last control written
+ */
+struct rk_exp_stats {
+	__u32 queued;
+	__u32 on_time;
+	__u32 late;
+	__u32 dropped;
+	__u32 failed;
+	__u32 max_write_us;
+	__u32 reserved[2];
+} __attribute__ ((packed));
+
+#define RK_EXP_CMD_QUEUE \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 64, struct rk_exp_req)
+
+#define RK_EXP_CMD_GET_STATS \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 65, struct rk_exp_stats)
+
+#endif
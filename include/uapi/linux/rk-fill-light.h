@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: ((GPL-2.0+ WITH Linux-syscall-note) OR MIT) */
+/*
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef _UAPI_RK_FILL_LIGHT_H
+#define _UAPI_RK_FILL_LIGHT_H
+
+#include <linux/types.h>
+#include <linux/videodev2.h>
+
+/*
+ * ir or white fill light on the "fill-light" pwm of the vicap, set on the
+ * rkcif capture nodes. in strobe mode the light is only lit while the
+ * sensor exposes the next frame, timed from the sof and the line time.
+ */
+#define RK_FILL_LIGHT_MODE_OFF		0
+/* lit all the time, as a plain pwm */
+#define RK_FILL_LIGHT_MODE_CONTINUOUS	1
+/* lit on the exposure window of every frame */
+#define RK_FILL_LIGHT_MODE_STROBE	2
+
+/*
+ * struct rk_fill_light_cfg - fill light config
+ *
+ * @mode: RK_FILL_LIGHT_MODE_*
+ * @brightness: duty of the pwm while lit, in percent
+ */
+struct rk_fill_light_cfg {
+	__u32 mode;
+	__u32 brightness;
+	__u32 reserved[2];
+};
+
+/*
+ * struct rk_fill_light_stats - strobe counters since the stream on
+ *
+ * @frames: sofs seen in strobe mode
+ * @pulses: times the light was switched on
+ * @late: pulses switched on more than RK_FILL_LIGHT_LATE_US after their
+ *	  exposure window started
+ * @skipped: frames without a pulse, no exposure or line time known
+ * @max_late_us: latest switch on after the window started
+ * @on_ms: time the light was lit
+ */
+struct rk_fill_light_stats {
+	__u32 frames;
+	__u32 pulses;
+	__u32 late;
+	__u32 skipped;
+	__u32 max_late_us;
+	__u32 on_ms;
+	__u32 reserved[2];
+};
+
+#define RK_FILL_LIGHT_LATE_US		100
+
+#define RK_FILL_LIGHT_CMD_SET_CFG \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 66, struct rk_fill_light_cfg)
+
+#define RK_FILL_LIGHT_CMD_GET_CFG \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 67, struct rk_fill_light_cfg)
+
+#define RK_FILL_LIGHT_CMD_GET_STATS \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 68, struct rk_fill_light_stats)
+
+#endif
@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: ((GPL-2.0+ WITH Linux-syscall-note) OR MIT) */
+/*
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef _UAPI_RK_FRAME_POLICY_H
+#define _UAPI_RK_FRAME_POLICY_H
+
+#include <linux/types.h>
+
+/*
+ * per frame policy of rkcif and rkisp. rk_frame_policy() is called with a
+ * struct rk_frame_info for every frame while rockchip_frame_policy.enable
+ * is set, a kprobe bpf program on it reads the info and returns the
+ * verdict with bpf_override_return().
+ */
+#define RK_FRAME_SRC_CIF	0
+#define RK_FRAME_SRC_ISP	1
+
+#define RK_FRAME_MEANS_MAX	16
+
+/*
+ * struct rk_frame_info - a frame about to be returned to userspace
+ *
+ * @size: sizeof(struct rk_frame_info), grows at the end only
+ * @source: RK_FRAME_SRC_*
+ * @dev_id: cif or isp device index
+ * @stream_id: stream of the device
+ * @seq: frame sequence of the stream
+ * @width: output width
+ * @height: output height
+ * @fourcc: output pixel format
+ * @sof_ns: start of frame, boottime on rv1106
+ * @motion: rk_motion_detect moving zones of the last luma frame
+ * @nr_means: valid entries of @luma_mean
+ * @luma_mean: the mipi luma grid means of the last luma frame
+ */
+struct rk_frame_info {
+	__u32 size;
+	__u32 source;
+	__u32 dev_id;
+	__u32 stream_id;
+	__u32 seq;
+	__u32 width;
+	__u32 height;
+	__u32 fourcc;
+	__u64 sof_ns;
+	__u32 motion;
+	__u32 nr_means;
+	__u32 luma_mean[RK_FRAME_MEANS_MAX];
+};
+
+/* verdict: 0 keeps the frame as it is */
+#define RK_FRAME_PASS		0
+/* give the buffer back to the hardware, userspace never sees the frame */
+#define RK_FRAME_DROP		(1 << 0)
+/*
+ * tag of bits 8-15, handed to userspace in timecode.userbits[0] of the
+ * v4l2 buffer with V4L2_BUF_FLAG_TIMECODE set, e.g. to route the frame
+ * to the npu or the recording buffer.
+ */
+#define RK_FRAME_TAG_SHIFT	8
+#define RK_FRAME_TAG_MASK	(0xff << RK_FRAME_TAG_SHIFT)
+#define RK_FRAME_TAG(tag)	(((tag) << RK_FRAME_TAG_SHIFT) & RK_FRAME_TAG_MASK)
+
+#endif
@@ -118,11 +118,20 @@
 /* ADD DATA */
 #define CIFISP_ADD_DATA_FIFO_SIZE		(2048 * 4)
 
+/* stats ring on the statistics video node, see module param stats_ring */
+#define RKISP1_CMD_GET_STATS_RING \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 0, struct rkisp1_stats_ring_info)
+
+#define RKISP1_STATS_RING_MAX			8
+
 /* Private v4l2 event */
 #define CIFISP_V4L2_EVENT_STREAM_START	\
 				(V4L2_EVENT_PRIVATE_START + 1)
 #define CIFISP_V4L2_EVENT_STREAM_STOP	\
 				(V4L2_EVENT_PRIVATE_START + 2)
+/* thermal step-down, u.data holds struct cifisp_cooling_event */
+#define CIFISP_V4L2_EVENT_COOLING	\
+				(V4L2_EVENT_PRIVATE_START + 3)
 
 /*
  * private control id
@@ -869,4 +878,47 @@ struct rkisp1_stat_buffer {
 	struct cifisp_stat params;
 } __attribute__ ((packed));
 
+/**
+ * struct cifisp_cooling_event - thermal cooling state of the isp
+ *
+ * @state: cooling state, 0 is full rate
+ * @max_state: highest cooling state
+ * @fps_percent: share of frames still delivered on the capture nodes
+ */
+struct cifisp_cooling_event {
+	__u32 state;
+	__u32 max_state;
+	__u32 fps_percent;
+} __attribute__ ((packed));
+
+/**
+ * struct rkisp1_stats_ring_head - head of the statistics ring buffer
+ *
+ * @seq: odd during driver update, increase by 2 for each new slot
+ * @wr_idx: slot index of the latest stats
+ * @slot_num: number of slot
+ * @slot_size: size of one slot, struct rkisp1_stat_buffer
+ * @frame_id: frame id of stats in each slot
+ * @timestamp: timestamp of stats in each slot
+ *
+ * slots follow the head at rkisp1_stats_ring_info.head_size offset, same
+ * read protocol as struct rkisp_stats_ring_head of isp2.
+ */
+struct rkisp1_stats_ring_head {
+	__u32 seq;
+	__u32 wr_idx;
+	__u32 slot_num;
+	__u32 slot_size;
+	__u32 frame_id[RKISP1_STATS_RING_MAX];
+	__u64 timestamp[RKISP1_STATS_RING_MAX];
+} __attribute__ ((packed));
+
+struct rkisp1_stats_ring_info {
+	int buf_fd;
+	__u32 buf_size;
+	__u32 head_size;
+	__u32 slot_num;
+	__u32 slot_size;
+} __attribute__ ((packed));
+
 #endif /* _UAPI_RK_ISP1_CONFIG_H */
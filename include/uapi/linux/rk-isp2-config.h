@@ -61,6 +61,17 @@
 #define RKISP_CMD_GET_BAY3D_BUFFD \
 	_IOR('V', BASE_VIDIOC_PRIVATE + 15, struct rkisp_bay3dbuf_info)
 
+/* isp32 3a stats ring, module param stats_ring to enable before stream on */
+#define RKISP_CMD_GET_STATS_RING \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 16, struct rkisp_stats_ring_info)
+
+/* stage a mode switch, e.g. day/night, see struct rkisp_mode_switch */
+#define RKISP_CMD_SET_MODE_SWITCH \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 17, struct rkisp_mode_switch)
+
+#define RKISP_CMD_GET_MODE_SWITCH \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 18, struct rkisp_mode_switch)
+
 /****************ISP VIDEO IOCTL******************************/
 
 #define RKISP_CMD_GET_CSI_MEMORY_MODE \
@@ -107,6 +118,22 @@
 
 #define RKISP_CMD_SET_EXPANDER \
 	_IOW('V', BASE_VIDIOC_PRIVATE + 114, struct rkmodule_hdr_cfg)
+
+/* selfpath snapshot, queued buffers are held and only armed frames captured
+ * >0: arm the number of frames to capture
+ * 0: snapshot mode with no frame armed
+ * <0: back to continuous capture
+ */
+#define RKISP_CMD_SET_SNAPSHOT \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 115, int)
+
+/* local preview, see struct rkisp_direct_show */
+#define RKISP_CMD_SET_DIRECT_SHOW \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 116, struct rkisp_direct_show)
+
+/* map output sizes onto the isp paths, see struct rkisp_multi_output */
+#define RKISP_CMD_SET_MULTI_OUTPUT \
+	_IOWR('V', BASE_VIDIOC_PRIVATE + 117, struct rkisp_multi_output)
 /*************************************************************/
 
 #define ISP2X_ID_DPCC			(0)
@@ -319,9 +346,88 @@ struct rkisp_meshbuf_size {
 	int buf_cnt;
 } __attribute__ ((packed));
 
+/*
+ * table_id is free for userspace to tag the table it wrote. it is 0 in a
+ * newly allocated buffer and kept while the driver reuses the buffer, so
+ * the same table needs no rewrite after a stream restart.
+ */
 struct isp2x_mesh_head {
 	enum isp2x_mesh_buf_stat stat;
 	u32 data_oft;
+	u32 table_id;
+} __attribute__ ((packed));
+
+#define RKISP_STATS_RING_MAX 8
+
+/* rkisp_stats_ring_head: head of stats ring buffer
+ *
+ * @seq: odd during driver update, increase by 2 for each new slot
+ * @wr_idx: slot index of the latest stats
+ * @slot_num: number of slot
+ * @slot_size: size of one slot, struct rkisp32_isp_stat_buffer for isp32
+ * @frame_id: frame id of stats in each slot
+ * @timestamp: frame end timestamp of stats in each slot
+ *
+ * slots follow the head at rkisp_stats_ring_info.head_size offset.
+ * Reader takes seq (even), wr_idx and copies the slot, the copy is valid
+ * if seq is unchanged or has increased less than 2 * (slot_num - 2).
+ */
+struct rkisp_stats_ring_head {
+	__u32 seq;
+	__u32 wr_idx;
+	__u32 slot_num;
+	__u32 slot_size;
+	__u32 frame_id[RKISP_STATS_RING_MAX];
+	__u64 timestamp[RKISP_STATS_RING_MAX];
+} __attribute__ ((packed));
+
+struct rkisp_stats_ring_info {
+	int buf_fd;
+	__u32 buf_size;
+	__u32 head_size;
+	__u32 slot_num;
+	__u32 slot_size;
+} __attribute__ ((packed));
+
+#define RKISP_MODE_SWITCH_CTRL_MAX	8
+
+enum rkisp_mode_switch_state {
+	RKISP_MODE_SWITCH_IDLE = 0,
+	RKISP_MODE_SWITCH_PENDING,
+	RKISP_MODE_SWITCH_DONE,
+	/* staged too late, switched after frame_id */
+	RKISP_MODE_SWITCH_LATE,
+	RKISP_MODE_SWITCH_FAIL,
+};
+
+/* rkisp_mode_switch: mode switch with no stream restart
+ *
+ * the isp params of the new mode are queued as usual with their frame_id
+ * set to frame_id. the sensor controls and the ir-cut action are staged
+ * here and written sensor_delay frames ahead, so the first frame of the
+ * new mode has the new exposure, filter and isp params together.
+ *
+ * @frame_id: first frame of the new mode
+ * @sensor_delay: frames from a sensor control write to its effect
+ * @ircut: V4L2_CID_BAND_STOP_FILTER value for the ir-cut, <0 to leave
+ * @ctrl_num: sensor controls in ctrl
+ * @ctrl: v4l2 control id and value of the sensor
+ * @state: enum rkisp_mode_switch_state, for RKISP_CMD_GET_MODE_SWITCH
+ * @switch_frame_id: first frame in the new mode, for the get
+ * @switch_timestamp: time the controls were written, for the get
+ */
+struct rkisp_mode_switch {
+	__u32 frame_id;
+	__u32 sensor_delay;
+	__s32 ircut;
+	__u32 ctrl_num;
+	struct {
+		__u32 id;
+		__s32 value;
+	} ctrl[RKISP_MODE_SWITCH_CTRL_MAX];
+	__u32 state;
+	__u32 switch_frame_id;
+	__u64 switch_timestamp;
 } __attribute__ ((packed));
 
 struct rkisp_bay3dbuf_info {
@@ -420,6 +526,53 @@ struct rkisp_wrap_info {
 	int height;
 };
 
+/* struct rkisp_direct_show
+ * local preview: done frames are flipped onto a vop plane in kernel and
+ * requeued once off screen, they are not returned to userspace.
+ * set with the stream off, an empty plane detaches.
+ * crtc: crtc name, empty for the first active one
+ * plane: plane name, e.g. "Esmart0-win0"
+ * dst_*: plane window on the crtc, dst_w 0 for the full mode
+ * top_zpos: raise the plane above the others
+ */
+struct rkisp_direct_show {
+	char crtc[32];
+	char plane[32];
+	unsigned int dst_x;
+	unsigned int dst_y;
+	unsigned int dst_w;
+	unsigned int dst_h;
+	unsigned int top_zpos;
+} __attribute__ ((packed));
+
+#define RKISP_MULTI_OUTPUT_MAX	4
+
+/* struct rkisp_output_req
+ * width/height/fourcc: requested output
+ * stream_id: returned stream id of the video node to capture it from
+ * adjusted: returned 1 if only a larger size, written back, is possible
+ */
+struct rkisp_output_req {
+	unsigned int width;
+	unsigned int height;
+	unsigned int fourcc;
+	int stream_id;
+	unsigned char adjusted;
+} __attribute__ ((packed));
+
+/* struct rkisp_multi_output
+ * the requests are spread over the main, self and bypass resizers and
+ * the 1/4 downscale of main and bypass, with the fewest bytes written and
+ * then the fewest resizers in use. set with the paths off.
+ * num: number of requests
+ * try_only: only solve, the formats of the video nodes stay as they are
+ */
+struct rkisp_multi_output {
+	unsigned int num;
+	unsigned char try_only;
+	struct rkisp_output_req out[RKISP_MULTI_OUTPUT_MAX];
+} __attribute__ ((packed));
+
 #define RKISP_TB_STREAM_BUF_MAX 5
 struct rkisp_tb_stream_buf {
 	unsigned int dma_addr;
@@ -69,6 +69,7 @@
 #define ISP39_STAT_DHAZ			ISP3X_STAT_DHAZ
 #define ISP39_STAT_INFO2DDR		BIT(19)
 #define ISP39_STAT_BAY3D		BIT(20)
+#define ISP39_STAT_PDAF			BIT(21)
 
 #define ISP39_MESH_BUF_NUM		ISP3X_MESH_BUF_NUM
 
@@ -1593,10 +1594,27 @@ struct isp39_stat {
 	struct isp32_info2ddr_stat info2ddr;
 } __attribute__ ((packed));
 
+/*
+ * pdaf data of the same frame, valid with ISP39_STAT_PDAF. buf_index is
+ * the index of the rkisp-pdaf video buffer the data is in, already done
+ * or to be dequeued next, so the af reads it in place with no matching
+ * by sequence. the layout is that of the pdaf node format: height lines
+ * of width 16-bit shield pixels each bytesperline apart.
+ */
+struct isp39_pdaf_stat {
+	__u32 frame_id;
+	__u32 buf_index;
+	__u32 width;
+	__u32 height;
+	__u32 bytesperline;
+	__u32 sizeimage;
+} __attribute__ ((packed));
+
 struct rkisp39_stat_buffer {
 	struct isp39_stat stat;
 	__u32 meas_type;
 	__u32 frame_id;
 	__u32 params_id;
+	struct isp39_pdaf_stat pdaf;
 } __attribute__ ((packed));
 #endif /* _UAPI_RK_ISP39_CONFIG_H */
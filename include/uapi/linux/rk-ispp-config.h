@@ -108,6 +108,10 @@
 	_IOW('V', BASE_VIDIOC_PRIVATE + 11, int)
 #define RKISPP_CMD_FEC_BUF_DEL \
 	_IOW('V', BASE_VIDIOC_PRIVATE + 12, int)
+#define RKISPP_CMD_FEC_MESH_SET \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 13, struct rkispp_fec_mesh)
+#define RKISPP_CMD_FEC_IN_OUT_ASYNC \
+	_IOWR('V', BASE_VIDIOC_PRIVATE + 14, struct rkispp_fec_in_out_async)
 
 /************EVENT_PRIVATE**************/
 #define RKISPP_V4L2_EVENT_TNR_COMPLETE  \
@@ -128,6 +132,30 @@ struct rkispp_fec_in_out {
 	int mesh_yfra_fd;
 };
 
+/* mesh of one lens/geometry, mapped once and used by mesh_id */
+struct rkispp_fec_mesh {
+	int mesh_id;
+	int out_width;
+	int out_height;
+	int mesh_xint_fd;
+	int mesh_xfra_fd;
+	int mesh_yint_fd;
+	int mesh_yfra_fd;
+};
+
+/*
+ * queued fec job: starts once in_fence_fd (-1 for none) signals, returns at
+ * once with out_fence_fd signalled when the job is done. with mesh_id >= 0
+ * the mesh fds of io are ignored.
+ */
+struct rkispp_fec_in_out_async {
+	struct rkispp_fec_in_out io;
+	int mesh_id;
+	int in_fence_fd;
+	int out_fence_fd;
+	int reserved;
+};
+
 struct rkispp_buf_idxfd {
 	u32 buf_num;
 	u32 index[MAX_BUF_IDXFD_NUM];
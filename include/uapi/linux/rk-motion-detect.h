@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: ((GPL-2.0+ WITH Linux-syscall-note) OR MIT) */
+/*
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef _UAPI_RK_MOTION_DETECT_H
+#define _UAPI_RK_MOTION_DETECT_H
+
+#include <linux/types.h>
+#include <linux/videodev2.h>
+
+/*
+ * kernel motion detection on the mipi luma grid, set on the luma video
+ * nodes rkisp-mipi-luma and rkcif-mipi-luma. it runs on the luma means of
+ * every frame also while the node is not streaming.
+ */
+#define RK_MD_ZONES_MAX		16
+
+/*
+ * struct rk_md_cfg - motion detection config
+ *
+ * @enable: run the detector
+ * @zone_mask: luma means taking part, bit n for mean n
+ * @threshold: change of a zone mean to its background, in percent
+ * @min_zones: moving zones of a frame to raise an event
+ * @hold_frames: quiet frames before the next event can be raised
+ */
+struct rk_md_cfg {
+	__u32 enable;
+	__u32 zone_mask;
+	__u32 threshold;
+	__u32 min_zones;
+	__u32 hold_frames;
+	__u32 reserved[3];
+};
+
+#define RK_MD_CMD_SET_CFG \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 0, struct rk_md_cfg)
+
+#define RK_MD_CMD_GET_CFG \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 1, struct rk_md_cfg)
+
+#endif
@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: ((GPL-2.0+ WITH Linux-syscall-note) OR MIT) */
+/*
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef _UAPI_RK_VAD_H
+#define _UAPI_RK_VAD_H
+
+#include <linux/types.h>
+
+/*
+ * /dev/vad_preroll, read only mmap of the vad history buffer
+ *
+ * offset 0:                  struct rk_vad_preroll_hdr, one page
+ * offset RK_VAD_PREROLL_HDR: the vad sram ring, hdr.size bytes
+ *
+ * the pre-roll is hdr.bytes bytes starting at ring offset hdr.head and
+ * wrapping at hdr.size. frames are hdr.channels * hdr.sample_bytes
+ * bytes, the detected channels only.
+ *
+ * seq is odd while vad is capturing and the ring is being overwritten,
+ * it turns even once a capture is frozen at wake up. a reader samples
+ * seq, copies or consumes the data, then checks seq is unchanged.
+ */
+#define RK_VAD_PREROLL_HDR	4096
+
+struct rk_vad_preroll_hdr {
+	__u32 seq;
+	__u32 size;
+	__u32 head;
+	__u32 bytes;
+	__u32 channels;
+	__u32 sample_bytes;
+	__u32 h_16bit;
+	__u32 reserved[9];
+};
+
+#endif /* _UAPI_RK_VAD_H */
@@ -51,6 +51,36 @@ struct crypt_fd_map_op {
 	__u32	phys_addr;	/* physics addr */
 };
 
+/* one range of RIOCCRYPT_FD_BATCH */
+struct crypt_fd_range_op {
+	__u32	ses;		/* session identifier, cipher or aead only */
+	__u16	op;		/* COP_ENCRYPT or COP_DECRYPT */
+	__u16	flags;		/* reserved, 0 */
+	__u32	len;		/* length of the payload */
+	__u32	auth_len;	/* aead: length of the aad right before the payload */
+	int	src_fd;		/* source dmabuf */
+	int	dst_fd;		/* destination dmabuf, may equal src_fd */
+	__u32	src_offset;	/* start of aad (or payload) in src_fd */
+	__u32	dst_offset;	/* start of aad (or payload) in dst_fd */
+	__u64	iv;		/* initialization vector */
+	__u32	iv_len;
+	__u32	tag_len;	/* aead: length of the tag, required with tag */
+	__u64	tag;		/* aead: tag out on encrypt, tag in on decrypt */
+	__s32	ret;		/* out: result of this range */
+	__u32	reserved;
+};
+
+#define RK_CRYPT_BATCH_MAX	64
+
+/* input of RIOCCRYPT_FD_BATCH */
+struct crypt_fd_batch_op {
+	__u64	ops;		/* pointer to count struct crypt_fd_range_op */
+	__u32	count;		/* number of ranges, up to RK_CRYPT_BATCH_MAX */
+	int	eventfd;	/* -1: run synchronously, else signalled when done */
+	__u32	flags;		/* reserved, 0 */
+	__u32	reserved;
+};
+
 #define AOP_ENCRYPT	0
 #define AOP_DECRYPT	1
 
@@ -81,5 +111,6 @@ struct crypt_rsa_op {
 #define RIOCCRYPT_DEV_ACCESS	_IOW('r',  108, struct crypt_fd_map_op)
 #define RIOCCRYPT_RSA_CRYPT	_IOWR('r', 109, struct crypt_rsa_op)
 #define RIOCAUTHCRYPT_FD	_IOWR('r', 110, struct crypt_auth_fd_op)
+#define RIOCCRYPT_FD_BATCH	_IOW('r',  111, struct crypt_fd_batch_op)
 
 #endif
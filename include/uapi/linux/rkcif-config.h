@@ -42,6 +42,26 @@
 #define RKCIF_CMD_START_CAPTURE_ONE_FRAME_AOV \
 	_IOW('V', BASE_VIDIOC_PRIVATE + 9, int)
 
+#define RKCIF_CMD_SET_BACKPRESSURE \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 10, struct rkcif_backpressure)
+
+/* source mipi id of a scale channel, several channels may share one source */
+#define RKCIF_CMD_GET_SCALE_SRC \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 11, int)
+
+#define RKCIF_CMD_SET_SCALE_SRC \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 12, int)
+
+/* tools node shares capture buffers by dmabuf instead of copying them */
+#define RKCIF_CMD_SET_TOOLS_SHARE \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 13, int)
+
+#define RKCIF_CMD_GET_TOOLS_FRAME \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 14, struct rkcif_tools_frame)
+
+#define RKCIF_CMD_PUT_TOOLS_FRAME \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 15, __u32)
+
 /* cif memory mode
  * 0: raw12/raw10/raw8 8bit memory compact
  * 1: raw12/raw10 16bit memory one pixel
@@ -91,4 +111,32 @@ struct rkcif_quick_stream_param {
 	int resume_mode;
 };
 
+/* adaptive frame skip driven by the downstream consumer
+ * depth: frames the consumer has queued but not yet processed
+ * high_wm: raise the hw skip ratio one step when depth >= high_wm
+ * low_wm: lower the hw skip ratio one step when depth <= low_wm
+ *
+ * high_wm 0 turns adaptive skip off and restores the RKCIF_CMD_SET_FPS config
+ */
+struct rkcif_backpressure {
+	__u32 depth;
+	__u32 high_wm;
+	__u32 low_wm;
+};
+
+/* capture frame shared with the tools node
+ * fd: dmabuf of plane 0 of the capture buffer, closed by the caller
+ * index: capture buffer index, handed back by RKCIF_CMD_PUT_TOOLS_FRAME
+ *
+ * the capture buffer is requeued to hw only after both the capture
+ * owner and the tools user have released it
+ */
+struct rkcif_tools_frame {
+	__s32 fd;
+	__u32 index;
+	__u32 sequence;
+	__u32 bytesused;
+	__u64 timestamp;
+};
+
 #endif
@@ -14,7 +14,10 @@
 #include <linux/rculist_nulls.h>
 #include <linux/cpu.h>
 #include <linux/tracehook.h>
+#include <linux/sched/rt.h>
+#include <linux/sched/deadline.h>
 #include <uapi/linux/io_uring.h>
+#include <uapi/linux/sched/types.h>
 
 #include "io-wq.h"
 
@@ -121,6 +124,11 @@ struct io_wq {
 	struct hlist_node cpuhp_node;
 
 	struct task_struct *task;
+	bool inherit;
+
+	atomic_long_t nr_enqueued;
+	atomic_long_t nr_no_free;
+	atomic_long_t nr_created;
 
 	struct io_wqe *wqes[];
 };
@@ -606,6 +614,27 @@ static void io_worker_handle_work(struct io_worker *worker)
 	} while (1);
 }
 
+/*
+ * Run at the priority the submitter has now rather than the one of
+ * whichever task forked the first worker. A deadline submitter can't be
+ * copied, its workers stay at the forked policy.
+ */
+static void io_wq_inherit_sched(struct task_struct *task)
+{
+	struct sched_attr attr = {
+		.size		= sizeof(attr),
+		.sched_policy	= READ_ONCE(task->policy),
+	};
+
+	if (dl_task(task))
+		return;
+	if (task_is_realtime(task))
+		attr.sched_priority = task->rt_priority;
+	else
+		attr.sched_nice = task_nice(task);
+	sched_setattr_nocheck(current, &attr);
+}
+
 static int io_wqe_worker(void *data)
 {
 	struct io_worker *worker = data;
@@ -619,6 +648,8 @@ static int io_wqe_worker(void *data)
 
 	snprintf(buf, sizeof(buf), "iou-wrk-%d", wq->task->pid);
 	set_task_comm(current, buf);
+	if (wq->inherit)
+		io_wq_inherit_sched(wq->task);
 
 	while (!test_bit(IO_WQ_BIT_EXIT, &wq->state)) {
 		long ret;
@@ -708,6 +739,7 @@ static void io_init_new_worker(struct io_wqe *wqe, struct io_worker *worker,
 	worker->task = tsk;
 	set_cpus_allowed_ptr(tsk, wqe->cpu_mask);
 	tsk->flags |= PF_NO_SETAFFINITY;
+	atomic_long_inc(&wqe->wq->nr_created);
 
 	raw_spin_lock(&wqe->lock);
 	hlist_nulls_add_head_rcu(&worker->nulls_node, &wqe->free_list);
@@ -927,6 +959,9 @@ static void io_wqe_enqueue(struct io_wqe *wqe, struct io_wq_work *work)
 
 	raw_spin_unlock(&wqe->lock);
 
+	if (do_create)
+		atomic_long_inc(&wqe->wq->nr_no_free);
+
 	if (do_create && ((work_flags & IO_WQ_WORK_CONCURRENT) ||
 	    !atomic_read(&acct->nr_running))) {
 		bool did_create;
@@ -955,6 +990,7 @@ void io_wq_enqueue(struct io_wq *wq, struct io_wq_work *work)
 {
 	struct io_wqe *wqe = wq->wqes[numa_node_id()];
 
+	atomic_long_inc(&wq->nr_enqueued);
 	io_wqe_enqueue(wqe, work);
 }
 
@@ -1120,10 +1156,20 @@ static int io_wqe_hash_wake(struct wait_queue_entry *wait, unsigned mode,
 	return 1;
 }
 
+/* the cpus of node, less those the submitter may not run on */
+static void io_wqe_init_cpu_mask(struct io_wqe *wqe, int node,
+				 struct task_struct *task, bool inherit)
+{
+	cpumask_copy(wqe->cpu_mask, cpumask_of_node(node));
+	if (inherit && cpumask_intersects(wqe->cpu_mask, task->cpus_ptr))
+		cpumask_and(wqe->cpu_mask, wqe->cpu_mask, task->cpus_ptr);
+}
+
 struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data)
 {
 	int ret, node, i;
 	struct io_wq *wq;
+	unsigned long unbound;
 
 	if (WARN_ON_ONCE(!data->free_work || !data->do_work))
 		return ERR_PTR(-EINVAL);
@@ -1141,6 +1187,11 @@ struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data)
 	wq->hash = data->hash;
 	wq->free_work = data->free_work;
 	wq->do_work = data->do_work;
+	wq->inherit = data->inherit;
+
+	unbound = task_rlimit(current, RLIMIT_NPROC);
+	if (data->max_unbound)
+		unbound = min_t(unsigned long, unbound, data->max_unbound);
 
 	ret = -ENOMEM;
 	for_each_node(node) {
@@ -1155,11 +1206,10 @@ struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data)
 		wq->wqes[node] = wqe;
 		if (!alloc_cpumask_var(&wqe->cpu_mask, GFP_KERNEL))
 			goto err;
-		cpumask_copy(wqe->cpu_mask, cpumask_of_node(node));
+		io_wqe_init_cpu_mask(wqe, node, data->task, data->inherit);
 		wqe->node = alloc_node;
 		wqe->acct[IO_WQ_ACCT_BOUND].max_workers = bounded;
-		wqe->acct[IO_WQ_ACCT_UNBOUND].max_workers =
-					task_rlimit(current, RLIMIT_NPROC);
+		wqe->acct[IO_WQ_ACCT_UNBOUND].max_workers = unbound;
 		INIT_LIST_HEAD(&wqe->wait.entry);
 		wqe->wait.func = io_wqe_hash_wake;
 		for (i = 0; i < IO_WQ_ACCT_NR; i++) {
@@ -1332,7 +1382,7 @@ int io_wq_cpu_affinity(struct io_wq *wq, cpumask_var_t mask)
 		if (mask)
 			cpumask_copy(wqe->cpu_mask, mask);
 		else
-			cpumask_copy(wqe->cpu_mask, cpumask_of_node(i));
+			io_wqe_init_cpu_mask(wqe, i, wq->task, wq->inherit);
 	}
 	rcu_read_unlock();
 	return 0;
@@ -1384,6 +1434,30 @@ int io_wq_max_workers(struct io_wq *wq, int *new_count)
 	return 0;
 }
 
+void io_wq_get_stats(struct io_wq *wq, struct io_wq_stats *stats)
+{
+	int i, node;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->enqueued = atomic_long_read(&wq->nr_enqueued);
+	stats->no_free = atomic_long_read(&wq->nr_no_free);
+	stats->created = atomic_long_read(&wq->nr_created);
+
+	rcu_read_lock();
+	for_each_node(node) {
+		struct io_wqe *wqe = wq->wqes[node];
+
+		raw_spin_lock(&wqe->lock);
+		for (i = 0; i < IO_WQ_ACCT_NR; i++) {
+			stats->nr_workers[i] += wqe->acct[i].nr_workers;
+			stats->max_workers[i] = max(stats->max_workers[i],
+						    wqe->acct[i].max_workers);
+		}
+		raw_spin_unlock(&wqe->lock);
+	}
+	rcu_read_unlock();
+}
+
 static __init int io_wq_init(void)
 {
 	int ret;
@@ -129,6 +129,21 @@ struct io_wq_data {
 	struct task_struct *task;
 	io_wq_work_fn *do_work;
 	free_work_fn *free_work;
+	/* 0 for RLIMIT_NPROC */
+	unsigned int max_unbound;
+	/* workers take the cpus and scheduling policy of task */
+	bool inherit;
+};
+
+struct io_wq_stats {
+	/* works queued from the ring */
+	unsigned long enqueued;
+	/* of those, found no idle worker */
+	unsigned long no_free;
+	/* worker threads started */
+	unsigned long created;
+	unsigned int nr_workers[2];
+	unsigned int max_workers[2];
 };
 
 struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data);
@@ -140,6 +155,7 @@ void io_wq_hash_work(struct io_wq_work *work, void *val);
 
 int io_wq_cpu_affinity(struct io_wq *wq, cpumask_var_t mask);
 int io_wq_max_workers(struct io_wq *wq, int *new_count);
+void io_wq_get_stats(struct io_wq *wq, struct io_wq_stats *stats);
 
 static inline bool io_wq_is_hashed(struct io_wq_work *work)
 {
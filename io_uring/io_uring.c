@@ -79,6 +79,7 @@
 #include <linux/pagemap.h>
 #include <linux/io_uring.h>
 #include <linux/tracehook.h>
+#include <linux/moduleparam.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/io_uring.h>
@@ -103,6 +104,27 @@
 
 #define IORING_MAX_REG_BUFFERS	(1U << 14)
 
+/*
+ * io-wq sizing for small cores, every extra worker is a context switch
+ * taken from the threads the submitter runs next to. the per ring limits
+ * of IORING_REGISTER_IOWQ_MAX_WORKERS still apply on top.
+ */
+static unsigned int iowq_max_bound;
+module_param(iowq_max_bound, uint, 0644);
+MODULE_PARM_DESC(iowq_max_bound, "Bound io-wq workers per task and node, 0 for min(sq depth, 4 * cpus)");
+
+static unsigned int iowq_max_unbound;
+module_param(iowq_max_unbound, uint, 0644);
+MODULE_PARM_DESC(iowq_max_unbound, "Unbound io-wq workers per task and node, 0 for RLIMIT_NPROC");
+
+static bool iowq_inherit;
+module_param(iowq_inherit, bool, 0644);
+MODULE_PARM_DESC(iowq_inherit, "io-wq workers run on the cpus and at the priority of the submitter");
+
+static bool offload_blocking_only;
+module_param(offload_blocking_only, bool, 0644);
+MODULE_PARM_DESC(offload_blocking_only, "Try IOSQE_ASYNC requests nonblocking first, punt only when they would block");
+
 #define SQE_VALID_FLAGS	(IOSQE_FIXED_FILE|IOSQE_IO_DRAIN|IOSQE_IO_LINK|	\
 				IOSQE_IO_HARDLINK | IOSQE_ASYNC | \
 				IOSQE_BUFFER_SELECT)
@@ -194,11 +216,6 @@ struct io_rings {
 	struct io_uring_cqe	cqes[] ____cacheline_aligned_in_smp;
 };
 
-enum io_uring_cmd_flags {
-	IO_URING_F_NONBLOCK		= 1,
-	IO_URING_F_COMPLETE_DEFER	= 2,
-};
-
 struct io_mapped_ubuf {
 	u64		ubuf;
 	u64		ubuf_end;
@@ -458,6 +475,8 @@ struct io_ring_ctx {
 		struct completion		ref_comp;
 		u32				iowq_limits[2];
 		bool				iowq_limits_set;
+		/* sqes consumed, against the io-wq punts in fdinfo */
+		unsigned long			nr_sqes;
 	};
 };
 
@@ -860,6 +879,7 @@ struct io_kiocb {
 		struct io_mkdir		mkdir;
 		struct io_symlink	symlink;
 		struct io_hardlink	hardlink;
+		struct io_uring_cmd	uring_cmd;
 		/* use only after cleaning per-op data, see io_clean_op() */
 		struct io_completion	compl;
 	};
@@ -1075,6 +1095,40 @@ static const struct io_op_def io_op_defs[] = {
 	},
 	[IORING_OP_RENAMEAT] = {},
 	[IORING_OP_UNLINKAT] = {},
+	[IORING_OP_MKDIRAT] = {
+		.not_supported		= 1,
+	},
+	[IORING_OP_SYMLINKAT] = {
+		.not_supported		= 1,
+	},
+	[IORING_OP_LINKAT] = {
+		.not_supported		= 1,
+	},
+	[IORING_OP_MSG_RING] = {
+		.not_supported		= 1,
+	},
+	[IORING_OP_FSETXATTR] = {
+		.not_supported		= 1,
+	},
+	[IORING_OP_SETXATTR] = {
+		.not_supported		= 1,
+	},
+	[IORING_OP_FGETXATTR] = {
+		.not_supported		= 1,
+	},
+	[IORING_OP_GETXATTR] = {
+		.not_supported		= 1,
+	},
+	[IORING_OP_SOCKET] = {
+		.not_supported		= 1,
+	},
+	[IORING_OP_URING_CMD] = {
+		.needs_file		= 1,
+		.unbound_nonreg_file	= 1,
+		.needs_async_setup	= 1,
+		.plug			= 1,
+		.async_size		= IORING_URING_CMD_SIZE,
+	},
 };
 
 /* requests with any of those set should undergo io_disarm_next() */
@@ -3849,6 +3903,94 @@ static int io_unlinkat(struct io_kiocb *req, unsigned int issue_flags)
 	return 0;
 }
 
+static void io_uring_cmd_work(struct io_kiocb *req, bool *locked)
+{
+	req->uring_cmd.task_work_cb(&req->uring_cmd);
+}
+
+void io_uring_cmd_complete_in_task(struct io_uring_cmd *ioucmd,
+			void (*task_work_cb)(struct io_uring_cmd *))
+{
+	struct io_kiocb *req = container_of(ioucmd, struct io_kiocb, uring_cmd);
+
+	ioucmd->task_work_cb = task_work_cb;
+	req->io_task_work.func = io_uring_cmd_work;
+	io_req_task_work_add(req);
+}
+EXPORT_SYMBOL_GPL(io_uring_cmd_complete_in_task);
+
+/*
+ * Completion of a command that ->uring_cmd() returned -EIOCBQUEUED for, may
+ * be called from any context.
+ */
+void io_uring_cmd_done(struct io_uring_cmd *ioucmd, ssize_t ret)
+{
+	struct io_kiocb *req = container_of(ioucmd, struct io_kiocb, uring_cmd);
+
+	if (ret < 0)
+		req_set_fail(req);
+	req->result = ret;
+	req->io_task_work.func = io_req_task_complete;
+	io_req_task_work_add(req);
+}
+EXPORT_SYMBOL_GPL(io_uring_cmd_done);
+
+static int io_uring_cmd_prep(struct io_kiocb *req,
+			     const struct io_uring_sqe *sqe)
+{
+	struct io_uring_cmd *ioucmd = &req->uring_cmd;
+
+	if (unlikely(req->ctx->flags & IORING_SETUP_IOPOLL))
+		return -EOPNOTSUPP;
+	if (unlikely(sqe->ioprio || sqe->uring_cmd_flags || sqe->buf_index ||
+		     sqe->splice_fd_in))
+		return -EINVAL;
+
+	/* points into the sq ring until the command goes async */
+	ioucmd->cmd = sqe->cmd;
+	ioucmd->cmd_op = READ_ONCE(sqe->cmd_op);
+	ioucmd->flags = 0;
+	return 0;
+}
+
+static int io_uring_cmd_prep_async(struct io_kiocb *req)
+{
+	memcpy(req->async_data, req->uring_cmd.cmd, IORING_URING_CMD_SIZE);
+	req->uring_cmd.cmd = req->async_data;
+	return 0;
+}
+
+static int io_uring_cmd(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_uring_cmd *ioucmd = &req->uring_cmd;
+	struct file *file = req->file;
+	int ret;
+
+	if (!file->f_op->uring_cmd)
+		return -EOPNOTSUPP;
+
+	if (req->ctx->compat)
+		issue_flags |= IO_URING_F_COMPAT;
+
+	ret = file->f_op->uring_cmd(ioucmd, issue_flags);
+	if (ret == -EAGAIN && (issue_flags & IO_URING_F_NONBLOCK)) {
+		/* the sqe is gone by the time io-wq runs it */
+		if (!req->async_data) {
+			if (io_alloc_async_data(req))
+				return -ENOMEM;
+			io_uring_cmd_prep_async(req);
+		}
+		return -EAGAIN;
+	}
+	if (ret == -EIOCBQUEUED)
+		return 0;
+
+	if (ret < 0)
+		req_set_fail(req);
+	__io_req_complete(req, issue_flags, ret, 0);
+	return 0;
+}
+
 static int io_shutdown_prep(struct io_kiocb *req,
 			    const struct io_uring_sqe *sqe)
 {
@@ -6378,6 +6520,8 @@ static int io_req_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 		return io_renameat_prep(req, sqe);
 	case IORING_OP_UNLINKAT:
 		return io_unlinkat_prep(req, sqe);
+	case IORING_OP_URING_CMD:
+		return io_uring_cmd_prep(req, sqe);
 	}
 
 	printk_once(KERN_WARNING "io_uring: unhandled opcode %d\n",
@@ -6405,6 +6549,8 @@ static int io_req_prep_async(struct io_kiocb *req)
 		return io_recvmsg_prep_async(req);
 	case IORING_OP_CONNECT:
 		return io_connect_prep_async(req);
+	case IORING_OP_URING_CMD:
+		return io_uring_cmd_prep_async(req);
 	}
 	printk_once(KERN_WARNING "io_uring: prep_async() bad opcode %d\n",
 		    req->opcode);
@@ -6672,6 +6818,9 @@ static int io_issue_sqe(struct io_kiocb *req, unsigned int issue_flags)
 	case IORING_OP_UNLINKAT:
 		ret = io_unlinkat(req, issue_flags);
 		break;
+	case IORING_OP_URING_CMD:
+		ret = io_uring_cmd(req, issue_flags);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
@@ -6988,8 +7137,12 @@ static int io_init_req(struct io_ring_ctx *ctx, struct io_kiocb *req,
 		return -EINVAL;
 	if (unlikely(req->opcode >= IORING_OP_LAST))
 		return -EINVAL;
+	if (unlikely(io_op_defs[req->opcode].not_supported))
+		return -EOPNOTSUPP;
 	if (!io_check_restriction(ctx, req, sqe_flags))
 		return -EACCES;
+	if ((sqe_flags & IOSQE_ASYNC) && READ_ONCE(offload_blocking_only))
+		req->flags &= ~REQ_F_FORCE_ASYNC;
 
 	if ((sqe_flags & IOSQE_BUFFER_SELECT) &&
 	    !io_op_defs[req->opcode].buffer_select)
@@ -7220,6 +7373,8 @@ static int io_submit_sqes(struct io_ring_ctx *ctx, unsigned int nr)
 		current->io_uring->cached_refs += unused;
 		percpu_ref_put_many(&ctx->refs, unused);
 	}
+	if (submitted > 0)
+		ctx->nr_sqes += submitted;
 
 	io_submit_state_end(&ctx->submit_state, ctx);
 	 /* Commit SQ ring head once we've consumed and submitted all SQEs */
@@ -8498,9 +8653,13 @@ static struct io_wq *io_init_wq_offload(struct io_ring_ctx *ctx,
 	data.task = task;
 	data.free_work = io_wq_free_work;
 	data.do_work = io_wq_submit_work;
+	data.max_unbound = READ_ONCE(iowq_max_unbound);
+	data.inherit = READ_ONCE(iowq_inherit);
 
 	/* Do QD, or 4 * CPUS, whatever is smallest */
 	concurrency = min(ctx->sq_entries, 4 * num_online_cpus());
+	if (READ_ONCE(iowq_max_bound))
+		concurrency = min(concurrency, READ_ONCE(iowq_max_bound));
 
 	return io_wq_create(concurrency, &data);
 }
@@ -10022,6 +10181,26 @@ static void __io_uring_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m)
 
 	seq_printf(m, "SqThread:\t%d\n", sq ? task_pid_nr(sq->thread) : -1);
 	seq_printf(m, "SqThreadCpu:\t%d\n", sq ? task_cpu(sq->thread) : -1);
+	seq_printf(m, "Sqes:\t%lu\n", READ_ONCE(ctx->nr_sqes));
+	if (has_lock) {
+		struct io_tctx_node *node;
+		struct io_wq_stats stats;
+
+		list_for_each_entry(node, &ctx->tctx_list, ctx_node) {
+			struct io_uring_task *tctx = node->task->io_uring;
+
+			if (!tctx->io_wq)
+				continue;
+			io_wq_get_stats(tctx->io_wq, &stats);
+			seq_printf(m, "IoWq %d:\tpunts:%lu no_free:%lu created:%lu bound:%u/%u unbound:%u/%u\n",
+				   task_pid_nr(node->task), stats.enqueued,
+				   stats.no_free, stats.created,
+				   stats.nr_workers[IO_WQ_BOUND],
+				   stats.max_workers[IO_WQ_BOUND],
+				   stats.nr_workers[IO_WQ_UNBOUND],
+				   stats.max_workers[IO_WQ_UNBOUND]);
+		}
+	}
 	seq_printf(m, "UserFiles:\t%u\n", ctx->nr_user_files);
 	for (i = 0; has_lock && i < ctx->nr_user_files; i++) {
 		struct file *f = io_file_from_index(ctx, i);
@@ -10946,6 +11125,11 @@ static int __init io_uring_init(void)
 	BUILD_BUG_SQE_ELEM(42, __u16,  personality);
 	BUILD_BUG_SQE_ELEM(44, __s32,  splice_fd_in);
 	BUILD_BUG_SQE_ELEM(44, __u32,  file_index);
+	BUILD_BUG_SQE_ELEM(8,  __u32,  cmd_op);
+	BUILD_BUG_SQE_ELEM(28, __u32,  uring_cmd_flags);
+	BUILD_BUG_SQE_ELEM(48, __u64,  addr3);
+	BUILD_BUG_ON(offsetof(struct io_uring_sqe, cmd) + IORING_URING_CMD_SIZE !=
+		     sizeof(struct io_uring_sqe));
 
 	BUILD_BUG_ON(sizeof(struct io_uring_files_update) !=
 		     sizeof(struct io_uring_rsrc_update));
@@ -0,0 +1,439 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Hardware accelerator time controller for cgroups.
+ *
+ * The video codecs (mpp), the 2d engines (rga) and the npu run jobs that
+ * userspace queues, one at a time per core and without preemption inside
+ * a job. Their schedulers charge the hardware time of every job to the
+ * cgroup of the submitter and ask this controller which queued job to run
+ * next, so that tenants sharing the accelerators get them by weight and
+ * can be capped.
+ *
+ * hwaccel.weight holds a weight per accelerator, 1 to 10000, default 100.
+ * Siblings which all have jobs queued get hardware time in proportion to
+ * their weights. An idle cgroup does not bank time: it restarts from the
+ * virtual time of the sibling that ran last.
+ *
+ * hwaccel.max holds "$MAX $PERIOD" per accelerator, in microseconds, like
+ * cpu.max. Jobs of a cgroup that has used $MAX of hardware time in the
+ * current period are not started until the next one. Jobs are not cut, a
+ * long one overruns the quota and the excess is paid back in the periods
+ * after. Limits are hierarchical, a job runs only if no ancestor is over.
+ *
+ * hwaccel.stat is hierarchical like cpu.stat, one line per accelerator:
+ * the hardware time used, the number of jobs, the number of periods the
+ * cgroup was throttled in and the time it was held back.
+ *
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+
+#include <linux/cgroup.h>
+#include <linux/cgroup_hwaccel.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+#define HWACCEL_MAX_STR		"max"
+#define HWACCEL_WEIGHT_DFL	100
+#define HWACCEL_WEIGHT_MAX	10000
+#define HWACCEL_PERIOD_DFL_US	100000
+#define HWACCEL_PERIOD_MIN_US	1000
+#define HWACCEL_PERIOD_MAX_US	USEC_PER_SEC
+
+static const char * const hwaccel_names[HWACCEL_TYPE_MAX] = {
+	[HWACCEL_MPP] = "mpp",
+	[HWACCEL_RGA] = "rga",
+	[HWACCEL_NPU] = "npu",
+};
+
+struct hwaccel_res {
+	/* config */
+	u32 weight;
+	u64 max_ns;
+	u64 period_ns;
+
+	/* bandwidth of the current period */
+	u64 period_start;
+	u64 period_usage;
+	u64 throttled_at;
+	bool throttled;
+
+	/* weight, virtual time of this cgroup among its siblings */
+	u64 vtime;
+	/* vtime of the children, an idle child restarts from here */
+	u64 vclock;
+
+	/* stat */
+	u64 usage_ns;
+	u64 nr_jobs;
+	u64 nr_throttled;
+	u64 throttled_ns;
+};
+
+struct hwaccel_cgroup {
+	struct cgroup_subsys_state	css;
+
+	/* taken from the irq of the accelerators */
+	spinlock_t			lock;
+	struct hwaccel_res		res[HWACCEL_TYPE_MAX];
+};
+
+static struct hwaccel_cgroup *css_hwaccel(struct cgroup_subsys_state *css)
+{
+	return css ? container_of(css, struct hwaccel_cgroup, css) : NULL;
+}
+
+static struct hwaccel_cgroup *parent_hwaccel(struct hwaccel_cgroup *hwcg)
+{
+	return css_hwaccel(hwcg->css.parent);
+}
+
+static struct cgroup_subsys_state *
+hwaccel_css_alloc(struct cgroup_subsys_state *parent)
+{
+	struct hwaccel_cgroup *hwcg;
+	int i;
+
+	hwcg = kzalloc(sizeof(*hwcg), GFP_KERNEL);
+	if (!hwcg)
+		return ERR_PTR(-ENOMEM);
+
+	spin_lock_init(&hwcg->lock);
+	for (i = 0; i < HWACCEL_TYPE_MAX; i++) {
+		hwcg->res[i].weight = HWACCEL_WEIGHT_DFL;
+		hwcg->res[i].max_ns = U64_MAX;
+		hwcg->res[i].period_ns = HWACCEL_PERIOD_DFL_US * NSEC_PER_USEC;
+	}
+
+	return &hwcg->css;
+}
+
+static void hwaccel_css_free(struct cgroup_subsys_state *css)
+{
+	kfree(css_hwaccel(css));
+}
+
+/* with hwcg->lock held, start the period now is in */
+static void hwaccel_res_roll(struct hwaccel_res *res, u64 now)
+{
+	u64 end = res->period_start + res->period_ns;
+	u64 periods, paid;
+
+	if (now < end)
+		return;
+
+	if (res->throttled) {
+		res->throttled_ns += end - res->throttled_at;
+		res->throttled = false;
+	}
+
+	periods = div64_u64(now - res->period_start, res->period_ns);
+	res->period_start += periods * res->period_ns;
+	/* an overrun is paid back, the unused quota is not kept */
+	if (res->max_ns == U64_MAX ||
+	    periods > div64_u64(U64_MAX, res->max_ns))
+		paid = U64_MAX;
+	else
+		paid = periods * res->max_ns;
+	res->period_usage = res->period_usage > paid ?
+			    res->period_usage - paid : 0;
+}
+
+struct hwaccel_cgroup *hwaccel_cgroup_get(void)
+{
+	return css_hwaccel(task_get_css(current, hwaccel_cgrp_id));
+}
+EXPORT_SYMBOL_GPL(hwaccel_cgroup_get);
+
+void hwaccel_cgroup_put(struct hwaccel_cgroup *hwcg)
+{
+	if (hwcg)
+		css_put(&hwcg->css);
+}
+EXPORT_SYMBOL_GPL(hwaccel_cgroup_put);
+
+/* ns of hardware time a job of hwcg has taken, up the hierarchy */
+void hwaccel_cgroup_charge(struct hwaccel_cgroup *hwcg,
+			   enum hwaccel_type type, u64 ns)
+{
+	struct hwaccel_cgroup *parent;
+	struct hwaccel_res *res;
+	unsigned long flags;
+	u64 now = ktime_get_ns();
+	u64 child_start = 0;
+	u64 delta;
+
+	for (; hwcg; hwcg = parent) {
+		parent = parent_hwaccel(hwcg);
+		res = &hwcg->res[type];
+
+		spin_lock_irqsave(&hwcg->lock, flags);
+		res->usage_ns += ns;
+		res->nr_jobs++;
+		hwaccel_res_roll(res, now);
+		res->period_usage += ns;
+		/* the clock of the children follows the one that just ran */
+		res->vclock = max(res->vclock, child_start);
+		if (parent) {
+			delta = div_u64(ns * HWACCEL_WEIGHT_DFL, res->weight);
+			res->vtime = max(res->vtime, READ_ONCE(parent->res[type].vclock));
+			child_start = res->vtime;
+			res->vtime += delta;
+		}
+		spin_unlock_irqrestore(&hwcg->lock, flags);
+	}
+}
+EXPORT_SYMBOL_GPL(hwaccel_cgroup_charge);
+
+/*
+ * 0 if a job of hwcg may be started now, else the ns until the next
+ * period of the cgroup, or of the ancestor that holds it back.
+ */
+u64 hwaccel_cgroup_throttled(struct hwaccel_cgroup *hwcg,
+			     enum hwaccel_type type)
+{
+	struct hwaccel_res *res;
+	unsigned long flags;
+	u64 now = ktime_get_ns();
+	u64 wait = 0;
+
+	for (; hwcg; hwcg = parent_hwaccel(hwcg)) {
+		res = &hwcg->res[type];
+		if (READ_ONCE(res->max_ns) == U64_MAX)
+			continue;
+
+		spin_lock_irqsave(&hwcg->lock, flags);
+		hwaccel_res_roll(res, now);
+		if (res->period_usage >= res->max_ns) {
+			if (!res->throttled) {
+				res->throttled = true;
+				res->throttled_at = now;
+				res->nr_throttled++;
+			}
+			wait = max(wait, res->period_start + res->period_ns - now);
+		}
+		spin_unlock_irqrestore(&hwcg->lock, flags);
+	}
+
+	return wait;
+}
+EXPORT_SYMBOL_GPL(hwaccel_cgroup_throttled);
+
+/*
+ * < 0 if a job of a should run before one of b, > 0 if after. Decided by
+ * the vtime of the two siblings below their closest common ancestor,
+ * 0 for the same cgroup or when one is an ancestor of the other, where
+ * the scheduler keeps its own order.
+ */
+int hwaccel_cgroup_cmp(struct hwaccel_cgroup *a, struct hwaccel_cgroup *b,
+		       enum hwaccel_type type)
+{
+	struct hwaccel_cgroup *ca = NULL, *cb = NULL;
+	u64 vclock, va, vb;
+
+	if (!a || !b)
+		return 0;
+
+	while (a != b) {
+		if (a->css.cgroup->level >= b->css.cgroup->level) {
+			ca = a;
+			a = parent_hwaccel(a);
+		} else {
+			cb = b;
+			b = parent_hwaccel(b);
+		}
+	}
+	if (!ca || !cb)
+		return 0;
+
+	vclock = READ_ONCE(a->res[type].vclock);
+	va = max(READ_ONCE(ca->res[type].vtime), vclock);
+	vb = max(READ_ONCE(cb->res[type].vtime), vclock);
+	if (va == vb)
+		return 0;
+
+	return va < vb ? -1 : 1;
+}
+EXPORT_SYMBOL_GPL(hwaccel_cgroup_cmp);
+
+static int hwaccel_parse_type(char **buf)
+{
+	char *name = strsep(buf, " ");
+	int i;
+
+	for (i = 0; i < HWACCEL_TYPE_MAX; i++)
+		if (name && !strcmp(name, hwaccel_names[i]))
+			return i;
+
+	return -EINVAL;
+}
+
+static int hwaccel_weight_show(struct seq_file *sf, void *v)
+{
+	struct hwaccel_cgroup *hwcg = css_hwaccel(seq_css(sf));
+	int i;
+
+	for (i = 0; i < HWACCEL_TYPE_MAX; i++)
+		seq_printf(sf, "%s %u\n", hwaccel_names[i],
+			   READ_ONCE(hwcg->res[i].weight));
+
+	return 0;
+}
+
+/* "$TYPE $WEIGHT" */
+static ssize_t hwaccel_weight_write(struct kernfs_open_file *of, char *buf,
+				    size_t nbytes, loff_t off)
+{
+	struct hwaccel_cgroup *hwcg = css_hwaccel(of_css(of));
+	u32 weight;
+	int type, err;
+
+	buf = strstrip(buf);
+	type = hwaccel_parse_type(&buf);
+	if (type < 0 || !buf)
+		return -EINVAL;
+
+	err = kstrtou32(skip_spaces(buf), 0, &weight);
+	if (err)
+		return err;
+	if (!weight || weight > HWACCEL_WEIGHT_MAX)
+		return -ERANGE;
+
+	spin_lock_irq(&hwcg->lock);
+	hwcg->res[type].weight = weight;
+	spin_unlock_irq(&hwcg->lock);
+
+	return nbytes;
+}
+
+static int hwaccel_max_show(struct seq_file *sf, void *v)
+{
+	struct hwaccel_cgroup *hwcg = css_hwaccel(seq_css(sf));
+	struct hwaccel_res *res;
+	u64 max_ns, period_ns;
+	int i;
+
+	for (i = 0; i < HWACCEL_TYPE_MAX; i++) {
+		res = &hwcg->res[i];
+		spin_lock_irq(&hwcg->lock);
+		max_ns = res->max_ns;
+		period_ns = res->period_ns;
+		spin_unlock_irq(&hwcg->lock);
+
+		seq_printf(sf, "%s ", hwaccel_names[i]);
+		if (max_ns == U64_MAX)
+			seq_printf(sf, "%s", HWACCEL_MAX_STR);
+		else
+			seq_printf(sf, "%llu", div_u64(max_ns, NSEC_PER_USEC));
+		seq_printf(sf, " %llu\n", div_u64(period_ns, NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
+/* "$TYPE $MAX [$PERIOD]", $MAX may be "max" */
+static ssize_t hwaccel_max_write(struct kernfs_open_file *of, char *buf,
+				 size_t nbytes, loff_t off)
+{
+	struct hwaccel_cgroup *hwcg = css_hwaccel(of_css(of));
+	struct hwaccel_res *res;
+	u64 max_us = U64_MAX, period_us = 0;
+	u64 now;
+	char *tok;
+	int type, err;
+
+	buf = strstrip(buf);
+	type = hwaccel_parse_type(&buf);
+	if (type < 0 || !buf)
+		return -EINVAL;
+	res = &hwcg->res[type];
+
+	buf = skip_spaces(buf);
+	tok = strsep(&buf, " ");
+	if (strcmp(tok, HWACCEL_MAX_STR)) {
+		err = kstrtou64(tok, 0, &max_us);
+		if (err)
+			return err;
+		if (!max_us || max_us > U64_MAX / NSEC_PER_USEC)
+			return -ERANGE;
+	}
+	if (buf) {
+		err = kstrtou64(skip_spaces(buf), 0, &period_us);
+		if (err)
+			return err;
+		if (period_us < HWACCEL_PERIOD_MIN_US ||
+		    period_us > HWACCEL_PERIOD_MAX_US)
+			return -ERANGE;
+	}
+
+	spin_lock_irq(&hwcg->lock);
+	res->max_ns = max_us == U64_MAX ? U64_MAX : max_us * NSEC_PER_USEC;
+	if (period_us)
+		res->period_ns = period_us * NSEC_PER_USEC;
+	/* the new bandwidth starts with a fresh period */
+	now = ktime_get_ns();
+	if (res->throttled)
+		res->throttled_ns += now - res->throttled_at;
+	res->throttled = false;
+	res->period_start = now;
+	res->period_usage = 0;
+	spin_unlock_irq(&hwcg->lock);
+
+	return nbytes;
+}
+
+static int hwaccel_stat_show(struct seq_file *sf, void *v)
+{
+	struct hwaccel_cgroup *hwcg = css_hwaccel(seq_css(sf));
+	struct hwaccel_res res;
+	u64 now;
+	int i;
+
+	for (i = 0; i < HWACCEL_TYPE_MAX; i++) {
+		spin_lock_irq(&hwcg->lock);
+		now = ktime_get_ns();
+		hwaccel_res_roll(&hwcg->res[i], now);
+		res = hwcg->res[i];
+		spin_unlock_irq(&hwcg->lock);
+
+		if (res.throttled)
+			res.throttled_ns += now - res.throttled_at;
+		seq_printf(sf, "%s usage_usec=%llu nr_jobs=%llu nr_throttled=%llu throttled_usec=%llu\n",
+			   hwaccel_names[i], div_u64(res.usage_ns, NSEC_PER_USEC),
+			   res.nr_jobs, res.nr_throttled,
+			   div_u64(res.throttled_ns, NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
+static struct cftype hwaccel_files[] = {
+	{
+		.name = "weight",
+		.seq_show = hwaccel_weight_show,
+		.write = hwaccel_weight_write,
+		.flags = CFTYPE_NOT_ON_ROOT,
+	},
+	{
+		.name = "max",
+		.seq_show = hwaccel_max_show,
+		.write = hwaccel_max_write,
+		.flags = CFTYPE_NOT_ON_ROOT,
+	},
+	{
+		.name = "stat",
+		.seq_show = hwaccel_stat_show,
+	},
+	{ }	/* terminate */
+};
+
+struct cgroup_subsys hwaccel_cgrp_subsys = {
+	.css_alloc	= hwaccel_css_alloc,
+	.css_free	= hwaccel_css_free,
+	.legacy_cftypes	= hwaccel_files,
+	.dfl_cftypes	= hwaccel_files,
+	.threaded	= true,
+};
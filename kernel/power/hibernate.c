@@ -752,6 +752,8 @@ int hibernate(void)
 			flags |= SF_NOCOMPRESS_MODE;
 		else
 		        flags |= SF_CRC32_MODE;
+		if (!nocompress && IS_ENABLED(CONFIG_HIBERNATION_LZ4))
+			flags |= SF_LZ4_MODE;
 
 		pm_pr_dbg("Writing hibernation image.\n");
 		error = swsusp_write(flags);
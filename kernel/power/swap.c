@@ -25,12 +25,16 @@
 #include <linux/pm.h>
 #include <linux/slab.h>
 #include <linux/lzo.h>
+#include <linux/lz4.h>
 #include <linux/vmalloc.h>
 #include <linux/cpumask.h>
 #include <linux/atomic.h>
 #include <linux/kthread.h>
 #include <linux/crc32.h>
 #include <linux/ktime.h>
+#ifdef CONFIG_ROCKCHIP_HW_DECOMPRESS
+#include <linux/soc/rockchip/rockchip_decompress.h>
+#endif
 
 #include "power.h"
 
@@ -526,6 +530,14 @@ static int swap_writer_finish(struct swap_map_handle *handle,
 /* Maximum number of threads for compression/decompression. */
 #define LZO_THREADS	3
 
+/*
+ * SF_LZ4_MODE images keep the layout of the LZO ones, a length header
+ * and a raw block per LZO_UNC_SIZE of data, the block compressed with LZ4.
+ */
+#define LZ4_CMP_MAX	LZ4_COMPRESSBOUND(LZO_UNC_SIZE)
+#define CMP_WRK_SIZE	(LZ4_MEM_COMPRESS > LZO1X_1_MEM_COMPRESS ? \
+			 LZ4_MEM_COMPRESS : LZO1X_1_MEM_COMPRESS)
+
 /* Minimum/maximum number of pages for read buffering. */
 #define LZO_MIN_RD_PAGES	1024
 #define LZO_MAX_RD_PAGES	8192
@@ -629,13 +641,14 @@ struct cmp_data {
 	atomic_t ready;                           /* ready to start flag */
 	atomic_t stop;                            /* ready to stop flag */
 	int ret;                                  /* return code */
+	bool lz4;                                 /* compress with LZ4 */
 	wait_queue_head_t go;                     /* start compression */
 	wait_queue_head_t done;                   /* compression done */
 	size_t unc_len;                           /* uncompressed length */
 	size_t cmp_len;                           /* compressed length */
 	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
 	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
-	unsigned char wrk[LZO1X_1_MEM_COMPRESS];  /* compression workspace */
+	unsigned char wrk[CMP_WRK_SIZE];          /* compression workspace */
 };
 
 /**
@@ -657,9 +670,19 @@ static int lzo_compress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
-		d->ret = lzo1x_1_compress(d->unc, d->unc_len,
-		                          d->cmp + LZO_HEADER, &d->cmp_len,
-		                          d->wrk);
+		if (IS_ENABLED(CONFIG_HIBERNATION_LZ4) && d->lz4) {
+			int len = LZ4_compress_default(d->unc,
+						       d->cmp + LZO_HEADER,
+						       d->unc_len, LZ4_CMP_MAX,
+						       d->wrk);
+
+			d->cmp_len = max(len, 0);
+			d->ret = len > 0 ? 0 : -1;
+		} else {
+			d->ret = lzo1x_1_compress(d->unc, d->unc_len,
+						  d->cmp + LZO_HEADER,
+						  &d->cmp_len, d->wrk);
+		}
 		atomic_set(&d->stop, 1);
 		wake_up(&d->done);
 	}
@@ -674,7 +697,7 @@ static int lzo_compress_threadfn(void *data)
  */
 static int save_image_lzo(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
-                          unsigned int nr_to_write)
+                          unsigned int nr_to_write, bool lz4)
 {
 	unsigned int m;
 	int ret = 0;
@@ -711,8 +734,10 @@ static int save_image_lzo(struct swap_map_handle *handle,
 		ret = -ENOMEM;
 		goto out_clean;
 	}
-	for (thr = 0; thr < nr_threads; thr++)
+	for (thr = 0; thr < nr_threads; thr++) {
 		memset(&data[thr], 0, offsetof(struct cmp_data, go));
+		data[thr].lz4 = lz4;
+	}
 
 	crc = kmalloc(sizeof(*crc), GFP_KERNEL);
 	if (!crc) {
@@ -767,7 +792,8 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	 */
 	handle->reqd_free_pages = reqd_free_pages();
 
-	pr_info("Using %u thread(s) for compression\n", nr_threads);
+	pr_info("Using %u thread(s) for %s compression\n", nr_threads,
+		lz4 ? "LZ4" : "LZO");
 	pr_info("Compressing and saving image data (%u pages)...\n",
 		nr_to_write);
 	m = nr_to_write / 10;
@@ -942,7 +968,8 @@ int swsusp_write(unsigned int flags)
 	if (!error) {
 		error = (flags & SF_NOCOMPRESS_MODE) ?
 			save_image(&handle, &snapshot, pages - 1) :
-			save_image_lzo(&handle, &snapshot, pages - 1);
+			save_image_lzo(&handle, &snapshot, pages - 1,
+				       flags & SF_LZ4_MODE);
 	}
 out_finish:
 	error = swap_writer_finish(&handle, flags, error);
@@ -1116,14 +1143,48 @@ struct dec_data {
 	atomic_t ready;                           /* ready to start flag */
 	atomic_t stop;                            /* ready to stop flag */
 	int ret;                                  /* return code */
+	bool lz4;                                 /* LZ4 compressed image */
+	bool hw;                                  /* on the decompress engine */
 	wait_queue_head_t go;                     /* start decompression */
 	wait_queue_head_t done;                   /* decompression done */
 	size_t unc_len;                           /* uncompressed length */
 	size_t cmp_len;                           /* compressed length */
 	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
+#ifdef CONFIG_ROCKCHIP_HW_DECOMPRESS
+	/* lz4 frame header room, with the length header before cmp */
+	unsigned char cmp_room[RK_DECOM_LZ4_HEAD];
+#endif
 	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
 };
 
+static int lz4_decompress_block(struct dec_data *d)
+{
+	int len;
+
+#ifdef CONFIG_ROCKCHIP_HW_DECOMPRESS
+	if (d->hw) {
+		u64 decom_len;
+
+		/* wraps the block in a frame over the length header */
+		if (!rk_decom_lz4_block(d->cmp + LZO_HEADER - RK_DECOM_LZ4_HEAD,
+					d->cmp_len, d->unc, LZO_UNC_SIZE,
+					&decom_len)) {
+			d->unc_len = decom_len;
+			return 0;
+		}
+		pr_warn("Hardware decompression failed, using LZ4\n");
+		d->hw = false;
+	}
+#endif
+	len = LZ4_decompress_safe(d->cmp + LZO_HEADER, d->unc, d->cmp_len,
+				  LZO_UNC_SIZE);
+	if (len < 0)
+		return -1;
+	d->unc_len = len;
+
+	return 0;
+}
+
 /**
  * Deompression function that runs in its own thread.
  */
@@ -1144,8 +1205,12 @@ static int lzo_decompress_threadfn(void *data)
 		atomic_set(&d->ready, 0);
 
 		d->unc_len = LZO_UNC_SIZE;
-		d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER, d->cmp_len,
-		                               d->unc, &d->unc_len);
+		if (IS_ENABLED(CONFIG_HIBERNATION_LZ4) && d->lz4)
+			d->ret = lz4_decompress_block(d);
+		else
+			d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER,
+						       d->cmp_len, d->unc,
+						       &d->unc_len);
 		if (clean_pages_on_decompress)
 			flush_icache_range((unsigned long)d->unc,
 					   (unsigned long)d->unc + d->unc_len);
@@ -1164,7 +1229,7 @@ static int lzo_decompress_threadfn(void *data)
  */
 static int load_image_lzo(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
-                          unsigned int nr_to_read)
+                          unsigned int nr_to_read, bool lz4)
 {
 	unsigned int m;
 	int ret = 0;
@@ -1181,6 +1246,12 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	unsigned char **page = NULL;
 	struct dec_data *data = NULL;
 	struct crc_data *crc = NULL;
+	bool hw = false;
+
+	if (lz4 && !IS_ENABLED(CONFIG_HIBERNATION_LZ4)) {
+		pr_err("LZ4 image, but no LZ4 support\n");
+		return -EINVAL;
+	}
 
 	hib_init_batch(&hb);
 
@@ -1198,14 +1269,31 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		goto out_clean;
 	}
 
-	data = vmalloc(array_size(nr_threads, sizeof(*data)));
+	/*
+	 * The decompress engine takes physically contiguous buffers and
+	 * serves one block at a time, so it gets a single thread and the
+	 * storage reads overlap with it.
+	 */
+	if (lz4 && IS_ENABLED(CONFIG_ROCKCHIP_HW_DECOMPRESS)) {
+		data = alloc_pages_exact(sizeof(*data),
+					 GFP_KERNEL | __GFP_NOWARN);
+		if (data) {
+			nr_threads = 1;
+			hw = true;
+		}
+	}
+	if (!data)
+		data = vmalloc(array_size(nr_threads, sizeof(*data)));
 	if (!data) {
 		pr_err("Failed to allocate LZO data\n");
 		ret = -ENOMEM;
 		goto out_clean;
 	}
-	for (thr = 0; thr < nr_threads; thr++)
+	for (thr = 0; thr < nr_threads; thr++) {
 		memset(&data[thr], 0, offsetof(struct dec_data, go));
+		data[thr].lz4 = lz4;
+		data[thr].hw = hw;
+	}
 
 	crc = kmalloc(sizeof(*crc), GFP_KERNEL);
 	if (!crc) {
@@ -1286,7 +1374,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	}
 	want = ring_size = i;
 
-	pr_info("Using %u thread(s) for decompression\n", nr_threads);
+	pr_info("Using %u thread(s) for %s decompression\n", nr_threads,
+		hw ? "hardware" : lz4 ? "LZ4" : "LZO");
 	pr_info("Loading and decompressing image data (%u pages)...\n",
 		nr_to_read);
 	m = nr_to_read / 10;
@@ -1347,7 +1436,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			data[thr].cmp_len = *(size_t *)page[pg];
 			if (unlikely(!data[thr].cmp_len ||
 			             data[thr].cmp_len >
-			             lzo1x_worst_compress(LZO_UNC_SIZE))) {
+			             (lz4 ? LZ4_CMP_MAX :
+				      lzo1x_worst_compress(LZO_UNC_SIZE)))) {
 				pr_err("Invalid LZO compressed length\n");
 				ret = -1;
 				goto out_finish;
@@ -1470,7 +1560,10 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		for (thr = 0; thr < nr_threads; thr++)
 			if (data[thr].thr)
 				kthread_stop(data[thr].thr);
-		vfree(data);
+		if (hw)
+			free_pages_exact(data, sizeof(*data));
+		else
+			vfree(data);
 	}
 	vfree(page);
 
@@ -1503,7 +1596,8 @@ int swsusp_read(unsigned int *flags_p)
 	if (!error) {
 		error = (*flags_p & SF_NOCOMPRESS_MODE) ?
 			load_image(&handle, &snapshot, header->pages - 1) :
-			load_image_lzo(&handle, &snapshot, header->pages - 1);
+			load_image_lzo(&handle, &snapshot, header->pages - 1,
+				       *flags_p & SF_LZ4_MODE);
 	}
 	swap_reader_finish(&handle);
 end:
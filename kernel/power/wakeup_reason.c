@@ -27,6 +27,7 @@
 #include <linux/notifier.h>
 #include <linux/suspend.h>
 #include <linux/slab.h>
+#include <trace/events/power.h>
 
 /*
  * struct wakeup_irq_node - stores data and relationships for IRQs logged as
@@ -68,6 +69,32 @@ static ktime_t curr_monotime; /* monotonic time after last suspend */
 static ktime_t last_stime; /* monotonic boottime offset before last suspend */
 static ktime_t curr_stime; /* monotonic boottime offset after last suspend */
 
+/*
+ * Per device resume callback times of the last resume, taken from the
+ * device_pm_callback tracepoints. The slowest ones are kept to show where
+ * the resume latency goes, e.g. which devices to make async.
+ */
+#define RESUME_DEV_INFLIGHT	32
+#define RESUME_DEV_TOP		16
+
+struct resume_dev_time {
+	char name[48];
+	const char *pm_ops;
+	u64 us;
+};
+
+static DEFINE_SPINLOCK(resume_dev_lock);
+static bool resume_dev_capture;
+static struct {
+	struct device *dev;
+	const char *pm_ops;
+	ktime_t start;
+} resume_dev_inflight[RESUME_DEV_INFLIGHT];
+static struct resume_dev_time resume_dev_top[RESUME_DEV_TOP];
+static int resume_dev_nr;
+static unsigned int resume_dev_callbacks;
+static u64 resume_dev_total_us;
+
 static void init_node(struct wakeup_irq_node *p, int irq)
 {
 	struct irq_desc *desc;
@@ -358,12 +385,118 @@ static ssize_t last_suspend_time_show(struct kobject *kobj,
 		       sleep_time.tv_nsec);
 }
 
+static void resume_dev_start(void *data, struct device *dev,
+			     const char *pm_ops, int event)
+{
+	unsigned long flags;
+	int i;
+
+	if (event != PM_EVENT_RESUME || !READ_ONCE(resume_dev_capture))
+		return;
+
+	spin_lock_irqsave(&resume_dev_lock, flags);
+	for (i = 0; i < RESUME_DEV_INFLIGHT; i++) {
+		if (!resume_dev_inflight[i].dev) {
+			resume_dev_inflight[i].dev = dev;
+			/* "early ", "noirq " or NULL, a string literal */
+			resume_dev_inflight[i].pm_ops = pm_ops;
+			resume_dev_inflight[i].start = ktime_get();
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&resume_dev_lock, flags);
+}
+
+static void resume_dev_end(void *data, struct device *dev, int error)
+{
+	struct resume_dev_time *t;
+	const char *pm_ops = NULL;
+	unsigned long flags;
+	ktime_t start = 0;
+	u64 us;
+	int i;
+
+	if (!READ_ONCE(resume_dev_capture))
+		return;
+
+	spin_lock_irqsave(&resume_dev_lock, flags);
+	for (i = 0; i < RESUME_DEV_INFLIGHT; i++) {
+		if (resume_dev_inflight[i].dev == dev) {
+			resume_dev_inflight[i].dev = NULL;
+			pm_ops = resume_dev_inflight[i].pm_ops;
+			start = resume_dev_inflight[i].start;
+			break;
+		}
+	}
+	if (!start)
+		goto unlock;
+
+	us = ktime_us_delta(ktime_get(), start);
+	resume_dev_total_us += us;
+	resume_dev_callbacks++;
+
+	/* kept slowest first */
+	for (i = resume_dev_nr; i > 0 && resume_dev_top[i - 1].us < us; i--)
+		if (i < RESUME_DEV_TOP)
+			resume_dev_top[i] = resume_dev_top[i - 1];
+	if (i == RESUME_DEV_TOP)
+		goto unlock;
+	if (resume_dev_nr < RESUME_DEV_TOP)
+		resume_dev_nr++;
+
+	t = &resume_dev_top[i];
+	snprintf(t->name, sizeof(t->name), "%s %s", dev_driver_string(dev),
+		 dev_name(dev));
+	t->pm_ops = pm_ops ? pm_ops : "";
+	t->us = us;
+unlock:
+	spin_unlock_irqrestore(&resume_dev_lock, flags);
+}
+
+static void resume_dev_reset(bool capture)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&resume_dev_lock, flags);
+	if (capture) {
+		memset(resume_dev_inflight, 0, sizeof(resume_dev_inflight));
+		resume_dev_nr = 0;
+		resume_dev_callbacks = 0;
+		resume_dev_total_us = 0;
+	}
+	WRITE_ONCE(resume_dev_capture, capture);
+	spin_unlock_irqrestore(&resume_dev_lock, flags);
+}
+
+static ssize_t last_resume_devices_show(struct kobject *kobj,
+					struct kobj_attribute *attr, char *buf)
+{
+	ssize_t buf_offset;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&resume_dev_lock, flags);
+	buf_offset = scnprintf(buf, PAGE_SIZE, "%llu us in %u callbacks\n",
+			       resume_dev_total_us, resume_dev_callbacks);
+	for (i = 0; i < resume_dev_nr; i++)
+		buf_offset += scnprintf(buf + buf_offset,
+					PAGE_SIZE - buf_offset,
+					"%llu %s%s\n", resume_dev_top[i].us,
+					resume_dev_top[i].pm_ops,
+					resume_dev_top[i].name);
+	spin_unlock_irqrestore(&resume_dev_lock, flags);
+
+	return buf_offset;
+}
+
 static struct kobj_attribute resume_reason = __ATTR_RO(last_resume_reason);
 static struct kobj_attribute suspend_time = __ATTR_RO(last_suspend_time);
+static struct kobj_attribute resume_devices = __ATTR_RO(last_resume_devices);
 
 static struct attribute *attrs[] = {
 	&resume_reason.attr,
 	&suspend_time.attr,
+	&resume_devices.attr,
 	NULL,
 };
 static struct attribute_group attr_group = {
@@ -381,6 +514,7 @@ static int wakeup_reason_pm_event(struct notifier_block *notifier,
 		/* monotonic time since boot including the time spent in suspend */
 		last_stime = ktime_get_boottime();
 		clear_wakeup_reasons();
+		resume_dev_reset(true);
 		break;
 	case PM_POST_SUSPEND:
 		/* monotonic time since boot */
@@ -388,6 +522,7 @@ static int wakeup_reason_pm_event(struct notifier_block *notifier,
 		/* monotonic time since boot including the time spent in suspend */
 		curr_stime = ktime_get_boottime();
 		print_wakeup_sources();
+		resume_dev_reset(false);
 		break;
 	default:
 		break;
@@ -423,6 +558,11 @@ static int __init wakeup_reason_init(void)
 	if (!wakeup_irq_nodes_cache)
 		goto fail_remove_group;
 
+	if (IS_ENABLED(CONFIG_TRACEPOINTS) &&
+	    (register_trace_device_pm_callback_start(resume_dev_start, NULL) ||
+	     register_trace_device_pm_callback_end(resume_dev_end, NULL)))
+		pr_warn("[%s] failed to register resume time probes\n", __func__);
+
 	return 0;
 
 fail_remove_group:
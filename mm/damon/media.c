@@ -0,0 +1,415 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DAMON-based proactive reclamation for media devices
+ *
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+
+#define pr_fmt(fmt) "damon-media: " fmt
+
+#include <linux/damon.h>
+#include <linux/module.h>
+#include <linux/pid.h>
+#include <linux/sched.h>
+#include <linux/sched/task.h>
+#include <linux/workqueue.h>
+#include <uapi/linux/sched/types.h>
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "damon_media."
+
+#define DAMON_MEDIA_MAX_TARGETS	8
+
+/*
+ * Enable or disable DAMON_MEDIA.
+ *
+ * The targets and all of the tunables below are read when DAMON_MEDIA is
+ * enabled, so they take effect on the next enable.
+ */
+static bool enabled __read_mostly;
+module_param(enabled, bool, 0600);
+
+/*
+ * Pids of the processes to reclaim from, typically the AI inference and the
+ * web UI processes. The capture and encode processes should stay out.
+ */
+static int target_pids[DAMON_MEDIA_MAX_TARGETS];
+static int nr_target_pids;
+module_param_array(target_pids, int, &nr_target_pids, 0600);
+
+/*
+ * Time threshold for cold memory regions identification in microseconds.
+ *
+ * Regions not accessed for this long are deactivated, so that any later
+ * reclaim, including the one kicked by a recording buffer burst, finds
+ * them at the tail of the LRU lists. 2 seconds by default.
+ */
+static unsigned long cold_age __read_mostly = 2000000;
+module_param(cold_age, ulong, 0600);
+
+/*
+ * Time threshold for regions to page out in microseconds.
+ *
+ * Regions not accessed for this long are paged out, anonymous pages to
+ * zram and clean file pages dropped. 10 seconds by default.
+ */
+static unsigned long min_age __read_mostly = 10000000;
+module_param(min_age, ulong, 0600);
+
+/*
+ * Limit of time for the page out in milliseconds.
+ *
+ * DAMON_MEDIA tries to use only up to this time within a time window
+ * (quota_reset_interval_ms) for paging out. Compressing to zram costs cpu
+ * time the encoder may need, so this is kept small. 5 ms by default.
+ */
+static unsigned long quota_ms __read_mostly = 5;
+module_param(quota_ms, ulong, 0600);
+
+/*
+ * Limit of size of memory for the page out in bytes.
+ *
+ * DAMON_MEDIA pages out up to this size of memory within a time window
+ * (quota_reset_interval_ms). 1 MiB by default.
+ */
+static unsigned long quota_sz __read_mostly = 1024 * 1024;
+module_param(quota_sz, ulong, 0600);
+
+/*
+ * The time/size quota charge reset interval in milliseconds.
+ *
+ * 1 second by default.
+ */
+static unsigned long quota_reset_interval_ms __read_mostly = 1000;
+module_param(quota_reset_interval_ms, ulong, 0600);
+
+/*
+ * The watermarks check time interval in microseconds.
+ *
+ * 1 second by default.
+ */
+static unsigned long wmarks_interval __read_mostly = 1000000;
+module_param(wmarks_interval, ulong, 0600);
+
+/*
+ * Free memory rate (per thousand) for the high watermark.
+ *
+ * Paging out stops once free memory goes above this. 300 permil by
+ * default, which leaves a 64 MiB device about 19 MiB for recording
+ * buffers.
+ */
+static unsigned long wmarks_high __read_mostly = 300;
+module_param(wmarks_high, ulong, 0600);
+
+/*
+ * Free memory rate (per thousand) for the middle watermark.
+ *
+ * Paging out starts once free memory goes below this. 250 permil by
+ * default.
+ */
+static unsigned long wmarks_mid __read_mostly = 250;
+module_param(wmarks_mid, ulong, 0600);
+
+/*
+ * Free memory rate (per thousand) for the low watermark.
+ *
+ * Below this the kernel's own reclaim is already running and paging out
+ * from here would only compete with it. 50 permil by default.
+ */
+static unsigned long wmarks_low __read_mostly = 50;
+module_param(wmarks_low, ulong, 0600);
+
+/*
+ * Sampling interval for the monitoring in microseconds.
+ *
+ * 5 ms by default.
+ */
+static unsigned long sample_interval __read_mostly = 5000;
+module_param(sample_interval, ulong, 0600);
+
+/*
+ * Aggregation interval for the monitoring in microseconds.
+ *
+ * 100 ms by default.
+ */
+static unsigned long aggr_interval __read_mostly = 100000;
+module_param(aggr_interval, ulong, 0600);
+
+/*
+ * Minimum number of monitoring regions.
+ *
+ * 10 by default.
+ */
+static unsigned long min_nr_regions __read_mostly = 10;
+module_param(min_nr_regions, ulong, 0600);
+
+/*
+ * Maximum number of monitoring regions.
+ *
+ * Kept low since kdamond itself runs on the devices this is meant for.
+ * 200 by default.
+ */
+static unsigned long max_nr_regions __read_mostly = 200;
+module_param(max_nr_regions, ulong, 0600);
+
+/*
+ * PID of the DAMON thread
+ *
+ * If DAMON_MEDIA is enabled, this becomes the PID of the worker thread.
+ * Else, -1.
+ */
+static int kdamond_pid __read_mostly = -1;
+module_param(kdamond_pid, int, 0400);
+
+/*
+ * Number of memory regions that tried to be paged out.
+ */
+static unsigned long nr_pageout_tried_regions __read_mostly;
+module_param(nr_pageout_tried_regions, ulong, 0400);
+
+/*
+ * Total bytes of memory regions that tried to be paged out.
+ */
+static unsigned long bytes_pageout_tried_regions __read_mostly;
+module_param(bytes_pageout_tried_regions, ulong, 0400);
+
+/*
+ * Number of memory regions that successfully be paged out.
+ */
+static unsigned long nr_pageout_regions __read_mostly;
+module_param(nr_pageout_regions, ulong, 0400);
+
+/*
+ * Total bytes of memory regions that successfully be paged out.
+ */
+static unsigned long bytes_pageout_regions __read_mostly;
+module_param(bytes_pageout_regions, ulong, 0400);
+
+/*
+ * Number of times that the time/space quota limits have exceeded
+ */
+static unsigned long nr_quota_exceeds __read_mostly;
+module_param(nr_quota_exceeds, ulong, 0400);
+
+static struct damon_ctx *ctx;
+
+static void damon_media_wmarks(struct damos_watermarks *wmarks)
+{
+	wmarks->metric = DAMOS_WMARK_FREE_MEM_RATE;
+	wmarks->interval = wmarks_interval;
+	wmarks->high = wmarks_high;
+	wmarks->mid = wmarks_mid;
+	wmarks->low = wmarks_low;
+}
+
+/*
+ * The preset: regions older than cold_age are always deactivated, and only
+ * those older than min_age are paged out, within the quota and only while
+ * free memory sits between the low and the middle watermark.
+ */
+static int damon_media_set_schemes(void)
+{
+	/* deactivating is cheap, keep doing it whatever the free memory */
+	struct damos_watermarks wmarks = {
+		.metric = DAMOS_WMARK_NONE,
+	};
+	struct damos_quota quota = {
+		/* Do not deactivate more than 8 MiB per second */
+		.sz = 8 * 1024 * 1024,
+		.reset_interval = 1000,
+		/* Within the quota, deactivate older regions first. */
+		.weight_sz = 0,
+		.weight_nr_accesses = 0,
+		.weight_age = 1
+	};
+	struct damos *schemes[2];
+	int err;
+
+	schemes[0] = damon_new_scheme(
+			/* Find regions having PAGE_SIZE or larger size */
+			PAGE_SIZE, ULONG_MAX,
+			/* and not accessed at all */
+			0, 0,
+			/* for cold_age or more micro-seconds */
+			cold_age / aggr_interval, UINT_MAX,
+			/* and deactivate those */
+			DAMOS_COLD,
+			&quota, &wmarks);
+	if (!schemes[0])
+		return -ENOMEM;
+
+	quota = (struct damos_quota) {
+		/* Do not page out more than quota_ms of cpu time */
+		.ms = quota_ms,
+		/* nor more than quota_sz bytes */
+		.sz = quota_sz,
+		/* within quota_reset_interval_ms */
+		.reset_interval = quota_reset_interval_ms,
+		/* Within the quota, page out older regions first. */
+		.weight_sz = 0,
+		.weight_nr_accesses = 0,
+		.weight_age = 1
+	};
+	damon_media_wmarks(&wmarks);
+	schemes[1] = damon_new_scheme(
+			PAGE_SIZE, ULONG_MAX,
+			0, 0,
+			/* for min_age or more micro-seconds */
+			min_age / aggr_interval, UINT_MAX,
+			/* and page out those */
+			DAMOS_PAGEOUT,
+			&quota, &wmarks);
+	if (!schemes[1]) {
+		damon_destroy_scheme(schemes[0]);
+		return -ENOMEM;
+	}
+
+	err = damon_set_schemes(ctx, schemes, 2);
+	if (err) {
+		damon_destroy_scheme(schemes[0]);
+		damon_destroy_scheme(schemes[1]);
+	}
+	return err;
+}
+
+/* vaddr targets are identified by their struct pid, as debugfs does */
+static int damon_media_set_targets(void)
+{
+	unsigned long ids[DAMON_MEDIA_MAX_TARGETS];
+	int i, nr = 0, err;
+
+	for (i = 0; i < nr_target_pids; i++) {
+		struct pid *pid = find_get_pid(target_pids[i]);
+
+		if (!pid) {
+			pr_warn("pid %d not found\n", target_pids[i]);
+			continue;
+		}
+		ids[nr++] = (unsigned long)pid;
+	}
+	if (!nr)
+		return -EINVAL;
+
+	err = damon_set_targets(ctx, ids, nr);
+	if (err) {
+		for (i = 0; i < nr; i++)
+			put_pid((struct pid *)ids[i]);
+	}
+	return err;
+}
+
+/* drop the pids taken by damon_media_set_targets() */
+static void damon_media_before_terminate(struct damon_ctx *c)
+{
+	struct damon_target *t, *next;
+
+	mutex_lock(&c->kdamond_lock);
+	damon_for_each_target_safe(t, next, c) {
+		put_pid((struct pid *)t->id);
+		damon_destroy_target(t);
+	}
+	mutex_unlock(&c->kdamond_lock);
+}
+
+static int damon_media_turn(bool on)
+{
+	int err;
+
+	if (!on) {
+		err = damon_stop(&ctx, 1);
+		if (!err)
+			kdamond_pid = -1;
+		return err;
+	}
+
+	err = damon_set_attrs(ctx, sample_interval, aggr_interval, 0,
+			min_nr_regions, max_nr_regions);
+	if (err)
+		return err;
+
+	err = damon_media_set_schemes();
+	if (err)
+		return err;
+
+	err = damon_media_set_targets();
+	if (err)
+		return err;
+
+	err = damon_start(&ctx, 1);
+	if (err) {
+		damon_media_before_terminate(ctx);
+		return err;
+	}
+
+	kdamond_pid = ctx->kdamond->pid;
+	pr_info("kdamond (pid %d) started\n", kdamond_pid);
+	return 0;
+}
+
+#define ENABLE_CHECK_INTERVAL_MS	1000
+static struct delayed_work damon_media_timer;
+static void damon_media_timer_fn(struct work_struct *work)
+{
+	static bool last_enabled;
+	bool now_enabled;
+
+	now_enabled = enabled;
+	if (last_enabled != now_enabled) {
+		if (!damon_media_turn(now_enabled))
+			last_enabled = now_enabled;
+		else
+			enabled = last_enabled;
+	}
+
+	schedule_delayed_work(&damon_media_timer,
+			msecs_to_jiffies(ENABLE_CHECK_INTERVAL_MS));
+}
+static DECLARE_DELAYED_WORK(damon_media_timer, damon_media_timer_fn);
+
+/*
+ * Monitoring and paging out only run when the cpus have nothing else to
+ * do, so the capture and encode threads never wait for kdamond.
+ */
+static int damon_media_before_start(struct damon_ctx *c)
+{
+	struct sched_param param = { .sched_priority = 0 };
+
+	return sched_setscheduler_nocheck(current, SCHED_IDLE, &param);
+}
+
+static int damon_media_after_aggregation(struct damon_ctx *c)
+{
+	struct damos *s;
+
+	/* update the stats parameter of the page out scheme */
+	damon_for_each_scheme(s, c) {
+		if (s->action != DAMOS_PAGEOUT)
+			continue;
+		nr_pageout_tried_regions = s->stat.nr_tried;
+		bytes_pageout_tried_regions = s->stat.sz_tried;
+		nr_pageout_regions = s->stat.nr_applied;
+		bytes_pageout_regions = s->stat.sz_applied;
+		nr_quota_exceeds = s->stat.qt_exceeds;
+	}
+
+	return 0;
+}
+
+static int __init damon_media_init(void)
+{
+	ctx = damon_new_ctx();
+	if (!ctx)
+		return -ENOMEM;
+
+	damon_va_set_primitives(ctx);
+	ctx->callback.before_start = damon_media_before_start;
+	ctx->callback.after_aggregation = damon_media_after_aggregation;
+	ctx->callback.before_terminate = damon_media_before_terminate;
+
+	schedule_delayed_work(&damon_media_timer, 0);
+	return 0;
+}
+
+module_init(damon_media_init);
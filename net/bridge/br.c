@@ -218,6 +218,8 @@ int br_boolopt_toggle(struct net_bridge *br, enum br_boolopt_id opt, bool on,
 	case BR_BOOLOPT_NO_LL_LEARN:
 		br_opt_toggle(br, BROPT_NO_LL_LEARN, on);
 		break;
+	case BR_BOOLOPT_FLOW_OFFLOAD:
+		return br_flow_toggle(br, on, extack);
 	default:
 		/* shouldn't be called with unsupported options */
 		WARN_ON(1);
@@ -232,6 +234,8 @@ int br_boolopt_get(const struct net_bridge *br, enum br_boolopt_id opt)
 	switch (opt) {
 	case BR_BOOLOPT_NO_LL_LEARN:
 		return br_opt_get(br, BROPT_NO_LL_LEARN);
+	case BR_BOOLOPT_FLOW_OFFLOAD:
+		return br_opt_get(br, BROPT_FLOW_OFFLOAD);
 	default:
 		/* shouldn't be called with unsupported options */
 		WARN_ON(1);
@@ -352,6 +356,10 @@ static int __init br_init(void)
 	if (err)
 		goto err_out5;
 
+	err = br_flow_init();
+	if (err)
+		goto err_out6;
+
 	brioctl_set(br_ioctl_deviceless_stub);
 
 #if IS_ENABLED(CONFIG_ATM_LANE)
@@ -366,6 +374,8 @@ static int __init br_init(void)
 
 	return 0;
 
+err_out6:
+	br_netlink_fini();
 err_out5:
 	unregister_switchdev_notifier(&br_switchdev_notifier);
 err_out4:
@@ -389,6 +399,7 @@ static void __exit br_deinit(void)
 	unregister_netdevice_notifier(&br_device_notifier);
 	brioctl_set(NULL);
 	unregister_pernet_subsys(&br_net_ops);
+	br_flow_fini();
 
 	rcu_barrier(); /* Wait for completion of call_rcu()'s */
 
@@ -0,0 +1,469 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ *	Flow offload of forwarded unicast ip flows
+ *	Linux ethernet bridge
+ *
+ *	A unicast tcp or udp flow is offloaded once one of its frames has
+ *	passed all bridge netfilter hooks on its way to a known port, and
+ *	conntrack tracks it past setup: confirmed, established for tcp, no
+ *	nat or helper. Its next frames are sent from the rx handler straight
+ *	to that port. The fdb is still looked up, both ways, so moves and
+ *	ageing work as before. The hooks are not run for offloaded frames,
+ *	a ruleset change applies to the flows offloaded before only once
+ *	they idle out or the option is toggled. tcp fin and rst, fragments,
+ *	ip options, extension headers and vlan filtering bridges stay on
+ *	the slow path.
+ *
+ *	Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+
+#include <linux/etherdevice.h>
+#include <linux/if_vlan.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/kernel.h>
+#include <linux/netdevice.h>
+#include <linux/proc_fs.h>
+#include <linux/rhashtable.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/tcp.h>
+#include <linux/udp.h>
+#include <net/ipv6.h>
+#include <net/net_namespace.h>
+#include <net/netfilter/nf_conntrack.h>
+#include <net/netfilter/nf_conntrack_helper.h>
+#include <net/netfilter/nf_conntrack_l4proto.h>
+#include "br_private.h"
+
+#define BR_FLOW_MAX		1024
+#define BR_FLOW_TIMEOUT		(30 * HZ)
+#define BR_FLOW_GC_INTERVAL	HZ
+
+struct br_flow_key {
+	struct in6_addr		saddr;
+	struct in6_addr		daddr;
+	int			ifindex;
+	__be16			sport;
+	__be16			dport;
+	__be16			proto;
+	u8			l4proto;
+	u8			dst[ETH_ALEN];
+	u8			src[ETH_ALEN];
+} __aligned(sizeof(u32));
+
+struct br_flow {
+	struct rhash_head	rhnode;
+	struct br_flow_key	key;
+
+	struct hlist_node	list;
+	struct net_bridge_port	*dst;
+	struct nf_conn		*ct;
+	unsigned long		used;
+	atomic64_t		packets;
+	atomic64_t		bytes;
+	struct rcu_head		rcu;
+};
+
+static const struct rhashtable_params br_flow_rht_params = {
+	.head_offset = offsetof(struct br_flow, rhnode),
+	.key_offset = offsetof(struct br_flow, key),
+	.key_len = sizeof(struct br_flow_key),
+	.automatic_shrinking = true,
+};
+
+/* skb->data is at the network header, the ingress port's frame */
+static bool br_flow_dissect(struct sk_buff *skb, int ifindex,
+			    struct br_flow_key *key)
+{
+	const struct ethhdr *eth = eth_hdr(skb);
+	unsigned int thoff;
+	u8 l4proto;
+
+	if (skb_vlan_tag_present(skb) || !is_unicast_ether_addr(eth->h_dest))
+		return false;
+
+	memset(key, 0, sizeof(*key));
+	switch (skb->protocol) {
+	case htons(ETH_P_IP): {
+		const struct iphdr *iph;
+
+		if (!pskb_may_pull(skb, sizeof(*iph)))
+			return false;
+		iph = (const struct iphdr *)skb->data;
+		if (iph->version != 4 || iph->ihl != 5 || ip_is_fragment(iph))
+			return false;
+		ipv6_addr_set_v4mapped(iph->saddr, &key->saddr);
+		ipv6_addr_set_v4mapped(iph->daddr, &key->daddr);
+		l4proto = iph->protocol;
+		thoff = sizeof(*iph);
+		break;
+	}
+	case htons(ETH_P_IPV6): {
+		const struct ipv6hdr *ip6h;
+
+		if (!pskb_may_pull(skb, sizeof(*ip6h)))
+			return false;
+		ip6h = (const struct ipv6hdr *)skb->data;
+		key->saddr = ip6h->saddr;
+		key->daddr = ip6h->daddr;
+		l4proto = ip6h->nexthdr;
+		thoff = sizeof(*ip6h);
+		break;
+	}
+	default:
+		return false;
+	}
+
+	switch (l4proto) {
+	case IPPROTO_TCP: {
+		const struct tcphdr *th;
+
+		if (!pskb_may_pull(skb, thoff + sizeof(*th)))
+			return false;
+		th = (const struct tcphdr *)(skb->data + thoff);
+		/* conntrack has to see the teardown */
+		if (th->fin || th->rst)
+			return false;
+		key->sport = th->source;
+		key->dport = th->dest;
+		break;
+	}
+	case IPPROTO_UDP: {
+		const struct udphdr *uh;
+
+		if (!pskb_may_pull(skb, thoff + sizeof(*uh)))
+			return false;
+		uh = (const struct udphdr *)(skb->data + thoff);
+		key->sport = uh->source;
+		key->dport = uh->dest;
+		break;
+	}
+	default:
+		return false;
+	}
+
+	/* the pulls may have moved the head */
+	eth = eth_hdr(skb);
+	ether_addr_copy(key->dst, eth->h_dest);
+	ether_addr_copy(key->src, eth->h_source);
+	key->proto = skb->protocol;
+	key->l4proto = l4proto;
+	key->ifindex = ifindex;
+
+	return true;
+}
+
+/* from the rx handler, true if the frame took the offloaded path */
+bool br_flow_forward(struct net_bridge_port *p, struct sk_buff *skb)
+{
+	struct net_bridge *br = p->br;
+	struct net_bridge_fdb_entry *fdb;
+	struct net_bridge_port *to;
+	struct br_flow_key key;
+	struct br_flow *flow;
+
+	if (!br_opt_get(br, BROPT_FLOW_OFFLOAD) ||
+	    p->state != BR_STATE_FORWARDING ||
+	    br_opt_get(br, BROPT_VLAN_ENABLED))
+		return false;
+
+	if (!br_flow_dissect(skb, p->dev->ifindex, &key))
+		return false;
+
+	flow = rhashtable_lookup_fast(&br->flow_hash_tbl, &key,
+				      br_flow_rht_params);
+	if (!flow)
+		return false;
+
+	/* the gc drops what fails here */
+	to = flow->dst;
+	fdb = br_fdb_find_rcu(br, key.dst, 0);
+	if (!fdb || READ_ONCE(fdb->dst) != to ||
+	    to->state != BR_STATE_FORWARDING || nf_ct_is_dying(flow->ct) ||
+	    (p->flags & to->flags & BR_ISOLATED) || skb_warn_if_lro(skb))
+		return false;
+
+	if (p->flags & BR_LEARNING)
+		br_fdb_update(br, p, key.src, 0, 0);
+
+	WRITE_ONCE(flow->used, jiffies);
+	atomic64_inc(&flow->packets);
+	atomic64_add(skb->len + ETH_HLEN, &flow->bytes);
+	nf_ct_offload_timeout(flow->ct);
+
+	skb->dev = to->dev;
+	skb_forward_csum(skb);
+	skb->tstamp = 0;
+	br_dev_queue_push_xmit(dev_net(to->dev), NULL, skb);
+
+	return true;
+}
+
+static bool br_flow_ct_offloadable(struct sk_buff *skb)
+{
+	enum ip_conntrack_info ctinfo;
+	struct nf_conn *ct;
+
+	ct = nf_ct_get(skb, &ctinfo);
+	if (!ct || !nf_ct_is_confirmed(ct) || nf_ct_is_dying(ct) ||
+	    ct->status & (IPS_NAT_MASK | IPS_SEQ_ADJUST) || nfct_help(ct))
+		return false;
+
+	/* udp video streams are one way, they never get a reply */
+	if (nf_ct_protonum(ct) == IPPROTO_TCP)
+		return ctinfo == IP_CT_ESTABLISHED ||
+		       ctinfo == IP_CT_ESTABLISHED_REPLY;
+
+	return ctinfo == IP_CT_NEW || ctinfo == IP_CT_ESTABLISHED ||
+	       ctinfo == IP_CT_ESTABLISHED_REPLY;
+}
+
+/* from br_dev_queue_push_xmit, the frame has passed all bridge hooks */
+void br_flow_learn(struct sk_buff *skb)
+{
+	struct net_bridge_port *in, *to;
+	struct net_bridge_fdb_entry *fdb;
+	enum ip_conntrack_info ctinfo;
+	struct net_device *indev;
+	struct br_flow_key key;
+	struct net_bridge *br;
+	struct br_flow *flow;
+	struct nf_conn *ct;
+	int i, err;
+
+	to = br_port_get_check_rcu(skb->dev);
+	if (!to || !br_opt_get(to->br, BROPT_FLOW_OFFLOAD))
+		return;
+	br = to->br;
+
+	if (br_opt_get(br, BROPT_VLAN_ENABLED) ||
+	    READ_ONCE(br->flow_count) >= BR_FLOW_MAX ||
+	    !br_flow_ct_offloadable(skb))
+		return;
+
+	/* forwarded from another port of br, floods are not learnt */
+	indev = dev_get_by_index_rcu(dev_net(skb->dev), skb->skb_iif);
+	in = indev ? br_port_get_check_rcu(indev) : NULL;
+	if (!in || in->br != br || in == to)
+		return;
+	fdb = br_fdb_find_rcu(br, eth_hdr(skb)->h_dest, 0);
+	if (!fdb || READ_ONCE(fdb->dst) != to)
+		return;
+
+	if (!br_flow_dissect(skb, in->dev->ifindex, &key) ||
+	    rhashtable_lookup_fast(&br->flow_hash_tbl, &key, br_flow_rht_params))
+		return;
+
+	flow = kzalloc(sizeof(*flow), GFP_ATOMIC);
+	if (!flow)
+		return;
+	ct = nf_ct_get(skb, &ctinfo);
+	nf_conntrack_get(&ct->ct_general);
+	flow->key = key;
+	flow->dst = to;
+	flow->ct = ct;
+	flow->used = jiffies;
+
+	/* conntrack misses the offloaded segments, don't let it reject later ones */
+	if (nf_ct_protonum(ct) == IPPROTO_TCP) {
+		spin_lock_bh(&ct->lock);
+		for (i = 0; i < ARRAY_SIZE(ct->proto.tcp.seen); i++)
+			ct->proto.tcp.seen[i].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+		spin_unlock_bh(&ct->lock);
+	}
+
+	spin_lock_bh(&br->flow_lock);
+	err = rhashtable_lookup_insert_fast(&br->flow_hash_tbl, &flow->rhnode,
+					    br_flow_rht_params);
+	if (!err) {
+		hlist_add_head_rcu(&flow->list, &br->flow_list);
+		br->flow_count++;
+	}
+	spin_unlock_bh(&br->flow_lock);
+
+	if (err) {
+		nf_ct_put(ct);
+		kfree(flow);
+	}
+}
+
+static void br_flow_free_rcu(struct rcu_head *head)
+{
+	struct br_flow *flow = container_of(head, struct br_flow, rcu);
+
+	nf_ct_put(flow->ct);
+	kfree(flow);
+}
+
+/* the offload pinned the conntrack timeout, give it its own one back */
+static void br_flow_fixup_ct(struct nf_conn *ct)
+{
+	struct net *net = nf_ct_net(ct);
+	unsigned int timeout;
+
+	if (nf_ct_protonum(ct) == IPPROTO_TCP)
+		timeout = nf_tcp_pernet(net)->timeouts[TCP_CONNTRACK_ESTABLISHED];
+	else
+		timeout = nf_udp_pernet(net)->timeouts[UDP_CT_REPLIED];
+
+	if (nf_ct_expires(ct) > timeout)
+		WRITE_ONCE(ct->timeout, nfct_time_stamp + timeout);
+}
+
+/* with br->flow_lock held */
+static void br_flow_del(struct net_bridge *br, struct br_flow *flow)
+{
+	rhashtable_remove_fast(&br->flow_hash_tbl, &flow->rhnode,
+			       br_flow_rht_params);
+	hlist_del_rcu(&flow->list);
+	br->flow_count--;
+	br_flow_fixup_ct(flow->ct);
+	call_rcu(&flow->rcu, br_flow_free_rcu);
+}
+
+static void br_flow_flush(struct net_bridge *br, const struct net_bridge_port *p)
+{
+	struct br_flow *flow;
+	struct hlist_node *tmp;
+
+	spin_lock_bh(&br->flow_lock);
+	hlist_for_each_entry_safe(flow, tmp, &br->flow_list, list) {
+		if (!p || flow->dst == p || flow->key.ifindex == p->dev->ifindex)
+			br_flow_del(br, flow);
+	}
+	spin_unlock_bh(&br->flow_lock);
+}
+
+/* under rtnl, before the port is freed */
+void br_flow_flush_port(struct net_bridge_port *p)
+{
+	if (br_opt_get(p->br, BROPT_FLOW_OFFLOAD))
+		br_flow_flush(p->br, p);
+}
+
+static void br_flow_gc(struct work_struct *work)
+{
+	struct net_bridge *br = container_of(work, struct net_bridge,
+					     flow_gc_work.work);
+	struct br_flow *flow;
+	struct hlist_node *tmp;
+
+	spin_lock_bh(&br->flow_lock);
+	hlist_for_each_entry_safe(flow, tmp, &br->flow_list, list) {
+		if (time_after(jiffies, READ_ONCE(flow->used) + BR_FLOW_TIMEOUT) ||
+		    nf_ct_is_dying(flow->ct) ||
+		    flow->dst->state != BR_STATE_FORWARDING)
+			br_flow_del(br, flow);
+	}
+	spin_unlock_bh(&br->flow_lock);
+
+	if (br_opt_get(br, BROPT_FLOW_OFFLOAD))
+		queue_delayed_work(system_long_wq, &br->flow_gc_work,
+				   BR_FLOW_GC_INTERVAL);
+}
+
+/* under rtnl, the table only exists while the option is on */
+int br_flow_toggle(struct net_bridge *br, bool on,
+		   struct netlink_ext_ack *extack)
+{
+	int err;
+
+	if (!!br_opt_get(br, BROPT_FLOW_OFFLOAD) == on)
+		return 0;
+
+	if (on) {
+		err = rhashtable_init(&br->flow_hash_tbl, &br_flow_rht_params);
+		if (err) {
+			NL_SET_ERR_MSG_MOD(extack, "Can't allocate the flow table");
+			return err;
+		}
+		spin_lock_init(&br->flow_lock);
+		INIT_HLIST_HEAD(&br->flow_list);
+		br->flow_count = 0;
+		INIT_DELAYED_WORK(&br->flow_gc_work, br_flow_gc);
+		br_opt_toggle(br, BROPT_FLOW_OFFLOAD, true);
+		queue_delayed_work(system_long_wq, &br->flow_gc_work,
+				   BR_FLOW_GC_INTERVAL);
+		return 0;
+	}
+
+	br_opt_toggle(br, BROPT_FLOW_OFFLOAD, false);
+	/* no rx handler or xmit still sees the option on */
+	synchronize_net();
+	cancel_delayed_work_sync(&br->flow_gc_work);
+	br_flow_flush(br, NULL);
+	rhashtable_destroy(&br->flow_hash_tbl);
+
+	return 0;
+}
+
+static int br_flow_seq_show(struct seq_file *m, void *v)
+{
+	struct net *net = seq_file_net(m);
+	const struct br_flow_key *key;
+	struct net_device *dev, *in;
+	struct net_bridge *br;
+	struct br_flow *flow;
+
+	rcu_read_lock();
+	for_each_netdev_rcu(net, dev) {
+		if (!netif_is_bridge_master(dev))
+			continue;
+		br = netdev_priv(dev);
+		if (!br_opt_get(br, BROPT_FLOW_OFFLOAD))
+			continue;
+
+		hlist_for_each_entry_rcu(flow, &br->flow_list, list) {
+			key = &flow->key;
+			in = dev_get_by_index_rcu(net, key->ifindex);
+			seq_printf(m, "%s %s > %s %s ", dev->name,
+				   in ? in->name : "?", flow->dst->dev->name,
+				   key->l4proto == IPPROTO_TCP ? "tcp" : "udp");
+			if (key->proto == htons(ETH_P_IP))
+				seq_printf(m, "%pI4:%u > %pI4:%u",
+					   &key->saddr.s6_addr32[3], ntohs(key->sport),
+					   &key->daddr.s6_addr32[3], ntohs(key->dport));
+			else
+				seq_printf(m, "[%pI6c]:%u > [%pI6c]:%u",
+					   &key->saddr, ntohs(key->sport),
+					   &key->daddr, ntohs(key->dport));
+			seq_printf(m, " packets %lld bytes %lld idle %ums\n",
+				   (s64)atomic64_read(&flow->packets),
+				   (s64)atomic64_read(&flow->bytes),
+				   jiffies_to_msecs(jiffies - READ_ONCE(flow->used)));
+		}
+	}
+	rcu_read_unlock();
+
+	return 0;
+}
+
+static int __net_init br_flow_net_init(struct net *net)
+{
+	if (!proc_create_net_single("br_flows", 0444, net->proc_net,
+				    br_flow_seq_show, NULL))
+		return -ENOMEM;
+
+	return 0;
+}
+
+static void __net_exit br_flow_net_exit(struct net *net)
+{
+	remove_proc_entry("br_flows", net->proc_net);
+}
+
+static struct pernet_operations br_flow_net_ops = {
+	.init	= br_flow_net_init,
+	.exit	= br_flow_net_exit,
+};
+
+int __init br_flow_init(void)
+{
+	return register_pernet_subsys(&br_flow_net_ops);
+}
+
+void br_flow_fini(void)
+{
+	unregister_pernet_subsys(&br_flow_net_ops);
+}
@@ -344,6 +344,7 @@ static void del_nbp(struct net_bridge_port *p)
 
 	nbp_vlan_flush(p);
 	br_fdb_delete_by_port(br, p, 0, 1);
+	br_flow_flush_port(p);
 	switchdev_deferred_process();
 	nbp_backup_clear(p);
 
@@ -378,6 +379,7 @@ void br_dev_delete(struct net_device *dev, struct list_head *head)
 	br_recalculate_neigh_suppress_enabled(br);
 
 	br_fdb_delete_by_port(br, NULL, 0, 1);
+	br_flow_toggle(br, false, NULL);
 
 	cancel_delayed_work_sync(&br->gc_work);
 
@@ -360,6 +360,9 @@ static rx_handler_result_t br_handle_frame(struct sk_buff **pskb)
 		if (ether_addr_equal(p->br->dev->dev_addr, dest))
 			skb->pkt_type = PACKET_HOST;
 
+		if (br_flow_forward(p, skb))
+			return RX_HANDLER_CONSUMED;
+
 		return nf_hook_bridge_pre(skb, pskb);
 	default:
 drop:
@@ -378,6 +378,7 @@ enum net_bridge_opts {
 	BROPT_VLAN_STATS_PER_PORT,
 	BROPT_NO_LL_LEARN,
 	BROPT_VLAN_BRIDGE_BINDING,
+	BROPT_FLOW_OFFLOAD,
 };
 
 struct net_bridge {
@@ -480,6 +481,15 @@ struct net_bridge {
 #endif
 	struct hlist_head		fdb_list;
 
+#ifdef CONFIG_BRIDGE_FLOW_OFFLOAD
+	/* offloaded flows, see br_flow.c */
+	spinlock_t			flow_lock;
+	struct rhashtable		flow_hash_tbl;
+	struct hlist_head		flow_list;
+	unsigned int			flow_count;
+	struct delayed_work		flow_gc_work;
+#endif
+
 #if IS_ENABLED(CONFIG_BRIDGE_MRP)
 	struct list_head		mrp_list;
 #endif
@@ -729,6 +739,49 @@ int br_forward_finish(struct net *net, struct sock *sk, struct sk_buff *skb);
 void br_flood(struct net_bridge *br, struct sk_buff *skb,
 	      enum br_pkt_type pkt_type, bool local_rcv, bool local_orig);
 
+/* br_flow.c */
+#ifdef CONFIG_BRIDGE_FLOW_OFFLOAD
+bool br_flow_forward(struct net_bridge_port *p, struct sk_buff *skb);
+void br_flow_learn(struct sk_buff *skb);
+void br_flow_flush_port(struct net_bridge_port *p);
+int br_flow_toggle(struct net_bridge *br, bool on,
+		   struct netlink_ext_ack *extack);
+int br_flow_init(void);
+void br_flow_fini(void);
+#else
+static inline bool br_flow_forward(struct net_bridge_port *p,
+				   struct sk_buff *skb)
+{
+	return false;
+}
+
+static inline void br_flow_learn(struct sk_buff *skb)
+{
+}
+
+static inline void br_flow_flush_port(struct net_bridge_port *p)
+{
+}
+
+static inline int br_flow_toggle(struct net_bridge *br, bool on,
+				 struct netlink_ext_ack *extack)
+{
+	if (!on)
+		return 0;
+	NL_SET_ERR_MSG_MOD(extack, "Flow offload is not supported");
+	return -EOPNOTSUPP;
+}
+
+static inline int br_flow_init(void)
+{
+	return 0;
+}
+
+static inline void br_flow_fini(void)
+{
+}
+#endif
+
 /* return true if both source port and dest port are isolated */
 static inline bool br_skb_isolated(const struct net_bridge_port *to,
 				   const struct sk_buff *skb)
@@ -343,6 +343,27 @@ static ssize_t no_linklocal_learn_store(struct device *d,
 }
 static DEVICE_ATTR_RW(no_linklocal_learn);
 
+static ssize_t flow_offload_show(struct device *d,
+				 struct device_attribute *attr,
+				 char *buf)
+{
+	struct net_bridge *br = to_bridge(d);
+	return sprintf(buf, "%d\n", br_boolopt_get(br, BR_BOOLOPT_FLOW_OFFLOAD));
+}
+
+static int set_flow_offload(struct net_bridge *br, unsigned long val)
+{
+	return br_boolopt_toggle(br, BR_BOOLOPT_FLOW_OFFLOAD, !!val, NULL);
+}
+
+static ssize_t flow_offload_store(struct device *d,
+				  struct device_attribute *attr,
+				  const char *buf, size_t len)
+{
+	return store_bridge_parm(d, buf, len, set_flow_offload);
+}
+static DEVICE_ATTR_RW(flow_offload);
+
 #ifdef CONFIG_BRIDGE_IGMP_SNOOPING
 static ssize_t multicast_router_show(struct device *d,
 				     struct device_attribute *attr, char *buf)
@@ -863,6 +884,7 @@ static struct attribute *bridge_attrs[] = {
 	&dev_attr_group_addr.attr,
 	&dev_attr_flush.attr,
 	&dev_attr_no_linklocal_learn.attr,
+	&dev_attr_flow_offload.attr,
 #ifdef CONFIG_BRIDGE_IGMP_SNOOPING
 	&dev_attr_multicast_router.attr,
 	&dev_attr_multicast_snooping.attr,
@@ -24,6 +24,7 @@ enum linux_mptcp_mib_field {
 	MPTCP_MIB_ECHOADD,		/* Received ADD_ADDR with echo-flag=1 */
 	MPTCP_MIB_RMADDR,		/* Received RM_ADDR */
 	MPTCP_MIB_RMSUBFLOW,		/* Remove a subflow */
+	MPTCP_MIB_REDUNDANTSEGS,	/* Segments duplicated on a second subflow */
 	__MPTCP_MIB_MAX
 };
 
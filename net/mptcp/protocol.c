@@ -1061,7 +1061,7 @@ static void mptcp_nospace(struct mptcp_sock *msk)
 	}
 }
 
-static bool mptcp_subflow_active(struct mptcp_subflow_context *subflow)
+bool mptcp_subflow_active(struct mptcp_subflow_context *subflow)
 {
 	struct sock *ssk = mptcp_subflow_tcp_sock(subflow);
 
@@ -1084,8 +1084,8 @@ struct subflow_send_info {
 	u64 ratio;
 };
 
-static struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk,
-					   u32 *sndbuf)
+static struct sock *mptcp_sched_default_get_send(struct mptcp_sock *msk,
+						 u32 *sndbuf)
 {
 	struct subflow_send_info send_info[2];
 	struct mptcp_subflow_context *subflow;
@@ -1094,19 +1094,6 @@ static struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk,
 	u64 ratio;
 	u32 pace;
 
-	sock_owned_by_me((struct sock *)msk);
-
-	*sndbuf = 0;
-	if (!mptcp_ext_cache_refill(msk))
-		return NULL;
-
-	if (__mptcp_check_fallback(msk)) {
-		if (!msk->first)
-			return NULL;
-		*sndbuf = msk->first->sk_sndbuf;
-		return sk_stream_memory_free(msk->first) ? msk->first : NULL;
-	}
-
 	/* re-use last subflow, if the burst allow that */
 	if (msk->last_snd && msk->snd_burst > 0 &&
 	    sk_stream_memory_free(msk->last_snd) &&
@@ -1162,6 +1149,107 @@ static struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk,
 	return NULL;
 }
 
+struct mptcp_sched_ops mptcp_sched_default = {
+	.name		= "default",
+	.get_send	= mptcp_sched_default_get_send,
+};
+
+static struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk,
+					   u32 *sndbuf)
+{
+	sock_owned_by_me((struct sock *)msk);
+
+	*sndbuf = 0;
+	if (!mptcp_ext_cache_refill(msk))
+		return NULL;
+
+	if (__mptcp_check_fallback(msk)) {
+		if (!msk->first)
+			return NULL;
+		*sndbuf = msk->first->sk_sndbuf;
+		return sk_stream_memory_free(msk->first) ? msk->first : NULL;
+	}
+
+	return msk->sched->get_send(msk, sndbuf);
+}
+
+/* duplicate the data in [seq, seq + len) still on the rtx queue on the
+ * subflow the scheduler asks for, if any, the same way the worker does
+ * for retransmissions
+ */
+static void mptcp_push_redundant(struct sock *sk, struct sock *ssk, u64 seq,
+				 size_t len)
+{
+	struct mptcp_sock *msk = mptcp_sk(sk);
+	int mss_now = 0, size_goal = 0;
+	struct mptcp_data_frag *dfrag;
+	u64 end = seq + len;
+	size_t copied = 0;
+	struct msghdr msg = {
+		.msg_flags = MSG_DONTWAIT,
+	};
+	long timeo = 0;
+
+	if (!msk->sched->get_redundant || __mptcp_check_fallback(msk))
+		return;
+
+	ssk = msk->sched->get_redundant(msk, ssk, len);
+	if (!ssk)
+		return;
+
+	lock_sock(ssk);
+	list_for_each_entry(dfrag, &msk->rtx_queue, list) {
+		int orig_len = dfrag->data_len, orig_offset = dfrag->offset;
+		u64 orig_seq = dfrag->data_seq;
+		u64 orig_end = orig_seq + orig_len;
+		bool partial;
+
+		if (!after64(orig_end, seq))
+			continue;
+		if (!before64(orig_seq, end))
+			break;
+
+		if (before64(orig_seq, seq)) {
+			dfrag->offset += seq - orig_seq;
+			dfrag->data_seq = seq;
+		}
+		dfrag->data_len = (before64(end, orig_end) ? end : orig_end) -
+				  dfrag->data_seq;
+
+		while (dfrag->data_len > 0) {
+			int ret;
+
+			if (!mptcp_ext_cache_refill(msk))
+				break;
+
+			ret = mptcp_sendmsg_frag(sk, ssk, &msg, dfrag, &timeo,
+						 &mss_now, &size_goal);
+			if (ret <= 0)
+				break;
+
+			MPTCP_INC_STATS(sock_net(sk), MPTCP_MIB_REDUNDANTSEGS);
+			copied += ret;
+			dfrag->data_len -= ret;
+			dfrag->offset += ret;
+		}
+
+		partial = dfrag->data_len > 0;
+		dfrag->data_seq = orig_seq;
+		dfrag->offset = orig_offset;
+		dfrag->data_len = orig_len;
+		if (partial)
+			break;
+	}
+
+	if (copied) {
+		mptcp_subflow_ctx(ssk)->redundant_bytes += copied;
+		tcp_push(ssk, msg.msg_flags, mss_now, tcp_sk(ssk)->nonagle,
+			 size_goal);
+		mptcp_set_timeout(sk, ssk);
+	}
+	release_sock(ssk);
+}
+
 static void ssk_check_wmem(struct mptcp_sock *msk)
 {
 	if (unlikely(!mptcp_is_writeable(msk)))
@@ -1175,6 +1263,7 @@ static int mptcp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 	struct page_frag *pfrag;
 	size_t copied = 0;
 	struct sock *ssk;
+	u64 start_seq;
 	u32 sndbuf;
 	bool tx_ok;
 	long timeo;
@@ -1183,6 +1272,7 @@ static int mptcp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 		return -EOPNOTSUPP;
 
 	lock_sock(sk);
+	start_seq = msk->write_seq;
 
 	timeo = sock_sndtimeo(sk, msg->msg_flags & MSG_DONTWAIT);
 
@@ -1258,6 +1348,7 @@ static int mptcp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 		 * at selection time, if possible.
 		 */
 		msk->snd_burst -= ret;
+		mptcp_subflow_ctx(ssk)->sched_bytes += ret;
 		copied += ret;
 
 		tx_ok = msg_data_left(msg);
@@ -1315,6 +1406,8 @@ static int mptcp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 	}
 
 	release_sock(ssk);
+	if (copied)
+		mptcp_push_redundant(sk, ssk, start_seq, copied);
 out:
 	ssk_check_wmem(msk);
 	release_sock(sk);
@@ -1843,6 +1936,7 @@ static int __mptcp_init_sock(struct sock *sk)
 
 	msk->first = NULL;
 	inet_csk(sk)->icsk_sync_mss = mptcp_sync_mss;
+	mptcp_sched_select(msk);
 
 	mptcp_pm_data_init(msk);
 
@@ -2826,6 +2920,7 @@ void __init mptcp_proto_init(void)
 	mptcp_subflow_init();
 	mptcp_pm_init();
 	mptcp_token_init();
+	mptcp_sched_init();
 
 	if (proto_register(&mptcp_prot, 1) != 0)
 		panic("Failed to register MPTCP proto.\n");
@@ -221,6 +221,7 @@ struct mptcp_sock {
 	struct list_head rtx_queue;
 	struct list_head join_list;
 	struct skb_ext	*cached_ext;	/* for the next sendmsg */
+	const struct mptcp_sched_ops *sched;
 	struct socket	*subflow; /* outgoing connect/listener/!mp_capable */
 	struct sock	*first;
 	struct mptcp_pm_data	pm;
@@ -321,6 +322,8 @@ struct mptcp_subflow_context {
 	u8	hmac[MPTCPOPT_HMAC_LEN];
 	u8	local_id;
 	u8	remote_id;
+	u64	sched_bytes;	    /* data picked for this subflow */
+	u64	redundant_bytes;    /* data duplicated from other subflows */
 
 	struct	sock *tcp_sock;	    /* tcp sk backpointer */
 	struct	sock *conn;	    /* parent mptcp_sock */
@@ -332,6 +335,23 @@ struct mptcp_subflow_context {
 	struct	rcu_head rcu;
 };
 
+#define MPTCP_SCHED_NAME_MAX	16
+
+/* A packet scheduler picks the subflow each sendmsg() call writes to.
+ * get_send is called with the msk socket lock held, only for non-fallback
+ * sockets and only when the ext cache is filled; it must return an active
+ * subflow with send space, or NULL. get_redundant is optional: once @len
+ * bytes have been written to @ssk it may return another subflow the same
+ * data is duplicated on.
+ */
+struct mptcp_sched_ops {
+	struct list_head list;
+	char name[MPTCP_SCHED_NAME_MAX];
+	struct sock *(*get_send)(struct mptcp_sock *msk, u32 *sndbuf);
+	struct sock *(*get_redundant)(struct mptcp_sock *msk, struct sock *ssk,
+				      size_t len);
+};
+
 static inline struct mptcp_subflow_context *
 mptcp_subflow_ctx(const struct sock *sk)
 {
@@ -362,6 +382,8 @@ mptcp_subflow_get_mapped_dsn(const struct mptcp_subflow_context *subflow)
 }
 
 int mptcp_is_enabled(struct net *net);
+const char *mptcp_get_scheduler(struct net *net);
+int mptcp_get_redundant_max(struct net *net);
 void mptcp_subflow_fully_established(struct mptcp_subflow_context *subflow,
 				     struct mptcp_options_received *mp_opt);
 bool mptcp_subflow_data_available(struct sock *sk);
@@ -388,6 +410,13 @@ static inline void mptcp_subflow_tcp_fallback(struct sock *sk,
 }
 
 void __init mptcp_proto_init(void);
+bool mptcp_subflow_active(struct mptcp_subflow_context *subflow);
+
+extern struct mptcp_sched_ops mptcp_sched_default;
+void mptcp_register_scheduler(struct mptcp_sched_ops *sched);
+const struct mptcp_sched_ops *mptcp_sched_find(const char *name);
+void mptcp_sched_select(struct mptcp_sock *msk);
+void __init mptcp_sched_init(void);
 #if IS_ENABLED(CONFIG_MPTCP_IPV6)
 int __init mptcp_proto_v6_init(void);
 #endif
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Multipath TCP packet schedulers
+ *
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+
+#define pr_fmt(fmt) "MPTCP: " fmt
+
+#include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/rculist.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <net/tcp.h>
+
+#include "protocol.h"
+
+static DEFINE_SPINLOCK(mptcp_sched_list_lock);
+static LIST_HEAD(mptcp_sched_list);
+
+const struct mptcp_sched_ops *mptcp_sched_find(const char *name)
+{
+	struct mptcp_sched_ops *sched;
+
+	list_for_each_entry_rcu(sched, &mptcp_sched_list, list) {
+		if (!strcmp(sched->name, name))
+			return sched;
+	}
+
+	return NULL;
+}
+
+/* schedulers are built in and never go away, so sockets may keep a plain
+ * pointer to the one they were created with
+ */
+void mptcp_register_scheduler(struct mptcp_sched_ops *sched)
+{
+	if (WARN_ON_ONCE(!sched->get_send))
+		return;
+
+	spin_lock(&mptcp_sched_list_lock);
+	if (mptcp_sched_find(sched->name))
+		pr_warn("scheduler %s already registered\n", sched->name);
+	else
+		list_add_tail_rcu(&sched->list, &mptcp_sched_list);
+	spin_unlock(&mptcp_sched_list_lock);
+}
+
+void mptcp_sched_select(struct mptcp_sock *msk)
+{
+	const struct mptcp_sched_ops *sched;
+
+	rcu_read_lock();
+	sched = mptcp_sched_find(mptcp_get_scheduler(sock_net((struct sock *)msk)));
+	rcu_read_unlock();
+
+	msk->sched = sched ? : &mptcp_sched_default;
+}
+
+/* Estimated time for a byte written now to reach the peer: half the
+ * smoothed rtt, plus the time to drain what is queued but not yet sent at
+ * the current pacing rate, plus a full rtt when the subflow is cwnd
+ * limited and has to wait for acks first.
+ */
+static u64 mptcp_sched_deadline_delay_us(struct sock *ssk)
+{
+	const struct tcp_sock *tp = tcp_sk(ssk);
+	u64 srtt = tp->srtt_us >> 3;
+	u64 delay = srtt >> 1;
+	u32 notsent = tp->write_seq - tp->snd_nxt;
+	u64 pace = READ_ONCE(ssk->sk_pacing_rate);
+
+	if (notsent && pace && pace != ~0UL)
+		delay += div64_u64((u64)notsent * USEC_PER_SEC, pace);
+
+	if (tcp_packets_in_flight(tp) >= tp->snd_cwnd)
+		delay += srtt;
+
+	return delay;
+}
+
+/* Live video writes a whole frame per sendmsg() call and sendmsg() keeps
+ * writing to the subflow picked here until it runs out of space, so an
+ * I-frame burst lands on the subflow expected to deliver it first instead
+ * of being split by send buffer load across a fast and a slow path.
+ */
+static struct sock *mptcp_sched_deadline_get_send(struct mptcp_sock *msk,
+						  u32 *sndbuf)
+{
+	u64 delay, best_delay[2] = { U64_MAX, U64_MAX };
+	struct mptcp_subflow_context *subflow;
+	struct sock *ssk, *best[2] = {};
+	int nr_active = 0;
+
+	mptcp_for_each_subflow(msk, subflow) {
+		ssk = mptcp_subflow_tcp_sock(subflow);
+		if (!mptcp_subflow_active(subflow))
+			continue;
+
+		nr_active += !subflow->backup;
+		*sndbuf = max(tcp_sk(ssk)->snd_wnd, *sndbuf);
+		if (!sk_stream_memory_free(ssk))
+			continue;
+
+		delay = mptcp_sched_deadline_delay_us(ssk);
+		if (delay < best_delay[subflow->backup]) {
+			best[subflow->backup] = ssk;
+			best_delay[subflow->backup] = delay;
+		}
+	}
+
+	pr_debug("msk=%p nr_active=%d ssk=%p:%llu backup=%p:%llu",
+		 msk, nr_active, best[0], best_delay[0], best[1], best_delay[1]);
+
+	if (!nr_active)
+		best[0] = best[1];
+
+	return best[0];
+}
+
+/* Small writes are the urgent ones (audio, parameter sets, control
+ * messages); they are cheap to send twice and the copy on the second
+ * fastest subflow, backup or not, covers a loss or a stall on the first.
+ */
+static struct sock *mptcp_sched_deadline_get_redundant(struct mptcp_sock *msk,
+						       struct sock *ssk,
+						       size_t len)
+{
+	struct mptcp_subflow_context *subflow;
+	u64 delay, best_delay = U64_MAX;
+	struct sock *best = NULL;
+
+	if (len > (size_t)mptcp_get_redundant_max(sock_net((struct sock *)msk)))
+		return NULL;
+
+	mptcp_for_each_subflow(msk, subflow) {
+		struct sock *tmp = mptcp_subflow_tcp_sock(subflow);
+
+		if (tmp == ssk || !mptcp_subflow_active(subflow) ||
+		    !sk_stream_memory_free(tmp))
+			continue;
+
+		delay = mptcp_sched_deadline_delay_us(tmp);
+		if (delay < best_delay) {
+			best = tmp;
+			best_delay = delay;
+		}
+	}
+
+	return best;
+}
+
+static struct mptcp_sched_ops mptcp_sched_deadline = {
+	.name		= "deadline",
+	.get_send	= mptcp_sched_deadline_get_send,
+	.get_redundant	= mptcp_sched_deadline_get_redundant,
+};
+
+void __init mptcp_sched_init(void)
+{
+	mptcp_register_scheduler(&mptcp_sched_default);
+	mptcp_register_scheduler(&mptcp_sched_deadline);
+}
@@ -0,0 +1,21 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#ifndef __RKMEDIA_LAT_H
+#define __RKMEDIA_LAT_H
+
+/* one frame, glass to wire, boottime ns */
+struct rkmedia_frame {
+	__u64 buf;
+	__u32 stream;
+	__u32 seq;
+	__u64 sof_ns;
+	__u64 cap_ns;
+	__u64 enc_start_ns;
+	__u64 enc_done_ns;
+	__u64 xmit_ns;
+	__u64 wire_ns;
+};
+
+#endif
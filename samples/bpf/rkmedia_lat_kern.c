@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Follows a camera frame by its dma-buf from rkcif/rkisp through the mpp
+ * encoder to the first stmmac packet sent after it was encoded, and
+ * emits one record per frame to a ring buffer.
+ */
+#include <linux/types.h>
+#include <uapi/linux/bpf.h>
+#include <bpf/bpf_helpers.h>
+#include "rkmedia_lat.h"
+
+/* frames, by dma-buf inode */
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__type(key, u64);
+	__type(value, struct rkmedia_frame);
+	__uint(max_entries, 64);
+} frames SEC(".maps");
+
+/* mpp task (session << 32 | task) to the frame it reads */
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__type(key, u64);
+	__type(value, u64);
+	__uint(max_entries, 64);
+} tasks SEC(".maps");
+
+/* skb carrying the first packet of a frame to the frame */
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__type(key, u64);
+	__type(value, u64);
+	__uint(max_entries, 64);
+} skbs SEC(".maps");
+
+/* the frame encoded last and not on the wire yet */
+struct {
+	__uint(type, BPF_MAP_TYPE_ARRAY);
+	__type(key, u32);
+	__type(value, u64);
+	__uint(max_entries, 1);
+} pending SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_RINGBUF);
+	__uint(max_entries, 64 * 1024);
+} records SEC(".maps");
+
+/* args: stream_id, seq, sof_ns, done_ns, buf */
+static int frame_buf(struct bpf_raw_tracepoint_args *ctx)
+{
+	struct rkmedia_frame frame = {};
+
+	frame.buf = ctx->args[4];
+	if (!frame.buf)
+		return 0;
+	frame.stream = ctx->args[0];
+	frame.seq = ctx->args[1];
+	frame.sof_ns = ctx->args[2];
+	frame.cap_ns = ctx->args[3];
+	bpf_map_update_elem(&frames, &frame.buf, &frame, BPF_ANY);
+	return 0;
+}
+
+SEC("raw_tracepoint/rkcif_frame_buf")
+int cif_frame(struct bpf_raw_tracepoint_args *ctx)
+{
+	return frame_buf(ctx);
+}
+
+SEC("raw_tracepoint/rkisp_frame_buf")
+int isp_frame(struct bpf_raw_tracepoint_args *ctx)
+{
+	return frame_buf(ctx);
+}
+
+/* args: session, task, fd, buf */
+SEC("raw_tracepoint/rkmpp_task_buf")
+int mpp_task_buf(struct bpf_raw_tracepoint_args *ctx)
+{
+	u64 key = ctx->args[0] << 32 | (u32)ctx->args[1];
+	u64 buf = ctx->args[3];
+
+	if (bpf_map_lookup_elem(&frames, &buf))
+		bpf_map_update_elem(&tasks, &key, &buf, BPF_ANY);
+	return 0;
+}
+
+static struct rkmedia_frame *task_frame(struct bpf_raw_tracepoint_args *ctx,
+					u64 *key)
+{
+	u64 *buf;
+
+	*key = ctx->args[1] << 32 | (u32)ctx->args[2];
+	buf = bpf_map_lookup_elem(&tasks, key);
+	if (!buf)
+		return NULL;
+	return bpf_map_lookup_elem(&frames, buf);
+}
+
+/* args: name, session, task, begin_ns, end_ns */
+SEC("raw_tracepoint/rkmpp_task_start")
+int mpp_task_start(struct bpf_raw_tracepoint_args *ctx)
+{
+	struct rkmedia_frame *frame;
+	u64 key;
+
+	frame = task_frame(ctx, &key);
+	if (frame)
+		frame->enc_start_ns = ctx->args[4];
+	return 0;
+}
+
+SEC("raw_tracepoint/rkmpp_task_done")
+int mpp_task_done(struct bpf_raw_tracepoint_args *ctx)
+{
+	struct rkmedia_frame *frame;
+	u32 zero = 0;
+	u64 key;
+
+	frame = task_frame(ctx, &key);
+	if (!frame)
+		return 0;
+	frame->enc_done_ns = ctx->args[4];
+	bpf_map_update_elem(&pending, &zero, &frame->buf, BPF_ANY);
+	bpf_map_delete_elem(&tasks, &key);
+	return 0;
+}
+
+/* args: skb, queue */
+SEC("raw_tracepoint/stmmac_xmit")
+int mac_xmit(struct bpf_raw_tracepoint_args *ctx)
+{
+	struct rkmedia_frame *frame;
+	u64 skb = ctx->args[0];
+	u32 zero = 0;
+	u64 *buf;
+
+	buf = bpf_map_lookup_elem(&pending, &zero);
+	if (!buf || !*buf)
+		return 0;
+	frame = bpf_map_lookup_elem(&frames, buf);
+	if (frame) {
+		frame->xmit_ns = bpf_ktime_get_boot_ns();
+		bpf_map_update_elem(&skbs, &skb, buf, BPF_ANY);
+	}
+	*buf = 0;
+	return 0;
+}
+
+/* args: skb, queue, xmit_ns, done_ns in CLOCK_MONOTONIC */
+SEC("raw_tracepoint/stmmac_tx_done")
+int mac_tx_done(struct bpf_raw_tracepoint_args *ctx)
+{
+	struct rkmedia_frame *frame;
+	u64 skb = ctx->args[0];
+	u64 *buf;
+
+	buf = bpf_map_lookup_elem(&skbs, &skb);
+	if (!buf)
+		return 0;
+	frame = bpf_map_lookup_elem(&frames, buf);
+	if (frame) {
+		frame->wire_ns = frame->xmit_ns + ctx->args[3] - ctx->args[2];
+		bpf_ringbuf_output(&records, frame, sizeof(*frame), 0);
+		bpf_map_delete_elem(&frames, buf);
+	}
+	bpf_map_delete_elem(&skbs, &skb);
+	return 0;
+}
+
+char _license[] SEC("license") = "GPL";
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Per frame glass to wire latency of a camera, encoder and ethernet
+ * pipeline. The capture buffers must be V4L2_MEMORY_DMABUF so the
+ * encoder task reading a frame can be told by its dma-buf. The first
+ * packet stmmac sends after a frame was encoded counts as its first
+ * byte on the wire.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/resource.h>
+#include <bpf/libbpf.h>
+#include <bpf/bpf.h>
+#include "rkmedia_lat.h"
+
+#define MAX_PROGS	8
+
+static volatile sig_atomic_t stop;
+
+static void int_exit(int sig)
+{
+	stop = 1;
+}
+
+static int print_frame(void *ctx, void *data, size_t size)
+{
+	const struct rkmedia_frame *f = data;
+
+	if (size < sizeof(*f))
+		return 0;
+
+	/* all in us, relative to the start of frame */
+	printf("stream %u seq %-6u cap %6llu enc %6llu-%-6llu xmit %6llu wire %6llu\n",
+	       f->stream, f->seq,
+	       (f->cap_ns - f->sof_ns) / 1000,
+	       f->enc_start_ns ? (f->enc_start_ns - f->sof_ns) / 1000 : 0,
+	       (f->enc_done_ns - f->sof_ns) / 1000,
+	       (f->xmit_ns - f->sof_ns) / 1000,
+	       (f->wire_ns - f->sof_ns) / 1000);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct rlimit r = {RLIM_INFINITY, RLIM_INFINITY};
+	struct bpf_link *links[MAX_PROGS];
+	struct ring_buffer *rb = NULL;
+	struct bpf_program *prog;
+	struct bpf_object *obj;
+	char filename[256];
+	int map_fd, ret = 1, i = 0;
+
+	setrlimit(RLIMIT_MEMLOCK, &r);
+	snprintf(filename, sizeof(filename), "%s_kern.o", argv[0]);
+
+	obj = bpf_object__open_file(filename, NULL);
+	if (libbpf_get_error(obj)) {
+		fprintf(stderr, "opening BPF object file failed\n");
+		return 1;
+	}
+
+	if (bpf_object__load(obj)) {
+		fprintf(stderr, "loading BPF object file failed\n");
+		goto cleanup;
+	}
+
+	bpf_object__for_each_program(prog, obj) {
+		if (i == MAX_PROGS)
+			break;
+		links[i] = bpf_program__attach(prog);
+		if (libbpf_get_error(links[i])) {
+			fprintf(stderr, "attaching %s failed, tracepoint missing?\n",
+				bpf_program__section_name(prog));
+			links[i] = NULL;
+			goto cleanup;
+		}
+		i++;
+	}
+
+	map_fd = bpf_object__find_map_fd_by_name(obj, "records");
+	if (map_fd < 0) {
+		fprintf(stderr, "finding the records map failed\n");
+		goto cleanup;
+	}
+
+	rb = ring_buffer__new(map_fd, print_frame, NULL, NULL);
+	if (libbpf_get_error(rb)) {
+		fprintf(stderr, "creating ring buffer failed\n");
+		rb = NULL;
+		goto cleanup;
+	}
+
+	signal(SIGINT, int_exit);
+	signal(SIGTERM, int_exit);
+
+	while (!stop) {
+		ret = ring_buffer__poll(rb, 100);
+		if (ret < 0 && ret != -EINTR) {
+			fprintf(stderr, "polling ring buffer failed: %d\n", ret);
+			break;
+		}
+	}
+	ret = 0;
+
+cleanup:
+	ring_buffer__free(rb);
+	for (i--; i >= 0; i--)
+		bpf_link__destroy(links[i]);
+	bpf_object__close(obj);
+	return ret;
+}
@@ -111,6 +111,8 @@ struct rk_i2s_tdm_dev {
 	unsigned int i2s_sdos[CH_GRP_MAX];
 	unsigned int quirks;
 	int clk_ppm;
+	/* fifo xrun events, counted even with per period irq disabled */
+	atomic_t xruns[SNDRV_PCM_STREAM_LAST + 1];
 	atomic_t refcount;
 	spinlock_t lock; /* xfer lock */
 };
@@ -1523,10 +1525,45 @@ static int rockchip_i2s_tdm_loopback_put(struct snd_kcontrol *kcontrol,
 	return 0;
 }
 
+static int rockchip_i2s_tdm_xrun_info(struct snd_kcontrol *kcontrol,
+				      struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = INT_MAX;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_xrun_get(struct snd_kcontrol *kcontrol,
+				     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_component_get_drvdata(component);
+
+	ucontrol->value.integer.value[0] =
+		atomic_read(&i2s_tdm->xruns[kcontrol->private_value]);
+
+	return 0;
+}
+
+#define I2S_TDM_XRUN_CTL(xname, stream) \
+{	.iface = SNDRV_CTL_ELEM_IFACE_MIXER, .name = xname, \
+	.access = SNDRV_CTL_ELEM_ACCESS_READ | \
+		  SNDRV_CTL_ELEM_ACCESS_VOLATILE, \
+	.info = rockchip_i2s_tdm_xrun_info, \
+	.get = rockchip_i2s_tdm_xrun_get, \
+	.private_value = stream }
+
 static const struct snd_kcontrol_new rockchip_i2s_tdm_snd_controls[] = {
 	SOC_ENUM_EXT("I2STDM Digital Loopback Mode", loopback_mode,
 		     rockchip_i2s_tdm_loopback_get,
 		     rockchip_i2s_tdm_loopback_put),
+	I2S_TDM_XRUN_CTL("I2STDM Playback FIFO Underruns",
+			 SNDRV_PCM_STREAM_PLAYBACK),
+	I2S_TDM_XRUN_CTL("I2STDM Capture FIFO Overruns",
+			 SNDRV_PCM_STREAM_CAPTURE),
 };
 
 static int rockchip_i2s_tdm_dai_probe(struct snd_soc_dai *dai)
@@ -2049,6 +2086,7 @@ static irqreturn_t rockchip_i2s_tdm_isr(int irq, void *devid)
 	regmap_read(i2s_tdm->regmap, I2S_INTSR, &val);
 	if (val & I2S_INTSR_TXUI_ACT) {
 		dev_warn_ratelimited(i2s_tdm->dev, "TX FIFO Underrun\n");
+		atomic_inc(&i2s_tdm->xruns[SNDRV_PCM_STREAM_PLAYBACK]);
 		regmap_update_bits(i2s_tdm->regmap, I2S_INTCR,
 				   I2S_INTCR_TXUIC, I2S_INTCR_TXUIC);
 		substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_PLAYBACK];
@@ -2058,6 +2096,7 @@ static irqreturn_t rockchip_i2s_tdm_isr(int irq, void *devid)
 
 	if (val & I2S_INTSR_RXOI_ACT) {
 		dev_warn_ratelimited(i2s_tdm->dev, "RX FIFO Overrun\n");
+		atomic_inc(&i2s_tdm->xruns[SNDRV_PCM_STREAM_CAPTURE]);
 		regmap_update_bits(i2s_tdm->regmap, I2S_INTCR,
 				   I2S_INTCR_RXOIC, I2S_INTCR_RXOIC);
 		substream = i2s_tdm->substreams[SNDRV_PCM_STREAM_CAPTURE];
@@ -2080,6 +2119,7 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	bool sync;
 #endif
 	int ret, val, i, irq;
+	unsigned int flags = 0;
 
 	ret = rockchip_i2s_tdm_dai_prepare(pdev, &soc_dai);
 	if (ret)
@@ -2306,10 +2346,18 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 		return 0;
 	}
 
+	/*
+	 * low latency: no per period dma irq, the pcm pointer comes from
+	 * the pl330 residue and userspace schedules itself from a timer,
+	 * fifo xruns are still caught by TXUI/RXOI.
+	 */
+	if (of_property_read_bool(node, "rockchip,low-latency"))
+		flags |= SND_DMAENGINE_PCM_FLAG_NO_PERIOD_WAKEUP;
+
 	if (of_property_read_bool(node, "rockchip,digital-loopback"))
 		ret = devm_snd_dmaengine_dlp_register(&pdev->dev, &dconfig);
 	else
-		ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL, 0);
+		ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL, flags);
 
 	if (ret) {
 		dev_err(&pdev->dev, "Could not register PCM\n");
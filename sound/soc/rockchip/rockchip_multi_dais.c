@@ -28,6 +28,15 @@ static inline struct rk_mdais_dev *to_info(struct snd_soc_dai *dai)
 	return snd_soc_dai_get_drvdata(dai);
 }
 
+static inline unsigned int *mdais_channel_maps(struct rk_mdais_dev *mdais,
+					       int stream)
+{
+	if (stream == SNDRV_PCM_STREAM_PLAYBACK)
+		return mdais->playback_channel_maps;
+
+	return mdais->capture_channel_maps;
+}
+
 static void hw_refine_channels(struct snd_pcm_hw_params *params,
 			       unsigned int channel)
 {
@@ -52,15 +61,15 @@ static int rockchip_mdais_hw_params(struct snd_pcm_substream *substream,
 	if (IS_ERR(cparams))
 		return PTR_ERR(cparams);
 
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		channel_maps = mdais->playback_channel_maps;
-	else
-		channel_maps = mdais->capture_channel_maps;
+	channel_maps = mdais_channel_maps(mdais, substream->stream);
 
 	for (i = 0; i < mdais->num_dais; i++) {
+		/* capture only or playback only members, like pdm or pwm */
+		if (!channel_maps[i])
+			continue;
+
 		child = mdais->dais[i].dai;
-		if (channel_maps[i])
-			hw_refine_channels(cparams, channel_maps[i]);
+		hw_refine_channels(cparams, channel_maps[i]);
 		if (child->driver->ops && child->driver->ops->hw_params) {
 			ret = child->driver->ops->hw_params(substream, cparams, child);
 			if (ret < 0) {
@@ -79,15 +88,30 @@ static int rockchip_mdais_trigger(struct snd_pcm_substream *substream,
 				  int cmd, struct snd_soc_dai *dai)
 {
 	struct rk_mdais_dev *mdais = to_info(dai);
+	int stream = substream->stream;
+	u64 start_ns[MAX_DAIS] = { 0 };
 	struct snd_soc_dai *child;
 	unsigned int *channel_maps;
+	bool start = false;
 	int ret = 0, i = 0;
 
-	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
-		channel_maps = mdais->playback_channel_maps;
-	else
-		channel_maps = mdais->capture_channel_maps;
+	channel_maps = mdais_channel_maps(mdais, stream);
 
+	switch (cmd) {
+	case SNDRV_PCM_TRIGGER_START:
+	case SNDRV_PCM_TRIGGER_RESUME:
+	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
+		start = true;
+		break;
+	}
+
+	/*
+	 * members are started back to back with irqs off, each one's
+	 * start is the last reg write of its trigger, so the time right
+	 * after it returns is when it began to move data. the spread is
+	 * reported to userspace so that a reference stream can be lined
+	 * up by a fixed offset instead of a correlation search.
+	 */
 	for (i = 0; i < mdais->num_dais; i++) {
 		/* skip DAIs which have no channel mapping */
 		if (!channel_maps[i])
@@ -100,6 +124,14 @@ static int rockchip_mdais_trigger(struct snd_pcm_substream *substream,
 			if (ret < 0)
 				return ret;
 		}
+		if (start)
+			start_ns[i] = ktime_get_ns();
+	}
+
+	if (start) {
+		spin_lock(&mdais->lock);
+		memcpy(mdais->start_ns[stream], start_ns, sizeof(start_ns));
+		spin_unlock(&mdais->lock);
 	}
 
 	return 0;
@@ -109,10 +141,14 @@ static int rockchip_mdais_startup(struct snd_pcm_substream *substream,
 				  struct snd_soc_dai *dai)
 {
 	struct rk_mdais_dev *mdais = to_info(dai);
+	unsigned int *channel_maps = mdais_channel_maps(mdais, substream->stream);
 	struct snd_soc_dai *child;
 	int ret = 0, i = 0;
 
 	for (i = 0; i < mdais->num_dais; i++) {
+		if (!channel_maps[i])
+			continue;
+
 		child = mdais->dais[i].dai;
 		if (child->driver->ops && child->driver->ops->startup) {
 			ret = child->driver->ops->startup(substream, child);
@@ -128,10 +164,14 @@ static void rockchip_mdais_shutdown(struct snd_pcm_substream *substream,
 				  struct snd_soc_dai *dai)
 {
 	struct rk_mdais_dev *mdais = to_info(dai);
+	unsigned int *channel_maps = mdais_channel_maps(mdais, substream->stream);
 	struct snd_soc_dai *child;
 	int i = 0;
 
 	for (i = 0; i < mdais->num_dais; i++) {
+		if (!channel_maps[i])
+			continue;
+
 		child = mdais->dais[i].dai;
 		if (child->driver->ops && child->driver->ops->shutdown) {
 			child->driver->ops->shutdown(substream, child);
@@ -143,10 +183,14 @@ static int rockchip_mdais_prepare(struct snd_pcm_substream *substream,
 				  struct snd_soc_dai *dai)
 {
 	struct rk_mdais_dev *mdais = to_info(dai);
+	unsigned int *channel_maps = mdais_channel_maps(mdais, substream->stream);
 	struct snd_soc_dai *child;
 	int ret = 0, i = 0;
 
 	for (i = 0; i < mdais->num_dais; i++) {
+		if (!channel_maps[i])
+			continue;
+
 		child = mdais->dais[i].dai;
 		if (child->driver->ops && child->driver->ops->prepare) {
 			ret = child->driver->ops->prepare(substream, child);
@@ -217,6 +261,61 @@ static int rockchip_mdais_tdm_slot(struct snd_soc_dai *dai,
 	return 0;
 }
 
+static int rockchip_mdais_start_offset_info(struct snd_kcontrol *kcontrol,
+					    struct snd_ctl_elem_info *uinfo)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_mdais_dev *mdais = to_info(dai);
+
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = mdais->num_dais;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = INT_MAX;
+
+	return 0;
+}
+
+/* start of each member in ns after the earliest one, 0 if not started */
+static int rockchip_mdais_start_offset_get(struct snd_kcontrol *kcontrol,
+					   struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_dai *dai = snd_kcontrol_chip(kcontrol);
+	struct rk_mdais_dev *mdais = to_info(dai);
+	int stream = kcontrol->private_value;
+	u64 start_ns[MAX_DAIS], first = U64_MAX;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&mdais->lock, flags);
+	memcpy(start_ns, mdais->start_ns[stream], sizeof(start_ns));
+	spin_unlock_irqrestore(&mdais->lock, flags);
+
+	for (i = 0; i < mdais->num_dais; i++)
+		if (start_ns[i] && start_ns[i] < first)
+			first = start_ns[i];
+
+	for (i = 0; i < mdais->num_dais; i++)
+		ucontrol->value.integer.value[i] = start_ns[i] ?
+			min_t(u64, start_ns[i] - first, INT_MAX) : 0;
+
+	return 0;
+}
+
+#define MDAIS_START_OFFSET_CTL(xname, stream) \
+{	.iface = SNDRV_CTL_ELEM_IFACE_PCM, .name = xname, \
+	.access = SNDRV_CTL_ELEM_ACCESS_READ | \
+		  SNDRV_CTL_ELEM_ACCESS_VOLATILE, \
+	.info = rockchip_mdais_start_offset_info, \
+	.get = rockchip_mdais_start_offset_get, \
+	.private_value = stream }
+
+static struct snd_kcontrol_new rockchip_mdais_controls[] = {
+	MDAIS_START_OFFSET_CTL("Multi DAIs Playback Start Offset",
+			       SNDRV_PCM_STREAM_PLAYBACK),
+	MDAIS_START_OFFSET_CTL("Multi DAIs Capture Start Offset",
+			       SNDRV_PCM_STREAM_CAPTURE),
+};
+
 static int rockchip_mdais_dai_probe(struct snd_soc_dai *dai)
 {
 	struct rk_mdais_dev *mdais = to_info(dai);
@@ -238,6 +337,9 @@ static int rockchip_mdais_dai_probe(struct snd_soc_dai *dai)
 		}
 	}
 
+	snd_soc_add_dai_controls(dai, rockchip_mdais_controls,
+				 ARRAY_SIZE(rockchip_mdais_controls));
+
 	return 0;
 }
 
@@ -540,6 +642,7 @@ static int rockchip_mdais_probe(struct platform_device *pdev)
 
 	mdais->dais = dais;
 	mdais->dev = &pdev->dev;
+	spin_lock_init(&mdais->lock);
 	dev_set_drvdata(&pdev->dev, mdais);
 
 	pm_runtime_enable(&pdev->dev);
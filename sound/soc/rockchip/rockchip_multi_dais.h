@@ -25,6 +25,9 @@ struct rk_mdais_dev {
 	unsigned int *playback_channel_maps;
 	unsigned int *capture_channel_maps;
 	int num_dais;
+	/* when each member was started, protected by lock */
+	u64 start_ns[SNDRV_PCM_STREAM_LAST + 1][MAX_DAIS];
+	spinlock_t lock;
 };
 
 int snd_dmaengine_mpcm_register(struct rk_mdais_dev *mdais);
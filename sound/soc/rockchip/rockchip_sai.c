@@ -1137,7 +1137,9 @@ static int rockchip_sai_probe(struct platform_device *pdev)
 	if (ret)
 		goto err_runtime_suspend;
 
-	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL, 0);
+	/* let mic array users read tdm slots as planes, no userspace split */
+	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL,
+					      SND_DMAENGINE_PCM_FLAG_PLANAR_CAPTURE);
 	if (ret)
 		goto err_runtime_suspend;
 
@@ -14,11 +14,21 @@
 #include <linux/mfd/syscon.h>
 #include <linux/regmap.h>
 #include <linux/reset.h>
+#include <linux/workqueue.h>
 #include <sound/pcm_params.h>
 #include <sound/dmaengine_pcm.h>
 
 #include "rockchip_spdifrx.h"
 
+/*
+ * the drift estimator samples the capture position every SPDIFRX_DRIFT_MS
+ * and fits the rate over the last SPDIFRX_DRIFT_SNAPS samples, that is an
+ * 8s baseline which keeps the dma burst granularity well below 10ppb.
+ */
+#define SPDIFRX_DRIFT_MS		250
+#define SPDIFRX_DRIFT_SNAPS		32
+#define SPDIFRX_LL_PERIODS_MAX		4
+
 struct rk_spdifrx_dev {
 	struct device *dev;
 	struct clk *mclk;
@@ -27,6 +37,17 @@ struct rk_spdifrx_dev {
 	struct regmap *regmap;
 	struct reset_control *reset;
 	int irq;
+	/* low latency profile: small periods, see rk_spdifrx_startup() */
+	unsigned int ll_period_us;
+	/* drift estimator, runs between startup and shutdown */
+	struct snd_pcm_substream *substream;
+	struct delayed_work drift_work;
+	snd_pcm_uframes_t drift_pos;
+	u64 snap_frames[SPDIFRX_DRIFT_SNAPS];
+	u64 snap_ns[SPDIFRX_DRIFT_SNAPS];
+	unsigned int snap_cnt;
+	int drift_ppb;
+	unsigned int jitter_us;
 };
 
 static int rk_spdifrx_runtime_suspend(struct device *dev)
@@ -129,16 +150,180 @@ static int rk_spdifrx_trigger(struct snd_pcm_substream *substream,
 	return ret;
 }
 
+/* absolute capture position, sampled together with the local clock */
+static bool rk_spdifrx_drift_sample(struct rk_spdifrx_dev *spdifrx,
+				    snd_pcm_uframes_t *pos, u64 *ns)
+{
+	struct snd_pcm_substream *substream = spdifrx->substream;
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	snd_pcm_uframes_t hw, off, ptr;
+	unsigned long flags;
+	bool running;
+
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	running = runtime->status->state == SNDRV_PCM_STATE_RUNNING;
+	if (running) {
+		/* hw_ptr is from the last period irq, ptr from the residue */
+		hw = runtime->status->hw_ptr;
+		ptr = substream->ops->pointer(substream);
+		*ns = ktime_get_ns();
+		off = hw % runtime->buffer_size;
+		hw -= off;
+		if (ptr < off)
+			hw += runtime->buffer_size;
+		*pos = (hw + ptr) % runtime->boundary;
+	}
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+
+	return running;
+}
+
+static void rk_spdifrx_drift_work(struct work_struct *work)
+{
+	struct rk_spdifrx_dev *spdifrx = container_of(to_delayed_work(work),
+						      struct rk_spdifrx_dev,
+						      drift_work);
+	struct snd_pcm_runtime *runtime = spdifrx->substream->runtime;
+	unsigned int n = SPDIFRX_DRIFT_SNAPS, i, cur, first;
+	snd_pcm_uframes_t pos;
+	u64 ns, frames, dns, df, dev_max = 0;
+	s64 err, dev;
+
+	if (!rk_spdifrx_drift_sample(spdifrx, &pos, &ns)) {
+		spdifrx->snap_cnt = 0;
+		goto out;
+	}
+
+	cur = spdifrx->snap_cnt % n;
+	frames = 0;
+	if (spdifrx->snap_cnt)
+		frames = spdifrx->snap_frames[(spdifrx->snap_cnt - 1) % n] +
+			 (pos - spdifrx->drift_pos + runtime->boundary) %
+			 runtime->boundary;
+	spdifrx->drift_pos = pos;
+	spdifrx->snap_frames[cur] = frames;
+	spdifrx->snap_ns[cur] = ns;
+	spdifrx->snap_cnt++;
+
+	/* need a couple of seconds before the estimate means anything */
+	if (spdifrx->snap_cnt < n / 4)
+		goto out;
+
+	first = spdifrx->snap_cnt > n ? spdifrx->snap_cnt % n : 0;
+	dns = ns - spdifrx->snap_ns[first];
+	df = frames - spdifrx->snap_frames[first];
+
+	/* ppb = (df / dns * 1e9 - rate) / rate * 1e9 */
+	err = (s64)(df * NSEC_PER_SEC) - (s64)(dns * runtime->rate);
+	err = div64_s64(err * 1000, div_u64(dns * runtime->rate, 1000000));
+	spdifrx->drift_ppb += (int)(err - spdifrx->drift_ppb) / 4;
+
+	/* jitter: worst deviation of a sample from the fitted line */
+	for (i = 0; i < min(spdifrx->snap_cnt, n); i++) {
+		dev = spdifrx->snap_frames[i] - spdifrx->snap_frames[first] -
+		      div64_u64((spdifrx->snap_ns[i] - spdifrx->snap_ns[first]) *
+				df, dns);
+		dev_max = max_t(u64, dev_max, abs(dev));
+	}
+	spdifrx->jitter_us = div_u64(dev_max * USEC_PER_SEC, runtime->rate);
+
+out:
+	schedule_delayed_work(&spdifrx->drift_work,
+			      msecs_to_jiffies(SPDIFRX_DRIFT_MS));
+}
+
+static int rk_spdifrx_startup(struct snd_pcm_substream *substream,
+			      struct snd_soc_dai *dai)
+{
+	struct rk_spdifrx_dev *spdifrx = snd_soc_dai_get_drvdata(dai);
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	int ret;
+
+	if (spdifrx->ll_period_us) {
+		ret = snd_pcm_hw_constraint_minmax(runtime,
+						   SNDRV_PCM_HW_PARAM_PERIOD_TIME,
+						   0, spdifrx->ll_period_us);
+		if (ret < 0)
+			return ret;
+
+		ret = snd_pcm_hw_constraint_minmax(runtime,
+						   SNDRV_PCM_HW_PARAM_PERIODS,
+						   2, SPDIFRX_LL_PERIODS_MAX);
+		if (ret < 0)
+			return ret;
+	}
+
+	spdifrx->substream = substream;
+	spdifrx->snap_cnt = 0;
+	spdifrx->drift_ppb = 0;
+	spdifrx->jitter_us = 0;
+	schedule_delayed_work(&spdifrx->drift_work,
+			      msecs_to_jiffies(SPDIFRX_DRIFT_MS));
+
+	return 0;
+}
+
+static void rk_spdifrx_shutdown(struct snd_pcm_substream *substream,
+				struct snd_soc_dai *dai)
+{
+	struct rk_spdifrx_dev *spdifrx = snd_soc_dai_get_drvdata(dai);
+
+	cancel_delayed_work_sync(&spdifrx->drift_work);
+	spdifrx->substream = NULL;
+}
+
+static int rk_spdifrx_drift_info(struct snd_kcontrol *kcontrol,
+				 struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = kcontrol->private_value ? 0 : INT_MIN;
+	uinfo->value.integer.max = INT_MAX;
+
+	return 0;
+}
+
+static int rk_spdifrx_drift_get(struct snd_kcontrol *kcontrol,
+				struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_spdifrx_dev *spdifrx = snd_soc_component_get_drvdata(component);
+
+	if (kcontrol->private_value)
+		ucontrol->value.integer.value[0] = READ_ONCE(spdifrx->jitter_us);
+	else
+		ucontrol->value.integer.value[0] = READ_ONCE(spdifrx->drift_ppb);
+
+	return 0;
+}
+
+#define SPDIFRX_DRIFT_CTL(xname, jitter) \
+{	.iface = SNDRV_CTL_ELEM_IFACE_MIXER, .name = xname, \
+	.access = SNDRV_CTL_ELEM_ACCESS_READ | \
+		  SNDRV_CTL_ELEM_ACCESS_VOLATILE, \
+	.info = rk_spdifrx_drift_info, \
+	.get = rk_spdifrx_drift_get, \
+	.private_value = jitter }
+
+/* source rate vs the local clock, for resampler control */
+static const struct snd_kcontrol_new rk_spdifrx_controls[] = {
+	SPDIFRX_DRIFT_CTL("SPDIFRX Rate Drift PPB", 0),
+	SPDIFRX_DRIFT_CTL("SPDIFRX Jitter US", 1),
+};
+
 static int rk_spdifrx_dai_probe(struct snd_soc_dai *dai)
 {
 	struct rk_spdifrx_dev *spdifrx = snd_soc_dai_get_drvdata(dai);
 
 	dai->capture_dma_data = &spdifrx->capture_dma_data;
 
-	return 0;
+	return snd_soc_add_dai_controls(dai, rk_spdifrx_controls,
+					ARRAY_SIZE(rk_spdifrx_controls));
 }
 
 static const struct snd_soc_dai_ops rk_spdifrx_dai_ops = {
+	.startup = rk_spdifrx_startup,
+	.shutdown = rk_spdifrx_shutdown,
 	.hw_params = rk_spdifrx_hw_params,
 	.trigger = rk_spdifrx_trigger,
 };
@@ -317,6 +502,15 @@ static int rk_spdifrx_probe(struct platform_device *pdev)
 	spdifrx->capture_dma_data.addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
 	spdifrx->capture_dma_data.maxburst = 4;
 
+	/* small periods for a low latency capture, e.g. hdmi-in encoders */
+	if (of_property_read_bool(pdev->dev.of_node, "rockchip,low-latency")) {
+		spdifrx->ll_period_us = 1000;
+		of_property_read_u32(pdev->dev.of_node,
+				     "rockchip,low-latency-period-us",
+				     &spdifrx->ll_period_us);
+	}
+	INIT_DELAYED_WORK(&spdifrx->drift_work, rk_spdifrx_drift_work);
+
 	spdifrx->dev = &pdev->dev;
 	dev_set_drvdata(&pdev->dev, spdifrx);
 
@@ -11,10 +11,13 @@
 #include <linux/clk.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
 #include <linux/of_device.h>
 #include <linux/of_address.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
+#include <linux/rk-vad.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
 #include <sound/soc.h>
@@ -88,6 +91,8 @@ struct rockchip_vad {
 	u32 buffer_time; /* msec */
 	struct dentry *debugfs_dir;
 	void *buf;
+	struct miscdevice preroll_dev;
+	struct rk_vad_preroll_hdr *preroll;
 	bool acodec_cfg;
 	bool vswitch;
 	bool h_16bit;
@@ -99,18 +104,30 @@ static inline int vframe_size(struct rockchip_vad *vad, int bytes)
 	return bytes / vad->channels / vad->sample_bytes;
 }
 
+/*
+ * burst read from vad sram: word accesses instead of the byte loop
+ * memcpy_fromio() falls back to on arm32.
+ */
+static void vad_burst_fromio(void *to, const void __iomem *from, size_t size)
+{
+	if (IS_ALIGNED((unsigned long)to | (unsigned long)from | size, 4))
+		__ioread32_copy(to, from, size / 4);
+	else
+		memcpy_fromio(to, from, size);
+}
+
 static int chunk_sort(void __iomem *pos, void __iomem *end, int loop_cnt)
 {
-	char tbuf[CHUNK_SIZE];
+	u32 tbuf[CHUNK_SIZE / 4];
 	int size1, size2;
 
 	size1 = loop_cnt * 4;
 	size2 = CHUNK_SIZE - size1;
 
 	while (pos < end) {
-		memcpy_fromio(&tbuf[0], pos + size1, size2);
-		memcpy_fromio(&tbuf[size2], pos, size1);
-		memcpy_toio(pos, &tbuf[0], CHUNK_SIZE);
+		vad_burst_fromio(&tbuf[0], pos + size1, size2);
+		vad_burst_fromio((u8 *)tbuf + size2, pos, size1);
+		__iowrite32_copy(pos, &tbuf[0], CHUNK_SIZE / 4);
 		pos += CHUNK_SIZE;
 	}
 
@@ -155,6 +172,40 @@ static int vad_buffer_sort(struct rockchip_vad *vad)
 	return 0;
 }
 
+static void rockchip_vad_preroll_invalidate(struct rockchip_vad *vad)
+{
+	struct rk_vad_preroll_hdr *hdr = vad->preroll;
+
+	if (!hdr || (hdr->seq & 1))
+		return;
+
+	WRITE_ONCE(hdr->seq, hdr->seq + 1);
+	smp_wmb();
+}
+
+/* hand the frozen ring to mmap readers */
+static void rockchip_vad_preroll_publish(struct rockchip_vad *vad)
+{
+	struct rk_vad_preroll_hdr *hdr = vad->preroll;
+	struct vad_buf *vbuf = &vad->vbuf;
+
+	if (!hdr)
+		return;
+
+	rockchip_vad_preroll_invalidate(vad);
+	if (vad_buffer_sort(vad) < 0)
+		return;
+
+	hdr->size = vad->memphy_end - vad->memphy + 0x8;
+	hdr->head = vbuf->pos - vbuf->begin;
+	hdr->bytes = vbuf->size;
+	hdr->channels = vad->channels;
+	hdr->sample_bytes = vad->sample_bytes;
+	hdr->h_16bit = vad->h_16bit;
+	smp_wmb();
+	WRITE_ONCE(hdr->seq, hdr->seq + 1);
+}
+
 static int rockchip_vad_stop(struct rockchip_vad *vad)
 {
 	unsigned int val, frames;
@@ -218,6 +269,7 @@ static int rockchip_vad_stop(struct rockchip_vad *vad)
 
 	vad_preprocess_init(params);
 	voice_inactive_frames = 0;
+	rockchip_vad_preroll_publish(vad);
 
 	dev_info(vad->dev, "bufsize: %d, hw_abs: 0x%x\n",
 		 vbuf->size, params->noise_abs);
@@ -230,6 +282,8 @@ static int rockchip_vad_setup(struct rockchip_vad *vad)
 	struct regmap *regmap = vad->regmap;
 	u32 val, mask;
 
+	rockchip_vad_preroll_invalidate(vad);
+
 	dev_info(vad->dev, "sw_abs: 0x%x\n",
 		 vad->uparams.noise_abs);
 	regmap_update_bits(regmap, VAD_DET_CON5,
@@ -340,18 +394,18 @@ snd_pcm_sframes_t snd_pcm_vad_read(struct snd_pcm_substream *substream,
 	sbuf = vad->buf;
 	pbuf = vad->buf + bytes - vbytes;
 	if (!vbuf->loop) {
-		memcpy_fromio(pbuf, vbuf->pos, vbytes);
+		vad_burst_fromio(pbuf, vbuf->pos, vbytes);
 		vbuf->pos += vbytes;
 	} else {
 		if ((vbuf->pos + vbytes) <= vbuf->end) {
-			memcpy_fromio(pbuf, vbuf->pos, vbytes);
+			vad_burst_fromio(pbuf, vbuf->pos, vbytes);
 			vbuf->pos += vbytes;
 		} else {
 			int part1 = vbuf->end - vbuf->pos;
 			int part2 = vbytes - part1;
 
-			memcpy_fromio(pbuf, vbuf->pos, part1);
-			memcpy_fromio(pbuf + part1, vbuf->begin, part2);
+			vad_burst_fromio(pbuf, vbuf->pos, part1);
+			vad_burst_fromio(pbuf + part1, vbuf->begin, part2);
 			vbuf->pos = vbuf->begin + part2;
 		}
 	}
@@ -384,8 +438,6 @@ int snd_pcm_vad_preprocess(struct snd_pcm_substream *substream,
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	struct rockchip_vad *vad = NULL;
-	unsigned int i;
-	s16 *data;
 
 	vad = substream_get_drvdata(substream);
 
@@ -396,14 +448,9 @@ int snd_pcm_vad_preprocess(struct snd_pcm_substream *substream,
 	/* retrieve the high 16bit data */
 	if (runtime->sample_bits == 32 && vad->h_16bit)
 		buf += 2;
-	for (i = 0; i < size; i++) {
-		data = buf;
-		if (vad_preprocess(*data))
-			voice_inactive_frames = 0;
-		else
-			voice_inactive_frames++;
-		buf += frames_to_bytes(runtime, 1);
-	}
+	voice_inactive_frames = vad_preprocess_block(buf, size,
+						     frames_to_bytes(runtime, 1),
+						     voice_inactive_frames);
 
 	vad_preprocess_update_params(&vad->uparams);
 	return 0;
@@ -445,13 +492,22 @@ static int vad_memcpy_fromio(void *to, void __iomem *from,
 
 	fcount = size / frame_sz;
 	if (padding_sz) {
+		void *src = to + fcount * padding_sz;
+
+		/*
+		 * one burst read into the tail of the region, then spread
+		 * the frames out front to back; a padded frame never runs
+		 * into a source frame that is still to be moved.
+		 */
+		vad_burst_fromio(src, from, size);
 		for (i = 0; i < fcount; i++) {
-			memcpy_fromio(to, from, frame_sz);
+			memmove(to, src, frame_sz);
+			memset(to + frame_sz, 0x0, padding_sz);
 			to += step_dst;
-			from += step_src;
+			src += step_src;
 		}
 	} else {
-		memcpy_fromio(to, from, size);
+		vad_burst_fromio(to, from, size);
 	}
 
 	return 0;
@@ -1117,6 +1173,79 @@ static const struct file_operations rockchip_vad_reg_debugfs_fops = {
 };
 #endif
 
+static int rockchip_vad_preroll_mmap(struct file *file,
+				     struct vm_area_struct *vma)
+{
+	struct rockchip_vad *vad = container_of(file->private_data,
+						struct rockchip_vad,
+						preroll_dev);
+	unsigned long ring = PAGE_ALIGN(vad->memphy_end - vad->memphy + 0x8);
+	unsigned long size = vma->vm_end - vma->vm_start;
+	unsigned long hdr_size = RK_VAD_PREROLL_HDR;
+	int ret;
+
+	if (vma->vm_pgoff || size > hdr_size + ring)
+		return -EINVAL;
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_flags |= VM_DONTEXPAND | VM_DONTDUMP;
+
+	ret = remap_pfn_range(vma, vma->vm_start,
+			      virt_to_phys(vad->preroll) >> PAGE_SHIFT,
+			      min(size, hdr_size), vma->vm_page_prot);
+	if (ret || size <= hdr_size)
+		return ret;
+
+	/* same wc attribute as the kernel mapping of the sram */
+	return remap_pfn_range(vma, vma->vm_start + hdr_size,
+			       vad->memphy >> PAGE_SHIFT, size - hdr_size,
+			       pgprot_writecombine(vma->vm_page_prot));
+}
+
+static const struct file_operations rockchip_vad_preroll_fops = {
+	.owner = THIS_MODULE,
+	.mmap = rockchip_vad_preroll_mmap,
+};
+
+static void rockchip_vad_preroll_register(struct rockchip_vad *vad)
+{
+	int ret;
+
+	if (!PAGE_ALIGNED(vad->memphy) ||
+	    !IS_ALIGNED(RK_VAD_PREROLL_HDR, PAGE_SIZE)) {
+		dev_info(vad->dev, "sram not page aligned, no pre-roll mmap\n");
+		return;
+	}
+
+	vad->preroll = (void *)get_zeroed_page(GFP_KERNEL);
+	if (!vad->preroll)
+		return;
+	/* nothing captured yet */
+	vad->preroll->seq = 1;
+
+	vad->preroll_dev.minor = MISC_DYNAMIC_MINOR;
+	vad->preroll_dev.name = "vad_preroll";
+	vad->preroll_dev.fops = &rockchip_vad_preroll_fops;
+	vad->preroll_dev.parent = vad->dev;
+	ret = misc_register(&vad->preroll_dev);
+	if (ret) {
+		dev_err(vad->dev, "failed to register pre-roll dev: %d\n", ret);
+		free_page((unsigned long)vad->preroll);
+		vad->preroll = NULL;
+	}
+}
+
+static void rockchip_vad_preroll_unregister(struct rockchip_vad *vad)
+{
+	if (!vad->preroll)
+		return;
+
+	misc_deregister(&vad->preroll_dev);
+	free_page((unsigned long)vad->preroll);
+	vad->preroll = NULL;
+}
+
 static void rockchip_vad_init(struct rockchip_vad *vad)
 {
 	unsigned int val, mask;
@@ -1228,8 +1357,9 @@ static int rockchip_vad_probe(struct platform_device *pdev)
 		goto err_phandle;
 	vad->memphy = sram_res.start;
 	vad->memphy_end = sram_res.start + resource_size(&sram_res) - 0x8;
-	vad->membase = devm_ioremap(&pdev->dev, sram_res.start,
-				    resource_size(&sram_res));
+	/* sram, like drivers/misc/sram.c map it wc so reads can burst */
+	vad->membase = devm_ioremap_wc(&pdev->dev, sram_res.start,
+				       resource_size(&sram_res));
 	if (!vad->membase) {
 		ret = -ENOMEM;
 		goto err_phandle;
@@ -1280,10 +1410,13 @@ static int rockchip_vad_probe(struct platform_device *pdev)
 #endif
 
 	platform_set_drvdata(pdev, vad);
+	rockchip_vad_preroll_register(vad);
 	ret = snd_soc_register_component(&pdev->dev, &soc_vad_codec,
 					 &vad_dai, 1);
-	if (ret)
+	if (ret) {
+		rockchip_vad_preroll_unregister(vad);
 		goto err;
+	}
 
 	of_node_put(sram_np);
 
@@ -1304,6 +1437,7 @@ static int rockchip_vad_remove(struct platform_device *pdev)
 		clk_disable_unprepare(vad->hclk);
 	of_node_put(vad->audio_node);
 	snd_soc_unregister_component(&pdev->dev);
+	rockchip_vad_preroll_unregister(vad);
 	return 0;
 }
 
@@ -9,6 +9,8 @@
 #ifndef _ROCKCHIP_VAD_PREPROCESS_H
 #define _ROCKCHIP_VAD_PREPROCESS_H
 
+#include <linux/types.h>
+
 struct vad_params {
 	int noise_abs;
 	int noise_level;
@@ -26,4 +28,33 @@ void vad_preprocess_destroy(void);
 void vad_preprocess_update_params(struct vad_uparams *uparams);
 int vad_preprocess(int data);
 
+/*
+ * vad_preprocess_block - run @count samples through vad_preprocess()
+ * @data: first sample
+ * @count: number of samples
+ * @stride: bytes from one sample to the next
+ * @inactive: inactive samples before this block
+ *
+ * The detector is a recursive filter plus a running noise floor, so the
+ * samples are fed in order; the block form only keeps the interleaved
+ * walk out of the caller. Returns the inactive count after the block.
+ */
+static inline unsigned int vad_preprocess_block(const s16 *data,
+						unsigned int count,
+						unsigned int stride,
+						unsigned int inactive)
+{
+	const u8 *p = (const u8 *)data;
+
+	while (count--) {
+		if (vad_preprocess(*(const s16 *)p))
+			inactive = 0;
+		else
+			inactive++;
+		p += stride;
+	}
+
+	return inactive;
+}
+
 #endif
@@ -115,6 +115,7 @@ dmaengine_pcm_set_runtime_hwparams(struct snd_soc_component *component,
 	struct dma_chan *chan = pcm->chan[substream->stream];
 	struct snd_dmaengine_dai_dma_data *dma_data;
 	struct snd_pcm_hardware hw;
+	int ret;
 
 	if (rtd->num_cpus > 1) {
 		dev_err(rtd->dev,
@@ -151,7 +152,27 @@ dmaengine_pcm_set_runtime_hwparams(struct snd_soc_component *component,
 						  &hw,
 						  chan);
 
-	return snd_soc_set_runtime_hwparams(substream, &hw);
+	if ((pcm->flags & SND_DMAENGINE_PCM_FLAG_NO_PERIOD_WAKEUP) &&
+	    !(hw.info & SNDRV_PCM_INFO_BATCH))
+		hw.info |= SNDRV_PCM_INFO_NO_PERIOD_WAKEUP;
+
+	if ((pcm->flags & SND_DMAENGINE_PCM_FLAG_PLANAR_CAPTURE) &&
+	    substream->stream == SNDRV_PCM_STREAM_CAPTURE)
+		hw.info |= SNDRV_PCM_INFO_NONINTERLEAVED;
+
+	ret = snd_soc_set_runtime_hwparams(substream, &hw);
+	if (ret)
+		return ret;
+
+	/* the mmapped buffer is the interleaved DMA buffer */
+	if (hw.info & SNDRV_PCM_INFO_NONINTERLEAVED)
+		ret = snd_pcm_hw_constraint_mask64(substream->runtime,
+				SNDRV_PCM_HW_PARAM_ACCESS,
+				BIT_ULL(SNDRV_PCM_ACCESS_MMAP_INTERLEAVED) |
+				BIT_ULL(SNDRV_PCM_ACCESS_RW_INTERLEAVED) |
+				BIT_ULL(SNDRV_PCM_ACCESS_RW_NONINTERLEAVED));
+
+	return ret;
 }
 
 static int dmaengine_pcm_open(struct snd_soc_component *component,
@@ -330,6 +351,63 @@ static int dmaengine_copy_user(struct snd_soc_component *component,
 	return 0;
 }
 
+/* bounce chunk for splitting one channel out of the interleaved buffer */
+#define DMAENGINE_PCM_PLANAR_CHUNK	256
+
+static void dmaengine_pcm_deinterleave(void *dst, const void *src,
+				       unsigned long samples, unsigned int ss,
+				       unsigned int fs)
+{
+	unsigned long i;
+
+	switch (ss) {
+	case 2:
+		for (i = 0; i < samples; i++, src += fs)
+			((u16 *)dst)[i] = *(const u16 *)src;
+		break;
+	case 4:
+		for (i = 0; i < samples; i++, src += fs)
+			((u32 *)dst)[i] = *(const u32 *)src;
+		break;
+	default:
+		for (i = 0; i < samples; i++, src += fs, dst += ss)
+			memcpy(dst, src, ss);
+		break;
+	}
+}
+
+static int dmaengine_copy_user_planar(struct snd_soc_component *component,
+				      struct snd_pcm_substream *substream,
+				      int channel, unsigned long hwoff,
+				      void __user *buf, unsigned long bytes)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	unsigned int ss = samples_to_bytes(runtime, 1);
+	unsigned int fs = frames_to_bytes(runtime, 1);
+	u8 tmp[DMAENGINE_PCM_PLANAR_CHUNK];
+	unsigned long done, n;
+	void *dma_ptr;
+
+	if (runtime->access != SNDRV_PCM_ACCESS_RW_NONINTERLEAVED) {
+		dma_ptr = runtime->dma_area + hwoff;
+		if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+			return copy_from_user(dma_ptr, buf, bytes) ? -EFAULT : 0;
+		return copy_to_user(buf, dma_ptr, bytes) ? -EFAULT : 0;
+	}
+
+	/* hwoff and bytes count in samples of this channel */
+	dma_ptr = runtime->dma_area + hwoff / ss * fs + channel * ss;
+	for (done = 0; done < bytes; done += n) {
+		n = min_t(unsigned long, bytes - done, sizeof(tmp) / ss * ss);
+		dmaengine_pcm_deinterleave(tmp, dma_ptr, n / ss, ss, fs);
+		if (copy_to_user(buf + done, tmp, n))
+			return -EFAULT;
+		dma_ptr += n / ss * fs;
+	}
+
+	return 0;
+}
+
 static const struct snd_soc_component_driver dmaengine_pcm_component = {
 	.name		= SND_DMAENGINE_PCM_DRV_NAME,
 	.probe_order	= SND_SOC_COMP_ORDER_LATE,
@@ -353,6 +431,18 @@ static const struct snd_soc_component_driver dmaengine_pcm_component_process = {
 	.pcm_construct	= dmaengine_pcm_new,
 };
 
+static const struct snd_soc_component_driver dmaengine_pcm_component_planar = {
+	.name		= SND_DMAENGINE_PCM_DRV_NAME,
+	.probe_order	= SND_SOC_COMP_ORDER_LATE,
+	.open		= dmaengine_pcm_open,
+	.close		= dmaengine_pcm_close,
+	.hw_params	= dmaengine_pcm_hw_params,
+	.trigger	= dmaengine_pcm_trigger,
+	.pointer	= dmaengine_pcm_pointer,
+	.copy_user	= dmaengine_copy_user_planar,
+	.pcm_construct	= dmaengine_pcm_new,
+};
+
 static const char * const dmaengine_pcm_dma_channel_names[] = {
 	[SNDRV_PCM_STREAM_PLAYBACK] = "tx",
 	[SNDRV_PCM_STREAM_CAPTURE] = "rx",
@@ -453,6 +543,8 @@ int snd_dmaengine_pcm_register(struct device *dev,
 
 	if (config && config->process)
 		driver = &dmaengine_pcm_component_process;
+	else if (flags & SND_DMAENGINE_PCM_FLAG_PLANAR_CAPTURE)
+		driver = &dmaengine_pcm_component_planar;
 	else
 		driver = &dmaengine_pcm_component;
 
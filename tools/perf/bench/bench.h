@@ -48,6 +48,10 @@ int bench_epoll_ctl(int argc, const char **argv);
 int bench_synthesize(int argc, const char **argv);
 int bench_kallsyms_parse(int argc, const char **argv);
 int bench_inject_build_id(int argc, const char **argv);
+int bench_dmabuf_alloc(int argc, const char **argv);
+int bench_dmabuf_mmap(int argc, const char **argv);
+int bench_dmabuf_sync(int argc, const char **argv);
+int bench_dmabuf_import(int argc, const char **argv);
 
 #define BENCH_FORMAT_DEFAULT_STR	"default"
 #define BENCH_FORMAT_DEFAULT		0
@@ -0,0 +1,500 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * dmabuf.c
+ *
+ * dmabuf: Benchmarks for dma-buf heap allocation, mmap, cache sync and
+ * import
+ *
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ */
+#include "bench.h"
+#include "../util/stat.h"
+#include "../util/string2.h"
+#include <subcmd/parse-options.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
+#include <linux/time64.h>
+
+#define DMA_HEAP_DEVPATH	"/dev/dma_heap"
+#define SYNC_MIN_SIZE		4096
+
+/*
+ * the drm.h under tools is only there for the ioctl beautifier and pulls
+ * in drm_mode.h, take the three vgem ioctls needed from the uapi here.
+ */
+struct drm_version {
+	int version_major;
+	int version_minor;
+	int version_patchlevel;
+	size_t name_len;
+	char *name;
+	size_t date_len;
+	char *date;
+	size_t desc_len;
+	char *desc;
+};
+
+struct drm_gem_close {
+	__u32 handle;
+	__u32 pad;
+};
+
+struct drm_prime_handle {
+	__u32 handle;
+	__u32 flags;
+	__s32 fd;
+};
+
+#define DRM_IOCTL_VERSION		_IOWR('d', 0x00, struct drm_version)
+#define DRM_IOCTL_GEM_CLOSE		_IOW('d', 0x09, struct drm_gem_close)
+#define DRM_IOCTL_PRIME_FD_TO_HANDLE	_IOWR('d', 0x2e, struct drm_prime_handle)
+
+static const char	*heap_str;
+static const char	*size_str	= "1MB";
+static unsigned int	nr_loops	= 100;
+static bool		partial;
+
+static const struct option options[] = {
+	OPT_STRING('H', "heap", &heap_str, "heap",
+		    "Specify the heap under " DMA_HEAP_DEVPATH ", all heaps by default"),
+	OPT_STRING('s', "size", &size_str, "1MB",
+		    "Specify the size of the buffers. "
+		    "Available units: B, KB, MB, GB and TB (case insensitive)"),
+	OPT_UINTEGER('l', "nr_loops", &nr_loops,
+		    "Specify the number of loops to run. (default: 100)"),
+	OPT_BOOLEAN('p', "partial", &partial,
+		    "sync: sync parts of one buffer with DMA_BUF_IOCTL_SYNC_PARTIAL"),
+	OPT_END()
+};
+
+static const char * const bench_dmabuf_usage[] = {
+	"perf bench dmabuf <benchmark> <options>",
+	NULL
+};
+
+typedef int (*dmabuf_bench_t)(const char *heap, int heap_fd, size_t size);
+
+static u64 now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static double ns2us(u64 ns)
+{
+	return (double)ns / NSEC_PER_USEC;
+}
+
+static void print_stats(const char *what, struct stats *st)
+{
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf(" %24s: %12.3f usec (+- %.2f%%)\n", what, avg_stats(st),
+		       rel_stddev_stats(stddev_stats(st), avg_stats(st)));
+		break;
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.3f\n", avg_stats(st));
+		break;
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+	}
+}
+
+static int dmabuf_alloc(int heap_fd, size_t size)
+{
+	struct dma_heap_allocation_data data = {
+		.len = size,
+		.fd_flags = O_RDWR | O_CLOEXEC,
+	};
+
+	if (ioctl(heap_fd, DMA_HEAP_IOCTL_ALLOC, &data) < 0)
+		return -errno;
+
+	return data.fd;
+}
+
+static int dmabuf_sync(int buf_fd, u64 flags, u32 offset, u32 len)
+{
+	struct dma_buf_sync_partial sync_partial = {
+		.flags = flags,
+		.offset = offset,
+		.len = len,
+	};
+	struct dma_buf_sync sync = {
+		.flags = flags,
+	};
+
+	if (partial)
+		return ioctl(buf_fd, DMA_BUF_IOCTL_SYNC_PARTIAL, &sync_partial);
+	return ioctl(buf_fd, DMA_BUF_IOCTL_SYNC, &sync);
+}
+
+static void *dmabuf_mmap(int buf_fd, size_t size)
+{
+	void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, buf_fd, 0);
+
+	return p == MAP_FAILED ? NULL : p;
+}
+
+static void touch_pages(void *p, size_t size)
+{
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	volatile char *c = p;
+	size_t off;
+
+	for (off = 0; off < size; off += page_size)
+		c[off] = 1;
+}
+
+static int do_alloc(const char *heap, int heap_fd, size_t size)
+{
+	struct stats alloc_stats, free_stats;
+	unsigned int i;
+	int buf_fd;
+	u64 t0, t1;
+
+	init_stats(&alloc_stats);
+	init_stats(&free_stats);
+
+	for (i = 0; i < nr_loops; i++) {
+		t0 = now_ns();
+		buf_fd = dmabuf_alloc(heap_fd, size);
+		t1 = now_ns();
+		if (buf_fd < 0) {
+			fprintf(stderr, "%s: alloc of %s failed: %s\n", heap,
+				size_str, strerror(-buf_fd));
+			return buf_fd;
+		}
+		update_stats(&alloc_stats, ns2us(t1 - t0));
+
+		t0 = now_ns();
+		close(buf_fd);
+		t1 = now_ns();
+		update_stats(&free_stats, ns2us(t1 - t0));
+	}
+
+	print_stats("alloc", &alloc_stats);
+	print_stats("free", &free_stats);
+
+	return 0;
+}
+
+static int do_mmap(const char *heap, int heap_fd, size_t size)
+{
+	struct stats mmap_stats, touch_stats, munmap_stats;
+	unsigned int i;
+	int buf_fd;
+	u64 t0, t1;
+	void *p;
+
+	init_stats(&mmap_stats);
+	init_stats(&touch_stats);
+	init_stats(&munmap_stats);
+
+	for (i = 0; i < nr_loops; i++) {
+		buf_fd = dmabuf_alloc(heap_fd, size);
+		if (buf_fd < 0) {
+			fprintf(stderr, "%s: alloc of %s failed: %s\n", heap,
+				size_str, strerror(-buf_fd));
+			return buf_fd;
+		}
+
+		t0 = now_ns();
+		p = dmabuf_mmap(buf_fd, size);
+		t1 = now_ns();
+		if (!p) {
+			fprintf(stderr, "%s: mmap failed: %s\n", heap, strerror(errno));
+			close(buf_fd);
+			return -errno;
+		}
+		update_stats(&mmap_stats, ns2us(t1 - t0));
+
+		/* the heaps fault the pages in on first access */
+		t0 = now_ns();
+		touch_pages(p, size);
+		t1 = now_ns();
+		update_stats(&touch_stats, ns2us(t1 - t0));
+
+		t0 = now_ns();
+		munmap(p, size);
+		t1 = now_ns();
+		update_stats(&munmap_stats, ns2us(t1 - t0));
+
+		close(buf_fd);
+	}
+
+	print_stats("mmap", &mmap_stats);
+	print_stats("first touch", &touch_stats);
+	print_stats("munmap", &munmap_stats);
+
+	return 0;
+}
+
+static int sync_one(const char *heap, int buf_fd, size_t len)
+{
+	struct stats start_stats, end_stats;
+	unsigned int i;
+	u64 t0, t1;
+
+	init_stats(&start_stats);
+	init_stats(&end_stats);
+
+	for (i = 0; i < nr_loops; i++) {
+		t0 = now_ns();
+		if (dmabuf_sync(buf_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW, 0, len))
+			goto out_err;
+		t1 = now_ns();
+		update_stats(&start_stats, ns2us(t1 - t0));
+
+		t0 = now_ns();
+		if (dmabuf_sync(buf_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW, 0, len))
+			goto out_err;
+		t1 = now_ns();
+		update_stats(&end_stats, ns2us(t1 - t0));
+	}
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf(" # %zu KB\n", len / 1024);
+	print_stats("sync start", &start_stats);
+	print_stats("sync end", &end_stats);
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf(" %24s: %12.3f MB/sec\n", "start + end",
+		       (double)len / (avg_stats(&start_stats) + avg_stats(&end_stats)));
+
+	return 0;
+
+out_err:
+	fprintf(stderr, "%s: sync of %zu bytes failed: %s\n", heap, len,
+		strerror(errno));
+	return -errno;
+}
+
+/* buffers of 4KB up to the size, or parts of one when partial */
+static int do_sync(const char *heap, int heap_fd, size_t size)
+{
+	int buf_fd = -1, ret = 0;
+	size_t len;
+	void *p;
+
+	for (len = SYNC_MIN_SIZE; len <= size && !ret; len <<= 1) {
+		if (buf_fd < 0 || !partial) {
+			buf_fd = dmabuf_alloc(heap_fd, partial ? size : len);
+			if (buf_fd < 0) {
+				fprintf(stderr, "%s: alloc failed: %s\n", heap,
+					strerror(-buf_fd));
+				return buf_fd;
+			}
+			/* cpu mapped and dirty, as a buffer really synced */
+			p = dmabuf_mmap(buf_fd, partial ? size : len);
+			if (p) {
+				touch_pages(p, partial ? size : len);
+				munmap(p, partial ? size : len);
+			}
+		}
+
+		ret = sync_one(heap, buf_fd, len);
+
+		if (!partial) {
+			close(buf_fd);
+			buf_fd = -1;
+		}
+	}
+
+	if (buf_fd >= 0)
+		close(buf_fd);
+
+	return ret;
+}
+
+static int check_vgem(int fd)
+{
+	struct drm_version version = { 0 };
+	char name[5] = { 0 };
+
+	version.name_len = 4;
+	version.name = name;
+
+	if (ioctl(fd, DRM_IOCTL_VERSION, &version))
+		return 0;
+
+	return !strcmp(name, "vgem");
+}
+
+static int open_vgem(void)
+{
+	char name[32];
+	int i, fd;
+
+	for (i = 0; i < 16; i++) {
+		snprintf(name, sizeof(name), "/dev/dri/card%d", i);
+		fd = open(name, O_RDWR | O_CLOEXEC);
+		if (fd < 0)
+			continue;
+		if (check_vgem(fd))
+			return fd;
+		close(fd);
+	}
+
+	return -1;
+}
+
+/* vgem attaches and maps the buffer on import, drops it on close */
+static int do_import(const char *heap, int heap_fd, size_t size)
+{
+	struct stats import_stats, close_stats;
+	struct drm_prime_handle prime;
+	struct drm_gem_close gem_close;
+	int vgem_fd, buf_fd, ret = 0;
+	unsigned int i;
+	u64 t0, t1;
+
+	vgem_fd = open_vgem();
+	if (vgem_fd < 0) {
+		fprintf(stderr, "no vgem device to import into, is CONFIG_DRM_VGEM set?\n");
+		return -ENODEV;
+	}
+
+	buf_fd = dmabuf_alloc(heap_fd, size);
+	if (buf_fd < 0) {
+		fprintf(stderr, "%s: alloc of %s failed: %s\n", heap, size_str,
+			strerror(-buf_fd));
+		close(vgem_fd);
+		return buf_fd;
+	}
+
+	init_stats(&import_stats);
+	init_stats(&close_stats);
+
+	for (i = 0; i < nr_loops; i++) {
+		memset(&prime, 0, sizeof(prime));
+		prime.fd = buf_fd;
+		t0 = now_ns();
+		ret = ioctl(vgem_fd, DRM_IOCTL_PRIME_FD_TO_HANDLE, &prime);
+		t1 = now_ns();
+		if (ret) {
+			ret = -errno;
+			fprintf(stderr, "%s: import failed: %s\n", heap, strerror(errno));
+			break;
+		}
+		update_stats(&import_stats, ns2us(t1 - t0));
+
+		memset(&gem_close, 0, sizeof(gem_close));
+		gem_close.handle = prime.handle;
+		t0 = now_ns();
+		ioctl(vgem_fd, DRM_IOCTL_GEM_CLOSE, &gem_close);
+		t1 = now_ns();
+		update_stats(&close_stats, ns2us(t1 - t0));
+	}
+
+	if (!ret) {
+		print_stats("import + attach", &import_stats);
+		print_stats("close + detach", &close_stats);
+	}
+
+	close(buf_fd);
+	close(vgem_fd);
+
+	return ret;
+}
+
+static int run_heap(const char *heap, const char *desc, dmabuf_bench_t fn,
+		    size_t size)
+{
+	char path[PATH_MAX];
+	int heap_fd, ret;
+
+	snprintf(path, sizeof(path), "%s/%s", DMA_HEAP_DEVPATH, heap);
+	heap_fd = open(path, O_RDWR | O_CLOEXEC);
+	if (heap_fd < 0) {
+		fprintf(stderr, "open %s failed: %s\n", path, strerror(errno));
+		return -errno;
+	}
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# heap '%s', %s %s, %u loops\n", heap, desc, size_str,
+		       nr_loops);
+	ret = fn(heap, heap_fd, size);
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("\n");
+
+	close(heap_fd);
+
+	return ret;
+}
+
+static int bench_dmabuf_common(int argc, const char **argv, const char *desc,
+			       dmabuf_bench_t fn)
+{
+	struct dirent *dent;
+	size_t size;
+	int ret = 0;
+	DIR *dir;
+
+	argc = parse_options(argc, argv, options, bench_dmabuf_usage, 0);
+	if (argc) {
+		usage_with_options(bench_dmabuf_usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	size = (size_t)perf_atoll((char *)size_str);
+	if ((s64)size <= 0 || !nr_loops) {
+		fprintf(stderr, "Invalid size:%s or loops:%u\n", size_str, nr_loops);
+		return 1;
+	}
+
+	if (heap_str)
+		return run_heap(heap_str, desc, fn, size) ? 1 : 0;
+
+	dir = opendir(DMA_HEAP_DEVPATH);
+	if (!dir) {
+		fprintf(stderr, "open %s failed: %s\n", DMA_HEAP_DEVPATH,
+			strerror(errno));
+		return 1;
+	}
+	/* a heap too small for the size must not hide the others */
+	while ((dent = readdir(dir))) {
+		if (dent->d_name[0] == '.')
+			continue;
+		if (run_heap(dent->d_name, desc, fn, size))
+			ret = 1;
+	}
+	closedir(dir);
+
+	return ret;
+}
+
+int bench_dmabuf_alloc(int argc, const char **argv)
+{
+	return bench_dmabuf_common(argc, argv, "alloc and free of", do_alloc);
+}
+
+int bench_dmabuf_mmap(int argc, const char **argv)
+{
+	return bench_dmabuf_common(argc, argv, "mmap and first touch of", do_mmap);
+}
+
+int bench_dmabuf_sync(int argc, const char **argv)
+{
+	return bench_dmabuf_common(argc, argv, "cache sync of 4KB up to", do_sync);
+}
+
+int bench_dmabuf_import(int argc, const char **argv)
+{
+	return bench_dmabuf_common(argc, argv, "vgem import of", do_import);
+}
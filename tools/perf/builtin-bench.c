@@ -16,6 +16,7 @@
  *  numa  ... NUMA scheduling and MM performance
  *  futex ... Futex performance
  *  epoll ... Event poll performance
+ *  dmabuf ... dma-buf heap performance
  */
 #include <subcmd/parse-options.h>
 #include "builtin.h"
@@ -84,6 +85,15 @@ static struct bench epoll_benchmarks[] = {
 };
 #endif // HAVE_EVENTFD_SUPPORT
 
+static struct bench dmabuf_benchmarks[] = {
+	{ "alloc",	"Benchmark for dma-buf heap alloc and free",	bench_dmabuf_alloc	},
+	{ "mmap",	"Benchmark for dma-buf mmap and first touch",	bench_dmabuf_mmap	},
+	{ "sync",	"Benchmark for DMA_BUF_IOCTL_SYNC by size",	bench_dmabuf_sync	},
+	{ "import",	"Benchmark for dma-buf import into vgem",	bench_dmabuf_import	},
+	{ "all",	"Run all dma-buf benchmarks",			NULL			},
+	{ NULL,		NULL,						NULL			}
+};
+
 static struct bench internals_benchmarks[] = {
 	{ "synthesize", "Benchmark perf event synthesis",	bench_synthesize	},
 	{ "kallsyms-parse", "Benchmark kallsyms parsing",	bench_kallsyms_parse	},
@@ -108,6 +118,7 @@ static struct collection collections[] = {
 #ifdef HAVE_EVENTFD_SUPPORT
 	{"epoll",       "Epoll stressing benchmarks",                   epoll_benchmarks        },
 #endif
+	{ "dmabuf",	"dma-buf heap benchmarks",			dmabuf_benchmarks	},
 	{ "internals",	"Perf-internals benchmarks",			internals_benchmarks	},
 	{ "all",	"All benchmarks",				NULL			},
 	{ NULL,		NULL,						NULL			}
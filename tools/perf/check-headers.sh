@@ -3,6 +3,8 @@
 
 FILES='
 include/uapi/linux/const.h
+include/uapi/linux/dma-buf.h
+include/uapi/linux/dma-heap.h
 include/uapi/drm/drm.h
 include/uapi/drm/i915_drm.h
 include/uapi/linux/fadvise.h
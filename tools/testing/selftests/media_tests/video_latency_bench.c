@@ -0,0 +1,475 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * video_latency_bench - V4L2 capture latency benchmark
+ *
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ */
+
+/*
+ * This benchmark should not be included in the Kselftest run. It needs a
+ * sensor streaming into a capture node, e.g. of rkisp or rkcif.
+ *
+ * It streams the capture node with DMABUF buffers from a dma-buf heap and
+ * measures, over the whole run:
+ *	- the VIDIOC_QBUF and VIDIOC_DQBUF syscall cost
+ *	- the time from the V4L2_EVENT_FRAME_SYNC of a frame on the subdev
+ *	  to its DQBUF, when a subdev is given
+ *	- the interval of the buffer timestamps and its jitter
+ *	- frames dropped, from gaps in the buffer sequence, and error buffers
+ *
+ * Usage:
+ *	sudo ./video_latency_bench -d /dev/videoX [-s /dev/v4l-subdevY]
+ *		[-n frames] [-b buffers] [-H /dev/dma_heap/system]
+ *		[-c frames.csv] [-m]
+ *
+ *	-s is the subdev sending the frame sync events, the isp subdev of
+ *	rkisp or the mipi csi2 subdev of rkcif. -c writes one csv line per
+ *	frame, -m prints the summary as key=value lines for scripts.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/dma-heap.h>
+#include <linux/videodev2.h>
+
+#define MAX_BUFFERS	32
+/* sofs remembered for frames not dequeued yet */
+#define SOF_RING	64
+
+struct stat_acc {
+	uint64_t n;
+	double sum;
+	double sum2;
+	double min;
+	double max;
+};
+
+struct buffer {
+	int fd[VIDEO_MAX_PLANES];
+};
+
+static struct buffer buffers[MAX_BUFFERS];
+static struct v4l2_format fmt;
+static enum v4l2_buf_type buf_type;
+static unsigned int num_planes;
+static bool mplane;
+
+static uint64_t sof_ns[SOF_RING];
+static uint32_t sof_seq[SOF_RING];
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void stat_add(struct stat_acc *s, double v)
+{
+	if (!s->n || v < s->min)
+		s->min = v;
+	if (!s->n || v > s->max)
+		s->max = v;
+	s->n++;
+	s->sum += v;
+	s->sum2 += v * v;
+}
+
+static double stat_avg(const struct stat_acc *s)
+{
+	return s->n ? s->sum / s->n : 0;
+}
+
+static double stat_stddev(const struct stat_acc *s)
+{
+	double avg = stat_avg(s);
+	double var;
+
+	if (s->n < 2)
+		return 0;
+	var = s->sum2 / s->n - avg * avg;
+	return var > 0 ? sqrt(var) : 0;
+}
+
+static void stat_print(const char *name, const struct stat_acc *s,
+		       bool machine)
+{
+	if (machine) {
+		printf("%s_n=%llu\n%s_avg_us=%.3f\n%s_stddev_us=%.3f\n"
+		       "%s_min_us=%.3f\n%s_max_us=%.3f\n",
+		       name, (unsigned long long)s->n, name, stat_avg(s),
+		       name, stat_stddev(s), name, s->min, name, s->max);
+		return;
+	}
+
+	printf("%-16s %8llu samples, avg %10.3f us, stddev %10.3f us, min %10.3f us, max %10.3f us\n",
+	       name, (unsigned long long)s->n, stat_avg(s), stat_stddev(s),
+	       s->min, s->max);
+}
+
+static int dmabuf_alloc(int heap_fd, size_t len)
+{
+	struct dma_heap_allocation_data data = {
+		.len = len,
+		.fd_flags = O_RDWR | O_CLOEXEC,
+	};
+
+	if (ioctl(heap_fd, DMA_HEAP_IOCTL_ALLOC, &data) < 0)
+		return -1;
+
+	return data.fd;
+}
+
+static int queue_buffer(int fd, unsigned int index, struct stat_acc *qbuf)
+{
+	struct v4l2_plane planes[VIDEO_MAX_PLANES];
+	struct v4l2_buffer buf;
+	unsigned int i;
+	uint64_t t0;
+	int ret;
+
+	memset(&buf, 0, sizeof(buf));
+	memset(planes, 0, sizeof(planes));
+	buf.type = buf_type;
+	buf.memory = V4L2_MEMORY_DMABUF;
+	buf.index = index;
+	if (mplane) {
+		buf.m.planes = planes;
+		buf.length = num_planes;
+		for (i = 0; i < num_planes; i++) {
+			planes[i].m.fd = buffers[index].fd[i];
+			planes[i].length = fmt.fmt.pix_mp.plane_fmt[i].sizeimage;
+		}
+	} else {
+		buf.m.fd = buffers[index].fd[0];
+		buf.length = fmt.fmt.pix.sizeimage;
+	}
+
+	t0 = now_ns();
+	ret = ioctl(fd, VIDIOC_QBUF, &buf);
+	if (qbuf && !ret)
+		stat_add(qbuf, (now_ns() - t0) / 1000.0);
+	if (ret)
+		printf("VIDIOC_QBUF errno %s\n", strerror(errno));
+
+	return ret;
+}
+
+static int setup_buffers(int fd, const char *heap, unsigned int count)
+{
+	struct v4l2_requestbuffers req;
+	unsigned int i, p;
+	size_t size;
+	int heap_fd;
+
+	heap_fd = open(heap, O_RDWR | O_CLOEXEC);
+	if (heap_fd < 0) {
+		printf("open %s errno %s\n", heap, strerror(errno));
+		return -1;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.count = count;
+	req.type = buf_type;
+	req.memory = V4L2_MEMORY_DMABUF;
+	if (ioctl(fd, VIDIOC_REQBUFS, &req) < 0) {
+		printf("VIDIOC_REQBUFS errno %s\n", strerror(errno));
+		close(heap_fd);
+		return -1;
+	}
+
+	for (i = 0; i < req.count; i++) {
+		for (p = 0; p < num_planes; p++) {
+			size = mplane ? fmt.fmt.pix_mp.plane_fmt[p].sizeimage :
+					fmt.fmt.pix.sizeimage;
+			buffers[i].fd[p] = dmabuf_alloc(heap_fd, size);
+			if (buffers[i].fd[p] < 0) {
+				printf("alloc of %zu bytes from %s errno %s\n",
+				       size, heap, strerror(errno));
+				close(heap_fd);
+				return -1;
+			}
+		}
+	}
+	close(heap_fd);
+
+	return req.count;
+}
+
+static int subscribe_sof(int sd_fd)
+{
+	struct v4l2_event_subscription sub;
+
+	memset(&sub, 0, sizeof(sub));
+	sub.type = V4L2_EVENT_FRAME_SYNC;
+	if (ioctl(sd_fd, VIDIOC_SUBSCRIBE_EVENT, &sub) < 0) {
+		printf("VIDIOC_SUBSCRIBE_EVENT errno %s\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+static void dequeue_sof(int sd_fd)
+{
+	struct v4l2_event ev;
+	unsigned int slot;
+
+	while (!ioctl(sd_fd, VIDIOC_DQEVENT, &ev)) {
+		if (ev.type != V4L2_EVENT_FRAME_SYNC)
+			continue;
+		slot = ev.u.frame_sync.frame_sequence % SOF_RING;
+		sof_seq[slot] = ev.u.frame_sync.frame_sequence;
+		sof_ns[slot] = (uint64_t)ev.timestamp.tv_sec * 1000000000ULL +
+			       ev.timestamp.tv_nsec;
+		if (!ev.pending)
+			break;
+	}
+}
+
+static void usage(const char *prog)
+{
+	printf("Usage: %s -d </dev/videoX> [-s </dev/v4l-subdevY>] [-n frames]\n"
+	       "\t[-b buffers] [-H </dev/dma_heap/name>] [-c <file.csv>] [-m]\n",
+	       prog);
+	exit(-1);
+}
+
+int main(int argc, char **argv)
+{
+	struct stat_acc qbuf = { 0 }, dqbuf = { 0 }, latency = { 0 };
+	struct stat_acc interval = { 0 };
+	const char *heap = "/dev/dma_heap/system";
+	const char *video_dev = NULL, *subdev = NULL, *csv_path = NULL;
+	struct v4l2_plane planes[VIDEO_MAX_PLANES];
+	unsigned int frames = 1000, count = 4;
+	uint64_t dropped = 0, errors = 0, unmatched = 0, done = 0;
+	uint64_t t0, t1, ts, last_ts = 0, start_ns;
+	struct v4l2_capability vcap;
+	struct pollfd pfd[2];
+	struct v4l2_buffer buf;
+	uint32_t last_seq = 0;
+	bool machine = false;
+	FILE *csv = NULL;
+	int fd, sd_fd = -1, opt, nfds, ret;
+	unsigned int slot;
+	double lat_us;
+
+	while ((opt = getopt(argc, argv, "d:s:n:b:H:c:m")) != -1) {
+		switch (opt) {
+		case 'd':
+			video_dev = optarg;
+			break;
+		case 's':
+			subdev = optarg;
+			break;
+		case 'n':
+			frames = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			count = strtoul(optarg, NULL, 0);
+			break;
+		case 'H':
+			heap = optarg;
+			break;
+		case 'c':
+			csv_path = optarg;
+			break;
+		case 'm':
+			machine = true;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!video_dev || !frames || !count || count > MAX_BUFFERS)
+		usage(argv[0]);
+
+	fd = open(video_dev, O_RDWR | O_NONBLOCK);
+	if (fd == -1) {
+		printf("Video Device open errno %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	if (ioctl(fd, VIDIOC_QUERYCAP, &vcap) < 0) {
+		printf("VIDIOC_QUERYCAP errno %s\n", strerror(errno));
+		exit(-1);
+	}
+	if (vcap.capabilities & V4L2_CAP_DEVICE_CAPS)
+		vcap.capabilities = vcap.device_caps;
+	mplane = vcap.capabilities & V4L2_CAP_VIDEO_CAPTURE_MPLANE;
+	if (!mplane && !(vcap.capabilities & V4L2_CAP_VIDEO_CAPTURE)) {
+		printf("%s is not a capture device\n", video_dev);
+		exit(-1);
+	}
+	buf_type = mplane ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE :
+			    V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+	/* stream the format the node is set up with */
+	memset(&fmt, 0, sizeof(fmt));
+	fmt.type = buf_type;
+	if (ioctl(fd, VIDIOC_G_FMT, &fmt) < 0) {
+		printf("VIDIOC_G_FMT errno %s\n", strerror(errno));
+		exit(-1);
+	}
+	num_planes = mplane ? fmt.fmt.pix_mp.num_planes : 1;
+
+	if (subdev) {
+		sd_fd = open(subdev, O_RDWR | O_NONBLOCK);
+		if (sd_fd == -1) {
+			printf("Subdev open errno %s\n", strerror(errno));
+			exit(-1);
+		}
+		if (subscribe_sof(sd_fd))
+			exit(-1);
+	}
+
+	if (csv_path) {
+		csv = fopen(csv_path, "w");
+		if (!csv) {
+			printf("open %s errno %s\n", csv_path, strerror(errno));
+			exit(-1);
+		}
+		fprintf(csv, "sequence,timestamp_ns,dqbuf_ns,sof_latency_us,interval_us,dqbuf_us,flags\n");
+	}
+
+	ret = setup_buffers(fd, heap, count);
+	if (ret <= 0)
+		exit(-1);
+	count = ret;
+	for (slot = 0; slot < count; slot++)
+		if (queue_buffer(fd, slot, NULL))
+			exit(-1);
+
+	if (ioctl(fd, VIDIOC_STREAMON, &buf_type) < 0) {
+		printf("VIDIOC_STREAMON errno %s\n", strerror(errno));
+		exit(-1);
+	}
+	start_ns = now_ns();
+
+	pfd[0].fd = fd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = sd_fd;
+	pfd[1].events = POLLPRI;
+	nfds = sd_fd >= 0 ? 2 : 1;
+
+	while (done < frames) {
+		ret = poll(pfd, nfds, 5000);
+		if (ret == 0) {
+			printf("no frame for 5 seconds\n");
+			break;
+		}
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			printf("poll errno %s\n", strerror(errno));
+			break;
+		}
+
+		/* the sof of a frame comes before its buffer */
+		if (nfds > 1 && (pfd[1].revents & POLLPRI))
+			dequeue_sof(sd_fd);
+		if (!(pfd[0].revents & POLLIN))
+			continue;
+
+		memset(&buf, 0, sizeof(buf));
+		buf.type = buf_type;
+		buf.memory = V4L2_MEMORY_DMABUF;
+		if (mplane) {
+			buf.m.planes = planes;
+			buf.length = num_planes;
+		}
+		t0 = now_ns();
+		ret = ioctl(fd, VIDIOC_DQBUF, &buf);
+		t1 = now_ns();
+		if (ret) {
+			if (errno == EAGAIN)
+				continue;
+			printf("VIDIOC_DQBUF errno %s\n", strerror(errno));
+			break;
+		}
+		stat_add(&dqbuf, (t1 - t0) / 1000.0);
+
+		if (buf.flags & V4L2_BUF_FLAG_ERROR)
+			errors++;
+		if (done && buf.sequence > last_seq + 1)
+			dropped += buf.sequence - last_seq - 1;
+
+		ts = (uint64_t)buf.timestamp.tv_sec * 1000000000ULL +
+		     buf.timestamp.tv_usec * 1000ULL;
+		if (done && ts > last_ts)
+			stat_add(&interval, (ts - last_ts) / 1000.0);
+
+		lat_us = -1;
+		if (sd_fd >= 0) {
+			slot = buf.sequence % SOF_RING;
+			if (sof_ns[slot] && sof_seq[slot] == buf.sequence &&
+			    t1 > sof_ns[slot]) {
+				lat_us = (t1 - sof_ns[slot]) / 1000.0;
+				stat_add(&latency, lat_us);
+			} else {
+				unmatched++;
+			}
+		}
+
+		if (csv)
+			fprintf(csv, "%u,%llu,%llu,%.3f,%.3f,%.3f,0x%x\n",
+				buf.sequence, (unsigned long long)ts,
+				(unsigned long long)t1, lat_us,
+				done && ts > last_ts ? (ts - last_ts) / 1000.0 : 0,
+				(t1 - t0) / 1000.0, buf.flags);
+
+		last_seq = buf.sequence;
+		last_ts = ts;
+		done++;
+
+		if (queue_buffer(fd, buf.index, &qbuf))
+			break;
+	}
+
+	ioctl(fd, VIDIOC_STREAMOFF, &buf_type);
+	t1 = now_ns();
+
+	if (machine) {
+		printf("device=%s\nframes=%llu\ndropped=%llu\nerrors=%llu\n"
+		       "unmatched_sof=%llu\nduration_ms=%llu\n",
+		       video_dev, (unsigned long long)done,
+		       (unsigned long long)dropped, (unsigned long long)errors,
+		       (unsigned long long)unmatched,
+		       (unsigned long long)((t1 - start_ns) / 1000000));
+	} else {
+		printf("%s: %llu frames in %llu ms, %llu dropped, %llu errors",
+		       video_dev, (unsigned long long)done,
+		       (unsigned long long)((t1 - start_ns) / 1000000),
+		       (unsigned long long)dropped, (unsigned long long)errors);
+		if (sd_fd >= 0)
+			printf(", %llu without sof", (unsigned long long)unmatched);
+		printf("\n");
+	}
+	stat_print("qbuf", &qbuf, machine);
+	stat_print("dqbuf", &dqbuf, machine);
+	stat_print("interval", &interval, machine);
+	if (sd_fd >= 0)
+		stat_print("sof_to_dqbuf", &latency, machine);
+
+	if (csv)
+		fclose(csv);
+	if (sd_fd >= 0)
+		close(sd_fd);
+	close(fd);
+
+	return done == frames ? 0 : 1;
+}
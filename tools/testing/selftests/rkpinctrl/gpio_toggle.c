@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co. Ltd.
+ *
+ * Toggle rate of gpio output lines. The lines are toggled once through
+ * one request per line and once through a single request holding all of
+ * them, which the driver sets with one write per bank.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/types.h>
+
+#include "../../../../include/uapi/linux/gpio.h"
+
+#define DEFAULT_TICKS	100000
+
+static int line_request(int chip, const unsigned int *offsets, int num)
+{
+	struct gpio_v2_line_request req;
+	int i, ret;
+
+	memset(&req, 0, sizeof(req));
+	for (i = 0; i < num; i++)
+		req.offsets[i] = offsets[i];
+	req.num_lines = num;
+	req.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+	strcpy(req.consumer, "gpio_toggle");
+
+	ret = ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &req);
+	if (ret < 0) {
+		perror("fail to request lines");
+		return ret;
+	}
+
+	return req.fd;
+}
+
+static int line_set(int fd, uint64_t bits, uint64_t mask)
+{
+	struct gpio_v2_line_values values = {
+		.bits = bits,
+		.mask = mask,
+	};
+
+	return ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values);
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, int lines, int ticks, double s)
+{
+	printf("%-8s lines:%d ticks:%d time:%.3fs ticks/s:%.0f toggles/s:%.0f\n",
+	       name, lines, ticks, s, ticks / s, (double)ticks * lines / s);
+}
+
+static int bench_single(int chip, const unsigned int *offsets, int num,
+			int ticks)
+{
+	int fd[GPIO_V2_LINES_MAX];
+	double start;
+	int i, t, ret = 0;
+
+	for (i = 0; i < num; i++) {
+		fd[i] = line_request(chip, &offsets[i], 1);
+		if (fd[i] < 0) {
+			num = i;
+			ret = -1;
+			goto out;
+		}
+	}
+
+	start = now_s();
+	for (t = 0; t < ticks; t++) {
+		for (i = 0; i < num; i++) {
+			if (line_set(fd[i], t & 1, 1) < 0) {
+				perror("fail to set line");
+				ret = -1;
+				goto out;
+			}
+		}
+	}
+	report("single", num, ticks, now_s() - start);
+
+out:
+	for (i = 0; i < num; i++)
+		close(fd[i]);
+	return ret;
+}
+
+static int bench_batch(int chip, const unsigned int *offsets, int num,
+		       int ticks)
+{
+	uint64_t mask = num == 64 ? ~0ULL : (1ULL << num) - 1;
+	double start;
+	int fd, t, ret = 0;
+
+	fd = line_request(chip, offsets, num);
+	if (fd < 0)
+		return -1;
+
+	start = now_s();
+	for (t = 0; t < ticks; t++) {
+		if (line_set(fd, t & 1 ? mask : 0, mask) < 0) {
+			perror("fail to set lines");
+			ret = -1;
+			break;
+		}
+	}
+	if (!ret)
+		report("batch", num, ticks, now_s() - start);
+
+	close(fd);
+	return ret;
+}
+
+static void usage(void)
+{
+	printf("%s:\n"
+		"gpio_toggle [gpiochip] [ticks] [line offset]...\n"
+		"e.g. gpio_toggle /dev/gpiochip3 100000 8 9 10 11\n",
+		__func__);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int offsets[GPIO_V2_LINES_MAX];
+	int chip, ticks, num, i;
+	int ret;
+
+	if (argc < 4 || argc - 3 > GPIO_V2_LINES_MAX) {
+		usage();
+		return -1;
+	}
+
+	ticks = atoi(argv[2]);
+	if (ticks <= 0)
+		ticks = DEFAULT_TICKS;
+	num = argc - 3;
+	for (i = 0; i < num; i++)
+		offsets[i] = atoi(argv[i + 3]);
+
+	chip = open(argv[1], O_RDWR);
+	if (chip < 0) {
+		printf("open %s failed!\n", argv[1]);
+		return chip;
+	}
+
+	ret = bench_single(chip, offsets, num, ticks);
+	if (!ret)
+		ret = bench_batch(chip, offsets, num, ticks);
+
+	close(chip);
+	return ret;
+}